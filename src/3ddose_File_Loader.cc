@@ -3,16 +3,17 @@
 // This program loads ASCII DOSXYZnrc 3ddose files.
 //
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <exception>
-#include <fstream>
 #include <numeric>
 #include <list>
 #include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>    
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <cstdlib>            //Needed for exit() calls.
@@ -24,6 +25,7 @@
 
 #include "Structs.h"
 #include "Imebra_Shim.h"      //Needed for Collate_Image_Arrays().
+#include "Text_Parsing.h"
 
 
 bool Load_From_3ddose_Files( Drover &DICOM_data,
@@ -50,21 +52,6 @@ bool Load_From_3ddose_Files( Drover &DICOM_data,
     //
     if(Filenames.empty()) return true;
 
-    const auto extract_separated_numbers = [](const std::string &in) -> std::vector<double> {
-            // This rountine extracts numerical function parameters.
-            auto split = SplitStringToVector(in, ' ', 'd');
-            split = SplitVector(split, '\t', 'd');
-
-            std::vector<double> numbers;
-            for(const auto &w : split){
-               try{
-                   const auto x = std::stod(w);
-                   numbers.emplace_back(x);
-               }catch(const std::exception &){ }
-            }
-            return numbers;
-    };
-
     size_t i = 0;
     const size_t N = Filenames.size();
 
@@ -77,10 +64,7 @@ bool Load_From_3ddose_Files( Drover &DICOM_data,
         try{
             //////////////////////////////////////////////////////////////
             // Attempt to load the file.
-            std::fstream FI(Filename.c_str(), std::ios::in);
-            if(!FI.good()){
-                throw std::runtime_error("Unable to read file.");
-            }
+            const mapped_text_file FI(Filename);
 
             bool dims_known = false;
             long int N_x = -1;
@@ -93,41 +77,16 @@ bool Load_From_3ddose_Files( Drover &DICOM_data,
 
             std::vector<double> doses;
 
-/*
-            try{
-                double shtl;
-                FI >> N_x >> N_y >> N_z;
-                for(long int i = 0; i <= N_x; ++i){ // Intentionally reads N_x+1 values.
-                    FI >> shtl;
-                    spatial_x.emplace_back(shtl);
-                }
-                for(long int i = 0; i <= N_x; ++i){ // Intentionally reads N_y+1 values.
-                    FI >> shtl;
-                    spatial_x.emplace_back(shtl);
-                }
-                for(long int i = 0; i <= N_x; ++i){ // Intentionally reads N_z+1 values.
-                    FI >> shtl;
-                    spatial_x.emplace_back(shtl);
-                }
-                while(!FI.eof()){
-                    FI >> shtl;
-                    doses.emplace_back(shtl);
-                }
-            }catch(const std::exception &){ }
-            FI.close();
-*/            
-            std::string aline;
-            while(!FI.eof()){
-                std::getline(FI, aline);
-
-                // Ignore comments.
-                const auto hash_pos = aline.find_first_of('#');
-                if(hash_pos != std::string::npos){
-                    aline = aline.substr(0, hash_pos);
-                }
+            // The dimensions and voxel boundaries are parsed line-by-line.
+            const char *pos = FI.begin();
+            std::vector<double> numbers;
+            while( (pos != FI.end())
+               &&  (!dims_known || (static_cast<long int>(spatial_z.size()) != (N_z + 1))) ){
+                const auto aline = Next_Line(pos, FI.end());
 
-                // Extract all numbers separated by whitespace.
-                const auto numbers = extract_separated_numbers(aline);
+                // Extract all numbers separated by whitespace, ignoring comments.
+                numbers.clear();
+                Append_Numbers(aline.first, aline.second, numbers);
                 if(numbers.empty()) continue;
 
                 // If the matrix dimensions are not yet known, seek this info before reading any other information.
@@ -148,57 +107,30 @@ bool Load_From_3ddose_Files( Drover &DICOM_data,
                     }
                     dims_known = true;
                     continue;
+                }
 
                 // Attempt to parse spatial information.
-                }else if( dims_known 
-                      && (static_cast<long int>(spatial_x.size()) != (N_x + 1)) ){
-
-                    for(const auto &n : numbers){
-                        if(!std::isfinite(n)) continue;
-                    }
-                    spatial_x.insert( std::end(spatial_x), std::begin(numbers), std::end(numbers) );
-
-                }else if( dims_known 
-                      && (static_cast<long int>(spatial_x.size()) == (N_x + 1))
-                      && (static_cast<long int>(spatial_y.size()) != (N_y + 1)) ){
-
-                    for(const auto &n : numbers){
-                        if(!std::isfinite(n)) continue;
-                    }
-                    spatial_y.insert( std::end(spatial_y), std::begin(numbers), std::end(numbers) );
-
-                }else if( dims_known 
-                      && (static_cast<long int>(spatial_x.size()) == (N_x + 1))
-                      && (static_cast<long int>(spatial_y.size()) == (N_y + 1))
-                      && (static_cast<long int>(spatial_z.size()) != (N_z + 1)) ){
-
-                    for(const auto &n : numbers){
-                        if(!std::isfinite(n)) continue;
-                    }
-                    spatial_z.insert( std::end(spatial_z), std::begin(numbers), std::end(numbers) );
-
-                // Continue reading in all dose and trailing dose uncertainties.
-                //
-                // If the final number of voxels differs from the stated dimensions, then this file is not valid.
-                }else if( dims_known 
-                      && (static_cast<long int>(spatial_x.size()) == (N_x + 1))
-                      && (static_cast<long int>(spatial_y.size()) == (N_y + 1))
-                      && (static_cast<long int>(spatial_z.size()) == (N_z + 1)) ){
-                    for(const auto &n : numbers){
-                        if(!std::isfinite(n)) continue;
-                    }
-
-                    // Append the doses.
-                    doses.insert( std::end(doses), std::begin(numbers), std::end(numbers) );
-
-                // Unexpected scenario.
-                }else{
-                    FUNCWARN("Unable to read 3ddose file.");
-                    return false;
+                auto *spatial = &spatial_x;
+                long int N_spatial = N_x + 1;
+                if(static_cast<long int>(spatial_x.size()) == (N_x + 1)){
+                    spatial = &spatial_y;
+                    N_spatial = N_y + 1;
+                }
+                if(static_cast<long int>(spatial_y.size()) == (N_y + 1)){
+                    spatial = &spatial_z;
+                    N_spatial = N_z + 1;
+                }
+                spatial->insert( std::end(*spatial), std::begin(numbers), std::end(numbers) );
+                if(N_spatial < static_cast<long int>(spatial->size())){
+                    throw std::runtime_error("Voxel boundaries not understood.");
                 }
-
             }
-            FI.close();
+            if(!dims_known) throw std::runtime_error("Dimensions not found.");
+
+            // Read in all doses and trailing dose uncertainties, which make up the bulk of the file.
+            //
+            // If the final number of voxels differs from the stated dimensions, then this file is not valid.
+            doses = Parse_Numbers(pos, FI.end());
 
             // Validate that the file has been fully read.
             if( (static_cast<long int>(doses.size()) != (N_x * N_y * N_z))   // Dose data only.
@@ -0,0 +1,333 @@
+//Alignment_Demons.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "Thread_Pool.h"
+#include "YgorImages_Functors/Rectilinear_Volume.h"
+#include "YgorImages_Functors/Volume_Convolution.h"
+
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorStats.h"        //Needed for Stats:: namespace.
+
+#include "Alignment_Field.h"
+#include "Alignment_Demons.h"
+
+
+namespace {
+
+// Axes smaller than twice this extent are not downsampled.
+constexpr long int min_pyramid_extent = 16;
+
+// Orders the images along their normal and packs them into a regular volume.
+rectilinear_volume
+pack_volume(planar_image_collection<float,double> &imagecoll){
+    const auto orientation_normal = imagecoll.images.front().image_plane().N_0.unit();
+    auto vol = pack_along_normal(imagecoll, orientation_normal);
+    if(!vol.is_regular){
+        throw std::invalid_argument("Images are not evenly spaced. Cannot continue");
+    }
+    return vol;
+}
+
+// The signed image spacing, with a fallback for single-image volumes that do not report a thickness.
+double
+level_image_spacing(const rectilinear_volume &v){
+    const auto img_spacing = v.image_spacing();
+    if( (v.images < 2)
+    &&  ( !std::isfinite(img_spacing) || (img_spacing <= 0.0) ) ){
+        return 1.0;
+    }
+    return img_spacing;
+}
+
+// Allocates an unbacked volume with the same grid as the given volume.
+rectilinear_volume
+like(const rectilinear_volume &v, long int channels){
+    return rectilinear_volume(v.images, v.rows, v.columns, channels,
+                              v.image_origins.front(), v.row_unit, v.col_unit,
+                              v.pxl_dx, v.pxl_dy, level_image_spacing(v));
+}
+
+// Copies a single channel into an unbacked volume.
+rectilinear_volume
+extract_channel(const rectilinear_volume &v, long int chnl){
+    auto out = like(v, 1);
+    parallel_for(0, v.images, [&](long int img) -> void {
+        for(long int row = 0; row < v.rows; ++row){
+            for(long int col = 0; col < v.columns; ++col){
+                out.reference(img, row, col, 0) = v.value(img, row, col, chnl);
+            }
+        }
+    });
+    return out;
+}
+
+// Halves the resolution of a single-channel volume along each sufficiently large axis, smoothing beforehand to
+// suppress aliasing. Voxel (0,0,0) is retained. Returns nothing if no axis can be halved.
+std::optional<rectilinear_volume>
+downsample(const rectilinear_volume &v){
+    const std::array<long int, 3> extent = {{ v.rows, v.columns, v.images }};
+    std::array<long int, 3> factor;
+    bool any = false;
+    for(long int a = 0; a < 3; ++a){
+        factor[a] = ((2 * min_pyramid_extent) <= extent[a]) ? 2 : 1;
+        any = any || (factor[a] == 2);
+    }
+    if(!any) return std::nullopt;
+
+    auto smoothed = v;
+    volume_convolution::gaussian_blur(smoothed, 0, {{ (factor[0] == 2) ? 1.0 : 0.0,
+                                                      (factor[1] == 2) ? 1.0 : 0.0,
+                                                      (factor[2] == 2) ? 1.0 : 0.0 }},
+                                      volume_convolution::boundary_t::Renormalize);
+
+    rectilinear_volume out( (v.images  + factor[2] - 1) / factor[2],
+                            (v.rows    + factor[0] - 1) / factor[0],
+                            (v.columns + factor[1] - 1) / factor[1],
+                            1,
+                            v.image_origins.front(), v.row_unit, v.col_unit,
+                            v.pxl_dx * factor[0],
+                            v.pxl_dy * factor[1],
+                            level_image_spacing(v) * factor[2] );
+    parallel_for(0, out.images, [&](long int img) -> void {
+        for(long int row = 0; row < out.rows; ++row){
+            for(long int col = 0; col < out.columns; ++col){
+                out.reference(img, row, col, 0) = smoothed.value(img * factor[2], row * factor[0], col * factor[1], 0);
+            }
+        }
+    });
+    return out;
+}
+
+// Estimates the gradient of a single-channel volume using central differences where possible and one-sided
+// differences otherwise. Non-finite voxels are avoided. The result is a world-space vector.
+vec3<double>
+gradient(const rectilinear_volume &v, long int img, long int row, long int col){
+    const auto f0 = static_cast<double>( v.value(img, row, col, 0) );
+    const auto diff = [&](long int d_img, long int d_row, long int d_col, long int extent, long int i) -> double {
+        if(extent < 2) return 0.0;
+        const bool has_p = (i + 1 < extent);
+        const bool has_m = (0 <= i - 1);
+        const auto fp = (has_p) ? static_cast<double>( v.value(img + d_img, row + d_row, col + d_col, 0) )
+                                : std::numeric_limits<double>::quiet_NaN();
+        const auto fm = (has_m) ? static_cast<double>( v.value(img - d_img, row - d_row, col - d_col, 0) )
+                                : std::numeric_limits<double>::quiet_NaN();
+        if(std::isfinite(fp) && std::isfinite(fm)) return 0.5 * (fp - fm);
+        if(std::isfinite(fp) && std::isfinite(f0)) return fp - f0;
+        if(std::isfinite(fm) && std::isfinite(f0)) return f0 - fm;
+        return 0.0;
+    };
+    const auto g_row = diff(0, 1, 0, v.rows, row) / v.pxl_dx;
+    const auto g_col = diff(0, 0, 1, v.columns, col) / v.pxl_dy;
+    const auto g_img = diff(1, 0, 0, v.images, img) / level_image_spacing(v);
+    return v.row_unit * g_row + v.col_unit * g_col + v.ortho_unit * g_img;
+}
+
+// Converts a three-channel displacement volume into a deformation field.
+deformation_field
+to_field(const rectilinear_volume &u){
+    const auto img_spacing = level_image_spacing(u);
+    deformation_field out( u.image_origins.front(),
+                           u.row_unit, u.col_unit,
+                           (img_spacing < 0.0) ? u.ortho_unit * -1.0 : u.ortho_unit,
+                           u.pxl_dx, u.pxl_dy, std::abs(img_spacing),
+                           u.rows, u.columns, u.images );
+
+    // Note: both use (image, row, column) ordering, but the field stores each component separately.
+    const auto N = static_cast<long int>(out.displacements[0].size());
+    parallel_for(0, N, [&](long int i) -> void {
+        out.displacements[0][i] = u.data[3 * i + 0];
+        out.displacements[1][i] = u.data[3 * i + 1];
+        out.displacements[2][i] = u.data[3 * i + 2];
+    }, /*grain=*/ std::max<long int>(1, N / 64));
+    return out;
+}
+
+} // namespace
+
+
+std::optional<deformation_field>
+AlignViaDemons(AlignViaDemonsParams & params,
+               planar_image_collection<float,double> & moving,
+               planar_image_collection<float,double> & stationary ){
+
+    if(moving.images.empty() || stationary.images.empty()){
+        FUNCWARN("Unable to perform demons alignment: an image array is empty");
+        return std::nullopt;
+    }
+    if( (params.levels < 1)
+    ||  (params.max_iterations < 0) ){
+        throw std::invalid_argument("Level or iteration parameters are invalid. Cannot continue.");
+    }
+    if( !std::isfinite(params.max_update_length)
+    ||  (params.max_update_length <= 0.0) ){
+        throw std::invalid_argument("Maximum update length is invalid. Cannot continue.");
+    }
+
+    // Build the resolution pyramids, finest first.
+    std::vector<rectilinear_volume> pyr_s;
+    std::vector<rectilinear_volume> pyr_m;
+    {
+        const auto vol_s = pack_volume(stationary);
+        const auto vol_m = pack_volume(moving);
+        if( (params.channel < 0)
+        ||  (vol_s.channels <= params.channel)
+        ||  (vol_m.channels <= params.channel) ){
+            throw std::invalid_argument("Channel is not present in both image arrays. Cannot continue.");
+        }
+        pyr_s.emplace_back( extract_channel(vol_s, params.channel) );
+        pyr_m.emplace_back( extract_channel(vol_m, params.channel) );
+    }
+    for(long int l = 1; l < params.levels; ++l){
+        auto ds = downsample(pyr_s.back());
+        if(!ds) break;
+        // Note: the moving volume may already be too coarse to downsample, in which case it is reused.
+        auto dm = downsample(pyr_m.back());
+        if(!dm) dm = pyr_m.back();
+        pyr_s.emplace_back( std::move(ds.value()) );
+        pyr_m.emplace_back( std::move(dm.value()) );
+    }
+    FUNCINFO("Registering using " << pyr_s.size() << " resolution levels");
+
+    std::optional<deformation_field> field;
+    for(long int level = static_cast<long int>(pyr_s.size()) - 1; 0 <= level; --level){
+        const auto &S = pyr_s[level];
+        const auto &M = pyr_m[level];
+        FUNCINFO("Registering level " << level << " with "
+                 << S.rows << "x" << S.columns << "x" << S.images << " voxels");
+
+        // The accumulated displacement (U), the update (dU), and the warped moving image (W), on the stationary grid.
+        auto U  = like(S, 3);
+        auto dU = like(S, 3);
+        auto W  = like(S, 1);
+        const long int N_lines = S.images * S.rows;
+
+        // Initialize from the coarser level.
+        if(field){
+            parallel_for(0, N_lines, [&](long int line) -> void {
+                const long int img = line / S.rows;
+                const long int row = line % S.rows;
+                std::vector<vec3<double>> q(S.columns);
+                field.value().pull_back( S.position(img, row, 0), S.col_unit * S.pxl_dy, S.columns, q.data() );
+                for(long int col = 0; col < S.columns; ++col){
+                    const auto u = q[col] - S.position(img, row, col);
+                    U.reference(img, row, col, 0) = static_cast<float>(u.x);
+                    U.reference(img, row, col, 1) = static_cast<float>(u.y);
+                    U.reference(img, row, col, 2) = static_cast<float>(u.z);
+                }
+            });
+        }
+
+        // The normalization that bounds the update length.
+        double mean_spacing = 0.0;
+        {
+            Stats::Running_Sum<double> rs;
+            long int n = 0;
+            if(1 < S.rows){    rs.Digest(S.pxl_dx); ++n; }
+            if(1 < S.columns){ rs.Digest(S.pxl_dy); ++n; }
+            if(1 < S.images){  rs.Digest(std::abs(level_image_spacing(S))); ++n; }
+            mean_spacing = (0 < n) ? rs.Current_Sum() / static_cast<double>(n) : S.pxl_dx;
+        }
+        const double K = std::pow(2.0 * params.max_update_length * mean_spacing, 2.0);
+
+        std::vector<double> line_sq_diffs(N_lines);
+        std::vector<long int> line_counts(N_lines);
+        double mse_prev = std::numeric_limits<double>::quiet_NaN();
+        for(long int iter = 0; iter < params.max_iterations; ++iter){
+
+            // Resample the moving image through the current deformation.
+            parallel_for(0, N_lines, [&](long int line) -> void {
+                const long int img = line / S.rows;
+                const long int row = line % S.rows;
+                for(long int col = 0; col < S.columns; ++col){
+                    const vec3<double> u( U.value(img, row, col, 0),
+                                          U.value(img, row, col, 1),
+                                          U.value(img, row, col, 2) );
+                    W.reference(img, row, col, 0) = M.interpolate( S.position(img, row, col) + u, 0,
+                                                                   std::numeric_limits<float>::quiet_NaN() );
+                }
+            });
+
+            // Compute the demons forces and tally the intensity mismatch.
+            parallel_for(0, N_lines, [&](long int line) -> void {
+                const long int img = line / S.rows;
+                const long int row = line % S.rows;
+                double sq_diffs = 0.0;
+                long int count = 0;
+                for(long int col = 0; col < S.columns; ++col){
+                    const auto diff = static_cast<double>( S.value(img, row, col, 0) )
+                                    - static_cast<double>( W.value(img, row, col, 0) );
+                    vec3<double> du(0.0, 0.0, 0.0);
+                    if(std::isfinite(diff)){
+                        sq_diffs += diff * diff;
+                        ++count;
+
+                        auto g = gradient(S, img, row, col);
+                        if(params.symmetric_forces){
+                            g = (g + gradient(W, img, row, col)) * 0.5;
+                        }
+                        const auto denom = g.Dot(g) + (diff * diff) / K;
+                        if(0.0 < denom) du = g * (diff / denom);
+                    }
+                    dU.reference(img, row, col, 0) = static_cast<float>(du.x);
+                    dU.reference(img, row, col, 1) = static_cast<float>(du.y);
+                    dU.reference(img, row, col, 2) = static_cast<float>(du.z);
+                }
+                line_sq_diffs[line] = sq_diffs;
+                line_counts[line] = count;
+            });
+
+            Stats::Running_Sum<double> rs;
+            long int count = 0;
+            for(long int line = 0; line < N_lines; ++line){
+                rs.Digest(line_sq_diffs[line]);
+                count += line_counts[line];
+            }
+            if(count == 0){
+                FUNCWARN("Unable to perform demons alignment: the image arrays do not overlap");
+                return std::nullopt;
+            }
+            const double mse = rs.Current_Sum() / static_cast<double>(count);
+            params.final_mse = mse;
+            FUNCINFO("Level " << level << ", iteration " << iter << ": mean squared difference = " << mse);
+
+            if( std::isfinite(mse_prev)
+            &&  (std::abs(mse_prev - mse) <= (params.relative_tolerance * mse_prev)) ){
+                break;
+            }
+            mse_prev = mse;
+
+            // Regularize and accumulate.
+            if(0.0 < params.update_sigma){
+                for(long int c = 0; c < 3; ++c){
+                    volume_convolution::gaussian_blur(dU, c, {{ params.update_sigma,
+                                                                params.update_sigma,
+                                                                params.update_sigma }});
+                }
+            }
+            const auto N_values = static_cast<long int>(U.data.size());
+            parallel_for(0, N_values, [&](long int i) -> void {
+                U.data[i] += dU.data[i];
+            }, /*grain=*/ std::max<long int>(1, N_values / 64));
+            if(0.0 < params.field_sigma){
+                for(long int c = 0; c < 3; ++c){
+                    volume_convolution::gaussian_blur(U, c, {{ params.field_sigma,
+                                                               params.field_sigma,
+                                                               params.field_sigma }});
+                }
+            }
+        }
+
+        field = to_field(U);
+    }
+    return field;
+}
+
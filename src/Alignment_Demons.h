@@ -0,0 +1,63 @@
+//Alignment_Demons.h - A part of DICOMautomaton 2020. Written by hal clark.
+
+#pragma once
+
+#include <optional>
+#include <limits>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
+#include "Alignment_Field.h"
+
+
+// This routine finds a deformable, intensity-based alignment of two image arrays using the 'demons' algorithm.
+//
+// Voxel intensities are assumed to be directly comparable (i.e., the same modality with the same calibration). The
+// moving image array is iteratively resampled through the current deformation, and each voxel is displaced along the
+// local intensity gradient in proportion to the intensity mismatch (Thirion's demons, optionally with symmetric
+// 'efficient second-order' forces). The update and/or the accumulated field are regularized by Gaussian smoothing.
+// The registration proceeds coarse-to-fine over a pyramid of Gaussian-smoothed, downsampled volumes.
+//
+// Both image arrays must form rectilinear grids, but they need not share a grid. The deformation field is defined on
+// the stationary grid.
+//
+// Note that this routine only identifies a transform, it does not implement it by altering the inputs.
+//
+struct AlignViaDemonsParams {
+    // The image channel to register, which is used for both image arrays.
+    long int channel = 0;
+
+    // The maximum number of resolution levels, including the full-resolution level. Each coarser level halves the
+    // resolution along each axis that is sufficiently large.
+    long int levels = 3;
+
+    // The maximum number of iterations at each resolution level.
+    long int max_iterations = 100;
+
+    // Iteration at a level stops when the mean squared intensity difference changes by this fraction or less.
+    double relative_tolerance = 1.0E-4;
+
+    // Whether to use symmetric forces, which average the stationary and warped moving image gradients. Symmetric
+    // forces generally converge faster and more reliably than Thirion's original (stationary gradient) forces.
+    bool symmetric_forces = true;
+
+    // Gaussian smoothing applied to each update ('fluid' regularization) and to the accumulated deformation field
+    // ('diffusion' regularization). Widths are standard deviations in units of voxels at the current level, so the
+    // physical smoothing is broadest at the coarsest level. Non-positive widths disable the corresponding smoothing.
+    double update_sigma = 0.0;
+    double field_sigma = 1.5;
+
+    // The largest displacement permitted in a single update, in units of the (mean) voxel size at the current level.
+    double max_update_length = 0.5;
+
+    // Output: the mean squared intensity difference at the final iteration.
+    double final_mse = std::numeric_limits<double>::quiet_NaN();
+};
+
+std::optional<deformation_field>
+AlignViaDemons(AlignViaDemonsParams & params,
+               planar_image_collection<float,double> & moving,       // Not modified.
+               planar_image_collection<float,double> & stationary ); // Not modified.
+
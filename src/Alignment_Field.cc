@@ -0,0 +1,292 @@
+//Alignment_Field.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Thread_Pool.h"
+#include "Alignment_Field.h"
+
+
+namespace {
+
+// Trilinearly interpolates the displacement at the given fractional (row, column, image) grid coordinates, clamping
+// to the grid.
+inline void
+sample(const deformation_field &df, const double (&f)[3], double (&u)[3]){
+    const long int extent[3] = { df.rows, df.columns, df.images };
+    const long int stride[3] = { df.columns, 1, df.rows * df.columns };
+
+    long int i0[3];
+    long int s[3];
+    double w[3];
+    for(int a = 0; a < 3; ++a){
+        const double fc = std::clamp(f[a], 0.0, static_cast<double>(extent[a] - 1));
+        if(!std::isfinite(fc)){
+            throw std::runtime_error("Failed to evaluate deformation field. Cannot continue.");
+        }
+        i0[a] = std::min<long int>(static_cast<long int>(fc), std::max<long int>(extent[a] - 2, 0));
+        w[a] = fc - static_cast<double>(i0[a]);
+        s[a] = (1 < extent[a]) ? stride[a] : 0;
+    }
+
+    const long int base = i0[0] * stride[0] + i0[1] * stride[1] + i0[2] * stride[2];
+    double wc[8];
+    long int ic[8];
+    for(int c = 0; c < 8; ++c){
+        const int b0 = (c & 1), b1 = ((c >> 1) & 1), b2 = ((c >> 2) & 1);
+        wc[c] = (b0 ? w[0] : 1.0 - w[0])
+              * (b1 ? w[1] : 1.0 - w[1])
+              * (b2 ? w[2] : 1.0 - w[2]);
+        ic[c] = base + b0 * s[0] + b1 * s[1] + b2 * s[2];
+    }
+    for(int a = 0; a < 3; ++a){
+        const float *comp = df.displacements[a].data();
+        double acc = 0.0;
+        for(int c = 0; c < 8; ++c){
+            acc += wc[c] * static_cast<double>(comp[ic[c]]);
+        }
+        u[a] = acc;
+    }
+    return;
+}
+
+// Converts a position into fractional (row, column, image) grid coordinates.
+inline void
+grid_coords(const deformation_field &df, const vec3<double> &v, double (&f)[3]){
+    const auto d = v - df.origin;
+    f[0] = d.Dot(df.row_unit) / df.pxl_dx;
+    f[1] = d.Dot(df.col_unit) / df.pxl_dy;
+    f[2] = d.Dot(df.img_unit) / df.pxl_dz;
+    return;
+}
+
+} // namespace
+
+
+deformation_field::deformation_field(const vec3<double> &o,
+                                     const vec3<double> &r_unit,
+                                     const vec3<double> &c_unit,
+                                     const vec3<double> &i_unit,
+                                     double dx, double dy, double dz,
+                                     long int N_rows, long int N_columns, long int N_images)
+    : origin(o), row_unit(r_unit.unit()), col_unit(c_unit.unit()), img_unit(i_unit.unit()),
+      pxl_dx(dx), pxl_dy(dy), pxl_dz(dz),
+      rows(N_rows), columns(N_columns), images(N_images) {
+
+    if( (this->rows <= 0) || (this->columns <= 0) || (this->images <= 0) ){
+        throw std::invalid_argument("Deformation field dimensions must be positive.");
+    }
+    if( !std::isfinite(dx) || !std::isfinite(dy) || !std::isfinite(dz)
+    ||  (dx <= 0.0) || (dy <= 0.0) || (dz <= 0.0) ){
+        throw std::invalid_argument("Deformation field voxel spacing is invalid.");
+    }
+    for(auto &comp : this->displacements){
+        comp.resize( static_cast<size_t>(this->rows * this->columns * this->images), 0.0f );
+    }
+}
+
+long int
+deformation_field::index(long int img, long int row, long int col) const {
+    return (img * this->rows + row) * this->columns + col;
+}
+
+vec3<double>
+deformation_field::position(long int img, long int row, long int col) const {
+    return this->origin + this->row_unit * (this->pxl_dx * static_cast<double>(row))
+                        + this->col_unit * (this->pxl_dy * static_cast<double>(col))
+                        + this->img_unit * (this->pxl_dz * static_cast<double>(img));
+}
+
+vec3<double>
+deformation_field::displacement(const vec3<double> &v) const {
+    double f[3];
+    double u[3];
+    grid_coords(*this, v, f);
+    sample(*this, f, u);
+    return vec3<double>(u[0], u[1], u[2]);
+}
+
+vec3<double>
+deformation_field::pull_back(const vec3<double> &v) const {
+    return v + this->displacement(v);
+}
+
+void
+deformation_field::pull_back(const vec3<double> &start, const vec3<double> &step, long int N, vec3<double> *out) const {
+    // Grid coordinates vary linearly along the line, so the projections are only needed once.
+    double f0[3];
+    grid_coords(*this, start, f0);
+    const double df[3] = { step.Dot(this->row_unit) / this->pxl_dx,
+                           step.Dot(this->col_unit) / this->pxl_dy,
+                           step.Dot(this->img_unit) / this->pxl_dz };
+    double f[3];
+    double u[3];
+    for(long int i = 0; i < N; ++i){
+        const auto t = static_cast<double>(i);
+        f[0] = f0[0] + df[0] * t;
+        f[1] = f0[1] + df[1] * t;
+        f[2] = f0[2] + df[2] * t;
+        sample(*this, f, u);
+        out[i] = vec3<double>( start.x + step.x * t + u[0],
+                               start.y + step.y * t + u[1],
+                               start.z + step.z * t + u[2] );
+    }
+    return;
+}
+
+vec3<double>
+deformation_field::transform(const vec3<double> &v) const {
+    // Invert the mapping x -> x + u(x) using a fixed-point iteration, which converges when the field is smooth
+    // (i.e., when the displacement gradient is everywhere smaller than one).
+    const auto tol = 1.0E-4 * std::min({ this->pxl_dx, this->pxl_dy, this->pxl_dz });
+    auto x = v - this->displacement(v);
+    for(long int i = 0; i < 50; ++i){
+        const auto x_next = v - this->displacement(x);
+        const auto change = x_next.distance(x);
+        x = x_next;
+        if(change < tol) break;
+    }
+    if(!x.isfinite()){
+        throw std::runtime_error("Failed to evaluate deformation field mapping function. Cannot continue.");
+    }
+    return x;
+}
+
+void
+deformation_field::apply_to(point_set<double> &ps) const {
+    const auto N = static_cast<long int>(ps.points.size());
+    parallel_for(0, N, [&](long int i) -> void {
+        ps.points[i] = this->transform(ps.points[i]);
+    });
+    return;
+}
+
+void
+deformation_field::apply_to(fv_surface_mesh<double, uint64_t> &mesh) const {
+    const auto N = static_cast<long int>(mesh.vertices.size());
+    parallel_for(0, N, [&](long int i) -> void {
+        mesh.vertices[i] = this->transform(mesh.vertices[i]);
+    });
+    return;
+}
+
+deformation_field
+deformation_field::compose(const deformation_field &next) const {
+    // The composite maps a stationary position x (of 'next') to the moving position p(q(x)), where q and p are the
+    // pull-backs of 'next' and this field, respectively.
+    deformation_field out( next.origin, next.row_unit, next.col_unit, next.img_unit,
+                           next.pxl_dx, next.pxl_dy, next.pxl_dz,
+                           next.rows, next.columns, next.images );
+    parallel_for(0, out.images * out.rows, [&](long int line) -> void {
+        const long int img = line / out.rows;
+        const long int row = line % out.rows;
+        const auto start = out.position(img, row, 0);
+        const auto step = out.col_unit * out.pxl_dy;
+
+        std::vector<vec3<double>> q(out.columns);
+        next.pull_back(start, step, out.columns, q.data());
+        for(long int col = 0; col < out.columns; ++col){
+            const auto u = this->pull_back(q[col]) - (start + step * static_cast<double>(col));
+            const auto i = out.index(img, row, col);
+            out.displacements[0][i] = static_cast<float>(u.x);
+            out.displacements[1][i] = static_cast<float>(u.y);
+            out.displacements[2][i] = static_cast<float>(u.z);
+        }
+    }, /*grain=*/ 1);
+    return out;
+}
+
+deformation_field
+deformation_field::invert() const {
+    // The inverse pulls a moving position y back to transform(y).
+    deformation_field out( this->origin, this->row_unit, this->col_unit, this->img_unit,
+                           this->pxl_dx, this->pxl_dy, this->pxl_dz,
+                           this->rows, this->columns, this->images );
+    parallel_for(0, out.images * out.rows, [&](long int line) -> void {
+        const long int img = line / out.rows;
+        const long int row = line % out.rows;
+        for(long int col = 0; col < out.columns; ++col){
+            const auto y = out.position(img, row, col);
+            const auto u = this->transform(y) - y;
+            const auto i = out.index(img, row, col);
+            out.displacements[0][i] = static_cast<float>(u.x);
+            out.displacements[1][i] = static_cast<float>(u.y);
+            out.displacements[2][i] = static_cast<float>(u.z);
+        }
+    }, /*grain=*/ 1);
+    return out;
+}
+
+bool
+deformation_field::write_to( std::ostream &os ) const {
+    // Maximize precision prior to emitting any floating-point numbers.
+    const auto original_precision = os.precision();
+    os.precision( std::numeric_limits<double>::max_digits10 );
+
+    os << this->origin << std::endl;
+    os << this->row_unit << std::endl;
+    os << this->col_unit << std::endl;
+    os << this->img_unit << std::endl;
+    os << this->pxl_dx << " " << this->pxl_dy << " " << this->pxl_dz << std::endl;
+    os << this->rows << " " << this->columns << " " << this->images << std::endl;
+    const auto N = this->displacements[0].size();
+    for(size_t i = 0; i < N; ++i){
+        os << this->displacements[0][i] << " "
+           << this->displacements[1][i] << " "
+           << this->displacements[2][i] << std::endl;
+    }
+
+    os.precision( original_precision );
+    os.flush();
+    return (!os.fail());
+}
+
+bool
+deformation_field::read_from( std::istream &is ){
+    try{
+        is >> this->origin;
+        is >> this->row_unit;
+        is >> this->col_unit;
+        is >> this->img_unit;
+    }catch(const std::exception &e){
+        FUNCWARN("Failed to read deformation field geometry: " << e.what());
+        return false;
+    }
+
+    is >> this->pxl_dx >> this->pxl_dy >> this->pxl_dz;
+    if( is.fail()
+    ||  !(0.0 < this->pxl_dx) || !(0.0 < this->pxl_dy) || !(0.0 < this->pxl_dz) ){
+        FUNCWARN("Voxel spacing could not be read, or is invalid.");
+        return false;
+    }
+
+    is >> this->rows >> this->columns >> this->images;
+    if( is.fail()
+    ||  !isininc(1, this->rows, 1'000'000)
+    ||  !isininc(1, this->columns, 1'000'000)
+    ||  !isininc(1, this->images, 1'000'000) ){
+        FUNCWARN("Deformation field dimensions could not be read, or are invalid.");
+        return false;
+    }
+
+    const auto N = static_cast<size_t>(this->rows * this->columns * this->images);
+    for(auto &comp : this->displacements){
+        comp.resize(N);
+    }
+    for(size_t i = 0; i < N; ++i){
+        is >> this->displacements[0][i] >> this->displacements[1][i] >> this->displacements[2][i];
+    }
+    return (!is.fail());
+}
+
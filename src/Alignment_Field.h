@@ -0,0 +1,84 @@
+//Alignment_Field.h - A part of DICOMautomaton 2020. Written by hal clark.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <iosfwd>
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorMath.h"         //Needed for vec3 class.
+
+
+// This class encapsulates a dense deformation, represented as a displacement field sampled on a regular grid.
+//
+// The field is defined in the *stationary* frame: a stationary position x corresponds to the moving position
+// x + u(x), where u is trilinearly interpolated from the grid. This is the mapping needed to resample moving images
+// onto a stationary grid (see pull_back()). The mapping from moving to stationary positions, which matches the
+// convention of the other transformations (see transform()), is the inverse and is evaluated iteratively.
+//
+// Displacements beyond the grid are taken from the nearest grid voxel.
+class deformation_field {
+    public:
+        // Grid geometry. Voxel (row, column, image) is centred at
+        //   origin + row_unit * (pxl_dx * row) + col_unit * (pxl_dy * column) + img_unit * (pxl_dz * image).
+        // The units must be orthonormal.
+        vec3<double> origin;
+        vec3<double> row_unit;
+        vec3<double> col_unit;
+        vec3<double> img_unit;
+        double pxl_dx;
+        double pxl_dy;
+        double pxl_dz;
+        long int rows;
+        long int columns;
+        long int images;
+
+        // Displacement vector components (in DICOM units; mm) along x, y, and z. Each component is stored separately
+        // with (image, row, column) ordering, so a 512^3 field occupies 1.5 GB.
+        std::array<std::vector<float>, 3> displacements;
+
+        // Constructor.
+        //
+        // Creates a zero (i.e., identity) field with the given geometry.
+        deformation_field() = delete;
+        deformation_field(const vec3<double> &origin,
+                          const vec3<double> &row_unit,
+                          const vec3<double> &col_unit,
+                          const vec3<double> &img_unit,
+                          double pxl_dx, double pxl_dy, double pxl_dz,
+                          long int rows, long int columns, long int images);
+
+        // Member functions.
+        long int index(long int img, long int row, long int col) const;
+        vec3<double> position(long int img, long int row, long int col) const;
+
+        vec3<double> displacement(const vec3<double> &v) const;
+
+        // Maps a stationary position to the corresponding moving position.
+        vec3<double> pull_back(const vec3<double> &v) const;
+
+        // Maps N evenly spaced stationary positions (start + step * i) to the corresponding moving positions. This is
+        // considerably faster than mapping the positions individually, e.g., when resampling a row of voxels.
+        void pull_back(const vec3<double> &start, const vec3<double> &step, long int N, vec3<double> *out) const;
+
+        // Maps a moving position to the corresponding stationary position.
+        vec3<double> transform(const vec3<double> &v) const;
+        void apply_to(point_set<double> &ps) const;
+        void apply_to(fv_surface_mesh<double, uint64_t> &mesh) const;
+
+        // Creates a field, sampled on the grid of 'next', that is equivalent to applying this transformation followed
+        // by 'next'. The stationary frame of this field must be the moving frame of 'next'.
+        deformation_field compose(const deformation_field &next) const;
+
+        // Creates a field, sampled on the same grid, that implements the inverse transformation. The grid should
+        // cover the region of interest in the moving frame.
+        deformation_field invert() const;
+
+        // Serialize and deserialize to a human- and machine-readable format.
+        bool write_to( std::ostream &os ) const;
+        bool read_from( std::istream &is );
+};
+
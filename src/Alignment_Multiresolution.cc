@@ -0,0 +1,185 @@
+//Alignment_Multiresolution.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "Point_Set_KD_Tree.h"
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorStats.h"        //Needed for Stats:: namespace.
+
+#include "Alignment_Rigid.h"
+#include "Alignment_TPSRPM.h"
+#include "Alignment_Multiresolution.h"
+
+
+point_set<double>
+Voxel_Grid_Decimate(const point_set<double> & ps,
+                    double voxel_size ){
+    if( !std::isfinite(voxel_size)
+    ||  !(0.0 < voxel_size) ){
+        throw std::invalid_argument("Voxel size must be finite and positive. Cannot continue.");
+    }
+
+    point_set<double> out;
+    if(ps.points.empty()) return out;
+
+    const auto inf = std::numeric_limits<double>::infinity();
+    vec3<double> lo(inf, inf, inf);
+    for(const auto &p : ps.points){
+        if(!p.isfinite()){
+            throw std::invalid_argument("Encountered a non-finite point. Cannot decimate.");
+        }
+        lo.x = std::min(lo.x, p.x);
+        lo.y = std::min(lo.y, p.y);
+        lo.z = std::min(lo.z, p.z);
+    }
+
+    using cell_t = std::tuple<int64_t, int64_t, int64_t, size_t>;
+    std::vector<cell_t> cells;
+    cells.reserve(ps.points.size());
+    for(size_t i = 0; i < ps.points.size(); ++i){
+        const auto &p = ps.points[i];
+        cells.emplace_back( static_cast<int64_t>(std::floor((p.x - lo.x) / voxel_size)),
+                            static_cast<int64_t>(std::floor((p.y - lo.y) / voxel_size)),
+                            static_cast<int64_t>(std::floor((p.z - lo.z) / voxel_size)),
+                            i );
+    }
+    std::sort(std::begin(cells), std::end(cells));
+
+    for(auto c_it = std::begin(cells); c_it != std::end(cells); ){
+        const auto same_cell = [&](const cell_t &c) -> bool {
+            return (std::get<0>(c) == std::get<0>(*c_it))
+                && (std::get<1>(c) == std::get<1>(*c_it))
+                && (std::get<2>(c) == std::get<2>(*c_it));
+        };
+        const auto c_end = std::find_if_not(c_it, std::end(cells), same_cell);
+
+        Stats::Running_Sum<double> x, y, z;
+        for(auto it = c_it; it != c_end; ++it){
+            const auto &p = ps.points[ std::get<3>(*it) ];
+            x.Digest(p.x);
+            y.Digest(p.y);
+            z.Digest(p.z);
+        }
+        const auto N = static_cast<double>( std::distance(c_it, c_end) );
+        out.points.emplace_back( x.Current_Sum() / N, y.Current_Sum() / N, z.Current_Sum() / N );
+        c_it = c_end;
+    }
+    return out;
+}
+
+
+std::vector<registration_level>
+Build_Registration_Pyramid(const AlignViaMultiresolutionParams & params,
+                           const point_set<double> & moving,
+                           const point_set<double> & stationary ){
+    std::vector<registration_level> out;
+    if(params.levels <= 1) return out;
+    if( (moving.points.size() < 2)
+    ||  (stationary.points.size() < 2) ){
+        return out;
+    }
+
+    double voxel_size = params.voxel_size;
+    if( !std::isfinite(voxel_size)
+    ||  !(0.0 < voxel_size) ){
+        const Point_Set_KD_Tree tree(stationary.points);
+        Stats::Running_Sum<double> rs;
+        for(const auto &p : stationary.points){
+            // Note: the first hit is the point itself.
+            rs.Digest( std::sqrt(tree.k_nearest(p, 2).back().sq_dist) );
+        }
+        voxel_size = 2.0 * rs.Current_Sum() / static_cast<double>(stationary.points.size());
+        FUNCINFO("Using a base voxel size of " << voxel_size);
+    }
+    if(!(0.0 < voxel_size)){
+        FUNCWARN("Unable to estimate a voxel size. Continuing without decimation");
+        return out;
+    }
+
+    const auto min_points = static_cast<size_t>( std::max<long int>(params.min_points, 1) );
+    for(long int l = 0; l < (params.levels - 1); ++l){
+        registration_level level;
+        level.voxel_size = voxel_size;
+        level.moving = Voxel_Grid_Decimate(moving, voxel_size);
+        level.stationary = Voxel_Grid_Decimate(stationary, voxel_size);
+
+        // Coarser levels would only retain fewer points.
+        if( (level.moving.points.size() < min_points)
+        ||  (level.stationary.points.size() < min_points) ){
+            break;
+        }
+        out.emplace_back(std::move(level));
+        voxel_size *= 2.0;
+    }
+
+    std::reverse(std::begin(out), std::end(out));
+    return out;
+}
+
+
+#ifdef DCMA_USE_EIGEN
+std::optional<affine_transform<double>>
+AlignViaMultiresolutionICP( const AlignViaMultiresolutionParams & mr_params,
+                            const point_set<double> & moving,
+                            const point_set<double> & stationary,
+                            long int max_icp_iters,
+                            double f_rel_tol ){
+
+    const auto solve_level = [&](const point_set<double> &m,
+                                 const point_set<double> &s,
+                                 bool,
+                                 const std::optional<affine_transform<double>> &seed)
+                                     -> std::optional<affine_transform<double>> {
+        return AlignViaExhaustiveICP(m, s, max_icp_iters, f_rel_tol, seed);
+    };
+    return Align_Coarse_To_Fine<affine_transform<double>>(mr_params, moving, stationary, solve_level);
+}
+
+
+std::optional<thin_plate_spline>
+AlignViaMultiresolutionTPSRPM( const AlignViaMultiresolutionParams & mr_params,
+                               AlignViaTPSRPMParams & params,
+                               const point_set<double> & moving,
+                               const point_set<double> & stationary ){
+
+    double T_prev = std::numeric_limits<double>::quiet_NaN();
+    const auto solve_level = [&](const point_set<double> &m,
+                                 const point_set<double> &s,
+                                 bool is_finest,
+                                 const std::optional<thin_plate_spline> &seed) -> std::optional<thin_plate_spline> {
+        if(is_finest){
+            params.seed_transform = seed;
+            params.T_start_override = (seed) ? T_prev : std::numeric_limits<double>::quiet_NaN();
+            return AlignViaTPSRPM(params, m, s);
+        }
+
+        // Decimated levels do not share point indices with the full-resolution sets.
+        AlignViaTPSRPMParams p = params;
+        p.forced_correspondence.clear();
+        p.report_final_correspondence = false;
+        p.T_end_scale = std::max(p.T_end_scale, 1.0);
+        p.seed_transform = seed;
+        p.T_start_override = (seed) ? T_prev : std::numeric_limits<double>::quiet_NaN();
+
+        std::optional<thin_plate_spline> t;
+        try{
+            t = AlignViaTPSRPM(p, m, s);
+        }catch(const std::exception &e){
+            FUNCWARN("TPS-RPM failed at a decimated level: " << e.what());
+        }
+        T_prev = (t) ? p.final_T : std::numeric_limits<double>::quiet_NaN();
+        return t;
+    };
+    return Align_Coarse_To_Fine<thin_plate_spline>(mr_params, moving, stationary, solve_level);
+}
+#endif // DCMA_USE_EIGEN
+
@@ -0,0 +1,113 @@
+//Alignment_Multiresolution.h - A part of DICOMautomaton 2020. Written by hal clark.
+
+#pragma once
+
+#include <optional>
+#include <limits>
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorMath.h"         //Needed for vec3 class.
+
+#include "Alignment_TPSRPM.h"
+
+
+// Replaces the points within each cell of a regular grid with their centroid. Cells are cubes with the given edge
+// length aligned to the minimum corner of the point set's bounding box. The output is ordered by cell, so it does not
+// depend on the order of the input points.
+point_set<double>
+Voxel_Grid_Decimate(const point_set<double> & ps,
+                    double voxel_size );
+
+
+struct AlignViaMultiresolutionParams {
+
+    // The number of resolution levels, including the full-resolution level. A single level disables decimation.
+    long int levels = 3;
+
+    // The voxel size used for the finest decimated level. Each coarser level doubles the voxel size. If not positive,
+    // twice the mean nearest-neighbour separation of the stationary point set is used.
+    double voxel_size = 0.0;
+
+    // Levels that would retain fewer points than this in either point set are omitted.
+    long int min_points = 25;
+};
+
+
+// A pair of decimated point sets at one resolution level.
+struct registration_level {
+    double voxel_size;
+    point_set<double> moving;
+    point_set<double> stationary;
+};
+
+// Decimates both point sets into successively coarser levels. Levels are ordered coarsest first and exclude the
+// full-resolution level, so the result may be empty.
+std::vector<registration_level>
+Build_Registration_Pyramid(const AlignViaMultiresolutionParams & params,
+                           const point_set<double> & moving,
+                           const point_set<double> & stationary );
+
+
+// Generic coarse-to-fine driver.
+//
+// The solver is invoked for every pyramid level, coarsest first, and then with the full-resolution point sets. It is
+// passed the result from the previous level (if any) to seed the solution, and must have the signature
+//
+//   std::optional<T> solve_level(const point_set<double> &moving,
+//                                const point_set<double> &stationary,
+//                                bool is_finest,
+//                                const std::optional<T> &seed);
+//
+// If a coarse level fails, the next level is attempted without a seed.
+template <class T, class F>
+std::optional<T>
+Align_Coarse_To_Fine(const AlignViaMultiresolutionParams & params,
+                     const point_set<double> & moving,
+                     const point_set<double> & stationary,
+                     F solve_level ){
+    std::optional<T> t;
+    const auto levels = Build_Registration_Pyramid(params, moving, stationary);
+    for(const auto &level : levels){
+        FUNCINFO("Registering level with voxel size " << level.voxel_size << ", "
+                 << level.moving.points.size() << " moving points, and "
+                 << level.stationary.points.size() << " stationary points");
+        auto t_level = solve_level(level.moving, level.stationary, false, t);
+        if(!t_level){
+            FUNCWARN("Registration failed at voxel size " << level.voxel_size << ", continuing without a seed");
+        }
+        t = t_level;
+    }
+    return solve_level(moving, stationary, true, t);
+}
+
+
+#ifdef DCMA_USE_EIGEN
+// This routine performs an exhaustive ICP alignment coarse-to-fine. Each level is seeded with the previous level's
+// transformation, and the coarsest level is seeded using a PCA-based alignment.
+//
+// Note that this routine only identifies a suitable transform, it does not implement it by altering the inputs.
+//
+std::optional<affine_transform<double>>
+AlignViaMultiresolutionICP( const AlignViaMultiresolutionParams & mr_params,
+                            const point_set<double> & moving,
+                            const point_set<double> & stationary,
+                            long int max_icp_iters = 100,
+                            double f_rel_tol = std::numeric_limits<double>::quiet_NaN() );
+
+// This routine performs a TPS-RPM alignment coarse-to-fine.
+//
+// Coarse levels anneal until the temperature reaches their own (squared) point spacing, since finer detail is not
+// resolved. Finer levels are seeded with the previous level's transformation and continue annealing from the previous
+// level's final temperature. Forced correspondences and final correspondence reporting only apply to the
+// full-resolution level.
+//
+// Note that this routine only identifies a suitable transform, it does not implement it by altering the inputs.
+//
+std::optional<thin_plate_spline>
+AlignViaMultiresolutionTPSRPM( const AlignViaMultiresolutionParams & mr_params,
+                               AlignViaTPSRPMParams & params,
+                               const point_set<double> & moving,
+                               const point_set<double> & stationary );
+#endif // DCMA_USE_EIGEN
+
@@ -26,6 +26,7 @@
 
 #include "Structs.h"
 #include "Thread_Pool.h"
+#include "Point_Set_KD_Tree.h"
 
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -300,7 +301,8 @@ std::optional<affine_transform<double>>
 AlignViaExhaustiveICP( const point_set<double> & moving,
                        const point_set<double> & stationary,
                        long int max_icp_iters,
-                       double f_rel_tol ){
+                       double f_rel_tol,
+                       const std::optional<affine_transform<double>> &t_seed ){
 
     // The WIP transformation.
     affine_transform<double> t;
@@ -323,14 +325,18 @@ AlignViaExhaustiveICP( const point_set<double> & moving,
     // optimal alignment is impeded by many local minima) will certainly negatively impact the convergence rate, and may
     // actually make it impossible to find the true alignment using this alignment method. Therefore, the PCA method is
     // used by default. If problems are encountered with the PCA method, resorting to the centroid method may be
-    // sufficient.
+    // sufficient. A user-provided seed (e.g., from a coarser registration) takes precedence.
     //
     // Default:
-    t = AlignViaPCA(moving, stationary).value();
+    t = (t_seed) ? t_seed.value() : AlignViaPCA(moving, stationary).value();
     //
     // Fallback:
     //t = AlignViaCentroid(moving, stationary).value();
 
+    // The stationary set does not change, so it is indexed once for all iterations.
+    if(stationary.points.empty()) return std::nullopt;
+    const Point_Set_KD_Tree stationary_tree(stationary.points);
+
     double f_prev = std::numeric_limits<double>::quiet_NaN();
     for(long int icp_iter = 0; icp_iter < max_icp_iters; ++icp_iter){
         // Copy the original points.
@@ -340,26 +346,16 @@ AlignViaExhaustiveICP( const point_set<double> & moving,
         t.apply_to(working);
         const auto centroid_w = working.Centroid();
 
-        // Exhaustively determine the correspondence between stationary and working points under the current
-        // transformation. Note that multiple working points may correspond to the same stationary point.
+        // Determine the correspondence between stationary and working points under the current transformation using
+        // nearest-neighbour queries. Note that multiple working points may correspond to the same stationary point.
         const auto N_working_points = working.points.size();
         if(N_working_points != corresp.points.size()) throw std::logic_error("Encountered inconsistent working buffers. Cannot continue.");
         {
-            asio_thread_pool tp;
+            const auto hits = stationary_tree.nearest(working.points);
             for(size_t i = 0; i < N_working_points; ++i){
-                tp.submit_task([&,i]() -> void {
-                    const auto w_p = working.points[i];
-                    double min_sq_dist = std::numeric_limits<double>::infinity();
-                    for(const auto &s_p : stationary.points){
-                        const auto sq_dist = w_p.sq_dist(s_p);
-                        if(sq_dist < min_sq_dist){
-                            min_sq_dist = sq_dist;
-                            corresp.points[i] = s_p;
-                        }
-                    }
-                }); // thread pool task closure.
+                corresp.points[i] = stationary.points[ hits[i].index ];
             }
-        } // Wait until all threads are done.
+        }
 
 
         ///////////////////////////////////
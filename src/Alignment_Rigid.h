@@ -38,13 +38,17 @@ AlignViaPCA(const point_set<double> & moving,
 #ifdef DCMA_USE_EIGEN
 // This routine performs an exhaustive iterative closest point (ICP) alignment.
 //
+// The initial correspondence is established using the seed transformation, if provided, or otherwise using a PCA-based
+// alignment.
+//
 // Note that this routine only identifies a suitable transform, it does not implement it by altering the inputs.
 //
 std::optional<affine_transform<double>>
 AlignViaExhaustiveICP( const point_set<double> & moving,
                        const point_set<double> & stationary,
                        long int max_icp_iters = 100,
-                       double f_rel_tol = std::numeric_limits<double>::quiet_NaN() );
+                       double f_rel_tol = std::numeric_limits<double>::quiet_NaN(),
+                       const std::optional<affine_transform<double>> &t_seed = std::nullopt );
 #endif // DCMA_USE_EIGEN
 
 
@@ -2,6 +2,7 @@
 
 #include <asio.hpp>
 #include <algorithm>
+#include <cmath>
 #include <optional>
 #include <fstream>
 #include <iterator>
@@ -27,6 +28,7 @@
 #include "Structs.h"
 #include "Regex_Selectors.h"
 #include "Thread_Pool.h"
+#include "Point_Set_KD_Tree.h"
 
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -120,10 +122,118 @@ thin_plate_spline::transform(const vec3<double> &v) const {
 }
 
 void
-thin_plate_spline::apply_to(point_set<double> &ps) const {
-    for(auto &p : ps.points){
-        p = this->transform(p);
+thin_plate_spline::apply_to(std::vector<vec3<double>> &vs) const {
+    const auto N = static_cast<long int>(this->control_points.points.size());
+    const bool log_kernel = (this->kernel_dimension == 2);
+    if( !log_kernel && (this->kernel_dimension != 3) ){
+        throw std::invalid_argument("Kernel dimension not currently supported. Cannot continue.");
+    }
+
+    // Control points and warp coefficients are held as separate arrays so the kernel sums can be vectorized.
+    std::vector<double> c_x(N), c_y(N), c_z(N), w_x(N), w_y(N), w_z(N);
+    for(long int i = 0; i < N; ++i){
+        const auto &P_i = this->control_points.points[i];
+        c_x[i] = P_i.x;
+        c_y[i] = P_i.y;
+        c_z[i] = P_i.z;
+        w_x[i] = W_A.read_coeff(i, 0);
+        w_y[i] = W_A.read_coeff(i, 1);
+        w_z[i] = W_A.read_coeff(i, 2);
+    }
+    double affine[4][3];
+    for(long int r = 0; r < 4; ++r){
+        for(long int c = 0; c < 3; ++c) affine[r][c] = W_A.read_coeff(N + r, c);
     }
+
+    // Points are processed in small tiles and control points in blocks that fit in cache, so each block is reused by
+    // every point in a tile. Block sums are accumulated with compensated summation like transform().
+    constexpr long int tile = 8;
+    constexpr long int block = 512;
+    const auto N_vs = static_cast<long int>(vs.size());
+    parallel_for(0, (N_vs + tile - 1) / tile, [&](long int t) -> void {
+        const long int j_begin = t * tile;
+        const long int j_end = std::min(N_vs, j_begin + tile);
+        const long int n = j_end - j_begin;
+
+        Stats::Running_Sum<double> x[tile];
+        Stats::Running_Sum<double> y[tile];
+        Stats::Running_Sum<double> z[tile];
+        for(long int j = 0; j < n; ++j){
+            const auto &v = vs[j_begin + j];
+            x[j].Digest(affine[0][0]);
+            x[j].Digest(affine[1][0] * v.x);
+            x[j].Digest(affine[2][0] * v.y);
+            x[j].Digest(affine[3][0] * v.z);
+
+            y[j].Digest(affine[0][1]);
+            y[j].Digest(affine[1][1] * v.x);
+            y[j].Digest(affine[2][1] * v.y);
+            y[j].Digest(affine[3][1] * v.z);
+
+            z[j].Digest(affine[0][2]);
+            z[j].Digest(affine[1][2] * v.x);
+            z[j].Digest(affine[2][2] * v.y);
+            z[j].Digest(affine[3][2] * v.z);
+        }
+
+        for(long int b = 0; b < N; b += block){
+            const long int b_end = std::min(N, b + block);
+            for(long int j = 0; j < n; ++j){
+                const auto &v = vs[j_begin + j];
+                double s_x = 0.0;
+                double s_y = 0.0;
+                double s_z = 0.0;
+                if(log_kernel){
+                    for(long int i = b; i < b_end; ++i){
+                        const double dx = c_x[i] - v.x;
+                        const double dy = c_y[i] - v.y;
+                        const double dz = c_z[i] - v.z;
+                        const double d2 = dx * dx + dy * dy + dz * dz;
+                        // Note: If points overlap exactly, this assumes they are actually infinitesimally separated.
+                        const double k = (0.0 < d2) ? d2 * std::log(d2) : 0.0;
+                        s_x += w_x[i] * k;
+                        s_y += w_y[i] * k;
+                        s_z += w_z[i] * k;
+                    }
+                }else{
+                    for(long int i = b; i < b_end; ++i){
+                        const double dx = c_x[i] - v.x;
+                        const double dy = c_y[i] - v.y;
+                        const double dz = c_z[i] - v.z;
+                        const double k = std::sqrt(dx * dx + dy * dy + dz * dz);
+                        s_x += w_x[i] * k;
+                        s_y += w_y[i] * k;
+                        s_z += w_z[i] * k;
+                    }
+                }
+                x[j].Digest(s_x);
+                y[j].Digest(s_y);
+                z[j].Digest(s_z);
+            }
+        }
+
+        for(long int j = 0; j < n; ++j){
+            const vec3<double> f_v( x[j].Current_Sum(),
+                                    y[j].Current_Sum(),
+                                    z[j].Current_Sum() );
+            if(!f_v.isfinite()){
+                throw std::runtime_error("Failed to evaluate TPS mapping function. Cannot continue.");
+            }
+            vs[j_begin + j] = f_v;
+        }
+    });
+    return;
+}
+
+void
+thin_plate_spline::apply_to(point_set<double> &ps) const {
+    this->apply_to(ps.points);
+    return;
+}
+
+void
+thin_plate_spline::apply_to(fv_surface_mesh<double, uint64_t> &mesh) const {
+    this->apply_to(mesh.vertices);
     return;
 }
 
@@ -188,6 +298,275 @@ thin_plate_spline::read_from( std::istream &is ){
     return (!is.fail());
 }
 
+#ifdef DCMA_USE_EIGEN
+namespace {
+
+// Selects a well-spread subset of points using farthest-point sampling, starting with the first point. If there are
+// fewer distinct points than requested, only the distinct points are selected.
+point_set<double>
+select_control_points(const point_set<double> &ps, long int N_ctrl){
+    const auto N = static_cast<long int>(ps.points.size());
+    point_set<double> out;
+    if(N <= N_ctrl){
+        out.points = ps.points;
+        return out;
+    }
+
+    std::vector<double> sq_dists(N, std::numeric_limits<double>::infinity());
+    long int next = 0;
+    for(long int n = 0; n < N_ctrl; ++n){
+        const auto c = ps.points[next];
+        out.points.emplace_back(c);
+
+        double farthest = -1.0;
+        for(long int i = 0; i < N; ++i){
+            sq_dists[i] = std::min(sq_dists[i], c.sq_dist(ps.points[i]));
+            if(farthest < sq_dists[i]){
+                farthest = sq_dists[i];
+                next = i;
+            }
+        }
+        if(farthest <= 0.0) break;
+    }
+    return out;
+}
+
+// A reduced-rank thin plate spline system.
+//
+// Rather than placing a kernel at every data point and solving the dense (N+4)x(N+4) interpolation system, kernels are
+// placed only at the spline's M control points and the coefficients are fitted to all N data points in the
+// least-squares sense (i.e., a Nystrom-style approximation). The orthogonality constraints on the warp coefficients
+// are eliminated using a null-space basis, so only an MxM symmetric system needs to be factored. Setup requires
+// O(N*M) memory and O(N*M^2) time, and each factorization requires O(M^3) time.
+//
+// Factorizations are retained, so subsequent solves with the same regularization and uniform weights (e.g.,
+// successive iterations at a fixed TPS-RPM temperature, or all iterations when regularization is disabled) only
+// require O(N*M) time.
+class reduced_tps_system {
+    private:
+        long int N_data = 0;
+        long int N_ctrl = 0;
+
+        Eigen::MatrixXd K_cc;                         // Kernel evaluated between control points.
+        Eigen::HouseholderQR<Eigen::MatrixXd> P_c_qr; // Provides the null space of the control points' affine basis.
+        Eigen::MatrixXd B;                            // Design matrix: [ K_dc Q_2, P_d ].
+        Eigen::MatrixXd R;                            // Regularization matrix: blockdiag( Q_2^T K_cc Q_2, 0 ).
+        Eigen::MatrixXd BtB;                          // Cached B^T B (lower triangle) for uniform weights.
+
+        Eigen::LDLT<Eigen::MatrixXd> LDLT;
+        bool factorization_is_reusable = false;
+        double factored_lambda = std::numeric_limits<double>::quiet_NaN();
+
+    public:
+        reduced_tps_system(const thin_plate_spline &t, const point_set<double> &data){
+            const auto &cps = t.control_points.points;
+            this->N_data = static_cast<long int>(data.points.size());
+            this->N_ctrl = static_cast<long int>(cps.size());
+            if(this->N_ctrl < 5){
+                throw std::invalid_argument("At least five distinct control points are required. Cannot continue.");
+            }
+
+            this->K_cc.resize(this->N_ctrl, this->N_ctrl);
+            Eigen::MatrixXd P_c(this->N_ctrl, 4);
+            for(long int i = 0; i < this->N_ctrl; ++i){
+                P_c(i, 0) = 1.0;
+                P_c(i, 1) = cps[i].x;
+                P_c(i, 2) = cps[i].y;
+                P_c(i, 3) = cps[i].z;
+                this->K_cc(i, i) = t.eval_kernel(0.0);
+                for(long int j = i + 1; j < this->N_ctrl; ++j){
+                    const auto kij = t.eval_kernel(cps[i].distance(cps[j]));
+                    this->K_cc(i, j) = kij;
+                    this->K_cc(j, i) = kij;
+                }
+            }
+
+            // The trailing (M-4) columns of Q span the null space of P_c^T, so warp coefficients w = Q_2 z
+            // automatically satisfy the TPS orthogonality constraints.
+            this->P_c_qr.compute(P_c);
+            const auto Q = this->P_c_qr.householderQ();
+
+            this->B.resize(this->N_data, this->N_ctrl);
+            parallel_for(0, this->N_data, [&](long int i) -> void {
+                for(long int j = 0; j < this->N_ctrl; ++j){
+                    this->B(i, j) = t.eval_kernel(data.points[i].distance(cps[j]));
+                }
+            });
+            this->B.applyOnTheRight(Q);
+            for(long int j = 0; j < (this->N_ctrl - 4); ++j){
+                this->B.col(j) = this->B.col(j + 4);
+            }
+            for(long int i = 0; i < this->N_data; ++i){
+                this->B(i, this->N_ctrl - 4) = 1.0;
+                this->B(i, this->N_ctrl - 3) = data.points[i].x;
+                this->B(i, this->N_ctrl - 2) = data.points[i].y;
+                this->B(i, this->N_ctrl - 1) = data.points[i].z;
+            }
+
+            Eigen::MatrixXd QtKQ = this->K_cc;
+            QtKQ.applyOnTheLeft(Q.adjoint());
+            QtKQ.applyOnTheRight(Q);
+            this->R = Eigen::MatrixXd::Zero(this->N_ctrl, this->N_ctrl);
+            this->R.topLeftCorner(this->N_ctrl - 4, this->N_ctrl - 4) = QtKQ.bottomRightCorner(this->N_ctrl - 4,
+                                                                                               this->N_ctrl - 4);
+        }
+
+        // Solves for the coefficients that minimize
+        //
+        //   sum_i omega_i |Y_i - f(x_i)|^2 + lambda * sum_d (w_d^T K_cc w_d),
+        //
+        // where x_i are the data points and w_d are the warp coefficients for dimension d. Uniform weights are used if
+        // omega is empty. Coefficients are written in the thin_plate_spline W_A layout.
+        void solve(double lambda,
+                   const Eigen::VectorXd &omega,
+                   const Eigen::Ref<const Eigen::MatrixXd> &Y,
+                   Eigen::Ref<Eigen::MatrixXd> W_A){
+            if( (Y.rows() != this->N_data)
+            ||  (W_A.rows() != (this->N_ctrl + 4)) ){
+                throw std::logic_error("Reduced TPS system dimensions do not match. Refusing to continue.");
+            }
+            const bool weighted = (omega.size() != 0);
+
+            if( weighted
+            ||  !this->factorization_is_reusable
+            ||  (this->factored_lambda != lambda) ){
+                // Note: only the lower triangle is formed, since it is all the factorization reads.
+                Eigen::MatrixXd G;
+                if(weighted){
+                    const Eigen::MatrixXd sqrt_omega_B = omega.cwiseSqrt().asDiagonal() * this->B;
+                    G = Eigen::MatrixXd::Zero(this->N_ctrl, this->N_ctrl);
+                    G.selfadjointView<Eigen::Lower>().rankUpdate(sqrt_omega_B.transpose());
+                }else{
+                    if(this->BtB.size() == 0){
+                        this->BtB = Eigen::MatrixXd::Zero(this->N_ctrl, this->N_ctrl);
+                        this->BtB.selfadjointView<Eigen::Lower>().rankUpdate(this->B.transpose());
+                    }
+                    G = this->BtB;
+                }
+                G += this->R * lambda;
+
+                this->LDLT.compute(G);
+                if(this->LDLT.info() != Eigen::Success){
+                    throw std::runtime_error("Unable to update transformation: LDLT decomposition failed.");
+                }
+                this->factorization_is_reusable = !weighted;
+                this->factored_lambda = lambda;
+            }
+
+            const Eigen::MatrixXd rhs = (weighted) ? Eigen::MatrixXd(this->B.transpose() * (omega.asDiagonal() * Y))
+                                                   : Eigen::MatrixXd(this->B.transpose() * Y);
+            const Eigen::MatrixXd theta = this->LDLT.solve(rhs);
+            if(this->LDLT.info() != Eigen::Success){
+                throw std::runtime_error("Unable to update transformation: LDLT solve failed.");
+            }
+
+            // Recover the warp coefficients from their null-space coordinates.
+            Eigen::MatrixXd w = Eigen::MatrixXd::Zero(this->N_ctrl, Y.cols());
+            w.bottomRows(this->N_ctrl - 4) = theta.topRows(this->N_ctrl - 4);
+            w.applyOnTheLeft(this->P_c_qr.householderQ());
+
+            W_A.topRows(this->N_ctrl) = w;
+            W_A.bottomRows(4) = theta.bottomRows(4);
+            return;
+        }
+
+        const Eigen::MatrixXd & control_point_kernel() const {
+            return this->K_cc;
+        }
+};
+
+// A truncated softassign correspondence matrix.
+//
+// Only a sparse subset of the coefficients between moving points (rows) and stationary points (columns) are stored,
+// along with the dense outlier 'gutter' column and row. Omitted coefficients are zero. The bottom-right coefficient,
+// which relates the two gutters, is always zero.
+struct truncated_correspondence {
+    struct coeff_t {
+        long int j;   // Stationary point index.
+        double m;
+    };
+    std::vector<std::vector<coeff_t>> rows; // Sorted by stationary point index.
+    std::vector<double> move_outliers;      // The gutter column, i.e., M(i, N_stat_points) for moving point outliers.
+    std::vector<double> stat_outliers;      // The gutter row, i.e., M(N_move_points, j) for stationary point outliers.
+
+    // Note: sums are accumulated in the same order as for the dense matrix.
+    std::vector<double> column_sums() const {
+        std::vector<Stats::Running_Sum<double>> rs(this->stat_outliers.size());
+        for(const auto &row : this->rows){
+            for(const auto &c : row) rs[c.j].Digest(c.m);
+        }
+        std::vector<double> sums;
+        sums.reserve(rs.size());
+        for(size_t j = 0; j < rs.size(); ++j){
+            rs[j].Digest(this->stat_outliers[j]);
+            sums.emplace_back(rs[j].Current_Sum());
+        }
+        return sums;
+    }
+
+    double row_sum(long int i) const {
+        Stats::Running_Sum<double> rs;
+        for(const auto &c : this->rows[i]) rs.Digest(c.m);
+        rs.Digest(this->move_outliers[i]);
+        return rs.Current_Sum();
+    }
+
+    // Performs one Sinkhorn iteration, normalizing rows and then columns. Rows or columns that sum to less than eps
+    // are not normalized.
+    void normalize(double eps){
+        const auto N_rows = static_cast<long int>(this->rows.size());
+        parallel_for(0, N_rows, [&](long int i) -> void {
+            const auto s = this->row_sum(i);
+            if(s < eps) return;
+            for(auto &c : this->rows[i]) c.m /= s;
+            this->move_outliers[i] /= s;
+        });
+
+        const auto sums = this->column_sums();
+        parallel_for(0, N_rows, [&](long int i) -> void {
+            for(auto &c : this->rows[i]){
+                if(eps <= sums[c.j]) c.m /= sums[c.j];
+            }
+        });
+        for(size_t j = 0; j < this->stat_outliers.size(); ++j){
+            if(eps <= sums[j]) this->stat_outliers[j] /= sums[j];
+        }
+        return;
+    }
+
+    // Reports the row- or column-sum (including gutters) that deviates the most from one.
+    double worst_row_col_sum_deviation() const {
+        double w = 0.0;
+        for(long int i = 0; i < static_cast<long int>(this->rows.size()); ++i){
+            w = std::max(w, std::abs(this->row_sum(i) - 1.0));
+        }
+        for(const auto &s : this->column_sums()){
+            w = std::max(w, std::abs(s - 1.0));
+        }
+        return w;
+    }
+
+    bool all_finite() const {
+        const auto is_finite = [](double x){ return std::isfinite(x); };
+        for(const auto &row : this->rows){
+            for(const auto &c : row){
+                if(!std::isfinite(c.m)) return false;
+            }
+        }
+        return std::all_of(std::begin(this->move_outliers), std::end(this->move_outliers), is_finite)
+            && std::all_of(std::begin(this->stat_outliers), std::end(this->stat_outliers), is_finite);
+    }
+
+    std::size_t nonzeros() const {
+        std::size_t n = 0;
+        for(const auto &row : this->rows) n += row.size();
+        return n;
+    }
+};
+
+} // namespace
+#endif // DCMA_USE_EIGEN
+
 #ifdef DCMA_USE_EIGEN
 // This routine finds a non-rigid alignment using thin plate splines.
 //
@@ -208,6 +587,35 @@ AlignViaTPS(AlignViaTPSParams & params,
         return std::nullopt;
     }
 
+    // Use a reduced set of control points, avoiding the dense system entirely.
+    if(params.solution_method == AlignViaTPSParams::SolutionMethod::LowRank){
+        thin_plate_spline t(select_control_points(moving, params.low_rank_control_points), params.kernel_dimension);
+        const auto N_ctrl_points = static_cast<long int>(t.control_points.points.size());
+        FUNCINFO("Using " << N_ctrl_points << " control points for " << N_move_points << " moving points");
+
+        Eigen::Map<Eigen::Matrix< double,
+                                  Eigen::Dynamic,
+                                  Eigen::Dynamic,
+                                  Eigen::ColMajor >> W_A(&(*(t.W_A.begin())),
+                                                         N_ctrl_points + 4,  3);
+        Eigen::MatrixXd Y(N_stat_points, 3);
+        for(long int j = 0; j < N_stat_points; ++j){
+            const auto P_stationary = stationary.points[j];
+            Y(j, 0) = P_stationary.x;
+            Y(j, 1) = P_stationary.y;
+            Y(j, 2) = P_stationary.z;
+        }
+
+        reduced_tps_system system(t, moving);
+        system.solve(params.lambda, Eigen::VectorXd(), Y, W_A);
+
+        if(!W_A.allFinite()){
+            FUNCWARN("Failed to solve for a finite-valued transform");
+            return std::nullopt;
+        }
+        return t;
+    }
+
     thin_plate_spline t(moving, params.kernel_dimension);
 
     // Prepare working buffers.
@@ -321,7 +729,11 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     const auto N_move_points = static_cast<long int>(moving.points.size());
     const auto N_stat_points = static_cast<long int>(stationary.points.size());
 
-    thin_plate_spline t(moving, params.kernel_dimension);
+    // When the low-rank solver is used, only a subset of the moving points are used as control points.
+    const bool use_low_rank = (params.solution_method == AlignViaTPSRPMParams::SolutionMethod::LowRank);
+    thin_plate_spline t( use_low_rank ? select_control_points(moving, params.low_rank_control_points) : moving,
+                         params.kernel_dimension );
+    const auto N_ctrl_points = static_cast<long int>(t.control_points.points.size());
 
     // Compute the centroid for the stationary point cloud.
     // Stationary point outliers will be assumed to have this location.
@@ -339,42 +751,36 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         FUNCINFO("Locating mean nearest-neighbour separation in moving point cloud");
         Stats::Running_Sum<double> rs;
         {
-            //asio_thread_pool tp;
+            const Point_Set_KD_Tree tree_move(moving.points);
             for(long int i = 0; i < N_move_points; ++i){
-                //tp.submit_task([&,i](void) -> void {
+                // The query point itself is among the two nearest, so the other is its nearest neighbour.
                 double min_sq_dist = std::numeric_limits<double>::infinity();
-                for(long int j = 0; j < N_move_points; ++j){
-                    if(i == j) continue;
-                    const auto sq_dist = (moving.points[i]).sq_dist( moving.points[j] );
-                    if(sq_dist < min_sq_dist) min_sq_dist = sq_dist;
+                for(const auto &h : tree_move.k_nearest(moving.points[i], 2)){
+                    if(h.index != static_cast<size_t>(i)){
+                        min_sq_dist = h.sq_dist;
+                        break;
+                    }
                 }
                 if(!std::isfinite(min_sq_dist)){
                     throw std::runtime_error("Unable to estimate nearest neighbour distance.");
                 }
                 rs.Digest(min_sq_dist);
-                //}); // thread pool task closure.
             }
         }
         mean_nn_sq_dist = rs.Current_Sum() / static_cast<double>( N_move_points );
 
         FUNCINFO("Locating max square-distance between all points");
         {
-            //asio_thread_pool tp;
-            //std::mutex saver_printer;
-            for(long int i = 0; i < (N_move_points + N_stat_points); ++i){
-                //tp.submit_task([&,i](void) -> void {
-                    for(long int j = 0; j < i; ++j){
-                        const auto A = (i < N_move_points) ? moving.points[i] : stationary.points[i - N_move_points];
-                        const auto B = (j < N_move_points) ? moving.points[j] : stationary.points[j - N_move_points];
-                        const auto sq_dist = A.sq_dist(B);
-                        if(max_sq_dist < sq_dist){
-                            //std::lock_guard<std::mutex> lock(saver_printer);
-                            max_sq_dist = sq_dist;
-                        }
-                    }
-                //}); // thread pool task closure.
+            std::vector<vec3<double>> all_points(moving.points);
+            all_points.insert( std::end(all_points), std::begin(stationary.points), std::end(stationary.points) );
+            const Point_Set_KD_Tree tree_all(all_points);
+            for(const auto &p : all_points){
+                const auto sq_dist = tree_all.farthest(p).sq_dist;
+                if(max_sq_dist < sq_dist){
+                    max_sq_dist = sq_dist;
+                }
             }
-        } // Wait until all threads are done.
+        }
     }
 
     const double T_start = params.T_start_scale * max_sq_dist;
@@ -396,6 +802,14 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     }
     FUNCINFO("T_start, T_step, and T_end are " << T_start << ", " << params.T_step << ", " << T_end);
 
+    // Annealing can begin at a cooler temperature, e.g., when continuing from a coarser registration.
+    double T_anneal_start = T_start;
+    if( std::isfinite(params.T_start_override)
+    &&  (0.0 < params.T_start_override) ){
+        T_anneal_start = std::max(params.T_start_override, T_end / params.T_step);
+        FUNCINFO("Annealing will begin at T = " << T_anneal_start);
+    }
+
     // Ensure any forced correpondences are valid and unique.
     {
         std::set<long int> s_m;
@@ -448,19 +862,39 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // Prepare working buffers.
     //
     // Main system matrix.
-    Eigen::MatrixXd L = Eigen::MatrixXd::Zero(N_move_points + 4, N_move_points + 4);
+    //
+    // Note: the dense system is not needed by the low-rank solver.
+    const auto N_dense = (use_low_rank) ? 0L : (N_move_points + 4);
+    Eigen::MatrixXd L = Eigen::MatrixXd::Zero(N_dense, N_dense);
     // Corresponding points working buffer.
     Eigen::MatrixXd Y = Eigen::MatrixXd::Zero(N_move_points + 4, 3); 
     // Identity matrix used for regularization.
-    Eigen::MatrixXd I_N4 = Eigen::MatrixXd::Identity(N_move_points + 4, N_move_points + 4);
+    Eigen::MatrixXd I_N4 = Eigen::MatrixXd::Identity(N_dense, N_dense);
     // Weighting matrix needed for 'double-sided outlier handling' -- Yang et al. (2011).
+    //
+    // Note: the low-rank solver instead uses the reciprocal weights directly.
     Eigen::MatrixXd W;
+    Eigen::VectorXd omega;
     if(params.double_sided_outliers){
-        W = Eigen::MatrixXd::Zero(N_move_points + 4, N_move_points + 4);
+        W = Eigen::MatrixXd::Zero(N_dense, N_dense);
+        if(use_low_rank) omega = Eigen::VectorXd::Zero(N_move_points);
     }
 
     // Corresponence matrix.
-    Eigen::MatrixXd M = Eigen::MatrixXd::Zero(N_move_points + 1, N_stat_points + 1);
+    //
+    // Note: when correspondence is truncated, a sparse matrix and a spatial index are used instead.
+    const bool use_truncation = params.truncate_correspondence;
+    if( use_truncation
+    &&  ( (params.max_correspondences < 1)
+       || !(0.0 < params.truncation_tolerance)
+       || !(params.truncation_tolerance < 1.0) ) ){
+        throw std::invalid_argument("Correspondence truncation parameters are invalid. Cannot continue.");
+    }
+    Eigen::MatrixXd M = (use_truncation) ? Eigen::MatrixXd()
+                                         : Eigen::MatrixXd::Zero(N_move_points + 1, N_stat_points + 1);
+    truncated_correspondence M_trunc;
+    std::optional<Point_Set_KD_Tree> stationary_tree;
+    if(use_truncation) stationary_tree.emplace(stationary.points);
 
     // TPS model parameters.
     //
@@ -469,61 +903,63 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // Note: To avoid a later copy, these coefficients are directly mapped to the transform buffer.
     //
     // Note: These are the parameters that get updated during the transformation update phase.
-    if(static_cast<long int>(t.W_A.size()) != (N_move_points + 4) * 3){
+    if(static_cast<long int>(t.W_A.size()) != (N_ctrl_points + 4) * 3){
         throw std::logic_error("TPS coefficients allocated with incorrect size. Refusing to continue.");
     }
     Eigen::Map<Eigen::Matrix< double,
                               Eigen::Dynamic,
                               Eigen::Dynamic,
                               Eigen::ColMajor >> W_A(&(*(t.W_A.begin())),
-                                                     N_move_points + 4,  3);
+                                                     N_ctrl_points + 4,  3);
     if( (t.W_A.num_rows() != W_A.rows())
     ||  (t.W_A.num_cols() != W_A.cols()) ){
         throw std::logic_error("TPS coefficient matrix dimesions do not match. Refusing to continue.");
     }
 
+    // The reduced system used by the low-rank solver.
+    std::optional<reduced_tps_system> reduced;
+    if(use_low_rank){
+        FUNCINFO("Using " << N_ctrl_points << " control points for " << N_move_points << " moving points");
+        reduced.emplace(t, moving);
 
-    Eigen::MatrixXd X(N_move_points, 4); // Stacked matrix of homogeneous moving set points.
-    Eigen::MatrixXd Z(N_move_points, 4); // Stacked matrix of corresponding homogeneous fixed set points.
-    Eigen::MatrixXd k(1, N_move_points); // TPS kernel vector.
-    Eigen::MatrixXd K(N_move_points, N_move_points); // TPS kernel matrix.
-
-    // Populate static elements.
-    //
-    // L matrix: "K" kernel part.
-    //
-    // Note: "K"s diagonals are later adjusted using the regularization parameter. They are set to zero initially.
-    for(long int i = 0; i < N_move_points; ++i) L(i, i) = 0.0;
-    for(long int i = 0; i < N_move_points; ++i){
-        const auto P_i = moving.points[i];
-        for(long int j = i + 1; j < N_move_points; ++j){
-            const auto P_j = moving.points[j];
-            const auto dist = P_i.distance(P_j);
-            const auto kij = t.eval_kernel(dist);
-            L(i, j) = kij;
-            L(j, i) = kij;
+    }else{
+        // Populate static elements.
+        //
+        // L matrix: "K" kernel part.
+        //
+        // Note: "K"s diagonals are later adjusted using the regularization parameter. They are set to zero initially.
+        for(long int i = 0; i < N_move_points; ++i) L(i, i) = 0.0;
+        for(long int i = 0; i < N_move_points; ++i){
+            const auto P_i = moving.points[i];
+            for(long int j = i + 1; j < N_move_points; ++j){
+                const auto P_j = moving.points[j];
+                const auto dist = P_i.distance(P_j);
+                const auto kij = t.eval_kernel(dist);
+                L(i, j) = kij;
+                L(j, i) = kij;
+            }
         }
-    }
 
-    // L matrix: "P" and "PT" parts.
-    for(long int i = 0; i < N_move_points; ++i){
-        const auto P_moving = moving.points[i];
-        L(i, N_move_points + 0) = 1.0;
-        L(i, N_move_points + 1) = P_moving.x;
-        L(i, N_move_points + 2) = P_moving.y;
-        L(i, N_move_points + 3) = P_moving.z;
-
-        L(N_move_points + 0, i) = 1.0;
-        L(N_move_points + 1, i) = P_moving.x;
-        L(N_move_points + 2, i) = P_moving.y;
-        L(N_move_points + 3, i) = P_moving.z;
+        // L matrix: "P" and "PT" parts.
+        for(long int i = 0; i < N_move_points; ++i){
+            const auto P_moving = moving.points[i];
+            L(i, N_move_points + 0) = 1.0;
+            L(i, N_move_points + 1) = P_moving.x;
+            L(i, N_move_points + 2) = P_moving.y;
+            L(i, N_move_points + 3) = P_moving.z;
+
+            L(N_move_points + 0, i) = 1.0;
+            L(N_move_points + 1, i) = P_moving.x;
+            L(N_move_points + 2, i) = P_moving.y;
+            L(N_move_points + 3, i) = P_moving.z;
+        }
+     
+        // Index matrix that only alters the "K" kernel part of L.
+        I_N4(N_move_points + 0, N_move_points + 0) = 0.0;
+        I_N4(N_move_points + 1, N_move_points + 1) = 0.0;
+        I_N4(N_move_points + 2, N_move_points + 2) = 0.0;
+        I_N4(N_move_points + 3, N_move_points + 3) = 0.0;
     }
- 
-    // Index matrix that only alters the "K" kernel part of L.
-    I_N4(N_move_points + 0, N_move_points + 0) = 0.0;
-    I_N4(N_move_points + 1, N_move_points + 1) = 0.0;
-    I_N4(N_move_points + 2, N_move_points + 2) = 0.0;
-    I_N4(N_move_points + 3, N_move_points + 3) = 0.0;
 
     // Prime the transformation with an identity affine component and no warp component.
     //
@@ -531,11 +967,30 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // temperature is sufficiently high then something like centroid-matching and PCA-alignment will naturally occur.
     // Conversely, if the temperature is set below the threshold required for global transformations, then only local
     // transformations (waprs) will occur; this may be what the user intends!
-    W_A(N_move_points + 1, 0) = 1.0; // x-component.
-    W_A(N_move_points + 2, 1) = 1.0; // y-component.
-    W_A(N_move_points + 3, 2) = 1.0; // z-component.
+    W_A(N_ctrl_points + 1, 0) = 1.0; // x-component.
+    W_A(N_ctrl_points + 2, 1) = 1.0; // y-component.
+    W_A(N_ctrl_points + 3, 2) = 1.0; // z-component.
 
-    if(params.seed_with_centroid_shift){
+    if(params.seed_transform){
+        // Re-express the seed using this routine's control points by interpolating its mapping of the moving points.
+        Eigen::MatrixXd Y_seed = Eigen::MatrixXd::Zero(N_move_points + 4, 3);
+        for(long int i = 0; i < N_move_points; ++i){
+            const auto P_seed = params.seed_transform.value().transform(moving.points[i]);
+            Y_seed(i, 0) = P_seed.x;
+            Y_seed(i, 1) = P_seed.y;
+            Y_seed(i, 2) = P_seed.z;
+        }
+        if(!Y_seed.allFinite()){
+            FUNCWARN("Seed transformation is not valid for the moving points");
+            return std::nullopt;
+        }
+        if(use_low_rank){
+            reduced.value().solve(0.0, Eigen::VectorXd(), Y_seed.topRows(N_move_points), W_A);
+        }else{
+            W_A = L.completeOrthogonalDecomposition().solve(Y_seed);
+        }
+
+    }else if(params.seed_with_centroid_shift){
         // Seed the affine transformation with the output from a simpler rigid registration.
         auto t_com = AlignViaCentroid(moving, stationary);
         if(!t_com){
@@ -543,9 +998,9 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             return std::nullopt;
         }
 
-        W_A(N_move_points + 0, 0) = t_com.value().read_coeff(3,0);
-        W_A(N_move_points + 0, 1) = t_com.value().read_coeff(3,1);
-        W_A(N_move_points + 0, 2) = t_com.value().read_coeff(3,2);
+        W_A(N_ctrl_points + 0, 0) = t_com.value().read_coeff(3,0);
+        W_A(N_ctrl_points + 0, 1) = t_com.value().read_coeff(3,1);
+        W_A(N_ctrl_points + 0, 2) = t_com.value().read_coeff(3,2);
     }
 
     // Invert the system matrix.
@@ -558,22 +1013,26 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     }
 
     // Prime the correspondence matrix with uniform correspondence terms.
-    for(long int i = 0; i < N_move_points; ++i){ // row
-        for(long int j = 0; j < N_stat_points; ++j){ // column
-            M(i, j) = 1.0 / static_cast<double>(N_move_points);
+    //
+    // Note: the truncated correspondence matrix is only populated when the correspondence is first updated.
+    if(!use_truncation){
+        for(long int i = 0; i < N_move_points; ++i){ // row
+            for(long int j = 0; j < N_stat_points; ++j){ // column
+                M(i, j) = 1.0 / static_cast<double>(N_move_points);
+            }
         }
-    }
-    {
-        const auto i = N_move_points; // row
-        for(long int j = 0; j < N_stat_points; ++j){ // column
+        {
+            const auto i = N_move_points; // row
+            for(long int j = 0; j < N_stat_points; ++j){ // column
+                M(i, j) = 0.01 / static_cast<double>(N_move_points);
+            }
+        }
+        for(long int i = 0; i < N_move_points; ++i){ // row
+            const auto j = N_stat_points; // column
             M(i, j) = 0.01 / static_cast<double>(N_move_points);
         }
+        M(N_move_points, N_stat_points) = 0.0;
     }
-    for(long int i = 0; i < N_move_points; ++i){ // row
-        const auto j = N_stat_points; // column
-        M(i, j) = 0.01 / static_cast<double>(N_move_points);
-    }
-    M(N_move_points, N_stat_points) = 0.0;
 
     // Implement the user-provided forced correspondences, if any exist, by overwriting the correspondence matrix.
     //
@@ -581,6 +1040,44 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     //       provide. Use of correspondence may require fine-tuning of the TPM-RPM algorithm parameters, especially the
     //       number of softassign iterations required.
     const auto implement_forced_correspondence = [&]() -> void {
+        if(use_truncation){
+            // Zero-out rows and columns.
+            std::vector<bool> zero_col(N_stat_points, false);
+            for(const auto &apair : params.forced_correspondence){
+                if(isininc(0, apair.first, N_move_points - 1)){
+                    for(auto &c : M_trunc.rows[apair.first]) c.m = 0.0;
+                    M_trunc.move_outliers[apair.first] = 0.0;
+                }
+                if(isininc(0, apair.second, N_stat_points - 1)){
+                    zero_col[apair.second] = true;
+                    M_trunc.stat_outliers[apair.second] = 0.0;
+                }
+            }
+            for(auto &row : M_trunc.rows){
+                for(auto &c : row){
+                    if(zero_col[c.j]) c.m = 0.0;
+                }
+            }
+
+            // Place the correspondence coefficient.
+            //
+            // Note: coefficients for valid pairs are always retained when the truncated matrix is populated.
+            for(const auto &apair : params.forced_correspondence){
+                const auto i_m = apair.first;
+                const auto j_s = apair.second;
+                const auto i_is_valid = isininc(0, i_m, N_move_points - 1);
+                const auto j_is_valid = isininc(0, j_s, N_stat_points - 1);
+                if( i_is_valid && j_is_valid ){
+                    for(auto &c : M_trunc.rows[i_m]){
+                        if(c.j == j_s) c.m = 1.0;
+                    }
+                }
+                if( !i_is_valid && j_is_valid )  M_trunc.stat_outliers[j_s] = 1.0;
+                if( i_is_valid && !j_is_valid )  M_trunc.move_outliers[i_m] = 1.0;
+            }
+            return;
+        }
+
         for(const auto &apair : params.forced_correspondence){
             const auto i_m = apair.first;
             const auto j_s = apair.second;
@@ -621,13 +1118,21 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         // Note: In some cases this causes the Sinkhorn tehnique to fail. Suppressing, but not altogether disallowing
         //       outlier coefficients does *not* seem to salvage the Sinkhorn method in these cases.
         if(!params.permit_move_outliers){
-            for(long int i = 0; i < N_move_points; ++i){ // row
-                M(i, N_stat_points) = 0.0;
+            if(use_truncation){
+                std::fill(std::begin(M_trunc.move_outliers), std::end(M_trunc.move_outliers), 0.0);
+            }else{
+                for(long int i = 0; i < N_move_points; ++i){ // row
+                    M(i, N_stat_points) = 0.0;
+                }
             }
         }
         if(!params.permit_stat_outliers){
-            for(long int j = 0; j < N_stat_points; ++j){ // column
-                M(N_move_points, j) = 0.0;
+            if(use_truncation){
+                std::fill(std::begin(M_trunc.stat_outliers), std::end(M_trunc.stat_outliers), 0.0);
+            }else{
+                for(long int j = 0; j < N_stat_points; ++j){ // column
+                    M(N_move_points, j) = 0.0;
+                }
             }
         }
 
@@ -638,6 +1143,8 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // the normalization (i.e., every row and every column sums to one, except the row and column including the
     // bottom-right coefficient).
     const auto worst_row_col_sum_deviation = [&]() -> double {
+        if(use_truncation) return M_trunc.worst_row_col_sum_deviation();
+
         double w = 0.0;
         for(long int i = 0; i < N_move_points; ++i){
             const auto ds = std::abs(M.row(i).sum() - 1.0);
@@ -657,51 +1164,121 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // Note: This sub-routine implements a 'soft-assign' technique for evaluating the correspondence.
     //       It supports outliers in either point cloud set.
     const auto update_correspondence = [&](double T_now, double s_reg) -> void {
-        // Non-outlier coefficients.
-        Stats::Running_Sum<double> com_moved_x;
-        Stats::Running_Sum<double> com_moved_y;
-        Stats::Running_Sum<double> com_moved_z;
-        for(long int i = 0; i < N_move_points; ++i){ // row
-            const auto P_moving = moving.points[i];
-            const auto P_moved = t.transform(P_moving); // Transform the point.
-            com_moved_x.Digest(P_moved.x);
-            com_moved_y.Digest(P_moved.y);
-            com_moved_z.Digest(P_moved.z);
-            for(long int j = 0; j < N_stat_points; ++j){ // column
-                const auto P_stationary = stationary.points[j];
-                const auto dP = P_stationary - P_moved;
-                M(i, j) = (1.0 / T_now)
+        if(use_truncation){
+            // Only coefficients for nearby pairs are retained. Discarded coefficients are smaller than the tolerance
+            // relative to the coefficient for coincident points.
+            const auto max_sq_dist = T_now * std::log(1.0 / params.truncation_tolerance);
+            const auto max_corr = static_cast<size_t>(params.max_correspondences);
+
+            // Coefficients named by forced correspondences must be retained.
+            std::vector<long int> forced_j(N_move_points, -1);
+            for(const auto &apair : params.forced_correspondence){
+                if( isininc(0, apair.first, N_move_points - 1)
+                &&  isininc(0, apair.second, N_stat_points - 1) ){
+                    forced_j[apair.first] = apair.second;
+                }
+            }
+
+            // Non-outlier coefficients and stationary outlier coefficients.
+            M_trunc.rows.resize(N_move_points);
+            M_trunc.move_outliers.assign(N_move_points, 0.0);
+            M_trunc.stat_outliers.assign(N_stat_points, 0.0);
+            std::vector<vec3<double>> moved(N_move_points);
+            parallel_for(0, N_move_points, [&](long int i) -> void {
+                const auto P_moved = t.transform(moving.points[i]); // Transform the point.
+                moved[i] = P_moved;
+
+                auto &row = M_trunc.rows[i];
+                row.clear();
+                for(const auto &h : stationary_tree.value().k_nearest(P_moved, max_corr, max_sq_dist)){
+                    row.push_back({ static_cast<long int>(h.index), 0.0 });
+                }
+                if( (0 <= forced_j[i])
+                &&  std::none_of(std::begin(row), std::end(row),
+                                 [&](const truncated_correspondence::coeff_t &c){ return (c.j == forced_j[i]); }) ){
+                    row.push_back({ forced_j[i], 0.0 });
+                }
+                std::sort(std::begin(row), std::end(row),
+                          [](const truncated_correspondence::coeff_t &l, const truncated_correspondence::coeff_t &r){
+                              return (l.j < r.j);
+                          });
+                for(auto &c : row){
+                    const auto dP = stationary.points[c.j] - P_moved;
+                    c.m = (1.0 / T_now)
                         * std::exp(s_reg / T_now)
                         * std::exp( -dP.Dot(dP) / T_now);
+                }
+
+                const auto dP = com_stat - P_moved;
+                M_trunc.move_outliers[i] = (1.0 / T_start)
+                                         * std::exp( -dP.Dot(dP) / T_start);
+            });
+
+            // Moving outlier coefficients.
+            Stats::Running_Sum<double> com_moved_x;
+            Stats::Running_Sum<double> com_moved_y;
+            Stats::Running_Sum<double> com_moved_z;
+            for(const auto &P_moved : moved){
+                com_moved_x.Digest(P_moved.x);
+                com_moved_y.Digest(P_moved.y);
+                com_moved_z.Digest(P_moved.z);
             }
-        }
-        const vec3<double> com_moved( com_moved_x.Current_Sum() / static_cast<double>(N_move_points), 
-                                      com_moved_y.Current_Sum() / static_cast<double>(N_move_points), 
-                                      com_moved_z.Current_Sum() / static_cast<double>(N_move_points) );
+            const vec3<double> com_moved( com_moved_x.Current_Sum() / static_cast<double>(N_move_points), 
+                                          com_moved_y.Current_Sum() / static_cast<double>(N_move_points), 
+                                          com_moved_z.Current_Sum() / static_cast<double>(N_move_points) );
+            parallel_for(0, N_stat_points, [&](long int j) -> void {
+                const auto dP = stationary.points[j] - com_moved; // Note: intentionally not transformed.
+                M_trunc.stat_outliers[j] = (1.0 / T_start)
+                                         * std::exp( -dP.Dot(dP) / T_start);
+            });
 
-        // Moving outlier coefficients.
-        {
-            const auto i = N_move_points; // row
-            const auto& P_moving = com_moved;
-            for(long int j = 0; j < N_stat_points; ++j){ // column
-                const auto P_stationary = stationary.points[j];
-                const auto dP = P_stationary - P_moving; // Note: intentionally not transformed.
+        }else{
+            // Non-outlier coefficients.
+            Stats::Running_Sum<double> com_moved_x;
+            Stats::Running_Sum<double> com_moved_y;
+            Stats::Running_Sum<double> com_moved_z;
+            for(long int i = 0; i < N_move_points; ++i){ // row
+                const auto P_moving = moving.points[i];
+                const auto P_moved = t.transform(P_moving); // Transform the point.
+                com_moved_x.Digest(P_moved.x);
+                com_moved_y.Digest(P_moved.y);
+                com_moved_z.Digest(P_moved.z);
+                for(long int j = 0; j < N_stat_points; ++j){ // column
+                    const auto P_stationary = stationary.points[j];
+                    const auto dP = P_stationary - P_moved;
+                    M(i, j) = (1.0 / T_now)
+                            * std::exp(s_reg / T_now)
+                            * std::exp( -dP.Dot(dP) / T_now);
+                }
+            }
+            const vec3<double> com_moved( com_moved_x.Current_Sum() / static_cast<double>(N_move_points), 
+                                          com_moved_y.Current_Sum() / static_cast<double>(N_move_points), 
+                                          com_moved_z.Current_Sum() / static_cast<double>(N_move_points) );
+
+            // Moving outlier coefficients.
+            {
+                const auto i = N_move_points; // row
+                const auto& P_moving = com_moved;
+                for(long int j = 0; j < N_stat_points; ++j){ // column
+                    const auto P_stationary = stationary.points[j];
+                    const auto dP = P_stationary - P_moving; // Note: intentionally not transformed.
+                    M(i, j) = (1.0 / T_start)
+                            * std::exp( -dP.Dot(dP) / T_start);
+                }
+            }
+
+            // Stationary outlier coefficients.
+            for(long int i = 0; i < N_move_points; ++i){ // row
+                const auto P_moving = moving.points[i];
+                const auto P_moved = t.transform(P_moving); // Transform the point.
+                const auto j = N_stat_points; // column
+                const auto& P_stationary = com_stat;
+                const auto dP = P_stationary - P_moved;
                 M(i, j) = (1.0 / T_start)
                         * std::exp( -dP.Dot(dP) / T_start);
             }
         }
 
-        // Stationary outlier coefficients.
-        for(long int i = 0; i < N_move_points; ++i){ // row
-            const auto P_moving = moving.points[i];
-            const auto P_moved = t.transform(P_moving); // Transform the point.
-            const auto j = N_stat_points; // column
-            const auto& P_stationary = com_stat;
-            const auto dP = P_stationary - P_moved;
-            M(i, j) = (1.0 / T_start)
-                    * std::exp( -dP.Dot(dP) / T_start);
-        }
-
         // Override forced correspondences and disable outlier detection (iff user specifies to do so).
         //
         // Note: Since the Skinhorn normalization procedure only modifies the coefficients via scaling (i.e.,
@@ -716,50 +1293,56 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             double w_last = -1.0; // Used to detect if the method stalls.
             const auto machine_eps = 100.0 * std::sqrt( std::numeric_limits<double>::epsilon() );
             for(long int norm_iter = 0; norm_iter < params.N_Sinkhorn_iters; ++norm_iter){
+                throw_if_cancelled();
 
-                // Tally the current row sums and re-scale the correspondence coefficients.
-                for(long int i = 0; i < N_move_points; ++i){ // row
-                    Stats::Running_Sum<double> rs;
-                    for(long int j = 0; j < (N_stat_points+1); ++j){ // column
-                        rs.Digest( M(i,j) );
-                    }
-                    const auto s = rs.Current_Sum();
-                    if(s < machine_eps){
-                        // Option A: error.
-                        //throw std::runtime_error("Unable to normalize column");
-                        // Option B: forgo normalization.
-                        // This might ruin the transform scaling, but it might also self-correct (n.b. verified below!).
-                        continue;
-                        // Option C: nominate this point as an outlier.
-                        // This may work, but I can't say for sure...
-                        //row_sums[i] += 1.0;
-                        //M(i,N_stat_points) += 1.0;
-                    }
-                    for(long int j = 0; j < (N_stat_points+1); ++j){ // column, intentionally ignoring the outlier coeff.
-                        M(i,j) /= s;
-                    }
-                }
+                if(use_truncation){
+                    M_trunc.normalize(machine_eps);
 
-                // Tally the current column sums and re-scale the correspondence coefficients.
-                for(long int j = 0; j < N_stat_points; ++j){ // column
-                    Stats::Running_Sum<double> rs;
-                    for(long int i = 0; i < (N_move_points+1); ++i){ // row
-                        rs.Digest( M(i,j) );
-                    }
-                    const auto s = rs.Current_Sum();
-                    if(s < machine_eps){
-                        // Option A: error.
-                        //throw std::runtime_error("Unable to normalize row");
-                        // Option B: forgo normalization.
-                        // This might ruin the transform scaling, but it might also self-correct (n.b. verified below!).
-                        continue;
-                        // Option C: nominate this point as an outlier.
-                        // This may work, but I can't say for sure...
-                        //col_sums[j] += 1.0;
-                        //M(N_move_points,j) += 1.0;
+                }else{
+                    // Tally the current row sums and re-scale the correspondence coefficients.
+                    for(long int i = 0; i < N_move_points; ++i){ // row
+                        Stats::Running_Sum<double> rs;
+                        for(long int j = 0; j < (N_stat_points+1); ++j){ // column
+                            rs.Digest( M(i,j) );
+                        }
+                        const auto s = rs.Current_Sum();
+                        if(s < machine_eps){
+                            // Option A: error.
+                            //throw std::runtime_error("Unable to normalize column");
+                            // Option B: forgo normalization.
+                            // This might ruin the transform scaling, but it might also self-correct (n.b. verified below!).
+                            continue;
+                            // Option C: nominate this point as an outlier.
+                            // This may work, but I can't say for sure...
+                            //row_sums[i] += 1.0;
+                            //M(i,N_stat_points) += 1.0;
+                        }
+                        for(long int j = 0; j < (N_stat_points+1); ++j){ // column, intentionally ignoring the outlier coeff.
+                            M(i,j) /= s;
+                        }
                     }
-                    for(long int i = 0; i < (N_move_points+1); ++i){ // row, intentionally ignoring the outlier coeff.
-                        M(i,j) /= s;
+
+                    // Tally the current column sums and re-scale the correspondence coefficients.
+                    for(long int j = 0; j < N_stat_points; ++j){ // column
+                        Stats::Running_Sum<double> rs;
+                        for(long int i = 0; i < (N_move_points+1); ++i){ // row
+                            rs.Digest( M(i,j) );
+                        }
+                        const auto s = rs.Current_Sum();
+                        if(s < machine_eps){
+                            // Option A: error.
+                            //throw std::runtime_error("Unable to normalize row");
+                            // Option B: forgo normalization.
+                            // This might ruin the transform scaling, but it might also self-correct (n.b. verified below!).
+                            continue;
+                            // Option C: nominate this point as an outlier.
+                            // This may work, but I can't say for sure...
+                            //col_sums[j] += 1.0;
+                            //M(N_move_points,j) += 1.0;
+                        }
+                        for(long int i = 0; i < (N_move_points+1); ++i){ // row, intentionally ignoring the outlier coeff.
+                            M(i,j) /= s;
+                        }
                     }
                 }
                 
@@ -794,7 +1377,7 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             }
         }
 
-        if(!M.allFinite()){
+        if( (use_truncation) ? !M_trunc.all_finite() : !M.allFinite() ){
             throw std::runtime_error("Failed to compute coefficient matrix.");
         }
         return;
@@ -802,6 +1385,40 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
 
     // Estimates how the correspondence matrix will binarize when T -> 0.
     const auto update_final_correspondence = [&]() -> void {
+        if(use_truncation){
+            // Note: omitted coefficients are zero, and ties are resolved in favour of the lowest index.
+            for(long int i = 0; i < N_move_points; ++i){ // row
+                double max_coeff = 0.0;
+                long int max_j = -1;
+                for(const auto &c : M_trunc.rows[i]){
+                    if( (max_coeff < c.m) || (max_j < 0) ){
+                        max_coeff = c.m;
+                        max_j = c.j;
+                    }
+                }
+                if( (max_coeff < M_trunc.move_outliers[i]) || (max_j < 0) ){
+                    max_j = N_stat_points;
+                }
+                params.final_move_correspondence.emplace_back( std::make_pair(i, max_j) );
+            }
+
+            std::vector<double> max_coeffs(M_trunc.stat_outliers);
+            std::vector<long int> max_is(N_stat_points, N_move_points);
+            for(long int i = 0; i < N_move_points; ++i){ // row
+                for(const auto &c : M_trunc.rows[i]){
+                    if( (max_coeffs[c.j] < c.m)
+                    ||  ((max_coeffs[c.j] == c.m) && (i < max_is[c.j])) ){
+                        max_coeffs[c.j] = c.m;
+                        max_is[c.j] = i;
+                    }
+                }
+            }
+            for(long int j = 0; j < N_stat_points; ++j){ // column
+                params.final_stat_correspondence.emplace_back( std::make_pair(max_is[j], j) );
+            }
+            return;
+        }
+
         for(long int i = 0; i < N_move_points; ++i){ // row
             double max_coeff = -(std::numeric_limits<double>::infinity());
             long int max_j = -1;
@@ -840,8 +1457,20 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // Update the transformation.
     //
     // Note: This sub-routine solves for the TPS solution using the current correspondence.
+    Eigen::MatrixXd LHS;
+    Eigen::LDLT<Eigen::MatrixXd> LDLT;
+    double LDLT_lambda = std::numeric_limits<double>::quiet_NaN();
     const auto update_transformation = [&](double lambda) -> void {
 
+        // Visits the non-outlier correspondence coefficients for the given moving point.
+        const auto for_each_coeff = [&](long int i, const auto &f) -> void {
+            if(use_truncation){
+                for(const auto &c : M_trunc.rows[i]) f(c.j, c.m);
+            }else{
+                for(long int j = 0; j < N_stat_points; ++j) f(j, M(i,j));
+            }
+        };
+
         // Fill the Y vector with the corresponding points.
         for(long int i = 0; i < N_move_points; ++i){
             double col_sum_inv = std::numeric_limits<double>::quiet_NaN();
@@ -850,9 +1479,9 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
                 //
                 // Note: The 'gutter' term is intentionally omitted here.
                 Stats::Running_Sum<double> col_sum_rs;
-                for(long int j = 0; j < N_stat_points; ++j){ // column
-                    col_sum_rs.Digest( M(i,j) );
-                }
+                for_each_coeff(i, [&](long int, double m_ij) -> void {
+                    col_sum_rs.Digest( m_ij );
+                });
                 col_sum_inv = 1.0 / col_sum_rs.Current_Sum();
                 if(!std::isfinite(col_sum_inv)){
                     // Kludge factor here. Change from inf to 'some big number'.
@@ -860,19 +1489,23 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
                     // TODO: Come up with better way to deal with perfect outliers.
                     col_sum_inv = std::sqrt( std::numeric_limits<double>::max() );
                 }
-                W(i,i) = col_sum_inv;
+                if(use_low_rank){
+                    omega(i) = 1.0 / col_sum_inv;
+                }else{
+                    W(i,i) = col_sum_inv;
+                }
             }
 
             Stats::Running_Sum<double> c_x;
             Stats::Running_Sum<double> c_y;
             Stats::Running_Sum<double> c_z;
-            for(long int j = 0; j < N_stat_points; ++j){ // column
+            for_each_coeff(i, [&](long int j, double m_ij) -> void {
                 const auto P_stationary = stationary.points[j];
 
                 double weight = std::numeric_limits<double>::quiet_NaN();
                 if(params.double_sided_outliers){
                     // 'Double-sided outlier handling' approach from Yang et al (2011).
-                    weight = M(i,j) * col_sum_inv;
+                    weight = m_ij * col_sum_inv;
                     if( !std::isfinite(weight)
                     ||  !isininc(0.0, weight, 1.0) ){
                         throw std::runtime_error("Encountered invalid weight. Is the point cloud degenerate? Refusing to continue.");
@@ -882,14 +1515,14 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
 
                 }else{
                     // Original formulation from Chui and Rangaran.
-                    weight = M(i,j);
+                    weight = m_ij;
                 }
 
                 const auto weighted_P = P_stationary * weight;
                 c_x.Digest(weighted_P.x);
                 c_y.Digest(weighted_P.y);
                 c_z.Digest(weighted_P.z);
-            }
+            });
             Y(i, 0) = c_x.Current_Sum();
             Y(i, 1) = c_y.Current_Sum();
             Y(i, 2) = c_z.Current_Sum();
@@ -922,30 +1555,39 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
 
         // Use LDLT method.
         }else if(params.solution_method == AlignViaTPSRPMParams::SolutionMethod::LDLT){
-            Eigen::MatrixXd LHS;
-            if(std::abs(L_1_start) != 0.0){
-                if(params.double_sided_outliers){
-                    LHS = L + W * lambda; // * static_cast<double>(N_stat_points);
-                    // Note: Yang et al. (2011) suggest scaling lambda by N_stat_points, but this is not done here for
-                    // reasons of parity; the scale of the lambda regularization parameter seems to remain more
-                    // comparable with the original algorithm.
+            // Re-use the factorization from the previous iteration if the system has not changed.
+            const auto effective_lambda = (std::abs(L_1_start) != 0.0) ? lambda : 0.0;
+            if( params.double_sided_outliers
+            ||  (LDLT_lambda != effective_lambda) ){
+                if(std::abs(L_1_start) != 0.0){
+                    if(params.double_sided_outliers){
+                        LHS = L + W * lambda; // * static_cast<double>(N_stat_points);
+                        // Note: Yang et al. (2011) suggest scaling lambda by N_stat_points, but this is not done here
+                        // for reasons of parity; the scale of the lambda regularization parameter seems to remain more
+                        // comparable with the original algorithm.
+                    }else{
+                        LHS = L + I_N4 * lambda; // Regularized version of L.
+                    }
                 }else{
-                    LHS = L + I_N4 * lambda; // Regularized version of L.
+                    LHS = L;
                 }
-            }else{
-                LHS = L;
-            }
-            
-            Eigen::LDLT<Eigen::MatrixXd> LDLT;
-            LDLT.compute(LHS.transpose() * LHS);
-            if(LDLT.info() != Eigen::Success){
-                throw std::runtime_error("Unable to update transformation: LDLT decomposition failed.");
+                
+                LDLT.compute(LHS.transpose() * LHS);
+                if(LDLT.info() != Eigen::Success){
+                    throw std::runtime_error("Unable to update transformation: LDLT decomposition failed.");
+                }
+                LDLT_lambda = effective_lambda;
             }
             
             W_A = LDLT.solve(LHS.transpose() * Y);
             if(LDLT.info() != Eigen::Success){
                 throw std::runtime_error("Unable to update transformation: LDLT solve failed.");
             }
+        // Use the low-rank method.
+        }else if(params.solution_method == AlignViaTPSRPMParams::SolutionMethod::LowRank){
+            const auto effective_lambda = (std::abs(L_1_start) != 0.0) ? lambda : 0.0;
+            reduced.value().solve(effective_lambda, omega, Y.topRows(N_move_points), W_A);
+
         }else{
             throw std::logic_error("Solution method not understood. Cannot continue.");
         }
@@ -965,12 +1607,36 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         // These will approach a binary state (min=0 and max=1) when the temperature is low.
         // Whether these are binary or not fully depends on the temperature, so they can be used to tweak the annealing
         // schedule.
-        const auto mean_row_min_coeff = M.rowwise().minCoeff().sum() / static_cast<double>( M.rows() );
-        const auto mean_row_max_coeff = M.rowwise().maxCoeff().sum() / static_cast<double>( M.rows() );
+        double mean_row_min_coeff = std::numeric_limits<double>::quiet_NaN();
+        double mean_row_max_coeff = std::numeric_limits<double>::quiet_NaN();
+        if(use_truncation){
+            // Note: omitted coefficients are zero, as are the bottom-right coefficient.
+            Stats::Running_Sum<double> rs_min;
+            Stats::Running_Sum<double> rs_max;
+            for(long int i = 0; i < N_move_points; ++i){
+                const auto &row = M_trunc.rows[i];
+                double min_coeff = M_trunc.move_outliers[i];
+                double max_coeff = M_trunc.move_outliers[i];
+                if(static_cast<long int>(row.size()) < N_stat_points) min_coeff = 0.0;
+                for(const auto &c : row){
+                    min_coeff = std::min(min_coeff, c.m);
+                    max_coeff = std::max(max_coeff, c.m);
+                }
+                rs_min.Digest(min_coeff);
+                rs_max.Digest(max_coeff);
+            }
+            rs_max.Digest( *std::max_element(std::begin(M_trunc.stat_outliers), std::end(M_trunc.stat_outliers)) );
+            mean_row_min_coeff = rs_min.Current_Sum() / static_cast<double>(N_move_points + 1);
+            mean_row_max_coeff = rs_max.Current_Sum() / static_cast<double>(N_move_points + 1);
+        }else{
+            mean_row_min_coeff = M.rowwise().minCoeff().sum() / static_cast<double>( M.rows() );
+            mean_row_max_coeff = M.rowwise().maxCoeff().sum() / static_cast<double>( M.rows() );
+        }
 
         FUNCINFO("Optimizer state: T = " << std::setw(12) << T_now 
                    << ", mean min,max corr coeffs = " << std::setw(12) << mean_row_min_coeff
-                   << ", " << std::setw(12) << mean_row_max_coeff );
+                   << ", " << std::setw(12) << mean_row_max_coeff 
+                   << ( (use_truncation) ? ", retained corr coeffs = " + std::to_string(M_trunc.nonzeros()) : "" ) );
         return;
     };
 
@@ -988,15 +1654,17 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     const auto estimate_bending_energies = [&]() -> bending_energies {
 
         // Compute (approximate) bending energy.
-        const auto E_x = (  W_A.block(0,0, N_move_points,1).transpose()
-                            * L.block(0,0, N_move_points,N_move_points) 
-                            * W_A.block(0,0, N_move_points,1) ).sum();
-        const auto E_y = (  W_A.block(0,1, N_move_points,1).transpose()
-                            * L.block(0,0, N_move_points,N_move_points) 
-                            * W_A.block(0,1, N_move_points,1) ).sum();
-        const auto E_z = (  W_A.block(0,2, N_move_points,1).transpose()
-                            * L.block(0,0, N_move_points,N_move_points) 
-                            * W_A.block(0,2, N_move_points,1) ).sum();
+        const auto K = (use_low_rank) ? reduced.value().control_point_kernel()
+                                      : Eigen::MatrixXd( L.block(0,0, N_move_points,N_move_points) );
+        const auto E_x = (  W_A.block(0,0, N_ctrl_points,1).transpose()
+                            * K
+                            * W_A.block(0,0, N_ctrl_points,1) ).sum();
+        const auto E_y = (  W_A.block(0,1, N_ctrl_points,1).transpose()
+                            * K
+                            * W_A.block(0,1, N_ctrl_points,1) ).sum();
+        const auto E_z = (  W_A.block(0,2, N_ctrl_points,1).transpose()
+                            * K
+                            * W_A.block(0,2, N_ctrl_points,1) ).sum();
         return bending_energies{ E_x, E_y, E_z };
     };
 
@@ -1016,7 +1684,9 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
 */
 
     // Anneal deterministically.
-    for(double T_now = T_start; T_now >= T_end; T_now *= params.T_step){
+    for(double T_now = T_anneal_start; T_now >= T_end; T_now *= params.T_step){
+        params.final_T = T_now;
+
         // Regularization parameter: controls how smooth the TPS interpolation is.
         const double L_1 = T_now * L_1_start;
 
@@ -1025,6 +1695,7 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         const double L_2 = T_now * L_2_start;
 
         for(long int iter_at_fixed_T = 0; iter_at_fixed_T < params.N_iters_at_fixed_T; ++iter_at_fixed_T){
+            throw_if_cancelled();
 
             // Update correspondence matrix.
             //
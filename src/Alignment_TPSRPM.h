@@ -2,8 +2,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <optional>
+#include <limits>
 #include <iosfwd>
+#include <vector>
 
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -27,7 +30,13 @@ class thin_plate_spline {
         double eval_kernel(const double &dist) const;
 
         vec3<double> transform(const vec3<double> &v) const;
+
+        // Transforms many points in parallel. Control points are evaluated in blocks stored contiguously, so this is
+        // considerably faster than transforming points individually. Results agree with transform() to within
+        // floating-point rounding.
+        void apply_to(std::vector<vec3<double>> &vs) const;
         void apply_to(point_set<double> &ps) const;
+        void apply_to(fv_surface_mesh<double, uint64_t> &mesh) const;
 
         // Serialize and deserialize to a human- and machine-readable format.
         bool write_to( std::ostream &os ) const;
@@ -55,12 +64,19 @@ struct AlignViaTPSParams {
 
     // The method used to solve the system of linear equtions that defines the thin plate spline solution.
     // The pseudoinverse will likely be able to provide a solution when the system is degenerate, but it might not be
-    // reasonable.
+    // reasonable. The low-rank method places kernels at a well-spread subset of the moving points and fits the
+    // coefficients to all points in the least-squares sense, so it scales to large point sets, but points are no
+    // longer interpolated exactly.
     enum class SolutionMethod {
         PseudoInverse,
-        LDLT
+        LDLT,
+        LowRank
     };
     SolutionMethod solution_method = SolutionMethod::LDLT;
+
+    // The maximum number of control points used by the low-rank solution method. Memory scales linearly and time
+    // cubically with this number.
+    long int low_rank_control_points = 1000;
 };
 
 std::optional<thin_plate_spline>
@@ -141,13 +157,39 @@ struct AlignViaTPSRPMParams {
     //
     // The method used to solve the system of linear equtions that defines the thin plate spline solution.
     // The pseudoinverse will likely be able to provide a solution when the system is degenerate, but it might not be
-    // reasonable.
+    // reasonable. The low-rank method places kernels at a well-spread subset of the moving points and fits the
+    // coefficients to all points in the least-squares sense, so it scales to large point sets.
+    //
+    // Note: factorizations are reused across iterations whenever the regularization does not change (e.g., at a fixed
+    // temperature, or throughout when lambda_start is zero) unless double-sided outlier handling is used.
     enum class SolutionMethod {
         PseudoInverse,
-        LDLT
+        LDLT,
+        LowRank
     };
     SolutionMethod solution_method = SolutionMethod::LDLT;
 
+    // The maximum number of control points used by the low-rank solution method. Memory scales linearly and time
+    // cubically with this number.
+    long int low_rank_control_points = 1000;
+
+    // Correspondence truncation parameters.
+    //
+    // Correspondence coefficients decay like exp(-d^2/T) with the separation d between points, so at all but the
+    // highest temperatures most are negligible. When truncation is enabled, the correspondence matrix is stored
+    // sparsely: for each moving point, only the nearest 'max_correspondences' stationary points within a
+    // temperature-dependent radius are retained. The radius is chosen so that discarded coefficients are smaller
+    // than 'truncation_tolerance' relative to the coefficient for coincident points. Memory then scales like
+    // N_move * max_correspondences rather than N_move * N_stat, and the correspondence update is computed in
+    // parallel.
+    //
+    // Note: truncation is an approximation. Retaining too few correspondences may impede large-scale deformations
+    //       at high temperatures, and stationary points that are not retained by any moving point at a given
+    //       temperature are necessarily treated as outliers.
+    bool truncate_correspondence = false;
+    long int max_correspondences = 100;
+    double truncation_tolerance = 1E-8;
+
     // Algorithm-altering parameters.
     //
     // Seed the initial transformation with the result of a rigid centroid-to-centroid shift transformation. The default
@@ -157,6 +199,18 @@ struct AlignViaTPSRPMParams {
     // computation.
     bool seed_with_centroid_shift = false;
 
+    // Seed the initial transformation with an existing transformation, e.g., from a registration of decimated copies
+    // of the point sets. The seed is re-expressed using the moving points as control points by interpolating its
+    // mapping of the moving points. When provided, the centroid shift seed is not used.
+    std::optional<thin_plate_spline> seed_transform;
+
+    // Begin annealing at this absolute temperature instead of the temperature derived from T_start_scale. This is
+    // useful when a seed transformation already accounts for the global alignment. At least one annealing step is
+    // always performed. Ignored unless finite and positive.
+    //
+    // Note that outlier coefficients are always derived from T_start_scale.
+    double T_start_override = std::numeric_limits<double>::quiet_NaN();
+
     // Correspondence parameters.
     //
     // Point-pairs that are forced to correspond. Indices are zero-based. The first index refers to the moving set, and
@@ -179,6 +233,9 @@ struct AlignViaTPSRPMParams {
     std::vector< std::pair<long int, long int> > final_move_correspondence; // moving point index -> stat point index.
     std::vector< std::pair<long int, long int> > final_stat_correspondence; // ALSO moving point index -> stat point index.
 
+    // The temperature of the final annealing step.
+    double final_T = std::numeric_limits<double>::quiet_NaN();
+
 };
 
 std::optional<thin_plate_spline>
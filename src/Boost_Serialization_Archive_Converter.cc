@@ -52,6 +52,9 @@ int main(int argc, char* argv[]){
     drover_serial_func_name_mapping["txt"] = Common_Boost_Serialize_Drover_to_Simple_Text;
     drover_serial_func_name_mapping["xml"] = Common_Boost_Serialize_Drover_to_XML;
 
+    drover_serial_func_name_mapping["native"] = Common_Boost_Serialize_Drover_to_Native_Archive;
+    drover_serial_func_name_mapping["native-compressed"] = Common_Boost_Serialize_Drover_to_Compressed_Native_Archive;
+
     Drover DICOM_data;
 
     
@@ -75,7 +78,11 @@ int main(int argc, char* argv[]){
                        { "-i file.xml.gz -o file.bin -t 'binary'",
                          "Convert to a binary file." },
                        { "-i file.xml.gz -o file.bin.gz -t 'gzip-binary'",
-                         "Convert to a gzipped binary file." }
+                         "Convert to a gzipped binary file." },
+                       { "-i file.xml.gz -o file.dcma -t 'native'",
+                         "Convert to a native archive, which loads quickly but is not portable." },
+                       { "-i file.xml.gz -o file.dcma -t 'native-compressed'",
+                         "Convert to a native archive with compressed voxel data." }
                      };
     arger.description = "A program for converting Boost.Serialization archives types which DICOMautomaton can read.";
 
@@ -105,7 +112,7 @@ int main(int argc, char* argv[]){
     );
 
     arger.push_back( ygor_arg_handlr_t(2, 't', "output-type", true, ConvertTo,
-      "The format to convert to. Supported: gzip-binary, gzip-txt, gzip-xml, binary, txt, xml.",
+      "The format to convert to. Supported: gzip-binary, gzip-txt, gzip-xml, binary, txt, xml, native, native-compressed.",
       [&](const std::string &optarg) -> void {
         ConvertTo = optarg;
         return;
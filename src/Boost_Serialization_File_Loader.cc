@@ -11,11 +11,22 @@
 #include "Common_Boost_Serialization.h"
 #include "Structs.h"
 
+#include "Boost_Serialization_File_Loader.h"
+
 
 bool Load_From_Boost_Serialization_Files( Drover &DICOM_data,
-                                          std::map<std::string,std::string> & /* InvocationMetadata */,
-                                          const std::string & /* FilenameLex */,
+                                          std::map<std::string,std::string> &InvocationMetadata,
+                                          const std::string &FilenameLex,
                                           std::list<boost::filesystem::path> &Filenames ){
+    return Load_Selected_From_Boost_Serialization_Files(DICOM_data, InvocationMetadata, FilenameLex, Filenames,
+                                                        drover_archive_selection());
+}
+
+bool Load_Selected_From_Boost_Serialization_Files( Drover &DICOM_data,
+                                                   std::map<std::string,std::string> & /* InvocationMetadata */,
+                                                   const std::string & /* FilenameLex */,
+                                                   std::list<boost::filesystem::path> &Filenames,
+                                                   const drover_archive_selection &selection ){
 
     //This routine will attempt to load boost.serialized files. Files that are not successfully loaded are not consumed
     // so that they can be passed on to the next loading stage as needed. 
@@ -30,7 +41,7 @@ bool Load_From_Boost_Serialization_Files( Drover &DICOM_data,
     for(const auto &fn : Filenames_Copy){
 
         Drover A;
-        const bool res = Common_Boost_Deserialize_Drover(A, fn);
+        const bool res = Common_Boost_Deserialize_Drover(A, fn, selection);
         if(res){
 
             //Concatenate loaded data to the existing data.
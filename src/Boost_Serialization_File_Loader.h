@@ -9,8 +9,16 @@
 #include <boost/filesystem.hpp>
 
 #include "Structs.h"
+#include "Common_Boost_Serialization.h"
 
 bool Load_From_Boost_Serialization_Files( Drover &DICOM_data,
                                           std::map<std::string,std::string> &InvocationMetadata,
                                           const std::string &FilenameLex,
                                           std::list<boost::filesystem::path> &Filenames );
+
+// Loads only the selected components from each archive.
+bool Load_Selected_From_Boost_Serialization_Files( Drover &DICOM_data,
+                                                   std::map<std::string,std::string> &InvocationMetadata,
+                                                   const std::string &FilenameLex,
+                                                   std::list<boost::filesystem::path> &Filenames,
+                                                   const drover_archive_selection &selection );
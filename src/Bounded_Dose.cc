@@ -0,0 +1,285 @@
+//Bounded_Dose.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Structs.h"
+#include "Dose_Meld.h"
+#include "Packed_Contours.h"
+#include "Thread_Pool.h"
+
+#include "Bounded_Dose.h"
+
+
+namespace {
+
+constexpr long int N_moment_orders = 5;
+constexpr long int N_moments = N_moment_orders * N_moment_orders * N_moment_orders;
+
+// A contour reduced to what is needed to test voxel inclusion, so the point lists are traversed only once.
+struct prepared_contour {
+    vec3<double> avg; // A point at the height of the contour, used to find the images it intersects.
+    double min_x;
+    double max_x;
+    double min_y;
+    double max_y;
+    std::vector<double> xs;
+    std::vector<double> ys;
+};
+
+struct prepared_roi {
+    std::vector<prepared_contour> contours;
+    vec3<double> centroid;
+};
+
+prepared_roi prepare_roi(const contour_collection<double> &cc, bool need_centroid){
+    prepared_roi out;
+    for(const auto &c : cc.contours){
+        if(c.points.size() < 3) continue;
+
+        prepared_contour pc;
+        pc.avg = c.First_N_Point_Avg(3);
+        pc.xs.reserve(c.points.size());
+        pc.ys.reserve(c.points.size());
+        for(const auto &p : c.points){
+            pc.xs.push_back(p.x);
+            pc.ys.push_back(p.y);
+        }
+        const auto [min_x, max_x] = std::minmax_element(std::begin(pc.xs), std::end(pc.xs));
+        const auto [min_y, max_y] = std::minmax_element(std::begin(pc.ys), std::end(pc.ys));
+        pc.min_x = *min_x;
+        pc.max_x = *max_x;
+        pc.min_y = *min_y;
+        pc.max_y = *max_y;
+        out.contours.push_back(std::move(pc));
+    }
+    if(need_centroid) out.centroid = cc.Centroid();
+    return out;
+}
+
+// The contribution of a single image to a single contour collection.
+struct partial_result {
+    std::vector<double> doses;
+    std::vector<bnded_dose_pos_dose_tup_t> voxels;
+    std::vector<double> moments;
+    int64_t sum = 0;
+    int64_t count = 0;
+    double min = 1E99;
+    double max = -1E99;
+};
+
+void visit_image(const planar_image<float,double> &image,
+                 const prepared_roi &roi,
+                 const bounded_dose_opts &opts,
+                 partial_result &out){
+    if(opts.moments) out.moments.assign(N_moments, 0.0);
+    const auto grid_factor = image.pxl_dx * image.pxl_dy * image.pxl_dz;
+    const vec3<double> r_dx = image.row_unit * image.pxl_dx * 0.5;
+    const vec3<double> r_dy = image.col_unit * image.pxl_dy * 0.5;
+
+    for(const auto &c : roi.contours){
+        if(!image.sandwiches_point_within_top_bottom_planes(c.avg)) continue;
+
+        for(long int i = 0; i < image.rows; ++i){
+            for(long int j = 0; j < image.columns; ++j){
+                const auto pos = image.position(i, j);
+                if( (pos.x < c.min_x) || (c.max_x < pos.x)
+                ||  (pos.y < c.min_y) || (c.max_y < pos.y) ) continue;
+                if(!Point_In_Projected_Contour(c.xs, c.ys, pos.x, pos.y)) continue;
+
+                // Greyscale or R channel. We assume the channels satisfy: R = G = B.
+                const auto pointval = static_cast<int64_t>(image.value(i, j, 0));
+                const auto pointdose = static_cast<double>(pointval);
+
+                out.sum += pointval;
+                out.count += 1;
+                out.min = std::min(out.min, pointdose);
+                out.max = std::max(out.max, pointdose);
+                if(opts.doses || !opts.quantiles.empty()) out.doses.push_back(pointdose);
+
+                if(opts.selector){
+                    auto tup = std::make_tuple(pos, r_dx, r_dy, pointdose, i, j);
+                    if(opts.selector(tup)) out.voxels.push_back(std::move(tup));
+                }
+
+                if(opts.moments){
+                    std::array<double, N_moment_orders> px, py, pz;
+                    px[0] = py[0] = pz[0] = 1.0;
+                    for(long int k = 1; k < N_moment_orders; ++k){
+                        px[k] = px[k-1] * (pos.x - roi.centroid.x);
+                        py[k] = py[k-1] * (pos.y - roi.centroid.y);
+                        pz[k] = pz[k-1] * (pos.z - roi.centroid.z);
+                    }
+                    const auto w = pointdose * grid_factor;
+                    double *m = out.moments.data();
+                    for(long int p = 0; p < N_moment_orders; ++p){
+                        for(long int q = 0; q < N_moment_orders; ++q){
+                            for(long int r = 0; r < N_moment_orders; ++r){
+                                *(m++) += px[p] * py[q] * pz[r] * w;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return;
+}
+
+} // namespace
+
+
+std::vector<double> Dose_Quantiles(std::vector<double> &values, const std::vector<double> &fractions){
+    std::vector<double> out(fractions.size(), std::numeric_limits<double>::quiet_NaN());
+    for(const auto &f : fractions){
+        if(!std::isfinite(f) || (f < 0.0) || (1.0 < f)){
+            throw std::invalid_argument("Quantile fractions must be within [0:1].");
+        }
+    }
+    const auto N = values.size();
+    if(N == 0) return out;
+
+    // Evaluate in ascending order so each selection only needs to partition the values above the previous one.
+    std::vector<size_t> order(fractions.size());
+    std::iota(std::begin(order), std::end(order), 0);
+    std::sort(std::begin(order), std::end(order), [&](size_t l, size_t r){ return (fractions[l] < fractions[r]); });
+
+    auto first = std::begin(values);
+    size_t k_selected = 0;
+    bool have_selected = false;
+    for(const auto i : order){
+        const double pos = fractions[i] * static_cast<double>(N - 1);
+        const auto k = std::min(static_cast<size_t>(std::floor(pos)), N - 1);
+        const double t = pos - static_cast<double>(k);
+
+        if(!have_selected || (k != k_selected)){
+            const auto nth = std::next(std::begin(values), k);
+            std::nth_element(first, nth, std::end(values));
+            first = std::next(nth);
+            k_selected = k;
+            have_selected = true;
+        }
+        const double lo = values[k];
+        const double hi = ((t <= 0.0) || ((k + 1) == N)) ? lo : *std::min_element(first, std::end(values));
+        out[i] = lo + t * (hi - lo);
+    }
+    return out;
+}
+
+
+const bounded_dose_roi *bounded_dose_results::find(const contour_collection<double> &cc) const {
+    const auto it = this->index.find(&cc);
+    return (it == std::end(this->index)) ? nullptr : &(this->rois.at(it->second));
+}
+
+
+bounded_dose_results Compute_Bounded_Dose(const Drover &DICOM_data, const bounded_dose_opts &opts){
+    std::vector<double> ignored;
+    Dose_Quantiles(ignored, opts.quantiles); // Validates the fractions before any work is done.
+
+    auto d = Isolate_Dose_Data(DICOM_data);
+    if(!d.Has_Contour_Data() || !d.Has_Image_Data()){
+        throw std::invalid_argument("Attempted to use bounded dose routine, but we do not have contours and/or dose");
+    }
+
+    // Only meld when needed. Moments, for instance, probably don't need to be melded.
+    std::list<std::shared_ptr<Image_Array>> dose_data_to_use(d.image_data);
+    if(opts.min_max && (dose_data_to_use.size() > 1)){
+        dose_data_to_use = Meld_Image_Data(d.image_data);
+        if(dose_data_to_use.size() != 1){
+            throw std::runtime_error("This routine cannot handle multiple dose data which cannot be melded");
+        }
+    }
+
+    bounded_dose_results out;
+    std::vector<std::reference_wrapper<const contour_collection<double>>> ccs;
+    for(const auto &cc : DICOM_data.contour_data->ccs){
+        out.index[&cc] = ccs.size();
+        ccs.emplace_back(std::cref(cc));
+    }
+    const auto N_ccs = static_cast<long int>(ccs.size());
+    out.rois.resize(N_ccs);
+
+    std::vector<prepared_roi> rois(N_ccs);
+    parallel_for(0, N_ccs, [&](long int c){
+        rois[c] = prepare_roi(ccs[c].get(), opts.moments);
+    }, 1);
+
+    // Every image, tagged with the dose array it belongs to, so the per-array means can be recovered.
+    std::vector<std::pair<long int, std::reference_wrapper<const planar_image<float,double>>>> images;
+    long int N_arrays = 0;
+    for(const auto &dd : dose_data_to_use){
+        for(const auto &img : dd->imagecoll.images) images.emplace_back(N_arrays, std::cref(img));
+        ++N_arrays;
+    }
+    const auto N_images = static_cast<long int>(images.size());
+
+    std::vector<partial_result> partials(N_images * N_ccs);
+    parallel_for(0, N_images * N_ccs, [&](long int t){
+        const auto n = t / N_ccs;
+        const auto c = t % N_ccs;
+        visit_image(images[n].second.get(), rois[c], opts, partials[t]);
+    }, 1);
+
+    // Combine in image order so the results are deterministic.
+    parallel_for(0, N_ccs, [&](long int c){
+        auto &roi = out.rois[c];
+        if(opts.moments) roi.moments.assign(N_moments, 0.0);
+
+        size_t N_doses = 0;
+        size_t N_voxels = 0;
+        for(long int n = 0; n < N_images; ++n){
+            N_doses += partials[n * N_ccs + c].doses.size();
+            N_voxels += partials[n * N_ccs + c].voxels.size();
+        }
+        roi.doses.reserve(N_doses);
+        roi.voxels.reserve(N_voxels);
+
+        std::vector<std::pair<int64_t, int64_t>> accumulated(N_arrays, { 0, 0 }); // Total dose and number of voxels.
+        for(long int n = 0; n < N_images; ++n){
+            auto &p = partials[n * N_ccs + c];
+            accumulated[images[n].first].first += p.sum;
+            accumulated[images[n].first].second += p.count;
+            roi.count += p.count;
+            roi.min = std::min(roi.min, p.min);
+            roi.max = std::max(roi.max, p.max);
+            roi.doses.insert(std::end(roi.doses), std::begin(p.doses), std::end(p.doses));
+            std::move(std::begin(p.voxels), std::end(p.voxels), std::back_inserter(roi.voxels));
+            for(size_t k = 0; k < p.moments.size(); ++k) roi.moments[k] += p.moments[k];
+        }
+
+        for(const auto &a : accumulated){
+            if(a.second == 0) continue;
+            roi.mean += static_cast<double>(a.first) / static_cast<double>(a.second);
+        }
+
+        if(!opts.quantiles.empty()){
+            if(opts.doses){
+                auto scratch = roi.doses;
+                roi.quantiles = Dose_Quantiles(scratch, opts.quantiles);
+            }else{
+                roi.quantiles = Dose_Quantiles(roi.doses, opts.quantiles);
+                roi.doses = std::vector<double>();
+            }
+        }
+    }, 1);
+
+    return out;
+}
@@ -0,0 +1,62 @@
+//Bounded_Dose.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Structs.h"
+
+
+// Selects which quantities are computed for the voxels bounded by each contour collection.
+struct bounded_dose_opts {
+    bool doses   = false; // Retain every bounded voxel's dose.
+    bool mean    = false;
+    bool min_max = false; // Multiple dose arrays are melded first, if possible.
+    bool moments = false; // Dose-weighted spatial moments, centralized on each contour collection's centroid.
+
+    // Fractions in [0:1] of the voxel dose distribution to evaluate, e.g., 0.5 for the median. See Dose_Quantiles().
+    std::vector<double> quantiles;
+
+    // When provided, bounded voxels for which this returns true are retained along with their positions.
+    // Voxels are visited concurrently, so the selector must be safe to call from multiple threads.
+    std::function<bool(const bnded_dose_pos_dose_tup_t &)> selector;
+};
+
+struct bounded_dose_roi {
+    std::vector<double> doses;                      // In the order the voxels were visited.
+    std::vector<bnded_dose_pos_dose_tup_t> voxels;  // Selected voxels, in the order they were visited.
+    std::vector<double> moments;                    // Indexed as [25*p + 5*q + r] for p, q, r in [0:4].
+    std::vector<double> quantiles;                  // In the order requested. NaN if no voxels are bounded.
+
+    int64_t count = 0;   // Number of bounded voxels, summed over all dose arrays.
+    double mean = 0.0;   // The per-dose-array means, summed.
+    double min = 1E99;
+    double max = -1E99;
+};
+
+struct bounded_dose_results {
+    std::vector<bounded_dose_roi> rois; // One per contour collection, in the order of the Drover's contour data.
+    std::unordered_map<const contour_collection<double> *, size_t> index; // Maps contour collections to rois.
+
+    const bounded_dose_roi *find(const contour_collection<double> &cc) const;
+};
+
+// Evaluates the given quantiles of the values, interpolating linearly between order statistics, so the 0.5 quantile
+// of an even number of values is the mean of the middle pair. Selection is used instead of sorting, so the cost is
+// roughly linear in the number of values for a handful of quantiles. The values are reordered.
+std::vector<double> Dose_Quantiles(std::vector<double> &values, const std::vector<double> &fractions);
+
+// Visits the dose voxels bounded by every contour collection and computes all requested quantities in a single pass.
+//
+// A voxel is bounded by a contour if its centre lies within the contour's projection onto the image plane and the
+// contour lies between the image's top and bottom planes. Voxels bounded by several contours of the same collection
+// are visited once per contour. Voxel values are truncated to integers, as the legacy Drover routines did.
+//
+// Image-collection pairs are processed in parallel, and the partial results are combined in a fixed order so the
+// results do not depend on scheduling.
+bounded_dose_results Compute_Bounded_Dose(const Drover &DICOM_data, const bounded_dose_opts &opts);
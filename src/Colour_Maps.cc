@@ -1,6 +1,14 @@
 //Colour_Maps.cc - A part of DICOMautomaton 2017. Written by hal clark.
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 
 #include "Colour_Maps.h"
@@ -16950,6 +16958,86 @@ ClampedColourRGB ColourMap_Composite_50_90_100_107_110(double y){
     return out;
 }
 
+ColourMapLUT::ColourMapLUT(const std::function<ClampedColourRGB(double)> &colour_map){
+    this->colours.reserve(N_entries);
+    this->colours_rgb8.reserve(N_entries);
+    const auto dest_type_max = static_cast<double>(std::numeric_limits<uint8_t>::max());
+    const auto to_rgb8 = [dest_type_max](double x) -> uint8_t {
+        return static_cast<uint8_t>( std::clamp(std::floor(x * dest_type_max), 0.0, dest_type_max) );
+    };
+    for(size_t i = 0; i < N_entries; ++i){
+        const auto res = colour_map( static_cast<double>(i) / static_cast<double>(N_entries - 1) );
+        this->colours.push_back(res);
+        this->colours_rgb8.push_back( {{ to_rgb8(res.R), to_rgb8(res.G), to_rgb8(res.B) }} );
+    }
+}
+
+size_t ColourMapLUT::index(double y) const {
+    if(!(0.0 < y)) return 0; // Also handles NaNs.
+    if(!(y < 1.0)) return N_entries - 1;
+    return static_cast<size_t>(y * static_cast<double>(N_entries - 1) + 0.5);
+}
+
+ClampedColourRGB ColourMapLUT::Lookup(double y) const {
+    return this->colours[this->index(y)];
+}
+
+std::array<uint8_t,3> ColourMapLUT::Lookup_RGB8(double y) const {
+    return this->colours_rgb8[this->index(y)];
+}
+
+void ColourMapLUT::Apply_RGB8(const float *values,
+                              size_t N,
+                              std::ptrdiff_t stride,
+                              double low,
+                              double high,
+                              const std::array<uint8_t,3> &non_finite,
+                              uint8_t *rgb_out) const {
+    // Indices are computed a block at a time in a branch-free loop that the compiler can vectorize, and then
+    // gathered from the table.
+    const float f_low = static_cast<float>(low);
+    const float f_scale = static_cast<float>( static_cast<double>(N_entries - 1) / (high - low) );
+    const bool degenerate = !(low < high) || !std::isfinite(f_low) || !std::isfinite(f_scale);
+    const float f_max = static_cast<float>(N_entries - 1);
+
+    constexpr size_t block_size = 256;
+    std::array<int32_t, block_size> indices;
+    for(size_t b = 0; b < N; b += block_size){
+        const size_t n = std::min(block_size, N - b);
+        const float *v = values + static_cast<std::ptrdiff_t>(b) * stride;
+        for(size_t i = 0; i < n; ++i){
+            const float x = v[static_cast<std::ptrdiff_t>(i) * stride];
+            float t = degenerate ? ((f_low < x) ? f_max : 0.0f)
+                                 : (x - f_low) * f_scale + 0.5f;
+            t = (t < 0.0f) ? 0.0f : t;
+            t = (f_max < t) ? f_max : t;
+            indices[i] = std::isfinite(x) ? static_cast<int32_t>(t) : -1;
+        }
+        for(size_t i = 0; i < n; ++i){
+            const auto &c = (indices[i] < 0) ? non_finite : this->colours_rgb8[indices[i]];
+            uint8_t *out = rgb_out + 3 * (b + i);
+            out[0] = c[0];
+            out[1] = c[1];
+            out[2] = c[2];
+        }
+    }
+    return;
+}
+
+std::shared_ptr<const ColourMapLUT> ColourMap_LUT(const std::function<ClampedColourRGB(double)> &colour_map){
+    using colour_map_fn_t = ClampedColourRGB(*)(double);
+    const auto *fn = colour_map.target<colour_map_fn_t>();
+    if(fn == nullptr) return std::make_shared<const ColourMapLUT>(colour_map); // Cannot be identified, so not cached.
+
+    static std::mutex m;
+    static std::map<colour_map_fn_t, std::shared_ptr<const ColourMapLUT>> cache;
+
+    std::lock_guard<std::mutex> lock(m);
+    auto &lut = cache[*fn];
+    if(!lut) lut = std::make_shared<const ColourMapLUT>(colour_map);
+    return lut;
+}
+
 /*
 //Note: prototype for above functions:
 
@@ -2,8 +2,14 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 
 struct ClampedColourRGB {
@@ -43,6 +49,43 @@ ClampedColourRGB ColourMap_YgorIncandescent(double y);
 ClampedColourRGB ColourMap_Composite_50_90_107_110(double y);
 ClampedColourRGB ColourMap_Composite_50_90_100_107_110(double y);
 
+//A colour map sampled at fixed, evenly-spaced points so that colouring becomes a table lookup.
+//
+// Lookups use the nearest sample, so the error relative to the underlying map is at most half the sample spacing.
+// Colours are also stored as 8-bit channels, each computed as floor(255 * channel).
+class ColourMapLUT {
+    public:
+        static constexpr size_t N_entries = 4096;
+
+        explicit ColourMapLUT(const std::function<ClampedColourRGB(double)> &colour_map);
+
+        //These take an input in [0,1], clamping if needed. NaNs map to the first entry.
+        ClampedColourRGB Lookup(double y) const;
+        std::array<uint8_t,3> Lookup_RGB8(double y) const;
+
+        //Colours N values, reading every 'stride'-th value and writing packed 8-bit RGB triplets. Values are mapped
+        // from [low,high] to [0,1] with clamping. If high <= low, values are mapped to either end of the table
+        // depending on whether they exceed low. Non-finite values receive the given colour.
+        void Apply_RGB8(const float *values,
+                        size_t N,
+                        std::ptrdiff_t stride,
+                        double low,
+                        double high,
+                        const std::array<uint8_t,3> &non_finite,
+                        uint8_t *rgb_out) const;
+
+    private:
+        std::vector<ClampedColourRGB> colours;
+        std::vector<std::array<uint8_t,3>> colours_rgb8;
+
+        size_t index(double y) const;
+};
+
+//Provides a shared table for the colour map. Tables for plain functions (e.g., the ColourMap_* functions above) are
+// generated once and reused, so this is cheap to call repeatedly. This function is thread-safe.
+std::shared_ptr<const ColourMapLUT> ColourMap_LUT(const std::function<ClampedColourRGB(double)> &colour_map);
+
+
 //This function takes a named colour and map it to a colour specified in terms of R,G,B all within [0,1].
 std::optional<ClampedColourRGB> Colour_from_name(const std::string& n);
 
@@ -14,17 +14,44 @@
 #include <boost/archive/xml_oarchive.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
-//#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/stream.hpp>
 #include <boost/math/special_functions/nonfinite_num_facets.hpp>
 #include <boost/serialization/nvp.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
 #include <string>    
+#include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
 
 #include "Common_Boost_Serialization.h"
+#include "Content_Hash.h"
+#include "Native_Contour_Codec.h"
 //#include "YgorMathChebyshevIOBoostSerialization.h"
 
 #ifdef DCMA_USE_GNU_GSL
@@ -35,6 +62,7 @@
 
 #include "Structs.h"
 #include "StructsIOBoostSerialization.h"
+#include "Thread_Pool.h"
 
 namespace boost {
 namespace iostreams {
@@ -43,6 +71,108 @@ struct output;
 }  // namespace boost
 
 
+namespace {
+
+// Decompresses a gzipped file in a separate thread, so decompression overlaps with parsing of the archive.
+//
+// Decompressed data is handed over in fixed-size chunks through a bounded queue. Errors encountered while decompressing
+// are reported to the reader as an input failure.
+class pipelined_gzip_streambuf : public std::streambuf {
+  private:
+    static constexpr size_t chunk_size = 1024 * 1024;
+    static constexpr size_t max_chunks = 4;
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::string> chunks;
+    bool done = false;      // The producer has finished, successfully or not.
+    bool failed = false;
+    bool abandoned = false; // The reader has stopped reading.
+    std::string current;
+    std::thread producer;
+
+    void produce(const std::string &filename){
+        try{
+            std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+            boost::iostreams::filtering_istream is;
+            is.push(boost::iostreams::gzip_decompressor());
+            is.push(ifs);
+            while(true){
+                std::string chunk(chunk_size, '\0');
+                is.read(&chunk[0], static_cast<std::streamsize>(chunk.size()));
+                chunk.resize(static_cast<size_t>(is.gcount()));
+                if(!chunk.empty()){
+                    std::unique_lock<std::mutex> lock(this->m);
+                    this->cv.wait(lock, [&](){ return this->abandoned || (this->chunks.size() < max_chunks); });
+                    if(this->abandoned) break;
+                    this->chunks.emplace_back(std::move(chunk));
+                    this->cv.notify_all();
+                }
+                if(!is){
+                    if(!is.eof()) throw std::runtime_error("Unable to decompress file");
+                    break;
+                }
+            }
+        }catch(const std::exception &){
+            std::lock_guard<std::mutex> lock(this->m);
+            this->failed = true;
+        }
+        std::lock_guard<std::mutex> lock(this->m);
+        this->done = true;
+        this->cv.notify_all();
+        return;
+    }
+
+  protected:
+    int_type underflow() override {
+        if(this->gptr() < this->egptr()) return traits_type::to_int_type(*(this->gptr()));
+
+        std::unique_lock<std::mutex> lock(this->m);
+        this->cv.wait(lock, [&](){ return this->done || !this->chunks.empty(); });
+        if(this->chunks.empty() || this->failed) return traits_type::eof();
+        this->current = std::move(this->chunks.front());
+        this->chunks.pop_front();
+        this->cv.notify_all();
+        lock.unlock();
+
+        char *b = &(this->current[0]);
+        this->setg(b, b, b + this->current.size());
+        return traits_type::to_int_type(*b);
+    }
+
+  public:
+    explicit pipelined_gzip_streambuf(const std::string &filename){
+        this->producer = std::thread([this, filename](){ this->produce(filename); });
+    }
+
+    ~pipelined_gzip_streambuf() override {
+        {
+            std::lock_guard<std::mutex> lock(this->m);
+            this->abandoned = true;
+        }
+        this->cv.notify_all();
+        this->producer.join();
+    }
+
+    pipelined_gzip_streambuf(const pipelined_gzip_streambuf &) = delete;
+    pipelined_gzip_streambuf & operator=(const pipelined_gzip_streambuf &) = delete;
+};
+
+// Removes the parts of a Drover that were not selected.
+void Apply_Selection(Drover &d, const drover_archive_selection &selection){
+    if(!selection.images)         d.image_data.clear();
+    if(!selection.contours)       d.contour_data = nullptr;
+    if(!selection.point_clouds)   d.point_data.clear();
+    if(!selection.surface_meshes) d.smesh_data.clear();
+    if(!selection.tplans)         d.tplan_data.clear();
+    if(!selection.line_samples)   d.lsamp_data.clear();
+    if(!selection.transforms)     d.trans_data.clear();
+    return;
+}
+
+} // namespace
+
+
 bool
 Common_Boost_Serialize_Drover(const Drover &in,
                               boost::filesystem::path Filename){
@@ -62,6 +192,13 @@ Common_Boost_Serialize_Drover(const Drover &in,
 bool
 Common_Boost_Deserialize_Drover(Drover &out,
                                 const boost::filesystem::path& Filename){
+    return Common_Boost_Deserialize_Drover(out, Filename, drover_archive_selection());
+}
+
+bool
+Common_Boost_Deserialize_Drover(Drover &out,
+                                const boost::filesystem::path& Filename,
+                                const drover_archive_selection &selection){
 
     //This routine attempts to deserialize an entire Drover class from a single file.
     //
@@ -75,7 +212,11 @@ Common_Boost_Deserialize_Drover(Drover &out,
     //   - no compression.
     //   
     // This routine will try opening the file multiple times until the correct combination (if any) 
-    // is found. The most anticipated combinations are therefore first.
+    // is found. The most anticipated combinations are therefore first. Gzipped archives are decompressed in a
+    // separate thread while they are parsed.
+    //
+    // Only native archives can skip loading unselected components. Other archives are fully deserialized, and the
+    // unselected components are then discarded.
     //
     // NOTE: By default, Boost.Serialize cannot deserialize NaN or +-Inf in text or xml. If you try, you get
     //       an unspecific invalid_input_stream exception with description: 'input stream error'. A 
@@ -93,86 +234,95 @@ Common_Boost_Deserialize_Drover(Drover &out,
         if(length == 0) return false;
     }
 
+    //Native archive. These are identified by their header, so no other formats need to be attempted.
+    if(Is_Native_Drover_Archive(Filename)){
+        return Common_Boost_Deserialize_Drover_from_Native_Archive(out, Filename, selection);
+    }
+
+    // Note: 'out' is only assigned after a successful parse, since a failed attempt can leave it partially populated.
+    const auto accept = [&](Drover &loaded) -> bool {
+        Apply_Selection(loaded, selection);
+        out = std::move(loaded);
+        return true;
+    };
+
     //XML, gzip compression.
     try{
-        std::ifstream ifs(Filename.string(), std::ios::in | std::ios::binary);
-
-        boost::iostreams::filtering_istream ifsb;
+        Drover loaded;
+        pipelined_gzip_streambuf sb(Filename.string());
+        std::istream ifsb(&sb);
         ifsb.imbue(std::locale(std::locale().classic(), new boost::math::nonfinite_num_get<char>));
-        ifsb.push(boost::iostreams::gzip_decompressor());
-        ifsb.push(ifs);
  
         {
             boost::archive::xml_iarchive ar(ifsb, boost::archive::no_codecvt);
-            ar & boost::serialization::make_nvp("dicom_data", out);
+            ar & boost::serialization::make_nvp("dicom_data", loaded);
         }
-        return true;
+        return accept(loaded);
     }catch(const std::exception &){ }
 
     //Simple text, gzip compression.
     try{
-        std::ifstream ifs(Filename.string(), std::ios::in | std::ios::binary);
-
-        boost::iostreams::filtering_istream ifsb;
+        Drover loaded;
+        pipelined_gzip_streambuf sb(Filename.string());
+        std::istream ifsb(&sb);
         ifsb.imbue(std::locale(std::locale().classic(), new boost::math::nonfinite_num_get<char>));
-        ifsb.push(boost::iostreams::gzip_decompressor());
-        ifsb.push(ifs);
 
         {
             boost::archive::text_iarchive ar(ifsb, boost::archive::no_codecvt);
-            ar & boost::serialization::make_nvp("dicom_data", out);
+            ar & boost::serialization::make_nvp("dicom_data", loaded);
         }
-        return true;
+        return accept(loaded);
     }catch(const std::exception &){ }
 
     //Binary, gzip compression.
     try{
-        std::ifstream ifs(Filename.string(), std::ios::in | std::ios::binary);
-
-        boost::iostreams::filtering_istream ifsb;
-        ifsb.push(boost::iostreams::gzip_decompressor());
-        ifsb.push(ifs);
+        Drover loaded;
+        pipelined_gzip_streambuf sb(Filename.string());
+        std::istream ifsb(&sb);
 
         {
             boost::archive::binary_iarchive ar(ifsb);
-            ar & boost::serialization::make_nvp("dicom_data", out);
+            ar & boost::serialization::make_nvp("dicom_data", loaded);
         }
-        return true;
+        return accept(loaded);
     }catch(const std::exception &){ }
 
     //Binary, no compression.
     try{
+        Drover loaded;
         std::ifstream ifs(Filename.string(), std::ios::in | std::ios::binary);
 
         {
             boost::archive::binary_iarchive ar(ifs);
-            ar & boost::serialization::make_nvp("dicom_data", out);
+            ar & boost::serialization::make_nvp("dicom_data", loaded);
         }
-        return true;
+        return accept(loaded);
     }catch(const std::exception &){ }
 
     //Simple text, no compression.
     try{
+        Drover loaded;
         std::ifstream ifs(Filename.string(), std::ios::in);
         ifs.imbue(std::locale(std::locale().classic(), new boost::math::nonfinite_num_get<char>));
 
         {
             boost::archive::text_iarchive ar(ifs, boost::archive::no_codecvt);
-            ar & boost::serialization::make_nvp("dicom_data", out);
+            ar & boost::serialization::make_nvp("dicom_data", loaded);
         }
-        return true;
+        return accept(loaded);
     }catch(const std::exception &){ }
 
     //XML, no compression.
     try{
+        Drover loaded;
         std::ifstream ifs(Filename.string(), std::ios::in);
         ifs.imbue(std::locale(std::locale().classic(), new boost::math::nonfinite_num_get<char>));
 
         {
             boost::archive::xml_iarchive ar(ifs, boost::archive::no_codecvt);
-            ar & boost::serialization::make_nvp("dicom_data", out);
+            ar & boost::serialization::make_nvp("dicom_data", loaded);
         }
-        return true;
+        return accept(loaded);
     }catch(const std::exception &){ }
 
     //Unknown serialization file. Cannot open. Signal failure.
@@ -315,6 +465,1101 @@ Common_Boost_Serialize_Drover_to_XML(const Drover &in,
 }
 
 
+//------------------
+// Native archive.
+//
+// The native archive stores voxel data raw, so it can be memory-mapped and copied directly into image buffers without
+// decompression or parsing. The layout is:
+//
+//   - a fixed-size header (magic, version, byte-order and float-format checks, and the location of the index, the
+//     contours, and the remainder),
+//   - voxel payloads for each image, stored as contiguous float32 (row, column, channel) and aligned to
+//     native_archive_alignment bytes, or optionally compressed (see below),
+//   - an index describing each Image_Array and image (dimensions, geometry, metadata, and payload location),
+//   - the contours, if any, in a compact encoding (see below), and
+//   - the remainder of the Drover (i.e., everything except image_data and contour_data) as a Boost.Serialization
+//     binary archive.
+//
+// The archive is not portable across architectures with differing byte order or float representation; such archives
+// are rejected rather than misinterpreted.
+//
+// Compressed payloads are predicted losslessly before compression: each voxel's bit pattern is replaced by its
+// difference from the same channel of the preceding voxel, and the bytes are then grouped by significance. Smoothly
+// varying images produce long runs of identical high-order bytes, which zlib compresses well at its fastest setting.
+// Payloads are compressed and decompressed concurrently.
+//
+// Metadata is stored per Image_Array as a table of distinct strings, a common block of entries shared by every image,
+// and per-image overrides, each entry being a pair of table indices. Series metadata (e.g., PatientID and
+// StudyInstanceUID) is therefore stored once per array rather than once per image.
+//
+// Contours are stored losslessly, but much more compactly than with Boost.Serialization; see
+// Native_Archive_Encode_Contours().
+//
+// Version 1 archives, which lack the per-payload codec, version 2 archives, which store every metadata entry
+// verbatim with each image, and version 3 archives, which store contours with Boost.Serialization, are still read.
+
+static const std::string native_archive_magic("DCMADRV1");
+static constexpr uint64_t native_archive_version = 4;
+static constexpr uint64_t native_archive_alignment = 64;
+static constexpr uint64_t native_archive_header_size = 64;
+static constexpr uint32_t native_archive_byte_order_check = 0x01020304;
+static constexpr float native_archive_float_check = -1.5f;
+
+namespace {
+
+struct native_archive_header {
+    uint64_t version = native_archive_version;
+    uint32_t byte_order_check = native_archive_byte_order_check;
+    float float_check = native_archive_float_check;
+    uint64_t index_offset = 0;
+    uint64_t index_size = 0;
+    uint64_t rest_offset = 0;
+    uint64_t rest_size = 0;
+    uint64_t contours_offset = 0; // Zero if there are no contours. The contours extend to the remainder.
+};
+
+// Helpers for writing the index to a buffer.
+template <class T>
+void Native_Archive_Put(std::string &buf, const T &x){
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially-copyable types can be stored directly.");
+    buf.append(reinterpret_cast<const char *>(&x), sizeof(T));
+    return;
+}
+void Native_Archive_Put(std::string &buf, const std::string &s){
+    Native_Archive_Put(buf, static_cast<uint64_t>(s.size()));
+    buf.append(s);
+    return;
+}
+void Native_Archive_Put(std::string &buf, const vec3<double> &v){
+    Native_Archive_Put(buf, v.x);
+    Native_Archive_Put(buf, v.y);
+    Native_Archive_Put(buf, v.z);
+    return;
+}
+
+enum class native_payload_codec : uint32_t {
+    raw = 0,             // Voxel data stored directly.
+    delta_shuffle_zlib = 1,
+};
+
+// Compresses voxel data using the delta_shuffle_zlib codec.
+std::string Native_Archive_Compress(const std::vector<float> &data, int64_t channels){
+    static_assert(sizeof(float) == sizeof(uint32_t), "float must be 32 bits");
+    const size_t N = data.size();
+    const size_t stride = static_cast<size_t>(std::max<int64_t>(1, channels));
+
+    std::string shuffled(N * sizeof(uint32_t), '\0');
+    for(size_t i = 0; i < N; ++i){
+        uint32_t bits = 0;
+        uint32_t prev_in_channel = 0;
+        std::memcpy(&bits, &data[i], sizeof(bits));
+        if(stride <= i) std::memcpy(&prev_in_channel, &data[i - stride], sizeof(prev_in_channel));
+        const uint32_t d = bits - prev_in_channel;
+        for(size_t k = 0; k < sizeof(uint32_t); ++k){
+            shuffled[k * N + i] = static_cast<char>((d >> (8 * k)) & 0xFFU);
+        }
+    }
+
+    std::string out;
+    {
+        boost::iostreams::filtering_ostream os;
+        os.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(boost::iostreams::zlib::best_speed)));
+        os.push(boost::iostreams::back_inserter(out));
+        os.write(shuffled.data(), static_cast<std::streamsize>(shuffled.size()));
+        os.reset(); // Flushes the compressor.
+    }
+    return out;
+}
+
+// Inverts Native_Archive_Compress(). Throws if the payload is corrupt or does not hold exactly N voxels.
+void Native_Archive_Decompress(const char *stored, uint64_t stored_size, int64_t channels, float *dest, size_t N){
+    const size_t stride = static_cast<size_t>(std::max<int64_t>(1, channels));
+    std::string shuffled(N * sizeof(uint32_t), '\0');
+    {
+        boost::iostreams::filtering_istream is;
+        is.push(boost::iostreams::zlib_decompressor());
+        is.push(boost::iostreams::array_source(stored, static_cast<size_t>(stored_size)));
+        is.read(&shuffled[0], static_cast<std::streamsize>(shuffled.size()));
+        if( (static_cast<size_t>(is.gcount()) != shuffled.size())
+        ||  (is.peek() != std::char_traits<char>::eof()) ){
+            throw std::runtime_error("Native archive compressed payload is invalid");
+        }
+    }
+
+    for(size_t i = 0; i < N; ++i){
+        uint32_t d = 0;
+        for(size_t k = 0; k < sizeof(uint32_t); ++k){
+            d |= static_cast<uint32_t>(static_cast<unsigned char>(shuffled[k * N + i])) << (8 * k);
+        }
+        uint32_t prev_in_channel = 0;
+        if(stride <= i) std::memcpy(&prev_in_channel, &dest[i - stride], sizeof(prev_in_channel));
+        const uint32_t bits = d + prev_in_channel;
+        std::memcpy(&dest[i], &bits, sizeof(bits));
+    }
+    return;
+}
+
+// Interns the metadata keys and values of an Image_Array for the index.
+struct native_archive_string_table {
+    std::vector<const std::string *> strings;
+    std::map<std::string, uint32_t> indices;
+
+    uint32_t intern(const std::string &x){
+        const auto it = this->indices.find(x);
+        if(it != std::end(this->indices)) return it->second;
+        if(this->strings.size() == std::numeric_limits<uint32_t>::max()){
+            throw std::runtime_error("Too many distinct metadata strings for native archive");
+        }
+        const auto n = static_cast<uint32_t>(this->strings.size());
+        const auto ins = this->indices.emplace(x, n);
+        this->strings.push_back( &(ins.first->first) );
+        return n;
+    }
+};
+
+// Bounds-checked reader for the index. Throws if the index is truncated.
+struct native_archive_reader {
+    const char *cur;
+    const char *end;
+
+    void need(uint64_t n) const {
+        if(static_cast<uint64_t>(this->end - this->cur) < n){
+            throw std::runtime_error("Native archive index is truncated");
+        }
+    }
+    template <class T>
+    T get(){
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially-copyable types can be read directly.");
+        this->need(sizeof(T));
+        T x;
+        std::memcpy(&x, this->cur, sizeof(T));
+        this->cur += sizeof(T);
+        return x;
+    }
+    std::string get_string(){
+        const auto n = this->get<uint64_t>();
+        this->need(n);
+        std::string s(this->cur, static_cast<size_t>(n));
+        this->cur += n;
+        return s;
+    }
+    vec3<double> get_vec3(){
+        const auto x = this->get<double>();
+        const auto y = this->get<double>();
+        const auto z = this->get<double>();
+        return vec3<double>(x, y, z);
+    }
+};
+
+// Contours.
+//
+// Contour points are stored per coordinate (see Native_Contour_Codec.h). The encoded stream is broken into blocks of
+// whole contours that are compressed with zlib, and blocks are encoded and decoded concurrently.
+constexpr size_t native_contour_block_points = 1 << 16;
+
+std::string Native_Archive_Zlib_Compress(const std::string &raw){
+    std::string out;
+    boost::iostreams::filtering_ostream os;
+    os.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(boost::iostreams::zlib::best_speed)));
+    os.push(boost::iostreams::back_inserter(out));
+    os.write(raw.data(), static_cast<std::streamsize>(raw.size()));
+    os.reset(); // Flushes the compressor.
+    return out;
+}
+
+std::string Native_Archive_Zlib_Decompress(const char *stored, uint64_t stored_size, uint64_t raw_size){
+    std::string raw(static_cast<size_t>(raw_size), '\0');
+    boost::iostreams::filtering_istream is;
+    is.push(boost::iostreams::zlib_decompressor());
+    is.push(boost::iostreams::array_source(stored, static_cast<size_t>(stored_size)));
+    is.read(&raw[0], static_cast<std::streamsize>(raw.size()));
+    if( (static_cast<size_t>(is.gcount()) != raw.size())
+    ||  (is.peek() != std::char_traits<char>::eof()) ){
+        throw std::runtime_error("Native archive contour data is invalid");
+    }
+    return raw;
+}
+
+// Encodes the contour collections. The layout is a string table for the contour metadata, the number of contours in
+// each collection, a table of blocks (contour count, decompressed size, and stored size), and the blocks.
+std::string Native_Archive_Encode_Contours(const Contour_Data &cd){
+    std::vector<const contour_of_points<double> *> contours;
+    native_archive_string_table table;
+    std::string section;
+
+    Native_Archive_Put(section, static_cast<uint64_t>(cd.ccs.size()));
+    for(const auto &cc : cd.ccs){
+        Native_Archive_Put(section, static_cast<uint64_t>(cc.contours.size()));
+        for(const auto &c : cc.contours){
+            contours.push_back(&c);
+            for(const auto &kv : c.metadata){
+                table.intern(kv.first);
+                table.intern(kv.second);
+            }
+        }
+    }
+
+    // Blocks hold whole contours, so each can be decoded independently.
+    std::vector<std::pair<size_t, size_t>> blocks; // [begin, end) into contours.
+    for(size_t i = 0; i < contours.size(); ){
+        const auto begin = i;
+        size_t points = 0;
+        while( (i < contours.size()) && (points < native_contour_block_points) ){
+            points += contours[i]->points.size();
+            ++i;
+        }
+        blocks.emplace_back(begin, i);
+    }
+
+    std::vector<std::string> raw(blocks.size());
+    std::vector<std::string> stored(blocks.size());
+    parallel_for(0, static_cast<long int>(blocks.size()), [&](long int b) -> void {
+        auto &buf = raw[b];
+        std::vector<double> xs, ys, zs;
+        for(auto i = blocks[b].first; i < blocks[b].second; ++i){
+            const auto &c = *(contours[i]);
+            Native_Archive_Put_Varint(buf, static_cast<uint64_t>(c.points.size()));
+            buf.push_back(static_cast<char>(c.closed ? 1 : 0));
+            Native_Archive_Put_Varint(buf, static_cast<uint64_t>(c.metadata.size()));
+            for(const auto &kv : c.metadata){
+                Native_Archive_Put_Varint(buf, table.indices.at(kv.first));
+                Native_Archive_Put_Varint(buf, table.indices.at(kv.second));
+            }
+            if(c.points.empty()) continue;
+
+            xs.clear();
+            ys.clear();
+            zs.clear();
+            for(const auto &p : c.points){
+                xs.push_back(p.x);
+                ys.push_back(p.y);
+                zs.push_back(p.z);
+            }
+            Native_Archive_Encode_Coordinate(buf, xs);
+            Native_Archive_Encode_Coordinate(buf, ys);
+            Native_Archive_Encode_Coordinate(buf, zs);
+        }
+        stored[b] = Native_Archive_Zlib_Compress(buf);
+    }, 1);
+
+    std::string out;
+    Native_Archive_Put(out, static_cast<uint64_t>(table.strings.size()));
+    for(const auto *x : table.strings) Native_Archive_Put(out, *x);
+    out += section;
+    Native_Archive_Put(out, static_cast<uint64_t>(blocks.size()));
+    for(size_t b = 0; b < blocks.size(); ++b){
+        Native_Archive_Put(out, static_cast<uint64_t>(blocks[b].second - blocks[b].first));
+        Native_Archive_Put(out, static_cast<uint64_t>(raw[b].size()));
+        Native_Archive_Put(out, static_cast<uint64_t>(stored[b].size()));
+    }
+    for(const auto &s : stored) out += s;
+    return out;
+}
+
+// Inverts Native_Archive_Encode_Contours(). Throws if the section is truncated or invalid.
+std::unique_ptr<Contour_Data> Native_Archive_Decode_Contours(const char *begin, const char *end){
+    native_archive_reader r{ begin, end };
+
+    std::vector<std::string> strings;
+    const auto N_strings = r.get<uint64_t>();
+    for(uint64_t i = 0; i < N_strings; ++i) strings.emplace_back( r.get_string() );
+
+    auto cd = std::make_unique<Contour_Data>();
+    std::vector<contour_of_points<double> *> contours;
+    const auto N_ccs = r.get<uint64_t>();
+    for(uint64_t i = 0; i < N_ccs; ++i){
+        const auto N_contours = r.get<uint64_t>();
+        cd->ccs.emplace_back();
+        cd->ccs.back().contours.resize(static_cast<size_t>(N_contours));
+        for(auto &c : cd->ccs.back().contours) contours.push_back(&c);
+    }
+
+    struct block_t {
+        size_t begin;
+        size_t end;
+        uint64_t raw_size;
+        const char *stored;
+        uint64_t stored_size;
+    };
+    std::vector<block_t> blocks;
+    const auto N_blocks = r.get<uint64_t>();
+    size_t first = 0;
+    for(uint64_t b = 0; b < N_blocks; ++b){
+        const auto N_contours = r.get<uint64_t>();
+        const auto raw_size = r.get<uint64_t>();
+        const auto stored_size = r.get<uint64_t>();
+        if( (contours.size() - first) < N_contours ){
+            throw std::runtime_error("Native archive contour data is invalid");
+        }
+        blocks.push_back( block_t{ first, first + static_cast<size_t>(N_contours), raw_size, nullptr, stored_size } );
+        first += static_cast<size_t>(N_contours);
+    }
+    if(first != contours.size()) throw std::runtime_error("Native archive contour data is invalid");
+    for(auto &b : blocks){
+        r.need(b.stored_size);
+        b.stored = r.cur;
+        r.cur += b.stored_size;
+    }
+
+    parallel_for(0, static_cast<long int>(blocks.size()), [&](long int i) -> void {
+        const auto &b = blocks[i];
+        const auto raw = Native_Archive_Zlib_Decompress(b.stored, b.stored_size, b.raw_size);
+        native_contour_reader cr{ raw.data(), raw.data() + raw.size() };
+        const auto get_string = [&]() -> const std::string & {
+            const auto k = cr.get_varint();
+            if(strings.size() <= k) throw std::runtime_error("Native archive contour data is invalid");
+            return strings[k];
+        };
+
+        std::vector<double> xs, ys, zs;
+        for(auto j = b.begin; j < b.end; ++j){
+            auto &c = *(contours[j]);
+            const auto N_points = cr.get_varint();
+            c.closed = (cr.get_byte() != 0);
+            const auto N_metadata = cr.get_varint();
+            for(uint64_t k = 0; k < N_metadata; ++k){
+                const auto &key = get_string();
+                c.metadata[key] = get_string();
+            }
+            if(N_points == 0) continue;
+
+            xs.resize(static_cast<size_t>(N_points));
+            ys.resize(static_cast<size_t>(N_points));
+            zs.resize(static_cast<size_t>(N_points));
+            Native_Archive_Decode_Coordinate(cr, xs);
+            Native_Archive_Decode_Coordinate(cr, ys);
+            Native_Archive_Decode_Coordinate(cr, zs);
+            for(size_t k = 0; k < xs.size(); ++k) c.points.emplace_back(xs[k], ys[k], zs[k]);
+        }
+        if(cr.cur != cr.end) throw std::runtime_error("Native archive contour data is invalid");
+    }, 1);
+
+    return cd;
+}
+
+} // namespace
+
+
+struct native_archive_writer::impl {
+    // An image that has been written, pending its index entry.
+    struct entry_t {
+        int64_t rows;
+        int64_t columns;
+        int64_t channels;
+        double pxl_dx;
+        double pxl_dy;
+        double pxl_dz;
+        vec3<double> anchor;
+        vec3<double> offset;
+        vec3<double> row_unit;
+        vec3<double> col_unit;
+        std::map<std::string, std::string> metadata;
+        uint64_t payload_offset;
+        uint64_t payload_size;
+        uint64_t stored_size;
+    };
+
+    boost::filesystem::path filename;
+    std::ofstream ofs;
+    native_payload_codec codec;
+
+    std::string arrays_index; // Index entries of the completed arrays.
+    uint64_t array_count = 0;
+    bool in_array = false;
+    std::vector<entry_t> entries; // The current array's images.
+    bool finished = false;
+
+    void pad_to_alignment(){
+        const auto pos = static_cast<uint64_t>(this->ofs.tellp());
+        const auto rem = pos % native_archive_alignment;
+        if(rem != 0) this->ofs << std::string(static_cast<size_t>(native_archive_alignment - rem), '\0');
+    }
+
+    // Appends the current array's index entries, which require its string table and common metadata.
+    void end_image_array(){
+        if(!this->in_array) return;
+        std::string &index = this->arrays_index;
+        Native_Archive_Put(index, static_cast<uint64_t>(this->entries.size()));
+
+        // Same as Image_Array::common_metadata().
+        std::map<std::string, std::string> common;
+        if(!this->entries.empty()) common = this->entries.front().metadata;
+        for(size_t i = 1; (i < this->entries.size()) && !common.empty(); ++i){
+            const auto &md = this->entries[i].metadata;
+            for(auto c_it = std::begin(common); c_it != std::end(common); ){
+                const auto m_it = md.find(c_it->first);
+                if( (m_it == std::end(md)) || (m_it->second != c_it->second) ){
+                    c_it = common.erase(c_it);
+                }else{
+                    ++c_it;
+                }
+            }
+        }
+
+        native_archive_string_table table;
+        for(const auto &e : this->entries){
+            for(const auto &kv : e.metadata){
+                table.intern(kv.first);
+                table.intern(kv.second);
+            }
+        }
+        Native_Archive_Put(index, static_cast<uint64_t>(table.strings.size()));
+        for(const auto *x : table.strings) Native_Archive_Put(index, *x);
+        Native_Archive_Put(index, static_cast<uint64_t>(common.size()));
+        for(const auto &kv : common){
+            Native_Archive_Put(index, table.indices.at(kv.first));
+            Native_Archive_Put(index, table.indices.at(kv.second));
+        }
+
+        for(const auto &e : this->entries){
+            Native_Archive_Put(index, e.rows);
+            Native_Archive_Put(index, e.columns);
+            Native_Archive_Put(index, e.channels);
+            Native_Archive_Put(index, e.pxl_dx);
+            Native_Archive_Put(index, e.pxl_dy);
+            Native_Archive_Put(index, e.pxl_dz);
+            Native_Archive_Put(index, e.anchor);
+            Native_Archive_Put(index, e.offset);
+            Native_Archive_Put(index, e.row_unit);
+            Native_Archive_Put(index, e.col_unit);
+            Native_Archive_Put(index, static_cast<uint64_t>(e.metadata.size() - common.size()));
+            for(const auto &kv : e.metadata){
+                if(common.count(kv.first) != 0) continue;
+                Native_Archive_Put(index, table.indices.at(kv.first));
+                Native_Archive_Put(index, table.indices.at(kv.second));
+            }
+            Native_Archive_Put(index, e.payload_offset);
+            Native_Archive_Put(index, e.payload_size);
+            Native_Archive_Put(index, static_cast<uint32_t>(this->codec));
+            Native_Archive_Put(index, e.stored_size);
+        }
+
+        this->entries.clear();
+        this->in_array = false;
+        ++(this->array_count);
+    }
+};
+
+native_archive_writer::native_archive_writer(const boost::filesystem::path &Filename, bool compress)
+  : pimpl(std::make_unique<impl>()) {
+    this->pimpl->filename = Filename;
+    this->pimpl->codec = (compress) ? native_payload_codec::delta_shuffle_zlib : native_payload_codec::raw;
+    this->pimpl->ofs.open(Filename.string(), std::ios::trunc | std::ios::binary);
+    if(!this->pimpl->ofs){
+        throw std::runtime_error("Unable to create native archive '" + Filename.string() + "'");
+    }
+
+    // Reserve space for the header, which is written last.
+    this->pimpl->ofs << std::string(static_cast<size_t>(native_archive_header_size), '\0');
+}
+
+native_archive_writer::~native_archive_writer(){
+    if(this->pimpl->finished) return;
+    this->pimpl->ofs.close();
+    boost::system::error_code ec;
+    boost::filesystem::remove(this->pimpl->filename, ec);
+}
+
+void native_archive_writer::begin_image_array(){
+    if(this->pimpl->finished) throw std::logic_error("Native archive has already been finished");
+    this->pimpl->end_image_array();
+    this->pimpl->in_array = true;
+}
+
+void native_archive_writer::add_images(const std::vector<const planar_image<float,double> *> &imgs){
+    auto &w = *(this->pimpl);
+    if(!w.in_array) throw std::logic_error("Images must be added to an Image_Array");
+    if(w.finished) throw std::logic_error("Native archive has already been finished");
+
+    std::vector<std::string> compressed;
+    if(w.codec != native_payload_codec::raw){
+        compressed.assign(imgs.size(), std::string());
+        parallel_for(0, static_cast<long int>(imgs.size()), [&](long int j) -> void {
+            compressed[j] = Native_Archive_Compress(imgs[j]->data, imgs[j]->channels);
+        }, 1);
+    }
+
+    for(size_t j = 0; j < imgs.size(); ++j){
+        const auto &img = *(imgs[j]);
+        w.pad_to_alignment();
+
+        impl::entry_t e;
+        e.payload_offset = static_cast<uint64_t>(w.ofs.tellp());
+        e.payload_size = static_cast<uint64_t>(img.data.size() * sizeof(float));
+        e.stored_size = e.payload_size;
+        if(w.codec == native_payload_codec::raw){
+            if(e.payload_size != 0){
+                w.ofs.write(reinterpret_cast<const char *>(img.data.data()),
+                            static_cast<std::streamsize>(e.payload_size));
+            }
+        }else{
+            auto &c = compressed[j];
+            e.stored_size = static_cast<uint64_t>(c.size());
+            w.ofs.write(c.data(), static_cast<std::streamsize>(c.size()));
+            std::string().swap(c);
+        }
+        if(!w.ofs) throw std::runtime_error("Unable to write native archive payload");
+
+        e.rows = static_cast<int64_t>(img.rows);
+        e.columns = static_cast<int64_t>(img.columns);
+        e.channels = static_cast<int64_t>(img.channels);
+        e.pxl_dx = static_cast<double>(img.pxl_dx);
+        e.pxl_dy = static_cast<double>(img.pxl_dy);
+        e.pxl_dz = static_cast<double>(img.pxl_dz);
+        e.anchor = img.anchor;
+        e.offset = img.offset;
+        e.row_unit = img.row_unit;
+        e.col_unit = img.col_unit;
+        e.metadata = img.metadata;
+        w.entries.push_back(std::move(e));
+    }
+    return;
+}
+
+void native_archive_writer::finish(const Drover &in){
+    auto &w = *(this->pimpl);
+    if(w.finished) throw std::logic_error("Native archive has already been finished");
+    w.end_image_array();
+
+    native_archive_header header;
+
+    w.pad_to_alignment();
+    header.index_offset = static_cast<uint64_t>(w.ofs.tellp());
+    std::string count;
+    Native_Archive_Put(count, w.array_count);
+    header.index_size = static_cast<uint64_t>(count.size() + w.arrays_index.size());
+    w.ofs.write(count.data(), static_cast<std::streamsize>(count.size()));
+    w.ofs.write(w.arrays_index.data(), static_cast<std::streamsize>(w.arrays_index.size()));
+    std::string().swap(w.arrays_index);
+
+    // Everything except the image data and contours is handled by Boost.Serialization. The copy is shallow.
+    Drover rest(in);
+    rest.image_data.clear();
+
+    if(in.contour_data != nullptr){
+        const auto contours = Native_Archive_Encode_Contours(*(in.contour_data));
+        w.pad_to_alignment();
+        header.contours_offset = static_cast<uint64_t>(w.ofs.tellp());
+        w.ofs.write(contours.data(), static_cast<std::streamsize>(contours.size()));
+        rest.contour_data = nullptr;
+    }
+
+    w.pad_to_alignment();
+    header.rest_offset = static_cast<uint64_t>(w.ofs.tellp());
+    {
+        boost::archive::binary_oarchive ar(w.ofs);
+        ar & boost::serialization::make_nvp("dicom_data", rest);
+    }
+    header.rest_size = static_cast<uint64_t>(w.ofs.tellp()) - header.rest_offset;
+
+    std::string h;
+    h.append(native_archive_magic);
+    Native_Archive_Put(h, header.version);
+    Native_Archive_Put(h, header.byte_order_check);
+    Native_Archive_Put(h, header.float_check);
+    Native_Archive_Put(h, header.index_offset);
+    Native_Archive_Put(h, header.index_size);
+    Native_Archive_Put(h, header.rest_offset);
+    Native_Archive_Put(h, header.rest_size);
+    Native_Archive_Put(h, header.contours_offset);
+    h.resize(static_cast<size_t>(native_archive_header_size), '\0');
+
+    w.ofs.seekp(0);
+    w.ofs.write(h.data(), static_cast<std::streamsize>(h.size()));
+    w.ofs.flush();
+    if(!w.ofs) throw std::runtime_error("Unable to write native archive");
+    w.ofs.close();
+    w.finished = true;
+    return;
+}
+
+
+static bool
+Write_Native_Archive(const Drover &in,
+                     const boost::filesystem::path& Filename,
+                     native_payload_codec codec){
+
+    try{
+        native_archive_writer writer(Filename, (codec != native_payload_codec::raw));
+
+        // Compressed payloads are prepared concurrently, a window of images at a time, but written in order.
+        const auto window = static_cast<size_t>( 2 * std::max<long int>(1, work_stealing_pool::get().concurrency()) );
+        std::vector<const planar_image<float,double> *> imgs;
+        for(const auto &ia_ptr : in.image_data){
+            if(ia_ptr == nullptr){
+                throw std::invalid_argument("Encountered an invalid Image_Array");
+            }
+            writer.begin_image_array();
+            for(const auto &img : ia_ptr->imagecoll.images){
+                imgs.push_back( &img );
+                if(window <= imgs.size()){
+                    writer.add_images(imgs);
+                    imgs.clear();
+                }
+            }
+            writer.add_images(imgs);
+            imgs.clear();
+        }
+        writer.finish(in);
+
+    }catch(const std::exception &){
+        return false;
+    }
+
+    return true;
+}
+
+bool
+Common_Boost_Serialize_Drover_to_Native_Archive(const Drover &in,
+                                                const boost::filesystem::path& Filename){
+    return Write_Native_Archive(in, Filename, native_payload_codec::raw);
+}
+
+bool
+Common_Boost_Serialize_Drover_to_Compressed_Native_Archive(const Drover &in,
+                                                           const boost::filesystem::path& Filename){
+    return Write_Native_Archive(in, Filename, native_payload_codec::delta_shuffle_zlib);
+}
+
+
+bool
+Is_Native_Drover_Archive(const boost::filesystem::path& Filename){
+    std::ifstream ifs(Filename.string(), std::ios::in | std::ios::binary);
+    if(!ifs) return false;
+
+    std::string magic(native_archive_magic.size(), '\0');
+    ifs.read(&magic[0], static_cast<std::streamsize>(magic.size()));
+    return ifs && (magic == native_archive_magic);
+}
+
+
+bool
+Common_Boost_Deserialize_Drover_from_Native_Archive(Drover &out,
+                                                    const boost::filesystem::path& Filename){
+    return Common_Boost_Deserialize_Drover_from_Native_Archive(out, Filename, drover_archive_selection());
+}
+
+bool
+Common_Boost_Deserialize_Drover_from_Native_Archive(Drover &out,
+                                                    const boost::filesystem::path& Filename,
+                                                    const drover_archive_selection &selection){
+
+    try{
+        boost::iostreams::mapped_file_source mf(Filename.string());
+        const char *base = mf.data();
+        const auto file_size = static_cast<uint64_t>(mf.size());
+
+        const auto in_bounds = [&](uint64_t offset, uint64_t size) -> bool {
+            return (offset <= file_size) && (size <= (file_size - offset));
+        };
+
+        // Header.
+        if(!in_bounds(0, native_archive_header_size)
+        || (std::memcmp(base, native_archive_magic.data(), native_archive_magic.size()) != 0)){
+            return false;
+        }
+        native_archive_reader hr{ base + native_archive_magic.size(), base + native_archive_header_size };
+        native_archive_header header;
+        header.version          = hr.get<uint64_t>();
+        header.byte_order_check = hr.get<uint32_t>();
+        header.float_check      = hr.get<float>();
+        header.index_offset     = hr.get<uint64_t>();
+        header.index_size       = hr.get<uint64_t>();
+        header.rest_offset      = hr.get<uint64_t>();
+        header.rest_size        = hr.get<uint64_t>();
+        if(4 <= header.version){
+            header.contours_offset = hr.get<uint64_t>();
+        }
+
+        if( (header.version < 1)
+        ||  (native_archive_version < header.version) ){
+            FUNCWARN("Native archive version " << header.version << " is not recognized");
+            return false;
+        }
+        if( (header.byte_order_check != native_archive_byte_order_check)
+        ||  (header.float_check != native_archive_float_check) ){
+            FUNCWARN("Native archive was written on an incompatible architecture");
+            return false;
+        }
+        if(!in_bounds(header.index_offset, header.index_size)
+        || !in_bounds(header.rest_offset, header.rest_size)
+        || (header.rest_offset < header.contours_offset)){
+            FUNCWARN("Native archive is truncated");
+            return false;
+        }
+
+        // Everything except the image data.
+        Drover loaded;
+        {
+            boost::iostreams::stream<boost::iostreams::array_source> ifs(base + header.rest_offset,
+                                                                         static_cast<size_t>(header.rest_size));
+            boost::archive::binary_iarchive ar(ifs);
+            ar & boost::serialization::make_nvp("dicom_data", loaded);
+        }
+        loaded.image_data.clear();
+        if( (header.contours_offset != 0) && selection.contours ){
+            loaded.contour_data = Native_Archive_Decode_Contours(base + header.contours_offset,
+                                                                 base + header.rest_offset);
+        }
+        Apply_Selection(loaded, selection);
+        if(!selection.images){
+            // Voxel payloads are neither indexed nor read.
+            out = std::move(loaded);
+            return true;
+        }
+
+        // Index. Image buffers are allocated here, but populated afterward in parallel.
+        struct payload_t {
+            std::vector<float> *dest;
+            uint64_t offset;
+            native_payload_codec codec;
+            uint64_t stored_size;
+            int64_t channels;
+        };
+        std::vector<payload_t> payloads;
+
+        native_archive_reader ir{ base + header.index_offset, base + header.index_offset + header.index_size };
+        const auto N_arrays = ir.get<uint64_t>();
+        for(uint64_t i = 0; i < N_arrays; ++i){
+            loaded.image_data.emplace_back( std::make_shared<Image_Array>() );
+            auto &imagecoll = loaded.image_data.back()->imagecoll;
+
+            const auto N_images = ir.get<uint64_t>();
+
+            std::vector<std::string> strings;
+            std::map<std::string, std::string> common;
+            const auto get_entry = [&]() -> std::pair<const std::string &, const std::string &> {
+                const auto k = ir.get<uint32_t>();
+                const auto v = ir.get<uint32_t>();
+                if( (strings.size() <= k) || (strings.size() <= v) ){
+                    throw std::runtime_error("Native archive metadata is invalid");
+                }
+                return { strings[k], strings[v] };
+            };
+            if(3 <= header.version){
+                const auto N_strings = ir.get<uint64_t>();
+                for(uint64_t k = 0; k < N_strings; ++k) strings.emplace_back( ir.get_string() );
+                const auto N_common = ir.get<uint64_t>();
+                for(uint64_t k = 0; k < N_common; ++k) common.insert( get_entry() );
+            }
+
+            for(uint64_t j = 0; j < N_images; ++j){
+                const auto rows     = ir.get<int64_t>();
+                const auto columns  = ir.get<int64_t>();
+                const auto channels = ir.get<int64_t>();
+                const auto pxl_dx   = ir.get<double>();
+                const auto pxl_dy   = ir.get<double>();
+                const auto pxl_dz   = ir.get<double>();
+                const auto anchor   = ir.get_vec3();
+                const auto offset   = ir.get_vec3();
+                const auto row_unit = ir.get_vec3();
+                const auto col_unit = ir.get_vec3();
+
+                imagecoll.images.emplace_back();
+                auto &img = imagecoll.images.back();
+
+                const auto N_metadata = ir.get<uint64_t>();
+                if(3 <= header.version){
+                    img.metadata = common;
+                    for(uint64_t k = 0; k < N_metadata; ++k) img.metadata.insert( get_entry() );
+                }else{
+                    for(uint64_t k = 0; k < N_metadata; ++k){
+                        auto key = ir.get_string();
+                        img.metadata[key] = ir.get_string();
+                    }
+                }
+
+                const auto payload_offset = ir.get<uint64_t>();
+                const auto payload_size = ir.get<uint64_t>();
+                auto codec = native_payload_codec::raw;
+                auto stored_size = payload_size;
+                if(2 <= header.version){
+                    codec = static_cast<native_payload_codec>(ir.get<uint32_t>());
+                    stored_size = ir.get<uint64_t>();
+                }
+                if( (rows < 0) || (columns < 0) || (channels < 0)
+                ||  (payload_size != static_cast<uint64_t>(rows * columns * channels) * sizeof(float))
+                ||  ( (codec != native_payload_codec::raw) && (codec != native_payload_codec::delta_shuffle_zlib) )
+                ||  ( (codec == native_payload_codec::raw) && (stored_size != payload_size) )
+                ||  !in_bounds(payload_offset, stored_size) ){
+                    throw std::runtime_error("Native archive image payload is invalid");
+                }
+
+                img.init_buffer(rows, columns, channels);
+                img.init_spatial(pxl_dx, pxl_dy, pxl_dz, anchor, offset);
+                img.init_orientation(row_unit, col_unit);
+                if(payload_size != 0){
+                    payloads.push_back( payload_t{ &img.data, payload_offset, codec, stored_size, channels } );
+                }
+            }
+        }
+
+        // Copy voxel data out of the mapping. Pages are faulted in concurrently, so this is typically limited by
+        // storage bandwidth.
+        parallel_for(0, static_cast<long int>(payloads.size()), [&](long int i) -> void {
+            auto &p = payloads[i];
+            if(p.codec == native_payload_codec::raw){
+                std::memcpy(p.dest->data(), base + p.offset, p.dest->size() * sizeof(float));
+            }else{
+                Native_Archive_Decompress(base + p.offset, p.stored_size, p.channels, p.dest->data(), p.dest->size());
+            }
+        }, 1);
+
+        out = std::move(loaded);
+
+    }catch(const std::exception &){
+        return false;
+    }
+
+    return true;
+}
+
+
+//------------------
+// Content hash.
+
+uint64_t
+Drover_Content_Hash(const Drover &in){
+    content_hasher h;
+
+    h.add(static_cast<uint64_t>(in.image_data.size()));
+    for(const auto &ia_ptr : in.image_data){
+        h.add( (ia_ptr == nullptr) ? static_cast<uint64_t>(0) : ia_ptr->content_hash() );
+    }
+    h.add( in.Has_Contour_Data() ? Content_Hash(in.contour_data->ccs) : static_cast<uint64_t>(0) );
+    h.add(static_cast<uint64_t>(in.point_data.size()));
+    for(const auto &pc_ptr : in.point_data){
+        h.add( (pc_ptr == nullptr) ? static_cast<uint64_t>(0) : Content_Hash(pc_ptr->pset) );
+    }
+    h.add(static_cast<uint64_t>(in.smesh_data.size()));
+    for(const auto &sm_ptr : in.smesh_data){
+        h.add( (sm_ptr == nullptr) ? static_cast<uint64_t>(0) : Content_Hash(sm_ptr->meshes) );
+    }
+
+    // The remaining objects are small and varied, so their serialized form is hashed instead. The copy is shallow.
+    Drover rest;
+    rest.tplan_data = in.tplan_data;
+    rest.lsamp_data = in.lsamp_data;
+    rest.trans_data = in.trans_data;
+    std::ostringstream ss;
+    {
+        boost::archive::binary_oarchive ar(ss, boost::archive::no_header);
+        ar & boost::serialization::make_nvp("dicom_data", rest);
+    }
+    const auto bytes = ss.str();
+    h.add(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+
+    return h.digest();
+}
+
+
+
+//------------------
+// Change tracking.
+
+namespace {
+
+// Hashes the serialized form of an object (e.g., for objects without a dedicated content hash).
+template <class T>
+uint64_t Serialized_Content_Hash(const T &obj){
+    std::ostringstream ss;
+    {
+        boost::archive::binary_oarchive ar(ss, boost::archive::no_header);
+        ar << obj;
+    }
+    const auto bytes = ss.str();
+    content_hasher h;
+    h.add(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+    return h.digest();
+}
+
+template <class T, class F>
+std::vector<drover_snapshot::object_t> Snapshot_List(const std::list<std::shared_ptr<T>> &l, F hash){
+    std::vector<drover_snapshot::object_t> out;
+    out.reserve(l.size());
+    for(const auto &ptr : l){
+        out.emplace_back();
+        out.back().identity = ptr.get();
+        out.back().hash = (ptr == nullptr) ? static_cast<uint64_t>(0) : hash(*ptr);
+    }
+    return out;
+}
+
+// Objects are first matched by identity, and then unmatched objects are matched by content.
+drover_changes::list_changes Diff_List(const std::vector<drover_snapshot::object_t> &before,
+                                       const std::vector<drover_snapshot::object_t> &after){
+    drover_changes::list_changes out;
+
+    std::multimap<const void *, size_t> by_identity;
+    for(size_t i = 0; i < before.size(); ++i) by_identity.emplace(before[i].identity, i);
+
+    std::vector<bool> matched(before.size(), false);
+    std::vector<size_t> unmatched;
+    for(size_t j = 0; j < after.size(); ++j){
+        auto it = by_identity.find(after[j].identity);
+        if(it == std::end(by_identity)){
+            unmatched.push_back(j);
+            continue;
+        }
+        matched[it->second] = true;
+        if(before[it->second].hash != after[j].hash) out.modified.push_back(j);
+        by_identity.erase(it);
+    }
+
+    std::multimap<uint64_t, size_t> by_hash;
+    for(size_t i = 0; i < before.size(); ++i){
+        if(!matched[i]) by_hash.emplace(before[i].hash, i);
+    }
+    for(const auto &j : unmatched){
+        auto it = by_hash.find(after[j].hash);
+        if(it == std::end(by_hash)){
+            out.added.push_back(j);
+            continue;
+        }
+        matched[it->second] = true;
+        by_hash.erase(it);
+    }
+
+    for(size_t i = 0; i < before.size(); ++i){
+        if(!matched[i]) out.removed.push_back(i);
+    }
+    std::sort(std::begin(out.modified), std::end(out.modified));
+    return out;
+}
+
+// The added and modified positions, in order.
+std::vector<size_t> Delta_Positions(const drover_changes::list_changes &c){
+    std::vector<size_t> out;
+    std::merge(std::begin(c.added), std::end(c.added), std::begin(c.modified), std::end(c.modified),
+               std::back_inserter(out));
+    return out;
+}
+
+template <class T>
+std::list<std::shared_ptr<T>> Delta_List(const std::list<std::shared_ptr<T>> &l,
+                                         const drover_changes::list_changes &c){
+    std::list<std::shared_ptr<T>> out;
+    const auto positions = Delta_Positions(c);
+    auto p_it = std::begin(positions);
+    size_t i = 0;
+    for(auto it = std::begin(l); (it != std::end(l)) && (p_it != std::end(positions)); ++it, ++i){
+        if(i != *p_it) continue;
+        out.push_back(*it);
+        ++p_it;
+    }
+    return out;
+}
+
+} // namespace
+
+drover_snapshot
+Snapshot_Drover(const Drover &in){
+    drover_snapshot out;
+    out.image_arrays = Snapshot_List(in.image_data, [](const Image_Array &ia){ return ia.content_hash(); });
+    if(in.contour_data != nullptr){
+        for(const auto &cc : in.contour_data->ccs){
+            out.contour_collections.emplace_back();
+            out.contour_collections.back().identity = &cc;
+            out.contour_collections.back().hash = Content_Hash(cc);
+        }
+    }
+    out.point_clouds = Snapshot_List(in.point_data, [](const Point_Cloud &pc){
+        content_hasher h;
+        h.add(pc.content_hash());
+        h.add(Serialized_Content_Hash(pc.point_attributes));
+        return h.digest();
+    });
+    out.surface_meshes = Snapshot_List(in.smesh_data, [](const Surface_Mesh &sm){
+        content_hasher h;
+        h.add(sm.content_hash());
+        h.add(Serialized_Content_Hash(sm.vertex_attributes));
+        h.add(Serialized_Content_Hash(sm.face_attributes));
+        return h.digest();
+    });
+    out.tplans = Snapshot_List(in.tplan_data, Serialized_Content_Hash<TPlan_Config>);
+    out.line_samples = Snapshot_List(in.lsamp_data, Serialized_Content_Hash<Line_Sample>);
+    out.transforms = Snapshot_List(in.trans_data, Serialized_Content_Hash<Transform3>);
+    return out;
+}
+
+bool drover_changes::list_changes::empty() const {
+    return this->added.empty() && this->modified.empty() && this->removed.empty();
+}
+
+bool drover_changes::empty() const {
+    return this->image_arrays.empty()
+        && this->contour_collections.empty()
+        && this->point_clouds.empty()
+        && this->surface_meshes.empty()
+        && this->tplans.empty()
+        && this->line_samples.empty()
+        && this->transforms.empty();
+}
+
+drover_changes
+Diff_Drover_Snapshots(const drover_snapshot &before, const drover_snapshot &after){
+    drover_changes out;
+    out.image_arrays        = Diff_List(before.image_arrays, after.image_arrays);
+    out.contour_collections = Diff_List(before.contour_collections, after.contour_collections);
+    out.point_clouds        = Diff_List(before.point_clouds, after.point_clouds);
+    out.surface_meshes      = Diff_List(before.surface_meshes, after.surface_meshes);
+    out.tplans              = Diff_List(before.tplans, after.tplans);
+    out.line_samples        = Diff_List(before.line_samples, after.line_samples);
+    out.transforms          = Diff_List(before.transforms, after.transforms);
+    return out;
+}
+
+Drover
+Drover_Delta(const Drover &after, const drover_changes &changes){
+    Drover out;
+    out.image_data = Delta_List(after.image_data, changes.image_arrays);
+    out.point_data = Delta_List(after.point_data, changes.point_clouds);
+    out.smesh_data = Delta_List(after.smesh_data, changes.surface_meshes);
+    out.tplan_data = Delta_List(after.tplan_data, changes.tplans);
+    out.lsamp_data = Delta_List(after.lsamp_data, changes.line_samples);
+    out.trans_data = Delta_List(after.trans_data, changes.transforms);
+
+    const auto positions = Delta_Positions(changes.contour_collections);
+    if(!positions.empty() && (after.contour_data != nullptr)){
+        out.Ensure_Contour_Data_Allocated();
+        auto p_it = std::begin(positions);
+        size_t i = 0;
+        for(auto it = std::begin(after.contour_data->ccs);
+            (it != std::end(after.contour_data->ccs)) && (p_it != std::end(positions)); ++it, ++i){
+            if(i != *p_it) continue;
+            out.contour_data->ccs.push_back(*it);
+            ++p_it;
+        }
+    }
+    return out;
+}
+
+std::string
+Describe_Drover_Changes(const drover_changes &changes){
+    const auto list_positions = [](const std::vector<size_t> &v) -> std::string {
+        std::string out;
+        for(const auto &p : v) out += (out.empty() ? "" : " ") + std::to_string(p);
+        return out;
+    };
+
+    std::ostringstream ss;
+    for(const auto &c : { std::make_pair("image_arrays", &changes.image_arrays),
+                          std::make_pair("contour_collections", &changes.contour_collections),
+                          std::make_pair("point_clouds", &changes.point_clouds),
+                          std::make_pair("surface_meshes", &changes.surface_meshes),
+                          std::make_pair("tplans", &changes.tplans),
+                          std::make_pair("line_samples", &changes.line_samples),
+                          std::make_pair("transforms", &changes.transforms) }){
+        if(c.second->empty()) continue;
+        ss << c.first
+           << " added='" << list_positions(c.second->added) << "'"
+           << " modified='" << list_positions(c.second->modified) << "'"
+           << " removed='" << list_positions(c.second->removed) << "'" << std::endl;
+    }
+    return ss.str();
+}
+
+
 //=====================================================================================================================
 
 #ifdef DCMA_USE_GNU_GSL
@@ -4,7 +4,10 @@
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <cstdint>
+#include <memory>
 #include <string>    
+#include <vector>
 
 #ifdef DCMA_USE_GNU_GSL
     #include "KineticModel_1Compartment2Input_5Param_Chebyshev_Common.h"
@@ -23,6 +26,17 @@ class Drover;
 #endif // DCMA_USE_GNU_GSL
 
 
+// The parts of a Drover to load from an archive.
+struct drover_archive_selection {
+    bool images = true;
+    bool contours = true;
+    bool point_clouds = true;
+    bool surface_meshes = true;
+    bool tplans = true;
+    bool line_samples = true;
+    bool transforms = true;
+};
+
 // --- Default Serialization routines.
 bool
 Common_Boost_Serialize_Drover(const Drover &in, boost::filesystem::path Filename);
@@ -30,6 +44,12 @@ Common_Boost_Serialize_Drover(const Drover &in, boost::filesystem::path Filename
 bool
 Common_Boost_Deserialize_Drover(Drover &out, const boost::filesystem::path& Filename);
 
+// Only the selected components are retained. Native archives skip reading voxel data if images are not selected.
+bool
+Common_Boost_Deserialize_Drover(Drover &out,
+                                const boost::filesystem::path& Filename,
+                                const drover_archive_selection &selection);
+
 
 
 // --- Specific Serialization Routines ---
@@ -49,6 +69,110 @@ Common_Boost_Serialize_Drover_to_Simple_Text(const Drover &in, const boost::file
 bool
 Common_Boost_Serialize_Drover_to_XML(const Drover &in, const boost::filesystem::path& Filename);
 
+// Native archive, which stores voxel data raw so it can be memory-mapped and loaded without decompression or parsing.
+// Archives are not portable between architectures with differing byte order. Common_Boost_Deserialize_Drover() will
+// also recognize these archives.
+bool
+Common_Boost_Serialize_Drover_to_Native_Archive(const Drover &in, const boost::filesystem::path& Filename);
+// Same as above, but voxel data are compressed losslessly, which is slower to load but generally much smaller.
+bool
+Common_Boost_Serialize_Drover_to_Compressed_Native_Archive(const Drover &in, const boost::filesystem::path& Filename);
+bool
+Common_Boost_Deserialize_Drover_from_Native_Archive(Drover &out, const boost::filesystem::path& Filename);
+bool
+Common_Boost_Deserialize_Drover_from_Native_Archive(Drover &out,
+                                                    const boost::filesystem::path& Filename,
+                                                    const drover_archive_selection &selection);
+bool
+Is_Native_Drover_Archive(const boost::filesystem::path& Filename);
+
+// Writes a native archive incrementally, so the image data need not be held in memory all at once. Payloads are
+// written as images are added and only the index entries are retained until the archive is finished. Throws on error.
+// An archive that is destroyed before being finished is removed.
+class native_archive_writer {
+  public:
+    explicit native_archive_writer(const boost::filesystem::path &Filename, bool compress = false);
+    ~native_archive_writer();
+
+    // Begins a new Image_Array. Images added afterward belong to it.
+    void begin_image_array();
+
+    // Writes the images in order. Compressed payloads are prepared concurrently.
+    void add_images(const std::vector<const planar_image<float,double> *> &imgs);
+
+    // Writes the index and the remainder of the Drover. Its image_data is ignored.
+    void finish(const Drover &rest);
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+};
+
+// A content hash covering all data in the Drover, suitable for detecting whether inputs have changed.
+uint64_t
+Drover_Content_Hash(const Drover &in);
+
+
+// --- Change tracking ---
+
+// The identity (i.e., address) and content hash of every object held by a Drover, in order. Contour collections are
+// tracked individually. Snapshots do not keep the objects alive.
+struct drover_snapshot {
+    struct object_t {
+        const void *identity = nullptr;
+        uint64_t hash = 0;
+    };
+
+    std::vector<object_t> image_arrays;
+    std::vector<object_t> contour_collections;
+    std::vector<object_t> point_clouds;
+    std::vector<object_t> surface_meshes;
+    std::vector<object_t> tplans;
+    std::vector<object_t> line_samples;
+    std::vector<object_t> transforms;
+};
+
+drover_snapshot
+Snapshot_Drover(const Drover &in);
+
+// The objects added, modified, or removed between two snapshots, identified by position. Added and modified objects
+// are positions within the later snapshot, and removed objects are positions within the earlier snapshot.
+//
+// Objects present in both snapshots with differing content are modified. Objects that were replaced by an identical
+// copy (e.g., when shared data is detached by an operation) are unchanged. Reordering alone is not reported.
+struct drover_changes {
+    struct list_changes {
+        std::vector<size_t> added;
+        std::vector<size_t> modified;
+        std::vector<size_t> removed;
+
+        bool empty() const;
+    };
+
+    list_changes image_arrays;
+    list_changes contour_collections;
+    list_changes point_clouds;
+    list_changes surface_meshes;
+    list_changes tplans;
+    list_changes line_samples;
+    list_changes transforms;
+
+    bool empty() const;
+};
+
+drover_changes
+Diff_Drover_Snapshots(const drover_snapshot &before, const drover_snapshot &after);
+
+// A Drover holding only the added and modified objects (in order), shared with rather than copied from the given
+// Drover. Contour collections are copied. Since the delta is an ordinary Drover, it can be written in any archive
+// format, e.g., with Common_Boost_Serialize_Drover_to_Native_Archive().
+Drover
+Drover_Delta(const Drover &after, const drover_changes &changes);
+
+// A plain-text listing of the changes, one line per kind of object, suitable for clients applying a delta.
+std::string
+Describe_Drover_Changes(const drover_changes &changes);
+
 
 
 #ifdef DCMA_USE_GNU_GSL
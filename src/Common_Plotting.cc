@@ -1,11 +1,14 @@
 //Common_Plotting.cc - A part of DICOMautomaton 2016. Written by hal clark.
 
-#include <unistd.h>           //fork().
-#include <cstdlib>            //quick_exit(), EXIT_SUCCESS.
+#include <condition_variable>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <functional>
 #include <map>
+#include <mutex>
 #include <string>    
+#include <thread>
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
@@ -18,6 +21,95 @@
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
 
+namespace {
+
+// Interactive plots occupy a worker until they are closed, so several can be open at once.
+constexpr size_t max_concurrent_plot_jobs = 16;
+
+class plot_job_queue {
+  private:
+    std::mutex m;
+    std::condition_variable job_cv;  // Signalled when jobs are added or the queue is stopping.
+    std::condition_variable idle_cv; // Signalled when the last job finishes.
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> workers;
+    size_t active = 0;
+    bool stopping = false;
+
+    void work(){
+        std::unique_lock<std::mutex> lock(this->m);
+        while(true){
+            this->job_cv.wait(lock, [&](){ return this->stopping || !this->jobs.empty(); });
+            if(this->jobs.empty()) return; // Only reached when stopping, after all jobs have been run.
+
+            auto job = std::move(this->jobs.front());
+            this->jobs.pop_front();
+            ++(this->active);
+            lock.unlock();
+            try{
+                job();
+            }catch(const std::exception &e){
+                FUNCWARN("Plotting failed: '" << e.what() << "'");
+            }
+            lock.lock();
+            --(this->active);
+            if(this->jobs.empty() && (this->active == 0)) this->idle_cv.notify_all();
+        }
+    }
+
+  public:
+    plot_job_queue() = default;
+    plot_job_queue(const plot_job_queue &) = delete;
+    plot_job_queue & operator=(const plot_job_queue &) = delete;
+
+    // Runs any outstanding jobs before returning.
+    ~plot_job_queue(){
+        {
+            std::lock_guard<std::mutex> lock(this->m);
+            this->stopping = true;
+        }
+        this->job_cv.notify_all();
+        for(auto &w : this->workers) w.join();
+    }
+
+    void submit(std::function<void()> job){
+        std::lock_guard<std::mutex> lock(this->m);
+        this->jobs.push_back(std::move(job));
+
+        // Workers are only created when every existing worker is occupied.
+        const auto idle = this->workers.size() - this->active;
+        if( (idle < this->jobs.size()) && (this->workers.size() < max_concurrent_plot_jobs) ){
+            this->workers.emplace_back(&plot_job_queue::work, this);
+        }
+        this->job_cv.notify_one();
+    }
+
+    void wait(){
+        std::unique_lock<std::mutex> lock(this->m);
+        this->idle_cv.wait(lock, [&](){ return this->jobs.empty() && (this->active == 0); });
+    }
+};
+
+plot_job_queue & get_plot_job_queue(){
+    static plot_job_queue q;
+    return q;
+}
+
+} // namespace
+
+
+void Submit_Plot_Job(std::function<void()> job){
+    if(!job) return;
+    get_plot_job_queue().submit(std::move(job));
+    return;
+}
+
+void Wait_For_Plot_Jobs(){
+    get_plot_job_queue().wait();
+    return;
+}
+
+
 void 
 PlotTimeCourses(const std::string& title,
                          const std::map<std::string, samples_1D<double>> &s1D_time_courses,
@@ -28,14 +120,13 @@ PlotTimeCourses(const std::string& title,
     // NOTE: This routine is spotty. It doesn't always work, and seems to have a hard time opening a display window when a
     //       large data set is loaded. Files therefore get written for backup access.
     //
-    // NOTE: This routine does not persist after the parent terminates. It could be made to by dealing with signalling.
-    //       A better approach would be sending data to a dedicated server over the net. Better for headless operations,
+    // NOTE: Plots do not persist after the parent terminates, but the parent waits for open plots when exiting. A
+    //       better approach would be sending data to a dedicated server over the net. Better for headless operations,
     //       better for managing the plots and data, better for archiving, etc..
-
-#if !defined(_WIN32) && !defined(_WIN64)
-    auto pid = fork();
-    if(pid == 0){ //Child process.
-#endif
+    //
+    // NOTE: Plotting previously forked the process, which is unsafe when other threads hold locks. The time courses
+    //       are now copied and plotted on a background thread instead.
+    Submit_Plot_Job([=]() -> void {
         //Package the data into a shuttle and write the to file.
         std::vector<YgorMathPlottingGnuplot::Shuttle<samples_1D<double>>> shuttle;
         for(auto & tcs : s1D_time_courses){
@@ -78,11 +169,6 @@ PlotTimeCourses(const std::string& title,
                          << "'. Attempt " << attempt << " of " << max_attempts << " ...");
             }
         }
-
-#if !defined(_WIN32) && !defined(_WIN64)
-        std::quick_exit(EXIT_SUCCESS);
-    }
-#endif
+    });
     return;
 }
-
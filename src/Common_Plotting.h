@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <string>
 
@@ -10,6 +11,18 @@ template <class T> class cheby_approx;
 template <class T> class samples_1D;
 
 
+// Plotting is performed on background threads so that interactive plots, which can remain open until the user closes
+// them, do not stall the caller. Jobs are started in submission order, and a bounded number run concurrently. Jobs
+// must own (i.e., capture by value) everything they access. Exceptions thrown by jobs are reported and discarded.
+//
+// Outstanding jobs are waited on when the process exits normally, so plots remain available for inspection.
+void Submit_Plot_Job(std::function<void()> job);
+
+// Blocks until every submitted plot job has finished. Must not be called from a plot job.
+void Wait_For_Plot_Jobs();
+
+// Writes the time courses to files and plots them asynchronously (see Submit_Plot_Job). The time courses are copied.
+
 void 
 PlotTimeCourses(const std::string& title,
                          const std::map<std::string, samples_1D<double>> &s1D_time_courses,
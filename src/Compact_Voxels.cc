@@ -0,0 +1,223 @@
+//Compact_Voxels.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "Compact_Voxels.h"
+
+
+namespace {
+
+// The stored value reserved for NaN with int16 storage.
+constexpr int16_t int16_nan = std::numeric_limits<int16_t>::min();
+constexpr double int16_max = static_cast<double>(std::numeric_limits<int16_t>::max());
+
+// Marks a sparse block that is not stored.
+constexpr uint32_t elided_block = std::numeric_limits<uint32_t>::max();
+
+} // namespace
+
+
+uint16_t Float_To_Half(float f){
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    const auto sign = static_cast<uint16_t>((x >> 16) & 0x8000U);
+    x &= 0x7FFFFFFFU;
+
+    if(0x7F800000U <= x){ // Infinity or NaN. NaNs remain quiet NaNs.
+        return sign | 0x7C00U | ((0x7F800000U < x) ? 0x0200U : 0U);
+    }
+    if(0x477FF000U <= x){ // Rounds beyond the largest binary16 value (65504).
+        return sign | 0x7C00U;
+    }
+
+    // Subnormal (or zero) in binary16.
+    if(x < 0x38800000U){
+        const auto e = x >> 23;
+        if(e < 102U) return sign; // Less than half the smallest subnormal.
+        const uint32_t m = (x & 0x7FFFFFU) | 0x800000U;
+        const uint32_t shift = 126U - e;
+        const uint32_t rem = m & ((1U << shift) - 1U);
+        const uint32_t half = 1U << (shift - 1U);
+        uint32_t r = m >> shift;
+        if( (half < rem) || ((rem == half) && ((r & 1U) != 0U)) ) ++r;
+        return sign | static_cast<uint16_t>(r);
+    }
+
+    // Normal. Re-bias the exponent and round the mantissa, letting carries propagate into the exponent.
+    const uint32_t r = x - 0x38000000U;
+    uint32_t h = r >> 13;
+    const uint32_t rem = r & 0x1FFFU;
+    if( (0x1000U < rem) || ((rem == 0x1000U) && ((h & 1U) != 0U)) ) ++h;
+    return sign | static_cast<uint16_t>(h);
+}
+
+float Half_To_Float(uint16_t h){
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000U) << 16;
+    const uint32_t e = (h >> 10) & 0x1FU;
+    const uint32_t m = h & 0x3FFU;
+
+    uint32_t x;
+    if(e == 0U){
+        if(m == 0U){
+            x = sign;
+        }else{
+            const auto v = std::ldexp(static_cast<float>(m), -24);
+            return (sign != 0U) ? -v : v;
+        }
+    }else if(e == 0x1FU){
+        x = sign | 0x7F800000U | (m << 13);
+    }else{
+        x = sign | ((e + 112U) << 23) | (m << 13);
+    }
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+
+size_t compact_voxels::bytes() const {
+    return this->f32.size() * sizeof(float)
+         + this->b16.size() * sizeof(uint16_t)
+         + this->blocks.size() * sizeof(uint32_t);
+}
+
+void compact_voxels::decode(size_t begin, size_t n, float *dest) const {
+    if(this->count < begin + n){
+        throw std::out_of_range("Requested voxels beyond the end of the buffer");
+    }
+    switch(this->storage){
+        case voxel_storage::float32:
+            std::copy_n(this->f32.data() + begin, n, dest);
+            break;
+        case voxel_storage::int16:
+            for(size_t i = 0; i < n; ++i){
+                const auto q = static_cast<int16_t>(this->b16[begin + i]);
+                dest[i] = (q == int16_nan) ? std::numeric_limits<float>::quiet_NaN()
+                                           : static_cast<float>(this->slope * static_cast<double>(q) + this->intercept);
+            }
+            break;
+        case voxel_storage::float16:
+            for(size_t i = 0; i < n; ++i) dest[i] = Half_To_Float(this->b16[begin + i]);
+            break;
+        case voxel_storage::sparse:
+            for(size_t i = 0; i < n; ){
+                const auto k = begin + i;
+                const auto b = this->blocks[k / sparse_voxel_block];
+                const auto o = k % sparse_voxel_block;
+                const auto m = std::min(n - i, sparse_voxel_block - o);
+                if(b == elided_block){
+                    std::fill_n(dest + i, m, 0.0f);
+                }else{
+                    std::copy_n(this->f32.data() + b * sparse_voxel_block + o, m, dest + i);
+                }
+                i += m;
+            }
+            break;
+    }
+    return;
+}
+
+void compact_voxels::decode(std::vector<float> &dest) const {
+    dest.resize(this->count);
+    this->decode(0, this->count, dest.data());
+    return;
+}
+
+
+void compact_voxels::accumulate(float weight, float *dest) const {
+    if(this->storage == voxel_storage::sparse){
+        for(size_t i = 0; i < this->blocks.size(); ++i){
+            const auto b = this->blocks[i];
+            if(b == elided_block) continue;
+            const float *src = this->f32.data() + b * sparse_voxel_block;
+            float *d = dest + i * sparse_voxel_block;
+            const auto m = std::min(sparse_voxel_block, this->count - i * sparse_voxel_block);
+            for(size_t j = 0; j < m; ++j) d[j] += weight * src[j];
+        }
+        return;
+    }
+
+    std::array<float, 1024> buf;
+    for(size_t i = 0; i < this->count; i += buf.size()){
+        const auto m = std::min(buf.size(), this->count - i);
+        this->decode(i, m, buf.data());
+        for(size_t j = 0; j < m; ++j) dest[i + j] += weight * buf[j];
+    }
+    return;
+}
+
+
+compact_voxels Encode_Voxels(const float *values, size_t count, voxel_storage storage){
+    compact_voxels out;
+    out.storage = storage;
+    out.count = count;
+
+    if(storage == voxel_storage::float32){
+        out.f32.assign(values, values + count);
+        return out;
+    }
+
+    if(storage == voxel_storage::sparse){
+        const auto N_blocks = (count + sparse_voxel_block - 1) / sparse_voxel_block;
+        out.blocks.assign(N_blocks, elided_block);
+        uint32_t N_stored = 0;
+        for(size_t i = 0; i < N_blocks; ++i){
+            const auto first = values + i * sparse_voxel_block;
+            const auto last = values + std::min(count, (i + 1) * sparse_voxel_block);
+            if(std::all_of(first, last, [](float v){ return (v == 0.0f); })) continue;
+
+            out.blocks[i] = N_stored++;
+            out.f32.insert(std::end(out.f32), first, last);
+            out.f32.resize(static_cast<size_t>(N_stored) * sparse_voxel_block, 0.0f);
+        }
+        out.f32.shrink_to_fit();
+        return out;
+    }
+
+    out.b16.resize(count);
+    if(storage == voxel_storage::float16){
+        for(size_t i = 0; i < count; ++i) out.b16[i] = Float_To_Half(values[i]);
+        return out;
+    }
+
+    // Integer-valued data that fits is stored exactly. Otherwise the finite range is spread over the integers.
+    double min = std::numeric_limits<double>::infinity();
+    double max = -min;
+    bool exact = true;
+    for(size_t i = 0; i < count; ++i){
+        const auto v = static_cast<double>(values[i]);
+        if(!std::isfinite(v)) continue;
+        min = std::min(min, v);
+        max = std::max(max, v);
+        if( exact && ((v != std::round(v)) || (int16_max < std::abs(v))) ) exact = false;
+    }
+    if(!exact){
+        out.intercept = 0.5 * (min + max);
+        out.slope = (max - min) / (2.0 * int16_max);
+        if(!(0.0 < out.slope)) out.slope = 1.0; // A single, non-integer value.
+    }
+
+    for(size_t i = 0; i < count; ++i){
+        const auto v = static_cast<double>(values[i]);
+        double q = 0.0;
+        if(std::isnan(v)){
+            out.b16[i] = static_cast<uint16_t>(int16_nan);
+            continue;
+        }else if(std::isinf(v)){
+            q = (0.0 < v) ? int16_max : -int16_max;
+        }else{
+            q = std::clamp(std::round((v - out.intercept) / out.slope), -int16_max, int16_max);
+        }
+        out.b16[i] = static_cast<uint16_t>(static_cast<int16_t>(q));
+    }
+    return out;
+}
+
@@ -0,0 +1,52 @@
+//Compact_Voxels.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Reduced-precision storage for voxel values.
+//
+// Values are encoded one buffer (e.g., one image) at a time and decoded back to float on access.
+enum class voxel_storage {
+    float32, // Full precision. Encoding is a copy.
+    int16,   // Rescaled 16-bit integers: value = slope * stored + intercept. Lossless for integer-valued data
+             // within [-32767:32767] (e.g., CT numbers); otherwise the finite range is spread over the integers.
+    float16, // IEEE 754 binary16, with round-to-nearest-even. About three significant digits.
+    sparse,  // Full precision, but blocks of consecutive values that are all zero are elided. Suits data that is zero
+             // over large regions, e.g., the dose from a single beam or beamlet.
+};
+
+// The number of consecutive values in each block of sparse storage.
+constexpr size_t sparse_voxel_block = 64;
+
+// IEEE 754 binary16 conversions. Values beyond the binary16 range become infinities and NaNs remain NaNs.
+uint16_t Float_To_Half(float f);
+float Half_To_Float(uint16_t h);
+
+struct compact_voxels {
+    voxel_storage storage = voxel_storage::float32;
+    double slope = 1.0;     // Only used for int16 storage.
+    double intercept = 0.0; // Only used for int16 storage.
+    size_t count = 0;
+
+    std::vector<float> f32;    // float32 storage, or the stored blocks of sparse storage.
+    std::vector<uint16_t> b16; // int16 (as two's complement bits) or binary16, depending on the storage.
+    std::vector<uint32_t> blocks; // Sparse storage: the position of each block in f32 (in blocks), if stored.
+
+    size_t bytes() const; // The memory consumed by the encoded values.
+
+    // Decodes values [begin, begin + n) into the destination.
+    void decode(size_t begin, size_t n, float *dest) const;
+    void decode(std::vector<float> &dest) const; // Resizes the destination.
+
+    // Adds the weighted values to the destination, which must hold 'count' values. Elided blocks are skipped, so
+    // summing sparse buffers only visits the stored blocks.
+    void accumulate(float weight, float *dest) const;
+};
+
+// With int16 storage, NaNs are preserved and infinities are clamped to the finite range.
+compact_voxels Encode_Voxels(const float *values, size_t count, voxel_storage storage);
+
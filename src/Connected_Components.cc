@@ -0,0 +1,231 @@
+//Connected_Components.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "Thread_Pool.h"
+#include "Distance_Transform.h"
+#include "Connected_Components.h"
+
+
+namespace {
+
+struct offset_t {
+    int64_t image;
+    int64_t row;
+    int64_t column;
+};
+
+// The neighbours that precede a voxel in raster order. Only these need to be examined during the first pass.
+std::vector<offset_t> preceding_neighbours(const distance_transform_grid &grid, ComponentConnectivity connectivity){
+    const int64_t max_nonzero = (connectivity == ComponentConnectivity::Faces) ? 1
+                              : (connectivity == ComponentConnectivity::Edges) ? 2 : 3;
+    std::vector<offset_t> out;
+    for(int64_t di = -1; di <= 0; ++di){
+        for(int64_t dr = -1; dr <= 1; ++dr){
+            for(int64_t dc = -1; dc <= 1; ++dc){
+                if(0 <= (di * 9 + dr * 3 + dc)) continue;
+                if(max_nonzero < ((di != 0) + (dr != 0) + (dc != 0))) continue;
+                if( ((di != 0) && !std::isfinite(grid.image_spacing))
+                ||  ((dr != 0) && !std::isfinite(grid.row_spacing))
+                ||  ((dc != 0) && !std::isfinite(grid.column_spacing)) ) continue;
+                out.push_back( offset_t{ di, dr, dc } );
+            }
+        }
+    }
+    return out;
+}
+
+// Every tree is rooted at its smallest voxel index, so parents always precede their children in raster order.
+int64_t find_root(std::vector<int64_t> &parent, int64_t n){
+    while(parent[n] != n){
+        parent[n] = parent[parent[n]]; // Path halving.
+        n = parent[n];
+    }
+    return n;
+}
+
+int64_t peek_root(const std::vector<int64_t> &parent, int64_t n){
+    while(parent[n] != n) n = parent[n];
+    return n;
+}
+
+void unite(std::vector<int64_t> &parent, int64_t a, int64_t b){
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if(a < b){
+        parent[b] = a;
+    }else if(b < a){
+        parent[a] = b;
+    }
+    return;
+}
+
+void validate(const std::vector<uint8_t> &mask, const distance_transform_grid &grid){
+    if( (grid.images < 0) || (grid.rows < 0) || (grid.columns < 0) ){
+        throw std::invalid_argument("Grid dimensions cannot be negative");
+    }
+    if(static_cast<int64_t>(mask.size()) != grid.size()){
+        throw std::invalid_argument("Mask size does not match grid dimensions");
+    }
+    for(const auto w : { grid.image_spacing, grid.row_spacing, grid.column_spacing }){
+        if(std::isnan(w) || !(0.0 < w)){
+            throw std::invalid_argument("Grid spacing must be positive");
+        }
+    }
+    return;
+}
+
+// Labels components of non-zero mask voxels, where adjacent voxels n and m are connected if joined(n, m) is true.
+//
+// The grid is partitioned into slabs of consecutive rows (spanning images), which are labelled independently. Only
+// voxels within one image (plus one row) of a slab's start can reach into the preceding slab, so merging the slabs
+// afterward only revisits those voxels.
+template <class F>
+connected_components
+label_components(const std::vector<uint8_t> &mask,
+                 const distance_transform_grid &grid,
+                 ComponentConnectivity connectivity,
+                 const F &joined){
+    validate(mask, grid);
+    const auto offsets = preceding_neighbours(grid, connectivity);
+
+    const int64_t N = grid.size();
+    const int64_t N_rows = grid.images * grid.rows;
+    const int64_t columns = grid.columns;
+
+    const int64_t n_tasks = 4 * static_cast<int64_t>(work_stealing_pool::get().concurrency());
+    const int64_t rows_per_slab = std::max<int64_t>(grid.rows + 1, N_rows / std::max<int64_t>(1, n_tasks));
+    const int64_t n_slabs = (N_rows + rows_per_slab - 1) / rows_per_slab;
+    const auto slab_begin = [&](int64_t s) -> int64_t { return std::min(N_rows, s * rows_per_slab); };
+
+    // Visits the preceding neighbours of voxel (g, c), where g is the row index spanning images.
+    const auto visit_neighbours = [&](int64_t g, int64_t c, int64_t g_min, int64_t g_max, auto &&f){
+        const auto i = g / grid.rows;
+        const auto r = g % grid.rows;
+        const auto n = g * columns + c;
+        for(const auto &o : offsets){
+            const auto i2 = i + o.image;
+            const auto r2 = r + o.row;
+            const auto c2 = c + o.column;
+            if( (i2 < 0) || (r2 < 0) || (grid.rows <= r2) || (c2 < 0) || (columns <= c2) ) continue;
+            const auto g2 = i2 * grid.rows + r2;
+            if( (g2 < g_min) || (g_max <= g2) ) continue;
+            const auto m = g2 * columns + c2;
+            if( (mask[m] != 0) && joined(n, m) ) f(n, m);
+        }
+    };
+
+    std::vector<int64_t> parent(N);
+
+    // First pass: label each slab independently, then point every voxel directly at its slab's root.
+    parallel_for(0, n_slabs, [&](long int s){
+        const auto g_begin = slab_begin(s);
+        const auto g_end = slab_begin(s + 1);
+        for(auto n = g_begin * columns; n < g_end * columns; ++n) parent[n] = n;
+        for(auto g = g_begin; g < g_end; ++g){
+            for(int64_t c = 0; c < columns; ++c){
+                if(mask[g * columns + c] == 0) continue;
+                visit_neighbours(g, c, g_begin, g + 1, [&](int64_t n, int64_t m){ unite(parent, n, m); });
+            }
+        }
+        for(auto n = g_begin * columns; n < g_end * columns; ++n) parent[n] = parent[parent[n]];
+    }, 1);
+
+    // Merge equivalences across slab boundaries.
+    for(int64_t s = 1; s < n_slabs; ++s){
+        const auto g_begin = slab_begin(s);
+        const auto g_end = std::min(slab_begin(s + 1), g_begin + grid.rows + 1);
+        for(auto g = g_begin; g < g_end; ++g){
+            for(int64_t c = 0; c < columns; ++c){
+                if(mask[g * columns + c] == 0) continue;
+                visit_neighbours(g, c, 0, g_begin, [&](int64_t n, int64_t m){ unite(parent, n, m); });
+            }
+        }
+    }
+
+    // Second pass: resolve roots, then number the roots in raster order.
+    connected_components out;
+    out.labels.assign(N, 0);
+    std::vector<int64_t> roots_per_slab(n_slabs + 1, 0);
+    parallel_for(0, n_slabs, [&](long int s){
+        int64_t count = 0;
+        for(auto n = slab_begin(s) * columns; n < slab_begin(s + 1) * columns; ++n){
+            if(mask[n] == 0) continue;
+            out.labels[n] = peek_root(parent, parent[n]);
+            if(out.labels[n] == n) ++count;
+        }
+        roots_per_slab[s + 1] = count;
+    }, 1);
+    for(int64_t s = 0; s < n_slabs; ++s) roots_per_slab[s + 1] += roots_per_slab[s];
+
+    parallel_for(0, n_slabs, [&](long int s){
+        auto next = roots_per_slab[s] + 1;
+        for(auto n = slab_begin(s) * columns; n < slab_begin(s + 1) * columns; ++n){
+            if( (mask[n] != 0) && (out.labels[n] == n) ) parent[n] = next++;
+        }
+    }, 1);
+    parallel_for(0, n_slabs, [&](long int s){
+        for(auto n = slab_begin(s) * columns; n < slab_begin(s + 1) * columns; ++n){
+            if(mask[n] != 0) out.labels[n] = parent[out.labels[n]];
+        }
+    }, 1);
+
+    out.sizes.assign(roots_per_slab.back() + 1, 0);
+    for(const auto &l : out.labels) ++out.sizes[l];
+    return out;
+}
+
+} // namespace
+
+
+int64_t connected_components::count() const {
+    return this->sizes.empty() ? 0 : static_cast<int64_t>(this->sizes.size()) - 1;
+}
+
+connected_components
+Label_Connected_Components(const std::vector<uint8_t> &mask,
+                           const distance_transform_grid &grid,
+                           ComponentConnectivity connectivity){
+    return label_components(mask, grid, connectivity, [](int64_t, int64_t){ return true; });
+}
+
+connected_components
+Label_Connected_Components(const std::vector<float> &values,
+                           const std::vector<uint8_t> &mask,
+                           const distance_transform_grid &grid,
+                           ComponentConnectivity connectivity,
+                           double tolerance){
+    if(values.size() != mask.size()){
+        throw std::invalid_argument("Value and mask sizes differ");
+    }
+    if(std::isnan(tolerance) || (tolerance < 0.0)){
+        throw std::invalid_argument("Tolerance must be non-negative");
+    }
+    return label_components(mask, grid, connectivity, [&](int64_t n, int64_t m){
+        const auto a = values[n];
+        const auto b = values[m];
+        if(!std::isfinite(a) || !std::isfinite(b)) return (std::isfinite(a) == std::isfinite(b));
+        return (std::abs(static_cast<double>(a) - static_cast<double>(b)) <= tolerance);
+    });
+}
+
+std::vector<uint8_t>
+Remove_Small_Components(const std::vector<uint8_t> &mask,
+                        const distance_transform_grid &grid,
+                        ComponentConnectivity connectivity,
+                        int64_t min_size){
+    if(min_size < 0){
+        throw std::invalid_argument("Minimum component size cannot be negative");
+    }
+    const auto cc = Label_Connected_Components(mask, grid, connectivity);
+    std::vector<uint8_t> out(mask.size(), 0);
+    parallel_for(0, static_cast<long int>(mask.size()), [&](long int n){
+        const auto l = cc.labels[n];
+        out[n] = ( (l != 0) && (min_size <= cc.sizes[l]) ) ? 1 : 0;
+    }, std::max<long int>(1, grid.rows * grid.columns));
+    return out;
+}
@@ -0,0 +1,56 @@
+//Connected_Components.h.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Distance_Transform.h"
+
+
+// Connected-component labelling for masks on rectilinear grids, using the (image, row, column) mask ordering and the
+// grid description from Distance_Transform.h.
+//
+// Labelling uses two raster passes with a union-find forest. Slabs of consecutive images are labelled in parallel and
+// equivalences across slab boundaries are merged afterward, so the cost is linear in the number of voxels. Voxels are
+// not connected along axes with infinite spacing, so (for example) an infinite image spacing labels every image
+// independently.
+enum class ComponentConnectivity {
+    Faces,     // 6-connectivity in 3D (4-connectivity within an image).
+    Edges,     // 18-connectivity in 3D (8-connectivity within an image).
+    Vertices,  // 26-connectivity in 3D (8-connectivity within an image).
+};
+
+struct connected_components {
+    // Component labels are in [1:N] and are numbered in the raster order of each component's first voxel.
+    // Voxels excluded by the mask are labelled 0.
+    std::vector<int64_t> labels;
+
+    // The number of voxels in each component, indexed by label. The first entry counts the excluded voxels.
+    std::vector<int64_t> sizes;
+
+    int64_t count() const; // The number of components.
+};
+
+// Labels the components formed by non-zero voxels. Throws if the mask and grid are inconsistent.
+connected_components
+Label_Connected_Components(const std::vector<uint8_t> &mask,
+                           const distance_transform_grid &grid,
+                           ComponentConnectivity connectivity);
+
+// Labels the components formed by non-zero mask voxels, where adjacent voxels are only connected if their values
+// differ by no more than the tolerance. Non-finite values are connected to other non-finite values, so NaNs and
+// infinities form components of their own. The values must have the same ordering as the mask.
+connected_components
+Label_Connected_Components(const std::vector<float> &values,
+                           const std::vector<uint8_t> &mask,
+                           const distance_transform_grid &grid,
+                           ComponentConnectivity connectivity,
+                           double tolerance);
+
+// Returns the mask with every component of fewer than min_size voxels removed.
+std::vector<uint8_t>
+Remove_Small_Components(const std::vector<uint8_t> &mask,
+                        const distance_transform_grid &grid,
+                        ComponentConnectivity connectivity,
+                        int64_t min_size);
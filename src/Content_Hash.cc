@@ -0,0 +1,258 @@
+//Content_Hash.cc.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Thread_Pool.h"
+#include "Content_Hash.h"
+
+
+namespace {
+
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+
+// Buffers are split into blocks of this many elements, which are hashed independently and then combined in order.
+constexpr size_t block_size = static_cast<size_t>(1) << 18;
+
+inline uint64_t rotl(uint64_t x, int r){
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t finalize(uint64_t h){
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline float canonical(float x){
+    return (x == 0.0f) ? 0.0f : x;
+}
+
+uint64_t hash_float_block(const float *p, size_t N){
+    content_hasher H;
+    H.add(p, N);
+    return H.digest();
+}
+
+uint64_t hash_vertex_block(const std::vector<vec3<double>> &verts, size_t begin, size_t end){
+    content_hasher H;
+    for(size_t i = begin; i < end; ++i) H.add(verts[i]);
+    return H.digest();
+}
+
+uint64_t hash_face_block(const std::vector<std::vector<uint64_t>> &faces, size_t begin, size_t end){
+    content_hasher H;
+    for(size_t i = begin; i < end; ++i){
+        H.add(static_cast<uint64_t>(faces[i].size()));
+        for(const auto &v : faces[i]) H.add(v);
+    }
+    return H.digest();
+}
+
+// Hashes N elements in parallel blocks, combining the block hashes in order.
+template <class F>
+void add_blocks(content_hasher &H, size_t N, F hash_block){
+    const auto N_blocks = (N + block_size - 1) / block_size;
+    std::vector<uint64_t> block_hashes(N_blocks, 0);
+    parallel_for(0, static_cast<long int>(N_blocks), [&](long int b) -> void {
+        const auto begin = static_cast<size_t>(b) * block_size;
+        const auto end = std::min(N, begin + block_size);
+        block_hashes[b] = hash_block(begin, end);
+    }, /*grain=*/ 1);
+
+    H.add(static_cast<uint64_t>(N));
+    for(const auto &bh : block_hashes) H.add(bh);
+}
+
+void add_image_header(content_hasher &H, const planar_image<float,double> &img){
+    H.add(static_cast<uint64_t>(img.rows));
+    H.add(static_cast<uint64_t>(img.columns));
+    H.add(static_cast<uint64_t>(img.channels));
+    H.add(img.pxl_dx);
+    H.add(img.pxl_dy);
+    H.add(img.pxl_dz);
+    H.add(img.anchor);
+    H.add(img.offset);
+    H.add(img.row_unit);
+    H.add(img.col_unit);
+    H.add(img.metadata);
+}
+
+void add_contour_collection(content_hasher &H, const contour_collection<double> &cc){
+    H.add(static_cast<uint64_t>(cc.contours.size()));
+    for(const auto &c : cc.contours){
+        H.add(static_cast<uint64_t>(c.closed));
+        H.add(static_cast<uint64_t>(c.points.size()));
+        for(const auto &p : c.points) H.add(p);
+        H.add(c.metadata);
+    }
+}
+
+} // namespace
+
+
+void content_hasher::add(uint64_t x){
+    this->h ^= rotl(x * P2, 31) * P1;
+    this->h = rotl(this->h, 27) * P1 + P4;
+    ++(this->count);
+}
+
+void content_hasher::add(double x){
+    if(x == 0.0) x = 0.0;
+    uint64_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    this->add(u);
+}
+
+void content_hasher::add(float x){
+    x = canonical(x);
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    this->add(static_cast<uint64_t>(u));
+}
+
+void content_hasher::add(const std::string &s){
+    this->add(reinterpret_cast<const uint8_t *>(s.data()), s.size());
+}
+
+void content_hasher::add(const vec3<double> &v){
+    this->add(v.x);
+    this->add(v.y);
+    this->add(v.z);
+}
+
+void content_hasher::add(const std::map<std::string, std::string> &metadata){
+    this->add(static_cast<uint64_t>(metadata.size()));
+    for(const auto &kv : metadata){
+        this->add(kv.first);
+        this->add(kv.second);
+    }
+}
+
+void content_hasher::add(const float *p, size_t N){
+    this->add(static_cast<uint64_t>(N));
+    size_t i = 0;
+    for( ; (i + 1) < N; i += 2){
+        const float f[2] = { canonical(p[i]), canonical(p[i + 1]) };
+        uint64_t u;
+        std::memcpy(&u, f, sizeof(u));
+        this->add(u);
+    }
+    if(i < N) this->add(p[i]);
+}
+
+void content_hasher::add(const uint8_t *p, size_t N){
+    this->add(static_cast<uint64_t>(N));
+    for(size_t i = 0; i < N; i += sizeof(uint64_t)){
+        uint64_t u = 0;
+        std::memcpy(&u, p + i, std::min(sizeof(uint64_t), N - i));
+        this->add(u);
+    }
+}
+
+uint64_t content_hasher::digest() const {
+    return finalize(this->h ^ (this->count * P2));
+}
+
+
+uint64_t Content_Hash(const planar_image<float,double> &img){
+    content_hasher H;
+    add_image_header(H, img);
+    add_blocks(H, img.data.size(), [&](size_t begin, size_t end) -> uint64_t {
+        return hash_float_block(img.data.data() + begin, end - begin);
+    });
+    return H.digest();
+}
+
+uint64_t Content_Hash(const planar_image_collection<float,double> &imagecoll){
+    // Images are typically too small to warrant further splitting, so each image's buffer is a single task. Larger
+    // buffers are split so a few large images still make use of all threads.
+    struct task_t {
+        const planar_image<float,double> *img;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<task_t> tasks;
+    std::vector<size_t> first_task;
+    for(const auto &img : imagecoll.images){
+        first_task.push_back(tasks.size());
+        const auto N = img.data.size();
+        for(size_t begin = 0; begin < N; begin += block_size){
+            tasks.push_back({ &img, begin, std::min(N, begin + block_size) });
+        }
+    }
+    first_task.push_back(tasks.size());
+
+    std::vector<uint64_t> task_hashes(tasks.size(), 0);
+    parallel_for(0, static_cast<long int>(tasks.size()), [&](long int i) -> void {
+        const auto &t = tasks[i];
+        task_hashes[i] = hash_float_block(t.img->data.data() + t.begin, t.end - t.begin);
+    }, /*grain=*/ 1);
+
+    content_hasher H;
+    H.add(static_cast<uint64_t>(imagecoll.images.size()));
+    size_t n = 0;
+    for(const auto &img : imagecoll.images){
+        add_image_header(H, img);
+        H.add(static_cast<uint64_t>(img.data.size()));
+        for(size_t i = first_task[n]; i < first_task[n + 1]; ++i) H.add(task_hashes[i]);
+        ++n;
+    }
+    return H.digest();
+}
+
+uint64_t Content_Hash(const contour_collection<double> &cc){
+    content_hasher H;
+    add_contour_collection(H, cc);
+    return H.digest();
+}
+
+uint64_t Content_Hash(const std::list<contour_collection<double>> &ccs){
+    content_hasher H;
+    H.add(static_cast<uint64_t>(ccs.size()));
+    for(const auto &cc : ccs) add_contour_collection(H, cc);
+    return H.digest();
+}
+
+uint64_t Content_Hash(const point_set<double> &ps){
+    content_hasher H;
+    add_blocks(H, ps.points.size(), [&](size_t begin, size_t end) -> uint64_t {
+        return hash_vertex_block(ps.points, begin, end);
+    });
+    H.add(ps.metadata);
+    return H.digest();
+}
+
+uint64_t Content_Hash(const fv_surface_mesh<double, uint64_t> &mesh){
+    content_hasher H;
+    add_blocks(H, mesh.vertices.size(), [&](size_t begin, size_t end) -> uint64_t {
+        return hash_vertex_block(mesh.vertices, begin, end);
+    });
+    add_blocks(H, mesh.faces.size(), [&](size_t begin, size_t end) -> uint64_t {
+        return hash_face_block(mesh.faces, begin, end);
+    });
+    H.add(mesh.metadata);
+    return H.digest();
+}
+
+
+uint64_t Next_Version_Stamp(){
+    static std::atomic<uint64_t> stamp(0);
+    return ++stamp;
+}
+
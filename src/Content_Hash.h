@@ -0,0 +1,54 @@
+//Content_Hash.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+
+// An incremental, non-cryptographic 64-bit hasher for fingerprinting data (e.g., to detect whether cached results are
+// stale). Values are consumed a word at a time, and -0.0 and 0.0 are treated as equal.
+class content_hasher {
+  public:
+    void add(uint64_t x);
+    void add(double x);
+    void add(float x);
+    void add(const std::string &s);
+    void add(const vec3<double> &v);
+    void add(const std::map<std::string, std::string> &metadata);
+
+    // Consumes a contiguous buffer of floats, which is considerably faster than adding them individually.
+    void add(const float *p, size_t N);
+
+    // Consumes a contiguous buffer of raw bytes.
+    void add(const uint8_t *p, size_t N);
+
+    // Returns the (finalized) hash. More data can be added afterward.
+    uint64_t digest() const;
+
+  private:
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    uint64_t count = 0;
+};
+
+
+// Content hashes covering all data (including geometry and metadata) of the given objects. Image buffers and large
+// meshes are hashed in parallel, but the result does not depend on the number of threads.
+uint64_t Content_Hash(const planar_image<float,double> &img);
+uint64_t Content_Hash(const planar_image_collection<float,double> &imagecoll);
+uint64_t Content_Hash(const contour_collection<double> &cc);
+uint64_t Content_Hash(const std::list<contour_collection<double>> &ccs);
+uint64_t Content_Hash(const point_set<double> &ps);
+uint64_t Content_Hash(const fv_surface_mesh<double, uint64_t> &mesh);
+
+
+// Returns a process-wide, monotonically increasing stamp. Stamps are never reused (e.g., so they can distinguish
+// temporary files written concurrently).
+uint64_t Next_Version_Stamp();
+
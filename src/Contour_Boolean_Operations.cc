@@ -8,6 +8,10 @@
 #include <map>
 #include <cmath>
 #include <any>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #ifdef DCMA_USE_CGAL
 #else
@@ -24,83 +28,95 @@
 #include "YgorMisc.h"
 #include "YgorMath.h"
 
+#include "Thread_Pool.h"
+#include "Packed_Contours.h"
+#include "Polygon_Overlay.h"
 #include "Contour_Boolean_Operations.h"
 
 
-// Because ROI contours are 2D planar contours embedded in R^3, an explicit projection plane must be provided. Contours
-// are projected on the plane, an orthonormal basis is created, the projected contours are expressed in the basis, and
-// the Boolean operations are performed. Note that the outgoing contours remain projected onto the provided plane.
-//
-// Note: This routine is only designed to handle simple, non-self-intersecting polygons. Operations on other contours
-//       are potentially undefined. (Refer to the documentation provided by the supporting library.)
-//
-// Note: This routine will project all contours onto the provided plane. Irrelevant contours should be filtered out
-//       beforehand.
-//
-// Note: This routine will only produce contours of a uniform direction. (The direction depends on the provided plane.)
-//       The orientation of the provided contours will be ignored.
-//
-// Note: Outgoing contours with holes are converted to single contours with seams. The seam location cannot (easily) be
-//       specified.
-//
-// Note: This routine is able to treat the inputs as sets of disconnected polygons.
-//
-// Note: The number of contours this routine can potentially return are [0,inf] depending on the operation and inputs --
-//       even when holes are converted to seams.
-//
-contour_collection<double>
-ContourBoolean(plane<double> p,
-               std::list<std::reference_wrapper<contour_of_points<double>>> A,
-               std::list<std::reference_wrapper<contour_of_points<double>>> B,
-               ContourBooleanMethod op,
-               ContourBooleanMethod construction_op){
-
-    // Identify an orthonormal set that spans the 2D plane. Store them for later projection.
-    const auto pi = std::acos(-1.0);
-    const auto U_z = p.N_0.unit();
-    vec3<double> U_y = vec3<double>(1.0, 0.0, 0.0); //Candidate vector.
-    if(U_y.Dot(U_z) > 0.25){
-        U_y = U_z.rotate_around_x(pi * 0.5);
-    }
-    vec3<double> U_x = U_z.Cross(U_y);
-    if(!U_z.GramSchmidt_orthogonalize(U_y, U_x)){
-        throw std::runtime_error("Unable to find planar basis vectors.");
-    }
-    U_x = U_x.unit();  // U_x and U_y now form an in-plane basis.
-    U_y = U_y.unit();
+namespace {
+
+// An orthonormal in-plane basis, used to express contours in 2D.
+struct planar_basis_t {
+    plane<double> p;
+    vec3<double> U_x;
+    vec3<double> U_y;
 
-    // Closure for expressing vectors in the plane's basis.
-    const auto R3_v_to_R2_P_basis = [=](vec3<double> R) -> vec3<double> {
-        // 'R' is a vector from the R^3 origin to a contour vertex.
-        // We want to express 'R' explicitly in terms of the R^2 plane's basis.
-        // (Our convention in this representation will be to use a vec3 but enforce z=0 everywhere.)
+    explicit planar_basis_t(const plane<double> &P) : p(P) {
+        // Identify an orthonormal set that spans the 2D plane.
+        const auto pi = std::acos(-1.0);
+        const auto U_z = p.N_0.unit();
+        U_y = vec3<double>(1.0, 0.0, 0.0); //Candidate vector.
+        if(U_y.Dot(U_z) > 0.25){
+            U_y = U_z.rotate_around_x(pi * 0.5);
+        }
+        U_x = U_z.Cross(U_y);
+        if(!U_z.GramSchmidt_orthogonalize(U_y, U_x)){
+            throw std::runtime_error("Unable to find planar basis vectors.");
+        }
+        U_x = U_x.unit();  // U_x and U_y now form an in-plane basis.
+        U_y = U_y.unit();
+    }
 
+    // Expresses a vector from the R^3 origin to a contour vertex in terms of the plane's basis. (Our convention in
+    // this representation will be to use a vec3 but enforce z=0 everywhere.)
+    vec3<double> to_plane(const vec3<double> &R) const {
         //Project onto the plane.
         const auto proj = p.Project_Onto_Plane_Orthogonally(R);
 
         //Now express the projected point in terms of the plane's basis.
         const auto dR = (proj - p.R_0);  // in-plane vector from plane's pinning vector.
-
         return vec3<double>(dR.Dot(U_x), dR.Dot(U_y), 0.0);
-    };
-
-    // Closure for converting from the plane's basis back to R^3 representation.
-    const auto R2_P_basis_to_R3_v = [=](vec3<double> R) -> vec3<double> {
-        // 'R' is a vector from the plane's origin (and R_0) to a contour vertex.
-        // We want to express 'R' explicitly in terms of the R^3 coordinate system the plane is described in.
-        // Note that we cannot un-project the vertices off the plane, so we assume they were already exactly coincident
-        // with the plane.
+    }
 
-        vec3<double> actual = p.R_0 + (U_x * R.x) + (U_y * R.y);
-        return actual;
-    };
+    // Converts from the plane's basis back to R^3 representation. Note that we cannot un-project the vertices off the
+    // plane, so we assume they were already exactly coincident with the plane.
+    vec3<double> from_plane(double x, double y) const {
+        return p.R_0 + (U_x * x) + (U_y * y);
+    }
+};
+
+// Expresses the contours in the planar basis (with z'=0 everywhere), oriented counter-clockwise. The projected
+// contours are only needed while the operations are performed, so they are packed into the provided arena.
+packed_contours
+project(const planar_basis_t &basis,
+        const std::list<std::reference_wrapper<contour_of_points<double>>> &contours,
+        std::pmr::memory_resource *arena){
+    size_t N_points = 0;
+    for(const auto &c_ref : contours) N_points += c_ref.get().points.size();
+
+    packed_contours out(arena);
+    out.reserve(contours.size(), N_points);
+    for(const auto &c_ref : contours){
+        out.start_contour(true);
+        for(const auto &v : c_ref.get().points){
+            out.add_point(basis.to_plane(v));
+        }
+        const auto i = out.size() - 1;
+        if(!(0.0 < Contour_Signed_Area(out, i, vec3<double>(0.0, 0.0, 1.0)))) out.reverse(i);
+    }
+    return out;
+}
 
-    // Extract the common metadata from all contours in both A and B sets. Store it for later.
+// Extracts the common metadata from all contours in both A and B sets.
+std::map<std::string, std::string>
+common_metadata_of(const std::list<std::reference_wrapper<contour_of_points<double>>> &A,
+                   const std::list<std::reference_wrapper<contour_of_points<double>>> &B){
     std::list<std::reference_wrapper<contour_of_points<double>>> all;
     all.insert(all.end(), A.begin(), A.end());
     all.insert(all.end(), B.begin(), B.end());
-    auto common_metadata = contour_collection<double>().get_common_metadata( { }, { std::ref(all) } );
-
+    return contour_collection<double>().get_common_metadata( { }, { std::ref(all) } );
+}
+
+// Performs the Boolean operations with CGAL polygon sets. The operand sets are built once and reused for each
+// operation.
+std::vector<contour_collection<double>>
+cgal_boolean(const planar_basis_t &basis,
+             const packed_contours &A,
+             const packed_contours &B,
+             const std::vector<ContourBooleanMethod> &ops,
+             ContourBooleanMethod construction_op,
+             const std::map<std::string, std::string> &common_metadata){
 
     using Kernel = CGAL::Simple_cartesian<double>;
     using Point_2 = Kernel::Point_2;
@@ -108,129 +124,227 @@ ContourBoolean(plane<double> p,
     using Polygon_with_holes_2 = CGAL::Polygon_with_holes_2<Kernel>;
     using Polygon_set_2 = CGAL::Polygon_set_2<Kernel>;
 
-    bool first_contour;
-
-    // Convert the A set of contours into CGAL style by projecting onto the plane and expressing in the new basis.
-    Polygon_set_2 A_set;
-    first_contour = true;
-    for(auto &c_ref : A){
-        //Express in the planar basis (with z'=0 everywhere).
-        contour_of_points<double> projected;
-        projected.closed = true;
-        for(auto &v : c_ref.get().points){
-            projected.points.emplace_back(R3_v_to_R2_P_basis(v));
-        }
-
-        //Ensure that the contour is counter-clockwise (as per the CGAL requirement for outer-boundary polygons).
-        if(!projected.Is_Counter_Clockwise()) projected.Reorient_Counter_Clockwise();
-
-        //Insert in the CGAL polygon set.
-        Polygon_2 A_cgal;
-        for(auto &v : projected.points){
-            A_cgal.push_back(Point_2(v.x,v.y));
+    // Convert the projected contours into CGAL style.
+    const auto construct = [&](const packed_contours &contours) -> Polygon_set_2 {
+        Polygon_set_2 set;
+        bool first_contour = true;
+        for(size_t i = 0; i < contours.size(); ++i){
+            //Insert in the CGAL polygon set.
+            Polygon_2 cgal;
+            for(auto k = contours.offsets[i]; k < contours.offsets[i + 1]; ++k){
+                cgal.push_back(Point_2(contours.x[k], contours.y[k]));
+            }
+            if(first_contour){
+                first_contour = false;
+                set.join(cgal);
+            }else if(construction_op == ContourBooleanMethod::join){
+                set.join(cgal);
+            }else if(construction_op == ContourBooleanMethod::intersection){
+                set.intersection(cgal);
+            }else if(construction_op == ContourBooleanMethod::difference){
+                set.difference(cgal);
+            }else if(construction_op == ContourBooleanMethod::symmetric_difference){
+                set.symmetric_difference(cgal);
+            }else{
+                throw std::logic_error("Requested Boolean operation is not supported.");
+            }
         }
-        if(first_contour){
-            first_contour = false;
-            A_set.join(A_cgal);
-        }else if(construction_op == ContourBooleanMethod::join){
-            A_set.join(A_cgal);
-        }else if(construction_op == ContourBooleanMethod::intersection){
-            A_set.intersection(A_cgal);
-        }else if(construction_op == ContourBooleanMethod::difference){
-            A_set.difference(A_cgal);
-        }else if(construction_op == ContourBooleanMethod::symmetric_difference){
-            A_set.symmetric_difference(A_cgal);
+        return set;
+    };
+    const auto A_set = construct(A);
+    const auto B_set = construct(B);
+
+    std::vector<contour_collection<double>> outs;
+    for(const auto &op : ops){
+        // Perform the selected Boolean operation.
+        Polygon_set_2 C_set;
+        C_set.join(A_set);
+        if(op == ContourBooleanMethod::noop){
+            //Intentionally do nothing here.
+        }else if(op == ContourBooleanMethod::join){
+            C_set.join(B_set);
+        }else if(op == ContourBooleanMethod::intersection){
+            C_set.intersection(B_set);
+        }else if(op == ContourBooleanMethod::difference){
+            C_set.difference(B_set);
+        }else if(op == ContourBooleanMethod::symmetric_difference){
+            C_set.symmetric_difference(B_set);
         }else{
             throw std::logic_error("Requested Boolean operation is not supported.");
         }
-    }
-
-    // Convert the B set of contours into CGAL style by projecting onto the plane and expressing in the new basis.
-    Polygon_set_2 B_set;
-    first_contour = true;
-    for(auto &c_ref : B){
-        //Express in the planar basis (with z'=0 everywhere).
-        contour_of_points<double> projected;
-        projected.closed = true;
-        for(auto &v : c_ref.get().points){
-            projected.points.emplace_back(R3_v_to_R2_P_basis(v));
-        }
 
-        //Ensure that the contour is counter-clockwise (as per the CGAL requirement for outer-boundary polygons).
-        if(!projected.Is_Counter_Clockwise()) projected.Reorient_Counter_Clockwise();
-
-        //Insert in the CGAL polygon set.
-        Polygon_2 B_cgal;
-        for(auto &v : projected.points){
-            B_cgal.push_back(Point_2(v.x,v.y));
-        }
-        if(first_contour){
-            first_contour = false;
-            B_set.join(B_cgal);
-        }else if(construction_op == ContourBooleanMethod::join){
-            B_set.join(B_cgal);
-        }else if(construction_op == ContourBooleanMethod::intersection){
-            B_set.intersection(B_cgal);
-        }else if(construction_op == ContourBooleanMethod::difference){
-            B_set.difference(B_cgal);
-        }else if(construction_op == ContourBooleanMethod::symmetric_difference){
-            B_set.symmetric_difference(B_cgal);
-        }else{
-            throw std::logic_error("Requested Boolean operation is not supported.");
+        // Convert each contour back to the DICOMautomaton coordinate system using the orthonormal basis.
+        outs.emplace_back();
+        auto &out = outs.back();
+        if(C_set.number_of_polygons_with_holes() != 0){
+            std::list<Polygon_with_holes_2> pwhl;
+            C_set.polygons_with_holes(std::back_inserter(pwhl));
+
+            for(auto &pwh : pwhl){
+                //If necessary, remove polygon holes by 'seaming' the contours.
+                // Otherwise there are no holes to seam.
+                //
+                // Note: The following connect_holes routine fails with CGAL 4.10-1 (Arch Linux)
+                //       when using CGAL::Exact_predicates_inexact_constructions_kernel. Beware if you switch kernels.
+                std::list<Point_2> p2l;
+                connect_holes(pwh,std::back_inserter(p2l));
+
+                if(p2l.empty()) continue;
+                out.contours.emplace_back();
+                for(auto &p2 : p2l){
+                    out.contours.back().points.emplace_back( basis.from_plane(p2.x(), p2.y()) );
+                }
+                //The outer boundary of all CGAL contours with holes are oriented clockwise.
+                // Flip them around as per normal positive orientation in DICOMautomaton.
+                out.contours.back().points.reverse();
+
+                //Attach the common metadata.
+                out.contours.back().closed = true;
+                out.contours.back().metadata = common_metadata;
+            }
         }
     }
+    return outs;
+}
 
-
-    // Perform the selected Boolean operation.
-    Polygon_set_2 C_set;
-    C_set.join(A_set);
+bool evaluate_op(ContourBooleanMethod op, bool a, bool b){
     if(op == ContourBooleanMethod::noop){
-        //Intentionally do nothing here.
+        return a;
     }else if(op == ContourBooleanMethod::join){
-        C_set.join(B_set);
+        return a || b;
     }else if(op == ContourBooleanMethod::intersection){
-        C_set.intersection(B_set);
+        return a && b;
     }else if(op == ContourBooleanMethod::difference){
-        C_set.difference(B_set);
+        return a && !b;
     }else if(op == ContourBooleanMethod::symmetric_difference){
-        C_set.symmetric_difference(B_set);
-    }else{
+        return a != b;
+    }
+    throw std::logic_error("Requested Boolean operation is not supported.");
+    return false;
+}
+
+// Performs the Boolean operations with a floating-point overlay. The overlay is built once and reused for each
+// operation.
+std::vector<contour_collection<double>>
+fast_boolean(const planar_basis_t &basis,
+             const packed_contours &A,
+             const packed_contours &B,
+             const std::vector<ContourBooleanMethod> &ops,
+             ContourBooleanMethod construction_op,
+             const std::map<std::string, std::string> &common_metadata){
+
+    if( (construction_op == ContourBooleanMethod::noop) && ((1 < A.size()) || (1 < B.size())) ){
         throw std::logic_error("Requested Boolean operation is not supported.");
     }
+    for(const auto &op : ops) evaluate_op(op, false, false); // Validate the operations before doing any work.
+
+    const auto to_rings = [](const packed_contours &contours){
+        std::vector<polygon_overlay_ring> rings(contours.size());
+        for(size_t i = 0; i < contours.size(); ++i){
+            rings[i].reserve(contours.vertex_count(i));
+            for(auto k = contours.offsets[i]; k < contours.offsets[i + 1]; ++k){
+                rings[i].push_back( {{ contours.x[k], contours.y[k] }} );
+            }
+        }
+        return rings;
+    };
+
+    // Sets are constructed by folding the contours together in order, like the polygon sets.
+    const auto rule = [construction_op](const std::vector<uint8_t> &in_ring) -> bool {
+        bool member = (in_ring.front() != 0);
+        for(size_t i = 1; i < in_ring.size(); ++i){
+            member = evaluate_op(construction_op, member, (in_ring[i] != 0));
+        }
+        return member;
+    };
+
+    const polygon_overlay overlay(to_rings(A), to_rings(B), rule, rule);
 
-    // Convert each contour back to the DICOMautomaton coordinate system using the orthonormal basis.
-    contour_collection<double> out;
-    if(C_set.number_of_polygons_with_holes() != 0){
-        std::list<Polygon_with_holes_2> pwhl;
-        C_set.polygons_with_holes(std::back_inserter(pwhl));
-
-        for(auto &pwh : pwhl){
-            //If necessary, remove polygon holes by 'seaming' the contours.
-            // Otherwise there are no holes to seam.
-            //
-            // Note: The following connect_holes routine fails with CGAL 4.10-1 (Arch Linux)
-            //       when using CGAL::Exact_predicates_inexact_constructions_kernel. Beware if you switch kernels.
-            std::list<Point_2> p2l;
-            connect_holes(pwh,std::back_inserter(p2l));
-
-            if(p2l.empty()) continue;
+    std::vector<contour_collection<double>> outs;
+    for(const auto &op : ops){
+        outs.emplace_back();
+        auto &out = outs.back();
+        const auto regions = overlay.extract([op](bool a, bool b){ return evaluate_op(op, a, b); });
+        for(const auto &region : regions){
+            const auto ring = Bridge_Holes(region);
+            if(ring.empty()) continue;
             out.contours.emplace_back();
-            for(auto &p2 : p2l){
-                const vec3<double> proj(p2.x(), p2.y(), 0.0);
-                const auto v = R2_P_basis_to_R3_v(proj);
-                out.contours.back().points.emplace_back(v);
+            for(const auto &v : ring){
+                out.contours.back().points.emplace_back( basis.from_plane(v[0], v[1]) );
             }
-            //The outer boundary of all CGAL contours with holes are oriented clockwise.
-            // Flip them around as per normal positive orientation in DICOMautomaton.
-            out.contours.back().points.reverse();
-
-            //Attach the common metadata.
             out.contours.back().closed = true;
             out.contours.back().metadata = common_metadata;
         }
     }
+    return outs;
+}
+
+std::vector<contour_collection<double>>
+boolean_job(const contour_boolean_job &job,
+            const std::vector<ContourBooleanMethod> &ops,
+            ContourBooleanMethod construction_op,
+            ContourBooleanEngine engine){
+    const planar_basis_t basis(job.p);
+    const auto common_metadata = common_metadata_of(job.A, job.B);
+
+    std::pmr::monotonic_buffer_resource arena;
+    const auto A = project(basis, job.A, &arena);
+    const auto B = project(basis, job.B, &arena);
+
+    if(engine == ContourBooleanEngine::cgal){
+        return cgal_boolean(basis, A, B, ops, construction_op, common_metadata);
+    }else if(engine == ContourBooleanEngine::fast){
+        return fast_boolean(basis, A, B, ops, construction_op, common_metadata);
+    }
+    throw std::logic_error("Requested Boolean engine is not supported.");
+}
+
+} // namespace
 
-    return out;
-}               
 
+// Because ROI contours are 2D planar contours embedded in R^3, an explicit projection plane must be provided. Contours
+// are projected on the plane, an orthonormal basis is created, the projected contours are expressed in the basis, and
+// the Boolean operations are performed. Note that the outgoing contours remain projected onto the provided plane.
+//
+// Note: This routine is only designed to handle simple, non-self-intersecting polygons. Operations on other contours
+//       are potentially undefined. (Refer to the documentation provided by the supporting library.)
+//
+// Note: This routine will project all contours onto the provided plane. Irrelevant contours should be filtered out
+//       beforehand.
+//
+// Note: This routine will only produce contours of a uniform direction. (The direction depends on the provided plane.)
+//       The orientation of the provided contours will be ignored.
+//
+// Note: Outgoing contours with holes are converted to single contours with seams. The seam location cannot (easily) be
+//       specified.
+//
+// Note: This routine is able to treat the inputs as sets of disconnected polygons.
+//
+// Note: The number of contours this routine can potentially return are [0,inf] depending on the operation and inputs --
+//       even when holes are converted to seams.
+//
+contour_collection<double>
+ContourBoolean(plane<double> p,
+               std::list<std::reference_wrapper<contour_of_points<double>>> A,
+               std::list<std::reference_wrapper<contour_of_points<double>>> B,
+               ContourBooleanMethod op,
+               ContourBooleanMethod construction_op,
+               ContourBooleanEngine engine){
+    const contour_boolean_job job{ p, A, B };
+    auto outs = boolean_job(job, { op }, construction_op, engine);
+    return std::move(outs.front());
+}
+
+
+std::vector<std::vector<contour_collection<double>>>
+ContourBooleanBatch(const std::vector<contour_boolean_job> &jobs,
+                    const std::vector<ContourBooleanMethod> &ops,
+                    ContourBooleanMethod construction_op,
+                    ContourBooleanEngine engine){
+    std::vector<std::vector<contour_collection<double>>> out(jobs.size());
+    parallel_for(0, static_cast<long int>(jobs.size()), [&](long int j){
+        out[j] = boolean_job(jobs[j], ops, construction_op, engine);
+    }, 1);
+    return out;
+}
 
@@ -6,6 +6,7 @@
 
 #include <list>
 #include <functional>
+#include <vector>
 
 #include "YgorMath.h"
 
@@ -19,6 +20,12 @@ typedef enum {
                           //                        all of B except the part shared by A.)
 } ContourBooleanMethod;
 
+enum class ContourBooleanEngine {
+    cgal,  // CGAL polygon sets.
+    fast,  // A floating-point overlay (see Polygon_Overlay.h). Typically much faster, but it does not guarantee
+           // topologically consistent results for nearly-degenerate inputs.
+};
+
 
 // Because ROI contours are 2D planar contours embedded in R^3, an explicit projection plane must be provided. Contours
 // are projected on the plane, an orthonormal basis is created, the projected contours are expressed in the basis, and
@@ -51,6 +58,26 @@ ContourBoolean(plane<double> p,
                std::list<std::reference_wrapper<contour_of_points<double>>> A,
                std::list<std::reference_wrapper<contour_of_points<double>>> B,
                ContourBooleanMethod op,
-               ContourBooleanMethod construction_op = ContourBooleanMethod::join);
+               ContourBooleanMethod construction_op = ContourBooleanMethod::join,
+               ContourBooleanEngine engine = ContourBooleanEngine::cgal);
+
+
+// The contours on a single plane, for batched operations.
+struct contour_boolean_job {
+    plane<double> p;
+    std::list<std::reference_wrapper<contour_of_points<double>>> A;
+    std::list<std::reference_wrapper<contour_of_points<double>>> B;
+};
+
+// Performs every operation on every job, returning the results indexed as [job][operation]. Results are identical to
+// calling ContourBoolean() for each job and operation, but the sets constructed from A and B are only built once per
+// job and reused for each operation, and the jobs (e.g., the planes of a volume) are processed in parallel.
+//
+// The contours are only read, so they can appear in several jobs.
+std::vector<std::vector<contour_collection<double>>>
+ContourBooleanBatch(const std::vector<contour_boolean_job> &jobs,
+                    const std::vector<ContourBooleanMethod> &ops,
+                    ContourBooleanMethod construction_op = ContourBooleanMethod::join,
+                    ContourBooleanEngine engine = ContourBooleanEngine::cgal);
 
 
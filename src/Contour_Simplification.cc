@@ -0,0 +1,208 @@
+//Contour_Simplification.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+
+#include "Thread_Pool.h"
+#include "Contour_Simplification.h"
+
+
+namespace {
+
+double segment_distance(const vec3<double> &p, const vec3<double> &a, const vec3<double> &b){
+    const auto ab = b - a;
+    const double L2 = ab.Dot(ab);
+    if(!(0.0 < L2)) return p.distance(a);
+    const double t = std::clamp((p - a).Dot(ab) / L2, 0.0, 1.0);
+    return p.distance(a + ab * t);
+}
+
+// Marks the vertices to keep. Chains are given as index pairs, which may exceed N for closed polylines (indices are
+// taken modulo N). An explicit stack is used so long contours cannot exhaust the call stack.
+void douglas_peucker(const std::vector<vec3<double>> &P,
+                     double tol,
+                     std::vector<std::pair<size_t, size_t>> chains,
+                     std::vector<uint8_t> &keep){
+    const auto N = P.size();
+    while(!chains.empty()){
+        const auto [a, b] = chains.back();
+        chains.pop_back();
+        if(b <= (a + 1)) continue;
+
+        const auto &A = P[a % N];
+        const auto &B = P[b % N];
+        size_t k_max = a;
+        double d_max = -1.0;
+        for(auto k = a + 1; k < b; ++k){
+            const double d = segment_distance(P[k % N], A, B);
+            if(d_max < d){
+                d_max = d;
+                k_max = k;
+            }
+        }
+        if(tol < d_max){
+            keep[k_max % N] = 1;
+            chains.emplace_back(a, k_max);
+            chains.emplace_back(k_max, b);
+        }
+    }
+    return;
+}
+
+std::vector<uint8_t> simplify_douglas_peucker(const std::vector<vec3<double>> &P, bool closed, double tol){
+    const auto N = P.size();
+    std::vector<uint8_t> keep(N, 0);
+    keep[0] = 1;
+    if(!closed){
+        keep[N - 1] = 1;
+        douglas_peucker(P, tol, { { 0, N - 1 } }, keep);
+        return keep;
+    }
+
+    // Closed polylines are split at the first vertex and the vertex farthest from it.
+    size_t f = 0;
+    double d_f = -1.0;
+    for(size_t k = 1; k < N; ++k){
+        const double d = P[k].distance(P[0]);
+        if(d_f < d){
+            d_f = d;
+            f = k;
+        }
+    }
+    keep[f] = 1;
+    douglas_peucker(P, tol, { { 0, f }, { f, N } }, keep);
+
+    // Ensure the contour does not degenerate into a line.
+    if(std::count(std::begin(keep), std::end(keep), 1) < 3){
+        size_t k_max = 0;
+        double d_max = -1.0;
+        for(size_t k = 1; k < N; ++k){
+            if(keep[k] != 0) continue;
+            const double d = segment_distance(P[k], P[0], P[f]);
+            if(d_max < d){
+                d_max = d;
+                k_max = k;
+            }
+        }
+        keep[k_max] = 1;
+    }
+    return keep;
+}
+
+std::vector<uint8_t> simplify_visvalingam_whyatt(const std::vector<vec3<double>> &P, bool closed, double tol){
+    const auto N = P.size();
+    std::vector<size_t> prev(N), next(N);
+    for(size_t k = 0; k < N; ++k){
+        prev[k] = (k == 0) ? (N - 1) : (k - 1);
+        next[k] = ((k + 1) == N) ? 0 : (k + 1);
+    }
+    std::vector<uint8_t> keep(N, 1);
+    std::vector<uint32_t> version(N, 0);
+
+    const auto removable = [&](size_t k) -> bool {
+        return closed || ((k != 0) && ((k + 1) != N));
+    };
+    const auto effective_area = [&](size_t k) -> double {
+        return 0.5 * (P[k] - P[prev[k]]).Cross(P[next[k]] - P[prev[k]]).length();
+    };
+
+    // A min-heap of candidate removals. Entries are invalidated lazily when a neighbour is removed.
+    struct entry_t {
+        double cost;
+        size_t k;
+        uint32_t version;
+    };
+    const auto cmp = [](const entry_t &l, const entry_t &r){ return (r.cost < l.cost); };
+    std::vector<entry_t> heap;
+    heap.reserve(N);
+    for(size_t k = 0; k < N; ++k){
+        if(removable(k)) heap.push_back( entry_t{ effective_area(k), k, 0 } );
+    }
+    std::make_heap(std::begin(heap), std::end(heap), cmp);
+
+    size_t remaining = N;
+    const size_t min_remaining = (closed) ? 3 : 2;
+    while(!heap.empty() && (min_remaining < remaining)){
+        std::pop_heap(std::begin(heap), std::end(heap), cmp);
+        const auto e = heap.back();
+        heap.pop_back();
+        if( (keep[e.k] == 0) || (e.version != version[e.k]) ) continue;
+
+        // The merged edge replaces every original vertex between the neighbours, including those already removed.
+        const auto p = prev[e.k];
+        const auto n = next[e.k];
+        bool within = true;
+        for(auto j = (p + 1) % N; j != n; j = (j + 1) % N){
+            if(tol < segment_distance(P[j], P[p], P[n])){
+                within = false;
+                break;
+            }
+        }
+        if(!within) continue; // Reconsidered if a neighbour is later removed.
+
+        keep[e.k] = 0;
+        next[p] = n;
+        prev[n] = p;
+        --remaining;
+        for(const auto q : { p, n }){
+            if(!removable(q)) continue;
+            ++version[q];
+            heap.push_back( entry_t{ effective_area(q), q, version[q] } );
+            std::push_heap(std::begin(heap), std::end(heap), cmp);
+        }
+    }
+    return keep;
+}
+
+} // namespace
+
+
+std::vector<vec3<double>>
+Simplify_Polyline(const std::vector<vec3<double>> &points,
+                  bool closed,
+                  double max_deviation,
+                  ContourSimplificationMethod method){
+    if(!std::isfinite(max_deviation) || (max_deviation < 0.0)){
+        throw std::invalid_argument("Maximum deviation must be finite and non-negative.");
+    }
+    const auto N = points.size();
+    if(N <= ((closed) ? 3 : 2)) return points;
+
+    std::vector<uint8_t> keep;
+    if(method == ContourSimplificationMethod::DouglasPeucker){
+        keep = simplify_douglas_peucker(points, closed, max_deviation);
+    }else if(method == ContourSimplificationMethod::VisvalingamWhyatt){
+        keep = simplify_visvalingam_whyatt(points, closed, max_deviation);
+    }else{
+        throw std::logic_error("Requested simplification method is not supported.");
+    }
+
+    std::vector<vec3<double>> out;
+    out.reserve(static_cast<size_t>(std::count(std::begin(keep), std::end(keep), 1)));
+    for(size_t k = 0; k < N; ++k){
+        if(keep[k] != 0) out.push_back(points[k]);
+    }
+    return out;
+}
+
+
+void Simplify_Contours(const std::vector<std::reference_wrapper<contour_of_points<double>>> &contours,
+                       double max_deviation,
+                       ContourSimplificationMethod method){
+    parallel_for(0, static_cast<long int>(contours.size()), [&](long int i){
+        auto &c = contours[i].get();
+        const std::vector<vec3<double>> points(std::begin(c.points), std::end(c.points));
+        const auto simplified = Simplify_Polyline(points, c.closed, max_deviation, method);
+        if(simplified.size() != points.size()){
+            c.points.assign(std::begin(simplified), std::end(simplified));
+        }
+    });
+    return;
+}
@@ -0,0 +1,31 @@
+//Contour_Simplification.h.
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+enum class ContourSimplificationMethod {
+    DouglasPeucker,     // Recursively retains the vertex farthest from the simplified edge.
+    VisvalingamWhyatt,  // Iteratively removes the vertex forming the smallest triangle with its neighbours.
+};
+
+// Removes vertices such that every original vertex remains within max_deviation (in DICOM units) of the simplified
+// polyline. Endpoints of open polylines are always retained, and at least three vertices of closed polylines are
+// retained (unless fewer were provided).
+//
+// Vertices are processed in flat arrays. Visvalingam-Whyatt removals are ordered with a binary heap stored in an array,
+// and a candidate is only removed if the merged edge stays within the deviation of the vertices it replaces.
+std::vector<vec3<double>>
+Simplify_Polyline(const std::vector<vec3<double>> &points,
+                  bool closed,
+                  double max_deviation,
+                  ContourSimplificationMethod method);
+
+// Simplifies the contours in-place, in parallel.
+void Simplify_Contours(const std::vector<std::reference_wrapper<contour_of_points<double>>> &contours,
+                       double max_deviation,
+                       ContourSimplificationMethod method);
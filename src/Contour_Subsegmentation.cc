@@ -0,0 +1,235 @@
+//Contour_Subsegmentation.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Packed_Contours.h"
+#include "Thread_Pool.h"
+#include "Contour_Subsegmentation.h"
+
+
+namespace {
+
+// The area of the portion of contour i lying above the plane {R : R.Dot(N) = s}.
+//
+// The contour is clipped against the half-space one edge at a time (as in Sutherland-Hodgman clipping), and each
+// clipped vertex is immediately folded into a fan of triangles, so the clipped contour is never stored. For non-convex
+// contours, clipping can produce zero-width bridges along the plane, but these enclose no area.
+double area_above(const packed_contours &pc, size_t i, const vec3<double> &N, double s){
+    const auto b = pc.offsets[i];
+    const auto e = pc.offsets[i + 1];
+    if((e - b) < 3) return 0.0;
+
+    const double *x = pc.x.data();
+    const double *y = pc.y.data();
+    const double *z = pc.z.data();
+
+    long int emitted = 0;
+    double q0x = 0.0, q0y = 0.0, q0z = 0.0;  // The first clipped vertex.
+    double qpx = 0.0, qpy = 0.0, qpz = 0.0;  // The previous clipped vertex.
+    double ax = 0.0, ay = 0.0, az = 0.0;     // Twice the vector area.
+    const auto emit = [&](double qx, double qy, double qz) -> void {
+        if(emitted == 0){
+            q0x = qx; q0y = qy; q0z = qz;
+        }else if(1 < emitted){
+            const double ux = qpx - q0x, uy = qpy - q0y, uz = qpz - q0z;
+            const double vx = qx - q0x, vy = qy - q0y, vz = qz - q0z;
+            ax += uy * vz - uz * vy;
+            ay += uz * vx - ux * vz;
+            az += ux * vy - uy * vx;
+        }
+        qpx = qx; qpy = qy; qpz = qz;
+        ++emitted;
+    };
+
+    auto prev = e - 1;
+    double d_prev = x[prev] * N.x + y[prev] * N.y + z[prev] * N.z - s;
+    for(auto k = b; k < e; ++k){
+        const double d = x[k] * N.x + y[k] * N.y + z[k] * N.z - s;
+        if((0.0 < d_prev) != (0.0 < d)){
+            const double t = d_prev / (d_prev - d);
+            emit(x[prev] + t * (x[k] - x[prev]),
+                 y[prev] + t * (y[k] - y[prev]),
+                 z[prev] + t * (z[k] - z[prev]));
+        }
+        if(0.0 < d) emit(x[k], y[k], z[k]);
+        prev = k;
+        d_prev = d;
+    }
+    return 0.5 * std::sqrt(ax * ax + ay * ay + az * az);
+}
+
+double total_area_above(const packed_contours &pc, const vec3<double> &N, double s){
+    double area = 0.0;
+    for(size_t i = 0; i < pc.size(); ++i) area += area_above(pc, i, N, s);
+    return area;
+}
+
+using plane_pair_t = std::pair<plane<double>, plane<double>>;
+
+plane_pair_t bisect_ROI(const contour_collection<double> &ROI,
+                        const subsegment_cleave &cleave,
+                        const subsegment_opts &opts){
+    if(ROI.contours.empty()) throw std::logic_error("Unable to split empty contour collection.");
+
+    std::pmr::monotonic_buffer_resource arena;
+    const auto pc = Pack_Contours(ROI.contours, false, &arena);
+
+    long int iters_taken = 0;
+    double final_area_frac = 0.0;
+    const auto lower_plane = Area_Bisection_Along_Plane(pc, cleave.N, cleave.lower, opts.fractional_tolerance,
+                                                        opts.max_bisects, &iters_taken, &final_area_frac);
+    FUNCINFO("Bisection: planar area fraction"
+             << " above LOWER plane with normal: " << cleave.N
+             << " was " << final_area_frac << "."
+             << " Requested: " << cleave.lower << "."
+             << " Iters: " << iters_taken);
+
+    const auto upper_plane = Area_Bisection_Along_Plane(pc, cleave.N, cleave.upper, opts.fractional_tolerance,
+                                                        opts.max_bisects, &iters_taken, &final_area_frac);
+    FUNCINFO("Bisection: planar area fraction"
+             << " above UPPER plane with normal: " << cleave.N
+             << " was " << final_area_frac << "."
+             << " Requested: " << cleave.upper << "."
+             << " Iters: " << iters_taken);
+
+    return std::make_pair(lower_plane, upper_plane);
+}
+
+// Selects the portion of the ROI above the lower plane and below the upper plane.
+contour_collection<double> subsegment_interior(const contour_collection<double> &ROI, const plane_pair_t &planes){
+    auto split1 = ROI.Split_Along_Plane(planes.first);
+    if(split1.size() != 2){
+        throw std::logic_error("Expected exactly two groups, above and below plane.");
+    }
+    auto split2 = split1.back().Split_Along_Plane(planes.second);
+    if(split2.size() != 2){
+        throw std::logic_error("Expected exactly two groups, above and below plane.");
+    }
+
+    if( split2.front().contours.empty() ){
+        FUNCWARN("Selection contains no contours. Try adjusting your criteria.");
+    }
+    return std::move(split2.front());
+}
+
+// Finds the planes bounding the ROI's sub-segment. The sub-segment contours are clipped only if requested.
+subsegment_bounds subsegment_ROI(const contour_collection<double> &ROI,
+                                 const subsegment_opts &opts,
+                                 bool clip_contours){
+    subsegment_bounds out;
+    if(opts.nested){
+        contour_collection<double> running(ROI);
+        for(size_t j = 0; j < opts.cleaves.size(); ++j){
+            out.planes.push_back( bisect_ROI(running, opts.cleaves[j], opts) );
+            if( clip_contours || ((j + 1) < opts.cleaves.size()) ){
+                running = subsegment_interior(running, out.planes.back());
+            }
+        }
+        if(clip_contours) out.contours = std::move(running);
+        return out;
+    }
+
+    // Compound cleaves only depend on the original ROI, so their planes can be found concurrently.
+    out.planes.resize(opts.cleaves.size());
+    {
+        task_group tg;
+        for(size_t j = 0; j < opts.cleaves.size(); ++j){
+            tg.run([&, j]() -> void {
+                out.planes[j] = bisect_ROI(ROI, opts.cleaves[j], opts);
+            });
+        }
+        tg.wait();
+    }
+
+    if(clip_contours){
+        out.contours = ROI;
+        for(const auto &p : out.planes) out.contours = subsegment_interior(out.contours, p);
+    }
+    return out;
+}
+
+} // namespace
+
+
+plane<double> Area_Bisection_Along_Plane(const packed_contours &pc,
+                                         const vec3<double> &N_in,
+                                         double fraction_above,
+                                         double tolerance,
+                                         long int max_bisects,
+                                         long int *iters_taken,
+                                         double *final_fraction){
+    const auto N = N_in.unit();
+    const double total = total_area_above(pc, N, -std::numeric_limits<double>::infinity());
+    if(!std::isfinite(total) || !(0.0 < total)){
+        throw std::invalid_argument("Contours enclose no area. Unable to bisect.");
+    }
+
+    // The fraction of area above the plane decreases monotonically as the plane moves along the normal.
+    double s_lo = std::numeric_limits<double>::infinity();
+    double s_hi = -s_lo;
+    for(size_t k = 0; k < pc.x.size(); ++k){
+        const double s = pc.x[k] * N.x + pc.y[k] * N.y + pc.z[k] * N.z;
+        s_lo = std::min(s_lo, s);
+        s_hi = std::max(s_hi, s);
+    }
+
+    long int iters = 0;
+    double s = 0.5 * (s_lo + s_hi);
+    double frac = total_area_above(pc, N, s) / total;
+    while( (++iters < max_bisects)
+       &&  (tolerance < std::abs(frac - fraction_above)) ){
+        if(fraction_above < frac){
+            s_lo = s;
+        }else{
+            s_hi = s;
+        }
+        s = 0.5 * (s_lo + s_hi);
+        frac = total_area_above(pc, N, s) / total;
+    }
+
+    if(iters_taken != nullptr) *iters_taken = iters;
+    if(final_fraction != nullptr) *final_fraction = frac;
+    return plane<double>(N, N * s);
+}
+
+
+std::vector<contour_collection<double>>
+Subsegment_ROIs(const std::list<std::reference_wrapper<contour_collection<double>>> &ROIs,
+                const subsegment_opts &opts){
+    auto bounds = Subsegment_ROI_Bounds(ROIs, opts, true);
+
+    std::vector<contour_collection<double>> out;
+    auto b_it = std::begin(bounds);
+    for(const auto &cc_ref : ROIs){
+        if(!cc_ref.get().contours.empty()) out.emplace_back( std::move(b_it->contours) );
+        ++b_it;
+    }
+    return out;
+}
+
+
+std::vector<subsegment_bounds>
+Subsegment_ROI_Bounds(const std::list<std::reference_wrapper<contour_collection<double>>> &ROIs,
+                      const subsegment_opts &opts,
+                      bool clip_contours){
+    const std::vector<std::reference_wrapper<contour_collection<double>>> refs(std::begin(ROIs), std::end(ROIs));
+
+    std::vector<subsegment_bounds> out(refs.size());
+    parallel_for(0, static_cast<long int>(refs.size()), [&](long int i){
+        if(refs[i].get().contours.empty()) return;
+        out[i] = subsegment_ROI(refs[i].get(), opts, clip_contours);
+    }, 1);
+    return out;
+}
@@ -0,0 +1,73 @@
+//Contour_Subsegmentation.h.
+
+#pragma once
+
+#include <functional>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Packed_Contours.h"
+
+
+// Finds the plane with the given (unit) normal such that the requested fraction of the total contour area lies above
+// it, i.e., on the side the normal points toward. The plane is found by bisection, stopping once the fraction is within
+// the tolerance or after the given number of bisections.
+//
+// Areas are evaluated by clipping the packed contours against the plane on the fly, so no contours are copied or
+// allocated while bisecting. Contours are treated as closed and planar. Throws if the contours enclose no area.
+plane<double> Area_Bisection_Along_Plane(const packed_contours &pc,
+                                         const vec3<double> &N,
+                                         double fraction_above,
+                                         double tolerance,
+                                         long int max_bisects,
+                                         long int *iters_taken = nullptr,
+                                         double *final_fraction = nullptr);
+
+
+// A pair of parallel cleaves. The fractions of the area that should remain above the lower and upper planes are given,
+// so the lower fraction is the larger of the two.
+struct subsegment_cleave {
+    vec3<double> N;
+    double lower = 1.0;
+    double upper = 0.0;
+};
+
+struct subsegment_opts {
+    // Nested cleaves partition the area remaining after the preceding cleaves. Otherwise (i.e., compound cleaves), all
+    // planes are found using the original ROI.
+    bool nested = true;
+
+    std::vector<subsegment_cleave> cleaves; // Performed in order.
+
+    double fractional_tolerance = 0.001;
+    long int max_bisects = 20;
+};
+
+// Extracts the portion of each ROI between every pair of cleaves. ROIs are processed in parallel, as are the planes of
+// compound cleaves. Results are returned in the order of the ROIs, omitting ROIs without contours.
+std::vector<contour_collection<double>>
+Subsegment_ROIs(const std::list<std::reference_wrapper<contour_collection<double>>> &ROIs,
+                const subsegment_opts &opts);
+
+
+// The planes bounding a sub-segment, and optionally its contours.
+//
+// The sub-segment is the portion of the ROI above every lower plane and below every upper plane, so it can also be
+// selected from a rasterized ROI by testing voxel centres against the planes rather than clipping the contours.
+struct subsegment_bounds {
+    std::vector<std::pair<plane<double>, plane<double>>> planes; // The (lower, upper) planes of each cleave, in order.
+
+    contour_collection<double> contours; // Empty unless requested.
+};
+
+// Finds the planes bounding each ROI's sub-segment, like Subsegment_ROIs. The final sub-segment contours are only
+// clipped if requested; nested cleaves always clip the intermediate sub-segments, since each pair of planes depends on
+// the area remaining after the preceding cleaves. Results are returned in the order of the ROIs, and ROIs without
+// contours have no planes.
+std::vector<subsegment_bounds>
+Subsegment_ROI_Bounds(const std::list<std::reference_wrapper<contour_collection<double>>> &ROIs,
+                      const subsegment_opts &opts,
+                      bool clip_contours);
@@ -4,13 +4,21 @@
 //
 
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <list>
+#include <stdexcept>
 //#include <utility>
 #include <tuple>
 #include <functional>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include <YgorMisc.h>
 #include <YgorString.h>
@@ -77,14 +85,12 @@ Node::emplace_child_node(Node &&n){
     return child_node;
 }
 
-// This routine writes the provided type to the provided stream. It verifies encoding, the expected length (in bytes)
-// are available to be written (and there are no extras). The number of bytes written is returned.
+// Verifies that a value can be written in binary form with the given encoding. Only little-endian encodings are
+// supported, and only on little-endian machines.
 template<class T>
-uint64_t
-write_to_stream( std::ostream &os,
-                 const T &x,
-                 uint64_t expected_length,
-                 Encoding enc ){
+void
+verify_binary_write( uint64_t expected_length,
+                     Encoding enc ){
 
     // Verify encoding can be handled.
     if( (enc != Encoding::ILE) 
@@ -111,14 +117,20 @@ write_to_stream( std::ostream &os,
     if(sizeof(T) != expected_length){
         throw std::runtime_error("Expected number of bytes does not match type size. (Is this intentional?)");
     }
+    return;
+}
 
-    // Write the bytes.
-    uint64_t written_length = 0;
-
+// This routine writes the provided type to the provided stream. It verifies encoding, the expected length (in bytes)
+// are available to be written (and there are no extras). The number of bytes written is returned.
+template<class T>
+uint64_t
+write_to_stream( std::ostream &os,
+                 const T &x,
+                 uint64_t expected_length,
+                 Encoding enc ){
+    verify_binary_write<T>(expected_length, enc);
     os.write(reinterpret_cast<const char *>(&x), sizeof(x));
-    written_length = expected_length;
-
-    return written_length;
+    return expected_length;
 }
 
 // Explicit instantiation for writing raw bytes via std::string.
@@ -148,152 +160,58 @@ write_to_stream( std::ostream &os,
     }
 
     // Write the bytes.
-    uint64_t written_length = 0;
-
     os.write(reinterpret_cast<const char *>(x.data()), available_length);
-    written_length = available_length;
-
-    return written_length;
+    return available_length;
 }
 
+// Appends the binary form of the provided type to a tag payload, with the same checks as write_to_stream().
+template<class T>
+void
+append_to_payload( std::string &payload,
+                   const T &x,
+                   uint64_t expected_length,
+                   Encoding enc ){
+    verify_binary_write<T>(expected_length, enc);
+    payload.append(reinterpret_cast<const char *>(&x), sizeof(x));
+    return;
+}
 
 
-// This routine emits a DICOM tag using the provided string of bytes payload. This routine handles writing the DICOM
-// structure.
-//
-// NOTE: The payload is treated as a string of bytes and is not interpretted or adjusted for endianness.
-//       All pre-processing should be taken care of before this routine is invoked.
-uint64_t
-emit_DICOM_tag(std::ostream &os,
-               Encoding enc,
-               const Node &node,   // Does not use the node's val member, to allow pre-processing.
-               const std::string& val){
-
-    uint64_t written_length = 0;
-
-    written_length += write_to_stream(os, node.key.group, 2, enc);
-    written_length += write_to_stream(os, node.key.tag, 2, enc);
-
-    // With implicit encoding all tags are written in the same way.
-    if(enc == Encoding::ILE){
-        // Deal with sequences separately.
-        if( node.VR == "SQ" ){
-            if(!val.empty()){
-                throw std::logic_error("'SQ' VR node passed data, but they can not have any data associated with them. (Is it intentional?)");
-            }
-
-            // Recursively emit the children to determine their lengths.
-            uint64_t seq_length = 0;
-            std::ostringstream seq_ss(std::ios_base::ate | std::ios_base::binary);
-
-            for(const auto &n : node.children){
-                std::ostringstream child_ss(std::ios_base::ate | std::ios_base::binary);
-                const uint64_t child_length = n.emit_DICOM(child_ss, enc, false);
-                const auto child_length_32 = static_cast<uint32_t>(child_length);
-
-                seq_length += write_to_stream(seq_ss, static_cast<uint16_t>(0xFFFE), 2, enc); // group.
-                seq_length += write_to_stream(seq_ss, static_cast<uint16_t>(0xE000), 2, enc); // tag.
-                seq_length += write_to_stream(seq_ss, child_length_32, 4, enc);
-                seq_length += write_to_stream(seq_ss, child_ss.str(), child_length, enc);
-            }
-
-            // Emit the full child lengths and serialized children.
-            const auto seq_length_32 = static_cast<uint32_t>(seq_length);
-            written_length += write_to_stream(os, seq_length_32, 4, enc);
-            written_length += write_to_stream(os, seq_ss.str(), seq_length, enc);
-
-        // All others.
-        }else{
-            const auto length    = static_cast<uint32_t>(val.length());
-            const auto add_space = static_cast<uint32_t>(length % 2);
-            const uint32_t full_length = (length + add_space);
-            const auto space_char = (node.VR == "UI") ? static_cast<unsigned char>('\0')
-                                                      : static_cast<unsigned char>(' ');
-
-            written_length += write_to_stream(os, full_length, 4, enc);
-            written_length += write_to_stream(os, val, length, enc);
-            if(0 < add_space) written_length += write_to_stream(os, space_char, 1, enc); // Ensure length is divisible by 2.
-        }
-
-    // With explicit encoding the VR is explicitly mentioned.
-    }else if(enc == Encoding::ELE){
-
-        // Deal with sequences separately.
-        if( node.VR == "SQ" ){
-            if(!val.empty()){
-                throw std::logic_error("'SQ' VR node passed data, but they can not have any data associated with them. (Is it intentional?)");
-            }
-
-            const uint16_t zero_16 = 0;
-            written_length += write_to_stream(os, node.VR, 2, enc);
-            written_length += write_to_stream(os, zero_16, 2, enc); // "Reserved" space.
-
-            // Recursively emit the children to determine their lengths.
-            uint64_t seq_length = 0;
-            std::ostringstream seq_ss(std::ios_base::ate | std::ios_base::binary);
-
-            for(const auto &n : node.children){
-                std::ostringstream child_ss(std::ios_base::ate | std::ios_base::binary);
-                const uint64_t child_length = n.emit_DICOM(child_ss, enc, false);
-                const auto child_length_32 = static_cast<uint32_t>(child_length);
-
-                // Emit a tag containing the length of the child.
-                seq_length += write_to_stream(seq_ss, static_cast<uint16_t>(0xFFFE), 2, enc); // group.
-                seq_length += write_to_stream(seq_ss, static_cast<uint16_t>(0xE000), 2, enc); // tag.
-                seq_length += write_to_stream(seq_ss, child_length_32, 4, enc);
-                seq_length += write_to_stream(seq_ss, child_ss.str(), child_length, enc);
-            }
-
-            // Emit the full child lengths and serialized children.
-            const auto seq_length_32 = static_cast<uint32_t>(seq_length);
-            written_length += write_to_stream(os, seq_length_32, 4, enc);
-            written_length += write_to_stream(os, seq_ss.str(), seq_length, enc);
-
-        // Some tags have reserved space.
-        }else if( (node.VR == "OB")
-              ||  (node.VR == "OW")
-              ||  (node.VR == "OF")
-              ||  (node.VR == "UT")
-              ||  (node.VR == "UN") ){
-            const auto length    = static_cast<uint32_t>(val.length());
-            const auto add_space = static_cast<uint32_t>(length % 2);
-            const uint32_t full_length = (length + add_space);
-            const uint16_t zero_16 = 0;
-            const uint8_t space_char = 0;
-
-            written_length += write_to_stream(os, node.VR, 2, enc);
-            written_length += write_to_stream(os, zero_16, 2, enc); // "Reserved" space.
-            written_length += write_to_stream(os, full_length, 4, enc);
+// DICOM files are written in two passes. The first pass validates every node, converts values that are not written
+// verbatim, and records the length of every node. Sequence lengths precede their items, so knowing them up-front lets
+// the second pass stream all tags directly to the output without buffering (and copying) nested sequences.
+namespace {
 
-            written_length += write_to_stream(os, val, length, enc);
-            if(0 < add_space) written_length += write_to_stream(os, space_char, 1, enc); // Ensure length is divisible by 2.
+// Per-node state, stored in depth-first order.
+struct emit_plan_t {
+    uint64_t length = 0;          // Bytes emitted for the node, including any tag header.
+    uint64_t payload_length = 0;  // Bytes of the value, before padding. For sequences, the bytes of all items.
+    size_t extent = 1;            // The number of plans for the node and all of its descendants.
+    bool converted = false;       // Whether the payload is 'bytes' rather than the node's value.
+    std::string bytes;
+};
 
-        // All others do not.
-        }else{
-            const auto length    = static_cast<uint16_t>(val.length());
-            const auto add_space = static_cast<uint16_t>(length % 2);
-            const uint16_t full_length = (length + add_space);
-            const auto space_char = (node.VR == "UI") ? static_cast<unsigned char>('\0')
-                                                      : static_cast<unsigned char>(' ');
+class dicom_emitter {
+  public:
+    uint64_t plan(const Node &node, Encoding enc, bool is_root_node);
+    uint64_t write(std::ostream &os, const Node &node, Encoding enc, bool is_root_node);
 
-            written_length += write_to_stream(os, node.VR, 2, enc);
-            written_length += write_to_stream(os, full_length, 2, enc);
+  private:
+    std::vector<emit_plan_t> plans;
+    size_t next = 0; // The next plan to be consumed while writing.
 
-            written_length += write_to_stream(os, val, length, enc);
-            if(0 < add_space) written_length += write_to_stream(os, space_char, 1, enc); // Ensure length is divisible by 2.
-        }
-         
-    }else{
-        throw std::runtime_error("Unsupported encoding specified. Refusing to continue.");
+    const std::string & payload(const Node &node, const emit_plan_t &p) const {
+        return p.converted ? p.bytes : node.val;
     }
+};
 
-    return written_length;
-}
-
-// This routine will recursively write a DICOM file from this node and all of its children.
-uint64_t Node::emit_DICOM(std::ostream &os,
-                          Encoding enc,
-                          bool is_root_node) const {
+// Validates a node's value and converts it to the bytes that will be written, if they differ from the value.
+//
+// NOTE: The payload is treated as a string of bytes and is not interpretted or adjusted for endianness afterward.
+void
+encode_value( const Node &node,
+              Encoding enc,
+              emit_plan_t &p ){
 
     // Used to search for forbidden characters.
     const std::string upper_case("ABCDEFGHIJKLMNOPQRSTUVWXYZ");
@@ -301,134 +219,61 @@ uint64_t Node::emit_DICOM(std::ostream &os,
     const std::string number_digits("0123456789");
     const std::string multiplicity(R"***(\)***"); // Value multiplicity separator.
 
-    uint64_t cumulative_length = 0;
-
-    // If this is the root node, ignore the VR and treat it as a simple container of children.
-    if(is_root_node){
-        // Verify the node does not have any data associated with it. If it does, it probably indicates a logic
-        // error since only children nodes should contain data.
-        if(!this->val.empty()){
-            throw std::logic_error("Nodes with 'SQ' VR can not have any data associated with them. (Is it intentional?)");
-        }
-
-        // Emit the DICM header before processing any nodes.
-        const std::string header = std::string(128, '\0') + std::string("DICM");
-        cumulative_length += write_to_stream(os, header, 132, enc);
-
-        // Process children nodes. To generate group lengths we need to emit them in bunches.
-        std::ostringstream child_ss(std::ios_base::ate | std::ios_base::binary);
-        uint64_t group_length = 0;
-        const auto end_child = std::end(this->children);
-        for(auto child_it = std::begin(this->children); child_it != end_child; ++child_it){
-            
-            // Always emit the meta information header tags (group = 0x0002) with little endian explicit encoding.
-            Encoding child_enc = (child_it->key.group <= 0x0002) ? Encoding::ELE : enc;
-                
-            // Emit this node into the temp buffer.
-            group_length += child_it->emit_DICOM(child_ss, child_enc, false);
-
-            // Evaluate whether the following node will be from a different group.
-            // If so, emit the group length tag and all children in the buffer.
-            const auto next_child_it = std::next(child_it);
-            if( (next_child_it == end_child) 
-            ||  (child_it->key.group != next_child_it->key.group) ){
-
-                // Emit the group length tag.
-                if( (child_it->key.group <= 0x0002)
-                &&  (child_enc == Encoding::ELE) ){  // TODO: Should I bother with this after group 0x0002? It is deprecated...
-                    Node group_length_node({child_it->key.group, 0x0000}, "UL", std::to_string(group_length));
-                    cumulative_length += group_length_node.emit_DICOM(os, child_enc, false);
-                }
-
-                // Emit all the children from the buffer.
-                os.write(reinterpret_cast<const char*>(child_ss.str().data()), group_length);
-                cumulative_length += group_length;
-
-                // Reset the children buffer.
-                group_length = 0;
-                std::ostringstream new_ss(std::ios_base::ate | std::ios_base::binary);
-                child_ss.swap(new_ss);
-            }
-        }
-
-    }else if( this->VR == "MULTI" ){ 
-        // Not a true DICOM VR. Used to emit children without any boilerplate (cf. the 'SQ' VR).
-        
-        // Verify the node does not have any data associated with it. If it does, it probably indicates a logic
-        // error since only children nodes should contain data.
-        if(!this->val.empty()){
-            throw std::logic_error("'MULTI' nodes can not have any data associated with them. (Is it intentional?)");
-        }
-
-        // Process children nodes serially, without any boilerplate or markers between children.
-        for(const auto & c : this->children){
-            cumulative_length += c.emit_DICOM(os, enc, false);
-        }
-
     // Text types.
-    }else if( this->VR == "CS" ){ //Code strings.
+    if( node.VR == "CS" ){ //Code strings.
         // Value multiplicity embiggens the maximum permissable length, but each individual element should be <= 16 chars.
-        auto tokens = SplitStringToVector(this->val,'\\','d');
+        auto tokens = SplitStringToVector(node.val,'\\','d');
         for(const auto &token : tokens){
             if(16 < token.length()) throw std::invalid_argument("Code string is too long. Cannot continue.");
         }
 
-        if(this->val.find_first_not_of(upper_case + number_digits + multiplicity + "_ ") != std::string::npos){
+        if(node.val.find_first_not_of(upper_case + number_digits + multiplicity + "_ ") != std::string::npos){
             throw std::invalid_argument("Invalid character found in code string. Cannot continue.");
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
 
-    }else if( this->VR == "SH" ){ //Short string.
-        if(16 < this->val.length()) throw std::runtime_error("Short string is too long. Consider using a longer VR. Cannot continue.");
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "SH" ){ //Short string.
+        if(16 < node.val.length()) throw std::runtime_error("Short string is too long. Consider using a longer VR. Cannot continue.");
 
-    }else if( this->VR == "LO" ){ //Long strings.
-        if(64 < this->val.length()) throw std::runtime_error("Long string is too long. Consider using a longer VR. Cannot continue.");
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "LO" ){ //Long strings.
+        if(64 < node.val.length()) throw std::runtime_error("Long string is too long. Consider using a longer VR. Cannot continue.");
 
-    }else if( this->VR == "ST" ){ //Short text.
-        if(1024 < this->val.length()) throw std::runtime_error("Short text is too long. Consider using a longer VR. Cannot continue.");
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "ST" ){ //Short text.
+        if(1024 < node.val.length()) throw std::runtime_error("Short text is too long. Consider using a longer VR. Cannot continue.");
 
-    }else if( this->VR == "LT" ){ //Long text.
-        if(10240 < this->val.length()) throw std::runtime_error("Long text is too long. Consider using a longer VR. Cannot continue.");
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "LT" ){ //Long text.
+        if(10240 < node.val.length()) throw std::runtime_error("Long text is too long. Consider using a longer VR. Cannot continue.");
 
-    }else if( this->VR == "UT" ){ //Unlimited text.
-        if(4'294'967'294 < this->val.length()) throw std::runtime_error("Unlimited text is too long. Cannot continue.");
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "UT" ){ //Unlimited text.
+        if(4'294'967'294 < node.val.length()) throw std::runtime_error("Unlimited text is too long. Cannot continue.");
 
 
     // Name types.
-    }else if( this->VR == "AE" ){ //Application entity.
-        if(16 < this->val.length()) throw std::runtime_error("Application entity is too long. Cannot continue.");
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "AE" ){ //Application entity.
+        if(16 < node.val.length()) throw std::runtime_error("Application entity is too long. Cannot continue.");
 
-    }else if( this->VR == "PN" ){ //Person name.
-        if(64 < this->val.length()) throw std::runtime_error("Person name is too long. Cannot continue.");
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "PN" ){ //Person name.
+        if(64 < node.val.length()) throw std::runtime_error("Person name is too long. Cannot continue.");
 
-    }else if( this->VR == "UI" ){ //Unique Identifier (UID).
-        if(64 < this->val.length()) throw std::runtime_error("UID is too long. Cannot continue.");
+    }else if( node.VR == "UI" ){ //Unique Identifier (UID).
+        if(64 < node.val.length()) throw std::runtime_error("UID is too long. Cannot continue.");
         // Does value multiplicity embiggen the maximum permissable length? TODO
-        if(this->val.find_first_not_of(number_digits + multiplicity + ".") != std::string::npos){
+        if(node.val.find_first_not_of(number_digits + multiplicity + ".") != std::string::npos){
             throw std::invalid_argument("Invalid character found in UID. Cannot continue.");
         }
 
         // Ensure there are no leading insignificant zeros.
-        auto tokens = SplitStringToVector(this->val,'.','d');
+        auto tokens = SplitStringToVector(node.val,'.','d');
         for(const auto &token : tokens){
             if( (1 < token.size()) && (token.at(0) == '0') ){
                 throw std::invalid_argument("UID contains an insignificant leading zero. Refusing to continue.");
             }
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
 
 
     //Date and Time.
-    }else if( this->VR == "DA" ){  //Date.
+    }else if( node.VR == "DA" ){  //Date.
         //Strip away colons. Also strip away everything after the leading non-numeric char.
-        std::string digits_only(val);
+        std::string digits_only(node.val);
         digits_only = PurgeCharsFromString(digits_only,":-");
         auto avec = SplitStringToVector(digits_only,'.','d');
         avec.resize(1);
@@ -438,11 +283,12 @@ uint64_t Node::emit_DICOM(std::ostream &os,
         if(digits_only.find_first_not_of(number_digits) != std::string::npos){
             throw std::invalid_argument("Invalid character found in date. Cannot continue.");
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, digits_only);
+        p.bytes = std::move(digits_only);
+        p.converted = true;
 
-    }else if( this->VR == "TM" ){  //Time.
+    }else if( node.VR == "TM" ){  //Time.
         //Strip away colons. Also strip away everything after the leading non-numeric char.
-        std::string digits_only(val);
+        std::string digits_only(node.val);
         digits_only = PurgeCharsFromString(digits_only,":-");
         auto avec = SplitStringToVector(digits_only,'.','d');
         avec.resize(1);
@@ -452,11 +298,12 @@ uint64_t Node::emit_DICOM(std::ostream &os,
         if(digits_only.find_first_not_of(number_digits + ".") != std::string::npos){
             throw std::invalid_argument("Invalid character found in time. Cannot continue.");
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, digits_only);
+        p.bytes = std::move(digits_only);
+        p.converted = true;
 
-    }else if( this->VR == "DT" ){  //Date Time.
+    }else if( node.VR == "DT" ){  //Date Time.
         //Strip away colons. Also strip away everything after the leading non-numeric char.
-        std::string digits_only(val);
+        std::string digits_only(node.val);
         digits_only = PurgeCharsFromString(digits_only,":-");
         auto avec = SplitStringToVector(digits_only,'.','d');
         avec.resize(1);
@@ -466,41 +313,39 @@ uint64_t Node::emit_DICOM(std::ostream &os,
         if(digits_only.find_first_not_of(number_digits + "+-.") != std::string::npos){
             throw std::invalid_argument("Invalid character found in date-time. Cannot continue.");
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, digits_only);
+        p.bytes = std::move(digits_only);
+        p.converted = true;
 
-    }else if( this->VR == "AS" ){ //Age string.
-        if(4 < this->val.length()) throw std::runtime_error("Age string is too long. Cannot continue.");
-        if(this->val.find_first_not_of(number_digits + "DWMY") != std::string::npos){
+    }else if( node.VR == "AS" ){ //Age string.
+        if(4 < node.val.length()) throw std::runtime_error("Age string is too long. Cannot continue.");
+        if(node.val.find_first_not_of(number_digits + "DWMY") != std::string::npos){
             throw std::invalid_argument("Invalid character found in age string. Cannot continue.");
         }
-        if(this->val.find_first_of("DWMY") == std::string::npos){
+        if(node.val.find_first_of("DWMY") == std::string::npos){
             throw std::invalid_argument("Age string is missing one of 'DWMY' characters. Cannot continue.");
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
 
 
     //Binary types.
-    }else if( this->VR == "OB" ){ //'Other' binary string: a string of bytes that doesn't fit any other VR.
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "OB" ){ //'Other' binary string: a string of bytes that doesn't fit any other VR.
 
-    }else if( this->VR == "OW" ){ //'Other word string': a string of 16bit values.
+    }else if( node.VR == "OW" ){ //'Other word string': a string of 16bit values.
         // Note: Assuming here that the list is represented as a string of unsigned integers (e.g., '123\234\0\25').
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        auto tokens = SplitStringToVector(this->val, '\\', 'd');
+        auto tokens = SplitStringToVector(node.val, '\\', 'd');
         if(tokens.empty()) throw std::runtime_error("No values found for encoding OW tag. Cannot continue.");
         for(auto &token_val : tokens){
             const auto val_u = static_cast<uint16_t>(std::stoul(token_val));
-            write_to_stream(ss, val_u, 2, enc);
+            append_to_payload(p.bytes, val_u, 2, enc);
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
+        p.converted = true;
 
 
     //Numeric types that are written as a string of characters.
-    }else if( this->VR == "IS" ){ //Integer string.
+    }else if( node.VR == "IS" ){ //Integer string.
         // I'm not sure if what the upper limit is for this VR type. Assuming 65534 for consistency with DS. TODO.
-        if(65534 < this->val.length()) throw std::invalid_argument("Decimal string is too long. Cannot continue.");
+        if(65534 < node.val.length()) throw std::invalid_argument("Decimal string is too long. Cannot continue.");
 
-        auto tokens = SplitStringToVector(this->val,'\\','d');
+        auto tokens = SplitStringToVector(node.val,'\\','d');
         for(const auto &token : tokens){
             // Maximum length per decimal number: 16 bytes.
             if(12 < token.length()) throw std::invalid_argument("Integer string element is too long. Cannot continue.");
@@ -513,128 +358,416 @@ uint64_t Node::emit_DICOM(std::ostream &os,
             }
         }
 
-        if(this->val.find_first_not_of(number_digits + multiplicity + "+-") != std::string::npos){
+        if(node.val.find_first_not_of(number_digits + multiplicity + "+-") != std::string::npos){
             throw std::invalid_argument("Invalid character found in integer string. Cannot continue.");
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
 
-    }else if( this->VR == "DS" ){ //Decimal string.
+    }else if( node.VR == "DS" ){ //Decimal string.
         // Maximum length for entire string (when multiple values are encoded and each is <= 16 bytes): 65534 bytes
-        if(65534 < this->val.length()) throw std::invalid_argument("Decimal string is too long. Cannot continue.");
+        if(65534 < node.val.length()) throw std::invalid_argument("Decimal string is too long. Cannot continue.");
+
+        if(node.val.find_first_not_of(number_digits + multiplicity + "+-eE.") != std::string::npos){
+            throw std::invalid_argument("Invalid character found in decimal string. Cannot continue.");
+        }
+
+        // Elements are parsed in-place since DS tags, e.g., contour data, can hold thousands of elements.
+        std::array<char, 17> element;
+        for(size_t begin = 0; begin < node.val.size(); ){
+            const auto end = std::min(node.val.find('\\', begin), node.val.size());
+            const auto len = end - begin;
 
-        auto tokens = SplitStringToVector(this->val,'\\','d');
-        for(const auto &token : tokens){
             // Maximum length per decimal number: 16 bytes.
-            if(16 < token.length()) throw std::invalid_argument("Decimal string element is too long. Cannot continue.");
+            if(16 < len) throw std::invalid_argument("Decimal string element is too long. Cannot continue.");
 
             // Ensure that, if an element is present it parses as a number.
-            try{
-                if(!token.empty()) [[maybe_unused]] auto r = std::stod(token);
-            }catch(const std::exception &e){
-                throw std::runtime_error("Unable to convert '"_s + token + "' to DS. Cannot continue.");
+            if(0 < len){
+                node.val.copy(element.data(), len, begin);
+                element[len] = '\0';
+                char *parsed_end = nullptr;
+                errno = 0;
+                [[maybe_unused]] const auto r = std::strtod(element.data(), &parsed_end);
+                if( (parsed_end == element.data()) || (errno == ERANGE) ){
+                    throw std::runtime_error("Unable to convert '"_s + element.data() + "' to DS. Cannot continue.");
+                }
             }
+            begin = end + 1;
         }
 
-        if(this->val.find_first_not_of(number_digits + multiplicity + "+-eE.") != std::string::npos){
-            throw std::invalid_argument("Invalid character found in decimal string. Cannot continue.");
-        }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
-
 
     //Numeric types that must be binary encoded.
-    }else if( this->VR == "FL" ){ //Floating-point.
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        const float val_f = std::stof(this->val);
-        write_to_stream(ss, val_f, 4, enc);
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
+    }else if( node.VR == "FL" ){ //Floating-point.
+        const float val_f = std::stof(node.val);
+        append_to_payload(p.bytes, val_f, 4, enc);
+        p.converted = true;
         // TODO: Ensure IEEE 754:1985 32-bit format.
 
-    }else if( this->VR == "FD" ){ //Floating-point double.
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        const double val_d = std::stod(this->val);
-        write_to_stream(ss, val_d, 8, enc);
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
+    }else if( node.VR == "FD" ){ //Floating-point double.
+        const double val_d = std::stod(node.val);
+        append_to_payload(p.bytes, val_d, 8, enc);
+        p.converted = true;
         // TODO: Ensure IEEE 754:1985 64-bit format.
 
-    }else if( this->VR == "OF" ){ //"Other" floating-point.
+    }else if( node.VR == "OF" ){ //"Other" floating-point.
         //The value payload may contain multiple floats separated by some partitioning character.
         // For example, '1.23\2.34\0.00\25E25\-1.23'.
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        auto tokens = SplitStringToVector(this->val, '\\', 'd');
+        auto tokens = SplitStringToVector(node.val, '\\', 'd');
         for(auto &token_val : tokens){
             const float val_f = std::stof(token_val);
-            write_to_stream(ss, val_f, 4, enc);
+            append_to_payload(p.bytes, val_f, 4, enc);
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
+        p.converted = true;
         // TODO: Ensure IEEE 754:1985 32-bit format.
 
-    }else if( this->VR == "OD" ){ //"Other" floating-point double.
+    }else if( node.VR == "OD" ){ //"Other" floating-point double.
         //The value payload may contain multiple floats separated by some partitioning character.
         // For example, '1.23\2.34\0.00\25E25\-1.23'.
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        auto tokens = SplitStringToVector(this->val, '\\', 'd');
+        auto tokens = SplitStringToVector(node.val, '\\', 'd');
         for(auto &token_val : tokens){
             const float val_f = std::stod(token_val);
-            write_to_stream(ss, val_f, 8, enc);
+            append_to_payload(p.bytes, val_f, 8, enc);
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
+        p.converted = true;
         // TODO: Ensure IEEE 754:1985 64-bit format.
 
-    }else if( this->VR == "SS" ){ //Signed short (16bit).
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        const int16_t val_i = std::stoi(this->val);
-        write_to_stream(ss, val_i, 2, enc);
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
-
-    }else if( this->VR == "US" ){ //Unsigned short (16bit).
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        const auto val_u = static_cast<uint16_t>(std::stoul(this->val));
-        write_to_stream(ss, val_u, 2, enc);
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
-
-    }else if( this->VR == "SL" ){ //Signed long (32bit).
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        const int32_t val_l = std::stol(this->val);
-        write_to_stream(ss, val_l, 4, enc);
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
-
-    }else if( this->VR == "UL" ){ //Unsigned long (32bit).
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        const uint32_t val_ul = std::stoul(this->val);
-        write_to_stream(ss, val_ul, 4, enc);
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
-
-    }else if( this->VR == "AT" ){ //Attribute tag (2x unsigned shorts representing a DICOM data tag).
+    }else if( node.VR == "SS" ){ //Signed short (16bit).
+        const int16_t val_i = std::stoi(node.val);
+        append_to_payload(p.bytes, val_i, 2, enc);
+        p.converted = true;
+
+    }else if( node.VR == "US" ){ //Unsigned short (16bit).
+        const auto val_u = static_cast<uint16_t>(std::stoul(node.val));
+        append_to_payload(p.bytes, val_u, 2, enc);
+        p.converted = true;
+
+    }else if( node.VR == "SL" ){ //Signed long (32bit).
+        const int32_t val_l = std::stol(node.val);
+        append_to_payload(p.bytes, val_l, 4, enc);
+        p.converted = true;
+
+    }else if( node.VR == "UL" ){ //Unsigned long (32bit).
+        const uint32_t val_ul = std::stoul(node.val);
+        append_to_payload(p.bytes, val_ul, 4, enc);
+        p.converted = true;
+
+    }else if( node.VR == "AT" ){ //Attribute tag (2x unsigned shorts representing a DICOM data tag).
         // Assuming the value payload contains exactly two unsigned integers, e.g., '123\234'.
-        std::ostringstream ss(std::ios_base::ate | std::ios_base::binary);
-        auto tokens = SplitStringToVector(this->val, '\\', 'd');
+        auto tokens = SplitStringToVector(node.val, '\\', 'd');
         if(tokens.size() != 2) throw std::runtime_error("Invalid number of integers for AT type tag; exactly 2 are needed.");
         for(auto &token_val : tokens){
             const auto val_u = static_cast<uint16_t>(std::stoul(token_val));
-            write_to_stream(ss, val_u, 2, enc);
+            append_to_payload(p.bytes, val_u, 2, enc);
         }
-        cumulative_length += emit_DICOM_tag(os, enc, *this, ss.str());
+        p.converted = true;
 
 
     //Other types.
-    }else if( this->VR == "UN" ){ //Unknown. Often needed for handling private DICOM tags.
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+    }else if( node.VR == "UN" ){ //Unknown. Often needed for handling private DICOM tags.
+
+    }else{
+        throw std::runtime_error("Unknown VR type. Cannot write to tag.");
+    }
+    return;
+}
+
+// The number of bytes preceding the payload of a tag.
+uint64_t
+tag_header_length( const Node &node,
+                   Encoding enc ){
+    if(enc == Encoding::ILE) return 8; // Group, tag, and a 4-byte length.
+    if(enc == Encoding::ELE){
+        if( (node.VR == "SQ")
+        ||  (node.VR == "OB")
+        ||  (node.VR == "OW")
+        ||  (node.VR == "OF")
+        ||  (node.VR == "UT")
+        ||  (node.VR == "UN") ){
+            return 12; // Group, tag, VR, reserved space, and a 4-byte length.
+        }
+        return 8; // Group, tag, VR, and a 2-byte length.
+    }
+    throw std::runtime_error("Unsupported encoding specified. Refusing to continue.");
+}
 
-    }else if( this->VR == "SQ" ){ //Sequence.
+uint64_t
+dicom_emitter::plan(const Node &node,
+                    Encoding enc,
+                    bool is_root_node){
+    const auto i = this->plans.size();
+    this->plans.emplace_back(); // Note: references are invalidated by the recursive calls below.
+
+    uint64_t length = 0;
+    uint64_t payload_length = 0;
+
+    // If this is the root node, ignore the VR and treat it as a simple container of children.
+    if(is_root_node){
         // Verify the node does not have any data associated with it. If it does, it probably indicates a logic
         // error since only children nodes should contain data.
-        if(!this->val.empty()){
+        if(!node.val.empty()){
             throw std::logic_error("Nodes with 'SQ' VR can not have any data associated with them. (Is it intentional?)");
         }
 
-        // Recursive calls happen in the following routine.
-        cumulative_length += emit_DICOM_tag(os, enc, *this, this->val);
+        length += 132; // The DICM header.
+        const auto end_child = std::end(node.children);
+        for(auto child_it = std::begin(node.children); child_it != end_child; ++child_it){
+            // Always emit the meta information header tags (group = 0x0002) with little endian explicit encoding.
+            const Encoding child_enc = (child_it->key.group <= 0x0002) ? Encoding::ELE : enc;
+            length += this->plan(*child_it, child_enc, false);
+
+            // Account for the group length tag emitted ahead of the meta information groups.
+            const auto next_child_it = std::next(child_it);
+            if( (child_it->key.group <= 0x0002)
+            &&  ( (next_child_it == end_child)
+               || (child_it->key.group != next_child_it->key.group) ) ){
+                length += 12;
+            }
+        }
+
+    }else if( node.VR == "MULTI" ){
+        // Not a true DICOM VR. Used to emit children without any boilerplate (cf. the 'SQ' VR).
+        if(!node.val.empty()){
+            throw std::logic_error("'MULTI' nodes can not have any data associated with them. (Is it intentional?)");
+        }
+        for(const auto &c : node.children){
+            length += this->plan(c, enc, false);
+        }
+
+    }else if( node.VR == "SQ" ){
+        // Verify the node does not have any data associated with it. If it does, it probably indicates a logic
+        // error since only children nodes should contain data.
+        if(!node.val.empty()){
+            throw std::logic_error("Nodes with 'SQ' VR can not have any data associated with them. (Is it intentional?)");
+        }
+        for(const auto &c : node.children){
+            payload_length += 8; // The item tag and item length.
+            payload_length += this->plan(c, enc, false);
+        }
+        length = tag_header_length(node, enc) + payload_length;
 
     }else{
-        throw std::runtime_error("Unknown VR type. Cannot write to tag.");
+        encode_value(node, enc, this->plans[i]);
+        payload_length = static_cast<uint64_t>(this->payload(node, this->plans[i]).length());
+        if( (enc == Encoding::ELE)
+        &&  (tag_header_length(node, enc) == 8)
+        &&  (0xFFFF < payload_length + (payload_length % 2)) ){
+            throw std::runtime_error("Value is too long to be written with explicit encoding and this VR. Cannot continue.");
+        }
+        length = tag_header_length(node, enc) + payload_length + (payload_length % 2);
+    }
+
+    auto &p = this->plans[i];
+    p.length = length;
+    p.payload_length = payload_length;
+    p.extent = this->plans.size() - i;
+    return length;
+}
+
+uint64_t
+dicom_emitter::write(std::ostream &os,
+                     const Node &node,
+                     Encoding enc,
+                     bool is_root_node){
+    const auto &p = this->plans.at(this->next++);
+    uint64_t written_length = 0;
+
+    if(is_root_node){
+        // Emit the DICM header before processing any nodes.
+        const std::string header = std::string(128, '\0') + std::string("DICM");
+        written_length += write_to_stream(os, header, 132, enc);
+
+        // Meta information groups are preceded by their length, which is the sum of the planned lengths of the
+        // group's nodes.
+        const auto end_child = std::end(node.children);
+        bool group_begins = true;
+        for(auto child_it = std::begin(node.children); child_it != end_child; ++child_it){
+            // Always emit the meta information header tags (group = 0x0002) with little endian explicit encoding.
+            const Encoding child_enc = (child_it->key.group <= 0x0002) ? Encoding::ELE : enc;
+
+            if( group_begins
+            &&  (child_it->key.group <= 0x0002) ){
+                uint64_t group_length = 0;
+                size_t j = this->next;
+                for(auto g_it = child_it; (g_it != end_child) && (g_it->key.group == child_it->key.group); ++g_it){
+                    group_length += this->plans.at(j).length;
+                    j += this->plans.at(j).extent;
+                }
+                Node group_length_node({child_it->key.group, 0x0000}, "UL", std::to_string(group_length));
+                written_length += group_length_node.emit_DICOM(os, child_enc, false);
+            }
+
+            written_length += this->write(os, *child_it, child_enc, false);
+
+            const auto next_child_it = std::next(child_it);
+            group_begins = (next_child_it == end_child) || (child_it->key.group != next_child_it->key.group);
+        }
+
+    }else if( node.VR == "MULTI" ){
+        // Process children nodes serially, without any boilerplate or markers between children.
+        for(const auto &c : node.children){
+            written_length += this->write(os, c, enc, false);
+        }
+
+    }else{
+        written_length += write_to_stream(os, node.key.group, 2, enc);
+        written_length += write_to_stream(os, node.key.tag, 2, enc);
+
+        // With explicit encoding the VR is explicitly mentioned, and some VRs are followed by reserved space.
+        const auto header_length = tag_header_length(node, enc);
+        if(enc == Encoding::ELE){
+            written_length += write_to_stream(os, node.VR, 2, enc);
+        }
+        if( (enc == Encoding::ELE)
+        &&  (header_length == 12) ){
+            const uint16_t zero_16 = 0;
+            written_length += write_to_stream(os, zero_16, 2, enc); // "Reserved" space.
+        }
+
+        if( node.VR == "SQ" ){
+            const auto seq_length_32 = static_cast<uint32_t>(p.payload_length);
+            written_length += write_to_stream(os, seq_length_32, 4, enc);
+
+            for(const auto &c : node.children){
+                // Emit a tag containing the length of the child.
+                const auto child_length_32 = static_cast<uint32_t>(this->plans.at(this->next).length);
+                written_length += write_to_stream(os, static_cast<uint16_t>(0xFFFE), 2, enc); // group.
+                written_length += write_to_stream(os, static_cast<uint16_t>(0xE000), 2, enc); // tag.
+                written_length += write_to_stream(os, child_length_32, 4, enc);
+                written_length += this->write(os, c, enc, false);
+            }
+
+        }else{
+            const auto &val = this->payload(node, p);
+            const auto add_space = static_cast<uint32_t>(p.payload_length % 2);
+            const auto full_length = static_cast<uint32_t>(p.payload_length + add_space);
+            if(header_length == 12){
+                written_length += write_to_stream(os, full_length, 4, enc);
+            }else if(enc == Encoding::ELE){
+                written_length += write_to_stream(os, static_cast<uint16_t>(full_length), 2, enc);
+            }else{
+                written_length += write_to_stream(os, full_length, 4, enc);
+            }
+            written_length += write_to_stream(os, val, p.payload_length, enc);
+
+            // Ensure length is divisible by 2.
+            if(0 < add_space){
+                const bool pad_with_null = (node.VR == "UI")
+                                        || ( (enc == Encoding::ELE) && (header_length == 12) );
+                const auto space_char = pad_with_null ? static_cast<unsigned char>('\0')
+                                                      : static_cast<unsigned char>(' ');
+                written_length += write_to_stream(os, space_char, 1, enc);
+            }
+        }
+    }
+
+    if(written_length != p.length){
+        throw std::logic_error("Emitted length differs from the planned length. Refusing to continue.");
+    }
+    return written_length;
+}
+
+} // namespace
+
+
+// This routine will recursively write a DICOM file from this node and all of its children.
+uint64_t Node::emit_DICOM(std::ostream &os,
+                          Encoding enc,
+                          bool is_root_node) const {
+    if( (enc != Encoding::ILE)
+    &&  (enc != Encoding::ELE) ){
+        throw std::runtime_error("Unsupported encoding specified. Refusing to continue.");
+    }
+
+    dicom_emitter emitter;
+    emitter.plan(*this, enc, is_root_node);
+    return emitter.write(os, *this, enc, is_root_node);
+}
+
+
+sequence_writer::sequence_writer(std::ostream &os,
+                                 Encoding enc)
+                               : os(os),
+                                 enc(enc) {
+    if( (enc != Encoding::ILE)
+    &&  (enc != Encoding::ELE) ){
+        throw std::runtime_error("Unsupported encoding specified. Refusing to continue.");
+    }
+}
+
+uint64_t sequence_writer::begin_sequence(NodeKey key){
+    if( !this->item_open.empty()
+    &&  !this->item_open.back() ){
+        throw std::logic_error("Nested sequences must be written within an item. Refusing to continue.");
+    }
+    this->item_open.push_back(false);
+
+    uint64_t written_length = 0;
+    written_length += write_to_stream(this->os, key.group, 2, this->enc);
+    written_length += write_to_stream(this->os, key.tag, 2, this->enc);
+    if(this->enc == Encoding::ELE){
+        written_length += write_to_stream(this->os, std::string("SQ"), 2, this->enc);
+        written_length += write_to_stream(this->os, static_cast<uint16_t>(0), 2, this->enc); // "Reserved" space.
+    }
+    written_length += write_to_stream(this->os, static_cast<uint32_t>(0xFFFFFFFF), 4, this->enc); // Undefined length.
+    return written_length;
+}
+
+uint64_t sequence_writer::begin_item(){
+    if( this->item_open.empty()
+    ||  this->item_open.back() ){
+        throw std::logic_error("Items must be written directly within a sequence. Refusing to continue.");
     }
+    this->item_open.back() = true;
+
+    uint64_t written_length = 0;
+    written_length += write_to_stream(this->os, static_cast<uint16_t>(0xFFFE), 2, this->enc); // group.
+    written_length += write_to_stream(this->os, static_cast<uint16_t>(0xE000), 2, this->enc); // tag.
+    written_length += write_to_stream(this->os, static_cast<uint32_t>(0xFFFFFFFF), 4, this->enc); // Undefined length.
+    return written_length;
+}
+
+uint64_t sequence_writer::emit(const Node &node){
+    if( this->item_open.empty()
+    ||  !this->item_open.back() ){
+        throw std::logic_error("Nodes must be written within an item. Refusing to continue.");
+    }
+    return node.emit_DICOM(this->os, this->enc, false);
+}
+
+uint64_t sequence_writer::end_item(){
+    if( this->item_open.empty()
+    ||  !this->item_open.back() ){
+        throw std::logic_error("No item is open. Refusing to continue.");
+    }
+    this->item_open.back() = false;
+
+    uint64_t written_length = 0;
+    written_length += write_to_stream(this->os, static_cast<uint16_t>(0xFFFE), 2, this->enc); // group.
+    written_length += write_to_stream(this->os, static_cast<uint16_t>(0xE00D), 2, this->enc); // Item delimitation.
+    written_length += write_to_stream(this->os, static_cast<uint32_t>(0), 4, this->enc);
+    return written_length;
+}
+
+uint64_t sequence_writer::end_sequence(){
+    if( this->item_open.empty()
+    ||  this->item_open.back() ){
+        throw std::logic_error("No sequence is open, or an item is still open. Refusing to continue.");
+    }
+    this->item_open.pop_back();
+
+    uint64_t written_length = 0;
+    written_length += write_to_stream(this->os, static_cast<uint16_t>(0xFFFE), 2, this->enc); // group.
+    written_length += write_to_stream(this->os, static_cast<uint16_t>(0xE0DD), 2, this->enc); // Sequence delimitation.
+    written_length += write_to_stream(this->os, static_cast<uint32_t>(0), 4, this->enc);
+    return written_length;
+}
+
 
-    return cumulative_length;
+void append_decimal_string(std::string &out, double x){
+    // Equivalent to the default iostream formatting ('%g'), but without the stream overhead.
+    std::array<char, 32> buf;
+    const auto [end, ec] = std::to_chars(buf.data(), buf.data() + buf.size(), x, std::chars_format::general, 6);
+    if(ec != std::errc()) throw std::runtime_error("Unable to format decimal string element. Cannot continue.");
+    out.append(buf.data(), end);
+    return;
 }
 
 } // namespace DCMA_DICOM
@@ -2,8 +2,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <iosfwd>
 #include <functional>
+#include <string>
+#include <vector>
 
 #include <list>
 
@@ -59,6 +62,31 @@ struct Node {
 
 };
 
+// Incrementally writes sequences whose items are generated on-the-fly. Unlike 'SQ' nodes, sequences and items are
+// written with undefined length and closed by delimitation items, so items need not be held in memory until the whole
+// sequence is available. Sequences can be nested within items.
+//
+// Each member function returns the number of bytes written.
+class sequence_writer {
+  public:
+    sequence_writer(std::ostream &os, Encoding enc);
+
+    uint64_t begin_sequence(NodeKey key);
+    uint64_t begin_item();
+    uint64_t emit(const Node &node); // Writes a node and its children within the current item.
+    uint64_t end_item();
+    uint64_t end_sequence();
+
+  private:
+    std::ostream &os;
+    Encoding enc;
+    std::vector<bool> item_open; // One entry per open sequence, innermost last.
+};
+
+// Appends a number formatted as a decimal string (DS) element, as iostreams would format it by default.
+// Non-finite numbers are formatted, but are not valid DS elements.
+void append_decimal_string(std::string &out, double x);
+
 
 } // namespace DCMA_DICOM
 
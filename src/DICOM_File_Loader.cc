@@ -5,10 +5,16 @@
 
 #include <exception>
 #include <fstream>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
 #include <string>    
+#include <tuple>
+#include <vector>
 //#include <cfenv>              //Needed for std::feclearexcept(FE_ALL_EXCEPT).
 
 #include <boost/algorithm/string/predicate.hpp>
@@ -16,29 +22,134 @@
 #include <algorithm>
 #include <cstdlib>            //Needed for exit() calls.
 
-#include "Explicator.h"       //Needed for Explicator class.
 #include "Imebra_Shim.h"      //Wrapper for Imebra library. Black-boxed to speed up compilation.
+#include "Lexicon_Cache.h"
 #include "Structs.h"
+#include "Thread_Pool.h"
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 
+#include "DICOM_File_Loader.h"
+
+
+// The result of reading and decoding a single file. Decoding is the expensive part of loading, so it is performed
+// separately (and possibly concurrently) from the bookkeeping needed to incorporate the data into a Drover.
+struct decoded_dicom_file {
+    std::string Modality;
+    std::unique_ptr<TPlan_Config> tplan;
+    std::unique_ptr<Contour_Data> contours;
+    std::unique_ptr<Image_Array> imgs;
+    std::function<void(planar_image<float,double> &)> pixels; // Decodes the pixel data, if decoding was deferred.
+    std::optional<std::string> error; // If decoding failed, the reason why.
+};
 
 static
-std::unique_ptr<Contour_Data>
-Concatenate_Contour_Data(std::unique_ptr<Contour_Data> A,
-                         std::unique_ptr<Contour_Data> B){
-    //This routine concatenates A and B's contour collections. No internal checking is performed.
-    // No copying is performed, but A and B are consumed. A is returned as if it were a new pointer.
-    A->ccs.splice( A->ccs.end(), std::move(B->ccs) );
-    return A;
+decoded_dicom_file
+Decode_DICOM(const std::function<std::shared_ptr<Parsed_DICOM_File>(void)> &parse, bool defer_pixels = false){
+    decoded_dicom_file out;
+
+    //Parse the file only once. All subsequent accessors share the parsed data set, which is released when this
+    // routine returns.
+    std::shared_ptr<Parsed_DICOM_File> pdf;
+    try{
+        pdf = parse();
+        out.Modality = get_modality(pdf);
+    }catch(const std::exception &){
+        out.Modality = "";
+        return out;
+    };
+
+    try{
+        if(boost::iequals(out.Modality,"RTPLAN")){
+            out.tplan = Load_TPlan_Config(pdf);
+
+        }else if(boost::iequals(out.Modality,"RTSTRUCT")){
+            out.contours = get_Contour_Data(pdf);
+
+        }else if(boost::iequals(out.Modality,"RTDOSE")){
+            out.imgs = Load_Dose_Array(pdf);
+
+        }else if(  boost::iequals(out.Modality,"CT")
+                || boost::iequals(out.Modality,"OT")
+                || boost::iequals(out.Modality,"US")
+                || boost::iequals(out.Modality,"MR")
+                || boost::iequals(out.Modality,"RTIMAGE")
+                || boost::iequals(out.Modality,"PT") ){
+            if(defer_pixels){
+                std::tie(out.imgs, out.pixels) = Load_Image_Array_Deferred(pdf);
+            }else{
+                out.imgs = Load_Image_Array(pdf);
+            }
+        }
+    }catch(const std::exception &e){
+        out.error = e.what();
+    }
+    return out;
+}
+
+static
+decoded_dicom_file
+Decode_DICOM_File(const std::string &Filename, bool defer_pixels = false){
+    return Decode_DICOM([&](){ return Parse_DICOM_File(Filename); }, defer_pixels);
+}
+
+
+dicom_predecode_cache::dicom_predecode_cache(long int max_in_flight) : tasks(max_in_flight) {}
+
+dicom_predecode_cache::~dicom_predecode_cache(){
+    try{
+        this->tasks.wait();
+    }catch(const std::exception &){}
+}
+
+void dicom_predecode_cache::add(const std::string &filename){
+    this->tasks.run([this, filename]() -> void {
+        auto d = std::make_unique<decoded_dicom_file>( Decode_DICOM_File(filename) );
+        std::lock_guard<std::mutex> lock(this->m);
+        this->decoded[filename] = std::move(d);
+    });
+    return;
+}
+
+void dicom_predecode_cache::add(const std::string &name, std::string contents){
+    auto c = std::make_shared<std::string>(std::move(contents));
+    this->tasks.run([this, name, c]() mutable -> void {
+        auto d = std::make_unique<decoded_dicom_file>( Decode_DICOM([&](){ return Parse_DICOM_Buffer(*c, name); }) );
+        c.reset(); // Release the raw data as soon as possible.
+        std::lock_guard<std::mutex> lock(this->m);
+        this->decoded[name] = std::move(d);
+    });
+    return;
+}
+
+void dicom_predecode_cache::wait(){
+    this->tasks.wait();
+    return;
+}
+
+std::unique_ptr<decoded_dicom_file> dicom_predecode_cache::take(const std::string &filename){
+    std::lock_guard<std::mutex> lock(this->m);
+    auto it = this->decoded.find(filename);
+    if(it == std::end(this->decoded)) return nullptr;
+    auto out = std::move(it->second);
+    this->decoded.erase(it);
+    return out;
+}
+
+bool dicom_predecode_cache::contains(const std::string &filename){
+    std::lock_guard<std::mutex> lock(this->m);
+    return (this->decoded.count(filename) != 0);
 }
 
 
 bool Load_From_DICOM_Files( Drover &DICOM_data,
                             std::map<std::string,std::string> & /* InvocationMetadata */,
                             const std::string &FilenameLex,
-                            std::list<boost::filesystem::path> &Filenames ){
+                            std::list<boost::filesystem::path> &Filenames,
+                            long int n_threads,
+                            dicom_predecode_cache *predecoded_cache,
+                            bool defer_pixels ){
 
     //This routine will attempt to load DICOM files on an individual file basis. Files that are not successfully loaded
     // are not consumed so that they can be passed on to the next loading stage as needed. 
@@ -46,13 +157,23 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
     // Note: This routine returns false only iff a file is suspected of being suited for this loader, but could not be
     //       loaded (e.g., the file seems appropriate, but a parsing failure was encountered).
     //
+    // Note: If more than one thread is requested, files are decoded concurrently before being incorporated in the
+    //       original order. The result is identical to decoding sequentially, but all files are decoded up-front.
+    //
+    // Note: Files already decoded by the (optional) cache are not decoded again.
+    //
+    // Note: If requested, decoding the pixel data of (single-frame) images is deferred until the pixels are first
+    //       accessed, so images that are discarded based only on their metadata are never decoded.
+    //
     if(Filenames.empty()) return true;
+    if(predecoded_cache != nullptr) predecoded_cache->wait();
 
     using loaded_imgs_storage_t = decltype(DICOM_data.image_data);
     std::list<loaded_imgs_storage_t> loaded_imgs_storage;
     using loaded_dose_storage_t = decltype(DICOM_data.image_data);
     std::list<loaded_dose_storage_t> loaded_dose_storage;
     std::shared_ptr<Contour_Data> loaded_contour_data_storage = std::make_shared<Contour_Data>();
+    std::map<std::string, std::function<void(planar_image<float,double> &)>> deferred_pixels; // Keyed on filename.
 
     //This routine currently assumes ALL image files are part of the same image set. Same for dose files.
     // (To change this behaviour, it will suffice to emplace_back() the storage lists as needed.)
@@ -62,18 +183,46 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
     size_t i = 0;
     const size_t N = Filenames.size();
 
+    //Decode all files concurrently, if requested.
+    std::vector<decoded_dicom_file> predecoded;
+    if(1 < n_threads){
+        predecoded.resize(N);
+        progress_tracker progress("DICOM decoding", static_cast<long int>(N),
+                                  [](long int completed, long int total, double eta_s) -> void {
+            FUNCINFO("Decoded " << completed << " of " << total << " files"
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done"
+                  << ", ~" << static_cast<long int>(eta_s) << " s remaining");
+        });
+        {
+            task_group tg(n_threads);
+            size_t j = 0;
+            for(const auto &p : Filenames){
+                const auto Filename = p.string();
+                auto *dest = &(predecoded[j++]);
+                if( (predecoded_cache != nullptr) && predecoded_cache->contains(Filename) ){
+                    progress.advance();
+                    continue;
+                }
+                tg.run([&,Filename,dest]() -> void {
+                    *dest = Decode_DICOM_File(Filename, defer_pixels);
+                    progress.advance();
+                });
+            }
+            tg.wait();
+        } // Thread pool joins here.
+    }
+
     auto bfit = Filenames.begin();
     while(bfit != Filenames.end()){
         FUNCINFO("Parsing file #" << i+1 << "/" << N << " = " << 100*(i+1)/N << "% \t" << *bfit);
         ++i;
 
         const auto Filename = bfit->string();
-        std::string Modality;
-        try{
-            Modality = get_modality(Filename);
-        }catch(const std::exception &){
-            Modality = "";
-        };
+        auto cached = (predecoded_cache == nullptr) ? nullptr : predecoded_cache->take(Filename);
+        auto decoded = (cached != nullptr)    ? std::move(*cached)
+                     : (predecoded.empty())   ? Decode_DICOM_File(Filename, defer_pixels)
+                                              : std::move(predecoded[i-1]);
+        const auto &Modality = decoded.Modality;
 
         if(boost::iequals(Modality,"RTRECORD")){
             FUNCWARN("RTRECORD file encountered. "
@@ -92,17 +241,24 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
         }else if(boost::iequals(Modality,"RTPLAN")){
             FUNCWARN("RTPLAN file support is experimental");
 
-            auto tplan = Load_TPlan_Config(Filename);
-            DICOM_data.tplan_data.emplace_back( std::move(tplan) );
+            if(decoded.error){
+                throw std::runtime_error(decoded.error.value());
+            }
+            DICOM_data.tplan_data.emplace_back( std::move(decoded.tplan) );
 
             bfit = Filenames.erase( bfit ); 
 
         }else if(boost::iequals(Modality,"RTSTRUCT")){
             const auto preloadcount = loaded_contour_data_storage->ccs.size();
             try{
-                auto combined = Concatenate_Contour_Data( loaded_contour_data_storage->Duplicate(),
-                                                          get_Contour_Data(Filename));
-                loaded_contour_data_storage = std::move(combined);
+                if(decoded.error){
+                    throw std::runtime_error(decoded.error.value());
+                }
+                if(decoded.contours == nullptr){
+                    throw std::runtime_error("No contour data decoded");
+                }
+                loaded_contour_data_storage->ccs.splice( loaded_contour_data_storage->ccs.end(),
+                                                         std::move(decoded.contours->ccs) );
 
             }catch(const std::exception &e){
                 FUNCWARN("Difficulty encountered during contour data loading: '" << e.what() << "'. Ignoring file and continuing");
@@ -124,7 +280,10 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
 
         }else if(boost::iequals(Modality,"RTDOSE")){
             try{
-                loaded_dose_storage.back().push_back( Load_Dose_Array(Filename));
+                if(decoded.error){
+                    throw std::runtime_error(decoded.error.value());
+                }
+                loaded_dose_storage.back().push_back( std::move(decoded.imgs) );
             }catch(const std::exception &e){
                 FUNCWARN("Difficulty encountered during dose array loading: '" << e.what() << "'. Ignoring file and continuing");
                 //loaded_dose_storage.back().pop_back();
@@ -142,7 +301,10 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
                 || boost::iequals(Modality,"PT") ){
 
             try{
-                loaded_imgs_storage.back().push_back( Load_Image_Array(Filename));
+                if(decoded.error){
+                    throw std::runtime_error(decoded.error.value());
+                }
+                loaded_imgs_storage.back().push_back( std::move(decoded.imgs) );
             }catch(const std::exception &e){
                 FUNCWARN("Difficulty encountered during image array loading: '" << e.what() << "'. Ignoring file and continuing");
                 //loaded_imgs_storage.back().pop_back();
@@ -150,23 +312,24 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
                 continue;
             }
 
-            if(loaded_imgs_storage.back().back()->imagecoll.images.size() != 1){
-                FUNCWARN("More or less than one image loaded into the image array. You'll need to tweak the code to handle this");
+            if(loaded_imgs_storage.back().back()->imagecoll.images.empty()){
+                FUNCWARN("No images loaded into the image array");
                 return false;
-                //If you get here, you've tried to load a file that contains more than one image slice. This is OK,
-                // (and is legitimate behaviour) but you'll need to update the following code to ensure each file's 
-                // metadata is set accordingly. This is all you need to do at the time of writing, but take a look over
-                // the rest of the code to ensure the code doesn't assume too much.
             }
             
             bfit = Filenames.erase( bfit ); 
 
             //If we want to add any additional image metadata, or replace the default Imebra_Shim.cc populated metadata
-            // with, say, the non-null PostgreSQL metadata, it should be done here.
-            loaded_imgs_storage.back().back()->imagecoll.images.back().metadata["Filename"] = Filename;
-            loaded_imgs_storage.back().back()->imagecoll.images.back().metadata["dt"] = "0.0";
+            // with, say, the non-null PostgreSQL metadata, it should be done here. Multi-frame files result in one
+            // image per frame.
+            for(auto &img : loaded_imgs_storage.back().back()->imagecoll.images){
+                img.metadata["Filename"] = Filename;
+                img.metadata["dt"] = "0.0";
+            }
             // ... more metadata operations ...
 
+            if(decoded.pixels) deferred_pixels[Filename] = std::move(decoded.pixels);
+
         }else{
             //Skip the file. It might be destined for some other loader.
             ++bfit;
@@ -182,7 +345,7 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
 
     //Attempt contour name normalization using the selected lexicon.
     {
-        Explicator X(FilenameLex);
+        const lexicon_translator X(FilenameLex);
         for(auto & cc : loaded_contour_data_storage->ccs){
              for(auto & c : cc.contours){
                  const auto NormalizedROIName = X(c.metadata["ROIName"]); //Could be cached, externally or internally.
@@ -193,14 +356,15 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
 
     //Concatenate contour data into the Drover instance.
     {
-        if(DICOM_data.contour_data == nullptr) DICOM_data.contour_data = std::make_shared<Contour_Data>();
-        auto combined = Concatenate_Contour_Data( DICOM_data.contour_data->Duplicate(),
-                                                  loaded_contour_data_storage->Duplicate());
-        DICOM_data.contour_data = std::move(combined);
+        //The loaded contours are not shared, so they can be moved rather than copied. The Drover's contours are only
+        // copied if they are shared with another owner.
+        auto &cd = Detach_Shared(DICOM_data.contour_data);
+        cd.ccs.splice( cd.ccs.end(), std::move(loaded_contour_data_storage->ccs) );
     }
 
     //Collate each group of images into a single set, if possible. Also stuff the correct contour data in the same set.
     // Also load dose data into the fray.
+    std::list<std::shared_ptr<Image_Array>> collated_arrays;
     for(auto &loaded_img_set : loaded_imgs_storage){
         if(loaded_img_set.empty()) continue;
 
@@ -211,6 +375,7 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
         }
 
         DICOM_data.image_data.emplace_back(std::move(collated_imgs));
+        collated_arrays.emplace_back(DICOM_data.image_data.back());
     }
     FUNCINFO("Number of image set groups currently loaded = " << DICOM_data.image_data.size());
 
@@ -247,5 +412,21 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
         }
     }
 
+    //Attach the deferred pixel data. Images are matched with their source by filename, since collating and sorting
+    // reorders them.
+    if(!deferred_pixels.empty()){
+        for(auto &ia_ptr : collated_arrays){
+            std::vector<std::function<void(planar_image<float,double> &)>> sources;
+            for(const auto &img : ia_ptr->imagecoll.images){
+                sources.emplace_back();
+                const auto f_it = img.metadata.find("Filename");
+                if(f_it == std::end(img.metadata)) continue;
+                const auto s_it = deferred_pixels.find(f_it->second);
+                if(s_it != std::end(deferred_pixels)) sources.back() = s_it->second;
+            }
+            ia_ptr->defer_pixels(std::move(sources));
+        }
+    }
+
     return true;
 }
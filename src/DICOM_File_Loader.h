@@ -5,12 +5,53 @@
 #include <string>    
 #include <map>
 #include <list>
+#include <memory>
+#include <mutex>
 
 #include <boost/filesystem.hpp>
 
 #include "Structs.h"
+#include "Thread_Pool.h"
+
+struct decoded_dicom_file;
+
+// Decodes DICOM files ahead of loading, e.g., while other files are still being received. Files are decoded
+// asynchronously on the process-wide thread pool and can later be incorporated by Load_From_DICOM_Files() without
+// being read again. Files that are not DICOM are simply passed over by the loader as usual.
+class dicom_predecode_cache {
+  public:
+    // If max_in_flight is positive, adding a file blocks (helping to decode in the meantime) while that many files are
+    // pending, which bounds the memory held by data that has not yet been decoded.
+    explicit dicom_predecode_cache(long int max_in_flight = 0);
+    ~dicom_predecode_cache(); // Waits for pending decodes.
+
+    dicom_predecode_cache(const dicom_predecode_cache &) = delete;
+    dicom_predecode_cache & operator=(const dicom_predecode_cache &) = delete;
+
+    // Begins decoding the file. Thread-safe.
+    void add(const std::string &filename);
+
+    // Begins decoding data that has already been read into memory, which is later taken by the given name instead of
+    // a filename. Thread-safe.
+    void add(const std::string &name, std::string contents);
+
+    // Blocks until all files added so far have been decoded.
+    void wait();
+
+    // Removes and returns the decoded file, or nullptr if the file was never added. Thread-safe.
+    std::unique_ptr<decoded_dicom_file> take(const std::string &filename);
+    bool contains(const std::string &filename);
+
+  private:
+    std::mutex m;
+    std::map<std::string, std::unique_ptr<decoded_dicom_file>> decoded;
+    task_group tasks;
+};
 
 bool Load_From_DICOM_Files( Drover &DICOM_data,
                             std::map<std::string,std::string> &InvocationMetadata,
                             const std::string &FilenameLex,
-                            std::list<boost::filesystem::path> &Filenames );
+                            std::list<boost::filesystem::path> &Filenames,
+                            long int n_threads = 1,
+                            dicom_predecode_cache *predecoded = nullptr,
+                            bool defer_pixels = false );
@@ -0,0 +1,843 @@
+//DICOM_Storage_SCP.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <cerrno>
+    #include <csignal>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+#endif
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Structs.h"
+#include "DICOM_File_Loader.h"
+#include "Operation_Dispatcher.h"
+
+#include "DICOM_Storage_SCP.h"
+
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace {
+
+// Upper layer protocol (DICOM PS3.8) PDU types.
+constexpr uint8_t pdu_associate_rq = 0x01;
+constexpr uint8_t pdu_associate_ac = 0x02;
+constexpr uint8_t pdu_associate_rj = 0x03;
+constexpr uint8_t pdu_data_tf      = 0x04;
+constexpr uint8_t pdu_release_rq   = 0x05;
+constexpr uint8_t pdu_release_rp   = 0x06;
+constexpr uint8_t pdu_abort        = 0x07;
+
+// DIMSE (DICOM PS3.7) command fields and statuses.
+constexpr uint16_t c_store_rq  = 0x0001;
+constexpr uint16_t c_store_rsp = 0x8001;
+constexpr uint16_t c_echo_rq   = 0x0030;
+constexpr uint16_t c_echo_rsp  = 0x8030;
+constexpr uint16_t no_data_set = 0x0101;
+
+constexpr uint16_t status_success        = 0x0000;
+constexpr uint16_t status_unrecognized   = 0x0211;
+constexpr uint16_t status_out_of_resources = 0xA700;
+constexpr uint16_t status_cannot_understand = 0xC000;
+
+const std::string application_context_uid = "1.2.840.10008.3.1.1.1";
+const std::string implementation_class_uid = "1.2.513.264.765.1.1.578";
+const std::string implementation_version = "DICOMautomaton";
+const std::string implicit_vr_le_uid = "1.2.840.10008.1.2";
+
+// Transfer syntaxes the loader understands, in order of preference.
+const std::vector<std::string> supported_transfer_syntaxes = {
+    "1.2.840.10008.1.2.1",    // Explicit VR little endian.
+    implicit_vr_le_uid,       // Implicit VR little endian.
+    "1.2.840.10008.1.2.5",    // RLE lossless.
+    "1.2.840.10008.1.2.4.70", // JPEG lossless, first-order prediction.
+    "1.2.840.10008.1.2.4.57", // JPEG lossless.
+};
+
+constexpr uint32_t max_received_pdu = 1024 * 1024;            // Advertised to peers.
+constexpr uint32_t max_accepted_pdu = 64 * 1024 * 1024;       // Peers that ignore the advertised limit are tolerated.
+constexpr size_t max_object_bytes = size_t(2) * 1024 * 1024 * 1024;
+constexpr long int association_timeout_s = 120;
+constexpr long int max_objects_in_flight = 64;                // Per group, bounds data held before decoding.
+
+
+uint16_t Get_BE16(const std::string &b, size_t pos){
+    if(b.size() < pos + 2) throw std::runtime_error("Truncated message");
+    return static_cast<uint16_t>( (static_cast<uint8_t>(b[pos]) << 8) | static_cast<uint8_t>(b[pos + 1]) );
+}
+uint32_t Get_BE32(const std::string &b, size_t pos){
+    return (static_cast<uint32_t>(Get_BE16(b, pos)) << 16) | Get_BE16(b, pos + 2);
+}
+uint16_t Get_LE16(const std::string &b, size_t pos){
+    if(b.size() < pos + 2) throw std::runtime_error("Truncated message");
+    return static_cast<uint16_t>( static_cast<uint8_t>(b[pos]) | (static_cast<uint8_t>(b[pos + 1]) << 8) );
+}
+uint32_t Get_LE32(const std::string &b, size_t pos){
+    return static_cast<uint32_t>(Get_LE16(b, pos)) | (static_cast<uint32_t>(Get_LE16(b, pos + 2)) << 16);
+}
+void Put_BE16(std::string &b, uint16_t v){
+    b.push_back(static_cast<char>(v >> 8));
+    b.push_back(static_cast<char>(v & 0xFF));
+}
+void Put_BE32(std::string &b, uint32_t v){
+    Put_BE16(b, static_cast<uint16_t>(v >> 16));
+    Put_BE16(b, static_cast<uint16_t>(v & 0xFFFF));
+}
+void Put_LE16(std::string &b, uint16_t v){
+    b.push_back(static_cast<char>(v & 0xFF));
+    b.push_back(static_cast<char>(v >> 8));
+}
+void Put_LE32(std::string &b, uint32_t v){
+    Put_LE16(b, static_cast<uint16_t>(v & 0xFFFF));
+    Put_LE16(b, static_cast<uint16_t>(v >> 16));
+}
+
+// Removes the padding from AE titles and UIDs.
+std::string Trim_Padding(const std::string &s){
+    const auto is_pad = [](char c){ return (c == ' ') || (c == '\0'); };
+    const auto first = std::find_if_not(std::begin(s), std::end(s), is_pad);
+    const auto last = std::find_if_not(std::rbegin(s), std::rend(s), is_pad).base();
+    return (first < last) ? std::string(first, last) : std::string();
+}
+
+// UIDs are padded with a null to an even length.
+std::string Pad_UID(std::string uid){
+    if(uid.size() % 2 != 0) uid.push_back('\0');
+    return uid;
+}
+
+// AE titles are padded with spaces to 16 characters.
+std::string Pad_AE(const std::string &ae){
+    auto out = ae.substr(0, 16);
+    out.resize(16, ' ');
+    return out;
+}
+
+
+// Socket I/O. Returns false if the peer closed the connection before any data was received.
+bool Read_Exact(int fd, size_t n, std::string &out){
+    out.resize(n);
+    size_t got = 0;
+    while(got < n){
+        const auto r = ::recv(fd, &out[got], n - got, 0);
+        if(r < 0){
+            if(errno == EINTR) continue;
+            throw std::runtime_error(std::string("Unable to read from peer: ") + std::strerror(errno));
+        }
+        if(r == 0){
+            if(got == 0) return false;
+            throw std::runtime_error("Peer closed the connection mid-message");
+        }
+        got += static_cast<size_t>(r);
+    }
+    return true;
+}
+
+void Write_All(int fd, const std::string &b){
+    size_t sent = 0;
+    while(sent < b.size()){
+        const auto n = ::send(fd, b.data() + sent, b.size() - sent, 0);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            throw std::runtime_error(std::string("Unable to write to peer: ") + std::strerror(errno));
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return;
+}
+
+struct pdu_t {
+    uint8_t type = 0;
+    std::string body;
+};
+
+// Returns false if the peer closed the connection between PDUs.
+bool Read_PDU(int fd, pdu_t &pdu){
+    std::string header;
+    if(!Read_Exact(fd, 6, header)) return false;
+    pdu.type = static_cast<uint8_t>(header[0]);
+    const auto length = Get_BE32(header, 2);
+    if(max_accepted_pdu < length) throw std::runtime_error("PDU is too large");
+    if(!Read_Exact(fd, length, pdu.body) && (length != 0)){
+        throw std::runtime_error("Peer closed the connection mid-message");
+    }
+    return true;
+}
+
+void Write_PDU(int fd, uint8_t type, const std::string &body){
+    std::string b;
+    b.push_back(static_cast<char>(type));
+    b.push_back('\0');
+    Put_BE32(b, static_cast<uint32_t>(body.size()));
+    b += body;
+    Write_All(fd, b);
+    return;
+}
+
+// Appends an item (or sub-item) with a 16-bit length.
+void Put_Item(std::string &b, uint8_t type, const std::string &value){
+    b.push_back(static_cast<char>(type));
+    b.push_back('\0');
+    Put_BE16(b, static_cast<uint16_t>(value.size()));
+    b += value;
+    return;
+}
+
+
+struct presentation_context_t {
+    uint8_t id = 0;
+    std::string abstract_syntax;
+    std::list<std::string> transfer_syntaxes;
+
+    // Filled in when the association is negotiated.
+    uint8_t result = 0;
+    std::string transfer_syntax;
+};
+
+struct association_rq_t {
+    std::string called_ae;
+    std::string calling_ae;
+    std::list<presentation_context_t> contexts;
+};
+
+association_rq_t Parse_Associate_RQ(const std::string &body){
+    if(body.size() < 68) throw std::runtime_error("Truncated association request");
+    association_rq_t rq;
+    rq.called_ae = Trim_Padding(body.substr(4, 16));
+    rq.calling_ae = Trim_Padding(body.substr(20, 16));
+
+    // Each item (and sub-item) is a type, a reserved byte, and a 16-bit length.
+    const auto for_each_item = [](const std::string &b, size_t pos, size_t end,
+                                  const std::function<void(uint8_t, const std::string &)> &f){
+        while(pos + 4 <= end){
+            const auto type = static_cast<uint8_t>(b[pos]);
+            const auto length = Get_BE16(b, pos + 2);
+            if(end < pos + 4 + length) throw std::runtime_error("Truncated association request item");
+            f(type, b.substr(pos + 4, length));
+            pos += 4 + length;
+        }
+    };
+
+    for_each_item(body, 68, body.size(), [&](uint8_t type, const std::string &item){
+        if(type != 0x20) return; // Only presentation contexts are needed; user information is not.
+        if(item.size() < 4) throw std::runtime_error("Truncated presentation context");
+        rq.contexts.emplace_back();
+        auto &pc = rq.contexts.back();
+        pc.id = static_cast<uint8_t>(item[0]);
+        for_each_item(item, 4, item.size(), [&](uint8_t sub_type, const std::string &sub){
+            if(sub_type == 0x30) pc.abstract_syntax = Trim_Padding(sub);
+            if(sub_type == 0x40) pc.transfer_syntaxes.push_back(Trim_Padding(sub));
+        });
+    });
+    return rq;
+}
+
+// Accepts every abstract syntax offered with a supported transfer syntax.
+void Negotiate(association_rq_t &rq){
+    for(auto &pc : rq.contexts){
+        pc.result = 4; // Transfer syntaxes not supported.
+        if(pc.abstract_syntax.empty()){
+            pc.result = 3; // Abstract syntax not supported.
+            continue;
+        }
+        for(const auto &ts : supported_transfer_syntaxes){
+            if(std::find(std::begin(pc.transfer_syntaxes), std::end(pc.transfer_syntaxes), ts)
+               != std::end(pc.transfer_syntaxes)){
+                pc.result = 0;
+                pc.transfer_syntax = ts;
+                break;
+            }
+        }
+    }
+    return;
+}
+
+std::string Encode_Associate_AC(const association_rq_t &rq){
+    std::string b;
+    Put_BE16(b, 0x0001); // Protocol version.
+    Put_BE16(b, 0x0000);
+    b += Pad_AE(rq.called_ae);
+    b += Pad_AE(rq.calling_ae);
+    b += std::string(32, '\0');
+
+    Put_Item(b, 0x10, application_context_uid);
+    for(const auto &pc : rq.contexts){
+        std::string item;
+        item.push_back(static_cast<char>(pc.id));
+        item.push_back('\0');
+        item.push_back(static_cast<char>(pc.result));
+        item.push_back('\0');
+        Put_Item(item, 0x40, (pc.result == 0) ? pc.transfer_syntax : implicit_vr_le_uid);
+        Put_Item(b, 0x21, item);
+    }
+
+    std::string user;
+    std::string max_length;
+    Put_BE32(max_length, max_received_pdu);
+    Put_Item(user, 0x51, max_length);
+    Put_Item(user, 0x52, implementation_class_uid);
+    Put_Item(user, 0x55, implementation_version);
+    Put_Item(b, 0x50, user);
+    return b;
+}
+
+
+// A DIMSE command set, which is always encoded with implicit VR little endian.
+struct dimse_command_t {
+    uint16_t command_field = 0;
+    uint16_t message_id = 0;
+    uint16_t data_set_type = no_data_set;
+    std::string sop_class_uid;
+    std::string sop_instance_uid;
+};
+
+dimse_command_t Parse_Command(const std::string &b){
+    dimse_command_t cmd;
+    size_t pos = 0;
+    while(pos + 8 <= b.size()){
+        const auto group = Get_LE16(b, pos);
+        const auto element = Get_LE16(b, pos + 2);
+        const auto length = Get_LE32(b, pos + 4);
+        pos += 8;
+        if(b.size() < pos + length) throw std::runtime_error("Truncated command");
+        if(group == 0x0000){
+            const auto value = b.substr(pos, length);
+            if(element == 0x0002) cmd.sop_class_uid = Trim_Padding(value);
+            if(element == 0x0100) cmd.command_field = Get_LE16(value, 0);
+            if(element == 0x0110) cmd.message_id = Get_LE16(value, 0);
+            if(element == 0x0800) cmd.data_set_type = Get_LE16(value, 0);
+            if(element == 0x1000) cmd.sop_instance_uid = Trim_Padding(value);
+        }
+        pos += length;
+    }
+    return cmd;
+}
+
+std::string Encode_Response(const dimse_command_t &rq, uint16_t command_field, uint16_t status){
+    std::string elements;
+    const auto put = [&](uint16_t element, const std::string &value){
+        Put_LE16(elements, 0x0000);
+        Put_LE16(elements, element);
+        Put_LE32(elements, static_cast<uint32_t>(value.size()));
+        elements += value;
+    };
+    const auto us = [](uint16_t v){
+        std::string out;
+        Put_LE16(out, v);
+        return out;
+    };
+
+    if(!rq.sop_class_uid.empty()) put(0x0002, Pad_UID(rq.sop_class_uid));
+    put(0x0100, us(command_field));
+    put(0x0120, us(rq.message_id));
+    put(0x0800, us(no_data_set));
+    put(0x0900, us(status));
+    if(!rq.sop_instance_uid.empty()) put(0x1000, Pad_UID(rq.sop_instance_uid));
+
+    std::string b;
+    std::string group_length;
+    Put_LE32(group_length, static_cast<uint32_t>(elements.size()));
+    Put_LE16(b, 0x0000);
+    Put_LE16(b, 0x0000);
+    Put_LE32(b, 4);
+    b += group_length;
+    return b + elements;
+}
+
+// Sends a command set as a single, final command fragment.
+void Write_Command(int fd, uint8_t context_id, const std::string &command){
+    std::string pdv;
+    Put_BE32(pdv, static_cast<uint32_t>(command.size() + 2));
+    pdv.push_back(static_cast<char>(context_id));
+    pdv.push_back(static_cast<char>(0x03));
+    pdv += command;
+    Write_PDU(fd, pdu_data_tf, pdv);
+    return;
+}
+
+
+// Walks top-level data set elements to find the study and series instance UIDs, skipping over sequences. Only the
+// little endian transfer syntaxes are accepted, so the data set is either explicit or implicit VR little endian.
+struct element_header_t {
+    uint16_t group = 0;
+    uint16_t element = 0;
+    uint32_t length = 0;
+    size_t value_pos = 0;
+};
+
+constexpr uint32_t undefined_length = 0xFFFFFFFF;
+
+element_header_t Read_Element_Header(const std::string &b, size_t pos, bool explicit_vr){
+    element_header_t h;
+    h.group = Get_LE16(b, pos);
+    h.element = Get_LE16(b, pos + 2);
+    if(!explicit_vr || (h.group == 0xFFFE)){ // Items and delimiters never have a VR.
+        h.length = Get_LE32(b, pos + 4);
+        h.value_pos = pos + 8;
+    }else{
+        if(b.size() < pos + 6) throw std::runtime_error("Truncated data set");
+        const auto vr = b.substr(pos + 4, 2);
+        static const std::set<std::string> long_vrs = { "OB", "OD", "OF", "OL", "OV", "OW",
+                                                        "SQ", "SV", "UC", "UN", "UR", "UT", "UV" };
+        if(long_vrs.count(vr) != 0){
+            h.length = Get_LE32(b, pos + 8);
+            h.value_pos = pos + 12;
+        }else{
+            h.length = Get_LE16(b, pos + 6);
+            h.value_pos = pos + 8;
+        }
+    }
+    return h;
+}
+
+// Skips to just past the given delimiter (either item ~ 0xE00D or sequence ~ 0xE0DD).
+size_t Skip_Undefined_Length(const std::string &b, size_t pos, bool explicit_vr, uint16_t delimiter, long int depth){
+    if(64 < depth) throw std::runtime_error("Data set is nested too deeply");
+    while(true){
+        const auto h = Read_Element_Header(b, pos, explicit_vr);
+        if( (h.group == 0xFFFE) && (h.element == delimiter) ) return h.value_pos;
+        if(h.length == undefined_length){
+            const uint16_t inner = ( (h.group == 0xFFFE) && (h.element == 0xE000) ) ? 0xE00D : 0xE0DD;
+            pos = Skip_Undefined_Length(b, h.value_pos, explicit_vr, inner, depth + 1);
+        }else{
+            pos = h.value_pos + h.length;
+        }
+        if(b.size() < pos) throw std::runtime_error("Truncated data set");
+    }
+}
+
+struct instance_uids_t {
+    std::string study;
+    std::string series;
+};
+
+instance_uids_t Find_Instance_UIDs(const std::string &b, bool explicit_vr){
+    instance_uids_t out;
+    size_t pos = 0;
+    while(pos + 8 <= b.size()){
+        const auto h = Read_Element_Header(b, pos, explicit_vr);
+        const auto tag = (static_cast<uint32_t>(h.group) << 16) | h.element;
+        if(0x0020000EU < tag) break;
+
+        if(h.length == undefined_length){
+            pos = Skip_Undefined_Length(b, h.value_pos, explicit_vr, 0xE0DD, 0);
+            continue;
+        }
+        if(b.size() < h.value_pos + h.length) throw std::runtime_error("Truncated data set");
+        if(tag == 0x0020000DU) out.study = Trim_Padding(b.substr(h.value_pos, h.length));
+        if(tag == 0x0020000EU) out.series = Trim_Padding(b.substr(h.value_pos, h.length));
+        pos = h.value_pos + h.length;
+    }
+    return out;
+}
+
+// Wraps a received data set in the DICOM file format (with a preamble and file meta information) for the loader.
+std::string Encode_Part10(const dimse_command_t &cmd, const std::string &transfer_syntax, const std::string &data_set){
+    std::string meta;
+    const auto put = [&](uint16_t element, const std::string &vr, const std::string &value){
+        Put_LE16(meta, 0x0002);
+        Put_LE16(meta, element);
+        meta += vr;
+        if(vr == "OB"){
+            Put_LE16(meta, 0x0000);
+            Put_LE32(meta, static_cast<uint32_t>(value.size()));
+        }else{
+            Put_LE16(meta, static_cast<uint16_t>(value.size()));
+        }
+        meta += value;
+    };
+    put(0x0001, "OB", std::string("\0\1", 2));
+    put(0x0002, "UI", Pad_UID(cmd.sop_class_uid));
+    put(0x0003, "UI", Pad_UID(cmd.sop_instance_uid));
+    put(0x0010, "UI", Pad_UID(transfer_syntax));
+    put(0x0012, "UI", Pad_UID(implementation_class_uid));
+    put(0x0013, "SH", implementation_version);
+
+    std::string b(128, '\0');
+    b += "DICM";
+    Put_LE16(b, 0x0002);
+    Put_LE16(b, 0x0000);
+    b += "UL";
+    Put_LE16(b, 4);
+    Put_LE32(b, static_cast<uint32_t>(meta.size()));
+    b.reserve(b.size() + meta.size() + data_set.size());
+    b += meta;
+    b += data_set;
+    return b;
+}
+
+
+// State shared by all associations and jobs.
+struct scp_state_t {
+    dicom_storage_scp_opts opts;
+    operation_plan plan;
+    std::map<std::string,std::string> InvocationMetadata;
+    std::string FilenameLex;
+
+    using clock_t = std::chrono::steady_clock;
+
+    struct group_t {
+        std::string uid;
+        std::shared_ptr<dicom_predecode_cache> cache;
+        std::list<std::string> names;
+        std::set<std::string> seen;
+        long int adding = 0; // Objects still being added to the cache, which are not yet listed.
+        clock_t::time_point last;
+    };
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::map<std::string, group_t> receiving;
+    std::deque<group_t> ready;
+    long int active_associations = 0;
+};
+
+std::string Sanitize_UID(const std::string &uid){
+    std::string out = uid;
+    for(auto &c : out){
+        if( !std::isdigit(static_cast<unsigned char>(c)) && (c != '.') ) c = '_';
+    }
+    return out;
+}
+
+void Write_File_Atomically(const boost::filesystem::path &p, const std::string &contents){
+    auto tmp = p;
+    tmp += ".partial";
+    {
+        std::ofstream of(tmp.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!of) throw std::runtime_error("Unable to write '" + tmp.string() + "'");
+        of.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        of.flush();
+        if(!of) throw std::runtime_error("Unable to write '" + tmp.string() + "'");
+    }
+    boost::filesystem::rename(tmp, p);
+    return;
+}
+
+uint16_t Store_Object(scp_state_t &s, const presentation_context_t &pc, const dimse_command_t &cmd,
+                      const std::string &data_set){
+    if(cmd.sop_instance_uid.empty() || cmd.sop_class_uid.empty()) return status_cannot_understand;
+
+    instance_uids_t uids;
+    try{
+        uids = Find_Instance_UIDs(data_set, (pc.transfer_syntax != implicit_vr_le_uid));
+    }catch(const std::exception &e){
+        FUNCWARN("Unable to interpret object '" << cmd.sop_instance_uid << "': " << e.what());
+        return status_cannot_understand;
+    }
+    const auto key = (s.opts.group_by_study) ? uids.study : uids.series;
+
+    try{
+        auto contents = Encode_Part10(cmd, pc.transfer_syntax, data_set);
+        std::string name = "dicom-scp/" + Sanitize_UID(cmd.sop_instance_uid) + ".dcm";
+        if(!s.opts.store_dir.empty()){
+            const auto p = boost::filesystem::path(s.opts.store_dir) / (Sanitize_UID(cmd.sop_instance_uid) + ".dcm");
+            Write_File_Atomically(p, contents);
+            name = p.string();
+        }
+
+        // The object is added to the cache before it is listed so a group is never loaded while objects are missing.
+        std::shared_ptr<dicom_predecode_cache> cache;
+        {
+            std::lock_guard<std::mutex> lock(s.m);
+            auto &g = s.receiving[key];
+            if(g.cache == nullptr){
+                g.uid = key;
+                g.cache = std::make_shared<dicom_predecode_cache>(max_objects_in_flight);
+            }
+            ++g.adding;
+            cache = g.cache;
+        }
+        cache->add(name, std::move(contents));
+        {
+            std::lock_guard<std::mutex> lock(s.m);
+            auto &g = s.receiving[key];
+            if(g.seen.insert(name).second) g.names.push_back(name);
+            --g.adding;
+            g.last = scp_state_t::clock_t::now();
+        }
+        s.cv.notify_all();
+
+    }catch(const std::exception &e){
+        FUNCWARN("Unable to store object '" << cmd.sop_instance_uid << "': " << e.what());
+        return status_out_of_resources;
+    }
+    return status_success;
+}
+
+void Serve_Association(int fd, scp_state_t &s){
+    pdu_t pdu;
+    if(!Read_PDU(fd, pdu)) return;
+    if(pdu.type != pdu_associate_rq) throw std::runtime_error("Expected an association request");
+
+    auto rq = Parse_Associate_RQ(pdu.body);
+    if(!s.opts.ae_title.empty() && (rq.called_ae != s.opts.ae_title)){
+        FUNCWARN("Rejecting association from '" << rq.calling_ae << "' calling '" << rq.called_ae << "'");
+        // Rejected permanently by the service user: called AE title not recognized.
+        Write_PDU(fd, pdu_associate_rj, std::string("\0\1\1\7", 4));
+        return;
+    }
+    Negotiate(rq);
+    Write_PDU(fd, pdu_associate_ac, Encode_Associate_AC(rq));
+
+    std::map<uint8_t, const presentation_context_t *> contexts;
+    for(const auto &pc : rq.contexts){
+        if(pc.result == 0) contexts[pc.id] = &pc;
+    }
+
+    std::string command;
+    std::string data_set;
+    std::optional<dimse_command_t> pending; // A command awaiting its data set.
+    long int N_stored = 0;
+
+    while(Read_PDU(fd, pdu)){
+        if(pdu.type == pdu_release_rq){
+            Write_PDU(fd, pdu_release_rp, std::string(4, '\0'));
+            break;
+        }
+        if(pdu.type == pdu_abort) break;
+        if(pdu.type != pdu_data_tf){
+            Write_PDU(fd, pdu_abort, std::string("\0\0\2\2", 4)); // Unexpected PDU.
+            throw std::runtime_error("Unexpected PDU type " + std::to_string(pdu.type));
+        }
+
+        // Each presentation data value is a length, a context ID, a control header, and a message fragment.
+        size_t pos = 0;
+        while(pos + 6 <= pdu.body.size()){
+            const auto length = Get_BE32(pdu.body, pos);
+            if( (length < 2) || (pdu.body.size() < pos + 4 + length) ) throw std::runtime_error("Malformed PDV");
+            const auto id = static_cast<uint8_t>(pdu.body[pos + 4]);
+            const auto control = static_cast<uint8_t>(pdu.body[pos + 5]);
+            const bool is_command = ((control & 0x01) != 0);
+            const bool is_last = ((control & 0x02) != 0);
+            auto &buf = (is_command) ? command : data_set;
+            if(max_object_bytes < buf.size() + length) throw std::runtime_error("Message is too large");
+            buf.append(pdu.body, pos + 6, length - 2);
+            pos += 4 + length;
+            if(!is_last) continue;
+
+            const auto pc_it = contexts.find(id);
+            if(pc_it == std::end(contexts)) throw std::runtime_error("PDV references an unaccepted context");
+
+            if(is_command){
+                const auto cmd = Parse_Command(command);
+                command.clear();
+                if(cmd.data_set_type != no_data_set){
+                    pending = cmd;
+                    continue;
+                }
+                if(cmd.command_field == c_echo_rq){
+                    Write_Command(fd, id, Encode_Response(cmd, c_echo_rsp, status_success));
+                }else{
+                    const auto rsp = static_cast<uint16_t>(cmd.command_field | 0x8000);
+                    Write_Command(fd, id, Encode_Response(cmd, rsp, status_unrecognized));
+                }
+                continue;
+            }
+
+            if(!pending) throw std::runtime_error("Data set received without a command");
+            const auto cmd = pending.value();
+            pending.reset();
+            auto rsp = static_cast<uint16_t>(cmd.command_field | 0x8000);
+            uint16_t status = status_unrecognized;
+            if(cmd.command_field == c_store_rq){
+                rsp = c_store_rsp;
+                status = Store_Object(s, *(pc_it->second), cmd, data_set);
+                if(status == status_success) ++N_stored;
+            }
+            data_set.clear();
+            data_set.shrink_to_fit();
+            Write_Command(fd, id, Encode_Response(cmd, rsp, status));
+        }
+    }
+    FUNCINFO("Received " << N_stored << " objects from '" << rq.calling_ae << "'");
+    return;
+}
+
+void Perform_Group(scp_state_t &s, scp_state_t::group_t &g){
+    FUNCINFO("Processing " << g.names.size() << " objects from " << (s.opts.group_by_study ? "study" : "series")
+             << " '" << g.uid << "'");
+
+    Drover DICOM_data;
+    auto InvocationMetadata = s.InvocationMetadata;
+    std::list<boost::filesystem::path> paths(std::begin(g.names), std::end(g.names));
+    if(!Load_From_DICOM_Files(DICOM_data, InvocationMetadata, s.FilenameLex, paths, 1, g.cache.get())){
+        throw std::runtime_error("Loading unsuccessful");
+    }
+    if(!paths.empty()) FUNCWARN("Unable to load " << paths.size() << " objects. Ignoring them");
+
+    if(!Operation_Dispatcher(DICOM_data, InvocationMetadata, s.FilenameLex, s.plan)){
+        throw std::runtime_error("Analysis failed");
+    }
+    return;
+}
+
+// Moves groups that have been quiet long enough to the ready queue.
+void Monitor_Groups(scp_state_t &s){
+    const auto quiet = std::chrono::duration_cast<scp_state_t::clock_t::duration>(
+                           std::chrono::duration<double>(s.opts.quiet_period) );
+    std::unique_lock<std::mutex> lock(s.m);
+    while(true){
+        auto next = scp_state_t::clock_t::now() + std::chrono::seconds(1);
+        const auto now = scp_state_t::clock_t::now();
+        for(auto it = std::begin(s.receiving); it != std::end(s.receiving); ){
+            if( (it->second.adding == 0)
+            &&  !it->second.names.empty()
+            &&  (it->second.last + quiet <= now) ){
+                s.ready.push_back(std::move(it->second));
+                it = s.receiving.erase(it);
+                s.cv.notify_all();
+                continue;
+            }
+            if(!it->second.names.empty()) next = std::min(next, it->second.last + quiet);
+            ++it;
+        }
+        s.cv.wait_until(lock, next);
+    }
+}
+
+void Perform_Groups(scp_state_t &s){
+    while(true){
+        scp_state_t::group_t g;
+        {
+            std::unique_lock<std::mutex> lock(s.m);
+            s.cv.wait(lock, [&](){ return !s.ready.empty(); });
+            g = std::move(s.ready.front());
+            s.ready.pop_front();
+        }
+        try{
+            Perform_Group(s, g);
+        }catch(const std::exception &e){
+            FUNCWARN("Processing '" << g.uid << "' failed: " << e.what());
+        }
+    }
+}
+
+} // namespace
+
+
+void Serve_DICOM_Storage(const dicom_storage_scp_opts &opts,
+                         const std::list<OperationArgPkg> &Operations,
+                         const std::map<std::string,std::string> &InvocationMetadata,
+                         const std::string &FilenameLex){
+    if( (opts.port <= 0) || (65535 < opts.port) ) throw std::invalid_argument("Port is invalid");
+    if(opts.max_associations <= 0){
+        throw std::invalid_argument("The number of concurrent associations must be positive");
+    }
+    if(opts.max_jobs <= 0) throw std::invalid_argument("The number of concurrent jobs must be positive");
+    if(!(0.0 <= opts.quiet_period)) throw std::invalid_argument("The quiet period must be non-negative");
+    if(16 < opts.ae_title.size()) throw std::invalid_argument("AE titles are limited to 16 characters");
+    if(!opts.store_dir.empty()) boost::filesystem::create_directories(opts.store_dir);
+
+    // Shared with detached threads, which outlive this function if it throws.
+    auto s = std::make_shared<scp_state_t>();
+    s->opts = opts;
+    s->plan = Compile_Operations(Operations);
+    s->InvocationMetadata = InvocationMetadata;
+    s->FilenameLex = FilenameLex;
+
+    // Peers that disconnect early should not terminate the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if(listen_fd < 0) throw std::runtime_error(std::string("Unable to create socket: ") + std::strerror(errno));
+    const int reuse = 1;
+    (void) ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(opts.port));
+    if( (::bind(listen_fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0)
+    ||  (::listen(listen_fd, 64) != 0) ){
+        const std::string err = std::strerror(errno);
+        ::close(listen_fd);
+        throw std::runtime_error("Unable to listen on port " + std::to_string(opts.port) + ": " + err);
+    }
+    FUNCINFO("Accepting DICOM associations on port " << opts.port
+             << (opts.ae_title.empty() ? std::string() : " as '" + opts.ae_title + "'"));
+
+    std::thread([s](){ Monitor_Groups(*s); }).detach();
+    for(long int i = 0; i < opts.max_jobs; ++i){
+        std::thread([s](){ Perform_Groups(*s); }).detach();
+    }
+
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(s->m);
+            s->cv.wait(lock, [&](){ return (s->active_associations < opts.max_associations); });
+        }
+
+        const int fd = ::accept(listen_fd, nullptr, nullptr);
+        if(fd < 0){
+            if(errno == EINTR) continue;
+            FUNCWARN("Unable to accept connection: " << std::strerror(errno));
+            continue;
+        }
+
+        // Stalled peers should not hold an association indefinitely.
+        timeval tv;
+        tv.tv_sec = association_timeout_s;
+        tv.tv_usec = 0;
+        (void) ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        (void) ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        {
+            std::lock_guard<std::mutex> lock(s->m);
+            ++(s->active_associations);
+        }
+        std::thread([s, fd](){
+            try{
+                Serve_Association(fd, *s);
+            }catch(const std::exception &e){
+                FUNCWARN("Association failed: " << e.what());
+            }
+            ::close(fd);
+
+            std::lock_guard<std::mutex> lock(s->m);
+            --(s->active_associations);
+            s->cv.notify_all();
+        }).detach();
+    }
+}
+
+#else
+
+void Serve_DICOM_Storage(const dicom_storage_scp_opts &,
+                         const std::list<OperationArgPkg> &,
+                         const std::map<std::string,std::string> &,
+                         const std::string &){
+    throw std::runtime_error("Receiving DICOM objects is not supported on this platform");
+}
+
+#endif
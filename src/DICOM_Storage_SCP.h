@@ -0,0 +1,41 @@
+//DICOM_Storage_SCP.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "Structs.h"
+
+
+// A DICOM Storage Service Class Provider (C-STORE SCP) that feeds received objects directly to the loader.
+//
+// Associations are accepted concurrently, each on its own thread. Objects are decoded in memory as they arrive (see
+// dicom_predecode_cache), so no filesystem round trip is needed. Received objects are grouped by series (or study),
+// and a group is considered complete once no new objects have arrived for it within the quiet period. The operations
+// are then performed on the group's data, independently of other groups. Objects arriving for a group after it has
+// been dispatched begin a new group.
+//
+// Verification (C-ECHO) is also supported. Any storage SOP class is accepted with the implicit or explicit little
+// endian transfer syntaxes, and with the compressed syntaxes the DICOM loader understands. Only associations that call
+// the configured AE title are accepted, unless it is empty.
+struct dicom_storage_scp_opts {
+    long int port = 11112;
+    std::string ae_title = "DICOMAUTOMATON";
+
+    long int max_associations = 16; // The number of associations accepted concurrently.
+    long int max_jobs = 1;          // The number of groups processed concurrently.
+    double quiet_period = 10.0;     // In seconds.
+    bool group_by_study = false;
+
+    // If not empty, received objects are also written to this directory as DICOM files (named after the SOP instance
+    // UID), e.g., for later ingress into a PACS database.
+    std::string store_dir;
+};
+
+// Blocks indefinitely. Throws if the port cannot be bound.
+void Serve_DICOM_Storage(const dicom_storage_scp_opts &opts,
+                         const std::list<OperationArgPkg> &Operations,
+                         const std::map<std::string,std::string> &InvocationMetadata,
+                         const std::string &FilenameLex);
@@ -0,0 +1,891 @@
+//DICOMautomaton_Benchmark.cc - A part of DICOMautomaton 2026.
+//
+// This program times performance-sensitive paths using deterministic, synthetic inputs of several sizes and writes
+// the results as JSON, so that regressions can be tracked between releases.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <map>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/resource.h>
+    #include <sys/types.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+#include "YgorArguments.h"    //Needed for ArgumentHandler class.
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorString.h"       //Needed for SplitStringToVector(...)
+
+#include "Structs.h"
+#include "Common_Boost_Serialization.h"
+#include "File_Loader.h"
+#include "Lexicon_Loader.h"
+#include "Operation_Dispatcher.h"
+#include "Regex_Selectors.h"
+#include "Thread_Pool.h"
+
+#ifdef DCMA_USE_EIGEN
+    #include "Alignment_TPSRPM.h"
+#endif
+
+
+namespace {
+
+// The dimensions of synthetic inputs. Images are cubic voxels with unit spacing.
+struct bench_size {
+    std::string name;
+    long int rows;
+    long int columns;
+    long int images;
+    long int points; // For point-based benchmarks.
+};
+
+const std::vector<bench_size> all_sizes = {
+    { "small",   64,  64,  32,  100 },
+    { "medium", 128, 128,  64,  250 },
+    { "large",  256, 256, 128,  500 },
+};
+
+// A benchmark prepares untimed state, then performs the timed work. State is prepared anew for every repetition so
+// operations which modify their inputs are always presented with identical data.
+struct bench_context {
+    bench_size size;
+    std::string FilenameLex;
+    boost::filesystem::path scratch; // A directory for files written or read during the benchmark.
+    Drover DICOM_data;
+    std::map<std::string, std::string> InvocationMetadata;
+};
+
+struct benchmark {
+    std::string name;
+    std::string desc;
+    std::function<void(bench_context &)> setup;
+    std::function<void(bench_context &)> run;
+};
+
+struct bench_result {
+    std::string name;
+    std::string size;
+    long int threads = 0;       // The worker thread budget, or zero if the default was used.
+    long int max_rss_kib = -1;  // Peak resident memory, if known.
+    std::vector<double> wall_s;
+    std::string error;
+
+    double median() const {
+        auto sorted = this->wall_s;
+        std::sort(std::begin(sorted), std::end(sorted));
+        const auto N = sorted.size();
+        if(N == 0) return std::numeric_limits<double>::quiet_NaN();
+        return (N % 2 == 1) ? sorted[N / 2] : 0.5 * (sorted[N / 2 - 1] + sorted[N / 2]);
+    }
+};
+
+void Run_Operations(bench_context &ctx, const std::list<std::string> &ops){
+    std::list<OperationArgPkg> Operations;
+    for(const auto &op : ops) Operations.emplace_back(op);
+    if(!Operation_Dispatcher(ctx.DICOM_data, ctx.InvocationMetadata, ctx.FilenameLex, Operations)){
+        throw std::runtime_error("Operation failed: '" + ops.front() + "'");
+    }
+    return;
+}
+
+// A simple phantom: a uniform background with a dense sphere and a grid of thin lines. The second variant is slightly
+// displaced and scaled, as if acquired separately, for comparisons.
+void Generate_Phantom(bench_context &ctx, bool variant = false){
+    const auto &s = ctx.size;
+    const vec3<double> centre( 0.5 * static_cast<double>(s.rows - 1) + (variant ? 1.5 : 0.0),
+                               0.5 * static_cast<double>(s.columns - 1),
+                               0.5 * static_cast<double>(s.images - 1) );
+    const double radius = 0.3 * static_cast<double>(std::min({ s.rows, s.columns, s.images })) * (variant ? 1.05 : 1.0);
+
+    std::stringstream ss;
+    ss << std::setprecision(12)
+       << "DrawGeometry:VoxelValue=1000.0:Shapes=solidsphere(" << centre.x << "," << centre.y << "," << centre.z
+       << ", " << radius << ")";
+    Run_Operations(ctx, { "GenerateSyntheticImages"
+                          ":NumberOfImages=" + std::to_string(s.images) +
+                          ":NumberOfRows=" + std::to_string(s.rows) +
+                          ":NumberOfColumns=" + std::to_string(s.columns) +
+                          ":VoxelValue=0.0",
+                          "DrawGeometry:VoxelValue=500.0:Shapes=grid(1.0,0.0,0.0, 0.0,1.0,0.0, 2.0, 16.0)",
+                          ss.str() });
+    return;
+}
+
+#ifdef DCMA_USE_EIGEN
+// A smooth, deterministic warp of pseudo-random points.
+void Generate_Point_Sets(long int N, point_set<double> &moving, point_set<double> &stationary){
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<double> rd(-50.0, 50.0);
+    for(long int i = 0; i < N; ++i){
+        const vec3<double> p(rd(gen), rd(gen), rd(gen));
+        moving.points.emplace_back(p);
+        stationary.points.emplace_back( p.x + 3.0 * std::sin(p.y / 20.0) + 1.0,
+                                        p.y + 2.0 * std::cos(p.z / 25.0),
+                                        p.z * 1.02 - 0.5 );
+    }
+    return;
+}
+#endif // DCMA_USE_EIGEN
+
+std::vector<benchmark> Known_Benchmarks(const std::list<std::string> &pipeline){
+    std::vector<benchmark> out;
+
+    if(!pipeline.empty()){
+        out.push_back({ "pipeline",
+                        "Perform the user-provided operations on the phantom.",
+                        [](bench_context &ctx){
+                            Generate_Phantom(ctx);
+                        },
+                        [pipeline](bench_context &ctx){
+                            Run_Operations(ctx, pipeline);
+                        } });
+    }
+
+    out.push_back({ "dicom_load",
+                    "Load a gzipped TAR archive of CT-modality DICOM files.",
+                    [](bench_context &ctx){
+                        Generate_Phantom(ctx);
+                        const auto fname = (ctx.scratch / "CTs.tgz").string();
+                        Run_Operations(ctx, { "DICOMExportImagesAsCT:Filename=" + fname });
+                        ctx.DICOM_data = Drover();
+                    },
+                    [](bench_context &ctx){
+                        std::list<boost::filesystem::path> paths = { ctx.scratch / "CTs.tgz" };
+                        if(!Load_Files(ctx.DICOM_data, ctx.InvocationMetadata, ctx.FilenameLex, paths, 1)){
+                            throw std::runtime_error("Unable to load DICOM files");
+                        }
+                    } });
+
+    out.push_back({ "voxel_visitor",
+                    "Mutate all voxels within whole-image contours with the partitioned voxel visitor.",
+                    [](bench_context &ctx){
+                        Generate_Phantom(ctx);
+                        Run_Operations(ctx, { "ContourWholeImages:ROILabel=everything" });
+                    },
+                    [](bench_context &ctx){
+                        Run_Operations(ctx, { "HighlightROIs:ROILabelRegex=everything"
+                                              ":InteriorVal=1.0:ExteriorVal=0.0" });
+                    } });
+
+    out.push_back({ "gamma_search",
+                    "Compute the gamma index (3%/3mm) by directly searching the reference neighbourhood.",
+                    [](bench_context &ctx){
+                        Generate_Phantom(ctx);
+                        Generate_Phantom(ctx, true);
+                        Run_Operations(ctx, { "ContourWholeImages:ROILabel=everything:ImageSelection=last" });
+                    },
+                    [](bench_context &ctx){
+                        Run_Operations(ctx, { "ComparePixels:ImageSelection=last:ReferenceImageSelection=first"
+                                              ":ROILabelRegex=everything:Method=gamma-search"
+                                              ":DiscType=relative:GammaDTAThreshold=3.0:GammaDiscThreshold=3.0" });
+                    } });
+
+    out.push_back({ "gamma_index",
+                    "Compute the gamma index (3%/3mm) from separate DTA and discrepancy estimates.",
+                    [](bench_context &ctx){
+                        Generate_Phantom(ctx);
+                        Generate_Phantom(ctx, true);
+                        Run_Operations(ctx, { "ContourWholeImages:ROILabel=everything:ImageSelection=last" });
+                    },
+                    [](bench_context &ctx){
+                        Run_Operations(ctx, { "ComparePixels:ImageSelection=last:ReferenceImageSelection=first"
+                                              ":ROILabelRegex=everything:Method=gamma-index"
+                                              ":DiscType=relative:GammaDTAThreshold=3.0:GammaDiscThreshold=3.0" });
+                    } });
+
+    out.push_back({ "simulate_radiograph",
+                    "Simulate a radiograph with a detector matching the image dimensions.",
+                    [](bench_context &ctx){
+                        Generate_Phantom(ctx);
+                    },
+                    [](bench_context &ctx){
+                        const auto fname = (ctx.scratch / "radiograph.fits").string();
+                        Run_Operations(ctx, { "SimulateRadiograph:Filename=" + fname +
+                                              ":Rows=" + std::to_string(ctx.size.rows) +
+                                              ":Columns=" + std::to_string(ctx.size.columns) });
+                    } });
+
+    out.push_back({ "marching_cubes",
+                    "Extract an iso-surface mesh from the images with marching cubes.",
+                    [](bench_context &ctx){
+                        Generate_Phantom(ctx);
+                    },
+                    [](bench_context &ctx){
+                        Run_Operations(ctx, { "ConvertImageToMeshes:Lower=250.0:Upper=inf:Method=marching" });
+                    } });
+
+#ifdef DCMA_USE_EIGEN
+    out.push_back({ "tps_rpm",
+                    "Register two warped point sets with TPS-RPM.",
+                    [](bench_context &){ },
+                    [](bench_context &ctx){
+                        point_set<double> moving;
+                        point_set<double> stationary;
+                        Generate_Point_Sets(ctx.size.points, moving, stationary);
+                        AlignViaTPSRPMParams params;
+                        if(!AlignViaTPSRPM(params, moving, stationary)){
+                            throw std::runtime_error("TPS-RPM registration failed");
+                        }
+                    } });
+#endif // DCMA_USE_EIGEN
+
+    const auto roundtrip = [](const std::string &name,
+                              const std::string &desc,
+                              std::function<bool(const Drover &, const boost::filesystem::path &)> serialize){
+        return benchmark{ name, desc,
+                          [](bench_context &ctx){
+                              Generate_Phantom(ctx);
+                              Run_Operations(ctx, { "ConvertImageToMeshes:Lower=250.0:Upper=inf:Method=marching" });
+                          },
+                          [serialize](bench_context &ctx){
+                              const auto fname = ctx.scratch / "roundtrip.archive";
+                              Drover reloaded;
+                              if(!serialize(ctx.DICOM_data, fname)
+                              || !Common_Boost_Deserialize_Drover(reloaded, fname)){
+                                  throw std::runtime_error("Archive round-trip failed");
+                              }
+                          } };
+    };
+    out.push_back(roundtrip("archive_roundtrip_gzip_binary",
+                            "Write and read a gzipped binary Boost.Serialization archive of images and meshes.",
+                            [](const Drover &d, const boost::filesystem::path &p){
+                                return Common_Boost_Serialize_Drover_to_Gzip_Binary(d, p);
+                            }));
+    out.push_back(roundtrip("archive_roundtrip_native",
+                            "Write and read a native archive of images and meshes.",
+                            [](const Drover &d, const boost::filesystem::path &p){
+                                return Common_Boost_Serialize_Drover_to_Native_Archive(d, p);
+                            }));
+
+    return out;
+}
+
+bench_result Run_Benchmark(const benchmark &b,
+                           const bench_size &s,
+                           long int repetitions,
+                           const std::string &FilenameLex,
+                           const boost::filesystem::path &scratch){
+    bench_result out;
+    out.name = b.name;
+    out.size = s.name;
+    try{
+        for(long int i = 0; i < repetitions; ++i){
+            bench_context ctx;
+            ctx.size = s;
+            ctx.FilenameLex = FilenameLex;
+            ctx.scratch = scratch;
+            b.setup(ctx);
+
+            const auto t_start = std::chrono::steady_clock::now();
+            b.run(ctx);
+            const auto t_end = std::chrono::steady_clock::now();
+            out.wall_s.push_back( std::chrono::duration<double>(t_end - t_start).count() );
+        }
+    }catch(const std::exception &e){
+        FUNCWARN("Benchmark '" << b.name << "' failed: " << e.what());
+        out.error = e.what();
+    }
+    return out;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Runs the benchmark in a child process with the given worker thread budget. The process-wide worker pool can only be
+// configured once, so a fresh process is needed for each thread count. Using a separate process also isolates the
+// peak resident memory, which covers both the setup and the timed repetitions.
+//
+// Note: the parent must not have started the worker pool (or any other threads) before calling this routine.
+bench_result Run_Benchmark_In_Child(const benchmark &b,
+                                    const bench_size &s,
+                                    long int repetitions,
+                                    long int threads,
+                                    work_stealing_pool_config config,
+                                    const std::string &FilenameLex,
+                                    const boost::filesystem::path &scratch){
+    bench_result out;
+    out.name = b.name;
+    out.size = s.name;
+    out.threads = threads;
+
+    int fds[2];
+    if(pipe(fds) != 0) throw std::runtime_error("Unable to create pipe");
+    std::cout.flush();
+    std::cerr.flush();
+    const pid_t pid = fork();
+    if(pid < 0){
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error("Unable to fork");
+    }
+
+    if(pid == 0){
+        close(fds[0]);
+        config.num_threads = threads;
+        work_stealing_pool::configure(config);
+        const auto r = Run_Benchmark(b, s, repetitions, FilenameLex, scratch);
+
+        std::stringstream ss;
+        ss << std::setprecision(17) << r.wall_s.size();
+        for(const auto &t : r.wall_s) ss << " " << t;
+        ss << "\n" << r.error;
+        const auto msg = ss.str();
+        size_t written = 0;
+        while(written < msg.size()){
+            const auto n = write(fds[1], msg.data() + written, msg.size() - written);
+            if(n <= 0) break;
+            written += static_cast<size_t>(n);
+        }
+        close(fds[1]);
+        std::cout.flush();
+        std::cerr.flush();
+        _exit(0);
+    }
+
+    close(fds[1]);
+    std::string msg;
+    char buf[4096];
+    while(true){
+        const auto n = read(fds[0], buf, sizeof(buf));
+        if(n <= 0) break;
+        msg.append(buf, static_cast<size_t>(n));
+    }
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage ru;
+    if(wait4(pid, &status, 0, &ru) == pid){
+#if defined(__APPLE__)
+        out.max_rss_kib = static_cast<long int>(ru.ru_maxrss) / 1024; // Reported in bytes.
+#else
+        out.max_rss_kib = static_cast<long int>(ru.ru_maxrss); // Reported in KiB.
+#endif
+    }
+
+    std::istringstream iss(msg);
+    size_t N = 0;
+    if(iss >> N){
+        for(size_t i = 0; i < N; ++i){
+            double t = 0.0;
+            if(iss >> t) out.wall_s.push_back(t);
+        }
+        iss.ignore(1);
+        std::getline(iss, out.error, '\0');
+    }
+    if( (!WIFEXITED(status) || (WEXITSTATUS(status) != 0) || (out.wall_s.size() != N)) && out.error.empty() ){
+        out.error = "Benchmark process terminated abnormally";
+    }
+    return out;
+}
+
+// Launches the dispatcher repeatedly with a trivial workload (an empty, virtual dataset and a single inexpensive
+// operation) and reports the duration of each phase of its startup profile, including the time before main(), as
+// results named 'startup:<phase>'. The time from launch to exit and the peak resident memory are reported as
+// 'startup:total'. The dispatcher locates (or creates) a lexicon itself, so lexicon location is also measured.
+//
+// Note: the parent must not have started the worker pool (or any other threads) before calling this routine.
+std::vector<bench_result> Run_Startup_Benchmark(const std::string &dispatcher,
+                                                long int repetitions,
+                                                const boost::filesystem::path &scratch){
+    const std::string size = "trivial";
+    bench_result total;
+    total.name = "startup:total";
+    total.size = size;
+
+    std::vector<std::string> phase_order;
+    std::map<std::string, std::vector<double>> phase_wall_s;
+    for(long int i = 0; i < repetitions; ++i){
+        const auto profile = (scratch / ("startup_" + std::to_string(i) + ".tsv")).string();
+        std::vector<std::string> args = { dispatcher, "--startup-profile", profile,
+                                          "--virtual-data", "--operation", "DeleteImages" };
+        std::vector<char *> argv;
+        for(auto &a : args) argv.push_back(a.data());
+        argv.push_back(nullptr);
+
+        std::cout.flush();
+        std::cerr.flush();
+        const auto t_start = std::chrono::steady_clock::now();
+        const pid_t pid = fork();
+        if(pid < 0) throw std::runtime_error("Unable to fork");
+
+        if(pid == 0){
+            // The launch time is taken as late as possible so that forking is not attributed to the dispatcher.
+            const auto epoch_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::system_clock::now().time_since_epoch() ).count();
+            setenv("DCMA_STARTUP_EPOCH_NS", std::to_string(epoch_ns).c_str(), 1);
+            const int devnull = open("/dev/null", O_WRONLY);
+            if(0 <= devnull){
+                dup2(devnull, STDOUT_FILENO);
+                dup2(devnull, STDERR_FILENO);
+                close(devnull);
+            }
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+
+        int status = 0;
+        struct rusage ru;
+        const bool waited = (wait4(pid, &status, 0, &ru) == pid);
+        const auto t_end = std::chrono::steady_clock::now();
+        if( !waited || !WIFEXITED(status) || (WEXITSTATUS(status) != 0) ){
+            total.error = (waited && WIFEXITED(status) && (WEXITSTATUS(status) == 127))
+                        ? "Unable to launch '" + dispatcher + "'"
+                        : "Dispatcher terminated abnormally";
+            break;
+        }
+        total.wall_s.push_back( std::chrono::duration<double>(t_end - t_start).count() );
+#if defined(__APPLE__)
+        total.max_rss_kib = std::max(total.max_rss_kib, static_cast<long int>(ru.ru_maxrss) / 1024);
+#else
+        total.max_rss_kib = std::max(total.max_rss_kib, static_cast<long int>(ru.ru_maxrss));
+#endif
+
+        std::ifstream ifs(profile);
+        std::string line;
+        bool any_phases = false;
+        while(std::getline(ifs, line)){
+            std::istringstream iss(line);
+            std::string name;
+            double start = 0.0;
+            double duration = 0.0;
+            if( !std::getline(iss, name, '\t') || !(iss >> start >> duration) ) continue;
+            if(phase_wall_s.count(name) == 0) phase_order.push_back(name);
+            phase_wall_s[name].push_back(duration);
+            any_phases = true;
+        }
+        if(!any_phases){
+            total.error = "No startup profile was written. Does the dispatcher support '--startup-profile'?";
+            break;
+        }
+    }
+
+    std::vector<bench_result> out;
+    for(const auto &name : phase_order){
+        bench_result r;
+        r.name = "startup:" + name;
+        r.size = size;
+        r.wall_s = phase_wall_s[name];
+        out.push_back(r);
+    }
+    out.push_back(total);
+    return out;
+}
+#endif
+
+std::string JSON_Escape(const std::string &in){
+    std::stringstream ss;
+    for(const auto c : in){
+        if(c == '"'){             ss << "\\\"";
+        }else if(c == '\\'){      ss << "\\\\";
+        }else if(c == '\n'){      ss << "\\n";
+        }else if(c == '\t'){      ss << "\\t";
+        }else if(static_cast<unsigned char>(c) < 0x20){
+            ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+               << std::dec << std::setfill(' ');
+        }else{
+            ss << c;
+        }
+    }
+    return ss.str();
+}
+
+// Speedup and parallel efficiency for one benchmark and size, relative to the smallest thread count swept.
+struct scaling_curve {
+    std::string name;
+    std::string size;
+    std::vector<long int> threads;
+    std::vector<double> speedup;
+    std::vector<double> efficiency;
+    std::vector<long int> max_rss_kib;
+    long int saturation_threads = 0; // Beyond this count, speedup improves by less than 10%.
+    bool scales_poorly = false;
+};
+
+std::vector<scaling_curve> Summarize_Scaling(const std::vector<bench_result> &results, double efficiency_threshold){
+    std::vector<scaling_curve> out;
+    std::map<std::pair<std::string, std::string>, std::vector<const bench_result*>> groups;
+    std::vector<std::pair<std::string, std::string>> order;
+    for(const auto &r : results){
+        if( (r.threads <= 0) || !r.error.empty() || r.wall_s.empty() ) continue;
+        const auto key = std::make_pair(r.name, r.size);
+        if(groups.count(key) == 0) order.push_back(key);
+        groups[key].push_back(&r);
+    }
+
+    for(const auto &key : order){
+        auto &rs = groups[key];
+        std::sort(std::begin(rs), std::end(rs), [](const bench_result *l, const bench_result *r){
+            return (l->threads < r->threads);
+        });
+        const auto base_threads = static_cast<double>(rs.front()->threads);
+        const auto base_time = rs.front()->median();
+
+        scaling_curve c;
+        c.name = key.first;
+        c.size = key.second;
+        for(const auto &r : rs){
+            const auto S = base_time / r->median();
+            c.threads.push_back(r->threads);
+            c.speedup.push_back(S);
+            c.efficiency.push_back(S * base_threads / static_cast<double>(r->threads));
+            c.max_rss_kib.push_back(r->max_rss_kib);
+        }
+
+        const auto N = c.threads.size();
+        c.saturation_threads = c.threads.back();
+        for(size_t i = 0; i < N; ++i){
+            const auto best_later = *std::max_element(std::next(std::begin(c.speedup), i), std::end(c.speedup));
+            if(best_later < 1.1 * c.speedup[i]){
+                c.saturation_threads = c.threads[i];
+                break;
+            }
+        }
+        c.scales_poorly = (1 < N) && (c.efficiency.back() < efficiency_threshold);
+        out.push_back(c);
+    }
+    return out;
+}
+
+void Write_JSON(std::ostream &os,
+                const std::vector<bench_result> &results,
+                const std::vector<scaling_curve> &curves,
+                long int repetitions){
+    const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    os << std::setprecision(9);
+    os << "{\n"
+       << "  \"program\": \"dicomautomaton_benchmark\",\n"
+       << "  \"timestamp\": " << static_cast<int64_t>(now) << ",\n"
+       << "  \"threads\": " << work_stealing_pool::get().concurrency() << ",\n"
+       << "  \"repetitions\": " << repetitions << ",\n"
+       << "  \"results\": [";
+    bool first = true;
+    for(const auto &r : results){
+        os << (first ? "\n" : ",\n");
+        first = false;
+
+        auto sorted = r.wall_s;
+        std::sort(std::begin(sorted), std::end(sorted));
+        os << "    { \"name\": \"" << JSON_Escape(r.name) << "\", \"size\": \"" << JSON_Escape(r.size) << "\"";
+        if(0 < r.threads) os << ", \"threads\": " << r.threads;
+        if(0 <= r.max_rss_kib) os << ", \"max_rss_kib\": " << r.max_rss_kib;
+        if(!r.error.empty()){
+            os << ", \"error\": \"" << JSON_Escape(r.error) << "\"";
+        }
+        if(!sorted.empty()){
+            double sum = 0.0;
+            for(const auto &t : sorted) sum += t;
+            os << ", \"min_s\": " << sorted.front()
+               << ", \"median_s\": " << r.median()
+               << ", \"mean_s\": " << sum / static_cast<double>(sorted.size())
+               << ", \"max_s\": " << sorted.back()
+               << ", \"wall_s\": [";
+            for(size_t i = 0; i < r.wall_s.size(); ++i) os << (i == 0 ? "" : ", ") << r.wall_s[i];
+            os << "]";
+        }
+        os << " }";
+    }
+    os << "\n  ]";
+
+    if(!curves.empty()){
+        const auto write_array = [&os](const auto &v){
+            os << "[";
+            for(size_t i = 0; i < v.size(); ++i) os << (i == 0 ? "" : ", ") << v[i];
+            os << "]";
+        };
+        os << ",\n  \"scaling\": [";
+        first = true;
+        for(const auto &c : curves){
+            os << (first ? "\n" : ",\n");
+            first = false;
+            os << "    { \"name\": \"" << JSON_Escape(c.name) << "\", \"size\": \"" << JSON_Escape(c.size) << "\"";
+            os << ", \"threads\": ";
+            write_array(c.threads);
+            os << ", \"speedup\": ";
+            write_array(c.speedup);
+            os << ", \"efficiency\": ";
+            write_array(c.efficiency);
+            os << ", \"max_rss_kib\": ";
+            write_array(c.max_rss_kib);
+            os << ", \"saturation_threads\": " << c.saturation_threads
+               << ", \"scales_poorly\": " << (c.scales_poorly ? "true" : "false") << " }";
+        }
+        os << "\n  ]";
+    }
+    os << "\n}\n";
+    return;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]){
+
+    std::string FilenameOut = "dicomautomaton_benchmark.json";
+    std::string SizesStr = "small,medium";
+    std::string FilterStr = ".*";
+    long int Repetitions = 3;
+    bool ListOnly = false;
+    std::string FilenameLex;
+    std::string ThreadSweepStr;
+    double EfficiencyThreshold = 0.5;
+    std::list<std::string> Pipeline;
+    std::string DispatcherExe;
+
+    work_stealing_pool_config ThreadPoolConfig;
+    try{
+        ThreadPoolConfig = work_stealing_pool::config_from_environment();
+    }catch(const std::exception &e){
+        FUNCERR("Unable to parse thread pool environment variables: " << e.what());
+    }
+
+    //================================================ Argument Parsing ==============================================
+
+    class ArgumentHandler arger;
+    arger.examples = { { "--help",
+                         "Show the help screen and some info about the program." },
+                       { "-o results.json",
+                         "Run the default benchmarks and write the results to 'results.json'." },
+                       { "-s small,medium,large -r 5",
+                         "Run all benchmarks at all sizes, repeating each five times." },
+                       { "-f 'gamma.*' -s large",
+                         "Run only the gamma benchmarks at the largest size." },
+                       { "-T 1,2,4,8,16 -s medium,large -f 'gamma.*|marching_cubes'",
+                         "Measure how the gamma and marching cubes benchmarks scale with thread count and size." },
+                       { "-T 1,2,4,8 -p 'ContourWholeImages' -p 'HighlightROIs:InteriorVal=1.0' -f pipeline",
+                         "Measure how a custom operation pipeline scales with thread count." },
+                       { "-d ./dicomautomaton_dispatcher -r 20",
+                         "Measure the startup of the dispatcher, broken down by phase." },
+                       { "-L",
+                         "List the available benchmarks." }
+                     };
+    arger.description = "A program for timing performance-sensitive DICOMautomaton routines using synthetic data."
+                        " Results are written as JSON.";
+
+    arger.default_callback = [](int, const std::string &optarg) -> void {
+      FUNCERR("Unrecognized option with argument: '" << optarg << "'");
+      return;
+    };
+    arger.optionless_callback = [](const std::string &optarg) -> void {
+      FUNCERR("Unrecognized option with argument: '" << optarg << "'");
+      return;
+    };
+
+    arger.push_back( ygor_arg_handlr_t(1, 'o', "output", true, FilenameOut,
+      "Output filename for the JSON results. Use '-' to write to stdout.",
+      [&](const std::string &optarg) -> void {
+        FilenameOut = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(2, 's', "sizes", true, SizesStr,
+      "A comma-separated list of input sizes to benchmark. Supported: small, medium, large.",
+      [&](const std::string &optarg) -> void {
+        SizesStr = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(3, 'f', "filter", true, FilterStr,
+      "A regular expression selecting benchmarks by name.",
+      [&](const std::string &optarg) -> void {
+        FilterStr = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(4, 'r', "repetitions", true, std::to_string(Repetitions),
+      "The number of timed repetitions of each benchmark. Each is preceded by an untimed setup.",
+      [&](const std::string &optarg) -> void {
+        Repetitions = std::stol(optarg);
+        if(Repetitions < 1) FUNCERR("At least one repetition is required");
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(5, 't', "threads", true, "0",
+      "The maximum number of worker threads to use. A value of zero uses all CPUs available to the process.",
+      [&](const std::string &optarg) -> void {
+        ThreadPoolConfig.num_threads = std::stol(optarg);
+        if(ThreadPoolConfig.num_threads < 0) FUNCERR("Thread count must be non-negative");
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(6, 'l', "lexicon", true, "<best guess>",
+      "Explicitly specify a lexicon file for normalizing ROI names.",
+      [&](const std::string &optarg) -> void {
+        FilenameLex = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(8, 'T', "thread-sweep", true, "1,2,4,8",
+      "A comma-separated list of worker thread counts. Each benchmark is run once per thread count (in a separate"
+      " process) and the speedup, parallel efficiency, and peak resident memory are reported. Overrides '--threads'.",
+      [&](const std::string &optarg) -> void {
+        ThreadSweepStr = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(9, 'e', "efficiency-threshold", true, "0.5",
+      "In a thread sweep, benchmarks with a parallel efficiency below this value at the largest thread count are"
+      " flagged as scaling poorly.",
+      [&](const std::string &optarg) -> void {
+        EfficiencyThreshold = std::stod(optarg);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(10, 'p', "pipeline", true, "HighlightROIs:InteriorVal=1.0",
+      "An operation (with arguments, as for dicomautomaton_dispatcher) to benchmark on the synthetic phantom."
+      " This option can be repeated to benchmark a sequence of operations, which is named 'pipeline'.",
+      [&](const std::string &optarg) -> void {
+        Pipeline.emplace_back(optarg);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(11, 'd', "dispatcher", true, "/usr/bin/dicomautomaton_dispatcher",
+      "Instead of running the benchmarks, measure the startup of the given dispatcher executable. Each repetition"
+      " launches it with a trivial workload and reports the duration of each phase of its startup profile (see the"
+      " dispatcher's '--startup-profile' option), including the time before main() that is spent loading shared"
+      " libraries and initializing static data. Sizes, filters, and thread sweeps do not apply.",
+      [&](const std::string &optarg) -> void {
+        DispatcherExe = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(7, 'L', "list", false, "",
+      "List the available benchmarks and exit.",
+      [&](const std::string &) -> void {
+        ListOnly = true;
+        return;
+      })
+    );
+
+    arger.Launch(argc, argv);
+
+    //============================================== Input Verification ==============================================
+
+    const auto benchmarks = Known_Benchmarks(Pipeline);
+    if(ListOnly){
+        for(const auto &b : benchmarks) std::cout << b.name << "\t" << b.desc << std::endl;
+        return 0;
+    }
+
+    std::vector<bench_size> sizes;
+    for(const auto &s : SplitStringToVector(SizesStr, ',', 'd')){
+        const auto it = std::find_if(std::begin(all_sizes), std::end(all_sizes),
+                                     [&](const bench_size &bs){ return (bs.name == s); });
+        if(it == std::end(all_sizes)) FUNCERR("Size '" << s << "' not understood");
+        sizes.push_back(*it);
+    }
+    const auto filter = Compile_Regex(FilterStr);
+
+    std::vector<long int> thread_sweep;
+    for(const auto &t : SplitStringToVector(ThreadSweepStr, ',', 'd')){
+        thread_sweep.push_back(std::stol(t));
+        if(thread_sweep.back() < 1) FUNCERR("Thread counts in a sweep must be positive");
+    }
+#if !defined(__unix__) && !defined(__APPLE__)
+    if(!thread_sweep.empty()) FUNCERR("Thread sweeps are not supported on this platform");
+    if(!DispatcherExe.empty()) FUNCERR("Startup benchmarks are not supported on this platform");
+#endif
+
+    // Note: in a sweep, the pool is configured separately in each child process.
+    if( thread_sweep.empty()
+    &&  !work_stealing_pool::configure(ThreadPoolConfig) ){
+        FUNCWARN("Worker pool was started before it could be configured. Ignoring thread settings");
+    }
+
+    if(FilenameLex.empty()) FilenameLex = Locate_Lexicon_File();
+    if(FilenameLex.empty()) FilenameLex = Create_Default_Lexicon_File();
+
+    const auto scratch = boost::filesystem::temp_directory_path()
+                       / boost::filesystem::unique_path("dcma_benchmark_%%%%-%%%%-%%%%");
+    boost::filesystem::create_directories(scratch);
+
+    //================================================== Benchmarks ==================================================
+
+    std::vector<bench_result> results;
+    if(!DispatcherExe.empty()){
+#if defined(__unix__) || defined(__APPLE__)
+        FUNCINFO("Benchmarking the startup of '" << DispatcherExe << "'");
+        results = Run_Startup_Benchmark(DispatcherExe, Repetitions, scratch);
+#endif
+    }else{
+        for(const auto &b : benchmarks){
+            if(!std::regex_match(b.name, filter)) continue;
+            for(const auto &s : sizes){
+                if(thread_sweep.empty()){
+                    FUNCINFO("Benchmarking '" << b.name << "' with size '" << s.name << "'");
+                    results.emplace_back( Run_Benchmark(b, s, Repetitions, FilenameLex, scratch) );
+                    continue;
+                }
+#if defined(__unix__) || defined(__APPLE__)
+                for(const auto &t : thread_sweep){
+                    FUNCINFO("Benchmarking '" << b.name << "' with size '" << s.name << "' and " << t << " threads");
+                    results.emplace_back( Run_Benchmark_In_Child(b, s, Repetitions, t, ThreadPoolConfig,
+                                                                 FilenameLex, scratch) );
+                }
+#endif
+            }
+        }
+    }
+
+    const auto curves = Summarize_Scaling(results, EfficiencyThreshold);
+    for(const auto &c : curves){
+        if(c.scales_poorly){
+            FUNCWARN("Benchmark '" << c.name << "' with size '" << c.size << "' scales poorly: efficiency is "
+                     << c.efficiency.back() << " with " << c.threads.back() << " threads and speedup saturates at "
+                     << c.saturation_threads << " threads");
+        }
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(scratch, ec);
+
+    //==================================================== Output ====================================================
+
+    if(FilenameOut == "-"){
+        Write_JSON(std::cout, results, curves, Repetitions);
+    }else{
+        std::ofstream ofs(FilenameOut);
+        Write_JSON(ofs, results, curves, Repetitions);
+        ofs.flush();
+        if(!ofs){
+            FUNCERR("Unable to write results to '" << FilenameOut << "'");
+        }
+        FUNCINFO("Wrote results to '" << FilenameOut << "'");
+    }
+
+    bool any_failed = false;
+    for(const auto &r : results) any_failed = any_failed || !r.error.empty();
+    return (any_failed ? 1 : 0);
+}
@@ -3,12 +3,14 @@
 // This program provides a standard entry-point into some DICOMautomaton analysis routines.
 //
 
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <iostream>
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>    
 #include <vector>
 //#include <cfenv>              //Needed for std::feclearexcept(FE_ALL_EXCEPT).
@@ -25,11 +27,19 @@
 #include "Structs.h"
 
 #include "Documentation.h"
+#include "Imebra_Shim.h"
 #include "PACS_Loader.h"
 #include "File_Loader.h"
 #include "Lexicon_Loader.h"
 
 #include "Operation_Dispatcher.h"
+#include "Startup_Profile.h"
+#include "Dispatch_Server.h"
+#include "DICOM_Storage_SCP.h"
+#include "Distributed_Dispatch.h"
+#include "Drover_Memory.h"
+#include "Thread_Pool.h"
+#include "Tracing.h"
 
 
 int main(int argc, char* argv[]){
@@ -40,6 +50,8 @@ int main(int argc, char* argv[]){
     // Because the loader and analysis stages are separate, and separate from each other, this code should be amenable
     // to both direct use and remote use via some RPC mechanism.
     //
+    Begin_Startup_Profile();
+    Begin_Startup_Phase("arguments");
 
     //------------------------------------------------- Data: General ------------------------------------------------
     // The following objects should remain available for the analysis dispatcher and for some analysis routines (where
@@ -65,6 +77,15 @@ int main(int argc, char* argv[]){
     //A Boolean guard variable to ensure loose parameters are only added to valid, active operations.
     bool MostRecentOperationActive = false;
 
+    //Settings for the process-wide worker pool which all parallel routines share. The environment provides defaults
+    // that can be overridden on the command line.
+    work_stealing_pool_config ThreadPoolConfig;
+    try{
+        ThreadPoolConfig = work_stealing_pool::config_from_environment();
+    }catch(const std::exception &e){
+        FUNCERR("Unable to parse thread pool environment variables: " << e.what());
+    }
+
 
     //------------------------------------------------- Data: Database -----------------------------------------------
     // The following objects are only relevant for the PACS database loader.
@@ -91,6 +112,28 @@ int main(int argc, char* argv[]){
     std::list<std::string> StandaloneFilesDirs;  // Used to defer filesystem checking.
     std::list<boost::filesystem::path> StandaloneFilesDirsReachable;
 
+    //The number of threads to use when decoding files. Files are loaded sequentially by default.
+    long int LoaderThreadCount = 1;
+
+    //Whether to defer decoding image pixel data until first needed.
+    bool DeferPixelDecoding = false;
+
+    //The memory budget for the data, in MiB, and where to spill image arrays that exceed it.
+    std::optional<double> MemoryBudgetMiB;
+    std::string MemoryScratchDir;
+
+    //Where and how often to checkpoint the data while performing operations.
+    dispatch_checkpoint_opts CheckpointOpts;
+
+    //Settings for serving jobs over a socket, rather than performing a single invocation.
+    dispatch_server_opts ServerOpts;
+
+    //Settings for receiving DICOM objects over the network, rather than loading files.
+    std::optional<dicom_storage_scp_opts> StorageOpts;
+
+    //Settings for distributing inputs across worker nodes, rather than performing the operations locally.
+    distributed_dispatch_opts DistributedOpts;
+
 
     //================================================ Argument Parsing ==============================================
 
@@ -178,6 +221,95 @@ int main(int argc, char* argv[]){
       })
     );
 
+    arger.push_back( ygor_arg_handlr_t(225, 'j', "load-threads", true, "1",
+      "The number of threads to use when decoding standalone files. Files are decoded concurrently,"
+      " but are merged in the same order as they would be if loaded sequentially."
+      " A value of zero uses all threads permitted by the worker thread budget (see --threads).",
+      [&](const std::string &optarg) -> void {
+        try{
+          LoaderThreadCount = std::stol(optarg);
+          if(LoaderThreadCount < 0) throw std::invalid_argument("Thread count must be non-negative");
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse loader thread count: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(225, 'D', "defer-pixel-decoding", false, "",
+      "Defer decoding the pixel data of standalone DICOM image files until the pixels are first needed."
+      " Images discarded based only on their metadata or geometry are never decoded."
+      " The raw file contents are retained until decoding, and pixel data errors are reported late.",
+      [&](const std::string &) -> void {
+        DeferPixelDecoding = true;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(226, 't', "threads", true, "0",
+      "The maximum number of worker threads this process will use for all parallel routines, including file"
+      " loading. This is useful for running several instances on a single machine without oversubscription."
+      " A value of zero uses all CPUs available to the process. Overrides the DCMA_THREADS environment variable.",
+      [&](const std::string &optarg) -> void {
+        try{
+          ThreadPoolConfig.num_threads = std::stol(optarg);
+          if(ThreadPoolConfig.num_threads < 0) throw std::invalid_argument("Thread count must be non-negative");
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse thread count: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(227, 'a', "cpu-affinity", true, "0-7,16-23",
+      "A list of CPUs to pin worker threads to. Workers are assigned to the listed CPUs round-robin."
+      " By default workers are not pinned. Overrides the DCMA_CPU_AFFINITY environment variable.",
+      [&](const std::string &optarg) -> void {
+        try{
+          ThreadPoolConfig.cpus = work_stealing_pool::parse_cpu_list(optarg);
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse CPU list: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(227, 'I', "numa-interleave", false, "",
+      "Interleave the pages of large volume buffers over all NUMA nodes, rather than placing them on the node of the"
+      " thread that first writes them. This gives consistent memory bandwidth across sockets when the threads that"
+      " access a buffer are not known in advance. Has no effect on systems with a single node."
+      " Overrides the DCMA_NUMA_PLACEMENT environment variable.",
+      [&](const std::string &) -> void {
+        Set_NUMA_Placement(numa_placement::interleave);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(228, 'b', "memory-budget", true, "4096",
+      "An approximate limit, in MiB, on the memory consumed by the loaded data. Between top-level operations, the"
+      " pixel data of the least-recently-used image arrays is spilled to memory-mapped scratch files until the"
+      " limit is honoured, and paged back in when an operation selects them. Only image arrays are spilled."
+      " A value of zero disables the limit. Overrides the DCMA_MEMORY_BUDGET_MB environment variable.",
+      [&](const std::string &optarg) -> void {
+        try{
+          MemoryBudgetMiB = std::stod(optarg);
+          if(!(0.0 <= MemoryBudgetMiB.value())) throw std::invalid_argument("Budget must be non-negative");
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse memory budget: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(229, 'B', "memory-scratch-dir", true, "/tmp/",
+      "The directory where image arrays are spilled when the memory budget is exceeded (see --memory-budget)."
+      " The system's temporary directory is used by default.",
+      [&](const std::string &optarg) -> void {
+        MemoryScratchDir = optarg;
+        return;
+      })
+    );
+
     arger.push_back( ygor_arg_handlr_t(230, 'v', "virtual-data", false, "",
       "Inform the loaders that virtual data will be generated. Use with care, because this"
       " option causes checks to be skipped that could break assumptions in some operations.",
@@ -187,6 +319,232 @@ int main(int argc, char* argv[]){
       })
     );
 
+    arger.push_back( ygor_arg_handlr_t(240, 'P', "profile", true, "/tmp/trace.json",
+      "Record the wall time, CPU time, peak memory growth, and the amount of data present before and after"
+      " each operation (including child operations). The profile is written to the given file in the"
+      " Chrome trace event format. Overrides the DCMA_PROFILE environment variable.",
+      [&](const std::string &optarg) -> void {
+        Enable_Operation_Profiling(optarg);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(240, 'R', "trace", true, "/tmp/zones.json",
+      "Record the time spent in instrumented routines (e.g., file loaders, voxel visitors, ray casters, and mesh"
+      " generation) on every thread. The trace is written to the given file in the Chrome trace event format, and can"
+      " be viewed with Perfetto. Requires tracing to be enabled at compile time (WITH_TRACING)."
+      " Overrides the DCMA_TRACE environment variable.",
+      [&](const std::string &optarg) -> void {
+        Enable_Tracing(optarg);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(240, 'E', "startup-profile", true, "/tmp/startup.tsv",
+      "Record the wall time of each phase of startup (e.g., argument parsing, locating the lexicon, and initializing"
+      " the DICOM codecs) along with data loading and the operations. The profile is written to the given file as"
+      " tab-separated text. Overrides the DCMA_STARTUP_PROFILE environment variable.",
+      [&](const std::string &optarg) -> void {
+        Enable_Startup_Profile(optarg);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(241, 'C', "concurrent-operations", false, "",
+      "Perform consecutive operations that access disjoint data (e.g., exports to separate files) concurrently."
+      " Operations that depend on one another are still performed in the order given, so results are unaffected.",
+      [&](const std::string &) -> void {
+        Enable_Concurrent_Dispatch(true);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(242, 'M', "memoize", true, "/path/to/cache/",
+      "Cache the results of expensive, deterministic operations in the given directory, and reuse them when the same"
+      " operation is later performed with the same arguments on the same data. Operations that write files as a"
+      " side-effect are not cached. Overrides the DCMA_MEMOIZE_DIR environment variable.",
+      [&](const std::string &optarg) -> void {
+        Enable_Operation_Memoization(optarg);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(243, 'K', "checkpoint", true, "/path/to/checkpoints/",
+      "Save the data to the given directory after performing top-level operations. If an earlier invocation with the"
+      " same operations and inputs was interrupted, resume after the operations it completed."
+      " Checkpoints are removed once all operations have completed.",
+      [&](const std::string &optarg) -> void {
+        CheckpointOpts.dirname = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(244, 'k', "checkpoint-interval", true, "1",
+      "The number of top-level operations to perform between checkpoints (see --checkpoint).",
+      [&](const std::string &optarg) -> void {
+        try{
+          CheckpointOpts.interval = std::stol(optarg);
+          if(CheckpointOpts.interval <= 0) throw std::invalid_argument("Interval must be positive");
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse checkpoint interval: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(244, 'T', "operation-timeout", true, "3600",
+      "The maximum number of seconds each operation may take. Operations that take longer are cancelled and the"
+      " analysis fails. Operations are cancelled cooperatively, so some may overrun the limit.",
+      [&](const std::string &optarg) -> void {
+        try{
+          Set_Operation_Timeout(std::stod(optarg));
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse operation timeout: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(245, 'S', "serve", true, "/tmp/dcma.sock",
+      "Rather than performing a single invocation, wait for jobs submitted over the given local socket."
+      " Each job lists files, metadata, and operations with the same names as the command line options,"
+      " one per line, followed by a 'run' line. Data are loaded separately for each job, but lexicons,"
+      " caches, and worker threads are shared between jobs. Sending only 'shutdown' stops the server."
+      " An address of the form 'tcp://host:port' accepts jobs over the network instead (e.g., to act as a worker"
+      " for --distribute), but connections are not authenticated, so only do so on trusted networks.",
+      [&](const std::string &optarg) -> void {
+        ServerOpts.socket_path = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(246, 'J', "serve-jobs", true, "1",
+      "The number of jobs to perform concurrently when serving jobs (see --serve), or the number of jobs to submit"
+      " to each worker concurrently when distributing them (see --distribute).",
+      [&](const std::string &optarg) -> void {
+        try{
+          ServerOpts.max_jobs = std::stol(optarg);
+          if(ServerOpts.max_jobs <= 0) throw std::invalid_argument("Job count must be positive");
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse concurrent job count: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(247, 'L', "dicom-listen", true, "11112",
+      "Rather than loading files, receive DICOM objects sent to the given TCP port (i.e., act as a C-STORE SCP)."
+      " Associations are accepted concurrently and objects are decoded as they arrive. Once a series has been"
+      " quiet for a while (see --dicom-quiet-period), the operations are performed on its data. Series are"
+      " processed independently, and --serve-jobs of them can be processed concurrently.",
+      [&](const std::string &optarg) -> void {
+        try{
+          if(!StorageOpts) StorageOpts.emplace();
+          StorageOpts->port = std::stol(optarg);
+          if( (StorageOpts->port <= 0) || (65535 < StorageOpts->port) ){
+            throw std::invalid_argument("Port must be within [1:65535]");
+          }
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse port: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(248, 'A', "dicom-ae-title", true, "DICOMAUTOMATON",
+      "The AE title that peers must call when sending DICOM objects (see --dicom-listen)."
+      " If empty, associations are accepted regardless of the called AE title.",
+      [&](const std::string &optarg) -> void {
+        if(!StorageOpts) StorageOpts.emplace();
+        if(16 < optarg.size()) FUNCERR("AE titles are limited to 16 characters");
+        StorageOpts->ae_title = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(249, 'Q', "dicom-quiet-period", true, "10.0",
+      "The number of seconds without new objects after which a received series is considered complete"
+      " (see --dicom-listen).",
+      [&](const std::string &optarg) -> void {
+        try{
+          if(!StorageOpts) StorageOpts.emplace();
+          StorageOpts->quiet_period = std::stod(optarg);
+          if(!(0.0 <= StorageOpts->quiet_period)) throw std::invalid_argument("Quiet period must be non-negative");
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse quiet period: " << e.what());
+        }
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(250, 'X', "dicom-store-dir", true, "/tmp/received/",
+      "Also write received DICOM objects to the given directory, named after their SOP instance UIDs"
+      " (see --dicom-listen). Objects are otherwise only held in memory.",
+      [&](const std::string &optarg) -> void {
+        if(!StorageOpts) StorageOpts.emplace();
+        StorageOpts->store_dir = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(251, 'G', "dicom-group-by-study", false, "",
+      "Perform the operations on each received study, rather than each received series (see --dicom-listen).",
+      [&](const std::string &) -> void {
+        if(!StorageOpts) StorageOpts.emplace();
+        StorageOpts->group_by_study = true;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(252, 'W', "distribute", true, "worker1:7000",
+      "Rather than performing the operations locally, distribute the inputs across the given worker, which should be"
+      " serving jobs over TCP (see --serve). Provide this option once per worker. Inputs are sharded by the values of"
+      " the partition keys (see --distribute-keys), and each shard is performed by a single worker. Workers read the"
+      " inputs by path, so inputs must be reachable by the same paths on every worker (e.g., a shared filesystem)."
+      " The data resulting from each shard are returned as a native archive (see --distribute-output-dir)."
+      " Failed shards are retried on other workers (see --distribute-attempts).",
+      [&](const std::string &optarg) -> void {
+        DistributedOpts.workers.push_back(optarg);
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(253, 'Y', "distribute-keys", true, "PatientID",
+      "The metadata keys used to shard the inputs when distributing them (see --distribute), separated by ';'."
+      " Inputs with distinct combinations of values are placed in separate shards, as with ForEachDistinct, and all"
+      " inputs lacking any of the keys are placed in one additional shard.",
+      [&](const std::string &optarg) -> void {
+        DistributedOpts.keys.clear();
+        for(const auto &k : SplitStringToVector(optarg, ';', 'd')){
+          if(!k.empty()) DistributedOpts.keys.push_back(k);
+        }
+        if(DistributedOpts.keys.empty()) FUNCERR("No partition keys provided");
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(254, 'O', "distribute-output-dir", true, "/tmp/results/",
+      "The directory where the native archive resulting from each shard is written when distributing the inputs"
+      " (see --distribute).",
+      [&](const std::string &optarg) -> void {
+        DistributedOpts.output_dir = optarg;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(255, 'N', "distribute-attempts", true, "3",
+      "The number of times each shard is attempted before it is considered failed (see --distribute).",
+      [&](const std::string &optarg) -> void {
+        try{
+          DistributedOpts.max_attempts = std::stol(optarg);
+          if(DistributedOpts.max_attempts <= 0) throw std::invalid_argument("Attempt count must be positive");
+        }catch(const std::exception &e){
+          FUNCERR("Unable to parse attempt count: " << e.what());
+        }
+        return;
+      })
+    );
+
     arger.push_back( ygor_arg_handlr_t(300, 'm', "metadata", true, "'Volunteer=01'",
       "Metadata key-value pairs which are tacked onto results destined for a database. "
       "If there is an conflicting key-value pair, the values are concatenated.",
@@ -311,11 +669,24 @@ int main(int argc, char* argv[]){
 #endif // DCMA_USE_POSTGRES
 
 
-    //Convert directories to filenames.
-// TODO.
+    //Configure the process-wide worker pool before any parallel routines are invoked.
+    Begin_Startup_Phase("configuration");
+    if(!work_stealing_pool::configure(ThreadPoolConfig)){
+        FUNCWARN("Worker pool was started before it could be configured. Ignoring thread settings");
+    }
+    const auto ThreadBudget = work_stealing_pool::get().concurrency();
 
+    if(MemoryBudgetMiB){
+        Set_Drover_Memory_Budget(static_cast<uint64_t>(MemoryBudgetMiB.value() * 1024.0 * 1024.0), MemoryScratchDir);
+    }else if(!MemoryScratchDir.empty()){
+        Set_Drover_Memory_Budget(Get_Drover_Memory_Budget(), MemoryScratchDir);
+    }
+    if( (LoaderThreadCount == 0)
+    ||  (ThreadBudget < LoaderThreadCount) ){
+        LoaderThreadCount = ThreadBudget;
+    }
 
-    //Remove non-existent filenames and directories.
+    //Remove non-existent filenames and directories. (Directories are recursively expanded by the loaders.)
     {
         boost::filesystem::path PathShuttle;
         for(const auto &auri : StandaloneFilesDirs){
@@ -334,6 +705,7 @@ int main(int argc, char* argv[]){
     }
 
     //Try find a lexicon file if none were provided.
+    Begin_Startup_Phase("lexicon");
     if(FilenameLex.empty()){
         FilenameLex = Locate_Lexicon_File();
         if(FilenameLex.empty()){
@@ -346,6 +718,71 @@ int main(int argc, char* argv[]){
         FUNCINFO("Using file '" << FilenameLex << "' as lexicon");
     }
 
+    Begin_Startup_Phase("dicom_codecs");
+    Initialize_DICOM_Codecs();
+
+    //The operation table is otherwise built when first needed, which would be attributed to a later phase.
+    if(Startup_Profile_Enabled()){
+        Begin_Startup_Phase("known_operations");
+        static_cast<void>(Cached_Known_Operations());
+    }
+    End_Startup_Phase();
+
+    //When serving jobs, all files and operations are provided by the jobs.
+    if(!ServerOpts.socket_path.empty()){
+        if( !StandaloneFilesDirs.empty()
+        ||  !Operations.empty() ){
+            FUNCWARN("Files and operations are provided by each job when serving jobs. Ignoring them");
+        }
+        ServerOpts.loader_threads = LoaderThreadCount;
+        ServerOpts.defer_pixels = DeferPixelDecoding;
+        Write_Startup_Profile();
+        try{
+            Serve_Dispatch_Jobs(ServerOpts, InvocationMetadata, FilenameLex);
+        }catch(const std::exception &e){
+            Write_Trace();
+            FUNCERR("Unable to serve jobs: " << e.what());
+        }
+        Write_Trace();
+        return 0;
+    }
+
+    //When receiving DICOM objects, data are provided by peers, but operations are provided on the command line.
+    if(StorageOpts){
+        if( !StandaloneFilesDirs.empty()
+        ||  !GroupedFilterQueryFiles.empty() ){
+            FUNCWARN("Data are provided by peers when receiving DICOM objects. Ignoring files and queries");
+        }
+        StorageOpts->max_jobs = ServerOpts.max_jobs;
+        Write_Startup_Profile();
+        try{
+            Serve_DICOM_Storage(StorageOpts.value(), Operations, InvocationMetadata, FilenameLex);
+        }catch(const std::exception &e){
+            Write_Trace();
+            FUNCERR("Unable to receive DICOM objects: " << e.what());
+        }
+        Write_Trace();
+        return 0;
+    }
+
+    //When distributing, inputs are sharded across workers and nothing is loaded locally.
+    if(!DistributedOpts.workers.empty()){
+        if(StandaloneFilesDirsReachable.empty()) FUNCERR("No files provided to distribute. Cannot proceed");
+        if(Operations.empty()) FUNCERR("No operations provided to distribute. Cannot proceed");
+        DistributedOpts.jobs_per_worker = ServerOpts.max_jobs;
+        Write_Startup_Profile();
+        long int N_failed = 0;
+        try{
+            N_failed = Distribute_Jobs(DistributedOpts, StandaloneFilesDirsReachable, InvocationMetadata, Operations);
+        }catch(const std::exception &e){
+            Write_Trace();
+            FUNCERR("Unable to distribute jobs: " << e.what());
+        }
+        Write_Trace();
+        if(N_failed != 0) FUNCERR(N_failed << " shards failed");
+        return 0;
+    }
+
     //We require at least one SQL file for PACS db loading, one file/directory name for standalone file loading..
     if( GroupedFilterQueryFiles.empty()    
     &&  StandaloneFilesDirsReachable.empty()
@@ -353,9 +790,6 @@ int main(int argc, char* argv[]){
 
         FUNCERR("No query files provided. Cannot proceed");
 
-// TODO: Special case: Launch RPC server to wait for data if no files or SQL files provided?
-
-
     //If DB or standalone loading, we require at least one action.
     }else if(Operations.empty()){
         FUNCWARN("No operations specified: defaulting to operation 'SFML_Viewer'");
@@ -364,6 +798,7 @@ int main(int argc, char* argv[]){
 
 
     //================================================= Data Loading =================================================
+    Begin_Startup_Phase("loading");
 
 #ifdef DCMA_USE_POSTGRES
     //PACS db loading.
@@ -376,7 +811,8 @@ int main(int argc, char* argv[]){
 #endif // DCMA_USE_POSTGRES
 
     //Standalone file loading.
-    if(!Load_Files(DICOM_data, InvocationMetadata, FilenameLex, StandaloneFilesDirsReachable)){
+    if(!Load_Files(DICOM_data, InvocationMetadata, FilenameLex, StandaloneFilesDirsReachable,
+                   LoaderThreadCount, DeferPixelDecoding)){
 #ifdef DCMA_FUZZ_TESTING
         // If file loading failed, then the loader successfully rejected bad data. Terminate to indicate this success.
         return 0;
@@ -387,8 +823,13 @@ int main(int argc, char* argv[]){
     }
 
     //============================================= Dispatch to Analyses =============================================
+    Begin_Startup_Phase("operations");
 
-    if(!Operation_Dispatcher(DICOM_data, InvocationMetadata, FilenameLex, Operations)){
+    const bool analyses_succeeded = Operation_Dispatcher(DICOM_data, InvocationMetadata, FilenameLex,
+                                                         Operations, CheckpointOpts);
+    Write_Startup_Profile();
+    Write_Trace();
+    if(!analyses_succeeded){
         FUNCERR("Analysis failed. Cannot continue");
     }
 
@@ -2,6 +2,18 @@
 //
 // This program provides a standard entry-point into some DICOMautomaton analysis routines.
 //
+// Files can either be uploaded together or dropped onto the page, in which case each file is uploaded separately and
+// decoding begins as soon as it arrives.
+//
+// Long-running work (file loading and operations) is executed by a small, process-wide pool of workers rather than
+// within the session, so sessions remain responsive while work is queued or underway. The number of workers and the
+// maximum number of queued jobs can be adjusted via the DCMA_WEBSERVER_WORKERS and DCMA_WEBSERVER_MAX_QUEUED
+// environment variables.
+//
+// Loaded data remains resident within each session so operations can be chained without reloading. Idle sessions
+// share a memory budget (DCMA_WEBSERVER_MEMORY_BUDGET_MB); when it is exceeded, the least-recently-used sessions spill
+// their data to disk in the native archive format and restore it when next needed.
+//
 
 #include <Wt/Http/Request.h>
 #include <Wt/WAnchor.h>
@@ -9,6 +21,7 @@
 #include <Wt/WBreak.h>
 #include <Wt/WCheckBox.h>
 #include <Wt/WContainerWidget.h>
+#include <Wt/WFileDropWidget.h>
 #include <Wt/WFileResource.h>
 #include <Wt/WFileUpload.h>
 #include <Wt/WGlobal.h>
@@ -18,9 +31,11 @@
 #include <Wt/WLength.h>
 #include <Wt/WLineEdit.h>
 #include <Wt/WLink.h>
+#include <Wt/WMemoryResource.h>
 #include <Wt/WProgressBar.h>
 #include <Wt/WPushButton.h>
 #include <Wt/WSelectionBox.h>
+#include <Wt/WServer.h>
 #include <Wt/WSignal.h>
 #include <Wt/WString.h>
 #include <Wt/WTable.h>
@@ -34,10 +49,14 @@
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <atomic>
 //#include <cfenv>              //Needed for std::feclearexcept(FE_ALL_EXCEPT).
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <ctime>
+#include <deque>
 #include <exception>
 #include <fstream>
 #include <functional>
@@ -45,15 +64,19 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <set> 
+#include <sstream>
 #include <stdexcept>
 #include <string>    
+#include <thread>
 #include <type_traits>
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
 #include "Boost_Serialization_File_Loader.h"
+#include "Common_Boost_Serialization.h"
 #include "DICOM_File_Loader.h"
 #include "FITS_File_Loader.h"
 #include "XYZ_File_Loader.h"
@@ -61,6 +84,8 @@
 #include "Operation_Dispatcher.h"
 #include "Structs.h"
 #include "Regex_Selectors.h"
+#include "Series_Preview.h"
+#include "Thread_Pool.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -178,10 +203,294 @@ std::string HumanToCamel(std::string in){
     return in;
 }
 
+
+// Returns the positive integer value of the environment variable, or the fallback if it is absent or invalid.
+static
+long int Positive_Env_Or(const char *name, long int fallback){
+    if(const char *v = std::getenv(name); (v != nullptr) && (*v != '\0')){
+        try{
+            const auto n = std::stol(v);
+            if(0 < n) return n;
+        }catch(const std::exception &){}
+        FUNCWARN("Ignoring invalid value '" << v << "' for " << name);
+    }
+    return fallback;
+}
+
+// Approximate memory consumed by the bulk data (i.e., voxels, vertices, and faces) held by a Drover.
+static
+uint64_t Approximate_Drover_Bytes(const Drover &d){
+    uint64_t out = 0;
+    for(const auto &ia : d.image_data){
+        if(ia == nullptr) continue;
+        for(const auto &img : ia->imagecoll.images) out += img.data.size() * sizeof(float);
+    }
+    if(d.contour_data != nullptr){
+        for(const auto &cc : d.contour_data->ccs){
+            for(const auto &c : cc.contours) out += c.points.size() * sizeof(vec3<double>);
+        }
+    }
+    for(const auto &pc : d.point_data){
+        if(pc != nullptr) out += pc->pset.points.size() * sizeof(vec3<double>);
+    }
+    for(const auto &sm : d.smesh_data){
+        if(sm == nullptr) continue;
+        out += sm->meshes.vertices.size() * sizeof(vec3<double>);
+        for(const auto &f : sm->meshes.faces) out += f.size() * sizeof(uint64_t);
+    }
+    return out;
+}
+
+
+// ------------------------------------------------- Job queue ---------------------------------------------------------
+
+// The data a session hands over to a job. The session does not touch it again until the job has ended.
+struct session_data {
+    Drover DICOM_data;
+    std::map<std::string,std::string> InvocationMetadata;
+    std::string FilenameLex;
+};
+
+// A unit of long-running work performed on behalf of a single session.
+//
+// Progress and completion notifications are posted to the owning session via Wt::WServer::post, which silently drops
+// them if the session has since terminated.
+class web_job : public std::enable_shared_from_this<web_job> {
+  public:
+    enum class state { queued, running, ended };
+
+    // Executed on a worker thread, so it must not access any widgets. Exceptions indicate failure. The work should
+    // check cancel_requested() periodically and return early when cancellation is requested. The work is performed
+    // with the job's cancellation token, so operations in progress are also cancelled.
+    using work_t = std::function<void(web_job &, session_data &)>;
+
+    web_job(std::string session_id_in,
+            session_data data_in,
+            work_t work_in,
+            std::function<void(const std::string &)> on_progress_in,
+            std::function<void()> on_end_in)
+        : data(std::move(data_in)),
+          session_id(std::move(session_id_in)),
+          work(std::move(work_in)),
+          on_progress(std::move(on_progress_in)),
+          on_end(std::move(on_end_in)) {}
+
+    session_data data;
+    std::string error; // Non-empty if the work failed. Only valid after the job has ended.
+
+    // Requests cancellation. Returns true if the job had not yet started, in which case it never will and the data can
+    // be reclaimed immediately.
+    bool cancel(){
+        this->token.cancel();
+        auto expected = state::queued;
+        return this->st.compare_exchange_strong(expected, state::ended);
+    }
+
+    bool cancel_requested() const {
+        return this->token.is_cancelled();
+    }
+
+    state get_state() const {
+        return this->st.load();
+    }
+
+    // Called by the work to report progress to the session.
+    void report(const std::string &msg){
+        auto f = this->on_progress;
+        this->post([f, msg](){ f(msg); });
+    }
+
+    // Called by a worker thread.
+    void run(){
+        auto expected = state::queued;
+        if(!this->st.compare_exchange_strong(expected, state::running)) return; // Cancelled before starting.
+
+        try{
+            const cancellation_token::scope scope(this->token);
+
+            // Forward the (rate-limited) reports of parallel routines so long computations visibly progress.
+            const progress_sink::scope sink_scope(progress_sink::observer_t([this](const progress_report &r){
+                std::stringstream ss;
+                ss << "<p>Computing now";
+                if(!r.label.empty()) ss << " (" << r.label << ")";
+                ss << ": " << std::fixed << std::setprecision(1)
+                   << ((0 < r.total) ? (100.0 * r.completed / r.total) : 100.0) << "% done, ~"
+                   << static_cast<long int>(r.eta_s) << " s remaining...</p>";
+                this->report(ss.str());
+            }));
+            this->work(*this, this->data);
+        }catch(const std::exception &e){
+            this->error = e.what();
+            if(this->error.empty()) this->error = "Unspecified error";
+        }
+        this->st.store(state::ended);
+
+        auto self = this->shared_from_this();
+        this->post([self](){ self->on_end(); });
+    }
+
+  private:
+    std::string session_id;
+    work_t work;
+    std::function<void(const std::string &)> on_progress;
+    std::function<void()> on_end;
+
+    std::atomic<state> st{ state::queued };
+    cancellation_token token;
+
+    void post(std::function<void()> f){
+        if(auto *server = Wt::WServer::instance()) server->post(this->session_id, std::move(f));
+        return;
+    }
+};
+
+// A process-wide, bounded pool of workers that execute jobs in submission order.
+//
+// Operations parallelize internally, so only a few jobs are run concurrently. This bounds the total load regardless of
+// the number of sessions.
+class web_job_queue {
+  public:
+    static web_job_queue & get(){
+        static web_job_queue q(Positive_Env_Or("DCMA_WEBSERVER_WORKERS", 2),
+                               Positive_Env_Or("DCMA_WEBSERVER_MAX_QUEUED", 64));
+        return q;
+    }
+
+    // Returns the number of jobs ahead of the submitted job. Throws if the queue is full.
+    long int submit(std::shared_ptr<web_job> job){
+        long int ahead = 0;
+        {
+            std::lock_guard<std::mutex> lock(this->m);
+            ahead = static_cast<long int>(this->jobs.size());
+            if(this->max_queued <= ahead) throw std::runtime_error("The server is busy. Please try again later");
+            this->jobs.emplace_back(std::move(job));
+        }
+        this->cv.notify_one();
+        return ahead;
+    }
+
+    ~web_job_queue(){
+        {
+            std::lock_guard<std::mutex> lock(this->m);
+            this->stopping = true;
+        }
+        this->cv.notify_all();
+        for(auto &w : this->workers) w.join();
+    }
+
+  private:
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<web_job>> jobs;
+    std::vector<std::thread> workers;
+    long int max_queued;
+    bool stopping = false;
+
+    web_job_queue(long int num_workers, long int max_queued_in) : max_queued(max_queued_in) {
+        for(long int i = 0; i < num_workers; ++i){
+            this->workers.emplace_back([this](){ this->worker_loop(); });
+        }
+    }
+
+    void worker_loop(){
+        while(true){
+            std::shared_ptr<web_job> job;
+            {
+                std::unique_lock<std::mutex> lock(this->m);
+                this->cv.wait(lock, [this](){ return this->stopping || !this->jobs.empty(); });
+                if(this->stopping) return;
+                job = std::move(this->jobs.front());
+                this->jobs.pop_front();
+            }
+            job->run();
+        }
+    }
+};
+
+// A process-wide memory budget for the data held by idle sessions.
+//
+// Whenever a session's resident data changes, the least-recently-used other sessions are asked to spill their data (by
+// posting the provided function to them) until the total fits within the budget. Sessions that are spilled, busy, or
+// terminated are not tracked.
+class session_memory_budget {
+  public:
+    static session_memory_budget & get(){
+        static session_memory_budget b(static_cast<uint64_t>(Positive_Env_Or("DCMA_WEBSERVER_MEMORY_BUDGET_MB", 4096))
+                                       * 1024 * 1024);
+        return b;
+    }
+
+    // Records the session's resident data and marks the session as the most recently used.
+    void touch(const std::string &session_id, uint64_t bytes, std::function<void()> spill){
+        std::vector<std::pair<std::string, std::function<void()>>> victims;
+        {
+            std::lock_guard<std::mutex> lock(this->m);
+            this->forget_locked(session_id);
+            if(bytes != 0){
+                this->entries[session_id] = { bytes, ++(this->clock), std::move(spill) };
+                this->total += bytes;
+            }
+
+            while(this->budget < this->total){
+                auto lru = std::end(this->entries);
+                for(auto it = std::begin(this->entries); it != std::end(this->entries); ++it){
+                    if(it->first == session_id) continue;
+                    if( (lru == std::end(this->entries))
+                    ||  (it->second.last_use < lru->second.last_use) ) lru = it;
+                }
+                if(lru == std::end(this->entries)) break;
+
+                victims.emplace_back(lru->first, lru->second.spill);
+                this->total -= lru->second.bytes;
+                this->entries.erase(lru);
+            }
+        }
+
+        if(auto *server = Wt::WServer::instance()){
+            for(auto &v : victims) server->post(v.first, v.second);
+        }
+        return;
+    }
+
+    void forget(const std::string &session_id){
+        std::lock_guard<std::mutex> lock(this->m);
+        this->forget_locked(session_id);
+        return;
+    }
+
+  private:
+    struct entry {
+        uint64_t bytes;
+        uint64_t last_use;
+        std::function<void()> spill;
+    };
+
+    std::mutex m;
+    std::map<std::string, entry> entries;
+    uint64_t total = 0;
+    uint64_t clock = 0;
+    uint64_t budget;
+
+    explicit session_memory_budget(uint64_t budget_in) : budget(budget_in) {}
+
+    void forget_locked(const std::string &session_id){
+        auto it = this->entries.find(session_id);
+        if(it == std::end(this->entries)) return;
+        this->total -= it->second.bytes;
+        this->entries.erase(it);
+        return;
+    }
+};
+
+
 // This class is instanced for each client. It holds all state for a single session.
 class BaseWebServerApplication : public Wt::WApplication {
   public:
     BaseWebServerApplication(const Wt::WEnvironment& env);
+    ~BaseWebServerApplication() override;
+
+    //Writes the session's data to disk and releases it. Does nothing if the data is in use or already spilled.
+    void spillData();
 
   private:
 
@@ -210,16 +519,48 @@ class BaseWebServerApplication : public Wt::WApplication {
     std::regex fnameregex   = Compile_Regex(".*filename.*");
     std::regex roiregex     = Compile_Regex(".*roi.*label.*regex.*");
     std::regex normroiregex = Compile_Regex(".*normalized.*roi.*label.*regex.*");
+
+    //The job currently executing on behalf of this session, if any. The session's data belongs to the job until the job
+    // ends.
+    std::shared_ptr<web_job> active_job;
+
+    //If non-empty, the session's data has been spilled to this native archive and must be restored before use.
+    std::string spilled_archive;
+
+    //Restores spilled data, if needed. Throws on failure.
+    void ensureResident();
+
+    //Reports the session's resident data to the process-wide memory budget.
+    void updateMemoryBudget();
+
+    //Files that are dropped onto the page are uploaded individually and decoded while the remainder are still being
+    // received.
+    std::shared_ptr<dicom_predecode_cache> predecoded = std::make_shared<dicom_predecode_cache>();
+    std::vector<std::pair<std::string,std::string>> dropped_files; // Client filename and spool filename.
+    long int pending_drops = 0; // The number of dropped files still in transit.
     
     // --------------------- Web widget shared functors ---------------------
 
     //void createInvocationMetadataGB(void);
     void createFileUploadGB();
     void filesUploaded(); //Post file upload event.
+    void loadUploadedFiles(const std::vector<std::pair<std::string,std::string>> &files);
     void createOperationSelectorGB();
     void createOperationParamSelectorGB();
     void appendOperationParamsColumn();
     void createComputeGB();
+    void displayComputeResults(Wt::WGroupBox *gb,
+                               Wt::WBreak *sep_break,
+                               const std::map<std::string,std::shared_ptr<Wt::WFileResource>> &OutputFiles,
+                               std::map<std::string,std::string> OutputMimetype);
+
+    //Hands the session's data to a job which performs the work on a worker thread. A cancel button is added to the
+    // group box and the feedback text is updated as the job progresses. Once the job ends, the data is returned to the
+    // session and on_end is invoked within the session.
+    void launchJob(Wt::WGroupBox *gb,
+                   Wt::WText *feedback,
+                   web_job::work_t work,
+                   std::function<void(const web_job &)> on_end);
 
 };
 
@@ -266,9 +607,130 @@ BaseWebServerApplication::BaseWebServerApplication(const Wt::WEnvironment &env)
         brk->addStyleClass("ClearFix");
     }
 
+    //Needed so that workers can notify the session of progress.
+    this->enableUpdates(true);
+
     this->createFileUploadGB();
 }
 
+BaseWebServerApplication::~BaseWebServerApplication(){
+    //The job owns the data it is working on, so it can safely continue until it notices the cancellation.
+    if(this->active_job != nullptr) (void) this->active_job->cancel();
+
+    session_memory_budget::get().forget(this->sessionId());
+    if(!this->spilled_archive.empty()) (void) RemoveFile(this->spilled_archive);
+}
+
+void BaseWebServerApplication::spillData(){
+    if( (this->active_job != nullptr)
+    ||  !this->spilled_archive.empty() ) return;
+
+    const auto archive = Get_Unique_Filename(this->InstancePrivateDirectory + "spilled_session_data_", 6, ".dcma");
+    if(!Common_Boost_Serialize_Drover_to_Native_Archive(this->DICOM_data, archive)){
+        FUNCWARN("Unable to spill session data to '" << archive << "'. Keeping it resident");
+        (void) RemoveFile(archive);
+        return;
+    }
+    this->DICOM_data = Drover();
+    this->spilled_archive = archive;
+    FUNCINFO("Spilled session data to '" << archive << "'");
+    return;
+}
+
+void BaseWebServerApplication::ensureResident(){
+    if(this->spilled_archive.empty()) return;
+
+    Drover d;
+    if(!Common_Boost_Deserialize_Drover_from_Native_Archive(d, this->spilled_archive)){
+        throw std::runtime_error("Unable to restore session data from '"_s + this->spilled_archive + "'");
+    }
+    this->DICOM_data = std::move(d);
+    (void) RemoveFile(this->spilled_archive);
+    this->spilled_archive.clear();
+    this->updateMemoryBudget();
+    return;
+}
+
+void BaseWebServerApplication::updateMemoryBudget(){
+    if( (this->active_job != nullptr)
+    ||  !this->spilled_archive.empty() ){
+        session_memory_budget::get().forget(this->sessionId());
+        return;
+    }
+    session_memory_budget::get().touch(this->sessionId(), Approximate_Drover_Bytes(this->DICOM_data), [](){
+        if(auto *app = dynamic_cast<BaseWebServerApplication *>(Wt::WApplication::instance())) app->spillData();
+        return;
+    });
+    return;
+}
+
+void BaseWebServerApplication::launchJob(Wt::WGroupBox *gb,
+                                         Wt::WText *feedback,
+                                         web_job::work_t work,
+                                         std::function<void(const web_job &)> on_end){
+    if(this->active_job != nullptr) throw std::logic_error("A job is already active for this session. Cannot continue.");
+
+    auto cancel_button = gb->addWidget(std::make_unique<Wt::WPushButton>("Cancel"));
+
+    //Reclaims the session's data. Only ever invoked within the session.
+    const auto end = [this, cancel_button, on_end]() -> void {
+        auto job = this->active_job;
+        if(job == nullptr) return;
+        this->active_job = nullptr;
+
+        this->DICOM_data = std::move(job->data.DICOM_data);
+        this->InvocationMetadata = std::move(job->data.InvocationMetadata);
+        this->updateMemoryBudget();
+
+        cancel_button->disable();
+        cancel_button->hide();
+        on_end(*job);
+        this->triggerUpdate();
+        return;
+    };
+    const auto progress = [this, feedback](const std::string &msg) -> void {
+        feedback->setText(msg);
+        this->triggerUpdate();
+        return;
+    };
+
+    std::string restore_error;
+    try{
+        this->ensureResident();
+    }catch(const std::exception &e){
+        restore_error = e.what();
+    }
+
+    session_data data;
+    data.DICOM_data = std::move(this->DICOM_data);
+    data.InvocationMetadata = std::move(this->InvocationMetadata);
+    data.FilenameLex = this->FilenameLex;
+    this->active_job = std::make_shared<web_job>(this->sessionId(), std::move(data), std::move(work), progress, end);
+    session_memory_budget::get().forget(this->sessionId());
+
+    cancel_button->clicked().connect(std::bind([=](){
+        cancel_button->disable();
+        if(this->active_job == nullptr) return;
+        if(this->active_job->cancel()){
+            end(); //The job never started.
+        }else{
+            feedback->setText("<p>Cancelling. The current step must complete first...</p>");
+        }
+        return;
+    }));
+
+    try{
+        if(!restore_error.empty()) throw std::runtime_error(restore_error);
+        const auto ahead = web_job_queue::get().submit(this->active_job);
+        if(0 < ahead) feedback->setText("<p>Waiting for " + std::to_string(ahead) + " other job(s) to start...</p>");
+    }catch(const std::exception &e){
+        this->active_job->error = e.what();
+        (void) this->active_job->cancel();
+        end();
+    }
+    return;
+}
+
 
 void BaseWebServerApplication::createFileUploadGB(){
     // This routine creates a file upload box.
@@ -297,6 +759,13 @@ void BaseWebServerApplication::createFileUploadGB(){
 
     (void*) gb->addWidget(std::make_unique<Wt::WBreak>());
 
+    auto dropper = gb->addWidget(std::make_unique<Wt::WFileDropWidget>());
+    dropper->setObjectName("file_upload_gb_drop_zone");
+    dropper->addStyleClass("FileDropZone");
+    (void*) dropper->addWidget(std::make_unique<Wt::WText>("Or drop files here. Dropped files are processed as they arrive."));
+
+    (void*) gb->addWidget(std::make_unique<Wt::WBreak>());
+
     auto feedback = gb->addWidget(std::make_unique<Wt::WText>());
     feedback->setObjectName("file_upload_gb_feedback");
     feedback->addStyleClass("FeedbackText");
@@ -315,11 +784,68 @@ void BaseWebServerApplication::createFileUploadGB(){
             feedback->setText("<p>File uploads are not supported by your browser. Cannot continue.</p>");
         }
         upbutton->disable();
+        dropper->disable();
         return;
     }));
 
     // -------
 
+    //Dropped files are uploaded one at a time. Each is handed to the decoder as soon as it arrives, and loading begins
+    // once the last file has landed.
+    const auto drop_progress = [=]() -> void {
+        std::stringstream ss;
+        ss << "<p>Received " << this->dropped_files.size() << " file(s). "
+           << this->pending_drops << " file(s) remaining...</p>";
+        feedback->setText(ss.str());
+        return;
+    };
+    const auto drop_settled = [=]() -> void {
+        if(0 < this->pending_drops) return;
+        dropper->disable();
+        if(this->dropped_files.empty()){
+            feedback->setText("<p>No files were received. Cannot continue.</p>");
+            return;
+        }
+        this->loadUploadedFiles(this->dropped_files);
+        return;
+    };
+
+    dropper->drop().connect([=](const std::vector<Wt::WFileDropWidget::File *> &files) -> void {
+        if(!dropper->isEnabled()){
+            for(auto *f : files) dropper->cancelUpload(f);
+            return;
+        }
+        upbutton->disable();
+        fileup->disable();
+        this->pending_drops += static_cast<long int>(files.size());
+        drop_progress();
+        return;
+    });
+    dropper->uploaded().connect([=](Wt::WFileDropWidget::File *f) -> void {
+        const auto spool = f->uploadedFile().spoolFileName();
+        this->dropped_files.emplace_back(f->clientFileName(), spool);
+        this->predecoded->add(spool);
+
+        --(this->pending_drops);
+        drop_progress();
+        drop_settled();
+        return;
+    });
+    dropper->uploadFailed().connect([=](Wt::WFileDropWidget::File *f) -> void {
+        FUNCWARN("Unable to receive dropped file '" << f->clientFileName() << "'. Continuing");
+        --(this->pending_drops);
+        drop_settled();
+        return;
+    });
+    dropper->tooLarge().connect([=](Wt::WFileDropWidget::File *f, uint64_t approx_size) -> void {
+        FUNCWARN("Dropped file '" << f->clientFileName() << "' is too large (~" << approx_size / (1000*1024) << " MB). Continuing");
+        --(this->pending_drops);
+        drop_settled();
+        return;
+    });
+
+    // -------
+
     fileup->fileTooLarge().connect(std::bind([=](int64_t approx_size) -> void {
         std::stringstream ss;
         ss << "<p>One of the selected files is larger than the maximum permissible size. " 
@@ -362,7 +888,7 @@ void BaseWebServerApplication::filesUploaded(){
     auto fileup = reinterpret_cast<Wt::WFileUpload *>( root()->find("file_upload_gb_file_picker") );
     if(fileup == nullptr) throw std::logic_error("Cannot find file uploader widget in DOM tree. Cannot continue.");
 
-    std::list<boost::filesystem::path> UploadedFilesDirsReachable;
+    std::vector<std::pair<std::string,std::string>> files;
     const auto files_vec = fileup->uploadedFiles(); //const std::vector< Http::UploadedFile > &
     for(const auto &afile : files_vec){
         // Assume ownership of the files so they do not disappear when the connection terminates.
@@ -370,18 +896,29 @@ void BaseWebServerApplication::filesUploaded(){
         // NOTE: You'll have to garbage-collect files that you steal. Perhaps by moving them to some infinite storage
         //       location or consuming when loaded into memory?
         //afile.stealSpoolFile();
-        UploadedFilesDirsReachable.emplace_back(afile.spoolFileName());
+        files.emplace_back(afile.clientFileName(), afile.spoolFileName());
+    }
+    fileup->disable();
+
+    this->loadUploadedFiles(files);
+    return;
+}
+
+void BaseWebServerApplication::loadUploadedFiles(const std::vector<std::pair<std::string,std::string>> &files){
+    // This routine loads the uploaded files (client filename and spool filename), which must all have been received.
+    std::list<boost::filesystem::path> UploadedFilesDirsReachable;
+    for(const auto &afile : files){
+        UploadedFilesDirsReachable.emplace_back(afile.second);
 
         //Copy the file to the working directory. (Useful for debugging.)
-        if(!CopyFile(afile.spoolFileName(), 
-                     this->InstancePrivateDirectory + afile.clientFileName())
-        && !CopyFile(afile.spoolFileName(), 
-                     this->InstancePrivateDirectory + afile.spoolFileName()) ){
-            FUNCWARN("Unable to copy uploaded file '" << afile.clientFileName() << "'"
-                     << " aka '" << afile.spoolFileName() << "' to archive directory. Continuing");
+        if(!CopyFile(afile.second, 
+                     this->InstancePrivateDirectory + afile.first)
+        && !CopyFile(afile.second, 
+                     this->InstancePrivateDirectory + afile.second) ){
+            FUNCWARN("Unable to copy uploaded file '" << afile.first << "'"
+                     << " aka '" << afile.second << "' to archive directory. Continuing");
         }
     }
-    fileup->disable();
 
 
     // Feedback for the client.
@@ -389,11 +926,11 @@ void BaseWebServerApplication::filesUploaded(){
     if(feedback == nullptr) throw std::logic_error("Cannot find file upload feedback text widget in DOM tree. Cannot continue.");
 
     std::stringstream ss;
-    ss << "<p>" << files_vec.size() << " file(s) have been uploaded. </p>";
+    ss << "<p>" << files.size() << " file(s) have been uploaded. </p>";
     {
         int i = 0;
-        for(const auto &afile : files_vec){
-            ss << "<p> File " << ++i << ": '" << afile.clientFileName() << "'. </p>";
+        for(const auto &afile : files){
+            ss << "<p> File " << ++i << ": '" << afile.first << "'. </p>";
         }
     }
     feedback->setText(ss.str());
@@ -425,64 +962,112 @@ void BaseWebServerApplication::filesUploaded(){
         gb->setFocus(false);
         this->processEvents();
 
-        //Uploaded file loading: Boost.Serialization archives.
-        if(!UploadedFilesDirsReachable.empty()
-        && !Load_From_Boost_Serialization_Files( this->DICOM_data,
-                                                 this->InvocationMetadata,
-                                                 this->FilenameLex,
-                                                 UploadedFilesDirsReachable )){
-            feedback->setText("<p>Failed to load client-provided Boost.Serialization archive. Instance terminated.</p>");
-            return;
-        }
+        //The files are loaded by a worker so the session remains responsive. A preview of each image array is also
+        // prepared so the client can see what was loaded.
+        auto previews = std::make_shared<std::vector<std::string>>();
+        this->launchJob(gb, feedback,
+                        [UploadedFilesDirsReachable, previews,
+                         predecoded = this->predecoded](web_job &job, session_data &data) mutable -> void {
+            //Uploaded file loading: Boost.Serialization archives.
+            job.report("<p>Loading files now (Boost.Serialization archives)...</p>");
+            if(!UploadedFilesDirsReachable.empty()
+            && !Load_From_Boost_Serialization_Files( data.DICOM_data,
+                                                     data.InvocationMetadata,
+                                                     data.FilenameLex,
+                                                     UploadedFilesDirsReachable )){
+                throw std::runtime_error("Failed to load client-provided Boost.Serialization archive");
+            }
+            if(job.cancel_requested()) return;
+
+            //Uploaded file loading: DICOM files.
+            job.report("<p>Loading files now (DICOM files)...</p>");
+            if(!UploadedFilesDirsReachable.empty()
+            && !Load_From_DICOM_Files( data.DICOM_data,
+                                       data.InvocationMetadata,
+                                       data.FilenameLex,
+                                       UploadedFilesDirsReachable,
+                                       /*n_threads=*/ 1,
+                                       predecoded.get() )){
+                throw std::runtime_error("Failed to load client-provided DICOM file");
+            }
+            if(job.cancel_requested()) return;
+
+            //Uploaded file loading: FITS files.
+            job.report("<p>Loading files now (FITS files)...</p>");
+            if(!UploadedFilesDirsReachable.empty()
+            && !Load_From_FITS_Files( data.DICOM_data, 
+                                      data.InvocationMetadata, 
+                                      data.FilenameLex,
+                                      UploadedFilesDirsReachable )){
+                throw std::runtime_error("Failed to load client-provided FITS file");
+            }
+            if(job.cancel_requested()) return;
+
+            //Uploaded file loading: XYZ files.
+            job.report("<p>Loading files now (XYZ files)...</p>");
+            if(!UploadedFilesDirsReachable.empty()
+            && !Load_From_XYZ_Files( data.DICOM_data, 
+                                      data.InvocationMetadata, 
+                                      data.FilenameLex,
+                                      UploadedFilesDirsReachable )){
+                throw std::runtime_error("Failed to load client-provided XYZ file");
+            }
 
-        //Uploaded file loading: DICOM files.
-        if(!UploadedFilesDirsReachable.empty()
-        && !Load_From_DICOM_Files( this->DICOM_data,
-                                   this->InvocationMetadata,
-                                   this->FilenameLex,
-                                   UploadedFilesDirsReachable )){
-            feedback->setText("<p>Failed to load client-provided DICOM file. Instance terminated.</p>");
-            return;
-        }
+            //Other loaders.
+            // ...
 
-        //Uploaded file loading: FITS files.
-        if(!UploadedFilesDirsReachable.empty()
-        && !Load_From_FITS_Files( this->DICOM_data, 
-                                  this->InvocationMetadata, 
-                                  this->FilenameLex,
-                                  UploadedFilesDirsReachable )){
-            feedback->setText("<p>Failed to load client-provided FITS file. Instance terminated.</p>");
-            return;
-        }
 
-        //Uploaded file loading: XYZ files.
-        if(!UploadedFilesDirsReachable.empty()
-        && !Load_From_XYZ_Files( this->DICOM_data, 
-                                  this->InvocationMetadata, 
-                                  this->FilenameLex,
-                                  UploadedFilesDirsReachable )){
-            feedback->setText("<p>Failed to load client-provided XYZ file. Instance terminated.</p>");
+            //If any standalone files remain, they cannot be loaded.
+            if(!UploadedFilesDirsReachable.empty()){
+                throw std::runtime_error("Failed to load client-provided file");
+            }
+
+            //Previews are not essential, so failures are ignored.
+            for(const auto &ia : data.DICOM_data.image_data){
+                if( job.cancel_requested() || (ia == nullptr) || ia->imagecoll.images.empty() ) continue;
+                try{
+                    std::vector<std::reference_wrapper<const planar_image<float,double>>> imgs;
+                    std::vector<std::map<std::string, std::string>> metadata;
+                    for(const auto &img : ia->imagecoll.images){
+                        imgs.emplace_back( std::cref(img) );
+                        metadata.emplace_back( img.metadata );
+                    }
+                    for(const auto &i : Select_Representative_Slices(metadata, 1)){
+                        const auto mips = Generate_Preview_Mipmaps(imgs[i].get());
+                        if(!mips.empty()) previews->emplace_back( Encode_Preview_PNG(mips.front()) );
+                    }
+                }catch(const std::exception &e){
+                    FUNCWARN("Unable to generate preview: " << e.what());
+                }
+            }
             return;
-        }
 
-        //Other loaders.
-        // ...
+        }, [this, feedback, gb, previews](const web_job &job) -> void {
+            this->predecoded.reset(); //Any remaining decoded data is not needed.
 
+            if(!job.error.empty()){
+                feedback->setText("<p>"_s + job.error + ". Instance terminated.</p>");
+                return;
+            }
+            if(job.cancel_requested()){
+                feedback->setText("<p>File loading was cancelled. Instance terminated.</p>");
+                return;
+            }
+            feedback->setText("<p>Loaded all files successfully. </p>");
 
-        //If any standalone files remain, they cannot be loaded.
-        if(!UploadedFilesDirsReachable.empty()){
-            std::stringstream es;
-            feedback->setText("<p>Failed to load client-provided file. Instance terminated.</p>");
-            return;
-        }
+            for(const auto &png : *previews){
+                auto res = std::make_shared<Wt::WMemoryResource>("image/png");
+                res->setData(std::vector<unsigned char>(std::begin(png), std::end(png)));
+                auto img = gb->addWidget(std::make_unique<Wt::WImage>(Wt::WLink(res)));
+                img->setAlternateText("Preview of a loaded image series.");
+            }
 
-        feedback->setText("<p>Loaded all files successfully. </p>");
-        this->processEvents();
+            //Create the next widgets for the user to interact with.
+            //this->createInvocationMetadataGB();
+            this->createOperationSelectorGB();
+            return;
+        });
     }
-
-    //Create the next widgets for the user to interact with.
-    //this->createInvocationMetadataGB();
-    this->createOperationSelectorGB();
     return;
 }
 
@@ -574,22 +1159,18 @@ void BaseWebServerApplication::createOperationSelectorGB(){
     auto describe = [=](){
         const std::string selected_op = selector->currentText().toUTF8();
         std::stringstream ss;
-        auto known_ops = Known_Operations();
-        for(auto &anop : known_ops){
-            const auto n = anop.first;
-            if( n == selected_op ){
-                auto op_docs = (anop.second.first)();
-                ss << "<p>" << op_docs.desc << "</p>";
-                if(!op_docs.notes.empty()){
-                    ss << "<p>Notes: <ul>" << std::endl;
-                    for(auto &note : op_docs.notes){
-                        ss << "<li>"
-                           << note
-                           << "</li>"
-                           << std::endl;
-                    }
-                    ss << "</ul></p>";
+        if(Cached_Known_Operations().count(selected_op) != 0){
+            const auto &op_docs = Known_Operation_Documentation(selected_op);
+            ss << "<p>" << op_docs.desc << "</p>";
+            if(!op_docs.notes.empty()){
+                ss << "<p>Notes: <ul>" << std::endl;
+                for(auto &note : op_docs.notes){
+                    ss << "<li>"
+                       << note
+                       << "</li>"
+                       << std::endl;
                 }
+                ss << "</ul></p>";
             }
         }
         descpanel->setText(Wt::WString(ss.str()));
@@ -606,8 +1187,8 @@ void BaseWebServerApplication::createOperationSelectorGB(){
         if(grouper == nullptr) throw std::logic_error("Cannot find operation grouper widget in DOM tree. Cannot continue.");
         const std::string selected_group = grouper->currentText().toUTF8(); 
 
-        auto known_ops = Known_Operations();
-        for(auto &anop : known_ops){
+        const auto &known_ops = Cached_Known_Operations();
+        for(const auto &anop : known_ops){
             const auto n = anop.first;
 
             if(selected_group == "QA"){
@@ -793,6 +1374,7 @@ void BaseWebServerApplication::appendOperationParamsColumn(){
     if(table == nullptr) throw std::logic_error("Cannot find operation parameter table widget in DOM tree. Cannot continue.");
 
     //Determine which ROIs are available, in case they will be needed.
+    this->ensureResident();
     std::set<std::string> ROI_labels;
     if(this->DICOM_data.contour_data != nullptr){
         for(auto &cc : this->DICOM_data.contour_data->ccs){
@@ -803,7 +1385,7 @@ void BaseWebServerApplication::appendOperationParamsColumn(){
     }
 
     //Get a list of the known DICOMautomaton operations.
-    auto known_ops = Known_Operations();
+    const auto &known_ops = Cached_Known_Operations();
 
     //Get the feedback element.
     auto feedback = reinterpret_cast<Wt::WText *>( root()->find("op_paramspec_gb_feedback") );
@@ -820,10 +1402,10 @@ void BaseWebServerApplication::appendOperationParamsColumn(){
     table->elementAt(0,cols)->addWidget(std::make_unique<Wt::WText>("Setting"));
 
     int table_row = 1;
-    for(auto &anop : known_ops){
+    for(const auto &anop : known_ops){
         if(anop.first != selected_op) continue; 
 
-        auto optdocs = anop.second.first();
+        const auto &optdocs = Known_Operation_Documentation(anop.first);
         if(optdocs.args.empty()){
             feedback->setText("<p>No parameters to adjust...</p>");
             break;
@@ -1027,9 +1609,9 @@ void BaseWebServerApplication::createComputeGB(){
     std::map<std::string,std::string> OutputMimetype;
     const auto rows = table->rowCount(); 
     const auto cols = table->columnCount(); 
-    bool AllSuccessful = true;
+    std::list<OperationArgPkg> Passes; // One per column.
     for(auto col = 1; col < cols; ++col){
-        auto op_doc_l = (Known_Operations()[selected_op].first)(); // Documentation parameter list.
+        const auto &op_doc_l = Known_Operation_Documentation(selected_op); // Documentation parameter list.
         OperationArgPkg op_args(selected_op); // The list of parameters passed to the operation.
         for(int row = 1; row < rows; ++row){
             const auto param_human_name = reinterpret_cast<Wt::WText *>(table->elementAt(row,0)->children().back())->text().toUTF8();
@@ -1172,27 +1754,95 @@ void BaseWebServerApplication::createComputeGB(){
             }
         }
 
-        // ---
+        Passes.emplace_back(op_args);
+    }
 
-        //Perform the operation.
-        std::list<OperationArgPkg> PackedOperation = { op_args };
-        try{
-            if(!Operation_Dispatcher( this->DICOM_data, 
-                                      this->InvocationMetadata, 
-                                      this->FilenameLex,
-                                      PackedOperation )){
-                throw std::runtime_error("Return value non-zero (non-descript error condition)");
+    //Objects added or modified by the operation(s) are also offered on their own in a native archive, so clients
+    // editing iteratively need not re-download the entire session. The listing describes how to apply the delta.
+    const auto DeltaArchive = Get_Unique_Filename(this->InstancePrivateDirectory + "drover_changes_", 6, ".dcma");
+    const auto DeltaListing = Get_Unique_Filename(this->InstancePrivateDirectory + "drover_changes_", 6, ".txt");
+    auto DeltaSummary = std::make_shared<std::string>();
+
+    //Perform the operation(s) on a worker so the session remains responsive.
+    this->launchJob(gb, feedback,
+                    [Passes,DeltaArchive,DeltaListing,DeltaSummary](web_job &job, session_data &data) -> void {
+        const auto before = Snapshot_Drover(data.DICOM_data);
+        const auto write_delta = [&]() -> void {
+            const auto changes = Diff_Drover_Snapshots(before, Snapshot_Drover(data.DICOM_data));
+            if(changes.empty()) return;
+            const auto listing = Describe_Drover_Changes(changes);
+            if( !Common_Boost_Serialize_Drover_to_Native_Archive(Drover_Delta(data.DICOM_data, changes), DeltaArchive)
+            ||  !OverwriteStringToFile(listing, DeltaListing) ){
+                FUNCWARN("Unable to write the changes to '" << DeltaArchive << "'");
+                return;
+            }
+            *DeltaSummary = listing;
+            return;
+        };
+
+        std::string LastFailure;
+        long int pass = 0;
+        for(const auto &op_args : Passes){
+            if(job.cancel_requested()) break;
+            ++pass;
+            job.report("<p>Computing now (pass "_s + std::to_string(pass) + " of "_s
+                       + std::to_string(Passes.size()) + ")...</p>");
+
+            std::list<OperationArgPkg> PackedOperation = { op_args };
+
+            // Operations consume the Drover they are given, so the session's data is retained in case this pass fails.
+            // Note that sharing the data means modifications will need to detach (copy) whatever they modify.
+            Drover retained(data.DICOM_data);
+            try{
+                if(!Operation_Dispatcher( data.DICOM_data, 
+                                          data.InvocationMetadata, 
+                                          data.FilenameLex,
+                                          PackedOperation )){
+                    throw std::runtime_error("Return value non-zero (non-descript error condition)");
+                }
+            }catch(const std::exception &e){
+                LastFailure = e.what();
+                data.DICOM_data = std::move(retained);
             }
-        }catch(const std::exception &e){
-            feedback->setText("<p>Operation failed: "_s + e.what() + ".</p>");
-            AllSuccessful = false;
-            //return;
         }
-    }
-    if(AllSuccessful){
-        feedback->setText("<p>Operation successful.</p>");
-    }
+        write_delta();
+        if(!LastFailure.empty()) throw std::runtime_error(LastFailure);
+        return;
+
+    }, [=](const web_job &job) -> void {
+        if(!job.error.empty()){
+            feedback->setText("<p>Operation failed: "_s + job.error + ".</p>");
+        }else if(job.cancel_requested()){
+            feedback->setText("<p>Operation cancelled.</p>");
+        }else{
+            feedback->setText("<p>Operation successful.</p>");
+        }
+
+        auto Files = OutputFiles;
+        auto Mimetypes = OutputMimetype;
+        if(!DeltaSummary->empty()){
+            const auto add_file = [&](const std::string &name, const std::string &fname,
+                                      const std::string &mimetype, const std::string &suggested) -> void {
+                auto fr = std::make_shared<Wt::WFileResource>();
+                fr->setFileName(fname);
+                fr->setMimeType(mimetype);
+                fr->suggestFileName(suggested);
+                Files[name] = fr;
+                Mimetypes[name] = mimetype;
+            };
+            add_file("DroverChanges", DeltaArchive, "application/octet-stream", "changes.dcma");
+            add_file("DroverChangesListing", DeltaListing, "text/plain", "changes.txt");
+        }
+        this->displayComputeResults(gb, sep_break, Files, Mimetypes);
+        return;
+    });
+    return;
+}
 
+void BaseWebServerApplication::displayComputeResults(Wt::WGroupBox *gb,
+                                                     Wt::WBreak *sep_break,
+                                                     const std::map<std::string,std::shared_ptr<Wt::WFileResource>> &OutputFiles,
+                                                     std::map<std::string,std::string> OutputMimetype){
     gb->show();
     sep_break->setFocus(true);
     gb->setCanReceiveFocus(true);
@@ -1203,7 +1853,7 @@ void BaseWebServerApplication::createComputeGB(){
     // ---
 
     // Corral the output.
-    for(auto &apair : OutputFiles){
+    for(const auto &apair : OutputFiles){
         const auto param_name = apair.first;
         const auto HumanParamName = CamelToHuman(param_name);
 
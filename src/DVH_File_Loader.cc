@@ -16,8 +16,7 @@
 #include <boost/filesystem.hpp>
 #include <cstdlib>            //Needed for exit() calls.
 
-#include "Explicator.h"       //Needed for Explicator class.
-
+#include "Lexicon_Cache.h"
 #include "Structs.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -82,7 +81,7 @@ void Consume_BOM(std::istream &is){
 }
 
 std::map<std::string, std::string> Read_Header_Block(std::istream &is,
-                                                     Explicator &X,
+                                                     const lexicon_translator &X,
                                                      std::map<std::string, std::string> metadata){
     // Parses a metadata block, reading a block of lines until a whitespace-only line is encountered.
     // The provided metadata will be combined with (and overwritten by) the locally parsed metadata.
@@ -331,7 +330,7 @@ bool Load_From_DVH_Files( Drover &DICOM_data,
     //
     if(Filenames.empty()) return true;
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     size_t i = 0;
     const size_t N = Filenames.size();
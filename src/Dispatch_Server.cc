@@ -0,0 +1,483 @@
+//Dispatch_Server.cc - A part of DICOMautomaton 2026.
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <cerrno>
+    #include <csignal>
+    #include <netdb.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorString.h"       //Needed for SplitStringToVector(...).
+
+#include "Structs.h"
+#include "Common_Boost_Serialization.h"
+#include "File_Loader.h"
+#include "Operation_Dispatcher.h"
+#include "Thread_Pool.h"
+
+#include "Dispatch_Server.h"
+
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace {
+
+const size_t max_job_bytes = 16 * 1024 * 1024;
+
+struct dispatch_job_t {
+    std::list<std::string> paths;
+    std::map<std::string,std::string> metadata;
+    std::list<OperationArgPkg> operations;
+    double timeout = 0.0; // In seconds. Non-positive: no deadline.
+    bool report_progress = false;
+    bool return_archive = false;
+    bool shutdown = false;
+};
+
+// Parses a job using the same rules as the equivalent command line options.
+dispatch_job_t Parse_Job(const std::list<std::string> &lines){
+    dispatch_job_t job;
+    long int depth = 0;
+    bool active = false;
+
+    const auto innermost = [&](long int n) -> OperationArgPkg * {
+        if(job.operations.empty()) throw std::invalid_argument("No parent node found");
+        OperationArgPkg *o = &( job.operations.back() );
+        for(long int i = 0; i < n; ++i){
+            o = o->lastChild();
+            if(o == nullptr) throw std::invalid_argument("No child node found");
+        }
+        return o;
+    };
+
+    for(const auto &line : lines){
+        const auto sep = line.find(' ');
+        const auto keyword = line.substr(0, sep);
+        const auto value = (sep == std::string::npos) ? std::string() : line.substr(sep + 1);
+
+        if(keyword == "standalone"){
+            job.paths.push_back(value);
+
+        }else if(keyword == "metadata"){
+            const auto tokens = SplitStringToVector(value, '=', 'd');
+            if(tokens.size() != 2) throw std::invalid_argument("Metadata format not recognized: '" + value + "'");
+            job.metadata[tokens.front()] += tokens.back();
+
+        }else if(keyword == "operation"){
+            if(depth == 0){
+                job.operations.emplace_back(value);
+            }else{
+                innermost(depth - 1)->makeChild(value);
+            }
+            active = true;
+
+        }else if(keyword == "parameter"){
+            if(!active) throw std::invalid_argument("Parameters must follow an operation");
+            if(!(innermost(depth)->insert(value))){
+                throw std::invalid_argument("Parameter insertion failed (is it duplicated?)");
+            }
+
+        }else if(keyword == "start-children"){
+            if(job.operations.empty()) throw std::invalid_argument("Children must follow an operation");
+            ++depth;
+            active = false;
+
+        }else if(keyword == "stop-children"){
+            --depth;
+            active = false;
+            if(depth < 0) throw std::invalid_argument("Mismatched scope modifiers detected");
+
+        }else if(keyword == "timeout"){
+            try{
+                job.timeout = std::stod(value);
+            }catch(const std::exception &){
+                throw std::invalid_argument("Timeout format not recognized: '" + value + "'");
+            }
+
+        }else if(keyword == "progress"){
+            job.report_progress = true;
+
+        }else if(keyword == "archive"){
+            job.return_archive = true;
+
+        }else if(keyword == "shutdown"){
+            job.shutdown = true;
+
+        }else{
+            throw std::invalid_argument("Unrecognized keyword '" + keyword + "'");
+        }
+    }
+    if(depth != 0) throw std::invalid_argument("Mismatched scope modifiers detected");
+    return job;
+}
+
+// Reads lines until a 'run' or 'shutdown' line, or until the client stops sending.
+std::list<std::string> Read_Job_Lines(int fd){
+    std::list<std::string> lines;
+    std::string buf;
+    size_t total = 0;
+    char chunk[4096];
+    while(true){
+        const auto n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            throw std::runtime_error(std::string("Unable to read job: ") + std::strerror(errno));
+        }
+        if(n == 0) break;
+
+        total += static_cast<size_t>(n);
+        if(max_job_bytes < total) throw std::runtime_error("Job description is too large");
+        buf.append(chunk, static_cast<size_t>(n));
+
+        size_t pos;
+        while((pos = buf.find('\n')) != std::string::npos){
+            auto line = buf.substr(0, pos);
+            buf.erase(0, pos + 1);
+            if(!line.empty() && (line.back() == '\r')) line.pop_back();
+
+            if(line == "run") return lines;
+            if(line.empty() || (line.front() == '#')) continue;
+            lines.push_back(line);
+            if(line == "shutdown") return lines;
+        }
+    }
+    if(!buf.empty()) lines.push_back(buf);
+    return lines;
+}
+
+bool Write_Bytes(int fd, const std::string &msg){
+    size_t sent = 0;
+    while(sent < msg.size()){
+        const auto n = ::send(fd, msg.data() + sent, msg.size() - sent, 0);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            FUNCWARN("Unable to send reply: " << std::strerror(errno));
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void Write_Reply(int fd, const std::string &reply){
+    Write_Bytes(fd, reply + "\n");
+    return;
+}
+
+// Returns the data as a native archive, which is staged in a temporary file.
+std::string Archive_Drover(const Drover &DICOM_data){
+    const auto path = boost::filesystem::temp_directory_path()
+                    / boost::filesystem::unique_path("dcma_job_%%%%-%%%%-%%%%-%%%%.dcma");
+    std::string out;
+    try{
+        if(!Common_Boost_Serialize_Drover_to_Native_Archive(DICOM_data, path)){
+            throw std::runtime_error("Unable to archive results");
+        }
+        std::ifstream ifs(path.string(), std::ios::in | std::ios::binary);
+        out.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        if(ifs.bad()) throw std::runtime_error("Unable to read archived results");
+    }catch(const std::exception &){
+        boost::system::error_code ec;
+        boost::filesystem::remove(path, ec);
+        throw;
+    }
+    boost::system::error_code ec;
+    boost::filesystem::remove(path, ec);
+    return out;
+}
+
+std::string Escape_JSON(const std::string &in){
+    std::stringstream ss;
+    for(const auto c : in){
+        switch(c){
+            case '"':  ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20){
+                    ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                }else{
+                    ss << c;
+                }
+                break;
+        }
+    }
+    return ss.str();
+}
+
+// Progress reports are written as single-line JSON objects so clients can parse them without tracking the format of
+// console messages.
+std::string Format_Progress(const progress_report &r){
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "PROGRESS {\"label\":\"" << Escape_JSON(r.label) << "\","
+       << "\"completed\":" << r.completed << ","
+       << "\"total\":" << r.total << ","
+       << "\"elapsed_s\":" << r.elapsed_s << ","
+       << "\"eta_s\":" << r.eta_s << "}";
+    return ss.str();
+}
+
+void Perform_Job(const dispatch_job_t &job,
+                 const dispatch_server_opts &opts,
+                 int fd,
+                 std::map<std::string,std::string> InvocationMetadata,
+                 const std::string &FilenameLex){
+    if(job.operations.empty()) throw std::invalid_argument("No operations specified");
+
+    for(const auto &p : job.metadata) InvocationMetadata[p.first] += p.second;
+
+    std::list<boost::filesystem::path> paths;
+    for(const auto &auri : job.paths){
+        bool wasOK = false;
+        try{
+            wasOK = boost::filesystem::exists(boost::filesystem::canonical(auri));
+        }catch(const boost::filesystem::filesystem_error &){ }
+        if(!wasOK) throw std::invalid_argument("Unable to resolve file or directory '" + auri + "'");
+        paths.emplace_back(auri);
+    }
+
+    auto deadline = cancellation_token::clock_t::time_point::max();
+    if(0.0 < job.timeout){
+        deadline = cancellation_token::clock_t::now()
+                 + std::chrono::milliseconds(static_cast<long int>(std::ceil(job.timeout * 1000.0)));
+    }
+    const auto token = cancellation_token::current().derive(deadline);
+    const cancellation_token::scope job_scope(token);
+
+    // Reports may arrive concurrently from workers, so writes are serialized to avoid interleaving lines.
+    std::mutex reply_m;
+    std::shared_ptr<const progress_sink::observer_t> observer;
+    if(job.report_progress){
+        observer = std::make_shared<const progress_sink::observer_t>([&reply_m, fd](const progress_report &r){
+            std::lock_guard<std::mutex> lock(reply_m);
+            Write_Reply(fd, Format_Progress(r));
+        });
+    }
+    const progress_sink::scope sink_scope(observer);
+
+    Drover DICOM_data;
+    if(!Load_Files(DICOM_data, InvocationMetadata, FilenameLex, paths, opts.loader_threads, opts.defer_pixels)){
+        throw std::runtime_error("File loading unsuccessful");
+    }
+    if(!Operation_Dispatcher(DICOM_data, InvocationMetadata, FilenameLex, job.operations)){
+        token.throw_if_cancelled();
+        throw std::runtime_error("Analysis failed");
+    }
+
+    if(job.return_archive){
+        const auto archive = Archive_Drover(DICOM_data);
+        std::lock_guard<std::mutex> lock(reply_m);
+        if(!Write_Bytes(fd, "ARCHIVE " + std::to_string(archive.size()) + "\n")
+        || !Write_Bytes(fd, archive)){
+            throw std::runtime_error("Unable to send archived results");
+        }
+    }
+    return;
+}
+
+struct listen_address_t {
+    sockaddr_storage addr;
+    socklen_t len = 0;
+    bool is_tcp = false;
+};
+
+// Wakes a blocked accept() by connecting to the socket.
+void Wake_Listener(const listen_address_t &a){
+    const int fd = ::socket(a.addr.ss_family, SOCK_STREAM, 0);
+    if(fd < 0) return;
+    (void) ::connect(fd, reinterpret_cast<const sockaddr *>(&a.addr), a.len);
+    ::close(fd);
+    return;
+}
+
+// Binds and listens on the Unix socket.
+int Listen_Unix(const std::string &socket_path, listen_address_t &a){
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(sizeof(addr.sun_path) <= socket_path.size()){
+        throw std::invalid_argument("Socket path '" + socket_path + "' is too long");
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    std::memset(&a.addr, 0, sizeof(a.addr));
+    std::memcpy(&a.addr, &addr, sizeof(addr));
+    a.len = sizeof(addr);
+
+    const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listen_fd < 0) throw std::runtime_error(std::string("Unable to create socket: ") + std::strerror(errno));
+
+    // A socket left behind by an earlier server is replaced, but other files are not.
+    struct stat st;
+    if( (::lstat(socket_path.c_str(), &st) == 0)
+    &&  S_ISSOCK(st.st_mode) ){
+        ::unlink(socket_path.c_str());
+    }
+
+    // Only the owner may submit jobs.
+    const auto old_mask = ::umask(0077);
+    const auto bound = ::bind(listen_fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+    ::umask(old_mask);
+    if( (bound != 0)
+    ||  (::listen(listen_fd, 64) != 0) ){
+        const std::string err = std::strerror(errno);
+        ::close(listen_fd);
+        throw std::runtime_error("Unable to listen on '" + socket_path + "': " + err);
+    }
+    return listen_fd;
+}
+
+// Binds and listens on the TCP address, given as 'host:port'.
+int Listen_TCP(const std::string &address, listen_address_t &a){
+    const auto sep = address.rfind(':');
+    if( (sep == std::string::npos) || (sep == 0) || (sep + 1 == address.size()) ){
+        throw std::invalid_argument("TCP address '" + address + "' is invalid. Use 'tcp://host:port'");
+    }
+    const auto host = address.substr(0, sep);
+    const auto port = address.substr(sep + 1);
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo *res = nullptr;
+    if(const auto rc = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &res); rc != 0){
+        throw std::runtime_error("Unable to resolve '" + address + "': " + ::gai_strerror(rc));
+    }
+    std::memset(&a.addr, 0, sizeof(a.addr));
+    std::memcpy(&a.addr, res->ai_addr, res->ai_addrlen);
+    a.len = res->ai_addrlen;
+    a.is_tcp = true;
+    ::freeaddrinfo(res);
+
+    const int listen_fd = ::socket(a.addr.ss_family, SOCK_STREAM, 0);
+    if(listen_fd < 0) throw std::runtime_error(std::string("Unable to create socket: ") + std::strerror(errno));
+    const int reuse = 1;
+    (void) ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if( (::bind(listen_fd, reinterpret_cast<const sockaddr *>(&a.addr), a.len) != 0)
+    ||  (::listen(listen_fd, 64) != 0) ){
+        const std::string err = std::strerror(errno);
+        ::close(listen_fd);
+        throw std::runtime_error("Unable to listen on '" + address + "': " + err);
+    }
+    return listen_fd;
+}
+
+} // namespace
+
+
+void Serve_Dispatch_Jobs(const dispatch_server_opts &opts,
+                         const std::map<std::string,std::string> &InvocationMetadata,
+                         const std::string &FilenameLex){
+    if(opts.socket_path.empty()) throw std::invalid_argument("No socket path provided");
+    if(opts.max_jobs <= 0) throw std::invalid_argument("The number of concurrent jobs must be positive");
+
+    // Clients that disconnect early should not terminate the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const std::string tcp_prefix = "tcp://";
+    listen_address_t addr;
+    const int listen_fd = (opts.socket_path.rfind(tcp_prefix, 0) == 0)
+                        ? Listen_TCP(opts.socket_path.substr(tcp_prefix.size()), addr)
+                        : Listen_Unix(opts.socket_path, addr);
+    FUNCINFO("Accepting jobs on '" << opts.socket_path << "'");
+
+    std::mutex m;
+    std::condition_variable cv;
+    long int active_jobs = 0;
+    bool stopping = false;
+
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait(lock, [&](){ return stopping || (active_jobs < opts.max_jobs); });
+            if(stopping) break;
+        }
+
+        const int fd = ::accept(listen_fd, nullptr, nullptr);
+        if(fd < 0){
+            if(errno == EINTR) continue;
+            FUNCWARN("Unable to accept connection: " << std::strerror(errno));
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if(stopping){
+                ::close(fd);
+                break;
+            }
+            ++active_jobs;
+        }
+
+        std::thread([&, fd](){
+            std::string reply = "OK";
+            bool shutdown = false;
+            try{
+                const auto job = Parse_Job(Read_Job_Lines(fd));
+                shutdown = job.shutdown;
+                if(!shutdown){
+                    Perform_Job(job, opts, fd, InvocationMetadata, FilenameLex);
+                }
+            }catch(const std::exception &e){
+                FUNCWARN("Job failed: " << e.what());
+                reply = std::string("FAILED: ") + e.what();
+            }
+            Write_Reply(fd, reply);
+            ::close(fd);
+
+            std::lock_guard<std::mutex> lock(m);
+            if(shutdown && !stopping){
+                FUNCINFO("Shutting down once jobs in progress have completed");
+                stopping = true;
+                Wake_Listener(addr);
+            }
+            --active_jobs;
+            cv.notify_all();
+        }).detach();
+    }
+
+    ::close(listen_fd);
+    if(!addr.is_tcp) ::unlink(opts.socket_path.c_str());
+
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [&](){ return (active_jobs == 0); });
+    return;
+}
+
+#else
+
+void Serve_Dispatch_Jobs(const dispatch_server_opts &,
+                         const std::map<std::string,std::string> &,
+                         const std::string &){
+    throw std::runtime_error("Serving jobs is not supported on this platform");
+}
+
+#endif
@@ -0,0 +1,57 @@
+//Dispatch_Server.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <map>
+#include <string>
+
+
+// A long-running server that performs jobs submitted over a local (Unix domain) socket.
+//
+// Each connection submits one job as lines of text mirroring the command line options, followed by a 'run' line:
+//
+//     standalone /path/to/dir/or/file
+//     metadata Volunteer=01
+//     operation ComputeX:abc=123
+//     parameter def=456
+//     start-children
+//     operation ComputeY
+//     stop-children
+//     timeout 3600
+//     run
+//
+// An optional timeout (in seconds) cancels the job if it has not completed in time. Blank lines and lines beginning
+// with '#' are ignored. The server replies with a single line, either 'OK' or 'FAILED: <reason>', and closes the
+// connection. A connection that sends only 'shutdown' stops the server once the jobs already in progress have
+// completed.
+//
+// If the job includes a 'progress' line, the reply is preceded by periodic progress reports, one per line, of the form
+//
+//     PROGRESS {"label":"SimulateRadiograph","completed":120,"total":512,"elapsed_s":4.100,"eta_s":13.393}
+//
+// where the label identifies the work being tracked (which may be empty), and 'eta_s' is the estimated number of
+// seconds remaining for that work. Reports from distinct work within a job may interleave.
+//
+// If the job includes an 'archive' line, the job's resulting data are returned as a native archive (see
+// Common_Boost_Serialize_Drover_to_Native_Archive()) before the final reply, as a line 'ARCHIVE <N>' followed by the
+// N bytes of the archive.
+//
+// Every job loads its own data and has its own copy of the invocation metadata, so jobs do not see each other's
+// data. The lexicon, selector caches, and worker pool are shared, so they remain warm between jobs. Note that jobs
+// share the filesystem and the working directory, so jobs that write files should be directed to distinct paths.
+//
+// Jobs can also be accepted over TCP by providing an address of the form 'tcp://host:port' instead of a socket path,
+// e.g., so a coordinator can distribute jobs across nodes (see Distributed_Dispatch.h). Connections are not
+// authenticated, so TCP should only be used on trusted networks.
+struct dispatch_server_opts {
+    std::string socket_path; // Or 'tcp://host:port'.
+
+    long int max_jobs = 1; // The number of jobs performed concurrently.
+    long int loader_threads = 1;
+    bool defer_pixels = false;
+};
+
+// Blocks until the server is shut down. Throws if the socket cannot be created.
+void Serve_Dispatch_Jobs(const dispatch_server_opts &opts,
+                         const std::map<std::string,std::string> &InvocationMetadata,
+                         const std::string &FilenameLex);
@@ -0,0 +1,184 @@
+//Distance_Transform.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "Thread_Pool.h"
+#include "Distance_Transform.h"
+
+
+namespace {
+
+constexpr double inf = std::numeric_limits<double>::infinity();
+
+// Tolerance for classifying voxels that lie on the margin ellipsoid.
+constexpr double margin_tolerance = 1.0E-9;
+
+// Scratch space for transforming a single line.
+struct line_scratch_t {
+    std::vector<double> f;   // The line's input values.
+    std::vector<int64_t> v;  // Positions of the parabolas in the lower envelope.
+    std::vector<double> z;   // Boundaries between the envelope's parabolas.
+
+    explicit line_scratch_t(int64_t n) : f(n), v(n), z(n + 1) {}
+};
+
+// Replaces the squared distances along a line (with the given stride between elements) with the lower envelope of the
+// parabolas (x - q*w)^2 + f(q). Infinite entries do not root a parabola.
+void transform_line(double *d, int64_t n, int64_t stride, double w, line_scratch_t &s){
+    bool any_finite = false;
+    for(int64_t q = 0; q < n; ++q){
+        s.f[q] = d[q * stride];
+        any_finite = any_finite || std::isfinite(s.f[q]);
+    }
+    if(!any_finite) return;
+
+    int64_t k = -1;
+    for(int64_t q = 0; q < n; ++q){
+        const auto fq = s.f[q];
+        if(!std::isfinite(fq)) continue;
+        const auto xq = static_cast<double>(q) * w;
+
+        double zq = -inf;
+        while(0 <= k){
+            const auto p = s.v[k];
+            const auto xp = static_cast<double>(p) * w;
+            zq = ((fq + xq * xq) - (s.f[p] + xp * xp)) / (2.0 * (xq - xp));
+            if(s.z[k] < zq) break;
+            --k;
+        }
+        ++k;
+        s.v[k] = q;
+        s.z[k] = (k == 0) ? -inf : zq;
+        s.z[k + 1] = inf;
+    }
+
+    k = 0;
+    for(int64_t q = 0; q < n; ++q){
+        const auto x = static_cast<double>(q) * w;
+        while(s.z[k + 1] < x) ++k;
+        const auto p = s.v[k];
+        const auto dx = x - static_cast<double>(p) * w;
+        d[q * stride] = dx * dx + s.f[p];
+    }
+    return;
+}
+
+// Transforms every line parallel to one axis, in parallel. Lines are addressed by an outer index (with outer_stride
+// between starts) and an inner index (with unit stride between starts).
+void transform_axis(std::vector<double> &d,
+                    int64_t n_outer, int64_t outer_stride,
+                    int64_t n_inner,
+                    int64_t n, int64_t stride, double w){
+    if( (n < 2) || !std::isfinite(w) ) return;
+
+    const int64_t n_lines = n_outer * n_inner;
+    const int64_t n_tasks = 4 * static_cast<int64_t>(work_stealing_pool::get().concurrency());
+    const int64_t lines_per_block = std::max<int64_t>(1, n_lines / std::max<int64_t>(1, n_tasks));
+    const int64_t n_blocks = (n_lines + lines_per_block - 1) / lines_per_block;
+
+    parallel_for(0, n_blocks, [&](long int b){
+        line_scratch_t s(n);
+        const int64_t l_end = std::min<int64_t>(n_lines, (b + 1) * lines_per_block);
+        for(int64_t l = b * lines_per_block; l < l_end; ++l){
+            const auto outer = l / n_inner;
+            const auto inner = l % n_inner;
+            transform_line(d.data() + outer * outer_stride + inner, n, stride, w, s);
+        }
+    }, 1);
+    return;
+}
+
+void validate(const std::vector<uint8_t> &mask, const distance_transform_grid &grid){
+    if( (grid.images < 0) || (grid.rows < 0) || (grid.columns < 0) ){
+        throw std::invalid_argument("Grid dimensions cannot be negative");
+    }
+    if(static_cast<int64_t>(mask.size()) != grid.size()){
+        throw std::invalid_argument("Mask size does not match grid dimensions");
+    }
+    for(const auto w : { grid.image_spacing, grid.row_spacing, grid.column_spacing }){
+        if(std::isnan(w) || !(0.0 < w)){
+            throw std::invalid_argument("Grid spacing must be positive");
+        }
+    }
+    return;
+}
+
+// Returns the grid with spacing scaled so that the margin ellipsoid becomes the unit sphere.
+distance_transform_grid scale_to_margins(const distance_transform_grid &grid,
+                                         const distance_transform_margins &margins){
+    const auto scale = [](double w, double m) -> double {
+        if(!std::isfinite(m) || (m < 0.0)){
+            throw std::invalid_argument("Margins must be finite and non-negative");
+        }
+        return (m == 0.0) ? inf : w / m;
+    };
+    auto out = grid;
+    out.image_spacing  = scale(grid.image_spacing,  margins.image);
+    out.row_spacing    = scale(grid.row_spacing,    margins.row);
+    out.column_spacing = scale(grid.column_spacing, margins.column);
+    return out;
+}
+
+} // namespace
+
+
+int64_t distance_transform_grid::size() const {
+    return this->images * this->rows * this->columns;
+}
+
+std::vector<double>
+Squared_Euclidean_Distance_Transform(const std::vector<uint8_t> &mask,
+                                     const distance_transform_grid &grid){
+    validate(mask, grid);
+
+    const auto N = grid.size();
+    std::vector<double> d(N);
+    parallel_for(0, N, [&](long int i){
+        d[i] = (mask[i] != 0) ? 0.0 : inf;
+    }, std::max<long int>(1, grid.rows * grid.columns));
+
+    const auto row_stride   = grid.columns;
+    const auto image_stride = grid.rows * grid.columns;
+
+    // Columns are contiguous, so they are processed first while the 1D distances are cheapest to reach.
+    transform_axis(d, grid.images * grid.rows, row_stride, 1,
+                   grid.columns, 1, grid.column_spacing);
+    transform_axis(d, grid.images, image_stride, grid.columns,
+                   grid.rows, row_stride, grid.row_spacing);
+    transform_axis(d, 1, 0, image_stride,
+                   grid.images, image_stride, grid.image_spacing);
+    return d;
+}
+
+std::vector<uint8_t>
+Dilate_Mask(const std::vector<uint8_t> &mask,
+            const distance_transform_grid &grid,
+            const distance_transform_margins &margins){
+    const auto scaled = scale_to_margins(grid, margins);
+    const auto d = Squared_Euclidean_Distance_Transform(mask, scaled);
+
+    std::vector<uint8_t> out(d.size());
+    for(size_t i = 0; i < d.size(); ++i){
+        out[i] = (d[i] <= (1.0 + margin_tolerance)) ? 1 : 0;
+    }
+    return out;
+}
+
+std::vector<uint8_t>
+Erode_Mask(const std::vector<uint8_t> &mask,
+           const distance_transform_grid &grid,
+           const distance_transform_margins &margins){
+    std::vector<uint8_t> complement(mask.size());
+    for(size_t i = 0; i < mask.size(); ++i){
+        complement[i] = (mask[i] == 0) ? 1 : 0;
+    }
+    auto out = Dilate_Mask(complement, grid, margins);
+    for(auto &m : out) m = (m == 0) ? 1 : 0;
+    return out;
+}
+
@@ -0,0 +1,59 @@
+//Distance_Transform.h.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+// Exact Euclidean distance transforms and margins for binary masks on rectilinear grids.
+//
+// Masks are stored contiguously with (image, row, column) ordering, like rectilinear_volume with a single channel. The
+// transform is computed separably (Felzenszwalb and Huttenlocher, 2012): each axis is processed in turn by finding the
+// lower envelope of the parabolas rooted at every voxel along each line, which is linear in the number of voxels and
+// exact for any (anisotropic) voxel spacing. Lines are processed in parallel.
+struct distance_transform_grid {
+    int64_t images  = 0;
+    int64_t rows    = 0;
+    int64_t columns = 0;
+
+    // Distances between adjacent voxel centres along each axis (in DICOM units; mm). Distances are not propagated
+    // along axes with infinite spacing, so (for example) an infinite image spacing treats every image independently.
+    double image_spacing  = 1.0;
+    double row_spacing    = 1.0;
+    double column_spacing = 1.0;
+
+    int64_t size() const;
+};
+
+// Returns the squared distance from each voxel to the nearest voxel for which the mask is non-zero. Voxels with no
+// reachable non-zero voxel are assigned infinity. Voxels outside the grid are not considered. Throws if the mask and
+// grid are inconsistent.
+std::vector<double>
+Squared_Euclidean_Distance_Transform(const std::vector<uint8_t> &mask,
+                                     const distance_transform_grid &grid);
+
+
+// Margins along each axis (in DICOM units; mm). Margins describe the semi-axes of an ellipsoidal structuring element,
+// so equal margins are isotropic and a zero margin disables growth (or shrinkage) along that axis.
+struct distance_transform_margins {
+    double image  = 0.0;
+    double row    = 0.0;
+    double column = 0.0;
+};
+
+// Returns the voxels within the margin of a non-zero voxel, i.e., the morphological dilation of the mask by the
+// ellipsoid. Voxels lying on the ellipsoid (to within floating-point rounding) are included. Throws if the margins are
+// negative or non-finite.
+std::vector<uint8_t>
+Dilate_Mask(const std::vector<uint8_t> &mask,
+            const distance_transform_grid &grid,
+            const distance_transform_margins &margins);
+
+// Returns the voxels farther than the margin from every zero voxel, i.e., the morphological erosion of the mask by the
+// ellipsoid. Voxels outside the grid are treated as non-zero, so the mask does not shrink away from the grid boundary.
+std::vector<uint8_t>
+Erode_Mask(const std::vector<uint8_t> &mask,
+           const distance_transform_grid &grid,
+           const distance_transform_margins &margins);
+
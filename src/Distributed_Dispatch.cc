@@ -0,0 +1,418 @@
+//Distributed_Dispatch.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <cerrno>
+    #include <csignal>
+    #include <netdb.h>
+    #include <sys/socket.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+#endif
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Structs.h"
+#include "Imebra_Shim.h"
+#include "Operation_Dispatcher.h"
+#include "Thread_Pool.h"
+
+#include "Distributed_Dispatch.h"
+
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace {
+
+// Workers that cannot be reached this many times in a row are no longer used.
+constexpr long int max_connect_failures = 3;
+
+struct shard_t {
+    std::string name; // Also names the resulting archive.
+    std::list<std::string> files;
+    long int attempts = 0;
+    std::string last_worker;
+};
+
+// Directories are expanded recursively, in a stable order. Paths are made absolute for the workers.
+std::list<std::string> Expand_Inputs(const std::list<boost::filesystem::path> &inputs){
+    std::list<std::string> out;
+    for(const auto &p : inputs){
+        const auto abs_p = boost::filesystem::absolute(p);
+        if(!boost::filesystem::is_directory(abs_p)){
+            out.push_back(abs_p.string());
+            continue;
+        }
+        std::vector<std::string> files;
+        for(const auto &e : boost::filesystem::recursive_directory_iterator(abs_p)){
+            if(boost::filesystem::is_regular_file(e.path())) files.push_back(e.path().string());
+        }
+        std::sort(std::begin(files), std::end(files));
+        out.insert(std::end(out), std::begin(files), std::end(files));
+    }
+    return out;
+}
+
+std::string Sanitize_Name(const std::string &in){
+    std::string out;
+    for(const auto c : in){
+        out.push_back( (std::isalnum(static_cast<unsigned char>(c)) || (c == '-') || (c == '.')) ? c : '_' );
+        if(64 <= out.size()) break;
+    }
+    return out;
+}
+
+void Write_Operation_Lines(std::ostream &os, const std::list<OperationArgPkg> &Operations){
+    for(const auto &optargs : Operations){
+        os << "operation " << optargs.getName() << "\n";
+
+        // Only the documented arguments can be enumerated, but these are the only arguments operations consult.
+        std::list<std::string> arg_names;
+        try{
+            for(const auto &a : Known_Operation_Documentation(optargs.getName()).args) arg_names.push_back(a.name);
+        }catch(const std::invalid_argument &){ } // Unknown operations are reported by the workers.
+        for(const auto &name : arg_names){
+            const auto val = optargs.getValueStr(name);
+            if(!val) continue;
+            if(val->find('\n') != std::string::npos){
+                throw std::invalid_argument("Argument '" + name + "' cannot contain a newline when distributed");
+            }
+            os << "parameter " << name << "=" << val.value() << "\n";
+        }
+
+        const auto children = optargs.getChildren();
+        if(!children.empty()){
+            os << "start-children\n";
+            Write_Operation_Lines(os, children);
+            os << "stop-children\n";
+        }
+    }
+    return;
+}
+
+int Connect_To_Worker(const std::string &worker){
+    const auto sep = worker.rfind(':');
+    if( (sep == std::string::npos) || (sep == 0) || (sep + 1 == worker.size()) ){
+        throw std::invalid_argument("Worker address '" + worker + "' is invalid. Use 'host:port'");
+    }
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *res = nullptr;
+    if(const auto rc = ::getaddrinfo(worker.substr(0, sep).c_str(), worker.substr(sep + 1).c_str(), &hints, &res);
+       rc != 0){
+        throw std::runtime_error(std::string("Unable to resolve worker: ") + ::gai_strerror(rc));
+    }
+    int fd = -1;
+    std::string err = "No addresses";
+    for(auto *r = res; r != nullptr; r = r->ai_next){
+        fd = ::socket(r->ai_family, r->ai_socktype, r->ai_protocol);
+        if(fd < 0) continue;
+        if(::connect(fd, r->ai_addr, r->ai_addrlen) == 0) break;
+        err = std::strerror(errno);
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(res);
+    if(fd < 0) throw std::runtime_error("Unable to connect to worker: " + err);
+    return fd;
+}
+
+struct job_result_t {
+    bool connected = false;
+    bool ok = false;
+    std::string archive;
+    std::string error;
+};
+
+job_result_t Submit_Job(const std::string &worker, const std::string &job){
+    job_result_t r;
+    int fd = -1;
+    try{
+        fd = Connect_To_Worker(worker);
+    }catch(const std::exception &e){
+        r.error = e.what();
+        return r;
+    }
+    r.connected = true;
+
+    try{
+        size_t sent = 0;
+        while(sent < job.size()){
+            const auto n = ::send(fd, job.data() + sent, job.size() - sent, 0);
+            if(n < 0){
+                if(errno == EINTR) continue;
+                throw std::runtime_error(std::string("Unable to send job: ") + std::strerror(errno));
+            }
+            sent += static_cast<size_t>(n);
+        }
+
+        // The reply is a series of lines, except for archives, which are raw bytes following their header line.
+        std::string buf;
+        std::optional<size_t> archive_size;
+        char chunk[65536];
+        while(true){
+            if(archive_size){
+                if(archive_size.value() <= buf.size()){
+                    r.archive = buf.substr(0, archive_size.value());
+                    buf.erase(0, archive_size.value());
+                    archive_size.reset();
+                    continue;
+                }
+            }else if(const auto pos = buf.find('\n'); pos != std::string::npos){
+                const auto line = buf.substr(0, pos);
+                buf.erase(0, pos + 1);
+                if(line == "OK"){
+                    r.ok = true;
+                    break;
+                }
+                const std::string archive_prefix = "ARCHIVE ";
+                if(line.rfind(archive_prefix, 0) == 0){
+                    archive_size = static_cast<size_t>(std::stoull(line.substr(archive_prefix.size())));
+                    r.archive.clear();
+                    buf.reserve(archive_size.value());
+                    continue;
+                }
+                if(line.rfind("PROGRESS ", 0) == 0) continue;
+                throw std::runtime_error(line);
+            }
+
+            const auto n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if(n < 0){
+                if(errno == EINTR) continue;
+                throw std::runtime_error(std::string("Unable to read reply: ") + std::strerror(errno));
+            }
+            if(n == 0) throw std::runtime_error("Worker closed the connection before replying");
+            buf.append(chunk, static_cast<size_t>(n));
+        }
+        if(r.archive.empty()) throw std::runtime_error("Worker did not return any results");
+
+    }catch(const std::exception &e){
+        r.ok = false;
+        r.error = e.what();
+    }
+    ::close(fd);
+    return r;
+}
+
+void Write_File_Atomically(const boost::filesystem::path &p, const std::string &contents){
+    auto tmp = p;
+    tmp += ".partial";
+    {
+        std::ofstream of(tmp.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!of) throw std::runtime_error("Unable to write '" + tmp.string() + "'");
+        of.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        of.flush();
+        if(!of) throw std::runtime_error("Unable to write '" + tmp.string() + "'");
+    }
+    boost::filesystem::rename(tmp, p);
+    return;
+}
+
+} // namespace
+
+
+long int Distribute_Jobs(const distributed_dispatch_opts &opts,
+                         const std::list<boost::filesystem::path> &inputs,
+                         const std::map<std::string,std::string> &InvocationMetadata,
+                         const std::list<OperationArgPkg> &Operations){
+    if(opts.workers.empty()) throw std::invalid_argument("No workers provided");
+    if(opts.jobs_per_worker <= 0) throw std::invalid_argument("The number of jobs per worker must be positive");
+    if(opts.max_attempts <= 0) throw std::invalid_argument("The number of attempts must be positive");
+    if(Operations.empty()) throw std::invalid_argument("No operations provided");
+
+    // Operations and metadata are common to every job.
+    std::string common;
+    {
+        std::stringstream ss;
+        for(const auto &p : InvocationMetadata){
+            if(p.first == "Invocation") continue; // Describes the coordinator, not the workers.
+            if( (p.first.find_first_of("=\n") != std::string::npos)
+            ||  (p.second.find_first_of("=\n") != std::string::npos) ){
+                FUNCWARN("Metadata '" << p.first << "' cannot be distributed. Ignoring it");
+                continue;
+            }
+            ss << "metadata " << p.first << "=" << p.second << "\n";
+        }
+        Write_Operation_Lines(ss, Operations);
+        ss << "archive\n" << "run\n";
+        common = ss.str();
+    }
+
+    // Shard the inputs.
+    const auto files = Expand_Inputs(inputs);
+    const std::vector<std::string> files_v(std::begin(files), std::end(files));
+    FUNCINFO("Reading metadata from " << files_v.size() << " files");
+    std::vector<std::optional<std::vector<std::string>>> signatures(files_v.size());
+    parallel_for(0, static_cast<long int>(files_v.size()), [&](long int i){
+        std::map<std::string,std::string> tags;
+        try{
+            tags = get_metadata_top_level_tags(Parse_DICOM_File(files_v[i]));
+        }catch(const std::exception &){
+            return; // Not DICOM.
+        }
+        std::vector<std::string> sig;
+        for(const auto &key : opts.keys){
+            const auto it = tags.find(key);
+            if(it == std::end(tags)) return;
+            sig.push_back(it->second);
+        }
+        signatures[i] = sig;
+    }, 1);
+
+    std::map<std::vector<std::string>, std::list<std::string>> partitions;
+    std::list<std::string> na_partition;
+    for(size_t i = 0; i < files_v.size(); ++i){
+        if(signatures[i]){
+            partitions[signatures[i].value()].push_back(files_v[i]);
+        }else{
+            na_partition.push_back(files_v[i]);
+        }
+    }
+
+    std::vector<shard_t> shards;
+    const auto add_shard = [&](const std::vector<std::string> &sig, std::list<std::string> &f){
+        std::stringstream ss;
+        ss << "shard_" << std::setw(5) << std::setfill('0') << shards.size();
+        for(const auto &v : sig) ss << "_" << Sanitize_Name(v);
+        shards.emplace_back();
+        shards.back().name = ss.str();
+        shards.back().files = std::move(f);
+    };
+    for(auto &p : partitions) add_shard(p.first, p.second);
+    if(!na_partition.empty()) add_shard({ "NA" }, na_partition);
+    FUNCINFO("Distributing " << shards.size() << " shards across " << opts.workers.size() << " workers");
+
+    boost::filesystem::create_directories(opts.output_dir);
+
+    // Signals that disappearing workers would otherwise raise should not terminate the coordinator.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<size_t> queue;
+    for(size_t i = 0; i < shards.size(); ++i) queue.push_back(i);
+    long int in_flight = 0;
+    long int N_completed = 0;
+    long int N_failed = 0;
+    std::map<std::string, long int> connect_failures;
+    std::map<std::string, bool> retired;
+
+    const auto serve_worker = [&](const std::string &worker){
+        while(true){
+            size_t i = 0;
+            std::string job;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [&](){ return retired[worker] || !queue.empty() || (in_flight == 0); });
+                if(retired[worker] || queue.empty()) return;
+
+                // Prefer shards that did not last fail on this worker.
+                auto it = std::find_if(std::begin(queue), std::end(queue),
+                                       [&](size_t k){ return (shards[k].last_worker != worker); });
+                if(it == std::end(queue)) it = std::begin(queue);
+                i = *it;
+                queue.erase(it);
+                ++in_flight;
+
+                std::stringstream ss;
+                for(const auto &f : shards[i].files) ss << "standalone " << f << "\n";
+                job = ss.str() + common;
+            }
+
+            auto r = Submit_Job(worker, job);
+            if(r.ok){
+                try{
+                    Write_File_Atomically(boost::filesystem::path(opts.output_dir) / (shards[i].name + ".dcma"),
+                                          r.archive);
+                }catch(const std::exception &e){
+                    r.ok = false;
+                    r.error = e.what();
+                }
+            }
+            r.archive.clear();
+
+            std::lock_guard<std::mutex> lock(m);
+            --in_flight;
+            auto &shard = shards[i];
+            if(r.ok){
+                connect_failures[worker] = 0;
+                ++N_completed;
+                FUNCINFO("Completed shard '" << shard.name << "' on '" << worker << "' ("
+                         << N_completed << " of " << shards.size() << " shards completed)");
+
+            }else if(!r.connected){
+                // The shard was never attempted, so it is not penalized.
+                queue.push_front(i);
+                if(max_connect_failures <= ++connect_failures[worker]){
+                    FUNCWARN("Unable to reach worker '" << worker << "': " << r.error << ". No longer using it");
+                    retired[worker] = true;
+                }
+
+            }else{
+                connect_failures[worker] = 0;
+                shard.last_worker = worker;
+                if(opts.max_attempts <= ++shard.attempts){
+                    ++N_failed;
+                    FUNCWARN("Shard '" << shard.name << "' failed on '" << worker << "': " << r.error
+                             << ". Giving up after " << shard.attempts << " attempts");
+                }else{
+                    queue.push_back(i);
+                    FUNCWARN("Shard '" << shard.name << "' failed on '" << worker << "': " << r.error
+                             << ". Retrying");
+                }
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::list<std::thread> threads;
+    for(const auto &worker : opts.workers){
+        for(long int j = 0; j < opts.jobs_per_worker; ++j){
+            threads.emplace_back(serve_worker, worker);
+        }
+    }
+    for(auto &t : threads) t.join();
+
+    // Shards remaining in the queue could not be submitted because no workers were reachable.
+    if(!queue.empty()){
+        FUNCWARN(queue.size() << " shards were not performed because no workers could be reached");
+        N_failed += static_cast<long int>(queue.size());
+    }
+    FUNCINFO("Completed " << N_completed << " of " << shards.size() << " shards");
+    return N_failed;
+}
+
+#else
+
+long int Distribute_Jobs(const distributed_dispatch_opts &,
+                         const std::list<boost::filesystem::path> &,
+                         const std::map<std::string,std::string> &,
+                         const std::list<OperationArgPkg> &){
+    throw std::runtime_error("Distributing jobs is not supported on this platform");
+}
+
+#endif
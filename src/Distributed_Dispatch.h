@@ -0,0 +1,39 @@
+//Distributed_Dispatch.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "Structs.h"
+
+
+// Distributes a batch of independent inputs across worker nodes, e.g., a cohort of patients processed with the same
+// operations.
+//
+// Inputs are sharded by the values of the given metadata keys, with the same semantics as ForEachDistinct: each
+// distinct combination of values forms one shard, and inputs lacking any of the keys (e.g., files that are not DICOM)
+// form one additional shard. Only the top-level DICOM metadata is read when sharding; pixel data are not decoded.
+//
+// Each shard is submitted as a job (see Dispatch_Server.h) to a worker serving jobs over TCP. Workers read the inputs
+// by path, so inputs must be reachable by the same (absolute) paths on every worker, e.g., on a shared filesystem.
+// The data resulting from each shard are streamed back as a native archive and written to the output directory.
+// Shards that fail are retried, on another worker where possible, up to the maximum number of attempts. Workers that
+// repeatedly cannot be reached are no longer used.
+struct distributed_dispatch_opts {
+    std::list<std::string> workers; // Each given as 'host:port'.
+    std::list<std::string> keys = { "PatientID" };
+    std::string output_dir = ".";
+
+    long int jobs_per_worker = 1; // The number of shards submitted to each worker concurrently.
+    long int max_attempts = 3;    // Per shard.
+};
+
+// Blocks until every shard has completed or exhausted its attempts. Returns the number of shards that failed.
+long int Distribute_Jobs(const distributed_dispatch_opts &opts,
+                         const std::list<boost::filesystem::path> &inputs,
+                         const std::map<std::string,std::string> &InvocationMetadata,
+                         const std::list<OperationArgPkg> &Operations);
@@ -0,0 +1,387 @@
+//Distribution_Sketch.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Distribution_Sketch.h"
+
+
+namespace {
+
+bool is_valid(double x, double w){
+    return std::isfinite(x) && std::isfinite(w) && (0.0 < w);
+}
+
+constexpr double pi = 3.14159265358979323846;
+
+} // namespace
+
+
+// ---------------------------------------------------- running_moments ----------------------------------------------------
+void running_moments::digest(double x, double w){
+    if(!is_valid(x, w)) return;
+    this->N += 1;
+    this->W += w;
+    const auto delta = x - this->m;
+    this->m += delta * (w / this->W);
+    this->M2 += w * delta * (x - this->m);
+    this->lo = std::min(this->lo, x);
+    this->hi = std::max(this->hi, x);
+}
+
+void running_moments::merge(const running_moments &other){
+    if(other.N == 0) return;
+    if(this->N == 0){
+        *this = other;
+        return;
+    }
+    const auto W_new = this->W + other.W;
+    const auto delta = other.m - this->m;
+    this->m += delta * (other.W / W_new);
+    this->M2 += other.M2 + delta * delta * (this->W * other.W / W_new);
+    this->W = W_new;
+    this->N += other.N;
+    this->lo = std::min(this->lo, other.lo);
+    this->hi = std::max(this->hi, other.hi);
+}
+
+size_t running_moments::count() const {
+    return this->N;
+}
+
+double running_moments::total_weight() const {
+    return this->W;
+}
+
+double running_moments::min() const {
+    return (this->N == 0) ? std::numeric_limits<double>::quiet_NaN() : this->lo;
+}
+
+double running_moments::max() const {
+    return (this->N == 0) ? std::numeric_limits<double>::quiet_NaN() : this->hi;
+}
+
+double running_moments::mean() const {
+    return (this->N == 0) ? std::numeric_limits<double>::quiet_NaN() : this->m;
+}
+
+double running_moments::unbiased_variance() const {
+    if( (this->N < 2) || !(1.0 < this->W) ) return std::numeric_limits<double>::quiet_NaN();
+    return this->M2 / (this->W - 1.0);
+}
+
+
+// -------------------------------------------------- fixed_bin_histogram --------------------------------------------------
+fixed_bin_histogram::fixed_bin_histogram(double lower, double bin_width, size_t bin_count)
+  : lower(lower), width(bin_width), weights(bin_count, 0.0) {
+    if( !std::isfinite(lower) || !std::isfinite(bin_width) || !(0.0 < bin_width) || (bin_count == 0) ){
+        throw std::invalid_argument("Invalid histogram bin layout");
+    }
+}
+
+fixed_bin_histogram fixed_bin_histogram::empty_copy() const {
+    return fixed_bin_histogram(this->lower, this->width, this->weights.size());
+}
+
+void fixed_bin_histogram::digest(double x, double w){
+    if(!is_valid(x, w)) return;
+    const auto N = this->weights.size();
+    const auto f = std::floor((x - this->lower) / this->width);
+    const auto i = (f <= 0.0) ? static_cast<size_t>(0)
+                 : ( (static_cast<double>(N - 1) <= f) ? (N - 1) : static_cast<size_t>(f) );
+    this->weights[i] += w;
+}
+
+void fixed_bin_histogram::merge(const fixed_bin_histogram &other){
+    if( (this->lower != other.lower)
+    ||  (this->width != other.width)
+    ||  (this->weights.size() != other.weights.size()) ){
+        throw std::invalid_argument("Unable to merge histograms with differing bin layouts");
+    }
+    for(size_t i = 0; i < this->weights.size(); ++i) this->weights[i] += other.weights[i];
+}
+
+size_t fixed_bin_histogram::size() const {
+    return this->weights.size();
+}
+
+double fixed_bin_histogram::bin_width() const {
+    return this->width;
+}
+
+double fixed_bin_histogram::bin_lower(size_t i) const {
+    return this->lower + this->width * static_cast<double>(i);
+}
+
+double fixed_bin_histogram::bin_centre(size_t i) const {
+    return this->bin_lower(i) + this->width * 0.5;
+}
+
+double fixed_bin_histogram::bin_weight(size_t i) const {
+    return this->weights.at(i);
+}
+
+
+std::vector<size_t> Otsu_Threshold_Bins(const fixed_bin_histogram &hist, size_t thresholds){
+    const auto L = hist.size();
+    const auto K = thresholds + 1; // The number of classes.
+    if( (thresholds == 0) || (L < K) ){
+        throw std::invalid_argument("Unable to partition the histogram into the requested number of classes");
+    }
+
+    // Between-class variance is invariant to affine transformations of the bin centres, so bin indices are used. With
+    // class weights w_k and first moments m_k, maximizing the variance is equivalent to maximizing sum_k m_k^2 / w_k.
+    std::vector<double> P(L + 1, 0.0); // Cumulative weight of bins [0, i).
+    std::vector<double> Q(L + 1, 0.0); // Cumulative first moment of bins [0, i).
+    for(size_t i = 0; i < L; ++i){
+        const auto w = hist.bin_weight(i);
+        P[i + 1] = P[i] + w;
+        Q[i + 1] = Q[i] + w * static_cast<double>(i);
+    }
+    const auto score = [&](size_t i, size_t j) -> double { // Bins [i, j).
+        const auto w = P[j] - P[i];
+        const auto m = Q[j] - Q[i];
+        return (0.0 < w) ? (m * m / w) : 0.0;
+    };
+
+    // best[j] holds the optimal score of partitioning bins [0, j) into the classes considered so far, and split[k][j]
+    // the first bin of the last of those classes.
+    std::vector<double> best(L + 1, 0.0);
+    for(size_t j = 1; j <= L; ++j) best[j] = score(0, j);
+    std::vector<std::vector<size_t>> split(K);
+
+    std::vector<double> next(L + 1, 0.0);
+    for(size_t k = 1; k < K; ++k){
+        // Only the final partition of the last class needs to end at L.
+        const auto j_begin = (k + 1 == K) ? L : (k + 1);
+        split[k].assign(L + 1, 0);
+        for(size_t j = j_begin; j <= L; ++j){
+            auto best_s = -std::numeric_limits<double>::infinity();
+            for(size_t i = k; i < j; ++i){
+                const auto s = best[i] + score(i, j);
+                if(best_s < s){
+                    best_s = s;
+                    split[k][j] = i;
+                }
+            }
+            next[j] = best_s;
+        }
+        std::swap(best, next);
+    }
+
+    std::vector<size_t> out(thresholds);
+    size_t j = L;
+    for(size_t k = thresholds; 0 < k; --k){
+        j = split[k][j];
+        out[k - 1] = j;
+    }
+    return out;
+}
+
+
+// -------------------------------------------------------- tdigest --------------------------------------------------------
+tdigest::tdigest(double compression) : compression(compression) {
+    if( !std::isfinite(compression) || !(1.0 <= compression) ){
+        throw std::invalid_argument("t-digest compression must be at least one");
+    }
+}
+
+void tdigest::digest(double x, double w){
+    if(!is_valid(x, w)) return;
+    this->W += w;
+    this->lo = std::min(this->lo, x);
+    this->hi = std::max(this->hi, x);
+    this->buffer.push_back({ x, w });
+    if(static_cast<double>(this->buffer.size()) >= 5.0 * this->compression) this->compress();
+}
+
+void tdigest::merge(const tdigest &other){
+    if(other.W <= 0.0) return;
+    this->W += other.W;
+    this->lo = std::min(this->lo, other.lo);
+    this->hi = std::max(this->hi, other.hi);
+    this->buffer.insert(std::end(this->buffer), std::begin(other.centroids), std::end(other.centroids));
+    this->buffer.insert(std::end(this->buffer), std::begin(other.buffer), std::end(other.buffer));
+    if(static_cast<double>(this->buffer.size()) >= 5.0 * this->compression) this->compress();
+}
+
+double tdigest::total_weight() const {
+    return this->W;
+}
+
+size_t tdigest::centroid_count() const {
+    return this->compressed().size();
+}
+
+void tdigest::compress(){
+    this->centroids = this->compressed();
+    this->buffer.clear();
+}
+
+std::vector<tdigest::centroid_t> tdigest::compressed() const {
+    if(this->buffer.empty()) return this->centroids;
+
+    std::vector<centroid_t> all;
+    all.reserve(this->centroids.size() + this->buffer.size());
+    all.insert(std::end(all), std::begin(this->centroids), std::end(this->centroids));
+    all.insert(std::end(all), std::begin(this->buffer), std::end(this->buffer));
+    std::stable_sort(std::begin(all), std::end(all), [](const centroid_t &L, const centroid_t &R) -> bool {
+        return L.mean < R.mean;
+    });
+
+    // The k1 scale function, k(q) = (compression/(2*pi))*asin(2q-1), limits each centroid to a unit span of k.
+    const auto delta = this->compression;
+    const auto k_max = delta / 4.0;
+    const auto q_limit = [&](double q0) -> double {
+        const auto k0 = (delta / (2.0 * pi)) * std::asin(std::clamp(2.0 * q0 - 1.0, -1.0, 1.0));
+        const auto k1 = k0 + 1.0;
+        if(k_max <= k1) return 1.0;
+        return (std::sin(2.0 * pi * k1 / delta) + 1.0) * 0.5;
+    };
+
+    std::vector<centroid_t> out;
+    out.reserve(static_cast<size_t>(delta));
+    out.push_back(all.front());
+    double w_before = 0.0; // Weight of all centroids before the one being built.
+    double limit = q_limit(0.0);
+    for(size_t i = 1; i < all.size(); ++i){
+        const auto &c = all[i];
+        auto &b = out.back();
+        const auto q = (w_before + b.weight + c.weight) / this->W;
+        if(q <= limit){
+            b.weight += c.weight;
+            b.mean += (c.mean - b.mean) * (c.weight / b.weight);
+        }else{
+            w_before += b.weight;
+            limit = q_limit(w_before / this->W);
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+// Both estimators treat the distribution as piecewise-linear through the extrema and the centroids, with each centroid
+// placed at the middle of its cumulative weight.
+double tdigest::quantile(double q) const {
+    if(this->W <= 0.0) return std::numeric_limits<double>::quiet_NaN();
+    if(q <= 0.0) return this->lo;
+    if(1.0 <= q) return this->hi;
+
+    const auto cs = this->compressed();
+    const auto target = q * this->W;
+
+    double prev_cum = 0.0;
+    double prev_val = this->lo;
+    double cum = 0.0;
+    for(const auto &c : cs){
+        const auto centre = cum + c.weight * 0.5;
+        if(target <= centre){
+            const auto span = centre - prev_cum;
+            const auto t = (0.0 < span) ? (target - prev_cum) / span : 1.0;
+            return prev_val + t * (c.mean - prev_val);
+        }
+        prev_cum = centre;
+        prev_val = c.mean;
+        cum += c.weight;
+    }
+    const auto span = this->W - prev_cum;
+    const auto t = (0.0 < span) ? (target - prev_cum) / span : 1.0;
+    return prev_val + t * (this->hi - prev_val);
+}
+
+double tdigest::cdf(double x) const {
+    if(this->W <= 0.0) return std::numeric_limits<double>::quiet_NaN();
+    if(x < this->lo) return 0.0;
+    if(this->hi <= x) return 1.0;
+
+    const auto cs = this->compressed();
+    std::vector<std::pair<double,double>> knots; // (value, cumulative weight).
+    knots.reserve(cs.size() + 2);
+    knots.emplace_back(this->lo, 0.0);
+    double cum = 0.0;
+    for(const auto &c : cs){
+        knots.emplace_back(c.mean, cum + c.weight * 0.5);
+        cum += c.weight;
+    }
+    knots.emplace_back(this->hi, this->W);
+
+    // Find the last knot at or below x. The final knot is above x, so a successor always exists.
+    auto it = std::upper_bound(std::begin(knots), std::end(knots), x,
+                               [](double v, const std::pair<double,double> &k){ return v < k.first; });
+    const auto &R = *it;
+    const auto &L = *std::prev(it);
+    const auto span = R.first - L.first;
+    const auto t = (0.0 < span) ? (x - L.first) / span : 0.0;
+    return (L.second + t * (R.second - L.second)) / this->W;
+}
+
+
+// -------------------------------------------------- distribution_sketch --------------------------------------------------
+void distribution_sketch::digest(double x, double w){
+    this->moments.digest(x, w);
+    this->quantiles.digest(x, w);
+}
+
+void distribution_sketch::merge(const distribution_sketch &other){
+    this->moments.merge(other.moments);
+    this->quantiles.merge(other.quantiles);
+}
+
+
+
+template <class T>
+sorted_quantiles<T>::sorted_quantiles(std::vector<T> values) : sorted(std::move(values)) {
+    this->sorted.erase( std::remove_if(std::begin(this->sorted), std::end(this->sorted),
+                                       [](T x){ return std::isnan(x); }),
+                        std::end(this->sorted) );
+    std::sort(std::begin(this->sorted), std::end(this->sorted));
+}
+
+template <class T>
+size_t sorted_quantiles<T>::size() const {
+    return this->sorted.size();
+}
+
+template <class T>
+bool sorted_quantiles<T>::empty() const {
+    return this->sorted.empty();
+}
+
+template <class T>
+T sorted_quantiles<T>::quantile(double q) const {
+    if(!std::isfinite(q) || (q < 0.0) || (1.0 < q)){
+        throw std::invalid_argument("Quantiles must be within [0:1].");
+    }
+    const auto N = this->sorted.size();
+    if(N == 0) return std::numeric_limits<T>::quiet_NaN();
+
+    const double pos = q * static_cast<double>(N - 1);
+    const auto k = std::min(static_cast<size_t>(std::floor(pos)), N - 1);
+    const double t = pos - static_cast<double>(k);
+    const auto lo = static_cast<double>(this->sorted[k]);
+    if( (t <= 0.0) || ((k + 1) == N) ) return this->sorted[k];
+    const auto hi = static_cast<double>(this->sorted[k + 1]);
+    return static_cast<T>(lo + t * (hi - lo));
+}
+
+template <class T>
+std::vector<T> sorted_quantiles<T>::quantiles(const std::vector<double> &qs) const {
+    std::vector<T> out;
+    out.reserve(qs.size());
+    for(const auto &q : qs) out.push_back(this->quantile(q));
+    return out;
+}
+
+template <class T>
+const std::vector<T> &sorted_quantiles<T>::values() const {
+    return this->sorted;
+}
+
+template class sorted_quantiles<float>;
+template class sorted_quantiles<double>;
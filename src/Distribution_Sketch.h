@@ -0,0 +1,146 @@
+//Distribution_Sketch.h.
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+
+// Streaming, mergeable summaries of (optionally weighted) scalar distributions.
+//
+// Each summary uses bounded memory regardless of how many values are digested, and summaries built independently
+// (e.g., one per thread or per image) can be merged afterward. Merging summaries in a fixed order produces the same
+// result regardless of how the work was scheduled. Non-finite values and non-positive weights are ignored.
+
+
+// Exact count, weight, mean, variance, and extrema. Weights are treated as frequencies.
+class running_moments {
+  public:
+    void digest(double x, double w = 1.0);
+    void merge(const running_moments &other);
+
+    size_t count() const;          // Number of values digested.
+    double total_weight() const;
+    double min() const;            // NaN if empty.
+    double max() const;            // NaN if empty.
+    double mean() const;           // NaN if empty.
+    double unbiased_variance() const; // NaN if fewer than two values.
+
+  private:
+    size_t N = 0;
+    double W = 0.0;
+    double m = 0.0;
+    double M2 = 0.0;
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -std::numeric_limits<double>::infinity();
+};
+
+
+// Histogram with a fixed number of equal-width bins. Values outside the bins are clamped into the first or last bin.
+class fixed_bin_histogram {
+  public:
+    fixed_bin_histogram(double lower, double bin_width, size_t bin_count);
+
+    // Returns a histogram with the same bin layout, but no weight.
+    fixed_bin_histogram empty_copy() const;
+
+    void digest(double x, double w = 1.0);
+
+    // Throws if the bin layouts differ.
+    void merge(const fixed_bin_histogram &other);
+
+    size_t size() const;
+    double bin_width() const;
+    double bin_lower(size_t i) const;
+    double bin_centre(size_t i) const;
+    double bin_weight(size_t i) const;
+
+  private:
+    double lower;
+    double width;
+    std::vector<double> weights;
+};
+
+// Multi-level Otsu thresholding. Partitions the bins into (thresholds + 1) contiguous classes such that the
+// between-class variance of the bin centres is maximal, and returns the index of the first bin of every class but the
+// first, in ascending order. Ties favour lower thresholds. Classes are found by dynamic programming over prefix sums of
+// the bin weights and moments, which costs O(L) for a single threshold and O(thresholds * L^2) otherwise, where L is
+// the number of bins. Throws if there are fewer bins than classes.
+std::vector<size_t> Otsu_Threshold_Bins(const fixed_bin_histogram &hist, size_t thresholds = 1);
+
+
+// Merging t-digest (Dunning, 2019) for estimating quantiles. Values are buffered and periodically compressed into at
+// most a few times 'compression' centroids, which are smallest near the tails, so extreme quantiles are estimated
+// most accurately. Extrema are tracked exactly.
+class tdigest {
+  public:
+    explicit tdigest(double compression = 200.0);
+
+    void digest(double x, double w = 1.0);
+    void merge(const tdigest &other);
+
+    double total_weight() const;
+
+    // Estimated value at the given quantile (in [0,1]). NaN if empty.
+    double quantile(double q) const;
+
+    // Estimated fraction of the weight at or below x. NaN if empty.
+    double cdf(double x) const;
+
+    // Number of centroids retained (after compression).
+    size_t centroid_count() const;
+
+  private:
+    struct centroid_t {
+        double mean;
+        double weight;
+    };
+
+    double compression;
+    double W = 0.0;
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -std::numeric_limits<double>::infinity();
+    std::vector<centroid_t> centroids; // Compressed, ordered by mean.
+    std::vector<centroid_t> buffer;    // Not yet compressed.
+
+    void compress();
+    std::vector<centroid_t> compressed() const;
+};
+
+
+// The combination of the above that suits most uses: exact moments and extrema along with quantile estimates.
+struct distribution_sketch {
+    running_moments moments;
+    tdigest quantiles;
+
+    void digest(double x, double w = 1.0);
+    void merge(const distribution_sketch &other);
+};
+
+
+
+// Exact quantiles of a fixed collection of values, for answering several queries about the same values. The values
+// are sorted once, after which each query is a constant-time lookup. Quantiles are interpolated linearly between order
+// statistics (as in Dose_Quantiles()), so the 0.5 quantile is the conventional median. NaNs are ignored.
+//
+// When only one or two quantiles are needed from a large collection, selection (e.g., Dose_Quantiles()) is cheaper.
+template <class T>
+class sorted_quantiles {
+  public:
+    sorted_quantiles() = default;
+    explicit sorted_quantiles(std::vector<T> values); // Pass an rvalue to avoid a copy.
+
+    size_t size() const;
+    bool empty() const;
+
+    // The value at the given quantile, which must be in [0,1]. NaN if empty.
+    T quantile(double q) const;
+
+    std::vector<T> quantiles(const std::vector<double> &qs) const;
+
+    const std::vector<T> &values() const; // In ascending order.
+
+  private:
+    std::vector<T> sorted;
+};
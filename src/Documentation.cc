@@ -621,7 +621,7 @@ void Emit_Documentation(std::ostream &os){
     );
 
     // Print an index of links to each operation.
-    auto known_ops = Known_Operations();
+    const auto &known_ops = Cached_Known_Operations();
     {
         for(auto &anop : known_ops){
             const auto name = anop.first;
@@ -634,13 +634,13 @@ void Emit_Documentation(std::ostream &os){
     reflow_and_emit_paragraph(os, max_width, nobullet, nobullet, nolinebreak,
         "# Operations Reference"
     );
-    for(auto &anop : known_ops){
+    for(const auto &anop : known_ops){
         const auto name = anop.first;
 
         reflow_and_emit_paragraph(os, max_width, nobullet, nobullet, nolinebreak,
             "## "_s + name
         );
-        auto optdocs = anop.second.first();
+        const auto &optdocs = Known_Operation_Documentation(name);
         reflow_and_emit_paragraph(os, max_width, nobullet, nobullet, nolinebreak,
             "### Description"
         );
@@ -12,16 +12,23 @@
 // computing the min/max dose).
 //
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <list>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 //#include <cstdint>   //For int64_t.
 //#include <utility>   //For std::pair.
-//#include <algorithm> //std::min_element/max_element.
 //#include <tuple>
 
 #include "Structs.h"
 #include "Regex_Selectors.h"
+#include "Separable_Resampling.h"
+#include "Paged_Images.h"
+#include "Thread_Pool.h"
 
 #include "Dose_Meld.h"
 
@@ -110,33 +117,24 @@ std::list<std::shared_ptr<Image_Array>>  Meld_Image_Data(const std::list<std::sh
     if(out.size() == 0) return out;
     if(out.size() == 1) return out;
 
-    auto d2_it = out.begin(); //Note: d*_it are ~ std::list<std::shared_ptr<Image_Array>>::iterator
-    auto d1_it = --(out.end());
-    while((d1_it != out.end()) && (d2_it != out.end()) && (d1_it != d2_it)){
-        //If the geometry is the same, we can easily meld the data. Do so and erase the superfluous data.
-        if((*d1_it)->imagecoll.Spatially_eq((*d2_it)->imagecoll)){
-            FUNCINFO("Image images are spatially equal. Performing the equivalent-geometry meld routine");
-
-            //Put the melded data into the first position.
-            *d1_it = Meld_Equal_Geom_Image_Data(*d1_it, *d2_it);
-            d2_it = out.erase(d2_it);
-            continue;
-
-        //If the geometry is not the same, we have to further investigate whether we can handle it or not. 
-        }else{
-            FUNCINFO("Image images are not spatially equal. Performing the nonequivalent-geometry meld routine");
-
-            *d1_it = Meld_Unequal_Geom_Image_Data(*d1_it, *d2_it);
-            if(*d1_it != nullptr){
-                d2_it = out.erase(d2_it);
-                continue;
-            }else{
-                FUNCERR("Unable to meld nonequivalent-geometry images");
-            }
-        }
+    //If the geometry is the same, we can easily meld the data without resampling.
+    const bool all_spatially_eq = std::all_of(std::next(out.begin()), out.end(), [&](const auto &dap){
+        return dap->imagecoll.Spatially_eq(out.front()->imagecoll);
+    });
+    if(all_spatially_eq){
+        FUNCINFO("Image images are spatially equal. Performing the equivalent-geometry meld routine");
+        std::shared_ptr<Image_Array> melded = Meld_Equal_Geom_Image_Data(out);
+        return { melded };
     }
-  
-    return out;
+
+    //Otherwise all data are resampled onto a common grid at once, which avoids compounding the resampling error.
+    FUNCINFO("Image images are not spatially equal. Performing the nonequivalent-geometry meld routine");
+    for(auto &dap : out) dap->page_in();
+    std::shared_ptr<Image_Array> melded = Meld_Unequal_Geom_Image_Data(out);
+    if(melded == nullptr){
+        FUNCERR("Unable to meld nonequivalent-geometry images");
+    }
+    return { melded };
 }
 
 std::unique_ptr<Image_Array> Meld_Equal_Geom_Image_Data(const std::shared_ptr<Image_Array>& A, const std::shared_ptr<Image_Array>& B){
@@ -177,6 +175,49 @@ std::unique_ptr<Image_Array> Meld_Equal_Geom_Image_Data(const std::shared_ptr<Im
     return out;
 }
 
+std::unique_ptr<Image_Array> Meld_Equal_Geom_Image_Data(const std::list<std::shared_ptr<Image_Array>> &dalist){
+    if(dalist.empty()) return nullptr;
+
+    auto out = std::make_unique<Image_Array>();
+    *out = *(dalist.front()); //Performs a deep copy, which is fully resident.
+
+    std::vector<planar_image<float,double> *> out_imgs;
+    for(auto &img : out->imagecoll.images) out_imgs.push_back( std::addressof(img) );
+
+    //Every input is accumulated onto each output image in turn. Paged-out inputs are accumulated through their store.
+    struct source_t {
+        std::shared_ptr<paged_image_store> store;
+        std::vector<const planar_image<float,double> *> imgs;
+    };
+    std::vector<source_t> sources;
+    for(auto d_it = std::next(dalist.begin()); d_it != dalist.end(); ++d_it){
+        sources.emplace_back();
+        sources.back().store = (*d_it)->get_page_store();
+        for(const auto &img : (*d_it)->imagecoll.images) sources.back().imgs.push_back( std::addressof(img) );
+        if(sources.back().imgs.size() != out_imgs.size()){
+            throw std::invalid_argument("Image arrays have differing numbers of images. Cannot meld.");
+        }
+    }
+
+    parallel_for(0, static_cast<long int>(out_imgs.size()), [&](long int i){
+        auto &img = *(out_imgs[i]);
+        for(const auto &src : sources){
+            if(src.store != nullptr){
+                src.store->accumulate_pixels(static_cast<size_t>(i), 1.0f, img);
+                continue;
+            }
+            const auto &data = src.imgs[i]->data;
+            if(data.size() != img.data.size()){
+                throw std::invalid_argument("Images have different dimensions. Cannot meld.");
+            }
+            for(size_t k = 0; k < data.size(); ++k) img.data[k] += data[k];
+        }
+        img.metadata["Description"] = "Equal-geometry dose melded.";
+    }, 1);
+
+    return out;
+}
+
 /*
 //A typical case where dose data collections do *not* have the same geometry.
 
@@ -196,95 +237,163 @@ std::unique_ptr<Image_Array> Meld_Equal_Geom_Image_Data(const std::shared_ptr<Im
 --(E) In function: Bounded_Image_General: This function cannot handle data sets with multiple, distinctly-shaped dose data. Terminating program.
 */
 
+namespace {
+
+// Accumulates the (trilinearly interpolated) values of an image array onto an image. Voxels outside the array are not
+// affected.
+//
+// When the image's rows and columns are aligned with those of the array, the two nearest slices of the array are
+// resampled with separable weights and interpolated linearly between. Otherwise the nearest voxel of the nearest slice
+// is used.
+void accumulate_onto(const std::vector<const planar_image<float,double> *> &in_imgs,
+                     const std::vector<plane<double>> &in_planes,
+                     const planar_image<float,double> &out_img,
+                     std::vector<std::vector<float>> &acc){
+    const auto rows = out_img.rows;
+    const auto columns = out_img.columns;
+    const auto channels = out_img.channels;
+
+    //Identify the nearest slices on either side of the image.
+    const auto pos = out_img.position(0, 0);
+    const planar_image<float,double> *lower = nullptr;
+    const planar_image<float,double> *upper = nullptr;
+    auto lower_dist = std::numeric_limits<double>::infinity();
+    auto upper_dist = std::numeric_limits<double>::infinity();
+    for(size_t i = 0; i < in_imgs.size(); ++i){
+        const auto signed_dist = in_planes[i].Get_Signed_Distance_To_Point(pos);
+        const auto dist = std::abs(signed_dist);
+        if((0.0 <= signed_dist) && (dist < lower_dist)){
+            lower_dist = dist;
+            lower = in_imgs[i];
+        }else if((signed_dist < 0.0) && (dist < upper_dist)){
+            upper_dist = dist;
+            upper = in_imgs[i];
+        }
+    }
+
+    //Weight the slices. Beyond the outermost slices, only the slice thickness is covered.
+    std::vector<std::pair<const planar_image<float,double> *, double>> slices;
+    if((lower != nullptr) && (upper != nullptr)){
+        const auto total_dist = lower_dist + upper_dist;
+        slices.emplace_back(lower, upper_dist / total_dist);
+        slices.emplace_back(upper, lower_dist / total_dist);
+    }else if((lower != nullptr) && (lower_dist <= 0.5 * lower->pxl_dz)){
+        slices.emplace_back(lower, 1.0);
+    }else if((upper != nullptr) && (upper_dist <= 0.5 * upper->pxl_dz)){
+        slices.emplace_back(upper, 1.0);
+    }
+    if(slices.empty()) return;
+
+    const bool aligned = std::all_of(slices.begin(), slices.end(), [&](const auto &s){
+        return Aligned_Sample_Positions(*(s.first), out_img).has_value();
+    });
+    if(aligned){
+        for(const auto &s : slices){
+            if(s.second == 0.0) continue;
+            const auto w = static_cast<float>(s.second);
+            const auto sample_pos = Aligned_Sample_Positions(*(s.first), out_img).value();
+            const auto row_w = Compute_Resampling_Weights(s.first->rows, sample_pos.first, resampling_kernel::linear);
+            const auto col_w = Compute_Resampling_Weights(s.first->columns, sample_pos.second, resampling_kernel::linear);
+            for(long int l = 0; l < std::min(channels, s.first->channels); ++l){
+                const auto vals = Resample_Image_Channel(*(s.first), l, row_w, col_w, 0.0f);
+                auto &a = acc[l];
+                for(size_t i = 0; i < a.size(); ++i) a[i] += w * vals[i];
+            }
+        }
+
+    }else{
+        const auto nearest = (slices.size() == 1) ? slices.front().first
+                                                  : ((lower_dist <= upper_dist) ? lower : upper);
+        for(long int r = 0; r < rows; ++r){
+            for(long int c = 0; c < columns; ++c){
+                const auto p = out_img.position(r,c);
+                for(long int l = 0; l < std::min(channels, nearest->channels); ++l){
+                    //If out of bounds, we will get a safe zero.
+                    const auto index = nearest->index(p,l);
+                    if(index != -1){
+                        acc[l][r * columns + c] += nearest->value(index);
+                    }
+                }
+            }
+        }
+    }
+    return;
+}
+
+} // namespace
+
 //Returns a nullptr on failure to meld. This is a fairly risky operation, so be weary of the data coming
 // from this function.
 std::unique_ptr<Image_Array> Meld_Unequal_Geom_Image_Data(std::shared_ptr<Image_Array> A, const std::shared_ptr<Image_Array>& B){
-    auto out = std::make_unique<Image_Array>();
-
-    //Determine whether or not we can meld the data. Currently we can only handle the case where
-    // a) all images in each set are same # of rows and columns as the others of the (same) set,
-    // b) one set is larger/encompasses the other set (ie. one is larger),
+    return Meld_Unequal_Geom_Image_Data( std::list<std::shared_ptr<Image_Array>>{ A, B } );
+}
 
+//Returns a nullptr on failure to meld. All data are resampled onto the grid of the largest array, which must be a
+// stack of parallel images, and summed. Each output image is processed independently in parallel and visits every
+// input once.
+std::unique_ptr<Image_Array> Meld_Unequal_Geom_Image_Data(const std::list<std::shared_ptr<Image_Array>> &dalist){
     //------------------------------ Data verification/suitability inspection ------------------------------
-    if(A->imagecoll.images.empty() || B->imagecoll.images.empty()){
+    if(dalist.empty()){
         return nullptr;
     }
-
-    for(auto i1_it = A->imagecoll.images.begin(), i2_it = --(A->imagecoll.images.begin());
-                (i1_it != A->imagecoll.images.end()) && (i2_it != A->imagecoll.images.end());    ){
-        if( (i1_it->channels != i2_it->channels)
-                || ((i1_it->rows > i2_it->rows) && (i1_it->columns < i2_it->columns)) //One is larger than the other.
-                || ((i1_it->rows < i2_it->rows) && (i1_it->columns > i2_it->columns))  ){
-            FUNCWARN("Unable to meld - one data set (A) is not self-consistent");
+    for(const auto &dap : dalist){
+        if((dap == nullptr) || dap->imagecoll.images.empty()){
             return nullptr;
         }
     }
 
-    for(auto i1_it = B->imagecoll.images.begin(), i2_it = --(B->imagecoll.images.begin());
-                (i1_it != B->imagecoll.images.end()) && (i2_it != B->imagecoll.images.end());    ){
-        if( (i1_it->channels != i2_it->channels)
-                || ((i1_it->rows > i2_it->rows) && (i1_it->columns < i2_it->columns)) //One is larger than the other.
-                || ((i1_it->rows < i2_it->rows) && (i1_it->columns > i2_it->columns))  ){
-            FUNCWARN("Unable to meld - one data set (B) is not self-consistent");
-            return nullptr;
+    //------------------------------------- Preparation for melding ----------------------------------------
+
+    //Get the largest of the images.
+    std::shared_ptr<Image_Array> larger = dalist.front();
+    for(const auto &dap : dalist){
+        if( dap->imagecoll.volume() > larger->imagecoll.volume() ){
+            larger = dap;
         }
     }
 
+    auto out = std::make_unique<Image_Array>();
+    *out = *larger; //Make a deep copy of the data.
 
-    //------------------------------------- Preparation for melding ----------------------------------------
+    struct source_t {
+        std::vector<const planar_image<float,double> *> imgs;
+        std::vector<plane<double>> planes;
+    };
+    std::vector<source_t> sources;
+    for(const auto &dap : dalist){
+        sources.emplace_back();
+        for(const auto &img : dap->imagecoll.images){
+            sources.back().imgs.push_back( std::addressof(img) );
+            sources.back().planes.push_back( img.image_plane() );
+        }
+    }
 
-    //Get the larger of the two images.
-    decltype(A) larger = B;
-    if( A->imagecoll.volume() >= B->imagecoll.volume() ){
-        larger = A;
+    std::vector<planar_image<float,double> *> out_imgs;
+    for(auto &img : out->imagecoll.images){
+        out_imgs.push_back( std::addressof(img) );
     }
 
-    *out = *larger; //Make a deep copy of the data.
+    //Now cycle through the output images, collecting the dose contributions from all inputs.
+    parallel_for(0, static_cast<long int>(out_imgs.size()), [&](long int i){
+        auto &img = *(out_imgs[i]);
+        const auto rows     = img.rows;
+        const auto columns  = img.columns;
+        const auto channels = img.channels;
 
-    //Now cycle through the voxel data, collecting the dose contributions from either A or B. 
-    auto i0_it = out->imagecoll.images.begin();
-    auto i1_it = A->imagecoll.images.begin();
-    auto i2_it = B->imagecoll.images.begin();
-    for(   ;    (i0_it != out->imagecoll.images.end())
-             && (i1_it !=   A->imagecoll.images.end())
-             && (i2_it !=   B->imagecoll.images.end()); ++i0_it, ++i1_it, ++i2_it){
+        std::vector<std::vector<float>> acc(channels, std::vector<float>(rows * columns, 0.0f));
+        for(const auto &src : sources){
+            accumulate_onto(src.imgs, src.planes, img, acc);
+        }
 
-        const auto rows     = i0_it->rows;
-        const auto columns  = i0_it->columns;
-        const auto channels = i0_it->channels;
         for(long int r = 0; r < rows; ++r){
             for(long int c = 0; c < columns; ++c){
                 for(long int l = 0; l < channels; ++l){
-                    //Clear the value in the channel.
-                    const auto zero = static_cast<decltype(i0_it->value(r,c,l))>(0);
-                    i0_it->reference(r,c,l) = zero;
-
-                    //Get the (floating-point) dose from each image. If out of bounds, we will 
-                    // get a safe zero. 
-                    const auto pos = i0_it->position(r,c);
-                    auto dose_sum = zero;
-
-                    const auto indexA = i1_it->index(pos,l);
-                    if(indexA != -1){
-                        dose_sum += i1_it->value(indexA);
-                    }
-
-                    const auto indexB = i2_it->index(pos,l);
-                    if(indexB != -1){
-                        dose_sum += i2_it->value(indexB);
-                    }
-
-                    //Set the new value.
-                    i0_it->reference(r,c,l) = dose_sum;
+                    img.reference(r,c,l) = acc[l][r * columns + c];
                 }
             }
         }
-    }
-
-    for(auto &img : out->imagecoll.images){
         img.metadata["Description"] = "Unequal-geometry dose melded.";
-    }
+    }, 1);
 
     return out;
 }
-
@@ -26,9 +26,18 @@ Meld_Image_Data(const std::list<std::shared_ptr<Image_Array>> &dalist);
 std::unique_ptr<Image_Array>
 Meld_Equal_Geom_Image_Data(const std::shared_ptr<Image_Array>& A, const std::shared_ptr<Image_Array>& B);
 
+//Sums any number of arrays with identical geometry in a single pass. Arrays may be paged out (see PageOutImages); sparse
+// arrays are summed without being paged in.
+std::unique_ptr<Image_Array>
+Meld_Equal_Geom_Image_Data(const std::list<std::shared_ptr<Image_Array>> &dalist);
+
 //Resamples dose data AND the smaller of the dose data grids onto the larger. Is a lossy operation.
 std::unique_ptr<Image_Array>
 Meld_Unequal_Geom_Image_Data(std::shared_ptr<Image_Array> A, const std::shared_ptr<Image_Array>& B);
 
+//Resamples all dose data onto the largest of the dose data grids and sums them in a single pass. Is a lossy operation.
+std::unique_ptr<Image_Array>
+Meld_Unequal_Geom_Image_Data(const std::list<std::shared_ptr<Image_Array>> &dalist);
+
 #endif
 
@@ -0,0 +1,274 @@
+//Drover_Memory.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
+#include "Structs.h"
+#include "Alignment_Field.h"
+#include "Alignment_TPSRPM.h"
+#include "Paged_Images.h"
+
+#include "Drover_Memory.h"
+
+
+namespace {
+
+// Rough per-node overheads of node-based containers (i.e., links and allocator bookkeeping).
+constexpr uint64_t list_node_overhead = 2 * sizeof(void *) + 16;
+constexpr uint64_t map_node_overhead = 4 * sizeof(void *) + 16;
+
+uint64_t Metadata_Bytes(const std::map<std::string, std::string> &metadata){
+    uint64_t out = 0;
+    for(const auto &p : metadata){
+        out += map_node_overhead + 2 * sizeof(std::string) + p.first.capacity() + p.second.capacity();
+    }
+    return out;
+}
+
+uint64_t Attribute_Bytes(const attribute_columns &attrs){
+    uint64_t out = 0;
+    for(const auto &c : attrs.columns){
+        out += map_node_overhead + sizeof(c) + c.first.capacity();
+        std::visit([&](const auto &v){
+            out += v.capacity() * sizeof(typename std::decay_t<decltype(v)>::value_type);
+        }, c.second);
+    }
+    return out;
+}
+
+template <class T>
+uint64_t Nested_Vector_Bytes(const std::vector<std::vector<T>> &v){
+    uint64_t out = v.capacity() * sizeof(std::vector<T>);
+    for(const auto &e : v) out += e.capacity() * sizeof(T);
+    return out;
+}
+
+} // namespace
+
+
+uint64_t drover_memory_usage::total() const {
+    return this->image_voxels
+         + this->compact_image_voxels
+         + this->image_metadata
+         + this->contours
+         + this->meshes
+         + this->point_clouds
+         + this->other;
+}
+
+
+uint64_t Resident_Image_Voxel_Bytes(const Image_Array &ia){
+    uint64_t out = 0;
+    for(const auto &img : ia.imagecoll.images) out += img.data.capacity() * sizeof(float);
+    return out;
+}
+
+
+drover_memory_usage Account_Drover_Memory(const Drover &DICOM_data){
+    drover_memory_usage u;
+
+    for(const auto &ia : DICOM_data.image_data){
+        if(ia == nullptr) continue;
+        const auto store = ia->get_page_store();
+        const bool compact = (store != nullptr) && (store->get_storage() != voxel_storage::float32);
+        if(compact) u.compact_image_voxels += store->compact_bytes();
+
+        for(const auto &img : ia->imagecoll.images){
+            const auto resident = static_cast<uint64_t>(img.data.capacity());
+            const auto expected = static_cast<uint64_t>(std::max<long int>(0, img.rows))
+                                * static_cast<uint64_t>(std::max<long int>(0, img.columns))
+                                * static_cast<uint64_t>(std::max<long int>(0, img.channels));
+            u.image_voxels += resident * sizeof(float);
+            if(!compact && (resident < expected)) u.paged_image_voxels += (expected - resident) * sizeof(float);
+            u.image_metadata += list_node_overhead + sizeof(img) + Metadata_Bytes(img.metadata);
+        }
+    }
+
+    if(DICOM_data.contour_data != nullptr){
+        for(const auto &cc : DICOM_data.contour_data->ccs){
+            u.contours += list_node_overhead + sizeof(cc);
+            for(const auto &c : cc.contours){
+                u.contours += list_node_overhead + sizeof(c) + Metadata_Bytes(c.metadata)
+                            + c.points.size() * (list_node_overhead + sizeof(vec3<double>));
+            }
+        }
+    }
+
+    for(const auto &sm : DICOM_data.smesh_data){
+        if(sm == nullptr) continue;
+        u.meshes += sizeof(*sm)
+                  + sm->meshes.vertices.capacity() * sizeof(vec3<double>)
+                  + Nested_Vector_Bytes(sm->meshes.faces)
+                  + Nested_Vector_Bytes(sm->meshes.involved_faces)
+                  + Metadata_Bytes(sm->meshes.metadata)
+                  + Attribute_Bytes(sm->vertex_attributes)
+                  + Attribute_Bytes(sm->face_attributes);
+    }
+
+    for(const auto &pc : DICOM_data.point_data){
+        if(pc == nullptr) continue;
+        u.point_clouds += sizeof(*pc)
+                        + pc->pset.points.capacity() * sizeof(vec3<double>)
+                        + Metadata_Bytes(pc->pset.metadata)
+                        + Attribute_Bytes(pc->point_attributes);
+    }
+
+    for(const auto &ls : DICOM_data.lsamp_data){
+        if(ls == nullptr) continue;
+        u.other += sizeof(*ls)
+                 + ls->line.samples.size() * sizeof(std::array<double, 4>)
+                 + Metadata_Bytes(ls->line.metadata);
+    }
+
+    for(const auto &tp : DICOM_data.tplan_data){
+        if(tp == nullptr) continue;
+        u.other += sizeof(*tp) + Metadata_Bytes(tp->metadata);
+        for(const auto &ds : tp->dynamic_states){
+            u.other += sizeof(ds) + Metadata_Bytes(ds.metadata)
+                     + ds.static_states.capacity() * sizeof(Static_Machine_State);
+        }
+    }
+
+    for(const auto &t : DICOM_data.trans_data){
+        if(t == nullptr) continue;
+        u.other += sizeof(*t) + Metadata_Bytes(t->metadata);
+        if(const auto *tps = std::get_if<thin_plate_spline>(&(t->transform))){
+            u.other += tps->control_points.points.capacity() * sizeof(vec3<double>)
+                     + static_cast<uint64_t>(tps->W_A.num_rows() * tps->W_A.num_cols()) * sizeof(double);
+        }else if(const auto *df = std::get_if<deformation_field>(&(t->transform))){
+            for(const auto &c : df->displacements) u.other += c.capacity() * sizeof(float);
+        }
+    }
+
+    return u;
+}
+
+
+//------------------------------------------------- Memory budget -------------------------------------------------
+namespace {
+
+struct memory_budget_state {
+    std::mutex m;
+    uint64_t budget = 0; // Disabled when zero.
+    std::string scratch_dir;
+
+    // Last-use stamps for image arrays. Expired entries are pruned during enforcement.
+    uint64_t clock = 0;
+    std::map<std::weak_ptr<Image_Array>, uint64_t, std::owner_less<std::weak_ptr<Image_Array>>> last_use;
+
+    memory_budget_state(){
+        if(const char *v = std::getenv("DCMA_MEMORY_BUDGET_MB"); (v != nullptr) && (*v != '\0')){
+            try{
+                const auto mb = std::stod(v);
+                if(!(0.0 <= mb)) throw std::invalid_argument("negative");
+                this->budget = static_cast<uint64_t>(mb * 1024.0 * 1024.0);
+            }catch(const std::exception &){
+                FUNCWARN("Ignoring invalid value '" << v << "' for DCMA_MEMORY_BUDGET_MB");
+            }
+        }
+    }
+};
+
+memory_budget_state & Budget_State(){
+    static memory_budget_state s;
+    return s;
+}
+
+} // namespace
+
+
+void Set_Drover_Memory_Budget(uint64_t bytes, const std::string &scratch_dir){
+    auto &s = Budget_State();
+    std::lock_guard<std::mutex> lock(s.m);
+    s.budget = bytes;
+    s.scratch_dir = scratch_dir;
+    return;
+}
+
+
+uint64_t Get_Drover_Memory_Budget(){
+    auto &s = Budget_State();
+    std::lock_guard<std::mutex> lock(s.m);
+    return s.budget;
+}
+
+
+void Touch_Image_Arrays(const std::list<std::shared_ptr<Image_Array>> &ias){
+    auto &s = Budget_State();
+    std::lock_guard<std::mutex> lock(s.m);
+    if(s.budget == 0) return;
+    ++(s.clock);
+    for(const auto &ia : ias){
+        if(ia != nullptr) s.last_use[ia] = s.clock;
+    }
+    return;
+}
+
+
+long int Enforce_Drover_Memory_Budget(Drover &DICOM_data){
+    auto &s = Budget_State();
+    std::unique_lock<std::mutex> lock(s.m);
+    if(s.budget == 0) return 0;
+
+    for(auto it = std::begin(s.last_use); it != std::end(s.last_use); ){
+        it = it->first.expired() ? s.last_use.erase(it) : std::next(it);
+    }
+
+    // Arrays that have never been touched are newly created, so they are treated as the most recently used. Ties are
+    // broken by position, which favours keeping the arrays most recently appended to the Drover.
+    ++(s.clock);
+    struct candidate_t {
+        std::shared_ptr<Image_Array> ia;
+        uint64_t last_use;
+        uint64_t bytes;
+    };
+    std::vector<candidate_t> candidates;
+    for(const auto &ia : DICOM_data.image_data){
+        if(ia == nullptr) continue;
+        auto &stamp = s.last_use[ia];
+        if(stamp == 0) stamp = s.clock;
+        if(ia->get_page_store() != nullptr) continue;
+
+        const auto bytes = Resident_Image_Voxel_Bytes(*ia);
+        if(bytes != 0) candidates.push_back( candidate_t{ ia, stamp, bytes } );
+    }
+    std::stable_sort(std::begin(candidates), std::end(candidates), [](const candidate_t &l, const candidate_t &r){
+        return (l.last_use < r.last_use);
+    });
+    const auto budget = s.budget;
+    const auto scratch_dir = s.scratch_dir;
+    lock.unlock();
+
+    auto usage = Account_Drover_Memory(DICOM_data).total();
+    if(usage <= budget) return 0;
+
+    long int spilled = 0;
+    for(auto &c : candidates){
+        if(usage <= budget) break;
+        c.ia->page_out(0, scratch_dir);
+        usage -= std::min(usage, c.bytes);
+        ++spilled;
+        FUNCINFO("Memory budget exceeded; spilled " << c.ia->imagecoll.images.size() << " images ("
+                 << (c.bytes / (1024 * 1024)) << " MiB) to disk");
+    }
+    if(budget < usage){
+        FUNCWARN("Unable to honour the memory budget: " << (usage / (1024 * 1024)) << " MiB remain resident,"
+                 " exceeding the budget of " << (budget / (1024 * 1024)) << " MiB");
+    }
+    return spilled;
+}
@@ -0,0 +1,51 @@
+//Drover_Memory.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "Structs.h"
+
+
+// Approximate memory consumed by the data held by a Drover, in bytes. Container overhead is estimated, so the figures
+// are intended for monitoring and budgeting rather than exact bookkeeping. Data shared between Drovers (e.g., shallow
+// copies) is counted once for each Drover.
+struct drover_memory_usage {
+    uint64_t image_voxels = 0;       // Resident pixel data.
+    uint64_t paged_image_voxels = 0; // Pixel data held out-of-core by a page store. Not included in the total.
+    uint64_t compact_image_voxels = 0; // Paged-out pixel data held in memory with reduced precision.
+    uint64_t image_metadata = 0;     // Image metadata and geometry.
+    uint64_t contours = 0;           // Contour vertices and metadata.
+    uint64_t meshes = 0;             // Surface mesh vertices, faces, attributes, and metadata.
+    uint64_t point_clouds = 0;       // Points, normals, attributes, and metadata.
+    uint64_t other = 0;              // Line samples, treatment plans, and transforms.
+
+    uint64_t total() const; // Resident data only.
+};
+
+drover_memory_usage Account_Drover_Memory(const Drover &DICOM_data);
+
+// The resident pixel data of a single image array.
+uint64_t Resident_Image_Voxel_Bytes(const Image_Array &ia);
+
+
+// An optional, process-wide budget for the memory consumed by the Drover being processed.
+//
+// When a budget is set, the dispatcher checks the accounted memory after each top-level operation and, whenever it
+// exceeds the budget, moves the pixel data of the least-recently-used image arrays into memory-mapped scratch files
+// (see Image_Array::page_out()) until it fits. Spilled arrays are paged back in when an operation selects them. Image
+// arrays are the only data spilled, so the budget can still be exceeded by other data or by a single large operation.
+//
+// The budget can also be set via the DCMA_MEMORY_BUDGET_MB environment variable. A budget of zero disables it.
+void Set_Drover_Memory_Budget(uint64_t bytes, const std::string &scratch_dir = "");
+uint64_t Get_Drover_Memory_Budget();
+
+// Marks the image arrays as the most recently used.
+void Touch_Image_Arrays(const std::list<std::shared_ptr<Image_Array>> &ias);
+
+// Spills the least-recently-used image arrays until the budget is honoured. Returns the number of arrays spilled.
+// Arrays that are already paged out, or whose pixel data has yet to be produced, are not considered.
+long int Enforce_Drover_Memory_Budget(Drover &DICOM_data);
@@ -1,7 +1,7 @@
 //FITS_File_Loader.cc - A part of DICOMautomaton 2016. Written by hal clark.
 //
-// This program loads image data FITS files. It is basic and can only currently deal with FITS files 
-// containing a single image slice (and probably only images exported using the Ygor exporter).
+// This program loads image data FITS files. Image HDUs (including cubes) are read with the memory-mapped reader, and
+// the Ygor readers are used as a fallback.
 //
 
 #include <cmath>
@@ -24,6 +24,39 @@
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 
+#include "FITS_IO.h"
+
+namespace {
+
+//Set some default parameters if none were included in the file metadata.
+template <class T>
+void Set_Default_Geometry(planar_image<T,double> &animg){
+    if(!std::isfinite(animg.pxl_dx)
+    || !std::isfinite(animg.pxl_dy)
+    || !std::isfinite(animg.pxl_dz)
+    || (animg.pxl_dx <= 0.0)
+    || (animg.pxl_dy <= 0.0)
+    || (animg.pxl_dz <= 0.0)
+    || !std::isfinite(animg.anchor.length())
+    || !std::isfinite(animg.offset.length()) ){
+        animg.init_spatial( 1.0, 1.0, 1.0, vec3<double>(0.0, 0.0, 0.0), vec3<double>(0.0, 0.0, 0.0));
+    }
+    if(!std::isfinite(animg.row_unit.length())
+    || !std::isfinite(animg.col_unit.length())
+    || (animg.row_unit.length() < 1E-5)
+    || (animg.col_unit.length() < 1E-5)  ){
+        animg.init_orientation( vec3<double>(0.0, 1.0, 0.0), vec3<double>(1.0, 0.0, 0.0) );
+    }
+    if(!std::isfinite(animg.rows)
+    || !std::isfinite(animg.columns)
+    || !std::isfinite(animg.channels) ){
+        throw std::runtime_error("FITS file missing key image parameters. Cannot continue.");
+    }
+    return;
+}
+
+} // namespace
+
 
 bool Load_From_FITS_Files( Drover &DICOM_data,
                            std::map<std::string,std::string> & /* InvocationMetadata */,
@@ -49,32 +82,28 @@ bool Load_From_FITS_Files( Drover &DICOM_data,
         ++i;
         const auto Filename = bfit->string();
 
-        //First, try planar_images that have been exported in the expected format.
+        //First, try the memory-mapped reader, which handles standard image HDUs (including cubes).
+        try{
+            auto animgs = Read_FITS_Images(Filename);
+            for(auto &animg : animgs) Set_Default_Geometry(animg);
+
+            FUNCINFO("Loaded FITS file with " << animgs.size() << " images of dimensions "
+                     << animgs.front().rows << " x " << animgs.front().columns
+                     << " and " << animgs.front().channels << " channels");
+
+            auto &images = DICOM_data.image_data.back()->imagecoll.images;
+            images.splice( std::end(images), animgs );
+            bfit = Filenames.erase( bfit );
+            continue;
+        }catch(const std::exception &e){
+            FUNCINFO("Unable to load as FITS file with the memory-mapped reader: '" << e.what() << "'");
+        };
+
+        //Then try planar_images that have been exported in the expected format.
         try{
             auto animg = ReadFromFITS<float,double>(Filename);
 
-            //Set some default parameters if none were included in the file metadata.
-            if(!std::isfinite(animg.pxl_dx) 
-            || !std::isfinite(animg.pxl_dy)
-            || !std::isfinite(animg.pxl_dz)
-            || (animg.pxl_dx <= 0.0)
-            || (animg.pxl_dy <= 0.0) 
-            || (animg.pxl_dz <= 0.0) 
-            || !std::isfinite(animg.anchor.length())
-            || !std::isfinite(animg.offset.length()) ){
-                animg.init_spatial( 1.0, 1.0, 1.0, vec3<double>(0.0, 0.0, 0.0), vec3<double>(0.0, 0.0, 0.0));
-            }
-            if(!std::isfinite(animg.row_unit.length())
-            || !std::isfinite(animg.col_unit.length())
-            || (animg.row_unit.length() < 1E-5) 
-            || (animg.col_unit.length() < 1E-5)  ){
-                animg.init_orientation( vec3<double>(0.0, 1.0, 0.0), vec3<double>(1.0, 0.0, 0.0) );
-            }
-            if(!std::isfinite(animg.rows)
-            || !std::isfinite(animg.columns)
-            || !std::isfinite(animg.channels) ){
-                throw std::runtime_error("FITS file missing key image parameters. Cannot continue.");
-            }
+            Set_Default_Geometry(animg);
 
             FUNCINFO("Loaded FITS file with dimensions " 
                      << animg.rows << " x " << animg.columns
@@ -91,28 +120,7 @@ bool Load_From_FITS_Files( Drover &DICOM_data,
         try{
             auto animg = ReadFromFITS<uint8_t,double>(Filename);
 
-            //Set some default parameters if none were included in the file metadata.
-            if(!std::isfinite(animg.pxl_dx) 
-            || !std::isfinite(animg.pxl_dy)
-            || !std::isfinite(animg.pxl_dz)
-            || (animg.pxl_dx <= 0.0)
-            || (animg.pxl_dy <= 0.0) 
-            || (animg.pxl_dz <= 0.0) 
-            || !std::isfinite(animg.anchor.length())
-            || !std::isfinite(animg.offset.length()) ){
-                animg.init_spatial( 1.0, 1.0, 1.0, vec3<double>(0.0, 0.0, 0.0), vec3<double>(0.0, 0.0, 0.0));
-            }
-            if(!std::isfinite(animg.row_unit.length())
-            || !std::isfinite(animg.col_unit.length())
-            || (animg.row_unit.length() < 1E-5) 
-            || (animg.col_unit.length() < 1E-5)  ){
-                animg.init_orientation( vec3<double>(0.0, 1.0, 0.0), vec3<double>(1.0, 0.0, 0.0) );
-            }
-            if(!std::isfinite(animg.rows)
-            || !std::isfinite(animg.columns)
-            || !std::isfinite(animg.channels) ){
-                throw std::runtime_error("FITS file missing key image parameters. Cannot continue.");
-            }
+            Set_Default_Geometry(animg);
 
             planar_image<float,double> animg2;
             animg2.cast_from(animg);
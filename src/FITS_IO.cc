@@ -0,0 +1,480 @@
+//FITS_IO.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <list>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+
+#include "Text_Parsing.h"
+#include "Thread_Pool.h"
+#include "FITS_IO.h"
+
+
+namespace {
+
+// FITS files are a sequence of 2880 byte blocks. Headers are 80 byte 'cards' and end with an 'END' card.
+const size_t block_bytes = 2880;
+const size_t card_bytes = 80;
+
+size_t Round_Up_To_Block(size_t bytes){
+    return ((bytes + block_bytes - 1) / block_bytes) * block_bytes;
+}
+
+std::string Trim(const std::string &s){
+    const auto b = s.find_first_not_of(' ');
+    if(b == std::string::npos) return "";
+    const auto e = s.find_last_not_of(' ');
+    return s.substr(b, e - b + 1);
+}
+
+struct fits_header {
+    std::vector<std::pair<std::string, std::string>> cards; // Keyword and value. String values are unquoted.
+
+    const std::string * find(const std::string &key) const {
+        for(const auto &c : this->cards){
+            if(c.first == key) return &(c.second);
+        }
+        return nullptr;
+    }
+
+    std::optional<double> number(const std::string &key) const {
+        const auto *v = this->find(key);
+        if(v == nullptr) return {};
+
+        // Fortran-style 'D' exponents are permitted.
+        auto s = *v;
+        std::replace(std::begin(s), std::end(s), 'D', 'E');
+        double x = std::numeric_limits<double>::quiet_NaN();
+        const char *b = s.data();
+        const char *e = b + s.size();
+        if( (b == e) || (Parse_Number(b, e, x) != e) ) return {};
+        return x;
+    }
+
+    int64_t integer(const std::string &key) const {
+        const auto x = this->number(key);
+        if( !x || (std::floor(x.value()) != x.value()) ){
+            throw std::invalid_argument("FITS keyword '" + key + "' is missing or not an integer");
+        }
+        return static_cast<int64_t>(x.value());
+    }
+
+    vec3<double> vector(const std::string &key, const vec3<double> &def) const {
+        const auto x = this->number(key + "1");
+        const auto y = this->number(key + "2");
+        const auto z = this->number(key + "3");
+        return (x && y && z) ? vec3<double>(x.value(), y.value(), z.value()) : def;
+    }
+};
+
+// Parses a card's value, which begins after the '= ' indicator.
+std::string Parse_Value(const std::string &s){
+    const auto b = s.find_first_not_of(' ');
+    if(b == std::string::npos) return "";
+
+    if(s[b] == '\''){
+        // Quotes within strings are doubled. Trailing spaces are not significant.
+        std::string out;
+        for(size_t i = b + 1; i < s.size(); ++i){
+            if(s[i] == '\''){
+                if( ((i + 1) < s.size()) && (s[i + 1] == '\'') ){
+                    out.push_back('\'');
+                    ++i;
+                    continue;
+                }
+                break;
+            }
+            out.push_back(s[i]);
+        }
+        const auto e = out.find_last_not_of(' ');
+        return (e == std::string::npos) ? "" : out.substr(0, e + 1);
+    }
+
+    return Trim(s.substr(b, s.find('/', b) - b));
+}
+
+// Parses the header beginning at b, and advances b past the header.
+fits_header Parse_Header(const char *&b, const char *e){
+    fits_header h;
+    while(true){
+        if(static_cast<size_t>(e - b) < block_bytes) throw std::invalid_argument("FITS header is truncated");
+
+        bool ended = false;
+        for(size_t c = 0; (c < block_bytes) && !ended; c += card_bytes){
+            const std::string card(b + c, card_bytes);
+            const auto key = Trim(card.substr(0, 8));
+            if(key == "END"){
+                ended = true;
+            }else if(card.compare(8, 2, "= ") == 0){
+                h.cards.emplace_back(key, Parse_Value(card.substr(10)));
+            }
+            // Other cards are commentary (e.g., COMMENT and HISTORY).
+        }
+        b += block_bytes;
+        if(ended) return h;
+    }
+}
+
+// Keywords describing the layout or geometry, which are not copied into image metadata.
+const std::set<std::string> structural_keywords = {
+    "SIMPLE", "XTENSION", "EXTNAME", "BITPIX", "NAXIS", "EXTEND", "PCOUNT", "GCOUNT", "BZERO", "BSCALE", "BLANK",
+    "PXLDX", "PXLDY", "PXLDZ",
+    "ROWUNIT1", "ROWUNIT2", "ROWUNIT3", "COLUNIT1", "COLUNIT2", "COLUNIT3",
+    "ANCHOR1", "ANCHOR2", "ANCHOR3", "OFFSET1", "OFFSET2", "OFFSET3", "STACK1", "STACK2", "STACK3",
+};
+
+bool Is_Structural(const std::string &key){
+    return (structural_keywords.count(key) != 0)
+        || ( (key.rfind("NAXIS", 0) == 0) && (key.find_first_not_of("0123456789", 5) == std::string::npos) );
+}
+
+// Reads a big-endian unsigned integer. Assembling the value from bytes does not depend on the host's byte order, and
+// compilers recognize the pattern as a byte swap, which is vectorized in the loops below.
+template <class U>
+U Read_BE(const unsigned char *u){
+    U x = 0;
+    for(size_t i = 0; i < sizeof(U); ++i) x = static_cast<U>((static_cast<uint64_t>(x) << 8) | u[i]);
+    return x;
+}
+
+void Write_BE32(unsigned char *u, uint32_t x){
+    u[0] = static_cast<unsigned char>((x >> 24) & 0xFF);
+    u[1] = static_cast<unsigned char>((x >> 16) & 0xFF);
+    u[2] = static_cast<unsigned char>((x >> 8) & 0xFF);
+    u[3] = static_cast<unsigned char>(x & 0xFF);
+    return;
+}
+
+// Decodes n big-endian samples of type R (stored as unsigned type U) into out[i * stride] as zero + scale * raw.
+// Integer samples equal to blank are assigned NaN.
+template <class R, class U>
+void Decode_Plane(const char *in, size_t n, double zero, double scale, std::optional<int64_t> blank,
+                  float *out, size_t stride){
+    const auto *u = reinterpret_cast<const unsigned char *>(in);
+    const auto raw = [&](size_t i) -> R {
+        const auto bits = Read_BE<U>(u + i * sizeof(U));
+        R x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    };
+
+    // Contiguous and unscaled planes are the common case, and are kept free of per-sample branches.
+    const bool unscaled = (zero == 0.0) && (scale == 1.0);
+    if(unscaled && (stride == 1)){
+        for(size_t i = 0; i < n; ++i) out[i] = static_cast<float>(raw(i));
+    }else if(unscaled){
+        for(size_t i = 0; i < n; ++i) out[i * stride] = static_cast<float>(raw(i));
+    }else{
+        for(size_t i = 0; i < n; ++i) out[i * stride] = static_cast<float>(zero + scale * static_cast<double>(raw(i)));
+    }
+    if(blank){
+        for(size_t i = 0; i < n; ++i){
+            if(static_cast<int64_t>(raw(i)) == blank.value()) out[i * stride] = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+    return;
+}
+
+void Decode_Plane(int64_t bitpix, const char *in, size_t n, double zero, double scale, std::optional<int64_t> blank,
+                  float *out, size_t stride){
+    switch(bitpix){
+        case   8: Decode_Plane<uint8_t, uint8_t>(in, n, zero, scale, blank, out, stride); break;
+        case  16: Decode_Plane<int16_t, uint16_t>(in, n, zero, scale, blank, out, stride); break;
+        case  32: Decode_Plane<int32_t, uint32_t>(in, n, zero, scale, blank, out, stride); break;
+        case  64: Decode_Plane<int64_t, uint64_t>(in, n, zero, scale, blank, out, stride); break;
+        case -32: Decode_Plane<float, uint32_t>(in, n, zero, scale, {}, out, stride); break;
+        case -64: Decode_Plane<double, uint64_t>(in, n, zero, scale, {}, out, stride); break;
+        default: throw std::invalid_argument("FITS BITPIX not supported");
+    }
+    return;
+}
+
+std::string Format_Card(const std::string &key, const std::string &value){
+    // Fixed-format values are right-justified to column 30.
+    std::string card = key;
+    card.resize(8, ' ');
+    card += "= ";
+    if(value.size() < 20) card += std::string(20 - value.size(), ' ');
+    card += value;
+    if(card_bytes < card.size()) throw std::logic_error("FITS card is too long");
+    card.resize(card_bytes, ' ');
+    return card;
+}
+
+std::string Format_Number(double x){
+    std::ostringstream ss;
+    ss << std::uppercase << std::setprecision(17) << x;
+    return ss.str();
+}
+
+// The shape and geometry written to the HDU.
+struct fits_layout_t {
+    int64_t rows = 0;
+    int64_t columns = 0;
+    int64_t channels = 0;
+    size_t count = 0;
+    vec3<double> stack;
+};
+
+fits_layout_t Validate_Images(const fits_images_t &imgs){
+    if(imgs.empty()) throw std::invalid_argument("No images provided");
+
+    fits_layout_t l;
+    const auto &first = imgs.front().get();
+    l.rows = first.rows;
+    l.columns = first.columns;
+    l.channels = first.channels;
+    l.count = imgs.size();
+    if( (l.rows <= 0) || (l.columns <= 0) || (l.channels <= 0) ){
+        throw std::invalid_argument("Images must not be empty");
+    }
+    if(imgs.size() == 1) return l;
+
+    l.stack = imgs[1].get().offset - first.offset;
+    const auto eps = 1E-3 * std::min(first.pxl_dx, first.pxl_dy);
+    for(size_t k = 1; k < imgs.size(); ++k){
+        const auto &img = imgs[k].get();
+        if( (img.rows != l.rows) || (img.columns != l.columns) || (img.channels != l.channels) ){
+            throw std::invalid_argument("Images have differing dimensions");
+        }
+        if( !(std::abs(img.pxl_dx - first.pxl_dx) <= eps)
+        ||  !(std::abs(img.pxl_dy - first.pxl_dy) <= eps)
+        ||  !(std::abs(img.pxl_dz - first.pxl_dz) <= eps)
+        ||  !(img.row_unit.distance(first.row_unit) <= 1E-6)
+        ||  !(img.col_unit.distance(first.col_unit) <= 1E-6)
+        ||  !(img.anchor.distance(first.anchor) <= eps)
+        ||  !(img.offset.distance(first.offset + l.stack * static_cast<double>(k)) <= eps) ){
+            throw std::invalid_argument("Images do not share geometry, or are not evenly spaced");
+        }
+    }
+    return l;
+}
+
+std::string Encode_Header(const fits_images_t &imgs, const fits_layout_t &l){
+    const auto &first = imgs.front().get();
+
+    std::vector<std::string> cards;
+    cards.emplace_back(Format_Card("SIMPLE", "T"));
+    cards.emplace_back(Format_Card("BITPIX", "-32"));
+    const bool multichannel = (1 < l.channels);
+    const auto naxis = multichannel ? 4 : ((1 < l.count) ? 3 : 2);
+    cards.emplace_back(Format_Card("NAXIS", std::to_string(naxis)));
+    cards.emplace_back(Format_Card("NAXIS1", std::to_string(l.columns)));
+    cards.emplace_back(Format_Card("NAXIS2", std::to_string(l.rows)));
+    if(multichannel){
+        cards.emplace_back(Format_Card("NAXIS3", std::to_string(l.channels)));
+        cards.emplace_back(Format_Card("NAXIS4", std::to_string(l.count)));
+    }else if(1 < l.count){
+        cards.emplace_back(Format_Card("NAXIS3", std::to_string(l.count)));
+    }
+
+    // Non-finite geometry is omitted, and replaced with defaults when read.
+    const auto add_number = [&](const std::string &key, double x){
+        if(std::isfinite(x)) cards.emplace_back(Format_Card(key, Format_Number(x)));
+    };
+    const auto add_vector = [&](const std::string &key, const vec3<double> &v){
+        add_number(key + "1", v.x);
+        add_number(key + "2", v.y);
+        add_number(key + "3", v.z);
+    };
+    add_number("PXLDX", first.pxl_dx);
+    add_number("PXLDY", first.pxl_dy);
+    add_number("PXLDZ", first.pxl_dz);
+    add_vector("ROWUNIT", first.row_unit);
+    add_vector("COLUNIT", first.col_unit);
+    add_vector("ANCHOR", first.anchor);
+    add_vector("OFFSET", first.offset);
+    if(1 < l.count) add_vector("STACK", l.stack);
+
+    std::string out;
+    for(const auto &c : cards) out += c;
+    out += "END";
+    out.resize(Round_Up_To_Block(out.size()), ' ');
+    return out;
+}
+
+} // namespace
+
+
+std::list<planar_image<float,double>>
+Read_FITS_Images(const std::string &filename){
+    const mapped_text_file FI(filename);
+    const char *b = FI.begin();
+    const char *e = FI.end();
+    if( (FI.size() < block_bytes) || (std::string(b, 8) != "SIMPLE  ") ){
+        throw std::invalid_argument("Not a FITS file");
+    }
+
+    std::list<planar_image<float,double>> out;
+    bool primary = true;
+    while(b != e){
+        const auto h = Parse_Header(b, e);
+        if(primary){
+            const auto *simple = h.find("SIMPLE");
+            if( (simple == nullptr) || (*simple != "T") ) throw std::invalid_argument("FITS file does not conform");
+        }
+
+        // Only the primary HDU and IMAGE extensions hold images. Other extensions (e.g., tables) are skipped.
+        const auto *xtension = h.find("XTENSION");
+        const bool is_image = primary || ( (xtension != nullptr) && (*xtension == "IMAGE") );
+        primary = false;
+
+        const auto bitpix = h.integer("BITPIX");
+        const auto naxis = h.integer("NAXIS");
+        std::vector<int64_t> dims;
+        for(int64_t i = 1; i <= naxis; ++i) dims.push_back(h.integer("NAXIS" + std::to_string(i)));
+
+        const auto sample_bytes = static_cast<size_t>(std::abs(bitpix) / 8);
+        size_t samples = dims.empty() ? 0 : 1;
+        for(const auto d : dims){
+            if(d < 0) throw std::invalid_argument("FITS axis length is negative");
+            samples *= static_cast<size_t>(d);
+        }
+        const auto pcount = h.number("PCOUNT").value_or(0.0);
+        const auto gcount = h.number("GCOUNT").value_or(1.0);
+        const auto data_bytes = sample_bytes * static_cast<size_t>(gcount) * (static_cast<size_t>(pcount) + samples);
+        if(static_cast<size_t>(e - b) < data_bytes) throw std::invalid_argument("FITS data is truncated");
+        const char *data = b;
+        b += std::min(Round_Up_To_Block(data_bytes), static_cast<size_t>(e - b));
+
+        if(!is_image || (samples == 0)) continue;
+        if(4 < naxis) throw std::invalid_argument("FITS images with more than four axes are not supported");
+
+        const auto columns = dims[0];
+        const auto rows = (1 < naxis) ? dims[1] : 1;
+        const auto channels = (naxis == 4) ? dims[2] : 1;
+        const auto count = (naxis == 4) ? dims[3] : ((naxis == 3) ? dims[2] : 1);
+
+        const auto zero = h.number("BZERO").value_or(0.0);
+        const auto scale = h.number("BSCALE").value_or(1.0);
+        std::optional<int64_t> blank;
+        if(h.find("BLANK") != nullptr) blank = h.integer("BLANK");
+
+        const auto pxl_dx = h.number("PXLDX").value_or(1.0);
+        const auto pxl_dy = h.number("PXLDY").value_or(1.0);
+        const auto pxl_dz = h.number("PXLDZ").value_or(1.0);
+        const auto row_unit = h.vector("ROWUNIT", vec3<double>(0.0, 1.0, 0.0));
+        const auto col_unit = h.vector("COLUNIT", vec3<double>(1.0, 0.0, 0.0));
+        const auto anchor = h.vector("ANCHOR", vec3<double>(0.0, 0.0, 0.0));
+        const auto offset = h.vector("OFFSET", vec3<double>(0.0, 0.0, 0.0));
+        const auto stack = h.vector("STACK", row_unit.Cross(col_unit).unit() * pxl_dz);
+
+        std::vector<planar_image<float,double> *> imgs;
+        for(int64_t k = 0; k < count; ++k){
+            out.emplace_back();
+            auto &img = out.back();
+            img.init_buffer(rows, columns, channels);
+            img.init_spatial(pxl_dx, pxl_dy, pxl_dz, anchor, offset + stack * static_cast<double>(k));
+            img.init_orientation(row_unit, col_unit);
+            for(const auto &c : h.cards){
+                if(!Is_Structural(c.first)) img.metadata[c.first] = c.second;
+            }
+            imgs.push_back(&img);
+        }
+
+        // Planes are decoded concurrently, directly from the mapped file into each image.
+        const auto plane_samples = static_cast<size_t>(rows * columns);
+        parallel_for(0, count * channels, [&](long int p) -> void {
+            const auto k = static_cast<size_t>(p / channels);
+            const auto chan = static_cast<size_t>(p % channels);
+            Decode_Plane(bitpix, data + static_cast<size_t>(p) * plane_samples * sample_bytes, plane_samples,
+                         zero, scale, blank, imgs[k]->data.data() + chan, static_cast<size_t>(channels));
+        }, /*grain=*/ 1);
+    }
+    if(out.empty()) throw std::invalid_argument("FITS file contains no images");
+    return out;
+}
+
+
+size_t
+FITS_Encoded_Size(const fits_images_t &imgs){
+    const auto l = Validate_Images(imgs);
+    const auto samples = static_cast<size_t>(l.rows * l.columns * l.channels) * l.count;
+    return Encode_Header(imgs, l).size() + Round_Up_To_Block(samples * sizeof(float));
+}
+
+void
+Write_FITS_Images(const fits_images_t &imgs,
+                  const std::function<void(const char *, size_t)> &write,
+                  size_t chunk_bytes){
+    const auto l = Validate_Images(imgs);
+    const auto header = Encode_Header(imgs, l);
+    write(header.data(), header.size());
+
+    // Planes are written in FITS order (channels, then images), and each is encoded into the chunk as it fills.
+    std::vector<unsigned char> chunk(std::max<size_t>(1, chunk_bytes / sizeof(float)) * sizeof(float));
+    const auto chunk_samples = chunk.size() / sizeof(float);
+    size_t filled = 0;
+    size_t written = 0;
+    const auto flush = [&](){
+        write(reinterpret_cast<const char *>(chunk.data()), filled * sizeof(float));
+        written += filled * sizeof(float);
+        filled = 0;
+    };
+
+    const auto plane_samples = static_cast<size_t>(l.rows * l.columns);
+    const auto stride = static_cast<size_t>(l.channels);
+    for(const auto &img_refw : imgs){
+        const float *d = img_refw.get().data.data();
+        for(size_t chan = 0; chan < stride; ++chan){
+            size_t i = 0;
+            while(i < plane_samples){
+                const auto n = std::min(plane_samples - i, chunk_samples - filled);
+                unsigned char *o = chunk.data() + filled * sizeof(float);
+                const float *s = d + i * stride + chan;
+                for(size_t j = 0; j < n; ++j){
+                    uint32_t bits;
+                    std::memcpy(&bits, s + j * stride, sizeof(bits));
+                    Write_BE32(o + j * sizeof(float), bits);
+                }
+                i += n;
+                filled += n;
+                if(filled == chunk_samples) flush();
+            }
+        }
+    }
+    if(0 < filled) flush();
+
+    const std::vector<char> padding(Round_Up_To_Block(written) - written, 0);
+    if(!padding.empty()) write(padding.data(), padding.size());
+    return;
+}
+
+void
+Write_FITS_Images(const fits_images_t &imgs, const std::string &filename){
+    std::ofstream ofs(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!ofs) throw std::runtime_error("Unable to open file '" + filename + "' for writing");
+    Write_FITS_Images(imgs, [&](const char *p, size_t n){
+        ofs.write(p, static_cast<std::streamsize>(n));
+    });
+    ofs.flush();
+    if(!ofs) throw std::runtime_error("Unable to write file '" + filename + "'");
+    return;
+}
+
+std::string
+Encode_FITS_Images(const fits_images_t &imgs){
+    std::string out;
+    out.reserve(FITS_Encoded_Size(imgs));
+    Write_FITS_Images(imgs, [&](const char *p, size_t n){
+        out.append(p, n);
+    });
+    return out;
+}
+
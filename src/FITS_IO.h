@@ -0,0 +1,59 @@
+//FITS_IO.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "YgorImages.h"
+
+
+// Routines for reading and writing FITS image files without staging the pixel data in intermediate buffers.
+//
+// Files are memory-mapped and each plane is decoded from FITS (big-endian) byte order directly into the image's
+// storage, so reading a file needs no memory beyond the images themselves. Encoding is done in fixed-size chunks that
+// are handed to the writer as they are filled, so large cubes can be written without an encoded copy of the whole
+// file.
+//
+// Each NAXIS1 x NAXIS2 plane of the primary HDU and of every IMAGE extension becomes a single-channel image, so 3D
+// cubes become a stack of images (ordered along NAXIS3). 4D HDUs hold multi-channel images, with channels along NAXIS3
+// and images along NAXIS4. All standard BITPIX values are supported, and BZERO, BSCALE, and BLANK are honoured.
+//
+// Image geometry is stored in the following (non-standard) keywords, which are written by this writer:
+//   PXLDX, PXLDY, PXLDZ                    voxel dimensions,
+//   ROWUNIT1-3, COLUNIT1-3                 row and column unit vectors,
+//   ANCHOR1-3, OFFSET1-3                   anchor and offset of the first image,
+//   STACK1-3                               offset between consecutive images along NAXIS3 (or NAXIS4).
+// When absent, images have unit voxels, default orientation, and are stacked along their normal. Other keywords are
+// copied into the image metadata.
+
+// Reads every image in the file. Throws if the file is not a FITS file or cannot be decoded.
+std::list<planar_image<float,double>>
+Read_FITS_Images(const std::string &filename);
+
+
+// Images written together in a single HDU. Multiple images must share rows, columns, channels, voxel dimensions,
+// anchor, and orientation, and must be evenly spaced; otherwise this throws.
+using fits_images_t = std::vector<std::reference_wrapper<const planar_image<float,double>>>;
+
+// The number of bytes needed to encode the images.
+size_t
+FITS_Encoded_Size(const fits_images_t &imgs);
+
+// Encodes the images as a FITS file with 32-bit floating-point pixels. The encoding is passed to 'write' in
+// consecutive pieces of up to chunk_bytes bytes.
+void
+Write_FITS_Images(const fits_images_t &imgs,
+                  const std::function<void(const char *, size_t)> &write,
+                  size_t chunk_bytes = 4 * 1024 * 1024);
+
+// Convenience wrappers that write the encoding to a file or to a string of exactly the encoded size. Throw on failure.
+void
+Write_FITS_Images(const fits_images_t &imgs, const std::string &filename);
+
+std::string
+Encode_FITS_Images(const fits_images_t &imgs);
+
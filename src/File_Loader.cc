@@ -1,8 +1,14 @@
 //File_Loader.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
 #include <exception>
-//#include <functional>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
 //#include <memory>
@@ -19,6 +25,8 @@
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
 #include "Structs.h"
+#include "Thread_Pool.h"
+#include "Tracing.h"
 
 #include "Boost_Serialization_File_Loader.h"
 #include "DICOM_File_Loader.h"
@@ -34,114 +42,415 @@
 
 
 
+using file_loader_t = std::function<bool( Drover &,
+                                          std::map<std::string,std::string> &,
+                                          const std::string &,
+                                          std::list<boost::filesystem::path> & )>;
+
+
+// Coarse file classification based on magic bytes and (when inconclusive) the file extension.
+//
+// This is only used to avoid offering files to loaders that cannot possibly load them, so it errs on the side of
+// 'unknown', which all loaders are offered.
+enum class file_format_hint {
+    unknown,    // Could be anything; offered to all loaders.
+    dicom,      // 'DICM' preamble, or a binary file with a DICOM extension.
+    tar,        // 'ustar' header magic.
+    gzip,       // Could be a compressed TAR file or a compressed Boost.Serialization archive.
+    archive,    // An uncompressed Boost.Serialization archive.
+    fits,       // 'SIMPLE  =' header.
+    stl,        // A binary file with an STL extension.
+    text,       // Plain text in an unrecognized format.
+};
+
+enum class loader_stage {
+    tar,
+    boost_archive,
+    dicom,
+    dvh,
+    fits,
+    dose3d,
+    off,
+    obj,
+    stl,
+    xyz,
+    lsamp,
+};
+
+[[maybe_unused]]
+static
+const char *
+Loader_Stage_Name(loader_stage stage){
+    switch(stage){
+        case loader_stage::tar:           return "TAR";
+        case loader_stage::boost_archive: return "Boost archive";
+        case loader_stage::dicom:         return "DICOM";
+        case loader_stage::dvh:           return "DVH";
+        case loader_stage::fits:          return "FITS";
+        case loader_stage::dose3d:        return "3ddose";
+        case loader_stage::off:           return "OFF";
+        case loader_stage::obj:           return "OBJ";
+        case loader_stage::stl:           return "STL";
+        case loader_stage::xyz:           return "XYZ";
+        case loader_stage::lsamp:         return "line sample";
+    }
+    return "unknown";
+}
+
+static
+file_format_hint
+Sniff_File_Format(const boost::filesystem::path &apath){
+    std::array<char, 512> buf;
+    buf.fill('\0');
+    std::streamsize n = 0;
+    {
+        std::ifstream ifs(apath.string(), std::ios::in | std::ios::binary);
+        if(!ifs) return file_format_hint::unknown;
+        ifs.read(buf.data(), buf.size());
+        n = ifs.gcount();
+    }
+    if(n <= 0) return file_format_hint::unknown;
+
+    const auto has_at = [&](std::streamsize offset, const std::string &magic) -> bool {
+        return (static_cast<std::streamsize>(offset + magic.size()) <= n)
+            && (std::memcmp(buf.data() + offset, magic.data(), magic.size()) == 0);
+    };
+
+    if(has_at(128, "DICM")) return file_format_hint::dicom;
+    if(has_at(257, "ustar")) return file_format_hint::tar;
+    if(has_at(0, "\x1F\x8B")) return file_format_hint::gzip;
+    if(has_at(0, "SIMPLE  =")) return file_format_hint::fits;
+    if(has_at(0, "DCMADRV1")) return file_format_hint::archive; // Native Drover archive.
+
+    const auto beg = std::begin(buf);
+    const auto end = std::next(beg, n);
+    const std::string boost_magic("serialization::archive");
+    if(std::search(beg, end, std::begin(boost_magic), std::end(boost_magic)) != end){
+        return file_format_hint::archive;
+    }
+
+    // Text files should not contain any null bytes. Binary files are more ambiguous, so rely on the extension.
+    if(std::find(beg, end, '\0') == end) return file_format_hint::text;
+
+    auto ext = apath.extension().string();
+    std::transform(std::begin(ext), std::end(ext), std::begin(ext), [](unsigned char c){ return std::tolower(c); });
+    if( (ext == ".dcm") || (ext == ".ima") ) return file_format_hint::dicom;
+    if( ext == ".stl" ) return file_format_hint::stl;
+
+    return file_format_hint::unknown;
+}
+
+// Returns true if a file with the given hint could possibly be loaded by the loader stage.
+static
+bool
+Stage_Admits(loader_stage stage, file_format_hint hint){
+    switch(hint){
+        case file_format_hint::unknown:
+            return true;
+        case file_format_hint::dicom:
+            return (stage == loader_stage::dicom);
+        case file_format_hint::tar:
+            return (stage == loader_stage::tar);
+        case file_format_hint::gzip:
+            return (stage == loader_stage::tar) || (stage == loader_stage::boost_archive);
+        case file_format_hint::archive:
+            return (stage == loader_stage::boost_archive);
+        case file_format_hint::fits:
+            return (stage == loader_stage::fits);
+        case file_format_hint::stl:
+            return (stage == loader_stage::stl);
+        case file_format_hint::text:
+            return (stage != loader_stage::tar)
+                && (stage != loader_stage::boost_archive)
+                && (stage != loader_stage::dicom)
+                && (stage != loader_stage::fits);
+    }
+    return true;
+}
+
+// Recursively expands directories, invoking the callback for each file as it is encountered rather than
+// materializing the full list. Entries are visited in lexicographical order within each directory so that
+// enumeration is deterministic. Symbolic links to directories are followed only if requested, which callers do for the
+// paths they were given explicitly; links found while recursing are skipped to avoid cycles.
+static
+void
+Enumerate_Files( const boost::filesystem::path &apath,
+                 const std::function<void(const boost::filesystem::path &)> &on_file,
+                 bool follow_symlinks ){
+    boost::system::error_code ec;
+    if(boost::filesystem::is_directory(apath, ec)){
+        if(!follow_symlinks && boost::filesystem::is_symlink(apath, ec)){
+            FUNCWARN("Not following symbolic link to directory '" << apath << "'");
+            return;
+        }
+
+        std::vector<boost::filesystem::path> entries;
+        for(boost::filesystem::directory_iterator d_it(apath, ec), d_end; !ec && (d_it != d_end); d_it.increment(ec)){
+            entries.emplace_back(d_it->path());
+        }
+        if(ec){
+            FUNCWARN("Unable to fully enumerate directory '" << apath << "': " << ec.message());
+        }
+        std::sort(std::begin(entries), std::end(entries));
+        for(const auto &e : entries) Enumerate_Files(e, on_file, false);
+
+    }else if(boost::filesystem::is_regular_file(apath, ec)){
+        on_file(apath);
+    }
+    return;
+}
+
+
+// This routine invokes a loader on each file individually and concurrently, and then merges the results in the
+// original file order. It is only suitable for loaders that treat each file independently (i.e., that do not
+// collate data across files), since each file is loaded into a separate Drover.
+//
+// The outcome mirrors invoking the loader once on all files: files that are loaded are consumed, files that are
+// not recognized are left in place, and a failure halts merging so that later files are left untouched.
+//
+// Files are processed in chunks so that only a bounded number of partially-loaded Drovers are held at once.
+static
+bool
+Load_Files_Concurrently( const file_loader_t &loader,
+                         Drover &DICOM_data,
+                         std::map<std::string,std::string> &InvocationMetadata,
+                         const std::string &FilenameLex,
+                         std::list<boost::filesystem::path> &Paths,
+                         long int n_threads ){
+
+    if( (n_threads <= 1)
+    ||  (Paths.size() < 2) ){
+        return loader(DICOM_data, InvocationMetadata, FilenameLex, Paths);
+    }
+
+    struct per_file_t {
+        Drover loaded;
+        std::list<boost::filesystem::path> remaining;
+        bool succeeded = false;
+    };
+    const size_t chunk_size = 16 * static_cast<size_t>(n_threads);
+
+    auto p_it = std::begin(Paths);
+    while(p_it != std::end(Paths)){
+        std::vector<per_file_t> per_file;
+        per_file.reserve(chunk_size);
+        for(auto c_it = p_it; (c_it != std::end(Paths)) && (per_file.size() < chunk_size); ++c_it){
+            per_file.emplace_back();
+            per_file.back().remaining.emplace_back(*c_it);
+        }
+
+        {
+            task_group tg(n_threads);
+            for(auto &pf : per_file){
+                per_file_t *pfp = &pf;
+                tg.run([&,pfp]() -> void {
+                    DCMA_TRACE_ZONE("loader", "file");
+                    auto l_InvocationMetadata = InvocationMetadata;
+                    try{
+                        pfp->succeeded = loader(pfp->loaded, l_InvocationMetadata, FilenameLex, pfp->remaining);
+                    }catch(const std::exception &e){
+                        FUNCWARN("Loader failed: '" << e.what() << "'");
+                        pfp->succeeded = false;
+                    }
+                });
+            }
+            tg.wait();
+        } // Thread pool joins here.
+
+        // Merge the results in the original order.
+        for(auto &pf : per_file){
+            if(!pf.succeeded) return false;
+
+            if(pf.remaining.empty()){
+                DICOM_data.Consume(pf.loaded);
+                p_it = Paths.erase(p_it);
+            }else{
+                ++p_it;
+            }
+        }
+    }
+    return true;
+}
+
+
 // This routine loads files. In order for it to return true, all files need to be successfully read.
 // If a file cannot be read, all others are tried before returning false.
+//
+// Directories are recursively expanded. Each file is only offered to the loaders that could plausibly load it, based
+// on a cheap inspection of the first few bytes of the file.
+//
+// If more than one thread is requested, files are decoded concurrently where the loader permits it. Results are
+// merged in the same order as if the files were loaded sequentially.
+//
+// If requested, decoding the pixel data of DICOM images is deferred until the pixels are first accessed.
 bool
 Load_Files( Drover &DICOM_data,
             std::map<std::string,std::string> &InvocationMetadata,
             const std::string &FilenameLex,
-            std::list<boost::filesystem::path> &Paths ){
+            std::list<boost::filesystem::path> &Paths,
+            long int n_threads,
+            bool defer_pixels ){
+    DCMA_TRACE_ZONE("loader", "Load_Files");
 
-    //Convert directories to filenames.
-    // TODO.
+    //Convert directories to filenames, removing non-existent filenames and directories and classifying files as
+    // they are encountered.
+    struct sniffed_file_t {
+        boost::filesystem::path path;
+        file_format_hint hint;
+    };
+    std::list<sniffed_file_t> Files;
 
-    //Remove non-existent filenames and directories.
     bool contained_unresolvable = false;
-    {
-        std::list<boost::filesystem::path> CPaths;
-        for(const auto &apath : Paths){
-            bool wasOK = false;
-            try{
-                wasOK = boost::filesystem::exists(apath);
-            }catch(const boost::filesystem::filesystem_error &){ }
-
-            if(wasOK){
-                CPaths.emplace_back(apath);
-            }else{
-                FUNCWARN("Unable to resolve file or directory '" << apath << "'");
-                contained_unresolvable = true;
-            }
+    for(const auto &apath : Paths){
+        bool wasOK = false;
+        try{
+            wasOK = boost::filesystem::is_directory(apath)
+                 || boost::filesystem::is_regular_file(apath);
+        }catch(const boost::filesystem::filesystem_error &){ }
+
+        if(!wasOK){
+            FUNCWARN("Unable to resolve file or directory '" << apath << "'");
+            contained_unresolvable = true;
+            continue;
+        }
+
+        try{
+            Enumerate_Files(apath, [&](const boost::filesystem::path &f) -> void {
+                Files.push_back( sniffed_file_t{ f, Sniff_File_Format(f) } );
+            }, true);
+        }catch(const std::exception &e){
+            FUNCWARN("Unable to enumerate '" << apath << "': " << e.what());
+            contained_unresolvable = true;
         }
-        Paths = CPaths;
     }
+    FUNCINFO("Located " << Files.size() << " files");
+
+    // Offers the files admitted by the given stage to the loader. Files the loader does not consume are retained, in
+    // order, for the following stages.
+    //
+    // Loaders that treat each file independently are offered the files in bounded chunks, so neither the candidate
+    // list nor the bookkeeping needed to remove consumed files grows with the total number of files. Loaders that
+    // collate data across files (e.g., DICOM series) must be offered all admitted files at once.
+    const auto run_stage = [&](loader_stage stage, const file_loader_t &loader, bool independent) -> bool {
+        const size_t chunk_size = independent ? 1024 : std::numeric_limits<size_t>::max();
+
+        auto f_it = std::begin(Files);
+        while(f_it != std::end(Files)){
+            std::vector<std::list<sniffed_file_t>::iterator> chunk;
+            std::list<boost::filesystem::path> candidates;
+            for( ; (f_it != std::end(Files)) && (chunk.size() < chunk_size); ++f_it){
+                if(!Stage_Admits(stage, f_it->hint)) continue;
+                chunk.emplace_back(f_it);
+                candidates.emplace_back(f_it->path);
+            }
+            if(candidates.empty()) break;
+
+            DCMA_TRACE_ZONE("loader", Loader_Stage_Name(stage));
+            const bool ret = loader(DICOM_data, InvocationMetadata, FilenameLex, candidates);
+
+            // Remove the consumed files. Multiple copies of the same file are handled by counting.
+            std::map<boost::filesystem::path, long int> unconsumed;
+            for(const auto &c : candidates) unconsumed[c] += 1;
+            for(const auto &c_it : chunk){
+                auto &count = unconsumed[c_it->path];
+                if(count <= 0){
+                    Files.erase(c_it);
+                    continue;
+                }
+                --count;
+            }
+            if(!ret) return false;
+        }
+        return true;
+    };
+
+    const auto concurrently = [&](const file_loader_t &loader) -> file_loader_t {
+        return [&,loader]( Drover &d,
+                           std::map<std::string,std::string> &im,
+                           const std::string &lex,
+                           std::list<boost::filesystem::path> &p ) -> bool {
+            return Load_Files_Concurrently(loader, d, im, lex, p, n_threads);
+        };
+    };
 
     //Standalone file loading: TAR files.
-    if(!Paths.empty()
-    && !Load_From_TAR_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::tar, Load_From_TAR_Files, false)){
         FUNCWARN("Failed to load TAR file");
         return false;
     }
 
     //Standalone file loading: Boost.Serialization archives.
-    if(!Paths.empty()
-    && !Load_From_Boost_Serialization_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::boost_archive, concurrently(Load_From_Boost_Serialization_Files), true)){
         FUNCWARN("Failed to load Boost.Serialization archive");
         return false;
     }
 
     //Standalone file loading: DICOM files.
-    if(!Paths.empty()
-    && !Load_From_DICOM_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::dicom, [&]( Drover &d,
+                                            std::map<std::string,std::string> &im,
+                                            const std::string &lex,
+                                            std::list<boost::filesystem::path> &p ) -> bool {
+                                        return Load_From_DICOM_Files(d, im, lex, p, n_threads, nullptr, defer_pixels);
+                                    }, false)){
         FUNCWARN("Failed to load DICOM file");
         return false;
     }
 
     //Standalone file loading: 'tabular DVH' line sample files.
-    if(!Paths.empty()
-    && !Load_From_DVH_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::dvh, Load_From_DVH_Files, false)){
         FUNCWARN("Failed to load DVH file");
         return false;
     }
 
     //Standalone file loading: FITS files.
-    if(!Paths.empty()
-    && !Load_From_FITS_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::fits, Load_From_FITS_Files, false)){
         FUNCWARN("Failed to load FITS file");
         return false;
     }
 
     //Standalone file loading: DOSXYZnrc 3ddose files.
-    if(!Paths.empty()
-    && !Load_From_3ddose_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::dose3d, concurrently(Load_From_3ddose_Files), true)){
         FUNCWARN("Failed to load 3ddose file");
         return false;
     }
 
     //Standalone file loading: OFF mesh files.
-    if(!Paths.empty()
-    && !Load_Mesh_From_OFF_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::off, concurrently(Load_Mesh_From_OFF_Files), true)){
         FUNCWARN("Failed to load OFF mesh file");
         return false;
     }
 
     //Standalone file loading: OBJ files.
-    if(!Paths.empty()
-    && !Load_Mesh_From_OBJ_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::obj, concurrently(Load_Mesh_From_OBJ_Files), true)){
         FUNCWARN("Failed to load OBJ mesh file");
         return false;
     }
 
     //Standalone file loading: STL mesh files (both ASCII and binary).
-    if(!Paths.empty()
-    && !Load_Mesh_From_STL_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::stl, concurrently(Load_Mesh_From_STL_Files), true)){
         FUNCWARN("Failed to load STL mesh file");
         return false;
     }
 
     //Standalone file loading: XYZ point cloud files.
-    if(!Paths.empty()
-    && !Load_From_XYZ_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::xyz, concurrently(Load_From_XYZ_Files), true)){
         FUNCWARN("Failed to load XYZ file");
         return false;
     }
 
     //Standalone file loading: line sample files.
-    if(!Paths.empty()
-    && !Load_From_Line_Sample_Files( DICOM_data, InvocationMetadata, FilenameLex, Paths )){
+    if(!run_stage(loader_stage::lsamp, concurrently(Load_From_Line_Sample_Files), true)){
         FUNCWARN("Failed to load line sample file");
         return false;
     }
 
+    //Report any files that could not be loaded by any loader.
+    Paths.clear();
+    for(const auto &f : Files){
+        FUNCWARN("Unable to load file '" << f.path << "'");
+        Paths.emplace_back(f.path);
+    }
+
     return (Paths.empty() && !contained_unresolvable);
 }
 
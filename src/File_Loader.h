@@ -14,5 +14,7 @@ bool
 Load_Files( Drover &DICOM_data,
             std::map<std::string,std::string> &InvocationMetadata,
             const std::string &FilenameLex,
-            std::list<boost::filesystem::path> &Paths );
+            std::list<boost::filesystem::path> &Paths,
+            long int n_threads = 1,
+            bool defer_pixels = false );
 
@@ -0,0 +1,129 @@
+//File_Prefetcher.cc.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "File_Prefetcher.h"
+
+
+namespace {
+
+constexpr size_t chunk_size = static_cast<size_t>(1) << 20;
+
+// Reads the file, discarding the contents. Returns the number of bytes read.
+size_t Fetch_File(const std::string &path, std::vector<char> &buf){
+    size_t total = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) return 0;
+
+    #if defined(POSIX_FADV_WILLNEED)
+        // Let the kernel issue (possibly parallel) readahead for the whole file while we read it sequentially.
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    #endif
+
+    while(true){
+        const auto n = ::read(fd, buf.data(), buf.size());
+        if(n <= 0) break;
+        total += static_cast<size_t>(n);
+    }
+    ::close(fd);
+#else
+    std::ifstream is(path, std::ios::in | std::ios::binary);
+    while(is){
+        is.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        total += static_cast<size_t>(is.gcount());
+    }
+#endif
+    return total;
+}
+
+} // namespace
+
+
+file_prefetcher::file_prefetcher(std::vector<std::string> paths_in,
+                                 size_t max_bytes_ahead_in,
+                                 size_t max_files_ahead_in)
+    : paths(std::move(paths_in)),
+      sizes(paths.size(), 0),
+      max_bytes_ahead(max_bytes_ahead_in),
+      max_files_ahead(std::max<size_t>(1, max_files_ahead_in)) {
+
+    if(!this->paths.empty()){
+        this->worker = std::thread([this](){ this->run(); });
+    }
+}
+
+file_prefetcher::~file_prefetcher(){
+    {
+        std::lock_guard<std::mutex> lock(this->m);
+        this->stop = true;
+    }
+    this->cv.notify_all();
+    if(this->worker.joinable()) this->worker.join();
+}
+
+void file_prefetcher::consume(size_t i){
+    {
+        std::lock_guard<std::mutex> lock(this->m);
+        if(i <= this->consumed) return;
+
+        // Earlier files are no longer needed, so their bytes no longer count against the limit.
+        const auto end = std::min(i, this->next_fetch);
+        for(size_t j = this->consumed; j < end; ++j){
+            this->bytes_ahead -= this->sizes[j];
+            this->sizes[j] = 0;
+        }
+        this->consumed = i;
+
+        // The consumer is reading file i itself, so there is no point in fetching it.
+        this->next_fetch = std::max(this->next_fetch, i + 1);
+    }
+    this->cv.notify_all();
+}
+
+void file_prefetcher::run(){
+    std::vector<char> buf(chunk_size);
+    const auto N = this->paths.size();
+
+    while(true){
+        size_t j;
+        {
+            std::unique_lock<std::mutex> lock(this->m);
+            this->cv.wait(lock, [&](){
+                return this->stop
+                    || (  (this->next_fetch < N)
+                       && ((this->next_fetch - this->consumed) <= this->max_files_ahead)
+                       && (this->bytes_ahead < this->max_bytes_ahead) );
+            });
+            if(this->stop) return;
+            j = this->next_fetch++;
+        }
+
+        const auto bytes = Fetch_File(this->paths[j], buf);
+
+        {
+            std::lock_guard<std::mutex> lock(this->m);
+            if(this->stop) return;
+            if(this->consumed <= j){
+                this->sizes[j] = bytes;
+                this->bytes_ahead += bytes;
+            }
+            if(N <= this->next_fetch) return; // All files have been fetched.
+        }
+    }
+}
+
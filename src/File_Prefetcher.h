@@ -0,0 +1,52 @@
+//File_Prefetcher.h.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Asynchronously reads files that will soon be needed so they are resident in the operating system's page cache when
+// they are eventually opened.
+//
+// This is meant for loading many files, in order, from slow (e.g., network) storage. A dedicated I/O thread reads
+// ahead of the consumer, so storage latency overlaps with decoding rather than adding to it. The data itself is
+// discarded; files are later read as usual through the page cache. At most 'max_bytes_ahead' bytes and
+// 'max_files_ahead' files beyond the file currently being consumed are fetched at any time.
+//
+// Failures are ignored; files that cannot be prefetched are simply read normally later.
+class file_prefetcher {
+  public:
+    file_prefetcher(std::vector<std::string> paths,
+                    size_t max_bytes_ahead = static_cast<size_t>(256) * 1024 * 1024,
+                    size_t max_files_ahead = 64);
+    ~file_prefetcher();
+
+    file_prefetcher(const file_prefetcher &) = delete;
+    file_prefetcher & operator=(const file_prefetcher &) = delete;
+
+    // Indicates that the file at the given index is about to be read, and that all earlier files are no longer needed.
+    void consume(size_t i);
+
+  private:
+    std::vector<std::string> paths;
+    std::vector<size_t> sizes; // Populated as files are prefetched.
+    size_t max_bytes_ahead;
+    size_t max_files_ahead;
+
+    std::mutex m;
+    std::condition_variable cv;
+    size_t next_fetch = 0;   // The next file to prefetch.
+    size_t consumed = 0;     // The index of the file currently being consumed.
+    size_t bytes_ahead = 0;  // Bytes prefetched for files at or beyond 'consumed'.
+    bool stop = false;
+
+    std::thread worker;
+
+    void run();
+};
+
@@ -0,0 +1,838 @@
+//Half_Edge_Mesh.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Surface_Mesh_BVH.h"
+#include "Thread_Pool.h"
+
+#include "Half_Edge_Mesh.h"
+
+
+half_edge_mesh::half_edge_mesh(const fv_surface_mesh<double, uint64_t> &mesh){
+    this->positions = mesh.vertices;
+    const auto N_verts = static_cast<uint64_t>(this->positions.size());
+
+    size_t N_tris = 0;
+    for(const auto &f : mesh.faces){
+        if(3 <= f.size()) N_tris += f.size() - 2;
+    }
+    this->corner_vertex.reserve(3 * N_tris);
+    for(const auto &f : mesh.faces){
+        for(const auto &i : f){
+            if(N_verts <= i) throw std::invalid_argument("Face refers to a nonexistent vertex");
+        }
+        for(size_t j = 2; j < f.size(); ++j){
+            // Degenerate triangles are dropped.
+            if( (f[0] == f[j - 1]) || (f[0] == f[j]) || (f[j - 1] == f[j]) ) continue;
+            this->corner_vertex.push_back(f[0]);
+            this->corner_vertex.push_back(f[j - 1]);
+            this->corner_vertex.push_back(f[j]);
+        }
+    }
+    this->link();
+}
+
+half_edge_mesh::half_edge_mesh(std::vector<vec3<double>> positions, std::vector<uint64_t> corner_vertex)
+    : positions(std::move(positions)), corner_vertex(std::move(corner_vertex)) {
+    if((this->corner_vertex.size() % 3) != 0) throw std::invalid_argument("Incomplete triangle");
+    const auto N_verts = static_cast<uint64_t>(this->positions.size());
+    for(const auto &i : this->corner_vertex){
+        if(N_verts <= i) throw std::invalid_argument("Triangle refers to a nonexistent vertex");
+    }
+    this->link();
+}
+
+void half_edge_mesh::link(){
+    const auto N_verts = static_cast<uint64_t>(this->positions.size());
+    const auto N_corners = static_cast<uint64_t>(this->corner_vertex.size());
+    this->face_alive.assign(N_corners / 3, 1);
+
+    // Group the corners by vertex, so half-edges can be matched by searching the (short) list of each vertex.
+    std::vector<uint64_t> first(N_verts + 1, 0);
+    for(const auto &v : this->corner_vertex) ++first[v + 1];
+    for(uint64_t v = 0; v < N_verts; ++v) first[v + 1] += first[v];
+    std::vector<uint64_t> by_vertex(N_corners);
+    {
+        auto fill = first;
+        for(uint64_t c = 0; c < N_corners; ++c) by_vertex[ fill[this->corner_vertex[c]]++ ] = c;
+    }
+
+    this->twin.assign(N_corners, none);
+    parallel_for(0, static_cast<long int>(N_corners), [&](long int i) -> void {
+        const auto c = static_cast<uint64_t>(i);
+        const auto a = this->corner_vertex[c];
+        const auto b = this->head(c);
+
+        for(uint64_t j = first[a]; j < first[a + 1]; ++j){
+            const auto o = by_vertex[j];
+            if( (o != c) && (this->head(o) == b) ){
+                throw std::runtime_error("Edge is shared by more than two faces or by inconsistently-oriented faces");
+            }
+        }
+        for(uint64_t j = first[b]; j < first[b + 1]; ++j){
+            const auto o = by_vertex[j];
+            if(this->head(o) == a){
+                this->twin[c] = o;
+                break;
+            }
+        }
+    });
+
+    this->vertex_corner.assign(N_verts, none);
+    this->vertex_manifold.assign(N_verts, 1);
+    parallel_for(0, static_cast<long int>(N_verts), [&](long int i) -> void {
+        const auto v = static_cast<uint64_t>(i);
+        if(first[v] == first[v + 1]) return;
+        this->vertex_corner[v] = by_vertex[first[v]];
+
+        uint64_t N_fan = 0;
+        this->for_each_corner_around(v, [&](uint64_t){ ++N_fan; });
+        if(N_fan != (first[v + 1] - first[v])) this->vertex_manifold[v] = 0;
+    });
+    return;
+}
+
+fv_surface_mesh<double, uint64_t> half_edge_mesh::to_fv_surface_mesh() const {
+    const auto N_verts = static_cast<uint64_t>(this->positions.size());
+    const auto N_faces = static_cast<uint64_t>(this->face_alive.size());
+
+    std::vector<uint64_t> index(N_verts, none);
+    for(uint64_t f = 0; f < N_faces; ++f){
+        if(!this->face_alive[f]) continue;
+        for(uint64_t c = 3 * f; c < 3 * f + 3; ++c) index[this->corner_vertex[c]] = 0;
+    }
+
+    fv_surface_mesh<double, uint64_t> out;
+    for(uint64_t v = 0; v < N_verts; ++v){
+        if(index[v] == none) continue;
+        index[v] = static_cast<uint64_t>(out.vertices.size());
+        out.vertices.push_back(this->positions[v]);
+    }
+    out.faces.reserve(N_faces);
+    for(uint64_t f = 0; f < N_faces; ++f){
+        if(!this->face_alive[f]) continue;
+        out.faces.push_back({{ index[this->corner_vertex[3 * f]],
+                               index[this->corner_vertex[3 * f + 1]],
+                               index[this->corner_vertex[3 * f + 2]] }});
+    }
+    return out;
+}
+
+bool half_edge_mesh::is_boundary_vertex(uint64_t v) const {
+    if(!this->vertex_manifold[v]) return true;
+    bool boundary = false;
+    this->for_each_corner_around(v, [&](uint64_t c){
+        if( (this->twin[c] == none) || (this->twin[prev(c)] == none) ) boundary = true;
+    });
+    return boundary;
+}
+
+uint64_t half_edge_mesh::valence(uint64_t v) const {
+    uint64_t n = 0;
+    this->for_each_neighbour(v, [&](uint64_t){ ++n; });
+    return n;
+}
+
+vec3<double> half_edge_mesh::vertex_normal(uint64_t v) const {
+    vec3<double> N(0.0, 0.0, 0.0);
+    this->for_each_corner_around(v, [&](uint64_t c){
+        const auto &A = this->positions[this->corner_vertex[c]];
+        const auto &B = this->positions[this->head(c)];
+        const auto &C = this->positions[this->corner_vertex[prev(c)]];
+        N += (B - A).Cross(C - A);
+    });
+    const auto len = N.length();
+    return (0.0 < len) ? (N / len) : N;
+}
+
+uint64_t half_edge_mesh::edge_count() const {
+    uint64_t n = 0;
+    const auto N_corners = static_cast<uint64_t>(this->corner_vertex.size());
+    for(uint64_t c = 0; c < N_corners; ++c){
+        if(!this->face_alive[face(c)]) continue;
+        if( (this->twin[c] == none) || (c < this->twin[c]) ) ++n;
+    }
+    return n;
+}
+
+bool half_edge_mesh::can_collapse(uint64_t c) const {
+    const auto u = this->corner_vertex[c];
+    const auto v = this->head(c);
+    if( (u == v)
+    ||  !this->vertex_manifold[u]
+    ||  !this->vertex_manifold[v] ) return false;
+
+    const auto t = this->twin[c];
+    const auto w0 = this->corner_vertex[prev(c)];
+    const auto w1 = (t == none) ? none : this->corner_vertex[prev(t)];
+    if(w0 == w1) return false;
+    if( (t != none)
+    &&  this->is_boundary_vertex(u)
+    &&  this->is_boundary_vertex(v) ) return false;
+
+    // Link condition: the only common neighbours are the vertices opposite the edge.
+    std::vector<uint64_t> nu;
+    this->for_each_neighbour(u, [&](uint64_t w){ nu.push_back(w); });
+    bool ok = true;
+    this->for_each_neighbour(v, [&](uint64_t w){
+        if( ok
+        &&  (w != w0)
+        &&  (w != w1)
+        &&  (std::find(std::begin(nu), std::end(nu), w) != std::end(nu)) ) ok = false;
+    });
+    return ok;
+}
+
+bool half_edge_mesh::collapse_preserves_orientation(uint64_t c, const vec3<double> &p) const {
+    const auto f0 = face(c);
+    const auto f1 = (this->twin[c] == none) ? none : face(this->twin[c]);
+
+    bool ok = true;
+    for(const auto x : { this->corner_vertex[c], this->head(c) }){
+        this->for_each_corner_around(x, [&](uint64_t cc){
+            const auto f = face(cc);
+            if( !ok || (f == f0) || (f == f1) ) return;
+            const auto &A = this->positions[x];
+            const auto &B = this->positions[this->head(cc)];
+            const auto &C = this->positions[this->corner_vertex[prev(cc)]];
+            const auto N_old = (B - A).Cross(C - A);
+            const auto N_new = (B - p).Cross(C - p);
+
+            // Degenerate triangles have no orientation to preserve, but new degeneracies are not created.
+            const auto L_old = N_old.length();
+            if(L_old <= 0.0) return;
+            if(N_new.Dot(N_old) <= 0.01 * L_old * N_new.length()) ok = false;
+        });
+    }
+    return ok;
+}
+
+void half_edge_mesh::collapse(uint64_t c, const vec3<double> &p){
+    const auto u = this->corner_vertex[c];
+    const auto v = this->head(c);
+    const auto t = this->twin[c];
+
+    std::vector<uint64_t> cu;
+    this->for_each_corner_around(u, [&](uint64_t cc){ cu.push_back(cc); });
+
+    // Bridges the two outer edges of a triangle being removed. The corners of the outer edges replace the triangle's
+    // corners at its far vertex and at the merged vertex.
+    uint64_t v_corner = none;
+    const auto remove_face = [&](uint64_t h) -> void {
+        const auto far = this->corner_vertex[prev(h)];
+        const auto a = this->twin[next(h)];  // Begins at the far vertex.
+        const auto b = this->twin[prev(h)];  // Ends at the far vertex.
+        if(a != none) this->twin[a] = b;
+        if(b != none) this->twin[b] = a;
+        this->face_alive[face(h)] = 0;
+
+        this->vertex_corner[far] = (a != none) ? a : ((b != none) ? next(b) : none);
+        if(v_corner == none) v_corner = (b != none) ? b : ((a != none) ? next(a) : none);
+        return;
+    };
+
+    const auto f0 = face(c);
+    const auto f1 = (t == none) ? none : face(t);
+    remove_face(c);
+    if(t != none) remove_face(t);
+
+    for(const auto cc : cu){
+        const auto f = face(cc);
+        if( (f == f0) || (f == f1) ) continue;
+        this->corner_vertex[cc] = v;
+        if(v_corner == none) v_corner = cc;
+    }
+    this->vertex_corner[v] = v_corner;
+    this->vertex_corner[u] = none;
+    this->positions[v] = p;
+    return;
+}
+
+bool half_edge_mesh::can_flip(uint64_t c) const {
+    const auto t = this->twin[c];
+    if(t == none) return false;
+
+    const auto a = this->corner_vertex[c];
+    const auto b = this->head(c);
+    const auto cc = this->corner_vertex[prev(c)];
+    const auto d = this->corner_vertex[prev(t)];
+    if(cc == d) return false;
+    for(const auto x : { a, b, cc, d }){
+        if(!this->vertex_manifold[x]) return false;
+    }
+    if( (this->valence(a) <= 3)
+    ||  (this->valence(b) <= 3) ) return false;
+
+    bool exists = false;
+    this->for_each_neighbour(cc, [&](uint64_t w){ if(w == d) exists = true; });
+    return !exists;
+}
+
+void half_edge_mesh::flip(uint64_t c){
+    const auto t = this->twin[c];
+    const auto n0 = next(c);
+    const auto p0 = prev(c);
+    const auto n1 = next(t);
+    const auto p1 = prev(t);
+
+    const auto a = this->corner_vertex[c];
+    const auto b = this->corner_vertex[n0];
+    const auto cc = this->corner_vertex[p0];
+    const auto d = this->corner_vertex[p1];
+
+    const auto X1 = this->twin[n0]; // b -> cc.
+    const auto X2 = this->twin[p0]; // cc -> a.
+    const auto X3 = this->twin[n1]; // a -> d.
+    const auto X4 = this->twin[p1]; // d -> b.
+
+    // The triangles (a, b, cc) and (b, a, d) become (d, cc, a) and (cc, d, b).
+    this->corner_vertex[c] = d;
+    this->corner_vertex[n0] = cc;
+    this->corner_vertex[p0] = a;
+    this->corner_vertex[t] = cc;
+    this->corner_vertex[n1] = d;
+    this->corner_vertex[p1] = b;
+
+    const auto pair = [&](uint64_t x, uint64_t y){
+        this->twin[x] = y;
+        if(y != none) this->twin[y] = x;
+    };
+    pair(n0, X2);
+    pair(p0, X3);
+    pair(n1, X4);
+    pair(p1, X1);
+
+    this->vertex_corner[a] = p0;
+    this->vertex_corner[b] = p1;
+    this->vertex_corner[cc] = n0;
+    this->vertex_corner[d] = n1;
+    return;
+}
+
+
+namespace {
+
+// A symmetric 4x4 error quadric, stored as the upper triangle.
+struct quadric_t {
+    std::array<double, 10> q = {{ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 }};
+
+    // Adds the squared distance to the plane n.x + d = 0 (with unit n), weighted by w.
+    void add_plane(const vec3<double> &n, double d, double w){
+        const double a = n.x, b = n.y, c = n.z;
+        q[0] += w*a*a; q[1] += w*a*b; q[2] += w*a*c; q[3] += w*a*d;
+                       q[4] += w*b*b; q[5] += w*b*c; q[6] += w*b*d;
+                                      q[7] += w*c*c; q[8] += w*c*d;
+                                                     q[9] += w*d*d;
+    }
+    quadric_t operator+(const quadric_t &rhs) const {
+        quadric_t out;
+        for(size_t i = 0; i < q.size(); ++i) out.q[i] = q[i] + rhs.q[i];
+        return out;
+    }
+    double evaluate(const vec3<double> &p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        return     q[0]*x*x + 2.0*q[1]*x*y + 2.0*q[2]*x*z + 2.0*q[3]*x
+                 +     q[4]*y*y + 2.0*q[5]*y*z + 2.0*q[6]*y
+                 +     q[7]*z*z + 2.0*q[8]*z
+                 +     q[9];
+    }
+    // Finds the position minimizing the error. Returns false if the system is poorly conditioned.
+    bool minimize(vec3<double> &p) const {
+        const double a = q[0], b = q[1], c = q[2];
+        const double e = q[4], f = q[5], i = q[7];
+        const double det = a*(e*i - f*f) - b*(b*i - f*c) + c*(b*f - e*c);
+        const double scale = std::abs(a) + std::abs(e) + std::abs(i);
+        if( !(std::abs(det) > 1e-12 * scale * scale * scale) ) return false;
+        const double r0 = -q[3], r1 = -q[6], r2 = -q[8];
+        p.x = ( r0*(e*i - f*f) - b*(r1*i - f*r2) + c*(r1*f - e*r2) ) / det;
+        p.y = ( a*(r1*i - f*r2) - r0*(b*i - f*c) + c*(b*r2 - r1*c) ) / det;
+        p.z = ( a*(e*r2 - r1*f) - b*(b*r2 - r1*c) + r0*(b*f - e*c) ) / det;
+        return p.isfinite();
+    }
+};
+
+struct collapse_candidate_t {
+    double cost;
+    vec3<double> p;
+    uint64_t stamp; // The number of collapses performed when the candidate was evaluated.
+};
+
+} // namespace
+
+
+void Loop_Subdivide(fv_surface_mesh<double, uint64_t> &mesh, long int iters){
+    const auto pi = std::acos(-1.0);
+    for(long int iter = 0; iter < iters; ++iter){
+        throw_if_cancelled();
+        const half_edge_mesh hem(mesh);
+        const auto N_verts = static_cast<uint64_t>(hem.positions.size());
+        const auto N_corners = static_cast<uint64_t>(hem.corner_vertex.size());
+        const auto N_faces = N_corners / 3;
+
+        // Number the edges, which each receive a new vertex.
+        std::vector<uint64_t> edge(N_corners, half_edge_mesh::none);
+        uint64_t N_edges = 0;
+        for(uint64_t c = 0; c < N_corners; ++c){
+            const auto t = hem.twin[c];
+            if( (t == half_edge_mesh::none) || (c < t) ){
+                edge[c] = N_edges++;
+                if(t != half_edge_mesh::none) edge[t] = edge[c];
+            }
+        }
+
+        // Accumulate the neighbours of every vertex, separately along boundaries.
+        std::vector<vec3<double>> sum(N_verts, vec3<double>(0.0, 0.0, 0.0));
+        std::vector<vec3<double>> b_sum(N_verts, vec3<double>(0.0, 0.0, 0.0));
+        std::vector<uint64_t> count(N_verts, 0);
+        std::vector<uint64_t> b_count(N_verts, 0);
+        for(uint64_t c = 0; c < N_corners; ++c){
+            const auto t = hem.twin[c];
+            if( (t != half_edge_mesh::none) && (t < c) ) continue;
+            const auto a = hem.corner_vertex[c];
+            const auto b = hem.head(c);
+            sum[a] += hem.positions[b];
+            sum[b] += hem.positions[a];
+            ++count[a];
+            ++count[b];
+            if(t == half_edge_mesh::none){
+                b_sum[a] += hem.positions[b];
+                b_sum[b] += hem.positions[a];
+                ++b_count[a];
+                ++b_count[b];
+            }
+        }
+
+        fv_surface_mesh<double, uint64_t> out;
+        out.metadata = mesh.metadata;
+        out.vertices.resize(N_verts + N_edges);
+        parallel_for(0, static_cast<long int>(N_verts), [&](long int i) -> void {
+            const auto &P = hem.positions[i];
+            auto &Q = out.vertices[i];
+            Q = P;
+            if(0 < b_count[i]){
+                // Boundary vertices follow the boundary curve. Other configurations (e.g., where boundaries meet at
+                // a vertex) are left in place.
+                if(b_count[i] == 2) Q = P * 0.75 + b_sum[i] * 0.125;
+            }else if(hem.vertex_manifold[i] && (3 <= count[i])){
+                const auto n = static_cast<double>(count[i]);
+                const double x = 0.375 + 0.25 * std::cos(2.0 * pi / n);
+                const double beta = (0.625 - x * x) / n;
+                Q = P * (1.0 - n * beta) + sum[i] * beta;
+            }
+        });
+        parallel_for(0, static_cast<long int>(N_corners), [&](long int i) -> void {
+            const auto c = static_cast<uint64_t>(i);
+            const auto t = hem.twin[c];
+            if( (t != half_edge_mesh::none) && (t < c) ) return;
+            const auto &A = hem.positions[hem.corner_vertex[c]];
+            const auto &B = hem.positions[hem.head(c)];
+            auto &Q = out.vertices[N_verts + edge[c]];
+            if(t == half_edge_mesh::none){
+                Q = (A + B) * 0.5;
+            }else{
+                const auto &C = hem.positions[hem.corner_vertex[half_edge_mesh::prev(c)]];
+                const auto &D = hem.positions[hem.corner_vertex[half_edge_mesh::prev(t)]];
+                Q = (A + B) * 0.375 + (C + D) * 0.125;
+            }
+        });
+
+        out.faces.resize(4 * N_faces);
+        parallel_for(0, static_cast<long int>(N_faces), [&](long int f) -> void {
+            const uint64_t c = 3 * static_cast<uint64_t>(f);
+            const auto a = hem.corner_vertex[c];
+            const auto b = hem.corner_vertex[c + 1];
+            const auto cc = hem.corner_vertex[c + 2];
+            const auto ab = N_verts + edge[c];
+            const auto bc = N_verts + edge[c + 1];
+            const auto ca = N_verts + edge[c + 2];
+            out.faces[4 * f + 0] = {{ a, ab, ca }};
+            out.faces[4 * f + 1] = {{ ab, b, bc }};
+            out.faces[4 * f + 2] = {{ ca, bc, cc }};
+            out.faces[4 * f + 3] = {{ ab, bc, ca }};
+        });
+
+        mesh = std::move(out);
+        FUNCINFO("The subdivided surface has " << mesh.vertices.size() << " vertices"
+                 " and " << mesh.faces.size() << " faces");
+    }
+    return;
+}
+
+
+void Simplify_Surface_Mesh(fv_surface_mesh<double, uint64_t> &mesh, long int edge_count_limit){
+    if(edge_count_limit <= 0) return;
+    const auto metadata = mesh.metadata;
+    half_edge_mesh hem(mesh);
+    const auto limit = static_cast<uint64_t>(edge_count_limit);
+
+    uint64_t N_edges = hem.edge_count();
+    if(N_edges <= limit) return;
+
+    const auto N_verts = static_cast<uint64_t>(hem.positions.size());
+    const auto N_corners = static_cast<uint64_t>(hem.corner_vertex.size());
+
+    // Boundaries are preserved by perpendicular planes, weighted so they dominate nearby face planes.
+    const double boundary_weight = 100.0;
+
+    std::vector<quadric_t> Q(N_verts);
+    for(uint64_t f = 0; f < N_corners / 3; ++f){
+        for(uint64_t j = 0; j < 3; ++j){
+            const auto c = 3 * f + j;
+            const auto &A = hem.positions[hem.corner_vertex[c]];
+            const auto &B = hem.positions[hem.head(c)];
+            const auto &C = hem.positions[hem.corner_vertex[half_edge_mesh::prev(c)]];
+            const auto N = (B - A).Cross(C - A);
+            const auto len = N.length();
+            if(!(0.0 < len)) continue;
+            const auto n = N / len;
+
+            // Each vertex receives the face plane, weighted by the face area.
+            Q[hem.corner_vertex[c]].add_plane(n, -n.Dot(A), 0.5 * len);
+
+            if(hem.twin[c] == half_edge_mesh::none){
+                const auto E = B - A;
+                const auto M = E.Cross(n);
+                const auto m_len = M.length();
+                if(0.0 < m_len){
+                    const auto m = M / m_len;
+                    const auto w = boundary_weight * E.sq_length();
+                    Q[hem.corner_vertex[c]].add_plane(m, -m.Dot(A), w);
+                    Q[hem.head(c)].add_plane(m, -m.Dot(A), w);
+                }
+            }
+        }
+    }
+
+    // The collapse stamp of the most recent change to each vertex. Candidates evaluated earlier are stale.
+    std::vector<uint64_t> version(N_verts, 0);
+    uint64_t N_collapses = 0;
+
+    const auto make_candidate = [&](uint64_t c) -> collapse_candidate_t {
+        collapse_candidate_t out;
+        out.stamp = N_collapses;
+        const auto u = hem.corner_vertex[c];
+        const auto v = hem.head(c);
+
+        const auto q = Q[u] + Q[v];
+        const auto &A = hem.positions[u];
+        const auto &B = hem.positions[v];
+        const auto M = (A + B) * 0.5;
+
+        // Positions far from the edge arise from nearly-singular systems, so the endpoints and midpoint are used.
+        vec3<double> p;
+        if( q.minimize(p)
+        &&  ((p - M).sq_length() <= 4.0 * (B - A).sq_length()) ){
+            out.p = p;
+            out.cost = q.evaluate(p);
+        }else{
+            out.p = M;
+            out.cost = q.evaluate(M);
+            for(const auto &x : { A, B }){
+                const auto cost = q.evaluate(x);
+                if(cost < out.cost){
+                    out.cost = cost;
+                    out.p = x;
+                }
+            }
+        }
+        return out;
+    };
+
+    // Candidates are stored per corner, and the queue holds only costs and corners. Since merged quadrics usually make
+    // collapses more expensive, re-evaluated candidates are only queued again if they became cheaper; otherwise the
+    // existing entry is re-queued with the new cost when it reaches the front.
+    std::vector<collapse_candidate_t> candidates(N_corners);
+    const auto unqueued = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> queued(N_corners, unqueued); // The cost of the pending entry for each corner, if any.
+    std::vector<std::pair<double, uint64_t>> entries;
+    for(uint64_t c = 0; c < N_corners; ++c){
+        const auto t = hem.twin[c];
+        if( (t == half_edge_mesh::none) || (c < t) ) entries.emplace_back(0.0, c);
+    }
+    parallel_for(0, static_cast<long int>(entries.size()), [&](long int i) -> void {
+        const auto c = entries[i].second;
+        candidates[c] = make_candidate(c);
+        entries[i].first = candidates[c].cost;
+        queued[c] = candidates[c].cost;
+    });
+    using queue_entry_t = std::pair<double, uint64_t>;
+    std::priority_queue<queue_entry_t, std::vector<queue_entry_t>, std::greater<queue_entry_t>>
+        queue(std::greater<queue_entry_t>(), std::move(entries));
+    const auto push = [&](uint64_t c) -> void {
+        candidates[c] = make_candidate(c);
+        if(!(queued[c] <= candidates[c].cost)){
+            queued[c] = candidates[c].cost;
+            queue.emplace(candidates[c].cost, c);
+        }
+    };
+
+    while( (limit < N_edges) && !queue.empty() ){
+        const auto top = queue.top();
+        queue.pop();
+        if(top.first != queued[top.second]) continue; // Superseded by a cheaper entry.
+        const auto cand = candidates[top.second];
+        if(top.first < cand.cost){
+            queued[top.second] = cand.cost;
+            queue.emplace(cand.cost, top.second);
+            continue;
+        }
+        queued[top.second] = unqueued;
+
+        const auto c = top.second;
+        const auto u = hem.corner_vertex[c];
+        const auto v = hem.head(c);
+        if( !hem.face_alive[half_edge_mesh::face(c)]
+        ||  (cand.stamp < version[u])
+        ||  (cand.stamp < version[v])
+        ||  !hem.can_collapse(c)
+        ||  !hem.collapse_preserves_orientation(c, cand.p) ) continue;
+
+        N_edges -= (hem.twin[c] == half_edge_mesh::none) ? 2 : 3;
+        hem.collapse(c, cand.p);
+        Q[v] = Q[u] + Q[v];
+        ++N_collapses;
+        version[u] = N_collapses;
+        version[v] = N_collapses;
+
+        // Re-evaluate the edges surrounding the merged vertex.
+        hem.for_each_corner_around(v, [&](uint64_t cc){
+            push(cc);
+            const auto pc = half_edge_mesh::prev(cc);
+            if(hem.twin[pc] == half_edge_mesh::none) push(pc);
+        });
+
+        if((N_collapses % 4096) == 0) throw_if_cancelled();
+    }
+
+    mesh = hem.to_fv_surface_mesh();
+    mesh.metadata = metadata;
+    FUNCINFO("Performed " << N_collapses << " edge collapses (" << N_edges << " edges remain)");
+    FUNCINFO("The simplified surface now has " << mesh.vertices.size() << " vertices"
+             " and " << mesh.faces.size() << " faces");
+    return;
+}
+
+
+namespace {
+
+// Splits edges longer than the given length. Triangles with several long edges are split into three or four
+// triangles at once, so a single pass can be performed concurrently. Returns false if no edges were split.
+bool Split_Long_Edges(fv_surface_mesh<double, uint64_t> &mesh, double max_length){
+    const half_edge_mesh hem(mesh);
+    const auto N_verts = static_cast<uint64_t>(hem.positions.size());
+    const auto N_corners = static_cast<uint64_t>(hem.corner_vertex.size());
+    const double max_sq_length = max_length * max_length;
+
+    std::vector<uint64_t> midpoint(N_corners, half_edge_mesh::none);
+    auto positions = hem.positions;
+    for(uint64_t c = 0; c < N_corners; ++c){
+        const auto t = hem.twin[c];
+        if( (t != half_edge_mesh::none) && (t < c) ) continue;
+        const auto &A = hem.positions[hem.corner_vertex[c]];
+        const auto &B = hem.positions[hem.head(c)];
+        if((B - A).sq_length() <= max_sq_length) continue;
+        midpoint[c] = static_cast<uint64_t>(positions.size());
+        if(t != half_edge_mesh::none) midpoint[t] = midpoint[c];
+        positions.push_back((A + B) * 0.5);
+    }
+    if(positions.size() == N_verts) return false;
+
+    std::vector<std::vector<uint64_t>> faces;
+    faces.reserve(N_corners);
+    for(uint64_t f = 0; f < N_corners / 3; ++f){
+        // Rotate the triangle so that the first edge is split, if any are.
+        uint64_t r = 0;
+        while( (r < 3) && (midpoint[3 * f + r] == half_edge_mesh::none) ) ++r;
+        if(r == 3){
+            faces.push_back({{ hem.corner_vertex[3 * f], hem.corner_vertex[3 * f + 1], hem.corner_vertex[3 * f + 2] }});
+            continue;
+        }
+        const uint64_t c0 = 3 * f + r;
+        const uint64_t c1 = half_edge_mesh::next(c0);
+        const uint64_t c2 = half_edge_mesh::next(c1);
+        const auto a = hem.corner_vertex[c0];
+        const auto b = hem.corner_vertex[c1];
+        const auto c = hem.corner_vertex[c2];
+        const auto m_ab = midpoint[c0];
+        const auto m_bc = midpoint[c1];
+        const auto m_ca = midpoint[c2];
+
+        const auto split_quad = [&](uint64_t w, uint64_t x, uint64_t y, uint64_t z){
+            // Splits the quadrilateral (w, x, y, z) along its shorter diagonal.
+            if((positions[y] - positions[w]).sq_length() <= (positions[z] - positions[x]).sq_length()){
+                faces.push_back({{ w, x, y }});
+                faces.push_back({{ w, y, z }});
+            }else{
+                faces.push_back({{ w, x, z }});
+                faces.push_back({{ x, y, z }});
+            }
+        };
+
+        if( (m_bc == half_edge_mesh::none) && (m_ca == half_edge_mesh::none) ){
+            faces.push_back({{ a, m_ab, c }});
+            faces.push_back({{ m_ab, b, c }});
+        }else if(m_ca == half_edge_mesh::none){
+            faces.push_back({{ m_ab, b, m_bc }});
+            split_quad(a, m_ab, m_bc, c);
+        }else if(m_bc == half_edge_mesh::none){
+            faces.push_back({{ a, m_ab, m_ca }});
+            split_quad(m_ab, b, c, m_ca);
+        }else{
+            faces.push_back({{ a, m_ab, m_ca }});
+            faces.push_back({{ m_ab, b, m_bc }});
+            faces.push_back({{ m_ca, m_bc, c }});
+            faces.push_back({{ m_ab, m_bc, m_ca }});
+        }
+    }
+
+    mesh.vertices = std::move(positions);
+    mesh.faces = std::move(faces);
+    return true;
+}
+
+} // namespace
+
+
+void Isotropic_Remesh(fv_surface_mesh<double, uint64_t> &mesh, double target_edge_length, long int iters){
+    if(!(0.0 < target_edge_length)) throw std::invalid_argument("Target edge length must be positive");
+    if(iters <= 0) return;
+
+    const auto metadata = mesh.metadata;
+    const double max_length = target_edge_length * 4.0 / 3.0;
+    const double min_length = target_edge_length * 4.0 / 5.0;
+
+    // Validate and triangulate the input before building the reference used for projection.
+    mesh = half_edge_mesh(mesh).to_fv_surface_mesh();
+    const Surface_Mesh_BVH reference(mesh);
+
+    for(long int iter = 0; iter < iters; ++iter){
+        throw_if_cancelled();
+
+        // Split. Each pass at least halves the longest edges, so few passes are needed.
+        for(long int pass = 0; pass < 32; ++pass){
+            if(!Split_Long_Edges(mesh, max_length)) break;
+        }
+
+        half_edge_mesh hem(mesh);
+        const auto N_corners = static_cast<uint64_t>(hem.corner_vertex.size());
+        const auto N_verts = static_cast<uint64_t>(hem.positions.size());
+
+        // Collapse short interior edges, unless doing so would create long edges.
+        for(uint64_t c = 0; c < N_corners; ++c){
+            if(!hem.face_alive[half_edge_mesh::face(c)]) continue;
+            const auto u = hem.corner_vertex[c];
+            const auto v = hem.head(c);
+            const auto &A = hem.positions[u];
+            const auto &B = hem.positions[v];
+            if(min_length * min_length <= (B - A).sq_length()) continue;
+            if( hem.is_boundary_vertex(u)
+            ||  hem.is_boundary_vertex(v)
+            ||  !hem.can_collapse(c) ) continue;
+
+            const auto p = (A + B) * 0.5;
+            bool short_enough = true;
+            for(const auto x : { u, v }){
+                hem.for_each_neighbour(x, [&](uint64_t w){
+                    if( (w != u) && (w != v)
+                    &&  (max_length * max_length < (hem.positions[w] - p).sq_length()) ) short_enough = false;
+                });
+            }
+            if( !short_enough
+            ||  !hem.collapse_preserves_orientation(c, p) ) continue;
+            hem.collapse(c, p);
+        }
+
+        // Flip edges to move valences towards 6 (or 4 along boundaries).
+        const auto target_valence = [&](uint64_t x) -> long int {
+            return hem.is_boundary_vertex(x) ? 4 : 6;
+        };
+        for(uint64_t c = 0; c < N_corners; ++c){
+            const auto t = hem.twin[c];
+            if( !hem.face_alive[half_edge_mesh::face(c)]
+            ||  (t == half_edge_mesh::none)
+            ||  (t < c)
+            ||  !hem.can_flip(c) ) continue;
+
+            const std::array<uint64_t, 4> x = {{ hem.corner_vertex[c],
+                                                 hem.head(c),
+                                                 hem.corner_vertex[half_edge_mesh::prev(c)],
+                                                 hem.corner_vertex[half_edge_mesh::prev(t)] }};
+            const std::array<long int, 4> delta = {{ -1, -1, 1, 1 }};
+            long int dev_before = 0;
+            long int dev_after = 0;
+            for(size_t i = 0; i < 4; ++i){
+                const auto val = static_cast<long int>(hem.valence(x[i]));
+                const auto tgt = target_valence(x[i]);
+                dev_before += std::abs(val - tgt);
+                dev_after += std::abs(val + delta[i] - tgt);
+            }
+            if(dev_before <= dev_after) continue;
+
+            // The new triangles must face the same way as the old.
+            const auto &A = hem.positions[x[0]];
+            const auto &B = hem.positions[x[1]];
+            const auto &C = hem.positions[x[2]];
+            const auto &D = hem.positions[x[3]];
+            const auto N_old = (B - A).Cross(C - A) + (A - B).Cross(D - B);
+            const auto N_0 = (C - D).Cross(A - D);
+            const auto N_1 = (D - C).Cross(B - C);
+            if( (N_0.Dot(N_old) <= 0.0)
+            ||  (N_1.Dot(N_old) <= 0.0) ) continue;
+            hem.flip(c);
+        }
+
+        // Tangential relaxation, then projection onto the original surface.
+        auto relaxed = hem.positions;
+        parallel_for(0, static_cast<long int>(N_verts), [&](long int i) -> void {
+            const auto v = static_cast<uint64_t>(i);
+            if( (hem.vertex_corner[v] == half_edge_mesh::none)
+            ||  hem.is_boundary_vertex(v) ) return;
+
+            vec3<double> centroid(0.0, 0.0, 0.0);
+            double n = 0.0;
+            hem.for_each_neighbour(v, [&](uint64_t w){
+                centroid += hem.positions[w];
+                n += 1.0;
+            });
+            if(n < 3.0) return;
+            centroid /= n;
+
+            const auto &P = hem.positions[v];
+            const auto N = hem.vertex_normal(v);
+            const auto d = centroid - P;
+            auto Q = P + d - N * N.Dot(d);
+
+            const auto hits = reference.all_intersections(Q - N * target_edge_length, Q + N * target_edge_length);
+            double best = std::numeric_limits<double>::infinity();
+            for(const auto &h : hits){
+                const auto dist = std::abs(h.t - 0.5);
+                if(dist < best){
+                    best = dist;
+                    Q = h.point;
+                }
+            }
+            relaxed[v] = Q;
+        });
+        hem.positions = std::move(relaxed);
+
+        mesh = hem.to_fv_surface_mesh();
+        FUNCINFO("After remeshing iteration " << (iter + 1) << " the surface has " << mesh.vertices.size()
+                 << " vertices and " << mesh.faces.size() << " faces");
+    }
+    mesh.metadata = metadata;
+    return;
+}
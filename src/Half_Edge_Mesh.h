@@ -0,0 +1,124 @@
+//Half_Edge_Mesh.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+// A compact, index-based half-edge representation of a triangle mesh.
+//
+// Half-edges are stored implicitly as triangle corners: corner c belongs to triangle c/3, and the half-edge of corner c
+// runs from the vertex of corner c to the vertex of the next corner in the same triangle. Only the vertex and the
+// opposite (i.e., twin) half-edge of each corner are stored, so the whole structure is a handful of flat arrays.
+//
+// Every edge must be shared by at most two consistently-oriented triangles. Vertices where several fans of triangles
+// meet (e.g., two cones touching at their apexes) are permitted, but are marked as non-manifold since their
+// neighbourhood cannot be traversed; the editing routines leave them alone.
+class half_edge_mesh {
+  public:
+    static constexpr uint64_t none = std::numeric_limits<uint64_t>::max();
+
+    std::vector<vec3<double>> positions;
+    std::vector<uint64_t> corner_vertex;  // Three per triangle.
+    std::vector<uint64_t> twin;           // Three per triangle. 'none' for boundary half-edges.
+    std::vector<uint64_t> vertex_corner;  // One corner per vertex. 'none' for unreferenced vertices.
+    std::vector<uint8_t> vertex_manifold;
+    std::vector<uint8_t> face_alive;      // Triangles are marked dead by collapse() rather than being removed.
+
+    // Polygons are fanned into triangles. Throws if an edge is shared by more than two faces, or by two faces with
+    // inconsistent orientations.
+    explicit half_edge_mesh(const fv_surface_mesh<double, uint64_t> &mesh);
+    half_edge_mesh(std::vector<vec3<double>> positions, std::vector<uint64_t> corner_vertex);
+
+    // Omits dead triangles and unreferenced vertices.
+    fv_surface_mesh<double, uint64_t> to_fv_surface_mesh() const;
+
+    static uint64_t next(uint64_t c){ return ((c % 3) == 2) ? (c - 2) : (c + 1); }
+    static uint64_t prev(uint64_t c){ return ((c % 3) == 0) ? (c + 2) : (c - 1); }
+    static uint64_t face(uint64_t c){ return c / 3; }
+
+    // The vertex at the end of the half-edge of corner c.
+    uint64_t head(uint64_t c) const { return this->corner_vertex[next(c)]; }
+
+    // Invokes f(c) for every corner c at a manifold vertex, in order around the vertex.
+    template <class F>
+    void for_each_corner_around(uint64_t v, F &&f) const {
+        const auto start = this->vertex_corner[v];
+        if(start == none) return;
+        uint64_t c = start;
+        while(true){
+            f(c);
+            c = this->twin[prev(c)];
+            if(c == start) return;
+            if(c == none) break;
+        }
+
+        // A boundary was encountered, so continue from the start in the other direction.
+        c = start;
+        while(true){
+            const auto t = this->twin[c];
+            if(t == none) return;
+            c = next(t);
+            f(c);
+        }
+    }
+
+    // Invokes f(w) for every vertex w adjacent to a manifold vertex.
+    template <class F>
+    void for_each_neighbour(uint64_t v, F &&f) const {
+        this->for_each_corner_around(v, [&](uint64_t c){
+            f(this->head(c));
+            if(this->twin[prev(c)] == none) f(this->corner_vertex[prev(c)]);
+        });
+    }
+
+    bool is_boundary_vertex(uint64_t v) const;
+    uint64_t valence(uint64_t v) const;
+    vec3<double> vertex_normal(uint64_t v) const; // Area-weighted.
+    uint64_t edge_count() const; // Of live triangles.
+
+    // Returns true if the half-edge of corner c can be collapsed topologically. Both vertices must be manifold, their
+    // common neighbours must be exactly the vertices opposite the edge, and an interior edge must not join two
+    // boundary vertices.
+    bool can_collapse(uint64_t c) const;
+
+    // Returns true if moving both vertices of the half-edge of corner c to p does not flip any surrounding triangle.
+    bool collapse_preserves_orientation(uint64_t c, const vec3<double> &p) const;
+
+    // Merges the vertex of corner c into the head of its half-edge, which is moved to p. The one or two triangles
+    // sharing the edge are marked dead. can_collapse() must be true.
+    void collapse(uint64_t c, const vec3<double> &p);
+
+    // Returns true if the interior edge of corner c can be flipped without creating a duplicate edge.
+    bool can_flip(uint64_t c) const;
+
+    // Replaces the edge shared by the two triangles of corner c with the other diagonal of the quadrilateral they
+    // form. can_flip() must be true.
+    void flip(uint64_t c);
+
+  private:
+    void link();
+};
+
+
+// Performs the given number of iterations of Loop subdivision. Boundaries are smoothed with the boundary rules.
+//
+// Each iteration splits every triangle into four and repositions the vertices, so the number of triangles grows by a
+// factor of four per iteration.
+void Loop_Subdivide(fv_surface_mesh<double, uint64_t> &mesh, long int iters);
+
+// Simplifies the mesh by collapsing edges, cheapest first, until no more than the given number of edges remain.
+//
+// The cost of a collapse is the quadric error metric of Garland and Heckbert (with area-weighted face quadrics and
+// constraint quadrics along boundaries) evaluated at the optimal position. Collapses that would alter the topology or
+// flip a triangle are skipped, so the limit may not be reached for some meshes.
+void Simplify_Surface_Mesh(fv_surface_mesh<double, uint64_t> &mesh, long int edge_count_limit);
+
+// Remeshes so that edges approach the given length, using the incremental scheme of Botsch and Kobbelt. Each
+// iteration splits long edges, collapses short edges, flips edges to equalize vertex valences, tangentially smooths,
+// and then projects vertices (along their normals) back onto the original surface. Boundary vertices do not move.
+void Isotropic_Remesh(fv_surface_mesh<double, uint64_t> &mesh, double target_edge_length, long int iters);
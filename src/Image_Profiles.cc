@@ -0,0 +1,99 @@
+//Image_Profiles.cc.
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorImages.h"
+
+#include "Image_Profiles.h"
+
+
+namespace {
+
+// Element strides of the pixel buffer, derived from the image's own indexing so no particular layout is assumed.
+struct image_strides {
+    int64_t base = 0;
+    int64_t row = 0;
+    int64_t col = 0;
+    int64_t chan = 0;
+};
+
+image_strides get_strides(const planar_image<float,double> &img){
+    image_strides s;
+    s.base = img.index(0, 0, 0);
+    s.row  = (1 < img.rows)     ? (img.index(1, 0, 0) - s.base) : 0;
+    s.col  = (1 < img.columns)  ? (img.index(0, 1, 0) - s.base) : 0;
+    s.chan = (1 < img.channels) ? (img.index(0, 0, 1) - s.base) : 0;
+    return s;
+}
+
+template <class F>
+void fill_pixels(planar_image<float,double> &img, F value_for){
+    const int64_t rows = img.rows;
+    const int64_t columns = img.columns;
+    const int64_t channels = img.channels;
+    if((rows <= 0) || (columns <= 0) || (channels <= 0)) return;
+
+    const auto s = get_strides(img);
+    float *data = img.data.data() + s.base;
+    for(int64_t r = 0; r < rows; ++r){
+        float *p = data + r * s.row;
+        for(int64_t c = 0; c < columns; ++c, p += s.col){
+            const auto val = static_cast<float>(value_for(r, c));
+            for(int64_t ch = 0; ch < channels; ++ch) p[ch * s.chan] = val;
+        }
+    }
+    return;
+}
+
+} // namespace
+
+
+void Accumulate_Rows_Columns(const planar_image<float,double> &img,
+                             std::vector<double> &row_sums,
+                             std::vector<double> &col_sums){
+    const int64_t rows = img.rows;
+    const int64_t columns = img.columns;
+    const int64_t channels = img.channels;
+    row_sums.assign(std::max<int64_t>(rows, 0), 0.0);
+    col_sums.assign(std::max<int64_t>(columns, 0), 0.0);
+    if((rows <= 0) || (columns <= 0) || (channels <= 0)) return;
+
+    // Values are accumulated in the same order as a row-major (row, column, channel) traversal.
+    const auto s = get_strides(img);
+    const float *data = img.data.data() + s.base;
+    double *cs = col_sums.data();
+    for(int64_t r = 0; r < rows; ++r){
+        const float *p = data + r * s.row;
+        double rs = 0.0;
+        for(int64_t c = 0; c < columns; ++c, p += s.col){
+            for(int64_t ch = 0; ch < channels; ++ch){
+                const double val = p[ch * s.chan];
+                rs += val;
+                cs[c] += val;
+            }
+        }
+        row_sums[r] = rs;
+    }
+    return;
+}
+
+
+void Fill_Rows(planar_image<float,double> &img, const std::vector<double> &row_vals){
+    if(static_cast<int64_t>(row_vals.size()) != img.rows){
+        throw std::invalid_argument("Row values do not match the image. Cannot continue.");
+    }
+    fill_pixels(img, [&](int64_t r, int64_t) -> double { return row_vals[r]; });
+    return;
+}
+
+
+void Fill_Columns(planar_image<float,double> &img, const std::vector<double> &col_vals){
+    if(static_cast<int64_t>(col_vals.size()) != img.columns){
+        throw std::invalid_argument("Column values do not match the image. Cannot continue.");
+    }
+    fill_pixels(img, [&](int64_t, int64_t c) -> double { return col_vals[c]; });
+    return;
+}
@@ -0,0 +1,19 @@
+//Image_Profiles.h.
+
+#pragma once
+
+#include <vector>
+
+#include "YgorImages.h"
+
+
+// Sums the pixel values (over all channels) along each row and each column of an image. The pixel buffer is traversed
+// once in storage order, so rows are reduced over contiguous memory. Outputs are resized to the number of rows and
+// columns, respectively.
+void Accumulate_Rows_Columns(const planar_image<float,double> &img,
+                             std::vector<double> &row_sums,
+                             std::vector<double> &col_sums);
+
+// Sets every channel of every pixel to the value of the pixel's row or column, respectively.
+void Fill_Rows(planar_image<float,double> &img, const std::vector<double> &row_vals);
+void Fill_Columns(planar_image<float,double> &img, const std::vector<double> &col_vals);
@@ -0,0 +1,154 @@
+//Image_Pyramid.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorImages.h"
+
+#include "Separable_Resampling.h"
+#include "Thread_Pool.h"
+#include "Image_Pyramid.h"
+
+
+namespace {
+
+// Maps an index onto [0, N) by mirroring about the boundaries.
+int64_t mirror(int64_t i, int64_t N){
+    const auto period = 2 * N;
+    i %= period;
+    if(i < 0) i += period;
+    return (i < N) ? i : (period - 1 - i);
+}
+
+// Binomial weights centred on each 2-sample block, i.e., samples 2s-1 through 2s+2 for output sample s.
+resampling_weights binomial_weights(int64_t N_in){
+    resampling_weights w;
+    w.taps = 4;
+    const auto N_out = (N_in + 1) / 2;
+    for(int64_t s = 0; s < N_out; ++s){
+        for(int64_t k = -1; k <= 2; ++k) w.index.push_back(mirror(2 * s + k, N_in));
+        for(const float x : { 0.125f, 0.375f, 0.375f, 0.125f }) w.weight.push_back(x);
+    }
+    return w;
+}
+
+int64_t halve(int64_t N){
+    return (N + 1) / 2;
+}
+
+} // namespace
+
+
+planar_image<float,double>
+Reduce_Image(const planar_image<float,double> &img,
+             image_pyramid_filter filter){
+    // The box filter and the geometry of the reduced image are shared, so both filters cover identical extents.
+    auto out = Decimate_Image(img, 2, 2);
+    if(filter == image_pyramid_filter::box) return out;
+    if(filter != image_pyramid_filter::gaussian){
+        throw std::invalid_argument("Image pyramid filter not understood");
+    }
+
+    const auto row_w = binomial_weights(img.rows);
+    const auto col_w = binomial_weights(img.columns);
+    for(int64_t chan = 0; chan < img.channels; ++chan){
+        const auto v = Resample_Image_Channel(img, chan, row_w, col_w);
+        for(int64_t r = 0; r < out.rows; ++r){
+            for(int64_t c = 0; c < out.columns; ++c){
+                out.reference(r, c, chan) = v[r * out.columns + c];
+            }
+        }
+    }
+    return out;
+}
+
+
+Image_Pyramid::Image_Pyramid(const planar_image_collection<float,double> &imagecoll,
+                             image_pyramid_filter filter)
+  : filter(filter),
+    original(&imagecoll){
+    if( (filter != image_pyramid_filter::box) && (filter != image_pyramid_filter::gaussian) ){
+        throw std::invalid_argument("Image pyramid filter not understood");
+    }
+
+    int64_t extent = 0;
+    for(const auto &img : imagecoll.images){
+        this->position_of.emplace(&img, this->collection.size());
+        this->collection.push_back(&img);
+        extent = std::max<int64_t>({ extent, img.rows, img.columns });
+    }
+
+    this->max_extents.push_back(extent);
+    while(1 < extent){
+        extent = halve(extent);
+        this->max_extents.push_back(extent);
+        this->levels.emplace_back( std::make_unique<level_t>() );
+    }
+}
+
+image_pyramid_filter Image_Pyramid::get_filter() const {
+    return this->filter;
+}
+
+size_t Image_Pyramid::size() const {
+    return this->max_extents.size();
+}
+
+const planar_image_collection<float,double> & Image_Pyramid::get_level(size_t level) const {
+    if(level == 0) return *(this->original);
+    if(this->size() <= level){
+        throw std::invalid_argument("Requested image pyramid level does not exist");
+    }
+
+    const auto &l = *(this->levels[level - 1]);
+    std::call_once(l.built, [&]() -> void {
+        // Each level is reduced from the preceding one, which is built first if needed.
+        const auto &prev = this->get_level(level - 1);
+        std::vector<const image_t *> prev_imgs;
+        for(const auto &img : prev.images) prev_imgs.push_back(&img);
+
+        l.imagecoll.images.resize(prev_imgs.size());
+        std::vector<image_t *> imgs;
+        for(auto &img : l.imagecoll.images) imgs.push_back(&img);
+
+        parallel_for(0, static_cast<long int>(imgs.size()), [&](long int i) -> void {
+            *(imgs[i]) = Reduce_Image(*(prev_imgs[i]), this->filter);
+        }, 1);
+        l.images.assign(std::begin(imgs), std::end(imgs));
+    });
+    return l.imagecoll;
+}
+
+size_t Image_Pyramid::find_level(int64_t max_extent) const {
+    for(size_t level = 0; level < this->size(); ++level){
+        if(this->max_extents[level] <= max_extent) return level;
+    }
+    return this->size() - 1;
+}
+
+const Image_Pyramid::image_t * Image_Pyramid::find_image(const image_t *original, size_t level) const {
+    const auto it = this->position_of.find(original);
+    if(it == std::end(this->position_of)) return nullptr;
+    if(level == 0) return original;
+
+    this->get_level(level);
+    return this->levels[level - 1]->images[it->second];
+}
+
+bool Image_Pyramid::is_current(const planar_image_collection<float,double> &imagecoll) const {
+    if( (&imagecoll != this->original)
+    ||  (imagecoll.images.size() != this->collection.size()) ) return false;
+
+    size_t i = 0;
+    for(const auto &img : imagecoll.images){
+        if(&img != this->collection[i++]) return false;
+    }
+    return true;
+}
+
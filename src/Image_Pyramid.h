@@ -0,0 +1,84 @@
+//Image_Pyramid.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "YgorImages.h"
+
+
+// How each level of an image pyramid is reduced from the preceding level.
+enum class image_pyramid_filter {
+    box,       // Each 2x2 block of pixels is averaged, as with Decimate_Image().
+    gaussian,  // Each 2x2 block is weighted by the separable binomial kernel [1,3,3,1]/8 along rows and columns, which
+               // suppresses more aliasing than a box. Boundaries are mirrored.
+};
+
+// Reduced-resolution copies of every image in a collection, for coarse-to-fine algorithms or previews.
+//
+// Level 0 is the collection itself, and each following level halves the rows and columns of the preceding level's
+// images (rounding up), so level k pixels are 2^k times as large as the originals along rows and columns. Images are
+// reduced in-plane only, so every level holds one image per original image, in collection order, covering the same
+// extent. Metadata is copied, and the Rows and Columns are updated. Levels are added until every image is a single
+// pixel.
+//
+// Levels are built lazily on first access (along with any preceding levels), so callers that only need a few coarse
+// levels avoid building the rest eagerly. The pyramid holds a reference to the collection, so it is invalidated
+// whenever images are added, removed, or altered. is_current() detects added or removed images;
+// Image_Array::get_image_pyramid() also detects in-place edits.
+class Image_Pyramid {
+  public:
+    using image_t = planar_image<float,double>;
+
+    explicit Image_Pyramid(const planar_image_collection<float,double> &imagecoll,
+                           image_pyramid_filter filter = image_pyramid_filter::box);
+
+    Image_Pyramid(const Image_Pyramid &) = delete;
+    Image_Pyramid & operator=(const Image_Pyramid &) = delete;
+
+    image_pyramid_filter get_filter() const;
+
+    // Number of levels, including level 0.
+    size_t size() const;
+
+    // Returns the images of the given level. Builds the level (and any preceding levels) on first access. Throws if
+    // the level does not exist.
+    const planar_image_collection<float,double> & get_level(size_t level) const;
+
+    // Returns the finest level whose images all have no more than max_extent rows and columns, or the coarsest level
+    // if there is none.
+    size_t find_level(int64_t max_extent) const;
+
+    // Returns the image of the given level corresponding to the original image, or nullptr if the image is not part of
+    // the pyramid.
+    const image_t * find_image(const image_t *original, size_t level) const;
+
+    // Returns true if the collection still has the same images, in the same order, as when the pyramid was created.
+    bool is_current(const planar_image_collection<float,double> &imagecoll) const;
+
+  private:
+    struct level_t {
+        mutable std::once_flag built;
+        mutable planar_image_collection<float,double> imagecoll;
+        mutable std::vector<const image_t *> images; // In collection order.
+    };
+
+    image_pyramid_filter filter;
+    const planar_image_collection<float,double> *original;
+    std::vector<const image_t *> collection; // In collection order.
+    std::unordered_map<const image_t *, size_t> position_of;
+    std::vector<int64_t> max_extents; // The largest row or column count of each level's images.
+    std::vector<std::unique_ptr<level_t>> levels; // Levels 1 and above.
+};
+
+// Reduces the image's rows and columns by half (rounding up) with the given filter, as for one level of an image
+// pyramid.
+planar_image<float,double>
+Reduce_Image(const planar_image<float,double> &img,
+             image_pyramid_filter filter);
+
@@ -0,0 +1,186 @@
+//Image_Slice_Index.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Image_Slice_Index.h"
+
+
+namespace {
+
+using rtree_point_t = boost::geometry::model::point<double, 3, boost::geometry::cs::cartesian>;
+using rtree_box_t = boost::geometry::model::box<rtree_point_t>;
+using rtree_value_t = std::pair<rtree_box_t, size_t>;
+
+// Tolerance used to pad image extents, so points on an image's boundary are not missed due to round-off.
+constexpr double extent_eps = 1.0E-6;
+
+vec3<double> Image_Normal(const planar_image<float,double> &img){
+    return img.row_unit.Cross(img.col_unit).unit();
+}
+
+} // namespace
+
+
+struct Image_Slice_Index::rtree_t {
+    boost::geometry::index::rtree<rtree_value_t, boost::geometry::index::rstar<16>> tree;
+};
+
+
+bool Image_Slice_Index::fingerprint_t::operator==(const fingerprint_t &rhs) const {
+    return (this->img == rhs.img)
+        && (this->anchor == rhs.anchor)
+        && (this->offset == rhs.offset)
+        && (this->row_unit == rhs.row_unit)
+        && (this->col_unit == rhs.col_unit)
+        && (this->rows == rhs.rows)
+        && (this->columns == rhs.columns)
+        && (this->pxl_dx == rhs.pxl_dx)
+        && (this->pxl_dy == rhs.pxl_dy)
+        && (this->pxl_dz == rhs.pxl_dz);
+}
+
+
+Image_Slice_Index::fingerprint_t Image_Slice_Index::fingerprint(const image_t &img){
+    fingerprint_t f;
+    f.img      = &img;
+    f.anchor   = img.anchor;
+    f.offset   = img.offset;
+    f.row_unit = img.row_unit;
+    f.col_unit = img.col_unit;
+    f.rows     = img.rows;
+    f.columns  = img.columns;
+    f.pxl_dx   = img.pxl_dx;
+    f.pxl_dy   = img.pxl_dy;
+    f.pxl_dz   = img.pxl_dz;
+    return f;
+}
+
+
+Image_Slice_Index::Image_Slice_Index(const planar_image_collection<float,double> &imagecoll){
+    this->fingerprints.reserve(imagecoll.images.size());
+    for(const auto &img : imagecoll.images){
+        this->fingerprints.emplace_back( fingerprint(img) );
+    }
+    if(this->fingerprints.empty()) return;
+
+    // Determine whether all images share an orientation.
+    this->normal = Image_Normal(imagecoll.images.front());
+    this->parallel = std::all_of(std::begin(imagecoll.images), std::end(imagecoll.images),
+                                 [&](const planar_image<float,double> &img) -> bool {
+                                     return (1.0 - extent_eps) < std::abs(Image_Normal(img).Dot(this->normal));
+                                 });
+
+    if(this->parallel){
+        this->slabs.reserve(this->fingerprints.size());
+        size_t i = 0;
+        for(const auto &img : imagecoll.images){
+            const auto c = this->normal.Dot(img.position(0, 0));
+            const auto half = 0.5 * std::abs(img.pxl_dz) + extent_eps;
+            slab_t s;
+            s.lower = c - half;
+            s.upper = c + half;
+            s.index = i++;
+            this->max_thickness = std::max(this->max_thickness, s.upper - s.lower);
+            this->slabs.emplace_back(s);
+        }
+        std::stable_sort(std::begin(this->slabs), std::end(this->slabs),
+                         [](const slab_t &l, const slab_t &r) -> bool { return (l.lower < r.lower); });
+
+    }else{
+        std::vector<rtree_value_t> boxes;
+        boxes.reserve(this->fingerprints.size());
+        size_t i = 0;
+        for(const auto &img : imagecoll.images){
+            const auto N = Image_Normal(img);
+            const auto R = img.row_unit * (0.5 * img.pxl_dx);
+            const auto C = img.col_unit * (0.5 * img.pxl_dy);
+            const auto Z = N * (0.5 * img.pxl_dz);
+            const auto p0 = img.position(0, 0);
+            const auto p1 = img.position(img.rows - 1, img.columns - 1);
+
+            vec3<double> lo( std::numeric_limits<double>::infinity(),
+                             std::numeric_limits<double>::infinity(),
+                             std::numeric_limits<double>::infinity() );
+            vec3<double> hi = lo * -1.0;
+            for(const auto &p : { p0 - R - C, p1 + R + C,
+                                  img.position(img.rows - 1, 0) + R - C,
+                                  img.position(0, img.columns - 1) - R + C }){
+                for(const auto &q : { p - Z, p + Z }){
+                    lo.x = std::min(lo.x, q.x - extent_eps);
+                    lo.y = std::min(lo.y, q.y - extent_eps);
+                    lo.z = std::min(lo.z, q.z - extent_eps);
+                    hi.x = std::max(hi.x, q.x + extent_eps);
+                    hi.y = std::max(hi.y, q.y + extent_eps);
+                    hi.z = std::max(hi.z, q.z + extent_eps);
+                }
+            }
+            boxes.emplace_back( rtree_box_t( rtree_point_t(lo.x, lo.y, lo.z),
+                                             rtree_point_t(hi.x, hi.y, hi.z) ), i++ );
+        }
+        this->rtree = std::make_unique<rtree_t>();
+        this->rtree->tree = decltype(this->rtree->tree)(boxes); // Bulk loading gives a better tree.
+    }
+}
+
+Image_Slice_Index::~Image_Slice_Index() = default;
+
+
+std::list<const Image_Slice_Index::image_t *>
+Image_Slice_Index::get_images_which_encompass_point(const vec3<double> &p) const {
+    std::vector<size_t> candidates;
+
+    if(this->parallel){
+        const auto d = this->normal.Dot(p);
+        auto it = std::lower_bound(std::begin(this->slabs), std::end(this->slabs), d - this->max_thickness,
+                                   [](const slab_t &s, double v) -> bool { return (s.lower < v); });
+        for( ; (it != std::end(this->slabs)) && (it->lower <= d); ++it){
+            if(d <= it->upper) candidates.emplace_back(it->index);
+        }
+
+    }else if(this->rtree != nullptr){
+        std::vector<rtree_value_t> hits;
+        this->rtree->tree.query( boost::geometry::index::intersects(rtree_point_t(p.x, p.y, p.z)),
+                                 std::back_inserter(hits) );
+        for(const auto &h : hits) candidates.emplace_back(h.second);
+    }
+
+    std::sort(std::begin(candidates), std::end(candidates));
+
+    std::list<const image_t *> out;
+    for(const auto &i : candidates){
+        const auto *img = this->fingerprints[i].img;
+        if(img->encompasses_point(p)) out.emplace_back(img);
+    }
+    return out;
+}
+
+
+bool Image_Slice_Index::is_current(const planar_image_collection<float,double> &imagecoll) const {
+    if(imagecoll.images.size() != this->fingerprints.size()) return false;
+    auto f_it = std::begin(this->fingerprints);
+    for(const auto &img : imagecoll.images){
+        if(!(fingerprint(img) == *f_it)) return false;
+        ++f_it;
+    }
+    return true;
+}
+
+
+bool Image_Slice_Index::is_parallel() const {
+    return this->parallel;
+}
+
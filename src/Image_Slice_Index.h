@@ -0,0 +1,77 @@
+//Image_Slice_Index.h.
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+
+// An index for quickly locating the images that encompass a given point.
+//
+// planar_image_collection::get_images_which_encompass_point() visits every image, which is costly when sampling many
+// points (e.g., ray casting through a dose grid). When all images share an orientation, which is typical, they are
+// sorted along their common normal and lookups are performed with a binary search. Otherwise a bounding-box R-tree is
+// used. Either way, candidate images are confirmed with planar_image::encompasses_point() and reported in the order
+// they appear in the collection, so results match the linear scan.
+//
+// The index holds pointers into the collection, so it is invalidated whenever images are added, removed, or
+// repositioned. is_current() can be used to detect such changes.
+class Image_Slice_Index {
+  public:
+    using image_t = planar_image<float,double>;
+
+    explicit Image_Slice_Index(const planar_image_collection<float,double> &imagecoll);
+    ~Image_Slice_Index();
+
+    Image_Slice_Index(const Image_Slice_Index &) = delete;
+    Image_Slice_Index & operator=(const Image_Slice_Index &) = delete;
+
+    // Returns the images which encompass the point, in collection order.
+    std::list<const image_t *> get_images_which_encompass_point(const vec3<double> &p) const;
+
+    // Returns true if the collection still has the same images, in the same order and geometry, as when the index was
+    // built. This is linear in the number of images, but much cheaper than rebuilding the index.
+    bool is_current(const planar_image_collection<float,double> &imagecoll) const;
+
+    // Whether all images shared an orientation, enabling the sorted (rather than R-tree) lookup.
+    bool is_parallel() const;
+
+  private:
+    struct fingerprint_t {
+        const image_t *img = nullptr;
+        vec3<double> anchor;
+        vec3<double> offset;
+        vec3<double> row_unit;
+        vec3<double> col_unit;
+        long int rows = 0;
+        long int columns = 0;
+        double pxl_dx = 0.0;
+        double pxl_dy = 0.0;
+        double pxl_dz = 0.0;
+
+        bool operator==(const fingerprint_t &rhs) const;
+    };
+    std::vector<fingerprint_t> fingerprints; // In collection order.
+    static fingerprint_t fingerprint(const image_t &img);
+
+    // Sorted lookup along the common normal.
+    bool parallel = false;
+    vec3<double> normal;
+    struct slab_t {
+        double lower = 0.0; // Extent of the image along the normal.
+        double upper = 0.0;
+        size_t index = 0;   // Position in the collection.
+    };
+    std::vector<slab_t> slabs; // Sorted by lower bound.
+    double max_thickness = 0.0;
+
+    // R-tree lookup for images with differing orientations.
+    struct rtree_t;
+    std::unique_ptr<rtree_t> rtree;
+};
+
@@ -12,8 +12,10 @@
 #include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <deque>
 #include <exception>
+#include <fstream>
 #include <optional>
 #include <functional>
 #include <iostream>
@@ -22,22 +24,29 @@
 #include <map>
 #include <memory>         //Needed for std::unique_ptr.
 #include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <tuple>
 #include <utility>        //Needed for std::pair.
 #include <vector>
 
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-but-set-variable"
 #pragma GCC diagnostic ignored "-Wunused-but-set-parameter"
 #include "imebra.h"
+#include "imebra20121219/library/base/include/memoryStream.h"
 
 #pragma GCC diagnostic pop
 
 #include "Imebra_Shim.h"
 #include "DCMA_DICOM.h"
+#include "Content_Hash.h"
 #include "Structs.h"
+#include "Thread_Pool.h"
 #include "YgorContainers.h" //Needed for 'bimap' class.
 #include "YgorMath.h"       //Needed for 'vec3' class.
 #include "YgorMisc.h"       //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -585,21 +594,92 @@ FUNCINFO("    This node is a leaf node. Creating a leaf tag");
 
 
 
-//------------------ General ----------------------
-//This is used to grab the contents of a single DICOM tag. It can be used for whatever. Some routines
-// use it to grab specific things. Each invocation involves disk access and file parsing.
+//------------------ Parsed files -----------------
+struct Parsed_DICOM_File {
+    std::string filename;
+    puntoexe::ptr<puntoexe::imebra::dataSet> top_data_set;
+    puntoexe::ptr<puntoexe::memory> contents; // The raw data, if it was parsed from memory rather than a file.
+};
+
+void Initialize_DICOM_Codecs(){
+    static const bool initialized = [](){
+        using namespace puntoexe;
+        auto factory = imebra::codecs::codecFactory::getCodecFactory();
+        if(imebra::codecs::codecFactory::getCodec(L"1.2.840.10008.1.2.1") == nullptr){ // Explicit VR little endian.
+            factory->registerCodec(ptr<imebra::codecs::codec>(new imebra::codecs::dicomCodec));
+        }
+        if(imebra::codecs::codecFactory::getCodec(L"1.2.840.10008.1.2.4.50") == nullptr){ // JPEG baseline.
+            factory->registerCodec(ptr<imebra::codecs::codec>(new imebra::codecs::jpegCodec));
+        }
+        return true;
+    }();
+    static_cast<void>(initialized);
+    return;
+}
+
+//Reads and decodes a DICOM file once so that the result can be shared by the accessors below.
 //
-//NOTE: On error, the output will be an empty string.
-std::string get_tag_as_string(const std::string &filename, size_t U, size_t L){
+//NOTE: Throws if the file cannot be opened or parsed.
+std::shared_ptr<Parsed_DICOM_File> Parse_DICOM_File(const std::string &filename){
     using namespace puntoexe;
     ptr<puntoexe::stream> readStream(new puntoexe::stream);
     readStream->openFile(filename.c_str(), std::ios::in);
-    if(readStream == nullptr) return std::string("");
 
     ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
     ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
-    if(TopDataSet == nullptr) return std::string("");
-    return TopDataSet->getString(U, 0, L, 0);
+    if(TopDataSet == nullptr){
+        throw std::runtime_error("Unable to parse file '"_s + filename + "'. Is it valid DICOM?");
+    }
+
+    auto out = std::make_shared<Parsed_DICOM_File>();
+    out->filename = filename;
+    out->top_data_set = TopDataSet;
+    return out;
+}
+
+std::shared_ptr<Parsed_DICOM_File> Parse_DICOM_Buffer(const std::string &contents, const std::string &name){
+    using namespace puntoexe;
+    ptr<memory> mem(new memory);
+    mem->assign(reinterpret_cast<const imbxUint8 *>(contents.data()), static_cast<imbxUint32>(contents.size()));
+    ptr<baseStream> readStream(new memoryStream(mem));
+
+    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
+    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    if(TopDataSet == nullptr){
+        throw std::runtime_error("Unable to parse '"_s + name + "'. Is it valid DICOM?");
+    }
+
+    auto out = std::make_shared<Parsed_DICOM_File>();
+    out->filename = name;
+    out->top_data_set = TopDataSet;
+    out->contents = mem;
+    return out;
+}
+
+std::string get_filename(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    return pdf->filename;
+}
+
+
+//------------------ General ----------------------
+//This is used to grab the contents of a single DICOM tag. It can be used for whatever. Some routines
+// use it to grab specific things. Each invocation involves disk access and file parsing.
+//
+//NOTE: On error, the output will be an empty string.
+std::string get_tag_as_string(const std::string &filename, size_t U, size_t L){
+    std::shared_ptr<Parsed_DICOM_File> pdf;
+    try{
+        pdf = Parse_DICOM_File(filename);
+    }catch(const std::exception &){
+        return std::string("");
+    }
+    return get_tag_as_string(pdf, U, L);
+}
+
+std::string get_tag_as_string(const std::shared_ptr<Parsed_DICOM_File> &pdf, size_t U, size_t L){
+    if( (pdf == nullptr) 
+    ||  (pdf->top_data_set == nullptr) ) return std::string("");
+    return pdf->top_data_set->getString(U, 0, L, 0);
 }
 
 std::string get_modality(const std::string &filename){
@@ -607,30 +687,46 @@ std::string get_modality(const std::string &filename){
     return get_tag_as_string(filename,0x0008,0x0060);
 }
 
+std::string get_modality(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    return get_tag_as_string(pdf,0x0008,0x0060);
+}
+
 std::string get_patient_ID(const std::string &filename){
     //Should exist in each DICOM file.
     return get_tag_as_string(filename,0x0010,0x0020);
 }
 
+std::string get_patient_ID(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    return get_tag_as_string(pdf,0x0010,0x0020);
+}
+
 //Mass top-level tag enumeration, for ingress into database.
 //
 //NOTE: May not be complete. Add additional tags as needed!
 std::map<std::string,std::string> get_metadata_top_level_tags(const std::string &filename){
+    //Attempt to parse the DICOM file and harvest the elements of interest.
+    std::shared_ptr<Parsed_DICOM_File> pdf;
+    try{
+        pdf = Parse_DICOM_File(filename);
+    }catch(const std::exception &){
+        FUNCWARN("Could not parse file '" << filename << "'. Is it valid DICOM? Cannot continue");
+        return std::map<std::string,std::string>();
+    }
+    return get_metadata_top_level_tags(pdf);
+}
+
+std::map<std::string,std::string> get_metadata_top_level_tags(const std::shared_ptr<Parsed_DICOM_File> &pdf){
     std::map<std::string,std::string> out;
     const auto ctrim = CANONICALIZE::TRIM_ENDS;
 
-    //Attempt to parse the DICOM file and harvest the elements of interest. We are only interested in
-    // top-level elements specifying metadata (i.e., not pixel data) and will not need to recurse into 
-    // any DICOM sequences.
-    puntoexe::ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(filename.c_str(), std::ios::in);
-    if(readStream == nullptr){
-        FUNCWARN("Could not parse file '" << filename << "'. Is it valid DICOM? Cannot continue");
+    //We are only interested in top-level elements specifying metadata (i.e., not pixel data) and will not need to
+    // recurse into any DICOM sequences.
+    if( (pdf == nullptr)
+    ||  (pdf->top_data_set == nullptr) ){
+        FUNCWARN("Parsed DICOM file not valid. Cannot continue");
         return out;
     }
-
-    puntoexe::ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    puntoexe::ptr<puntoexe::imebra::dataSet> tds = puntoexe::imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    puntoexe::ptr<puntoexe::imebra::dataSet> tds = pdf->top_data_set;
 
     //We pull out all the data we need as strings. For single element strings, the SQL engine can directly perform
     // the type casting. The benefit of this is twofold: (1) the SQL engine hides the checking code, simplifying
@@ -1118,6 +1214,58 @@ std::map<std::string,std::string> get_metadata_top_level_tags(const std::string
     return out;
 }
 
+//Content fingerprint, for duplicate detection.
+uint64_t get_content_hash(const std::string &filename){
+    return get_content_hash(Parse_DICOM_File(filename));
+}
+
+uint64_t get_content_hash(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    if( (pdf == nullptr)
+    ||  (pdf->top_data_set == nullptr) ){
+        throw std::invalid_argument("Parsed DICOM file not valid. Cannot compute content hash.");
+    }
+
+    //Only the tags that identify the object and describe how the pixel data is to be interpreted are considered.
+    // Tags are trimmed when harvested, so padding differences are ignored.
+    auto mmap = get_metadata_top_level_tags(pdf);
+    content_hasher H;
+    for(const auto &key : { "PatientID", "StudyInstanceUID", "SeriesInstanceUID", "SOPInstanceUID", "SOPClassUID",
+                            "FrameOfReferenceUID", "Modality", "Rows", "Columns", "NumberOfFrames",
+                            "SamplesPerPixel", "PhotometricInterpretation", "BitsAllocated", "BitsStored",
+                            "PixelRepresentation" }){
+        H.add(mmap[key]);
+    }
+
+    const bool create_if_not_found = false;
+    auto tag_ptr = pdf->top_data_set->getTag(0x7FE0, 0, 0x0010, create_if_not_found);
+    if(tag_ptr != nullptr){
+        //Encapsulated pixel data is spread over several buffers (i.e., the offset table and fragments).
+        const auto N_buffers = tag_ptr->getBuffersCount();
+        H.add(static_cast<uint64_t>(N_buffers));
+        for(uint32_t b = 0; b < N_buffers; ++b){
+            auto rdh_ptr = tag_ptr->getDataHandlerRaw(b, false, "");
+            if(rdh_ptr == nullptr) throw std::runtime_error("Unable to access pixel data. Cannot compute content hash.");
+            H.add(reinterpret_cast<const uint8_t *>(rdh_ptr->getMemoryBuffer()), static_cast<size_t>(rdh_ptr->getSize()));
+        }
+    }else if(pdf->contents != nullptr){
+        const auto N_bytes = static_cast<uint64_t>(pdf->contents->size());
+        H.add(reinterpret_cast<const uint8_t *>(pdf->contents->data()), static_cast<size_t>(N_bytes));
+        H.add(N_bytes);
+    }else{
+        std::ifstream is(pdf->filename, std::ios::in | std::ios::binary);
+        if(!is) throw std::runtime_error("Unable to read file '"_s + pdf->filename + "'. Cannot compute content hash.");
+        std::vector<char> buf(static_cast<size_t>(1) << 20);
+        uint64_t N_bytes = 0;
+        while(is){
+            is.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+            const auto N = static_cast<size_t>(is.gcount());
+            H.add(reinterpret_cast<const uint8_t *>(buf.data()), N);
+            N_bytes += N;
+        }
+        H.add(N_bytes);
+    }
+    return H.digest();
+}
 
 
 //------------------ Contours ---------------------
@@ -1125,12 +1273,12 @@ std::map<std::string,std::string> get_metadata_top_level_tags(const std::string
 //Returns a bimap with the (raw) ROI tags and their corresponding ROI numbers. The ROI numbers are
 // arbitrary identifiers used within the DICOM file to identify contours more conveniently.
 bimap<std::string,long int> get_ROI_tags_and_numbers(const std::string &FilenameIn){
-    using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(FilenameIn.c_str(), std::ios::in);
+    return get_ROI_tags_and_numbers(Parse_DICOM_File(FilenameIn));
+}
 
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+bimap<std::string,long int> get_ROI_tags_and_numbers(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    using namespace puntoexe;
+    ptr<imebra::dataSet> TopDataSet = pdf->top_data_set;
     ptr<imebra::dataSet> SecondDataSet;
 
     size_t i=0, j;
@@ -1165,16 +1313,17 @@ bimap<std::string,long int> get_ROI_tags_and_numbers(const std::string &Filename
 
 //Returns contour data from a DICOM RTSTRUCT file sorted into ROI-specific collections.
 std::unique_ptr<Contour_Data> get_Contour_Data(const std::string &filename){
+    return get_Contour_Data(Parse_DICOM_File(filename));
+}
+
+std::unique_ptr<Contour_Data> get_Contour_Data(const std::shared_ptr<Parsed_DICOM_File> &pdf){
     auto output = std::make_unique<Contour_Data>();
-    bimap<std::string,long int> tags_names_and_numbers = get_ROI_tags_and_numbers(filename);
+    bimap<std::string,long int> tags_names_and_numbers = get_ROI_tags_and_numbers(pdf);
 
-    auto FileMetadata = get_metadata_top_level_tags(filename);
+    auto FileMetadata = get_metadata_top_level_tags(pdf);
 
     using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(filename.c_str(), std::ios::in);
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    ptr<imebra::dataSet> TopDataSet = pdf->top_data_set;
     ptr<imebra::dataSet> SecondDataSet, ThirdDataSet;
 
     //Collect the data into a container of contours with meta info. It may be unordered (within the file).
@@ -1255,19 +1404,18 @@ std::unique_ptr<Contour_Data> get_Contour_Data(const std::string &filename){
 //-------------------- Images ----------------------
 //This routine will often result in an array with only a single image. So collate output as needed.
 //
-// NOTE: I believe this routine is only valid for single frame images, like common CT and MR images.
-//       PT and US have not been tested. RTDOSE files should use the Load_Dose_Array code, which 
-//       handles multi-frame images (and thus might be adaptable for other non-RTDOSE multi-frame 
-//       images).
+// NOTE: Multi-frame images (e.g., 'enhanced' CT and MR) result in one image per frame.
+//       PT and US have not been tested. RTDOSE files should use the Load_Dose_Array code.
 std::unique_ptr<Image_Array> Load_Image_Array(const std::string &FilenameIn){
+    return Load_Image_Array(Parse_DICOM_File(FilenameIn));
+}
+
+//Reads the metadata and geometry of a single-frame image. The pixel buffer is allocated, but not filled.
+static std::unique_ptr<Image_Array> Load_Image_Array_Header(const std::shared_ptr<Parsed_DICOM_File> &pdf){
     auto out = std::make_unique<Image_Array>();
 
     using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(FilenameIn.c_str(), std::ios::in);
-
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    ptr<imebra::dataSet> TopDataSet = pdf->top_data_set;
 
     //Helper routines that do not create tags when they are missing.
     //
@@ -1443,175 +1591,365 @@ std::unique_ptr<Image_Array> Load_Image_Array(const std::string &FilenameIn){
         //       in this routine.
     }
 
-    // --------------------------------------- Image Pixel Data ---------------------------------------------
-    {    
-        out->imagecoll.images.emplace_back();
+    // ---------------------------------------- Image Geometry ----------------------------------------------
+    //The number of channels is only known for certain once the pixel data are decoded. Except for RTIMAGEs, the pixels
+    // are converted to 'MONOCHROME2', which has a single channel.
+    const auto samples_per_pixel = retrieve_coalesce_as_long_int({ {0x0028, 0x0002, 0} }).value_or(1.0);
+    const auto img_chnls = (modality == "RTIMAGE") ? static_cast<long int>(samples_per_pixel) : 1L;
 
-        //--------------------------------------------------------------------------------------------------
-        //Retrieve the pixel data from file. This is an excessively long exercise!
-        ptr<puntoexe::imebra::image> firstImage;
-        try{
-            firstImage = TopDataSet->getImage(0);
-        }catch(const std::exception &e){
-            throw std::domain_error("This file does not have accessible pixel data."
-                                    " The DICOM image loader should not be called for this file");
-        }
-    
-        //Process image using modalityVOILUT transform to convert its pixel values into meaningful values.
-        // From what I can tell, this conversion is necessary to transform the raw data from a possibly
-        // manufacturer-specific, proprietary format into something physically meaningful for us. 
-        //
-        // I have not experimented with disabling this conversion. Leaving it intact causes the datum from
-        // a Philips "Interra" machine's PAR/REC format to coincide with the exported DICOM data.
-        ptr<imebra::transforms::transform> modVOILUT(new imebra::transforms::modalityVOILUT(TopDataSet));
-        imbxUint32 width, height;
-        firstImage->getSize(&width, &height);
-        ptr<imebra::image> convertedImage(modVOILUT->allocateOutputImage(firstImage, width, height));
-        modVOILUT->runTransform(firstImage, 0, 0, width, height, convertedImage, 0, 0);
+    out->imagecoll.images.emplace_back();
+    auto &img = out->imagecoll.images.back();
+    img.metadata = get_metadata_top_level_tags(pdf);
+    img.init_orientation(image_orien_r,image_orien_c);
+    img.init_buffer(image_rows, image_cols, img_chnls); //Underlying type specifies per-pixel space allocated.
 
-    
-        //Convert the 'convertedImage' into an image suitable for the viewing on screen. The VOILUT transform 
-        // applies the contrast suggested by the dataSet to the image. Apply the first one we find. Relevant
-        // DICOM tags reside around (0x0028,0x3010) and (0x0028,0x1050).
-        //
-        // This conversion uses the first suggested transformation found in the DICOM file, and will vary
-        // from file to file. Generally, the transformation scales the pixel values to cover the range of the
-        // available pixel range (i.e., u16). The transformation *CAN* induce clipping or truncation which 
-        // cannot be recovered from!
-        //
-        // Therefore, in my opinion, it is never worthwhile to perform this conversion. If you want to window
-        // or scale the values, you should do so as needed using the WindowCenter and WindowWidth values 
-        // directly.
-        //
-        // Report available conversions:
-        if(false){
-            ptr<imebra::transforms::VOILUT> myVoiLut(new imebra::transforms::VOILUT(TopDataSet));
-            std::vector<imbxUint32> VoiLutIds;
-            for(imbxUint32 i = 0;  ; ++i){
-                const auto VoiLutId = myVoiLut->getVOILUTId(i);
-                if(VoiLutId == 0) break;
-                VoiLutIds.push_back(VoiLutId);
-            }
-            //auto VoiLutIds = myVoiLut->getVOILUTIds();
-            for(auto VoiLutId : VoiLutIds){
-                const std::wstring VoiLutDescriptionWS = myVoiLut->getVOILUTDescription(VoiLutId);
-                const std::string VoiLutDescription(VoiLutDescriptionWS.begin(), VoiLutDescriptionWS.end());
-                FUNCINFO("Found 'presentation' VOI/LUT with description '" << VoiLutDescription << "' (not applying it!)");
-
-                //Print the center and width of the VOI/LUT.
-                imbxInt32 VoiLutCenter = std::numeric_limits<imbxInt32>::max();
-                imbxInt32 VoiLutWidth  = std::numeric_limits<imbxInt32>::max();
-                myVoiLut->getCenterWidth(&VoiLutCenter, &VoiLutWidth);
-                if((VoiLutCenter != std::numeric_limits<imbxInt32>::max())
-                || (VoiLutWidth  != std::numeric_limits<imbxInt32>::max())){
-                    FUNCINFO("    - 'Presentation' VOI/LUT has centre = " << VoiLutCenter << " and width = " << VoiLutWidth);
-                }
+    const auto img_pxldz = image_thickness;
+    img.init_spatial(image_pxldx,image_pxldy,img_pxldz, image_anchor, image_pos);
+    return out;
+}
+
+//Decodes the pixel data of a single-frame image into an image with matching geometry (see
+// Load_Image_Array_Header()). An empty pixel buffer is allocated first.
+static void Decode_Image_Pixels(const std::shared_ptr<Parsed_DICOM_File> &pdf, planar_image<float,double> &img){
+    using namespace puntoexe;
+    ptr<imebra::dataSet> TopDataSet = pdf->top_data_set;
+    const auto modality = get_modality(pdf);
+    const auto image_rows = img.rows;
+    const auto image_cols = img.columns;
+
+    //--------------------------------------------------------------------------------------------------
+    //Retrieve the pixel data from file. This is an excessively long exercise!
+    ptr<puntoexe::imebra::image> firstImage;
+    try{
+        firstImage = TopDataSet->getImage(0);
+    }catch(const std::exception &e){
+        throw std::domain_error("This file does not have accessible pixel data."
+                                " The DICOM image loader should not be called for this file");
+    }
+
+    //Process image using modalityVOILUT transform to convert its pixel values into meaningful values.
+    // From what I can tell, this conversion is necessary to transform the raw data from a possibly
+    // manufacturer-specific, proprietary format into something physically meaningful for us. 
+    //
+    // I have not experimented with disabling this conversion. Leaving it intact causes the datum from
+    // a Philips "Interra" machine's PAR/REC format to coincide with the exported DICOM data.
+    ptr<imebra::transforms::transform> modVOILUT(new imebra::transforms::modalityVOILUT(TopDataSet));
+    imbxUint32 width, height;
+    firstImage->getSize(&width, &height);
+    ptr<imebra::image> convertedImage(modVOILUT->allocateOutputImage(firstImage, width, height));
+    modVOILUT->runTransform(firstImage, 0, 0, width, height, convertedImage, 0, 0);
+
+
+    //Convert the 'convertedImage' into an image suitable for the viewing on screen. The VOILUT transform 
+    // applies the contrast suggested by the dataSet to the image. Apply the first one we find. Relevant
+    // DICOM tags reside around (0x0028,0x3010) and (0x0028,0x1050).
+    //
+    // This conversion uses the first suggested transformation found in the DICOM file, and will vary
+    // from file to file. Generally, the transformation scales the pixel values to cover the range of the
+    // available pixel range (i.e., u16). The transformation *CAN* induce clipping or truncation which 
+    // cannot be recovered from!
+    //
+    // Therefore, in my opinion, it is never worthwhile to perform this conversion. If you want to window
+    // or scale the values, you should do so as needed using the WindowCenter and WindowWidth values 
+    // directly.
+    //
+    // Report available conversions:
+    if(false){
+        ptr<imebra::transforms::VOILUT> myVoiLut(new imebra::transforms::VOILUT(TopDataSet));
+        std::vector<imbxUint32> VoiLutIds;
+        for(imbxUint32 i = 0;  ; ++i){
+            const auto VoiLutId = myVoiLut->getVOILUTId(i);
+            if(VoiLutId == 0) break;
+            VoiLutIds.push_back(VoiLutId);
+        }
+        //auto VoiLutIds = myVoiLut->getVOILUTIds();
+        for(auto VoiLutId : VoiLutIds){
+            const std::wstring VoiLutDescriptionWS = myVoiLut->getVOILUTDescription(VoiLutId);
+            const std::string VoiLutDescription(VoiLutDescriptionWS.begin(), VoiLutDescriptionWS.end());
+            FUNCINFO("Found 'presentation' VOI/LUT with description '" << VoiLutDescription << "' (not applying it!)");
+
+            //Print the center and width of the VOI/LUT.
+            imbxInt32 VoiLutCenter = std::numeric_limits<imbxInt32>::max();
+            imbxInt32 VoiLutWidth  = std::numeric_limits<imbxInt32>::max();
+            myVoiLut->getCenterWidth(&VoiLutCenter, &VoiLutWidth);
+            if((VoiLutCenter != std::numeric_limits<imbxInt32>::max())
+            || (VoiLutWidth  != std::numeric_limits<imbxInt32>::max())){
+                FUNCINFO("    - 'Presentation' VOI/LUT has centre = " << VoiLutCenter << " and width = " << VoiLutWidth);
             }
         }
-        //
-        // Disable Imebra conversion:
-        ptr<imebra::image> presImage(convertedImage);
-        //
-        // Enable Imebra conversion:
-        //ptr<imebra::transforms::VOILUT> myVoiLut(new imebra::transforms::VOILUT(TopDataSet));
-        //imbxUint32 lutId = myVoiLut->getVOILUTId(0);
-        //myVoiLut->setVOILUT(lutId);
-        //ptr<imebra::image> presImage(myVoiLut->allocateOutputImage(convertedImage, width, height));
-        //myVoiLut->runTransform(convertedImage, 0, 0, width, height, presImage, 0, 0);
-        //{
-        //  //Print a description of the VOI/LUT if available.
-        //  //const std::wstring VoiLutDescriptionWS = myVoiLut->getVOILUTDescription(lutId);
-        //  //const std::string VoiLutDescription(VoiLutDescriptionWS.begin(), VoiLutDescriptionWS.end());
-        //  //FUNCINFO("Using VOI/LUT with description '" << VoiLutDescription << "'");
-        //
-        //  //Print the center and width of the VOI/LUT.
-        //  imbxInt32 VoiLutCenter = std::numeric_limits<imbxInt32>::max();
-        //  imbxInt32 VoiLutWidth  = std::numeric_limits<imbxInt32>::max();
-        //  myVoiLut->getCenterWidth(&VoiLutCenter, &VoiLutWidth);
-        //  if((VoiLutCenter != std::numeric_limits<imbxInt32>::max())
-        //  || (VoiLutWidth  != std::numeric_limits<imbxInt32>::max())){
-        //      FUNCINFO("Using VOI/LUT with centre = " << VoiLutCenter << " and width = " << VoiLutWidth);
-        //  }
-        //}
+    }
+    //
+    // Disable Imebra conversion:
+    ptr<imebra::image> presImage(convertedImage);
+    //
+    // Enable Imebra conversion:
+    //ptr<imebra::transforms::VOILUT> myVoiLut(new imebra::transforms::VOILUT(TopDataSet));
+    //imbxUint32 lutId = myVoiLut->getVOILUTId(0);
+    //myVoiLut->setVOILUT(lutId);
+    //ptr<imebra::image> presImage(myVoiLut->allocateOutputImage(convertedImage, width, height));
+    //myVoiLut->runTransform(convertedImage, 0, 0, width, height, presImage, 0, 0);
+    //{
+    //  //Print a description of the VOI/LUT if available.
+    //  //const std::wstring VoiLutDescriptionWS = myVoiLut->getVOILUTDescription(lutId);
+    //  //const std::string VoiLutDescription(VoiLutDescriptionWS.begin(), VoiLutDescriptionWS.end());
+    //  //FUNCINFO("Using VOI/LUT with description '" << VoiLutDescription << "'");
+    //
+    //  //Print the center and width of the VOI/LUT.
+    //  imbxInt32 VoiLutCenter = std::numeric_limits<imbxInt32>::max();
+    //  imbxInt32 VoiLutWidth  = std::numeric_limits<imbxInt32>::max();
+    //  myVoiLut->getCenterWidth(&VoiLutCenter, &VoiLutWidth);
+    //  if((VoiLutCenter != std::numeric_limits<imbxInt32>::max())
+    //  || (VoiLutWidth  != std::numeric_limits<imbxInt32>::max())){
+    //      FUNCINFO("Using VOI/LUT with centre = " << VoiLutCenter << " and width = " << VoiLutWidth);
+    //  }
+    //}
 
  
-        //Get the image in terms of 'RGB'/'MONOCHROME1'/'MONOCHROME2'/'YBR_FULL'/etc.. channels.
-        //
-        // This allows up to transform the data into a desired format before allocating any space.
-        //
-        // NOTE: The 'Photometric Interpretation' is specified in the DICOM file at 0x0028,0x0004 as a
-        //       string. For instance "MONOCHROME2" is present in some MR images at the time of writing.
-        //       It's not clear that I will want Imebra to transform the data under any circumstances, but
-        //       to simplify things for now I'll assume we always want 'MONOCHROME2' format.
-        //
-        // NOTE: After some further digging, I believe letting Imebra convert to monochrome will allow
-        //       us to handle compressed images without any extra work.
-        puntoexe::imebra::transforms::colorTransforms::colorTransformsFactory*  pFactory = 
-            puntoexe::imebra::transforms::colorTransforms::colorTransformsFactory::getColorTransformsFactory();
-        ptr<puntoexe::imebra::transforms::transform> myColorTransform = 
-            pFactory->getTransform(presImage->getColorSpace(), L"MONOCHROME2");//L"RGB");
+    //Get the image in terms of 'RGB'/'MONOCHROME1'/'MONOCHROME2'/'YBR_FULL'/etc.. channels.
+    //
+    // This allows up to transform the data into a desired format before allocating any space.
+    //
+    // NOTE: The 'Photometric Interpretation' is specified in the DICOM file at 0x0028,0x0004 as a
+    //       string. For instance "MONOCHROME2" is present in some MR images at the time of writing.
+    //       It's not clear that I will want Imebra to transform the data under any circumstances, but
+    //       to simplify things for now I'll assume we always want 'MONOCHROME2' format.
+    //
+    // NOTE: After some further digging, I believe letting Imebra convert to monochrome will allow
+    //       us to handle compressed images without any extra work.
+    puntoexe::imebra::transforms::colorTransforms::colorTransformsFactory*  pFactory = 
+        puntoexe::imebra::transforms::colorTransforms::colorTransformsFactory::getColorTransformsFactory();
+    ptr<puntoexe::imebra::transforms::transform> myColorTransform = 
+        pFactory->getTransform(presImage->getColorSpace(), L"MONOCHROME2");//L"RGB");
+    if(myColorTransform != nullptr){ //If we get a nullptr, we do not need to transform the image.
+        ptr<puntoexe::imebra::image> rgbImage(myColorTransform->allocateOutputImage(presImage,width,height));
+        myColorTransform->runTransform(presImage, 0, 0, width, height, rgbImage, 0, 0);
+        presImage = rgbImage;
+    }
+
+    //Get a 'dataHandler' to access the image data waiting in 'presImage.' Get some image metadata.
+    imbxUint32 rowSize, channelPixelSize, channelsNumber, sizeX, sizeY;
+    //Select the image to use.
+    // firstImage     -- Displays RTIMAGE, and CT(MR?) but neither CT nor RTIMAGE values are in HU.
+    // convertedImage -- Works for CT (MR?) but not RTIMAGE.
+    // presImage      -- Works for CT and MR, but not RTIMAGE.
+    ptr<puntoexe::imebra::image> switchImage = ( modality == "RTIMAGE" ) ? firstImage : presImage;
+    ptr<puntoexe::imebra::handlers::dataHandlerNumericBase> myHandler = 
+        switchImage->getDataHandler(false, &rowSize, &channelPixelSize, &channelsNumber);
+    presImage->getSize(&sizeX, &sizeY);
+    //----------------------------------------------------------------------------------------------------
+
+    if((static_cast<long int>(sizeX) != image_cols) || (static_cast<long int>(sizeY) != image_rows)){
+        FUNCWARN("sizeX = " << sizeX << ", sizeY = " << sizeY << " and image_cols = " << image_cols << ", image_rows = " << image_rows);
+        throw std::domain_error("The number of rows and columns in the image data differ when comparing sizeX/Y and img_rows/cols. Please verify");
+        //If this issue arises, I have likely confused definition of X and Y. The DICOM standard specifically calls (0028,0010) 
+        // a 'row'. Perhaps I've got many things backward...
+    }
+
+    const auto img_chnls = static_cast<long int>(channelsNumber);
+    if(img.channels != img_chnls){
+        if(img.data.empty()){
+            throw std::domain_error("The number of channels in the image data differs from the header. Cannot continue");
+        }
+        img.init_buffer(image_rows, image_cols, img_chnls);
+    }
+    if(img.data.empty()) img.data.resize(static_cast<size_t>(image_rows * image_cols * img_chnls));
+
+    //Sometimes Imebra returns a different number of bits than the DICOM header specifies. Presumably this
+    // is for some reason (maybe even simplification of implementation, which is fair). Since I convert to
+    // a float or uint32_t, the only practical concern is whether or not it will fit.
+    const auto img_bits  = static_cast<unsigned int>(channelPixelSize*8); //16 bit, 32 bit, 8 bit, etc..
+    if(img_bits > 32){
+        throw std::domain_error("The number of bits returned by Imebra is too large to fit in uint32_t"
+                                " You can increase this if needed, or try to scale down to 32 bits");
+    }
+
+    //Write the data to our allocated memory. We do it pixel-by-pixel because the 'PixelRepresentation' could mean
+    // the pixel locality is laid out in various ways (two ways?). This approach abstracts the issue away.
+    imbxUint32 data_index = 0;
+    for(long int row = 0; row < image_rows; ++row){
+        for(long int col = 0; col < image_cols; ++col){
+            for(long int chnl = 0; chnl < img_chnls; ++chnl){
+                //Let Imebra work out the conversion by asking for a double. Hope it can be narrowed if necessary!
+                const auto DoubleChannelValue = myHandler->getDouble(data_index);
+                const auto OutgoingPixelValue = static_cast<float>(DoubleChannelValue);
+
+                img.reference(row,col,chnl) = OutgoingPixelValue;
+                ++data_index;
+            } //Loop over channels.
+        } //Loop over columns.
+    } //Loop over rows.
+}
+
+//Whether the file holds a multi-frame image, e.g., an 'enhanced' CT or MR image.
+static bool Is_Multiframe_Image(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    const auto &TopDataSet = pdf->top_data_set;
+    return (TopDataSet->getTag(0x0028, 0, 0x0008, false) != nullptr) //"NumberOfFrames".
+        && (0 < TopDataSet->getUnsignedLong(0x0028, 0, 0x0008, 0));
+}
+
+//Loads each frame of a multi-frame image as a separate image.
+//
+// Geometry and rescaling parameters are read from the per-frame functional groups, falling back on the shared
+// functional groups, and then on the top-level tags. The top-level metadata is read once and shared by all frames.
+static std::unique_ptr<Image_Array> Load_Multiframe_Image_Array(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    auto out = std::make_unique<Image_Array>();
+
+    using namespace puntoexe;
+    ptr<imebra::dataSet> TopDataSet = pdf->top_data_set;
+
+    const auto to_doubles = [](const std::vector<std::string> &strs) -> std::vector<double> {
+        std::vector<double> out;
+        for(const auto &s : strs){
+            try{
+                out.push_back(std::stod(s));
+            }catch(const std::exception &){
+                return {};
+            }
+        }
+        return out;
+    };
+    const auto functional = [&](long int frame, uint16_t seq_group, uint16_t seq_tag,
+                                uint16_t group, uint16_t tag, size_t expected) -> std::optional<std::vector<double>> {
+        const std::array<path_node, 2> groups = {{ path_node{ 0x5200, 0x9230, 0, static_cast<uint32_t>(frame) },
+                                                   path_node{ 0x5200, 0x9229, 0, 0 } }};
+        for(const auto &g : groups){
+            const auto vals = to_doubles( extract_seq_tag_as_string(TopDataSet, { g,
+                                                                                  path_node{ seq_group, seq_tag, 0, 0 },
+                                                                                  path_node{ group, tag, 0, 0 } }) );
+            if(expected <= vals.size()) return vals;
+        }
+        const auto vals = to_doubles( extract_seq_tag_as_string(TopDataSet, { path_node{ group, tag, 0, 0 } }) );
+        if(expected <= vals.size()) return vals;
+        return std::nullopt;
+    };
+
+    const auto frame_count = static_cast<long int>(TopDataSet->getUnsignedLong(0x0028, 0, 0x0008, 0));
+    const auto image_rows  = static_cast<long int>(TopDataSet->getUnsignedLong(0x0028, 0, 0x0010, 0));
+    const auto image_cols  = static_cast<long int>(TopDataSet->getUnsignedLong(0x0028, 0, 0x0011, 0));
+    const auto metadata = get_metadata_top_level_tags(pdf);
+    const vec3<double> image_anchor(0.0, 0.0, 0.0);
+
+    struct frame_t {
+        vec3<double> pos;
+        vec3<double> orien_r;
+        vec3<double> orien_c;
+        double pxldx = 1.0;
+        double pxldy = 1.0;
+        double thickness = 1.0;
+        double slope = 1.0;
+        double intercept = 0.0;
+    };
+    std::vector<frame_t> frames(frame_count);
+    for(long int i = 0; i < frame_count; ++i){
+        auto &f = frames[i];
+        //"PlanePositionSequence/ImagePositionPatient".
+        const auto pos = functional(i, 0x0020, 0x9113, 0x0020, 0x0032, 3)
+                         .value_or(std::vector<double>{ 0.0, 0.0, 0.0 });
+        f.pos = vec3<double>(pos[0], pos[1], pos[2]);
+
+        //"PlaneOrientationSequence/ImageOrientationPatient".
+        const auto orien = functional(i, 0x0020, 0x9116, 0x0020, 0x0037, 6)
+                           .value_or(std::vector<double>{ 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 });
+        f.orien_c = vec3<double>(orien[0], orien[1], orien[2]).unit();
+        f.orien_r = vec3<double>(orien[3], orien[4], orien[5]).unit();
+
+        const auto spacing = functional(i, 0x0028, 0x9110, 0x0028, 0x0030, 2); //"PixelMeasuresSequence/PixelSpacing".
+        if(!spacing) throw std::domain_error("Pixel spacing is not available for frame " + std::to_string(i));
+        f.pxldy = spacing.value()[0];
+        f.pxldx = spacing.value()[1];
+        f.thickness = functional(i, 0x0028, 0x9110, 0x0018, 0x0050, 1) //"PixelMeasuresSequence/SliceThickness".
+                      .value_or(std::vector<double>{ 1.0 })[0];
+
+        //"PixelValueTransformationSequence/RescaleIntercept" and ".../RescaleSlope".
+        f.intercept = functional(i, 0x0028, 0x9145, 0x0028, 0x1052, 1).value_or(std::vector<double>{ 0.0 })[0];
+        f.slope     = functional(i, 0x0028, 0x9145, 0x0028, 0x1053, 1).value_or(std::vector<double>{ 1.0 })[0];
+    }
+
+    std::vector<planar_image<float,double> *> imgs;
+    for(long int i = 0; i < frame_count; ++i){
+        out->imagecoll.images.emplace_back();
+        imgs.push_back( &(out->imagecoll.images.back()) );
+    }
+
+    //Frames are decoded concurrently (see Load_Dose_Array()). The rescaling parameters are applied directly, since
+    // Imebra's modality transform only consults the top-level tags.
+    parallel_for(0, frame_count, [&](long int i){
+        const auto &f = frames[i];
+        auto &img = *(imgs[i]);
+
+        ptr<puntoexe::imebra::image> presImage = TopDataSet->getImage(static_cast<imbxUint32>(i));
+        if(presImage == nullptr) throw std::domain_error("This file does not have accessible pixel data");
+        imbxUint32 width, height;
+        presImage->getSize(&width, &height);
+
+        puntoexe::imebra::transforms::colorTransforms::colorTransformsFactory*  pFactory =
+             puntoexe::imebra::transforms::colorTransforms::colorTransformsFactory::getColorTransformsFactory();
+        ptr<puntoexe::imebra::transforms::transform> myColorTransform =
+             pFactory->getTransform(presImage->getColorSpace(), L"MONOCHROME2");
         if(myColorTransform != nullptr){ //If we get a nullptr, we do not need to transform the image.
-            ptr<puntoexe::imebra::image> rgbImage(myColorTransform->allocateOutputImage(presImage,width,height));
-            myColorTransform->runTransform(presImage, 0, 0, width, height, rgbImage, 0, 0);
-            presImage = rgbImage;
+            ptr<puntoexe::imebra::image> monoImage(myColorTransform->allocateOutputImage(presImage,width,height));
+            myColorTransform->runTransform(presImage, 0, 0, width, height, monoImage, 0, 0);
+            presImage = monoImage;
         }
-    
-        //Get a 'dataHandler' to access the image data waiting in 'presImage.' Get some image metadata.
+
         imbxUint32 rowSize, channelPixelSize, channelsNumber, sizeX, sizeY;
-        //Select the image to use.
-        // firstImage     -- Displays RTIMAGE, and CT(MR?) but neither CT nor RTIMAGE values are in HU.
-        // convertedImage -- Works for CT (MR?) but not RTIMAGE.
-        // presImage      -- Works for CT and MR, but not RTIMAGE.
-        ptr<puntoexe::imebra::image> switchImage = ( modality == "RTIMAGE" ) ? firstImage : presImage;
-        ptr<puntoexe::imebra::handlers::dataHandlerNumericBase> myHandler = 
-            switchImage->getDataHandler(false, &rowSize, &channelPixelSize, &channelsNumber);
+        ptr<puntoexe::imebra::handlers::dataHandlerNumericBase> myHandler =
+            presImage->getDataHandler(false, &rowSize, &channelPixelSize, &channelsNumber);
         presImage->getSize(&sizeX, &sizeY);
-        //----------------------------------------------------------------------------------------------------
-
         if((static_cast<long int>(sizeX) != image_cols) || (static_cast<long int>(sizeY) != image_rows)){
-            FUNCWARN("sizeX = " << sizeX << ", sizeY = " << sizeY << " and image_cols = " << image_cols << ", image_rows = " << image_rows);
-            throw std::domain_error("The number of rows and columns in the image data differ when comparing sizeX/Y and img_rows/cols. Please verify");
-            //If this issue arises, I have likely confused definition of X and Y. The DICOM standard specifically calls (0028,0010) 
-            // a 'row'. Perhaps I've got many things backward...
+            throw std::domain_error("The number of rows and columns in the image data differ from the header");
         }
 
-        out->imagecoll.images.back().metadata = get_metadata_top_level_tags(FilenameIn);
-        out->imagecoll.images.back().init_orientation(image_orien_r,image_orien_c);
-
+        img.metadata = metadata;
+        img.init_orientation(f.orien_r, f.orien_c);
         const auto img_chnls = static_cast<long int>(channelsNumber);
-        out->imagecoll.images.back().init_buffer(image_rows, image_cols, img_chnls); //Underlying type specifies per-pixel space allocated.
+        img.init_buffer(image_rows, image_cols, img_chnls);
+        img.init_spatial(f.pxldx, f.pxldy, f.thickness, image_anchor, f.pos);
 
-        const auto img_pxldz = image_thickness;
-        out->imagecoll.images.back().init_spatial(image_pxldx,image_pxldy,img_pxldz, image_anchor, image_pos);
+        img.metadata["Frame"] = std::to_string(i);
+        img.metadata["ImagePositionPatient"] = f.pos.to_string();
+        img.metadata["SliceThickness"] = std::to_string(f.thickness);
 
-        //Sometimes Imebra returns a different number of bits than the DICOM header specifies. Presumably this
-        // is for some reason (maybe even simplification of implementation, which is fair). Since I convert to
-        // a float or uint32_t, the only practical concern is whether or not it will fit.
-        const auto img_bits  = static_cast<unsigned int>(channelPixelSize*8); //16 bit, 32 bit, 8 bit, etc..
-        if(img_bits > 32){
-            throw std::domain_error("The number of bits returned by Imebra is too large to fit in uint32_t"
-                                    " You can increase this if needed, or try to scale down to 32 bits");
-        }
-
-        //Write the data to our allocated memory. We do it pixel-by-pixel because the 'PixelRepresentation' could mean
-        // the pixel locality is laid out in various ways (two ways?). This approach abstracts the issue away.
         imbxUint32 data_index = 0;
         for(long int row = 0; row < image_rows; ++row){
             for(long int col = 0; col < image_cols; ++col){
                 for(long int chnl = 0; chnl < img_chnls; ++chnl){
-                    //Let Imebra work out the conversion by asking for a double. Hope it can be narrowed if necessary!
-                    const auto DoubleChannelValue = myHandler->getDouble(data_index);
-                    const auto OutgoingPixelValue = static_cast<float>(DoubleChannelValue);
-
-                    out->imagecoll.images.back().reference(row,col,chnl) = OutgoingPixelValue;
+                    const auto val = myHandler->getDouble(data_index) * f.slope + f.intercept;
+                    img.reference(row,col,chnl) = static_cast<float>(val);
                     ++data_index;
-                } //Loop over channels.
-            } //Loop over columns.
-        } //Loop over rows.
-    }
+                }
+            }
+        }
+    }, 1);
+
+    return out;
+}
+
+std::unique_ptr<Image_Array> Load_Image_Array(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    if(Is_Multiframe_Image(pdf)) return Load_Multiframe_Image_Array(pdf);
+    auto out = Load_Image_Array_Header(pdf);
+    Decode_Image_Pixels(pdf, out->imagecoll.images.back());
     return out;
 }
 
+std::pair<std::unique_ptr<Image_Array>, std::function<void(planar_image<float,double> &)>>
+Load_Image_Array_Deferred(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    if(pdf->top_data_set->getTag(0x7FE0, 0, 0x0010) == nullptr){ //"PixelData".
+        throw std::domain_error("This file does not have accessible pixel data."
+                                " The DICOM image loader should not be called for this file");
+    }
+    if(Is_Multiframe_Image(pdf)) return { Load_Multiframe_Image_Array(pdf), nullptr };
+    auto out = Load_Image_Array_Header(pdf);
+    auto &img = out->imagecoll.images.back();
+    if(img.channels != 1){
+        //The channel count cannot be relied on, so the geometry might change when decoding.
+        Decode_Image_Pixels(pdf, img);
+        return { std::move(out), nullptr };
+    }
+    std::vector<float>().swap(img.data);
+    return { std::move(out), [pdf](planar_image<float,double> &i) -> void { Decode_Image_Pixels(pdf, i); } };
+}
+
 //These 'shared' pointers will actually be unique. This routine just converts from unique to shared for you.
 std::list<std::shared_ptr<Image_Array>>  Load_Image_Arrays(const std::list<std::string> &filenames){
     std::list<std::shared_ptr<Image_Array>> out;
@@ -1654,17 +1992,18 @@ std::unique_ptr<Image_Array> Collate_Image_Arrays(std::list<std::shared_ptr<Imag
 //--------------------- Dose -----------------------
 //This routine reads a single DICOM dose file.
 std::unique_ptr<Image_Array>  Load_Dose_Array(const std::string &FilenameIn){
-    auto metadata = get_metadata_top_level_tags(FilenameIn);
+    return Load_Dose_Array(Parse_DICOM_File(FilenameIn));
+}
+
+std::unique_ptr<Image_Array>  Load_Dose_Array(const std::shared_ptr<Parsed_DICOM_File> &pdf){
+    const auto FilenameIn = pdf->filename;
+    auto metadata = get_metadata_top_level_tags(pdf);
     metadata["Modality"] = "RTDOSE";
 
     auto out = std::make_unique<Image_Array>();
 
     using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(FilenameIn.c_str(), std::ios::in);
-
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    ptr<imebra::dataSet> TopDataSet = pdf->top_data_set;
 
     //These should exist in all files. They appear to be the same for CT and DS files of the same set. Not sure
     // if this is *always* the case.
@@ -1715,10 +2054,18 @@ std::unique_ptr<Image_Array>  Load_Dose_Array(const std::string &FilenameIn){
     const auto image_bits  = static_cast<unsigned long int>(TopDataSet->getUnsignedLong(0x0028, 0, 0x0101, 0));
     const auto grid_scale  = static_cast<double>(TopDataSet->getDouble(0x3004, 0, 0x000e, 0));
 
-    //Grab the image data for each individual frame.
-    auto gfov_it = gfov.begin();
-    for(unsigned long int curr_frame = 0; (curr_frame < frame_count) && (gfov_it != gfov.end()); ++curr_frame, ++gfov_it){
+    //Grab the image data for each individual frame. Frames are decoded concurrently. Imebra serializes access to the
+    // data set where needed, but encapsulated (compressed) frames are decompressed in parallel.
+    const std::vector<double> gfov_v(std::begin(gfov), std::end(gfov));
+    const auto N_frames = static_cast<long int>(std::min<size_t>(frame_count, gfov_v.size()));
+    std::vector<planar_image<float,double> *> frames;
+    for(long int i = 0; i < N_frames; ++i){
         out->imagecoll.images.emplace_back();
+        frames.push_back( &(out->imagecoll.images.back()) );
+    }
+    parallel_for(0, N_frames, [&](long int i){
+        const auto curr_frame = static_cast<unsigned long int>(i);
+        auto &img = *(frames[i]);
 
         //--------------------------------------------------------------------------------------------------
         //Retrieve the pixel data from file. This is an excessively long exercise!
@@ -1770,20 +2117,20 @@ std::unique_ptr<Image_Array>  Load_Dose_Array(const std::string &FilenameIn){
             // a 'row'. Perhaps I've got many things backward...
         }
 
-        out->imagecoll.images.back().metadata = metadata;
-        out->imagecoll.images.back().init_orientation(image_orien_r,image_orien_c);
+        img.metadata = metadata;
+        img.init_orientation(image_orien_r,image_orien_c);
 
         const auto img_chnls = static_cast<long int>(channelsNumber);
-        out->imagecoll.images.back().init_buffer(image_rows, image_cols, img_chnls);
+        img.init_buffer(image_rows, image_cols, img_chnls);
 
         const auto img_pxldz = image_thickness;
-        const auto gvof_offset = static_cast<double>(*gfov_it);  //Offset along \hat{z} from 
+        const auto gvof_offset = gfov_v[i];  //Offset along \hat{z} from 
         const auto img_offset = image_pos + image_stack_unit * gvof_offset;
-        out->imagecoll.images.back().init_spatial(image_pxldx,image_pxldy,img_pxldz, image_anchor, img_offset);
+        img.init_spatial(image_pxldx,image_pxldy,img_pxldz, image_anchor, img_offset);
 
-        out->imagecoll.images.back().metadata["GridFrameOffset"] = std::to_string(gvof_offset);
-        out->imagecoll.images.back().metadata["Frame"] = std::to_string(curr_frame);
-        out->imagecoll.images.back().metadata["ImagePositionPatient"] = img_offset.to_string();
+        img.metadata["GridFrameOffset"] = std::to_string(gvof_offset);
+        img.metadata["Frame"] = std::to_string(curr_frame);
+        img.metadata["ImagePositionPatient"] = img_offset.to_string();
 
 
         const auto img_bits  = static_cast<unsigned int>(channelPixelSize*8); //16 bit, 32 bit, 8 bit, etc..
@@ -1804,13 +2151,13 @@ std::unique_ptr<Image_Array>  Load_Dose_Array(const std::string &FilenameIn){
                     const auto DoubleChannelValue = myHandler->getDouble(data_index);
                     const float OutgoingPixelValue = static_cast<float>(DoubleChannelValue) 
                                                      * static_cast<float>(grid_scale);
-                    out->imagecoll.images.back().reference(row,col,chnl) = OutgoingPixelValue;
+                    img.reference(row,col,chnl) = OutgoingPixelValue;
 
                     ++data_index;
                 } //Loop over channels.
             } //Loop over columns.
         } //Loop over rows.
-    } //Loop over frames.
+    }, 1); //Loop over frames.
 
     return out;
 }
@@ -1831,14 +2178,15 @@ std::list<std::shared_ptr<Image_Array>>  Load_Dose_Arrays(const std::list<std::s
 
 std::unique_ptr<TPlan_Config> 
 Load_TPlan_Config(const std::string &FilenameIn){
+    return Load_TPlan_Config(Parse_DICOM_File(FilenameIn));
+}
+
+std::unique_ptr<TPlan_Config> 
+Load_TPlan_Config(const std::shared_ptr<Parsed_DICOM_File> &pdf){
     std::unique_ptr<TPlan_Config> out(new TPlan_Config());
 
     using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(FilenameIn.c_str(), std::ios::in);
-
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> base_node_ptr = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    ptr<imebra::dataSet> base_node_ptr = pdf->top_data_set;
 
 
     const auto convert_first_to_string = [](const std::vector<std::string> &in) -> std::optional<std::string> {
@@ -1911,7 +2259,7 @@ Load_TPlan_Config(const std::string &FilenameIn){
 
 
     // ------------------------------------------- General --------------------------------------------------
-    out->metadata = get_metadata_top_level_tags(FilenameIn);
+    out->metadata = get_metadata_top_level_tags(pdf);
     out->metadata["Modality"] = "RTPLAN";
 
     // DoseReferenceSequence
@@ -2664,19 +3012,30 @@ void Write_CT_Images(const std::shared_ptr<Image_Array>& IA,
     // TODO: Sample any existing UID (ReferencedFrameOfReferenceUID or FrameOfReferenceUID). 
     // Probably OK to use only the first in this case though...
 
-    long int InstanceNumber = -1;
+    // Instance numbers and UIDs are assigned up-front, in order, so they do not depend on the order in which slices
+    // are encoded.
+    struct slice_t {
+        const planar_image<float,double> *img;
+        long int InstanceNumber;
+        std::string SOPInstanceUID;
+    };
+    std::vector<slice_t> slices;
     for(const auto &animg : IA->imagecoll.images){
         if( (animg.rows <= 0) || (animg.columns <= 0) || (animg.channels <= 0) ){
             continue;
         }
+        slices.push_back({ &animg, static_cast<long int>(slices.size()), Generate_Random_UID(60) });
+    }
 
-        ++InstanceNumber;
+    // Encodes a single file. This is invoked concurrently.
+    const auto encode_slice = [&](const slice_t &slice) -> std::string {
+        const auto &animg = *(slice.img);
+        const auto InstanceNumber = slice.InstanceNumber;
+        const auto &SOPInstanceUID = slice.SOPInstanceUID;
 
         DCMA_DICOM::Encoding enc = DCMA_DICOM::Encoding::ELE;
         DCMA_DICOM::Node root_node;
 
-        const auto SOPInstanceUID = Generate_Random_UID(60);
-
         //auto cm = IA->imagecoll.get_common_metadata({});
         auto cm = animg.metadata;
 
@@ -2861,16 +3220,18 @@ void Write_CT_Images(const std::shared_ptr<Image_Array>& IA,
         }
 
         {
-            std::stringstream ss_pixels;
+            std::string pixels(sizeof(int16_t) * animg.rows * animg.columns * animg.channels, '\0');
+            auto *pixel_it = &(pixels[0]);
             for(long int row = 0; row != animg.rows; ++row){
                 for(long int col = 0; col != animg.columns; ++col){
                     for(long int chnl = 0; chnl != animg.channels; ++chnl){
                         auto val = static_cast<int16_t>( std::round( animg.value(row, col, chnl ) ) );
-                        ss_pixels.write( reinterpret_cast<const char *>(&val), sizeof(val) );
+                        std::memcpy(pixel_it, &val, sizeof(val));
+                        pixel_it += sizeof(val);
                     }
                 }
             }
-            root_node.emplace_child_node({{0x7FE0, 0x0010}, "OB", ss_pixels.str() }); // PixelData.
+            root_node.emplace_child_node({{0x7FE0, 0x0010}, "OB", std::move(pixels) }); // PixelData.
 
             // Note: the standard mentions that:
             //
@@ -2897,15 +3258,29 @@ void Write_CT_Images(const std::shared_ptr<Image_Array>& IA,
         root_node.emplace_child_node({{0x0028, 0x1050}, "DS", "0" }); //WindowCenter.
         root_node.emplace_child_node({{0x0028, 0x1051}, "DS", "1000" }); //WindowWidth
 
-        // Send the file to the user's handler.
-        {
-            std::stringstream ss;
-            const auto bytes_reqd = root_node.emit_DICOM(ss, enc);
-            if(!ss) throw std::runtime_error("Stream not in good state after emitting DICOM file");
-            if(bytes_reqd <= 0) throw std::runtime_error("Not enough DICOM data available for valid file");
+        std::ostringstream ss(std::ios_base::out | std::ios_base::binary);
+        const auto bytes_reqd = root_node.emit_DICOM(ss, enc);
+        if(!ss) throw std::runtime_error("Stream not in good state after emitting DICOM file");
+        if(bytes_reqd <= 0) throw std::runtime_error("Not enough DICOM data available for valid file");
+        return ss.str();
+    };
 
-            const auto fsize = static_cast<long int>(bytes_reqd);
+    // Encode a window of slices concurrently, then send the files to the user's handler in order. The window bounds the
+    // number of encoded files held in memory.
+    const auto window = static_cast<size_t>( 2 * std::max<long int>(1, work_stealing_pool::get().concurrency()) );
+    std::vector<std::string> encoded;
+    for(size_t b = 0; b < slices.size(); b += window){
+        const auto n = std::min(window, slices.size() - b);
+        encoded.assign(n, std::string());
+        parallel_for(0, static_cast<long int>(n), [&](long int j){
+            encoded[j] = encode_slice(slices[b + j]);
+        }, 1);
+
+        for(auto &e : encoded){
+            const auto fsize = static_cast<long int>(e.size());
+            boost::iostreams::stream<boost::iostreams::array_source> ss(e.data(), e.size());
             file_handler(ss, fsize);
+            e = std::string();
         }
     }
 
@@ -3149,63 +3524,9 @@ void Write_Contours(std::list<std::reference_wrapper<contour_collection<double>>
 
     //-------------------------------------------------------------------------------------------------
     // ROI Contour Module.
-
-    // Emit the ROI Contour Sequence.
-    {
-        DCMA_DICOM::Node *rc_seq_ptr = root_node.emplace_child_node({{0x3006, 0x0039}, "SQ", ""});  // ROIContourSequence
-        //uint32_t roi_seq_n = 0;
-        uint32_t roi_seq_n = 1;
-        for(const auto cc_refw : CC){
-            //auto cm = cc_refw.get().get_common_metadata({}, {});
-
-            DCMA_DICOM::Node *multi_rc_seq_ptr = rc_seq_ptr->emplace_child_node({{0x0000, 0x0000}, "MULTI", ""});
-
-            multi_rc_seq_ptr->emplace_child_node({{0x3006, 0x0084}, "IS", std::to_string(roi_seq_n) }); // ReferencedROINumber (Does this need to be 1-based? TODO)
-            //multi_rc_seq_ptr->emplace_child_node({{0x3006, 0x002A}, "IS", R"***(255\0\0)***" }); // ROIDisplayColor
-            DCMA_DICOM::Node *c_seq_ptr = multi_rc_seq_ptr->emplace_child_node({{0x3006, 0x0040}, "SQ", ""});  // ContourSequence
-
-            //uint32_t contour_seq_n = 0;
-            uint32_t contour_seq_n = 1;
-            for(const auto& c : cc_refw.get().contours){
-                DCMA_DICOM::Node *multi_c_seq_ptr = c_seq_ptr->emplace_child_node({{0x0000, 0x0000}, "MULTI", ""});
-
-                multi_c_seq_ptr->emplace_child_node({{0x3006, 0x0048}, "IS", std::to_string(contour_seq_n) }); // ContourNumber
-                multi_c_seq_ptr->emplace_child_node({{0x3006, 0x0042}, "CS", "CLOSED_PLANAR" }); // ContourGeometricType
-                //multi_c_seq_ptr->emplace_child_node({{0x3006, 0x0044}, "DS", "1.0" }); // ContourSlabThickness (in DICOM units; mm)
-                //multi_c_seq_ptr->emplace_child_node({{0x3006, 0x0045}, "DS", R"***(0.0\0.0\1.0)***" }); // ContourOffsetVector
-                multi_c_seq_ptr->emplace_child_node({{0x3006, 0x0046}, "IS", std::to_string(c.points.size()) }); // NumberOfControlPoints
-
-                //DCMA_DICOM::Node *ac_seq_ptr = rc_seq_ptr->emplace_child_node({{0x3006, 0x0049}, "SQ", ""});  // AttachedContours  ???
-                //for(attached_contours ...){
-                //    DCMA_DICOM::Node *multi_ac_seq_ptr = ac_seq_ptr->emplace_child_node({{0x0000, 0x0000}, "MULTI", ""});
-                //    multi_ac_seq_ptr->emplace_child_node({{0x3006, 0x0049}, "???", std::to_string(c.points.size()) }); // AttachedContours
-                //} 
-
-                // Emit the actual contour data.
-                //
-                // Note: If explicit VR transfer syntax is used, each contour should not exceed 65534 bytes!
-                std::stringstream ss;
-                bool isnew = true;
-                for(const auto & p : c.points){
-                    if(!isnew){
-                        ss << R"***(\)***"; // Delimit from the previous coordinates.
-                    }else{
-                        isnew = false;
-                    }
-                    ss << p.x <<  R"***(\)***" << p.y << R"***(\)***" << p.z;
-                }
-                if(65534 < ss.str().size()) throw std::runtime_error("Contour too large, data loss may occur. Refusing to proceed.");
-                multi_c_seq_ptr->emplace_child_node({{0x3006, 0x0050}, "DS", ss.str() }); // ContourData
-
-                //FUNCINFO("Emitted contour " << contour_seq_n << " of " << cc_refw.get().contours.size() 
-                //     << " from ROI " << roi_seq_n << " of " << CC.size() );
-
-                ++contour_seq_n;
-            }
-
-            ++roi_seq_n;
-        }
-    }
+    //
+    // Note: The ROI Contour Sequence holds nearly all of the data, so it is not added to the tree. It is written
+    //       incrementally with the other nodes instead; see below.
 
     //-------------------------------------------------------------------------------------------------
     // RT ROI Observations Module.
@@ -3242,8 +3563,67 @@ void Write_Contours(std::list<std::reference_wrapper<contour_collection<double>>
 
     // Send the file to the user's handler.
     {
+        // Nodes that follow the ROI Contour Sequence are emitted after it.
+        const DCMA_DICOM::Node rc_seq_node({0x3006, 0x0039}, "SQ", "");
+        DCMA_DICOM::Node trailing_nodes({0x0000, 0x0000}, "MULTI", "");
+        trailing_nodes.children.splice( std::end(trailing_nodes.children), root_node.children,
+                                        std::find_if( std::begin(root_node.children), std::end(root_node.children),
+                                                      [&](const DCMA_DICOM::Node &n){ return rc_seq_node < n; } ),
+                                        std::end(root_node.children) );
+
         std::stringstream ss;
-        const auto bytes_reqd = root_node.emit_DICOM(ss, enc);
+        auto bytes_reqd = root_node.emit_DICOM(ss, enc);
+
+        // Emit the ROI Contour Sequence one contour at a time, so only the file itself is held in memory.
+        DCMA_DICOM::sequence_writer sw(ss, enc);
+        bytes_reqd += sw.begin_sequence(rc_seq_node.key); // ROIContourSequence
+        uint32_t roi_seq_n = 1;
+        std::string contour_data;
+        for(const auto cc_refw : CC){
+            bytes_reqd += sw.begin_item();
+            //bytes_reqd += sw.emit({{0x3006, 0x002A}, "IS", R"***(255\0\0)***" }); // ROIDisplayColor
+
+            bytes_reqd += sw.begin_sequence({0x3006, 0x0040}); // ContourSequence
+            uint32_t contour_seq_n = 1;
+            for(const auto& c : cc_refw.get().contours){
+                // Note: If explicit VR transfer syntax is used, each contour should not exceed 65534 bytes!
+                contour_data.clear();
+                for(const auto & p : c.points){
+                    if(!contour_data.empty()) contour_data += R"***(\)***"; // Delimit from the previous coordinates.
+                    DCMA_DICOM::append_decimal_string(contour_data, p.x);
+                    contour_data += R"***(\)***";
+                    DCMA_DICOM::append_decimal_string(contour_data, p.y);
+                    contour_data += R"***(\)***";
+                    DCMA_DICOM::append_decimal_string(contour_data, p.z);
+                }
+                if(65534 < contour_data.size()){
+                    throw std::runtime_error("Contour too large, data loss may occur. Refusing to proceed.");
+                }
+
+                DCMA_DICOM::Node c_node({0x0000, 0x0000}, "MULTI", "");
+                c_node.emplace_child_node({{0x3006, 0x0042}, "CS", "CLOSED_PLANAR" }); // ContourGeometricType
+                //c_node.emplace_child_node({{0x3006, 0x0044}, "DS", "1.0" }); // ContourSlabThickness (in mm)
+                //c_node.emplace_child_node({{0x3006, 0x0045}, "DS", R"***(0.0\0.0\1.0)***" }); // ContourOffsetVector
+                // NumberOfControlPoints
+                c_node.emplace_child_node({{0x3006, 0x0046}, "IS", std::to_string(c.points.size()) });
+                c_node.emplace_child_node({{0x3006, 0x0048}, "IS", std::to_string(contour_seq_n) }); // ContourNumber
+                c_node.emplace_child_node({{0x3006, 0x0050}, "DS", contour_data }); // ContourData
+
+                bytes_reqd += sw.begin_item();
+                bytes_reqd += sw.emit(c_node);
+                bytes_reqd += sw.end_item();
+                ++contour_seq_n;
+            }
+            bytes_reqd += sw.end_sequence();
+
+            // ReferencedROINumber (Does this need to be 1-based? TODO)
+            bytes_reqd += sw.emit({{0x3006, 0x0084}, "IS", std::to_string(roi_seq_n) });
+            bytes_reqd += sw.end_item();
+            ++roi_seq_n;
+        }
+        bytes_reqd += sw.end_sequence();
+
+        bytes_reqd += trailing_nodes.emit_DICOM(ss, enc, false);
         if(!ss) throw std::runtime_error("Stream not in good state after emitting DICOM file");
         if(bytes_reqd <= 0) throw std::runtime_error("Not enough DICOM data available for valid file");
 
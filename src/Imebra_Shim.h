@@ -4,10 +4,13 @@
 #define _IMEBRA_SHIM_H_DICOMAUTOMATON
 
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Structs.h"
@@ -17,6 +20,29 @@ class Contour_Data;
 class Image_Array;
 
 
+//------------------ Parsed files -----------------
+//Opaque handle to a DICOM file that has been read and decoded. Each routine below that accepts a filename will
+// re-read and re-parse the file, so callers that need to query a single file multiple times should parse it once and
+// pass the handle instead. The handle (and the parsed data) is released when the last copy goes out of scope.
+struct Parsed_DICOM_File;
+
+//Ensures the codecs needed to parse files are registered. Codecs register themselves during static initialization,
+// but static linking can discard a registration that nothing else references, so any missing codecs are registered
+// here. Parsing does not require this to be called, but it fixes (and makes measurable) when initialization occurs.
+void Initialize_DICOM_Codecs();
+
+//NOTE: Throws if the file cannot be read or parsed.
+std::shared_ptr<Parsed_DICOM_File> Parse_DICOM_File(const std::string &filename);
+
+//Parses DICOM data that has already been read into memory, e.g., a file extracted from an archive. The name is
+// reported wherever a filename would be.
+//
+//NOTE: Throws if the data cannot be parsed.
+std::shared_ptr<Parsed_DICOM_File> Parse_DICOM_Buffer(const std::string &contents, const std::string &name);
+
+std::string get_filename(const std::shared_ptr<Parsed_DICOM_File> &pdf);
+
+
 //------------------ General ----------------------
 //Generic helper functions.
 std::string Generate_Random_UID(long int len);
@@ -25,26 +51,48 @@ std::string Generate_Random_Int_Str(long int low, long int high);
 
 //One-offs.
 std::string get_tag_as_string(const std::string &filename, size_t U, size_t L);
+std::string get_tag_as_string(const std::shared_ptr<Parsed_DICOM_File> &pdf, size_t U, size_t L);
 
 std::string get_modality(const std::string &filename);
+std::string get_modality(const std::shared_ptr<Parsed_DICOM_File> &pdf);
 
 std::string get_patient_ID(const std::string &filename);
+std::string get_patient_ID(const std::shared_ptr<Parsed_DICOM_File> &pdf);
 
 //Mass top-level tag enumeration, for ingress into database.
 //
 //NOTE: May not be complete. Add additional tags as needed!
 std::map<std::string,std::string> get_metadata_top_level_tags(const std::string &filename);
+std::map<std::string,std::string> get_metadata_top_level_tags(const std::shared_ptr<Parsed_DICOM_File> &pdf);
+
+//Content fingerprint, for duplicate detection. Covers the raw (possibly encapsulated) pixel data and a normalized subset
+// of identifying top-level tags, so files that differ only in incidental metadata share a hash. Files without pixel
+// data are hashed byte-for-byte instead.
+//
+//NOTE: Throws if the file cannot be read or parsed.
+uint64_t get_content_hash(const std::string &filename);
+uint64_t get_content_hash(const std::shared_ptr<Parsed_DICOM_File> &pdf);
 
 
 //------------------ Contours ---------------------
 bimap<std::string,long int> get_ROI_tags_and_numbers(const std::string &filename);
+bimap<std::string,long int> get_ROI_tags_and_numbers(const std::shared_ptr<Parsed_DICOM_File> &pdf);
 
 std::unique_ptr<Contour_Data>  get_Contour_Data(const std::string &filename);
+std::unique_ptr<Contour_Data>  get_Contour_Data(const std::shared_ptr<Parsed_DICOM_File> &pdf);
 
 
 //-------------------- Images ----------------------
 //This routine will often result in an array with only a single image. So collate output as needed.
 std::unique_ptr<Image_Array> Load_Image_Array(const std::string &filename);
+std::unique_ptr<Image_Array> Load_Image_Array(const std::shared_ptr<Parsed_DICOM_File> &pdf);
+
+//Reads the metadata and geometry, but defers decoding the pixel data. The image's pixel buffer is left empty and the
+// returned function decodes it when invoked (e.g., by a store attached with Image_Array::defer_pixels()). The function
+// keeps the parsed file alive, and errors in the pixel data are only reported when it is invoked. If decoding cannot be
+// deferred, the pixels are decoded immediately and an empty function is returned.
+std::pair<std::unique_ptr<Image_Array>, std::function<void(planar_image<float,double> &)>>
+Load_Image_Array_Deferred(const std::shared_ptr<Parsed_DICOM_File> &pdf);
 
 //These pointers will actually be unique. This just aims to convert from unique_ptr to shared_ptr for you.
 std::list<std::shared_ptr<Image_Array>>  Load_Image_Arrays(const std::list<std::string> &filenames);
@@ -55,12 +103,14 @@ std::unique_ptr<Image_Array> Collate_Image_Arrays(std::list<std::shared_ptr<Imag
 
 //--------------------- Dose -----------------------
 std::unique_ptr<Image_Array> Load_Dose_Array(const std::string &filename);
+std::unique_ptr<Image_Array> Load_Dose_Array(const std::shared_ptr<Parsed_DICOM_File> &pdf);
 
 //These pointers will actually be unique. This just aims to convert from unique_ptr to shared_ptr for you.
 std::list<std::shared_ptr<Image_Array>>  Load_Dose_Arrays(const std::list<std::string> &filenames);
 
 //-------------------- Plans ------------------------
 std::unique_ptr<TPlan_Config> Load_TPlan_Config(const std::string &filename);
+std::unique_ptr<TPlan_Config> Load_TPlan_Config(const std::shared_ptr<Parsed_DICOM_File> &pdf);
 
 //-------------------- Export -----------------------
 //Writes an Image_Array as if it were a dose matrix.
@@ -1,7 +1,9 @@
 //KineticModel_1Compartment2Input_5Param_Chebyshev_Common.cc.
 
+#include <cmath>
 #include <limits>
 #include <tuple>
+#include <vector>
 
 #include "KineticModel_1Compartment2Input_5Param_Chebyshev_Common.h"
 #include "YgorMathChebyshev.h"
@@ -11,6 +13,16 @@ void
 Evaluate_Model( const KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters &state,
                 const double t,
                 KineticModel_1Compartment2Input_5Param_Chebyshev_Results &res){
+    std::vector<KineticModel_1Compartment2Input_5Param_Chebyshev_Results> out;
+    Evaluate_Model(state, std::vector<double>{ t }, out);
+    res = out.front();
+    return;
+}
+
+void
+Evaluate_Model( const KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters &state,
+                const std::vector<double> &ts,
+                std::vector<KineticModel_1Compartment2Input_5Param_Chebyshev_Results> &res){
                 
     // Chebyshev polynomial approximation method. 
     // 
@@ -25,6 +37,11 @@ Evaluate_Model( const KineticModel_1Compartment2Input_5Param_Chebyshev_Parameter
     //       exponential below, you should first separate the 'tau' and 't' components into separate 
     //       polynomials, differentiate the relevant axis, and then combine them afterward.
     //
+    // The exponential kernel at time t is $\exp(k_2 \tau + k_2 (\tau_A - t))$, which only depends on t via a constant
+    // factor. So the kernel is multiplied and integrated once, without the factor, and the factor is applied when
+    // evaluating each time. Likewise, the $(\tau + \tau_A - t)$ factor needed for the $k_2$ gradient is split into a
+    // $\tau$ part and a constant part. Since coefficient truncation is linear, this matches evaluating each time
+    // individually.
 
     const double k1A  = state.k1A;
     const double tauA = state.tauA;
@@ -35,91 +52,71 @@ Evaluate_Model( const KineticModel_1Compartment2Input_5Param_Chebyshev_Parameter
     const size_t exp_approx_N = state.ExpApproxTrunc;
     const double mult_trunc = state.MultiplicationCoeffTrunc;
 
-    double int_AIF_exp      = std::numeric_limits<double>::quiet_NaN();
-    double int_VIF_exp      = std::numeric_limits<double>::quiet_NaN();
-    double int_AIF_exp_tau  = std::numeric_limits<double>::quiet_NaN();
-    double int_VIF_exp_tau  = std::numeric_limits<double>::quiet_NaN();
-    double int_dAIF_exp     = std::numeric_limits<double>::quiet_NaN();
-    double int_dVIF_exp     = std::numeric_limits<double>::quiet_NaN();
-
-    //AIF integral(s).
-    {
-        const double A = k2;
-        const double B = k2 * (tauA - t);
-        const double C = 1.0;
-        const double taumin = -tauA;
-        const double taumax = t - tauA;
-        double expmin, expmax;
-        std::tie(expmin,expmax) = state.cAIF->Get_Domain();
-    
-        cheby_approx<double> exp_kern = Chebyshev_Basis_Approx_Exp_Analytic1(exp_approx_N,expmin,expmax, A,B,C);
-        cheby_approx<double> integrand;
-        cheby_approx<double> integral;
-
-        //Evaluate the model.
-        integrand = exp_kern.Fast_Approx_Multiply(*(state.cAIF),mult_trunc);
-        integral = integrand.Chebyshev_Integral();
-        int_AIF_exp = (integral.Sample(taumax) - integral.Sample(taumin));
-
-        //Compute things for gradients.
-        {
-            //Evaluate $\partial_{k2}$ part of gradient.
-            integrand = integrand.Fast_Approx_Multiply(Chebyshev_Basis_Exact_Linear(expmin,expmax,1.0,tauA-t),mult_trunc);
-            integral = integrand.Chebyshev_Integral();
-            int_AIF_exp_tau = (integral.Sample(taumax) - integral.Sample(taumin));
-
-            //Evaluate $\partial_{tauA}$ part of gradient.
-            integrand = exp_kern.Fast_Approx_Multiply(*(state.dcAIF),mult_trunc);
-            integral = integrand.Chebyshev_Integral();
-            int_dAIF_exp = (integral.Sample(taumax) - integral.Sample(taumin));
-        }
-    }
-     
-    //VIF integral(s).
-    {
-        const double A = k2;
-        const double B = k2 * (tauV - t);
-        const double C = 1.0;
-        const double taumin = -tauV;
-        const double taumax = t - tauV;
+    //Integrals that are shared by all times: (model, tau-weighted model, constant-weighted model, derivative).
+    struct shared_integrals_t {
+        cheby_approx<double> exp_C;
+        cheby_approx<double> exp_C_tau;
+        cheby_approx<double> exp_C_one;
+        cheby_approx<double> exp_dC;
+    };
+    const auto compute_shared = [&](const cheby_approx<double> &C,
+                                    const cheby_approx<double> &dC) -> shared_integrals_t {
         double expmin, expmax;
-        std::tie(expmin,expmax) = state.cVIF->Get_Domain();
- 
-        cheby_approx<double> exp_kern = Chebyshev_Basis_Approx_Exp_Analytic1(exp_approx_N,expmin,expmax, A,B,C);
-        cheby_approx<double> integrand;
-        cheby_approx<double> integral;
-
-        //Evaluate the model.
-        integrand = exp_kern.Fast_Approx_Multiply(*state.cVIF,mult_trunc);
-        integral = integrand.Chebyshev_Integral();
-        int_VIF_exp = (integral.Sample(taumax) - integral.Sample(taumin));
-
-        //Compute things for gradients.
+        std::tie(expmin,expmax) = C.Get_Domain();
+
+        const cheby_approx<double> exp_kern = Chebyshev_Basis_Approx_Exp_Analytic1(exp_approx_N,expmin,expmax, k2,0.0,1.0);
+        const cheby_approx<double> integrand = exp_kern.Fast_Approx_Multiply(C,mult_trunc);
+
+        shared_integrals_t out;
+        out.exp_C = integrand.Chebyshev_Integral();
+        out.exp_C_tau = integrand.Fast_Approx_Multiply(Chebyshev_Basis_Exact_Linear(expmin,expmax,1.0,0.0),mult_trunc)
+                                 .Chebyshev_Integral();
+        out.exp_C_one = integrand.Fast_Approx_Multiply(Chebyshev_Basis_Exact_Linear(expmin,expmax,0.0,1.0),mult_trunc)
+                                 .Chebyshev_Integral();
+        out.exp_dC = exp_kern.Fast_Approx_Multiply(dC,mult_trunc).Chebyshev_Integral();
+        return out;
+    };
+    const auto A = compute_shared(*(state.cAIF), *(state.dcAIF));
+    const auto V = compute_shared(*(state.cVIF), *(state.dcVIF));
+
+    const auto A_taumin = std::make_tuple(A.exp_C.Sample(-tauA), A.exp_C_tau.Sample(-tauA),
+                                          A.exp_C_one.Sample(-tauA), A.exp_dC.Sample(-tauA));
+    const auto V_taumin = std::make_tuple(V.exp_C.Sample(-tauV), V.exp_C_tau.Sample(-tauV),
+                                          V.exp_C_one.Sample(-tauV), V.exp_dC.Sample(-tauV));
+
+    res.resize(ts.size());
+    for(size_t i = 0; i < ts.size(); ++i){
+        const double t = ts[i];
+
+        //AIF integral(s).
+        const double scale_A  = std::exp(k2 * (tauA - t));
+        const double taumax_A = t - tauA;
+        const double int_AIF_exp     = scale_A * (A.exp_C.Sample(taumax_A) - std::get<0>(A_taumin));
+        const double int_AIF_exp_tau = scale_A * ( (A.exp_C_tau.Sample(taumax_A) - std::get<1>(A_taumin))
+                                                 + (tauA - t) * (A.exp_C_one.Sample(taumax_A) - std::get<2>(A_taumin)) );
+        const double int_dAIF_exp    = scale_A * (A.exp_dC.Sample(taumax_A) - std::get<3>(A_taumin));
+
+        //VIF integral(s).
+        const double scale_V  = std::exp(k2 * (tauV - t));
+        const double taumax_V = t - tauV;
+        const double int_VIF_exp     = scale_V * (V.exp_C.Sample(taumax_V) - std::get<0>(V_taumin));
+        const double int_VIF_exp_tau = scale_V * ( (V.exp_C_tau.Sample(taumax_V) - std::get<1>(V_taumin))
+                                                 + (tauV - t) * (V.exp_C_one.Sample(taumax_V) - std::get<2>(V_taumin)) );
+        const double int_dVIF_exp    = scale_V * (V.exp_dC.Sample(taumax_V) - std::get<3>(V_taumin));
+
+        //Evaluate the model's integral. This is the model's predicted contrast enhancement.
+        res[i].I = (k1A * int_AIF_exp) + (k1V * int_VIF_exp);
+
+        //Work out gradient information, if desired.
         {
-            //Evaluate $\partial_{k2}$ part of gradient.
-            integrand = integrand.Fast_Approx_Multiply(Chebyshev_Basis_Exact_Linear(expmin,expmax,1.0,tauV-t),mult_trunc);
-            integral = integrand.Chebyshev_Integral();
-            int_VIF_exp_tau = (integral.Sample(taumax) - integral.Sample(taumin));
-
-            //Evaluate $\partial_{tauV}$ part of gradient.
-            integrand = exp_kern.Fast_Approx_Multiply((*state.dcVIF),mult_trunc);
-            integral = integrand.Chebyshev_Integral();
-            int_dVIF_exp = (integral.Sample(taumax) - integral.Sample(taumin));
+            res[i].d_I_d_k1A  = ( int_AIF_exp );  // $\partial_{k1A}$
+            res[i].d_I_d_tauA = ( -k1A * int_dAIF_exp ); // $\partial_{tauA}$
+            res[i].d_I_d_k1V  = ( int_VIF_exp ); // $\partial_{k1V}$
+            res[i].d_I_d_tauV = ( -k1V * int_dVIF_exp ); // $\partial_{tauV}$
+            res[i].d_I_d_k2   = ( (k1A * int_AIF_exp_tau) + (k1V * int_VIF_exp_tau)  ); // $\partial_{k2}$
         }
     }
 
-    //Evaluate the model's integral. This is the model's predicted contrast enhancement.
-    res.I = (k1A * int_AIF_exp) + (k1V * int_VIF_exp);
-
-    //Work out gradient information, if desired.
-    {
-        res.d_I_d_k1A  = ( int_AIF_exp );  // $\partial_{k1A}$
-        res.d_I_d_tauA = ( -k1A * int_dAIF_exp ); // $\partial_{tauA}$
-        res.d_I_d_k1V  = ( int_VIF_exp ); // $\partial_{k1V}$
-        res.d_I_d_tauV = ( -k1V * int_dVIF_exp ); // $\partial_{tauV}$
-        res.d_I_d_k2   = ( (k1A * int_AIF_exp_tau) + (k1V * int_VIF_exp_tau)  ); // $\partial_{k2}$
-    }
-
     return;
 }
 
@@ -7,6 +7,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <vector>
 
 #include "YgorMathChebyshevIOBoostSerialization.h"
 #include "YgorMathIOBoostSerialization.h"
@@ -55,6 +56,7 @@ struct KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters {
 
     // Fitting quantities (IFF available).
     double RSS  = std::numeric_limits<double>::quiet_NaN(); // Residual sum of squares.
+    size_t FittingIterations = 0; // Optimizer iterations, summed over all passes. (Instrumentation only; not serialized.)
 
     // 5-parameter liver CT perfusion parameters.
     double k1A  = std::numeric_limits<double>::quiet_NaN();
@@ -140,4 +142,11 @@ void
 Evaluate_Model( const KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters &state,
                 const double t,
                 KineticModel_1Compartment2Input_5Param_Chebyshev_Results &res);
+
+//Means for evaluating the model at many times with the supplied parameters. The Chebyshev kernel products and integrals
+// are computed once and shared by all times, so this is much faster than evaluating each time individually.
+void
+Evaluate_Model( const KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters &state,
+                const std::vector<double> &ts,
+                std::vector<KineticModel_1Compartment2Input_5Param_Chebyshev_Results> &res);
  
@@ -7,6 +7,7 @@
 #include <cmath>
 #include <limits>
 #include <memory>
+#include <vector>
 
 #ifdef DCMA_USE_NLOPT
 #include <nlopt.h>
@@ -42,12 +43,18 @@ MinimizationFunction_5Param(unsigned, const double *params, double *grad, void *
     state->tauV = params[3];
     state->k2   = params[4];
 
-    KineticModel_1Compartment2Input_5Param_Chebyshev_Results model_res;
+    std::vector<double> ts;
+    ts.reserve(state->cROI->samples.size());
+    for(const auto &P : state->cROI->samples) ts.push_back(P[0]);
+
+    std::vector<KineticModel_1Compartment2Input_5Param_Chebyshev_Results> model_results;
+    Evaluate_Model(*state, ts, model_results);
+
+    size_t i = 0;
     for(const auto &P : state->cROI->samples){
-        const double t = P[0];
         const double R = P[2];
 
-        Evaluate_Model(*state, t, model_res);
+        const auto &model_res = model_results[i++];
         const double I = model_res.I;
         
         sqDist += std::pow(R - I, 2.0); //Standard L2-norm.
@@ -287,12 +294,18 @@ MinimizationFunction_3Param(unsigned, const double *params, double *grad, void *
     state->tauV = 0.0;
     state->k2   = params[2];
 
-    KineticModel_1Compartment2Input_5Param_Chebyshev_Results model_res;
+    std::vector<double> ts;
+    ts.reserve(state->cROI->samples.size());
+    for(const auto &P : state->cROI->samples) ts.push_back(P[0]);
+
+    std::vector<KineticModel_1Compartment2Input_5Param_Chebyshev_Results> model_results;
+    Evaluate_Model(*state, ts, model_results);
+
+    size_t i = 0;
     for(const auto &P : state->cROI->samples){
-        const double t = P[0];
         const double R = P[2];
 
-        Evaluate_Model(*state, t, model_res);
+        const auto &model_res = model_results[i++];
         const double I = model_res.I;
         
         sqDist += std::pow(R - I, 2.0); //Standard L2-norm.
@@ -45,19 +45,23 @@ MinimizationFunction_f_5Param( const gsl_vector *params,  //Parameters being fit
     state->tauV = gsl_vector_get(params, 3);
     state->k2   = gsl_vector_get(params, 4);
 
-    KineticModel_1Compartment2Input_5Param_Chebyshev_Results model_res;
+    std::vector<double> ts;
+    ts.reserve(state->cROI->samples.size());
+    for(const auto &P : state->cROI->samples) ts.push_back(P[0]);
+
+    std::vector<KineticModel_1Compartment2Input_5Param_Chebyshev_Results> model_res;
+    try{
+        Evaluate_Model(*state, ts, model_res);
+    }catch(std::exception &){
+        model_res.assign(ts.size(), KineticModel_1Compartment2Input_5Param_Chebyshev_Results());
+    }
 
     size_t i = 0;
     double I;
     for(const auto &P : state->cROI->samples){
-        const double t = P[0];
         const double R = P[2];
  
-        I = std::numeric_limits<double>::quiet_NaN();
-        try{
-            Evaluate_Model(*state, t, model_res);
-            I = model_res.I;
-        }catch(std::exception &){ }
+        I = model_res[i].I;
         I = std::isfinite(I) ? I : std::numeric_limits<double>::infinity();
 
         gsl_vector_set(f, i, I - R);
@@ -86,30 +90,30 @@ MinimizationFunction_df_5Param( const gsl_vector *params,  //Parameters being fi
     state->tauV = gsl_vector_get(params, 3);
     state->k2   = gsl_vector_get(params, 4);
 
-    KineticModel_1Compartment2Input_5Param_Chebyshev_Results model_res;
+    std::vector<double> ts;
+    ts.reserve(state->cROI->samples.size());
+    for(const auto &P : state->cROI->samples) ts.push_back(P[0]);
 
-    size_t i = 0;
-    //double I;
-    for(const auto &P : state->cROI->samples){
-        const double t = P[0];
- 
+    std::vector<KineticModel_1Compartment2Input_5Param_Chebyshev_Results> model_res;
+    bool evaluated = false;
+    try{
+        Evaluate_Model(*state, ts, model_res);
+        evaluated = true;
+    }catch(std::exception &){ }
+
+    for(size_t i = 0; i < ts.size(); ++i){
         gsl_matrix_set(J, i, 0, std::numeric_limits<double>::infinity());
         gsl_matrix_set(J, i, 1, std::numeric_limits<double>::infinity());
         gsl_matrix_set(J, i, 2, std::numeric_limits<double>::infinity());
         gsl_matrix_set(J, i, 3, std::numeric_limits<double>::infinity());
         gsl_matrix_set(J, i, 4, std::numeric_limits<double>::infinity());
+        if(!evaluated) continue;
 
-        try{
-            Evaluate_Model(*state, t, model_res);
-
-            gsl_matrix_set(J, i, 0, model_res.d_I_d_k1A);
-            gsl_matrix_set(J, i, 1, model_res.d_I_d_tauA);
-            gsl_matrix_set(J, i, 2, model_res.d_I_d_k1V);
-            gsl_matrix_set(J, i, 3, model_res.d_I_d_tauV);
-            gsl_matrix_set(J, i, 4, model_res.d_I_d_k2);
-
-        }catch(std::exception &){ }
-        ++i;
+        gsl_matrix_set(J, i, 0, model_res[i].d_I_d_k1A);
+        gsl_matrix_set(J, i, 1, model_res[i].d_I_d_tauA);
+        gsl_matrix_set(J, i, 2, model_res[i].d_I_d_k1V);
+        gsl_matrix_set(J, i, 3, model_res[i].d_I_d_tauV);
+        gsl_matrix_set(J, i, 4, model_res[i].d_I_d_k2);
     }
 
     return GSL_SUCCESS;
@@ -130,6 +134,7 @@ Optimize_LevenbergMarquardt_5Param(KineticModel_1Compartment2Input_5Param_Chebys
 
     state.FittingPerformed = true;
     state.FittingSuccess = false;
+    state.FittingIterations = 0;
 
     bool skip_second_pass = false; //Gets set if a very good fit is found on the first pass.
 
@@ -191,6 +196,7 @@ Optimize_LevenbergMarquardt_5Param(KineticModel_1Compartment2Input_5Param_Chebys
         const auto dof = static_cast<double>(datum - dimen);
         const double red_chisq = chisq/dof;
 
+        state.FittingIterations += gsl_multifit_fdfsolver_niter(solver);
         state.RSS  = chisq;
         state.k1A  = gsl_vector_get(solver->x,0);
         state.tauA = gsl_vector_get(solver->x,1);
@@ -252,6 +258,7 @@ Optimize_LevenbergMarquardt_5Param(KineticModel_1Compartment2Input_5Param_Chebys
         //Perform the optimization.
         int info = -1;
         int status = gsl_multifit_fdfsolver_driver(solver, max_iters, paramtol_rel, gtol_rel, ftol_rel, &info);
+        state.FittingIterations += gsl_multifit_fdfsolver_niter(solver);
 
         if(status == GSL_SUCCESS){
             //Compute the final residual norm.
@@ -98,6 +98,40 @@ ComputeIntegralSummations(KineticModel_1Compartment2Input_Reduced3Param_Chebyshe
     std::tie(exp_A_min,exp_A_max) = state->cAIF->Get_Domain();
     std::tie(exp_V_min,exp_V_max) = state->cVIF->Get_Domain();
 
+    //The exponential kernel for sample time $t_i$ is $\exp(k_2 \tau + k_2 (\tau_A - t_i))$ (and likewise for the VIF), which
+    // only depends on $t_i$ via a constant factor. So the kernel products and their integrals are computed once per
+    // evaluation and scaled for each sample, rather than being recomputed for every sample.
+    cheby_approx<double> integral_A;
+    cheby_approx<double> t_integral_A;
+    cheby_approx<double> integral_V;
+    cheby_approx<double> t_integral_V;
+    double integral_A_at_taumin   = std::numeric_limits<double>::quiet_NaN();
+    double t_integral_A_at_taumin = std::numeric_limits<double>::quiet_NaN();
+    double integral_V_at_taumin   = std::numeric_limits<double>::quiet_NaN();
+    double t_integral_V_at_taumin = std::numeric_limits<double>::quiet_NaN();
+    try{
+        const cheby_approx<double> exp_kern_A = Chebyshev_Basis_Approx_Exp_Analytic1(exp_approx_N,exp_A_min,exp_A_max, k2,0.0,1.0);
+        const cheby_approx<double> integrand_A = exp_kern_A * (*(state->cAIF));
+        integral_A = integrand_A.Chebyshev_Integral();
+        integral_A_at_taumin = integral_A.Sample(-tauA);
+
+        const cheby_approx<double> exp_kern_V = Chebyshev_Basis_Approx_Exp_Analytic1(exp_approx_N,exp_V_min,exp_V_max, k2,0.0,1.0);
+        const cheby_approx<double> integrand_V = exp_kern_V * (*(state->cVIF));
+        integral_V = integrand_V.Chebyshev_Integral();
+        integral_V_at_taumin = integral_V.Sample(-tauV);
+
+        if(ComputeGradientToo){
+            t_integral_A = (integrand_A * Chebyshev_Basis_Exact_Linear(exp_A_min,exp_A_max,1.0,0.0)).Chebyshev_Integral();
+            t_integral_A_at_taumin = t_integral_A.Sample(-tauA);
+
+            t_integral_V = (integrand_V * Chebyshev_Basis_Exact_Linear(exp_V_min,exp_V_max,1.0,0.0)).Chebyshev_Integral();
+            t_integral_V_at_taumin = t_integral_V.Sample(-tauV);
+        }
+    }catch(const std::exception &e){
+        IndicateFailure();
+        return;
+    }
+
     for(const auto &R : state->cROI->samples){
         const double ti = R[0];
         const double Ri = R[2];
@@ -108,25 +142,15 @@ ComputeIntegralSummations(KineticModel_1Compartment2Input_Reduced3Param_Chebyshe
 
         //AIF integral.
         try{   
-            const double A = k2;
-            const double B = k2 * (tauA - ti);
-            const double C = 1.0; 
-            const double taumin = -tauA;
+            const double scale = std::exp(k2 * (tauA - ti));
             const double taumax = ti - tauA;
-            
-            const cheby_approx<double> exp_kern = Chebyshev_Basis_Approx_Exp_Analytic1(exp_approx_N,exp_A_min,exp_A_max, A,B,C);
-            const cheby_approx<double> integrand = exp_kern * (*(state->cAIF));
-            const cheby_approx<double> integral = integrand.Chebyshev_Integral();
 
-            IA = (integral.Sample(taumax) - integral.Sample(taumin));
+            IA = scale * (integral_A.Sample(taumax) - integral_A_at_taumin);
 
             if(ComputeGradientToo){
                 dtauA_IA = AIF_at_neg_tauA * std::exp(k2 * ti) - state->cAIF->Sample(ti - tauA);
 
-                const cheby_approx<double> t_integrand = integrand * Chebyshev_Basis_Exact_Linear(exp_A_min,exp_A_max,1.0,0.0);
-                const cheby_approx<double> t_integral = t_integrand.Chebyshev_Integral();
-
-                dk2_IA = -ti*IA + (t_integral.Sample(taumax) - t_integral.Sample(taumin));
+                dk2_IA = -ti*IA + scale * (t_integral_A.Sample(taumax) - t_integral_A_at_taumin);
             }
         }catch(const std::exception &e){
             IndicateFailure();
@@ -140,25 +164,15 @@ ComputeIntegralSummations(KineticModel_1Compartment2Input_Reduced3Param_Chebyshe
 
         //VIF integral.
         try{   
-            const double A = k2;
-            const double B = k2 * (tauV - ti);
-            const double C = 1.0; 
-            const double taumin = -tauV;
+            const double scale = std::exp(k2 * (tauV - ti));
             const double taumax = ti - tauV;
-            
-            const cheby_approx<double> exp_kern = Chebyshev_Basis_Approx_Exp_Analytic1(exp_approx_N,exp_V_min,exp_V_max, A,B,C);
-            const cheby_approx<double> integrand = exp_kern * (*(state->cVIF));
-            const cheby_approx<double> integral = integrand.Chebyshev_Integral();
 
-            IV = (integral.Sample(taumax) - integral.Sample(taumin));
+            IV = scale * (integral_V.Sample(taumax) - integral_V_at_taumin);
 
             if(ComputeGradientToo){
                 dtauV_IV = VIF_at_neg_tauV * std::exp(k2 * ti) - state->cVIF->Sample(ti - tauV);
 
-                const cheby_approx<double> t_integrand = integrand * Chebyshev_Basis_Exact_Linear(exp_V_min,exp_V_max,1.0,0.0);
-                const cheby_approx<double> t_integral = t_integrand.Chebyshev_Integral();
-
-                dk2_IV = -ti*IV + (t_integral.Sample(taumax) - t_integral.Sample(taumin));
+                dk2_IV = -ti*IV + scale * (t_integral_V.Sample(taumax) - t_integral_V_at_taumin);
             }
         }catch(const std::exception &e){
             IndicateFailure();
@@ -0,0 +1,112 @@
+//KineticModel_Chebyshev_Cache.cc.
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "YgorMath.h"
+#include "YgorMathBSpline.h"   //Needed for basis_spline class.
+#include "YgorMathChebyshev.h" //Needed for cheby_approx class.
+
+#include "Content_Hash.h"
+#include "KineticModel_Chebyshev_Cache.h"
+
+
+namespace {
+
+// Input functions are small, so only a handful are retained.
+constexpr size_t max_cached_expansions = 32;
+
+struct cache_entry_t {
+    uint64_t key;
+    samples_1D<double> samples;
+    chebyshev_expansion_settings settings;
+    chebyshev_expansion expansion;
+};
+
+std::mutex cache_mutex;
+std::list<cache_entry_t> cache; // Ordered from most to least recently used.
+
+uint64_t Cache_Key(const samples_1D<double> &samples, const chebyshev_expansion_settings &settings){
+    content_hasher H;
+    H.add(static_cast<uint64_t>(samples.samples.size()));
+    for(const auto &s : samples.samples){
+        for(const auto &x : s) H.add(x);
+    }
+    H.add(static_cast<uint64_t>(settings.num_coeffs));
+    H.add(settings.domain_min);
+    H.add(settings.domain_max);
+    H.add(static_cast<uint64_t>(settings.use_basis_spline));
+    H.add(static_cast<uint64_t>(settings.basis_spline_order));
+    H.add(static_cast<uint64_t>(settings.basis_spline_coeffs));
+    return H.digest();
+}
+
+// Hash collisions are not tolerable here, so hits are confirmed with a full comparison.
+bool Matches(const cache_entry_t &e, const samples_1D<double> &samples, const chebyshev_expansion_settings &settings){
+    return (e.settings.num_coeffs          == settings.num_coeffs)
+        && (e.settings.domain_min          == settings.domain_min)
+        && (e.settings.domain_max          == settings.domain_max)
+        && (e.settings.use_basis_spline    == settings.use_basis_spline)
+        && (e.settings.basis_spline_order  == settings.basis_spline_order)
+        && (e.settings.basis_spline_coeffs == settings.basis_spline_coeffs)
+        && (e.samples.samples == samples.samples);
+}
+
+chebyshev_expansion Build_Expansion(const samples_1D<double> &samples, const chebyshev_expansion_settings &settings){
+    cheby_approx<double> ca;
+
+    //Use basis spline interpolation when constructing the Chebyshev approximation.
+    if(settings.use_basis_spline){
+        const auto pinf = std::numeric_limits<double>::infinity(); //use automatic (maximal) endpoint determination.
+        basis_spline bs(samples.Strip_Uncertainties_in_y(), pinf, pinf,
+                        settings.basis_spline_order, settings.basis_spline_coeffs,
+                        basis_spline_breakpoints::adaptive_datum_density);
+        auto interp = [&bs](double t) -> double {
+                const auto interpolated_f = bs.Sample(t)[2];
+                return interpolated_f;
+        };
+        ca.Prepare(interp, settings.num_coeffs, settings.domain_min, settings.domain_max);
+
+    //Use (default) linear interpolation when constructing the Chebyshev approximation.
+    }else{
+        ca.Prepare(samples, settings.num_coeffs, settings.domain_min, settings.domain_max);
+    }
+
+    chebyshev_expansion out;
+    out.derivative = std::make_shared<const cheby_approx<double>>( ca.Chebyshev_Derivative() );
+    out.integral   = std::make_shared<const cheby_approx<double>>( ca.Chebyshev_Integral() );
+    out.approx     = std::make_shared<const cheby_approx<double>>( std::move(ca) );
+    return out;
+}
+
+} // namespace
+
+
+chebyshev_expansion
+Get_Chebyshev_Expansion(const samples_1D<double> &samples, const chebyshev_expansion_settings &settings){
+    const auto key = Cache_Key(samples, settings);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for(auto it = std::begin(cache); it != std::end(cache); ++it){
+            if( (it->key == key) && Matches(*it, samples, settings) ){
+                cache.splice(std::begin(cache), cache, it);
+                return cache.front().expansion;
+            }
+        }
+    }
+
+    // Built without holding the lock. Concurrent requests for the same expansion may both build it, which is harmless.
+    auto expansion = Build_Expansion(samples, settings);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.push_front({ key, samples, settings, expansion });
+    while(max_cached_expansions < cache.size()) cache.pop_back();
+    return expansion;
+}
+
@@ -0,0 +1,37 @@
+//KineticModel_Chebyshev_Cache.h.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "YgorMath.h"
+#include "YgorMathChebyshev.h"
+
+
+// Settings that, together with the source samples, fully determine a Chebyshev expansion of an input function.
+struct chebyshev_expansion_settings {
+    size_t num_coeffs = 0;
+    double domain_min = 0.0;
+    double domain_max = 0.0;
+
+    // If enabled, the samples are interpolated with a basis spline rather than linearly.
+    bool use_basis_spline = false;
+    long int basis_spline_order = 4;
+    size_t basis_spline_coeffs = 0;
+};
+
+// A Chebyshev expansion of an input function (e.g., an AIF or VIF) along with its derivative and antiderivative.
+struct chebyshev_expansion {
+    std::shared_ptr<const cheby_approx<double>> approx;
+    std::shared_ptr<const cheby_approx<double>> derivative;
+    std::shared_ptr<const cheby_approx<double>> integral;
+};
+
+
+// Returns the Chebyshev expansion of the given samples. Expansions are memoized process-wide, keyed by the sample
+// content and settings, so repeated fits (and re-runs of operations) on the same input functions reuse them rather
+// than rebuilding them. The most recently used expansions are retained. Thread-safe.
+chebyshev_expansion
+Get_Chebyshev_Expansion(const samples_1D<double> &samples, const chebyshev_expansion_settings &settings);
+
@@ -0,0 +1,76 @@
+//Lexicon_Cache.cc - A part of DICOMautomaton 2026.
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "Explicator.h"       //Needed for Explicator class.
+
+#include "Lexicon_Cache.h"
+
+
+struct lexicon_translator::shared_t {
+    explicit shared_t(const std::string &FilenameLex) : X(FilenameLex) {}
+
+    // Explicator retains the results of the last match, so lookups are serialized.
+    std::mutex X_m;
+    Explicator X;
+
+    std::mutex memo_m;
+    std::map<std::string, std::string> memo;
+};
+
+namespace {
+
+// Keyed on the canonical path, and holding the modification time of the lexicon when it was parsed.
+std::mutex lexicon_cache_m;
+std::map<std::string, std::pair<std::filesystem::file_time_type, std::shared_ptr<lexicon_translator::shared_t>>>
+    lexicon_cache;
+
+} // namespace
+
+
+lexicon_translator::lexicon_translator(const std::string &FilenameLex){
+    std::error_code ec;
+    auto path = std::filesystem::weakly_canonical(FilenameLex, ec).string();
+    if(ec) path = FilenameLex;
+    const auto mtime = std::filesystem::last_write_time(FilenameLex, ec);
+    if(ec){
+        // Leave the reporting of unreadable lexicons to Explicator, and do not cache them.
+        this->shared = std::make_shared<shared_t>(FilenameLex);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(lexicon_cache_m);
+    auto it = lexicon_cache.find(path);
+    if( (it == std::end(lexicon_cache))
+    ||  (it->second.first != mtime) ){
+        auto s = std::make_shared<shared_t>(FilenameLex);
+        it = lexicon_cache.insert_or_assign(path, std::make_pair(mtime, std::move(s))).first;
+    }
+    this->shared = it->second.second;
+}
+
+std::string lexicon_translator::operator()(const std::string &label) const {
+    auto &s = *(this->shared);
+    {
+        std::lock_guard<std::mutex> lock(s.memo_m);
+        const auto it = s.memo.find(label);
+        if(it != std::end(s.memo)) return it->second;
+    }
+
+    std::string canonical;
+    {
+        std::lock_guard<std::mutex> lock(s.X_m);
+        canonical = s.X(label);
+    }
+
+    std::lock_guard<std::mutex> lock(s.memo_m);
+    s.memo.emplace(label, canonical);
+    return canonical;
+}
+
@@ -0,0 +1,26 @@
+//Lexicon_Cache.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+
+// Translates labels (e.g., ROI names) to their canonical form using a lexicon.
+//
+// Lexicons are parsed once per process and shared by every translator constructed for the same file, and each
+// translation is memoized, so operations invoked repeatedly (e.g., within Repeat or ForEachDistinct) avoid re-parsing
+// the lexicon and re-matching labels. A lexicon is re-parsed if its modification time changes. Translators are cheap
+// to copy and are thread-safe.
+class lexicon_translator {
+  public:
+    explicit lexicon_translator(const std::string &FilenameLex);
+
+    std::string operator()(const std::string &label) const;
+
+    struct shared_t; // The parsed lexicon and memoized translations.
+
+  private:
+    std::shared_ptr<shared_t> shared;
+};
+
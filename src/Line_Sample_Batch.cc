@@ -0,0 +1,255 @@
+//Line_Sample_Batch.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Thread_Pool.h"
+#include "Time_Course_Tensor.h"
+#include "Line_Sample_Batch.h"
+
+
+namespace {
+
+// The number of series processed per task. Each task sweeps its block of series once per abscissa.
+constexpr size_t series_block_size = 4096;
+
+// Invokes f(begin, end) for consecutive blocks of series, concurrently.
+template <class F>
+void for_each_series_block(size_t N, F f){
+    const auto N_blocks = static_cast<long int>((N + series_block_size - 1) / series_block_size);
+    parallel_for(0, N_blocks, [&](long int b) -> void {
+        const auto begin = static_cast<size_t>(b) * series_block_size;
+        const auto end = std::min(N, begin + series_block_size);
+        f(begin, end);
+    }, /*grain=*/ 1);
+    return;
+}
+
+void validate_abscissae(const std::vector<double> &x){
+    for(size_t k = 0; k < x.size(); ++k){
+        if(!std::isfinite(x[k])) throw std::invalid_argument("Abscissae must be finite");
+        if( (0 < k) && (x[k] < x[k - 1]) ) throw std::invalid_argument("Abscissae must be non-decreasing");
+    }
+    return;
+}
+
+} // namespace
+
+
+line_sample_batch::line_sample_batch(std::vector<double> x_in, size_t N)
+  : x(std::move(x_in)){
+    validate_abscissae(this->x);
+    this->y.assign(this->x.size() * N, 0.0);
+}
+
+size_t line_sample_batch::size() const {
+    return this->x.empty() ? 0 : (this->y.size() / this->x.size());
+}
+
+size_t line_sample_batch::samples() const {
+    return this->x.size();
+}
+
+
+line_sample_batch
+Make_Line_Sample_Batch(const std::vector<std::reference_wrapper<const samples_1D<double>>> &series){
+    if(series.empty()) return line_sample_batch();
+
+    std::vector<double> x;
+    for(const auto &d : series.front().get().samples) x.push_back(d[0]);
+    for(const auto &s : series){
+        const auto &samples = s.get().samples;
+        if( (samples.size() != x.size())
+        ||  !std::equal(std::begin(x), std::end(x), std::begin(samples),
+                        [](double a, const std::array<double, 4> &d){ return a == d[0]; }) ){
+            throw std::invalid_argument("Series must share identical abscissae");
+        }
+    }
+
+    const auto N = series.size();
+    line_sample_batch out(std::move(x), N);
+    const auto N_k = out.samples();
+    for_each_series_block(N, [&](size_t begin, size_t end) -> void {
+        for(size_t k = 0; k < N_k; ++k){
+            double *y = out.y.data() + k * N;
+            for(auto i = begin; i < end; ++i) y[i] = series[i].get().samples[k][2];
+        }
+    });
+    return out;
+}
+
+line_sample_batch
+Make_Line_Sample_Batch(const Time_Course_Tensor::group_t &group){
+    if(!group.has_times()){
+        throw std::invalid_argument("Every image must have a finite time");
+    }
+    if(group.size() == 0) return line_sample_batch();
+
+    const auto &first = *(group.get_images().front());
+    const auto N = first.data.size();
+    line_sample_batch out(group.get_times(), N);
+    const auto N_k = out.samples();
+    for_each_series_block(N, [&](size_t begin, size_t end) -> void {
+        for(auto i = begin; i < end; ++i){
+            const float *s = group.get_series(static_cast<long int>(i));
+            for(size_t k = 0; k < N_k; ++k) out.y[k * N + i] = static_cast<double>(s[k]);
+        }
+    });
+    return out;
+}
+
+samples_1D<double>
+Extract_Line_Sample(const line_sample_batch &batch, size_t series){
+    if(batch.size() <= series) throw std::out_of_range("Requested series does not exist");
+
+    samples_1D<double> out;
+    out.samples.reserve(batch.samples());
+    const bool inhibitsort = true;
+    for(size_t k = 0; k < batch.samples(); ++k){
+        out.push_back(batch.x[k], 0.0, batch.at(series, k), 0.0, inhibitsort);
+    }
+    return out;
+}
+
+
+std::vector<double>
+Integrate_Line_Sample_Batch(const line_sample_batch &batch,
+                            double lower,
+                            double upper){
+    const auto N = batch.size();
+    const auto N_k = batch.samples();
+    const auto &x = batch.x;
+
+    // The integral of the linear interpolant is a weighted sum of the ordinates, so the weights are computed once.
+    std::vector<double> w(N_k, 0.0);
+    for(size_t k = 0; (k + 1) < N_k; ++k){
+        const auto h = x[k + 1] - x[k];
+        const auto a = std::max(x[k], lower);
+        const auto b = std::min(x[k + 1], upper);
+        if( !(0.0 < h) || !(a < b) ) continue;
+
+        w[k]     += ((x[k + 1] - a) * (x[k + 1] - a) - (x[k + 1] - b) * (x[k + 1] - b)) / (2.0 * h);
+        w[k + 1] += ((b - x[k]) * (b - x[k]) - (a - x[k]) * (a - x[k])) / (2.0 * h);
+    }
+
+    std::vector<double> out(N, 0.0);
+    for_each_series_block(N, [&](size_t begin, size_t end) -> void {
+        for(size_t k = 0; k < N_k; ++k){
+            if(w[k] == 0.0) continue; // Samples outside the range are not touched, so they cannot propagate.
+            const double wk = w[k];
+            const double *y = batch.y.data() + k * N;
+            for(auto i = begin; i < end; ++i) out[i] += wk * y[i];
+        }
+    });
+    return out;
+}
+
+line_sample_batch
+Resample_Line_Sample_Batch(const line_sample_batch &batch,
+                           const std::vector<double> &x){
+    validate_abscissae(x);
+    const auto N = batch.size();
+    const auto N_k = batch.samples();
+    line_sample_batch out(x, N);
+
+    // Each new abscissa is located once, and expressed as a blend of two existing samples.
+    struct blend_t {
+        size_t k0 = 0;
+        size_t k1 = 0;
+        double t = 0.0;
+        bool inside = false;
+    };
+    std::vector<blend_t> blends(x.size());
+    for(size_t j = 0; j < x.size(); ++j){
+        auto &b = blends[j];
+        if( (N_k == 0) || (x[j] < batch.x.front()) || (batch.x.back() < x[j]) ) continue;
+
+        const auto it = std::upper_bound(std::begin(batch.x), std::end(batch.x), x[j]);
+        b.inside = true;
+        if(it == std::end(batch.x)){
+            b.k0 = b.k1 = N_k - 1; // x[j] coincides with the final abscissa.
+            continue;
+        }
+        b.k1 = static_cast<size_t>(std::distance(std::begin(batch.x), it));
+        b.k0 = b.k1 - 1;
+        b.t = (x[j] - batch.x[b.k0]) / (batch.x[b.k1] - batch.x[b.k0]);
+    }
+
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+    for_each_series_block(N, [&](size_t begin, size_t end) -> void {
+        for(size_t j = 0; j < x.size(); ++j){
+            const auto &b = blends[j];
+            double *o = out.y.data() + j * N;
+            if(!b.inside){
+                for(auto i = begin; i < end; ++i) o[i] = nan;
+                continue;
+            }
+            const double *y0 = batch.y.data() + b.k0 * N;
+            const double *y1 = batch.y.data() + b.k1 * N;
+            const double t = b.t;
+            const double s = 1.0 - t;
+            for(auto i = begin; i < end; ++i) o[i] = s * y0[i] + t * y1[i];
+        }
+    });
+    return out;
+}
+
+size_t
+Normalize_Line_Sample_Batch(line_sample_batch &batch,
+                            line_sample_normalization method){
+    const auto N = batch.size();
+    const auto N_k = batch.samples();
+
+    // Each series is transformed as y := (y - shift) * scale.
+    std::vector<double> shift(N, 0.0);
+    std::vector<double> scale;
+    if(method == line_sample_normalization::area){
+        scale = Integrate_Line_Sample_Batch(batch);
+        for(auto &s : scale) s = 1.0 / s;
+
+    }else if(method == line_sample_normalization::peak){
+        std::vector<double> hi(N, -std::numeric_limits<double>::infinity());
+        std::fill(std::begin(shift), std::end(shift), std::numeric_limits<double>::infinity());
+        for_each_series_block(N, [&](size_t begin, size_t end) -> void {
+            for(size_t k = 0; k < N_k; ++k){
+                const double *y = batch.y.data() + k * N;
+                for(auto i = begin; i < end; ++i){
+                    shift[i] = (y[i] < shift[i]) ? y[i] : shift[i];
+                    hi[i] = (hi[i] < y[i]) ? y[i] : hi[i];
+                }
+            }
+        });
+        scale.resize(N);
+        for(size_t i = 0; i < N; ++i) scale[i] = 1.0 / (hi[i] - shift[i]);
+
+    }else{
+        throw std::invalid_argument("Normalization method not understood");
+    }
+
+    size_t failed = 0;
+    for(size_t i = 0; i < N; ++i){
+        if(!std::isfinite(scale[i]) || !std::isfinite(shift[i])){
+            scale[i] = std::numeric_limits<double>::quiet_NaN();
+            shift[i] = 0.0;
+            ++failed;
+        }
+    }
+
+    for_each_series_block(N, [&](size_t begin, size_t end) -> void {
+        for(size_t k = 0; k < N_k; ++k){
+            double *y = batch.y.data() + k * N;
+            for(auto i = begin; i < end; ++i) y[i] = (y[i] - shift[i]) * scale[i];
+        }
+    });
+    return failed;
+}
+
@@ -0,0 +1,79 @@
+//Line_Sample_Batch.h.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Time_Course_Tensor.h"
+
+
+// Many one-dimensional series sampled at shared abscissae, e.g., the time courses of every voxel in an image volume.
+//
+// Compared with holding a samples_1D per series, the abscissae are stored once and the ordinates share a single
+// buffer. Ordinates are stored sample-major: y[k * size() + i] is the ordinate of series i at abscissa x[k]. The
+// kernels below therefore sweep each sample across all series with unit stride and no dependence between series, so
+// the inner loops vectorize without reassociating floating-point arithmetic. Series are also partitioned among
+// threads.
+//
+// Uncertainties and metadata are not represented.
+struct line_sample_batch {
+    std::vector<double> x; // Shared abscissae, in non-decreasing order.
+    std::vector<double> y; // Ordinates, sample-major.
+
+    line_sample_batch() = default;
+
+    // Allocates the ordinates of N series (initialized to zero) at the given abscissae. Throws if the abscissae are not
+    // finite and non-decreasing.
+    line_sample_batch(std::vector<double> x, size_t N);
+
+    size_t size() const;    // The number of series.
+    size_t samples() const; // The number of abscissae.
+
+    double & at(size_t series, size_t k){ return this->y[k * this->size() + series]; }
+    double at(size_t series, size_t k) const { return this->y[k * this->size() + series]; }
+};
+
+
+// Packs the series into a batch. All series must be sampled at identical abscissae, otherwise this throws.
+line_sample_batch
+Make_Line_Sample_Batch(const std::vector<std::reference_wrapper<const samples_1D<double>>> &series);
+
+// Packs the voxel time courses of a tensor group, ordered by planar_image::index(). The group's images must all have
+// finite times, otherwise this throws.
+line_sample_batch
+Make_Line_Sample_Batch(const Time_Course_Tensor::group_t &group);
+
+// Unpacks one series. Uncertainties are zero.
+samples_1D<double>
+Extract_Line_Sample(const line_sample_batch &batch, size_t series);
+
+
+// Integrates the linear interpolant of every series over [lower, upper] (clamped to the abscissae), like
+// samples_1D::Integrate_Over_Kernel_unit() over the whole domain by default. Non-finite ordinates propagate.
+std::vector<double>
+Integrate_Line_Sample_Batch(const line_sample_batch &batch,
+                            double lower = -std::numeric_limits<double>::infinity(),
+                            double upper = std::numeric_limits<double>::infinity());
+
+// Linearly interpolates every series at the given abscissae, which must be non-decreasing. Abscissae outside the
+// batch's abscissae are assigned NaN.
+line_sample_batch
+Resample_Line_Sample_Batch(const line_sample_batch &batch,
+                           const std::vector<double> &x);
+
+enum class line_sample_normalization {
+    area,  // Scale so the integral over the whole domain is one.
+    peak,  // Shift and scale so the ordinates span [0, 1].
+};
+
+// Normalizes every series in-place, like NormalizeLineSamples. Series that cannot be normalized because the required
+// scale factor is not finite are assigned NaN. Returns the number of such series.
+size_t
+Normalize_Line_Sample_Batch(line_sample_batch &batch,
+                            line_sample_normalization method);
+
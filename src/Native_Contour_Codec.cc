@@ -0,0 +1,131 @@
+//Native_Contour_Codec.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Native_Contour_Codec.h"
+
+
+namespace {
+
+constexpr int native_contour_max_decimals = 12;
+
+enum class native_coordinate_codec : uint8_t {
+    constant = 0, // A single double.
+    decimal  = 1, // The number of decimal digits, then the delta-encoded fixed-point values.
+    bits     = 2, // The delta-encoded bit patterns.
+};
+
+uint64_t Native_Archive_Zigzag(int64_t x){
+    return (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(-static_cast<int64_t>(x < 0));
+}
+
+int64_t Native_Archive_Unzigzag(uint64_t x){
+    return static_cast<int64_t>(x >> 1) ^ -static_cast<int64_t>(x & 1U);
+}
+
+double Native_Archive_Pow10(int d){
+    double p = 1.0;
+    for(int i = 0; i < d; ++i) p *= 10.0; // Exact for the supported range.
+    return p;
+}
+
+// Returns the fewest decimal digits d for which every coordinate x is exactly k / 10^d for an integer k, or -1.
+//
+// Note: a negative zero would be decoded as a positive zero, so it cannot be represented.
+int Native_Archive_Decimal_Digits(const std::vector<double> &xs){
+    if(std::any_of(std::begin(xs), std::end(xs), [](double x){ return (x == 0.0) && std::signbit(x); })) return -1;
+
+    for(int d = 0; d <= native_contour_max_decimals; ++d){
+        const auto p = Native_Archive_Pow10(d);
+        const bool exact = std::all_of(std::begin(xs), std::end(xs), [&](double x) -> bool {
+            const auto k = std::nearbyint(x * p);
+            if(!(std::abs(k) < 9007199254740992.0)) return false; // 2^53, or not finite.
+            const auto y = k / p;
+            return (std::memcmp(&x, &y, sizeof(double)) == 0);
+        });
+        if(exact) return d;
+    }
+    return -1;
+}
+
+} // namespace
+
+
+void Native_Archive_Put_Varint(std::string &buf, uint64_t x){
+    while(0x80U <= x){
+        buf.push_back(static_cast<char>((x & 0x7FU) | 0x80U));
+        x >>= 7;
+    }
+    buf.push_back(static_cast<char>(x));
+    return;
+}
+
+void Native_Archive_Encode_Coordinate(std::string &buf, const std::vector<double> &xs){
+    const bool constant = std::all_of(std::begin(xs), std::end(xs), [&](double x) -> bool {
+        return (std::memcmp(&x, &(xs.front()), sizeof(double)) == 0);
+    });
+    if(constant){
+        buf.push_back(static_cast<char>(native_coordinate_codec::constant));
+        buf.append(reinterpret_cast<const char *>(&(xs.front())), sizeof(double));
+        return;
+    }
+
+    const auto d = Native_Archive_Decimal_Digits(xs);
+    if(0 <= d){
+        buf.push_back(static_cast<char>(native_coordinate_codec::decimal));
+        buf.push_back(static_cast<char>(d));
+        const auto p = Native_Archive_Pow10(d);
+        int64_t prev = 0;
+        for(const auto &x : xs){
+            const auto k = static_cast<int64_t>(std::nearbyint(x * p));
+            Native_Archive_Put_Varint(buf, Native_Archive_Zigzag(k - prev));
+            prev = k;
+        }
+        return;
+    }
+
+    buf.push_back(static_cast<char>(native_coordinate_codec::bits));
+    uint64_t prev = 0;
+    for(const auto &x : xs){
+        uint64_t bits = 0;
+        std::memcpy(&bits, &x, sizeof(bits));
+        Native_Archive_Put_Varint(buf, Native_Archive_Zigzag(static_cast<int64_t>(bits - prev)));
+        prev = bits;
+    }
+    return;
+}
+
+void Native_Archive_Decode_Coordinate(native_contour_reader &r, std::vector<double> &xs){
+    const auto codec = static_cast<native_coordinate_codec>(r.get_byte());
+    if(codec == native_coordinate_codec::constant){
+        std::fill(std::begin(xs), std::end(xs), r.get_double());
+
+    }else if(codec == native_coordinate_codec::decimal){
+        const auto d = static_cast<int>(r.get_byte());
+        if(native_contour_max_decimals < d) throw std::runtime_error("Native archive contour data is invalid");
+        const auto p = Native_Archive_Pow10(d);
+        int64_t k = 0;
+        for(auto &x : xs){
+            k += Native_Archive_Unzigzag(r.get_varint());
+            x = static_cast<double>(k) / p;
+        }
+
+    }else if(codec == native_coordinate_codec::bits){
+        uint64_t bits = 0;
+        for(auto &x : xs){
+            bits += static_cast<uint64_t>(Native_Archive_Unzigzag(r.get_varint()));
+            std::memcpy(&x, &bits, sizeof(bits));
+        }
+
+    }else{
+        throw std::runtime_error("Native archive contour data is invalid");
+    }
+    return;
+}
@@ -0,0 +1,58 @@
+//Native_Contour_Codec.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+// Lossless encoding of contour point coordinates for native Drover archives.
+//
+// Each coordinate of a contour (e.g., all x coordinates) is encoded separately. Coordinates which can be reproduced
+// exactly from a decimal fixed-point value (e.g., those parsed from DICOM decimal strings) are stored as integer
+// multiples of the coarsest such step, and other coordinates as differences of their bit patterns. Both are
+// delta-encoded and written as zigzag varints. A coordinate which is constant over a contour (e.g., the image plane of
+// a contour drawn on an axial slice) is stored once. Decoding reproduces every coordinate bit-for-bit, including
+// signed zeros and non-finite values.
+
+void Native_Archive_Put_Varint(std::string &buf, uint64_t x);
+
+// Appends the encoded coordinates to the buffer.
+void Native_Archive_Encode_Coordinate(std::string &buf, const std::vector<double> &xs);
+
+// Bounds-checked reader for encoded contour data. Throws if the data are truncated or invalid.
+struct native_contour_reader {
+    const char *cur;
+    const char *end;
+
+    uint8_t get_byte(){
+        if(this->cur == this->end) throw std::runtime_error("Native archive contour data is truncated");
+        return static_cast<uint8_t>(*(this->cur++));
+    }
+    uint64_t get_varint(){
+        uint64_t x = 0;
+        for(int shift = 0; shift < 64; shift += 7){
+            const auto b = this->get_byte();
+            x |= static_cast<uint64_t>(b & 0x7FU) << shift;
+            if((b & 0x80U) == 0U) return x;
+        }
+        throw std::runtime_error("Native archive contour data is invalid");
+    }
+    double get_double(){
+        if(static_cast<size_t>(this->end - this->cur) < sizeof(double)){
+            throw std::runtime_error("Native archive contour data is truncated");
+        }
+        double x;
+        std::memcpy(&x, this->cur, sizeof(double));
+        this->cur += sizeof(double);
+        return x;
+    }
+};
+
+// Inverts Native_Archive_Encode_Coordinate(). The number of coordinates is not encoded, so xs must already hold the
+// number that were encoded.
+void Native_Archive_Decode_Coordinate(native_contour_reader &r, std::vector<double> &xs);
@@ -4,20 +4,49 @@
 // Operations can be anything, e.g., analyses, serialization, and visualization.
 //
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/algorithm/string/predicate.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <functional>
+#include <iomanip>
+#include <iterator>
 #include <list>
 #include <map>
+#include <mutex>
+#include <optional>
 #include <ostream>
+#include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>    
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/resource.h>
+#endif
 
 #include <YgorMisc.h>
 
+#include "Common_Boost_Serialization.h"
+#include "Content_Hash.h"
+#include "Drover_Memory.h"
+#include "Regex_Selectors.h"
 #include "Structs.h"
+#include "Thread_Pool.h"
+#include "Tracing.h"
+#include "YgorImages_Functors/Pointwise_Fusion.h"
 
 #include "Operations/AccumulateRowsColumns.h"
 #include "Operations/AnalyzeHistograms.h"
@@ -28,6 +57,7 @@
 #include "Operations/AutoCropImages.h"
 #include "Operations/Average.h"
 #include "Operations/BEDConvert.h"
+#include "Operations/BooleanSurfaceMeshes.h"
 #include "Operations/BoostSerializeDrover.h"
 #include "Operations/BuildLexiconInteractively.h"
 #include "Operations/ClusterDBSCAN.h"
@@ -35,6 +65,7 @@
 #include "Operations/ContourBasedRayCastDoseAccumulate.h"
 #include "Operations/ContourSimilarity.h"
 #include "Operations/ContourViaGeometry.h"
+#include "Operations/ContourViaThreshold.h"
 #include "Operations/ContourVote.h"
 #include "Operations/ContourWholeImages.h"
 #include "Operations/ContouringAides.h"
@@ -42,6 +73,8 @@
 #include "Operations/ConvertContoursToPoints.h"
 #include "Operations/ConvertDoseToImage.h"
 #include "Operations/ConvertImageToDose.h"
+#include "Operations/ConvertImageToMeshes.h"
+#include "Operations/ConvertMeshesToContours.h"
 #include "Operations/ConvertNaNsToAir.h"
 #include "Operations/ConvertNaNsToZeros.h"
 #include "Operations/ConvertPixelsToPoints.h"
@@ -90,6 +123,7 @@
 #include "Operations/ExportPointClouds.h"
 #include "Operations/ExtractAlphaBeta.h"
 #include "Operations/ExtractImageHistograms.h"
+#include "Operations/ExtractImagesWarp.h"
 #include "Operations/ExtractPointsWarp.h"
 #include "Operations/ForEachDistinct.h"
 #include "Operations/FVPicketFence.h"
@@ -122,8 +156,10 @@
 #include "Operations/NegatePixels.h"
 #include "Operations/NormalizeLineSamples.h"
 #include "Operations/NormalizePixels.h"
+#include "Operations/OffsetSurfaceMeshes.h"
 #include "Operations/OptimizeStaticBeams.h"
 #include "Operations/OrderImages.h"
+#include "Operations/PageOutImages.h"
 #include "Operations/PartitionContours.h"
 #include "Operations/PlotPerROITimeCourses.h"
 #include "Operations/PlotLineSamples.h"
@@ -133,14 +169,19 @@
 #include "Operations/PurgeContours.h"
 #include "Operations/RankPixels.h"
 #include "Operations/ReduceNeighbourhood.h"
+#include "Operations/ReformatImages.h"
+#include "Operations/RemeshSurfaceMeshes.h"
 #include "Operations/Repeat.h"
+#include "Operations/ReportMemoryUsage.h"
 #include "Operations/ScalePixels.h"
 #include "Operations/SelectSlicesIntersectingROI.h"
 #include "Operations/SimplifyContours.h"
+#include "Operations/SimplifySurfaceMeshes.h"
 #include "Operations/SimulateRadiograph.h"
 #include "Operations/SpatialBlur.h"
 #include "Operations/SpatialDerivative.h"
 #include "Operations/SpatialSharpen.h"
+#include "Operations/SubdivideSurfaceMeshes.h"
 #include "Operations/Subsegment_ComputeDose_VanLuijk.h"
 #include "Operations/SubsegmentContours.h"
 #include "Operations/SubtractImages.h"
@@ -158,6 +199,7 @@
 #include "Operations/VolumetricCorrelationDetector.h"
 #include "Operations/VolumetricSpatialBlur.h"
 #include "Operations/VolumetricSpatialDerivative.h"
+#include "Operations/WarpMeshes.h"
 #include "Operations/WarpPoints.h"
 
 #ifdef DCMA_USE_SDL
@@ -186,17 +228,11 @@
 #ifdef DCMA_USE_CGAL
     #include "Operations/BCCAExtractRadiomicFeatures.h"
     #include "Operations/ContourBooleanOperations.h"
-    #include "Operations/ContourViaThreshold.h"
-    #include "Operations/ConvertImageToMeshes.h"
-    #include "Operations/ConvertMeshesToContours.h"
     #include "Operations/DumpROISurfaceMeshes.h"
     #include "Operations/ExtractRadiomicFeatures.h"
     #include "Operations/MakeMeshesManifold.h"
     #include "Operations/MinkowskiSum3D.h"
-    #include "Operations/RemeshSurfaceMeshes.h"
     #include "Operations/SeamContours.h"
-    #include "Operations/SimplifySurfaceMeshes.h"
-    #include "Operations/SubdivideSurfaceMeshes.h"
     #include "Operations/SurfaceBasedRayCastDoseAccumulate.h"
 #endif // DCMA_USE_CGAL
 
@@ -215,6 +251,7 @@ std::map<std::string, op_packet_t> Known_Operations(){
     out["AutoCropImages"] = std::make_pair(OpArgDocAutoCropImages, AutoCropImages);
     out["Average"] = std::make_pair(OpArgDocAverage, Average);
     out["BEDConvert"] = std::make_pair(OpArgDocBEDConvert, BEDConvert);
+    out["BooleanSurfaceMeshes"] = std::make_pair(OpArgDocBooleanSurfaceMeshes, BooleanSurfaceMeshes);
     out["BoostSerializeDrover"] = std::make_pair(OpArgDocBoost_Serialize_Drover, Boost_Serialize_Drover);
     out["BuildLexiconInteractively"] = std::make_pair(OpArgDocBuildLexiconInteractively, BuildLexiconInteractively);
     out["ClusterDBSCAN"] = std::make_pair(OpArgDocClusterDBSCAN, ClusterDBSCAN);
@@ -222,6 +259,7 @@ std::map<std::string, op_packet_t> Known_Operations(){
     out["ContourBasedRayCastDoseAccumulate"] = std::make_pair(OpArgDocContourBasedRayCastDoseAccumulate, ContourBasedRayCastDoseAccumulate);
     out["ContourSimilarity"] = std::make_pair(OpArgDocContourSimilarity, ContourSimilarity);
     out["ContourViaGeometry"] = std::make_pair(OpArgDocContourViaGeometry, ContourViaGeometry);
+    out["ContourViaThreshold"] = std::make_pair(OpArgDocContourViaThreshold, ContourViaThreshold);
     out["ContourVote"] = std::make_pair(OpArgDocContourVote, ContourVote);
     out["ContourWholeImages"] = std::make_pair(OpArgDocContourWholeImages, ContourWholeImages);
     out["ContouringAides"] = std::make_pair(OpArgDocContouringAides, ContouringAides);
@@ -229,6 +267,8 @@ std::map<std::string, op_packet_t> Known_Operations(){
     out["ConvertContoursToPoints"] = std::make_pair(OpArgDocConvertContoursToPoints, ConvertContoursToPoints);
     out["ConvertDoseToImage"] = std::make_pair(OpArgDocConvertDoseToImage, ConvertDoseToImage);
     out["ConvertImageToDose"] = std::make_pair(OpArgDocConvertImageToDose, ConvertImageToDose);
+    out["ConvertImageToMeshes"] = std::make_pair(OpArgDocConvertImageToMeshes, ConvertImageToMeshes);
+    out["ConvertMeshesToContours"] = std::make_pair(OpArgDocConvertMeshesToContours, ConvertMeshesToContours);
     out["ConvertNaNsToAir"] = std::make_pair(OpArgDocConvertNaNsToAir, ConvertNaNsToAir);
     out["ConvertNaNsToZeros"] = std::make_pair(OpArgDocConvertNaNsToZeros, ConvertNaNsToZeros);
     out["ConvertPixelsToPoints"] = std::make_pair(OpArgDocConvertPixelsToPoints, ConvertPixelsToPoints);
@@ -277,6 +317,7 @@ std::map<std::string, op_packet_t> Known_Operations(){
     out["ExportWarps"] = std::make_pair(OpArgDocExportWarps, ExportWarps);
     out["ExtractAlphaBeta"] = std::make_pair(OpArgDocExtractAlphaBeta, ExtractAlphaBeta);
     out["ExtractImageHistograms"] = std::make_pair(OpArgDocExtractImageHistograms, ExtractImageHistograms);
+    out["ExtractImagesWarp"] = std::make_pair(OpArgDocExtractImagesWarp, ExtractImagesWarp);
     out["ExtractPointsWarp"] = std::make_pair(OpArgDocExtractPointsWarp, ExtractPointsWarp);
     out["ForEachDistinct"] = std::make_pair(OpArgDocForEachDistinct, ForEachDistinct);
     out["FVPicketFence"] = std::make_pair(OpArgDocFVPicketFence, FVPicketFence);
@@ -309,8 +350,10 @@ std::map<std::string, op_packet_t> Known_Operations(){
     out["NegatePixels"] = std::make_pair(OpArgDocNegatePixels, NegatePixels);
     out["NormalizeLineSamples"] = std::make_pair(OpArgDocNormalizeLineSamples, NormalizeLineSamples);
     out["NormalizePixels"] = std::make_pair(OpArgDocNormalizePixels, NormalizePixels);
+    out["OffsetSurfaceMeshes"] = std::make_pair(OpArgDocOffsetSurfaceMeshes, OffsetSurfaceMeshes);
     out["OptimizeStaticBeams"] = std::make_pair(OpArgDocOptimizeStaticBeams, OptimizeStaticBeams);
     out["OrderImages"] = std::make_pair(OpArgDocOrderImages, OrderImages);
+    out["PageOutImages"] = std::make_pair(OpArgDocPageOutImages, PageOutImages);
     out["PlotLineSamples"] = std::make_pair(OpArgDocPlotLineSamples, PlotLineSamples);
     out["PartitionContours"] = std::make_pair(OpArgDocPartitionContours, PartitionContours);
     out["PlotPerROITimeCourses"] = std::make_pair(OpArgDocPlotPerROITimeCourses, PlotPerROITimeCourses);
@@ -320,14 +363,19 @@ std::map<std::string, op_packet_t> Known_Operations(){
     out["PurgeContours"] = std::make_pair(OpArgDocPurgeContours, PurgeContours);
     out["RankPixels"] = std::make_pair(OpArgDocRankPixels, RankPixels);
     out["ReduceNeighbourhood"] = std::make_pair(OpArgDocReduceNeighbourhood, ReduceNeighbourhood);
+    out["ReformatImages"] = std::make_pair(OpArgDocReformatImages, ReformatImages);
+    out["RemeshSurfaceMeshes"] = std::make_pair(OpArgDocRemeshSurfaceMeshes, RemeshSurfaceMeshes);
     out["Repeat"] = std::make_pair(OpArgDocReduceNeighbourhood, Repeat);
+    out["ReportMemoryUsage"] = std::make_pair(OpArgDocReportMemoryUsage, ReportMemoryUsage);
     out["ScalePixels"] = std::make_pair(OpArgDocScalePixels, ScalePixels);
     out["SelectSlicesIntersectingROI"] = std::make_pair(OpArgDocSelectSlicesIntersectingROI, SelectSlicesIntersectingROI);
     out["SimplifyContours"] = std::make_pair(OpArgDocSimplifyContours, SimplifyContours);
+    out["SimplifySurfaceMeshes"] = std::make_pair(OpArgDocSimplifySurfaceMeshes, SimplifySurfaceMeshes);
     out["SimulateRadiograph"] = std::make_pair(OpArgDocSimulateRadiograph, SimulateRadiograph);
     out["SpatialBlur"] = std::make_pair(OpArgDocSpatialBlur, SpatialBlur);
     out["SpatialDerivative"] = std::make_pair(OpArgDocSpatialDerivative, SpatialDerivative);
     out["SpatialSharpen"] = std::make_pair(OpArgDocSpatialSharpen, SpatialSharpen);
+    out["SubdivideSurfaceMeshes"] = std::make_pair(OpArgDocSubdivideSurfaceMeshes, SubdivideSurfaceMeshes);
     out["SubsegmentContours"] = std::make_pair(OpArgDocSubsegmentContours, SubsegmentContours);
     out["Subsegment_ComputeDose_VanLuijk"] = std::make_pair(OpArgDocSubsegment_ComputeDose_VanLuijk, Subsegment_ComputeDose_VanLuijk);
     out["SubtractImages"] = std::make_pair(OpArgDocSubtractImages, SubtractImages);
@@ -345,6 +393,7 @@ std::map<std::string, op_packet_t> Known_Operations(){
     out["VolumetricCorrelationDetector"] = std::make_pair(OpArgDocVolumetricCorrelationDetector, VolumetricCorrelationDetector);
     out["VolumetricSpatialBlur"] = std::make_pair(OpArgDocVolumetricSpatialBlur, VolumetricSpatialBlur);
     out["VolumetricSpatialDerivative"] = std::make_pair(OpArgDocVolumetricSpatialDerivative, VolumetricSpatialDerivative);
+    out["WarpMeshes"] = std::make_pair(OpArgDocWarpMeshes, WarpMeshes);
     out["WarpPoints"] = std::make_pair(OpArgDocWarpPoints, WarpPoints);
 
 #ifdef DCMA_USE_SDL
@@ -373,54 +422,916 @@ std::map<std::string, op_packet_t> Known_Operations(){
 #ifdef DCMA_USE_CGAL
     out["BCCAExtractRadiomicFeatures"] = std::make_pair(OpArgDocBCCAExtractRadiomicFeatures, BCCAExtractRadiomicFeatures);
     out["ContourBooleanOperations"] = std::make_pair(OpArgDocContourBooleanOperations, ContourBooleanOperations);
-    out["ContourViaThreshold"] = std::make_pair(OpArgDocContourViaThreshold, ContourViaThreshold);
-    out["ConvertImageToMeshes"] = std::make_pair(OpArgDocConvertImageToMeshes, ConvertImageToMeshes);
-    out["ConvertMeshesToContours"] = std::make_pair(OpArgDocConvertMeshesToContours, ConvertMeshesToContours);
     out["DumpROISurfaceMeshes"] = std::make_pair(OpArgDocDumpROISurfaceMeshes, DumpROISurfaceMeshes);
     out["ExtractRadiomicFeatures"] = std::make_pair(OpArgDocExtractRadiomicFeatures, ExtractRadiomicFeatures);
     out["MakeMeshesManifold"] = std::make_pair(OpArgDocMakeMeshesManifold, MakeMeshesManifold);
     out["MinkowskiSum3D"] = std::make_pair(OpArgDocMinkowskiSum3D, MinkowskiSum3D);
-    out["RemeshSurfaceMeshes"] = std::make_pair(OpArgDocRemeshSurfaceMeshes, RemeshSurfaceMeshes);
     out["SeamContours"] = std::make_pair(OpArgDocSeamContours, SeamContours);
-    out["SimplifySurfaceMeshes"] = std::make_pair(OpArgDocSimplifySurfaceMeshes, SimplifySurfaceMeshes);
-    out["SubdivideSurfaceMeshes"] = std::make_pair(OpArgDocSubdivideSurfaceMeshes, SubdivideSurfaceMeshes);
     out["SurfaceBasedRayCastDoseAccumulate"] = std::make_pair(OpArgDocSurfaceBasedRayCastDoseAccumulate, SurfaceBasedRayCastDoseAccumulate);
 #endif // DCMA_USE_CGAL
 
     return out;
 }
 
+// Operations that transform voxels independently, and the stages that implement them. Consecutive pointwise operations
+// are fused into a single traversal of the voxels (see Apply_Pointwise_Stages). A factory may decline to provide a
+// stage for some parameters, in which case the operation is performed normally.
+namespace {
+
+using pointwise_stage_factory_t = std::function<std::optional<pointwise_stage>(Drover &, const OperationArgPkg &)>;
+
+std::map<std::string, pointwise_stage_factory_t> Known_Pointwise_Stages(){
+    std::map<std::string, pointwise_stage_factory_t> out;
+    out["ConvertNaNsToAir"] = PointwiseStageConvertNaNsToAir;
+    out["LogScale"] = PointwiseStageLogScale;
+    out["PreFilterEnormousCTValues"] = PointwiseStagePreFilterEnormousCTValues;
+    out["ThresholdImages"] = PointwiseStageThresholdImages;
+    out["ThresholdOtsu"] = PointwiseStageThresholdOtsu;
+    return out;
+}
+
+// Stages whose parameters are derived from the voxels (e.g., a threshold computed from a histogram) reflect the voxels
+// as they are when the stage is created, before any other fused stage has been applied. They can only begin a run.
+bool Pointwise_Stage_Must_Lead(const std::string &op_name){
+    const std::set<std::string> leading = { "ThresholdOtsu" };
+    return (leading.count(op_name) != 0);
+}
+
+// The mappings are immutable, so they are built once and shared by every (possibly nested or concurrent) dispatch.
+const std::map<std::string, pointwise_stage_factory_t> & Cached_Known_Pointwise_Stages(){
+    static const auto mapping = Known_Pointwise_Stages();
+    return mapping;
+}
+
+} // namespace
+
+
+//------------------------------------------------- Profiling -------------------------------------------------
+// Operations can optionally be instrumented. Each operation invocation (including children invoked by meta-operations
+// like Repeat and ForEachDistinct) is recorded as a 'complete' event in the Chrome trace event format, which can be
+// inspected with chrome://tracing, Perfetto, or any JSON parser. The trace is re-written whenever a top-level
+// invocation of Operation_Dispatcher() completes.
+
+namespace {
+
+struct drover_census {
+    long int image_arrays = 0;
+    long int images = 0;
+    long int contour_collections = 0;
+    long int contours = 0;
+    long int point_clouds = 0;
+    long int meshes = 0;
+    uint64_t resident_bytes = 0; // Approximate.
+};
+
+drover_census Take_Census(const Drover &DICOM_data){
+    drover_census c;
+    c.image_arrays = static_cast<long int>(DICOM_data.image_data.size());
+    for(const auto &ia_ptr : DICOM_data.image_data){
+        if(ia_ptr != nullptr) c.images += static_cast<long int>(ia_ptr->imagecoll.images.size());
+    }
+    if(DICOM_data.contour_data != nullptr){
+        c.contour_collections = static_cast<long int>(DICOM_data.contour_data->ccs.size());
+        for(const auto &cc : DICOM_data.contour_data->ccs){
+            c.contours += static_cast<long int>(cc.contours.size());
+        }
+    }
+    c.point_clouds = static_cast<long int>(DICOM_data.point_data.size());
+    c.meshes = static_cast<long int>(DICOM_data.smesh_data.size());
+    c.resident_bytes = Account_Drover_Memory(DICOM_data).total();
+    return c;
+}
+
+// Peak resident set size of the process in kB, or -1 if unavailable.
+long int Peak_RSS_kB(){
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0){
+    #if defined(__APPLE__)
+        return static_cast<long int>(usage.ru_maxrss / 1024); // Reported in bytes.
+    #else
+        return static_cast<long int>(usage.ru_maxrss); // Reported in kB.
+    #endif
+    }
+#endif
+    return -1;
+}
+
+struct operation_profile_event {
+    std::string name;
+    long int depth = 0;
+    std::chrono::steady_clock::time_point wall_start;
+    std::clock_t cpu_start = 0;
+    long int peak_rss_start_kB = -1;
+    drover_census before;
+
+    double wall_us = 0.0;
+    double cpu_us = 0.0;
+    long int peak_rss_delta_kB = 0;
+    drover_census after;
+    bool succeeded = false;
+};
+
+struct operation_profiler {
+    std::mutex m;
+    std::string filename; // Profiling is disabled when empty.
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::vector<operation_profile_event> events;
+    long int depth = 0;
+
+    operation_profiler(){
+        if(const char *f = std::getenv("DCMA_PROFILE"); f != nullptr) this->filename = f;
+    }
+};
+
+operation_profiler & Profiler(){
+    static operation_profiler p;
+    return p;
+}
+
+std::string Escape_JSON(const std::string &in){
+    std::stringstream ss;
+    for(const auto c : in){
+        switch(c){
+            case '"':  ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20){
+                    ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                }else{
+                    ss << c;
+                }
+                break;
+        }
+    }
+    return ss.str();
+}
+
+void Write_Census(std::ostream &os, const std::string &prefix, const drover_census &c){
+    os << "\"" << prefix << "image_arrays\":" << c.image_arrays << ","
+       << "\"" << prefix << "images\":" << c.images << ","
+       << "\"" << prefix << "contour_collections\":" << c.contour_collections << ","
+       << "\"" << prefix << "contours\":" << c.contours << ","
+       << "\"" << prefix << "point_clouds\":" << c.point_clouds << ","
+       << "\"" << prefix << "meshes\":" << c.meshes << ","
+       << "\"" << prefix << "resident_bytes\":" << c.resident_bytes;
+    return;
+}
+
+// Note: the profiler mutex must be held by the caller.
+void Write_Profile(const operation_profiler &p){
+    std::ofstream os(p.filename, std::ios::out | std::ios::trunc);
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for(const auto &e : p.events){
+        const double ts = std::chrono::duration<double, std::micro>(e.wall_start - p.epoch).count();
+        os << (first ? "\n" : ",\n");
+        first = false;
+        os << "{\"name\":\"" << Escape_JSON(e.name) << "\",\"cat\":\"operation\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+           << "\"ts\":" << ts << ",\"dur\":" << e.wall_us << ",\"args\":{"
+           << "\"depth\":" << e.depth << ","
+           << "\"succeeded\":" << (e.succeeded ? "true" : "false") << ","
+           << "\"cpu_us\":" << e.cpu_us << ","
+           << "\"peak_rss_delta_kB\":" << e.peak_rss_delta_kB << ",";
+        Write_Census(os, "before_", e.before);
+        os << ",";
+        Write_Census(os, "after_", e.after);
+        os << "}}";
+    }
+    os << "\n]}\n";
+    os.flush();
+    if(!os) FUNCWARN("Unable to write operation profile to '" << p.filename << "'");
+    return;
+}
+
+operation_profile_event Begin_Operation_Profile(const std::string &name, const Drover &DICOM_data){
+    auto &p = Profiler();
+    operation_profile_event e;
+    e.name = name;
+    {
+        std::lock_guard<std::mutex> lock(p.m);
+        if(p.filename.empty()) return e;
+        e.depth = p.depth++;
+    }
+    e.before = Take_Census(DICOM_data);
+    e.peak_rss_start_kB = Peak_RSS_kB();
+    e.cpu_start = std::clock();
+    e.wall_start = std::chrono::steady_clock::now();
+    return e;
+}
+
+void End_Operation_Profile(operation_profile_event &e, const Drover &DICOM_data, bool succeeded){
+    const auto wall_stop = std::chrono::steady_clock::now();
+    const auto cpu_stop = std::clock();
+
+    auto &p = Profiler();
+    std::lock_guard<std::mutex> lock(p.m);
+    if(p.filename.empty()) return;
+
+    e.wall_us = std::chrono::duration<double, std::micro>(wall_stop - e.wall_start).count();
+    e.cpu_us = 1.0E6 * static_cast<double>(cpu_stop - e.cpu_start) / static_cast<double>(CLOCKS_PER_SEC);
+    const auto peak_rss_stop_kB = Peak_RSS_kB();
+    if( (0 <= e.peak_rss_start_kB) && (0 <= peak_rss_stop_kB) ){
+        e.peak_rss_delta_kB = peak_rss_stop_kB - e.peak_rss_start_kB;
+    }
+    e.after = Take_Census(DICOM_data);
+    e.succeeded = succeeded;
+
+    FUNCINFO("Operation '" << e.name << "' took " << (e.wall_us / 1.0E6) << " s wall, "
+             << (e.cpu_us / 1.0E6) << " s CPU, and grew peak RSS by " << e.peak_rss_delta_kB << " kB");
+
+    p.events.emplace_back(e);
+    p.depth = (0 < p.depth) ? (p.depth - 1) : 0;
+    if(p.depth == 0) Write_Profile(p);
+    return;
+}
+
+} // namespace
+
+
+//------------------------------------------------ Paged-out images -----------------------------------------------
+// Most operations expect all pixel data to be resident. Only the operations listed here are able to stream through
+// paged-out image arrays (see PageOutImages), or do not access pixel data at all; before any other operation is
+// performed, all arrays are paged back in. This also applies to arrays whose pixel data has yet to be decoded.
+//
+// When a memory budget is active (see Drover_Memory.h), arrays are spilled between top-level operations and only the
+// arrays an operation selects (via its documented '...ImageSelection' arguments) are paged back in. Operations without
+// such arguments still receive every array.
+
+namespace {
+
+bool Supports_Paged_Images(const std::string &op_name){
+    const std::set<std::string> aware = { "DeleteImages",
+                                          "MeldDose",
+                                          "PageOutImages",
+                                          "Repeat",
+                                          "ReportMemoryUsage",
+                                          "ScalePixels",
+                                          "SelectSlicesIntersectingROI",
+                                          "SpatialBlur",
+                                          "ThresholdImages" };
+    return (aware.count(op_name) != 0);
+}
+
+void Page_In_Images(Drover &DICOM_data){
+    for(auto &ia_ptr : DICOM_data.image_data){
+        if( (ia_ptr != nullptr) && (ia_ptr->get_page_store() != nullptr) ){
+            FUNCINFO("Paging in " << ia_ptr->imagecoll.images.size() << " images");
+            ia_ptr->page_in();
+        }
+    }
+    return;
+}
+
+void Page_In_Images(Drover &DICOM_data, const OperationArgPkg &optargs, const std::vector<std::string> &arg_names){
+    if(0 < Get_Drover_Memory_Budget()){
+        std::list<std::shared_ptr<Image_Array>> selected;
+        bool selective = false;
+        try{
+            for(const auto &name : arg_names){
+                if(!boost::algorithm::ends_with(name, "ImageSelection")) continue;
+                const auto selection = optargs.getValueStr(name);
+                if(!selection) continue;
+
+                selective = true;
+                auto IAs_all = All_IAs( DICOM_data );
+                for(auto & iap_it : Whitelist( IAs_all, selection.value() )) selected.push_back(*iap_it);
+            }
+        }catch(const std::exception &){
+            selective = false; // Let the operation report invalid selections.
+        }
+
+        if(selective){
+            for(auto &ia_ptr : selected){
+                if( (ia_ptr != nullptr) && (ia_ptr->get_page_store() != nullptr) ){
+                    FUNCINFO("Paging in " << ia_ptr->imagecoll.images.size() << " images");
+                    ia_ptr->page_in();
+                }
+            }
+            Touch_Image_Arrays(selected);
+            return;
+        }
+    }
+
+    Page_In_Images(DICOM_data);
+    Touch_Image_Arrays(DICOM_data.image_data);
+    return;
+}
+
+// Operations that invoke the dispatcher (e.g., Repeat) may hold references into the Drover, so the budget is only
+// enforced between top-level operations.
+thread_local long int dispatch_depth = 0;
+
+struct dispatch_depth_guard {
+    dispatch_depth_guard(){ ++dispatch_depth; }
+    ~dispatch_depth_guard(){ --dispatch_depth; }
+};
+
+} // namespace
+
+
+//----------------------------------------------- Concurrent dispatch ---------------------------------------------
+// Operations listed here declare which kinds of data they access, how, and (where an argument selects the objects)
+// which argument does the selecting. Runs of consecutive declared operations are scheduled as a dependency graph:
+// operations that access the same kind of data, where at least one alters it, are performed in order, and all others
+// are performed concurrently, so the result is the same as performing them sequentially. Undeclared operations act as
+// barriers.
+//
+// Declarations must be complete, e.g., an operation that inserts metadata into an image array alters the images.
+
+namespace {
+
+std::atomic<bool> concurrent_dispatch{false};
+
+enum class data_kind {
+    contours,
+    images,
+    points,
+    meshes,
+    tplans,
+    lsamps,
+    transforms,
+};
+
+enum class access_mode {
+    read,   // Objects are only inspected.
+    modify, // Selected objects are altered in-place; none are added, removed, or reordered.
+    write,  // Objects may be altered, added, removed, or reordered.
+};
+
+struct data_access {
+    data_kind kind;
+    access_mode mode;
+    std::string selector; // The argument selecting the objects accessed. Empty if any object may be accessed.
+};
+
+std::optional<std::vector<data_access>> Declared_Data_Access(const std::string &op_name){
+    using k = data_kind;
+    using m = access_mode;
+    static const std::map<std::string, std::vector<data_access>> declared = {
+        { "DumpImageMetadataOccurrencesToFile", { { k::images, m::read, "ImageSelection" } } },
+        { "DumpTPlanMetadataOccurrencesToFile", { { k::tplans, m::read, "TPlanSelection" } } },
+        { "ExportFITSImages",                   { { k::images, m::read, "ImageSelection" } } },
+        { "ExportLineSamples",                  { { k::lsamps, m::read, "LineSelection" } } },
+        { "ExportPointClouds",                  { { k::points, m::read, "PointSelection" } } },
+        { "ExportSurfaceMeshes",                { { k::meshes, m::read, "MeshSelection" } } },
+        { "ExportWarps",                        { { k::transforms, m::read, "TransformSelection" } } },
+        { "ExtractImageHistograms",             { { k::images, m::read, "ImageSelection" },
+                                                  { k::contours, m::read, "" },
+                                                  { k::lsamps, m::write, "" } } },
+        { "ThresholdImages",                    { { k::images, m::modify, "ImageSelection" } } } };
+    const auto it = declared.find(op_name);
+    if(it == std::end(declared)) return {};
+    return it->second;
+}
+
+// An access with the selected objects identified by their positions, if known.
+struct resolved_access {
+    data_kind kind;
+    access_mode mode;
+    std::optional<std::set<long int>> positions;
+};
+
+// Only positional specifiers (e.g., "#0" or "last") are resolved. Selecting objects by their metadata would inspect
+// objects that concurrent operations may be modifying.
+template <class T>
+std::optional<std::set<long int>> Selected_Positions(std::list<std::shared_ptr<T>> &objs, const std::string &specifier){
+    if(specifier.find_first_of("@;") != std::string::npos) return {};
+
+    std::list<typename std::list<std::shared_ptr<T>>::iterator> all;
+    for(auto it = std::begin(objs); it != std::end(objs); ++it) all.push_back(it);
+
+    std::set<long int> out;
+    try{
+        for(const auto &it : Whitelist(all, specifier)) out.insert(std::distance(std::begin(objs), it));
+    }catch(const std::exception &){
+        return {}; // Let the operation report invalid selections.
+    }
+    return out;
+}
+
+std::vector<resolved_access> Resolve_Data_Access(Drover &DICOM_data,
+                                                 const std::vector<data_access> &accesses,
+                                                 const OperationArgPkg &optargs){
+    std::vector<resolved_access> out;
+    for(const auto &a : accesses){
+        out.push_back( resolved_access{ a.kind, a.mode, {} } );
+        if( (a.mode == access_mode::write) || a.selector.empty() ) continue;
+
+        const auto specifier = optargs.getValueStr(a.selector);
+        if(!specifier) continue;
+
+        auto &positions = out.back().positions;
+        switch(a.kind){
+            case data_kind::contours:   break; // Contours are selected by ROI name, so are treated as a whole.
+            case data_kind::images:     positions = Selected_Positions(DICOM_data.image_data, specifier.value()); break;
+            case data_kind::points:     positions = Selected_Positions(DICOM_data.point_data, specifier.value()); break;
+            case data_kind::meshes:     positions = Selected_Positions(DICOM_data.smesh_data, specifier.value()); break;
+            case data_kind::tplans:     positions = Selected_Positions(DICOM_data.tplan_data, specifier.value()); break;
+            case data_kind::lsamps:     positions = Selected_Positions(DICOM_data.lsamp_data, specifier.value()); break;
+            case data_kind::transforms: positions = Selected_Positions(DICOM_data.trans_data, specifier.value()); break;
+        }
+    }
+    return out;
+}
+
+bool Data_Access_Conflicts(const std::vector<resolved_access> &A, const std::vector<resolved_access> &B){
+    for(const auto &a : A){
+        for(const auto &b : B){
+            if(a.kind != b.kind) continue;
+            if( (a.mode == access_mode::read) && (b.mode == access_mode::read) ) continue;
+            if( (a.mode == access_mode::write) || (b.mode == access_mode::write) ) return true;
+            if( !a.positions || !b.positions ) return true;
+            for(const auto &p : a.positions.value()){
+                if(b.positions->count(p) != 0) return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Copies the objects an operation was permitted to alter from the Drover it was given into the shared Drover.
+template <class T>
+void Merge_Altered(std::list<std::shared_ptr<T>> &out,
+                   const std::list<std::shared_ptr<T>> &in,
+                   const resolved_access &a){
+    if(a.mode == access_mode::read) return;
+    if( (a.mode == access_mode::write) || !a.positions ){
+        out = in;
+        return;
+    }
+    if(out.size() != in.size()){
+        throw std::logic_error("An operation added or removed objects it declared it would only modify");
+    }
+    auto in_it = std::begin(in);
+    long int i = 0;
+    for(auto &o : out){
+        if(a.positions->count(i) != 0) o = *in_it;
+        ++in_it;
+        ++i;
+    }
+    return;
+}
+
+void Merge_Altered(Drover &out, const Drover &in, const resolved_access &a){
+    switch(a.kind){
+        case data_kind::contours:
+            if(a.mode != access_mode::read) out.contour_data = in.contour_data;
+            break;
+        case data_kind::images:     Merge_Altered(out.image_data, in.image_data, a); break;
+        case data_kind::points:     Merge_Altered(out.point_data, in.point_data, a); break;
+        case data_kind::meshes:     Merge_Altered(out.smesh_data, in.smesh_data, a); break;
+        case data_kind::tplans:     Merge_Altered(out.tplan_data, in.tplan_data, a); break;
+        case data_kind::lsamps:     Merge_Altered(out.lsamp_data, in.lsamp_data, a); break;
+        case data_kind::transforms: Merge_Altered(out.trans_data, in.trans_data, a); break;
+    }
+    return;
+}
+
+} // namespace
+
+
+//-------------------------------------------------- Memoization --------------------------------------------------
+// Results of expensive, deterministic operations can be cached on disk and reused when the same operation is later
+// invoked with the same arguments on the same data (e.g., when a pipeline is re-run on unchanged inputs). Only the
+// returned data is cached, so operations that write files as a side-effect are not memoized; a cached result would
+// silently skip writing them.
+
+namespace {
+
+struct operation_memoizer {
+    std::mutex m;
+    std::string dirname; // Memoization is disabled when empty.
+
+    operation_memoizer(){
+        if(const char *d = std::getenv("DCMA_MEMOIZE_DIR"); d != nullptr) this->dirname = d;
+    }
+};
+
+operation_memoizer & Memoizer(){
+    static operation_memoizer m;
+    return m;
+}
+
+bool Is_Memoizable_Operation(const std::string &op_name){
+    // Note: the ray-cast dose accumulation operations are expensive but are deliberately omitted because they write
+    // FITS maps as a side-effect.
+    const std::set<std::string> memoizable = { "CT_Liver_Perfusion_Pharmaco_1C2I_5Param",
+                                               "CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param",
+                                               "ExtractPointsWarp" };
+    return (memoizable.count(op_name) != 0);
+}
+
+// Returns the file where the result of the operation is (or would be) cached, or an empty path if the operation is not
+// memoized. When the operation is memoized, all images are paged in first, since both the key and the cached result
+// cover every image array and not only those the operation selects.
+std::filesystem::path Memoized_Result_Path(const std::string &op_name,
+                                           const std::vector<std::string> &arg_names,
+                                           const OperationArgPkg &optargs,
+                                           const std::map<std::string,std::string> &InvocationMetadata,
+                                           const std::string &FilenameLex,
+                                           Drover &DICOM_data){
+    std::string dirname;
+    {
+        auto &m = Memoizer();
+        std::lock_guard<std::mutex> lock(m.m);
+        dirname = m.dirname;
+    }
+    if( dirname.empty()
+    ||  !Is_Memoizable_Operation(op_name)
+    ||  !optargs.getChildren().empty() ) return {};
+
+    Page_In_Images(DICOM_data);
+
+    content_hasher h;
+    h.add(std::string("DICOMautomaton memoized operation v1"));
+    h.add(op_name);
+    for(const auto &name : arg_names){
+        h.add(name);
+        h.add(optargs.getValueStr(name).value_or(""));
+    }
+    h.add(InvocationMetadata);
+    {
+        std::ifstream ifs(FilenameLex, std::ios::in | std::ios::binary);
+        h.add(std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()));
+    }
+    h.add(Drover_Content_Hash(DICOM_data));
+
+    std::stringstream ss;
+    ss << op_name << "_" << std::hex << std::setw(16) << std::setfill('0') << h.digest() << ".dcma";
+    return std::filesystem::path(dirname) / ss.str();
+}
+
+bool Load_Memoized_Result(const std::filesystem::path &path, Drover &DICOM_data){
+    std::error_code ec;
+    if(!std::filesystem::exists(path, ec)) return false;
+
+    Drover cached;
+    if(!Common_Boost_Deserialize_Drover_from_Native_Archive(cached, path.string())){
+        FUNCWARN("Ignoring unreadable memoized result '" << path.string() << "'");
+        return false;
+    }
+    DICOM_data = std::move(cached);
+    return true;
+}
+
+// Writes a native archive to a temporary file first so that concurrent or interrupted runs never observe a partial
+// archive.
+bool Write_Archive_Atomically(const std::filesystem::path &path, const Drover &DICOM_data, bool compress){
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto tmp_path = path;
+    tmp_path += ".tmp" + std::to_string(Next_Version_Stamp());
+    bool stored = compress ? Common_Boost_Serialize_Drover_to_Compressed_Native_Archive(DICOM_data, tmp_path.string())
+                           : Common_Boost_Serialize_Drover_to_Native_Archive(DICOM_data, tmp_path.string());
+    if(stored){
+        std::filesystem::rename(tmp_path, path, ec);
+        stored = !ec;
+    }
+    if(!stored) std::filesystem::remove(tmp_path, ec);
+    return stored;
+}
+
+void Store_Memoized_Result(const std::filesystem::path &path, const Drover &DICOM_data){
+    if(!Write_Archive_Atomically(path, DICOM_data, true)){
+        FUNCWARN("Unable to memoize result to '" << path.string() << "'");
+    }
+    return;
+}
+
+} // namespace
+
+
+void Enable_Operation_Memoization(const std::string &dirname){
+    auto &m = Memoizer();
+    std::lock_guard<std::mutex> lock(m.m);
+    m.dirname = dirname;
+    return;
+}
+
+
+void Enable_Concurrent_Dispatch(bool enable){
+    concurrent_dispatch.store(enable);
+    return;
+}
+
+
+//---------------------------------------------------- Deadlines --------------------------------------------------
+// Each operation is performed with a cancellation token derived from the caller's, so cancelling the caller's token
+// (e.g., a job in a server process) stops the operation, and an optional per-operation deadline can be imposed.
+
+namespace {
+
+std::atomic<long int> operation_timeout_ms{0};
+
+cancellation_token Operation_Cancellation_Token(){
+    const auto timeout = operation_timeout_ms.load();
+    if(timeout <= 0) return cancellation_token::current().derive();
+    return cancellation_token::current().derive( cancellation_token::clock_t::now()
+                                               + std::chrono::milliseconds(timeout) );
+}
+
+} // namespace
+
+void Set_Operation_Timeout(double seconds){
+    const auto ms = (0.0 < seconds) ? static_cast<long int>(std::ceil(seconds * 1000.0)) : 0L;
+    operation_timeout_ms.store(ms);
+    return;
+}
+
+
+void Enable_Operation_Profiling(const std::string &filename){
+    auto &p = Profiler();
+    std::lock_guard<std::mutex> lock(p.m);
+    p.filename = filename;
+    return;
+}
+
+
+//----------------------------------------------- Operation registry ----------------------------------------------
+// Operations are resolved through a case-insensitive hash table that is built once per process. Each entry also holds
+// the operation's documented arguments and defaults, which are generated the first time they are needed and then
+// reused. Operations that are never invoked never generate their documentation.
+
+struct resolved_operation {
+    std::string name; // The canonical name.
+    op_packet_t packet;
+    const pointwise_stage_factory_t *pointwise_stage = nullptr;
+    bool pointwise_stage_leads = false;
+    std::optional<std::vector<data_access>> access; // Declared data access, if any.
+    bool paged_images = false;
+
+    struct documentation {
+        OperationDoc doc;
+        std::vector<std::string> arg_names; // Every documented argument.
+        std::vector<std::pair<std::string, std::string>> defaults; // Expected arguments and their default values.
+    };
+    const documentation & docs() const;
+
+    mutable std::once_flag docs_once;
+    mutable documentation docs_cache;
+};
+
+const resolved_operation::documentation & resolved_operation::docs() const {
+    std::call_once(this->docs_once, [this](){
+        this->docs_cache.doc = this->packet.first();
+        for(const auto &a : this->docs_cache.doc.args){
+            this->docs_cache.arg_names.push_back(a.name);
+            if(a.expected) this->docs_cache.defaults.emplace_back(a.name, a.default_val);
+        }
+    });
+    return this->docs_cache;
+}
+
+
+const std::map<std::string, op_packet_t> & Cached_Known_Operations(){
+    static const auto mapping = Known_Operations();
+    return mapping;
+}
+
+namespace {
+
+std::string Operation_Registry_Key(const std::string &name){
+    return boost::algorithm::to_lower_copy(name);
+}
+
+const std::unordered_map<std::string, resolved_operation> & Operation_Registry(){
+    static const auto registry = [](){
+        std::unordered_map<std::string, resolved_operation> out;
+        const auto &stages = Cached_Known_Pointwise_Stages();
+        for(const auto &p : Cached_Known_Operations()){
+            auto &r = out.try_emplace(Operation_Registry_Key(p.first)).first->second;
+            r.name = p.first;
+            r.packet = p.second;
+            const auto stage_it = stages.find(p.first);
+            if(stage_it != std::end(stages)) r.pointwise_stage = &(stage_it->second);
+            r.pointwise_stage_leads = Pointwise_Stage_Must_Lead(p.first);
+            r.access = Declared_Data_Access(p.first);
+            r.paged_images = Supports_Paged_Images(p.first);
+        }
+        return out;
+    }();
+    return registry;
+}
+
+const resolved_operation * Resolve_Operation(const std::string &name){
+    const auto &registry = Operation_Registry();
+    const auto it = registry.find(Operation_Registry_Key(name));
+    return (it == std::end(registry)) ? nullptr : &(it->second);
+}
+
+} // namespace
+
+
+const OperationDoc & Known_Operation_Documentation(const std::string &name){
+    const auto *op = Resolve_Operation(name);
+    if(op == nullptr){
+        throw std::invalid_argument("No operation matched '" + name + "'");
+    }
+    return op->docs().doc;
+}
+
+
+operation_plan Compile_Operations(const std::list<OperationArgPkg> &Operations){
+    operation_plan out;
+    out.steps.reserve(Operations.size());
+    for(const auto &optargs : Operations){
+        out.steps.push_back( operation_plan::step{ Resolve_Operation(optargs.getName()), optargs } );
+
+        //Insert all expected, documented parameters with the default value.
+        auto &step = out.steps.back();
+        if(step.op != nullptr){
+            for(const auto &d : step.op->docs().defaults) step.optargs.insert(d.first, d.second);
+        }
+    }
+    return out;
+}
+
 
 bool Operation_Dispatcher( Drover &DICOM_data,
                            const std::map<std::string,std::string> &InvocationMetadata,
                            const std::string &FilenameLex,
                            const std::list<OperationArgPkg> &Operations ){
+    return Operation_Dispatcher(DICOM_data, InvocationMetadata, FilenameLex, Compile_Operations(Operations));
+}
 
-    auto op_name_mapping = Known_Operations();
+
+bool Operation_Dispatcher( Drover &DICOM_data,
+                           const std::map<std::string,std::string> &InvocationMetadata,
+                           const std::string &FilenameLex,
+                           const operation_plan &plan ){
+
+    const bool is_top_level = (dispatch_depth == 0);
+    const dispatch_depth_guard depth_guard;
 
     try{
-        for(const auto &OptArgs : Operations){
-            auto optargs = OptArgs;
-            bool WasFound = false;
-            for(const auto &op_func : op_name_mapping){
-                if(boost::iequals(op_func.first,optargs.getName())){
-                    WasFound = true;
-
-                    //Attempt to insert all expected, documented parameters with the default value.
-                    auto OpDocs = op_func.second.first();
-                    for(const auto &r : OpDocs.args){
-                        if(r.expected) optargs.insert( r.name, r.default_val );
+        for(auto op_it = std::begin(plan.steps); op_it != std::end(plan.steps); ){
+            throw_if_cancelled();
+            if(is_top_level) Enforce_Drover_Memory_Budget(DICOM_data);
+
+            //Runs of consecutive operations that declare their data access are scheduled by their dependencies. Each
+            // round concurrently performs the remaining operations that do not conflict with an earlier remaining
+            // operation, each on a shallow copy of the Drover. Whatever each operation was permitted to alter is then
+            // merged back in order.
+            if(concurrent_dispatch.load()){
+                auto end_it = op_it;
+                while( (end_it != std::end(plan.steps))
+                &&     (end_it->op != nullptr)
+                &&     end_it->op->access ){
+                    // Fusing consecutive pointwise operations takes precedence.
+                    const auto after_it = std::next(end_it);
+                    if( (end_it->op->pointwise_stage != nullptr)
+                    &&  (after_it != std::end(plan.steps))
+                    &&  (after_it->op != nullptr)
+                    &&  (after_it->op->pointwise_stage != nullptr) ) break;
+                    end_it = after_it;
+                }
+
+                std::vector<decltype(op_it)> remaining;
+                for(auto it = op_it; it != end_it; ++it) remaining.push_back(it);
+
+                bool scheduled = false;
+                while(!remaining.empty()){
+                    // Selections are resolved anew each round, since earlier rounds may have altered the data.
+                    std::vector<std::vector<resolved_access>> accesses;
+                    for(const auto &it : remaining){
+                        accesses.push_back( Resolve_Data_Access(DICOM_data, it->op->access.value(), it->optargs) );
+                    }
+                    std::vector<size_t> round;
+                    for(size_t i = 0; i < remaining.size(); ++i){
+                        bool independent = true;
+                        for(size_t j = 0; (j < i) && independent; ++j){
+                            independent = !Data_Access_Conflicts(accesses[j], accesses[i]);
+                        }
+                        if(independent) round.push_back(i);
+                    }
+
+                    // Without any concurrency to gain, the operation is performed as usual (e.g., so it is memoized).
+                    if(!scheduled && (round.size() < 2)) break;
+                    scheduled = true;
+
+                    for(const auto &i : round){
+                        const auto &it = remaining[i];
+                        if(!it->op->paged_images) Page_In_Images(DICOM_data, it->optargs, it->op->docs().arg_names);
+                    }
+
+                    std::vector<Drover> results;
+                    results.reserve(round.size());
+                    for(size_t r = 0; r < round.size(); ++r) results.emplace_back(DICOM_data);
+
+                    FUNCINFO("Performing " << round.size() << " independent operations concurrently..");
+                    task_group tg;
+                    for(size_t r = 0; r < round.size(); ++r){
+                        const auto it = remaining[round[r]];
+                        Drover *result = &(results[r]);
+                        tg.run([&, it, result]() -> void {
+                            const auto &op = *(it->op);
+                            const dispatch_depth_guard task_depth_guard;
+                            FUNCINFO("Performing operation '" << op.name << "' now..");
+                            const cancellation_token::scope op_scope{ Operation_Cancellation_Token() };
+                            DCMA_TRACE_ZONE("operation", Intern_Trace_Name(op.name));
+                            auto profile = Begin_Operation_Profile(op.name, *result);
+                            try{
+                                *result = op.packet.second(std::move(*result), it->optargs,
+                                                           InvocationMetadata, FilenameLex);
+                            }catch(const std::exception &){
+                                End_Operation_Profile(profile, *result, false);
+                                throw;
+                            }
+                            End_Operation_Profile(profile, *result, true);
+                        });
+                    }
+                    tg.wait();
+
+                    for(size_t r = 0; r < round.size(); ++r){
+                        for(const auto &a : accesses[round[r]]) Merge_Altered(DICOM_data, results[r], a);
                     }
+                    for(auto r_it = std::rbegin(round); r_it != std::rend(round); ++r_it){
+                        remaining.erase( std::next(std::begin(remaining), static_cast<long int>(*r_it)) );
+                    }
+                }
+                if(scheduled){
+                    op_it = end_it;
+                    continue;
+                }
+            }
+
+            //Consecutive pointwise operations are fused so the voxels are only traversed once.
+            std::vector<pointwise_stage> stages;
+            auto next_it = op_it;
+            for( ; next_it != std::end(plan.steps); ++next_it){
+                if( (next_it->op == nullptr)
+                ||  (next_it->op->pointwise_stage == nullptr) ) break;
+                if(next_it->op->pointwise_stage_leads){
+                    // Leading stages inspect the voxels when created, so they are only created if a stage may follow.
+                    const auto after_it = std::next(next_it);
+                    if( !stages.empty()
+                    ||  (after_it == std::end(plan.steps))
+                    ||  (after_it->op == nullptr)
+                    ||  (after_it->op->pointwise_stage == nullptr) ) break;
+                }
+
+                auto stage = (*(next_it->op->pointwise_stage))(DICOM_data, next_it->optargs);
+                if(!stage) break;
+                stages.emplace_back(std::move(stage.value()));
+            }
+            if(2 <= stages.size()){
+                std::string fused_name;
+                for(const auto &stage : stages) fused_name += (fused_name.empty() ? "" : "+") + stage.name;
+
+                FUNCINFO("Performing fused operations '" << fused_name << "' now..");
+                auto profile = Begin_Operation_Profile(fused_name, DICOM_data);
+                try{
+                    DCMA_TRACE_ZONE("operation", Intern_Trace_Name(fused_name));
+                    const cancellation_token::scope op_scope{ Operation_Cancellation_Token() };
+                    Apply_Pointwise_Stages(stages);
+                }catch(const std::exception &){
+                    End_Operation_Profile(profile, DICOM_data, false);
+                    throw;
+                }
+                End_Operation_Profile(profile, DICOM_data, true);
+                op_it = next_it;
+                continue;
+            }
+
+            if(op_it->op == nullptr){
+                throw std::invalid_argument("No operation matched '" + op_it->optargs.getName() + "'");
+            }
+            const auto &op = *(op_it->op);
+            const auto &optargs = op_it->optargs;
+
+            if(!op.paged_images) Page_In_Images(DICOM_data, optargs, op.docs().arg_names);
 
-                    FUNCINFO("Performing operation '" << op_func.first << "' now..");
-                    DICOM_data = op_func.second.second(DICOM_data,
-                                                       optargs,
-                                                       InvocationMetadata,
-                                                       FilenameLex);
+            FUNCINFO("Performing operation '" << op.name << "' now..");
+            auto profile = Begin_Operation_Profile(op.name, DICOM_data);
+            try{
+                DCMA_TRACE_ZONE("operation", Intern_Trace_Name(op.name));
+                const cancellation_token::scope op_scope{ Operation_Cancellation_Token() };
+                const auto memo_path = Memoized_Result_Path(op.name, op.docs().arg_names, optargs,
+                                                            InvocationMetadata, FilenameLex, DICOM_data);
+                if( !memo_path.empty()
+                &&  Load_Memoized_Result(memo_path, DICOM_data) ){
+                    FUNCINFO("Restored memoized result from '" << memo_path.string() << "'");
+                }else{
+                    // The Drover is moved through the operation so its data remain uniquely owned where possible,
+                    // letting copy-on-write modifications (see Detach_Shared) proceed in-place.
+                    DICOM_data = op.packet.second(std::move(DICOM_data),
+                                                  optargs,
+                                                  InvocationMetadata,
+                                                  FilenameLex);
+                    if(!memo_path.empty()) Store_Memoized_Result(memo_path, DICOM_data);
                 }
+            }catch(const std::exception &){
+                End_Operation_Profile(profile, DICOM_data, false);
+                throw;
             }
-            if(!WasFound) throw std::invalid_argument("No operation matched '" + optargs.getName() + "'");
+            End_Operation_Profile(profile, DICOM_data, true);
+            ++op_it;
         }
+        if(is_top_level) Enforce_Drover_Memory_Budget(DICOM_data);
     }catch(const std::exception &e){
         FUNCWARN("Analysis failed: '" << e.what() << "'. Aborting remaining analyses");
         return false;
@@ -428,3 +1339,107 @@ bool Operation_Dispatcher( Drover &DICOM_data,
 
     return true;
 }
+
+
+//------------------------------------------------- Checkpointing -------------------------------------------------
+// The Drover is saved after every few (top-level) operations. Checkpoints are named after a fingerprint of the
+// operations, their documented arguments, the lexicon, and the input data, so a checkpoint is only ever resumed by an
+// invocation that would reproduce it. Only the latest checkpoint is retained, and it is removed once all operations
+// have completed.
+
+namespace {
+
+void Add_Operations_Fingerprint(content_hasher &h, const std::list<OperationArgPkg> &Operations){
+    h.add(static_cast<uint64_t>(Operations.size()));
+    for(const auto &optargs : Operations){
+        h.add(optargs.getName());
+        if(const auto *op = Resolve_Operation(optargs.getName()); op != nullptr){
+            for(const auto &name : op->docs().arg_names){
+                h.add(name);
+                h.add(optargs.getValueStr(name).value_or(""));
+            }
+        }
+        Add_Operations_Fingerprint(h, optargs.getChildren());
+    }
+    return;
+}
+
+std::filesystem::path Checkpoint_Path(const dispatch_checkpoint_opts &opts, uint64_t fingerprint, size_t N_completed){
+    std::stringstream ss;
+    ss << "checkpoint_" << std::hex << std::setw(16) << std::setfill('0') << fingerprint
+       << "_" << std::dec << std::setw(6) << N_completed << ".dcma";
+    return std::filesystem::path(opts.dirname) / ss.str();
+}
+
+} // namespace
+
+
+bool Operation_Dispatcher( Drover &DICOM_data,
+                           const std::map<std::string,std::string> &InvocationMetadata,
+                           const std::string &FilenameLex,
+                           const std::list<OperationArgPkg> &Operations,
+                           const dispatch_checkpoint_opts &opts ){
+    if(opts.dirname.empty()){
+        return Operation_Dispatcher(DICOM_data, InvocationMetadata, FilenameLex, Operations);
+    }
+    if(opts.interval <= 0){
+        FUNCWARN("Checkpoint interval must be positive");
+        return false;
+    }
+
+    std::vector<OperationArgPkg> ops(std::begin(Operations), std::end(Operations));
+    const auto N_ops = ops.size();
+
+    Page_In_Images(DICOM_data);
+    content_hasher h;
+    h.add(std::string("DICOMautomaton checkpoint v1"));
+    Add_Operations_Fingerprint(h, Operations);
+    h.add(InvocationMetadata);
+    {
+        std::ifstream ifs(FilenameLex, std::ios::in | std::ios::binary);
+        h.add(std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()));
+    }
+    h.add(Drover_Content_Hash(DICOM_data));
+    const auto fingerprint = h.digest();
+
+    // Resume from the latest valid checkpoint, if any.
+    size_t N_completed = 0;
+    std::error_code ec;
+    for(size_t k = N_ops; 0 < k; --k){
+        const auto path = Checkpoint_Path(opts, fingerprint, k);
+        if(!std::filesystem::exists(path, ec)) continue;
+
+        Drover resumed;
+        if(!Common_Boost_Deserialize_Drover_from_Native_Archive(resumed, path.string())){
+            FUNCWARN("Ignoring unreadable checkpoint '" << path.string() << "'");
+            continue;
+        }
+        DICOM_data = std::move(resumed);
+        N_completed = k;
+        FUNCINFO("Resuming from checkpoint '" << path.string() << "' after " << k << " of " << N_ops << " operations");
+        break;
+    }
+
+    while(N_completed < N_ops){
+        const auto N_next = std::min(N_ops, N_completed + static_cast<size_t>(opts.interval));
+        const std::list<OperationArgPkg> segment( std::next(std::begin(ops), N_completed),
+                                                  std::next(std::begin(ops), N_next) );
+        if(!Operation_Dispatcher(DICOM_data, InvocationMetadata, FilenameLex, segment)){
+            return false;
+        }
+
+        const auto prev_path = Checkpoint_Path(opts, fingerprint, N_completed);
+        N_completed = N_next;
+        if(N_completed < N_ops){
+            Page_In_Images(DICOM_data);
+            const auto path = Checkpoint_Path(opts, fingerprint, N_completed);
+            if(Write_Archive_Atomically(path, DICOM_data, false)){
+                FUNCINFO("Wrote checkpoint '" << path.string() << "'");
+            }else{
+                FUNCWARN("Unable to write checkpoint '" << path.string() << "'");
+            }
+        }
+        std::filesystem::remove(prev_path, ec);
+    }
+    return true;
+}
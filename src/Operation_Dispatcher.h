@@ -7,6 +7,7 @@
 #include <list>
 #include <functional>
 #include <utility>
+#include <vector>
 
 #include "Structs.h"
 
@@ -19,8 +20,73 @@ typedef std::pair<op_doc_func_t,op_func_t> op_packet_t;
 
 std::map<std::string, op_packet_t> Known_Operations();
 
+// The same mapping, built once per process. Documentation is not generated.
+const std::map<std::string, op_packet_t> & Cached_Known_Operations();
+
+// The documentation of a known operation (case-insensitive), generated on first request and cached thereafter.
+// Throws if the operation is unknown.
+const OperationDoc & Known_Operation_Documentation(const std::string &name);
+
+// Performs the operations in order. The Drover is moved into and out of each operation, so if an operation fails the
+// Drover is left in a valid but unspecified state. Callers that need to recover from failures should retain a (shallow)
+// copy beforehand.
 bool Operation_Dispatcher( Drover &DICOM_data,
                            const std::map<std::string,std::string> &InvocationMetadata,
                            const std::string &FilenameLex,
                            const std::list<OperationArgPkg> &Operations);
 
+// Operations resolved against the known operations, with the documented defaults inserted into each operation's
+// arguments. Resolving is performed once, so a plan can be dispatched repeatedly (e.g., by Repeat and ForEachDistinct)
+// without the lookups and documentation being regenerated. Plans are immutable and can be dispatched concurrently.
+struct resolved_operation; // Opaque.
+struct operation_plan {
+    struct step {
+        const resolved_operation *op; // nullptr if the operation is unknown, which is reported when dispatched.
+        OperationArgPkg optargs;
+    };
+    std::vector<step> steps;
+};
+
+operation_plan Compile_Operations(const std::list<OperationArgPkg> &Operations);
+
+bool Operation_Dispatcher( Drover &DICOM_data,
+                           const std::map<std::string,std::string> &InvocationMetadata,
+                           const std::string &FilenameLex,
+                           const operation_plan &plan);
+
+// Checkpointing options for long-running pipelines.
+struct dispatch_checkpoint_opts {
+    std::string dirname; // Checkpointing is disabled when empty.
+    long int interval = 1; // The number of top-level operations performed between checkpoints.
+};
+
+// Same as above, but the Drover is saved (as a native archive) after every few operations. If a checkpoint written by
+// an earlier, interrupted invocation with the same operations and input data is found, the operations it covers are
+// skipped. Consecutive operations are only fused or overlapped within the same interval.
+bool Operation_Dispatcher( Drover &DICOM_data,
+                           const std::map<std::string,std::string> &InvocationMetadata,
+                           const std::string &FilenameLex,
+                           const std::list<OperationArgPkg> &Operations,
+                           const dispatch_checkpoint_opts &opts );
+
+// Enables per-operation instrumentation (wall time, CPU time, peak RSS growth, and Drover contents before and after
+// each operation). Results are written to the given file in the Chrome trace event format. Profiling can also be
+// enabled by setting the DCMA_PROFILE environment variable to a filename. An empty filename disables profiling.
+void Enable_Operation_Profiling(const std::string &filename);
+
+// Enables on-disk caching of the results of expensive, deterministic operations (e.g., point cloud warps and kinetic
+// model fits). Results are keyed on the operation, its arguments, the lexicon, and the content of all input data, and
+// are reused when all match. Operations that write files as a side-effect are not memoized. Memoization can also be
+// enabled by setting the DCMA_MEMOIZE_DIR environment variable to a directory. An empty directory name disables
+// memoization.
+void Enable_Operation_Memoization(const std::string &dirname);
+
+// Enables concurrent execution of consecutive operations that access disjoint data (e.g., exporting meshes while
+// extracting histograms from images). Operations that declare which kinds of data they read and alter are scheduled
+// by their dependencies, so results are unchanged; all other operations are performed in order. Disabled by default.
+void Enable_Concurrent_Dispatch(bool enable);
+
+// Imposes a deadline on each operation, after which the operation is cancelled and the analysis fails. Operations check
+// for cancellation cooperatively (see cancellation_token), so some operations may overrun. Operations are also cancelled
+// when the token associated with the calling thread is. A non-positive timeout disables the deadline.
+void Set_Operation_Timeout(double seconds);
@@ -17,6 +17,8 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Image_Profiles.h"
+#include "../Thread_Pool.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "AccumulateRowsColumns.h"
 #include "YgorImages.h"
@@ -63,21 +65,22 @@ Drover AccumulateRowsColumns(Drover DICOM_data,
         std::vector<YgorMathPlottingGnuplot::Shuttle<samples_1D<double>>> row_sums;
         std::vector<YgorMathPlottingGnuplot::Shuttle<samples_1D<double>>> col_sums;
         {
-            decltype((*iap_it)->imagecoll.images) shtl;
-            for(const auto & animg : (*iap_it)->imagecoll.images){
-                std::vector<double> row_sum(animg.rows, 0.0);
-                std::vector<double> col_sum(animg.columns, 0.0);
+            std::vector<const planar_image<float,double> *> imgs;
+            for(const auto & animg : (*iap_it)->imagecoll.images) imgs.push_back(&animg);
+            const auto N_imgs = static_cast<long int>(imgs.size());
+
+            // Images are processed independently, and the results are gathered in the original order.
+            std::vector<samples_1D<double>> row_profiles(N_imgs);
+            std::vector<samples_1D<double>> col_profiles(N_imgs);
+            std::vector<std::optional<planar_image<float,double>>> row_profs(N_imgs);
+            std::vector<std::optional<planar_image<float,double>>> col_profs(N_imgs);
+            parallel_for(0, N_imgs, [&](long int n){
+                const auto &animg = *(imgs[n]);
 
                 //Sum pixel values row- and column-wise.
-                for(auto row = 0; row < animg.rows; ++row){
-                    for(auto col = 0; col < animg.columns; ++col){
-                        for(auto chan = 0; chan < animg.channels; ++chan){
-                            const auto val = animg.value(row, col, chan);
-                            row_sum[row] += val;
-                            col_sum[col] += val;
-                        }//Loop over channels.
-                    } //Loop over cols
-                } //Loop over rows
+                std::vector<double> row_sum;
+                std::vector<double> col_sum;
+                Accumulate_Rows_Columns(animg, row_sum, col_sum);
 
                 //Record the data in the form of comparative plots.
                 {
@@ -94,30 +97,22 @@ Drover AccumulateRowsColumns(Drover DICOM_data,
                     }
                     const auto row_area = row_profile.Integrate_Over_Kernel_unit()[0];
                     const auto col_area = col_profile.Integrate_Over_Kernel_unit()[0];
-                    row_profile = row_profile.Multiply_With(1.0/row_area);
-                    col_profile = col_profile.Multiply_With(1.0/col_area);
-
-                    row_sums.emplace_back(row_profile, "Row Profile");
-                    col_sums.emplace_back(col_profile, "Column Profile");
+                    row_profiles[n] = row_profile.Multiply_With(1.0/row_area);
+                    col_profiles[n] = col_profile.Multiply_With(1.0/col_area);
                 }
 
                 // Produce some images for the user to inspect.
                 planar_image<float,double> row_prof(animg);
                 planar_image<float,double> col_prof(animg);
+                Fill_Rows(row_prof, row_sum);
+                Fill_Columns(col_prof, col_sum);
+
                 Stats::Running_MinMax<float> minmax_row;
                 Stats::Running_MinMax<float> minmax_col;
-
-                for(auto row = 0; row < animg.rows; ++row){
-                    for(auto col = 0; col < animg.columns; ++col){
-                        for(auto chan = 0; chan < animg.channels; ++chan){
-                            row_prof.reference(row, col, chan) = row_sum[row];
-                            col_prof.reference(row, col, chan) = col_sum[col];
-
-                            minmax_row.Digest( row_sum[row] );
-                            minmax_col.Digest( col_sum[col] );
-                        }//Loop over channels.
-                    } //Loop over cols
-                } //Loop over rows
+                if(0 < animg.channels){
+                    if(0 < animg.columns) for(const auto &v : row_sum) minmax_row.Digest( v );
+                    if(0 < animg.rows) for(const auto &v : col_sum) minmax_col.Digest( v );
+                }
 
                 const std::string row_desc = "Row-wise pixel accumulation";
                 const std::string col_desc = "Column-wise pixel accumulation";
@@ -126,8 +121,16 @@ Drover AccumulateRowsColumns(Drover DICOM_data,
                 UpdateImageWindowCentreWidth( std::ref(row_prof), minmax_row );
                 UpdateImageWindowCentreWidth( std::ref(col_prof), minmax_col );
 
-                shtl.emplace_back( row_prof );
-                shtl.emplace_back( col_prof );
+                row_profs[n] = std::move(row_prof);
+                col_profs[n] = std::move(col_prof);
+            }, 1);
+
+            decltype((*iap_it)->imagecoll.images) shtl;
+            for(long int n = 0; n < N_imgs; ++n){
+                row_sums.emplace_back(row_profiles[n], "Row Profile");
+                col_sums.emplace_back(col_profiles[n], "Column Profile");
+                shtl.emplace_back( std::move(row_profs[n].value()) );
+                shtl.emplace_back( std::move(col_profs[n].value()) );
             }
 
             (*iap_it)->imagecoll.images.splice( (*iap_it)->imagecoll.images.end(),
@@ -24,8 +24,10 @@
 #include <vector>
 
 #include "../Insert_Contours.h"
+#include "../Image_Profiles.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "AnalyzeLightRadFieldCoincidence.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
@@ -221,20 +223,28 @@ Drover AnalyzeLightRadFieldCoincidence(Drover DICOM_data,
             row_cm << "Row compatibility matrix:" << std::endl;
             col_cm << "Column compatibility matrix:" << std::endl;
 
-            for(const auto & animg : (*iap_it)->imagecoll.images){
+            // Frames are analyzed independently in batches spread over the thread pool. The candidate edges of each
+            // frame are gathered afterward in the original order, so the results do not depend on scheduling.
+            std::vector<const planar_image<float,double> *> imgs;
+            for(const auto & animg : (*iap_it)->imagecoll.images) imgs.push_back(&animg);
+            const auto N_imgs = static_cast<long int>(imgs.size());
+
+            struct frame_edges {
+                std::vector<std::optional<samples_1D<double>>> row_fe;
+                std::vector<std::optional<samples_1D<double>>> col_fe;
+            };
+            std::vector<frame_edges> frames(N_imgs);
+
+            parallel_for(0, N_imgs, [&](long int n){
+                const auto &animg = *(imgs[n]);
+                auto &frame = frames[n];
+                frame.row_fe.resize(AFEs.size());
+                frame.col_fe.resize(AFEs.size());
 
                 //Sum pixel values row- and column-wise.
-                std::vector<double> row_sum(animg.rows, 0.0);
-                std::vector<double> col_sum(animg.columns, 0.0);
-                for(auto row = 0; row < animg.rows; ++row){
-                    for(auto col = 0; col < animg.columns; ++col){
-                        for(auto chan = 0; chan < animg.channels; ++chan){
-                            const auto val = animg.value(row, col, chan);
-                            row_sum[row] += val;
-                            col_sum[col] += val;
-                        }//Loop over channels.
-                    } //Loop over cols
-                } //Loop over rows
+                std::vector<double> row_sum;
+                std::vector<double> col_sum;
+                Accumulate_Rows_Columns(animg, row_sum, col_sum);
 
                 //Record the data in the form of comparative plots.
                 {
@@ -339,19 +349,25 @@ Drover AnalyzeLightRadFieldCoincidence(Drover DICOM_data,
                         //There should only be 1-2 peaks within the anticipated field edge zone.
                         // If there are more, they're probably just noise. But better to filter them out later.
                         if(row_peaks.size() >= 1){
-                            row_fe_candidates[i].emplace_back(row_subset);
+                            frame.row_fe[i] = std::move(row_subset);
                         }
                         if(col_peaks.size() >= 1){
-                            col_fe_candidates[i].emplace_back(col_subset);
+                            frame.col_fe[i] = std::move(col_subset);
                         }
+                    }
+                }
+            }, 1);
 
-                        row_cm << !!(!row_peaks.empty()) << " ";
-                        col_cm << !!(!col_peaks.empty()) << " ";
+            for(auto &frame : frames){
+                for(size_t i = 0; i < AFEs.size(); ++i){
+                    if(frame.row_fe[i]) row_fe_candidates[i].emplace_back(std::move(frame.row_fe[i].value()));
+                    if(frame.col_fe[i]) col_fe_candidates[i].emplace_back(std::move(frame.col_fe[i].value()));
 
-                    }
-                    row_cm << std::endl;
-                    col_cm << std::endl;
+                    row_cm << !!(frame.row_fe[i]) << " ";
+                    col_cm << !!(frame.col_fe[i]) << " ";
                 }
+                row_cm << std::endl;
+                col_cm << std::endl;
             }
         }
 
@@ -21,8 +21,10 @@
 #include <utility>
 
 #include "../Insert_Contours.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "../Write_File.h"
 
 #include "YgorImages.h"
@@ -32,8 +34,6 @@
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorFilesDirs.h"
 
-#include "Explicator.h"
-
 #include "AnalyzePicketFence.h"
 
 OperationDoc OpArgDocAnalyzePicketFence(){
@@ -55,6 +55,11 @@ OperationDoc OpArgDocAnalyzePicketFence(){
         " magnification factor of SAD/SID is applied to all distances."
     );
 
+    out.notes.emplace_back(
+        "Multiple image arrays can be selected to analyze a batch of images. Images are analyzed concurrently, but"
+        " results are written, plotted, and contoured in the order the image arrays were selected."
+    );
+
     out.args.emplace_back();
     out.args.back() = IAWhitelistOpArgDoc();
     out.args.back().name = "ImageSelection";
@@ -178,12 +183,12 @@ Drover AnalyzePicketFence(Drover DICOM_data,
                           /*InvocationMetadata*/,
                           const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
 
-    auto MLCModel = OptArgs.getValueStr("MLCModel").value();
+    const auto MLCModelStr = OptArgs.getValueStr("MLCModel").value();
 
     const auto MLCROILabel = OptArgs.getValueStr("MLCROILabel").value();
     const auto JunctionROILabel = OptArgs.getValueStr("JunctionROILabel").value();
@@ -220,7 +225,28 @@ Drover AnalyzePicketFence(Drover DICOM_data,
         throw std::invalid_argument("No image arrays selected. Cannot continue.");
     }
 
-    for(auto & iap_it : IAs){
+    // Findings that are reported once every image array has been analyzed.
+    struct PF_Report {
+        std::string leaf_gaps_header;
+        std::string leaf_gaps_body;
+        std::string summary_header;
+        std::string summary_body;
+
+        std::vector< YgorMathPlottingGnuplot::Shuttle<samples_1D<double>> > leaf_plot_shtl;
+        std::vector< YgorMathPlottingGnuplot::Shuttle<samples_1D<double>> > junction_plot_shtl;
+
+        std::list<contour_collection<double>> contours;
+    };
+
+    // Image arrays are analyzed concurrently. Files, plots, and contours are only produced afterward, in the order the
+    // image arrays were selected, so batches of images give the same results as analyzing them one at a time.
+    const std::vector<decltype(IAs)::value_type> IA_vec(IAs.begin(), IAs.end());
+    std::vector<PF_Report> reports(IA_vec.size());
+    parallel_for(0, static_cast<long int>(IA_vec.size()), [&](long int n){
+        const auto &iap_it = IA_vec[n];
+        auto &report = reports[n];
+        auto MLCModel = MLCModelStr;
+
         if((*iap_it)->imagecoll.images.empty()) throw std::invalid_argument("Unable to find an image to analyze.");
 
         planar_image<float, double> *animg = &( (*iap_it)->imagecoll.images.front() );
@@ -515,18 +541,23 @@ Drover AnalyzePicketFence(Drover DICOM_data,
                     const long int chan = 0;
                     const auto orig_pxl_dz = animg->pxl_dz;
                     animg->pxl_dz = 1.0; // Ensure there is some image thickness.
-                    const std::vector<double> sample_dists { -2.0, -1.5, -0.5, 0.0, 0.5, 1.0, 1.5, 2.0 };
+                    const std::array<double, 8> sample_dists { -2.0, -1.5, -0.5, 0.0, 0.5, 1.0, 1.5, 2.0 };
+                    std::array<vec3<double>, 8> sample_offsets;
+                    for(size_t k = 0; k < sample_dists.size(); ++k){
+                        sample_offsets[k] = PFC.junction_axis * sample_dists[k] * sample_spacing;
+                    }
+
+                    // Pixels in the vicinity of the leaf line are looked up directly, skipping those outside the image.
+                    std::vector<double> samples;
+                    samples.reserve(sample_offsets.size());
                     for(const auto &R : R_list){
                         const auto rel_R = (R - corner_R);
                         const auto l = rel_R.Dot(PFC.leaf_axis);
 
-                        std::vector<double> samples; // Sample vicinity of the leaf line.
-                        for(const auto &offset : sample_dists){
-                            const auto offset_R = R + (PFC.junction_axis * offset * sample_spacing);
-                            try{
-                                const auto val = animg->value(offset_R, chan);
-                                samples.push_back(val);
-                            }catch(const std::exception &){}
+                        samples.clear();
+                        for(const auto &offset_R : sample_offsets){
+                            const auto indx = animg->index(R + offset_R, chan);
+                            if(0 <= indx) samples.push_back(animg->data[indx]);
                         }
                         if(!samples.empty()){
                             const auto avgd = Stats::Mean(samples);
@@ -1010,15 +1041,7 @@ Drover AnalyzePicketFence(Drover DICOM_data,
                 }
 
                 //Report findings about this leaf-pair.
-                FUNCINFO("Attempting to claim a mutex");
-                try{
-                    auto gen_filename = [&]() -> std::string {
-                        if(LeafGapsFileName.empty()){
-                            LeafGapsFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_evaluatepf_", 6, ".csv");
-                        }
-                        return LeafGapsFileName;
-                    };
-
+                {
                     std::stringstream header;
                     header << "PatientID,"
                            << "StationName,"
@@ -1051,13 +1074,8 @@ Drover AnalyzePicketFence(Drover DICOM_data,
                          << UserComment.value_or("")
                          << std::endl;
 
-                    Append_File( gen_filename,
-                                 "dicomautomaton_operation_analyzepicketfence_mutex",
-                                 header.str(),
-                                 body.str() );
-
-                }catch(const std::exception &e){
-                    FUNCERR("Unable to write to output file: '" << e.what() << "'");
+                    report.leaf_gaps_header = header.str();
+                    report.leaf_gaps_body += body.str();
                 }
 
 
@@ -1078,15 +1096,7 @@ Drover AnalyzePicketFence(Drover DICOM_data,
 
 
         //Report a summary.
-        FUNCINFO("Attempting to claim a mutex");
-        try{
-            auto gen_filename = [&]() -> std::string {
-                if(ResultsSummaryFileName.empty()){
-                    ResultsSummaryFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_pfsummary_", 6, ".csv");
-                }
-                return ResultsSummaryFileName;
-            };
-
+        {
             std::stringstream header;
             header << "Quantity,"
                    << "Result"
@@ -1118,13 +1128,8 @@ Drover AnalyzePicketFence(Drover DICOM_data,
                  << PFC.CollimatorCompensation
                  << std::endl;
 
-            Append_File( gen_filename,
-                         "dicomautomaton_operation_analyzepicketfence_mutex",
-                         header.str(),
-                         body.str() );
-
-        }catch(const std::exception &e){
-            FUNCERR("Unable to write to output file: '" << e.what() << "'");
+            report.summary_header = header.str();
+            report.summary_body = body.str();
         }
 
         //---------------------------------------------------------------------------
@@ -1207,26 +1212,69 @@ Drover AnalyzePicketFence(Drover DICOM_data,
         }
 
 
+        report.leaf_plot_shtl = std::move(PFC.leaf_plot_shtl);
+        report.junction_plot_shtl = std::move(PFC.junction_plot_shtl);
+
+        report.contours.splice( report.contours.end(), PFC.peak_contours );
+        report.contours.splice( report.contours.end(), PFC.leaf_pair_contours );
+        report.contours.splice( report.contours.end(), PFC.junction_contours );
+    }, 1);
+
+    for(auto &report : reports){
+        FUNCINFO("Attempting to claim a mutex");
+        try{
+            auto gen_filename = [&]() -> std::string {
+                if(LeafGapsFileName.empty()){
+                    LeafGapsFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_evaluatepf_", 6, ".csv");
+                }
+                return LeafGapsFileName;
+            };
+            if(!report.leaf_gaps_body.empty()){
+                Append_File( gen_filename,
+                             "dicomautomaton_operation_analyzepicketfence_mutex",
+                             report.leaf_gaps_header,
+                             report.leaf_gaps_body );
+            }
+
+        }catch(const std::exception &e){
+            FUNCERR("Unable to write to output file: '" << e.what() << "'");
+        }
+
+        FUNCINFO("Attempting to claim a mutex");
+        try{
+            auto gen_filename = [&]() -> std::string {
+                if(ResultsSummaryFileName.empty()){
+                    ResultsSummaryFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_pfsummary_", 6, ".csv");
+                }
+                return ResultsSummaryFileName;
+            };
+            Append_File( gen_filename,
+                         "dicomautomaton_operation_analyzepicketfence_mutex",
+                         report.summary_header,
+                         report.summary_body );
+
+        }catch(const std::exception &e){
+            FUNCERR("Unable to write to output file: '" << e.what() << "'");
+        }
+
         //---------------------------------------------------------------------------
         //Display some interactive plots.
         if(InteractivePlots){
 
             // Plot leaf-pair profiles that were over tolerance.
             if(true){
-                YgorMathPlottingGnuplot::Plot<double>(PFC.leaf_plot_shtl, "Failed leaf-pair profiles", "DICOM position", "Pixel Intensity");
+                YgorMathPlottingGnuplot::Plot<double>(report.leaf_plot_shtl, "Failed leaf-pair profiles", "DICOM position", "Pixel Intensity");
             }
 
             // Plot junction profiles.
             if(false){
-                YgorMathPlottingGnuplot::Plot<double>(PFC.junction_plot_shtl, "Junction profiles", "DICOM position", "Pixel Intensity");
+                YgorMathPlottingGnuplot::Plot<double>(report.junction_plot_shtl, "Junction profiles", "DICOM position", "Pixel Intensity");
             }
         }
 
         // Insert contours.
         DICOM_data.Ensure_Contour_Data_Allocated();
-        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), PFC.peak_contours );
-        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), PFC.leaf_pair_contours );
-        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), PFC.junction_contours );
+        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), report.contours );
     }
 
     return DICOM_data;
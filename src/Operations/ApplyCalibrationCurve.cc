@@ -1,6 +1,8 @@
 //ApplyCalibrationCurve.cc - A part of DICOMautomaton 2018. Written by hal clark.
 
+#include <algorithm>
 #include <any>
+#include <cmath>
 #include <optional>
 #include <functional>
 #include <iterator>
@@ -13,7 +15,9 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Uniform_LUT.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
 #include "ApplyCalibrationCurve.h"
 #include "YgorImages.h"
@@ -35,6 +39,12 @@ OperationDoc OpArgDocApplyCalibrationCurve(){
         "This routine can handle overlapping or duplicate contours."
     );
 
+    out.notes.emplace_back(
+        "The calibration curve is resampled onto a dense, uniform grid so that each voxel is transformed with a"
+        " constant-time lookup. The grid is refined until the discrepancy with direct linear interpolation of the"
+        " curve is negligible (relative to the magnitude of the calibrated values); the bound is reported."
+    );
+
     out.args.emplace_back();
     out.args.back().name = "Channel";
     out.args.back().desc = "The image channel to use. Zero-based. Use '-1' to operate on all available channels.";
@@ -149,6 +159,12 @@ Drover ApplyCalibrationCurve(Drover DICOM_data,
         throw std::invalid_argument("Calibration curve file could not be read or was invalid. Cannot continue.");
     }
 
+    //Tabulate the curve once so each voxel is a constant-time lookup rather than a search over the curve samples.
+    // The tolerance is relative to the magnitude of the calibrated values.
+    double calib_mag = 0.0;
+    for(const auto &s : calib_curve.samples) calib_mag = std::max(calib_mag, std::abs(s[2]));
+    const auto calib_lut = Compile_LUT(calib_curve, 1.0E-5 * calib_mag);
+
     //Stuff references to all contours into a list. Remember that you can still address specific contours through
     // the original holding containers (which are not modified here).
     auto cc_all = All_CCs( DICOM_data );
@@ -192,16 +208,16 @@ Drover ApplyCalibrationCurve(Drover DICOM_data,
 
         ud.f_bounded = [&](long int /*row*/, long int /*col*/, long int chan, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
             if( (Channel < 0) || (Channel == chan) ){
-                voxel_val = calib_curve.Interpolate_Linearly(voxel_val)[2];
+                voxel_val = calib_lut(voxel_val);
             }
         };
         std::function<void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &)> f_noop;
         ud.f_visitor = f_noop;
         ud.f_unbounded = f_noop;
 
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     PartitionedImageVoxelVisitorMutator,
+                                     {}, cc_ROIs, &ud )){
             throw std::runtime_error("Unable to apply calibration curve to voxels with the specified ROI(s).");
         }
     }
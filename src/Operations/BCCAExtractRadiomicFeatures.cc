@@ -4,6 +4,7 @@
 #include <list>
 #include <map>
 #include <string>    
+#include <utility>
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
@@ -77,12 +78,12 @@ Drover BCCAExtractRadiomicFeatures(Drover DICOM_data,
                                    const std::string& FilenameLex){
 
     DICOM_data = SimplifyContours(
-                     DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+                     std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
     DICOM_data = ExtractRadiomicFeatures(
-                     DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+                     std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
 #ifdef DCMA_USE_SFML
     DICOM_data = PresentationImage(
-                     DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+                     std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
 #endif
 
     return DICOM_data;
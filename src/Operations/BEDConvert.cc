@@ -1,6 +1,8 @@
 //BEDConvert.cc - A part of DICOMautomaton 2017, 2019, 2020. Written by hal clark.
 
+#include <algorithm>
 #include <any>
+#include <cmath>
 #include <optional>
 #include <functional>
 #include <iterator>
@@ -10,10 +12,13 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <utility>
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Uniform_LUT.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/BEDConversion.h"
 #include "BEDConvert.h"
 #include "YgorImages.h"
@@ -223,10 +228,25 @@ Drover BEDConvert(Drover DICOM_data,
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
     IAs = Whitelist(IAs, "Modality", "RTDOSE");
+
+    //Tabulate the transforms once, over the range of dose present, rather than evaluating them for every voxel.
+    // The tolerance is relative to the largest transformed dose.
+    double D_max = 0.0;
+    for(auto & iap_it : IAs){
+        D_max = std::max(D_max, Finite_Voxel_Range((*iap_it)->imagecoll).second);
+    }
+    if(0.0 < D_max){
+        for(const auto & [abr, lut] : { std::make_pair(ud.AlphaBetaRatioEarly, &ud.EarlyLUT),
+                                        std::make_pair(ud.AlphaBetaRatioLate, &ud.LateLUT) }){
+            const auto f = BEDConversion_Transform(ud, abr);
+            *lut = Compile_LUT(f, 0.0, D_max, 1.0E-5 * std::abs(f(D_max)));
+        }
+    }
+
     for(auto & iap_it : IAs){
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          BEDConversion,
-                                                          {}, cc_ROIs, &ud )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     BEDConversion,
+                                     {}, cc_ROIs, &ud )){
             throw std::runtime_error("Unable to convert image_array voxels to BED or EQDx using the specified ROI(s).");
         }
     }
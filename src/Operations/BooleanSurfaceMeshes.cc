@@ -0,0 +1,150 @@
+//BooleanSurfaceMeshes.cc - A part of DICOMautomaton 2026.
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "../Lexicon_Cache.h"
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+#include "../Surface_Mesh_Booleans.h"
+
+#include "BooleanSurfaceMeshes.h"
+
+
+OperationDoc OpArgDocBooleanSurfaceMeshes(){
+    OperationDoc out;
+    out.name = "BooleanSurfaceMeshes";
+
+    out.desc =
+        "This operation computes the union, intersection, or difference of two groups of surface meshes, creating a"
+        " new mesh. It is useful for deriving planning volumes in interactive time.";
+
+    out.notes.emplace_back(
+        "Selected surface meshes should be closed. All meshes in each selection are combined (i.e., their union is"
+        " taken) before the operation is performed."
+    );
+    out.notes.emplace_back(
+        "Meshes are sampled as signed distance fields on a voxel grid, combined, and re-extracted with Marching Cubes."
+        " The result is accurate to roughly half a voxel and features smaller than a voxel are lost."
+        " Time and memory scale with the number of voxels, so the voxel size should be only as small as needed."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = SMWhitelistOpArgDoc();
+    out.args.back().name = "MeshSelection";
+    out.args.back().default_val = "last";
+    out.args.back().desc += " These meshes form the first operand.";
+
+    out.args.emplace_back();
+    out.args.back() = SMWhitelistOpArgDoc();
+    out.args.back().name = "ReferenceMeshSelection";
+    out.args.back().default_val = "first";
+    out.args.back().desc += " These meshes form the second operand.";
+
+    out.args.emplace_back();
+    out.args.back().name = "Operation";
+    out.args.back().desc = "The Boolean operation to perform."
+                           " 'difference' removes the second operand from the first.";
+    out.args.back().default_val = "union";
+    out.args.back().expected = true;
+    out.args.back().examples = { "union", "intersection", "difference" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+    out.args.emplace_back();
+    out.args.back().name = "VoxelSize";
+    out.args.back().desc = "The size of the voxels used to represent the meshes, which controls the tolerance."
+                           " DICOM units are assumed.";
+    out.args.back().default_val = "1.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.5", "1.0", "2.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "MeshLabel";
+    out.args.back().desc = "A label to attach to the new surface mesh.";
+    out.args.back().default_val = "unspecified";
+    out.args.back().expected = true;
+    out.args.back().examples = { "unspecified", "PTV", "body", "ring" };
+
+    return out;
+}
+
+
+
+Drover BooleanSurfaceMeshes(Drover DICOM_data,
+                            const OperationArgPkg& OptArgs,
+                            const std::map<std::string, std::string>&,
+                            const std::string& FilenameLex){
+
+    const lexicon_translator X(FilenameLex);
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto MeshSelectionStr = OptArgs.getValueStr("MeshSelection").value();
+    const auto ReferenceMeshSelectionStr = OptArgs.getValueStr("ReferenceMeshSelection").value();
+    const auto OperationStr = OptArgs.getValueStr("Operation").value();
+    const auto VoxelSize = std::stod( OptArgs.getValueStr("VoxelSize").value() );
+    const auto MeshLabel = OptArgs.getValueStr("MeshLabel").value();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto NormalizedMeshLabel = X(MeshLabel);
+
+    const auto regex_union        = Compile_Regex("^un?i?o?n?$");
+    const auto regex_intersection = Compile_Regex("^in?t?e?r?s?e?c?t?i?o?n?$");
+    const auto regex_difference   = Compile_Regex("^di?f?f?e?r?e?n?c?e?$");
+
+    mesh_boolean_op op;
+    if(std::regex_match(OperationStr, regex_union)){
+        op = mesh_boolean_op::Union;
+    }else if(std::regex_match(OperationStr, regex_intersection)){
+        op = mesh_boolean_op::Intersection;
+    }else if(std::regex_match(OperationStr, regex_difference)){
+        op = mesh_boolean_op::Difference;
+    }else{
+        throw std::invalid_argument("Operation not understood. Cannot continue.");
+    }
+
+    // Concatenates the selected meshes. Overlapping components are treated as their union.
+    const auto combine = [&](const std::string &selection) -> fv_surface_mesh<double, uint64_t> {
+        auto SMs_all = All_SMs( DICOM_data );
+        auto SMs = Whitelist( SMs_all, selection );
+        if(SMs.empty()){
+            throw std::invalid_argument("No meshes selected. Cannot continue.");
+        }
+
+        fv_surface_mesh<double, uint64_t> out;
+        for(auto & smp_it : SMs){
+            const auto &m = (*smp_it)->meshes;
+            const auto offset = static_cast<uint64_t>(out.vertices.size());
+            out.vertices.insert(std::end(out.vertices), std::begin(m.vertices), std::end(m.vertices));
+            for(const auto &f : m.faces){
+                out.faces.emplace_back(f);
+                for(auto &v : out.faces.back()) v += offset;
+            }
+            if(out.metadata.empty()) out.metadata = m.metadata;
+        }
+        return out;
+    };
+    const auto A = combine(MeshSelectionStr);
+    const auto B = combine(ReferenceMeshSelectionStr);
+
+    auto out = std::make_shared<Surface_Mesh>();
+    out->meshes = Boolean_Surface_Meshes(A, B, op, VoxelSize);
+    if(out->meshes.faces.empty()){
+        FUNCWARN("Boolean mesh is empty");
+    }
+
+    out->meshes.metadata = A.metadata;
+    out->meshes.metadata["MeshLabel"] = MeshLabel;
+    out->meshes.metadata["NormalizedMeshLabel"] = NormalizedMeshLabel;
+    out->meshes.metadata["Description"] = "Boolean surface mesh";
+    DICOM_data.smesh_data.emplace_back( out );
+
+    return DICOM_data;
+}
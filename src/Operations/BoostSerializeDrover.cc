@@ -50,6 +50,21 @@ OperationDoc OpArgDocBoost_Serialize_Drover(){
                                  "tplans+images+contours",
                                  "contours+images+pointclouds" };
 
+
+    out.args.emplace_back();
+    out.args.back().name = "Format";
+    out.args.back().desc = "The archive format to write."
+                           " 'gzip-xml' is portable across most CPUs, but is large and slow to load."
+                           " 'native' stores voxel data uncompressed in a layout that can be memory-mapped, which"
+                           " makes loading large image sets considerably faster."
+                           " 'native-compressed' is the same, but voxel data are losslessly compressed using multiple"
+                           " threads, which trades some loading speed for much smaller files."
+                           " Native archives can only be loaded on CPUs with the same byte order and float format.";
+    out.args.back().default_val = "gzip-xml";
+    out.args.back().expected = true;
+    out.args.back().examples = { "gzip-xml", "native", "native-compressed" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -61,6 +76,7 @@ Drover Boost_Serialize_Drover(const Drover& DICOM_data,
     //---------------------------------------------- User Parameters --------------------------------------------------
     auto FilenameStr = OptArgs.getValueStr("Filename").value();
     auto ComponentsStr = OptArgs.getValueStr("Components").value();
+    const auto FormatStr = OptArgs.getValueStr("Format").value();
 
     //-----------------------------------------------------------------------------------------------------------------
 
@@ -70,6 +86,10 @@ Drover Boost_Serialize_Drover(const Drover& DICOM_data,
     const auto regex_smeshes  = Compile_Regex(".*su?r?f?a?c?e?.*mes?h?e?s?.*");
     const auto regex_tplans   = Compile_Regex(".*t?r?e?a?t?m?e?n?t?.*pla?n?s?.*");
 
+    const auto regex_gzxml    = Compile_Regex("^gz?i?p?-?xml$");
+    const auto regex_native   = Compile_Regex("^na?t?i?v?e?$");
+    const auto regex_native_c = Compile_Regex("^na?t?i?v?e?-?co?m?p?r?e?s?s?e?d?$");
+
     const bool include_images   = std::regex_match(ComponentsStr, regex_images);
     const bool include_contours = std::regex_match(ComponentsStr, regex_contours);
     const bool include_pclouds  = std::regex_match(ComponentsStr, regex_pclouds);
@@ -99,7 +119,16 @@ Drover Boost_Serialize_Drover(const Drover& DICOM_data,
         d.tplan_data = DICOM_data.tplan_data;
     }
 
-    const auto res = Common_Boost_Serialize_Drover(d, apath);
+    bool res = false;
+    if(std::regex_match(FormatStr, regex_native)){
+        res = Common_Boost_Serialize_Drover_to_Native_Archive(d, apath);
+    }else if(std::regex_match(FormatStr, regex_native_c)){
+        res = Common_Boost_Serialize_Drover_to_Compressed_Native_Archive(d, apath);
+    }else if(std::regex_match(FormatStr, regex_gzxml)){
+        res = Common_Boost_Serialize_Drover(d, apath);
+    }else{
+        throw std::invalid_argument("Format not understood. Cannot continue.");
+    }
     if(res){
         FUNCINFO("Dumped serialization to file " << apath);
     }else{
@@ -16,6 +16,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/CT_Perfusion_Clip_Search.h"
 #include "../YgorImages_Functors/Processing/CT_Reasonable_HU_Window.h"
 #include "../YgorImages_Functors/Processing/DBSCAN_Time_Courses.h"
@@ -64,9 +65,9 @@ Drover CT_Liver_Perfusion(Drover DICOM_data,
 
     //Force the window to something reasonable to be uniform and cover normal tissue HU range.
     if(true) for(auto & img_arr : orig_img_arrays){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               StandardAbdominalHUWindow,
-                                               {}, {} )){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     StandardAbdominalHUWindow,
+                                     {}, {} )){
             FUNCERR("Unable to force window to cover reasonable HU range");
         }
     }
@@ -193,10 +194,10 @@ Drover CT_Liver_Perfusion(Drover DICOM_data,
             ud.f_unbounded = [&](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
                     voxel_val = 1.0;
             };
-            if(!roi_highlighted_img_arrays.back()->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                                             PartitionedImageVoxelVisitorMutator,
-                                                                             {}, cc_all,
-                                                                             &ud )){
+            if(!Process_Images_Balanced( roi_highlighted_img_arrays.back()->imagecoll,
+                                         PartitionedImageVoxelVisitorMutator,
+                                         {}, cc_all,
+                                         &ud )){
                 FUNCERR("Unable to highlight ROIs");
             }
         }
@@ -256,9 +257,9 @@ for(auto & img_arr : C_enhancement_img_arrays){
         DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>( *img_arr ) );
         log_scaled_img_arrays.emplace_back( DICOM_data.image_data.back() );
 
-        if(!log_scaled_img_arrays.back()->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                                    LogScalePixels,
-                                                                    {}, {} )){
+        if(!Process_Images_Balanced( log_scaled_img_arrays.back()->imagecoll,
+                                     LogScalePixels,
+                                     {}, {} )){
             FUNCERR("Unable to perform logarithmic pixel scaling");
         }
     }
@@ -327,9 +328,9 @@ for(auto & img_arr : C_enhancement_img_arrays){
         DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>( *img_arr ) );
         clip_likelihood_map_img_arrays.emplace_back( DICOM_data.image_data.back() );
 
-        if(!clip_likelihood_map_img_arrays.back()->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                                             CTPerfusionSearchForLiverClips,
-                                                                             {}, {} )){
+        if(!Process_Images_Balanced( clip_likelihood_map_img_arrays.back()->imagecoll,
+                                     CTPerfusionSearchForLiverClips,
+                                     {}, {} )){
             FUNCERR("Unable to perform search for liver clip markers");
         }
     }
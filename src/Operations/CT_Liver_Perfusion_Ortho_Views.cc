@@ -11,6 +11,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/CT_Reasonable_HU_Window.h"
 #include "../YgorImages_Functors/Processing/Orthogonal_Slices.h"
 #include "CT_Liver_Perfusion_Ortho_Views.h"
@@ -74,16 +75,16 @@ Drover CT_Liver_Perfusion_Ortho_Views(Drover DICOM_data,
 
     //Force the window to something reasonable to be uniform and cover normal tissue HU range.
     if(true) for(auto & img_arr : intersecting_row){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               StandardAbdominalHUWindow,
-                                               {}, {} )){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     StandardAbdominalHUWindow,
+                                     {}, {} )){
             FUNCERR("Unable to force window to cover reasonable HU range");
         }
     }
     if(true) for(auto & img_arr : intersecting_col){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               StandardAbdominalHUWindow,
-                                               {}, {} )){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     StandardAbdominalHUWindow,
+                                     {}, {} )){
             FUNCERR("Unable to force window to cover reasonable HU range");
         }
     }
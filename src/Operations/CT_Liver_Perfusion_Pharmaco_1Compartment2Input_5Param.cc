@@ -18,10 +18,12 @@
 #include <vector>
 
 #include "../Common_Plotting.h"
+#include "../KineticModel_Chebyshev_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Compute/Per_ROI_Time_Courses.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/CT_Reasonable_HU_Window.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Pixel_Decimate.h"
 #include "../YgorImages_Functors/Processing/Liver_Kinetic_1Compartment2Input_5Param_Chebyshev_Common.h"
@@ -255,6 +257,19 @@ OperationDoc OpArgDocCT_Liver_Perfusion_Pharmaco_1C2I_5Param(){
                             "10.01"};
 
 
+    out.args.emplace_back();
+    out.args.back().name = "WarmStart";
+    out.args.back().desc = "Control whether each voxel's model fit is initialized from the fitted parameters of"
+                      " neighbouring voxels, which have already been fitted. Neighbouring voxels tend to have"
+                      " similar parameters, so the optimizer typically converges in far fewer iterations."
+                      " If a warm-started fit fails, it is repeated from the default initial guess."
+                      " (This setting only applies when the Chebyshev polynomial method is being used.)";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true",
+                            "false" };
+
+
     out.args.emplace_back();
     out.args.back().name = "VIFROINameRegex";
     out.args.back().desc = "Regex for the name of the ROI to use as the VIF. It should generally be a"
@@ -292,6 +307,7 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_5Param(Drover DICOM_data,
     const auto ChebyshevPolyCoefficientsStr = OptArgs.getValueStr("ChebyshevPolyCoefficients").value();
 
     const auto VIFROIName = OptArgs.getValueStr("VIFROINameRegex").value();
+    const auto WarmStartStr = OptArgs.getValueStr("WarmStart").value();
     //-----------------------------------------------------------------------------------------------------------------
     const auto AIFROINameRegex = Compile_Regex(AIFROIName);
     const auto VIFROINameRegex = Compile_Regex(VIFROIName);
@@ -346,6 +362,7 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_5Param(Drover DICOM_data,
     const auto ShouldPlotAIFVIF = std::regex_match(PlotAIFVIF, TrueRegex);
     const auto UseBasisSplineInterpolation = std::regex_match(UseBasisSplineInterpolationStr, TrueRegex);
     const auto UseChebyshevPolyMethod = std::regex_match(UseChebyshevPolyMethodStr, TrueRegex);
+    const auto WarmStart = std::regex_match(WarmStartStr, TrueRegex);
 
 
     //Tokenize the plotting criteria.
@@ -389,9 +406,9 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_5Param(Drover DICOM_data,
 
     //Force the window to something reasonable to be uniform and cover normal tissue HU range.
     if(true) for(auto & img_arr : orig_img_arrays){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               StandardAbdominalHUWindow,
-                                               {}, {} )){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     StandardAbdominalHUWindow,
+                                     {}, {} )){
             FUNCERR("Unable to force window to cover reasonable HU range");
         }
     }
@@ -501,6 +518,7 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_5Param(Drover DICOM_data,
     // portal vein and ascending aorta curves.
     ComputePerROITimeCoursesUserData ud; // User Data.
     if(true) for(auto & img_arr : C_enhancement_img_arrays){
+        ud.tensor = img_arr->get_time_course_tensor();
         if(!img_arr->imagecoll.Compute_Images( ComputePerROICourses,   //Non-modifying function, can use in-place.
                                                { },
                                                cc_AIF_VIF,
@@ -535,9 +553,9 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_5Param(Drover DICOM_data,
 
         //for(auto & img_arr : DICOM_data.image_data){
         for(auto & img_arr : C_enhancement_img_arrays){
-            if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                   DecimateRC,
-                                                   {}, {} )){
+            if(!Process_Images_Balanced( img_arr->imagecoll,
+                                         DecimateRC,
+                                         {}, {} )){
                 FUNCERR("Unable to decimate pixels");
             }
         }
@@ -577,6 +595,7 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_5Param(Drover DICOM_data,
         ud_cheby.ContrastInjectionLeadTime = ContrastInjectionLeadTime;
         ud_cheby.ExpApproxTrunc = ExponentialKernelCoeffTruncation;
         ud_cheby.MultiplicationCoeffTrunc = FastChebyshevMultiplication;
+        ud_cheby.WarmStart = WarmStart;
         {
             //Correct any unaccounted-for contrast enhancement shifts. 
             if(true) for(auto & theROI : ud.time_courses){
@@ -649,28 +668,21 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_5Param(Drover DICOM_data,
 
                 const auto tmin = theROI.second.Get_Extreme_Datum_x().first[0];
                 const auto tmax = theROI.second.Get_Extreme_Datum_x().second[0];
-                const auto pinf = std::numeric_limits<double>::infinity(); //use automatic (maximal) endpoint determination.
-
-                cheby_approx<double> ca;
-
-                //Use basis spline interpolation when constructing the Chebyshev approximation.
+                chebyshev_expansion_settings settings;
+                settings.num_coeffs = num_ca_coeffs;
+                settings.domain_min = tmin + 5.0;
+                settings.domain_max = tmax - 5.0;
+                settings.use_basis_spline = UseBasisSplineInterpolation;
+                settings.basis_spline_order = BasisSplineOrder;
+                settings.basis_spline_coeffs = num_bs_coeffs;
                 if(UseBasisSplineInterpolation){
                     theROI.second = theROI.second.Strip_Uncertainties_in_y();
-                    //basis_spline bs(theROI.second, pinf, pinf, BasisSplineOrder, num_bs_coeffs, basis_spline_breakpoints::equal_spacing);
-                    basis_spline bs(theROI.second, pinf, pinf, BasisSplineOrder, num_bs_coeffs, basis_spline_breakpoints::adaptive_datum_density);
-                    auto interp = [&bs](double t) -> double {
-                            const auto interpolated_f = bs.Sample(t)[2];
-                            return interpolated_f;
-                    };
-                    ca.Prepare(interp, num_ca_coeffs, tmin + 5.0, tmax - 5.0);
-
-                //Use (default) linear interpolation when constructing the Chebyshev approximation.
-                }else{
-                    ca.Prepare(theROI.second, num_ca_coeffs, tmin + 5.0, tmax - 5.0);
                 }
 
-                ud_cheby.time_courses[theROI.first] = ca;
-                ud_cheby.time_course_derivatives[theROI.first] = ca.Chebyshev_Derivative();
+                //Expansions are memoized, so re-running this operation (or another model) on the same AIF and VIF reuses them.
+                const auto expansion = Get_Chebyshev_Expansion(theROI.second, settings);
+                ud_cheby.time_courses[theROI.first] = *(expansion.approx);
+                ud_cheby.time_course_derivatives[theROI.first] = *(expansion.derivative);
             }
 
             if(ShouldPlotAIFVIF){
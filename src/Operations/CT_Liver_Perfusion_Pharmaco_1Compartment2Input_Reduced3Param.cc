@@ -18,10 +18,12 @@
 #include <vector>
 
 #include "../Common_Plotting.h"
+#include "../KineticModel_Chebyshev_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Compute/Per_ROI_Time_Courses.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/CT_Reasonable_HU_Window.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Pixel_Decimate.h"
 #include "../YgorImages_Functors/Processing/Liver_Kinetic_1Compartment2Input_Reduced3Param_Chebyshev_Common.h"
@@ -56,6 +58,20 @@ OperationDoc OpArgDocCT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(){
                             "Major_Artery" };
 
 
+    out.args.emplace_back();
+    out.args.back().name = "Backend";
+    out.args.back().desc = "Controls where the per-voxel model fits are performed. 'cpu' fits each voxel independently"
+                      " using a local optimizer. 'sycl' first performs an exhaustive search over a grid of"
+                      " (tauA, tauV, k2) for all voxels simultaneously on a SYCL device (e.g., a GPU), and then"
+                      " polishes each voxel's optimum with the same local optimizer, so the fitted parameters"
+                      " remain those of the CPU model. The grid search is also less likely to become stuck in a"
+                      " poor local minimum. If DICOMautomaton was built without SYCL support, or no suitable"
+                      " device is available, 'sycl' falls back to 'cpu'.";
+    out.args.back().default_val = "cpu";
+    out.args.back().expected = true;
+    out.args.back().examples = { "cpu", "sycl" };
+
+
     out.args.emplace_back();
     out.args.back().name = "ExponentialKernelCoeffTruncation";
     out.args.back().desc = "Control the number of Chebyshev coefficients used to approximate the exponential"
@@ -265,6 +281,7 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(Drover DICOM_data,
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto AIFROIName = OptArgs.getValueStr("AIFROINameRegex").value();
+    const auto BackendStr = OptArgs.getValueStr("Backend").value();
     const long int ExponentialKernelCoeffTruncation = std::stol( OptArgs.getValueStr("ExponentialKernelCoeffTruncation").value() );
     const auto FastChebyshevMultiplicationStr = OptArgs.getValueStr("FastChebyshevMultiplication").value();
     const auto PlotAIFVIF = OptArgs.getValueStr("PlotAIFVIF").value();
@@ -284,6 +301,8 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(Drover DICOM_data,
     const auto VIFROINameRegex = Compile_Regex(VIFROIName);
     const auto TargetROINameRegex = Compile_Regex(TargetROIName);
     const auto TrueRegex = Compile_Regex("^tr?u?e?$");
+    const auto regex_cpu = Compile_Regex("^cp?u?$");
+    const auto regex_sycl = Compile_Regex("^sy?c?l?$");
     const auto IsPositiveInteger = Compile_Regex("^[0-9]*$");
     const auto IsPositiveFloat = Compile_Regex("^[0-9.]*$");
     const auto IsRelativePosFloat = Compile_Regex("^[*][0-9.]*$");
@@ -329,6 +348,17 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(Drover DICOM_data,
 
 
 
+    bool UseAccelerator = false;
+    if(std::regex_match(BackendStr, regex_sycl)){
+        UseAccelerator = true;
+#ifndef DCMA_USE_SYCL
+        FUNCWARN("SYCL support was not enabled at compile time. Falling back to the CPU backend");
+        UseAccelerator = false;
+#endif // DCMA_USE_SYCL
+    }else if(!std::regex_match(BackendStr, regex_cpu)){
+        throw std::invalid_argument("Backend argument '" + BackendStr + "' is not valid");
+    }
+
     //Boolean options.
     const auto ShouldPlotAIFVIF = std::regex_match(PlotAIFVIF, TrueRegex);
     const auto UseBasisSplineInterpolation = std::regex_match(UseBasisSplineInterpolationStr, TrueRegex);
@@ -375,9 +405,9 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(Drover DICOM_data,
 
     //Force the window to something reasonable to be uniform and cover normal tissue HU range.
     if(true) for(auto & img_arr : orig_img_arrays){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               StandardAbdominalHUWindow,
-                                               {}, {} )){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     StandardAbdominalHUWindow,
+                                     {}, {} )){
             FUNCERR("Unable to force window to cover reasonable HU range");
         }
     }
@@ -487,6 +517,7 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(Drover DICOM_data,
     // portal vein and ascending aorta curves.
     ComputePerROITimeCoursesUserData ud; // User Data.
     if(true) for(auto & img_arr : C_enhancement_img_arrays){
+        ud.tensor = img_arr->get_time_course_tensor();
         if(!img_arr->imagecoll.Compute_Images( ComputePerROICourses,   //Non-modifying function, can use in-place.
                                                { },
                                                cc_AIF_VIF,
@@ -521,9 +552,9 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(Drover DICOM_data,
 
         //for(auto & img_arr : DICOM_data.image_data){
         for(auto & img_arr : C_enhancement_img_arrays){
-            if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                   DecimateRC,
-                                                   {}, {} )){
+            if(!Process_Images_Balanced( img_arr->imagecoll,
+                                         DecimateRC,
+                                         {}, {} )){
                 FUNCERR("Unable to decimate pixels");
             }
         }
@@ -561,6 +592,7 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(Drover DICOM_data,
     ud_cheby.ContrastInjectionLeadTime = ContrastInjectionLeadTime;
     ud_cheby.ExpApproxTrunc = ExponentialKernelCoeffTruncation;
     ud_cheby.MultiplicationCoeffTrunc = FastChebyshevMultiplication;
+    ud_cheby.UseAccelerator = UseAccelerator;
     {
         //Correct any unaccounted-for contrast enhancement shifts. 
         if(true) for(auto & theROI : ud.time_courses){
@@ -633,28 +665,21 @@ Drover CT_Liver_Perfusion_Pharmaco_1C2I_Reduced3Param(Drover DICOM_data,
 
             const auto tmin = theROI.second.Get_Extreme_Datum_x().first[0];
             const auto tmax = theROI.second.Get_Extreme_Datum_x().second[0];
-            const auto pinf = std::numeric_limits<double>::infinity(); //use automatic (maximal) endpoint determination.
-
-            cheby_approx<double> ca;
-
-            //Use basis spline interpolation when constructing the Chebyshev approximation.
+            chebyshev_expansion_settings settings;
+            settings.num_coeffs = num_ca_coeffs;
+            settings.domain_min = tmin + 5.0;
+            settings.domain_max = tmax - 5.0;
+            settings.use_basis_spline = UseBasisSplineInterpolation;
+            settings.basis_spline_order = BasisSplineOrder;
+            settings.basis_spline_coeffs = num_bs_coeffs;
             if(UseBasisSplineInterpolation){
                 theROI.second = theROI.second.Strip_Uncertainties_in_y();
-                //basis_spline bs(theROI.second, pinf, pinf, BasisSplineOrder, num_bs_coeffs, basis_spline_breakpoints::equal_spacing);
-                basis_spline bs(theROI.second, pinf, pinf, BasisSplineOrder, num_bs_coeffs, basis_spline_breakpoints::adaptive_datum_density);
-                auto interp = [&bs](double t) -> double {
-                        const auto interpolated_f = bs.Sample(t)[2];
-                        return interpolated_f;
-                };
-                ca.Prepare(interp, num_ca_coeffs, tmin + 5.0, tmax - 5.0);
-
-            //Use (default) linear interpolation when constructing the Chebyshev approximation.
-            }else{
-                ca.Prepare(theROI.second, num_ca_coeffs, tmin + 5.0, tmax - 5.0);
             }
 
-            ud_cheby.time_courses[theROI.first] = ca;
-            ud_cheby.time_course_derivatives[theROI.first] = ca.Chebyshev_Derivative();
+            //Expansions are memoized, so re-running this operation (or another model) on the same AIF and VIF reuses them.
+            const auto expansion = Get_Chebyshev_Expansion(theROI.second, settings);
+            ud_cheby.time_courses[theROI.first] = *(expansion.approx);
+            ud_cheby.time_course_derivatives[theROI.first] = *(expansion.derivative);
         }
 
         if(ShouldPlotAIFVIF){
@@ -11,20 +11,23 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "../Structs.h"
+#include "../Point_Set_DBSCAN.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
 #include "ClusterDBSCAN.h"
 #include "YgorImages.h"
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 #include "YgorStats.h"       //Needed for Stats:: namespace.
 
-#include "YgorClustering.hpp"
-
 
 OperationDoc OpArgDocClusterDBSCAN(){
     OperationDoc out;
@@ -39,6 +42,10 @@ OperationDoc OpArgDocClusterDBSCAN(){
     out.notes.emplace_back(
         "This operation will work with single images and image volumes. Images need not be rectilinear."
     );
+    out.notes.emplace_back(
+        "Clustering is performed in parallel using a spatial grid. Results are identical to sequential DBSCAN"
+        " visiting voxels in image order, so cluster numbers are reproducible regardless of the number of threads."
+    );
     
 
     out.args.emplace_back();
@@ -183,6 +190,17 @@ OperationDoc OpArgDocClusterDBSCAN(){
                                  "median" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
+    out.args.emplace_back();
+    out.args.back().name = "BoundedMemory";
+    out.args.back().desc = "Whether to limit memory usage at the cost of some speed."
+                           " By default, spatial neighbourhood lookups are cached, which can require a few hundred"
+                           " bytes per voxel when the voxels selected for clustering are sparse."
+                           " Enabling this option avoids the cache, which may be necessary for very large volumes.";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -214,6 +232,8 @@ Drover ClusterDBSCAN(Drover DICOM_data,
 
     const auto ReductionStr = OptArgs.getValueStr("Reduction").value();;
 
+    const auto BoundedMemoryStr = OptArgs.getValueStr("BoundedMemory").value();
+
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_centre = Compile_Regex("^cent.*");
     const auto regex_pci = Compile_Regex("^planar_?c?o?r?n?e?r?s?_?inc?l?u?s?i?v?e?$");
@@ -226,6 +246,13 @@ Drover ClusterDBSCAN(Drover DICOM_data,
     const auto regex_none = Compile_Regex("^no?n?e?$");
     const auto regex_median = Compile_Regex("^medi?a?n?$");
 
+    const auto regex_true = Compile_Regex("^tr?u?e?$");
+
+    dbscan_options dbscan_opts;
+    dbscan_opts.eps = Eps;
+    dbscan_opts.min_points = static_cast<long int>(MinPoints);
+    dbscan_opts.bounded_memory = std::regex_match(BoundedMemoryStr, regex_true);
+
 
     //Stuff references to all contours into a list. Remember that you can still address specific contours through
     // the original holding containers (which are not modified here).
@@ -236,17 +263,14 @@ Drover ClusterDBSCAN(Drover DICOM_data,
         throw std::invalid_argument("No contours selected. Cannot continue.");
     }
 
-    // DBSCAN setup.
-    constexpr size_t MaxElementsInANode = 6; // 16, 32, 128, 256, ... ?
-    using RTreeParameter_t = boost::geometry::index::rstar<MaxElementsInANode>;
-
-    using UserData_t = std::pair< planar_image<float,double>*, long int >;
-    using CDat_t = ClusteringDatum<3, double, // Spatial dimensions.
-                            0, double, // Attribute dimensions (not used).
-                            uint64_t,  // Cluster ID type.
-                            UserData_t>;
-    //typedef boost::geometry::model::box<CDat_t> Box_t;
-    using RTree_t = boost::geometry::index::rtree<CDat_t,RTreeParameter_t>;
+    // Voxels are identified by the image's position in the collection and the voxel index, which provides a
+    // deterministic order for clustering.
+    struct voxel_t {
+        size_t img_num;
+        long int index;
+        planar_image<float,double> *img;
+        vec3<double> pos;
+    };
 
 
     auto IAs_all = All_IAs( DICOM_data );
@@ -255,8 +279,11 @@ Drover ClusterDBSCAN(Drover DICOM_data,
 
         // --------------------------------
         // Prepare for clustering.
-        RTree_t rtree;
-        std::mutex rtree_locker;
+        std::unordered_map<const planar_image<float,double>*, size_t> img_nums;
+        for(const auto &img : (*iap_it)->imagecoll.images) img_nums.emplace(std::addressof(img), img_nums.size());
+
+        std::vector<voxel_t> voxels;
+        std::mutex voxels_locker;
 
         PartitionedImageVoxelVisitorMutatorUserData ud;
 
@@ -290,12 +317,12 @@ Drover ClusterDBSCAN(Drover DICOM_data,
             if( (Channel < 0) || (Channel == chan) ){
                 if(isininc(Lower, voxel_val, Upper)){
                 //|| !std::isfinite(voxel_val) ){
-                    const auto p = img_refw.get().position(row,col);
-                    const auto index = img_refw.get().index(row,col,chan);
+                    auto *img_ptr = std::addressof(img_refw.get());
+                    const auto p = img_ptr->position(row,col);
+                    const auto index = img_ptr->index(row,col,chan);
 
-                    std::lock_guard<std::mutex> lock(rtree_locker);
-                    rtree.insert(CDat_t({ p.x, p.y, p.z }, {}, 
-                                        std::make_pair(std::addressof(img_refw.get()), index) ));
+                    std::lock_guard<std::mutex> lock(voxels_locker);
+                    voxels.push_back({ img_nums.at(img_ptr), index, img_ptr, p });
                     ++BeforeCount;
                 }
             }
@@ -305,10 +332,10 @@ Drover ClusterDBSCAN(Drover DICOM_data,
             return;
         };
 
-        // Fill the r-tree.
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
+        // Gather the voxels.
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     PartitionedImageVoxelVisitorMutator,
+                                     {}, cc_ROIs, &ud )){
             throw std::runtime_error("Unable to identify voxels for clustering using the specified ROI(s).");
         }
 
@@ -317,42 +344,35 @@ Drover ClusterDBSCAN(Drover DICOM_data,
         // Cluster.
         FUNCINFO("Number of voxels being clustered: " << BeforeCount);
 
-        DBSCAN<RTree_t,CDat_t>(rtree,Eps,MinPoints);
+        std::sort(std::begin(voxels), std::end(voxels), [](const voxel_t &L, const voxel_t &R) -> bool {
+            return (L.img_num == R.img_num) ? (L.index < R.index) : (L.img_num < R.img_num);
+        });
+        std::vector<int64_t> cluster_ids;
+        {
+            std::vector<vec3<double>> points;
+            points.reserve(voxels.size());
+            for(const auto &v : voxels) points.push_back(v.pos);
+            cluster_ids = Point_Set_DBSCAN(points, dbscan_opts);
+        }
 
         // --------------------------------
         // Determine which clusters are too large.
-        std::map<typename CDat_t::ClusterIDType_, long int> cluster_member_count;
-        {
-            constexpr auto RTreeSpatialQueryGetAll = [](const CDat_t &) -> bool { return true; };
-            RTree_t::const_query_iterator it;
-            it = rtree.qbegin(boost::geometry::index::satisfies( RTreeSpatialQueryGetAll ));
-            for( ; it != rtree.qend(); ++it){
-                if(it->CID.IsRegular()){
-                    const auto cluster_id = it->CID.Raw;
-                    cluster_member_count[cluster_id] += 1;
-                }
-            }
+        std::map<int64_t, long int> cluster_member_count;
+        for(const auto &cluster_id : cluster_ids){
+            if(cluster_id != dbscan_noise) cluster_member_count[cluster_id] += 1;
         }
 
         // --------------------------------
         // Overwrite voxel values for clustered voxels.
         if( std::regex_match(ReductionStr, regex_none) ){
             long int AfterCount = 0;
-            {
-                constexpr auto RTreeSpatialQueryGetAll = [](const CDat_t &) -> bool { return true; };
-                RTree_t::const_query_iterator it;
-                it = rtree.qbegin(boost::geometry::index::satisfies( RTreeSpatialQueryGetAll ));
-                for( ; it != rtree.qend(); ++it){
-                    const auto img_ptr = it->UserData.first;
-                    const auto index = it->UserData.second;
-
-                    if(it->CID.IsRegular()){
-                        ++AfterCount;
-                        const auto cluster_id = it->CID.Raw;
-                        if(cluster_member_count[cluster_id] <= MaxPoints){
-                            const auto new_val = static_cast<float>(cluster_id);
-                            img_ptr->reference(index) = new_val;
-                        }
+            for(size_t i = 0; i < voxels.size(); ++i){
+                const auto cluster_id = cluster_ids[i];
+                if(cluster_id != dbscan_noise){
+                    ++AfterCount;
+                    if(cluster_member_count[cluster_id] <= MaxPoints){
+                        const auto new_val = static_cast<float>(cluster_id);
+                        voxels[i].img->reference(voxels[i].index) = new_val;
                     }
                 }
             }
@@ -363,31 +383,17 @@ Drover ClusterDBSCAN(Drover DICOM_data,
         }else if( std::regex_match(ReductionStr, regex_median) ){
 
             // Segregate the data based on ClusterID.
-            std::map<uint64_t, std::vector<double> > seg_x;
-            std::map<uint64_t, std::vector<double> > seg_y;
-            std::map<uint64_t, std::vector<double> > seg_z;
-            {
-                constexpr auto RTreeSpatialQueryGetAll = [](const CDat_t &) -> bool { return true; };
-                RTree_t::const_query_iterator it;
-                it = rtree.qbegin(boost::geometry::index::satisfies( RTreeSpatialQueryGetAll ));
-                for( ; it != rtree.qend(); ++it){
-                    if(it->CID.IsRegular()){
-                        const auto cluster_id = it->CID.Raw;
-                        if(cluster_member_count[cluster_id] <= MaxPoints){
-                            const auto img_ptr = it->UserData.first;
-                            const auto index = it->UserData.second;
-
-                            const auto rcc = img_ptr->row_column_channel_from_index(index);
-                            const auto row = std::get<0>(rcc);
-                            const auto col = std::get<1>(rcc);
-
-                            const auto pos = img_ptr->position(row, col);
-
-                            seg_x[cluster_id].push_back( pos.x );
-                            seg_y[cluster_id].push_back( pos.y );
-                            seg_z[cluster_id].push_back( pos.z );
-                        }
-                    }
+            std::map<int64_t, std::vector<double> > seg_x;
+            std::map<int64_t, std::vector<double> > seg_y;
+            std::map<int64_t, std::vector<double> > seg_z;
+            for(size_t i = 0; i < voxels.size(); ++i){
+                const auto cluster_id = cluster_ids[i];
+                if( (cluster_id != dbscan_noise)
+                &&  (cluster_member_count[cluster_id] <= MaxPoints) ){
+                    const auto &pos = voxels[i].pos;
+                    seg_x[cluster_id].push_back( pos.x );
+                    seg_y[cluster_id].push_back( pos.y );
+                    seg_z[cluster_id].push_back( pos.z );
                 }
             }
 
@@ -100,10 +100,18 @@ OperationDoc OpArgDocComparePixels(){
                            " are satisfied (gamma <= 1 iff both pass). It was proposed by Low et al. in 1998"
                            " ((doi:10.1118/1.598248). Gamma analyses permits trade-offs between spatial"
                            " and dosimetric discrepancies which can arise when the image arrays slightly differ"
-                           " in alignment or pixel values.";
+                           " in alignment or pixel values."
+                           " The 'gamma-search' method computes the gamma index by directly minimizing the gamma"
+                           " function of Low et al. over the reference neighbourhood, visiting a precomputed table"
+                           " of offsets in order of increasing distance and halting once no closer offset can"
+                           " improve the result. It is usually much faster than 'gamma-index', supports"
+                           " supersampling the reference images, but requires them to be regularly spaced."
+                           " Note that 'gamma-index' estimates DTA and the point discrepancy separately, so the two"
+                           " methods can report slightly different values.";
     out.args.back().default_val = "gamma-index";
     out.args.back().expected = true;
     out.args.back().examples = { "gamma-index",
+                                 "gamma-search",
                                  "DTA",
                                  "discrepancy" };
     out.args.back().samples = OpArgSamples::Exhaustive;
@@ -294,6 +302,31 @@ OperationDoc OpArgDocComparePixels(){
     out.args.back().examples = { "true",
                                  "false" };
 
+    out.args.emplace_back();
+    out.args.back().name = "GammaSupersample";
+    out.args.back().desc = "Parameter for 'gamma-search' comparisons."
+                           " The number of samples taken per reference voxel along each axis. Values between voxel"
+                           " centres are trilinearly interpolated. Supersampling reduces the error caused by"
+                           " coarse reference grids, but the cost grows with the cube of this factor."
+                           " A value of 1 disables supersampling.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1",
+                                 "2",
+                                 "4" };
+
+    out.args.emplace_back();
+    out.args.back().name = "GammaTolerance";
+    out.args.back().desc = "Parameter for 'gamma-search' comparisons."
+                           " The search for each voxel is halted once the reported gamma index is known to be"
+                           " within this (absolute) tolerance of the true minimum. Larger values reduce runtime."
+                           " A value of 0 evaluates the minimum exactly (i.e., to within the sampling resolution).";
+    out.args.back().default_val = "0.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0",
+                                 "0.01",
+                                 "0.05" };
+
     return out;
 }
 
@@ -329,11 +362,14 @@ Drover ComparePixels(Drover DICOM_data,
     const auto GammaDTAThreshold = std::stod( OptArgs.getValueStr("GammaDTAThreshold").value() );
     const auto GammaDiscThreshold = std::stod( OptArgs.getValueStr("GammaDiscThreshold").value() );
     const auto GammaTerminateAboveOneStr = OptArgs.getValueStr("GammaTerminateAboveOne").value();
+    const auto GammaSupersample = std::stol( OptArgs.getValueStr("GammaSupersample").value() );
+    const auto GammaTolerance = std::stod( OptArgs.getValueStr("GammaTolerance").value() );
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_true = Compile_Regex("^tr?u?e?$");
 
     const auto method_gam = Compile_Regex("^ga?m?m?a?-?i?n?d?e?x?$");
+    const auto method_gsr = Compile_Regex("^ga?m?m?a?-?se?a?r?c?h?$");
     const auto method_dta = Compile_Regex("^dta?$");
     const auto method_dis = Compile_Regex("^dis?c?r?e?p?a?n?c?y?$");
 
@@ -373,6 +409,8 @@ Drover ComparePixels(Drover DICOM_data,
 
         if(std::regex_match(MethodStr, method_gam)){
             ud.comparison_method = ComputeCompareImagesUserData::ComparisonMethod::GammaIndex;
+        }else if(std::regex_match(MethodStr, method_gsr)){
+            ud.comparison_method = ComputeCompareImagesUserData::ComparisonMethod::GammaIndexSearch;
         }else if(std::regex_match(MethodStr, method_dta)){
             ud.comparison_method = ComputeCompareImagesUserData::ComparisonMethod::DTA;
         }else if(std::regex_match(MethodStr, method_dis)){
@@ -424,6 +462,8 @@ Drover ComparePixels(Drover DICOM_data,
         ud.gamma_DTA_threshold = GammaDTAThreshold;
 
         ud.gamma_terminate_when_max_exceeded = GammaTerminateAboveOne;
+        ud.gamma_supersample = GammaSupersample;
+        ud.gamma_tolerance = GammaTolerance;
         //ud.gamma_terminated_early = std::nextafter(1.0, std::numeric_limits<double>::infinity());
 
         if(!(*iap_it)->imagecoll.Compute_Images( ComputeCompareImages, 
@@ -432,7 +472,8 @@ Drover ComparePixels(Drover DICOM_data,
         }
 
 
-        if(std::regex_match(MethodStr, method_gam)){
+        if( std::regex_match(MethodStr, method_gam)
+        ||  std::regex_match(MethodStr, method_gsr) ){
             FUNCINFO("Passing rate: " 
                      << ud.passed
                      << " out of " 
@@ -1,7 +1,9 @@
 //ContourBasedRayCastDoseAccumulate.cc - A part of DICOMautomaton 2015, 2016. Written by hal clark.
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <optional>
 #include <fstream>
 #include <functional>
@@ -13,13 +15,16 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <utility>
 #include <vector>
 
 #include "../Dose_Meld.h"
+#include "../Image_Slice_Index.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "ContourBasedRayCastDoseAccumulate.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorImagesIO.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -27,6 +32,22 @@
 
 
 
+namespace {
+
+// The extent of a sphere or cylinder, expanded by the radius, along the grid axes. Rays travel along the third axis.
+struct ray_cast_primitive {
+    bool is_sphere = false;
+    size_t index = 0; // Into the spheres or cylinders.
+    std::array<double, 3> lo;
+    std::array<double, 3> hi;
+};
+
+// Rays are processed in square tiles, each with the list of primitives that could be encountered by its rays.
+constexpr long int ray_tile_extent = 16;
+
+} // namespace
+
+
 OperationDoc OpArgDocContourBasedRayCastDoseAccumulate(){
     OperationDoc out;
     out.name = "ContourBasedRayCastDoseAccumulate";
@@ -126,7 +147,7 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data,
     const auto Rows = std::stol(RowsStr);
     const auto Columns = std::stol(ColumnsStr);
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //Ensure the Ray dL is sufficiently small. We enforce that ray cannot step over the cylinder in a single iteration
     // for 95% of the width of the cylinder. So if the rays are oncoming and directed at the cylinder perpendicularly,
@@ -204,7 +225,7 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data,
     } 
 
     //Merge the dose arrays if multiple are available.
-    DICOM_data = Meld_Only_Dose_Data(DICOM_data);
+    DICOM_data = Meld_Only_Dose_Data(std::move(DICOM_data));
 
     //Gather only dose images.
     auto IAs_all = All_IAs( DICOM_data );
@@ -234,9 +255,6 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data,
     }
 
     //Pre-compute the line segments and spheres we will use to define the surface boundary. 
-    //
-    // NOTE: We should be using a spatial indexing data structure, like R*-tree. (Does it support cylinders? Can it be
-    // made to support cylinders?) TODO.
     std::vector<line_segment<double>> cylinders; // Radii are all the same: CylinderRadius.
     std::vector<vec3<double>> spheres; // Centres of the spheres. The radii are the same as the cylinder radii.
 
@@ -381,66 +399,138 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data,
     DetectImg.init_orientation(GridX, GridY);
     DetectImg.fill_pixels(0.0);
 
+    //Bin the spheres and cylinders into tiles of rays, so each ray only needs to consider the primitives it might
+    // encounter. Rays travel parallel to GridNormal, so they can only encounter primitives whose extent (projected onto
+    // the grid plane) encompasses the ray.
+    std::vector<ray_cast_primitive> primitives;
+    primitives.reserve(spheres.size() + cylinders.size());
+    const auto grid_coords = [&](const vec3<double> &v) -> std::array<double, 3> {
+        return {{ v.Dot(GridX), v.Dot(GridY), v.Dot(GridNormal) }};
+    };
+    const auto add_primitive = [&](bool is_sphere, size_t index, const std::vector<vec3<double>> &verts) -> void {
+        ray_cast_primitive p;
+        p.is_sphere = is_sphere;
+        p.index = index;
+        p.lo = grid_coords(verts.front());
+        p.hi = p.lo;
+        for(const auto &v : verts){
+            const auto c = grid_coords(v);
+            for(size_t i = 0; i < 3; ++i){
+                p.lo[i] = std::min(p.lo[i], c[i]);
+                p.hi[i] = std::max(p.hi[i], c[i]);
+            }
+        }
+        // A small tolerance guards against round-off in the ray positions. Primitives are tested exactly later.
+        const auto expand = CylinderRadius * (1.0 + 1E-6) + 1E-9;
+        for(size_t i = 0; i < 3; ++i){
+            p.lo[i] -= expand;
+            p.hi[i] += expand;
+        }
+        primitives.push_back(p);
+    };
+    for(size_t i = 0; i < spheres.size(); ++i) add_primitive(true, i, { spheres[i] });
+    for(size_t i = 0; i < cylinders.size(); ++i){
+        add_primitive(false, i, { cylinders[i].Get_R0(), cylinders[i].Get_R1() });
+    }
+
+    //Ray (row, column) positions map to the first and second grid coordinates, respectively.
+    const auto ray_origin = grid_coords(SourceImg.position(0, 0));
+    const auto ray_du = SourceImg.pxl_dx;
+    const auto ray_dv = SourceImg.pxl_dy;
+    const long int tile_rows = (Rows + ray_tile_extent - 1) / ray_tile_extent;
+    const long int tile_cols = (Columns + ray_tile_extent - 1) / ray_tile_extent;
+    std::vector<std::vector<uint32_t>> tiles(static_cast<size_t>(tile_rows * tile_cols));
+    for(size_t n = 0; n < primitives.size(); ++n){
+        const auto &p = primitives[n];
+        const auto clamp_tile = [](double x, long int N) -> long int {
+            return std::clamp<long int>(static_cast<long int>(std::floor(x)), 0L, N - 1L);
+        };
+        if( (p.hi[0] < ray_origin[0] - ray_du) || (p.hi[1] < ray_origin[1] - ray_dv) ) continue;
+        const auto tr_min = clamp_tile((p.lo[0] - ray_origin[0]) / ray_du / ray_tile_extent, tile_rows);
+        const auto tr_max = clamp_tile((p.hi[0] - ray_origin[0]) / ray_du / ray_tile_extent, tile_rows);
+        const auto tc_min = clamp_tile((p.lo[1] - ray_origin[1]) / ray_dv / ray_tile_extent, tile_cols);
+        const auto tc_max = clamp_tile((p.hi[1] - ray_origin[1]) / ray_dv / ray_tile_extent, tile_cols);
+        for(long int tr = tr_min; tr <= tr_max; ++tr){
+            for(long int tc = tc_min; tc <= tc_max; ++tc){
+                tiles[tr * tile_cols + tc].push_back(static_cast<uint32_t>(n));
+            }
+        }
+    }
+
     //Now ready to ray cast. Loop over integer pixel coordinates. Start and finish are image pixels.
     // The top image can be the length image.
+    //
+    // Tiles of rays are cast concurrently. Each ray writes only its own pixels.
     const auto sq_radius = std::pow(CylinderRadius, 2.0);
-    for(long int row = 0; row < Rows; ++row){
-        FUNCINFO("Working on row " << (row+1) << " of " << Rows 
-                  << " --> " << static_cast<int>(1000.0*(row+1)/Rows)/10.0 << "% done");
-        for(long int col = 0; col < Columns; ++col){
-            double accumulated_length = 0.0;      //Length of ray travel within the 'surface'.
-            double accumulated_doselength = 0.0;
-
-            vec3<double> ray_pos = SourceImg.position(row, col);
-            const vec3<double> terminus = DetectImg.position(row, col);
-            const vec3<double> ray_dir = (terminus - ray_pos).unit();
-
-            //Go until we get within certain distance or overshoot and the ray wants to backtrack.
-            while(    (ray_dir.Dot( (terminus - ray_pos).unit() ) > 0.8 ) // Ray orientation is still downward-facing.
-                   && (ray_pos.distance(terminus) > std::max(RaydL, grid_margin)) ){ // Still far away from detector.
-
-                ray_pos += ray_dir * RaydL;
-                const auto midpoint = ray_pos - (ray_dir * RaydL * 0.5);
-
-                //Search to see if ray is in an object.
-                bool skip = false; //Was already found to be in a surface and was counted.
-                for(const auto &asphere : spheres){
-                    if(ray_pos.sq_dist(asphere) < sq_radius){
+    const auto img_index = img_arr_ptr->get_slice_index();
+    progress_tracker progress("ray casting", tile_rows * tile_cols,
+                              [](long int completed, long int total, double eta_s) -> void {
+        FUNCINFO("Cast " << completed << " of " << total << " ray tiles (ETA " << eta_s << " s)");
+    });
+    parallel_for(0, tile_rows * tile_cols, [&](long int tile) -> void {
+        const auto &tile_prims = tiles[tile];
+        const long int row_min = (tile / tile_cols) * ray_tile_extent;
+        const long int col_min = (tile % tile_cols) * ray_tile_extent;
+        const long int row_max = std::min(Rows, row_min + ray_tile_extent);
+        const long int col_max = std::min(Columns, col_min + ray_tile_extent);
+
+        std::vector<const ray_cast_primitive *> ray_prims;
+        for(long int row = row_min; row < row_max; ++row){
+            for(long int col = col_min; col < col_max; ++col){
+                double accumulated_length = 0.0;      //Length of ray travel within the 'surface'.
+                double accumulated_doselength = 0.0;
+
+                vec3<double> ray_pos = SourceImg.position(row, col);
+                const vec3<double> terminus = DetectImg.position(row, col);
+                const vec3<double> ray_dir = (terminus - ray_pos).unit();
+
+                //Only the primitives whose extent encompasses this ray can be encountered.
+                const auto ray_coords = grid_coords(ray_pos);
+                ray_prims.clear();
+                for(const auto &n : tile_prims){
+                    const auto &p = primitives[n];
+                    if( (p.lo[0] <= ray_coords[0]) && (ray_coords[0] <= p.hi[0])
+                    &&  (p.lo[1] <= ray_coords[1]) && (ray_coords[1] <= p.hi[1]) ){
+                        ray_prims.push_back(&p);
+                    }
+                }
+
+                //Go until we get within certain distance or overshoot and the ray wants to backtrack, i.e., while the
+                // ray orientation is still downward-facing and the ray is still far away from the detector.
+                while(    (ray_dir.Dot( (terminus - ray_pos).unit() ) > 0.8 )
+                       && (ray_pos.distance(terminus) > std::max(RaydL, grid_margin)) ){
+
+                    ray_pos += ray_dir * RaydL;
+                    const auto midpoint = ray_pos - (ray_dir * RaydL * 0.5);
+
+                    //Search to see if ray is in an object.
+                    const auto w = ray_pos.Dot(GridNormal);
+                    const auto inside = std::any_of(std::begin(ray_prims), std::end(ray_prims),
+                                                    [&](const ray_cast_primitive *p) -> bool {
+                        if( (w < p->lo[2]) || (p->hi[2] < w) ) return false;
+                        return (p->is_sphere) ? (ray_pos.sq_dist(spheres[p->index]) < sq_radius)
+                                              : cylinders[p->index].Within_Cylindrical_Volume(ray_pos, CylinderRadius);
+                    });
+
+                    if(inside){
                         accumulated_length += RaydL;
 
                         //Find the dose at the half-way point.
-                        auto encompass_imgs = img_arr_ptr->imagecoll.get_images_which_encompass_point( midpoint );
+                        auto encompass_imgs = img_index->get_images_which_encompass_point( midpoint );
                         for(const auto &enc_img : encompass_imgs){
                             const auto pix_val = enc_img->value(midpoint, 0);
                             accumulated_doselength += RaydL * pix_val;
                         }
-                        skip = true;
-                        break;
                     }
                 }
 
-                if(!skip){
-                    for(const auto &acylinder : cylinders){
-                        if(acylinder.Within_Cylindrical_Volume(ray_pos, CylinderRadius)){
-                            accumulated_length += RaydL;
-
-                            //Find the dose at the half-way point.
-                            auto encompass_imgs = img_arr_ptr->imagecoll.get_images_which_encompass_point( midpoint );
-                            for(const auto &enc_img : encompass_imgs){
-                                const auto pix_val = enc_img->value(midpoint, 0);
-                                accumulated_doselength += RaydL * pix_val;
-                            }
-                            break;
-                        }
-                    }
-                }
+                //Deposit the dose in the images.
+                SourceImg.reference(row, col, 0) = static_cast<float>(accumulated_length);
+                DetectImg.reference(row, col, 0) = static_cast<float>(accumulated_doselength);
             }
-
-            //Deposit the dose in the images.
-            SourceImg.reference(row, col, 0) = static_cast<float>(accumulated_length);
-            DetectImg.reference(row, col, 0) = static_cast<float>(accumulated_doselength);
         }
-    }
+        progress.advance();
+    }, /*grain=*/ 1);
 
     // Save image maps to file.
     if(!WriteToFITS(SourceImg, LengthMapFileName)){
@@ -12,14 +12,16 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <vector>
 
 #include "../Contour_Boolean_Operations.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "ContourBooleanOperations.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorString.h"       //Needed for SplitStringToVector.
 
 #ifdef DCMA_USE_CGAL
 #else
@@ -53,6 +55,12 @@ OperationDoc OpArgDocContourBooleanOperations(){
     out.notes.emplace_back(
         "Only the common metadata between contours is propagated to the product contours."
     );
+
+    out.notes.emplace_back(
+        "Planes are processed in parallel. When several operations are requested, the sets 'A' and 'B' are only"
+        " constructed once per plane, so requesting several operations at once is faster than invoking this"
+        " operation repeatedly."
+    );
         
 
     out.args.emplace_back();
@@ -106,18 +114,36 @@ OperationDoc OpArgDocContourBooleanOperations(){
     out.args.emplace_back();
     out.args.back().name = "Operation";
     out.args.back().desc = "The Boolean operation (e.g., the function 'f') to perform on the sets of"
-                      " contour polygons 'A' and 'B'. 'Symmetric difference' is also known as 'XOR'.";
+                      " contour polygons 'A' and 'B'. 'Symmetric difference' is also known as 'XOR'."
+                      " Multiple operations can be performed at once by providing a comma-separated list;"
+                      " each produces a separate ROI.";
     out.args.back().default_val = "join";
     out.args.back().expected = true;
-    out.args.back().examples = { "intersection", "join", "difference", "symmetric_difference" };
-    out.args.back().samples = OpArgSamples::Exhaustive;
+    out.args.back().examples = { "intersection", "join", "difference", "symmetric_difference",
+                                 "join,intersection" };
 
     out.args.emplace_back();
     out.args.back().name = "OutputROILabel";
-    out.args.back().desc = "The label to attach to the ROI contour product of f(A,B).";
+    out.args.back().desc = "The label to attach to the ROI contour product of f(A,B)."
+                      " If multiple operations are requested, a comma-separated list with one label per"
+                      " operation must be provided.";
     out.args.back().default_val = "Boolean_result";
     out.args.back().expected = true;
-    out.args.back().examples = { "A+B", "A-B", "AuB", "AnB", "AxB", "A^B", "union", "xor", "combined", "body_without_spinal_cord" };
+    out.args.back().examples = { "A+B", "A-B", "AuB", "AnB", "AxB", "A^B", "union", "xor", "combined", "body_without_spinal_cord",
+                                 "AuB,AnB" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Engine";
+    out.args.back().desc = "The implementation used to compute the Boolean operations."
+                      " 'cgal' uses CGAL polygon sets, which handle degenerate inputs robustly."
+                      " 'fast' uses a floating-point polygon overlay that is typically much faster, but may"
+                      " produce slightly different results for nearly-degenerate inputs (e.g., contours that"
+                      " touch or nearly touch, or features narrower than roughly a billionth of the contours'"
+                      " extent).";
+    out.args.back().default_val = "cgal";
+    out.args.back().expected = true;
+    out.args.back().examples = { "cgal", "fast" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
 
     return out;
 }
@@ -136,7 +162,8 @@ Drover ContourBooleanOperations(const Drover& DICOM_data,
     const auto NormalizedROILabelRegexB = OptArgs.getValueStr("NormalizedROILabelRegexB").value();
 
     const auto Operation_str = OptArgs.getValueStr("Operation").value();
-    const auto OutputROILabel = OptArgs.getValueStr("OutputROILabel").value();
+    const auto OutputROILabel_str = OptArgs.getValueStr("OutputROILabel").value();
+    const auto Engine_str = OptArgs.getValueStr("Engine").value();
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto roiregexA = Compile_Regex(ROILabelRegexA);
@@ -150,21 +177,42 @@ Drover ContourBooleanOperations(const Drover& DICOM_data,
     const auto regex_difference = Compile_Regex("^diffe?r?e?n?c?e?$");
     const auto regex_symmdiff = Compile_Regex("^symme?t?r?i?c?_?d?i?f?f?e?r?e?n?c?e?$");
 
-    //Figure out which operation is desired.
-    ContourBooleanMethod op = ContourBooleanMethod::join;
-    if(std::regex_match(Operation_str,regex_join)){
-        op = ContourBooleanMethod::join;
-    }else if(std::regex_match(Operation_str,regex_intersection)){
-        op = ContourBooleanMethod::intersection;
-    }else if(std::regex_match(Operation_str,regex_difference)){
-        op = ContourBooleanMethod::difference;
-    }else if(std::regex_match(Operation_str,regex_symmdiff)){
-        op = ContourBooleanMethod::symmetric_difference;
+    const auto regex_cgal = Compile_Regex("^cg?a?l?$");
+    const auto regex_fast = Compile_Regex("^fa?s?t?$");
+
+    //Figure out which operations are desired.
+    std::vector<ContourBooleanMethod> ops;
+    for(const auto &Op_str : SplitStringToVector(Operation_str, ',', 'd')){
+        if(std::regex_match(Op_str,regex_join)){
+            ops.push_back(ContourBooleanMethod::join);
+        }else if(std::regex_match(Op_str,regex_intersection)){
+            ops.push_back(ContourBooleanMethod::intersection);
+        }else if(std::regex_match(Op_str,regex_difference)){
+            ops.push_back(ContourBooleanMethod::difference);
+        }else if(std::regex_match(Op_str,regex_symmdiff)){
+            ops.push_back(ContourBooleanMethod::symmetric_difference);
+        }else{
+            throw std::logic_error("Unanticipated Boolean operation request.");
+        }
+    }
+    const auto OutputROILabels = SplitStringToVector(OutputROILabel_str, ',', 'd');
+    if(ops.empty()){
+        throw std::invalid_argument("No Boolean operation was requested.");
+    }
+    if(OutputROILabels.size() != ops.size()){
+        throw std::invalid_argument("One output ROI label is required for each requested operation.");
+    }
+
+    ContourBooleanEngine engine = ContourBooleanEngine::cgal;
+    if(std::regex_match(Engine_str,regex_cgal)){
+        engine = ContourBooleanEngine::cgal;
+    }else if(std::regex_match(Engine_str,regex_fast)){
+        engine = ContourBooleanEngine::fast;
     }else{
-        throw std::logic_error("Unanticipated Boolean operation request.");
+        throw std::invalid_argument("Engine not understood.");
     }
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
 
     //Stuff references to all contours into a list. Remember that you can still address specific contours through
@@ -221,66 +269,67 @@ Drover ContourBooleanOperations(const Drover& DICOM_data,
     const double est_cont_spacing = (ucp.size() <= 1) ? fallback_spacing : cont_sep_range / static_cast<double>(ucp.size() - 1);
     const double est_cont_thickness = 0.5005 * est_cont_spacing; // Made slightly thicker to avoid gaps.
 
-    //For identifying duplicate vertices later.
+    //Remove duplicate vertices once, up-front.
     const auto verts_equal_F = [](const vec3<double> &vA, const vec3<double> &vB) -> bool {
         return ( vA.sq_dist(vB) < std::pow(0.01,2.0) );
     };
+    for(auto &cc : cc_A_B){
+        for(auto &cop : cc.get().contours){
+            cop.Remove_Sequential_Duplicate_Points(verts_equal_F);
+            cop.Remove_Needles(verts_equal_F);
+        }
+    }
 
     // For each plane, pack the shuttles with (only) the relevant contours.
-    contour_collection<double> cc_new;
-    for(const auto &aplane : ucp){
-        std::list<std::reference_wrapper<contour_of_points<double>>> A;
-        std::list<std::reference_wrapper<contour_of_points<double>>> B;
-
-        for(auto &cc : cc_A){
+    const auto pack = [&](const plane<double> &aplane,
+                          std::list<std::reference_wrapper<contour_collection<double>>> &ccs,
+                          std::list<std::reference_wrapper<contour_of_points<double>>> &shuttle){
+        for(auto &cc : ccs){
             for(auto &cop : cc.get().contours){
                 //Ignore contours that are not 'on' the specified plane.
                 // We give planes a thickness to help determine coincidence.
-                cop.Remove_Sequential_Duplicate_Points(verts_equal_F);
-                cop.Remove_Needles(verts_equal_F);
                 if(cop.points.empty()) continue;
                 const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
                 if(dist_to_plane > est_cont_thickness) continue;
 
                 //Pack the contour into the shuttle.
-                A.emplace_back(std::ref(cop));
-            }
-        }
-        for(auto &cc : cc_B){
-            for(auto &cop : cc.get().contours){
-                cop.Remove_Sequential_Duplicate_Points(verts_equal_F);
-                cop.Remove_Needles(verts_equal_F);
-                if(cop.points.empty()) continue;
-                const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
-                if(dist_to_plane > est_cont_thickness) continue;
-
-                B.emplace_back(std::ref(cop));
+                shuttle.emplace_back(std::ref(cop));
             }
         }
+    };
+    std::vector<contour_boolean_job> jobs;
+    for(const auto &aplane : ucp){
+        jobs.push_back( contour_boolean_job{ aplane, {}, {} } );
+        pack(aplane, cc_A, jobs.back().A);
+        pack(aplane, cc_B, jobs.back().B);
+    }
 
-        //Perform the operation.
-        //FUNCINFO("About to perform boolean operation. A and B have " << A.size() << " and " << B.size() << " elements, respectively");
-        auto cc = ContourBoolean(aplane, A, B, op);
+    //Perform the operations on all planes.
+    auto results = ContourBooleanBatch(jobs, ops, ContourBooleanMethod::join, engine);
 
+    for(size_t i = 0; i < ops.size(); ++i){
         //Insert any contours created into a holding contour_collection.
-        cc_new.contours.splice(cc_new.contours.end(), std::move(cc.contours));
-    }
+        contour_collection<double> cc_new;
+        for(auto &r : results){
+            cc_new.contours.splice(cc_new.contours.end(), std::move(r.at(i).contours));
+        }
 
-    //Attach the requested metadata.
-    cc_new.Insert_Metadata("ROIName", OutputROILabel);
-    cc_new.Insert_Metadata("NormalizedROIName", X(OutputROILabel));
-    cc_new.Insert_Metadata("ROINumber", "999");
-    cc_new.Insert_Metadata("MinimumSeparation", std::to_string(est_cont_spacing));
-
-    // Insert it into the Contour_Data.
-    FUNCINFO("Boolean operation created " << cc_new.contours.size() << " contours");
-    if(cc_new.contours.empty()){
-        FUNCWARN("ROI was not added because it is empty");
-        // Note: While it is valid to have no resulting contours (e.g., the difference operation), having zero contours
-        // in the collection is not well-defined in many situations and will potentially cause issues in other operations.
-        // So the result is not propagated out at this time.
-    }else{
-        DICOM_data.contour_data->ccs.emplace_back(cc_new);
+        //Attach the requested metadata.
+        cc_new.Insert_Metadata("ROIName", OutputROILabels[i]);
+        cc_new.Insert_Metadata("NormalizedROIName", X(OutputROILabels[i]));
+        cc_new.Insert_Metadata("ROINumber", "999");
+        cc_new.Insert_Metadata("MinimumSeparation", std::to_string(est_cont_spacing));
+
+        // Insert it into the Contour_Data.
+        FUNCINFO("Boolean operation created " << cc_new.contours.size() << " contours");
+        if(cc_new.contours.empty()){
+            FUNCWARN("ROI was not added because it is empty");
+            // Note: While it is valid to have no resulting contours (e.g., the difference operation), having zero contours
+            // in the collection is not well-defined in many situations and will potentially cause issues in other operations.
+            // So the result is not propagated out at this time.
+        }else{
+            DICOM_data.contour_data->ccs.emplace_back(cc_new);
+        }
     }
 
     return DICOM_data;
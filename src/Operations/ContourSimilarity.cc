@@ -7,6 +7,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <regex>
 #include <stdexcept>
 #include <string>    
 #include <vector>
@@ -21,11 +22,10 @@
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 #include "YgorFilesDirs.h"
 
-#include "Explicator.h"
-
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "../YgorImages_Functors/Compute/Contour_Similarity.h"
+#include "../YgorImages_Functors/ROI_Similarity.h"
 
 #include "ContourSimilarity.h"
 
@@ -35,11 +35,25 @@ OperationDoc OpArgDocContourSimilarity(){
     out.desc = 
         "This operation estimates the similarity or overlap between two sets of contours."
         " The comparison is based on point samples. It is useful for comparing contouring styles."
-        " This operation currently reports Dice and Jaccard similarity metrics.";
+        " This operation currently reports Dice and Jaccard similarity metrics, and optionally the Hausdorff"
+        " distance, 95th percentile Hausdorff distance, and mean surface distance.";
+
+    out.notes.emplace_back(
+        "ROIs are distinguished by name. Every ROI selected by the 'A' selectors is compared with every"
+        " differently-named ROI selected by the 'B' selectors, and each pair is reported once."
+        " Every ROI is rasterized only once, so comparing many ROIs in a single invocation is much faster than"
+        " invoking this operation for each pair."
+    );
 
     out.notes.emplace_back(
         "This routine requires an image grid, which is used to control where the contours are sampled."
-        " Images are not modified."
+        " The images must form a regular rectilinear grid that covers all ROIs, and should be at least as fine"
+        " as the contours. Images are not modified."
+    );
+
+    out.notes.emplace_back(
+        "Surface distances are measured between the centres of surface voxels, i.e., voxels within an ROI that have"
+        " a face-adjacent neighbour outside of it. They are computed exactly at the resolution of the image grid."
     );
 
     out.args.emplace_back();
@@ -67,6 +81,14 @@ OperationDoc OpArgDocContourSimilarity(){
     out.args.back().name = "NormalizedROILabelRegexB";
     out.args.back().default_val = ".*";
 
+    out.args.emplace_back();
+    out.args.back().name = "SurfaceDistances";
+    out.args.back().desc = "Whether to compute surface distance metrics, which requires a distance transform per ROI.";
+    out.args.back().default_val = "true";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     out.args.emplace_back();
     out.args.back().name = "FileName";
     out.args.back().desc = "A filename (or full path) in which to append similarity data generated by this routine."
@@ -101,10 +123,14 @@ Drover ContourSimilarity(Drover DICOM_data,
     const auto NormalizedROILabelRegexB = OptArgs.getValueStr("NormalizedROILabelRegexB").value();
     const auto ROILabelRegexB = OptArgs.getValueStr("ROILabelRegexB").value();
 
+    const auto SurfaceDistancesStr = OptArgs.getValueStr("SurfaceDistances").value();
+
     auto FileName = OptArgs.getValueStr("FileName").value();
     const auto UserComment = OptArgs.getValueStr("UserComment");
     //-----------------------------------------------------------------------------------------------------------------
-    Explicator X(FilenameLex);
+    const auto regex_true = Compile_Regex("^tr?u?e?$");
+    const bool SurfaceDistances = std::regex_match(SurfaceDistancesStr, regex_true);
+    const lexicon_translator X(FilenameLex);
 
     auto cc_all = All_CCs( DICOM_data );
 
@@ -113,18 +139,12 @@ Drover ContourSimilarity(Drover DICOM_data,
     if(cc_A.empty()){
         throw std::invalid_argument("No contours selected (A). Cannot continue.");
     }
-    if(cc_A.size() != 1){
-        throw std::invalid_argument("Multiple contour collections selected (A). Refusing to continue.");
-    }
 
     auto cc_B = Whitelist( cc_all, { { "ROIName", ROILabelRegexB },
                                      { "NormalizedROIName", NormalizedROILabelRegexB } } );
     if(cc_B.empty()){
         throw std::invalid_argument("No contours selected (B). Cannot continue.");
     }
-    if(cc_B.size() != 1){
-        throw std::invalid_argument("Multiple contour collections selected (B). Refusing to continue.");
-    }
 
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
@@ -135,14 +155,22 @@ Drover ContourSimilarity(Drover DICOM_data,
         throw std::invalid_argument("Multiple image arrays selected. Cannot continue.");
     }
     auto iap_it = IAs.front();
-    ComputeContourSimilarityUserData ud;
-    ud.Clear();
-    if(!(*iap_it)->imagecoll.Compute_Images( ComputeContourSimilarity, { },
-                                           { cc_A.front(), cc_B.front() }, &ud )){
-        throw std::runtime_error("Unable to compute contour similarity metrics. Cannot continue.");
+
+    roi_similarity_options opts;
+    opts.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
+    opts.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+    opts.surface_distances = SurfaceDistances;
+    const auto similarities = Compute_ROI_Similarities((*iap_it)->imagecoll, cc_A, cc_B, opts);
+    if(similarities.empty()){
+        throw std::invalid_argument("No pairs of distinct ROIs selected. Cannot continue.");
+    }
+    for(const auto &s : similarities){
+        FUNCINFO("Dice coefficient(" << s.ROIName_A << "," << s.ROIName_B << ") = " << s.dice);
+        FUNCINFO("Jaccard coefficient(" << s.ROIName_A << "," << s.ROIName_B << ") = " << s.jaccard);
+        if(SurfaceDistances){
+            FUNCINFO("Hausdorff distance(" << s.ROIName_A << "," << s.ROIName_B << ") = " << s.hausdorff);
+        }
     }
-    FUNCINFO("Dice coefficient(A,B) = " << ud.Dice_Coefficient());
-    FUNCINFO("Jaccard coefficient(A,B) = " << ud.Jaccard_Coefficient());
 
     // Attempt to identify the patient for reporting purposes.
     std::string patient_ID;
@@ -158,20 +186,6 @@ Drover ContourSimilarity(Drover DICOM_data,
         patient_ID = "unknown_patient";
     }
 
-    std::string ROINameA;
-    if( auto o = cc_A.front().get().contours.front().GetMetadataValueAs<std::string>("ROIName") ){
-        ROINameA = o.value();
-    }else{
-        ROINameA = "unknown_roi";
-    }
-
-    std::string ROINameB;
-    if( auto o = cc_B.front().get().contours.front().GetMetadataValueAs<std::string>("ROIName") ){
-        ROINameB = o.value();
-    }else{
-        ROINameB = "unknown_roi";
-    }
-
     //Report the findings. 
     FUNCINFO("Attempting to claim a mutex");
 
@@ -199,18 +213,26 @@ Drover ContourSimilarity(Drover DICOM_data,
                << "ROInameB,"
                << "NormalizedROInameB,"
                << "DiceSimilarity,"
-               << "JaccardSimilarity"
+               << "JaccardSimilarity,"
+               << "HausdorffDistance,"
+               << "HausdorffDistance95,"
+               << "MeanSurfaceDistance"
+               << std::endl;
+        }
+        for(const auto &s : similarities){
+            FO << UserComment.value_or("") << ","
+               << patient_ID        << ","
+               << s.ROIName_A       << ","
+               << X(s.ROIName_A)    << ","
+               << s.ROIName_B       << ","
+               << X(s.ROIName_B)    << ","
+               << s.dice            << ","
+               << s.jaccard         << ","
+               << s.hausdorff       << ","
+               << s.hausdorff_95    << ","
+               << s.mean_surface
                << std::endl;
         }
-        FO << UserComment.value_or("") << ","
-           << patient_ID        << ","
-           << ROINameA          << ","
-           << X(ROINameA)       << ","
-           << ROINameB          << ","
-           << X(ROINameB)       << ","
-           << ud.Dice_Coefficient() << ","
-           << ud.Jaccard_Coefficient()
-           << std::endl;
         FO.flush();
         FO.close();
 
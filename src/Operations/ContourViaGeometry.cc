@@ -22,8 +22,7 @@
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
-#include "Explicator.h"       //Needed for Explicator class.
-
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
@@ -96,7 +95,7 @@ Drover ContourViaGeometry(Drover DICOM_data,
                           const std::map<std::string, std::string>&
                           /*InvocationMetadata*/,
                           const std::string& FilenameLex){
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ROILabel = OptArgs.getValueStr("ROILabel").value();
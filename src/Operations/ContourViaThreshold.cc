@@ -2,8 +2,12 @@
 
 #include <asio.hpp>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <fstream>
+#include <functional>
 #include <iterator>
 #include <list>
 #include <map>
@@ -16,11 +20,12 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Distribution_Sketch.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "ContourViaThreshold.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -28,11 +33,143 @@
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
 #ifdef DCMA_USE_CGAL
-#else
-    #error "Attempted to compile without CGAL support, which is required."
+    #include "../Surface_Meshes.h"
 #endif
 
-#include "../Surface_Meshes.h"
+
+namespace {
+
+// Extracts closed iso-contours from a single image with marching squares.
+//
+// The field is sampled at pixel centres and is negative (or zero) inside the ROI. The image is padded with a ring of
+// exterior samples, mirrored so that contours around interior pixels on the border coincide with the image edge, which
+// guarantees every contour is closed. Segments are oriented with the interior on their left, so outer boundaries run
+// counter-clockwise and holes clockwise when viewed along the image normal (row_unit x col_unit). Ambiguous (saddle)
+// cells are resolved using the average of the four corners.
+//
+// Every grid edge adjoins two cells; a crossing on it is the start of a segment in exactly one cell and the
+// end of a segment in the other. Segments are therefore joined into loops using a table keyed on edges, in time linear
+// in the number of pixels.
+std::list<contour_of_points<double>>
+Marching_Squares(const planar_image<float,double> &img,
+                 long int chnl,
+                 const std::function<double(float)> &field){
+    const int64_t R = img.rows;
+    const int64_t C = img.columns;
+    const int64_t Rp = R + 2; // Including padding.
+    const int64_t Cp = C + 2;
+
+    // Non-finite values are clamped so interpolation remains well-defined. NaNs are considered exterior.
+    const double big = 1.0E30;
+    std::vector<float> F(static_cast<size_t>(Rp * Cp));
+    const auto node = [Cp](int64_t r, int64_t c) -> int64_t { return r * Cp + c; };
+    for(int64_t r = 0; r < R; ++r){
+        for(int64_t c = 0; c < C; ++c){
+            const double f = field(img.value(r, c, chnl));
+            F[node(r + 1, c + 1)] = static_cast<float>( std::isnan(f) ? big : std::clamp(f, -big, big) );
+        }
+    }
+    for(int64_t r = 0; r < Rp; ++r){
+        for(int64_t c = 0; c < Cp; ++c){
+            if( (0 < r) && (r < (Rp - 1)) && (0 < c) && (c < (Cp - 1)) ) continue;
+            const auto f = F[node(std::clamp<int64_t>(r, 1, R), std::clamp<int64_t>(c, 1, C))];
+            F[node(r, c)] = std::max(std::abs(f), std::numeric_limits<float>::min());
+        }
+    }
+
+    // Edge (r,c,0) joins nodes (r,c) and (r,c+1); edge (r,c,1) joins nodes (r,c) and (r+1,c).
+    const auto edge = [Cp](int64_t r, int64_t c, int64_t dir) -> int64_t { return 2 * (r * Cp + c) + dir; };
+    constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+    if(static_cast<int64_t>(none) <= 2 * Rp * Cp){
+        throw std::invalid_argument("Image is too large for marching squares. Cannot continue.");
+    }
+    std::vector<uint32_t> next(static_cast<size_t>(2 * Rp * Cp), none);
+    std::vector<uint32_t> starts;
+
+    for(int64_t r = 0; r < (Rp - 1); ++r){
+        for(int64_t c = 0; c < (Cp - 1); ++c){
+            // Corners and edges in cyclic order. Edge k runs from corner k to corner k+1.
+            const float f[4] = { F[node(r, c)], F[node(r, c + 1)], F[node(r + 1, c + 1)], F[node(r + 1, c)] };
+            const bool in[4] = { (f[0] <= 0.0f), (f[1] <= 0.0f), (f[2] <= 0.0f), (f[3] <= 0.0f) };
+            if( (in[0] == in[1]) && (in[1] == in[2]) && (in[2] == in[3]) ) continue;
+            const int64_t e[4] = { edge(r, c, 0), edge(r, c + 1, 1), edge(r + 1, c, 0), edge(r, c, 1) };
+
+            // Crossings from interior to exterior are segment ends, and from exterior to interior are segment starts.
+            int64_t ends[2];
+            int64_t begins[2];
+            int64_t N_ends = 0;
+            int64_t N_begins = 0;
+            for(int64_t k = 0; k < 4; ++k){
+                const auto l = (k + 1) % 4;
+                if(in[k] && !in[l]) ends[N_ends++] = k;
+                if(!in[k] && in[l]) begins[N_begins++] = k;
+            }
+
+            if(N_begins == 1){
+                next[e[begins[0]]] = static_cast<uint32_t>(e[ends[0]]);
+                starts.push_back(static_cast<uint32_t>(e[begins[0]]));
+            }else{
+                // A saddle. If the centre is interior, the exterior corners are cut off, joining each start to the
+                // preceding end. Otherwise the interior corners are cut off, joining each start to the following end.
+                const bool centre_in = ( (static_cast<double>(f[0]) + f[1] + f[2] + f[3]) <= 0.0 );
+                for(int64_t b = 0; b < 2; ++b){
+                    const auto k = begins[b];
+                    const auto k_prev = (k + 3) % 4;
+                    const auto k_next = (k + 1) % 4;
+                    const auto x = centre_in ? ( (ends[0] == k_prev) ? ends[0] : ends[1] )
+                                             : ( (ends[0] == k_next) ? ends[0] : ends[1] );
+                    next[e[k]] = static_cast<uint32_t>(e[x]);
+                    starts.push_back(static_cast<uint32_t>(e[k]));
+                }
+            }
+        }
+    }
+
+    // Crossings are interpolated along edges between the adjoining pixel centres.
+    const auto origin = img.position(0, 0) - img.row_unit * img.pxl_dx - img.col_unit * img.pxl_dy;
+    const auto position = [&](int64_t r, int64_t c) -> vec3<double> {
+        return origin + img.row_unit * (img.pxl_dx * static_cast<double>(r))
+                      + img.col_unit * (img.pxl_dy * static_cast<double>(c));
+    };
+    const auto crossing = [&](int64_t id) -> vec3<double> {
+        const auto dir = id % 2;
+        const auto n = id / 2;
+        const auto r = n / Cp;
+        const auto c = n % Cp;
+        const auto r2 = r + dir;
+        const auto c2 = c + (1 - dir);
+        const double f_A = F[node(r, c)];
+        const double f_B = F[node(r2, c2)];
+        const double t = std::clamp(f_A / (f_A - f_B), 0.0, 1.0);
+        return position(r, c) * (1.0 - t) + position(r2, c2) * t;
+    };
+
+    std::list<contour_of_points<double>> out;
+    for(const auto s : starts){
+        if(next[s] == none) continue; // Already part of a loop.
+
+        contour_of_points<double> cop;
+        cop.closed = true;
+        auto id = s;
+        do{
+            const auto p = crossing(id);
+            if(cop.points.empty() || (cop.points.back() != p)) cop.points.emplace_back(p);
+            const auto n = next[id];
+            next[id] = none;
+            id = n;
+            if(id == none){
+                throw std::logic_error("Marching squares produced an open contour. Cannot continue.");
+            }
+        }while(id != s);
+
+        // Degenerate loops (e.g., around isolated samples lying exactly on the threshold) are discarded.
+        if( (1 < cop.points.size()) && (cop.points.back() == cop.points.front()) ) cop.points.pop_back();
+        if(3 <= cop.points.size()) out.emplace_back(std::move(cop));
+    }
+    return out;
+}
+
+} // namespace
 
 
 OperationDoc OpArgDocContourViaThreshold(){
@@ -41,9 +178,10 @@ OperationDoc OpArgDocContourViaThreshold(){
 
     out.desc = 
         "This operation constructs ROI contours using images and pixel/voxel value thresholds."
-        " There are two methods of contour generation available:"
+        " There are three methods of contour generation available:"
         " a simple binary method in which voxels are either fully in or fully out of the contour,"
-        " and a method based on marching cubes that will provide smoother contours."
+        " a method based on marching cubes that will provide smoother contours,"
+        " and a method based on marching squares that provides smooth contours quickly."
         " The marching cubes method does **not** construct a full surface mesh; rather each"
         " individual image slice has their own mesh constructed in parallel.";
         
@@ -63,6 +201,14 @@ OperationDoc OpArgDocContourViaThreshold(){
         " the computational penalty. The marching cubes approach will properly handle 'pinches' and contours should"
         " all be topologically valid."
     );
+
+    out.notes.emplace_back(
+        "The marching squares method processes all images in parallel and does not require a surface mesh,"
+        " so it is suitable for large images (e.g., whole-body CT). Contours are consistently oriented:"
+        " outer boundaries are counter-clockwise and holes are clockwise with respect to the image orientation,"
+        " and 'pinches' are resolved consistently. Contours lie between pixel centres and are closed along the"
+        " image boundary."
+    );
         
 
     out.args.emplace_back();
@@ -115,17 +261,22 @@ OperationDoc OpArgDocContourViaThreshold(){
 
     out.args.emplace_back();
     out.args.back().name = "Method";
-    out.args.back().desc = "There are currently two supported methods for generating contours:"
+    out.args.back().desc = "There are currently three supported methods for generating contours:"
                            " (1) a simple (and fast) binary inclusivity checker, that simply checks if a voxel is within"
-                           " the ROI by testing the value at the voxel centre, and (2) a robust (but slow) method based"
-                           " on marching cubes. The binary method is fast, but produces extremely jagged contours."
+                           " the ROI by testing the value at the voxel centre, (2) a robust (but slow) method based"
+                           " on marching cubes, and (3) a robust and fast method based on marching squares."
+                           " The binary method is fast, but produces extremely jagged contours."
                            " It may also have problems with 'pinches' and topological consistency."
                            " The marching method is more robust and should reliably produce contours for even"
-                           " the most complicated topologies, but is considerably slower than the binary method.";
+                           " the most complicated topologies, but is considerably slower than the binary method."
+                           " The squares method interpolates the threshold crossing between adjacent voxel centres,"
+                           " producing smooth and topologically valid contours at a speed comparable to the binary"
+                           " method. The marching method requires CGAL support.";
     out.args.back().default_val = "binary";
     out.args.back().expected = true;
     out.args.back().examples = { "binary",
-                                 "marching" };
+                                 "marching",
+                                 "squares" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
     
@@ -154,7 +305,7 @@ Drover ContourViaThreshold(Drover DICOM_data,
                            /*InvocationMetadata*/,
                            const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ROILabel = OptArgs.getValueStr("ROILabel").value();
@@ -180,6 +331,7 @@ Drover ContourViaThreshold(Drover DICOM_data,
 
     const auto binary_regex = Compile_Regex("^bi?n?a?r?y?$");
     const auto marching_regex = Compile_Regex("^ma?r?c?h?i?n?g?$");
+    const auto squares_regex = Compile_Regex("^sq?u?a?r?e?s?$");
 
     const auto TrueRegex = Compile_Regex("^tr?u?e?$");
 
@@ -199,10 +351,6 @@ Drover ContourViaThreshold(Drover DICOM_data,
     for(auto & iap_it : IAs){
         const long int img_count = (*iap_it)->imagecoll.images.size();
 
-        asio_thread_pool tp;
-        std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
-        long int completed = 0;
-
         //Determine the bounds in terms of pixel-value thresholds.
         auto cl = Lower; // Will be replaced if percentages/percentiles requested.
         auto cu = Upper; // Will be replaced if percentages/percentiles requested.
@@ -230,8 +378,9 @@ Drover ContourViaThreshold(Drover DICOM_data,
                          return;
                     });
                 }
-                if(Lower_is_Ptile) cl = Stats::Percentile(pixel_vals, Lower / 100.0);
-                if(Upper_is_Ptile) cu = Stats::Percentile(pixel_vals, Upper / 100.0);
+                const sorted_quantiles<float> ptiles(std::move(pixel_vals));
+                if(Lower_is_Ptile) cl = ptiles.quantile(Lower / 100.0);
+                if(Upper_is_Ptile) cu = ptiles.quantile(Upper / 100.0);
             }
         }
         if(cl > cu){
@@ -244,11 +393,39 @@ Drover ContourViaThreshold(Drover DICOM_data,
             return (cl <= p) && (p <= cu);
         };
 
+        //The equivalent scalar field for marching squares, which is non-positive exactly where the oracle is true.
+        std::function<double(float)> field;
+        if(std::isfinite(cl) && std::isfinite(cu)){
+            const double midpoint = (cl + cu) * 0.5;
+            const double half_width = (cu - cl) * 0.5;
+            field = [=](float p) -> double { return std::abs(p - midpoint) - half_width; };
+        }else if(std::isfinite(cl)){
+            field = [=](float p) -> double { return cl - p; };
+        }else if(std::isfinite(cu)){
+            field = [=](float p) -> double { return p - cu; };
+        }else{
+            field = [=](float p) -> double { return pixel_oracle(p) ? -1.0 : 1.0; };
+        }
+
+        std::vector<const planar_image<float,double>*> imgs;
         for(const auto &animg : (*iap_it)->imagecoll.images){
             if( (animg.rows < 1) || (animg.columns < 1) || (Channel >= animg.channels) ){
                 throw std::runtime_error("Image or channel is empty -- cannot contour via thresholds.");
             }
-            tp.submit_task([&]() -> void {
+            imgs.emplace_back( &animg );
+        }
+
+        // Contours are buffered per image and merged in image order afterward, so workers never contend for the
+        // collection and the output does not depend on scheduling.
+        std::vector<std::list<contour_of_points<double>>> slice_contours(img_count);
+        progress_tracker progress("ContourViaThreshold", img_count,
+                                  [](long int completed, long int total, double) -> void {
+            FUNCINFO("Completed " << completed << " of " << total
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+        });
+
+        parallel_for(0, img_count, [&](long int i) -> void {
+                const auto &animg = *(imgs[i]);
 
                 // ---------------------------------------------------
                 // The binary inclusivity method.
@@ -388,19 +565,12 @@ Drover ContourViaThreshold(Drover DICOM_data,
                     */
 
 
-                    //Save the contours and print some information to screen.
-                    {
-                        std::lock_guard<std::mutex> lock(saver_printer);
-                        DICOM_data.contour_data->ccs.back().contours.splice(DICOM_data.contour_data->ccs.back().contours.end(), copl);
-
-                        ++completed;
-                        FUNCINFO("Completed " << completed << " of " << img_count
-                              << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-                    }
+                    slice_contours[i].splice(slice_contours[i].end(), copl);
 
                 // ---------------------------------------------------
                 // The marching cubes method.
                 }else if(std::regex_match(MethodStr, marching_regex)){
+#ifdef DCMA_USE_CGAL
 
                     //Prepare a mask image for contouring.
                     auto mask = animg;
@@ -505,23 +675,37 @@ Drover ContourViaThreshold(Drover DICOM_data,
                     }
                     */
 
-                    // Save the contours and print some information to screen.
-                    {
-                        std::lock_guard<std::mutex> lock(saver_printer);
-                        DICOM_data.contour_data->ccs.back().contours.splice(DICOM_data.contour_data->ccs.back().contours.end(),
-                                                                            lcc.contours);
+                    slice_contours[i].splice(slice_contours[i].end(), lcc.contours);
+#else
+                    throw std::invalid_argument("The marching cubes method requires CGAL support. Cannot continue.");
+#endif // DCMA_USE_CGAL
 
-                        ++completed;
-                        FUNCINFO("Completed " << completed << " of " << img_count
-                              << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+                // ---------------------------------------------------
+                // The marching squares method.
+                }else if(std::regex_match(MethodStr, squares_regex)){
+                    auto copl = Marching_Squares(animg, Channel, field);
+                    for(auto &cop : copl){
+                        cop.metadata["ROIName"] = ROILabel;
+                        cop.metadata["NormalizedROIName"] = NormalizedROILabel;
+                        cop.metadata["Description"] = "Contoured via threshold ("_s + LowerStr
+                                                     + " <= pixel_val <= " + UpperStr + ")";
+                        cop.metadata["MinimumSeparation"] = std::to_string(MinimumSeparation);
+                        cop.metadata["ROINumber"] = std::to_string(10000); // TODO: find highest existing and ++ it.
+                        for(const auto &key : { "StudyInstanceUID", "FrameOfReferenceUID" }){
+                            if(animg.metadata.count(key) != 0) cop.metadata[key] = animg.metadata.at(key);
+                        }
                     }
+                    slice_contours[i].splice(slice_contours[i].end(), copl);
 
                 }else{
                     throw std::invalid_argument("The contouring method is not understood. Cannot continue.");
                 }
 
-            }); // thread pool task closure.
-        }
+                progress.advance();
+        }, 1);
+
+        auto &contours = DICOM_data.contour_data->ccs.back().contours;
+        for(auto &copl : slice_contours) contours.splice(contours.end(), copl);
     }
 
     return DICOM_data;
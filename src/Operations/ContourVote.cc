@@ -1,20 +1,25 @@
 //ContourVote.cc - A part of DICOMautomaton 2018. Written by hal clark.
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>            //Needed for exit() calls.
 #include <optional>
 #include <functional>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <utility>
+#include <vector>
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "ContourVote.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 
@@ -132,7 +137,7 @@ Drover ContourVote(const Drover& DICOM_data,
                    /*InvocationMetadata*/,
                    const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto WinnerROILabel = OptArgs.getValueStr("WinnerROILabel").value();
@@ -180,48 +185,38 @@ Drover ContourVote(const Drover& DICOM_data,
         FUNCWARN("No contours participated, so no contours won");
     }
         
+    // Each contour's score is evaluated once up-front, rather than within every comparison.
+    std::function<double(const contour_of_points<double> &)> score;
     if(!std::isnan( Area )){
-        cop_ROIs.sort( [&](const std::reference_wrapper<contour_of_points<double>> A,
-                           const std::reference_wrapper<contour_of_points<double>> B ){
-                               const auto AA = std::abs(A.get().Get_Signed_Area());
-                               const auto BA = std::abs(B.get().Get_Signed_Area());
-                               return std::abs(Area - AA) < std::abs(Area - BA);
-                      });
+        score = [&](const contour_of_points<double> &c){ return std::abs(Area - std::abs(c.Get_Signed_Area())); };
     }else if(!std::isnan( Perimeter )){
-        cop_ROIs.sort( [&](const std::reference_wrapper<contour_of_points<double>> A,
-                           const std::reference_wrapper<contour_of_points<double>> B ){
-                               const auto AP = A.get().Perimeter();
-                               const auto BP = B.get().Perimeter();
-                               return std::abs(Perimeter - AP) < std::abs(Perimeter - BP);
-                      });
+        score = [&](const contour_of_points<double> &c){ return std::abs(Perimeter - c.Perimeter()); };
     }else if(!std::isnan( CentroidX )){
-        cop_ROIs.sort( [&](const std::reference_wrapper<contour_of_points<double>> A,
-                           const std::reference_wrapper<contour_of_points<double>> B ){
-                               const auto AX = A.get().Centroid().x;
-                               const auto BX = B.get().Centroid().x;
-                               return std::abs(CentroidX - AX) < std::abs(CentroidX - BX);
-                      });
+        score = [&](const contour_of_points<double> &c){ return std::abs(CentroidX - c.Centroid().x); };
     }else if(!std::isnan( CentroidY )){
-        cop_ROIs.sort( [&](const std::reference_wrapper<contour_of_points<double>> A,
-                           const std::reference_wrapper<contour_of_points<double>> B ){
-                               const auto AY = A.get().Centroid().y;
-                               const auto BY = B.get().Centroid().y;
-                               return std::abs(CentroidY - AY) < std::abs(CentroidY - BY);
-                      });
+        score = [&](const contour_of_points<double> &c){ return std::abs(CentroidY - c.Centroid().y); };
     }else if(!std::isnan( CentroidZ )){
-        cop_ROIs.sort( [&](const std::reference_wrapper<contour_of_points<double>> A,
-                           const std::reference_wrapper<contour_of_points<double>> B ){
-                               const auto AZ = A.get().Centroid().z;
-                               const auto BZ = B.get().Centroid().z;
-                               return std::abs(CentroidZ - AZ) < std::abs(CentroidZ - BZ);
-                      });
+        score = [&](const contour_of_points<double> &c){ return std::abs(CentroidZ - c.Centroid().z); };
     }
 
+    const std::vector<std::reference_wrapper<contour_of_points<double>>> candidates(std::begin(cop_ROIs),
+                                                                                   std::end(cop_ROIs));
+    const auto N = static_cast<long int>(candidates.size());
+    const auto winners = std::min<long int>(N, WinnerCount);
+
+    // Ties are broken by the original order, so without a criterion the first contours win.
+    // Contours whose score cannot be evaluated are ranked last.
+    std::vector<std::pair<double, long int>> ranked(static_cast<size_t>(N));
+    parallel_for(0, N, [&](long int i) -> void {
+        const auto s = (score) ? score(candidates[i].get()) : 0.0;
+        ranked[i] = { std::isnan(s) ? std::numeric_limits<double>::infinity() : s, i };
+    });
+    std::partial_sort(std::begin(ranked), std::next(std::begin(ranked), winners), std::end(ranked));
+
     //Create a new contour collection from the winning contours.
     contour_collection<double> cc_new;
-    for(auto & cop : cop_ROIs){
-        if(cc_new.contours.size() >= WinnerCount) break;
-        cc_new.contours.emplace_back(cop.get());
+    for(long int i = 0; i < winners; ++i){
+        cc_new.contours.emplace_back(candidates[ranked[i].second].get());
     }
 
     //Attach the requested metadata.
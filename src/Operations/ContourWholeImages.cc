@@ -11,10 +11,10 @@
 #include <stdexcept>
 #include <string>    
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "ContourWholeImages.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 
@@ -74,7 +74,7 @@ Drover ContourWholeImages(Drover DICOM_data,
 
     //-----------------------------------------------------------------------------------------------------------------
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
     const auto NormalizedROILabel = X(ROILabel);
     const long int ROINumber = 10001; // TODO: find highest existing and ++ it.
 
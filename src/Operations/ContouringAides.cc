@@ -11,6 +11,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Logarithmic_Pixel_Scale.h"
 #include "ContouringAides.h"
 #include "YgorImages.h"
@@ -45,9 +46,9 @@ Drover ContouringAides(Drover DICOM_data,
         DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>( *img_arr ) );
         log_scaled_img_arrays.emplace_back( DICOM_data.image_data.back() );
 
-        if(!log_scaled_img_arrays.back()->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                                    LogScalePixels,
-                                                                    {}, {} )){
+        if(!Process_Images_Balanced( log_scaled_img_arrays.back()->imagecoll,
+                                     LogScalePixels,
+                                     {}, {} )){
             FUNCERR("Unable to perform logarithmic pixel scaling");
         }
     }
@@ -17,9 +17,8 @@
 #include "YgorMathIOOBJ.h"
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 
-#include "Explicator.h"
-
 #include "../Contour_Boolean_Operations.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Simple_Meshing.h"
@@ -106,7 +105,7 @@ Drover ConvertContoursToMeshes(Drover DICOM_data,
                                const std::map<std::string, std::string>&,
                                const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
@@ -16,11 +16,11 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "ConvertContoursToPoints.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -93,7 +93,7 @@ Drover ConvertContoursToPoints(Drover DICOM_data,
                                const std::map<std::string, std::string>& /*InvocationMetadata*/,
                                const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
@@ -118,35 +118,36 @@ Drover ConvertContoursToPoints(Drover DICOM_data,
     //Construct a destination for the point clouds.
     DICOM_data.point_data.emplace_back( std::make_unique<Point_Cloud>() );
 
-    if( std::regex_match(MethodStr, regex_vertices) ){
-        // Insert all vertices into the point cloud.
-        for(auto & cc_refw : cc_ROIs){
-            for(const auto & c : cc_refw.get().contours){
-                for(const auto & v : c.points){
-                    DICOM_data.point_data.back()->pset.points.emplace_back( v );
-                }
-            }
-        }
+    const auto use_vertices = std::regex_match(MethodStr, regex_vertices);
+    const auto use_centroid = std::regex_match(MethodStr, regex_centroid);
+    if(!use_vertices && !use_centroid){
+        throw std::invalid_argument("Method not understood. Cannot continue.");
+    }
 
-    }else if( std::regex_match(MethodStr, regex_centroid) ){
-        // Insert all vertices into the point cloud.
-        for(auto & cc_refw : cc_ROIs){
-            for(const auto & c : cc_refw.get().contours){
-                for(const auto & v : c.points){
-                    DICOM_data.point_data.back()->pset.points.emplace_back( v );
-                }
-            }
+    // Insert all vertices into the point cloud. Vertices are counted first so the output can be allocated once, and
+    // then each contour's vertices are copied into their own range concurrently.
+    std::vector<const contour_of_points<double> *> contours;
+    std::vector<size_t> offsets(1, 0);
+    for(auto & cc_refw : cc_ROIs){
+        for(const auto & c : cc_refw.get().contours){
+            contours.push_back( &c );
+            offsets.push_back( offsets.back() + c.points.size() );
         }
-        
+    }
+    auto &points = DICOM_data.point_data.back()->pset.points;
+    points.resize(offsets.back());
+    parallel_for(0, static_cast<long int>(contours.size()), [&](long int i) -> void {
+        std::copy( std::begin(contours[i]->points), std::end(contours[i]->points),
+                   std::next(std::begin(points), offsets[i]) );
+    });
+
+    if(use_centroid){
         // Determine the centroid.
         const auto centroid = DICOM_data.point_data.back()->pset.Centroid();
 
         // Replace the point cloud points with only the centroid.
-        DICOM_data.point_data.back()->pset.points.clear();
-        DICOM_data.point_data.back()->pset.points.emplace_back( centroid );
-
-    }else{
-        throw std::invalid_argument("Method not understood. Cannot continue.");
+        points.clear();
+        points.emplace_back( centroid );
     }
 
     // Determine the common set of contour metadata and assign it to the point data.
@@ -16,24 +16,19 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Distribution_Sketch.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "ConvertImageToMeshes.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
-#include "YgorMathIOOFF.h"
 
-#ifdef DCMA_USE_CGAL
-#else
-    #error "Attempted to compile without CGAL support, which is required."
-#endif
-
-#include "../Surface_Meshes.h"
+#include "../Simple_Meshing.h"
 
 
 OperationDoc OpArgDocConvertImageToMeshes(){
@@ -131,7 +126,7 @@ Drover ConvertImageToMeshes(Drover DICOM_data,
                             /*InvocationMetadata*/,
                             const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
@@ -193,8 +188,9 @@ Drover ConvertImageToMeshes(Drover DICOM_data,
                          return;
                     });
                 }
-                if(Lower_is_Ptile) cl = Stats::Percentile(pixel_vals, Lower / 100.0);
-                if(Upper_is_Ptile) cu = Stats::Percentile(pixel_vals, Upper / 100.0);
+                const sorted_quantiles<float> ptiles(std::move(pixel_vals));
+                if(Lower_is_Ptile) cl = ptiles.quantile(Lower / 100.0);
+                if(Upper_is_Ptile) cu = ptiles.quantile(Upper / 100.0);
             }
         }
         if(cl > cu){
@@ -284,24 +280,15 @@ Drover ConvertImageToMeshes(Drover DICOM_data,
         for(auto &amask : masks){
             mask_imgs.push_back(std::ref(amask));
         }
-        // Note: meshing parameter MutateOpts are irrelevant since we supply our own mask.
-        auto meshing_params = dcma_surface_meshes::Parameters();
-        auto output_mesh = dcma_surface_meshes::Estimate_Surface_Mesh_Marching_Cubes( 
-                                                        mask_imgs,
+        // Note: the mesh is emitted directly, so no intermediary polyhedron is needed.
+        auto output_mesh = Marching_Cubes_Surface_Mesh( mask_imgs,
                                                         inclusion_threshold, 
-                                                        below_is_interior,
-                                                        meshing_params );
+                                                        below_is_interior );
 
         // Emit the meshes.
         {
-            std::stringstream ss;
-            if(!(ss << output_mesh)){
-                throw std::runtime_error("Unable to emit mesh OFF format. Cannot continue.");
-            }
             DICOM_data.smesh_data.emplace_back( std::make_unique<Surface_Mesh>() );
-            if(!ReadFVSMeshFromOFF( DICOM_data.smesh_data.back()->meshes, ss )){
-                throw std::runtime_error("Unable to parse mesh OFF format. Cannot continue.");
-            }
+            DICOM_data.smesh_data.back()->meshes = std::move(output_mesh);
 
             DICOM_data.smesh_data.back()->meshes.metadata = ia_metadata;
             DICOM_data.smesh_data.back()->meshes.metadata["MeshLabel"] = MeshLabel;
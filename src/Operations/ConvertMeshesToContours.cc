@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <optional>
 #include <fstream>
+#include <functional>
 #include <iterator>
 #include <list>
 #include <map>
@@ -16,24 +17,18 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "ConvertMeshesToContours.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
-#include "YgorMathIOOFF.h"
 
-#ifdef DCMA_USE_CGAL
-#else
-    #error "Attempted to compile without CGAL support, which is required."
-#endif
-
-#include "../Surface_Meshes.h"
+#include "../Surface_Mesh_Slicer.h"
 
 
 OperationDoc OpArgDocConvertMeshesToContours(){
@@ -53,7 +48,8 @@ OperationDoc OpArgDocConvertMeshesToContours(){
         "Images and meshes are unaltered. Existing contours are ignored and unaltered."
     );
     out.notes.emplace_back(
-        "Contour orientation is (likely) not guaranteed to be consistent in this routine."
+        "Contours are oriented consistently with the mesh faces. Meshes with consistently-oriented faces will"
+        " produce consistently-oriented contours."
     );
         
 
@@ -86,7 +82,7 @@ Drover ConvertMeshesToContours(Drover DICOM_data,
                                const std::map<std::string, std::string>& /*InvocationMetadata*/,
                                const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ROILabel = OptArgs.getValueStr("ROILabel").value();
@@ -115,29 +111,19 @@ Drover ConvertMeshesToContours(Drover DICOM_data,
     long int completed = 0;
     long int N_new_contours = 0;
     for(auto & smp_it : SMs){
-        // Convert to a CGAL mesh.
-        std::stringstream ss;
-        if(!WriteFVSMeshToOFF( (*smp_it)->meshes, ss )){
-            throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
-        }
-
-        dcma_surface_meshes::Polyhedron surface_mesh;
-        if(!( ss >> surface_mesh )){
-            throw std::runtime_error("Mesh could not be treated as a polyhedron. (Is it manifold?)");
-        }
-        
-        // Use a method robust to non-manifold meshes.
-        //
-        // Note: If you need to use this, hide it behind a toggle parameter.
-        //       Proceeding with a manifold mesh can cause lots of issues later.
-        //dcma_surface_meshes::Polyhedron surface_mesh = dcma_surface_meshes::FVSMeshToPolyhedron((*smp_it)->meshes);
-
         for(auto & iap_it : IAs){
+            // Slice the mesh along all image planes at once.
+            std::vector<std::reference_wrapper<const planar_image<float,double>>> imgs;
+            std::vector<plane<double>> planes;
             for(const auto &animg : (*iap_it)->imagecoll.images){
-                // Slice the mesh along the image plane.
-                auto lcc = polyhedron_processing::Slice_Polyhedron( surface_mesh, 
-                                                                    {{ animg.image_plane() }} );
+                imgs.emplace_back( std::cref(animg) );
+                planes.emplace_back( animg.image_plane() );
+            }
+            auto lccs = Slice_Surface_Mesh( (*smp_it)->meshes, planes );
 
+            for(size_t i = 0; i < imgs.size(); ++i){
+                const auto &animg = imgs[i].get();
+                auto &lcc = lccs[i];
                 N_new_contours += lcc.contours.size();
 
                 // Tag the contours with metadata.
@@ -1,14 +1,17 @@
 //ConvertNaNsToAir.cc - A part of DICOMautomaton 2015, 2016. Written by hal clark.
 
 #include <any>
+#include <cmath>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>    
 
 #include "../Structs.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/CT_Convert_NaNs_to_Air.h"
 #include "ConvertNaNsToAir.h"
 #include "YgorImages.h"
@@ -31,12 +34,30 @@ Drover ConvertNaNsToAir(Drover DICOM_data,
                         const std::string& /*FilenameLex*/){
 
     for(auto & img_arr : DICOM_data.image_data){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               CTNaNsToAir,
-                                               {}, {} )){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     CTNaNsToAir,
+                                     {}, {} )){
             FUNCERR("Unable to censor pixels with enormous values");
         }
     }
 
     return DICOM_data;
 }
+
+std::optional<pointwise_stage> PointwiseStageConvertNaNsToAir(Drover &DICOM_data, const OperationArgPkg& /*OptArgs*/){
+    pointwise_stage stage;
+    stage.name = "ConvertNaNsToAir";
+    for(auto & img_arr : DICOM_data.image_data) stage.arrays.push_back(img_arr);
+
+    //Mirrors CTNaNsToAir.
+    stage.transform = [](float *vals, size_t n, size_t stride, Stats::Running_MinMax<float> &minmax) -> void {
+        for(size_t i = 0; i < n; ++i){
+            auto &v = vals[i * stride];
+            v = std::isfinite(v) ? v : -1024.0f;
+            minmax.Digest(v);
+        }
+    };
+    stage.description = "NaN Pixel Filtered";
+    stage.update_window = true;
+    return stage;
+}
@@ -9,6 +9,7 @@
 
 #include "../Structs.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Convert_NaNs_to_Zero.h"
 #include "ConvertNaNsToZeros.h"
 #include "YgorImages.h"
@@ -31,9 +32,9 @@ Drover ConvertNaNsToZeros(Drover DICOM_data,
                           const std::string& /*FilenameLex*/){
 
     for(auto & img_arr : DICOM_data.image_data){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               NaNsToZeros,
-                                               {}, {} )){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     NaNsToZeros,
+                                     {}, {} )){
             FUNCERR("Unable to censor NaN pixels");
         }
     }
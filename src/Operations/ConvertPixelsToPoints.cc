@@ -8,7 +8,7 @@
 #include <list>
 #include <map>
 #include <memory>
-#include <mutex>
+#include <numeric>
 #include <regex>
 #include <set> 
 #include <stdexcept>
@@ -16,11 +16,12 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Distribution_Sketch.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "ConvertPixelsToPoints.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -40,6 +41,9 @@ OperationDoc OpArgDocConvertPixelsToPoints(){
     out.notes.emplace_back(
         "Existing point clouds are ignored and unaltered."
     );
+    out.notes.emplace_back(
+        "The value of each converted pixel is stored alongside the point in a 'PixelValue' point attribute."
+    );
         
 
     out.args.emplace_back();
@@ -100,7 +104,7 @@ Drover ConvertPixelsToPoints(Drover DICOM_data,
                              /*InvocationMetadata*/,
                              const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto LabelStr = OptArgs.getValueStr("Label").value();
@@ -125,76 +129,89 @@ Drover ConvertPixelsToPoints(Drover DICOM_data,
 
     //Construct a destination for the point clouds.
     DICOM_data.point_data.emplace_back( std::make_unique<Point_Cloud>() );
+    auto &pc = *(DICOM_data.point_data.back());
+    auto &pixel_values = pc.point_attributes.emplace<float>("PixelValue", 0);
 
-    std::mutex point_pusher; // Who gets to save points.
-
-    //Iterate over each requested image_array. Each image is processed independently, so a thread pool is used.
+    //Gather the images to convert. Each image is processed independently.
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+    std::vector<const planar_image<float, double> *> imgs;
     for(auto & iap_it : IAs){
-        asio_thread_pool tp;
-        std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
-        long int completed = 0;
-        const long int img_count = (*iap_it)->imagecoll.images.size();
-
         for(const auto &img : (*iap_it)->imagecoll.images){
             if( (img.rows < 1) || (img.columns < 1) || (Channel >= img.channels) ){
                 continue;
             }
+            imgs.push_back( &img );
+        }
+    }
 
-            std::reference_wrapper< const planar_image<float, double>> img_refw( std::ref(img) );
-
-            tp.submit_task([&,img_refw]() -> void {
-
-                //Determine the bounds in terms of pixel-value thresholds.
-                auto cl = Lower; // Will be replaced if percentages/percentiles requested.
-                auto cu = Upper; // Will be replaced if percentages/percentiles requested.
-                {
-                    //Percentage-based.
-                    if(Lower_is_Percent || Upper_is_Percent){
-                        Stats::Running_MinMax<float> rmm;
-                        img_refw.get().apply_to_pixels([&rmm,Channel](long int, long int, long int chnl, float val) -> void {
-                             if(Channel == chnl) rmm.Digest(val);
-                             return;
-                        });
-                        if(Lower_is_Percent) cl = (rmm.Current_Min() + (rmm.Current_Max() - rmm.Current_Min()) * Lower / 100.0);
-                        if(Upper_is_Percent) cu = (rmm.Current_Min() + (rmm.Current_Max() - rmm.Current_Min()) * Upper / 100.0);
-                    }
-
-                    //Percentile-based.
-                    if(Lower_is_Ptile || Upper_is_Ptile){
-                        std::vector<float> pixel_vals;
-                        pixel_vals.reserve(img_refw.get().rows * img_refw.get().columns * img_refw.get().channels);
-                        img_refw.get().apply_to_pixels([&pixel_vals,Channel](long int, long int, long int chnl, float val) -> void {
-                             if(Channel == chnl) pixel_vals.push_back(val);
-                             return;
-                        });
-                        if(Lower_is_Ptile) cl = Stats::Percentile(pixel_vals, Lower / 100.0);
-                        if(Upper_is_Ptile) cu = Stats::Percentile(pixel_vals, Upper / 100.0);
-                    }
-                }
-
-                //Construct a pixel 'oracle' closure using the user-specified threshold criteria. This function identifies whether
-                //the pixel is within (true) or outside of (false) the final ROI.
-                auto pixel_oracle = [cu,cl](float p) -> bool {
-                    return (cl <= p) && (p <= cu);
-                };
-
-                //Perform the conversion.
-                img_refw.get().apply_to_pixels([&,Channel](long int row, long int col, long int chnl, float val) -> void {
-                    if((chnl == Channel) && pixel_oracle(val)){
-                        const auto pos = img_refw.get().position(row, col);
-                         
-                        std::lock_guard<std::mutex> lock(point_pusher);
-                        DICOM_data.point_data.back()->pset.points.emplace_back( pos );
-                     }
+    //Points are extracted in two passes. The first determines the thresholds and counts the points from each image,
+    // so the output can be allocated once. The second fills each image's (disjoint) range of the output concurrently.
+    std::vector<std::pair<double, double>> bounds(imgs.size());
+    std::vector<size_t> offsets(imgs.size() + 1, 0);
+    parallel_for(0, static_cast<long int>(imgs.size()), [&](long int i) -> void {
+        const auto &img = *(imgs[i]);
+
+        //Determine the bounds in terms of pixel-value thresholds.
+        auto cl = Lower; // Will be replaced if percentages/percentiles requested.
+        auto cu = Upper; // Will be replaced if percentages/percentiles requested.
+        {
+            //Percentage-based.
+            if(Lower_is_Percent || Upper_is_Percent){
+                Stats::Running_MinMax<float> rmm;
+                img.apply_to_pixels([&rmm,Channel](long int, long int, long int chnl, float val) -> void {
+                     if(Channel == chnl) rmm.Digest(val);
                      return;
                 });
+                if(Lower_is_Percent) cl = (rmm.Current_Min() + (rmm.Current_Max() - rmm.Current_Min()) * Lower / 100.0);
+                if(Upper_is_Percent) cu = (rmm.Current_Min() + (rmm.Current_Max() - rmm.Current_Min()) * Upper / 100.0);
+            }
 
-            }); // Thread pool task.
-        } // Loop over images.
-    } // Loop over image arrays.
+            //Percentile-based.
+            if(Lower_is_Ptile || Upper_is_Ptile){
+                std::vector<float> pixel_vals;
+                pixel_vals.reserve(img.rows * img.columns * img.channels);
+                img.apply_to_pixels([&pixel_vals,Channel](long int, long int, long int chnl, float val) -> void {
+                     if(Channel == chnl) pixel_vals.push_back(val);
+                     return;
+                });
+                const sorted_quantiles<float> ptiles(std::move(pixel_vals));
+                if(Lower_is_Ptile) cl = ptiles.quantile(Lower / 100.0);
+                if(Upper_is_Ptile) cu = ptiles.quantile(Upper / 100.0);
+            }
+        }
+        bounds[i] = { cl, cu };
 
+        size_t count = 0;
+        for(long int row = 0; row < img.rows; ++row){
+            for(long int col = 0; col < img.columns; ++col){
+                const auto val = img.value(row, col, Channel);
+                if( (cl <= val) && (val <= cu) ) ++count;
+            }
+        }
+        offsets[i + 1] = count;
+    }, /*grain=*/ 1);
+    std::partial_sum(std::begin(offsets), std::end(offsets), std::begin(offsets));
+
+    pc.pset.points.resize(offsets.back());
+    pixel_values.resize(offsets.back());
+    parallel_for(0, static_cast<long int>(imgs.size()), [&](long int i) -> void {
+        const auto &img = *(imgs[i]);
+        const auto [cl, cu] = bounds[i];
+
+        //Points are emitted in the same order they were counted, so each image fills exactly its own range.
+        auto n = offsets[i];
+        for(long int row = 0; row < img.rows; ++row){
+            for(long int col = 0; col < img.columns; ++col){
+                const auto val = img.value(row, col, Channel);
+                if( (cl <= val) && (val <= cu) ){
+                    pc.pset.points[n] = img.position(row, col);
+                    pixel_values[n] = val;
+                    ++n;
+                }
+            }
+        }
+    }, /*grain=*/ 1);
 
     // Determine the common set of image metadata and assign it to the point data.
     {
@@ -207,11 +224,11 @@ Drover ConvertPixelsToPoints(Drover DICOM_data,
         }
         std::map<std::string,std::string> cm = dummy.get_common_metadata(all_img_list_iters);
 
-        DICOM_data.point_data.back()->pset.metadata = cm;
+        pc.pset.metadata = cm;
     }
 
-    DICOM_data.point_data.back()->pset.metadata["Label"] = LabelStr;
-    DICOM_data.point_data.back()->pset.metadata["Description"] = "Point cloud derived from volumetric images.";
+    pc.pset.metadata["Label"] = LabelStr;
+    pc.pset.metadata["Description"] = "Point cloud derived from volumetric images.";
 
     return DICOM_data;
 }
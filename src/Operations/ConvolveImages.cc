@@ -17,6 +17,7 @@
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
+#include "../YgorImages_Functors/Volume_Convolution.h"
 
 #include "YgorImages.h"
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
@@ -111,6 +112,27 @@ OperationDoc OpArgDocConvolveImages(){
                                  "pattern-match" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "Controls how convolution and correlation are computed."
+                           " Pattern-matching is not affected by this parameter."
+                           " 'Automatic' selects the cheapest method for the provided kernel."
+                           " 'Direct' evaluates the kernel at every voxel, which is fastest for small kernels."
+                           " 'Separable' applies the kernel as three successive 1D kernels, which is only possible"
+                           " if the kernel factors into a product of 1D kernels."
+                           " 'FFT' uses tiled fast Fourier transforms, which is fastest for large kernels."
+                           " All methods produce the same result (to within floating-point round-off)."
+                           " As before, voxels whose neighbourhood extends beyond the image array or includes"
+                           " non-finite voxels are assigned NaN.";
+    out.args.back().default_val = "automatic";
+    out.args.back().expected = true;
+    out.args.back().examples = { "automatic",
+                                 "direct",
+                                 "separable",
+                                 "fft" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -129,6 +151,7 @@ Drover ConvolveImages(Drover DICOM_data,
 
     const auto Channel = std::stol( OptArgs.getValueStr("Channel").value() );
     const auto OperationStr = OptArgs.getValueStr("Operation").value();
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_conv = Compile_Regex("^conv?o?l?u?t?i?o?n?$");
@@ -138,6 +161,24 @@ Drover ConvolveImages(Drover DICOM_data,
     const bool op_is_conv = std::regex_match(OperationStr, regex_conv);
     const bool op_is_corr = std::regex_match(OperationStr, regex_corr);
     const bool op_is_mtch = std::regex_match(OperationStr, regex_mtch);
+
+    const auto regex_auto = Compile_Regex("^au?t?o?m?a?t?i?c?$");
+    const auto regex_drct = Compile_Regex("^di?r?e?c?t?$");
+    const auto regex_sepr = Compile_Regex("^se?p?a?r?a?b?l?e?$");
+    const auto regex_fft  = Compile_Regex("^ff?t?$");
+
+    auto method = volume_convolution::method_t::Automatic;
+    if(std::regex_match(MethodStr, regex_auto)){
+        method = volume_convolution::method_t::Automatic;
+    }else if(std::regex_match(MethodStr, regex_drct)){
+        method = volume_convolution::method_t::Direct;
+    }else if(std::regex_match(MethodStr, regex_sepr)){
+        method = volume_convolution::method_t::Separable;
+    }else if(std::regex_match(MethodStr, regex_fft)){
+        method = volume_convolution::method_t::FFT;
+    }else{
+        throw std::invalid_argument("Method not understood. Cannot continue.");
+    }
     //-----------------------------------------------------------------------------------------------------------------
 
     // Identify the contours to use.
@@ -178,6 +219,45 @@ Drover ConvolveImages(Drover DICOM_data,
         }
 
         auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+
+        const auto first_img_num = 0L;
+        const auto first_img_refw = img_adj.index_to_image(first_img_num);
+        const long int k_rows = first_img_refw.get().rows;
+        const long int k_columns = first_img_refw.get().columns;
+        const auto k_imgs = static_cast<long int>(img_adj.int_to_img.size());
+
+        if( op_is_conv
+        ||  op_is_corr ){
+            // Pack the kernel on a contiguous buffer and apply it using the convolution engine.
+            volume_convolution::kernel_t k;
+            k.extent = {{ k_rows, k_columns, k_imgs }};
+            k.centre = {{ k_rows / 2, k_columns / 2, k_imgs / 2 }}; // (Approximately) centre the kernel.
+            k.weights.resize(k.size());
+            for(long int i = 0; i < k_imgs; ++i){
+                const auto l_img_refw = img_adj.index_to_image(i + first_img_num);
+                for(long int r = 0; r < k_rows; ++r){
+                    for(long int c = 0; c < k_columns; ++c){
+                        k.at(r, c, i) = l_img_refw.get().value(r, c, (Channel < 0) ? 0 : Channel);
+                    }
+                }
+            }
+            if(op_is_conv) k = volume_convolution::flip(k);
+            FUNCINFO("Kernel comprises " << k.size() << " voxels");
+
+            for(auto & iap_it : IAs){
+                volume_convolution::apply_within_contours( (*iap_it)->imagecoll, orientation_normal, cc_ROIs, Channel,
+                    [&](rectilinear_volume &vol, long int c) -> void {
+                        volume_convolution::apply(vol, c, k, volume_convolution::boundary_t::Propagate, method);
+                    });
+
+                for(auto &img : (*iap_it)->imagecoll.images){
+                    UpdateImageDescription( std::ref(img), "Image Convolved" );
+                    UpdateImageWindowCentreWidth( std::ref(img) );
+                }
+            }
+            continue;
+        }
+
         for(auto & iap_it : IAs){
 
             ComputeVolumetricNeighbourhoodSamplerUserData ud;
@@ -193,13 +273,6 @@ Drover ConvolveImages(Drover DICOM_data,
             std::vector<std::array<long int, 3>> triplets;
             std::vector<float> k_values;
 
-            const auto first_img_num = 0L;
-            const auto first_img_refw = img_adj.index_to_image(first_img_num);
-            const long int k_rows = first_img_refw.get().rows;
-            const long int k_columns = first_img_refw.get().columns;
-            const auto k_imgs = static_cast<long int>(img_adj.int_to_img.size());
-            //std::map<long int, img_ptr_t> int_to_img;
-
             const auto d_r = k_rows / 2;   // Offsets to (approximately) centre the kernel.
             const auto d_c = k_columns / 2;
             const auto d_i = k_imgs / 2;
@@ -30,6 +30,7 @@
 #include "../Thread_Pool.h"
 #include "../Write_File.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
 
 #include "CountVoxels.h"
@@ -261,9 +262,9 @@ Drover CountVoxels(Drover DICOM_data,
             return;
         };
 
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     PartitionedImageVoxelVisitorMutator,
+                                     {}, cc_ROIs, &ud )){
             throw std::runtime_error("Unable to count voxels.");
         }
     }
@@ -4,6 +4,7 @@
 #include <list>
 #include <map>
 #include <string>    
+#include <utility>
 
 #include "../Dose_Meld.h"
 #include "../Structs.h"
@@ -84,11 +85,11 @@ Drover CropROIDose(Drover DICOM_data,
                    const std::map<std::string, std::string>& InvocationMetadata,
                    const std::string& FilenameLex){
 
-    DICOM_data = Meld_Only_Dose_Data(DICOM_data);
+    DICOM_data = Meld_Only_Dose_Data(std::move(DICOM_data));
 
-    DICOM_data = HighlightROIs(DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+    DICOM_data = HighlightROIs(std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
 
-    DICOM_data = DICOMExportImagesAsDose(DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+    DICOM_data = DICOMExportImagesAsDose(std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
 
     return DICOM_data;
 }
@@ -1,5 +1,8 @@
 //DeDuplicateImages.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <deque>
 #include <optional>
 #include <iterator>
@@ -9,12 +12,16 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <utility>
+#include <vector>
 
 #include "YgorMisc.h"
 #include "YgorStats.h"
 
+#include "../Content_Hash.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 
 #include "DeDuplicateImages.h"
 
@@ -34,10 +41,110 @@ OperationDoc OpArgDocDeDuplicateImages(){
     out.args.back() = IAWhitelistOpArgDoc();
     out.args.back().name = "ImageSelection";
     out.args.back().default_val = "all";
-    
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "Controls how duplicates are identified."
+                           " 'Similar' compares every pair of image arrays, treating arrays with nearby centres,"
+                           " similar volumes, and overlapping voxel intensity ranges as duplicates."
+                           " 'Exact' only treats arrays with identical geometry, identical voxel values, and"
+                           " identical 'MetadataKeys' metadata as duplicates. Candidates are first grouped by a"
+                           " geometry and metadata fingerprint and a (parallel) hash of the voxel values, and"
+                           " voxels are only compared within groups, so this method scales to many arrays.";
+    out.args.back().default_val = "similar";
+    out.args.back().expected = true;
+    out.args.back().examples = { "similar",
+                                 "exact" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+    out.args.emplace_back();
+    out.args.back().name = "MetadataKeys";
+    out.args.back().desc = "A regular expression matching the image metadata keys that duplicates must share when"
+                           " using the 'exact' method. All other metadata is ignored.";
+    out.args.back().default_val = "Modality";
+    out.args.back().expected = true;
+    out.args.back().examples = { "Modality",
+                                 "Modality|PatientID|FrameOfReferenceUID",
+                                 "^$" };
+
     return out;
 }
 
+
+namespace {
+
+bool same_vec3(const vec3<double> &a, const vec3<double> &b){
+    return (a.x == b.x) && (a.y == b.y) && (a.z == b.z);
+}
+
+// A cheap fingerprint of the geometry and the selected metadata, which duplicates must share.
+uint64_t geometry_fingerprint(const planar_image_collection<float,double> &imagecoll, const std::regex &metadata_keys){
+    content_hasher h;
+    h.add(static_cast<uint64_t>(imagecoll.images.size()));
+    for(const auto &img : imagecoll.images){
+        h.add(static_cast<uint64_t>(img.rows));
+        h.add(static_cast<uint64_t>(img.columns));
+        h.add(static_cast<uint64_t>(img.channels));
+        h.add(img.pxl_dx);
+        h.add(img.pxl_dy);
+        h.add(img.pxl_dz);
+        h.add(img.anchor);
+        h.add(img.offset);
+        h.add(img.row_unit);
+        h.add(img.col_unit);
+        for(const auto &kv : img.metadata){
+            if(!std::regex_search(kv.first, metadata_keys)) continue;
+            h.add(kv.first);
+            h.add(kv.second);
+        }
+    }
+    return h.digest();
+}
+
+uint64_t voxel_hash(const planar_image_collection<float,double> &imagecoll){
+    content_hasher h;
+    for(const auto &img : imagecoll.images) h.add(img.data.data(), img.data.size());
+    return h.digest();
+}
+
+// Confirms a match, since fingerprints and hashes can collide. NaNs match NaNs, and (like the hash) -0.0 matches 0.0.
+bool identical_image_arrays(const planar_image_collection<float,double> &A,
+                            const planar_image_collection<float,double> &B,
+                            const std::regex &metadata_keys){
+    if(A.images.size() != B.images.size()) return false;
+
+    const auto selected_metadata = [&](const planar_image<float,double> &img){
+        std::map<std::string, std::string> out;
+        for(const auto &kv : img.metadata){
+            if(std::regex_search(kv.first, metadata_keys)) out.insert(kv);
+        }
+        return out;
+    };
+
+    for(auto a_it = std::begin(A.images), b_it = std::begin(B.images); a_it != std::end(A.images); ++a_it, ++b_it){
+        if( (a_it->rows != b_it->rows)
+        ||  (a_it->columns != b_it->columns)
+        ||  (a_it->channels != b_it->channels)
+        ||  (a_it->pxl_dx != b_it->pxl_dx)
+        ||  (a_it->pxl_dy != b_it->pxl_dy)
+        ||  (a_it->pxl_dz != b_it->pxl_dz)
+        ||  !same_vec3(a_it->anchor, b_it->anchor)
+        ||  !same_vec3(a_it->offset, b_it->offset)
+        ||  !same_vec3(a_it->row_unit, b_it->row_unit)
+        ||  !same_vec3(a_it->col_unit, b_it->col_unit)
+        ||  (a_it->data.size() != b_it->data.size()) ) return false;
+
+        if(!std::equal(std::begin(a_it->data), std::end(a_it->data), std::begin(b_it->data),
+                       [](float a, float b){ return (a == b) || (std::isnan(a) && std::isnan(b)); })) return false;
+
+        if(selected_metadata(*a_it) != selected_metadata(*b_it)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
 Drover DeDuplicateImages(Drover DICOM_data,
                          const OperationArgPkg& OptArgs,
                          const std::map<std::string, std::string>&,
@@ -45,12 +152,21 @@ Drover DeDuplicateImages(Drover DICOM_data,
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
+    const auto MetadataKeysStr = OptArgs.getValueStr("MetadataKeys").value();
 
     const auto d_center_threshold = 1.0; // DICOM units; mm.
     const auto d_volume_threshold = 1.0 * 1.0 * 1.0; // ~ the volume of a typical voxel.
     const auto vox_range_overlap_dice_threshold = 0.99; // the minimum acceptable dice similarity of the voxel intensity range.
     //-----------------------------------------------------------------------------------------------------------------
 
+    const auto regex_similar = Compile_Regex("^si?m?i?l?a?r?$");
+    const auto regex_exact = Compile_Regex("^ex?a?c?t?$");
+    const bool use_exact = std::regex_match(MethodStr, regex_exact);
+    if(!use_exact && !std::regex_match(MethodStr, regex_similar)){
+        throw std::invalid_argument("'Method' parameter is invalid. Cannot continue.");
+    }
+
     const auto voxel_intensity_min_max = [](std::shared_ptr<Image_Array> ia){
         Stats::Running_MinMax<float> rmm;
         const auto tally_mm = [&rmm](long int, long int, long int, float val) -> void {
@@ -68,6 +184,44 @@ Drover DeDuplicateImages(Drover DICOM_data,
     //std::list<std::shared_ptr<Image_Array>> IA_duplicates;
     std::list< std::list<std::shared_ptr<Image_Array>>::iterator > IA_duplicates;
 
+    if(use_exact){
+        const std::regex metadata_keys(MetadataKeysStr, std::regex::ECMAScript);
+        const std::vector<std::list<std::shared_ptr<Image_Array>>::iterator> candidates(std::begin(IAs), std::end(IAs));
+        const auto N = static_cast<long int>(candidates.size());
+
+        // Fingerprint and hash every array in parallel.
+        std::vector<std::pair<uint64_t, uint64_t>> keys(N);
+        parallel_for(0, N, [&](long int i){
+            const auto &imagecoll = (*candidates[i])->imagecoll;
+            keys[i] = { geometry_fingerprint(imagecoll, metadata_keys), voxel_hash(imagecoll) };
+        }, 1);
+
+        // Bucket the candidates, preserving their order so the first of each set of duplicates is retained.
+        std::map<std::pair<uint64_t, uint64_t>, std::vector<long int>> buckets;
+        for(long int i = 0; i < N; ++i) buckets[keys[i]].push_back(i);
+        FUNCINFO("Grouped " << N << " image arrays into " << buckets.size() << " candidate groups");
+
+        for(const auto &b : buckets){
+            std::vector<long int> retained;
+            for(const auto i : b.second){
+                bool is_duplicate = false;
+                for(const auto j : retained){
+                    if(identical_image_arrays((*candidates[j])->imagecoll, (*candidates[i])->imagecoll, metadata_keys)){
+                        is_duplicate = true;
+                        break;
+                    }
+                }
+                if(is_duplicate){
+                    FUNCINFO("Duplicate image array identified");
+                    IA_duplicates.push_back( candidates[i] );
+                }else{
+                    retained.push_back(i);
+                }
+            }
+        }
+        IAs.clear();
+    }
+
     // Score each relevant metric for each image array.
     for(auto iapA_it_it = std::begin(IAs); iapA_it_it != std::end(IAs); ++iapA_it_it){
         const auto center_A = (*(*iapA_it_it))->imagecoll.center();
@@ -9,12 +9,13 @@
 #include <stdexcept>
 #include <string>    
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/DecayDoseOverTime.h"
 #include "DecayDoseOverTimeHalve.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 
 
@@ -75,7 +76,7 @@ Drover DecayDoseOverTimeHalve(Drover DICOM_data,
 
     //-----------------------------------------------------------------------------------------------------------------
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //Merge the image arrays if necessary.
     if(DICOM_data.image_data.empty()){
@@ -100,9 +101,9 @@ Drover DecayDoseOverTimeHalve(Drover DICOM_data,
     }
 
     // Perform the dose modification.
-    if(!img_arr_ptr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                        DecayDoseOverTime,
-                                                        {}, cc_ROIs, &ud )){
+    if(!Process_Images_Balanced( img_arr_ptr->imagecoll,
+                                 DecayDoseOverTime,
+                                 {}, cc_ROIs, &ud )){
         throw std::runtime_error("Unable to decay dose (via halving).");
     }
 
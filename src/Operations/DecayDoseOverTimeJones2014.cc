@@ -1,6 +1,8 @@
 //DecayDoseOverTimeJones2014.cc - A part of DICOMautomaton 2017. Written by hal clark.
 
+#include <algorithm>
 #include <any>
+#include <cmath>
 #include <optional>
 #include <fstream>
 #include <functional>
@@ -11,12 +13,15 @@
 #include <stdexcept>
 #include <string>    
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Uniform_LUT.h"
+#include "../BED_Conversion.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/DecayDoseOverTime.h"
 #include "DecayDoseOverTimeJones2014.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -170,7 +175,7 @@ Drover DecayDoseOverTimeJones2014(Drover DICOM_data,
 
     ud.UseMoreConservativeRecovery = std::regex_match(UseMoreConservativeRecovery_str, TrueRegex);
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //Merge the image arrays if necessary.
     if(DICOM_data.image_data.empty()){
@@ -217,10 +222,22 @@ Drover DecayDoseOverTimeJones2014(Drover DICOM_data,
     if(ud.TemporalGapMonths <  0) ud.TemporalGapMonths =  0.0;
     if(ud.TemporalGapMonths > 36) ud.TemporalGapMonths = 36.0; 
 
+    // Tabulate the decay once, over the range of dose present, rather than evaluating it for every voxel. The error is
+    // also checked where the dose reaches tolerance, since the transform is not smooth there.
+    {
+        const auto [D_min, D_max] = Finite_Voxel_Range(img_arr_ptr->imagecoll);
+        const auto D_tol = D_from_n_BEDabr(ud.Course1NumberOfFractions,
+                                           BEDabr_from_n_D_abr(ud.ToleranceNumberOfFractions,
+                                                               ud.ToleranceTotalDose,
+                                                               ud.AlphaBetaRatio));
+        const auto tol = 1.0E-5 * std::max(std::abs(D_min), std::abs(D_max));
+        ud.LUT = Compile_LUT(DecayDoseOverTime_Transform(ud), D_min, D_max, tol, { D_tol });
+    }
+
     // Perform the dose modification.
-    if(!img_arr_ptr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                        DecayDoseOverTime,
-                                                        {}, cc_ROIs, &ud )){
+    if(!Process_Images_Balanced( img_arr_ptr->imagecoll,
+                                 DecayDoseOverTime,
+                                 {}, cc_ROIs, &ud )){
         throw std::runtime_error("Unable to decay dose (Jones and Grant 2014 model).");
     }
 
@@ -9,6 +9,7 @@
 
 #include "../Structs.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Pixel_Decimate.h"
 #include "DecimatePixels.h"
 #include "YgorImages.h"
@@ -64,9 +65,9 @@ Drover DecimatePixels(Drover DICOM_data,
                                     std::placeholders::_5);
 
         for(auto & img_arr : DICOM_data.image_data){
-            if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                   DecimateRC,
-                                                   {}, {} )){
+            if(!Process_Images_Balanced( img_arr->imagecoll,
+                                         DecimateRC,
+                                         {}, {} )){
                 FUNCERR("Unable to decimate pixels");
             }
         }
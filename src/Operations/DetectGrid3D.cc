@@ -44,6 +44,8 @@
 #include "../Regex_Selectors.h"
 #include "../Insert_Contours.h"
 #include "../Write_File.h"
+#include "../Thread_Pool.h"
+#include "../Parallel_RANSAC.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
@@ -52,6 +54,9 @@
 
 #include "DetectGrid3D.h"
 
+// The number of points handled by each task when projecting, matching, or scoring points in parallel.
+static const long int point_grain = 4096;
+
 // Used to store state about a fitted 3D grid.
 struct Grid_Context {
     // Controls how the corresponding points are determined. See operation documentation for more information.
@@ -337,8 +342,11 @@ void
 Project_Into_Proto_Cube( Grid_Context &GC,
                         ICP_Context &ICPC ){
     // Using the current grid axes directions and anchor point, project all points into the proto cell.
-    auto p_cell_it = std::begin(ICPC.p_cell);
-    for(const auto &P : ICPC.cohort){
+    if(ICPC.p_cell.size() != ICPC.cohort.size() ){
+        throw std::logic_error("Insufficient working space allocated. Cannot continue.");
+    }
+    parallel_for(0, static_cast<long int>(ICPC.cohort.size()), [&](long int i){
+        const auto &P = ICPC.cohort[i];
 
         // Vector rel. to grid anchor.
         const auto R = (P - GC.current_grid_anchor);
@@ -386,9 +394,8 @@ Project_Into_Proto_Cube( Grid_Context &GC,
             }
         }
 
-        *p_cell_it = C;
-        ++p_cell_it;
-    }
+        ICPC.p_cell[i] = C;
+    }, point_grain);
     return;
 }
 
@@ -404,17 +411,12 @@ Translate_Grid_Optimally( Grid_Context &GC,
     // scalar distance; since all points have been projecting into the unit cube, at most the point will be
     // 0.5*separation from the nearest plane. Thus if we subtract 1.0*separation for the points in the upper half, we can
     // use simple 1D distribution analysis to determine optimal translations of the anchor point.
-    std::vector<double> dist_x;
-    std::vector<double> dist_y;
-    std::vector<double> dist_z;
-
-    dist_x.reserve(ICPC.p_cell.size());
-    dist_y.reserve(ICPC.p_cell.size());
-    dist_z.reserve(ICPC.p_cell.size());
+    std::vector<double> dist_x(ICPC.p_cell.size());
+    std::vector<double> dist_y(ICPC.p_cell.size());
+    std::vector<double> dist_z(ICPC.p_cell.size());
     {
-        auto p_cell_it = std::begin(ICPC.p_cell);
-        for(const auto &pp : ICPC.cohort){
-            const auto C = (*p_cell_it) - GC.current_grid_anchor;
+        parallel_for(0, static_cast<long int>(ICPC.p_cell.size()), [&](long int i){
+            const auto C = ICPC.p_cell[i] - GC.current_grid_anchor;
 
             const auto proj_x = GC.current_grid_x.Dot(C);
             const auto proj_y = GC.current_grid_y.Dot(C);
@@ -424,12 +426,10 @@ Translate_Grid_Optimally( Grid_Context &GC,
             const auto dy = (0.5*GC.grid_sep < proj_y) ? proj_y - GC.grid_sep : proj_y;
             const auto dz = (0.5*GC.grid_sep < proj_z) ? proj_z - GC.grid_sep : proj_z;
 
-            dist_x.emplace_back(dx);
-            dist_y.emplace_back(dy);
-            dist_z.emplace_back(dz);
-
-            ++p_cell_it;
-        }
+            dist_x[i] = dx;
+            dist_y[i] = dy;
+            dist_z[i] = dz;
+        }, point_grain);
     }
 
     const auto shift_x = Stats::Mean(dist_x);
@@ -519,13 +519,10 @@ Find_Corresponding_Points( Grid_Context &GC,
 
 
     // Find the corresponding point for each projected proto cube point.
-    auto closest_dist = std::numeric_limits<double>::quiet_NaN();
-    auto closest_proj = NaN_vec3;
-    auto c_it = std::begin(ICPC.p_corr);
-    for(const auto &P : ICPC.p_cell){
-
-        closest_dist = std::numeric_limits<double>::quiet_NaN();
-        closest_proj = NaN_vec3;
+    parallel_for(0, static_cast<long int>(ICPC.p_cell.size()), [&](long int i){
+        const auto &P = ICPC.p_cell[i];
+        auto closest_dist = std::numeric_limits<double>::quiet_NaN();
+        auto closest_proj = NaN_vec3;
 
         if(GC.grid_sampling == 1){ // Grid cell corners (i.e., "0D" grid intersections) are sampled.
             for(const auto &c : corners){
@@ -565,9 +562,8 @@ Find_Corresponding_Points( Grid_Context &GC,
             throw std::logic_error("Invalid grid sampling method. Cannot continue.");
         }
 
-        (*c_it) = closest_proj;
-        ++c_it;
-    }
+        ICPC.p_corr[i] = closest_proj;
+    }, point_grain);
     return;
 }
 
@@ -704,16 +700,10 @@ Score_Fit( ICP_Context &ICPC,
            bool verbose = false){
 
     // Evaluate the fit using the corresponding points.
-    std::vector<double> dists;
-    dists.reserve(ICPC.p_corr.size());
-    auto c_it = std::begin(ICPC.p_corr);
-    for(const auto &P : ICPC.p_cell){
-        const auto C = (*c_it);
-        const auto dist = P.distance(C);
-        dists.emplace_back(dist);
-
-        ++c_it;
-    }
+    std::vector<double> dists(ICPC.p_corr.size());
+    parallel_for(0, static_cast<long int>(dists.size()), [&](long int i){
+        dists[i] = ICPC.p_cell[i].distance(ICPC.p_corr[i]);
+    }, point_grain);
 
     if(verbose){
         std::cout << " Score fit stats:    " << std::endl;
@@ -923,6 +913,7 @@ ICP_Fit_Grid( std::mt19937 re,
 static int icp_invoke = 0;
 
     for(long int loop = 1; loop <= icp_max_loops; ++loop){
+        throw_if_cancelled();
 //        std::cout << "====================================== " << "Loop: " << loop << std::endl;
 
         // Nominate a random point to be the rotation centre.
@@ -930,7 +921,7 @@ static int icp_invoke = 0;
         // Note: This *might* be wasteful, but it will also help protect against picking an irrelevant point and being
         // stuck with it for the entire ICP procedure. TODO: try commenting out this code to always use the ransac point
         // as the rotation centre.
-        std::uniform_int_distribution<long int> rd(0, ICPC.cohort.size());
+        std::uniform_int_distribution<long int> rd(0, static_cast<long int>(ICPC.cohort.size()) - 1);
         const auto N_select = rd(re);
         ICPC.rot_centre = (*std::next( std::begin(ICPC.cohort), N_select ));
 
@@ -1271,25 +1262,24 @@ if(false){
             return;
         };
 
+        // Index the points so the vicinity of each RANSAC centre can be gathered without scanning the whole cloud.
+        const ransac_cell_index cohort_index((*pcp_it)->pset.points, RANSACDist);
+
         // Perform a RANSAC analysis by only analyzing the vicinity of a randomly selected point.
         long int ransac_loop = 0;
         std::mutex saver_printer;
         while(ransac_loop < RANSACMaxLoops){
+            throw_if_cancelled();
             // Randomly select a point from the cloud.
-            std::uniform_int_distribution<long int> rd(0, (*pcp_it)->pset.points.size());
+            std::uniform_int_distribution<long int> rd(0, static_cast<long int>((*pcp_it)->pset.points.size()) - 1);
             const auto N = rd(re);
             ICPC.ransac_centre = (* std::next( std::begin((*pcp_it)->pset.points), N ));
 
-            // Retain only the points within a small distance of the RANSAC centre.
-            using pcp_t = decltype((*pcp_it)->pset.points.front());
-            ICPC.cohort = (*pcp_it)->pset.points;
-            ICPC.cohort.erase(
-                std::remove_if(std::begin(ICPC.cohort), 
-                               std::end(ICPC.cohort),
-                               [&](pcp_t &pcp) -> bool {
-                                   return (pcp.distance(ICPC.ransac_centre) > RANSACDist);
-                               }),
-                std::end(ICPC.cohort) );
+            // Retain only the points within a small distance of the RANSAC centre, in their original order.
+            ICPC.cohort.clear();
+            for(const auto i : cohort_index.within(ICPC.ransac_centre, RANSACDist)){
+                ICPC.cohort.push_back( (*pcp_it)->pset.points[i] );
+            }
 
             if(ICPC.cohort.size() < 3){
                 // If there are too few points to meaningfully continue, then the only thing we can assume is that the
@@ -16,19 +16,19 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../YgorImages_Functors/Analytic_Rasterization.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
-#include "../YgorImages_Functors/Grouping/Misc_Functors.h"
-#include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
+#include "../YgorImages_Functors/Voxel_Inclusion_Mask.h"
 
 #include "DrawGeometry.h"
 
@@ -41,6 +41,11 @@ OperationDoc OpArgDocDrawGeometry(){
     out.desc = 
         "This operation draws shapes and patterns on images."
         " Drawing is confined to one or more ROIs.";
+
+    out.notes.emplace_back(
+        "Shapes are rasterized analytically: the voxels covered by a shape are computed directly as spans for each"
+        " row, so only covered voxels are visited. Images are drawn concurrently."
+    );
         
     
     out.args.emplace_back();
@@ -111,7 +116,7 @@ OperationDoc OpArgDocDrawGeometry(){
     out.args.emplace_back();
     out.args.back().name = "Shapes";
     out.args.back().desc = "This parameter is used to specify the shapes and patterns to consider."
-                           " Currently grids, wireframecubes, and solidspheres are available."
+                           " Currently grids, wireframecubes, solidspheres, and planes are available."
                            " Grids have four configurable parameters: two orientation unit vectors, line thickness, and line separation."
                            " A grid intersecting at the image array's centre, aligned with (1.0,0.0,0.0) and (0.0,1.0,0.0), with"
                            " line thickness (i.e., diameter) 3.0 (DICOM units; mm), and separation 15.0 can be specified as"
@@ -123,14 +128,18 @@ OperationDoc OpArgDocDrawGeometry(){
                            " Solid spheres have two configurable parameters: a centre vector and a radius."
                            " A solid sphere at (1.0,2.0,3.0) with radius 15.0 (all DICOM units; mm) can be specified as"
                            " 'solidsphere(1.0,2.0,3.0, 15.0)'."
-                           " Grid, wireframecube, and solidsphere shapes only overwrite voxels that intersect the geometry"
-                           " (i.e., the surface if hollow or the internal volume if solid)"
+                           " Planes have three configurable parameters: a normal vector, a point on the plane, and a"
+                           " thickness. A plane with normal (0.0,0.0,1.0) through (1.0,2.0,3.0) that is 2.0 thick (all"
+                           " DICOM units; mm) can be specified as 'plane(0.0,0.0,1.0, 1.0,2.0,3.0, 2.0)'."
+                           " Grid, wireframecube, solidsphere, and plane shapes only overwrite voxels that intersect the"
+                           " geometry (i.e., the surface if hollow or the internal volume if solid)"
                            " permitting easier composition of multiple shapes or custom backgrounds.";
     out.args.back().default_val = "grid(-0.0941083,0.995562,0, 0.992667,0.0938347,0.0762047, 3.0, 15.0)";
     out.args.back().expected = true;
     out.args.back().examples = { "grid(1.0,0.0,0.0, 0.0,1.0,0.0, 3.0, 15.0)",
                                  "wireframecube(1.0,0.0,0.0, 0.0,1.0,0.0, 3.0, 15.0)",
-                                 "solidsphere(0.0,0.0,0.0, 15.0)"  };
+                                 "solidsphere(0.0,0.0,0.0, 15.0)",
+                                 "plane(0.0,0.0,1.0, 0.0,0.0,0.0, 2.0)" };
 
     return out;
 }
@@ -143,7 +152,7 @@ Drover DrawGeometry(Drover DICOM_data,
                     /*InvocationMetadata*/,
                     const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
@@ -182,12 +191,12 @@ Drover DrawGeometry(Drover DICOM_data,
     const auto regex_grid = Compile_Regex("^gr?i?d?.*$");
     const auto regex_wcube = Compile_Regex("^wi?r?e?f?r?a?m?e?c?u?b?e?.*$");
     const auto regex_ssph = Compile_Regex("^so?l?i?d?sp?h?e?r?e?.*$");
+    const auto regex_plane = Compile_Regex("^pl?a?n?e?.*$");
 
     const bool shape_is_grid = std::regex_match(ShapesStr, regex_grid);
     const bool shape_is_wcube = std::regex_match(ShapesStr, regex_wcube);
     const bool shape_is_ssph = std::regex_match(ShapesStr, regex_ssph);
-
-    std::function<void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &)> f_noop;
+    const bool shape_is_plane = std::regex_match(ShapesStr, regex_plane);
 
     const vec3<double> vec3_nan( std::numeric_limits<double>::quiet_NaN(),
                                  std::numeric_limits<double>::quiet_NaN(),
@@ -207,6 +216,10 @@ Drover DrawGeometry(Drover DICOM_data,
     vec3<double> ssph_centre = vec3_nan;
     double ssph_radius = std::numeric_limits<double>::quiet_NaN();
 
+    // Planes.
+    plane<double> plane_P(vec3_nan, vec3_nan);
+    double plane_half_thickness = std::numeric_limits<double>::quiet_NaN();
+
     if(shape_is_grid || shape_is_wcube){
         auto split = SplitStringToVector(ShapesStr, '(', 'd');
         split = SplitVector(split, ')', 'd');
@@ -261,6 +274,38 @@ Drover DrawGeometry(Drover DICOM_data,
 
         if(!std::isfinite(ssph_radius) || (ssph_radius <= 0.0)) throw std::invalid_argument("Sphere radius is invalid.");
         if(!ssph_centre.isfinite()) throw std::invalid_argument("Sphere centre is invalid.");
+
+    }else if(shape_is_plane){
+        auto split = SplitStringToVector(ShapesStr, '(', 'd');
+        split = SplitVector(split, ')', 'd');
+        split = SplitVector(split, ',', 'd');
+
+        std::vector<double> numbers;
+        for(const auto &w : split){
+           try{
+               const auto x = std::stod(w);
+               numbers.emplace_back(x);
+           }catch(const std::exception &){ }
+        }
+        if(numbers.size() != 7){
+            throw std::invalid_argument("Unable to parse plane shape parameters. Cannot continue.");
+        }
+
+        const auto N = vec3<double>( numbers.at(0),
+                                     numbers.at(1),
+                                     numbers.at(2) ).unit();
+        const auto R = vec3<double>( numbers.at(3),
+                                     numbers.at(4),
+                                     numbers.at(5) );
+        plane_half_thickness = numbers.at(6) * 0.5;
+
+        if(!N.isfinite()) throw std::invalid_argument("Plane normal is invalid.");
+        if(!R.isfinite()) throw std::invalid_argument("Plane point is invalid.");
+        if(!std::isfinite(plane_half_thickness) || (plane_half_thickness <= 0.0)){
+            throw std::invalid_argument("Plane thickness is invalid.");
+        }
+        plane_P = plane<double>(N, R);
+
     }else{
         throw std::invalid_argument("Shape not understood. Refusing to continue.");
     }
@@ -285,12 +330,13 @@ Drover DrawGeometry(Drover DICOM_data,
 
         ////////////////////////////////////////////////////////////
         // Grid pattern.
-        std::vector<line<double>> grid_lines;
+        vec3<double> grid_origin = vec3_nan;
+        long int N_lines = 0;
         if(shape_is_grid){
             const auto img_origin = img_refw.get().anchor + img_refw.get().offset;
             const auto img_centre = (*iap_it)->imagecoll.center();
 
-            const auto& grid_origin = img_centre; // Note: changing this will require changing N_lines below!
+            grid_origin = img_centre; // Note: changing this will require changing N_lines below!
 
             unit_z = unit_x.Cross(unit_y).unit();
             if(!unit_x.GramSchmidt_orthogonalize(unit_y, unit_z)){
@@ -306,35 +352,10 @@ Drover DrawGeometry(Drover DICOM_data,
                      << unit_z );
 
             // Ensure the image will be tiled with grid lines by ensuring the maximum spatial extent will be covered no
-            // matter how the grid is oriented.
+            // matter how the grid is oriented. Lines pass through the lattice points of each pair of unit vectors,
+            // within N_lines of the origin.
             const auto img_halfspan = (img_centre - img_origin).length();
-            const auto N_lines = static_cast<long int>(std::ceil(img_halfspan / grid_sep));
-
-            // Create the grid lines.
-            for(long int y = -N_lines; y <= N_lines; ++y){
-                for(long int z = -N_lines; z <= N_lines; ++z){
-                    const auto A = grid_origin + (unit_y * grid_sep * (y * 1.0))
-                                               + (unit_z * grid_sep * (z * 1.0));
-                    const auto B = A + unit_x;
-                    grid_lines.emplace_back(A, B);
-                }
-            }
-            for(long int x = -N_lines; x <= N_lines; ++x){
-                for(long int y = -N_lines; y <= N_lines; ++y){
-                    const auto A = grid_origin + (unit_x * grid_sep * (x * 1.0))
-                                               + (unit_y * grid_sep * (y * 1.0));
-                    const auto B = A + unit_z;
-                    grid_lines.emplace_back(A, B);
-                }
-            }
-            for(long int x = -N_lines; x <= N_lines; ++x){
-                for(long int z = -N_lines; z <= N_lines; ++z){
-                    const auto A = grid_origin + (unit_x * grid_sep * (x * 1.0))
-                                               + (unit_z * grid_sep * (z * 1.0));
-                    const auto B = A + unit_y;
-                    grid_lines.emplace_back(A, B);
-                }
-            }
+            N_lines = static_cast<long int>(std::ceil(img_halfspan / grid_sep));
         }
 
         ////////////////////////////////////////////////////////////
@@ -399,123 +420,72 @@ Drover DrawGeometry(Drover DICOM_data,
         ////////////////////////////////////////////////////////////
 
 
-        PartitionedImageVoxelVisitorMutatorUserData ud;
-
-        ud.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
-        ud.mutation_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
-        ud.mutation_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
-        ud.mutation_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
-        ud.description = "Drawn geometry";
+        Mutate_Voxels_Opts mutation_opts;
+        mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
+        mutation_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
+        mutation_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+        mutation_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
+        std::string description = "Drawn geometry";
 
         if(shape_is_wcube){
-            ud.description += ": wireframe cube";
+            description += ": wireframe cube";
         }else if(shape_is_grid){
-            ud.description += ": grid";
+            description += ": grid";
         }else if(shape_is_ssph){
-            ud.description += ": solid sphere";
+            description += ": solid sphere";
+        }else if(shape_is_plane){
+            description += ": plane";
         }else{
             throw std::invalid_argument("Shape not understood. Refusing to continue.");
         }
 
         if( std::regex_match(ContourOverlapStr, regex_ignore) ){
-            ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+            mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
         }else if( std::regex_match(ContourOverlapStr, regex_honopps) ){
-            ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
+            mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
         }else if( std::regex_match(ContourOverlapStr, regex_cancel) ){
-            ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations;
+            mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations;
         }else{
             throw std::invalid_argument("ContourOverlap argument '"_s + ContourOverlapStr + "' is not valid");
         }
         if( std::regex_match(InclusivityStr, regex_centre) ){
-            ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
+            mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
         }else if( std::regex_match(InclusivityStr, regex_pci) ){
-            ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
+            mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
         }else if( std::regex_match(InclusivityStr, regex_pce) ){
-            ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Exclusive;
+            mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Exclusive;
         }else{
             throw std::invalid_argument("Inclusivity argument '"_s + InclusivityStr + "' is not valid");
         }
 
-        // Create a functor for the specific geometry / shape.
-        std::function<void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &)> f_overwrite;
-
-
-        // Grid pattern.
-        if(shape_is_grid){
-            f_overwrite = [&]( long int row,
-                               long int col,
-                               long int chan,
-                               std::reference_wrapper<planar_image<float,double>> img_refw,
-                               float &voxel_val ) -> void {
-                if( (Channel < 0) || (Channel == chan) ){
-                    const auto pos = img_refw.get().position(row,col);
-
-                    for(const auto &l : grid_lines){
-                        const auto dist = l.Distance_To_Point(pos);
-                        if(dist < grid_rad){
-                            voxel_val = VoxelValue;
-                            return;
-                        }
-                    }
-                    //voxel_val = 0.0f;
-                    return;
-                }
-            };
-        }
-
-        // Cube pattern.
-        if(shape_is_wcube){
-            f_overwrite = [&]( long int row,
-                               long int col,
-                               long int chan,
-                               std::reference_wrapper<planar_image<float,double>> img_refw,
-                               float &voxel_val ) -> void {
-                if( (Channel < 0) || (Channel == chan) ){
-                    const auto pos = img_refw.get().position(row,col);
-
-                    for(const auto &l : wcube_lines){
-                        if(l.Within_Pill_Volume(pos, grid_rad)){
-                            voxel_val = VoxelValue;
-                            return;
-                        }
-                    }
-                    //voxel_val = 0.0f;
-                    return;
-                }
-            };
-        }
+        // Rasterize the shape on each image, confine it to the selected partition, and draw it.
+        std::vector<planar_image<float,double> *> imgs;
+        for(auto &img : (*iap_it)->imagecoll.images) imgs.push_back( &img );
+
+        parallel_for(0, static_cast<long int>(imgs.size()), [&](long int i) -> void {
+            auto &img = *(imgs[i]);
+
+            voxel_inclusion_mask covered;
+            if(shape_is_grid){
+                covered = Rasterize_Grid(img, grid_origin, unit_x, unit_y, unit_z, grid_sep, grid_rad, N_lines);
+            }else if(shape_is_wcube){
+                covered = Rasterize_Capsules(img, wcube_lines, grid_rad);
+            }else if(shape_is_ssph){
+                covered = Rasterize_Sphere(img, ssph_centre, ssph_radius);
+            }else{
+                covered = Rasterize_Slab(img, plane_P, plane_half_thickness);
+            }
 
-        // Sphere pattern.
-        if(shape_is_ssph){
-            f_overwrite = [&]( long int row,
-                               long int col,
-                               long int chan,
-                               std::reference_wrapper<planar_image<float,double>> img_refw,
-                               float &voxel_val ) -> void {
-                if( (Channel < 0) || (Channel == chan) ){
-                    const auto pos = img_refw.get().position(row,col);
-
-                    const auto dist = pos.distance(ssph_centre);
-                    if(dist <= ssph_radius){
-                        voxel_val = VoxelValue;
-                    }
-                    return;
-                }
-            };
-        }
+            if(!ShouldOverwriteInterior || !ShouldOverwriteExterior){
+                const auto bounded = Get_Voxel_Inclusion_Mask(img, cc_ROIs, mutation_opts);
+                covered = (ShouldOverwriteInterior) ? Intersect_Voxel_Spans(covered, *bounded)
+                                                    : Intersect_Voxel_Spans(covered, Invert_Voxel_Spans(*bounded));
+            }
+            Fill_Voxel_Spans(img, covered, Channel, static_cast<float>(VoxelValue));
 
-        // Enable the functor as necessary.
-        ud.f_bounded = f_noop;
-        ud.f_unbounded = f_noop;
-        ud.f_visitor = f_noop;
-        if(ShouldOverwriteInterior) ud.f_bounded = f_overwrite;
-        if(ShouldOverwriteExterior) ud.f_unbounded = f_overwrite;
-
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
-            throw std::runtime_error("Unable to draw geometry within the specified ROI(s).");
-        }
+            UpdateImageDescription( std::ref(img), description );
+            UpdateImageWindowCentreWidth( std::ref(img) );
+        }, 1);
     }
 
     return DICOM_data;
@@ -14,6 +14,7 @@
 
 #include "../Structs.h"
 #include "../Alignment_TPSRPM.h"
+#include "../Alignment_Field.h"
 #include "../Regex_Selectors.h"
 
 #include "DroverDebug.h"
@@ -267,6 +268,8 @@ Drover DroverDebug(Drover DICOM_data,
                         return "an affine transformation";
                     }else if constexpr (std::is_same_v<V, thin_plate_spline>){
                         return "a thin-plate spline transformation";
+                    }else if constexpr (std::is_same_v<V, deformation_field>){
+                        return "a deformation field transformation";
                     }else{
                         static_assert(std::is_same_v<V,void>, "Transformation not understood.");
                     }
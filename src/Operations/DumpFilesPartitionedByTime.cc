@@ -1,13 +1,16 @@
 //DumpFilesPartitionedByTime.cc - A part of DICOMautomaton 2015, 2016. Written by hal clark.
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <list>
 #include <map>
 #include <memory>
 #include <string>    
-#include <utility>            //Needed for std::pair.
+#include <vector>
 
 #include "../Structs.h"
+#include "../Time_Course_Tensor.h"
 #include "DumpFilesPartitionedByTime.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -30,19 +33,32 @@ Drover DumpFilesPartitionedByTime(Drover DICOM_data,
                                   const std::map<std::string, std::string>& /*InvocationMetadata*/,
                                   const std::string& /*FilenameLex*/){
 
-    std::multimap<std::string,std::string> partitions;
+    //Images are ordered numerically by time using each array's (cached) temporal index. Ties retain the order of
+    // the arrays and images.
+    struct entry_t {
+        double t;
+        std::string dt;
+        std::string filename;
+    };
+    std::vector<entry_t> partitions;
     for(auto &img_arr : DICOM_data.image_data){
-        for(auto &img : img_arr->imagecoll.images){
-            if(!img.MetadataKeyPresent("dt")){
-                FUNCWARN("Time key is not present for file '" << img.metadata["StoreFullPathName"] << "'. Omitting it");
-                continue;
-            }
-            partitions.insert( std::make_pair( img.metadata["dt"],
-                                               img.metadata["StoreFullPathName"] ) );
+        const auto index = img_arr->get_temporal_index();
+        for(const auto &img : index->get_untimed_images()){
+            FUNCWARN("Time key is not present or not numeric for file '"
+                     << img->GetMetadataValueAs<std::string>("StoreFullPathName").value_or("") << "'. Omitting it");
+        }
+        const auto &imgs = index->get_images();
+        const auto &times = index->get_times();
+        for(size_t i = 0; i < imgs.size(); ++i){
+            partitions.push_back( { times[i],
+                                    imgs[i]->GetMetadataValueAs<std::string>("dt").value_or(""),
+                                    imgs[i]->GetMetadataValueAs<std::string>("StoreFullPathName").value_or("") } );
         }
     } 
-    for(const auto &apair : partitions){
-        std::cout << apair.first << " " << apair.second << std::endl;
+    std::stable_sort(std::begin(partitions), std::end(partitions),
+                     [](const entry_t &L, const entry_t &R) -> bool { return L.t < R.t; });
+    for(const auto &p : partitions){
+        std::cout << p.dt << " " << p.filename << std::endl;
     } 
 
     return DICOM_data;
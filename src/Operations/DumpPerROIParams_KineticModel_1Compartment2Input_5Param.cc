@@ -382,17 +382,24 @@ Drover DumpPerROIParams_KineticModel_1Compartment2Input_5Param(
 
                                 double RSS = 0.0;
                                 try{
-                                    for(auto & ROIsample : ROI_time_course.samples){
+                                    if(HaveModel == Have_1Compartment2Input_5Param_Chebyshev_Model){
+                                        //Evaluate all samples at once so the kernel integrals are only built once.
+                                        std::vector<double> ts;
+                                        ts.reserve(ROI_time_course.samples.size());
+                                        for(const auto & ROIsample : ROI_time_course.samples) ts.push_back(ROIsample[0]);
+
+                                        std::vector<KineticModel_1Compartment2Input_5Param_Chebyshev_Results> eval_res;
+                                        Evaluate_Model(model_5params_cheby,ts,eval_res);
+                                        for(size_t i = 0; i < ts.size(); ++i){
+                                            RSS += std::pow(eval_res[i].I - ROI_time_course.samples[i][2], 2.0);
+                                        }
+                                    }else for(auto & ROIsample : ROI_time_course.samples){
                                         const double t = ROIsample[0];
                                         const double f = ROIsample[2];
                                         if(HaveModel == Have_1Compartment2Input_5Param_LinearInterp_Model){
                                             KineticModel_1Compartment2Input_5Param_LinearInterp_Results eval_res;
                                             Evaluate_Model(model_5params_linear,t,eval_res);
                                             RSS += std::pow(eval_res.I - f, 2.0);
-                                        }else if(HaveModel == Have_1Compartment2Input_5Param_Chebyshev_Model){
-                                            KineticModel_1Compartment2Input_5Param_Chebyshev_Results eval_res;
-                                            Evaluate_Model(model_5params_cheby,t,eval_res);
-                                            RSS += std::pow(eval_res.I - f, 2.0);
                                         }else if(HaveModel == Have_1Compartment2Input_Reduced3Param_Chebyshev_Model){
                                             KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_Results eval_res;
                                             Evaluate_Model(model_3params_cheby,t,eval_res);
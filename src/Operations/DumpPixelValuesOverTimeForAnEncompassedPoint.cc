@@ -5,11 +5,13 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>    
 #include <utility>            //Needed for std::pair.
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Time_Course_Tensor.h"
 #include "DumpPixelValuesOverTimeForAnEncompassedPoint.h"
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -33,21 +35,32 @@ Drover DumpPixelValuesOverTimeForAnEncompassedPoint(Drover DICOM_data,
                                                     const std::map<std::string, std::string>& /*InvocationMetadata*/,
                                                     const std::string& /*FilenameLex*/){
 
-    const auto apoint = DICOM_data.image_data.front()->imagecoll.images.front().center();
-    auto encompassing_images = DICOM_data.image_data.front()->imagecoll.get_images_which_encompass_point(apoint);
+    auto img_arr = DICOM_data.image_data.front();
+    const auto &first_img = img_arr->imagecoll.images.front();
+    const auto apoint = first_img.center();
     const int channel = 0;
 
+    //The spatially-overlapping images are ordered temporally, and the point's values are stored contiguously.
+    const auto tensor = img_arr->get_time_course_tensor();
+    const auto group = tensor->find_group(&first_img);
+    const auto index = first_img.index(apoint, channel);
+    if( (group == nullptr) || (index < 0) ){
+        throw std::logic_error("Unable to locate the point's time course");
+    }
+    const float *series = group->get_series(index);
+
     std::cout << "time\t";
     std::cout << "pixel intensity\t";
     std::cout << "modality\t";
     std::cout << "image center\t";
     std::cout << "image volume" << std::endl;
-    for(const auto &img_it : encompassing_images){
-        std::cout << img_it->metadata.find("FrameReferenceTime")->second << "\t";
-        std::cout << img_it->value(apoint, channel) << "\t";
-        std::cout << img_it->metadata.find("Modality")->second << "\t";
-        std::cout << img_it->center() << "\t";
-        std::cout << (img_it->rows * img_it->columns * img_it->pxl_dx * img_it->pxl_dy * img_it->pxl_dz) << std::endl;
+    for(size_t t = 0; t < group->size(); ++t){
+        const auto &img = group->get_images()[t];
+        std::cout << img->metadata.find("FrameReferenceTime")->second << "\t";
+        std::cout << series[t] << "\t";
+        std::cout << img->metadata.find("Modality")->second << "\t";
+        std::cout << img->center() << "\t";
+        std::cout << (img->rows * img->columns * img->pxl_dx * img->pxl_dy * img->pxl_dz) << std::endl;
     }
 
     return DICOM_data;
@@ -10,6 +10,7 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
@@ -19,11 +20,13 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Bounded_Dose.h"
+#include "../Distribution_Sketch.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
+#include "../YgorImages_Functors/ROI_Voxels.h"
 #include "DumpROISNR.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -46,6 +49,11 @@ OperationDoc OpArgDocDumpROISNR(){
         " course it may be more sensible to aggregate images in some way (e.g., spatial averaging) prior to calling"
         " this routine."
     );
+    out.notes.emplace_back(
+        "Voxels are bounded by an ROI when their centres are bounded by any of the ROI's contours. Voxels bounded by"
+        " several contours are counted once. The bounded voxels are shared with other reports (e.g.,"
+        " ExtractRadiomicFeatures) over the same images and ROIs, so the images are only traversed once."
+    );
 
 
     out.args.emplace_back();
@@ -87,7 +95,7 @@ Drover DumpROISNR(Drover DICOM_data,
 
     //-----------------------------------------------------------------------------------------------------------------
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //Merge the image arrays if necessary.
     if(DICOM_data.image_data.empty()){
@@ -120,11 +128,31 @@ Drover DumpROISNR(Drover DICOM_data,
         patient_ID = "unknown_patient";
     }
 
-    //Accumulate the voxel intensity distributions.
-    AccumulatePixelDistributionsUserData ud;
-    if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
-                                               cc_ROIs, &ud )){
-        throw std::runtime_error("Unable to accumulate pixel distributions.");
+    //Group the contours by ROI.
+    std::map<std::string, ROI_Voxels::ccsl_t> ROIs;
+    for(const auto &cc_refw : cc_ROIs){
+        if(cc_refw.get().contours.empty()) continue;
+        const auto ROIName = cc_refw.get().contours.front().GetMetadataValueAs<std::string>("ROIName");
+        if(!ROIName){
+            throw std::invalid_argument("Missing necessary tags for reporting analysis results. Cannot continue.");
+        }
+        ROIs[ROIName.value()].push_back(cc_refw);
+    }
+
+    //Summarize the voxel intensity distributions.
+    struct roi_summary_t {
+        running_moments moments;
+        double median = std::numeric_limits<double>::quiet_NaN();
+    };
+    std::map<std::string, roi_summary_t> summaries;
+    for(const auto &roi : ROIs){
+        const auto voxels = Get_ROI_Voxels(*img_arr_ptr, roi.second);
+        if(voxels->size() == 0) continue;
+
+        auto vals = voxels->get_combined_values();
+        auto &summary = summaries[roi.first];
+        for(const auto &v : vals) summary.moments.digest(v);
+        summary.median = Dose_Quantiles(vals, { 0.5 }).front();
     }
 
     //Report the findings. 
@@ -143,11 +171,11 @@ Drover DumpROISNR(Drover DICOM_data,
         if(!FO_snr){
             throw std::runtime_error("Unable to open file for reporting derivative data. Cannot continue.");
         }
-        for(const auto &av : ud.accumulated_voxels){
+        for(const auto &av : summaries){
             const auto lROIname = av.first;
-            const auto PixelMean = Stats::Mean( av.second );
-            const auto PixelMedian = Stats::Median( av.second );
-            const auto PixelStdDev = std::sqrt(Stats::Unbiased_Var_Est( av.second ));
+            const auto PixelMean = av.second.moments.mean();
+            const auto PixelMedian = av.second.median;
+            const auto PixelStdDev = std::sqrt(av.second.moments.unbiased_variance());
 
             FO_snr  << "PatientID='" << patient_ID << "',"
                       << "NormalizedROIname='" << X(lROIname) << "',"
@@ -156,7 +184,7 @@ Drover DumpROISNR(Drover DICOM_data,
                       << "PixelMedian=" << PixelMedian << ","
                       << "PixelStdDev=" << PixelStdDev << ","
                       << "SNR=" << PixelMean/PixelStdDev << ","
-                      << "VoxelCount=" << av.second.size() << std::endl;
+                      << "VoxelCount=" << av.second.moments.count() << std::endl;
         }
         FO_snr.flush();
         FO_snr.close();
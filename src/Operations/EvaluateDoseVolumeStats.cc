@@ -19,11 +19,11 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
+#include "../YgorImages_Functors/Dose_Volume_Stats.h"
 #include "EvaluateDoseVolumeStats.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -130,7 +130,7 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data,
     const auto theregex_Body = Compile_Regex(BodyROILabelRegex);
     const auto thenormalizedregex_Body = Compile_Regex(BodyNormalizedROILabelRegex);
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
 
     //Merge the image arrays if necessary.
@@ -195,63 +195,39 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data,
         patient_ID = "unknown_person";
     }
 
-    //Accumulate the voxel intensity distributions.
-    AccumulatePixelDistributionsUserData ud_PTV;
-    if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
-                                               cc_PTV_ROIs, &ud_PTV )){
-        throw std::runtime_error("Unable to accumulate PTV pixel distributions.");
-    }
-    AccumulatePixelDistributionsUserData ud_Body;
-    if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
-                                               cc_Body_ROIs, &ud_Body )){
-        throw std::runtime_error("Unable to accumulate Body pixel distributions.");
-    }
-
-
+    //Accumulate the dose-volume statistics. PTV voxels are retained so the dose percentiles are exact.
     const auto Dpres95 = 0.95 * PTVPrescriptionDose;
-    long int N_Body_over_Dpres95 = 0; //We assume all body ROIs are part of a single object.
+    dose_volume_options dv_opts;
+    dv_opts.thresholds = { Dpres95 };
+    const auto dvs_Body = Compute_Dose_Volume_Stats(img_arr_ptr->imagecoll, cc_Body_ROIs, dv_opts);
+
+    dv_opts.retain_voxels = true;
+    const auto dvs_PTV = Compute_Dose_Volume_Stats(img_arr_ptr->imagecoll, cc_PTV_ROIs, dv_opts);
 
     //Evalute the models.
-    {
-        for(auto &av : ud_Body.accumulated_voxels){
-            for(const auto &D_voxel : av.second){
-                if(D_voxel > Dpres95) ++N_Body_over_Dpres95;
-            }
-            av.second.clear(); // Reduce memory pressure.
-        }
+    double V_Body_over_Dpres95 = 0.0; //We assume all body ROIs are part of a single object.
+    for(const auto &dvs : dvs_Body){
+        V_Body_over_Dpres95 += dvs.second.volume_above.front();
     }
 
     std::map<std::string, double> HI; // Heterogeneity index.
     std::map<std::string, double> CN; // Conformity number.
-
-    std::map<std::string, long int> N_PTV_over_Dpres95; //We assume all PTV ROIs are distinct.
-    {
-        for(const auto &av : ud_PTV.accumulated_voxels){
-            const auto lROIname = av.first;
-
-            const auto D_02 = Stats::Percentile(av.second, 0.98); // D_02 == 98% dose percentile.
-            const auto D_50 = Stats::Percentile(av.second, 0.50);
-            const auto D_98 = Stats::Percentile(av.second, 0.02); // D_98 == 2% dose percentile.
-
-            HI[lROIname] = (D_02 - D_98)/D_50;
-
-            long int N_over_Dpres95 = 0;
-            for(const auto &D_voxel : av.second){
-                if(D_voxel > Dpres95) ++N_over_Dpres95;
-            }
-            N_PTV_over_Dpres95[lROIname] += N_over_Dpres95;
-        }
-        for(const auto &av : ud_PTV.accumulated_voxels){
-            const auto lROIname = av.first;
-            const auto N = av.second.size();
-            //const long double V_frac = static_cast<long double>(1) / N; // Fractional volume of a single voxel compared to whole ROI.
-
-            const auto N_T = static_cast<double>(N);
-            const auto N_T_pres = static_cast<double>(N_PTV_over_Dpres95[lROIname]);
-            const auto N_pres = static_cast<double>(N_Body_over_Dpres95);
-
-            CN[lROIname] = (N_T_pres * N_T_pres) / (N_T * N_pres);
-        }
+    std::map<std::string, double> DoseMedians;
+    for(const auto &dvs : dvs_PTV){
+        const auto lROIname = dvs.first;
+        const auto &s = dvs.second;
+
+        const auto percentiles = s.Quantiles({ 0.98, 0.50, 0.02 });
+        const auto D_02 = percentiles[0]; // D_02 == 98% dose percentile.
+        const auto D_50 = percentiles[1];
+        const auto D_98 = percentiles[2]; // D_98 == 2% dose percentile.
+        HI[lROIname] = (D_02 - D_98)/D_50;
+        DoseMedians[lROIname] = D_50;
+
+        const auto V_T = s.volume;
+        const auto V_T_pres = s.volume_above.front();
+        const auto V_pres = V_Body_over_Dpres95;
+        CN[lROIname] = (V_T_pres * V_T_pres) / (V_T * V_pres);
     }
 
 
@@ -288,13 +264,14 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data,
                    << "VoxelCount"
                    << std::endl;
         }
-        for(const auto &av : ud_PTV.accumulated_voxels){
-            const auto lROIname = av.first;
-            const auto DoseMin = Stats::Min( av.second );
-            const auto DoseMean = Stats::Mean( av.second );
-            const auto DoseMedian = Stats::Median( av.second );
-            const auto DoseMax = Stats::Max( av.second );
-            const auto DoseStdDev = std::sqrt(Stats::Unbiased_Var_Est( av.second ));
+        for(const auto &dvs : dvs_PTV){
+            const auto lROIname = dvs.first;
+            const auto &s = dvs.second;
+            const auto DoseMin = s.moments.min();
+            const auto DoseMean = s.moments.mean();
+            const auto DoseMedian = DoseMedians[lROIname];
+            const auto DoseMax = s.moments.max();
+            const auto DoseStdDev = std::sqrt(s.moments.unbiased_variance());
             const auto HeterogeneityIndex = HI[lROIname];
             const auto ConformityNumber = CN[lROIname];
 
@@ -309,7 +286,7 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data,
                     << DoseMedian         << ","
                     << DoseMax            << ","
                     << DoseStdDev         << ","
-                    << av.second.size()
+                    << s.moments.count()
                     << std::endl;
         }
         FO_tcp.flush();
@@ -19,18 +19,33 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
+#include "../YgorImages_Functors/Dose_Volume_Stats.h"
 #include "EvaluateNTCPModels.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorStats.h"        //Needed for Stats:: namespace.
+#include "YgorString.h"       //Needed for SplitStringToVector().
 
 
+namespace {
+
+// Parses a comma-separated list of model parameters.
+std::vector<double> parse_parameter_list(const std::string &s){
+    std::vector<double> out;
+    for(const auto &token : SplitStringToVector(s, ',', 'd')){
+        out.push_back( std::stod(token) );
+    }
+    if(out.empty()) throw std::invalid_argument("No model parameters provided. Cannot continue.");
+    return out;
+}
+
+} // namespace
+
 
 OperationDoc OpArgDocEvaluateNTCPModels(){
     OperationDoc out;
@@ -60,6 +75,12 @@ OperationDoc OpArgDocEvaluateNTCPModels(){
         " Huang et al. 2015 (doi:10.1038/srep18010) used alpha=1 for the LKB model and alpha=5 for the mEUD model."
     );
 
+    out.notes.emplace_back(
+        "When multiple values are provided for any LKB parameter, a row is written for every combination of LKB"
+        " parameters, and the parameters are appended as columns. Voxel doses are traversed only once regardless of"
+        " the number of combinations. Sweeps should be written to a separate file, since the columns differ."
+    );
+
 
     out.args.emplace_back();
     out.args.back().name = "NTCPFileName";
@@ -138,18 +159,20 @@ OperationDoc OpArgDocEvaluateNTCPModels(){
     out.args.emplace_back();
     out.args.back().name = "LKB_TD50";
     out.args.back().desc = "The dose (in Gray) needed to deliver to the selected OAR that will induce the effect in 50%"
-                           " of cases.";
+                           " of cases. Multiple comma-separated values can be provided to evaluate every LKB"
+                           " parameter combination.";
     out.args.back().default_val = "26.8";
     out.args.back().expected = true;
-    out.args.back().examples = { "26.8" };
+    out.args.back().examples = { "26.8", "20,25,30" };
 
 
     out.args.emplace_back();
     out.args.back().name = "LKB_M";
-    out.args.back().desc = "No description given...";
+    out.args.back().desc = "No description given... Multiple comma-separated values can be provided to evaluate"
+                           " every LKB parameter combination.";
     out.args.back().default_val = "0.45";
     out.args.back().expected = true;
-    out.args.back().examples = { "0.45" };
+    out.args.back().examples = { "0.45", "0.3,0.45,0.6" };
 
 
     out.args.emplace_back();
@@ -174,10 +197,11 @@ OperationDoc OpArgDocEvaluateNTCPModels(){
                       " spans [1:40]. AAPM TG report 166 also provides a listing of recommended values,"
                       " suggesting -10 for PTV and GTV, +1 for parotid, 20 for spinal cord, and 8-16 for"
                       " rectum, bladder, brainstem, chiasm, eye, and optic nerve. Burman (1991) and QUANTEC"
-                      " (2010) also provide estimates.";
+                      " (2010) also provide estimates."
+                      " Multiple comma-separated values can be provided to evaluate every LKB parameter combination.";
     out.args.back().default_val = "1.0";
     out.args.back().expected = true;
-    out.args.back().examples = { "1", "3", "4", "20", "31" };
+    out.args.back().examples = { "1", "3", "4", "20", "31", "1,2,4,8" };
 
 
     out.args.emplace_back();
@@ -205,9 +229,9 @@ Drover EvaluateNTCPModels(Drover DICOM_data,
     const auto ROILabelRegex = OptArgs.getValueStr("ROILabelRegex").value();
     const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
 
-    const auto LKB_M = std::stod( OptArgs.getValueStr("LKB_M").value() );
-    const auto LKB_TD50 = std::stod( OptArgs.getValueStr("LKB_TD50").value() );
-    const auto LKB_Alpha = std::stod( OptArgs.getValueStr("LKB_Alpha").value() );
+    const auto LKB_Ms = parse_parameter_list( OptArgs.getValueStr("LKB_M").value() );
+    const auto LKB_TD50s = parse_parameter_list( OptArgs.getValueStr("LKB_TD50").value() );
+    const auto LKB_Alphas = parse_parameter_list( OptArgs.getValueStr("LKB_Alpha").value() );
 
     const auto UserComment = OptArgs.getValueStr("UserComment");
 
@@ -222,7 +246,8 @@ Drover EvaluateNTCPModels(Drover DICOM_data,
 
     //-----------------------------------------------------------------------------------------------------------------
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
+    const bool IsSweep = (1 < LKB_Ms.size()) || (1 < LKB_TD50s.size()) || (1 < LKB_Alphas.size());
 
     //Merge the image arrays if necessary.
     if(DICOM_data.image_data.empty()){
@@ -255,85 +280,78 @@ Drover EvaluateNTCPModels(Drover DICOM_data,
         patient_ID = "unknown_patient";
     }
 
-    //Accumulate the voxel intensity distributions.
-    AccumulatePixelDistributionsUserData ud;
-    if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
-                                               cc_ROIs, &ud )){
-        throw std::runtime_error("Unable to accumulate pixel distributions.");
+    //Accumulate the dose-volume statistics. Voxels are retained so every parameter combination can be evaluated
+    // without re-traversing the images.
+    dose_volume_options dv_opts;
+    dv_opts.retain_voxels = true;
+
+    // LKB model.
+    //
+    // Note: Assumes voxel doses are EQD2. Pre-convert if the RT plan is not already in 2Gy/fraction!
+    std::vector<std::function<double(double)>> LKB_integrands;
+    for(const auto LKB_Alpha : LKB_Alphas){
+        LKB_integrands.emplace_back([=](double D_voxel) -> double {
+            const auto scaled = std::pow(D_voxel, LKB_Alpha); //Problematic for (non-physical) 0.0.
+            return std::isfinite(scaled) ? scaled : 0.0;
+        });
     }
 
+    // mEUD model.
+    //
+    // Note: Assumes voxel doses are EQD2. Pre-convert if the RT plan is not already in 2Gy/fraction!
+    //NOTE: this model only uses the 100c with the highest dose. So sort and filter the voxels before computing mEUD!
+    // Also, the model presented by Huang et al. is underspecified in their paper. Check the original for more
+    // comprehensive explanation.
+
+    const auto dvs_ROIs = Compute_Dose_Volume_Stats(img_arr_ptr->imagecoll, cc_ROIs, dv_opts);
+
     //Evalute the models.
-    std::map<std::string, double> LKBModel;
+    struct LKB_result_t {
+        double TD50;
+        double M;
+        double Alpha;
+        double NTCP;
+    };
+    std::map<std::string, std::vector<LKB_result_t>> LKBModel;
     std::map<std::string, double> FenwickModel;
 //    std::map<std::string, double> mEUDModel;
-    {
-        for(const auto &av : ud.accumulated_voxels){
-            const auto lROIname = av.first;
-
-            const auto N = av.second.size();
-            const long double V_frac = static_cast<long double>(1) / N; // Fractional volume of a single voxel compared to whole ROI.
-
-            std::vector<double> LKB_gEUD_elements;
-//            std::vector<double> mEUD_elements;
-            LKB_gEUD_elements.reserve(N);
-//            mEUD_elements.reserve(N);
-            for(const auto &D_voxel : av.second){
-                // LKB model.
-                //
-                // Note: Assumes voxel doses are EQD2. Pre-convert if the RT plan is not already in 2Gy/fraction!
-                {
-                    const auto scaled = std::pow(D_voxel, LKB_Alpha); //Problematic for (non-physical) 0.0.
-                    if(std::isfinite(scaled)){
-                        LKB_gEUD_elements.push_back(V_frac * std::pow(D_voxel, LKB_Alpha));
-                    }else{
-                        LKB_gEUD_elements.push_back(0.0); //No real need to include this except acknowledging what we are doing.
+    for(const auto &dvs : dvs_ROIs){
+        const auto lROIname = dvs.first;
+        const auto &s = dvs.second;
+
+        {
+            const auto OAR_mean_dose = s.moments.mean();
+            const auto numer = OAR_mean_dose - 29.2;
+            const auto denom = 13.1 * std::sqrt(2);
+            const auto t = numer/denom;
+            const auto NTCP_Fenwick = 0.5*(1.0 + std::erf(t));
+            FenwickModel[lROIname] = NTCP_Fenwick;
+        }
+        {
+            const auto integrals = Integrate_Retained_Voxels(s, LKB_integrands);
+            for(size_t a = 0; a < LKB_Alphas.size(); ++a){
+                const auto LKB_gEUD = std::pow(integrals[a] / s.volume, 1.0 / LKB_Alphas[a]);
+                for(const auto LKB_TD50 : LKB_TD50s){
+                    for(const auto LKB_M : LKB_Ms){
+                        const auto numer = LKB_gEUD - LKB_TD50;
+                        const auto denom = LKB_M * LKB_TD50 * std::sqrt(2.0);
+                        const auto t = numer/denom;
+                        const auto NTCP_LKB = 0.5*(1.0 + std::erf(t));
+                        LKBModel[lROIname].push_back({ LKB_TD50, LKB_M, LKB_Alphas[a], NTCP_LKB });
                     }
                 }
-                
-                // mEUD model.
-                //
-                // Note: Assumes voxel doses are EQD2. Pre-convert if the RT plan is not already in 2Gy/fraction!
-                {
-//NOTE: this model only uses the 100c with the highest dose. So sort and filter the voxels before computing mEUD!
-// Also, the model presented by Huang et al. is underspecified in their paper. Check the original for more comprehensive
-// explanation.
-//                    gEUD_elements.push_back(V_frac * std::pow(D_voxel, gEUD_Alpha));
-                }
-
-                // ... other models ...
-                // ...
-
-            }
-
-            //Post-processing.
-            {
-                const auto OAR_mean_dose = Stats::Mean(av.second);
-                const auto numer = OAR_mean_dose - 29.2;
-                const auto denom = 13.1 * std::sqrt(2);
-                const auto t = numer/denom;
-                const auto NTCP_Fenwick = 0.5*(1.0 + std::erf(t));
-                FenwickModel[lROIname] = NTCP_Fenwick;
-            }
-            {
-                const auto LKB_gEUD = std::pow( Stats::Sum(LKB_gEUD_elements), 1.0 / LKB_Alpha );
-
-                const auto numer = LKB_gEUD - LKB_TD50;
-                const auto denom = LKB_M * LKB_TD50 * std::sqrt(2.0);
-                const auto t = numer/denom;
-                const auto NTCP_LKB = 0.5*(1.0 + std::erf(t));
-                LKBModel[lROIname] = NTCP_LKB;
             }
-            {
+        }
+        {
 /*
-                const double mEUD = std::pow( Stats::Sum(mEUD_elements), 1.0 / EUD_Alpha );
+            const double mEUD = std::pow( Stats::Sum(mEUD_elements), 1.0 / EUD_Alpha );
 
-                const double numer = std::pow(mEUD, EUD_Gamma50*4);
-                const double denom = numer + std::pow(EUD_TCD50, EUD_Gamma50*4);
-                double NTCP_mEUD = numer/denom; // This is a sigmoid curve.
+            const double numer = std::pow(mEUD, EUD_Gamma50*4);
+            const double denom = numer + std::pow(EUD_TCD50, EUD_Gamma50*4);
+            double NTCP_mEUD = numer/denom; // This is a sigmoid curve.
 
-                mEUDModel[lROIname] = NTCP_mEUD; 
+            mEUDModel[lROIname] = NTCP_mEUD; 
 */
-            }
         }
     }
 
@@ -369,34 +387,46 @@ Drover EvaluateNTCPModels(Drover DICOM_data,
                    << "DoseMedian,"
                    << "DoseMax,"
                    << "DoseStdDev,"
-                   << "VoxelCount"
-                   << std::endl;
+                   << "VoxelCount";
+            if(IsSweep){
+                FO_tcp << ",LKB_TD50,"
+                       << "LKB_M,"
+                       << "LKB_Alpha";
+            }
+            FO_tcp << std::endl;
         }
-        for(const auto &av : ud.accumulated_voxels){
-            const auto lROIname = av.first;
-            const auto DoseMin = Stats::Min( av.second );
-            const auto DoseMean = Stats::Mean( av.second );
-            const auto DoseMedian = Stats::Median( av.second );
-            const auto DoseMax = Stats::Max( av.second );
-            const auto DoseStdDev = std::sqrt(Stats::Unbiased_Var_Est( av.second ));
-            const auto NTCPLKB = LKBModel[lROIname];
+        for(const auto &dvs : dvs_ROIs){
+            const auto lROIname = dvs.first;
+            const auto &s = dvs.second;
+            const auto DoseMin = s.moments.min();
+            const auto DoseMean = s.moments.mean();
+            const auto DoseMedian = s.Quantiles({ 0.5 }).front();
+            const auto DoseMax = s.moments.max();
+            const auto DoseStdDev = std::sqrt(s.moments.unbiased_variance());
 //            const auto NTCPmEUD = mEUDModel[lROIname];
             const auto NTCPFenwick = FenwickModel[lROIname];
 
-            FO_tcp  << UserComment.value_or("") << ","
-                    << patient_ID        << ","
-                    << lROIname          << ","
-                    << X(lROIname)       << ","
-                    << NTCPLKB*100.0     << ","
-//                    << NTCPmEUD*100.0    << ","
-                    << NTCPFenwick*100.0 << ","
-                    << DoseMin           << ","
-                    << DoseMean          << ","
-                    << DoseMedian        << ","
-                    << DoseMax           << ","
-                    << DoseStdDev        << ","
-                    << av.second.size()
-                    << std::endl;
+            for(const auto &LKB : LKBModel[lROIname]){
+                FO_tcp  << UserComment.value_or("") << ","
+                        << patient_ID        << ","
+                        << lROIname          << ","
+                        << X(lROIname)       << ","
+                        << LKB.NTCP*100.0    << ","
+//                        << NTCPmEUD*100.0    << ","
+                        << NTCPFenwick*100.0 << ","
+                        << DoseMin           << ","
+                        << DoseMean          << ","
+                        << DoseMedian        << ","
+                        << DoseMax           << ","
+                        << DoseStdDev        << ","
+                        << s.moments.count();
+                if(IsSweep){
+                    FO_tcp << "," << LKB.TD50
+                           << "," << LKB.M
+                           << "," << LKB.Alpha;
+                }
+                FO_tcp << std::endl;
+            }
         }
         FO_tcp.flush();
         FO_tcp.close();
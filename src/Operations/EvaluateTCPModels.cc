@@ -20,18 +20,33 @@
 #include <vector>
 
 #include "../Contour_Collection_Estimates.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
+#include "../YgorImages_Functors/Dose_Volume_Stats.h"
 #include "EvaluateTCPModels.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorStats.h"        //Needed for Stats:: namespace.
+#include "YgorString.h"       //Needed for SplitStringToVector().
 
 
+namespace {
+
+// Parses a comma-separated list of model parameters.
+std::vector<double> parse_parameter_list(const std::string &s){
+    std::vector<double> out;
+    for(const auto &token : SplitStringToVector(s, ',', 'd')){
+        out.push_back( std::stod(token) );
+    }
+    if(out.empty()) throw std::invalid_argument("No model parameters provided. Cannot continue.");
+    return out;
+}
+
+} // namespace
+
 
 OperationDoc OpArgDocEvaluateTCPModels(){
     OperationDoc out;
@@ -64,6 +79,12 @@ OperationDoc OpArgDocEvaluateTCPModels(){
         " equality of D_{50}. However, the difference seems relatively insignificant.)"
     );
 
+    out.notes.emplace_back(
+        "When multiple values are provided for any model parameter, a row is written for every combination of"
+        " parameters, and the parameters are appended as columns. Voxel doses are traversed only once regardless of"
+        " the number of combinations. Sweeps should be written to a separate file, since the columns differ."
+    );
+
 
     out.args.emplace_back();
     out.args.back().name = "TCPFileName";
@@ -96,10 +117,11 @@ OperationDoc OpArgDocEvaluateTCPModels(){
                       " 4th Edition by Joiner et al., sections 5.3-5.5.) This parameter is empirically"
                       " fit and not universal. Late endpoints for normal tissues have gamma_50 around 2-6"
                       " whereas gamma_50 nominally varies around 1.5-2.5 for local control of squamous"
-                      " cell carcinomas of the head and neck.";
+                      " cell carcinomas of the head and neck."
+                      " Multiple comma-separated values can be provided to evaluate every combination of parameters.";
     out.args.back().default_val = "2.3";
     out.args.back().expected = true;
-    out.args.back().examples = { "1.5", "2", "2.5", "6" };
+    out.args.back().examples = { "1.5", "2", "2.5", "6", "1.5,2,2.5" };
 
     
     out.args.emplace_back();
@@ -112,10 +134,11 @@ OperationDoc OpArgDocEvaluateTCPModels(){
                       " fit and not universal. In 'Quantifying the position and steepness of radiation "
                       " dose-response curves' by Bentzen and Tucker in 1994, D_50 of around 60-65 Gy are reported"
                       " for local control of head and neck cancers (pyriform sinus carcinoma and neck nodes with"
-                      " max diameter <= 3cm). Martel et al. report 84.5 Gy in lung.";
+                      " max diameter <= 3cm). Martel et al. report 84.5 Gy in lung."
+                      " Multiple comma-separated values can be provided to evaluate every combination of parameters.";
     out.args.back().default_val = "65";
     out.args.back().expected = true;
-    out.args.back().examples = { "37.9", "52", "60", "65", "84.5" };
+    out.args.back().examples = { "37.9", "52", "60", "65", "84.5", "60,65,70" };
 
 
     out.args.emplace_back();
@@ -131,10 +154,11 @@ OperationDoc OpArgDocEvaluateTCPModels(){
                       " [0.7:2.2] respectively. (Refer to table 3 for site-specific values.) Additionally, "
                       " Gay et al. (doi:10.1016/j.ejmp.2007.07.001) claim that a value of 4.0 for late effects"
                       " a value of 2.0 for tumors in 'are reasonable initial estimates in [our] experience.' Their"
-                      " table 2 lists (NTCP) estimates based on the work of Emami (doi:10.1016/0360-3016(91)90171-Y).";
+                      " table 2 lists (NTCP) estimates based on the work of Emami (doi:10.1016/0360-3016(91)90171-Y)."
+                      " Multiple comma-separated values can be provided to evaluate every combination of parameters.";
     out.args.back().default_val = "0.8";
     out.args.back().expected = true;
-    out.args.back().examples = { "0.8", "1.5" };
+    out.args.back().examples = { "0.8", "1.5", "0.8,1.5" };
 
 
     out.args.emplace_back();
@@ -148,10 +172,11 @@ OperationDoc OpArgDocEvaluateTCPModels(){
                       " a median of 37.9 Gy for microscopic disease. The inter-quartile range was "
                       " [38.4:62.8] and [27.0:49.1] respectively. (Refer to table 3 for site-specific values.)"
                       " Gay et al. (doi:10.1016/j.ejmp.2007.07.001) table 2 lists (NTCP) estimates based on the"
-                      " work of Emami (doi:10.1016/0360-3016(91)90171-Y) ranging from 18-68 Gy.";
+                      " work of Emami (doi:10.1016/0360-3016(91)90171-Y) ranging from 18-68 Gy."
+                      " Multiple comma-separated values can be provided to evaluate every combination of parameters.";
     out.args.back().default_val = "51.9";
     out.args.back().expected = true;
-    out.args.back().examples = { "51.9", "37.9" };
+    out.args.back().examples = { "51.9", "37.9", "37.9,51.9" };
 
 
     out.args.emplace_back();
@@ -176,10 +201,11 @@ OperationDoc OpArgDocEvaluateTCPModels(){
                       " spans [1:40]. AAPM TG report 166 also provides a listing of recommended values,"
                       " suggesting -10 for PTV and GTV, +1 for parotid, 20 for spinal cord, and 8-16 for"
                       " rectum, bladder, brainstem, chiasm, eye, and optic nerve. Burman (1991) and QUANTEC"
-                      " (2010) also provide estimates.";
+                      " (2010) also provide estimates."
+                      " Multiple comma-separated values can be provided to evaluate every combination of parameters.";
     out.args.back().default_val = "-13.0";
     out.args.back().expected = true;
-    out.args.back().examples = { "-40", "-13.0", "-10", "-7.2", "0.3", "1", "3", "4", "20", "40" };
+    out.args.back().examples = { "-40", "-13.0", "-10", "-7.2", "0.3", "1", "3", "4", "20", "40", "-13,-10,-7.2" };
 
     out.args.emplace_back();
     out.args.back().name = "Fenwick_C";
@@ -189,20 +215,22 @@ OperationDoc OpArgDocEvaluateTCPModels(){
                       " The Fenwick model is semi-empirical, so this number must be fitted or used from"
                       " values reported in the literature. Fenwick et al. 2008"
                       " (doi:10.1016/j.clon.2008.12.011) provide values: 9.58 for local progression free survival"
-                      " at 30 months for NSCLC tumours and 5.00 for head-and-neck tumours.";
+                      " at 30 months for NSCLC tumours and 5.00 for head-and-neck tumours."
+                      " Multiple comma-separated values can be provided to evaluate every combination of parameters.";
     out.args.back().default_val = "9.58";
     out.args.back().expected = true;
-    out.args.back().examples = { "9.58", "5.00" };
+    out.args.back().examples = { "9.58", "5.00", "5.00,9.58" };
 
     out.args.emplace_back();
     out.args.back().name = "Fenwick_M";
     out.args.back().desc = "This parameter describes the dose-response steepness in the Fenwick model."
                       " Fenwick et al. 2008 (doi:10.1016/j.clon.2008.12.011) provide values:"
                       " 0.392 for local progression free survival at 30 months for NSCLC tumours and"
-                      " 0.280 for head-and-neck tumours.";
+                      " 0.280 for head-and-neck tumours."
+                      " Multiple comma-separated values can be provided to evaluate every combination of parameters.";
     out.args.back().default_val = "0.392";
     out.args.back().expected = true;
-    out.args.back().examples = { "0.392", "0.280" };
+    out.args.back().examples = { "0.392", "0.280", "0.280,0.392" };
 
     out.args.emplace_back();
     out.args.back().name = "Fenwick_Vref";
@@ -211,10 +239,11 @@ OperationDoc OpArgDocEvaluateTCPModels(){
                       " involved nodes) which the D_{50} are estimated using. In other words, this is a"
                       " 'nominal' tumour volume. Fenwick et al. 2008"
                       " (doi:10.1016/j.clon.2008.12.011) recommend 148'410 mm^3 (i.e., a sphere of"
-                      " diameter 6.6 cm). However, an appropriate value depends on the nature of the tumour.";
+                      " diameter 6.6 cm). However, an appropriate value depends on the nature of the tumour."
+                      " Multiple comma-separated values can be provided to evaluate every combination of parameters.";
     out.args.back().default_val = "148410.0";
     out.args.back().expected = true;
-    out.args.back().examples = { "148410.0" };
+    out.args.back().examples = { "148410.0", "100000,148410" };
 
     out.args.emplace_back();
     out.args.back().name = "UserComment";
@@ -243,21 +272,30 @@ Drover EvaluateTCPModels(Drover DICOM_data,
 
     const auto UserComment = OptArgs.getValueStr("UserComment");
 
-    const auto Gamma50 = std::stod( OptArgs.getValueStr("Gamma50").value() );
-    const auto Dose50 = std::stod( OptArgs.getValueStr("Dose50").value() );
+    const auto Gamma50s = parse_parameter_list( OptArgs.getValueStr("Gamma50").value() );
+    const auto Dose50s = parse_parameter_list( OptArgs.getValueStr("Dose50").value() );
 
-    const auto EUD_Gamma50 = std::stod( OptArgs.getValueStr("EUD_Gamma50").value() );
-    const auto EUD_TCD50 = std::stod( OptArgs.getValueStr("EUD_TCD50").value() );
-    const auto EUD_Alpha = std::stod( OptArgs.getValueStr("EUD_Alpha").value() );
+    const auto EUD_Gamma50s = parse_parameter_list( OptArgs.getValueStr("EUD_Gamma50").value() );
+    const auto EUD_TCD50s = parse_parameter_list( OptArgs.getValueStr("EUD_TCD50").value() );
+    const auto EUD_Alphas = parse_parameter_list( OptArgs.getValueStr("EUD_Alpha").value() );
 
-    const auto Fenwick_D50 = Dose50; // Shared with Martel model. There may be a slight difference though.
-    const auto Fenwick_C = std::stod( OptArgs.getValueStr("Fenwick_C").value() );
-    const auto Fenwick_M = std::stod( OptArgs.getValueStr("Fenwick_M").value() );
-    const auto Fenwick_Vref = std::stod( OptArgs.getValueStr("Fenwick_Vref").value() );
+    // Note: Fenwick's D50 is shared with Martel model. There may be a slight difference though.
+    const auto Fenwick_Cs = parse_parameter_list( OptArgs.getValueStr("Fenwick_C").value() );
+    const auto Fenwick_Ms = parse_parameter_list( OptArgs.getValueStr("Fenwick_M").value() );
+    const auto Fenwick_Vrefs = parse_parameter_list( OptArgs.getValueStr("Fenwick_Vref").value() );
 
     //-----------------------------------------------------------------------------------------------------------------
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
+
+    // Every combination of parameters is evaluated. Combinations are enumerated with the last parameter varying
+    // fastest.
+    const std::vector<size_t> param_counts = { Gamma50s.size(), Dose50s.size(),
+                                               EUD_Gamma50s.size(), EUD_TCD50s.size(), EUD_Alphas.size(),
+                                               Fenwick_Cs.size(), Fenwick_Ms.size(), Fenwick_Vrefs.size() };
+    size_t N_combinations = 1;
+    for(const auto n : param_counts) N_combinations *= n;
+    const bool IsSweep = (1 < N_combinations);
 
     //Merge the image arrays if necessary.
     if(DICOM_data.image_data.empty()){
@@ -297,72 +335,60 @@ Drover EvaluateTCPModels(Drover DICOM_data,
         patient_ID = "unknown_patient";
     }
 
-    //Accumulate the voxel intensity distributions.
-    AccumulatePixelDistributionsUserData ud;
-    if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
-                                               cc_ROIs, &ud )){
-        throw std::runtime_error("Unable to accumulate pixel distributions.");
+    //Accumulate the dose-volume statistics. Each model is evaluated as a volume-weighted integral over the voxels.
+    // Voxels are retained so every parameter combination can be evaluated without re-traversing the images.
+    dose_volume_options dv_opts;
+    dv_opts.retain_voxels = true;
+    std::vector<std::function<double(double)>> integrands;
+
+    // Martel model. The TCP is the volume-weighted geometric mean of the voxel TCPs.
+    //
+    // Integrand index: Gamma50 * |Dose50| + Dose50.
+    const size_t Martel_offset = integrands.size();
+    for(const auto Gamma50 : Gamma50s){
+        for(const auto Dose50 : Dose50s){
+            integrands.emplace_back([=](double D_voxel) -> double {
+                const auto numer = std::pow(D_voxel, Gamma50*4);
+                const auto denom = std::pow(Dose50, Gamma50*4) + numer;
+                const auto TCP_voxel = numer/denom; // This is a sigmoid curve.
+                return std::log(TCP_voxel);
+            });
+        }
     }
 
-    //Evalute the models.
-    std::map<std::string, double> MartelModel;
-    std::map<std::string, double> gEUDModel;
-    std::map<std::string, double> FenwickModel;
-    {
-        for(const auto &av : ud.accumulated_voxels){
-            const auto lROIname = av.first;
-
-            const auto N = av.second.size();
-            const double V_frac = 1.0 / N; // Fractional volume of a single voxel compared to whole ROI.
-
-            double TCP_Martel = 1.0;
-            double TCP_Fenwick = 1.0;
-
-            std::vector<double> gEUD_elements;
-            gEUD_elements.reserve(N);
-            for(const auto &D_voxel : av.second){
-                // Martel model.
-                {
-                    const auto numer = std::pow(D_voxel, Gamma50*4);
-                    const auto denom = std::pow(Dose50, Gamma50*4) + numer;
-                    const auto TCP_voxel = numer/denom; // This is a sigmoid curve.
-                    TCP_Martel *= std::pow(TCP_voxel, V_frac);
-                }
-                
-                // gEUD model.
-                {
-                    gEUD_elements.push_back(V_frac * std::pow(D_voxel, EUD_Alpha));
-                }
+    // gEUD model.
+    const size_t gEUD_offset = integrands.size();
+    for(const auto EUD_Alpha : EUD_Alphas){
+        integrands.emplace_back(gEUD_Integrand(EUD_Alpha));
+    }
 
-                // Fenwick model.
-                {
-                    const auto numer = (D_voxel - Fenwick_D50 - Fenwick_C * std::log(ROI_V/Fenwick_Vref));
-                    const auto denom = Fenwick_M * D_voxel * std::sqrt(2.0);
-                    //Note: the 'normal distribution function Phi(z)' referred to in Fenwick's paper is
-                    // (1/sqrt(2pi))*integral(exp(-x*x/2)dx, -inf, z) == 0.5*(1+erf(z/sqrt(2))).
-                    const auto TCP_voxel = 0.5*(1.0 + std::erf(numer/denom)); // This is a sigmoid curve.
-                    TCP_Fenwick *= std::pow(TCP_voxel, V_frac);
+    // Fenwick model. Also a volume-weighted geometric mean.
+    //
+    // Integrand index: ((Dose50 * |C| + C) * |M| + M) * |Vref| + Vref.
+    const size_t Fenwick_offset = integrands.size();
+    for(const auto Fenwick_D50 : Dose50s){
+        for(const auto Fenwick_C : Fenwick_Cs){
+            for(const auto Fenwick_M : Fenwick_Ms){
+                for(const auto Fenwick_Vref : Fenwick_Vrefs){
+                    integrands.emplace_back([=](double D_voxel) -> double {
+                        const auto numer = (D_voxel - Fenwick_D50 - Fenwick_C * std::log(ROI_V/Fenwick_Vref));
+                        const auto denom = Fenwick_M * D_voxel * std::sqrt(2.0);
+                        //Note: the 'normal distribution function Phi(z)' referred to in Fenwick's paper is
+                        // (1/sqrt(2pi))*integral(exp(-x*x/2)dx, -inf, z) == 0.5*(1+erf(z/sqrt(2))).
+                        const auto TCP_voxel = 0.5*(1.0 + std::erf(numer/denom)); // This is a sigmoid curve.
+                        return std::log(TCP_voxel);
+                    });
                 }
-
-                // ... other models ...
-                // ...
-
             }
+        }
+    }
 
-            //Post-processing.
-            MartelModel[lROIname] = TCP_Martel;
-            FenwickModel[lROIname] = TCP_Fenwick;
-
-            {
-                const auto gEUD = std::pow( Stats::Sum(gEUD_elements), 1.0 / EUD_Alpha );
-
-                const auto numer = std::pow(gEUD, EUD_Gamma50*4);
-                const auto denom = numer + std::pow(EUD_TCD50, EUD_Gamma50*4);
-                double TCP_gEUD = numer/denom; // This is a sigmoid curve.
+    const auto dvs_ROIs = Compute_Dose_Volume_Stats(img_arr_ptr->imagecoll, cc_ROIs, dv_opts);
 
-                gEUDModel[lROIname] = TCP_gEUD; 
-            }
-        }
+    //Evalute the models.
+    std::map<std::string, std::vector<double>> ModelIntegrals;
+    for(const auto &dvs : dvs_ROIs){
+        ModelIntegrals[dvs.first] = Integrate_Retained_Voxels(dvs.second, integrands);
     }
 
 
@@ -395,29 +421,78 @@ Drover EvaluateTCPModels(Drover DICOM_data,
                    << "DoseMean,"
                    << "DoseMedian,"
                    << "DoseStdDev,"
-                   << "VoxelCount"
-                   << std::endl;
+                   << "VoxelCount";
+            if(IsSweep){
+                FO_tcp << ",Gamma50,"
+                       << "Dose50,"
+                       << "EUD_Gamma50,"
+                       << "EUD_TCD50,"
+                       << "EUD_Alpha,"
+                       << "Fenwick_C,"
+                       << "Fenwick_M,"
+                       << "Fenwick_Vref";
+            }
+            FO_tcp << std::endl;
         }
-        for(const auto &av : ud.accumulated_voxels){
-            const auto lROIname = av.first;
-            const auto DoseMean = Stats::Mean( av.second );
-            const auto DoseMedian = Stats::Median( av.second );
-            const auto DoseStdDev = std::sqrt(Stats::Unbiased_Var_Est( av.second ));
-            const auto TCPMartel = MartelModel[lROIname];
-            const auto TCPgEUD = gEUDModel[lROIname];
-            const auto TCPFenwick = FenwickModel[lROIname];
-
-            FO_tcp  << UserComment.value_or("") << ","
-                    << patient_ID        << ","
-                    << lROIname          << ","
-                    << X(lROIname)       << ","
-                    << TCPMartel*100.0   << ","
-                    << TCPgEUD*100.0     << ","
-                    << TCPFenwick*100.0  << ","
-                    << DoseMean          << ","
-                    << DoseMedian        << ","
-                    << DoseStdDev        << ","
-                    << av.second.size()  << std::endl;
+        for(const auto &dvs : dvs_ROIs){
+            const auto lROIname = dvs.first;
+            const auto &s = dvs.second;
+            const auto DoseMean = s.moments.mean();
+            const auto DoseMedian = s.Quantiles({ 0.5 }).front();
+            const auto DoseStdDev = std::sqrt(s.moments.unbiased_variance());
+            const auto &integrals = ModelIntegrals.at(lROIname);
+
+            for(size_t n = 0; n < N_combinations; ++n){
+                // Decompose the combination number into the index of each parameter.
+                std::vector<size_t> i(param_counts.size());
+                auto rem = n;
+                for(size_t j = 0; j < param_counts.size(); ++j){
+                    const auto k = param_counts.size() - 1 - j;
+                    i[k] = rem % param_counts[k];
+                    rem /= param_counts[k];
+                }
+                const auto Gamma50_i = i[0], Dose50_i = i[1];
+                const auto EUD_Gamma50_i = i[2], EUD_TCD50_i = i[3], EUD_Alpha_i = i[4];
+                const auto Fenwick_C_i = i[5], Fenwick_M_i = i[6], Fenwick_Vref_i = i[7];
+
+                const auto TCPMartel = std::exp(integrals.at(Martel_offset + Gamma50_i * Dose50s.size() + Dose50_i)
+                                                / s.volume);
+
+                const auto Fenwick_i = ((Dose50_i * Fenwick_Cs.size() + Fenwick_C_i) * Fenwick_Ms.size()
+                                        + Fenwick_M_i) * Fenwick_Vrefs.size() + Fenwick_Vref_i;
+                const auto TCPFenwick = std::exp(integrals.at(Fenwick_offset + Fenwick_i) / s.volume);
+
+                const auto EUD_Gamma50 = EUD_Gamma50s[EUD_Gamma50_i];
+                const auto EUD_TCD50 = EUD_TCD50s[EUD_TCD50_i];
+                const auto EUD_Alpha = EUD_Alphas[EUD_Alpha_i];
+                const auto gEUD = std::pow(integrals.at(gEUD_offset + EUD_Alpha_i) / s.volume, 1.0 / EUD_Alpha);
+                const auto numer = std::pow(gEUD, EUD_Gamma50*4);
+                const auto denom = numer + std::pow(EUD_TCD50, EUD_Gamma50*4);
+                const auto TCPgEUD = numer/denom; // This is a sigmoid curve.
+
+                FO_tcp  << UserComment.value_or("") << ","
+                        << patient_ID        << ","
+                        << lROIname          << ","
+                        << X(lROIname)       << ","
+                        << TCPMartel*100.0   << ","
+                        << TCPgEUD*100.0     << ","
+                        << TCPFenwick*100.0  << ","
+                        << DoseMean          << ","
+                        << DoseMedian        << ","
+                        << DoseStdDev        << ","
+                        << s.moments.count();
+                if(IsSweep){
+                    FO_tcp << "," << Gamma50s[Gamma50_i]
+                           << "," << Dose50s[Dose50_i]
+                           << "," << EUD_Gamma50
+                           << "," << EUD_TCD50
+                           << "," << EUD_Alpha
+                           << "," << Fenwick_Cs[Fenwick_C_i]
+                           << "," << Fenwick_Ms[Fenwick_M_i]
+                           << "," << Fenwick_Vrefs[Fenwick_Vref_i];
+                }
+                FO_tcp << std::endl;
+            }
         }
         FO_tcp.flush();
         FO_tcp.close();
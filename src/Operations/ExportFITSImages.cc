@@ -2,6 +2,7 @@
 
 #include <asio.hpp>
 #include <algorithm>
+#include <cstdio>
 #include <optional>
 #include <fstream>
 #include <iterator>
@@ -29,6 +30,8 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../Output_Sink.h"
+#include "../FITS_IO.h"
 
 #include "ExportFITSImages.h"
 
@@ -56,13 +59,29 @@ OperationDoc OpArgDocExportFITSImages(){
     out.args.back().name = "FilenameBase";
     out.args.back().desc = "The base filename that images will be written to."
                            " A sequentially-increasing number and file suffix are appended after the base filename."
-                           " Note that the file type is FITS.";
+                           " Note that the file type is FITS."
+                           " If the base filename is '-' or ends with '.tar', '.tar.gz', or '.tgz', the files are instead"
+                           " packed into a TAR archive (written to stdout for '-').";
     out.args.back().default_val = "/tmp/dcma_exportfitsimages";
     out.args.back().expected = true;
     out.args.back().examples = { "../somedir/out", 
                                  "/path/to/some/dir/file_prefix" };
     out.args.back().mimetype = "application/object-file-format"; // TODO: find correct MIME type.
 
+    out.args.emplace_back();
+    out.args.back().name = "Layout";
+    out.args.back().desc = "Controls how images are grouped into files."
+                           " 'Slices' writes each image to a separate file."
+                           " 'Cube' writes each image array to a single file, with images stacked along the third"
+                           " axis (or the fourth axis for multi-channel images). Images in a cube must share"
+                           " dimensions, voxel sizes, and orientation, and must be evenly spaced."
+                           " Files are encoded in fixed-size chunks, so large cubes can be written without"
+                           " an additional copy of the image data.";
+    out.args.back().default_val = "slices";
+    out.args.back().expected = true;
+    out.args.back().examples = { "slices", "cube" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -76,23 +95,54 @@ Drover ExportFITSImages(Drover DICOM_data,
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
     const auto FilenameBaseStr = OptArgs.getValueStr("FilenameBase").value();
+    const auto LayoutStr = OptArgs.getValueStr("Layout").value();
 
     //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_slices = Compile_Regex("^sl?i?c?e?s?$");
+    const auto regex_cube = Compile_Regex("^cu?b?e?$");
+
+    const bool as_cube = std::regex_match(LayoutStr, regex_cube);
+    if(!as_cube && !std::regex_match(LayoutStr, regex_slices)){
+        throw std::invalid_argument("Layout not understood. Cannot continue.");
+    }
 
     const auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
-    for(auto & iap_it : IAs){
-        long int count = 0;
-        for(auto &pimg : (*iap_it)->imagecoll.images){
-            const auto pixel_dump_filename_out = Get_Unique_Sequential_Filename(FilenameBaseStr + "_", 6, ".fits");
-            if(WriteToFITS(pimg, pixel_dump_filename_out)){
-                FUNCINFO("Exported image " << count << " to file '" << pixel_dump_filename_out << "'");
+    output_sink sink(FilenameBaseStr);
+
+    // Files are written directly, or encoded once and handed to the archive.
+    const auto export_file = [&](const fits_images_t &imgs, const std::string &desc){
+        const auto fname = sink.next_name(".fits");
+        try{
+            if(!sink.is_archive()){
+                Write_FITS_Images(imgs, fname);
+                FUNCINFO("Exported " << desc << " to file '" << fname << "'");
             }else{
-                FUNCWARN("Unable to export image to file '" << pixel_dump_filename_out << "'");
+                sink.write(fname, Encode_FITS_Images(imgs));
+                FUNCINFO("Exported " << desc << " to archive member '" << fname << "'");
             }
+        }catch(const std::exception &e){
+            FUNCWARN("Unable to export " << desc << " to '" << fname << "': " << e.what());
+        }
+    };
+
+    for(auto & iap_it : IAs){
+        const auto &images = (*iap_it)->imagecoll.images;
+        if(as_cube){
+            if(!images.empty()){
+                export_file(fits_images_t(std::begin(images), std::end(images)),
+                            "cube of " + std::to_string(images.size()) + " images");
+            }
+            continue;
+        }
+
+        long int count = 0;
+        for(const auto &pimg : images){
+            export_file(fits_images_t{ std::cref(pimg) }, "image " + std::to_string(count));
             ++count;
         }
     }
+    sink.finish();
 
     return DICOM_data;
 }
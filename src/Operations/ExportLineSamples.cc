@@ -11,6 +11,7 @@
 #include <mutex>
 #include <regex>
 #include <set> 
+#include <sstream>
 #include <stdexcept>
 #include <string>    
 #include <utility>            //Needed for std::pair.
@@ -29,6 +30,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../Output_Sink.h"
 
 #include "ExportLineSamples.h"
 
@@ -54,7 +56,9 @@ OperationDoc OpArgDocExportLineSamples(){
                            " if available. Metadata is included, but will be base64 encoded if any non-printable"
                            " characters are detected. If no name is given, the default will be used."
                            " A '_', a sequentially-increasing number, and the '.dat' file suffix are"
-                           " appended after the base filename.";
+                           " appended after the base filename."
+                           " If the base filename is '-' or ends with '.tar', '.tar.gz', or '.tgz', the files are instead"
+                           " packed into a TAR archive (written to stdout for '-').";
     out.args.back().default_val = "/tmp/dcma_exportlinesamples";
     out.args.back().expected = true;
     out.args.back().examples = { "line_sample", 
@@ -82,19 +86,22 @@ Drover ExportLineSamples(Drover DICOM_data,
     auto LSs_all = All_LSs( DICOM_data );
     const auto LSs = Whitelist( LSs_all, LineSelectionStr );
     const auto N_LSs = LSs.size();
+    output_sink sink(FilenameBaseStr);
     for(auto & lsp_it : LSs){
 
         // Determine which filename to use.
-        const auto FN = Get_Unique_Sequential_Filename(FilenameBaseStr + "_", 6, ".dat");
-        std::fstream FO(FN, std::fstream::out);
+        const auto FN = sink.next_name(".dat");
+        std::ostringstream FO;
 
         // Write the data to file.
         if(!(*lsp_it)->line.Write_To_Stream(FO)){
             throw std::runtime_error("Unable to write line sample. Cannot continue.");
         }
+        sink.write(FN, FO.str());
 
         FUNCINFO("Line sample written to '" << FN << "'");
     }
+    sink.finish();
 
     return DICOM_data;
 }
@@ -12,6 +12,7 @@
 #include <mutex>
 #include <regex>
 #include <set> 
+#include <sstream>
 #include <stdexcept>
 #include <string>    
 #include <utility>            //Needed for std::pair.
@@ -30,6 +31,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../Output_Sink.h"
 
 #include "ExportPointClouds.h"
 
@@ -55,7 +57,9 @@ OperationDoc OpArgDocExportPointClouds(){
                            //" Metadata is included, but will be base64 encoded if any non-printable"
                            //" characters are detected. If no name is given, the default will be used."
                            " A '_', a sequentially-increasing number, and the '.xyz' file suffix are"
-                           " appended after the base filename.";
+                           " appended after the base filename."
+                           " If the base filename is '-' or ends with '.tar', '.tar.gz', or '.tgz', the files are instead"
+                           " packed into a TAR archive (written to stdout for '-').";
     out.args.back().default_val = "/tmp/dcma_exportpointclouds";
     out.args.back().expected = true;
     out.args.back().examples = { "point_cloud", 
@@ -83,18 +87,21 @@ Drover ExportPointClouds(Drover DICOM_data,
     auto PCs_all = All_PCs( DICOM_data );
     const auto PCs = Whitelist( PCs_all, PointSelectionStr );
     const auto N_PCs = PCs.size();
+    output_sink sink(FilenameBaseStr);
     for(auto & pcp_it : PCs){
 
         // Determine which filename to use.
-        const auto FN = Get_Unique_Sequential_Filename(FilenameBaseStr + "_", 6, ".xyz");
+        const auto FN = sink.next_name(".xyz");
 
-        std::fstream FO(FN, std::fstream::out);
+        std::ostringstream FO;
         if(!WritePointSetToXYZ((*pcp_it)->pset, FO) || !FO){
             throw std::runtime_error("Unable to write point cloud. Cannot continue.");
         }
+        sink.write(FN, FO.str());
 
         FUNCINFO("Point cloud written to '" << FN << "'");
     }
+    sink.finish();
 
     return DICOM_data;
 }
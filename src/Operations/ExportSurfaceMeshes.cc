@@ -11,6 +11,7 @@
 #include <mutex>
 #include <regex>
 #include <set> 
+#include <sstream>
 #include <stdexcept>
 #include <string>    
 #include <utility>            //Needed for std::pair.
@@ -29,6 +30,8 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../Output_Sink.h"
+#include "../STL_Mesh_IO.h"
 
 #include "ExportSurfaceMeshes.h"
 
@@ -48,13 +51,17 @@ OperationDoc OpArgDocExportSurfaceMeshes(){
     out.args.emplace_back();
     out.args.back().name = "Filename";
     out.args.back().desc = "The filename (or full path name) to which the surface mesh data should be written."
-                           " The file format is an ASCII OFF model."
-                           " If no name is given, unique names will be chosen automatically.";
+                           " The file format is an ASCII OFF model, unless the name ends with '.stl', in which"
+                           " case a binary STL model is written."
+                           " If no name is given, unique names will be chosen automatically."
+                           " If the name is '-' or ends with '.tar', '.tar.gz', or '.tgz', all selected meshes are"
+                           " packed into a TAR archive (written to stdout for '-').";
     out.args.back().default_val = "";
     out.args.back().expected = true;
     out.args.back().examples = { "smesh.off", 
                                  "../somedir/mesh.off", 
-                                 "/path/to/some/surface_mesh.off" };
+                                 "/path/to/some/surface_mesh.off",
+                                 "/path/to/some/surface_mesh.stl" };
     out.args.back().mimetype = "application/object-file-format"; // TODO: find correct MIME type.
 
     return out;
@@ -76,14 +83,38 @@ Drover ExportSurfaceMeshes(Drover DICOM_data,
 
     auto SMs_all = All_SMs( DICOM_data );
     auto SMs = Whitelist( SMs_all, MeshSelectionStr );
+
+    if(output_sink::is_archive_target(FilenameStr)){
+        output_sink sink(FilenameStr);
+        for(auto & smp_it : SMs){
+            const auto FN = sink.next_name(".off");
+            std::ostringstream FO;
+            if(!WriteFVSMeshToOFF( (*smp_it)->meshes, FO )){
+                throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
+            }
+            sink.write(FN, FO.str());
+            FUNCINFO("Surface mesh written to archive member '" << FN << "'");
+        }
+        sink.finish();
+        return DICOM_data;
+    }
+
+    const std::string stl_ext = ".stl";
+    const bool write_stl = (stl_ext.size() <= FilenameStr.size())
+                        && (FilenameStr.compare(FilenameStr.size() - stl_ext.size(), stl_ext.size(), stl_ext) == 0);
+
     for(auto & smp_it : SMs){
         auto FN = FilenameStr;
         if(FilenameStr.empty()){
             FN = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_exportsurfacemeshes_", 6, ".off");
         }
-        std::fstream FO(FN, std::fstream::out);
+        std::fstream FO(FN, std::fstream::out | std::fstream::binary);
 
-        if(!WriteFVSMeshToOFF( (*smp_it)->meshes, FO )){
+        if(write_stl){
+            if(!Write_FV_Surface_Mesh_To_Binary_STL( (*smp_it)->meshes, FO )){
+                throw std::runtime_error("Unable to write mesh in STL format. Cannot continue.");
+            }
+        }else if(!WriteFVSMeshToOFF( (*smp_it)->meshes, FO )){
             throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
         }
         FUNCINFO("Surface mesh written to '" << FN << "'");
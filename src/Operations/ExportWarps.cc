@@ -28,6 +28,7 @@
 
 #include "../Structs.h"
 #include "../Alignment_TPSRPM.h"
+#include "../Alignment_Field.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 
@@ -114,6 +115,13 @@ Drover ExportWarps(Drover DICOM_data,
                     std::runtime_error("Unable to write to file. Cannot continue.");
                 }
 
+            // Deformation field transformations.
+            }else if constexpr (std::is_same_v<V, deformation_field>){
+                FUNCINFO("Exporting deformation field transformation now");
+                if(!(t.write_to(FO))){
+                    std::runtime_error("Unable to write to file. Cannot continue.");
+                }
+
             }else{
                 static_assert(std::is_same_v<V,void>, "Transformation not understood.");
             }
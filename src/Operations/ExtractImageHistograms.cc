@@ -20,11 +20,11 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Compute/Extract_Histograms.h"
 #include "ExtractImageHistograms.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -239,7 +239,7 @@ Drover ExtractImageHistograms(Drover DICOM_data,
     const auto regex_separate = Compile_Regex("^se?p?[ea]?r?a?t?e?$");
     const auto regex_combined = Compile_Regex("^co?m?b?i?n?e?d?$");
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     if( std::regex_match(GroupingStr, regex_combined) && !GroupLabelOpt ){
         throw std::invalid_argument("A valid 'GroupLabel' must be provided when 'Grouping'='combined'.");
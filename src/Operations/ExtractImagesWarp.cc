@@ -0,0 +1,201 @@
+//ExtractImagesWarp.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <algorithm>
+#include <optional>
+#include <list>
+#include <map>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>    
+#include <utility>            //Needed for std::pair.
+#include <vector>
+
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+
+#include "../Alignment_Field.h"
+#include "../Alignment_Demons.h"
+
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorString.h"       //Needed for GetFirstRegex(...)
+
+#include "ExtractImagesWarp.h"
+
+OperationDoc OpArgDocExtractImagesWarp(){
+    OperationDoc out;
+    out.name = "ExtractImagesWarp";
+
+    out.desc = 
+        "This operation uses two image arrays (one 'moving' and the other 'stationary' or 'reference') to find a"
+        " deformable transformation ('warp') that will map the moving images to the stationary images, based on"
+        " voxel intensities. The resulting transformation is a dense deformation field that can be later be used"
+        " to warp other objects, e.g., via WarpPoints or TransformImages.";
+        
+    out.notes.emplace_back(
+        "The 'moving' images are *not* warped by this operation -- this operation merely identifies a suitable"
+        " transformation."
+    );
+    out.notes.emplace_back(
+        "Both image arrays must form regular rectilinear grids, but they need not share the same grid."
+        " The deformation field is sampled on the stationary image grid."
+    );
+    out.notes.emplace_back(
+        "The demons algorithm assumes voxel intensities are directly comparable between image arrays, i.e., that"
+        " both have the same modality and calibration. Rigid pre-alignment and intensity windowing may improve"
+        " results considerably."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "MovingImageSelection";
+    out.args.back().default_val = "last";
+    out.args.back().desc = "The image array that will serve as input to the warp function. "_s
+                         + out.args.back().desc;
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "ReferenceImageSelection";
+    out.args.back().default_val = "first";
+    out.args.back().desc = "The stationary image array to use as a reference for the moving image array. "_s
+                         + out.args.back().desc
+                         + " Note that this image array is not modified.";
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "The alignment algorithm to use. Currently only 'demons' is available.";
+    out.args.back().default_val = "demons";
+    out.args.back().expected = true;
+    out.args.back().examples = { "demons" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Channel";
+    out.args.back().desc = "The image channel to register (zero-based)."
+                           " Note that both moving and reference images will share this specifier.";
+    out.args.back().default_val = "0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0", "1", "2" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Levels";
+    out.args.back().desc = "The maximum number of resolution levels, including the full-resolution level."
+                           " Each coarser level halves the resolution, which helps recover large deformations"
+                           " and reduces runtime.";
+    out.args.back().default_val = "3";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "3", "5" };
+
+    out.args.emplace_back();
+    out.args.back().name = "MaxIterations";
+    out.args.back().desc = "The maximum number of iterations performed at each resolution level.";
+    out.args.back().default_val = "100";
+    out.args.back().expected = true;
+    out.args.back().examples = { "20", "100", "500" };
+
+    out.args.emplace_back();
+    out.args.back().name = "RelativeTolerance";
+    out.args.back().desc = "Iteration at a resolution level stops when the mean squared intensity difference changes"
+                           " by this fraction or less between successive iterations.";
+    out.args.back().default_val = "1E-4";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1E-3", "1E-4", "1E-6" };
+
+    out.args.emplace_back();
+    out.args.back().name = "UpdateSigma";
+    out.args.back().desc = "The width (standard deviation, in voxels) of the Gaussian used to smooth each update"
+                           " ('fluid' regularization). Zero disables this smoothing.";
+    out.args.back().default_val = "0.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0", "1.0", "2.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "FieldSigma";
+    out.args.back().desc = "The width (standard deviation, in voxels) of the Gaussian used to smooth the accumulated"
+                           " deformation field ('diffusion' regularization). Larger values produce smoother"
+                           " deformations. Zero disables this smoothing.";
+    out.args.back().default_val = "1.5";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0", "1.0", "1.5", "3.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "SymmetricForces";
+    out.args.back().desc = "Whether to average the stationary and warped moving image gradients when computing"
+                           " displacement updates. Symmetric forces generally converge faster.";
+    out.args.back().default_val = "true";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
+
+    return out;
+}
+
+
+
+Drover ExtractImagesWarp(Drover DICOM_data,
+                         const OperationArgPkg& OptArgs,
+                         const std::map<std::string, std::string>&
+                         /*InvocationMetadata*/,
+                         const std::string& /*FilenameLex*/){
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto MovingImageSelectionStr = OptArgs.getValueStr("MovingImageSelection").value();
+    const auto ReferenceImageSelectionStr = OptArgs.getValueStr("ReferenceImageSelection").value();
+
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
+    const auto Channel = std::stol( OptArgs.getValueStr("Channel").value() );
+    const auto Levels = std::stol( OptArgs.getValueStr("Levels").value() );
+    const auto MaxIters = std::stol( OptArgs.getValueStr("MaxIterations").value() );
+    const auto RelativeTol = std::stod( OptArgs.getValueStr("RelativeTolerance").value() );
+    const auto UpdateSigma = std::stod( OptArgs.getValueStr("UpdateSigma").value() );
+    const auto FieldSigma = std::stod( OptArgs.getValueStr("FieldSigma").value() );
+    const auto SymmetricForcesStr = OptArgs.getValueStr("SymmetricForces").value();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_demons = Compile_Regex("^de?m?o?n?s?$");
+    const auto regex_true   = Compile_Regex("^tr?u?e?$");
+
+    const auto SymmetricForces = std::regex_match(SymmetricForcesStr, regex_true);
+
+    auto IAs_all = All_IAs( DICOM_data );
+    auto ref_IAs = Whitelist( IAs_all, ReferenceImageSelectionStr );
+    if(ref_IAs.size() != 1){
+        throw std::invalid_argument("A single reference image array must be selected. Cannot continue.");
+    }
+
+    // Iterate over the moving image arrays, aligning each to the reference image array.
+    auto moving_IAs = Whitelist( IAs_all, MovingImageSelectionStr );
+    for(auto & iap_it : moving_IAs){
+        FUNCINFO("There are " << (*ref_IAs.front())->imagecoll.images.size() << " images in the reference image array");
+        FUNCINFO("There are " << (*iap_it)->imagecoll.images.size() << " images in the moving image array");
+
+        if( std::regex_match(MethodStr, regex_demons) ){
+            AlignViaDemonsParams params;
+            params.channel            = Channel;
+            params.levels             = Levels;
+            params.max_iterations     = MaxIters;
+            params.relative_tolerance = RelativeTol;
+            params.update_sigma       = UpdateSigma;
+            params.field_sigma        = FieldSigma;
+            params.symmetric_forces   = SymmetricForces;
+
+            auto t_opt = AlignViaDemons( params,
+                                         (*iap_it)->imagecoll,
+                                         (*ref_IAs.front())->imagecoll );
+            if(t_opt){
+                FUNCINFO("Successfully found warp using demons with final mean squared difference " << params.final_mse);
+                DICOM_data.trans_data.emplace_back( std::make_shared<Transform3>( ) );
+                DICOM_data.trans_data.back()->transform = t_opt.value();
+                DICOM_data.trans_data.back()->metadata["Name"] = "unspecified";
+                DICOM_data.trans_data.back()->metadata["WarpType"] = "Demons";
+            }else{
+                throw std::runtime_error("Failed to warp using demons.");
+            }
+
+        }else{
+            throw std::invalid_argument("Method not understood. Cannot continue.");
+        }
+    }
+
+    return DICOM_data;
+}
@@ -16,14 +16,14 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 
 #include "../Alignment_Rigid.h"
 #include "../Alignment_TPSRPM.h"
-
-#include "Explicator.h"       //Needed for Explicator class.
+#include "../Alignment_Multiresolution.h"
 
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -207,10 +207,12 @@ OperationDoc OpArgDocExtractPointsWarp(){
     out.args.back().desc = "The method used to solve the system of linear equtions that defines the thin plate spline"
                            " solution. The pseudoinverse will likely be able to provide a solution when the system is"
                            " degenerate, but it might not be reasonable or even sensible. The LDLT method scales"
-                           " better.";
+                           " better. The low-rank method places spline kernels at a well-spread subset of the moving"
+                           " points (see LowRankControlPoints) and fits the remaining points in the least-squares"
+                           " sense; it is approximate, but scales to point clouds far too large for the other methods.";
     out.args.back().default_val = "LDLT";
     out.args.back().expected = true;
-    out.args.back().examples = { "LDLT", "PseudoInverse", };
+    out.args.back().examples = { "LDLT", "PseudoInverse", "LowRank", };
     out.args.back().samples = OpArgSamples::Exhaustive;
 #endif
 
@@ -383,14 +385,29 @@ OperationDoc OpArgDocExtractPointsWarp(){
     out.args.back().desc = "The method used to solve the system of linear equtions that defines the thin plate spline"
                            " solution. The pseudoinverse will likely be able to provide a solution when the system is"
                            " degenerate, but it might not be reasonable or even sensible. The LDLT method scales"
-                           " better."
+                           " better. The low-rank method places spline kernels at a well-spread subset of the moving"
+                           " points (see LowRankControlPoints) and fits the remaining points in the least-squares"
+                           " sense; it is approximate, but scales to point clouds far too large for the other methods."
                            " Note that this parameter is used with the TPS-RPM method, but *not* in the TPS method.";
     out.args.back().default_val = "LDLT";
     out.args.back().expected = true;
-    out.args.back().examples = { "LDLT", "PseudoInverse", };
+    out.args.back().examples = { "LDLT", "PseudoInverse", "LowRank", };
     out.args.back().samples = OpArgSamples::Exhaustive;
 #endif
 
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "LowRankControlPoints";
+    out.args.back().desc = "The maximum number of control points used when the low-rank solver is selected for either"
+                           " the TPS or TPS-RPM methods. Control points are selected from the moving point cloud so"
+                           " that they are spread out as evenly as possible. More control points permit finer"
+                           " deformations, but memory use grows linearly and computation time grows cubically."
+                           " This parameter is ignored by the other solvers.";
+    out.args.back().default_val = "1000";
+    out.args.back().expected = true;
+    out.args.back().examples = { "250", "1000", "5000" };
+#endif
+
 #ifdef DCMA_USE_EIGEN
     out.args.emplace_back();
     out.args.back().name = "TPSRPMHardConstraints";
@@ -448,6 +465,59 @@ OperationDoc OpArgDocExtractPointsWarp(){
     out.args.back().examples = { "true", "false" };
 #endif
 
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "TPSRPMTruncateCorrespondence";
+    out.args.back().desc = "If enabled, the TPS-RPM correspondence matrix is stored sparsely, retaining for each moving"
+                           " point only the nearest stationary points within a temperature-dependent radius (see"
+                           " TPSRPMMaxCorrespondences). This reduces memory usage from the product of the point cloud"
+                           " sizes to roughly linear in the moving point cloud size, and permits registration of large"
+                           " point clouds (e.g., organ surfaces). Truncation is an approximation; large-scale"
+                           " deformations at high temperatures may be impeded if too few correspondences are retained."
+                           " Note that this parameter is used with the TPS-RPM method, but *not* in the TPS method.";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
+#endif
+
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "TPSRPMMaxCorrespondences";
+    out.args.back().desc = "The maximum number of stationary points retained as potential correspondences for each"
+                           " moving point when the correspondence matrix is truncated."
+                           " Note that this parameter is used with the TPS-RPM method, but *not* in the TPS method.";
+    out.args.back().default_val = "100";
+    out.args.back().expected = true;
+    out.args.back().examples = { "25", "100", "500" };
+#endif
+
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "MultiresolutionLevels";
+    out.args.back().desc = "The number of resolution levels to use, including the full-resolution level."
+                           " When more than one level is used, both point clouds are decimated on successively"
+                           " coarser voxel grids, the coarsest level is registered first, and each result is used to"
+                           " seed the registration of the next finer level. This can greatly reduce runtime for large"
+                           " point clouds and can help avoid local minima. Levels that would retain too few points"
+                           " are omitted. A single level disables decimation."
+                           " Note that this parameter is used with the exhaustive ICP and TPS-RPM methods only.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "2", "3", "5" };
+#endif
+
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "MultiresolutionVoxelSize";
+    out.args.back().desc = "The voxel grid spacing (in DICOM units; mm) used to decimate the finest decimated level."
+                           " Each coarser level doubles the spacing. If zero or negative, twice the mean"
+                           " nearest-neighbour separation of the reference point cloud is used."
+                           " Note that this parameter is used with the exhaustive ICP and TPS-RPM methods only.";
+    out.args.back().default_val = "0.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0", "1.5", "5.0" };
+#endif
+
     out.args.emplace_back();
     out.args.back().name = "MaxIterations";
     out.args.back().desc = "If the method is iterative, only permit this many iterations to occur."
@@ -485,7 +555,7 @@ Drover ExtractPointsWarp(Drover DICOM_data,
                          /*InvocationMetadata*/,
                          const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto MovingPointSelectionStr = OptArgs.getValueStr("MovingPointSelection").value();
@@ -515,6 +585,14 @@ Drover ExtractPointsWarp(Drover DICOM_data,
     const auto TPSRPMHardContraintsStr = OptArgs.getValueStr("TPSRPMHardConstraints").value();
     const auto TPSRPMPermitMovingOutliersStr = OptArgs.getValueStr("TPSRPMPermitMovingOutliers").value();
     const auto TPSRPMPermitStationaryOutliersStr = OptArgs.getValueStr("TPSRPMPermitStationaryOutliers").value();
+    const auto TPSRPMTruncateCorrespondenceStr = OptArgs.getValueStr("TPSRPMTruncateCorrespondence").value();
+    const auto TPSRPMMaxCorrespondences = std::stol( OptArgs.getValueStr("TPSRPMMaxCorrespondences").value() );
+
+    const auto LowRankControlPoints = std::stol( OptArgs.getValueStr("LowRankControlPoints").value() );
+
+    AlignViaMultiresolutionParams mr_params;
+    mr_params.levels = std::stol( OptArgs.getValueStr("MultiresolutionLevels").value() );
+    mr_params.voxel_size = std::stod( OptArgs.getValueStr("MultiresolutionVoxelSize").value() );
 #endif // DCMA_USE_EIGEN
 
     const auto MaxIters = std::stol( OptArgs.getValueStr("MaxIterations").value() );
@@ -531,11 +609,13 @@ Drover ExtractPointsWarp(Drover DICOM_data,
 
     const auto regex_ldlt = Compile_Regex("^LD?L?T?$");
     const auto regex_pinv = Compile_Regex("^ps?e?u?d?o?[-_]?i?n?v?e?r?s?e?$");
+    const auto regex_lowrank = Compile_Regex("^lo?w?[-_]?r?a?n?k?$");
 
     const auto TPSRPMSeedWithCentroidShift = std::regex_match(TPSRPMSeedWithCentroidShiftStr, regex_true);
     const auto TPSRPMDoubleSidedOutliers = std::regex_match(TPSRPMDoubleSidedOutliersStr, regex_true);
     const auto TPSRPMPermitMovingOutliers = std::regex_match(TPSRPMPermitMovingOutliersStr, regex_true);
     const auto TPSRPMPermitStationaryOutliers = std::regex_match(TPSRPMPermitStationaryOutliersStr, regex_true);
+    const auto TPSRPMTruncateCorrespondence = std::regex_match(TPSRPMTruncateCorrespondenceStr, regex_true);
 
     std::vector<std::pair<long int, long int>> TPSRPMHardContraints;
     {
@@ -604,10 +684,15 @@ Drover ExtractPointsWarp(Drover DICOM_data,
  
 
         }else if( std::regex_match(MethodStr, regex_exhicp) ){
-            auto t_opt = AlignViaExhaustiveICP( (*pcp_it)->pset,
-                                                (*ref_PCs.front())->pset,
-                                                MaxIters,
-                                                RelativeTol );
+            auto t_opt = (1 < mr_params.levels) ? AlignViaMultiresolutionICP( mr_params,
+                                                                              (*pcp_it)->pset,
+                                                                              (*ref_PCs.front())->pset,
+                                                                              MaxIters,
+                                                                              RelativeTol )
+                                                : AlignViaExhaustiveICP( (*pcp_it)->pset,
+                                                                         (*ref_PCs.front())->pset,
+                                                                         MaxIters,
+                                                                         RelativeTol );
             if(t_opt){
                 FUNCINFO("Successfully found warp using exhaustive ICP");
                 DICOM_data.trans_data.emplace_back( std::make_shared<Transform3>( ) );
@@ -628,6 +713,9 @@ Drover ExtractPointsWarp(Drover DICOM_data,
                 params.solution_method = AlignViaTPSParams::SolutionMethod::LDLT;
             }else if( std::regex_match(TPSSolverStr, regex_pinv) ){
                 params.solution_method = AlignViaTPSParams::SolutionMethod::PseudoInverse;
+            }else if( std::regex_match(TPSSolverStr, regex_lowrank) ){
+                params.solution_method = AlignViaTPSParams::SolutionMethod::LowRank;
+                params.low_rank_control_points = LowRankControlPoints;
             }else{
                 throw std::runtime_error("Solver not understood. Unable to continue.");
             }
@@ -661,6 +749,8 @@ Drover ExtractPointsWarp(Drover DICOM_data,
             params.forced_correspondence    = TPSRPMHardContraints;
             params.permit_move_outliers     = TPSRPMPermitMovingOutliers;
             params.permit_stat_outliers     = TPSRPMPermitStationaryOutliers;
+            params.truncate_correspondence  = TPSRPMTruncateCorrespondence;
+            params.max_correspondences      = TPSRPMMaxCorrespondences;
 
 /*
 // Debugging...
@@ -670,6 +760,9 @@ params.report_final_correspondence = true;
                 params.solution_method = AlignViaTPSRPMParams::SolutionMethod::LDLT;
             }else if( std::regex_match(TPSRPMSolverStr, regex_pinv) ){
                 params.solution_method = AlignViaTPSRPMParams::SolutionMethod::PseudoInverse;
+            }else if( std::regex_match(TPSRPMSolverStr, regex_lowrank) ){
+                params.solution_method = AlignViaTPSRPMParams::SolutionMethod::LowRank;
+                params.low_rank_control_points = LowRankControlPoints;
             }else{
                 throw std::runtime_error("Solver not understood. Unable to continue.");
             }
@@ -678,9 +771,13 @@ params.report_final_correspondence = true;
                      << " zeta = " << TPSRPMZetaStart << ","
                      << " and kdim = " << TPSRPMKDim);
 
-            auto t_opt = AlignViaTPSRPM( params,
-                                         (*pcp_it)->pset,
-                                         (*ref_PCs.front())->pset );
+            auto t_opt = (1 < mr_params.levels) ? AlignViaMultiresolutionTPSRPM( mr_params,
+                                                                                 params,
+                                                                                 (*pcp_it)->pset,
+                                                                                 (*ref_PCs.front())->pset )
+                                                : AlignViaTPSRPM( params,
+                                                                  (*pcp_it)->pset,
+                                                                  (*ref_PCs.front())->pset );
             if(t_opt){
                 FUNCINFO("Successfully found warp using TPS-RPM");
                 DICOM_data.trans_data.emplace_back( std::make_shared<Transform3>( ) );
@@ -13,8 +13,10 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <regex>
 #include <stdexcept>
+#include <sstream>
 #include <string>    
 #include <vector>
 #include <utility>
@@ -31,16 +33,16 @@
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorFilesDirs.h"
 
-#include "Explicator.h"
-
+#include "../Distribution_Sketch.h"
 #include "../Insert_Contours.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Write_File.h"
 #include "../Thread_Pool.h"
 #include "../Surface_Meshes.h"
-#include "../YgorImages_Functors/Grouping/Misc_Functors.h"
-#include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
+#include "../YgorImages_Functors/ROI_Voxels.h"
+#include "../YgorImages_Functors/Voxel_Inclusion_Mask.h"
 
 #include "ExtractRadiomicFeatures.h"
 
@@ -61,6 +63,16 @@ OperationDoc OpArgDocExtractRadiomicFeatures(){
         " Often removing the highest-frequency components of the contour will help, such as edges that conform"
         " tightly to individual voxels."
     );
+    out.notes.emplace_back(
+        "ROIs are processed concurrently. Surface meshes and voxel inclusion masks are cached, so repeated"
+        " invocations with the same ROIs (e.g., for different images) reuse them."
+    );
+    out.notes.emplace_back(
+        "Texture features are computed from grey level co-occurrence (GLCM) and run length (GLRLM) matrices."
+        " Matrices are aggregated over all slices and the four in-plane directions before features are computed"
+        " (i.e., IBSI '2.5D merged'), using symmetric co-occurrence at a distance of one voxel."
+        " Only the first channel is used."
+    );
 
 
     out.args.emplace_back();
@@ -101,432 +113,488 @@ OperationDoc OpArgDocExtractRadiomicFeatures(){
     out.args.back().default_val = ".*";
 
 
-    return out;
-}
+    out.args.emplace_back();
+    out.args.back().name = "PerROI";
+    out.args.back().desc = "Controls whether the selected ROIs are combined (false) or whether a separate row is"
+                           " reported for each distinct ROIName (true).";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
 
-Drover ExtractRadiomicFeatures(Drover DICOM_data,
-                               const OperationArgPkg& OptArgs,
-                               const std::map<std::string, std::string>& /*InvocationMetadata*/,
-                               const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    out.args.emplace_back();
+    out.args.back().name = "TextureBins";
+    out.args.back().desc = "The number of grey levels voxel intensities are discretized into for texture features."
+                           " Intensities are divided into equal-width bins spanning the intensities within the ROI."
+                           " Texture features are not computed if zero.";
+    out.args.back().default_val = "0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0", "16", "32", "64" };
 
-    //---------------------------------------------- User Parameters --------------------------------------------------
-    auto FeaturesFileName = OptArgs.getValueStr("FeaturesFileName").value();
 
-    const auto UserComment = OptArgs.getValueStr("UserComment").value_or("");
+    return out;
+}
 
-    const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
-    const auto ROILabelRegex = OptArgs.getValueStr("ROILabelRegex").value();
 
-    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+namespace {
 
-    //-----------------------------------------------------------------------------------------------------------------
+// Named features, in the order they are reported.
+using features_t = std::vector<std::pair<std::string, double>>;
 
-    //Stuff references to all contours into a list. Remember that you can still address specific contours through
-    // the original holding containers (which are not modified here).
-    auto cc_all = All_CCs( DICOM_data );
-    auto cc_ROIs = Whitelist( cc_all, { { "ROIName", ROILabelRegex },
-                                        { "NormalizedROIName", NormalizedROILabelRegex } } );
+struct roi_group_t {
+    std::string ROIName;
+    std::list<std::reference_wrapper<contour_collection<double>>> ccs;
+};
 
-    if(cc_ROIs.empty()){
-        throw std::invalid_argument("No contours selected. Cannot continue.");
-    }
-
-    // TODO: extract all ROI names and append them together. Best to put it in a top-level file for access elsehwere
-    // too.
-    // std::list<std::string> get_distinct_values_for_key(const std::string &akey) const;
-    const auto ROINameOpt = cc_ROIs.front().get().contours.front().GetMetadataValueAs<std::string>("ROIName");  // HACK! FIXME. TODO.
-    const auto& ROIName = ROINameOpt.value();
+features_t Contour_Features(const roi_group_t &g){
+    features_t out;
 
+    double TotalPerimeter = std::numeric_limits<double>::quiet_NaN();
+    double LongestPerimeter = std::numeric_limits<double>::quiet_NaN();
 
-    // Contour-based features.
-    std::stringstream contours_header;
-    std::stringstream contours_report;
-    {
-        double TotalPerimeter = std::numeric_limits<double>::quiet_NaN();
-        double LongestPerimeter = std::numeric_limits<double>::quiet_NaN();
-
-        for(const auto &cc_refw : cc_ROIs){
-            const auto p = cc_refw.get().Perimeter();
-            if(!std::isfinite(TotalPerimeter)){
-                TotalPerimeter = p;
-            }else{
-                TotalPerimeter += p;
-            }
+    for(const auto &cc_refw : g.ccs){
+        const auto p = cc_refw.get().Perimeter();
+        if(!std::isfinite(TotalPerimeter)){
+            TotalPerimeter = p;
+        }else{
+            TotalPerimeter += p;
+        }
 
-            const auto pl = cc_refw.get().Longest_Perimeter();
-            if(!std::isfinite(LongestPerimeter)){
-                LongestPerimeter = pl;
-            }else{
-                LongestPerimeter = std::max(LongestPerimeter, pl);
-            }
+        const auto pl = cc_refw.get().Longest_Perimeter();
+        if(!std::isfinite(LongestPerimeter)){
+            LongestPerimeter = pl;
+        }else{
+            LongestPerimeter = std::max(LongestPerimeter, pl);
         }
-        contours_header << ",TotalPerimeter";
-        contours_report << "," << TotalPerimeter;
-
-        contours_header << ",LongestPerimeter";
-        contours_report << "," << LongestPerimeter;
-
-        double LongestVertVertDistance = -1.0;
-        for(const auto &cc_refw : cc_ROIs){
-            for(const auto &cA : cc_refw.get().contours){
-                for(const auto &vA : cA.points){
-                    for(const auto &cB : cc_refw.get().contours){
-                        for(const auto &vB : cB.points){
-                            const auto dist = vB.distance( vA );
-                            if(dist > LongestVertVertDistance) LongestVertVertDistance = dist;
-                        }
+    }
+    out.emplace_back("TotalPerimeter", TotalPerimeter);
+    out.emplace_back("LongestPerimeter", LongestPerimeter);
+
+    double LongestVertVertDistance = -1.0;
+    for(const auto &cc_refw : g.ccs){
+        for(const auto &cA : cc_refw.get().contours){
+            for(const auto &vA : cA.points){
+                for(const auto &cB : cc_refw.get().contours){
+                    for(const auto &vB : cB.points){
+                        const auto dist = vB.distance( vA );
+                        if(dist > LongestVertVertDistance) LongestVertVertDistance = dist;
                     }
                 }
             }
         }
-        contours_header << ",LongestVertexVertexDistance";
-        contours_report << "," << LongestVertVertDistance;
-
     }
+    out.emplace_back("LongestVertexVertexDistance", LongestVertVertDistance);
+    return out;
+}
 
-    // Surface-mesh-based features.
-    std::stringstream smesh_header;
-    std::stringstream smesh_report;
-    {
-        dcma_surface_meshes::Parameters meshing_params;
-        meshing_params.RQ = dcma_surface_meshes::ReproductionQuality::Medium;
-        meshing_params.GridRows = 1024;
-        meshing_params.GridColumns = 1024;
-        auto smesh = dcma_surface_meshes::Estimate_Surface_Mesh( cc_ROIs, meshing_params );
-
-        //if(!polyhedron_processing::SaveAsOFF(smesh, "/tmp/test.off")){
-        //    FUNCERR("Unable to write mesh as OFF file");
-        //}
-
-
-        //polyhedron_processing::Subdivide(smesh, MeshSubdivisions);
-        //polyhedron_processing::Simplify(smesh, MeshSimplificationEdgeCountLimit);
-        //polyhedron_processing::SaveAsOFF(smesh, base_dir + "_polyhedron.off");
-
-        const auto V = polyhedron_processing::Volume(smesh);
-        smesh_header << ",MeshVolume";
-        smesh_report << "," << V;
-
-        const auto A = polyhedron_processing::SurfaceArea(smesh);
-        smesh_header << ",MeshSurfaceArea";
-        smesh_report << "," << A;
-
-        const auto SA_V = A/V;
-        smesh_header << ",MeshSurfaceAreaVolumeRatio";
-        smesh_report << "," << SA_V;
+features_t Mesh_Features(const roi_group_t &g){
+    features_t out;
 
-        const auto pi = std::acos(-1.0);
-        const auto Sph = std::pow(36.0 * pi * V * V, 1.0/3.0)/A;
-        smesh_header << ",MeshSphericity";
-        smesh_report << "," << Sph;
+    dcma_surface_meshes::Parameters meshing_params;
+    meshing_params.RQ = dcma_surface_meshes::ReproductionQuality::Medium;
+    meshing_params.GridRows = 1024;
+    meshing_params.GridColumns = 1024;
+    const auto smesh = dcma_surface_meshes::Estimate_Surface_Mesh( g.ccs, meshing_params );
 
-        const auto C = V/std::sqrt( pi * std::pow(A, 3.0) );
-        smesh_header << ",MeshCompactness";
-        smesh_report << "," << C;
-    }
+    const auto V = polyhedron_processing::Volume(smesh);
+    out.emplace_back("MeshVolume", V);
 
+    const auto A = polyhedron_processing::SurfaceArea(smesh);
+    out.emplace_back("MeshSurfaceArea", A);
+    out.emplace_back("MeshSurfaceAreaVolumeRatio", A/V);
 
-    std::mutex common_access;
-    std::stringstream header;
-    std::stringstream report;
+    const auto pi = std::acos(-1.0);
+    out.emplace_back("MeshSphericity", std::pow(36.0 * pi * V * V, 1.0/3.0)/A);
+    out.emplace_back("MeshCompactness", V/std::sqrt( pi * std::pow(A, 3.0) ));
+    return out;
+}
 
-    // Cycle over the Image_Arrays, processing each one-at-a-time.
-    auto IAs_all = All_IAs( DICOM_data );
-    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
-    for(auto & iap_it : IAs){
-        if((*iap_it)->imagecoll.images.empty()) throw std::invalid_argument("Unable to find an image to analyze.");
+features_t First_Order_Features(const std::vector<double> &voxel_vals){
+    features_t out;
+
+    const auto N_I    = static_cast<double>(voxel_vals.size());
+    const auto I_min  = Stats::Min(voxel_vals);
+    const auto I_max  = Stats::Max(voxel_vals);
+    const auto I_mean = Stats::Mean(voxel_vals);
+    const sorted_quantiles<double> ptiles(voxel_vals);
+    const auto I_02   = ptiles.quantile(0.02);
+    const auto I_05   = ptiles.quantile(0.05);
+    const auto I_10   = ptiles.quantile(0.10);
+    const auto I_25   = ptiles.quantile(0.25);
+    const auto I_50   = ptiles.quantile(0.50);
+    const auto I_75   = ptiles.quantile(0.75);
+    const auto I_90   = ptiles.quantile(0.90);
+    const auto I_95   = ptiles.quantile(0.95);
+    const auto I_98   = ptiles.quantile(0.98);
+
+    // Simple first-order statistics and derived quantities.
+    out.emplace_back("Min", I_min);
+    out.emplace_back("Percentile02", I_02);
+    out.emplace_back("Percentile05", I_05);
+    out.emplace_back("Percentile10", I_10);
+    out.emplace_back("Percentile25", I_25);
+    out.emplace_back("Mean", I_mean);
+    out.emplace_back("Median", I_50);
+    out.emplace_back("Percentile75", I_75);
+    out.emplace_back("Percentile90", I_90);
+    out.emplace_back("Percentile95", I_95);
+    out.emplace_back("Percentile98", I_98);
+    out.emplace_back("Max", I_max);
+    out.emplace_back("InterQuartileRange", (I_75 - I_25));
+    out.emplace_back("Range", (I_max - I_min));
+
+    // Deviations.
+    const auto central_moment = [&](long int n) -> double {
+        return std::accumulate( std::begin(voxel_vals), std::end(voxel_vals),
+                                static_cast<double>(0),
+                                [&](double run, double I) -> double {
+                                    double m = 1.0;
+                                    for(long int i = 0; i < n; ++i) m *= (I - I_mean);
+                                    return run + m;
+                                }) / N_I;
+    };
+    const auto Var = central_moment(2);
+    out.emplace_back("Variance", Var);
+
+    const auto StdDev = std::sqrt(Var);
+    out.emplace_back("StandardDeviation", StdDev);
+
+    const auto CM3 = central_moment(3);
+    const auto CM4 = central_moment(4);
+    out.emplace_back("CoefficientOfVariation", StdDev / I_mean);
+    out.emplace_back("Skewness", CM3 / (StdDev * StdDev * StdDev));
+
+    // Also known as Pearson's non-parametric second skewness coefficient.
+    out.emplace_back("PearsonsMedianSkewness", 3.0 * (I_mean - I_50) / StdDev);
+
+    const auto Kurtosis = CM4 / (StdDev * StdDev * StdDev * StdDev);
+    out.emplace_back("Kurtosis", Kurtosis);
+    out.emplace_back("ExcessKurtosis", Kurtosis - 3.0);
+
+    const auto MAD = std::accumulate( std::begin(voxel_vals), std::end(voxel_vals),
+                                      static_cast<double>(0),
+                                      [&](double run, double I) -> double {
+                                          return run + std::abs(I - I_mean);
+                                      }) / N_I;
+    out.emplace_back("MeanAbsoluteDeviation", MAD);
+
+    auto v = voxel_vals; // A vector comprised only of the inner 10th-90th percentile data.
+    v.erase( std::remove_if( std::begin(v), std::end(v), [&](double I){
+                //Remove all intensities not within the 10th and 90th percentiles.
+                return !isininc(I_10, I, I_90);
+             }),
+             std::end(v) );
+
+    const auto v_N_I    = static_cast<double>(v.size());
+    const auto v_I_mean = Stats::Mean(v);
+    const auto rMAD = std::accumulate( std::begin(v), std::end(v),
+                                       static_cast<double>(0),
+                                       [&](double run, double I) -> double {
+                                           return run + std::abs(I - v_I_mean);
+                                       }) / v_N_I;
+    out.emplace_back("RobustMeanAbsoluteDeviation", rMAD);
+
+    // Pixel intensity 'image energy.' Also a shifted energy with voxel intensities translated so the smallest voxel
+    // intensity contributes zero energy.
+    const auto E = std::accumulate( std::begin(voxel_vals), std::end(voxel_vals),
+                                    static_cast<double>(0),
+                                    [&](double run, double I) -> double {
+                                        return run + I*I;
+                                    });
+    out.emplace_back("IntensityEnergy", E);
+    out.emplace_back("RootMeanSquaredIntensity", std::sqrt(1.0*E/N_I));
+
+    const auto E_shifted = std::accumulate( std::begin(voxel_vals), std::end(voxel_vals),
+                                            static_cast<double>(0),
+                                            [&](double run, double I) -> double {
+                                                return run + (I + I_min) * (I + I_min);
+                                            });
+    out.emplace_back("ShiftedIntensityEnergy", E_shifted);
+    out.emplace_back("ShiftedRootMeanSquaredIntensity", std::sqrt(1.0*E_shifted/N_I));
+    return out;
+}
 
-        //Determine which PatientID(s) to report.
-        const auto PatientIDs = (*iap_it)->imagecoll.get_distinct_values_for_key("PatientID");
-        std::string PatientID;
-        if(PatientIDs.empty()){
-            PatientID = "Unknown";
-        }else if(PatientIDs.size() == 1){
-            PatientID = PatientIDs.front();
-        }else if(PatientIDs.size() == 1){
-            PatientID = std::accumulate(std::begin(PatientIDs), std::end(PatientIDs), std::string(), 
-                            [](const std::string &run, const std::string &id){
-                                return (run + (run.empty() ? "" : "_") + id);
-                            });
+// Grey level co-occurrence and run length features. Each image's bounded voxels are discretized into a dense grid of
+// integer grey levels spanning the mask's bounding box (with -1 marking unbounded voxels), so the matrices are
+// accumulated with integer comparisons and contiguous loads only.
+features_t Texture_Features(const ROI_Voxels &h, long int N_g){
+    const auto I_min = Stats::Min(h.get_values());
+    const auto I_max = Stats::Max(h.get_values());
+    const double scale = (I_min < I_max) ? static_cast<double>(N_g) / (I_max - I_min) : 0.0;
+
+    // In-plane directions; the opposite directions are accounted for by symmetry.
+    const std::array<std::array<long int, 2>, 4> dirs = {{ {{ 0, 1 }}, {{ 1, 1 }}, {{ 1, 0 }}, {{ 1, -1 }} }};
+
+    std::vector<uint64_t> glcm(N_g * N_g, 0);
+    std::vector<std::vector<uint64_t>> glrlm(N_g); // Indexed by grey level and (run length - 1).
+    uint64_t N_runs = 0;
+    uint64_t N_voxels = 0;
+
+    std::vector<int32_t> grid;
+    for(const auto &iv : h.get_images()){
+        const auto &img = *(iv.img);
+        const auto &mask = *(iv.mask);
+
+        long int r_min = mask.rows;
+        long int r_max = -1;
+        long int c_min = mask.columns;
+        long int c_max = -1;
+        for(long int row = 0; row < mask.rows; ++row){
+            const auto r_begin = mask.row_offsets[row];
+            const auto r_end = mask.row_offsets[row + 1];
+            if(r_begin == r_end) continue;
+            r_min = std::min(r_min, row);
+            r_max = std::max(r_max, row);
+            c_min = std::min(c_min, static_cast<long int>(mask.runs[r_begin][0]));
+            c_max = std::max(c_max, static_cast<long int>(mask.runs[r_end - 1][1]) - 1);
+        }
+        if(r_max < r_min) continue;
+
+        const long int H = r_max - r_min + 1;
+        const long int W = c_max - c_min + 1;
+        grid.assign(H * W, -1);
+        for(long int row = r_min; row <= r_max; ++row){
+            for(auto r = mask.row_offsets[row]; r < mask.row_offsets[row + 1]; ++r){
+                const auto run_end = static_cast<long int>(mask.runs[r][1]);
+                for(auto col = static_cast<long int>(mask.runs[r][0]); col < run_end; ++col){
+                    const auto val = static_cast<double>(img.value(row, col, 0));
+                    if(!std::isfinite(val)) continue;
+                    const auto bin = std::clamp<long int>(static_cast<long int>(std::floor((val - I_min) * scale)),
+                                                          0, N_g - 1);
+                    grid[(row - r_min) * W + (col - c_min)] = static_cast<int32_t>(bin);
+                    ++N_voxels;
+                }
+            }
         }
 
-        std::vector<double> voxel_vals;
-
-        PartitionedImageVoxelVisitorMutatorUserData ud;
-        ud.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
-        ud.mutation_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
-        ud.mutation_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
-        ud.mutation_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
-        ud.description = "";
-
-        //ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
-        //ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations;
-        ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
-
-        //ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Exclusive;
-        //ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
-        ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
-
-        std::function<void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &)> f_noop;
-        ud.f_unbounded = f_noop;
-        ud.f_visitor = f_noop;
-        ud.f_bounded = [&](long int /*row*/, 
-                           long int /*col*/, 
-                           long int /*chan*/, 
-                           std::reference_wrapper<planar_image<float,double>> /*img_refw*/, 
-                           float &voxel_val) {
-            // Append the value to the voxel store.
-            voxel_vals.emplace_back(voxel_val);
-
-            // Append the value rounded to the nearest integer to the voxel store.
-            //voxel_vals.emplace_back( static_cast<long int>( std::round(voxel_val) ) );
-            return;
+        const auto at = [&](long int row, long int col) -> int32_t {
+            return ( (0 <= row) && (row < H) && (0 <= col) && (col < W) ) ? grid[row * W + col] : -1;
         };
+        for(const auto &d : dirs){
+            for(long int row = 0; row < H; ++row){
+                for(long int col = 0; col < W; ++col){
+                    const auto a = grid[row * W + col];
+                    if(a < 0) continue;
+
+                    const auto b = at(row + d[0], col + d[1]);
+                    if(0 <= b){
+                        ++glcm[a * N_g + b];
+                        ++glcm[b * N_g + a];
+                    }
 
-        if(!(*iap_it)->imagecoll.Process_Images( GroupIndividualImages,
-                                                 PartitionedImageVoxelVisitorMutator,
-                                                 {}, cc_ROIs, &ud )){
-            throw std::runtime_error("Unable to harvest voxels within the specified ROI(s).");
+                    // Runs are counted from their first voxel.
+                    if(at(row - d[0], col - d[1]) == a) continue;
+                    long int len = 1;
+                    while(at(row + len * d[0], col + len * d[1]) == a) ++len;
+                    auto &runs = glrlm[a];
+                    if(static_cast<long int>(runs.size()) < len) runs.resize(len, 0);
+                    ++runs[len - 1];
+                    ++N_runs;
+                }
+            }
         }
+    }
 
-        // Process the voxel data.
-        if(voxel_vals.empty()){
-            throw std::domain_error("No voxels identified interior to the selected ROI(s). Cannot continue.");
-        }
+    features_t out;
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
 
-/*
-        //Ignore voxels outside of a specific window.
-        //
-        // Note: require the user to provide the window, or do not enable this step! TODO
-        {
-            voxel_vals.erase( std::remove_if( std::begin(voxel_vals), std::end(voxel_vals), [&](double I){
-                        //Remove all intensities not within the 10th and 90th percentiles.
-                        return !isininc(-500.0, I, 400.0);
-                     }),
-                     std::end(voxel_vals) );
+    // Co-occurrence features. Grey levels are numbered from one.
+    {
+        const auto N_pairs = static_cast<double>(std::accumulate(std::begin(glcm), std::end(glcm), uint64_t(0)));
+        double mu = 0.0;
+        for(long int i = 0; i < N_g; ++i){
+            for(long int j = 0; j < N_g; ++j){
+                mu += static_cast<double>(i + 1) * static_cast<double>(glcm[i * N_g + j]) / N_pairs;
+            }
         }
-*/       
 
-        //Reset the header.
-        {
-            std::stringstream dummy;
-            header = std::move(dummy);
+        double energy = 0.0, entropy = 0.0, contrast = 0.0, dissimilarity = 0.0, homogeneity = 0.0;
+        double var = 0.0, covar = 0.0;
+        for(long int i = 0; i < N_g; ++i){
+            for(long int j = 0; j < N_g; ++j){
+                const auto p = static_cast<double>(glcm[i * N_g + j]) / N_pairs;
+                if(p <= 0.0) continue;
+                const auto d = static_cast<double>(std::abs(i - j));
+                energy += p * p;
+                entropy -= p * std::log2(p);
+                contrast += d * d * p;
+                dissimilarity += d * p;
+                homogeneity += p / (1.0 + d);
+                var += (static_cast<double>(i + 1) - mu) * (static_cast<double>(i + 1) - mu) * p;
+                covar += (static_cast<double>(i + 1) - mu) * (static_cast<double>(j + 1) - mu) * p;
+            }
         }
+        const bool valid = (0.0 < N_pairs);
+        out.emplace_back("GLCMJointEnergy", valid ? energy : nan);
+        out.emplace_back("GLCMJointEntropy", valid ? entropy : nan);
+        out.emplace_back("GLCMContrast", valid ? contrast : nan);
+        out.emplace_back("GLCMDissimilarity", valid ? dissimilarity : nan);
+        out.emplace_back("GLCMInverseDifference", valid ? homogeneity : nan);
+        out.emplace_back("GLCMCorrelation", (valid && (0.0 < var)) ? covar / var : nan);
+    }
 
-        const auto N_I    = static_cast<double>(voxel_vals.size());
-        const auto I_min  = Stats::Min(voxel_vals);
-        const auto I_max  = Stats::Max(voxel_vals);
-        const auto I_mean = Stats::Mean(voxel_vals);
-        const auto I_02   = Stats::Percentile(voxel_vals, 0.02);
-        const auto I_05   = Stats::Percentile(voxel_vals, 0.05);
-        const auto I_10   = Stats::Percentile(voxel_vals, 0.10);
-        const auto I_25   = Stats::Percentile(voxel_vals, 0.25);
-        const auto I_50   = Stats::Percentile(voxel_vals, 0.50);
-        const auto I_75   = Stats::Percentile(voxel_vals, 0.75);
-        const auto I_90   = Stats::Percentile(voxel_vals, 0.90);
-        const auto I_95   = Stats::Percentile(voxel_vals, 0.95);
-        const auto I_98   = Stats::Percentile(voxel_vals, 0.98);
-
-        // Patient metadata.
-        {
-            header << "PatientID";
-            report << PatientID;
-            
-            header << ",ROIName";
-            report << "," << ROIName;
-            
-            header << ",UserComment";
-            report << "," << UserComment;
+    // Run length features.
+    {
+        double sre = 0.0, lre = 0.0, glnu = 0.0;
+        std::vector<double> by_length;
+        for(long int i = 0; i < N_g; ++i){
+            double by_level = 0.0;
+            for(size_t j = 0; j < glrlm[i].size(); ++j){
+                const auto r = static_cast<double>(glrlm[i][j]);
+                const auto len = static_cast<double>(j + 1);
+                sre += r / (len * len);
+                lre += r * len * len;
+                by_level += r;
+                if(by_length.size() <= j) by_length.resize(j + 1, 0.0);
+                by_length[j] += r;
+            }
+            glnu += by_level * by_level;
         }
+        double rlnu = 0.0;
+        for(const auto &r : by_length) rlnu += r * r;
+
+        const auto N_r = static_cast<double>(N_runs);
+        const bool valid = (0 < N_runs);
+        out.emplace_back("GLRLMShortRunsEmphasis", valid ? sre / N_r : nan);
+        out.emplace_back("GLRLMLongRunsEmphasis", valid ? lre / N_r : nan);
+        out.emplace_back("GLRLMGreyLevelNonUniformity", valid ? glnu / N_r : nan);
+        out.emplace_back("GLRLMRunLengthNonUniformity", valid ? rlnu / N_r : nan);
+        out.emplace_back("GLRLMRunPercentage", valid ? N_r / (static_cast<double>(dirs.size() * N_voxels)) : nan);
+    }
+    return out;
+}
 
+} // namespace
 
-        // Simple first-order statistics and derived quantities.
-        {
-            header << ",Min";
-            report << "," << I_min;
-
-            header << ",Percentile02";
-            report << "," << I_02;
+Drover ExtractRadiomicFeatures(Drover DICOM_data,
+                               const OperationArgPkg& OptArgs,
+                               const std::map<std::string, std::string>& /*InvocationMetadata*/,
+                               const std::string& FilenameLex){
 
-            header << ",Percentile05";
-            report << "," << I_05;
+    const lexicon_translator X(FilenameLex);
 
-            header << ",Percentile10";
-            report << "," << I_10;
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    auto FeaturesFileName = OptArgs.getValueStr("FeaturesFileName").value();
 
-            header << ",Percentile25";
-            report << "," << I_25;
+    const auto UserComment = OptArgs.getValueStr("UserComment").value_or("");
 
-            header << ",Mean";
-            report << "," << I_mean;
+    const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
+    const auto ROILabelRegex = OptArgs.getValueStr("ROILabelRegex").value();
 
-            header << ",Median";
-            report << "," << I_50;
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
 
-            header << ",Percentile75";
-            report << "," << I_75;
+    const auto PerROIStr = OptArgs.getValueStr("PerROI").value();
+    const auto TextureBins = std::stol( OptArgs.getValueStr("TextureBins").value() );
 
-            header << ",Percentile90";
-            report << "," << I_90;
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_true = Compile_Regex("^tr?u?e?$");
+    const auto PerROI = std::regex_match(PerROIStr, regex_true);
 
-            header << ",Percentile95";
-            report << "," << I_95;
+    if(TextureBins < 0){
+        throw std::invalid_argument("The number of texture bins must be non-negative.");
+    }
 
-            header << ",Percentile98";
-            report << "," << I_98;
+    //Stuff references to all contours into a list. Remember that you can still address specific contours through
+    // the original holding containers (which are not modified here).
+    auto cc_all = All_CCs( DICOM_data );
+    auto cc_ROIs = Whitelist( cc_all, { { "ROIName", ROILabelRegex },
+                                        { "NormalizedROIName", NormalizedROILabelRegex } } );
 
-            header << ",Max";
-            report << "," << I_max;
+    if(cc_ROIs.empty()){
+        throw std::invalid_argument("No contours selected. Cannot continue.");
+    }
 
-            header << ",InterQuartileRange";
-            report << "," << (I_75 - I_25);
+    // Group the contours. When combined, the ROI is named after the first contour.
+    std::vector<roi_group_t> groups;
+    for(const auto &cc_refw : cc_ROIs){
+        if(cc_refw.get().contours.empty()) continue;
+        const auto ROIName = cc_refw.get().contours.front().GetMetadataValueAs<std::string>("ROIName")
+                                                           .value_or("Unknown");
+        auto g_it = std::find_if(std::begin(groups), std::end(groups),
+                                 [&](const roi_group_t &g){ return !PerROI || (g.ROIName == ROIName); });
+        if(g_it == std::end(groups)){
+            groups.emplace_back();
+            groups.back().ROIName = ROIName;
+            g_it = std::prev(std::end(groups));
+        }
+        g_it->ccs.push_back(cc_refw);
+    }
+    if(groups.empty()){
+        throw std::invalid_argument("Selected contours are all empty. Cannot continue.");
+    }
+    const auto N_groups = static_cast<long int>(groups.size());
 
-            header << ",Range";
-            report << "," << (I_max - I_min);
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+    std::vector<std::shared_ptr<Image_Array>> arrays;
+    std::vector<std::string> PatientIDs;
+    for(auto & iap_it : IAs){
+        if((*iap_it)->imagecoll.images.empty()) throw std::invalid_argument("Unable to find an image to analyze.");
+        arrays.emplace_back(*iap_it);
 
-/*
-            header << ",";
-            report << "," << ;
-*/
+        //Determine which PatientID(s) to report.
+        const auto IDs = (*iap_it)->imagecoll.get_distinct_values_for_key("PatientID");
+        PatientIDs.emplace_back( std::accumulate(std::begin(IDs), std::end(IDs), std::string(),
+                                                 [](const std::string &run, const std::string &id){
+                                                     return (run + (run.empty() ? "" : "_") + id);
+                                                 }) );
+        if(PatientIDs.back().empty()) PatientIDs.back() = "Unknown";
+    }
+    const auto N_arrays = static_cast<long int>(arrays.size());
 
+    // Shape features depend only on the ROIs, so they are computed once per ROI. Voxel features are computed for every
+    // combination of image array and ROI. All are independent.
+    std::vector<features_t> shape_features(N_groups);
+    std::vector<features_t> voxel_features(N_arrays * N_groups);
+    std::vector<features_t> texture_features(N_arrays * N_groups);
+    {
+        task_group tg;
+        for(long int g = 0; g < N_groups; ++g){
+            tg.run([&,g]() -> void {
+                shape_features[g] = Contour_Features(groups[g]);
+                const auto smesh = Mesh_Features(groups[g]);
+                shape_features[g].insert(std::end(shape_features[g]), std::begin(smesh), std::end(smesh));
+            });
         }
-
-        // Deviations.
-        {
-            const auto Var = std::accumulate(
-                               std::begin(voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + (I - I_mean) * (I - I_mean);
-                               }) / N_I;
-                                
-            header << ",Variance";
-            report << "," << Var;
-
-            const auto StdDev = std::sqrt(Var);
-
-            header << ",StandardDeviation";
-            report << "," << StdDev;
-
-
-            const auto CM3 = std::accumulate(
-                               std::begin(voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + (I - I_mean) * (I - I_mean) * (I - I_mean);
-                               }) / N_I;
-                                
-            const auto CM4 = std::accumulate(
-                               std::begin(voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + (I - I_mean) * (I - I_mean) * (I - I_mean) * (I - I_mean);
-                               }) / N_I;
-                                
-            const auto CV = StdDev / I_mean;
-
-            header << ",CoefficientOfVariation";
-            report << "," << CV;
-
-            const auto Skewness = CM3 / (StdDev * StdDev * StdDev);
-
-            header << ",Skewness";
-            report << "," << Skewness;
-
-            const auto pSkewness = 3.0 * (I_mean - I_50) / StdDev;
-
-            header << ",PearsonsMedianSkewness"; // Also known as Pearson's non-parametric second skewness coefficient.
-            report << "," << pSkewness;
-
-            const auto Kurtosis = CM4 / (StdDev * StdDev * StdDev * StdDev);
-
-            header << ",Kurtosis";
-            report << "," << Kurtosis;
-
-            const auto eKurtosis = Kurtosis - 3.0;
-
-            header << ",ExcessKurtosis";
-            report << "," << eKurtosis;
-
-            const auto MAD = std::accumulate(
-                               std::begin(voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + std::abs(I - I_mean);
-                               }) / N_I;
-                                
-            header << ",MeanAbsoluteDeviation";
-            report << "," << MAD;
-
-            auto v = voxel_vals; // A vector comprised only of the inner 10th-90th percentile data.
-            v.erase( std::remove_if( std::begin(v), std::end(v), [&](double I){
-                        //Remove all intensities not within the 10th and 90th percentiles.
-                        return !isininc(I_10, I, I_90);
-                     }),
-                     std::end(v) );
-
-            const auto v_N_I    = static_cast<double>(v.size());
-            const auto v_I_mean = Stats::Mean(v);
-            const auto rMAD = std::accumulate(
-                               std::begin(v), std::end(v),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + std::abs(I - v_I_mean);
-                               }) / v_N_I;
-                                
-            header << ",RobustMeanAbsoluteDeviation";
-            report << "," << rMAD;
+        for(long int a = 0; a < N_arrays; ++a){
+            for(long int g = 0; g < N_groups; ++g){
+                tg.run([&,a,g]() -> void {
+                    // The extraction is shared with other reports over the same array and ROIs.
+                    const auto h = Get_ROI_Voxels(*(arrays[a]), groups[g].ccs);
+                    if(h->size() == 0){
+                        throw std::domain_error("No voxels identified interior to the selected ROI(s)."
+                                                " Cannot continue.");
+                    }
+                    voxel_features[a * N_groups + g] = First_Order_Features(h->get_values());
+                    if(0 < TextureBins) texture_features[a * N_groups + g] = Texture_Features(*h, TextureBins);
+                });
+            }
         }
+        tg.wait();
+    }
 
-        // Pixel intensity 'image energy.' Also a shifted energy with voxel intensities translated so the smallest voxel
-        // intensity contributes zero energy.
-        {
-            const auto E = std::accumulate(std::begin(
-                               voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + I*I;
-                               });
-                                
-            header << ",IntensityEnergy";
-            report << "," << E;
-
-            const auto RMSI = std::sqrt(1.0*E/N_I);
-            header << ",RootMeanSquaredIntensity";
-            report << "," << RMSI;
-
-            const auto E_shifted = std::accumulate(std::begin(
-                               voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + (I + I_min) * (I + I_min);
-                               });
-                                
-            header << ",ShiftedIntensityEnergy";
-            report << "," << E_shifted;
-
-            const auto RMSI_shifted = std::sqrt(1.0*E_shifted/N_I);
-            header << ",ShiftedRootMeanSquaredIntensity";
-            report << "," << RMSI_shifted;
+    std::stringstream header;
+    std::stringstream report;
+    for(long int a = 0; a < N_arrays; ++a){
+        for(long int g = 0; g < N_groups; ++g){
+            std::stringstream row_header;
+            row_header << "PatientID,ROIName,UserComment";
+            report << PatientIDs[a] << "," << groups[g].ROIName << "," << UserComment;
+
+            for(const auto *f : { &voxel_features[a * N_groups + g],
+                                  &shape_features[g],
+                                  &texture_features[a * N_groups + g] }){
+                for(const auto &p : *f){
+                    row_header << "," << p.first;
+                    report << "," << p.second;
+                }
+            }
+            row_header << std::endl;
+            report << std::endl;
+            header = std::move(row_header);
         }
-
-
-        // Add the contour- and surface-mesh-based features.
-        header << contours_header.str();
-        report << contours_report.str();
-
-        header << smesh_header.str();
-        report << smesh_report.str();
-
-        header << std::endl;
-        report << std::endl;
     }
 
-    //Print the report.
-    //std::cout << report.str();
-
     //Write the report to file.
     try{
         auto gen_filename = [&]() -> std::string {
@@ -536,7 +604,6 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
             return FeaturesFileName;
         };
 
-        FUNCINFO("About to claim a mutex");
         Append_File( gen_filename,
                      "dicomautomaton_operation_extractradiomicfeatures_mutex",
                      header.str(),
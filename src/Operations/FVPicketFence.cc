@@ -4,6 +4,7 @@
 #include <list>
 #include <map>
 #include <string>    
+#include <utility>
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
@@ -136,16 +137,16 @@ Drover FVPicketFence(Drover DICOM_data,
                      const std::map<std::string, std::string>& InvocationMetadata,
                      const std::string& FilenameLex){
 
-    DICOM_data = ContourWholeImages(DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
-    DICOM_data = IsolatedVoxelFilter(DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+    DICOM_data = ContourWholeImages(std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
+    DICOM_data = IsolatedVoxelFilter(std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
 
-    DICOM_data = AutoCropImages(DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
-    DICOM_data = CropImages(DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+    DICOM_data = AutoCropImages(std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
+    DICOM_data = CropImages(std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
 
-    DICOM_data = AnalyzePicketFence(DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+    DICOM_data = AnalyzePicketFence(std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
 
 #ifdef DCMA_USE_SFML    
-    DICOM_data = PresentationImage(DICOM_data, OptArgs, InvocationMetadata, FilenameLex);
+    DICOM_data = PresentationImage(std::move(DICOM_data), OptArgs, InvocationMetadata, FilenameLex);
 #endif
 
     return DICOM_data;
@@ -2,6 +2,7 @@
 
 #include <asio.hpp>
 #include <algorithm>
+#include <atomic>
 #include <optional>
 #include <fstream>
 #include <iterator>
@@ -109,14 +110,19 @@ OperationDoc OpArgDocForEachDistinct() {
         "If this operation has no children, this operation will evaluate to a no-op."
     );
     out.notes.emplace_back(
-        "Each invocation is performed sequentially, and all side-effects are carried forward for each iteration."
-        " However, partitions are generated before any child operations are invoked, so newly-added elements (e.g.,"
-        " new Image_Arrays) created by one invocation will not participate in subsequent invocations."
+        "By default, each invocation is performed sequentially, and all side-effects are carried forward for each"
+        " iteration. However, partitions are generated before any child operations are invoked, so newly-added"
+        " elements (e.g., new Image_Arrays) created by one invocation will not participate in subsequent invocations."
         " The final order of the partitions is arbitrary."
     );
     out.notes.emplace_back(
         " This operation will most often be used to process data group-wise rather than as a whole."
     );
+    out.notes.emplace_back(
+        "Partitions can optionally be processed concurrently. Each partition holds distinct data, but children"
+        " operations with external side-effects (e.g., writing to the same file) must not conflict with one another."
+        " Regardless of concurrency, partitions are recombined in the same order."
+    );
 
     out.args.emplace_back();
     out.args.back().name = "KeysCommon";
@@ -132,6 +138,15 @@ OperationDoc OpArgDocForEachDistinct() {
                                  "SeriesInstanceUID", 
                                  "StationName" };
 
+    out.args.emplace_back();
+    out.args.back().name = "Concurrency";
+    out.args.back().desc = "The maximum number of partitions to process concurrently."
+                           " The default processes partitions one at a time."
+                           " Zero uses as many as the process-wide worker pool provides.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "2", "4", "0" };
+
     return out;
 }
 
@@ -141,6 +156,7 @@ Drover ForEachDistinct(Drover DICOM_data,
               const std::string& FilenameLex){
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto KeysCommonStr = OptArgs.getValueStr("KeysCommon").value();
+    const auto Concurrency = std::stol( OptArgs.getValueStr("Concurrency").value() );
 
     //-----------------------------------------------------------------------------------------------------------------
 
@@ -213,8 +229,36 @@ Drover ForEachDistinct(Drover DICOM_data,
 
         // Invoke children operations over each valid partition.
         FUNCINFO("Performing children operations over " << partitions.size() << " partitions (+1 'N/A' partition)");
-        for(auto & p : partitions){
-            if(!Operation_Dispatcher(p.second, InvocationMetadata, FilenameLex, OptArgs.getChildren())){
+        const auto plan = Compile_Operations(OptArgs.getChildren());
+        if(Concurrency < 0){
+            throw std::invalid_argument("Concurrency must be non-negative. Cannot continue");
+
+        }else if( (Concurrency == 1)
+              ||  (partitions.size() <= 1) ){
+            for(auto & p : partitions){
+                if(!Operation_Dispatcher(p.second, InvocationMetadata, FilenameLex, plan)){
+                    throw std::runtime_error("Child analysis failed. Cannot continue");
+                }
+            }
+
+        }else{
+            // Partitions share no data, so each can be processed independently. Nested parallelism within children
+            // operations shares the same worker pool.
+            std::atomic<bool> failed{false};
+            {
+                task_group tg(Concurrency);
+                for(auto & p : partitions){
+                    auto *d = &(p.second);
+                    tg.run([&, d]() -> void {
+                        if(failed.load()) return;
+                        if(!Operation_Dispatcher(*d, InvocationMetadata, FilenameLex, plan)){
+                            failed.store(true);
+                        }
+                    });
+                }
+                tg.wait();
+            }
+            if(failed.load()){
                 throw std::runtime_error("Child analysis failed. Cannot continue");
             }
         }
@@ -46,6 +46,19 @@ OperationDoc OpArgDocGenerateSurfaceMask(){
     out.args.back().expected = true;
     out.args.back().examples = { "0.0", "-1.0", "1.23", "2.34E26" };
 
+    out.args.emplace_back();
+    out.args.back().name = "SurfaceThickness";
+    out.args.back().desc = "Controls how the surface is identified."
+                           " If zero, voxels are compared with their immediate in-plane neighbours and the nearest"
+                           " voxels of adjacent images, and the surface comprises voxels that differ from one of them."
+                           " If positive, the surface comprises all voxels within this distance (in DICOM units; mm)"
+                           " of a voxel on the other side of the ROI boundary. Distances are computed exactly with a"
+                           " Euclidean distance transform, which requires the images to form a regular rectilinear"
+                           " grid but is considerably faster.";
+    out.args.back().default_val = "0.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0", "1.0", "2.5", "5.0" };
+
 
 
     out.args.emplace_back();
@@ -72,6 +85,7 @@ Drover GenerateSurfaceMask(Drover DICOM_data,
     const auto BackgroundVal  = std::stod(OptArgs.getValueStr("BackgroundVal").value());
     const auto InteriorVal    = std::stod(OptArgs.getValueStr("InteriorVal").value());
     const auto SurfaceVal     = std::stod(OptArgs.getValueStr("SurfaceVal").value());
+    const auto SurfaceThickness = std::stod(OptArgs.getValueStr("SurfaceThickness").value());
     const auto ROILabelRegex  = OptArgs.getValueStr("ROILabelRegex").value();
     const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
     //-----------------------------------------------------------------------------------------------------------------
@@ -98,6 +112,7 @@ Drover GenerateSurfaceMask(Drover DICOM_data,
     ud.background_val = BackgroundVal;
     ud.surface_val    = SurfaceVal;
     ud.interior_val   = InteriorVal;
+    ud.surface_thickness = SurfaceThickness;
 
     if(!img_arr_ptr->imagecoll.Compute_Images( ComputeGenerateSurfaceMask, { },
                                                cc_ROIs, &ud )){
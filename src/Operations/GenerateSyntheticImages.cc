@@ -1,6 +1,7 @@
 //GenerateSyntheticImages.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <list>
 #include <map>
@@ -8,10 +9,13 @@
 #include <stdexcept>
 #include <string>    
 
+#include <boost/filesystem.hpp>
+
 #include "../Imebra_Shim.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "Explicator.h"       //Needed for Explicator class.
+#include "../Synthetic_Images.h"
 #include "GenerateSyntheticImages.h"
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -25,6 +29,12 @@ OperationDoc OpArgDocGenerateSyntheticImages(){
         "This operation generates a synthetic, regular bitmap image array."
         " It can be used for testing how images are quantified or transformed.";
 
+    out.notes.emplace_back(
+        "Images are generated concurrently. If an ArchiveFilename is provided, images are instead generated in small"
+        " batches and written directly to a native archive, so arrays far larger than the available memory can be"
+        " generated (e.g., for load-testing). In this case no images are added to the Drover."
+    );
+
     out.args.emplace_back();
     out.args.back().name = "NumberOfImages";
     out.args.back().desc = "The number of images to create.";
@@ -185,6 +195,23 @@ OperationDoc OpArgDocGenerateSyntheticImages(){
     out.args.back().expected = false;
     out.args.back().examples = { "keyA@valueA;keyB@valueB" };
 
+    out.args.emplace_back();
+    out.args.back().name = "ArchiveFilename";
+    out.args.back().desc = "If provided, images are streamed to a native archive at this location rather than being"
+                           " retained in memory. The archive can be loaded like any other native archive.";
+    out.args.back().default_val = "";
+    out.args.back().expected = false;
+    out.args.back().examples = { "/tmp/synthetic.dcma", "synthetic.dcma" };
+
+    out.args.emplace_back();
+    out.args.back().name = "ArchiveFormat";
+    out.args.back().desc = "The native archive format to use when an ArchiveFilename is provided."
+                           " 'native' stores voxel data uncompressed, and 'native-compressed' losslessly compresses"
+                           " voxel data.";
+    out.args.back().default_val = "native";
+    out.args.back().expected = true;
+    out.args.back().examples = { "native", "native-compressed" };
+
     return out;
 }
 
@@ -193,7 +220,7 @@ Drover GenerateSyntheticImages(Drover DICOM_data,
                                const std::map<std::string, std::string>&,
                                const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto NumberOfImages = std::stol( OptArgs.getValueStr("NumberOfImages").value() );
@@ -213,7 +240,7 @@ Drover GenerateSyntheticImages(Drover DICOM_data,
     const auto ImageOrientationColumnStr = OptArgs.getValueStr("ImageOrientationColumn").value();
     const auto ImageOrientationRowStr = OptArgs.getValueStr("ImageOrientationRow").value();
 
-    auto InstanceNumber = std::stol( OptArgs.getValueStr("InstanceNumber").value() );
+    const auto InstanceNumber = std::stol( OptArgs.getValueStr("InstanceNumber").value() );
     const auto AcquisitionNumber = std::stol( OptArgs.getValueStr("AcquisitionNumber").value() );
 
     const auto VoxelValue = std::stod( OptArgs.getValueStr("VoxelValue").value() );
@@ -221,6 +248,9 @@ Drover GenerateSyntheticImages(Drover DICOM_data,
 
     const auto MetadataOpt = OptArgs.getValueStr("Metadata");
 
+    const auto ArchiveFilenameOpt = OptArgs.getValueStr("ArchiveFilename");
+    const auto ArchiveFormatStr = OptArgs.getValueStr("ArchiveFormat").value();
+
     //-----------------------------------------------------------------------------------------------------------------
 
     const auto parse_vec3 = [](const std::string &in) -> vec3<double> {
@@ -236,7 +266,7 @@ Drover GenerateSyntheticImages(Drover DICOM_data,
         return out;
     };
     const auto ImageAnchor = parse_vec3(ImageAnchorStr);
-    auto ImagePosition = parse_vec3(ImagePositionStr);
+    const auto ImagePosition = parse_vec3(ImagePositionStr);
 
     auto ImageOrientationColumn = parse_vec3(ImageOrientationColumnStr).unit();
     auto ImageOrientationRow = parse_vec3(ImageOrientationRowStr).unit();
@@ -248,6 +278,12 @@ Drover GenerateSyntheticImages(Drover DICOM_data,
     ImageOrientationRow = ImageOrientationRow.unit();
     ImageOrientationOrtho = ImageOrientationOrtho.unit();
 
+    const auto regex_native   = Compile_Regex("^na?t?i?v?e?$");
+    const auto regex_native_c = Compile_Regex("^na?t?i?v?e?-?co?m?p?r?e?s?s?e?d?$");
+    const bool compress = std::regex_match(ArchiveFormatStr, regex_native_c);
+    if(!compress && !std::regex_match(ArchiveFormatStr, regex_native)){
+        throw std::invalid_argument("ArchiveFormat not understood. Refusing to continue.");
+    }
 
     // Parse user-provided metadata.
     std::map<std::string, std::string> Metadata;
@@ -281,11 +317,6 @@ Drover GenerateSyntheticImages(Drover DICOM_data,
         }
     }
 
-    using loaded_imgs_storage_t = decltype(DICOM_data.image_data);
-    std::list<loaded_imgs_storage_t> loaded_imgs_storage;
-    //std::shared_ptr<Contour_Data> loaded_contour_data_storage = std::make_shared<Contour_Data>();
-
-
     // Temporal metadata.
     const std::string ContentDate = "20190427";
     const std::string ContentTime = "111558";
@@ -301,97 +332,74 @@ Drover GenerateSyntheticImages(Drover DICOM_data,
     const std::string Modality = "CT";
 
     // --- The virtual 'signal' image series ---
-    loaded_imgs_storage.emplace_back();
-    for(long int img_index = 0; img_index < NumberOfImages; ++img_index){
-        const std::string SOPInstanceUID = Generate_Random_String_of_Length(6);
-
-        auto out = std::make_unique<Image_Array>();
-        out->imagecoll.images.emplace_back();
-
-        out->imagecoll.images.back().metadata["Filename"] = OriginFilename;
-
-        out->imagecoll.images.back().metadata["PatientID"] = PatientID;
-        out->imagecoll.images.back().metadata["StudyInstanceUID"] = StudyInstanceUID;
-        out->imagecoll.images.back().metadata["SeriesInstanceUID"] = SeriesInstanceUID;
-        out->imagecoll.images.back().metadata["SOPInstanceUID"] = SOPInstanceUID;
-
-        out->imagecoll.images.back().metadata["Rows"] = std::to_string(NumberOfRows);
-        out->imagecoll.images.back().metadata["Columns"] = std::to_string(NumberOfColumns);
-        out->imagecoll.images.back().metadata["SliceThickness"] = std::to_string(SliceThickness);
-        out->imagecoll.images.back().metadata["SpacingBetweenSlices"] = std::to_string(SpacingBetweenSlices);
-        out->imagecoll.images.back().metadata["ImagePositionPatient"] = std::to_string(ImagePosition.x) + "\\"
-                                                                      + std::to_string(ImagePosition.y) + "\\"
-                                                                      + std::to_string(ImagePosition.z);
-        out->imagecoll.images.back().metadata["ImageOrientationPatient"] = std::to_string(ImageOrientationRow.x) + "\\"
-                                                                         + std::to_string(ImageOrientationRow.y) + "\\"
-                                                                         + std::to_string(ImageOrientationRow.z) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.x) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.y) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.z);
-        out->imagecoll.images.back().metadata["PixelSpacing"] = std::to_string(VoxelWidth) + "\\" + std::to_string(VoxelHeight);
-        out->imagecoll.images.back().metadata["FrameOfReferenceUID"] = FrameOfReferenceUID;
-
-        out->imagecoll.images.back().metadata["StudyTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["SeriesTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["AcquisitionTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["ContentTime"] = ContentTime;
-
-        out->imagecoll.images.back().metadata["StudyDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["SeriesDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["AcquisitionDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["ContentDate"] = ContentDate;
-
-        out->imagecoll.images.back().metadata["InstanceNumber"] = std::to_string(InstanceNumber);
-        out->imagecoll.images.back().metadata["AcquisitionNumber"] = std::to_string(AcquisitionNumber);
-
-        out->imagecoll.images.back().metadata["Modality"] = Modality;
+    synthetic_image_series series;
+    series.images = NumberOfImages;
+    series.rows = NumberOfRows;
+    series.columns = NumberOfColumns;
+    series.channels = NumberOfChannels;
+    series.pxl_dx = VoxelWidth;
+    series.pxl_dy = VoxelHeight;
+    series.pxl_dz = SliceThickness;
+    series.anchor = ImageAnchor;
+    series.position = ImagePosition;
+    series.step = ImageOrientationOrtho * SpacingBetweenSlices;
+    series.row_unit = ImageOrientationRow;
+    series.col_unit = ImageOrientationColumn;
+    series.generate_uid = [](){ return Generate_Random_String_of_Length(6); };
+
+    series.metadata["Filename"] = OriginFilename;
+
+    series.metadata["PatientID"] = PatientID;
+    series.metadata["StudyInstanceUID"] = StudyInstanceUID;
+    series.metadata["SeriesInstanceUID"] = SeriesInstanceUID;
+
+    series.metadata["SpacingBetweenSlices"] = std::to_string(SpacingBetweenSlices);
+    series.metadata["FrameOfReferenceUID"] = FrameOfReferenceUID;
+
+    series.metadata["StudyTime"] = ContentTime;
+    series.metadata["SeriesTime"] = ContentTime;
+    series.metadata["AcquisitionTime"] = ContentTime;
+    series.metadata["ContentTime"] = ContentTime;
+
+    series.metadata["StudyDate"] = ContentDate;
+    series.metadata["SeriesDate"] = ContentDate;
+    series.metadata["AcquisitionDate"] = ContentDate;
+    series.metadata["ContentDate"] = ContentDate;
+
+    series.metadata["AcquisitionNumber"] = std::to_string(AcquisitionNumber);
+
+    series.metadata["Modality"] = Modality;
+
+    series.fill = [&](long int img_index, planar_image<float,double> &img) -> void {
+        img.metadata["InstanceNumber"] = std::to_string(InstanceNumber + img_index);
 
         // Finally, insert user-specified metadata.
         //
         // Note: This must occur last so it overwrites incumbent metadata entries.
         for(const auto &kvp : Metadata){
-            out->imagecoll.images.back().metadata[kvp.first] = kvp.second;
+            img.metadata[kvp.first] = kvp.second;
         }
 
-        // ---
-
-        out->imagecoll.images.back().init_orientation(ImageOrientationRow, ImageOrientationColumn);
-        out->imagecoll.images.back().init_buffer(NumberOfRows, NumberOfColumns, NumberOfChannels);
-        out->imagecoll.images.back().init_spatial(VoxelWidth, VoxelHeight, SliceThickness, ImageAnchor, ImagePosition);
-
-        out->imagecoll.images.back().fill_pixels(VoxelValue);
+        img.fill_pixels(VoxelValue);
 
         if(std::isfinite(StipleValue)){
             for(long int row = 0; row < NumberOfRows; ++row){
                 for(long int col = 0; col < NumberOfColumns; ++col){
-                    //const auto R = out->imagecoll.images.back().position(row,col);
                     for(long int chnl = 0; chnl < NumberOfChannels; ++chnl){
                         const auto stipled = ( (img_index + row + col + chnl) % 2) == 0;
                         const auto val = (stipled) ? StipleValue : VoxelValue;
-                        out->imagecoll.images.back().reference(row,col,chnl) = val;
+                        img.reference(row,col,chnl) = val;
                     } //Loop over channels.
                 } //Loop over columns.
             } //Loop over rows.
         }
+    };
 
-
-        ImagePosition += ImageOrientationOrtho * SpacingBetweenSlices;
-        ++InstanceNumber;
-
-        loaded_imgs_storage.back().push_back( std::move( out ) );
-    }
-
-
-    //Collate each group of images into a single set, if possible. Also stuff the correct contour data in the same set.
-    for(auto &loaded_img_set : loaded_imgs_storage){
-        if(loaded_img_set.empty()) continue;
-
-        auto collated_imgs = Collate_Image_Arrays(loaded_img_set);
-        if(!collated_imgs){
-            throw std::runtime_error("Unable to collate images. Virtual data should never cause this error.");
-        }
-
-        DICOM_data.image_data.emplace_back(std::move(collated_imgs));
+    if(ArchiveFilenameOpt){
+        const boost::filesystem::path apath(ArchiveFilenameOpt.value());
+        Stream_Synthetic_Images_to_Native_Archive(series, apath, compress);
+    }else if(0 < NumberOfImages){
+        DICOM_data.image_data.emplace_back( Generate_Synthetic_Images(series) );
     }
 
     //Create an empty contour set iff one does not exist.
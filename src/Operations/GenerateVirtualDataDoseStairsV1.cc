@@ -9,9 +9,10 @@
 #include <string>    
 
 #include "../Imebra_Shim.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "Explicator.h"       //Needed for Explicator class.
+#include "../Synthetic_Images.h"
 #include "GenerateVirtualDataDoseStairsV1.h"
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -32,11 +33,7 @@ Drover GenerateVirtualDataDoseStairsV1(Drover DICOM_data,
                                        const std::map<std::string, std::string>&,
                                        const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
-
-    using loaded_imgs_storage_t = decltype(DICOM_data.image_data);
-    std::list<loaded_imgs_storage_t> loaded_imgs_storage;
-    //std::shared_ptr<Contour_Data> loaded_contour_data_storage = std::make_shared<Contour_Data>();
+    const lexicon_translator X(FilenameLex);
 
     const float Dmax = 70.0; //Gray.
 
@@ -45,7 +42,6 @@ Drover GenerateVirtualDataDoseStairsV1(Drover DICOM_data,
     long int Columns = 20;
     long int Channels = 1;
 
-    const double SliceThickness = 1.0;
     const double SliceLocation  = 1.0;
     const double SpacingBetweenSlices = 1.0;
     const vec3<double> ImageAnchor(0.0, 0.0, 0.0);
@@ -56,9 +52,8 @@ Drover GenerateVirtualDataDoseStairsV1(Drover DICOM_data,
     const double ImagePixeldx = 1.0; //Spacing between adjacent columns.
     const double ImageThickness = 1.0;
 
-    long int InstanceNumber = 1; //Gets bumped for each image.
-    long int SliceNumber    = 1; //Gets bumped at each temporal bump.
-    long int ImageIndex     = 1; //For PET series. Not sure when to bump...
+    const long int SliceNumber = 1;
+    const long int ImageIndex  = 1; //For PET series.
     const long int AcquisitionNumber = 1;
 
     // Temporal metadata.
@@ -77,83 +72,56 @@ Drover GenerateVirtualDataDoseStairsV1(Drover DICOM_data,
 
 
     // --- The virtual 'signal' image series ---
-    loaded_imgs_storage.emplace_back();
-    SliceNumber = 1;
-    for(long int time_index = 0; time_index < 1; ++time_index, ++SliceNumber){
-        const std::string SOPInstanceUID = Generate_Random_UID(60);
-
-        auto out = std::make_unique<Image_Array>();
-        out->imagecoll.images.emplace_back();
-
-        out->imagecoll.images.back().metadata["Filename"] = OriginFilename;
-
-        out->imagecoll.images.back().metadata["PatientID"] = PatientID;
-        out->imagecoll.images.back().metadata["StudyInstanceUID"] = StudyInstanceUID;
-        out->imagecoll.images.back().metadata["SeriesInstanceUID"] = SeriesInstanceUID;
-        out->imagecoll.images.back().metadata["SOPInstanceUID"] = SOPInstanceUID;
-
-        out->imagecoll.images.back().metadata["Rows"] = std::to_string(Rows);
-        out->imagecoll.images.back().metadata["Columns"] = std::to_string(Columns);
-        out->imagecoll.images.back().metadata["SliceThickness"] = std::to_string(SliceThickness);
-        out->imagecoll.images.back().metadata["SliceNumber"] = std::to_string(SliceNumber);
-        out->imagecoll.images.back().metadata["SliceLocation"] = std::to_string(SliceLocation);
-        out->imagecoll.images.back().metadata["ImageIndex"] = std::to_string(ImageIndex);
-        out->imagecoll.images.back().metadata["SpacingBetweenSlices"] = std::to_string(SpacingBetweenSlices);
-        out->imagecoll.images.back().metadata["ImagePositionPatient"] = std::to_string(ImagePosition.x) + "\\"
-                                                                      + std::to_string(ImagePosition.y) + "\\"
-                                                                      + std::to_string(ImagePosition.z);
-        out->imagecoll.images.back().metadata["ImageOrientationPatient"] = std::to_string(ImageOrientationRow.x) + "\\"
-                                                                         + std::to_string(ImageOrientationRow.y) + "\\"
-                                                                         + std::to_string(ImageOrientationRow.z) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.x) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.y) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.z);
-        out->imagecoll.images.back().metadata["PixelSpacing"] = std::to_string(ImagePixeldx) + "\\" + std::to_string(ImagePixeldy);
-        out->imagecoll.images.back().metadata["FrameOfReferenceUID"] = FrameOfReferenceUID;
-
-        out->imagecoll.images.back().metadata["StudyTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["SeriesTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["AcquisitionTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["ContentTime"] = ContentTime;
-
-        out->imagecoll.images.back().metadata["StudyDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["SeriesDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["AcquisitionDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["ContentDate"] = ContentDate;
-
-        out->imagecoll.images.back().metadata["Modality"] = Modality;
-
-        // ---
-
-        out->imagecoll.images.back().init_orientation(ImageOrientationRow,ImageOrientationColumn);
-        out->imagecoll.images.back().init_buffer(Rows, Columns, Channels);
-        out->imagecoll.images.back().init_spatial(ImagePixeldx,ImagePixeldy,ImageThickness, ImageAnchor, ImagePosition);
-
+    synthetic_image_series series;
+    series.images = 1;
+    series.rows = Rows;
+    series.columns = Columns;
+    series.channels = Channels;
+    series.pxl_dx = ImagePixeldx;
+    series.pxl_dy = ImagePixeldy;
+    series.pxl_dz = ImageThickness;
+    series.anchor = ImageAnchor;
+    series.position = ImagePosition;
+    series.row_unit = ImageOrientationRow;
+    series.col_unit = ImageOrientationColumn;
+
+    series.metadata["Filename"] = OriginFilename;
+
+    series.metadata["PatientID"] = PatientID;
+    series.metadata["StudyInstanceUID"] = StudyInstanceUID;
+    series.metadata["SeriesInstanceUID"] = SeriesInstanceUID;
+
+    series.metadata["SliceNumber"] = std::to_string(SliceNumber);
+    series.metadata["SliceLocation"] = std::to_string(SliceLocation);
+    series.metadata["ImageIndex"] = std::to_string(ImageIndex);
+    series.metadata["SpacingBetweenSlices"] = std::to_string(SpacingBetweenSlices);
+    series.metadata["FrameOfReferenceUID"] = FrameOfReferenceUID;
+
+    series.metadata["StudyTime"] = ContentTime;
+    series.metadata["SeriesTime"] = ContentTime;
+    series.metadata["AcquisitionTime"] = ContentTime;
+    series.metadata["ContentTime"] = ContentTime;
+
+    series.metadata["StudyDate"] = ContentDate;
+    series.metadata["SeriesDate"] = ContentDate;
+    series.metadata["AcquisitionDate"] = ContentDate;
+    series.metadata["ContentDate"] = ContentDate;
+
+    series.metadata["Modality"] = Modality;
+
+    series.fill = [&](long int, planar_image<float,double> &img) -> void {
         for(long int row = 0; row < Rows; ++row){
             for(long int col = 0; col < Columns; ++col){
                 for(long int chnl = 0; chnl < Channels; ++chnl){
                     auto OutgoingPixelValue = static_cast<float>(col + row * Columns + chnl * Columns * Rows); 
                     OutgoingPixelValue *= Dmax / (Rows*Columns*Channels - 1); // Rescale to [0,Dmax].
-                    out->imagecoll.images.back().reference(row,col,chnl) = OutgoingPixelValue;
+                    img.reference(row,col,chnl) = OutgoingPixelValue;
                 } //Loop over channels.
             } //Loop over columns.
         } //Loop over rows.
+    };
 
-        loaded_imgs_storage.back().push_back( std::move( out ) );
-    }
-
-
-    //Collate each group of images into a single set, if possible. Also stuff the correct contour data in the same set.
-    for(auto &loaded_img_set : loaded_imgs_storage){
-        if(loaded_img_set.empty()) continue;
-
-        auto collated_imgs = Collate_Image_Arrays(loaded_img_set);
-        if(!collated_imgs){
-            throw std::runtime_error("Unable to collate images. Virtual data should never cause this error.");
-        }
-
-        DICOM_data.image_data.emplace_back(std::move(collated_imgs));
-    }
+    DICOM_data.image_data.emplace_back( Generate_Synthetic_Images(series) );
 
 
     //Create contours.
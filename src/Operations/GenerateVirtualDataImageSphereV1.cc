@@ -9,9 +9,10 @@
 #include <string>    
 
 #include "../Imebra_Shim.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "Explicator.h"       //Needed for Explicator class.
+#include "../Synthetic_Images.h"
 #include "GenerateVirtualDataImageSphereV1.h"
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -33,11 +34,7 @@ Drover GenerateVirtualDataImageSphereV1(Drover DICOM_data,
                                         const std::map<std::string, std::string>&,
                                         const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
-
-    using loaded_imgs_storage_t = decltype(DICOM_data.image_data);
-    std::list<loaded_imgs_storage_t> loaded_imgs_storage;
-    //std::shared_ptr<Contour_Data> loaded_contour_data_storage = std::make_shared<Contour_Data>();
+    const lexicon_translator X(FilenameLex);
 
     // The test images are divided into sections.
     const long int Images   = 100;
@@ -47,7 +44,7 @@ Drover GenerateVirtualDataImageSphereV1(Drover DICOM_data,
 
     const double SpacingBetweenSlices = 1.0;
     const vec3<double> ImageAnchor(0.0, 0.0, 0.0);
-    vec3<double> ImagePosition(100.0,100.0,100.0);
+    const vec3<double> ImagePosition(100.0,100.0,100.0);
     const vec3<double> ImageOrientationColumn = vec3<double>(1.0,0.0,0.0).unit();
     const vec3<double> ImageOrientationRow    = vec3<double>(0.0,1.0,0.0).unit();
     const vec3<double> ImageOrientationOrtho  = ImageOrientationColumn.Cross( ImageOrientationRow ).unit();
@@ -58,7 +55,6 @@ Drover GenerateVirtualDataImageSphereV1(Drover DICOM_data,
     const vec3<double> SphereCentre(150.0, 150.0, 150.0);
     const double SphereRadius = 25.0;
 
-    long int InstanceNumber = 1; //Gets bumped for each image.
     const long int AcquisitionNumber = 1;
 
     // Temporal metadata.
@@ -76,83 +72,55 @@ Drover GenerateVirtualDataImageSphereV1(Drover DICOM_data,
     const std::string Modality = "CT";
 
     // --- The virtual 'signal' image series ---
-    loaded_imgs_storage.emplace_back();
-    for(long int img_index = 0; img_index < Images; ++img_index){
-        const std::string SOPInstanceUID = Generate_Random_UID(60);
-
-        auto out = std::make_unique<Image_Array>();
-        out->imagecoll.images.emplace_back();
-
-        out->imagecoll.images.back().metadata["Filename"] = OriginFilename;
-
-        out->imagecoll.images.back().metadata["PatientID"] = PatientID;
-        out->imagecoll.images.back().metadata["StudyInstanceUID"] = StudyInstanceUID;
-        out->imagecoll.images.back().metadata["SeriesInstanceUID"] = SeriesInstanceUID;
-        out->imagecoll.images.back().metadata["SOPInstanceUID"] = SOPInstanceUID;
-
-        out->imagecoll.images.back().metadata["Rows"] = std::to_string(Rows);
-        out->imagecoll.images.back().metadata["Columns"] = std::to_string(Columns);
-        out->imagecoll.images.back().metadata["SliceThickness"] = std::to_string(SliceThickness);
-        out->imagecoll.images.back().metadata["SpacingBetweenSlices"] = std::to_string(SpacingBetweenSlices);
-        out->imagecoll.images.back().metadata["ImagePositionPatient"] = std::to_string(ImagePosition.x) + "\\"
-                                                                      + std::to_string(ImagePosition.y) + "\\"
-                                                                      + std::to_string(ImagePosition.z);
-        out->imagecoll.images.back().metadata["ImageOrientationPatient"] = std::to_string(ImageOrientationRow.x) + "\\"
-                                                                         + std::to_string(ImageOrientationRow.y) + "\\"
-                                                                         + std::to_string(ImageOrientationRow.z) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.x) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.y) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.z);
-        out->imagecoll.images.back().metadata["PixelSpacing"] = std::to_string(ImagePixeldx) + "\\" + std::to_string(ImagePixeldy);
-        out->imagecoll.images.back().metadata["FrameOfReferenceUID"] = FrameOfReferenceUID;
-
-        out->imagecoll.images.back().metadata["StudyTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["SeriesTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["AcquisitionTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["ContentTime"] = ContentTime;
-
-        out->imagecoll.images.back().metadata["StudyDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["SeriesDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["AcquisitionDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["ContentDate"] = ContentDate;
-
-        out->imagecoll.images.back().metadata["Modality"] = Modality;
-
-        // ---
-
-        out->imagecoll.images.back().init_orientation(ImageOrientationRow, ImageOrientationColumn);
-        out->imagecoll.images.back().init_buffer(Rows, Columns, Channels);
-        out->imagecoll.images.back().init_spatial(ImagePixeldx, ImagePixeldy, SliceThickness, ImageAnchor, ImagePosition);
-
+    synthetic_image_series series;
+    series.images = Images;
+    series.rows = Rows;
+    series.columns = Columns;
+    series.channels = Channels;
+    series.pxl_dx = ImagePixeldx;
+    series.pxl_dy = ImagePixeldy;
+    series.pxl_dz = SliceThickness;
+    series.anchor = ImageAnchor;
+    series.position = ImagePosition;
+    series.step = ImageOrientationOrtho * SpacingBetweenSlices;
+    series.row_unit = ImageOrientationRow;
+    series.col_unit = ImageOrientationColumn;
+
+    series.metadata["Filename"] = OriginFilename;
+
+    series.metadata["PatientID"] = PatientID;
+    series.metadata["StudyInstanceUID"] = StudyInstanceUID;
+    series.metadata["SeriesInstanceUID"] = SeriesInstanceUID;
+
+    series.metadata["SpacingBetweenSlices"] = std::to_string(SpacingBetweenSlices);
+    series.metadata["FrameOfReferenceUID"] = FrameOfReferenceUID;
+
+    series.metadata["StudyTime"] = ContentTime;
+    series.metadata["SeriesTime"] = ContentTime;
+    series.metadata["AcquisitionTime"] = ContentTime;
+    series.metadata["ContentTime"] = ContentTime;
+
+    series.metadata["StudyDate"] = ContentDate;
+    series.metadata["SeriesDate"] = ContentDate;
+    series.metadata["AcquisitionDate"] = ContentDate;
+    series.metadata["ContentDate"] = ContentDate;
+
+    series.metadata["Modality"] = Modality;
+
+    series.fill = [&](long int, planar_image<float,double> &img) -> void {
         for(long int row = 0; row < Rows; ++row){
             for(long int col = 0; col < Columns; ++col){
-                const auto R = out->imagecoll.images.back().position(row,col);
+                const auto R = img.position(row,col);
                 const auto dist = R.distance(SphereCentre);
                 for(long int chnl = 0; chnl < Channels; ++chnl){
                     const auto val = (dist < SphereRadius) ? 1.0 : 0.0;
-                    out->imagecoll.images.back().reference(row,col,chnl) = val;
+                    img.reference(row,col,chnl) = val;
                 } //Loop over channels.
             } //Loop over columns.
         } //Loop over rows.
+    };
 
-        ImagePosition += ImageOrientationOrtho * SpacingBetweenSlices;
-        ++InstanceNumber;
-
-        loaded_imgs_storage.back().push_back( std::move( out ) );
-    }
-
-
-    //Collate each group of images into a single set, if possible. Also stuff the correct contour data in the same set.
-    for(auto &loaded_img_set : loaded_imgs_storage){
-        if(loaded_img_set.empty()) continue;
-
-        auto collated_imgs = Collate_Image_Arrays(loaded_img_set);
-        if(!collated_imgs){
-            throw std::runtime_error("Unable to collate images. Virtual data should never cause this error.");
-        }
-
-        DICOM_data.image_data.emplace_back(std::move(collated_imgs));
-    }
+    DICOM_data.image_data.emplace_back( Generate_Synthetic_Images(series) );
 
     //Create an empty contour set.
     DICOM_data.Ensure_Contour_Data_Allocated();
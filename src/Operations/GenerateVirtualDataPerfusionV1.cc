@@ -15,11 +15,11 @@
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
-#include "Explicator.h"
-
 #include "../Imebra_Shim.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Synthetic_Images.h"
 #include "GenerateVirtualDataPerfusionV1.h"
 
 OperationDoc OpArgDocGenerateVirtualDataPerfusionV1(){
@@ -39,12 +39,7 @@ Drover GenerateVirtualDataPerfusionV1(Drover DICOM_data,
                                       const std::map<std::string, std::string>&,
                                       const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
-
-    using loaded_imgs_storage_t = decltype(DICOM_data.image_data);
-    std::list<loaded_imgs_storage_t> loaded_imgs_storage;
-    std::shared_ptr<Contour_Data> loaded_contour_data_storage = std::make_shared<Contour_Data>();
-
+    const lexicon_translator X(FilenameLex);
 
     // The test images are divided into sections. Some sections are for testing purposes, and others provide fake data
     // for the perfusion models (i.e., AIF and VIF).
@@ -52,7 +47,6 @@ Drover GenerateVirtualDataPerfusionV1(Drover DICOM_data,
     long int Columns = 20;
     long int Channels = 1;
 
-    const double SliceThickness = 1.0;
     const double SliceLocation  = 1.0;
     const double SpacingBetweenSlices = 1.0;
     const vec3<double> ImageAnchor(0.0, 0.0, 0.0);
@@ -63,9 +57,7 @@ Drover GenerateVirtualDataPerfusionV1(Drover DICOM_data,
     const double ImagePixeldx = 1.0; //Spacing between adjacent columns.
     const double ImageThickness = 1.0;
 
-    long int InstanceNumber = 1; //Gets bumped for each image.
-    long int SliceNumber    = 1; //Gets bumped at each temporal bump.
-    long int ImageIndex     = 1; //For PET series. Not sure when to bump...
+    const long int ImageIndex = 1; //For PET series.
     const long int AcquisitionNumber = 1;
 
     // Temporal metadata.
@@ -89,61 +81,51 @@ Drover GenerateVirtualDataPerfusionV1(Drover DICOM_data,
 
 
     // --- The virtual 'signal' image series ---
-    loaded_imgs_storage.emplace_back();
-    SliceNumber = 1;
-    for(long int time_index = 0; time_index < NumberOfTemporalPositions; ++time_index, ++SliceNumber){
+    //
+    // All images share the same position; they differ only temporally.
+    synthetic_image_series series;
+    series.images = NumberOfTemporalPositions;
+    series.rows = Rows;
+    series.columns = Columns;
+    series.channels = Channels;
+    series.pxl_dx = ImagePixeldx;
+    series.pxl_dy = ImagePixeldy;
+    series.pxl_dz = ImageThickness;
+    series.anchor = ImageAnchor;
+    series.position = ImagePosition;
+    series.step = vec3<double>(0.0, 0.0, 0.0);
+    series.row_unit = ImageOrientationRow;
+    series.col_unit = ImageOrientationColumn;
+
+    series.metadata["Filename"] = OriginFilename;
+
+    series.metadata["PatientID"] = PatientID;
+    series.metadata["StudyInstanceUID"] = StudyInstanceUID;
+    series.metadata["SeriesInstanceUID"] = SeriesInstanceUID;
+
+    series.metadata["SliceLocation"] = std::to_string(SliceLocation);
+    series.metadata["ImageIndex"] = std::to_string(ImageIndex);
+    series.metadata["SpacingBetweenSlices"] = std::to_string(SpacingBetweenSlices);
+    series.metadata["FrameOfReferenceUID"] = FrameOfReferenceUID;
+
+    series.metadata["StudyTime"] = ContentTime;
+    series.metadata["SeriesTime"] = ContentTime;
+    series.metadata["AcquisitionTime"] = ContentTime;
+    series.metadata["ContentTime"] = ContentTime;
+
+    series.metadata["StudyDate"] = ContentDate;
+    series.metadata["SeriesDate"] = ContentDate;
+    series.metadata["AcquisitionDate"] = ContentDate;
+    series.metadata["ContentDate"] = ContentDate;
+
+    series.metadata["Modality"] = Modality;
+
+    series.fill = [&](long int time_index, planar_image<float,double> &img) -> void {
         const double t = dt * time_index;
-        long int FrameReferenceTime = t * 1000.0;
-
-        const std::string SOPInstanceUID = Generate_Random_UID(60);
-
-        auto out = std::make_unique<Image_Array>();
-        out->imagecoll.images.emplace_back();
-
-        out->imagecoll.images.back().metadata["Filename"] = OriginFilename;
-
-        out->imagecoll.images.back().metadata["PatientID"] = PatientID;
-        out->imagecoll.images.back().metadata["StudyInstanceUID"] = StudyInstanceUID;
-        out->imagecoll.images.back().metadata["SeriesInstanceUID"] = SeriesInstanceUID;
-        out->imagecoll.images.back().metadata["SOPInstanceUID"] = SOPInstanceUID;
-
-        out->imagecoll.images.back().metadata["dt"] = std::to_string(t);
-        out->imagecoll.images.back().metadata["Rows"] = std::to_string(Rows);
-        out->imagecoll.images.back().metadata["Columns"] = std::to_string(Columns);
-        out->imagecoll.images.back().metadata["SliceThickness"] = std::to_string(SliceThickness);
-        out->imagecoll.images.back().metadata["SliceNumber"] = std::to_string(SliceNumber);
-        out->imagecoll.images.back().metadata["SliceLocation"] = std::to_string(SliceLocation);
-        out->imagecoll.images.back().metadata["ImageIndex"] = std::to_string(ImageIndex);
-        out->imagecoll.images.back().metadata["SpacingBetweenSlices"] = std::to_string(SpacingBetweenSlices);
-        out->imagecoll.images.back().metadata["ImagePositionPatient"] = std::to_string(ImagePosition.x) + "\\"
-                                                                      + std::to_string(ImagePosition.y) + "\\"
-                                                                      + std::to_string(ImagePosition.z);
-        out->imagecoll.images.back().metadata["ImageOrientationPatient"] = std::to_string(ImageOrientationRow.x) + "\\"
-                                                                         + std::to_string(ImageOrientationRow.y) + "\\"
-                                                                         + std::to_string(ImageOrientationRow.z) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.x) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.y) + "\\"
-                                                                         + std::to_string(ImageOrientationColumn.z);
-        out->imagecoll.images.back().metadata["PixelSpacing"] = std::to_string(ImagePixeldx) + "\\" + std::to_string(ImagePixeldy);
-        out->imagecoll.images.back().metadata["FrameOfReferenceUID"] = FrameOfReferenceUID;
-
-        out->imagecoll.images.back().metadata["StudyTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["SeriesTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["AcquisitionTime"] = ContentTime;
-        out->imagecoll.images.back().metadata["ContentTime"] = ContentTime;
-
-        out->imagecoll.images.back().metadata["StudyDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["SeriesDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["AcquisitionDate"] = ContentDate;
-        out->imagecoll.images.back().metadata["ContentDate"] = ContentDate;
-
-        out->imagecoll.images.back().metadata["Modality"] = Modality;
-
-        // ---
-
-        out->imagecoll.images.back().init_orientation(ImageOrientationRow,ImageOrientationColumn);
-        out->imagecoll.images.back().init_buffer(Rows, Columns, Channels);
-        out->imagecoll.images.back().init_spatial(ImagePixeldx,ImagePixeldy,ImageThickness, ImageAnchor, ImagePosition);
+        const long int SliceNumber = time_index + 1;
+
+        img.metadata["dt"] = std::to_string(t);
+        img.metadata["SliceNumber"] = std::to_string(SliceNumber);
 
         for(long int row = 0; row < Rows; ++row){
             for(long int col = 0; col < Columns; ++col){
@@ -191,26 +173,13 @@ Drover GenerateVirtualDataPerfusionV1(Drover DICOM_data,
                         throw std::runtime_error("Image dimensions have been changed without changing the pixel definitions.");
                     }
 
-                    out->imagecoll.images.back().reference(row,col,chnl) = OutgoingPixelValue;
+                    img.reference(row,col,chnl) = OutgoingPixelValue;
                 } //Loop over channels.
             } //Loop over columns.
         } //Loop over rows.
+    };
 
-        loaded_imgs_storage.back().push_back( std::move( out ) );
-    }
-
-
-    //Collate each group of images into a single set, if possible. Also stuff the correct contour data in the same set.
-    for(auto &loaded_img_set : loaded_imgs_storage){
-        if(loaded_img_set.empty()) continue;
-
-        auto collated_imgs = Collate_Image_Arrays(loaded_img_set);
-        if(!collated_imgs){
-            throw std::runtime_error("Unable to collate images. Virtual data should never cause this error.");
-        }
-
-        DICOM_data.image_data.emplace_back(std::move(collated_imgs));
-    }
+    DICOM_data.image_data.emplace_back( Generate_Synthetic_Images(series) );
 
 
     //Create contours.
@@ -9,6 +9,7 @@
 
 #include "../Structs.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/CT_Reasonable_HU_Window.h"
 #include "GiveWholeImageArrayAHeadAndNeckWindowLevel.h"
 #include "YgorImages.h"
@@ -31,9 +32,9 @@ Drover GiveWholeImageArrayAHeadAndNeckWindowLevel(Drover DICOM_data,
                                                   const std::map<std::string, std::string>& /*InvocationMetadata*/,
                                                   const std::string& /*FilenameLex*/){
     for(auto & img_arr : DICOM_data.image_data){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               StandardHeadAndNeckHUWindow,
-                                               {}, {})){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     StandardHeadAndNeckHUWindow,
+                                     {}, {})){
             FUNCERR("Unable to force window to cover a reasonable head-and-neck HU range");
         }
     }
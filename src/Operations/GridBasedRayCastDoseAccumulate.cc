@@ -11,19 +11,23 @@
 #include <list>
 #include <map>
 #include <memory>
-#include <mutex>
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <utility>
+#include <vector>
 
 #include "../Dose_Meld.h"
+#include "../Image_Slice_Index.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../Tracing.h"
 #include "../YgorImages_Functors/Compute/GenerateSurfaceMask.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Bicubic_Supersample.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "GridBasedRayCastDoseAccumulate.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
@@ -194,10 +198,10 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
     const auto refregex = Compile_Regex(ReferenceROILabelRegex);
     const auto refnormalizedregex = Compile_Regex(NormalizedReferenceROILabelRegex);
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //Merge the dose arrays if multiple are available.
-    DICOM_data = Meld_Only_Dose_Data(DICOM_data);
+    DICOM_data = Meld_Only_Dose_Data(std::move(DICOM_data));
 
     //Gather only dose images.
     auto IAs_all = All_IAs( DICOM_data );
@@ -352,9 +356,9 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
         bicub_ud.RowScaleFactor    = 3;
         bicub_ud.ColumnScaleFactor = 3;
 
-        if(!grid_arr_ptr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                             InImagePlaneBicubicSupersample,
-                                                             {}, {}, &bicub_ud )){
+        if(!Process_Images_Balanced( grid_arr_ptr->imagecoll,
+                                     InImagePlaneBicubicSupersample,
+                                     {}, {}, &bicub_ud )){
             FUNCERR("Unable to bicubically supersample surface mask");
         }
     }
@@ -449,16 +453,57 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
 
     //Now ready to ray cast. Loop over integer pixel coordinates. Start and finish are image pixels.
     // The top image can be the length image.
+    //
+    // Rays are processed in square tiles of neighbouring pixels, which traverse nearby voxels and so share cached
+    // image data. Each tile accumulates into its own buffers, which are reduced into the images after all tiles
+    // complete. Workers therefore never contend for shared accumulators or for the console.
     {
-        asio_thread_pool tp;
-        std::mutex printer; // Who gets to print to the console and iterate the counter.
-        long int completed = 0;
+        // Indices for quickly locating the images encompassing each sample point.
+        const auto grid_index = grid_arr_ptr->get_slice_index();
+        const auto img_index = img_arr_ptr->get_slice_index();
 
         const double cleaved_gap_dist = std::abs(ROICleaving.Get_Signed_Distance_To_Point(ROI_centroid));
 
-        for(long int row = 0; row < SourceDetectorRows; ++row){
-            tp.submit_task([&,row]() -> void {
-                for(long int col = 0; col < SourceDetectorColumns; ++col){
+        struct tile_t {
+            long int row_begin = 0;
+            long int row_end = 0;
+            long int col_begin = 0;
+            long int col_end = 0;
+            std::vector<double> length;      //Length of ray travel within the 'surface'.
+            std::vector<double> doselength;
+        };
+        const long int tile_size = 16;
+        std::vector<tile_t> tiles;
+        for(long int r = 0; r < SourceDetectorRows; r += tile_size){
+            for(long int c = 0; c < SourceDetectorColumns; c += tile_size){
+                tiles.emplace_back();
+                tiles.back().row_begin = r;
+                tiles.back().row_end = std::min(SourceDetectorRows, r + tile_size);
+                tiles.back().col_begin = c;
+                tiles.back().col_end = std::min(SourceDetectorColumns, c + tile_size);
+            }
+        }
+
+        progress_tracker progress("GridBasedRayCastDoseAccumulate", SourceDetectorRows * SourceDetectorColumns,
+                                  [](long int completed, long int total, double eta_s) -> void {
+            FUNCINFO("Completed " << completed << " of " << total << " rays"
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done"
+                  << ", ~" << static_cast<long int>(eta_s) << " s remaining");
+        });
+
+        parallel_for(0, static_cast<long int>(tiles.size()), [&](long int i) -> void {
+            DCMA_TRACE_ZONE("ray caster", "dose accumulation tile");
+            auto &tile = tiles[i];
+            const long int tile_cols = tile.col_end - tile.col_begin;
+            const long int N_rays = (tile.row_end - tile.row_begin) * tile_cols;
+            tile.length.assign(N_rays, 0.0);
+            tile.doselength.assign(N_rays, 0.0);
+
+            // Consecutive samples usually fall within the same grid image, so check it before consulting the index.
+            const planar_image<float,double> *last_grid_img = nullptr;
+
+            for(long int row = tile.row_begin; row < tile.row_end; ++row){
+                for(long int col = tile.col_begin; col < tile.col_end; ++col){
                     double accumulated_length = 0.0;      //Length of ray travel within the 'surface'.
                     double accumulated_doselength = 0.0;
                     vec3<double> ray_pos = SourceImg->position(row, col);
@@ -475,15 +520,19 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
                         const auto midpoint = ray_pos - (ray_dir * RaydL * 0.5);
 
                         //Check if it was in the surface at the midpoint.
-                        auto rel_img = grid_arr_ptr->imagecoll.get_images_which_encompass_point(midpoint);
-                        if(rel_img.empty()) continue;
-                        const auto mask_val = rel_img.front()->value(midpoint, 0);
+                        if( (last_grid_img == nullptr)
+                        ||  !last_grid_img->encompasses_point(midpoint) ){
+                            auto rel_img = grid_index->get_images_which_encompass_point(midpoint);
+                            last_grid_img = rel_img.empty() ? nullptr : rel_img.front();
+                        }
+                        if(last_grid_img == nullptr) continue;
+                        const auto mask_val = last_grid_img->value(midpoint, 0);
                         const auto is_in_surface = (mask_val == surface_mask_val);
                         if(is_in_surface){
                             accumulated_length += RaydL;
 
                             //Find the dose at the half-way point.
-                            auto encompass_imgs = img_arr_ptr->imagecoll.get_images_which_encompass_point( midpoint );
+                            auto encompass_imgs = img_index->get_images_which_encompass_point( midpoint );
                             for(const auto &enc_img : encompass_imgs){
                                 const auto pix_val = enc_img->value(midpoint, 0);
                                 accumulated_doselength += RaydL * pix_val;
@@ -491,7 +540,23 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
                         }
                     }
 
-                    //Deposit the dose in the images.
+                    const long int j = (row - tile.row_begin) * tile_cols + (col - tile.col_begin);
+                    tile.length[j] = accumulated_length;
+                    tile.doselength[j] = accumulated_doselength;
+                }
+                progress.advance(tile_cols);
+            }
+        }, /*grain=*/ 1);
+
+        //Deposit the dose in the images.
+        for(const auto &tile : tiles){
+            const long int tile_cols = tile.col_end - tile.col_begin;
+            for(long int row = tile.row_begin; row < tile.row_end; ++row){
+                for(long int col = tile.col_begin; col < tile.col_end; ++col){
+                    const long int j = (row - tile.row_begin) * tile_cols + (col - tile.col_begin);
+                    const auto accumulated_length = tile.length[j];
+                    const auto accumulated_doselength = tile.doselength[j];
+
                     SourceImg->reference(row, col, 0) = static_cast<float>(accumulated_length);
                     DetectImg->reference(row, col, 0) = static_cast<float>(accumulated_doselength);
                     DoseImg->reference(row, col, 0) = 0.0f;
@@ -500,16 +565,9 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
                                                           / static_cast<float>(accumulated_length);
                     }
                 }
-
-                {
-                    std::lock_guard<std::mutex> lock(printer);
-                    ++completed;
-                    FUNCINFO("Completed " << completed << " of " << SourceDetectorRows 
-                          << " --> " << static_cast<int>(1000.0*(completed)/SourceDetectorRows)/10.0 << "% done");
-                }
-            });
+            }
         }
-    } // Complete tasks and terminate thread pool.
+    }
 
     // Save image maps to file.
     if(LengthMapFileName.empty()){
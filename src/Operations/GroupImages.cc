@@ -16,6 +16,7 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 
 #include "GroupImages.h"
@@ -135,35 +136,35 @@ Drover GroupImages(Drover DICOM_data,
         auto IAs_all = All_IAs( DICOM_data );
         auto IAs = Whitelist( IAs_all, ImageSelectionStr );
         for(auto & iap_it : IAs){
-            while(!(*iap_it)->imagecoll.images.empty()){
-                auto img_it = (*iap_it)->imagecoll.images.begin();
-
-                //Retrieve the selected metadata.
+            auto &images = (*iap_it)->imagecoll.images;
+            std::vector<std::list<planar_image<float,double>>::iterator> img_its;
+            for(auto it = std::begin(images); it != std::end(images); ++it) img_its.push_back(it);
+            const auto N = static_cast<long int>(img_its.size());
+
+            // Retrieve the selected metadata once per image. Images missing one or more keys get no key.
+            std::vector<std::optional<std::vector<std::string>>> keys(N);
+            parallel_for(0, N, [&](long int i){
                 std::vector<std::string> img_m;
                 for(auto &akey : KeysCommon){
-                    auto v = img_it->GetMetadataValueAs<std::string>(akey);
-                    if(!v) break;
+                    auto v = img_its[i]->GetMetadataValueAs<std::string>(akey);
+                    if(!v) return;
                     img_m.push_back(v.value());
                 }
+                keys[i] = std::move(img_m);
+            });
 
+            for(long int i = 0; i < N; ++i){
                 // If one or more metadata are missing, the image gets moved to the special NA group.
-                if(img_m.size() != KeysCommon.size()){
+                if(!keys[i]){
                     if(na_group == nullptr) na_group = std::make_shared<Image_Array>();
-                    na_group->imagecoll.images.splice( na_group->imagecoll.images.end(),
-                                                       (*iap_it)->imagecoll.images,
-                                                       img_it );
+                    na_group->imagecoll.images.splice( na_group->imagecoll.images.end(), images, img_its[i] );
 
                 // Otherwise, if all metadata were present move the image to the corresponding group.
                 }else{
-                    auto ia = new_group[img_m];
+                    auto &ia = new_group.try_emplace( std::move(keys[i].value()) ).first->second;
                     if(ia == nullptr) ia = std::make_shared<Image_Array>();
-
-                    ia->imagecoll.images.splice( ia->imagecoll.images.end(),
-                                                 (*iap_it)->imagecoll.images,
-                                                 img_it );
-                    new_group[img_m] = ia;
+                    ia->imagecoll.images.splice( ia->imagecoll.images.end(), images, img_its[i] );
                 }
-
             }
         }
 
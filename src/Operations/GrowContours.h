@@ -10,7 +10,7 @@
 
 OperationDoc OpArgDocGrowContours();
 
-Drover GrowContours(const Drover& DICOM_data,
+Drover GrowContours(Drover DICOM_data,
                     const OperationArgPkg& /*OptArgs*/,
                     const std::map<std::string, std::string>& /*InvocationMetadata*/,
                     const std::string& /*FilenameLex*/);
@@ -14,6 +14,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
 #include "HighlightROIs.h"
 #include "YgorImages.h"
@@ -212,9 +213,9 @@ Drover HighlightROIs(Drover DICOM_data,
         ud.f_visitor = f_noop;
 
 
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     PartitionedImageVoxelVisitorMutator,
+                                     {}, cc_ROIs, &ud )){
             throw std::runtime_error("Unable to highlight voxels within the specified ROI(s).");
         }
     }
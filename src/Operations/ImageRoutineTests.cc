@@ -11,6 +11,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/ImagePartialDerivative.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Bicubic_Supersample.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Bilinear_Supersample.h"
@@ -46,9 +47,9 @@ Drover ImageRoutineTests(Drover DICOM_data,
         DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>( *img_arr ) );
         bilin_resampled_img_arrays.emplace_back( DICOM_data.image_data.back() );
 
-        if(!bilin_resampled_img_arrays.back()->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                                         InImagePlaneBilinearSupersample,
-                                                                         {}, {}, &bilin_ud )){
+        if(!Process_Images_Balanced( bilin_resampled_img_arrays.back()->imagecoll,
+                                     InImagePlaneBilinearSupersample,
+                                     {}, {}, &bilin_ud )){
             FUNCERR("Unable to bilinearly supersample images");
         }
     }
@@ -61,9 +62,9 @@ Drover ImageRoutineTests(Drover DICOM_data,
         DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>( *img_arr ) );
         bicub_resampled_img_arrays.emplace_back( DICOM_data.image_data.back() );
 
-        if(!bicub_resampled_img_arrays.back()->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                                         InImagePlaneBicubicSupersample,
-                                                                         {}, {}, &bicub_ud )){
+        if(!Process_Images_Balanced( bicub_resampled_img_arrays.back()->imagecoll,
+                                     InImagePlaneBicubicSupersample,
+                                     {}, {}, &bicub_ud )){
             FUNCERR("Unable to bicubically supersample images");
         }
     }
@@ -79,9 +80,9 @@ Drover ImageRoutineTests(Drover DICOM_data,
         DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>( *img_arr ) );
         cross_second_deriv_img_arrays.emplace_back( DICOM_data.image_data.back() );
 
-        if(!cross_second_deriv_img_arrays.back()->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                                            ImagePartialDerivative,
-                                                                            {}, {}, &csd_ud )){
+        if(!Process_Images_Balanced( cross_second_deriv_img_arrays.back()->imagecoll,
+                                     ImagePartialDerivative,
+                                     {}, {}, &csd_ud )){
             FUNCERR("Unable to compute 'cross' second-order partial derivative");
         }
     }
@@ -16,16 +16,17 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../YgorImages_Functors/Analytic_Rasterization.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 
 #include "ImprintImages.h"
@@ -39,6 +40,11 @@ OperationDoc OpArgDocImprintImages(){
     out.desc = 
         "This operation creates imprints of point clouds on the selected images."
         " Images are modified where the points are coindicident.";
+
+    out.notes.emplace_back(
+        "Images are imprinted concurrently. Points are sorted along the image normal so that each image only"
+        " considers the points within its own slab."
+    );
         
     
     out.args.emplace_back();
@@ -77,7 +83,7 @@ Drover ImprintImages(Drover DICOM_data,
                      /*InvocationMetadata*/,
                      const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
@@ -96,42 +102,37 @@ Drover ImprintImages(Drover DICOM_data,
 
     for(auto & pcp_it : PCs){
         for(auto & iap_it : IAs){
-            for(auto &img : (*iap_it)->imagecoll.images){
-
-                if(false){
+            if(false){
 /*
 
 // TODO : updated when attributes are supported.
 
-                // If there is a magnitude attribute, use it.
-                }else if( (*pcp_it)->attributes.count("magnitude") != 0 ){
-                    // Verify it is a simple scalar attribute.
-                    auto *magn = std::any_cast<std::vector<double>>( &((*pcp_it)->attributes["magnitude"]) );
-                    if( (magn == nullptr) 
-                    ||  (magn->size() != (*pcp_it)->points.size()) ){
-                        throw std::runtime_error("Point cloud magnitude present, but invalid. Refusing to continue.");
-                    }
+            // If there is a magnitude attribute, use it.
+            }else if( (*pcp_it)->attributes.count("magnitude") != 0 ){
+                // Verify it is a simple scalar attribute.
+                auto *magn = std::any_cast<std::vector<double>>( &((*pcp_it)->attributes["magnitude"]) );
+                if( (magn == nullptr) 
+                ||  (magn->size() != (*pcp_it)->points.size()) ){
+                    throw std::runtime_error("Point cloud magnitude present, but invalid. Refusing to continue.");
+                }
 
-                    // Imprint the images.
-                    auto m_it = std::begin(*magn);
-                    for(const auto &pp : (*pcp_it)->points){
-                        const auto P = pp.first;
-                        const auto index = img.index( P, Channel );
-                        if(0 <= index){
-                            img.reference(index) = *m_it;
-                        }
-                        ++m_it;
+                // Imprint the images.
+                auto m_it = std::begin(*magn);
+                for(const auto &pp : (*pcp_it)->points){
+                    const auto P = pp.first;
+                    const auto index = img.index( P, Channel );
+                    if(0 <= index){
+                        img.reference(index) = *m_it;
                     }
+                    ++m_it;
+                }
 
 
 */                
-                // If there is no magnitude attribute, simply use the user-provided VoxelValue.
-                }else{
-                    for(const auto &P : (*pcp_it)->pset.points){
-                        const auto index = img.index( P, Channel );
-                        if(0 <= index) img.reference(index) = VoxelValue;
-                    }
-                }
+            // If there is no magnitude attribute, simply use the user-provided VoxelValue.
+            }else{
+                Imprint_Points( (*iap_it)->imagecoll.images, (*pcp_it)->pset.points,
+                                Channel, static_cast<float>(VoxelValue) );
             }
         }
     }
@@ -41,6 +41,11 @@ OperationDoc OpArgDocInterpolateSlices(){
         " invalid and marked with NaNs. Non-rectilearity which amounts to a differing number of rows"
         " or columns will merely be slower to interpolate."
     );
+    out.notes.emplace_back(
+        "Images that share an orientation but otherwise differ (e.g., in voxel dimensions, extent, or offset, as"
+        " when regridding dose onto a CT) are interpolated in-plane with separable weights that are computed"
+        " once per row and column, which is nearly as fast as the rectilinear case."
+    );
 
 
     out.args.emplace_back();
@@ -1,6 +1,10 @@
 //IsolatedVoxelFilter.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
 #include <any>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <functional>
 #include <iterator>
@@ -10,12 +14,16 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <vector>
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
+#include "../Connected_Components.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
+#include "../YgorImages_Functors/ROI_Mask_Volume.h"
 #include "IsolatedVoxelFilter.h"
 #include "YgorImages.h"
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
@@ -38,6 +46,12 @@ OperationDoc OpArgDocIsolatedVoxelFilter(){
         "If the neighbourhood involves voxels that do not exist, they are treated as NaNs in the same"
         " way that voxels with the NaN value are treated."
     );
+    out.notes.emplace_back(
+        "The 'component' method labels connected components of agreeing voxels in a single linear-time pass, and"
+        " considers every voxel of a component with fewer than 'MinComponentSize' voxels to be isolated. Mean and"
+        " median replacements are then drawn from the voxels bordering the component, so small islands are"
+        " replaced wholesale rather than being averaged with themselves."
+    );
     
     out.args.emplace_back();
     out.args.back() = IAWhitelistOpArgDoc();
@@ -135,6 +149,44 @@ OperationDoc OpArgDocIsolatedVoxelFilter(){
                                  "2.0",
                                  "15.0" };
 
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "Controls how isolated voxels are identified."
+                           " 'Neighbourhood' counts the agreeing voxels surrounding each voxel."
+                           " 'Component' labels the connected components of agreeing voxels within the selected"
+                           " ROIs and treats components with fewer than 'MinComponentSize' voxels as isolated."
+                           " The 'component' method does not support the 'conservative' replacement strategy.";
+    out.args.back().default_val = "neighbourhood";
+    out.args.back().expected = true;
+    out.args.back().examples = { "neighbourhood",
+                                 "component" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+
+    out.args.emplace_back();
+    out.args.back().name = "Connectivity";
+    out.args.back().desc = "For the 'component' method, controls which adjacent voxels are connected."
+                           " 'Faces' connects the 6 voxels sharing a face, 'edges' connects the 18 voxels sharing"
+                           " a face or an edge, and 'vertices' connects all 26 surrounding voxels.";
+    out.args.back().default_val = "vertices";
+    out.args.back().expected = true;
+    out.args.back().examples = { "faces",
+                                 "edges",
+                                 "vertices" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+
+    out.args.emplace_back();
+    out.args.back().name = "MinComponentSize";
+    out.args.back().desc = "For the 'component' method, the number of voxels a component must contain to be"
+                           " considered 'well-connected.'";
+    out.args.back().default_val = "8";
+    out.args.back().expected = true;
+    out.args.back().examples = { "2",
+                                 "8",
+                                 "100" };
+
     return out;
 }
 
@@ -157,6 +209,10 @@ Drover IsolatedVoxelFilter(Drover DICOM_data,
 
     const auto MaxDistance = std::stod( OptArgs.getValueStr("MaxDistance").value() );
 
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
+    const auto ConnectivityStr = OptArgs.getValueStr("Connectivity").value();
+    const auto MinComponentSize = std::stol( OptArgs.getValueStr("MinComponentSize").value() );
+
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_mean = Compile_Regex("^mea?n?$");
     const auto regex_median = Compile_Regex("^medi?a?n?$");
@@ -216,6 +272,41 @@ Drover IsolatedVoxelFilter(Drover DICOM_data,
         throw std::invalid_argument("'Replace' parameter is invalid. Cannot continue.");
     }
 
+    const auto regex_neighbourhood = Compile_Regex("^ne?i?g?h?b?o?u?r?h?o?o?d?$");
+    const auto regex_component = Compile_Regex("^co?m?p?o?n?e?n?t?$");
+
+    bool method_is_component = false;
+    if( std::regex_match(MethodStr, regex_component) ){
+        method_is_component = true;
+    }else if( !std::regex_match(MethodStr, regex_neighbourhood) ){
+        throw std::invalid_argument("'Method' parameter is invalid. Cannot continue.");
+    }
+
+    const auto regex_faces = Compile_Regex("^fa?c?e?s?$");
+    const auto regex_edges = Compile_Regex("^ed?g?e?s?$");
+    const auto regex_vertices = Compile_Regex("^ve?r?t?i?c?e?s?$");
+
+    auto connectivity = ComponentConnectivity::Vertices;
+    if( std::regex_match(ConnectivityStr, regex_faces) ){
+        connectivity = ComponentConnectivity::Faces;
+    }else if( std::regex_match(ConnectivityStr, regex_edges) ){
+        connectivity = ComponentConnectivity::Edges;
+    }else if( !std::regex_match(ConnectivityStr, regex_vertices) ){
+        throw std::invalid_argument("'Connectivity' parameter is invalid. Cannot continue.");
+    }
+
+    if(method_is_component){
+        if(replacement_is_conserv){
+            throw std::invalid_argument("The 'component' method does not support conservative replacement.");
+        }
+        if(MinComponentSize < 0){
+            throw std::invalid_argument("'MinComponentSize' cannot be negative. Cannot continue.");
+        }
+        if(replace_is_well && !replacement_is_value){
+            throw std::invalid_argument("Well-connected voxels can only be replaced with a numeric value.");
+        }
+    }
+
     const auto machine_eps = std::sqrt( std::numeric_limits<float>::epsilon() );
 
 
@@ -233,6 +324,108 @@ Drover IsolatedVoxelFilter(Drover DICOM_data,
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
     for(auto & iap_it : IAs){
 
+        if(method_is_component){
+            Mutate_Voxels_Opts mutation_opts;
+            mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
+            mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+            auto vol = Rasterize_ROI_Mask_Volume((*iap_it)->imagecoll, cc_ROIs, mutation_opts);
+            const auto &grid = vol.grid;
+            const auto image_size = grid.rows * grid.columns;
+            const auto channels = vol.images.front().get().channels;
+
+            // The neighbours that could be connected to a voxel, used to find the voxels bordering each component.
+            const long int max_nonzero = (connectivity == ComponentConnectivity::Faces) ? 1
+                                       : (connectivity == ComponentConnectivity::Edges) ? 2 : 3;
+            std::vector<std::array<long int, 3>> neighbours;
+            for(long int di = -1; di <= 1; ++di){
+                for(long int dr = -1; dr <= 1; ++dr){
+                    for(long int dc = -1; dc <= 1; ++dc){
+                        const long int nonzero = (di != 0) + (dr != 0) + (dc != 0);
+                        if( (nonzero == 0) || (max_nonzero < nonzero) ) continue;
+                        if( (di != 0) && !std::isfinite(grid.image_spacing) ) continue;
+                        neighbours.push_back( { di, dr, dc } );
+                    }
+                }
+            }
+
+            std::vector<float> vals(static_cast<size_t>(grid.size()));
+            for(long int chan = 0; chan < channels; ++chan){
+                if( (0 <= Channel) && (chan != Channel) ) continue;
+
+                parallel_for(0, grid.images, [&](long int i){
+                    const auto &img = vol.images[i].get();
+                    for(long int row = 0; row < grid.rows; ++row){
+                        for(long int col = 0; col < grid.columns; ++col){
+                            vals[i * image_size + row * grid.columns + col] = img.value(row, col, chan);
+                        }
+                    }
+                }, 1);
+
+                const auto comps = Label_Connected_Components(vals, vol.mask, grid, connectivity, machine_eps);
+                const auto is_isolated = [&](int64_t l) -> bool {
+                    return (l != 0) && (comps.sizes[l] < MinComponentSize);
+                };
+
+                // Gather the distinct voxels bordering each isolated component.
+                std::vector<std::vector<float>> surrounding;
+                if(replacement_is_mean || replacement_is_median){
+                    surrounding.resize(comps.sizes.size());
+                    std::vector<int64_t> last_visitor(vals.size(), 0);
+                    for(long int n = 0; n < grid.size(); ++n){
+                        const auto l = comps.labels[n];
+                        if(!is_isolated(l)) continue;
+
+                        const auto i = n / image_size;
+                        const auto row = (n / grid.columns) % grid.rows;
+                        const auto col = n % grid.columns;
+                        for(const auto &o : neighbours){
+                            const auto i2 = i + o[0];
+                            const auto row2 = row + o[1];
+                            const auto col2 = col + o[2];
+                            if( (i2 < 0) || (grid.images <= i2)
+                            ||  (row2 < 0) || (grid.rows <= row2)
+                            ||  (col2 < 0) || (grid.columns <= col2) ) continue;
+                            const auto m = i2 * image_size + row2 * grid.columns + col2;
+                            if( (vol.mask[m] == 0) || (comps.labels[m] == l) || (last_visitor[m] == l) ) continue;
+                            last_visitor[m] = l;
+                            if(std::isfinite(vals[m])) surrounding[l].push_back(vals[m]);
+                        }
+                    }
+                }
+
+                std::vector<float> replacements(comps.sizes.size(), std::numeric_limits<float>::quiet_NaN());
+                std::vector<uint8_t> replace(comps.sizes.size(), 0);
+                for(size_t l = 1; l < comps.sizes.size(); ++l){
+                    if(is_isolated(l) != replace_is_iso) continue;
+                    if(replacement_is_value){
+                        replacements[l] = replacement_value;
+                    }else if(surrounding[l].empty()){
+                        continue; // Nothing to draw a replacement from, so the component is left unaltered.
+                    }else if(replacement_is_mean){
+                        replacements[l] = Stats::Mean(surrounding[l]);
+                    }else if(replacement_is_median){
+                        replacements[l] = Stats::Median(surrounding[l]);
+                    }
+                    replace[l] = 1;
+                }
+
+                parallel_for(0, grid.images, [&](long int i){
+                    auto &img = vol.images[i].get();
+                    for(long int row = 0; row < grid.rows; ++row){
+                        for(long int col = 0; col < grid.columns; ++col){
+                            const auto l = comps.labels[i * image_size + row * grid.columns + col];
+                            if(replace[l] != 0) img.reference(row, col, chan) = replacements[l];
+                        }
+                    }
+                }, 1);
+            }
+
+            for(auto &img_refw : vol.images){
+                UpdateImageDescription( img_refw, "Isolated voxel filtered" );
+            }
+            continue;
+        }
+
         ComputeVolumetricNeighbourhoodSamplerUserData ud;
         ud.channel = Channel;
         ud.maximum_distance = MaxDistance;
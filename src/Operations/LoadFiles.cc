@@ -31,6 +31,7 @@
 #include "../Thread_Pool.h"
 #include "../Write_File.h"
 #include "../File_Loader.h"
+#include "../Boost_Serialization_File_Loader.h"
 
 #include "LoadFiles.h"
 
@@ -64,6 +65,32 @@ OperationDoc OpArgDocLoadFiles(){
     out.args.back().expected = true;
     out.args.back().examples = { "/tmp/image.dcm", "rois.dcm", "dose.dcm", "image.fits", "point_cloud.xyz" };
 
+    out.args.emplace_back();
+    out.args.back().name = "Components";
+    out.args.back().desc = "Which components to load from serialized Drover archives."
+                           " Either 'all', or any combination of (images), (contours), (point clouds),"
+                           " (surface meshes), (treatment plans), (line samples), and (transforms)."
+                           " Native archives skip reading voxel data entirely when images are not selected;"
+                           " other archives are fully read and the remaining components discarded."
+                           " Other file types are always loaded in full.";
+    out.args.back().default_val = "all";
+    out.args.back().expected = true;
+    out.args.back().examples = { "all",
+                                 "contours",
+                                 "contours+surfacemeshes",
+                                 "pointclouds+tplans" };
+
+    out.args.emplace_back();
+    out.args.back().name = "DeferPixelDecoding";
+    out.args.back().desc = "Whether to defer decoding the pixel data of DICOM images until the pixels are first needed."
+                           " Image metadata and geometry are available immediately, so images discarded based only"
+                           " on their metadata or geometry (e.g., 'SelectSlicesIntersectingROI' or 'DeleteImages')"
+                           " are never decoded. The raw file contents are retained in the meantime, and errors in"
+                           " the pixel data are only reported when the pixels are first needed.";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
+
     return out;
 }
 
@@ -76,6 +103,8 @@ Drover LoadFiles(Drover DICOM_data,
     //---------------------------------------------- User Parameters --------------------------------------------------
 //    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
     const auto FileNameStr = OptArgs.getValueStr("FileName").value();
+    const auto ComponentsStr = OptArgs.getValueStr("Components").value();
+    const auto DeferPixelDecodingStr = OptArgs.getValueStr("DeferPixelDecoding").value();
 
     //-----------------------------------------------------------------------------------------------------------------
 
@@ -112,7 +141,36 @@ Drover LoadFiles(Drover DICOM_data,
     // Load the files to a dummy Drover class.
     Drover DD_work;
     std::map<std::string, std::string> dummy;
-    const auto res = Load_Files(DD_work, dummy, FilenameLex, Paths);
+
+    const auto regex_true     = Compile_Regex("^tr?u?e?$");
+    const auto DeferPixelDecoding = std::regex_match(DeferPixelDecodingStr, regex_true);
+
+    const auto regex_all      = Compile_Regex("^al?l?$");
+    const auto regex_images   = Compile_Regex(".*ima?ge?s?.*");
+    const auto regex_contours = Compile_Regex(".*cont?o?u?r?s?.*");
+    const auto regex_pclouds  = Compile_Regex(".*po?i?n?t?.*clo?u?d?s?.*");
+    const auto regex_smeshes  = Compile_Regex(".*su?r?f?a?c?e?.*mes?h?e?s?.*");
+    const auto regex_tplans   = Compile_Regex(".*(tpla?n?s?|tre?a?t?m?e?n?t?.?pla?n?s?).*");
+    const auto regex_lsamps   = Compile_Regex(".*li?n?e?.?sa?m?p?l?e?s?.*");
+    const auto regex_tforms   = Compile_Regex(".*(tra?n?s?fo?r?m?s?|warps?).*");
+
+    if(!std::regex_match(ComponentsStr, regex_all)){
+        drover_archive_selection selection;
+        selection.images         = std::regex_match(ComponentsStr, regex_images);
+        selection.contours       = std::regex_match(ComponentsStr, regex_contours);
+        selection.point_clouds   = std::regex_match(ComponentsStr, regex_pclouds);
+        selection.surface_meshes = std::regex_match(ComponentsStr, regex_smeshes);
+        selection.tplans         = std::regex_match(ComponentsStr, regex_tplans);
+        selection.line_samples   = std::regex_match(ComponentsStr, regex_lsamps);
+        selection.transforms     = std::regex_match(ComponentsStr, regex_tforms);
+
+        // Archives are loaded selectively. Anything else is passed on to the general loader.
+        if(!Load_Selected_From_Boost_Serialization_Files(DD_work, dummy, FilenameLex, Paths, selection)){
+            throw std::runtime_error("Unable to load one or more archives. Refusing to continue.");
+        }
+    }
+
+    const auto res = Paths.empty() || Load_Files(DD_work, dummy, FilenameLex, Paths, 1, DeferPixelDecoding);
     if(!res){
         throw std::runtime_error("Unable to load one or more files. Refusing to continue.");
     }
@@ -1,9 +1,11 @@
 //LogScale.cc - A part of DICOMautomaton 2015, 2016. Written by hal clark.
 
 #include <any>
+#include <cmath>
 #include <optional>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
@@ -14,6 +16,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Logarithmic_Pixel_Scale.h"
 #include "LogScale.h"
 #include "YgorImages.h"
@@ -48,12 +51,37 @@ Drover LogScale(Drover DICOM_data,
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
     for(auto & iap_it : IAs){
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          LogScalePixels,
-                                                          {}, {} )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     LogScalePixels,
+                                     {}, {} )){
             throw std::runtime_error("Unable to log-scale image.");
         }
     }
 
     return DICOM_data;
 }
+
+std::optional<pointwise_stage> PointwiseStageLogScale(Drover &DICOM_data, const OperationArgPkg& OptArgs){
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+
+    pointwise_stage stage;
+    stage.name = "LogScale";
+    auto IAs_all = All_IAs( DICOM_data );
+    for(auto & iap_it : Whitelist( IAs_all, ImageSelectionStr )) stage.arrays.push_back(*iap_it);
+
+    //Mirrors LogScalePixels.
+    stage.transform = [](float *vals, size_t n, size_t stride, Stats::Running_MinMax<float> &minmax) -> void {
+        for(size_t i = 0; i < n; ++i){
+            auto &v = vals[i * stride];
+            const auto pixel_val = v;
+            v = std::numeric_limits<float>::quiet_NaN();
+            if(pixel_val > static_cast<float>(0)){
+                v = std::log(pixel_val);
+                minmax.Digest(v);
+            }
+        }
+    };
+    stage.description = "Log-Scaled";
+    stage.update_window = true;
+    return stage;
+}
@@ -3,9 +3,11 @@
 #pragma once
 
 #include <map>
+#include <optional>
 #include <string>
 
 #include "../Structs.h"
+#include "../YgorImages_Functors/Pointwise_Fusion.h"
 
 
 OperationDoc OpArgDocLogScale();
@@ -15,3 +17,5 @@ Drover LogScale(Drover DICOM_data,
                 const std::map<std::string, std::string>&
                 /*InvocationMetadata*/,
                 const std::string& /*FilenameLex*/);
+
+std::optional<pointwise_stage> PointwiseStageLogScale(Drover &DICOM_data, const OperationArgPkg& OptArgs);
@@ -34,6 +34,7 @@
 #endif
 
 #include "../Surface_Meshes.h"
+#include "../Surface_Mesh_Adjacency.h"
 
 
 OperationDoc OpArgDocMakeMeshesManifold(){
@@ -95,16 +96,16 @@ Drover MakeMeshesManifold(Drover DICOM_data,
 
         DICOM_data.smesh_data.emplace_back( std::make_shared<Surface_Mesh>() );
 
-        // Attempt to convert directly to a polyhedron.
+        // Attempt to convert directly to a polyhedron. Meshes that are already manifold can be identified from their
+        // (cached) connectivity without the round-trip.
         std::stringstream ss;
-        if(!WriteFVSMeshToOFF( (*smp_it)->meshes, ss )){
+        dcma_surface_meshes::Polyhedron surface_mesh;
+        const bool is_manifold = (*smp_it)->get_adjacency()->is_manifold();
+        if(!is_manifold && !WriteFVSMeshToOFF( (*smp_it)->meshes, ss )){
             throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
         }
 
-
-
-        dcma_surface_meshes::Polyhedron surface_mesh;
-        if(ss >> surface_mesh){
+        if(is_manifold || (ss >> surface_mesh)){
             // Mesh was manifold, so no conversion is necessary. Store the mesh.
             *(DICOM_data.smesh_data.back()) = *(*smp_it);
 
@@ -2,6 +2,7 @@
 
 #include <map>
 #include <string>    
+#include <utility>
 
 #include "../Dose_Meld.h"
 #include "../Structs.h"
@@ -28,7 +29,7 @@ Drover MeldDose(Drover DICOM_data,
                 const std::map<std::string, std::string>& /*InvocationMetadata*/,
                 const std::string& /*FilenameLex*/){
 
-    DICOM_data = Meld_Only_Dose_Data(DICOM_data);
+    DICOM_data = Meld_Only_Dose_Data(std::move(DICOM_data));
 
     return DICOM_data;
 }
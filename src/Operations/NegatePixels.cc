@@ -14,6 +14,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Negate_Image.h"
 #include "NegatePixels.h"
 #include "YgorImages.h"
@@ -48,9 +49,9 @@ Drover NegatePixels(Drover DICOM_data,
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
     for(auto & iap_it : IAs){
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          NegateImage,
-                                                          {}, {} )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     NegateImage,
+                                     {}, {} )){
             throw std::runtime_error("Unable to negate image.");
         }
     }
@@ -20,6 +20,7 @@
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
 
 #include "NormalizePixels.h"
@@ -224,9 +225,9 @@ Drover NormalizePixels(Drover DICOM_data,
                 }
                 return;
             };
-            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                              PartitionedImageVoxelVisitorMutator,
-                                                              {}, cc_ROIs, &ud )){
+            if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                         PartitionedImageVoxelVisitorMutator,
+                                         {}, cc_ROIs, &ud )){
                 throw std::runtime_error("Unable to determine min and max voxel intensities.");
             }
             const auto min = minmax.Current_Min();
@@ -258,9 +259,9 @@ Drover NormalizePixels(Drover DICOM_data,
                 }
                 return;
             };
-            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                              PartitionedImageVoxelVisitorMutator,
-                                                              {}, cc_ROIs, &ud )){
+            if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                         PartitionedImageVoxelVisitorMutator,
+                                         {}, cc_ROIs, &ud )){
                 throw std::runtime_error("Unable to determine sum of voxel intensities.");
             }
             const auto per_voxel_sum = total_sum / static_cast<double>(total_count);
@@ -278,9 +279,9 @@ Drover NormalizePixels(Drover DICOM_data,
         }
 
         // Apply the adjustment closure.
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     PartitionedImageVoxelVisitorMutator,
+                                     {}, cc_ROIs, &ud )){
             throw std::runtime_error("Unable to normalize images.");
         }
     }
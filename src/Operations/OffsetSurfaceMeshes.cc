@@ -0,0 +1,147 @@
+//OffsetSurfaceMeshes.cc - A part of DICOMautomaton 2026.
+
+#include <cmath>
+#include <list>
+#include <map>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "../Lexicon_Cache.h"
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+#include "../Surface_Mesh_Booleans.h"
+
+#include "OffsetSurfaceMeshes.h"
+
+
+OperationDoc OpArgDocOffsetSurfaceMeshes(){
+    OperationDoc out;
+    out.name = "OffsetSurfaceMeshes";
+
+    out.desc =
+        "This operation adds or subtracts a margin to (or extracts a shell from) the selected surface meshes,"
+        " creating new meshes. It is useful for deriving planning volumes in interactive time.";
+
+    out.notes.emplace_back(
+        "Selected surface meshes should be closed. Overlapping components are treated as their union."
+    );
+    out.notes.emplace_back(
+        "Meshes are sampled as signed distance fields on a voxel grid, offset, and re-extracted with Marching Cubes."
+        " The result is accurate to roughly half a voxel and features smaller than a voxel are lost."
+        " Time and memory scale with the number of voxels, so the voxel size should be only as small as needed."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = SMWhitelistOpArgDoc();
+    out.args.back().name = "MeshSelection";
+    out.args.back().default_val = "last";
+
+    out.args.emplace_back();
+    out.args.back().name = "Operation";
+    out.args.back().desc = "The specific operation to perform."
+                           " 'dilate' grows the mesh outward by the distance,"
+                           " 'erode' shrinks the mesh inward by the distance, and"
+                           " 'shell' keeps only the part of the mesh interior within the distance of the surface.";
+    out.args.back().default_val = "dilate";
+    out.args.back().expected = true;
+    out.args.back().examples = { "dilate", "erode", "shell" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+    out.args.emplace_back();
+    out.args.back().name = "Distance";
+    out.args.back().desc = "For dilation and erosion, the distance the surface should travel."
+                           " For shells, the thickness of the shell."
+                           " In all cases DICOM units are assumed.";
+    out.args.back().default_val = "5.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.5", "1.0", "3.0", "5.0", "10.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "VoxelSize";
+    out.args.back().desc = "The size of the voxels used to represent the meshes, which controls the tolerance."
+                           " DICOM units are assumed.";
+    out.args.back().default_val = "1.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.5", "1.0", "2.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "MeshLabel";
+    out.args.back().desc = "A label to attach to the new surface meshes.";
+    out.args.back().default_val = "unspecified";
+    out.args.back().expected = true;
+    out.args.back().examples = { "unspecified", "PTV", "body", "ring" };
+
+    return out;
+}
+
+
+
+Drover OffsetSurfaceMeshes(Drover DICOM_data,
+                           const OperationArgPkg& OptArgs,
+                           const std::map<std::string, std::string>&,
+                           const std::string& FilenameLex){
+
+    const lexicon_translator X(FilenameLex);
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto MeshSelectionStr = OptArgs.getValueStr("MeshSelection").value();
+    const auto OperationStr = OptArgs.getValueStr("Operation").value();
+    const auto Distance = std::stod( OptArgs.getValueStr("Distance").value() );
+    const auto VoxelSize = std::stod( OptArgs.getValueStr("VoxelSize").value() );
+    const auto MeshLabel = OptArgs.getValueStr("MeshLabel").value();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto NormalizedMeshLabel = X(MeshLabel);
+
+    const auto regex_dilate = Compile_Regex("^di?l?a?t?e?$");
+    const auto regex_erode  = Compile_Regex("^er?o?d?e?$");
+    const auto regex_shell  = Compile_Regex("^sh?e?l?l?$");
+
+    const bool op_dilate = std::regex_match(OperationStr, regex_dilate);
+    const bool op_erode  = std::regex_match(OperationStr, regex_erode);
+    const bool op_shell  = std::regex_match(OperationStr, regex_shell);
+    if(!op_dilate && !op_erode && !op_shell){
+        throw std::invalid_argument("Operation not understood. Cannot continue.");
+    }
+    if( !std::isfinite(Distance) || (Distance < 0.0) ){
+        throw std::invalid_argument("Distance must be non-negative. Cannot continue.");
+    }
+
+    auto SMs_all = All_SMs( DICOM_data );
+    auto SMs = Whitelist( SMs_all, MeshSelectionStr );
+
+    // Note: new meshes are appended after the selection is evaluated, so they are not themselves selected.
+    std::list<std::shared_ptr<Surface_Mesh>> selected;
+    for(auto & smp_it : SMs) selected.emplace_back( *smp_it );
+
+    long int completed = 0;
+    const auto sm_count = selected.size();
+    for(const auto &sm : selected){
+        auto out = std::make_shared<Surface_Mesh>();
+        if(op_shell){
+            out->meshes = Shell_Surface_Mesh(sm->meshes, Distance, VoxelSize);
+        }else{
+            out->meshes = Offset_Surface_Mesh(sm->meshes, (op_dilate ? Distance : -Distance), VoxelSize);
+        }
+        if(out->meshes.faces.empty()){
+            FUNCWARN("Offset mesh is empty");
+        }
+
+        out->meshes.metadata = sm->meshes.metadata;
+        out->meshes.metadata["MeshLabel"] = MeshLabel;
+        out->meshes.metadata["NormalizedMeshLabel"] = NormalizedMeshLabel;
+        out->meshes.metadata["Description"] = "Offset surface mesh";
+        DICOM_data.smesh_data.emplace_back( out );
+
+        ++completed;
+        FUNCINFO("Completed " << completed << " of " << sm_count
+              << " --> " << static_cast<int>(1000.0*(completed)/sm_count)/10.0 << "% done");
+    }
+
+    return DICOM_data;
+}
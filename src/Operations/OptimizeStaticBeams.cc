@@ -13,6 +13,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <regex>
 #include <stdexcept>
 #include <string>    
@@ -32,9 +33,9 @@
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorFilesDirs.h"
 
-#include "Explicator.h"
-
+#include "../Distribution_Sketch.h"
 #include "../Insert_Contours.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Write_File.h"
@@ -61,12 +62,6 @@ struct dose_dist_stats {
 
 };
 
-// Global objects so lambdas can be non-capturing and thus passed as function pointers.
-std::function< dose_dist_stats (std::vector<double> &, std::vector<double> &)> global_evaluate_weights;
-std::vector<double> global_working;
-bool generate_dose_dist_stats = false;
-
-
 // This routine determines the normalization factor required to satisfy the given DVH criteria: $V_{D} \geq V_{min}$.
 // Every element in the input should be multiplied with the return value to satisfy the DVH criteria.
 //
@@ -205,6 +200,19 @@ OperationDoc OpArgDocOptimizeStaticBeams(){
     out.args.back().expected = true;
     out.args.back().examples = { "48.0", "60.0", "63.3", "70.0", "100.0" };
 
+
+    out.args.emplace_back();
+    out.args.back().name = "MultiStart";
+    out.args.back().desc = "The number of optimizations to run concurrently. The first is always a global search"
+                           " (DIRECT-L) over the whole weight space. The remainder are local searches (Subplex)"
+                           " started from deterministically-random weights, which can help escape the shallow"
+                           " local minima that the global search sometimes settles in. The lowest-cost result"
+                           " is reported. Each optimization evaluates candidate weights independently, so"
+                           " additional starts cost little extra wall time when idle cores are available.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "4", "8", "16" };
+
     return out;
 }
 
@@ -214,7 +222,7 @@ Drover OptimizeStaticBeams(Drover DICOM_data,
                            /*InvocationMetadata*/,
                            const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
@@ -232,7 +240,12 @@ Drover OptimizeStaticBeams(Drover DICOM_data,
     const auto dvh_Vmin_frac = std::stod(  OptArgs.getValueStr("NormalizationV").value() );
     const auto D_Rx = std::stod(  OptArgs.getValueStr("RxDose").value() );
 
+    const auto MultiStart = std::stol( OptArgs.getValueStr("MultiStart").value() );
+
     //-----------------------------------------------------------------------------------------------------------------
+    if(MultiStart < 1){
+        throw std::invalid_argument("At least one optimization start is required. Cannot continue.");
+    }
 
     if(ResultsSummaryFileName.empty()){
         ResultsSummaryFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_optimizestaticbeamssummary_", 6, ".csv");
@@ -348,26 +361,36 @@ Drover OptimizeStaticBeams(Drover DICOM_data,
     }
 
     const auto N_beams = static_cast<long int>(voxels.size());
-    const auto N_voxels = voxels.front().size();
+    const auto N_voxels = static_cast<long int>(voxels.front().size());
 
-    std::stringstream ss;
+    // Pack the per-beam dose influence of each sampled ROI voxel contiguously (voxel-major), so evaluating a weighting
+    // scheme is a single pass over a compact N_voxels x N_beams matrix rather than one pass per beam.
+    std::vector<double> influence(N_voxels * N_beams);
+    for(long int v = 0; v < N_voxels; ++v){
+        for(long int beam = 0; beam < N_beams; ++beam){
+            influence[v * N_beams + beam] = voxels[beam][v];
+        }
+    }
+    voxels.clear();
+    voxels.shrink_to_fit();
 
     // This routine evaluates weighting schemes to produce cost and quality metrics.
-    auto evaluate_weights = [&,N_beams](std::vector<double> &weights, 
-                                        std::vector<double> &working) -> dose_dist_stats {
+    //
+    // Note: only the working buffer is modified, so concurrent evaluations are safe provided each uses its own buffer.
+    auto evaluate_weights = [&,N_beams,N_voxels](const std::vector<double> &weights,
+                                                 std::vector<double> &working,
+                                                 bool generate_dose_dist_stats) -> dose_dist_stats {
 
         dose_dist_stats out;
 
         // Compute the total dose using the current weighting scheme.
-        //
-        // Note: This requires consistent voxel ordering!
-        std::fill(working.begin(), working.end(), 0.0);
-        for(long int beam = 0; beam < N_beams; ++beam){
-            const auto weight = weights[beam];
-            std::transform( working.begin(), working.end(),
-                            voxels[beam].begin(), 
-                            working.begin(),
-                            [=](const double &L, const double &R){ return L + weight * R; });
+        working.resize(N_voxels);
+        const double *w = weights.data();
+        for(long int v = 0; v < N_voxels; ++v){
+            const double *row = influence.data() + v * N_beams;
+            double D = 0.0;
+            for(long int beam = 0; beam < N_beams; ++beam) D += w[beam] * row[beam];
+            working[v] = D;
         }
 
         // Sanity check.
@@ -389,11 +412,12 @@ Drover OptimizeStaticBeams(Drover DICOM_data,
             out.D_min  = 100.0 * Stats::Min(working) / D_Rx;
             out.D_max  = 100.0 * Stats::Max(working) / D_Rx;
             out.D_mean = 100.0 * Stats::Mean(working) / D_Rx;
-            out.D_02   = Stats::Percentile(working, 0.02);
-            out.D_05   = Stats::Percentile(working, 0.05);
-            out.D_50   = Stats::Percentile(working, 0.50);
-            out.D_95   = Stats::Percentile(working, 0.95);
-            out.D_98   = Stats::Percentile(working, 0.98);
+            const sorted_quantiles<double> ptiles(working);
+            out.D_02   = ptiles.quantile(0.02);
+            out.D_05   = ptiles.quantile(0.05);
+            out.D_50   = ptiles.quantile(0.50);
+            out.D_95   = ptiles.quantile(0.95);
+            out.D_98   = ptiles.quantile(0.98);
         }
 
         //Compute the cost function for each dose element.
@@ -409,60 +433,94 @@ Drover OptimizeStaticBeams(Drover DICOM_data,
 */
         return out;
     };
-    global_evaluate_weights = evaluate_weights;
+
+    // Normalizes the weights so they sum to one. The optimizers work with unnormalized weights to avoid a constraint.
+    const auto normalize_weights = [](std::vector<double> weights) -> std::vector<double> {
+        const auto sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+        std::transform(weights.begin(), weights.end(),
+                       weights.begin(), [=](double ow) -> double { return ow / sum; });
+        return weights;
+    };
+
+    // Each optimization gets its own context so the objective can be passed as a non-capturing function pointer.
+    struct objective_context {
+        const decltype(evaluate_weights) *evaluate;
+        const decltype(normalize_weights) *normalize;
+        std::vector<double> working;
+    };
 
     //Constrained surface optimization.
     auto f_to_optimize = [](const std::vector<double> &open_weights, 
                             std::vector<double> &grad, 
-                            void * ) -> double {
+                            void *data) -> double {
         if(!grad.empty()) throw std::logic_error("This implementation cannot handle derivatives.");
 
-        std::vector<double> weights(open_weights);
-        const auto sum = std::accumulate(weights.begin(), weights.end(), 0.0);
-        std::transform(weights.begin(), weights.end(), weights.begin(), [=](double ow) -> double { return ow / sum; });
-
-        auto res = global_evaluate_weights(weights, global_working);
-        return res.cost;
+        auto *ctx = static_cast<objective_context *>(data);
+        const auto weights = (*ctx->normalize)(open_weights);
+        return (*ctx->evaluate)(weights, ctx->working, false).cost;
     };
 
-    std::vector<double> open_weights(N_beams, 0.5);
-    std::vector<double> working(N_voxels, 0.0);
-    global_working = working;
+    // Initial weights. The global search starts from uniform weights; the rest are seeded deterministically.
+    struct start_result {
+        std::vector<double> open_weights;
+        double minf = std::numeric_limits<double>::infinity();
+    };
+    std::vector<start_result> starts(MultiStart);
+    {
+        std::mt19937 re( random_seed );
+        std::uniform_real_distribution<double> rd(0.05, 1.0);
+        for(long int i = 0; i < MultiStart; ++i){
+            starts[i].open_weights.resize(N_beams, 0.5);
+            if(i == 0) continue;
+            for(auto &ow : starts[i].open_weights) ow = rd(re);
+        }
+    }
 
 #ifdef DCMA_USE_NLOPT
-    //nlopt::opt optimizer(nlopt::LN_NELDERMEAD, N_beams);
-    nlopt::opt optimizer(nlopt::GN_DIRECT_L, N_beams);
-    //nlopt::opt optimizer(nlopt::GN_ISRES, N_beams);
-    //nlopt::opt optimizer(nlopt::GN_ESCH, N_beams);
-
-    std::vector<double> lower_bounds(N_beams, 0.0);
-    std::vector<double> upper_bounds(N_beams, 1.0);
-
-    optimizer.set_lower_bounds(lower_bounds);
-    optimizer.set_upper_bounds(upper_bounds);
-    optimizer.set_min_objective(f_to_optimize, nullptr);
-    optimizer.set_ftol_abs(-HUGE_VAL);
-    optimizer.set_ftol_rel(1.0E-8);
-    optimizer.set_xtol_abs(-HUGE_VAL);
-    optimizer.set_xtol_rel(-HUGE_VAL);
-    optimizer.set_maxeval(500'000);
-    double minf;
-
-    generate_dose_dist_stats = false;
-    FUNCINFO("Beginning optimization now..")
-    nlopt::result nlopt_result = optimizer.optimize(open_weights, minf); // open_weights will contain the current-best weights on success.
-    FUNCINFO("Optimizer result: " << nlopt_result);
+    FUNCINFO("Beginning optimization now..");
+    parallel_for(0, MultiStart, [&](long int i){
+        const auto algorithm = (i == 0) ? nlopt::GN_DIRECT_L : nlopt::LN_SBPLX;
+        nlopt::opt optimizer(algorithm, N_beams);
+
+        std::vector<double> lower_bounds(N_beams, 0.0);
+        std::vector<double> upper_bounds(N_beams, 1.0);
+
+        objective_context ctx = { &evaluate_weights, &normalize_weights, std::vector<double>(N_voxels, 0.0) };
+
+        optimizer.set_lower_bounds(lower_bounds);
+        optimizer.set_upper_bounds(upper_bounds);
+        optimizer.set_min_objective(f_to_optimize, static_cast<void *>(&ctx));
+        optimizer.set_ftol_abs(-HUGE_VAL);
+        optimizer.set_ftol_rel(1.0E-8);
+        optimizer.set_xtol_abs(-HUGE_VAL);
+        optimizer.set_xtol_rel(-HUGE_VAL);
+        optimizer.set_maxeval(500'000);
+
+        auto &start = starts[i];
+        try{
+            // open_weights will contain the current-best weights on success.
+            const nlopt::result nlopt_result = optimizer.optimize(start.open_weights, start.minf);
+            FUNCINFO("Optimizer result for start " << i << ": " << nlopt_result << " with cost " << start.minf);
+        }catch(const std::exception &e){
+            FUNCWARN("Optimization start " << i << " failed: '" << e.what() << "'");
+            start.minf = std::numeric_limits<double>::infinity();
+        }
+    }, 1);
 #else // DCMA_USE_NLOPT
     FUNCERR("Unable to optimize -- nlopt was not used");
 #endif // DCMA_USE_NLOPT
 
-    std::vector<double> weights(open_weights);
-    const auto sum = std::accumulate(weights.begin(), weights.end(), 0.0);
-    std::transform(weights.begin(), weights.end(), 
-                   weights.begin(), [=](double ow) -> double { return ow / sum; });
+    const auto best = std::min_element(starts.begin(), starts.end(),
+                                       [](const start_result &l, const start_result &r){ return (l.minf < r.minf); });
+    if(!std::isfinite(best->minf)){
+        throw std::runtime_error("All optimization starts failed. Cannot continue.");
+    }
+    const auto best_start = static_cast<long int>(std::distance(starts.begin(), best));
+
+    const auto weights = normalize_weights(best->open_weights);
 
-    generate_dose_dist_stats = true;
-    const auto res = global_evaluate_weights(weights, global_working);
+    std::vector<double> working(N_voxels, 0.0);
+    const auto res = evaluate_weights(weights, working, true);
 
     // Construct a summary.
     std::stringstream summary;
@@ -474,6 +532,7 @@ Drover OptimizeStaticBeams(Drover DICOM_data,
     
     summary << "# of voxels = " << N_voxels << std::endl
             << "# of beams  = " << N_beams << std::endl
+            << "# of starts = " << MultiStart << " (best: " << best_start << ")" << std::endl
             << std::endl;
 
     summary << "D_min  = " << res.D_min << std::endl
@@ -1,10 +1,12 @@
 //OrderImages.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
+#include <algorithm>
 #include <optional>
 #include <iterator>
 #include <list>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <regex>
 #include <stdexcept>
 #include <string>    
@@ -13,6 +15,7 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "OrderImages.h"
 #include "YgorImages.h"
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
@@ -50,7 +53,7 @@ OperationDoc OpArgDocOrderImages(){
     out.args.back().desc = "Image metadata key to use for ordering."
                            " Images will be sorted according to the key's value 'natural' sorting order, which"
                            " compares sub-strings of numbers and characters separately."
-                           " Note this ordering is expected to be stable, but may not always be on some systems.";
+                           " This ordering is stable; images with identical values retain their relative order.";
     out.args.back().default_val = "";
     out.args.back().expected = true;
     out.args.back().examples = { "AcquisitionTime",
@@ -62,6 +65,77 @@ OperationDoc OpArgDocOrderImages(){
 }
 
 
+namespace {
+
+// A metadata value broken into runs of text and numbers so values can be compared 'naturally,' i.e., with look-ahead
+// for numerical values. Missing values are represented by an empty optional.
+struct natural_sort_token {
+    bool is_num = false;
+    double num = 0.0;
+    std::string text;
+};
+using natural_sort_key = std::optional<std::vector<natural_sort_token>>;
+
+std::vector<natural_sort_token> Tokenize_Natural(const std::string &in){
+    std::vector<std::string> pieces;
+    std::string shtl;
+    bool last_was_num = false;
+    for(char i : in){
+        const auto as_int = static_cast<int>(i);
+        const auto is_num = ( isdigit(as_int) != 0 ) 
+                            || (!last_was_num && (i == '-'))
+                            || ( last_was_num && (i == '.')) ;  // TODO: Support exponential notation.
+
+        if( is_num == !last_was_num ){  // Iff there is a transition.
+            if(!shtl.empty()) pieces.emplace_back(shtl);
+            shtl.clear();
+        }
+        shtl += i;
+
+        last_was_num = is_num;
+    }
+    if(!shtl.empty()) pieces.emplace_back(shtl);
+
+    std::vector<natural_sort_token> out;
+    out.reserve(pieces.size());
+    for(auto &p : pieces){
+        natural_sort_token t;
+        t.is_num = Is_String_An_X<double>(p);
+        if(t.is_num) t.num = stringtoX<double>(p);
+        t.text = std::move(p);
+        out.push_back(std::move(t));
+    }
+    return out;
+}
+
+// A strict ordering: images with the key precede images without it, numbers precede text, and a key that is a prefix
+// of another precedes it.
+bool Natural_Less(const natural_sort_key &A, const natural_sort_key &B){
+    if(  A && !B ) return true;
+    if( !A ) return false;
+
+    const auto &A_vec = A.value();
+    const auto &B_vec = B.value();
+    for(size_t i = 0; ; ++i){
+        // Check if either vectors have run out of tokens.
+        if(B_vec.size() <= i) return false;
+        if(A_vec.size() <= i) return true;
+
+        const auto &a = A_vec[i];
+        const auto &b = B_vec[i];
+        if( a.is_num != b.is_num ) return a.is_num;
+        if( a.is_num ){
+            if( a.num == b.num ) continue;
+            return (a.num < b.num);
+        }
+        if( a.text == b.text ) continue;
+        return (a.text < b.text);
+    }
+}
+
+} // namespace
+
+
 Drover OrderImages(Drover DICOM_data,
                    const OperationArgPkg& OptArgs,
                    const std::map<std::string, std::string>& /*InvocationMetadata*/,
@@ -73,99 +147,31 @@ Drover OrderImages(Drover DICOM_data,
     const auto KeyStr = OptArgs.getValueStr("Key").value();
 
     //-----------------------------------------------------------------------------------------------------------------
-    using img_t = planar_image<float,double>;
-
-    // --------
-    // Define an ordering that will work for words/characters and numbers mixed together.
-    const auto ordering = [KeyStr]( const img_t &A, const img_t &B ) -> bool {
-        const auto A_opt = A.GetMetadataValueAs<std::string>(KeyStr);
-        const auto B_opt = B.GetMetadataValueAs<std::string>(KeyStr);
-
-        if(  A_opt && !B_opt ){
-            return true;
-        }else if( !A_opt &&  B_opt ){
-            return false;
-        }else if( !A_opt && !B_opt ){
-            return true; // Non-sensical, because both are NA. Hopefully this at least preserves order.
-        }else if(  A_opt &&  B_opt ){
-            // A 'natural' sort algorithm that performs look-ahead for numerical values.
-
-            const auto Break = [](std::string in) -> std::vector<std::string> {
-                std::vector<std::string> out;
-                std::string shtl;
-                bool last_was_num = false;
-                for(char i : in){
-                    const auto as_int = static_cast<int>(i);
-                    const auto is_num = ( isdigit(as_int) != 0 ) 
-                                        || (!last_was_num && (i == '-'))
-                                        || ( last_was_num && (i == '.')) ;  // TODO: Support exponential notation.
-
-                    if( is_num == !last_was_num ){  // Iff there is a transition.
-                        if(!shtl.empty()) out.emplace_back(shtl);
-                        shtl.clear();
-                    }
-                    shtl += i;
-
-                    last_was_num = is_num;
-                }
-                if(!shtl.empty()) out.emplace_back(shtl);
-                return out;
-            };
-
-            const auto A_vec = Break(A_opt.value());
-            const auto B_vec = Break(B_opt.value());
-
-            size_t i = 0;
-            while(true){
-                // Check if either vectors have run out of tokens.
-                if( (A_vec.size() <= i) && (B_vec.size() <= i)){
-                    return true; // Strings were (effectively) identical.
-                }else if(A_vec.size() <= i){
-                    return true;
-                }else if(B_vec.size() <= i){
-                    return false;
-                }
-
-                // Check if either vectors can employ numeric sorting.
-                const bool A_is_num = Is_String_An_X<double>(A_vec[i]);
-                const bool B_is_num = Is_String_An_X<double>(B_vec[i]);
-                if( !A_is_num && !B_is_num ){
-                    if( A_vec[i] == B_vec[i] ){
-                        ++i;
-                        continue;
-                    }
-                    return (A_vec[i] < B_vec[i]);
-                }else if(  A_is_num && !B_is_num ){
-                    return true;
-                }else if( !A_is_num &&  B_is_num ){
-                    return false;
-                }else if(  A_is_num &&  B_is_num ){
-                    const auto A_num = stringtoX<double>(A_vec[i]);
-                    const auto B_num = stringtoX<double>(B_vec[i]);
-                    if( A_num == B_num ){
-                        ++i;
-                        continue;
-                    }
-                    return (A_num < B_num);
-                }
-
-                throw std::logic_error("Should never get here (1/3). Refusing to continue.");
-                return true;
-            }
-            
-            throw std::logic_error("Should never get here (2/3). Refusing to continue.");
-            return true;
-        }
-
-        throw std::logic_error("Should never get here (3/3). Refusing to continue.");
-        return true;
-    };
-    // --------
 
+    // Sort keys are extracted and tokenized once per image, and then the images are sorted by their keys. Images with
+    // identical keys retain their relative order.
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
     for(auto & iap_it : IAs){
-        (*iap_it)->imagecoll.images.sort( ordering );
+        auto &images = (*iap_it)->imagecoll.images;
+        std::vector<std::list<planar_image<float,double>>::iterator> img_its;
+        for(auto it = std::begin(images); it != std::end(images); ++it) img_its.push_back(it);
+        const auto N = static_cast<long int>(img_its.size());
+
+        std::vector<natural_sort_key> keys(N);
+        parallel_for(0, N, [&](long int i){
+            const auto val = img_its[i]->GetMetadataValueAs<std::string>(KeyStr);
+            if(val) keys[i] = Tokenize_Natural(val.value());
+        });
+
+        std::vector<long int> order(N);
+        std::iota(std::begin(order), std::end(order), 0);
+        std::stable_sort(std::begin(order), std::end(order), [&](long int l, long int r){
+            return Natural_Less(keys[l], keys[r]);
+        });
+
+        // Rotate each image to the back, in order. Images are relinked rather than copied.
+        for(const auto i : order) images.splice(std::end(images), images, img_its[i]);
     }
 
     return DICOM_data;
@@ -0,0 +1,138 @@
+//PageOutImages.cc - A part of DICOMautomaton 2026. Written by hal clark.
+
+#include <list>
+#include <map>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>    
+
+#include "../Compact_Voxels.h"
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+#include "PageOutImages.h"
+#include "YgorImages.h"
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+
+
+OperationDoc OpArgDocPageOutImages(){
+    OperationDoc out;
+    out.name = "PageOutImages";
+    out.desc = 
+        "This operation moves the pixel data of image arrays into a scratch file, keeping only a bounded amount"
+        " resident in memory. Slice-local operations then stream through the images, paging them in and out as"
+        " needed, which permits processing image arrays that do not fit in memory.";
+
+    out.notes.emplace_back(
+        "Only some operations can stream paged-out images: ScalePixels, SpatialBlur, ThresholdImages, MeldDose, and"
+        " chains of fused pointwise operations (e.g., ConvertNaNsToAir followed by LogScale)."
+        " Image arrays are automatically paged back in (in their entirety) before any other operation is performed."
+    );
+
+    out.notes.emplace_back(
+        "Image geometry and metadata remain resident. The scratch file is removed when the image array is paged"
+        " back in or discarded."
+    );
+
+    out.notes.emplace_back(
+        "With reduced-precision or sparse storage no scratch file is used. Instead, paged-out pixel data is held"
+        " compactly in memory and is converted back to full precision as it is streamed. Sparse storage is lossless."
+        " Reduced precision uses half as many bytes, but is lossy unless 16-bit integer storage is used for"
+        " integer-valued images within [-32767:32767], e.g., CT numbers. Pixel data remains in reduced precision until"
+        " the image array is paged back in, so the precision is lost even if images are never modified."
+    );
+
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "ImageSelection";
+    out.args.back().default_val = "all";
+
+
+    out.args.emplace_back();
+    out.args.back().name = "MemoryBudget";
+    out.args.back().desc = "The maximum amount of pixel data (in MiB) to keep resident for each image array."
+                           " At least one image per worker thread is always kept resident while it is processed,"
+                           " regardless of the budget.";
+    out.args.back().default_val = "1024";
+    out.args.back().expected = true;
+    out.args.back().examples = { "256", "1024", "8192" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "ScratchDirectory";
+    out.args.back().desc = "The directory in which to create scratch files. If empty, the system's temporary"
+                           " directory is used. A directory on fast, local storage with ample free space is best.";
+    out.args.back().default_val = "";
+    out.args.back().expected = true;
+    out.args.back().examples = { "", "/tmp/", "/scratch/" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "Storage";
+    out.args.back().desc = "How paged-out pixel data is held."
+                           " 'float32' retains full precision in a scratch file."
+                           " 'int16' holds 16-bit integers in memory, with a per-image linear rescaling when the"
+                           " pixel values are not integers (or exceed the range); non-finite values other than NaN"
+                           " are clamped."
+                           " 'float16' holds IEEE 754 half-precision values in memory, retaining about three"
+                           " significant digits. This may be suitable for dose or other smoothly-varying images."
+                           " 'sparse' holds full-precision values in memory, but omits runs of zero-valued pixels."
+                           " This is suitable for images that are zero over large regions, such as the dose from an"
+                           " individual beam or beamlet. MeldDose sums equal-geometry sparse arrays without paging"
+                           " them in, so many such arrays can be kept in memory and summed quickly.";
+    out.args.back().default_val = "float32";
+    out.args.back().expected = true;
+    out.args.back().examples = { "float32", "int16", "float16", "sparse" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+    return out;
+}
+
+
+Drover PageOutImages(Drover DICOM_data,
+                     const OperationArgPkg& OptArgs,
+                     const std::map<std::string, std::string>& /*InvocationMetadata*/,
+                     const std::string& /*FilenameLex*/){
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+
+    const auto MemoryBudget = std::stod( OptArgs.getValueStr("MemoryBudget").value() );
+    const auto ScratchDirectory = OptArgs.getValueStr("ScratchDirectory").value();
+    const auto StorageStr = OptArgs.getValueStr("Storage").value();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    if(!(0.0 <= MemoryBudget)){
+        throw std::invalid_argument("Memory budget must be non-negative.");
+    }
+    const auto max_resident_bytes = static_cast<size_t>(MemoryBudget * 1024.0 * 1024.0);
+
+    const auto regex_float32 = Compile_Regex("^fl?o?a?t?_?32$");
+    const auto regex_int16   = Compile_Regex("^in?t?_?16$");
+    const auto regex_float16 = Compile_Regex("^fl?o?a?t?_?16$");
+    const auto regex_sparse  = Compile_Regex("^sp?a?r?s?e?$");
+
+    voxel_storage storage = voxel_storage::float32;
+    if(std::regex_match(StorageStr, regex_float32)){
+        storage = voxel_storage::float32;
+    }else if(std::regex_match(StorageStr, regex_int16)){
+        storage = voxel_storage::int16;
+    }else if(std::regex_match(StorageStr, regex_float16)){
+        storage = voxel_storage::float16;
+    }else if(std::regex_match(StorageStr, regex_sparse)){
+        storage = voxel_storage::sparse;
+    }else{
+        throw std::invalid_argument("'Storage' parameter is invalid. Cannot continue.");
+    }
+
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+    for(auto & iap_it : IAs){
+        (*iap_it)->page_out(max_resident_bytes, ScratchDirectory, storage);
+        FUNCINFO("Paged out " << (*iap_it)->imagecoll.images.size() << " images");
+    }
+
+    return DICOM_data;
+}
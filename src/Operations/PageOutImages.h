@@ -0,0 +1,16 @@
+// PageOutImages.h.
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "../Structs.h"
+
+
+OperationDoc OpArgDocPageOutImages();
+
+Drover PageOutImages(Drover DICOM_data,
+                     const OperationArgPkg& /*OptArgs*/,
+                     const std::map<std::string, std::string>& /*InvocationMetadata*/,
+                     const std::string& /*FilenameLex*/);
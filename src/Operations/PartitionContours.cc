@@ -22,10 +22,10 @@
 #include <numeric>
 
 #include "../Dose_Meld.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "PartitionContours.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
@@ -249,7 +249,7 @@ Drover PartitionContours(Drover DICOM_data,
         throw std::invalid_argument("Requested number of partitions along 'Z' axis is not valid. Refusing to continue.");
     }
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     // Stuff references to all contours into a list. Remember that you can still address specific contours through
     // the original holding containers (which are not modified here).
@@ -27,6 +27,7 @@
 #include <thread>
 #include <chrono>
 
+#include "../Common_Plotting.h"
 #include "../Insert_Contours.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
@@ -276,9 +277,7 @@ void Plot(const std::vector<Shuttle<samples_1D<T>>> &Shuttles,
     //       local items. This 'child' thread may run beyond the main thread, so it is possible 
     //       that everything else will be deconstructed while this runs!
     //
-    // NOTE: I can't remember right now how to force parallel thread execution. Maybe std::async?
-    //       If it is an issue, fix it. It shouldn't really be an issue because the thread just
-    //       waits around to close the pipe, but Gnuplot will close the other end at some point.
+    // NOTE: Callers now run plotting on a background thread via Submit_Plot_Job() (see Common_Plotting.h).
     //
     // NOTE: I've found that if there are several items in the ThreadWaiter, the main process will
     //       terminate after any one of the threads have joined (actually I think all threads too,
@@ -390,12 +389,14 @@ Drover PlotLineSamples(Drover DICOM_data,
         FUNCINFO("Line sample course with name '" << LineName << "' written to '" << fn << "'");
     }
 
-    try{
-        YgorMathPlottingGnuplot::Plot<double>(shuttle, TitleStr, AbscissaLabelStr, OrdinateLabelStr);
-        //Plot<double>(shuttle, "Title here", "X-label here", "Y-label here");
-    }catch(const std::exception &e){
-        FUNCWARN("Unable to plot line sample: " << e.what());
-    }
+    // Plotting is performed in the background so subsequent operations can proceed while the plot is open.
+    Submit_Plot_Job([=]() -> void {
+        try{
+            YgorMathPlottingGnuplot::Plot<double>(shuttle, TitleStr, AbscissaLabelStr, OrdinateLabelStr);
+        }catch(const std::exception &e){
+            FUNCWARN("Unable to plot line sample: " << e.what());
+        }
+    });
 
     return DICOM_data;
 }
@@ -76,6 +76,7 @@ Drover PlotPerROITimeCourses(Drover DICOM_data,
 
     //Compute some aggregate C(t) curves from the available ROIs.
     ComputePerROITimeCoursesUserData ud; // User Data.
+    ud.tensor = img_arr->get_time_course_tensor();
     if(!img_arr->imagecoll.Compute_Images( ComputePerROICourses,   //Non-modifying function, can use in-place.
                                            { },
                                            cc_ROIs,
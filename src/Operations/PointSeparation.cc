@@ -21,10 +21,10 @@
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 #include "YgorFilesDirs.h"
 
-#include "Explicator.h"
-
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Point_Set_KD_Tree.h"
 #include "../YgorImages_Functors/Compute/Contour_Similarity.h"
 
 #include "PointSeparation.h"
@@ -94,7 +94,7 @@ Drover PointSeparation(Drover DICOM_data,
     auto FileName = OptArgs.getValueStr("FileName").value();
     const auto UserComment = OptArgs.getValueStr("UserComment");
     //-----------------------------------------------------------------------------------------------------------------
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     auto PCs_all = All_PCs( DICOM_data );
     const auto PCs_A = Whitelist( PCs_all, PointSelectionAStr );
@@ -133,31 +133,42 @@ Drover PointSeparation(Drover DICOM_data,
     double sq_separation_max = -sq_separation_min;
     double sq_hausdorff = -std::numeric_limits<double>::infinity();
 
-    for(const auto & pcpA_it : PCs_A){
-        for(const auto& vA : (*pcpA_it)->pset.points){
-
-            double sq_nearest = std::numeric_limits<double>::infinity();
-            for(const auto & pcpB_it : PCs_B){
-                for(const auto& vB : (*pcpB_it)->pset.points){
-                    const auto sq_sep = vA.sq_dist(vB);
-                    // Identify the nearest point in set B for the current set A point.
-                    if(sq_sep < sq_nearest){
-                        sq_nearest = sq_sep;
-                    }
-                    // Identify the shortest A-point to B-point distance for all points in A and B.
-                    if(sq_sep < sq_separation_min){
-                        sq_separation_min = sq_sep;
-                    }
-                    // Identify the longest A-point to B-point distance for all points in A and B.
-                    if(sq_separation_max < sq_sep){
-                        sq_separation_max = sq_sep;
-                    }
+    // Index all B points once so that each A point needs only a nearest- and a farthest-point query. A single point
+    // cloud can use its cached index.
+    std::shared_ptr<const Point_Set_KD_Tree> tree_B_ptr;
+    if(PCs_B.size() == 1){
+        tree_B_ptr = (*PCs_B.front())->get_kd_tree();
+    }else{
+        std::vector<vec3<double>> all_B;
+        for(const auto & pcpB_it : PCs_B){
+            all_B.insert( std::end(all_B), std::begin((*pcpB_it)->pset.points), std::end((*pcpB_it)->pset.points) );
+        }
+        tree_B_ptr = std::make_shared<const Point_Set_KD_Tree>(all_B);
+    }
+    if(0 < tree_B_ptr->size()){
+        const auto &tree_B = *tree_B_ptr;
+
+        for(const auto & pcpA_it : PCs_A){
+            const auto nearest = tree_B.nearest( (*pcpA_it)->pset.points );
+            for(size_t i = 0; i < nearest.size(); ++i){
+                const auto sq_nearest = nearest[i].sq_dist;
+
+                // Identify the shortest A-point to B-point distance for all points in A and B.
+                if(sq_nearest < sq_separation_min){
+                    sq_separation_min = sq_nearest;
                 }
-            }
 
-            // Identify if the nearest matching point in set B for the current set A point is the A-B Hausdorff distance.
-            if(sq_hausdorff < sq_nearest){
-                sq_hausdorff = sq_nearest;
+                // Identify the longest A-point to B-point distance for all points in A and B.
+                const auto sq_farthest = tree_B.farthest( (*pcpA_it)->pset.points[i] ).sq_dist;
+                if(sq_separation_max < sq_farthest){
+                    sq_separation_max = sq_farthest;
+                }
+
+                // Identify if the nearest matching point in set B for the current set A point is the A-B Hausdorff
+                // distance.
+                if(sq_hausdorff < sq_nearest){
+                    sq_hausdorff = sq_nearest;
+                }
             }
         }
     }
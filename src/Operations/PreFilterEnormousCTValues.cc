@@ -1,14 +1,18 @@
 //PreFilterEnormousCTValues.cc - A part of DICOMautomaton 2015, 2016. Written by hal clark.
 
 #include <any>
+#include <cmath>
 #include <functional>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>    
 
 #include "../Structs.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/CT_Perf_Pixel_Filter.h"
 #include "PreFilterEnormousCTValues.h"
 #include "YgorImages.h"
@@ -31,12 +35,30 @@ Drover PreFilterEnormousCTValues(Drover DICOM_data,
                                  const std::string& /*FilenameLex*/){
 
     for(auto & img_arr : DICOM_data.image_data){
-        if(!img_arr->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                               CTPerfEnormousPixelFilter,
-                                               {}, {} )){
+        if(!Process_Images_Balanced( img_arr->imagecoll,
+                                     CTPerfEnormousPixelFilter,
+                                     {}, {} )){
             FUNCERR("Unable to censor pixels with enormous values");
         }
     }
 
     return DICOM_data;
 }
+
+std::optional<pointwise_stage> PointwiseStagePreFilterEnormousCTValues(Drover &DICOM_data, const OperationArgPkg& /*OptArgs*/){
+    pointwise_stage stage;
+    stage.name = "PreFilterEnormousCTValues";
+    for(auto & img_arr : DICOM_data.image_data) stage.arrays.push_back(img_arr);
+
+    //Mirrors CTPerfEnormousPixelFilter.
+    stage.transform = [](float *vals, size_t n, size_t stride, Stats::Running_MinMax<float> &minmax) -> void {
+        for(size_t i = 0; i < n; ++i){
+            auto &v = vals[i * stride];
+            v = (v < static_cast<float>(2E4)) ? v : std::numeric_limits<float>::quiet_NaN();
+            if(std::isfinite(v)) minmax.Digest(v);
+        }
+    };
+    stage.description = "Enormous Pixel Filtered";
+    stage.update_window = true;
+    return stage;
+}
@@ -73,6 +73,17 @@ OperationDoc OpArgDocRankPixels(){
     out.args.back().expected = true;
     out.args.back().examples = { "inf", "0.0", "1500" };
 
+    out.args.emplace_back();
+    out.args.back().name = "Approximate";
+    out.args.back().desc = "Whether to estimate ranks using a streaming quantile sketch rather than an exact sort."
+                           " Memory use is bounded regardless of the number of voxels, which is useful for very large"
+                           " image arrays. Ranks and percentiles are then approximate, and tied pixel values are"
+                           " not rank-averaged.";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
 
     return out;
 }
@@ -90,10 +101,13 @@ Drover RankPixels(Drover DICOM_data,
     const auto MethodStr = OptArgs.getValueStr("Method").value();
     const auto LowerThreshold = std::stod( OptArgs.getValueStr("LowerThreshold").value() );
     const auto UpperThreshold = std::stod( OptArgs.getValueStr("UpperThreshold").value() );
+    const auto ApproximateStr = OptArgs.getValueStr("Approximate").value();
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto method_rank = Compile_Regex("^ra?n?k?$");
     const auto method_tile = Compile_Regex("^pe?r?c?e?n?t?i?l?e?$");
+    const auto regex_true = Compile_Regex("^tr?u?e?$");
+    const auto Approximate = std::regex_match(ApproximateStr, regex_true);
 
     //-----------------------------------------------------------------------------------------------------------------
     {
@@ -103,6 +117,7 @@ Drover RankPixels(Drover DICOM_data,
             RankPixelsUserData ud;
             ud.inc_lower_threshold = LowerThreshold;
             ud.inc_upper_threshold = UpperThreshold;
+            ud.approximate = Approximate;
 
             if( std::regex_match(MethodStr, method_rank) ){
                 ud.replacement_method = RankPixelsUserData::ReplacementMethod::Rank;
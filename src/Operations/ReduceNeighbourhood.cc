@@ -43,6 +43,12 @@ OperationDoc OpArgDocReduceNeighbourhood(){
         " dilation and erosion, which produces an outline), and various other combinations of core"
         " and composite operations."
     );
+    out.notes.emplace_back(
+        "The 'min', 'mean', 'median', and 'max' reductions (and their aliases) are computed incrementally"
+        " using sliding windows, which is considerably faster for large neighbourhoods. Voxels near the edges of"
+        " the image array, and spherical neighbourhoods of image arrays that are not regularly spaced, are sampled"
+        " exhaustively."
+    );
     
     out.args.emplace_back();
     out.args.back() = IAWhitelistOpArgDoc();
@@ -515,19 +521,23 @@ Drover ReduceNeighbourhood(Drover DICOM_data,
             ud.f_reduce = [](float, std::vector<float> &shtl, vec3<double>) -> float {
                               return Stats::Min(shtl);
                           };
+            ud.reduction = ComputeVolumetricNeighbourhoodSamplerUserData::Reduction::Min;
         }else if( std::regex_match(ReductionStr, regex_median) ){
             ud.f_reduce = [](float, std::vector<float> &shtl, vec3<double>) -> float {
                               return Stats::Median(shtl);
                           };
+            ud.reduction = ComputeVolumetricNeighbourhoodSamplerUserData::Reduction::Median;
         }else if( std::regex_match(ReductionStr, regex_mean) ){
             ud.f_reduce = [](float, std::vector<float> &shtl, vec3<double>) -> float {
                               return Stats::Mean(shtl);
                           };
+            ud.reduction = ComputeVolumetricNeighbourhoodSamplerUserData::Reduction::Mean;
         }else if( std::regex_match(ReductionStr, regex_max)
               ||  std::regex_match(ReductionStr, regex_dilate) ){
             ud.f_reduce = [](float, std::vector<float> &shtl, vec3<double>) -> float {
                               return Stats::Max(shtl);
                           };
+            ud.reduction = ComputeVolumetricNeighbourhoodSamplerUserData::Reduction::Max;
 
         }else if( std::regex_match(ReductionStr, regex_stdize) ){
             const auto nan = std::numeric_limits<double>::quiet_NaN();
@@ -0,0 +1,179 @@
+//ReformatImages.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>    
+
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+#include "../YgorImages_Functors/Rectilinear_Volume.h"
+#include "../YgorImages_Functors/Multiplanar_Reformat.h"
+#include "ReformatImages.h"
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorString.h"       //Needed for SplitStringToVector(...)
+
+
+OperationDoc OpArgDocReformatImages(){
+    OperationDoc out;
+    out.name = "ReformatImages";
+
+    out.desc = 
+        "This operation generates multiplanar reformats (reslices) of the selected image arrays, e.g., sagittal and"
+        " coronal views of an axial series. Reformatted images are stored in a new image array for each selected"
+        " image array, so they can be viewed or exported like any other images.";
+
+    out.notes.emplace_back(
+        "The selected images must form a regular rectilinear grid."
+    );
+    out.notes.emplace_back(
+        "Orthogonal reformats copy voxels exactly and have rows that span the original images. Oblique reformats"
+        " are sampled with trilinear interpolation, and voxels outside the original images are assigned NaN."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "ImageSelection";
+    out.args.back().default_val = "last";
+
+    out.args.emplace_back();
+    out.args.back().name = "Plane";
+    out.args.back().desc = "The planes to generate."
+                           " 'Row' generates one image for every row of the original images, and 'column'"
+                           " generates one image for every column."
+                           " 'Oblique' generates a stack of parallel planes with the provided normal that covers"
+                           " the original images.";
+    out.args.back().default_val = "row";
+    out.args.back().expected = true;
+    out.args.back().examples = { "row",
+                                 "column",
+                                 "oblique" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+    out.args.emplace_back();
+    out.args.back().name = "Stride";
+    out.args.back().desc = "For orthogonal reformats, only every Nth plane is generated."
+                           " A stride of 1 generates all planes.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1",
+                                 "2",
+                                 "10" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Normal";
+    out.args.back().desc = "For oblique reformats, the normal of the generated planes."
+                           " It need not be a unit vector."
+                           " Specify coordinates separated by commas.";
+    out.args.back().default_val = "0.0, 0.0, 1.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0, 0.0, 1.0",
+                                 "1.0, 1.0, 0.0",
+                                 "0.0, -0.5, 1.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Spacing";
+    out.args.back().desc = "For oblique reformats, the distance between adjacent voxels and adjacent planes"
+                           " (in DICOM units: mm). A non-positive spacing uses the smallest voxel spacing of the"
+                           " original images.";
+    out.args.back().default_val = "0.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0",
+                                 "1.0",
+                                 "2.5" };
+
+    return out;
+}
+
+Drover ReformatImages(Drover DICOM_data,
+                      const OperationArgPkg& OptArgs,
+                      const std::map<std::string, std::string>&,
+                      const std::string&){
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+    const auto PlaneStr = OptArgs.getValueStr("Plane").value();
+    const auto Stride = std::stol( OptArgs.getValueStr("Stride").value() );
+    const auto NormalStr = OptArgs.getValueStr("Normal").value();
+    const auto Spacing = std::stod( OptArgs.getValueStr("Spacing").value() );
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_row = Compile_Regex("^ro?w?$");
+    const auto regex_col = Compile_Regex("^co?l?u?m?n?$");
+    const auto regex_obl = Compile_Regex("^ob?l?i?q?u?e?$");
+
+    const bool plane_is_row = std::regex_match(PlaneStr, regex_row);
+    const bool plane_is_col = std::regex_match(PlaneStr, regex_col);
+    const bool plane_is_obl = std::regex_match(PlaneStr, regex_obl);
+    if(!plane_is_row && !plane_is_col && !plane_is_obl){
+        throw std::invalid_argument("'Plane' parameter is invalid. Cannot continue.");
+    }
+
+    const auto xyz = SplitStringToVector(NormalStr, ',', 'd');
+    if(xyz.size() != 3){
+        throw std::invalid_argument("Unable to parse 'Normal' parameter. Cannot continue.");
+    }
+    const vec3<double> Normal( std::stod(xyz.at(0)), std::stod(xyz.at(1)), std::stod(xyz.at(2)) );
+
+    std::list<std::shared_ptr<Image_Array>> reformatted;
+
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+    for(auto & iap_it : IAs){
+        auto &imagecoll = (*iap_it)->imagecoll;
+        if(imagecoll.images.empty()) continue;
+
+        const auto &first = imagecoll.images.front();
+        const auto anchor = first.anchor;
+        const auto vol = pack_along_normal(imagecoll, first.image_plane().N_0.unit());
+        if(!vol.is_regular){
+            throw std::invalid_argument("Images are not evenly spaced. Cannot continue.");
+        }
+
+        std::list<planar_image<float,double>> imgs;
+        if(plane_is_obl){
+            const auto dxy = (0.0 < Spacing) ? Spacing
+                                             : std::min({ vol.pxl_dx, vol.pxl_dy,
+                                                          (1 < vol.images) ? std::abs(vol.image_spacing())
+                                                                           : vol.pxl_dz });
+            for(const auto &geom : Oblique_Reformat_Planes(vol, Normal, dxy, dxy)){
+                imgs.emplace_back( Reformat_Oblique(vol, geom, std::numeric_limits<float>::quiet_NaN(), anchor) );
+            }
+        }else{
+            imgs = Reformat_Orthogonal(vol, (plane_is_row) ? orthogonal_reformat::FixedRow
+                                                           : orthogonal_reformat::FixedColumn,
+                                       Stride, anchor);
+        }
+
+        // Metadata describing the original images' geometry no longer applies.
+        auto common_metadata = imagecoll.get_common_metadata({});
+        for(const auto &key : { "ImagePositionPatient", "ImageOrientationPatient", "SliceLocation",
+                                "SOPInstanceUID", "SpacingBetweenSlices" }){
+            common_metadata.erase(key);
+        }
+
+        auto out = std::make_shared<Image_Array>();
+        for(auto &img : imgs){
+            img.metadata = common_metadata;
+            img.metadata["Rows"] = std::to_string(img.rows);
+            img.metadata["Columns"] = std::to_string(img.columns);
+            img.metadata["PixelSpacing"] = std::to_string(img.pxl_dx) + "\\" + std::to_string(img.pxl_dy);
+            img.metadata["SliceThickness"] = std::to_string(img.pxl_dz);
+            img.metadata["Description"] = (plane_is_obl) ? "Multiplanar reformat: oblique"
+                                        : (plane_is_row) ? "Multiplanar reformat: row"
+                                                         : "Multiplanar reformat: column";
+        }
+        out->imagecoll.images.splice( out->imagecoll.images.end(), imgs );
+        reformatted.emplace_back(out);
+    }
+
+    DICOM_data.image_data.splice( DICOM_data.image_data.end(), reformatted );
+    return DICOM_data;
+}
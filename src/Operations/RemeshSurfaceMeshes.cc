@@ -1,10 +1,5 @@
 //RemeshSurfaceMeshes.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
-#ifdef DCMA_USE_CGAL
-#else
-    #error "Attempted to compile without CGAL support, which is required."
-#endif
-
 #include <asio.hpp>
 #include <algorithm>
 #include <optional>
@@ -33,7 +28,10 @@
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 #include "YgorMathIOOFF.h"
 
-#include "../Surface_Meshes.h"
+#include "../Half_Edge_Mesh.h"
+#ifdef DCMA_USE_CGAL
+    #include "../Surface_Meshes.h"
+#endif // DCMA_USE_CGAL
 
 
 OperationDoc OpArgDocRemeshSurfaceMeshes(){
@@ -45,7 +43,8 @@ OperationDoc OpArgDocRemeshSurfaceMeshes(){
         " original meshes with remeshed copies.";
         
     out.notes.emplace_back(
-        "Selected surface meshes should represent polyhedra."
+        "Selected surface meshes should be orientable and every edge should be shared by at most two faces."
+        " Polygonal faces are triangulated. The 'cgal' method also requires meshes to be closed polyhedra."
     );
 
     out.args.emplace_back();
@@ -69,6 +68,19 @@ OperationDoc OpArgDocRemeshSurfaceMeshes(){
     out.args.back().expected = true;
     out.args.back().examples = { "0.2", "0.75", "1.0", "1.5", "2.015" };
 
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "The implementation to use."
+                           " The 'native' method performs incremental isotropic remeshing directly on the mesh,"
+                           " projecting vertices back onto the original surface, and leaves boundary vertices in place."
+                           " The 'cgal' method uses CGAL's isotropic remeshing."
+                           " The 'cgal' method is only available when built with CGAL support.";
+    out.args.back().default_val = "native";
+    out.args.back().expected = true;
+    out.args.back().examples = { "native", "cgal" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -83,10 +95,23 @@ Drover RemeshSurfaceMeshes(Drover DICOM_data,
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto MeshSelectionStr = OptArgs.getValueStr("MeshSelection").value();
     const auto MeshIterations = std::stol( OptArgs.getValueStr("Iterations").value() );
-    const auto MeshTargetEdgeLength = std::stol( OptArgs.getValueStr("TargetEdgeLength").value() );
+    const auto MeshTargetEdgeLength = std::stod( OptArgs.getValueStr("TargetEdgeLength").value() );
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
 
     //-----------------------------------------------------------------------------------------------------------------
 
+    const auto regex_native = Compile_Regex("^na?t?i?v?e?$");
+    const auto regex_cgal = Compile_Regex("^cg?a?l?$");
+    const bool use_native = std::regex_match(MethodStr, regex_native);
+    if(!use_native && !std::regex_match(MethodStr, regex_cgal)){
+        throw std::invalid_argument("Method not understood. Cannot continue.");
+    }
+#ifndef DCMA_USE_CGAL
+    if(!use_native){
+        throw std::invalid_argument("The 'cgal' method requires CGAL support. Cannot continue.");
+    }
+#endif // DCMA_USE_CGAL
+
 
     auto SMs_all = All_SMs( DICOM_data );
     auto SMs = Whitelist( SMs_all, MeshSelectionStr );
@@ -97,32 +122,42 @@ Drover RemeshSurfaceMeshes(Drover DICOM_data,
 
         const auto orig_metadata = (*smp_it)->meshes.metadata;
 
-        // Convert to a CGAL mesh.
-        std::stringstream ss_i;
-        if(!WriteFVSMeshToOFF( (*smp_it)->meshes, ss_i )){
-            throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
-        }
-
-        dcma_surface_meshes::Polyhedron surface_mesh;
-        if(!( ss_i >> surface_mesh )){
-            throw std::runtime_error("Mesh could not be treated as a polyhedron. (Is it manifold?)");
-        }
-
-        // Remesh.
-        polyhedron_processing::Remesh(surface_mesh, MeshTargetEdgeLength, MeshIterations);
-
-        // Convert back from CGAL mesh.
-        std::stringstream ss_o;
-        if(!( ss_o << surface_mesh )){
-            throw std::runtime_error("Remeshed mesh could not be treated as a polyhedron. (Is it manifold?)");
-        }
-
-        if(!ReadFVSMeshFromOFF( (*smp_it)->meshes, ss_o )){
-            throw std::runtime_error("Unable to read mesh in OFF format. Cannot continue.");
+        if(use_native){
+            Isotropic_Remesh( (*smp_it)->meshes, MeshTargetEdgeLength, MeshIterations );
+        }else{
+#ifdef DCMA_USE_CGAL
+            // Convert to a CGAL mesh.
+            std::stringstream ss_i;
+            if(!WriteFVSMeshToOFF( (*smp_it)->meshes, ss_i )){
+                throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
+            }
+
+            dcma_surface_meshes::Polyhedron surface_mesh;
+            if(!( ss_i >> surface_mesh )){
+                throw std::runtime_error("Mesh could not be treated as a polyhedron. (Is it manifold?)");
+            }
+
+            // Remesh.
+            polyhedron_processing::Remesh(surface_mesh, MeshTargetEdgeLength, MeshIterations);
+
+            // Convert back from CGAL mesh.
+            std::stringstream ss_o;
+            if(!( ss_o << surface_mesh )){
+                throw std::runtime_error("Remeshed mesh could not be treated as a polyhedron. (Is it manifold?)");
+            }
+
+            if(!ReadFVSMeshFromOFF( (*smp_it)->meshes, ss_o )){
+                throw std::runtime_error("Unable to read mesh in OFF format. Cannot continue.");
+            }
+#endif // DCMA_USE_CGAL
         }
 
         (*smp_it)->meshes.metadata = orig_metadata;
 
+        // Vertices and faces have been renumbered, so per-element attributes no longer apply.
+        (*smp_it)->vertex_attributes.clear();
+        (*smp_it)->face_attributes.clear();
+
         ++completed;
         FUNCINFO("Completed " << completed << " of " << sm_count
               << " --> " << static_cast<int>(1000.0*(completed)/sm_count)/10.0 << "% done");
@@ -80,8 +80,9 @@ Drover Repeat(Drover DICOM_data,
 
     FUNCINFO("Repeating " << OptArgs.getChildren().size() << " immediate children operations " << N << " times");
 
+    const auto plan = Compile_Operations(OptArgs.getChildren());
     for(long int i = 0; i < N; ++i){
-        if(!Operation_Dispatcher(DICOM_data, InvocationMetadata, FilenameLex, OptArgs.getChildren())){
+        if(!Operation_Dispatcher(DICOM_data, InvocationMetadata, FilenameLex, plan)){
             FUNCERR("Analysis failed. Cannot continue");
         }
     }
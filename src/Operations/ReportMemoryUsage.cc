@@ -0,0 +1,109 @@
+//ReportMemoryUsage.cc - A part of DICOMautomaton 2026. Written by hal clark.
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>    
+#include <utility>
+#include <vector>
+
+#include "../Structs.h"
+#include "../Drover_Memory.h"
+#include "ReportMemoryUsage.h"
+#include "YgorFilesDirs.h"
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+
+
+OperationDoc OpArgDocReportMemoryUsage(){
+    OperationDoc out;
+    out.name = "ReportMemoryUsage";
+    out.desc = 
+        "This operation reports the approximate amount of memory consumed by the loaded data, broken down by the"
+        " type of data. It can be used to find which steps of a pipeline consume the most memory, or to choose a"
+        " memory budget (see the '--memory-budget' option).";
+
+    out.notes.emplace_back(
+        "Container overhead is estimated, so the figures are approximate. Data shared between objects is counted"
+        " each time it is referenced. Pixel data paged out to scratch files is reported separately and does not count"
+        " toward the resident total. Pixel data held with reduced precision (see PageOutImages) is resident."
+    );
+
+    out.notes.emplace_back(
+        "This operation does not page in image arrays, so it can be used to inspect data that exceeds a memory budget."
+    );
+
+
+    out.args.emplace_back();
+    out.args.back().name = "FileName";
+    out.args.back().desc = "A filename (or full path) in which to append the memory usage, in bytes."
+                           " The format is CSV. Leave empty to only report the usage to the console.";
+    out.args.back().default_val = "";
+    out.args.back().expected = true;
+    out.args.back().examples = { "", "/tmp/memory_usage.csv", "localfile.csv" };
+    out.args.back().mimetype = "text/csv";
+
+    out.args.emplace_back();
+    out.args.back().name = "UserComment";
+    out.args.back().desc = "A string that will be inserted into the output file which will simplify merging output"
+                           " from different stages of a pipeline.";
+    out.args.back().default_val = "";
+    out.args.back().expected = true;
+    out.args.back().examples = { "", "after loading", "after resampling" };
+
+    return out;
+}
+
+
+Drover ReportMemoryUsage(Drover DICOM_data,
+                         const OperationArgPkg& OptArgs,
+                         const std::map<std::string, std::string>& /*InvocationMetadata*/,
+                         const std::string& /*FilenameLex*/){
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto FileName = OptArgs.getValueStr("FileName").value();
+    const auto UserComment = OptArgs.getValueStr("UserComment").value();
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto u = Account_Drover_Memory(DICOM_data);
+    const std::vector<std::pair<std::string, uint64_t>> categories = {
+        { "ImageVoxels", u.image_voxels },
+        { "PagedImageVoxels", u.paged_image_voxels },
+        { "CompactImageVoxels", u.compact_image_voxels },
+        { "ImageMetadata", u.image_metadata },
+        { "Contours", u.contours },
+        { "Meshes", u.meshes },
+        { "PointClouds", u.point_clouds },
+        { "Other", u.other },
+        { "Total", u.total() } };
+
+    for(const auto &c : categories){
+        FUNCINFO(c.first << ": " << (static_cast<double>(c.second) / (1024.0 * 1024.0)) << " MiB");
+    }
+    if(const auto budget = Get_Drover_Memory_Budget(); 0 < budget){
+        FUNCINFO("Budget: " << (static_cast<double>(budget) / (1024.0 * 1024.0)) << " MiB");
+    }
+
+    if(!FileName.empty()){
+        const auto FirstWrite = !Does_File_Exist_And_Can_Be_Read(FileName);
+        std::fstream FO(FileName, std::fstream::out | std::fstream::app);
+        if(!FO){
+            throw std::runtime_error("Unable to open file for reporting memory usage. Cannot continue.");
+        }
+        if(FirstWrite){ // Write a CSV header.
+            FO << "UserComment";
+            for(const auto &c : categories) FO << "," << c.first;
+            FO << std::endl;
+        }
+        FO << UserComment;
+        for(const auto &c : categories) FO << "," << c.second;
+        FO << std::endl;
+        FO.flush();
+        if(!FO){
+            throw std::runtime_error("Unable to write memory usage to file. Cannot continue.");
+        }
+    }
+
+    return DICOM_data;
+}
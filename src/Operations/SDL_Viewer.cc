@@ -19,7 +19,9 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
+#include <set>
 #include <stdexcept>
 #include <string>    
 #include <tuple>
@@ -30,6 +32,7 @@
 
 #include <boost/filesystem.hpp>
 
+#include "../Lexicon_Cache.h"
 #include "../imgui20201021/imgui.h"
 #include "../imgui20201021/imgui_impl_sdl.h"
 #include "../imgui20201021/imgui_impl_opengl3.h"
@@ -46,14 +49,15 @@
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
-#include "Explicator.h"
-
 #include "../Colour_Maps.h"
 #include "../Common_Boost_Serialization.h"
 #include "../Common_Plotting.h"
 
 #include "../Structs.h"
+#include "../Half_Edge_Mesh.h"
+#include "../Image_Pyramid.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
 
 #include "../Font_DCMA_Minimal.h"
@@ -75,6 +79,16 @@ OperationDoc OpArgDocSDL_Viewer(){
     out.args.back().expected = true;
     out.args.back().examples = { "60", "30", "10", "1" };
 
+    out.args.emplace_back();
+    out.args.back().name = "PrefetchRadius";
+    out.args.back().desc = "The number of images on either side of the displayed image that are prepared in the"
+                           " background, so scrolling through them does not stall. Prepared images are retained as"
+                           " textures, so larger values use more graphics memory."
+                           " Zero disables prefetching.";
+    out.args.back().default_val = "8";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0", "4", "8", "16" };
+
     return out;
 }
 
@@ -85,9 +99,10 @@ Drover SDL_Viewer(Drover DICOM_data,
 
     // ----------------------------------------- User Parameters ------------------------------------------
     const auto FPSLimit = std::stoul( OptArgs.getValueStr("FPSLimit").value() );
+    const auto PrefetchRadius = static_cast<long int>( std::stoul( OptArgs.getValueStr("PrefetchRadius").value() ) );
 
     // --------------------------------------- Operational State ------------------------------------------
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     // Image viewer state.
     long int img_array_num = -1; // The image array currently displayed.
@@ -268,17 +283,40 @@ Drover SDL_Viewer(Drover DICOM_data,
 
     // -------------------------------- Functors for various things ---------------------------------------
 
-    // Create an OpenGL texture from an image.
-    struct opengl_texture_handle_t {
-        GLuint texture_number = 0;
+    // Window/level and colour map settings, which determine how images are rasterized.
+    struct raster_settings_t {
+        std::optional<double> custom_centre;
+        std::optional<double> custom_width;
+        size_t colour_map = 0;
+
+        bool operator==(const raster_settings_t &rhs) const {
+            return (this->custom_centre == rhs.custom_centre)
+                && (this->custom_width == rhs.custom_width)
+                && (this->colour_map == rhs.colour_map);
+        }
+    };
+    const auto current_raster_settings = [&custom_centre,
+                                          &custom_width,
+                                          &colour_map]() -> raster_settings_t {
+            raster_settings_t out;
+            out.custom_centre = custom_centre;
+            out.custom_width = custom_width;
+            out.colour_map = colour_map;
+            return out;
+    };
+
+    // Rasterize an image into an 8-bit RGB buffer suitable for uploading as a texture.
+    //
+    // Note: this only reads the image and the (immutable) colour maps, so it can be invoked from worker threads.
+    struct raster_t {
+        std::vector<std::byte> pixels;
         int col_count = 0;
         int row_count = 0;
     };
-    const auto Load_OpenGL_Texture = [&custom_centre,
-                                      &custom_width,
-                                      &colour_maps,
-                                      &colour_map,
-                                      &nan_colour]( const planar_image<float,double>& img ) -> opengl_texture_handle_t {
+    const auto Rasterize_Image = [&colour_maps,
+                                  &nan_colour]( const planar_image<float,double>& img,
+                                                const raster_settings_t &settings ) -> raster_t {
+            const auto &colour_map = colour_maps.at(settings.colour_map);
             const auto img_cols = img.columns;
             const auto img_rows = img.rows;
 
@@ -286,8 +324,11 @@ Drover SDL_Viewer(Drover DICOM_data,
                 FUNCERR("Image dimensions are not reasonable. Is this a mistake? Refusing to continue");
             }
 
-            std::vector<std::byte> animage;
-            animage.reserve(img_cols * img_rows * 3);
+            raster_t out;
+            out.col_count = img_cols;
+            out.row_count = img_rows;
+            auto &animage = out.pixels;
+            animage.resize(img_cols * img_rows * 3);
 
             //------------------------------------------------------------------------------------------------
             //Apply a window to the data if it seems like the WindowCenter or WindowWidth specified in the image metadata
@@ -298,66 +339,25 @@ Drover SDL_Viewer(Drover DICOM_data,
             auto img_win_c     = img.GetMetadataValueAs<double>("WindowCenter");
             auto img_win_fw    = img.GetMetadataValueAs<double>("WindowWidth"); //Full width or range. (Diameter, not radius.)
 
-            auto custom_win_c  = custom_centre; 
-            auto custom_win_fw = custom_width; 
+            auto custom_win_c  = settings.custom_centre; 
+            auto custom_win_fw = settings.custom_width; 
 
             const auto UseCustomWL = (custom_win_c && custom_win_fw);
             const auto UseImgWL = (UseCustomWL) ? false 
                                                 : (  img_win_valid && img_desc && img_win_c 
                                                   && img_win_fw && (img_win_valid.value() == img_desc.value()));
 
+            // The range of pixel values mapped onto the colour map.
+            double low;
+            double high;
             if( UseCustomWL || UseImgWL ){
-                //Window/linear scaling transformation parameters.
-                //const auto win_r = 0.5*(win_fw.value() - 1.0); //The 'radius' of the range, or half width omitting the centre point.
-
                 //The 'radius' of the range, or half width omitting the centre point.
                 const auto win_r  = (UseCustomWL) ? 0.5*custom_win_fw.value()
                                                   : 0.5*img_win_fw.value();
                 const auto win_c  = (UseCustomWL) ? custom_win_c.value()
                                                   : img_win_c.value();
-                const auto win_fw = (UseCustomWL) ? custom_win_fw.value()
-                                                  : img_win_fw.value();
-
-                //The output range we are targeting. In this case, a commodity 8 bit (2^8 = 256 intensities) display.
-                const auto destmin = static_cast<double>( 0 );
-                const auto destmax = static_cast<double>( std::numeric_limits<uint8_t>::max() );
-
-                for(auto j = 0; j < img_rows; ++j){
-                    for(auto i = 0; i < img_cols; ++i){
-                        const auto val = static_cast<double>( img.value(j,i,0) ); //The first (R or gray) channel.
-                        if(!std::isfinite(val)){
-                            animage.push_back( nan_colour[0] );
-                            animage.push_back( nan_colour[1] );
-                            animage.push_back( nan_colour[2] );
-                        }else{
-                            double x; // range = [0,1].
-                            if(val <= (win_c - win_r)){
-                                x = 0.0;
-                            }else if(val >= (win_c + win_r)){
-                                x = 1.0;
-                            }else{
-                                x = (val - (win_c - win_r)) / win_fw;
-                            }
-
-                            const auto res = colour_maps[colour_map].second(x);
-                            const double x_R = res.R;
-                            const double x_G = res.G;
-                            const double x_B = res.B;
-
-                            const double out_R = x_R * (destmax - destmin) + destmin;
-                            const double out_B = x_B * (destmax - destmin) + destmin;
-                            const double out_G = x_G * (destmax - destmin) + destmin;
-
-                            const auto scaled_R = static_cast<uint8_t>( std::floor(out_R) );
-                            const auto scaled_G = static_cast<uint8_t>( std::floor(out_G) );
-                            const auto scaled_B = static_cast<uint8_t>( std::floor(out_B) );
-
-                            animage.push_back( std::byte{scaled_R} );
-                            animage.push_back( std::byte{scaled_G} );
-                            animage.push_back( std::byte{scaled_B} );
-                        }
-                    }
-                }
+                low  = win_c - win_r;
+                high = win_c + win_r;
 
             //------------------------------------------------------------------------------------------------
             //Scale pixels to fill the maximum range. None will be clipped or truncated.
@@ -366,62 +366,39 @@ Drover SDL_Viewer(Drover DICOM_data,
                 // If you don't want to window you need to anticipate and ignore the gigantic numbers being 
                 // you might encounter. This is not the place to do this! If you need to do it here, write a
                 // filter routine and *call* it from here.
-                //
-                // NOTE: This routine could definitely use a re-working, especially to make it safe for all
-                //       arithmetical types (i.e., handling negatives, ensuring there is no overflow or wrap-
-                //       around, ensuring there is minimal precision loss).
-                using pixel_value_t = decltype(img.value(0, 0, 0));
                 const auto pixel_minmax_allchnls = img.minmax();
-                const auto lowest = std::get<0>(pixel_minmax_allchnls);
-                const auto highest = std::get<1>(pixel_minmax_allchnls);
-
-                //const auto lowest = Stats::Percentile(img.data, 0.01);
-                //const auto highest = Stats::Percentile(img.data, 0.99);
-
-                const auto pixel_type_max = static_cast<double>(std::numeric_limits<pixel_value_t>::max());
-                const auto pixel_type_min = static_cast<double>(std::numeric_limits<pixel_value_t>::min());
-                const auto dest_type_max = static_cast<double>(std::numeric_limits<uint8_t>::max()); //Min is implicitly 0.
-
-                const double clamped_low  = static_cast<double>(lowest )/pixel_type_max;
-                const double clamped_high = static_cast<double>(highest)/pixel_type_max;
-
-                for(auto j = 0; j < img_rows; ++j){ 
-                    for(auto i = 0; i < img_cols; ++i){ 
-                        const auto val = img.value(j,i,0);
-                        if(!std::isfinite(val)){
-                            animage.push_back( nan_colour[0] );
-                            animage.push_back( nan_colour[1] );
-                            animage.push_back( nan_colour[2] );
-                        }else{
-                            const double clamped_value = (static_cast<double>(val) - pixel_type_min)/(pixel_type_max - pixel_type_min);
-                            auto rescaled_value = (clamped_value - clamped_low)/(clamped_high - clamped_low);
-                            if( rescaled_value < 0.0 ){
-                                rescaled_value = 0.0;
-                            }else if( rescaled_value > 1.0 ){
-                                rescaled_value = 1.0;
-                            }
-
-                            const auto res = colour_maps[colour_map].second(rescaled_value);
-                            const double x_R = res.R;
-                            const double x_G = res.G;
-                            const double x_B = res.B;
-                            
-                            const auto scaled_R = static_cast<uint8_t>(x_R * dest_type_max);
-                            const auto scaled_G = static_cast<uint8_t>(x_G * dest_type_max);
-                            const auto scaled_B = static_cast<uint8_t>(x_B * dest_type_max);
-
-                            animage.push_back( std::byte{scaled_R} );
-                            animage.push_back( std::byte{scaled_G} );
-                            animage.push_back( std::byte{scaled_B} );
-                        }
-                    }
-                }
+                low  = static_cast<double>(std::get<0>(pixel_minmax_allchnls));
+                high = static_cast<double>(std::get<1>(pixel_minmax_allchnls));
+
+                //low = Stats::Percentile(img.data, 0.01);
+                //high = Stats::Percentile(img.data, 0.99);
+            }
+
+            // Colour the first (R or gray) channel, one row at a time, using the colour map's lookup table.
+            const auto lut = ColourMap_LUT(colour_map.second);
+            const std::array<uint8_t, 3> non_finite = {{ std::to_integer<uint8_t>(nan_colour[0]),
+                                                         std::to_integer<uint8_t>(nan_colour[1]),
+                                                         std::to_integer<uint8_t>(nan_colour[2]) }};
+            const auto col_stride = (1 < img_cols) ? (img.index(0, 1, 0) - img.index(0, 0, 0)) : 1;
+            auto *rgb = reinterpret_cast<uint8_t*>(animage.data());
+            for(long int j = 0; j < img_rows; ++j){
+                lut->Apply_RGB8(img.data.data() + img.index(j, 0, 0), img_cols, col_stride,
+                                low, high, non_finite, rgb + 3 * j * img_cols);
             }
-        
 
+            return out;
+    };
+
+    // Create an OpenGL texture from a rasterized image.
+    struct opengl_texture_handle_t {
+        GLuint texture_number = 0;
+        int col_count = 0;
+        int row_count = 0;
+    };
+    const auto Upload_OpenGL_Texture = []( const raster_t &raster ) -> opengl_texture_handle_t {
             opengl_texture_handle_t out;
-            out.col_count = img_cols;
-            out.row_count = img_rows;
+            out.col_count = raster.col_count;
+            out.row_count = raster.row_count;
 
             CHECK_FOR_GL_ERRORS();
 
@@ -437,13 +414,207 @@ Drover SDL_Viewer(Drover DICOM_data,
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             CHECK_FOR_GL_ERRORS();
 
+            // Rows of RGB pixels are not always 4-byte aligned.
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
             glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, out.col_count, out.row_count, 0, GL_RGB, GL_UNSIGNED_BYTE, static_cast<void*>(animage.data()));
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, out.col_count, out.row_count, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                         static_cast<const void*>(raster.pixels.data()));
             CHECK_FOR_GL_ERRORS();
 
             return out;
     };
 
+    // ----------------------------------------- Texture streaming ----------------------------------------
+    // Rasterizing large images is too slow to do while scrolling, so images near the displayed image are rasterized
+    // ahead of time on the process-wide thread pool. Finished rasters are uploaded as textures a few per frame and
+    // retained, so scrolling back and forth only rebinds existing textures. All OpenGL calls remain on this thread.
+    //
+    // Changing the window/level or colour map invalidates everything, which is tracked via a generation counter so
+    // that in-flight rasterizations can be discarded.
+    using image_key_t = std::pair<long int, long int>; // (Image_Array number, image number).
+    struct prefetch_state_t {
+        std::mutex m;
+        uint64_t generation = 0;
+        std::map<image_key_t, raster_t> ready;
+        std::set<image_key_t> pending;
+    };
+    auto prefetch_state = std::make_shared<prefetch_state_t>();
+    task_group prefetch_tasks;
+
+    std::map<image_key_t, opengl_texture_handle_t> textures;
+    const auto texture_capacity = static_cast<size_t>(2 * PrefetchRadius + 1);
+    raster_settings_t active_raster_settings = current_raster_settings();
+
+    const auto get_image = [&](const image_key_t &key) -> const planar_image<float,double>* {
+            if( (key.first < 0) || (static_cast<long int>(DICOM_data.image_data.size()) <= key.first) ) return nullptr;
+            const auto &imagecoll = (*std::next(DICOM_data.image_data.begin(), key.first))->imagecoll;
+            if( (key.second < 0) || (static_cast<long int>(imagecoll.images.size()) <= key.second) ) return nullptr;
+            return &*std::next(imagecoll.images.begin(), key.second);
+    };
+
+    // Images too large to upload as a single texture are displayed using a reduced-resolution level of the array's
+    // image pyramid, which is shared with other consumers. The pyramid is also returned so the level stays alive.
+    GLint max_texture_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    const int64_t max_texture_extent = std::clamp<int64_t>(max_texture_size, 512, 8192);
+    using display_image_t = std::pair<const planar_image<float,double>*, std::shared_ptr<const Image_Pyramid>>;
+    const auto get_display_image = [&](const image_key_t &key) -> display_image_t {
+            const auto *img = get_image(key);
+            if( (img == nullptr)
+            ||  ( (img->rows <= max_texture_extent) && (img->columns <= max_texture_extent) ) ){
+                return { img, nullptr };
+            }
+            const auto &img_arr = *std::next(DICOM_data.image_data.begin(), key.first);
+            auto pyramid = img_arr->get_image_pyramid(image_pyramid_filter::gaussian);
+            const auto *reduced = pyramid->find_image(img, pyramid->find_level(max_texture_extent));
+            return { (reduced == nullptr) ? img : reduced, pyramid };
+    };
+
+    // How far an image is from the displayed image. Images in other arrays are considered infinitely far.
+    const auto distance_from_current = [&](const image_key_t &key) -> long int {
+            if(key.first != img_array_num) return std::numeric_limits<long int>::max();
+            return std::abs(key.second - img_num);
+    };
+
+    // Discard all textures and rasters if the rasterization settings have changed.
+    const auto invalidate_if_settings_changed = [&]() -> void {
+            const auto settings = current_raster_settings();
+            if(settings == active_raster_settings) return;
+            active_raster_settings = settings;
+
+            for(auto &t : textures) glDeleteTextures(1, &t.second.texture_number);
+            textures.clear();
+
+            std::lock_guard<std::mutex> lock(prefetch_state->m);
+            ++(prefetch_state->generation);
+            prefetch_state->ready.clear();
+            prefetch_state->pending.clear();
+            return;
+    };
+
+    // Retain a texture, evicting those farthest from the displayed image if there are too many.
+    const auto store_texture = [&](const image_key_t &key, const opengl_texture_handle_t &handle) -> void {
+            textures[key] = handle;
+            while(texture_capacity < textures.size()){
+                auto farthest = std::begin(textures);
+                for(auto it = std::begin(textures); it != std::end(textures); ++it){
+                    if(distance_from_current(farthest->first) < distance_from_current(it->first)) farthest = it;
+                }
+                if(distance_from_current(farthest->first) == 0) break;
+                glDeleteTextures(1, &farthest->second.texture_number);
+                textures.erase(farthest);
+            }
+            return;
+    };
+
+    // Queue rasterization of the images surrounding the displayed image, nearest first.
+    const auto schedule_prefetch = [&]() -> void {
+            if(PrefetchRadius <= 0) return;
+
+            std::lock_guard<std::mutex> lock(prefetch_state->m);
+            for(auto it = std::begin(prefetch_state->ready); it != std::end(prefetch_state->ready); ){
+                if(PrefetchRadius < distance_from_current(it->first)){
+                    it = prefetch_state->ready.erase(it);
+                }else{
+                    ++it;
+                }
+            }
+
+            for(long int d = 1; d <= PrefetchRadius; ++d){
+                for(const auto n : { img_num + d, img_num - d }){
+                    const image_key_t key = { img_array_num, n };
+                    if( (get_image(key) == nullptr)
+                    ||  (textures.count(key) != 0)
+                    ||  (prefetch_state->ready.count(key) != 0)
+                    ||  (prefetch_state->pending.count(key) != 0) ) continue;
+                    const auto disp = get_display_image(key);
+                    const auto *img = disp.first;
+
+                    prefetch_state->pending.insert(key);
+                    prefetch_tasks.run([state = prefetch_state,
+                                        generation = prefetch_state->generation,
+                                        settings = active_raster_settings,
+                                        key,
+                                        img,
+                                        pyramid = disp.second, // Keeps reduced levels alive.
+                                        &Rasterize_Image]() -> void {
+                        {
+                            std::lock_guard<std::mutex> lock(state->m);
+                            if( (state->generation != generation)
+                            ||  (state->pending.count(key) == 0) ) return;
+                        }
+
+                        raster_t raster;
+                        try{
+                            raster = Rasterize_Image(*img, settings);
+                        }catch(const std::exception &){
+                            // The image will be rasterized again, reporting the error, if it is displayed.
+                        }
+
+                        std::lock_guard<std::mutex> lock(state->m);
+                        state->pending.erase(key);
+                        if( (state->generation == generation)
+                        &&  !raster.pixels.empty() ){
+                            state->ready[key] = std::move(raster);
+                        }
+                    });
+                }
+            }
+            return;
+    };
+
+    // Upload a few finished rasters so they are resident before they are needed.
+    const auto upload_prefetched_textures = [&](size_t max_uploads) -> void {
+            for(size_t i = 0; i < max_uploads; ++i){
+                image_key_t key;
+                raster_t raster;
+                {
+                    std::lock_guard<std::mutex> lock(prefetch_state->m);
+                    auto it = std::begin(prefetch_state->ready);
+                    if(it == std::end(prefetch_state->ready)) return;
+                    key = it->first;
+                    raster = std::move(it->second);
+                    prefetch_state->ready.erase(it);
+                }
+                if(textures.count(key) != 0) continue;
+                store_texture(key, Upload_OpenGL_Texture(raster));
+            }
+            return;
+    };
+
+    // Provide a texture for the specified image, using a prefetched texture or raster if available.
+    const auto Load_OpenGL_Texture = [&]( const image_key_t &key ) -> opengl_texture_handle_t {
+            invalidate_if_settings_changed();
+
+            auto t_it = textures.find(key);
+            if(t_it == std::end(textures)){
+                std::optional<raster_t> raster;
+                {
+                    std::lock_guard<std::mutex> lock(prefetch_state->m);
+                    auto r_it = prefetch_state->ready.find(key);
+                    if(r_it != std::end(prefetch_state->ready)){
+                        raster = std::move(r_it->second);
+                        prefetch_state->ready.erase(r_it);
+                    }
+                    // Any in-flight rasterization of this image is no longer useful.
+                    prefetch_state->pending.erase(key);
+                }
+                if(!raster){
+                    const auto disp = get_display_image(key);
+                    if(disp.first == nullptr){
+                        throw std::invalid_argument("Requested image does not exist. Cannot continue");
+                    }
+                    raster = Rasterize_Image(*(disp.first), active_raster_settings);
+                }
+                store_texture(key, Upload_OpenGL_Texture(raster.value()));
+                t_it = textures.find(key);
+            }
+            const auto out = t_it->second;
+
+            schedule_prefetch();
+            return out;
+    };
+
     // Advance to the specified Image_Array. Also resets necessary display image iterators.
     const auto advance_to_image_array = [&](const long int n){
             const long int N_arrays = DICOM_data.image_data.size();
@@ -489,6 +660,239 @@ Drover SDL_Viewer(Drover DICOM_data,
             return;
     };
 
+    // ------------------------------------------ Mesh rendering ------------------------------------------
+    // Meshes are uploaded to the GPU once per level of detail and retained, and transformed by a shader so the
+    // buffers never change. Coarser levels are generated in the background by repeatedly simplifying the mesh, each
+    // level having roughly a quarter of the edges of the previous one. Every frame draws the coarsest level that still
+    // provides about one triangle per few pixels of the mesh's projected footprint.
+    struct mesh_lod_t {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint ebo = 0;
+        long int N_vertices = 0;
+        long int N_triangles = 0;
+    };
+    struct mesh_lod_state_t {
+        std::mutex m;
+        bool cancelled = false;
+        std::map<long int, fv_surface_mesh<double, uint64_t>> ready; // Simplified meshes awaiting upload.
+    };
+    struct mesh_draw_cache_t {
+        std::shared_ptr<Surface_Mesh> mesh; // Retained so the key cannot be reused while cached.
+        vec3<double> bbox_min;
+        vec3<double> bbox_max;
+        std::map<long int, mesh_lod_t> levels; // Level 0 is the full mesh.
+        std::shared_ptr<mesh_lod_state_t> state;
+    };
+    std::map<const Surface_Mesh*, mesh_draw_cache_t> mesh_caches;
+    task_group mesh_lod_tasks;
+
+    const long int mesh_lod_max_levels = 5;
+    const long int mesh_lod_min_edges = 1000;
+    bool mesh_lod_automatic = true;
+    int mesh_lod_manual_level = 0;
+    float mesh_lod_pixels_per_triangle = 4.0f;
+
+    GLuint mesh_shader = 0;
+    GLint mesh_shader_rotation = -1;
+    GLint mesh_shader_colour = -1;
+    const auto Build_Mesh_Shader = [&]() -> void {
+            const char *vert_src = "#version 130\n"
+                                   "in vec3 v_pos;\n"
+                                   "uniform mat3 rotation;\n"
+                                   "void main(){ gl_Position = vec4(rotation * v_pos, 1.0); }\n";
+            const char *frag_src = "#version 130\n"
+                                   "uniform vec4 colour;\n"
+                                   "out vec4 frag_colour;\n"
+                                   "void main(){ frag_colour = colour; }\n";
+            const auto compile = [](GLenum type, const char *src) -> GLuint {
+                GLuint s = glCreateShader(type);
+                glShaderSource(s, 1, &src, nullptr);
+                glCompileShader(s);
+                GLint ok = GL_FALSE;
+                glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+                if(ok != GL_TRUE){
+                    std::array<char, 1024> log;
+                    glGetShaderInfoLog(s, static_cast<GLsizei>(log.size()), nullptr, log.data());
+                    glDeleteShader(s);
+                    throw std::runtime_error("Unable to compile mesh shader: "_s + std::string(log.data()));
+                }
+                return s;
+            };
+
+            const auto vert = compile(GL_VERTEX_SHADER, vert_src);
+            const auto frag = compile(GL_FRAGMENT_SHADER, frag_src);
+            mesh_shader = glCreateProgram();
+            glAttachShader(mesh_shader, vert);
+            glAttachShader(mesh_shader, frag);
+            glBindAttribLocation(mesh_shader, 0, "v_pos");
+            glLinkProgram(mesh_shader);
+            glDeleteShader(vert);
+            glDeleteShader(frag);
+
+            GLint ok = GL_FALSE;
+            glGetProgramiv(mesh_shader, GL_LINK_STATUS, &ok);
+            if(ok != GL_TRUE){
+                glDeleteProgram(mesh_shader);
+                mesh_shader = 0;
+                throw std::runtime_error("Unable to link mesh shader");
+            }
+            mesh_shader_rotation = glGetUniformLocation(mesh_shader, "rotation");
+            mesh_shader_colour = glGetUniformLocation(mesh_shader, "colour");
+            CHECK_FOR_GL_ERRORS();
+            return;
+    };
+
+    // Copy a mesh into GPU buffers, scaling each of x, y, and z to [-1/sqrt(2),+1/sqrt(2)] so the corners are not
+    // clipped when the bounding cube is rotated.
+    const auto Upload_Mesh_LOD = [&](const fv_surface_mesh<double, uint64_t> &mesh,
+                                     const vec3<double> &bbox_min,
+                                     const vec3<double> &bbox_max) -> mesh_lod_t {
+            mesh_lod_t out;
+            const auto scale = [](double v, double min, double max) -> float {
+                return static_cast<float>(0.707 * (2.0 * (v - min) / (max - min) - 1.0));
+            };
+
+            std::vector<float> vertices;
+            vertices.reserve(3 * mesh.vertices.size());
+            for(const auto& v : mesh.vertices){
+                vertices.push_back(scale(v.x, bbox_min.x, bbox_max.x));
+                vertices.push_back(scale(v.y, bbox_min.y, bbox_max.y));
+                vertices.push_back(scale(v.z, bbox_min.z, bbox_max.z));
+            }
+
+            std::vector<unsigned int> indices;
+            for(const auto& f : mesh.faces){
+                if(f.size() < 3) continue; // Ignore faces that cannot be broken into triangles.
+
+                const auto it_1 = std::cbegin(f);
+                const auto it_2 = std::next(it_1);
+                const auto end = std::end(f);
+                for(auto it_3 = std::next(it_2); it_3 != end; ++it_3){
+                    indices.push_back(static_cast<unsigned int>(*it_1));
+                    indices.push_back(static_cast<unsigned int>(*it_2));
+                    indices.push_back(static_cast<unsigned int>(*it_3));
+                }
+            }
+            out.N_vertices = static_cast<long int>(mesh.vertices.size());
+            out.N_triangles = static_cast<long int>(indices.size() / 3);
+
+            CHECK_FOR_GL_ERRORS();
+            glGenVertexArrays(1, &out.vao);
+            glGenBuffers(1, &out.vbo);
+            glGenBuffers(1, &out.ebo);
+
+            glBindVertexArray(out.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, out.vbo);
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat),
+                         static_cast<void*>(vertices.data()), GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, out.ebo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
+                         static_cast<void*>(indices.data()), GL_STATIC_DRAW);
+
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0); // Vertex positions, 3 floats per vertex.
+
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            CHECK_FOR_GL_ERRORS();
+            return out;
+    };
+
+    const auto Delete_Mesh_LOD = [](mesh_lod_t &lod) -> void {
+            glDeleteBuffers(1, &lod.ebo);
+            glDeleteBuffers(1, &lod.vbo);
+            glDeleteVertexArrays(1, &lod.vao);
+            lod = mesh_lod_t();
+            return;
+    };
+
+    // Provide the cached levels for the mesh, uploading the full mesh and scheduling simplification as needed.
+    // The returned reference remains valid until the cache is cleared.
+    const auto Load_Mesh_LODs = [&](const std::shared_ptr<Surface_Mesh> &smesh_ptr) -> mesh_draw_cache_t & {
+            auto c_it = mesh_caches.find(smesh_ptr.get());
+            if(c_it != std::end(mesh_caches)) return c_it->second;
+
+            auto &cache = mesh_caches[smesh_ptr.get()];
+            cache.mesh = smesh_ptr;
+            cache.state = std::make_shared<mesh_lod_state_t>();
+
+            const auto inf = std::numeric_limits<double>::infinity();
+            cache.bbox_min = vec3<double>( inf,  inf,  inf);
+            cache.bbox_max = vec3<double>(-inf, -inf, -inf);
+            for(const auto& v : smesh_ptr->meshes.vertices){
+                cache.bbox_min = vec3<double>( std::min(cache.bbox_min.x, v.x),
+                                               std::min(cache.bbox_min.y, v.y),
+                                               std::min(cache.bbox_min.z, v.z) );
+                cache.bbox_max = vec3<double>( std::max(cache.bbox_max.x, v.x),
+                                               std::max(cache.bbox_max.y, v.y),
+                                               std::max(cache.bbox_max.z, v.z) );
+            }
+            cache.levels[0] = Upload_Mesh_LOD(smesh_ptr->meshes, cache.bbox_min, cache.bbox_max);
+
+            // Every edge is shared by (at most) two faces.
+            long int N_edges = 0;
+            for(const auto& f : smesh_ptr->meshes.faces) N_edges += static_cast<long int>(f.size());
+            N_edges /= 2;
+            if(N_edges < 4 * mesh_lod_min_edges) return cache;
+
+            // Each level is simplified from the previous one, so the full mesh is only copied once.
+            mesh_lod_tasks.run([state = cache.state,
+                                smesh_ptr,
+                                N_edges,
+                                mesh_lod_max_levels,
+                                mesh_lod_min_edges]() -> void {
+                auto mesh = smesh_ptr->meshes;
+                auto edge_limit = N_edges;
+                for(long int level = 1; level < mesh_lod_max_levels; ++level){
+                    edge_limit /= 4;
+                    if(edge_limit < mesh_lod_min_edges) break;
+                    {
+                        std::lock_guard<std::mutex> lock(state->m);
+                        if(state->cancelled) return;
+                    }
+                    Simplify_Surface_Mesh(mesh, edge_limit);
+
+                    std::lock_guard<std::mutex> lock(state->m);
+                    state->ready[level] = mesh;
+                }
+            });
+            return cache;
+    };
+
+    // Upload at most one finished level per frame, since each upload copies an entire mesh.
+    const auto upload_simplified_meshes = [&]() -> void {
+            for(auto &c : mesh_caches){
+                fv_surface_mesh<double, uint64_t> mesh;
+                long int level = 0;
+                {
+                    std::lock_guard<std::mutex> lock(c.second.state->m);
+                    auto it = std::begin(c.second.state->ready);
+                    if(it == std::end(c.second.state->ready)) continue;
+                    level = it->first;
+                    mesh = std::move(it->second);
+                    c.second.state->ready.erase(it);
+                }
+                c.second.levels[level] = Upload_Mesh_LOD(mesh, c.second.bbox_min, c.second.bbox_max);
+                return;
+            }
+            return;
+    };
+
+    // Select a level for the mesh, given its footprint in pixels.
+    const auto select_mesh_lod = [&](const mesh_draw_cache_t &cache, double footprint) -> long int {
+            if(!mesh_lod_automatic){
+                // Use the nearest available level at or below the requested level.
+                auto it = cache.levels.upper_bound(static_cast<long int>(mesh_lod_manual_level));
+                return std::prev(it)->first;
+            }
+            const auto wanted = footprint / static_cast<double>(mesh_lod_pixels_per_triangle);
+            for(auto it = std::rbegin(cache.levels); it != std::rend(cache.levels); ++it){
+                if(wanted <= static_cast<double>(it->second.N_triangles)) return it->first;
+            }
+            return 0;
+    };
+
     // ------------------------------------------- Main loop ----------------------------------------------
 
     // Pre-load the first image.
@@ -496,9 +900,7 @@ Drover SDL_Viewer(Drover DICOM_data,
     if( DICOM_data.Has_Image_Data()
     &&  (0 <= img_array_num)
     &&  (0 <= img_num) ){
-        auto img_array_ptr_it = std::next(DICOM_data.image_data.begin(), img_array_num);
-        auto disp_img_it = std::next((*img_array_ptr_it)->imagecoll.images.begin(), img_num);
-        current_texture = Load_OpenGL_Texture(*disp_img_it);
+        current_texture = Load_OpenGL_Texture({ img_array_num, img_num });
     }
 
 long int frame_count = 0;
@@ -592,12 +994,12 @@ long int frame_count = 0;
                 advance_to_image_array(new_img_array_num);
                 img_array_ptr_it = std::next(DICOM_data.image_data.begin(), img_array_num);
                 disp_img_it = std::next((*img_array_ptr_it)->imagecoll.images.begin(), img_num);
-                current_texture = Load_OpenGL_Texture(*disp_img_it);
+                current_texture = Load_OpenGL_Texture({ img_array_num, img_num });
 
             }else if( new_img_num != img_num ){
                 advance_to_image(new_img_num);
                 disp_img_it = std::next((*img_array_ptr_it)->imagecoll.images.begin(), img_num);
-                current_texture = Load_OpenGL_Texture(*disp_img_it);
+                current_texture = Load_OpenGL_Texture({ img_array_num, img_num });
             }
 
             // Note: unhappy with this. Can cause feedback loop and flicker/jumpiness when resizing. Works OK for now
@@ -625,123 +1027,84 @@ long int frame_count = 0;
 
 // Tinkering with rendering surface meshes.
 if(DICOM_data.Has_Mesh_Data()){
-    auto smesh_ptr = DICOM_data.smesh_data.front();
-
-    const auto N_verts = smesh_ptr->meshes.vertices.size();
-
-    long int N_triangles = 0;
-    for(const auto& f : smesh_ptr->meshes.faces){
-        long int l_N_indices = f.size();
-        if(l_N_indices < 3) continue; // Ignore faces that cannot be broken into triangles.
-        N_triangles += (l_N_indices - 2);
+    auto &cache = Load_Mesh_LODs(DICOM_data.smesh_data.front());
+    if(mesh_shader == 0) Build_Mesh_Shader();
+
+    // The same slow tumble as always, applied by the shader. Columns are the images of the basis vectors.
+    std::array<float, 9> rotation;
+    std::array<vec3<double>, 3> basis = {{ vec3<double>(1.0, 0.0, 0.0),
+                                           vec3<double>(0.0, 1.0, 0.0),
+                                           vec3<double>(0.0, 0.0, 1.0) }};
+    for(size_t i = 0; i < basis.size(); ++i){
+        auto w = basis[i];
+        w = w.rotate_around_z(3.14159265 * static_cast<double>(frame_count / 59900.0));
+        w = w.rotate_around_y(3.14159265 * static_cast<double>(frame_count / 11000.0));
+        w = w.rotate_around_x(3.14159265 * static_cast<double>(frame_count / 26000.0));
+        basis[i] = w;
+        rotation[3 * i + 0] = static_cast<float>(w.x);
+        rotation[3 * i + 1] = static_cast<float>(w.y);
+        rotation[3 * i + 2] = static_cast<float>(w.z);
     }
 
+    // Estimate the mesh's footprint from the projection of its (rotated) bounding cube.
     const auto inf = std::numeric_limits<double>::infinity();
-    auto x_min = inf;
-    auto y_min = inf;
-    auto z_min = inf;
-    auto x_max = -inf;
-    auto y_max = -inf;
-    auto z_max = -inf;
-    for(const auto& v : smesh_ptr->meshes.vertices){
-        if(v.x < x_min) x_min = v.x;
-        if(v.y < y_min) y_min = v.y;
-        if(v.z < z_min) z_min = v.z;
-        if(x_max < v.x) x_max = v.x;
-        if(y_max < v.y) y_max = v.y;
-        if(z_max < v.z) z_max = v.z;
+    double x_min = inf, x_max = -inf, y_min = inf, y_max = -inf;
+    for(const auto sx : { -0.707, 0.707 }){
+        for(const auto sy : { -0.707, 0.707 }){
+            for(const auto sz : { -0.707, 0.707 }){
+                const auto p = basis[0] * sx + basis[1] * sy + basis[2] * sz;
+                x_min = std::min(x_min, p.x);
+                x_max = std::max(x_max, p.x);
+                y_min = std::min(y_min, p.y);
+                y_max = std::max(y_max, p.y);
+            }
+        }
     }
+    const auto footprint = 0.5 * (x_max - x_min) * static_cast<double>(io.DisplaySize.x)
+                         * 0.5 * (y_max - y_min) * static_cast<double>(io.DisplaySize.y);
+
+    const auto level = select_mesh_lod(cache, footprint);
+    const auto &lod = cache.levels.at(level);
 
     {
         ImGui::Begin("Meshes");
-        std::string msg = "Drawing "_s + std::to_string(N_verts) + " verts and "_s + std::to_string(N_triangles) + " triangles.";
+        std::string msg = "Drawing "_s + std::to_string(lod.N_vertices) + " verts and "_s
+                        + std::to_string(lod.N_triangles) + " triangles (level "_s + std::to_string(level) + ").";
         ImGui::Text(msg.c_str());
-        ImGui::End();
-    }
-
-    std::vector<float> vertices;
-    vertices.reserve(3 * N_verts);
-    for(const auto& v : smesh_ptr->meshes.vertices){
-        // Scale each of x, y, and z to [-1,+1], but shrink to [-1/sqrt(2),+1/sqrt(2)] to account for rotation.
-        // Scaling down will ensure the corners are not clipped when the cube is rotated.
-        vec3<double> w( 0.707 * (2.0 * (v.x - x_min) / (x_max - x_min) - 1.0),
-                        0.707 * (2.0 * (v.y - y_min) / (y_max - y_min) - 1.0),
-                        0.707 * (2.0 * (v.z - z_min) / (z_max - z_min) - 1.0) );
-
-        w = w.rotate_around_z(3.14159265 * static_cast<double>(frame_count / 59900.0));
-        w = w.rotate_around_y(3.14159265 * static_cast<double>(frame_count / 11000.0));
-        w = w.rotate_around_x(3.14159265 * static_cast<double>(frame_count / 26000.0));
-        vertices.push_back(static_cast<float>(w.x));
-        vertices.push_back(static_cast<float>(w.y));
-        vertices.push_back(static_cast<float>(w.z));
-    }
-    
-    std::vector<unsigned int> indices;
-    indices.reserve(3 * N_triangles);
-    for(const auto& f : smesh_ptr->meshes.faces){
-        long int l_N_indices = f.size();
-        if(l_N_indices < 3) continue; // Ignore faces that cannot be broken into triangles.
-
-        const auto it_1 = std::cbegin(f);
-        const auto it_2 = std::next(it_1);
-        const auto end = std::end(f);
-        for(auto it_3 = std::next(it_2); it_3 != end; ++it_3){
-            indices.push_back(static_cast<unsigned int>(*it_1));
-            indices.push_back(static_cast<unsigned int>(*it_2));
-            indices.push_back(static_cast<unsigned int>(*it_3));
+        msg = std::to_string(cache.levels.size()) + " level(s) of detail available."_s;
+        ImGui::Text(msg.c_str());
+        ImGui::Checkbox("Automatic detail", &mesh_lod_automatic);
+        if(mesh_lod_automatic){
+            ImGui::SliderFloat("Pixels per triangle", &mesh_lod_pixels_per_triangle, 0.5f, 64.0f, "%.1f");
+        }else{
+            ImGui::SliderInt("Detail level", &mesh_lod_manual_level, 0, static_cast<int>(mesh_lod_max_levels - 1));
         }
+        ImGui::End();
     }
 
-    GLuint vao = 0;
-    GLuint vbo = 0;
-    GLuint ebo = 0;
-
-    CHECK_FOR_GL_ERRORS();
-
-    glGenVertexArrays(1, &vao); // Create a VAO inside the OpenGL context.
-    glGenBuffers(1, &vbo); // Create a VBO inside the OpenGL context.
-    glGenBuffers(1, &ebo); // Create a EBO inside the OpenGL context.
-
-    glBindVertexArray(vao); // Bind = make it the currently-used object.
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-    CHECK_FOR_GL_ERRORS();
-
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), static_cast<void*>(vertices.data()), GL_STATIC_DRAW); // Copy vertex data.
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), static_cast<void*>(indices.data()), GL_STATIC_DRAW); // Copy index data.
-
-    CHECK_FOR_GL_ERRORS();
-
-    glEnableVertexAttribArray(0); // enable attribute with index 0.
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0); // Vertex positions, 3 floats per vertex, attrib index 0.
-
-    glBindVertexArray(0);
-    CHECK_FOR_GL_ERRORS();
-
-
     // Draw the mesh.
     CHECK_FOR_GL_ERRORS();
-    glBindVertexArray(vao); // Bind = make it the currently-used object.
+    glUseProgram(mesh_shader);
+    glUniformMatrix3fv(mesh_shader_rotation, 1, GL_FALSE, rotation.data());
+    glUniform4f(mesh_shader_colour, 1.0f, 1.0f, 1.0f, 1.0f);
+    glBindVertexArray(lod.vao);
 
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // Enable wireframe mode.
     CHECK_FOR_GL_ERRORS();
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0); // Draw using the current shader setup.
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * lod.N_triangles), GL_UNSIGNED_INT, 0);
     CHECK_FOR_GL_ERRORS();
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL); // Disable wireframe mode.
 
     glBindVertexArray(0);
-    CHECK_FOR_GL_ERRORS();
-
-    glDisableVertexAttribArray(0); // Free OpenGL resources.
-    glDisableVertexAttribArray(1);
-    glDeleteBuffers(1, &ebo);
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
+    glUseProgram(0);
     CHECK_FOR_GL_ERRORS();
 }
 
+        // Upload any simplified meshes and images prepared in the background, but not so many that the frame rate
+        // suffers.
+        upload_simplified_meshes();
+        upload_prefetched_textures(2);
+
         // Render the ImGui components and swap OpenGL buffers.
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -749,7 +1112,33 @@ if(DICOM_data.Has_Mesh_Data()){
         SDL_GL_SwapWindow(window);
     }
 
+    // Stop prefetching, since the image data is about to be returned.
+    {
+        std::lock_guard<std::mutex> lock(prefetch_state->m);
+        ++(prefetch_state->generation);
+        prefetch_state->pending.clear();
+    }
+    try{
+        prefetch_tasks.wait();
+    }catch(const std::exception &){}
+
+    // Stop simplifying meshes. A simplification already underway must finish, since it cannot be interrupted.
+    for(auto &c : mesh_caches){
+        std::lock_guard<std::mutex> lock(c.second.state->m);
+        c.second.state->cancelled = true;
+    }
+    try{
+        mesh_lod_tasks.wait();
+    }catch(const std::exception &){}
+
     // OpenGL and SDL cleanup.
+    for(auto &t : textures) glDeleteTextures(1, &t.second.texture_number);
+    textures.clear();
+    for(auto &c : mesh_caches){
+        for(auto &l : c.second.levels) Delete_Mesh_LOD(l.second);
+    }
+    mesh_caches.clear();
+    if(mesh_shader != 0) glDeleteProgram(mesh_shader);
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
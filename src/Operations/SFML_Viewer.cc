@@ -40,8 +40,6 @@
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
-#include "Explicator.h"
-
 #include "../Colour_Maps.h"
 #include "../Common_Boost_Serialization.h"
 #include "../Common_Plotting.h"
@@ -52,6 +50,7 @@
     #include "../KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_Common.h"
 #endif
 
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
@@ -117,7 +116,7 @@ Drover SFML_Viewer(Drover DICOM_data,
     const auto SingleScreenshot = std::regex_match(SingleScreenshotStr, TrueRegex);
     long int SingleScreenshotCounter = 3; // Used to count down frames before taking the snapshot.
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //Trim any empty image sets.
     for(auto it = DICOM_data.image_data.begin(); it != DICOM_data.image_data.end();  ){
@@ -171,6 +170,20 @@ Drover SFML_Viewer(Drover DICOM_data,
     contour_coll_shtl.contours.emplace_back();    //Prime the shuttle with an empty contour.
     contour_coll_shtl.contours.back().closed = true;
 
+    //The existing contours that are drawn on each image, cached so they need not be searched for on every frame.
+    // Vertices are stored as fractions of the image's (column, row) extent, so they can be mapped onto the display
+    // sprite with a transformation regardless of zoom or panning. Draw lists must be invalidated whenever the
+    // existing contours are altered.
+    struct contour_draw_list_t {
+        std::vector<std::reference_wrapper<contour_of_points<double>>> contours; // For hover tests.
+        std::vector<sf::Vertex> lines; // Pairs of vertices, one pair per contour segment.
+#if (SFML_VERSION_MAJOR > 2) || ((SFML_VERSION_MAJOR == 2) && (SFML_VERSION_MINOR >= 5))
+        sf::VertexBuffer buffer = sf::VertexBuffer(sf::Lines, sf::VertexBuffer::Static);
+        bool uploaded = false;
+#endif
+    };
+    std::map<const planar_image<float,double> *, contour_draw_list_t> contour_draw_lists;
+
     //Attempt to load fonts. We should try a few different files, and include a back-up somewhere accessible...
     sf::Font afont;
     if( !afont.loadFromFile("dcma_minimal.otf") // A minimal ASCII-only font.
@@ -298,6 +311,94 @@ Drover SFML_Viewer(Drover DICOM_data,
     };
     size_t colour_map = 0;
 
+    //If shaders are available, windowing and colour mapping are performed on the GPU. Pixel values are packed into the
+    // texture (as 24-bit fixed-point values spanning the image's range, with the alpha channel flagging non-finite
+    // values) and the colour maps are sampled from lookup textures, so changing the window/level or colour map only
+    // changes shader uniforms. Otherwise images are rasterized on the CPU whenever anything changes.
+    const long int colour_map_lut_size = 1024;
+    const std::string colour_mapping_shader_source = R"***(
+        uniform sampler2D texture;
+        uniform sampler2D lut;
+        uniform float lut_size;
+        uniform float enc_low;
+        uniform float enc_range;
+        uniform float win_low;
+        uniform float win_fullwidth;
+        uniform vec4 nan_colour;
+
+        void main(){
+            vec4 p = texture2D(texture, gl_TexCoord[0].xy);
+            if(p.a < 0.5){
+                gl_FragColor = nan_colour;
+                return;
+            }
+            float q = dot(floor(p.rgb * 255.0 + 0.5), vec3(65536.0, 256.0, 1.0)) / 16777215.0;
+            float val = enc_low + q * enc_range;
+            float x = clamp((val - win_low) / win_fullwidth, 0.0, 1.0);
+            gl_FragColor = texture2D(lut, vec2((x * (lut_size - 1.0) + 0.5) / lut_size, 0.5));
+        }
+    )***";
+
+    sf::Shader colour_mapping_shader;
+    std::vector<sf::Texture> colour_map_luts;
+    const bool use_gpu_colour_mapping = sf::Shader::isAvailable()
+                                     && colour_mapping_shader.loadFromMemory(colour_mapping_shader_source,
+                                                                             sf::Shader::Fragment);
+    if(use_gpu_colour_mapping){
+        colour_map_luts.resize(colour_maps.size());
+        for(size_t c = 0; c < colour_maps.size(); ++c){
+            sf::Image lut;
+            lut.create(colour_map_lut_size, 1);
+            for(long int i = 0; i < colour_map_lut_size; ++i){
+                const auto x = static_cast<double>(i) / static_cast<double>(colour_map_lut_size - 1);
+                const auto res = colour_maps[c].second(x);
+                const auto dest_type_max = static_cast<double>(std::numeric_limits<uint8_t>::max());
+                lut.setPixel(i, 0, sf::Color(static_cast<uint8_t>(std::floor(res.R * dest_type_max)),
+                                             static_cast<uint8_t>(std::floor(res.G * dest_type_max)),
+                                             static_cast<uint8_t>(std::floor(res.B * dest_type_max))));
+            }
+            if(!colour_map_luts[c].loadFromImage(lut)) FUNCERR("Unable to create colour map lookup texture");
+            colour_map_luts[c].setSmooth(true);
+        }
+        colour_mapping_shader.setUniform("texture", sf::Shader::CurrentTexture);
+        colour_mapping_shader.setUniform("lut_size", static_cast<float>(colour_map_lut_size));
+        colour_mapping_shader.setUniform("nan_colour", sf::Glsl::Vec4(NaN_Color));
+        FUNCINFO("Performing windowing and colour mapping on the GPU");
+    }
+
+    //The range of values packed into the current texture, needed to unpack them in the shader.
+    double packed_low = 0.0;
+    double packed_range = 1.0;
+
+    //Determines the window for an image, as (low, full width), using the same logic as CPU rasterization.
+    const auto select_window = [&](const disp_img_it_t &img_it) -> std::pair<double, double> {
+        if(custom_centre && custom_width){
+            return { custom_centre.value() - 0.5 * custom_width.value(), custom_width.value() };
+        }
+        auto img_win_valid = img_it->GetMetadataValueAs<std::string>("WindowValidFor");
+        auto img_desc      = img_it->GetMetadataValueAs<std::string>("Description");
+        auto img_win_c     = img_it->GetMetadataValueAs<double>("WindowCenter");
+        auto img_win_fw    = img_it->GetMetadataValueAs<double>("WindowWidth");
+        if( img_win_valid && img_desc && img_win_c
+        &&  img_win_fw && (img_win_valid.value() == img_desc.value()) ){
+            return { img_win_c.value() - 0.5 * img_win_fw.value(), img_win_fw.value() };
+        }
+        //Scale pixels to fill the maximum range.
+        return { packed_low, packed_range };
+    };
+
+    //Sets the shader uniforms for the current image, window/level, and colour map.
+    const auto update_colour_mapping_shader = [&](const disp_img_it_t &img_it) -> void {
+        const auto win = select_window(img_it);
+        const auto fullwidth = std::max(win.second, std::numeric_limits<double>::min());
+        colour_mapping_shader.setUniform("lut", colour_map_luts.at(colour_map));
+        colour_mapping_shader.setUniform("enc_low", static_cast<float>(packed_low));
+        colour_mapping_shader.setUniform("enc_range", static_cast<float>(packed_range));
+        colour_mapping_shader.setUniform("win_low", static_cast<float>(win.first));
+        colour_mapping_shader.setUniform("win_fullwidth", static_cast<float>(fullwidth));
+        return;
+    };
+
     const auto load_img_texture_sprite = [&](const disp_img_it_t &img_it, disp_img_texture_sprite_t &out) -> bool {
         //This routine returns a pair of (texture,sprite) because the texture must be kept around
         // for the duration of the sprite.
@@ -308,8 +409,50 @@ Drover SFML_Viewer(Drover DICOM_data,
             FUNCERR("Image dimensions are not reasonable. Is this a mistake? Refusing to continue");
         }
 
-        sf::Image animage;
-        animage.create(img_cols, img_rows);
+        if(use_gpu_colour_mapping){
+            auto lowest = std::numeric_limits<double>::infinity();
+            auto highest = -std::numeric_limits<double>::infinity();
+            for(auto j = 0; j < img_rows; ++j){
+                for(auto i = 0; i < img_cols; ++i){
+                    const auto val = static_cast<double>( img_it->value(j,i,0) );
+                    if(!std::isfinite(val)) continue;
+                    lowest = std::min(lowest, val);
+                    highest = std::max(highest, val);
+                }
+            }
+            packed_low = std::isfinite(lowest) ? lowest : 0.0;
+            packed_range = (std::isfinite(lowest) && (lowest < highest)) ? (highest - lowest) : 1.0;
+
+            const auto packed_max = static_cast<double>((1UL << 24) - 1);
+            std::vector<sf::Uint8> packed(static_cast<size_t>(img_cols) * img_rows * 4, 0);
+            auto p_it = std::begin(packed);
+            for(auto j = 0; j < img_rows; ++j){
+                for(auto i = 0; i < img_cols; ++i){
+                    const auto val = static_cast<double>( img_it->value(j,i,0) );
+                    if(std::isfinite(val)){
+                        const auto q = static_cast<uint32_t>(std::round((val - packed_low) / packed_range * packed_max));
+                        *(p_it++) = static_cast<sf::Uint8>((q >> 16) & 0xFF);
+                        *(p_it++) = static_cast<sf::Uint8>((q >> 8) & 0xFF);
+                        *(p_it++) = static_cast<sf::Uint8>(q & 0xFF);
+                        *(p_it++) = 255;
+                    }else{
+                        p_it += 4; // Zero alpha flags non-finite values.
+                    }
+                }
+            }
+
+            out.first = sf::Texture();
+            out.second = sf::Sprite();
+            if(!out.first.create(img_cols, img_rows)) FUNCERR("Unable to create empty SFML texture");
+            out.first.update(packed.data());
+            out.first.setSmooth(false); // Interpolating packed values would be meaningless.
+            out.second.setTexture(out.first);
+            {
+                const auto ImagePixelAspectRatio = img_it->pxl_dy / img_it->pxl_dx;
+                out.second.setScale(1.0f,ImagePixelAspectRatio);
+            }
+            return true;
+        }
 
         //------------------------------------------------------------------------------------------------
         //Apply a window to the data if it seems like the WindowCenter or WindowWidth specified in the image metadata
@@ -328,53 +471,17 @@ Drover SFML_Viewer(Drover DICOM_data,
                                             : (  img_win_valid && img_desc && img_win_c 
                                               && img_win_fw && (img_win_valid.value() == img_desc.value()));
 
+        // The range of pixel values mapped onto the colour map.
+        double low;
+        double high;
         if( UseCustomWL || UseImgWL ){
-            //Window/linear scaling transformation parameters.
-            //const auto win_r = 0.5*(win_fw.value() - 1.0); //The 'radius' of the range, or half width omitting the centre point.
-
             //The 'radius' of the range, or half width omitting the centre point.
             const auto win_r  = (UseCustomWL) ? 0.5*custom_win_fw.value()
                                               : 0.5*img_win_fw.value();
             const auto win_c  = (UseCustomWL) ? custom_win_c.value()
                                               : img_win_c.value();
-            const auto win_fw = (UseCustomWL) ? custom_win_fw.value()
-                                              : img_win_fw.value();
-
-            //The output range we are targeting. In this case, a commodity 8 bit (2^8 = 256 intensities) display.
-            const auto destmin = static_cast<double>( 0 );
-            const auto destmax = static_cast<double>( std::numeric_limits<uint8_t>::max() );
-    
-            for(auto i = 0; i < img_cols; ++i){
-                for(auto j = 0; j < img_rows; ++j){
-                    const auto val = static_cast<double>( img_it->value(j,i,0) ); //The first (R or gray) channel.
-                    if(!std::isfinite(val)){
-                        animage.setPixel(i,j,NaN_Color);
-                    }else{
-                        double x; // range = [0,1].
-                        if(val <= (win_c - win_r)){
-                            x = 0.0;
-                        }else if(val >= (win_c + win_r)){
-                            x = 1.0;
-                        }else{
-                            x = (val - (win_c - win_r)) / win_fw;
-                        }
-
-                        const auto res = colour_maps[colour_map].second(x);
-                        const double x_R = res.R;
-                        const double x_G = res.G;
-                        const double x_B = res.B;
-
-                        const double out_R = x_R * (destmax - destmin) + destmin;
-                        const double out_B = x_B * (destmax - destmin) + destmin;
-                        const double out_G = x_G * (destmax - destmin) + destmin;
-    
-                        const auto scaled_R = static_cast<uint8_t>( std::floor(out_R) );
-                        const auto scaled_G = static_cast<uint8_t>( std::floor(out_G) );
-                        const auto scaled_B = static_cast<uint8_t>( std::floor(out_B) );
-                        animage.setPixel(i,j,sf::Color(scaled_R,scaled_G,scaled_B));
-                    }
-                }
-            }
+            low  = win_c - win_r;
+            high = win_c + win_r;
 
         //------------------------------------------------------------------------------------------------
         //Scale pixels to fill the maximum range. None will be clipped or truncated.
@@ -383,58 +490,35 @@ Drover SFML_Viewer(Drover DICOM_data,
             // If you don't want to window you need to anticipate and ignore the gigantic numbers being 
             // you might encounter. This is not the place to do this! If you need to do it here, write a
             // filter routine and *call* it from here.
-            //
-            // NOTE: This routine could definitely use a re-working, especially to make it safe for all
-            //       arithmetical types (i.e., handling negatives, ensuring there is no overflow or wrap-
-            //       around, ensuring there is minimal precision loss).
-            using pixel_value_t = decltype(img_it->value(0, 0, 0));
             const auto pixel_minmax_allchnls = img_it->minmax();
-            const auto lowest = std::get<0>(pixel_minmax_allchnls);
-            const auto highest = std::get<1>(pixel_minmax_allchnls);
-
-            //const auto lowest = Stats::Percentile(img_it->data, 0.01);
-            //const auto highest = Stats::Percentile(img_it->data, 0.99);
-
-            const auto pixel_type_max = static_cast<double>(std::numeric_limits<pixel_value_t>::max());
-            const auto pixel_type_min = static_cast<double>(std::numeric_limits<pixel_value_t>::min());
-            const auto dest_type_max = static_cast<double>(std::numeric_limits<uint8_t>::max()); //Min is implicitly 0.
-
-            const double clamped_low  = static_cast<double>(lowest )/pixel_type_max;
-            const double clamped_high = static_cast<double>(highest)/pixel_type_max;
-    
-            for(auto i = 0; i < img_cols; ++i){ 
-                for(auto j = 0; j < img_rows; ++j){ 
-                    const auto val = img_it->value(j,i,0);
-                    if(!std::isfinite(val)){
-                        animage.setPixel(i,j,NaN_Color);
-                    }else{
-                        const double clamped_value = (static_cast<double>(val) - pixel_type_min)/(pixel_type_max - pixel_type_min);
-                        auto rescaled_value = (clamped_value - clamped_low)/(clamped_high - clamped_low);
-                        if( rescaled_value < 0.0 ){
-                            rescaled_value = 0.0;
-                        }else if( rescaled_value > 1.0 ){
-                            rescaled_value = 1.0;
-                        }
+            low  = static_cast<double>(std::get<0>(pixel_minmax_allchnls));
+            high = static_cast<double>(std::get<1>(pixel_minmax_allchnls));
 
-                        const auto res = colour_maps[colour_map].second(rescaled_value);
-                        const double x_R = res.R;
-                        const double x_G = res.G;
-                        const double x_B = res.B;
-                        
-                        const auto scaled_R = static_cast<uint8_t>(x_R * dest_type_max);
-                        const auto scaled_G = static_cast<uint8_t>(x_G * dest_type_max);
-                        const auto scaled_B = static_cast<uint8_t>(x_B * dest_type_max);
-                        animage.setPixel(i,j,sf::Color(scaled_R,scaled_G,scaled_B));
-                    }
-                }
+            //low = Stats::Percentile(img_it->data, 0.01);
+            //high = Stats::Percentile(img_it->data, 0.99);
+        }
+
+        // Colour the first (R or gray) channel, one row at a time, using the colour map's lookup table.
+        const auto lut = ColourMap_LUT(colour_maps[colour_map].second);
+        const std::array<uint8_t, 3> non_finite = {{ NaN_Color.r, NaN_Color.g, NaN_Color.b }};
+        const auto col_stride = (1 < img_cols) ? (img_it->index(0, 1, 0) - img_it->index(0, 0, 0)) : 1;
+        std::vector<uint8_t> rgb(3 * img_cols);
+        std::vector<sf::Uint8> rgba(4 * img_cols * img_rows, 255);
+        for(long int j = 0; j < img_rows; ++j){
+            lut->Apply_RGB8(img_it->data.data() + img_it->index(j, 0, 0), img_cols, col_stride,
+                            low, high, non_finite, rgb.data());
+            auto *row = rgba.data() + 4 * j * img_cols;
+            for(long int i = 0; i < img_cols; ++i){
+                row[4 * i + 0] = rgb[3 * i + 0];
+                row[4 * i + 1] = rgb[3 * i + 1];
+                row[4 * i + 2] = rgb[3 * i + 2];
             }
         }
-        
 
         out.first = sf::Texture();
         out.second = sf::Sprite();
         if(!out.first.create(img_cols, img_rows)) FUNCERR("Unable to create empty SFML texture");
-        if(!out.first.loadFromImage(animage)) FUNCERR("Unable to create SFML texture from planar_image");
+        out.first.update(rgba.data());
         //out.first.setSmooth(true);        
         out.first.setSmooth(false);        
         out.second.setTexture(out.first);
@@ -449,6 +533,12 @@ Drover SFML_Viewer(Drover DICOM_data,
         return true;
     };
 
+    //Re-colours the displayed image after the window/level or colour map changes.
+    const auto recolour_img_texture_sprite = [&]() -> bool {
+        if(use_gpu_colour_mapping) return true; // The shader uniforms are updated when drawing.
+        return load_img_texture_sprite(disp_img_it, disp_img_texture_sprite);
+    };
+
     //Scale the image to fill the available space.
     const auto scale_sprite_to_fill_screen = [](const sf::RenderWindow &awindow, 
                                                 const disp_img_it_t &img_it, 
@@ -710,7 +800,7 @@ Drover SFML_Viewer(Drover DICOM_data,
     const auto cycle_colour_maps_next = [&](){
             colour_map = (colour_map + 1) % colour_maps.size();
 
-            if(load_img_texture_sprite(disp_img_it, disp_img_texture_sprite)){
+            if(recolour_img_texture_sprite()){
                 scale_sprite_to_fill_screen(window,disp_img_it,disp_img_texture_sprite);
                 FUNCINFO("Reloaded texture using '" << colour_maps[colour_map].first << "' colour map");
             }else{
@@ -722,7 +812,7 @@ Drover SFML_Viewer(Drover DICOM_data,
     const auto cycle_colour_maps_prev = [&](){
             colour_map = (colour_map + colour_maps.size() - 1) % colour_maps.size();
 
-            if(load_img_texture_sprite(disp_img_it, disp_img_texture_sprite)){
+            if(recolour_img_texture_sprite()){
                 scale_sprite_to_fill_screen(window,disp_img_it,disp_img_texture_sprite);
                 FUNCINFO("Reloaded texture using '" << colour_maps[colour_map].first << "' colour map");
             }else{
@@ -1607,6 +1697,7 @@ Drover SFML_Viewer(Drover DICOM_data,
                 //Insert the contours into the Drover object.
                 DICOM_data.Ensure_Contour_Data_Allocated();
                 DICOM_data.contour_data->ccs.emplace_back(contour_coll_shtl);
+                contour_draw_lists.clear();
 
                 //Clear the data in preparation for the next contour collection.
                 contour_coll_shtl.contours.clear();
@@ -1678,7 +1769,7 @@ Drover SFML_Viewer(Drover DICOM_data,
                 custom_width.emplace(new_fullwidth);
                 custom_centre.emplace(new_centre);
 
-                if(load_img_texture_sprite(disp_img_it, disp_img_texture_sprite)){
+                if(recolour_img_texture_sprite()){
                     scale_sprite_to_fill_screen(window,disp_img_it,disp_img_texture_sprite);
                 }else{
                     FUNCERR("Unable to reload image after adjusting window/level");
@@ -1904,7 +1995,7 @@ Drover SFML_Viewer(Drover DICOM_data,
 
                 //Re-draw the image.
                 if(pressing_shift || pressing_control){
-                    if(load_img_texture_sprite(disp_img_it, disp_img_texture_sprite)){
+                    if(recolour_img_texture_sprite()){
                         scale_sprite_to_fill_screen(window,disp_img_it,disp_img_texture_sprite);
                     }else{
                         FUNCERR("Unable to reload image after adjusting window/level");
@@ -2135,7 +2226,12 @@ Drover SFML_Viewer(Drover DICOM_data,
         window.clear(sf::Color::Black);
         //window.draw(ashape);
 
-        window.draw(disp_img_texture_sprite.second);
+        if(use_gpu_colour_mapping){
+            update_colour_mapping_shader(disp_img_it);
+            window.draw(disp_img_texture_sprite.second, &colour_mapping_shader);
+        }else{
+            window.draw(disp_img_texture_sprite.second);
+        }
 
         BRcornertext.setString(BRcornertextss.str());
         BLcornertext.setString(BLcornertextss.str());
@@ -2214,22 +2310,35 @@ Drover SFML_Viewer(Drover DICOM_data,
             contourtext.setFillColor(sf::Color::Green);
             contourtext.setOutlineColor(sf::Color::Green);
 
-            for(auto & cc : DICOM_data.contour_data->ccs){
-                //auto base_ptr = reinterpret_cast<contour_collection<double> *>(&cc);
-                for(auto & c : cc.contours){
-                    if(!c.points.empty() 
-                    && ( 
-                          // Permit contours with any included vertices or at least the 'centre' within the image.
-                          ( disp_img_it->sandwiches_point_within_top_bottom_planes(c.Average_Point())
-                            || disp_img_it->encompasses_any_of_contour_of_points(c) )
-                          || 
-                          ( disp_img_it->pxl_dz <= std::numeric_limits<double>::min() ) // //Permit contours on purely 2D images.
-                       ) ){
-                        sf::VertexArray lines;
-                        lines.setPrimitiveType(sf::LinesStrip);
+            //Gather the contours that intersect the displayed image, if they have not already been gathered.
+            auto dl_it = contour_draw_lists.find(&*disp_img_it);
+            if(dl_it == contour_draw_lists.end()){
+                dl_it = contour_draw_lists.emplace(&*disp_img_it, contour_draw_list_t()).first;
+                auto &dl = dl_it->second;
+
+                //Get a DICOM-coordinate bounding box for the image.
+                const auto img_dicom_width = disp_img_it->pxl_dx * disp_img_it->rows;
+                const auto img_dicom_height = disp_img_it->pxl_dy * disp_img_it->columns; 
+                const auto img_top_left = disp_img_it->anchor + disp_img_it->offset
+                                        - disp_img_it->row_unit * disp_img_it->pxl_dx * 0.5f
+                                        - disp_img_it->col_unit * disp_img_it->pxl_dy * 0.5f;
+                const auto arb_pos_unit = disp_img_it->row_unit.Cross(disp_img_it->col_unit).unit();
+
+                for(auto & cc : DICOM_data.contour_data->ccs){
+                    for(auto & c : cc.contours){
+                        if(c.points.empty()
+                        || !( 
+                              // Permit contours with any included vertices or at least the 'centre' within the image.
+                              ( disp_img_it->sandwiches_point_within_top_bottom_planes(c.Average_Point())
+                                || disp_img_it->encompasses_any_of_contour_of_points(c) )
+                              || 
+                              ( disp_img_it->pxl_dz <= std::numeric_limits<double>::min() ) // //Permit contours on purely 2D images.
+                           ) ){
+                            continue;
+                        }
+                        dl.contours.emplace_back( std::ref(c) );
 
                         //Change colour depending on the orientation.
-                        const auto arb_pos_unit = disp_img_it->row_unit.Cross(disp_img_it->col_unit).unit();
                         vec3<double> c_orient;
                         try{ // Protect against degenerate contours. (Should we instead ignore them altogether?)
                             c_orient = c.Estimate_Planar_Normal();
@@ -2248,70 +2357,75 @@ Drover SFML_Viewer(Drover DICOM_data,
                             }
                         }
 
+                        //Map the vertices from DICOM coordinates to fractions of the image extent, using the top left
+                        // as zero, and close the contour.
+                        const auto first = dl.lines.size();
                         for(auto & p : c.points){
-                            //We have three distinct coordinate systems: DICOM, pixel coordinates and screen pixel coordinates,
-                            // and SFML 'world' coordinates. We need to map from the DICOM coordinates to screen pixel coords.
-
-                            //Get a DICOM-coordinate bounding box for the image.
-                            const auto img_dicom_width = disp_img_it->pxl_dx * disp_img_it->rows;
-                            const auto img_dicom_height = disp_img_it->pxl_dy * disp_img_it->columns; 
-                            const auto img_top_left = disp_img_it->anchor + disp_img_it->offset
-                                                    - disp_img_it->row_unit * disp_img_it->pxl_dx * 0.5f
-                                                    - disp_img_it->col_unit * disp_img_it->pxl_dy * 0.5f;
-                            const auto img_top_right = img_top_left + disp_img_it->row_unit * img_dicom_width;
-                            const auto img_bottom_left = img_top_left + disp_img_it->col_unit * img_dicom_height;
-                            
-                            //Clamp the point to the bounding box, using the top left as zero.
                             const auto dR = p - img_top_left;
                             const auto clamped_col = dR.Dot( disp_img_it->col_unit ) / img_dicom_height;
                             const auto clamped_row = dR.Dot( disp_img_it->row_unit ) / img_dicom_width;
-
-                            //Convert to SFML coordinates using the SFML bounding box for the display image.
-                            sf::FloatRect DispImgBBox = disp_img_texture_sprite.second.getGlobalBounds(); //Uses top left corner as (0,0).
-                            const auto world_x = DispImgBBox.left + DispImgBBox.width  * clamped_col;
-                            const auto world_y = DispImgBBox.top  + DispImgBBox.height * clamped_row;
-
-                            lines.append( sf::Vertex( sf::Vector2f(world_x, world_y), c_color ) );
-                        }
-                        if(lines.getVertexCount() != 0) lines.append( lines[0] );
-                        window.draw(lines);
-
-                        //Check if the mouse is within the contour. If so, display the name.
-                        const sf::Vector2i mouse_coords = sf::Mouse::getPosition(window);
-                        //--------------------
-                        sf::Vector2f mouse_world_pos = window.mapPixelToCoords(mouse_coords);
-                        sf::FloatRect DispImgBBox = disp_img_texture_sprite.second.getGlobalBounds();
-                        if(DispImgBBox.contains(mouse_world_pos)){
-                            //Assuming the image is not rotated or skewed (though possibly scaled), determine which image pixel
-                            // we are hovering over.
-
-                            //Get a DICOM-coordinate bounding box for the image.
-                            const auto img_dicom_width = disp_img_it->pxl_dx * disp_img_it->rows;
-                            const auto img_dicom_height = disp_img_it->pxl_dy * disp_img_it->columns; 
-                            const auto img_top_left = disp_img_it->anchor + disp_img_it->offset
-                                                    - disp_img_it->row_unit * disp_img_it->pxl_dx * 0.5f
-                                                    - disp_img_it->col_unit * disp_img_it->pxl_dy * 0.5f;
-                            const auto img_top_right = img_top_left + disp_img_it->row_unit * img_dicom_width;
-                            const auto img_bottom_left = img_top_left + disp_img_it->col_unit * img_dicom_height;
-
-                            const auto clamped_col_as_f = std::fabs(mouse_world_pos.x - DispImgBBox.left)/(DispImgBBox.width);
-                            const auto clamped_row_as_f = std::fabs(DispImgBBox.top - mouse_world_pos.y)/(DispImgBBox.height);
-
-                            const auto dicom_pos = img_top_left 
-                                                 + disp_img_it->row_unit * img_dicom_width  * clamped_row_as_f
-                                                 + disp_img_it->col_unit * img_dicom_height * clamped_col_as_f;
-
-                            const auto img_plane = disp_img_it->image_plane();
-                            if(c.Is_Point_In_Polygon_Projected_Orthogonally(img_plane,dicom_pos)){
-                                auto ROINameOpt = c.GetMetadataValueAs<std::string>("ROIName");
-                                auto NormROINameOpt = c.GetMetadataValueAs<std::string>("NormalizedROIName");
-                                contourtextss << (NormROINameOpt ? NormROINameOpt.value() : "???");
-                                contourtextss << " --- "; 
-                                contourtextss << (ROINameOpt ? ROINameOpt.value() : "???");
-                                contourtextss << std::endl; 
-                            }
-                        //--------------------
+                            const sf::Vertex v( sf::Vector2f(clamped_col, clamped_row), c_color );
+                            if(first != dl.lines.size()) dl.lines.push_back(v); // Ends the previous segment.
+                            dl.lines.push_back(v);
                         }
+                        dl.lines.push_back(dl.lines[first]);
+                    }
+                }
+            }
+            auto &dl = dl_it->second;
+
+            //Map the image extent onto the display sprite.
+            sf::FloatRect DispImgBBox = disp_img_texture_sprite.second.getGlobalBounds(); //Uses top left corner as (0,0).
+            sf::Transform extent_to_world;
+            extent_to_world.translate(DispImgBBox.left, DispImgBBox.top);
+            extent_to_world.scale(DispImgBBox.width, DispImgBBox.height);
+
+            if(!dl.lines.empty()){
+#if (SFML_VERSION_MAJOR > 2) || ((SFML_VERSION_MAJOR == 2) && (SFML_VERSION_MINOR >= 5))
+                if(!dl.uploaded && sf::VertexBuffer::isAvailable()){
+                    dl.uploaded = dl.buffer.create(dl.lines.size()) && dl.buffer.update(dl.lines.data());
+                }
+                if(dl.uploaded){
+                    window.draw(dl.buffer, extent_to_world);
+                }else{
+                    window.draw(dl.lines.data(), dl.lines.size(), sf::Lines, extent_to_world);
+                }
+#else
+                window.draw(dl.lines.data(), dl.lines.size(), sf::Lines, extent_to_world);
+#endif
+            }
+
+            //Check if the mouse is within any of the contours. If so, display the name.
+            const sf::Vector2i mouse_coords = sf::Mouse::getPosition(window);
+            sf::Vector2f mouse_world_pos = window.mapPixelToCoords(mouse_coords);
+            if(DispImgBBox.contains(mouse_world_pos)){
+                //Assuming the image is not rotated or skewed (though possibly scaled), determine which image pixel
+                // we are hovering over.
+
+                //Get a DICOM-coordinate bounding box for the image.
+                const auto img_dicom_width = disp_img_it->pxl_dx * disp_img_it->rows;
+                const auto img_dicom_height = disp_img_it->pxl_dy * disp_img_it->columns; 
+                const auto img_top_left = disp_img_it->anchor + disp_img_it->offset
+                                        - disp_img_it->row_unit * disp_img_it->pxl_dx * 0.5f
+                                        - disp_img_it->col_unit * disp_img_it->pxl_dy * 0.5f;
+
+                const auto clamped_col_as_f = std::fabs(mouse_world_pos.x - DispImgBBox.left)/(DispImgBBox.width);
+                const auto clamped_row_as_f = std::fabs(DispImgBBox.top - mouse_world_pos.y)/(DispImgBBox.height);
+
+                const auto dicom_pos = img_top_left 
+                                     + disp_img_it->row_unit * img_dicom_width  * clamped_row_as_f
+                                     + disp_img_it->col_unit * img_dicom_height * clamped_col_as_f;
+
+                const auto img_plane = disp_img_it->image_plane();
+                for(auto &c_refw : dl.contours){
+                    auto &c = c_refw.get();
+                    if(c.Is_Point_In_Polygon_Projected_Orthogonally(img_plane,dicom_pos)){
+                        auto ROINameOpt = c.GetMetadataValueAs<std::string>("ROIName");
+                        auto NormROINameOpt = c.GetMetadataValueAs<std::string>("NormalizedROIName");
+                        contourtextss << (NormROINameOpt ? NormROINameOpt.value() : "???");
+                        contourtextss << " --- "; 
+                        contourtextss << (ROINameOpt ? ROINameOpt.value() : "???");
+                        contourtextss << std::endl; 
                     }
                 }
             }
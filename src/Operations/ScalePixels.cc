@@ -17,6 +17,7 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Paged_Images.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
@@ -142,7 +143,13 @@ Drover ScalePixels(Drover DICOM_data,
     for(auto & iap_it : IAs){
         if((*iap_it)->imagecoll.images.empty()) continue;
 
-        PartitionedImageVoxelVisitorMutatorUserData ud;
+        // Scaling only needs the voxel value, so the span-based mutator is used to let the multiplication vectorize.
+        const auto f_scale = [ScaleFactor](float &val) -> void {
+            val *= ScaleFactor;
+        };
+        using ud_t = PartitionedImageVoxelSpanMutatorUserData<decltype(f_scale)>;
+        ud_t ud(f_scale);
+        ud.channel = Channel;
         ud.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
         ud.mutation_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
         ud.mutation_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
@@ -168,17 +175,15 @@ Drover ScalePixels(Drover DICOM_data,
             throw std::invalid_argument("Inclusivity argument '"_s + InclusivityStr + "' is not valid");
         }
 
-        ud.f_bounded = [&](long int, long int, long int chan, std::reference_wrapper<planar_image<float,double>>, float &val) {
-            if( (Channel < 0) || (Channel == chan) ){
-                val *= ScaleFactor;
-            }
-            return;
-        };
-
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
-            throw std::runtime_error("Unable to scale voxel values.");
+        if(auto store = (*iap_it)->get_page_store()){
+            //Paged-out images are streamed through one at a time, which is equivalent to grouping individual images.
+            Stream_Images(*store, [&](paged_image_store::image_list_t::iterator img_it) -> void {
+                if(!PartitionedImageVoxelSpanMutator<decltype(f_scale)>(img_it, { img_it }, {}, cc_ROIs, &ud)){
+                    throw std::runtime_error("Unable to scale voxel values.");
+                }
+            });
+        }else{
+            Mutate_Voxel_Spans_Balanced( (*iap_it)->imagecoll, cc_ROIs, ud );
         }
     }
 
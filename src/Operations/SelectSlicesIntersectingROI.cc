@@ -8,6 +8,7 @@
 #include <string>    
 
 #include "../Structs.h"
+#include "../Paged_Images.h"
 #include "../Regex_Selectors.h"
 #include "SelectSlicesIntersectingROI.h"
 #include "YgorImages.h"
@@ -70,8 +71,13 @@ Drover SelectSlicesIntersectingROI(Drover DICOM_data,
     };
 
     //Cycle over all images and dose arrays, trimming spurious images.
+    //Only the image geometry is needed, so paged-out (or not yet decoded) pixel data is not loaded.
     for(auto &img_arr : DICOM_data.image_data){
-        img_arr->imagecoll.Retain_Images_Satisfying( retain_encompassing_imgs );
+        if(auto store = img_arr->get_page_store()){
+            store->retain( retain_encompassing_imgs );
+        }else{
+            img_arr->imagecoll.Retain_Images_Satisfying( retain_encompassing_imgs );
+        }
     }
 
     return DICOM_data;
@@ -11,15 +11,15 @@
 #include <string>    
 #include <vector>
 
+#include "../Contour_Simplification.h"
 #include "../Insert_Contours.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 
 #include "YgorMath.h"         //Needed for vec3 class.
 
-#include "Explicator.h"
-
 #include "SimplifyContours.h"
 
 OperationDoc OpArgDocSimplifyContours(){
@@ -37,6 +37,9 @@ OperationDoc OpArgDocSimplifyContours(){
         "Simplification is generally performed most eagerly on regions with relatively low curvature."
         " Regions of high curvature are generally simplified only as necessary."
     );
+    out.notes.emplace_back(
+        "Contours are simplified in parallel."
+    );
 
 
     out.args.emplace_back();
@@ -84,10 +87,25 @@ OperationDoc OpArgDocSimplifyContours(){
                            " result in numerical imprecision.";
     out.args.back().default_val = "vert-collapse";
     out.args.back().expected = true;
-    out.args.back().examples = { "vertex-collapse", "vertex-removal" };
+    out.args.back().examples = { "vertex-collapse", "vertex-removal", "douglas-peucker", "visvalingam-whyatt" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
 
+    out.args.emplace_back();
+    out.args.back().name = "MaxDeviation";
+    out.args.back().desc = "The maximum distance (in DICOM units; mm) any original vertex may lie from the"
+                           " simplified contour. This only applies to the 'douglas-peucker' and"
+                           " 'visvalingam-whyatt' methods, which guarantee the bound and ignore the"
+                           " FractionalAreaTolerance."
+                           " 'Douglas-Peucker' recursively retains the vertex farthest from each simplified edge."
+                           " 'Visvalingam-Whyatt' repeatedly removes the vertex forming the smallest"
+                           " triangle with its neighbours, which tends to preserve the overall shape better"
+                           " for the same number of vertices, but only while the bound holds.";
+    out.args.back().default_val = "0.5";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.1", "0.5", "1.0", "2.0" };
+
+
     return out;
 }
 
@@ -96,20 +114,25 @@ Drover SimplifyContours(const Drover& DICOM_data,
                         const std::map<std::string, std::string>& /*InvocationMetadata*/,
                         const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
     const auto ROILabelRegex = OptArgs.getValueStr("ROILabelRegex").value();
     const auto FractionalAreaTolerance = std::stod( OptArgs.getValueStr("FractionalAreaTolerance").value() );
     const auto SimplificationMethod = OptArgs.getValueStr("SimplificationMethod").value();
+    const auto MaxDeviation = std::stod( OptArgs.getValueStr("MaxDeviation").value() );
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_vert_col = Compile_Regex("ve?r?t?e?x?-?co?l?l?a?p?s?e?");
     const auto regex_vert_rem = Compile_Regex("ve?r?t?e?x?-?re?m?o?v?a?l?");
+    const auto regex_doug_peu = Compile_Regex("do?u?g?l?a?s?-?p?e?u?c?k?e?r?");
+    const auto regex_visv_why = Compile_Regex("vi?s?v?a?l?i?n?g?a?m?-?w?h?y?a?t?t?");
 
     if( !std::regex_match(SimplificationMethod, regex_vert_col)
-    &&  !std::regex_match(SimplificationMethod, regex_vert_rem) ){
+    &&  !std::regex_match(SimplificationMethod, regex_vert_rem)
+    &&  !std::regex_match(SimplificationMethod, regex_doug_peu)
+    &&  !std::regex_match(SimplificationMethod, regex_visv_why) ){
         throw std::invalid_argument("SimplificationMethod selection is not valid. Cannot continue.");
     }
 
@@ -120,25 +143,38 @@ Drover SimplifyContours(const Drover& DICOM_data,
     auto cc_ROIs = Whitelist( cc_all, { { "ROIName", ROILabelRegex },
                                         { "NormalizedROIName", NormalizedROILabelRegex } } );
 
-    const bool AssumePlanar = true;
+    std::vector<std::reference_wrapper<contour_of_points<double>>> contours;
     for(auto &cc_refw : cc_ROIs){
-        for(auto &c : cc_refw.get().contours){
+        for(auto &c : cc_refw.get().contours) contours.emplace_back(std::ref(c));
+    }
+
+    if( std::regex_match(SimplificationMethod, regex_vert_col)
+    ||  std::regex_match(SimplificationMethod, regex_vert_rem) ){
+        const bool collapse = std::regex_match(SimplificationMethod, regex_vert_col);
+        const bool AssumePlanar = true;
+        parallel_for(0, static_cast<long int>(contours.size()), [&](long int i){
+            auto &c = contours[i].get();
             const auto A_orig = std::abs( c.Get_Signed_Area(AssumePlanar) );
             const auto A_tol = FractionalAreaTolerance * A_orig;
 
-            if( std::regex_match(SimplificationMethod, regex_vert_col) ){
+            if(collapse){
                 // Vertex collapse. Adjacent vertices are merged together.
                 c = c.Collapse_Vertices(A_tol);
 
-            }else if( std::regex_match(SimplificationMethod, regex_vert_rem) ){
+            }else{
                 // Vertex removal. No vertices are added.
                 c = c.Remove_Vertices(A_tol);
-
-            }else{
-                throw std::logic_error("SimplificationMethod options have been updated incompletely. Cannot continue.");
             }
+        });
+
+    }else if( std::regex_match(SimplificationMethod, regex_doug_peu) ){
+        Simplify_Contours(contours, MaxDeviation, ContourSimplificationMethod::DouglasPeucker);
+
+    }else if( std::regex_match(SimplificationMethod, regex_visv_why) ){
+        Simplify_Contours(contours, MaxDeviation, ContourSimplificationMethod::VisvalingamWhyatt);
 
-        }
+    }else{
+        throw std::logic_error("SimplificationMethod options have been updated incompletely. Cannot continue.");
     }
 
     return DICOM_data;
@@ -45,9 +45,16 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../Tracing.h"
 #include "../Dose_Meld.h"
 
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Rectilinear_Volume.h"
+#include "../YgorImages_Functors/Rectilinear_Volume_Ray_Caster.h"
+
+#ifdef DCMA_USE_SYCL
+    #include "../SYCL_Ray_Caster.h"
+#endif // DCMA_USE_SYCL
 
 #include "SimulateRadiograph.h"
 
@@ -88,7 +95,9 @@ OperationDoc OpArgDocSimulateRadiograph(){
     out.args.emplace_back();
     out.args.back().name = "Filename";
     out.args.back().desc = "The filename (or full path) to which the simulated image will be saved to."
-                           " The format is FITS. Leaving empty will result in a unique name being generated.";
+                           " The format is FITS. Leaving empty will result in a unique name being generated."
+                           " If multiple radiographs are simulated, a sequence number is inserted before the"
+                           " file extension.";
     out.args.back().default_val = "";
     out.args.back().expected = true;
     out.args.back().examples = { "", "./img.fits", "sim_radiograph.fits", "/tmp/out.fits" };
@@ -105,10 +114,38 @@ OperationDoc OpArgDocSimulateRadiograph(){
                            " coordinate system of a given image can be specified as 'relative(10.0, -23.4, 45.6)'."
                            " Relative offsets must be specified relative to the image centre."
                            " Note that DICOM units (i.e., mm) are used for all coordinates.";
+    out.args.back().desc += " Multiple source positions can be separated by semicolons, in which case one"
+                            " radiograph is simulated for each source position. All radiographs are simulated in a"
+                            " single pass and are collected into a single image array.";
     out.args.back().default_val = "relative(0.0, 1000.0, 20.0)";
     out.args.back().expected = true;
     out.args.back().examples = { "relative(0.0, 1610.0, 20.0)",
-                                 "absolute(-123.0, 123.0, 1.23)" };
+                                 "absolute(-123.0, 123.0, 1.23)",
+                                 "relative(0.0, 1000.0, 0.0); relative(1000.0, 0.0, 0.0)" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "ArcProjections";
+    out.args.back().desc = "The number of projections to simulate along an arc."
+                           " Each source position is rotated about the image centre, around an axis parallel to the"
+                           " image normal (i.e., the gantry axis for axial CT), in equal increments spanning"
+                           " ArcAngle degrees. A radiograph is simulated for every rotated source position."
+                           " This can be used to generate a library of digitally reconstructed radiographs, or to"
+                           " simulate a cone-beam CT acquisition."
+                           " Setting this parameter to 1 disables arc rotation.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "4", "90", "360" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "ArcAngle";
+    out.args.back().desc = "The angle (in degrees) spanned by arc projections. See ArcProjections for details."
+                           " If the arc spans a full rotation, the final projection is omitted since it would"
+                           " duplicate the first.";
+    out.args.back().default_val = "360.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "360.0", "180.0", "-45.0" };
 
 
     out.args.emplace_back();
@@ -190,6 +227,9 @@ Drover SimulateRadiograph(Drover DICOM_data,
 
     const auto SourcePositionStr = OptArgs.getValueStr("SourcePosition").value();
 
+    const auto ArcProjections = std::stol( OptArgs.getValueStr("ArcProjections").value() );
+    const auto ArcAngle = std::stod( OptArgs.getValueStr("ArcAngle").value() );
+
     const auto AttenuationScale = std::stod( OptArgs.getValueStr("AttenuationScale").value() );
 
     const auto ImageModelStr = OptArgs.getValueStr("ImageModel").value();
@@ -200,27 +240,34 @@ Drover SimulateRadiograph(Drover DICOM_data,
     //-----------------------------------------------------------------------------------------------------------------
     const auto Channel = 0;
 
-    const auto regex_rel = Compile_Regex("^re?l?a?t?i?v?e?.*$");
-    const auto regex_abs = Compile_Regex("^ab?s?o?l?u?t?e?.*$");
+    const auto regex_rel = Compile_Regex("^\\s*re?l?a?t?i?v?e?.*$");
+    const auto regex_abs = Compile_Regex("^\\s*ab?s?o?l?u?t?e?.*$");
 
     const auto regex_mudl = Compile_Regex("^at?t?e?n?u?a?t?i?o?n?[-_]?l?e?n?g?t?h?$");
     const auto regex_exp = Compile_Regex("^expo?n?e?n?t?i?a?l?$");
 
-    const bool spos_is_relative = std::regex_match(SourcePositionStr, regex_rel);
-    const bool spos_is_absolute = std::regex_match(SourcePositionStr, regex_abs);
-
     const bool imgmodel_is_mudl = std::regex_match(ImageModelStr, regex_mudl);
     const bool imgmodel_is_exp  = std::regex_match(ImageModelStr, regex_exp);
 
-    const vec3<double> vec3_nan( std::numeric_limits<double>::quiet_NaN(),
-                                 std::numeric_limits<double>::quiet_NaN(),
-                                 std::numeric_limits<double>::quiet_NaN() );
     //-----------------------------------------------------------------------------------------------------------------
     const auto machine_eps = std::sqrt( 10.0 * std::numeric_limits<double>::epsilon() );
 
-    vec3<double> source_position = vec3_nan;
-    {
-        auto split = SplitStringToVector(SourcePositionStr, '(', 'd');
+    if(ArcProjections < 1){
+        throw std::invalid_argument("At least one arc projection is required. Cannot continue.");
+    }
+    if(!std::isfinite(ArcAngle)){
+        throw std::invalid_argument("Arc angle is invalid. Cannot continue.");
+    }
+
+    struct source_spec_t {
+        vec3<double> position;
+        bool is_relative;
+    };
+    std::vector<source_spec_t> source_specs;
+    for(const auto &spec : SplitStringToVector(SourcePositionStr, ';', 'd')){
+        if(spec.find_first_not_of(" \t") == std::string::npos) continue;
+
+        auto split = SplitStringToVector(spec, '(', 'd');
         split = SplitVector(split, ')', 'd');
         split = SplitVector(split, ',', 'd');
 
@@ -232,13 +279,23 @@ Drover SimulateRadiograph(Drover DICOM_data,
            }catch(const std::exception &){ }
         }
         if(numbers.size() != 3){
-            throw std::invalid_argument("Unable to parse grid/cube shape parameters. Cannot continue.");
+            throw std::invalid_argument("Unable to parse source position parameters. Cannot continue.");
         }
 
-        source_position = vec3<double>( numbers.at(0),
-                                        numbers.at(1),
-                                        numbers.at(2) );
+        const vec3<double> source_position( numbers.at(0),
+                                            numbers.at(1),
+                                            numbers.at(2) );
         if(!source_position.isfinite()) throw std::invalid_argument("Source position invalid.");
+
+        const bool spos_is_relative = std::regex_match(spec, regex_rel);
+        const bool spos_is_absolute = std::regex_match(spec, regex_abs);
+        if(!spos_is_relative && !spos_is_absolute){
+            throw std::invalid_argument("Source position must be either relative or absolute. Cannot continue.");
+        }
+        source_specs.push_back( source_spec_t{ source_position, spos_is_relative } );
+    }
+    if(source_specs.empty()){
+        throw std::invalid_argument("No source positions provided. Cannot continue.");
     }
 
     auto IAs_all = All_IAs( DICOM_data );
@@ -279,70 +336,21 @@ Drover SimulateRadiograph(Drover DICOM_data,
         throw std::logic_error("Image array contained no images. Cannot continue.");
     }
 
-    const auto pxl_dx = img_arr_ptr->imagecoll.images.front().pxl_dx;
-    const auto pxl_dy = img_arr_ptr->imagecoll.images.front().pxl_dy;
-    const auto pxl_dz = img_arr_ptr->imagecoll.images.front().pxl_dz;
-    const auto pxl_diagonal_sq_length = (pxl_dx*pxl_dx + pxl_dy*pxl_dy + pxl_dz*pxl_dz);
-
-    const auto grid_zero = img_adj.index_to_image(0).get().position(0,0); // Centre of the (0,0,0) voxel.
-    const auto img_bps = img_adj.bounding_volume_planes;
-
-    const auto N_rows = static_cast<long int>(img_arr_ptr->imagecoll.images.front().rows);
-    const auto N_cols = static_cast<long int>(img_arr_ptr->imagecoll.images.front().columns);
-    const auto N_imgs = static_cast<long int>(img_adj.int_to_img.size());
-
-    // Determine an appropriate radiograph orientation.
-    const auto img_centre = img_arr_ptr->imagecoll.center(); // TODO: For TBI, should be at the t0 point (i.e., at the level of the lung).
-    auto ray_source = vec3_nan;
-    if(spos_is_relative){
-        ray_source = img_centre + source_position;  // Should be relative to voxel at (0,0,0), not image centre.
-    }else if(spos_is_absolute){
-        ray_source = source_position;
-    }else{
-        throw std::logic_error("Unknown option. Cannot continue.");
-    }
-    if(ray_source.distance(img_centre) < machine_eps){
-        throw std::invalid_argument("Ray source point cannot coincide with image centre. Refusing to continue.");
-    }
-    const line<double> source_centre_line(ray_source, img_centre); 
-
-    // Determine which way will be 'up' in the radiograph.
-    const auto ray_unit = (img_centre - ray_source).unit();
-    auto rg_up = img_unit;
-    auto rg_left = rg_up.Cross(ray_unit).unit();
-    if(!ray_unit.GramSchmidt_orthogonalize(rg_up, rg_left)){
-        throw std::invalid_argument("Cannot orthogonalize radiograph orientation unit vectors. Cannot continue.");
-    }
-    rg_up = rg_up.unit();
-    rg_left = rg_left.unit();
-
-    FUNCINFO("Proceeding with radiograph into-plane orientation unit vector: " << ray_unit);
-    FUNCINFO("Proceeding with radiograph leftward orientation unit vector: " << rg_left);
-    FUNCINFO("Proceeding with radiograph upward orientation unit vector: " << rg_up);
-    FUNCINFO("Proceeding with ray source at: " << ray_source);
-    FUNCINFO("Proceeding with image centre at: " << img_centre);
-    FUNCINFO("Proceeding with ray source - image centre line: " << source_centre_line);
-
-    // Confirm the bounding planes are all correctly oriented.
-    for(const auto & img_bp : img_bps){
-        if(!img_bp.Is_Point_Above_Plane(img_centre)){
-            throw std::logic_error("Bounding planes are not inward oriented. Refusing to continue.");
-            // Note: could just re-orient them here...
-        }
-    }
-    if(img_bps.size() != 6){
-        throw std::logic_error("Incorrect number of bounding planes provided. Cannot continue.");
+    // Pack the images into a contiguous volume, ordered along the image normal, for ray casting.
+    std::list<std::reference_wrapper<planar_image<float,double>>> ordered_imgs;
+    for(long int k = 0; k < static_cast<long int>(img_adj.int_to_img.size()); ++k){
+        ordered_imgs.push_back( img_adj.index_to_image(k) );
     }
-
-    // Pre-compute whether the ray source position is bounded within the image volume.
-    bool ray_source_is_within_image_volume = false;
-    {
-        long int N_bounds = 0;
-        for(const auto & img_bp : img_bps){
-            N_bounds += (img_bp.Is_Point_Above_Plane(ray_source)) ? 1L : 0L;
-        }
-        ray_source_is_within_image_volume = (N_bounds == 6);
+    const rectilinear_volume vol(ordered_imgs);
+    const rectilinear_volume_ray_caster ray_caster(vol, Channel);
+
+#ifdef DCMA_USE_SYCL
+    // Prefer a GPU, if one is available.
+    auto gpu_ray_caster = sycl_volume_ray_caster::create(vol, Channel);
+    if(gpu_ray_caster != nullptr){
+        FUNCINFO("Proceeding with GPU ray casting on device '" << gpu_ray_caster->device_name() << "'");
     }
+#endif // DCMA_USE_SYCL
 
     // Encode the image geometry as contours for volumetric bounds determination.
     contour_collection<double> cc;
@@ -358,272 +366,244 @@ Drover SimulateRadiograph(Drover DICOM_data,
     }
     std::list<std::reference_wrapper<contour_collection<double>>> cc_ROIs = { std::ref(cc) };
 
-    //------------------------
-    // Create a detector that will encompass the images.
-    //
-    // Note: We are generous here because the source is a single point. The image projection will therefore be
-    //       magnified. If the source is too close the projection will 
-    double grid_x_margin = 5.0;
-    double grid_y_margin = 5.0;
-    double grid_z_margin = 5.0;
-
-    //Generate a grid volume bounding the ROI(s). We ask for many images in order to compress the pxl_dz taken by each.
-    // Only two are actually allocated.
-    const auto NumberOfPanelImages = 1000L;
-    auto sd_image_collection = Symmetrically_Contiguously_Grid_Volume<float,double>(
-             cc_ROIs, 
-             grid_x_margin, grid_y_margin, grid_z_margin,
-             RadiographRows, RadiographColumns, /*number_of_channels=*/ 1, NumberOfPanelImages, 
-             source_centre_line, (rg_up * -1.0), rg_left,
-             /*pixel_fill=*/ 0.0, 
-             /*only_top_and_bottom=*/ true);
-
-    //Get handles for each image.
-    planar_image<float, double> *DetectImg = &(*std::next(sd_image_collection.images.begin(),0));
-    planar_image<float, double> *OrthoSrcImg = &(*std::next(sd_image_collection.images.begin(),1));
-
-    // Confirm the detector image is oriented correctly.
-    //
-    // Note: the detector will always be on the opposite side of the image centre compared with the source point
-    // (i.e., the source will always points towards the image centre).
-    {
-        const auto dICSP = img_centre - source_position;
-        const auto dDPIC = DetectImg->center() - img_centre;
-        if(dICSP.Dot(dDPIC) < 0.0){
-            std::swap(DetectImg, OrthoSrcImg);
+    // Enumerate the ray sources, rotating each along the arc (if requested).
+    const auto img_centre = img_arr_ptr->imagecoll.center(); // TODO: For TBI, should be at the t0 point (i.e., at the level of the lung).
+    const auto pi = std::acos(-1.0);
+    const bool arc_is_full_rotation = (std::abs(std::remainder(ArcAngle, 360.0)) < machine_eps)
+                                   && (machine_eps < std::abs(ArcAngle));
+    const auto arc_divisions = (ArcProjections == 1) ? 1L 
+                             : (arc_is_full_rotation ? ArcProjections : (ArcProjections - 1L));
+    const auto rotate_about_img_unit = [&](const vec3<double> &v, double angle) -> vec3<double> {
+        // Rodrigues' rotation formula.
+        const auto c = std::cos(angle);
+        const auto s = std::sin(angle);
+        return (v * c) + (img_unit.Cross(v) * s) + (img_unit * (img_unit.Dot(v) * (1.0 - c)));
+    };
+
+    std::vector<vec3<double>> ray_sources;
+    for(const auto &spec : source_specs){
+        const auto base_source = spec.is_relative ? (img_centre + spec.position) // Should be relative to voxel at (0,0,0), not image centre.
+                                                  : spec.position;
+        for(long int i = 0; i < ArcProjections; ++i){
+            const auto angle = (ArcAngle * pi / 180.0) * static_cast<double>(i) / static_cast<double>(arc_divisions);
+            const auto ray_source = img_centre + rotate_about_img_unit(base_source - img_centre, angle);
+            if(ray_source.distance(img_centre) < machine_eps){
+                throw std::invalid_argument("Ray source point cannot coincide with image centre. Refusing to continue.");
+            }
+            ray_sources.emplace_back(ray_source);
         }
     }
+    const auto N_projections = static_cast<long int>(ray_sources.size());
 
-    DetectImg->metadata["Description"] = "Virtual radiograph detector";
-    OrthoSrcImg->metadata["Description"] = "(unused)";
+    // Create a detector for each ray source.
+    //
+    // Detector geometry is cheap to generate, so all detectors are created up-front. All rays for all projections are
+    // then marched through the shared volume together.
+    std::list<planar_image_collection<float,double>> projection_collections;
+    std::vector<planar_image<float, double> *> detectors;
+    for(const auto &ray_source : ray_sources){
+        const line<double> source_centre_line(ray_source, img_centre); 
+
+        // Determine which way will be 'up' in the radiograph.
+        const auto ray_unit = (img_centre - ray_source).unit();
+        auto rg_up = img_unit;
+        auto rg_left = rg_up.Cross(ray_unit).unit();
+        if(!ray_unit.GramSchmidt_orthogonalize(rg_up, rg_left)){
+            throw std::invalid_argument("Cannot orthogonalize radiograph orientation unit vectors. Cannot continue.");
+        }
+        rg_up = rg_up.unit();
+        rg_left = rg_left.unit();
+
+        FUNCINFO("Proceeding with radiograph into-plane orientation unit vector: " << ray_unit);
+        FUNCINFO("Proceeding with radiograph leftward orientation unit vector: " << rg_left);
+        FUNCINFO("Proceeding with radiograph upward orientation unit vector: " << rg_up);
+        FUNCINFO("Proceeding with ray source at: " << ray_source);
+        FUNCINFO("Proceeding with image centre at: " << img_centre);
+        FUNCINFO("Proceeding with ray source - image centre line: " << source_centre_line);
+
+        //------------------------
+        // Create a detector that will encompass the images.
+        //
+        // Note: We are generous here because the source is a single point. The image projection will therefore be
+        //       magnified. If the source is too close the projection will 
+        double grid_x_margin = 5.0;
+        double grid_y_margin = 5.0;
+        double grid_z_margin = 5.0;
+
+        //Generate a grid volume bounding the ROI(s). We ask for many images in order to compress the pxl_dz taken by each.
+        // Only two are actually allocated.
+        const auto NumberOfPanelImages = 1000L;
+        projection_collections.emplace_back( Symmetrically_Contiguously_Grid_Volume<float,double>(
+                 cc_ROIs, 
+                 grid_x_margin, grid_y_margin, grid_z_margin,
+                 RadiographRows, RadiographColumns, /*number_of_channels=*/ 1, NumberOfPanelImages, 
+                 source_centre_line, (rg_up * -1.0), rg_left,
+                 /*pixel_fill=*/ 0.0, 
+                 /*only_top_and_bottom=*/ true) );
+        auto &sd_image_collection = projection_collections.back();
+
+        // Confirm the detector image is oriented correctly, and discard the other image.
+        //
+        // Note: the detector will always be on the opposite side of the image centre compared with the source point
+        // (i.e., the source will always points towards the image centre).
+        {
+            const auto dICSP = img_centre - ray_source;
+            const auto dDPIC = sd_image_collection.images.front().center() - img_centre;
+            if(dICSP.Dot(dDPIC) < 0.0){
+                sd_image_collection.images.pop_front();
+            }
+        }
+        sd_image_collection.images.resize(1);
 
-    const auto detector_plane = DetectImg->image_plane();
-    const auto orthosrc_plane = OrthoSrcImg->image_plane();
+        auto *DetectImg = &(sd_image_collection.images.front());
+        DetectImg->metadata["Description"] = "Virtual radiograph detector";
+        DetectImg->metadata["RadiographSourcePosition"] = ray_source.to_string();
+        detectors.push_back(DetectImg);
+    }
 
     //------------------------
     // March rays through the image data.
-    {
-        asio_thread_pool tp;
-        std::mutex printer; // Who gets to print to the console and iterate the counter.
-        long int completed = 0;
-
-        for(long int RadiographRow = 0; RadiographRow < RadiographRows; ++RadiographRow){
-            tp.submit_task([&,RadiographRow]() -> void {
+    //
+    // Each time the ray samples the CT number, the ray is simulated to have interacted with the medium for the length of
+    // the ray within the voxel.
+    //
+    // For purposes of simulating a radiograph, the remaining fractional ray intensity could be immediately reduced by
+    // multiplying by a factor of exp(-attenuation_coeff*dL). However, it is easier to sum all the attenuation_coeff*dL
+    // contributions and apply the reduction factor once at the end.
+    const auto attenuation_coeff = [](float voxel_val) -> float {
+        // Ficticious mass density encountered by the ray.
+        const auto intensity = (voxel_val < -1000.0f) ? -1000.0f : voxel_val; // Enforce physicality.
+        return 1.0f + (intensity / 1000.0f);
+    };
+
+    bool rays_marched = false;
+#ifdef DCMA_USE_SYCL
+    if(gpu_ray_caster != nullptr){
+        // The same transformation as attenuation_coeff, expressed in a form the device can evaluate.
+        sycl_volume_ray_caster::transform_t gpu_attenuation_coeff;
+        gpu_attenuation_coeff.lower  = -1000.0;
+        gpu_attenuation_coeff.scale  = 1.0 / 1000.0;
+        gpu_attenuation_coeff.offset = 1.0;
+
+        const long int N_rays = RadiographRows * RadiographColumns;
+        std::vector<vec3<double>> ray_termini;
+        std::vector<double> accumulated_attenuation_length_product(N_rays, 0.0);
+        for(long int p = 0; p < N_projections; ++p){
+            throw_if_cancelled();
+            auto *DetectImg = detectors[p];
+            ray_termini.clear();
+            ray_termini.reserve(N_rays);
+            for(long int RadiographRow = 0; RadiographRow < RadiographRows; ++RadiographRow){
                 for(long int RadiographCol = 0; RadiographCol < RadiographColumns; ++RadiographCol){
+                    ray_termini.emplace_back( DetectImg->position(RadiographRow, RadiographCol) );
+                }
+            }
 
-                    // Construct a line segment between the source and detector. 
-                    const auto ray_terminus = DetectImg->position(RadiographRow, RadiographCol);
-                    const auto ray_line = line<double>(ray_source, ray_terminus);
-
-                    // Find the intersection of the ray with the detector bounding planes.
-                    vec3<double> detector_panel_bp_intersection;
-                    if(!detector_plane.Intersects_With_Line_Once(ray_line, detector_panel_bp_intersection)){
-                        throw std::logic_error("Ray line does not intersect far image array bounding plane. Cannot continue.");
-                    }
-                    const auto ray_ls = line_segment<double>(ray_source, detector_panel_bp_intersection);
-
-                    // Find the intersections of the ray and the bounding box containing the images.
-                    std::vector<vec3<double>> bp_intersections;
-                    for(const auto & img_bp : img_bps){
-                        vec3<double> P;
-                        //if(img_bp.Intersects_With_Line_Once(ray_line, P)){
-                        if(img_bp.Intersects_With_Line_Segment_Once(ray_ls, P)){
-
-                            // Determine if the intersection point is on a face of the cube.
-                            const auto bp_centre = img_bp.Project_Onto_Plane_Orthogonally(img_centre);
-                            const auto dP = (P - bp_centre);
-                            const auto dP_row = std::abs(dP.Dot(row_unit));
-                            const auto dP_col = std::abs(dP.Dot(col_unit));
-                            const auto dP_img = std::abs(dP.Dot(img_unit));
-
-                            const auto max_row = (static_cast<double>(N_rows) * pxl_dx * 0.5);
-                            const auto max_col = (static_cast<double>(N_cols) * pxl_dy * 0.5);
-                            const auto max_img = (static_cast<double>(N_imgs) * pxl_dz * 0.5);
-
-                            if( (dP_row <= max_row)
-                            &&  (dP_col <= max_col)
-                            &&  (dP_img <= max_img) ){
-                                bp_intersections.emplace_back(P);
-                            }
-                        }
-                    }
+            gpu_ray_caster->integrate(ray_sources[p], ray_termini.data(), N_rays,
+                                      gpu_attenuation_coeff, accumulated_attenuation_length_product.data());
 
-                    // Explicitly add the ray source point if it is bounded within the image volume.
-                    if(ray_source_is_within_image_volume){
-                        bp_intersections.emplace_back(ray_source);
-                    }
-
-                    // Skip rays that do not intersect the image volume twice.
-                    if(bp_intersections.size() != 2){
-                        continue;
+            long int i = 0;
+            for(long int RadiographRow = 0; RadiographRow < RadiographRows; ++RadiographRow){
+                for(long int RadiographCol = 0; RadiographCol < RadiographColumns; ++RadiographCol, ++i){
+                    DetectImg->reference(RadiographRow, RadiographCol, 0)
+                        = static_cast<float>(accumulated_attenuation_length_product[i]);
+                }
+            }
+            FUNCINFO("Completed " << (p + 1) << " of " << N_projections << " projections");
+        }
+        rays_marched = true;
+    }
+#endif // DCMA_USE_SYCL
+
+    if(!rays_marched){
+        progress_tracker progress("SimulateRadiograph", N_projections * RadiographRows,
+                                  [](long int completed, long int total, double eta_s) -> void {
+            FUNCINFO("Completed " << completed << " of " << total
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done"
+                  << ", ~" << static_cast<long int>(eta_s) << " s remaining");
+        });
+        task_group tg;
+
+        for(long int p = 0; p < N_projections; ++p){
+            for(long int RadiographRow = 0; RadiographRow < RadiographRows; ++RadiographRow){
+                tg.run([&,p,RadiographRow]() -> void {
+                    DCMA_TRACE_ZONE("ray caster", "radiograph row");
+                    const auto &ray_source = ray_sources[p];
+                    auto *DetectImg = detectors[p];
+
+                    // Rays terminate at the centre of each detector pixel.
+                    std::vector<vec3<double>> ray_termini;
+                    ray_termini.reserve(RadiographColumns);
+                    for(long int RadiographCol = 0; RadiographCol < RadiographColumns; ++RadiographCol){
+                        ray_termini.emplace_back( DetectImg->position(RadiographRow, RadiographCol) );
                     }
 
-                    // Explicitly state the ray start and end positions using identified bounding-box intersection points.
-                    const vec3<double> ray_start = bp_intersections[0];
-                    const vec3<double> ray_end = bp_intersections[1];
-                    const auto ray_direction = (ray_end - ray_start).unit();
-                    const auto ray_total_sq_dist = ray_end.sq_dist(ray_start);
-
-                    // Determine whether moving from tail to head along the ray will increase or decrease the
-                    // row/col/img coordinates. Note that the direction will never change.
-                    const long int incr_row = (row_unit.Dot(ray_direction) < 0.0) ? -1L : 1L;
-                    const long int incr_col = (col_unit.Dot(ray_direction) < 0.0) ? -1L : 1L;
-                    const long int incr_img = (img_unit.Dot(ray_direction) < 0.0) ? -1L : 1L;
-
-                    // Determine the amount the ray will traverse due to incrementing i, j, or k individually.
-                    const auto true_ray_pos_dR_incr_row = ray_direction * (std::abs(row_unit.Dot(ray_direction)) * pxl_dx);
-                    const auto true_ray_pos_dR_incr_col = ray_direction * (std::abs(col_unit.Dot(ray_direction)) * pxl_dy);
-                    const auto true_ray_pos_dR_incr_img = ray_direction * (std::abs(img_unit.Dot(ray_direction)) * pxl_dz);
-
-                    const auto true_ray_pos_dR_incr_row_length = true_ray_pos_dR_incr_row.length();
-                    const auto true_ray_pos_dR_incr_col_length = true_ray_pos_dR_incr_col.length();
-                    const auto true_ray_pos_dR_incr_img_length = true_ray_pos_dR_incr_img.length();
-
-                    const auto blocky_ray_pos_dR_incr_row = row_unit * (pxl_dx * static_cast<double>(incr_row));
-                    const auto blocky_ray_pos_dR_incr_col = col_unit * (pxl_dy * static_cast<double>(incr_col));
-                    const auto blocky_ray_pos_dR_incr_img = img_unit * (pxl_dz * static_cast<double>(incr_img));
-
-                    // Determine the pseudo integer coordinates for the starting point.
-                    //
-                    // Note that these coordinates will not necessarily intersect any real voxels. They are defined only
-                    // by the (infinite) regular grid that coincides with the real voxels.
-                    const auto ray_start_grid_offset = ray_start - grid_zero;
-                    const auto ray_start_row_index = static_cast<long int>( std::round( ray_start_grid_offset.Dot(row_unit)/pxl_dx ) );
-                    const auto ray_start_col_index = static_cast<long int>( std::round( ray_start_grid_offset.Dot(col_unit)/pxl_dy ) );
-                    const auto ray_start_img_index = static_cast<long int>( std::round( ray_start_grid_offset.Dot(img_unit)/pxl_dz ) );
-
-                    long int ray_i = ray_start_row_index;
-                    long int ray_j = ray_start_col_index;
-                    long int ray_k = ray_start_img_index;
-
-                    vec3<double> true_ray_pos = ray_start;
-                    vec3<double> blocky_ray_pos = grid_zero + row_unit * (static_cast<double>(ray_i) * pxl_dx)
-                                                            + col_unit * (static_cast<double>(ray_j) * pxl_dy)
-                                                            + img_unit * (static_cast<double>(ray_k) * pxl_dz);
-
-                    const auto ray_start_side_of_terminus_plane = detector_plane.Is_Point_Above_Plane(ray_start);
-
-                    // Each time the ray samples the CT number, the ray is simulated to have interacted with the medium
-                    // for the length of the ray advancement.
-                    //
-                    // For purposes of simulating a radiograph, the remaining fractional ray intensity could be
-                    // immediately reduced by multiplying by a factor of exp(-attenuation_coeff*dL). However, it is
-                    // easier to sum all the attenuation_coeff*dL contributions and apply the reduction factor once at
-                    // the end.
-                    double accumulated_attenuation_length_product = 0.0;
-                    double last_move_dist = 0.0;
-
-                    while(true){
-                        // Test which single increment (either i, j, or k) remaing the closest to the ray line.
-                        const auto cand_pos_i = blocky_ray_pos + blocky_ray_pos_dR_incr_row;
-                        const auto cand_pos_j = blocky_ray_pos + blocky_ray_pos_dR_incr_col;
-                        const auto cand_pos_k = blocky_ray_pos + blocky_ray_pos_dR_incr_img;
-
-                        const auto cand_sq_dist_i = ray_line.Sq_Distance_To_Point( cand_pos_i );
-                        const auto cand_sq_dist_j = ray_line.Sq_Distance_To_Point( cand_pos_j );
-                        const auto cand_sq_dist_k = ray_line.Sq_Distance_To_Point( cand_pos_k );
-
-                        if( (cand_sq_dist_i <= cand_sq_dist_j) && (cand_sq_dist_i <= cand_sq_dist_k) ){
-                            blocky_ray_pos = cand_pos_i;
-                            true_ray_pos += true_ray_pos_dR_incr_row;
-                            last_move_dist = true_ray_pos_dR_incr_row_length;
-                            ray_i += incr_row;
-                        }else if( cand_sq_dist_j <= cand_sq_dist_k ){
-                            blocky_ray_pos = cand_pos_j;
-                            true_ray_pos += true_ray_pos_dR_incr_col;
-                            last_move_dist = true_ray_pos_dR_incr_col_length;
-                            ray_j += incr_col;
-                        }else{
-                            blocky_ray_pos = cand_pos_k;
-                            true_ray_pos += true_ray_pos_dR_incr_img;
-                            last_move_dist = true_ray_pos_dR_incr_img_length;
-                            ray_k += incr_img;
-                        }
-
-                        // Terminate if the geometry is invalid.
-                        if( pxl_diagonal_sq_length < true_ray_pos.sq_dist(blocky_ray_pos) ){
-                            throw std::runtime_error("Real ray position and blocky ray position differ by more than a voxel diagonal");
-                        }
-
-                        // Process the voxel.
-                        if( ( 0 <= ray_i ) && (ray_i < N_rows)
-                        &&  ( 0 <= ray_j ) && (ray_j < N_cols)
-                        &&  ( 0 <= ray_k ) && (ray_k < N_imgs) ){
-                            const auto intersecting_img_refw = img_adj.index_to_image(ray_k);
-                            const auto voxel_val = intersecting_img_refw.get().value(ray_i, ray_j, Channel);
-
-                            // Ficticious mass density encountered by the ray.
-                            const auto intensity = (voxel_val < -1000.0f) ? -1000.0f : voxel_val; // Enforce physicality.
-                            const auto attenuation_coeff = 1.0f + (intensity / 1000.0f); 
-
-                            accumulated_attenuation_length_product += attenuation_coeff * last_move_dist;
-                            
-                            // Could alternately invoke a more generic user function using (i,j,k) and the various ray
-                            // positions/distances here.
-
-                            //  ... TODO ...
-
-                        }
-
-                        // Terminate if the ray has traveled far enough.
-                        const auto ray_traveled_sq_dist = ray_start.sq_dist(true_ray_pos);
-                        if(ray_total_sq_dist <= ray_traveled_sq_dist){
-                            break;
-                        }
-                    }
+                    std::vector<double> accumulated_attenuation_length_product(RadiographColumns, 0.0);
+                    ray_caster.integrate(ray_source, ray_termini.data(), RadiographColumns,
+                                         attenuation_coeff, accumulated_attenuation_length_product.data());
 
                     //Record the result in the image.
-                    DetectImg->reference(RadiographRow, RadiographCol, 0) = static_cast<float>(accumulated_attenuation_length_product);
-                }
-
-                {
-                    // Report progress.
-                    std::lock_guard<std::mutex> lock(printer);
-                    ++completed;
-                    FUNCINFO("Completed " << completed << " of " << RadiographRows 
-                          << " --> " << static_cast<int>(1000.0*(completed)/RadiographRows)/10.0 << "% done");
-                }
-            });
+                    for(long int RadiographCol = 0; RadiographCol < RadiographColumns; ++RadiographCol){
+                        DetectImg->reference(RadiographRow, RadiographCol, 0)
+                            = static_cast<float>(accumulated_attenuation_length_product[RadiographCol]);
+                    }
 
+                    progress.advance();
+                });
+            }
         }
+        tg.wait();
     } // Complete tasks and terminate thread pool.
 
     //------------------------
 
-    // Post-process the image according to user criteria.
-    if(imgmodel_is_mudl){
-        // Do nothing -- no need to transform.
-
-    }else if(imgmodel_is_exp){
-        // Implement a generic radiograph image with exponential attenuation.
-        for(long int row = 0; row < RadiographRows; ++row){
-            for(long int col = 0; col < RadiographColumns; ++col){
-                const auto alp = DetectImg->reference(row, col, 0);
-                const auto att = 1.0 - std::exp(-alp * AttenuationScale);
-                DetectImg->reference(row, col, 0) = att;
+    DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>() );
+    auto pc_it = std::begin(projection_collections);
+    for(long int p = 0; p < N_projections; ++p, ++pc_it){
+        auto *DetectImg = detectors[p];
+
+        // Post-process the image according to user criteria.
+        if(imgmodel_is_mudl){
+            // Do nothing -- no need to transform.
+
+        }else if(imgmodel_is_exp){
+            // Implement a generic radiograph image with exponential attenuation.
+            for(long int row = 0; row < RadiographRows; ++row){
+                for(long int col = 0; col < RadiographColumns; ++col){
+                    const auto alp = DetectImg->reference(row, col, 0);
+                    const auto att = 1.0 - std::exp(-alp * AttenuationScale);
+                    DetectImg->reference(row, col, 0) = att;
+                }
             }
+
+        }else{
+            throw std::invalid_argument("Image model not understood. Unable to continue.");
         }
 
-    }else{
-        throw std::invalid_argument("Image model not understood. Unable to continue.");
-    }
+        // Save image maps to file.
+        std::string ProjectionFilename = FilenameStr;
+        if(ProjectionFilename.empty()){
+            ProjectionFilename = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_simulateradiograph_", 6, ".fits");
+        }else if(1 < N_projections){
+            const auto stem_end = ProjectionFilename.find_last_of('.');
+            const auto dir_end = ProjectionFilename.find_last_of('/');
+            const auto insert_at = ( (stem_end == std::string::npos)
+                                  || ((dir_end != std::string::npos) && (stem_end < dir_end)) )
+                                 ? ProjectionFilename.size() : stem_end;
+            std::stringstream ss;
+            ss << "_" << std::setw(6) << std::setfill('0') << p;
+            ProjectionFilename.insert(insert_at, ss.str());
+        }
 
-    // Save image maps to file.
-    if(FilenameStr.empty()){
-        FilenameStr = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_simulateradiograph_", 6, ".fits");
-    }
+        if(!WriteToFITS(*DetectImg, ProjectionFilename)){
+            throw std::runtime_error("Unable to write FITS file for simulated radiograph.");
+        }
 
-    if(!WriteToFITS(*DetectImg, FilenameStr)){
-        throw std::runtime_error("Unable to write FITS file for simulated radiograph.");
+        // Insert the image maps as images for later processing and/or viewing, if desired.
+        DICOM_data.image_data.back()->imagecoll.images.splice(
+            DICOM_data.image_data.back()->imagecoll.images.end(),
+            pc_it->images );
     }
 
-    // Insert the image maps as images for later processing and/or viewing, if desired.
-    *OrthoSrcImg = *DetectImg;
-    sd_image_collection.images.resize(1);
-
-    DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>() );
-    DICOM_data.image_data.back()->imagecoll = sd_image_collection;
-
     return DICOM_data;
 }
-
@@ -13,7 +13,9 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Paged_Images.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Blur.h"
 #include "SpatialBlur.h"
 #include "YgorImages.h"
@@ -35,10 +37,12 @@ OperationDoc OpArgDocSpatialBlur(){
     out.args.emplace_back();
     out.args.back().name = "Estimator";
     out.args.back().desc = "Controls the (in-plane) blur estimator to use."
-                      " Options are currently: box_3x3, box_5x5, gaussian_3x3, gaussian_5x5, and gaussian_open."
-                      " The latter (gaussian_open) is adaptive and requires a supplementary parameter that controls"
-                      " the number of adjacent pixels to consider. The former ('...3x3' and '...5x5') are 'fixed'"
-                      " estimators that use a convolution kernel with a fixed size (3x3 or 5x5 pixel neighbourhoods)."
+                      " Options are currently: box_3x3, box_5x5, gaussian_3x3, gaussian_5x5, gaussian_open, and"
+                      " box_open."
+                      " The latter (gaussian_open and box_open) are adaptive and require a supplementary parameter"
+                      " that controls the number of adjacent pixels to consider."
+                      " The former ('...3x3' and '...5x5') are 'fixed' estimators that use a convolution kernel"
+                      " with a fixed size (3x3 or 5x5 pixel neighbourhoods)."
                       " All estimators operate in 'pixel-space' and are ignorant about the image spatial extent."
                       " All estimators are normalized, and thus won't significantly affect the pixel magnitude scale.";
     out.args.back().default_val = "gaussian_open";
@@ -47,14 +51,15 @@ OperationDoc OpArgDocSpatialBlur(){
                             "box_5x5",
                             "gaussian_3x3",
                             "gaussian_5x5",
-                            "gaussian_open" };
+                            "gaussian_open",
+                            "box_open" };
 
     out.args.emplace_back();
     out.args.back().name = "GaussianOpenSigma";
     out.args.back().desc = "Controls the number of neighbours to consider (only) when using the gaussian_open estimator."
                       " The number of pixels is computed automatically to accommodate the specified sigma"
-                      " (currently ignored pixels have 3*sigma or less weighting). Be aware this operation can take"
-                      " an enormous amount of time, since the pixel neighbourhoods quickly grow large.";
+                      " (currently ignored pixels have 3*sigma or less weighting). Large sigmas are handled with"
+                      " recursive filters, so the runtime does not grow with the neighbourhood size.";
     out.args.back().default_val = "1.5";
     out.args.back().expected = true;
     out.args.back().examples = { "0.5",
@@ -63,6 +68,19 @@ OperationDoc OpArgDocSpatialBlur(){
                             "2.5",
                             "5.0" };
 
+    out.args.emplace_back();
+    out.args.back().name = "BoxOpenRadius";
+    out.args.back().desc = "Controls the number of neighbours to consider (only) when using the box_open estimator."
+                      " Pixels within this many rows and columns are averaged, i.e., the box is (2*radius + 1) pixels"
+                      " wide. Pixels outside the image and non-finite pixels are excluded from the average."
+                      " Summed-area tables are used, so the runtime does not grow with the box size.";
+    out.args.back().default_val = "2";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1",
+                            "2",
+                            "5",
+                            "25" };
+
     return out;
 }
 
@@ -75,6 +93,7 @@ Drover SpatialBlur(Drover DICOM_data,
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
     const auto EstimatorStr = OptArgs.getValueStr("Estimator").value();
     const auto GaussianOpenSigma = std::stod( OptArgs.getValueStr("GaussianOpenSigma").value() );
+    const auto BoxOpenRadius = std::stol( OptArgs.getValueStr("BoxOpenRadius").value() );
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_box3x3 = Compile_Regex("^bo?x?_?3x?3?$");
@@ -82,6 +101,7 @@ Drover SpatialBlur(Drover DICOM_data,
     const auto regex_gau3x3 = Compile_Regex("^ga?u?s?s?i?a?n?_?3x?3?$");
     const auto regex_gau5x5 = Compile_Regex("^ga?u?s?s?i?a?n?_?5x?5?$");
     const auto regex_gauopn = Compile_Regex("^ga?u?s?s?i?a?n?_?op?e?n?$");
+    const auto regex_boxopn = Compile_Regex("^bo?x?_?op?e?n?$");
 
 
     auto IAs_all = All_IAs( DICOM_data );
@@ -89,6 +109,7 @@ Drover SpatialBlur(Drover DICOM_data,
     for(auto & iap_it : IAs){
         InPlaneImageBlurUserData ud;
         ud.gaussian_sigma = GaussianOpenSigma;
+        ud.box_radius = BoxOpenRadius;
 
         if( std::regex_match(EstimatorStr, regex_box3x3) ){
             ud.estimator = BlurEstimator::box_3x3;
@@ -100,13 +121,22 @@ Drover SpatialBlur(Drover DICOM_data,
             ud.estimator = BlurEstimator::gaussian_5x5;
         }else if( std::regex_match(EstimatorStr, regex_gauopn) ){
             ud.estimator = BlurEstimator::gaussian_open;
+        }else if( std::regex_match(EstimatorStr, regex_boxopn) ){
+            ud.estimator = BlurEstimator::box_open;
         }else{
             throw std::invalid_argument("Estimator argument '"_s + EstimatorStr + "' is not valid");
         }
 
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          InPlaneImageBlur,
-                                                          {}, {}, &ud )){
+        if(auto store = (*iap_it)->get_page_store()){
+            //Paged-out images are streamed through one at a time, which is equivalent to grouping individual images.
+            Stream_Images(*store, [&](paged_image_store::image_list_t::iterator img_it) -> void {
+                if(!InPlaneImageBlur(img_it, { img_it }, {}, {}, &ud)){
+                    throw std::runtime_error("Unable to compute specified blur.");
+                }
+            });
+        }else if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                           InPlaneImageBlur,
+                                           {}, {}, &ud )){
             throw std::runtime_error("Unable to compute specified blur.");
         }
     }
@@ -14,6 +14,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/ImagePartialDerivative.h"
 #include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
 #include "SpatialDerivative.h"
@@ -156,9 +157,9 @@ Drover SpatialDerivative(Drover DICOM_data,
             throw std::invalid_argument("Method argument '"_s + MethodStr + "' is not valid");
         }
 
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          ImagePartialDerivative,
-                                                          {}, {}, &ud )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     ImagePartialDerivative,
+                                     {}, {}, &ud )){
             throw std::runtime_error("Unable to compute in-plane partial derivative.");
         }
     }
@@ -14,6 +14,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Sharpen.h"
 #include "SpatialSharpen.h"
 #include "YgorImages.h"
@@ -72,9 +73,9 @@ Drover SpatialSharpen(Drover DICOM_data,
             throw std::invalid_argument("Estimator argument '"_s + EstimatorStr + "' is not valid");
         }
 
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          InPlaneImageSharpen,
-                                                          {}, {}, &ud )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     InPlaneImageSharpen,
+                                     {}, {}, &ud )){
             throw std::runtime_error("Unable to compute specified sharpen estimator.");
         }
     }
@@ -1,10 +1,5 @@
 //SubdivideSurfaceMeshes.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
-#ifdef DCMA_USE_CGAL
-#else
-    #error "Attempted to compile without CGAL support, which is required."
-#endif
-
 #include <asio.hpp>
 #include <algorithm>
 #include <optional>
@@ -33,7 +28,10 @@
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 #include "YgorMathIOOFF.h"
 
-#include "../Surface_Meshes.h"
+#include "../Half_Edge_Mesh.h"
+#ifdef DCMA_USE_CGAL
+    #include "../Surface_Meshes.h"
+#endif // DCMA_USE_CGAL
 
 
 OperationDoc OpArgDocSubdivideSurfaceMeshes(){
@@ -45,7 +43,8 @@ OperationDoc OpArgDocSubdivideSurfaceMeshes(){
         " the specified criteria, replacing the original meshes with subdivided copies.";
         
     out.notes.emplace_back(
-        "Selected surface meshes should represent polyhedra."
+        "Selected surface meshes should be orientable and every edge should be shared by at most two faces."
+        " Polygonal faces are triangulated. The 'cgal' method also requires meshes to represent polyhedra."
     );
 
     out.args.emplace_back();
@@ -61,6 +60,19 @@ OperationDoc OpArgDocSubdivideSurfaceMeshes(){
     out.args.back().expected = true;
     out.args.back().examples = { "1", "2", "5" };
 
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "The implementation to use."
+                           " The 'native' method performs Loop subdivision directly on the mesh, using the"
+                           " boundary rules along boundaries."
+                           " The 'cgal' method uses CGAL's Loop subdivision."
+                           " The 'cgal' method is only available when built with CGAL support.";
+    out.args.back().default_val = "native";
+    out.args.back().expected = true;
+    out.args.back().examples = { "native", "cgal" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -74,9 +86,22 @@ Drover SubdivideSurfaceMeshes(Drover DICOM_data,
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto MeshSelectionStr = OptArgs.getValueStr("MeshSelection").value();
     const auto MeshIterations = std::stol( OptArgs.getValueStr("Iterations").value() );
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
 
     //-----------------------------------------------------------------------------------------------------------------
 
+    const auto regex_native = Compile_Regex("^na?t?i?v?e?$");
+    const auto regex_cgal = Compile_Regex("^cg?a?l?$");
+    const bool use_native = std::regex_match(MethodStr, regex_native);
+    if(!use_native && !std::regex_match(MethodStr, regex_cgal)){
+        throw std::invalid_argument("Method not understood. Cannot continue.");
+    }
+#ifndef DCMA_USE_CGAL
+    if(!use_native){
+        throw std::invalid_argument("The 'cgal' method requires CGAL support. Cannot continue.");
+    }
+#endif // DCMA_USE_CGAL
+
 
     auto SMs_all = All_SMs( DICOM_data );
     auto SMs = Whitelist( SMs_all, MeshSelectionStr );
@@ -87,37 +112,47 @@ Drover SubdivideSurfaceMeshes(Drover DICOM_data,
 
         const auto orig_metadata = (*smp_it)->meshes.metadata;
 
-        // Convert to a CGAL mesh.
-        std::stringstream ss_i;
-        if(!WriteFVSMeshToOFF( (*smp_it)->meshes, ss_i )){
-            throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
-        }
-
-        dcma_surface_meshes::Polyhedron surface_mesh;
-        if(!( ss_i >> surface_mesh )){
-            throw std::runtime_error("Mesh could not be treated as a polyhedron. (Is it manifold?)");
-        }
-
-        // Simplify.
-        polyhedron_processing::Subdivide(surface_mesh, MeshIterations);
-
-        // Convert back from CGAL mesh.
-        std::stringstream ss_o;
-        if(!( ss_o << surface_mesh )){
-            throw std::runtime_error("Simplified mesh could not be treated as a polyhedron. (Is it manifold?)");
-        }
-
-        (*smp_it)->meshes.vertices.clear();
-        (*smp_it)->meshes.faces.clear();
-        (*smp_it)->meshes.involved_faces.clear();
-        (*smp_it)->meshes.metadata.clear();
-
-        if(!ReadFVSMeshFromOFF( (*smp_it)->meshes, ss_o )){
-            throw std::runtime_error("Unable to read mesh in OFF format. Cannot continue.");
+        if(use_native){
+            Loop_Subdivide( (*smp_it)->meshes, MeshIterations );
+        }else{
+#ifdef DCMA_USE_CGAL
+            // Convert to a CGAL mesh.
+            std::stringstream ss_i;
+            if(!WriteFVSMeshToOFF( (*smp_it)->meshes, ss_i )){
+                throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
+            }
+
+            dcma_surface_meshes::Polyhedron surface_mesh;
+            if(!( ss_i >> surface_mesh )){
+                throw std::runtime_error("Mesh could not be treated as a polyhedron. (Is it manifold?)");
+            }
+
+            // Simplify.
+            polyhedron_processing::Subdivide(surface_mesh, MeshIterations);
+
+            // Convert back from CGAL mesh.
+            std::stringstream ss_o;
+            if(!( ss_o << surface_mesh )){
+                throw std::runtime_error("Simplified mesh could not be treated as a polyhedron. (Is it manifold?)");
+            }
+
+            (*smp_it)->meshes.vertices.clear();
+            (*smp_it)->meshes.faces.clear();
+            (*smp_it)->meshes.involved_faces.clear();
+            (*smp_it)->meshes.metadata.clear();
+
+            if(!ReadFVSMeshFromOFF( (*smp_it)->meshes, ss_o )){
+                throw std::runtime_error("Unable to read mesh in OFF format. Cannot continue.");
+            }
+#endif // DCMA_USE_CGAL
         }
 
         (*smp_it)->meshes.metadata = orig_metadata;
 
+        // Vertices and faces have been renumbered, so per-element attributes no longer apply.
+        (*smp_it)->vertex_attributes.clear();
+        (*smp_it)->face_attributes.clear();
+
         ++completed;
         FUNCINFO("Completed " << completed << " of " << sm_count
               << " --> " << static_cast<int>(1000.0*(completed)/sm_count)/10.0 << "% done");
@@ -13,10 +13,11 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Contour_Subsegmentation.h"
 #include "../Dose_Meld.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "SubsegmentContours.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -256,7 +257,7 @@ Drover SubsegmentContours(const Drover& DICOM_data,
                  << ZSelectionLower << " and " << ZSelectionUpper << " respectively");
     }
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
 
     // Stuff references to all contours into a list. Remember that you can still address specific contours through
@@ -301,138 +302,58 @@ Drover SubsegmentContours(const Drover& DICOM_data,
         throw std::invalid_argument("Planar orientations not understood. Cannot continue.");
     }
 
-    // This routine returns a pair of planes that approximately encompass the desired interior volume. The ROIs are not
-    // altered. The lower plane is the first element of the pair. This routine can be applied to any contour_collection
-    // and the planes can also be applied to any contour_collection.
-    const auto bisect_ROIs = [FractionalTolerance,MaxBisects](
-                                 const contour_collection<double> &ROIs,
-                                 const vec3<double> &planar_normal,
-                                 double SelectionLower,
-                                 double SelectionUpper) -> 
-                                     std::pair<plane<double>, plane<double>> {
-
-        if(ROIs.contours.empty()) throw std::logic_error("Unable to split empty contour collection.");
-        size_t iters_taken = 0;
-        double final_area_frac = 0.0;
-
-        //Find the lower plane.
-        plane<double> lower_plane;
-        ROIs.Total_Area_Bisection_Along_Plane(planar_normal,
-                                                      SelectionLower,
-                                                      FractionalTolerance,
-                                                      MaxBisects,
-                                                      &lower_plane,
-                                                      &iters_taken,
-                                                      &final_area_frac);
-        FUNCINFO("Bisection: planar area fraction"
-                 << " above LOWER plane with normal: " << planar_normal
-                 << " was " << final_area_frac << "."
-                 << " Requested: " << SelectionLower << "."
-                 << " Iters: " << iters_taken);
-
-        //Find the upper plane.
-        plane<double> upper_plane;
-        ROIs.Total_Area_Bisection_Along_Plane(planar_normal,
-                                                      SelectionUpper,
-                                                      FractionalTolerance,
-                                                      MaxBisects,
-                                                      &upper_plane,
-                                                      &iters_taken,
-                                                      &final_area_frac);
-        FUNCINFO("Bisection: planar area fraction"
-                 << " above UPPER plane with normal: " << planar_normal
-                 << " was " << final_area_frac << "."
-                 << " Requested: " << SelectionUpper << "."
-                 << " Iters: " << iters_taken);
-
-        return std::make_pair(lower_plane, upper_plane);
-    };
-
-    const auto subsegment_interior = [](const contour_collection<double> &ROIs,
-                                        const std::pair<plane<double>, plane<double>> &planes) ->
-                                            contour_collection<double> {
-        const plane<double> lower_plane(planes.first);
-        const plane<double> upper_plane(planes.second);
-
-        //Implements the sub-segmentation, selecting only the interior portion.
-        auto split1 = ROIs.Split_Along_Plane(lower_plane);
-        if(split1.size() != 2){
-            throw std::logic_error("Expected exactly two groups, above and below plane.");
-        }
-        auto split2 = split1.back().Split_Along_Plane(upper_plane);
-        if(split2.size() != 2){
-            throw std::logic_error("Expected exactly two groups, above and below plane.");
-        }
-
-        if(false) for(auto & it : split2){ it.Plot(); }
-
-        const contour_collection<double> cc_selection( split2.front() );
-        if( cc_selection.contours.empty() ){
-            FUNCWARN("Selection contains no contours. Try adjusting your criteria.");
-        }
-        return cc_selection;
-    };
-
     // Perform the sub-segmentation.
-    std::list<contour_collection<double>> cc_selection;
-    for(const auto &cc_ref : cc_ROIs){
-        if(cc_ref.get().contours.empty()) continue;
-
-        // ---------------------------------- Compound sub-segmentation --------------------------------------
-        //Generate all planes using the original contour_collection before sub-segmenting.
-        //
-        // NOTE: This method results in sub-segments of different volumes depending on the location within the ROI.
-        //       Do not use this method unless you know what you're doing.
-        if( std::regex_match(SubsegMethodReq,SubsegMethodCompound) ){
-            const auto x_planes_pair = bisect_ROIs(cc_ref.get(), x_normal, XSelectionLower, XSelectionUpper);
-            const auto y_planes_pair = bisect_ROIs(cc_ref.get(), y_normal, YSelectionLower, YSelectionUpper);
-            const auto z_planes_pair = bisect_ROIs(cc_ref.get(), z_normal, ZSelectionLower, ZSelectionUpper);
-
-            //Perform the sub-segmentation.
-            contour_collection<double> running(cc_ref.get());
-            running = subsegment_interior(running, x_planes_pair);
-            running = subsegment_interior(running, y_planes_pair);
-            running = subsegment_interior(running, z_planes_pair);
-            cc_selection.emplace_back(running);
-
-        // ----------------------------------- Nested sub-segmentation ---------------------------------------
-        // Instead of relying on whole-organ sub-segmentation, attempt to fairly partition the *remaining* volume 
-        // at each pair of cleaves.
-        //
-        // NOTE: This method will generate sub-segments with equal volumes (as best possible given the number of slices
-        //       if the plane orientations are aligned with the contour planes) and should be preferred over compound
-        //       sub-segmentation in almost all cases. It should be faster too.
-        }else if( std::regex_match(SubsegMethodReq,SubsegMethodNested) ){
-            contour_collection<double> running(cc_ref.get());
-
-            for(const auto &cleave : NestedCleaveOrder){
-                if( (cleave == static_cast<unsigned char>('X'))
-                      ||  (cleave == static_cast<unsigned char>('x')) ){
-                    const auto x_planes_pair = bisect_ROIs(running, x_normal, XSelectionLower, XSelectionUpper);
-                    running = subsegment_interior(running, x_planes_pair);
-
-                }else if( (cleave == static_cast<unsigned char>('Y'))
-                      ||  (cleave == static_cast<unsigned char>('y')) ){
-                    const auto y_planes_pair = bisect_ROIs(running, y_normal, YSelectionLower, YSelectionUpper);
-                    running = subsegment_interior(running, y_planes_pair);
-
-                }else if( (cleave == static_cast<unsigned char>('Z'))
-                      ||  (cleave == static_cast<unsigned char>('z')) ){
-                    const auto z_planes_pair = bisect_ROIs(running, z_normal, ZSelectionLower, ZSelectionUpper);
-                    running = subsegment_interior(running, z_planes_pair);
-
-                }else{
-                    throw std::invalid_argument("Cleave axis '"_s + cleave + "' not understood. Cannot continue.");
-                }
+    subsegment_opts opts;
+    opts.fractional_tolerance = FractionalTolerance;
+    opts.max_bisects = MaxBisects;
+    const subsegment_cleave x_cleave{ x_normal, XSelectionLower, XSelectionUpper };
+    const subsegment_cleave y_cleave{ y_normal, YSelectionLower, YSelectionUpper };
+    const subsegment_cleave z_cleave{ z_normal, ZSelectionLower, ZSelectionUpper };
+
+    // ---------------------------------- Compound sub-segmentation --------------------------------------
+    //Generate all planes using the original contour_collection before sub-segmenting.
+    //
+    // NOTE: This method results in sub-segments of different volumes depending on the location within the ROI.
+    //       Do not use this method unless you know what you're doing.
+    if( std::regex_match(SubsegMethodReq,SubsegMethodCompound) ){
+        opts.nested = false;
+        opts.cleaves = { x_cleave, y_cleave, z_cleave };
+
+    // ----------------------------------- Nested sub-segmentation ---------------------------------------
+    // Instead of relying on whole-organ sub-segmentation, attempt to fairly partition the *remaining* volume 
+    // at each pair of cleaves.
+    //
+    // NOTE: This method will generate sub-segments with equal volumes (as best possible given the number of slices
+    //       if the plane orientations are aligned with the contour planes) and should be preferred over compound
+    //       sub-segmentation in almost all cases. It should be faster too.
+    }else if( std::regex_match(SubsegMethodReq,SubsegMethodNested) ){
+        opts.nested = true;
+        for(const auto &cleave : NestedCleaveOrder){
+            if( (cleave == static_cast<unsigned char>('X'))
+            ||  (cleave == static_cast<unsigned char>('x')) ){
+                opts.cleaves.push_back(x_cleave);
+
+            }else if( (cleave == static_cast<unsigned char>('Y'))
+                  ||  (cleave == static_cast<unsigned char>('y')) ){
+                opts.cleaves.push_back(y_cleave);
+
+            }else if( (cleave == static_cast<unsigned char>('Z'))
+                  ||  (cleave == static_cast<unsigned char>('z')) ){
+                opts.cleaves.push_back(z_cleave);
+
+            }else{
+                throw std::invalid_argument("Cleave axis '"_s + cleave + "' not understood. Cannot continue.");
             }
-
-            cc_selection.emplace_back(running);
-
-        }else{
-            throw std::invalid_argument("Subsegmentation method not understood. Cannot continue.");
         }
+
+    }else{
+        throw std::invalid_argument("Subsegmentation method not understood. Cannot continue.");
     }
 
+    // ROIs are sub-segmented in parallel.
+    std::list<contour_collection<double>> cc_selection;
+    for(auto &cc : Subsegment_ROIs(cc_ROIs, opts)) cc_selection.emplace_back(std::move(cc));
+
     //Generate references.
     decltype(cc_ROIs) final_selected_ROI_refs;
     for(auto &cc : cc_selection) final_selected_ROI_refs.push_back( std::ref(cc) );
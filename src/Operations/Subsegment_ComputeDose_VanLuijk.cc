@@ -20,11 +20,12 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Contour_Subsegmentation.h"
 #include "../Dose_Meld.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "Subsegment_ComputeDose_VanLuijk.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
@@ -54,6 +55,21 @@ OperationDoc OpArgDocSubsegment_ComputeDose_VanLuijk(){
     out.args.back().mimetype = "text/csv";
 
 
+    out.args.emplace_back();
+    out.args.back().name = "DoseAccumulation";
+    out.args.back().desc = "The method used to select the voxels within each sub-segment."
+                      " 'Mask' rasterizes each original ROI once and selects the voxels whose centres lie between"
+                      " the cleaving planes, so the dose within every sub-segment is accumulated in a single pass."
+                      " Sub-segment contours are then only generated when they are needed for area data or retained"
+                      " sub-segments. Overlapping contours within an ROI are counted once."
+                      " 'Contours' clips the ROI contours with the cleaving planes and tests every voxel against each"
+                      " clipped contour individually.";
+    out.args.back().default_val = "Mask";
+    out.args.back().expected = true;
+    out.args.back().examples = { "Mask", "Contours" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+
     out.args.emplace_back();
     out.args.back().name = "DerivativeDataFileName";
     out.args.back().desc = "A filename (or full path) in which to append derivative data generated by this routine."
@@ -225,6 +241,7 @@ Drover Subsegment_ComputeDose_VanLuijk(Drover DICOM_data,
     auto AreaDataFileName = OptArgs.getValueStr("AreaDataFileName").value();
     auto DerivativeDataFileName = OptArgs.getValueStr("DerivativeDataFileName").value();
     auto DistributionDataFileName = OptArgs.getValueStr("DistributionDataFileName").value();
+    const auto DoseAccumulationStr = OptArgs.getValueStr("DoseAccumulation").value();
     const auto PlanarOrientation = OptArgs.getValueStr("PlanarOrientation").value();
     const auto ReplaceAllWithSubsegmentStr = OptArgs.getValueStr("ReplaceAllWithSubsegment").value();
     const auto RetainSubsegment = OptArgs.getValueStr("RetainSubsegment").value();
@@ -245,11 +262,19 @@ Drover Subsegment_ComputeDose_VanLuijk(Drover DICOM_data,
     const auto SubsegMethodCompound = Compile_Regex("Compound");
     const auto SubsegMethodNested = Compile_Regex("Nested");
 
+    const auto DoseAccumMask = Compile_Regex("^ma?s?k?$");
+    const auto DoseAccumContours = Compile_Regex("^co?n?t?o?u?r?s?$");
+
     const auto OrientAxisAligned = Compile_Regex("AxisAligned");
     const auto OrientStaticObl = Compile_Regex("StaticOblique");
 
     const auto ReplaceAllWithSubsegment = std::regex_match(ReplaceAllWithSubsegmentStr, TrueRegex);
 
+    const bool UseMask = std::regex_match(DoseAccumulationStr, DoseAccumMask);
+    if(!UseMask && !std::regex_match(DoseAccumulationStr, DoseAccumContours)){
+        throw std::invalid_argument("Dose accumulation method not understood. Cannot continue.");
+    }
+
     const auto XSelectionTokens = SplitStringToVector(XSelectionStr, ';', 'd');
     const auto YSelectionTokens = SplitStringToVector(YSelectionStr, ';', 'd');
     const auto ZSelectionTokens = SplitStringToVector(ZSelectionStr, ';', 'd');
@@ -283,10 +308,10 @@ Drover Subsegment_ComputeDose_VanLuijk(Drover DICOM_data,
                  << ZSelectionLower << " and " << ZSelectionUpper << " respectively");
     }
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //Merge the dose arrays if multiple are available.
-    DICOM_data = Meld_Only_Dose_Data(DICOM_data);
+    DICOM_data = Meld_Only_Dose_Data(std::move(DICOM_data));
 
     //Gather only dose images.
     auto IAs_all = All_IAs( DICOM_data );
@@ -360,123 +385,52 @@ Drover Subsegment_ComputeDose_VanLuijk(Drover DICOM_data,
         throw std::invalid_argument("Planar orientations not understood. Cannot continue.");
     }
 
-    //This routine returns a pair of planes that approximately encompass the desired interior volume. The ROIs are not
-    // altered. The lower plane is the first element of the pair. This routine can be applied to any contour_collection
-    // and the planes can also be applied to any contour_collection.
-    const auto bisect_ROIs = [FractionalTolerance,MaxBisects](
-                                 const contour_collection<double> &ROIs,
-                                 const vec3<double> &planar_normal,
-                                 double SelectionLower,
-                                 double SelectionUpper) -> 
-                                     std::pair<plane<double>, plane<double>> {
-
-        if(ROIs.contours.empty()) throw std::logic_error("Unable to split empty contour collection.");
-        size_t iters_taken = 0;
-        double final_area_frac = 0.0;
-
-        //Find the lower plane.
-        plane<double> lower_plane;
-        ROIs.Total_Area_Bisection_Along_Plane(planar_normal,
-                                                      SelectionLower,
-                                                      FractionalTolerance,
-                                                      MaxBisects,
-                                                      &lower_plane,
-                                                      &iters_taken,
-                                                      &final_area_frac);
-        FUNCINFO("Bisection: planar area fraction"
-                 << " above LOWER plane with normal: " << planar_normal
-                 << " was " << final_area_frac << "."
-                 << " Requested: " << SelectionLower << "."
-                 << " Iters: " << iters_taken);
-
-        //Find the upper plane.
-        plane<double> upper_plane;
-        ROIs.Total_Area_Bisection_Along_Plane(planar_normal,
-                                                      SelectionUpper,
-                                                      FractionalTolerance,
-                                                      MaxBisects,
-                                                      &upper_plane,
-                                                      &iters_taken,
-                                                      &final_area_frac);
-        FUNCINFO("Bisection: planar area fraction"
-                 << " above UPPER plane with normal: " << planar_normal
-                 << " was " << final_area_frac << "."
-                 << " Requested: " << SelectionUpper << "."
-                 << " Iters: " << iters_taken);
-
-        return std::make_pair(lower_plane, upper_plane);
-    };
-
-    const auto subsegment_interior = [](const contour_collection<double> &ROIs,
-                                        const std::pair<plane<double>, plane<double>> &planes) ->
-                                            contour_collection<double> {
-        const plane<double> lower_plane(planes.first);
-        const plane<double> upper_plane(planes.second);
-
-        //Implements the sub-segmentation, selecting only the interior portion.
-        auto split1 = ROIs.Split_Along_Plane(lower_plane);
-        if(split1.size() != 2){
-            throw std::logic_error("Expected exactly two groups, above and below plane.");
-        }
-        auto split2 = split1.back().Split_Along_Plane(upper_plane);
-        if(split2.size() != 2){
-            throw std::logic_error("Expected exactly two groups, above and below plane.");
-        }
+    //Perform the sub-segmentation.
+    subsegment_opts opts;
+    opts.fractional_tolerance = FractionalTolerance;
+    opts.max_bisects = MaxBisects;
+    const subsegment_cleave x_cleave{ x_normal, XSelectionLower, XSelectionUpper };
+    const subsegment_cleave y_cleave{ y_normal, YSelectionLower, YSelectionUpper };
+    const subsegment_cleave z_cleave{ z_normal, ZSelectionLower, ZSelectionUpper };
+
+    // ---------------------------------- Compound sub-segmentation --------------------------------------
+    //Generate all planes using the original contour_collection before sub-segmenting.
+    //
+    // NOTE: This method results in sub-segments of different volumes depending on the location within the ROI.
+    //       Do not use this method unless you know what you're doing.
+    if( std::regex_match(SubsegMethodReq,SubsegMethodCompound) ){
+        opts.nested = false;
+        opts.cleaves = { x_cleave, y_cleave, z_cleave };
+
+    // ----------------------------------- Nested sub-segmentation ---------------------------------------
+    // Instead of relying on whole-organ sub-segmentation, attempt to fairly partition the *remaining* volume 
+    // at each pair of cleaves.
+    //
+    // NOTE: This method will generate sub-segments with equal volumes (as best possible given the number of slices
+    //       if the plane orientations are aligned with the contour planes) and should be preferred over compound
+    //       sub-segmentation in almost all cases. It should be faster too.
+    }else if( std::regex_match(SubsegMethodReq,SubsegMethodNested) ){
+        opts.nested = true;
+        opts.cleaves = { z_cleave, x_cleave, y_cleave };
 
-        if(false) for(auto & it : split2){ it.Plot(); }
+    }else{
+        throw std::invalid_argument("Subsegmentation method not understood. Cannot continue.");
+    }
 
-        const contour_collection<double> cc_selection( split2.front() );
-        if( cc_selection.contours.empty() ){
-            FUNCWARN("Selection contains no contours. Try adjusting your criteria.");
-        }
-        return cc_selection;
-    };
+    // ROIs are sub-segmented in parallel. Sub-segment contours are only needed when dose is accumulated within them,
+    // or when they are reported or retained.
+    const bool need_contours = !UseMask
+                            || !AreaDataFileName.empty()
+                            || !RetainSubsegment.empty()
+                            || ReplaceAllWithSubsegment;
+    auto bounds = Subsegment_ROI_Bounds(cc_ROIs, opts, need_contours);
 
-    //Perform the sub-segmentation.
     std::list<contour_collection<double>> cc_selection;
-    for(const auto &cc_ref : cc_ROIs){
-        if(cc_ref.get().contours.empty()) continue;
-
-        // ---------------------------------- Compound sub-segmentation --------------------------------------
-        //Generate all planes using the original contour_collection before sub-segmenting.
-        //
-        // NOTE: This method results in sub-segments of different volumes depending on the location within the ROI.
-        //       Do not use this method unless you know what you're doing.
-        if( std::regex_match(SubsegMethodReq,SubsegMethodCompound) ){
-            const auto x_planes_pair = bisect_ROIs(cc_ref.get(), x_normal, XSelectionLower, XSelectionUpper);
-            const auto y_planes_pair = bisect_ROIs(cc_ref.get(), y_normal, YSelectionLower, YSelectionUpper);
-            const auto z_planes_pair = bisect_ROIs(cc_ref.get(), z_normal, ZSelectionLower, ZSelectionUpper);
-
-            //Perform the sub-segmentation.
-            contour_collection<double> running(cc_ref.get());
-            running = subsegment_interior(running, x_planes_pair);
-            running = subsegment_interior(running, y_planes_pair);
-            running = subsegment_interior(running, z_planes_pair);
-            cc_selection.emplace_back(running);
-
-        // ----------------------------------- Nested sub-segmentation ---------------------------------------
-        // Instead of relying on whole-organ sub-segmentation, attempt to fairly partition the *remaining* volume 
-        // at each pair of cleaves.
-        //
-        // NOTE: This method will generate sub-segments with equal volumes (as best possible given the number of slices
-        //       if the plane orientations are aligned with the contour planes) and should be preferred over compound
-        //       sub-segmentation in almost all cases. It should be faster too.
-        }else if( std::regex_match(SubsegMethodReq,SubsegMethodNested) ){
-            contour_collection<double> running(cc_ref.get());
-
-            const auto z_planes_pair = bisect_ROIs(running, z_normal, ZSelectionLower, ZSelectionUpper);
-            running = subsegment_interior(running, z_planes_pair);
-
-            const auto x_planes_pair = bisect_ROIs(running, x_normal, XSelectionLower, XSelectionUpper);
-            running = subsegment_interior(running, x_planes_pair);
-
-            const auto y_planes_pair = bisect_ROIs(running, y_normal, YSelectionLower, YSelectionUpper);
-            running = subsegment_interior(running, y_planes_pair);
-
-            cc_selection.emplace_back(running);
-
-        }else{
-            throw std::invalid_argument("Subsegmentation method not understood. Cannot continue.");
+    {
+        auto b_it = std::begin(bounds);
+        for(const auto &cc_ref : cc_ROIs){
+            if(!cc_ref.get().contours.empty() && need_contours) cc_selection.emplace_back( std::move(b_it->contours) );
+            ++b_it;
         }
     }
 
@@ -486,8 +440,43 @@ Drover Subsegment_ComputeDose_VanLuijk(Drover DICOM_data,
 
     //Accumulate the voxel intensity distributions.
     AccumulatePixelDistributionsUserData ud;
-    if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
-                                           final_selected_ROI_refs, &ud )){
+    if(UseMask){
+        // Each original ROI is partitioned by name and bounded on both sides by every pair of cleaving planes. The
+        // upper planes are flipped so that the sub-segment lies above all planes.
+        std::list<contour_collection<double>> cc_storage;
+        std::vector<half_space_clipped_roi> clipped;
+        auto b_it = std::begin(bounds);
+        for(const auto &cc_ref : cc_ROIs){
+            const auto &planes = (b_it++)->planes;
+
+            std::map<std::string, size_t> index;
+            for(const auto &c : cc_ref.get().contours){
+                if(c.points.empty()) continue;
+                const auto lROIname = c.GetMetadataValueAs<std::string>("ROIName");
+                if(!lROIname){
+                    throw std::invalid_argument("Missing necessary tags for reporting analysis results."
+                                                " Cannot continue.");
+                }
+
+                auto i_it = index.find(lROIname.value());
+                if(i_it == std::end(index)){
+                    i_it = index.emplace(lROIname.value(), clipped.size()).first;
+                    cc_storage.emplace_back();
+                    clipped.emplace_back();
+                    clipped.back().name = lROIname.value();
+                    clipped.back().ccsl.push_back( std::ref(cc_storage.back()) );
+                    for(const auto &p : planes){
+                        clipped.back().half_spaces.push_back( p.first );
+                        clipped.back().half_spaces.emplace_back( p.second.N_0 * -1.0, p.second.R_0 );
+                    }
+                }
+                clipped[i_it->second].ccsl.front().get().contours.push_back(c);
+            }
+        }
+        Accumulate_Clipped_Pixel_Distributions(img_arr_ptr->imagecoll, clipped, ud);
+
+    }else if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
+                                                   final_selected_ROI_refs, &ud )){
         throw std::runtime_error("Unable to accumulate pixel distributions.");
     }
 
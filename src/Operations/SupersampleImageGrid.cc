@@ -14,6 +14,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Bicubic_Supersample.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Bilinear_Supersample.h"
 #include "../YgorImages_Functors/Compute/Interpolate_Image_Slices.h"
@@ -119,9 +120,9 @@ Drover SupersampleImageGrid(Drover DICOM_data,
             InImagePlaneBilinearSupersampleUserData bilin_ud;
             bilin_ud.RowScaleFactor = RowScaleFactor; 
             bilin_ud.ColumnScaleFactor = ColumnScaleFactor; 
-            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                              InImagePlaneBilinearSupersample,
-                                                              {}, {}, &bilin_ud )){
+            if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                         InImagePlaneBilinearSupersample,
+                                         {}, {}, &bilin_ud )){
                 throw std::runtime_error("Unable to bilinearly supersample images. Cannot continue.");
             }
         }
@@ -131,9 +132,9 @@ Drover SupersampleImageGrid(Drover DICOM_data,
             InImagePlaneBicubicSupersampleUserData bicub_ud;
             bicub_ud.RowScaleFactor = RowScaleFactor; 
             bicub_ud.ColumnScaleFactor = ColumnScaleFactor; 
-            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                              InImagePlaneBicubicSupersample,
-                                                              {}, {}, &bicub_ud )){
+            if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                         InImagePlaneBicubicSupersample,
+                                         {}, {}, &bicub_ud )){
                 throw std::runtime_error("Unable to bicubically supersample images. Cannot continue.");
             }
         }
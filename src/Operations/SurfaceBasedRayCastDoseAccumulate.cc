@@ -13,7 +13,7 @@
 #include <functional>
 #include <thread>
 #include <array>
-#include <mutex>
+#include <cstdint>
 #include <limits>
 #include <cmath>
 #include <regex>
@@ -50,10 +50,7 @@
 
 #include <CGAL/subdivision_method_3.h>
 
-#include <CGAL/AABB_tree.h>
-#include <CGAL/AABB_traits.h>
 #include <CGAL/boost/graph/graph_traits_Polyhedron_3.h>
-#include <CGAL/AABB_face_graph_triangle_primitive.h>
 #include <boost/optional.hpp>
 
 
@@ -73,12 +70,12 @@
 #include "YgorImagesIO.h"
 #include "YgorImagesPlotting.h"
 
-#include "Explicator.h"       //Needed for Explicator class.
-
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "../Surface_Meshes.h"
+#include "../Surface_Mesh_BVH.h"
 #include "../Dose_Meld.h"
 
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
@@ -135,7 +132,7 @@ OperationDoc OpArgDocSurfaceBasedRayCastDoseAccumulate(){
         " Though it is not required by the implementation, only the ray-surface intersection nearest to the detector is"
         " considered. All other intersections (i.e., on the far side of the surface mesh) are ignored."
         " This routine is fairly fast compared to the slow grid-based counterpart previously implemented. The speedup comes"
-        " from use of an AABB-tree to accelerate intersection queries and avoid having to 'walk' rays step-by-step through"
+        " from use of a bounding volume hierarchy to accelerate intersection queries and avoid having to 'walk' rays step-by-step through"
         " over/through the geometry.";
 
 
@@ -327,6 +324,32 @@ OperationDoc OpArgDocSurfaceBasedRayCastDoseAccumulate(){
     out.args.back().default_val = "1024";
     out.args.back().expected = true;
     out.args.back().examples = { "100", "128", "1024", "4096" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "AdaptiveRayTolerance";
+    out.args.back().desc = "If positive, rays are cast adaptively rather than for every pixel. The detector is"
+                      " partitioned into square cells which are recursively subdivided (i.e., a quadtree) wherever"
+                      " the rays cast at a cell's corners and centre differ in the number of ray-surface (or"
+                      " reference ROI) intersections, or where the dose of the centre ray differs from the value"
+                      " interpolated from the corners by more than this tolerance (in units of dose)."
+                      " The remaining pixels are bilinearly interpolated from the corners of their cell."
+                      " The difference between cast and interpolated centre rays serves as an error estimate, and the"
+                      " largest accepted difference is reported along with the number of rays cast."
+                      " Note that features smaller than the initial cell size can be missed if they are not"
+                      " intersected by any of a cell's rays. A value of zero disables adaptive ray casting.";
+    out.args.back().default_val = "0.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0", "0.01", "0.1", "1.0" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "AdaptiveRayInitialSpacing";
+    out.args.back().desc = "The initial size of adaptive ray casting cells, in pixels. Only used when"
+                      " AdaptiveRayTolerance is positive. Surface features smaller than this may be missed.";
+    out.args.back().default_val = "16";
+    out.args.back().expected = true;
+    out.args.back().examples = { "4", "8", "16", "32" };
     
 /*
     out.args.emplace_back();
@@ -435,6 +458,8 @@ Drover SurfaceBasedRayCastDoseAccumulate(Drover DICOM_data,
 
     const auto SourceDetectorRows = std::stol(OptArgs.getValueStr("SourceDetectorRows").value());
     const auto SourceDetectorColumns = std::stol(OptArgs.getValueStr("SourceDetectorColumns").value());
+    const auto AdaptiveRayTolerance = std::stod(OptArgs.getValueStr("AdaptiveRayTolerance").value());
+    const auto AdaptiveRayInitialSpacing = std::stol(OptArgs.getValueStr("AdaptiveRayInitialSpacing").value());
 
 /*
     const auto MeshingAngularBound = std::stod(OptArgs.getValueStr("MeshingAngularBound").value());
@@ -454,14 +479,21 @@ Drover SurfaceBasedRayCastDoseAccumulate(Drover DICOM_data,
     const auto refnormalizedregex = Compile_Regex(NormalizedReferenceROILabelRegex);
     const auto TrueRegex = Compile_Regex("^tr?u?e?$");
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
 
     //Boolean options.
     const auto OnlyGenerateSurface = std::regex_match(OnlyGenerateSurfaceStr, TrueRegex);
 
+    if( !std::isfinite(AdaptiveRayTolerance) || (AdaptiveRayTolerance < 0.0) ){
+        throw std::invalid_argument("Adaptive ray tolerance is invalid. Cannot continue.");
+    }
+    if(AdaptiveRayInitialSpacing < 1){
+        throw std::invalid_argument("Adaptive ray initial spacing must be positive. Cannot continue.");
+    }
+
     //Merge the dose arrays if multiple are available.
-    DICOM_data = Meld_Only_Dose_Data(DICOM_data);
+    DICOM_data = Meld_Only_Dose_Data(std::move(DICOM_data));
 
     //Gather only dose images.
     auto IAs_all = All_IAs( DICOM_data );
@@ -605,21 +637,9 @@ Drover SurfaceBasedRayCastDoseAccumulate(Drover DICOM_data,
     if(OnlyGenerateSurface) return DICOM_data;
 
 
-    // ================================ Construct AABB Trees for Spatial Lookups ===================================
-    //typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
-    using Kernel                = dcma_surface_meshes::Kernel;
-    using Point                 = Kernel::Point_3;
-    using Segment               = Kernel::Segment_3;
-    using Line                  = Kernel::Line_3;
-    using Triangle_Primitive    = CGAL::AABB_face_graph_triangle_primitive<dcma_surface_meshes::Polyhedron>;
-    using Traits                = CGAL::AABB_traits<Kernel, Triangle_Primitive>;
-    using AABB_Tree             = CGAL::AABB_tree<Traits>;
-    using Segment_intersection  = boost::optional<AABB_Tree::Intersection_and_primitive_id<Segment>::Type>;
-    //using Line_intersection     = boost::optional<AABB_Tree::Intersection_and_primitive_id<Line>::Type>;
-
-    //Construct the tree.
-    AABB_Tree tree(faces(polyhedron).first, faces(polyhedron).second, polyhedron);
-    AABB_Tree ref_tree(faces(ref_polyhedron).first, faces(ref_polyhedron).second, ref_polyhedron);
+    // ================================ Construct BVHs for Spatial Lookups ===================================
+    const Surface_Mesh_BVH tree( dcma_surface_meshes::PolyhedronToFVSMesh(polyhedron) );
+    const Surface_Mesh_BVH ref_tree( dcma_surface_meshes::PolyhedronToFVSMesh(ref_polyhedron) );
 
     //Figure out what z-margin is needed so the extra two images do not interfere with the grid lining up with the
     // contours. (Want exactly one contour plane per image.) So the margin should be large enough so the empty
@@ -749,114 +769,218 @@ Drover SurfaceBasedRayCastDoseAccumulate(Drover DICOM_data,
 
     // ============================================== Ray-cast ==============================================
 
+    //Casts the ray for a single pixel, depositing the results in the images.
+    const auto cast_ray = [&](long int row, long int col) -> void {
+        //Construct a line segment between the source and detector. 
+        long int accumulated_counts = 0;      //The number of ray-surface intersections.
+        long int ref_accumulated_counts = 0;  //Whether the ray intersects the reference ROI anywhere..
+        double accumulated_totaldose = 0.0;   //The total accumulated dose from all intersections.
+        const vec3<double> ray_start = SourceImg->position(row, col); // The naive starting position, without boosting.
+        const vec3<double> ray_end = DetectImg->position(row, col);
+
+        //Enumerate all intersections.
+        auto intersections = tree.all_intersections(ray_start, ray_end);
+        if(!intersections.empty()){
+
+            //Sort by distance from the detector so the first intersection is closest to the detector.
+            std::stable_sort(std::begin(intersections), std::end(intersections),
+                             [&](const Surface_Mesh_BVH::hit_t &A, const Surface_Mesh_BVH::hit_t &B) -> bool {
+                return std::abs( detector_plane.Get_Signed_Distance_To_Point(A.point) ) 
+                          < std::abs( detector_plane.Get_Signed_Distance_To_Point(B.point) );
+            });
+
+            //Cycle through the intersections stopping after the point nearest the detector is located.
+            for(const auto & intersection : intersections){
+                const vec3<double> &P = intersection.point;
+
+                //Compute the distance to the detector.
+                const auto P_src_dist = std::abs( detector_plane.Get_Signed_Distance_To_Point(P) );
+                DepthImg->reference(row, col, accumulated_counts) = static_cast<float>( P_src_dist );
+
+                //Compute the distance to the COM-COM line (between target ROI and reference ROI).
+                const auto P_rad_dist = COM_COM_line.Distance_To_Point(P);
+                RadialDistImg->reference(row, col, accumulated_counts) = static_cast<float>( P_rad_dist );
+
+                //Find the dose at the intersection point.
+                const auto interp_val = img_arr_ptr->imagecoll.trilinearly_interpolate(P,0);
+
+                accumulated_totaldose += interp_val;
+                ++accumulated_counts;
+
+                //Determine whether the reference ROI is orthogonally adjacent to this intersection.
+                //
+                //Fast check for intersections with the reference ROI.
+                if(ref_tree.any_intersection( line<double>(ray_start, ray_end) )){
+                    ++ref_accumulated_counts;
+                }
+
+                //Terminate the loop after desired number of intersections.
+                if(accumulated_counts >= MaxRaySurfaceIntersections) break;
+            }
+        }
+
+        //Deposit the dose in the images.
+        SourceImg->reference(row, col, 0)    = static_cast<float>(accumulated_counts);
+        DetectImg->reference(row, col, 0)    = static_cast<float>(accumulated_totaldose);
+        DetectRefImg->reference(row, col, 0) = static_cast<float>(ref_accumulated_counts);
+        if(ref_accumulated_counts != 0){
+            RefCroppedImg->reference(row, col, 0)    = static_cast<float>(accumulated_totaldose);
+        }
+    };
+
     //Now ready to ray cast. Loop over integer pixel coordinates. Start and finish are image pixels.
     // The top image can be the length image.
-    {
-        asio_thread_pool tp;
-        std::mutex printer; // Who gets to print to the console and iterate the counter.
-        long int completed = 0;
+    if(AdaptiveRayTolerance <= 0.0){
+        progress_tracker progress("SurfaceBasedRayCastDoseAccumulate", SourceDetectorRows,
+                                  [](long int completed, long int total, double eta_s) -> void {
+            FUNCINFO("Completed " << completed << " of " << total
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done"
+                  << ", ~" << static_cast<long int>(eta_s) << " s remaining");
+        });
+        task_group tg;
 
         for(long int row = 0; row < SourceDetectorRows; ++row){
-            tp.submit_task([&,row]() -> void {
-                for(long int col = 0; col < SourceDetectorColumns; ++col){
-
-                    //Construct a line segment between the source and detector. 
-                    long int accumulated_counts = 0;      //The number of ray-surface intersections.
-                    long int ref_accumulated_counts = 0;  //Whether the ray intersects the reference ROI anywhere..
-                    double accumulated_totaldose = 0.0;   //The total accumulated dose from all intersections.
-                    const vec3<double> ray_start = SourceImg->position(row, col); // The naive starting position, without boosting.
-                    const vec3<double> ray_end = DetectImg->position(row, col);
-
-                    Segment line_segment( Point(ray_start.x, ray_start.y, ray_start.z),
-                                          Point(ray_end.x,   ray_end.y,   ray_end.z)   );
-
-                    //Fast check for intersections.
-                    if(tree.do_intersect(line_segment)){
-
-                        //Enumerate all intersections. Note that some may be line segment "glances."
-                        std::list<Segment_intersection> intersections;
-                        tree.all_intersections(line_segment, std::back_inserter(intersections));
-
-                        //Sort by distance from the detector so the first intersection is closest to the detector.
-                        intersections.sort([&](const Segment_intersection &A, const Segment_intersection &B) -> bool {
-                            const Point *pA = boost::get<Point>(&(A->first));
-                            const Point *pB = boost::get<Point>(&(B->first));
-                            if( (pA) && (pB) ){ // Both valid points.
-                                const vec3<double> PA(static_cast<double>( CGAL::to_double( pA->x() )),
-                                                      static_cast<double>( CGAL::to_double( pA->y() )),
-                                                      static_cast<double>( CGAL::to_double( pA->z() )));
-                                const vec3<double> PB(static_cast<double>( CGAL::to_double( pB->x() )),
-                                                      static_cast<double>( CGAL::to_double( pB->y() )),
-                                                      static_cast<double>( CGAL::to_double( pB->z() )));
-                                return std::abs( detector_plane.Get_Signed_Distance_To_Point(PA) ) 
-                                          < std::abs( detector_plane.Get_Signed_Distance_To_Point(PB) );
-                            }else if((pA) && !(pB)){
-                                return true;
-                            }else if(!(pA) && (pB)){
-                                return false;
-                            }
-                            return false; //Both non-points.
-
-                        });
-
-                        //Cycle through the intersections stopping after the point nearest the detector is located.
-                        for(const auto & intersection : intersections){
-                            if(intersection){
-                                const Point* p = boost::get<Point>(&(intersection->first));
-                                if(p){
-                                    //Convert from CGAL vector to Ygor vector.
-                                    const vec3<double> P(static_cast<double>( CGAL::to_double( p->x() )),
-                                                         static_cast<double>( CGAL::to_double( p->y() )),
-                                                         static_cast<double>( CGAL::to_double( p->z() )));
-
-                                    //Compute the distance to the detector.
-                                    const auto P_src_dist = std::abs( detector_plane.Get_Signed_Distance_To_Point(P) );
-                                    DepthImg->reference(row, col, accumulated_counts) = static_cast<float>( P_src_dist );
-
-                                    //Compute the distance to the COM-COM line (between target ROI and reference ROI).
-                                    const auto P_rad_dist = COM_COM_line.Distance_To_Point(P);
-                                    RadialDistImg->reference(row, col, accumulated_counts) = static_cast<float>( P_rad_dist );
-
-                                    //Find the dose at the intersection point.
-                                    const auto interp_val = img_arr_ptr->imagecoll.trilinearly_interpolate(P,0);
-
-                                    accumulated_totaldose += interp_val;
-                                    ++accumulated_counts;
-
-                                    //Determine whether the reference ROI is orthogonally adjacent to this intersection.
-                                    Line cgal_line( Point(ray_start.x, ray_start.y, ray_start.z),
-                                                    Point(ray_end.x,   ray_end.y,   ray_end.z)   );
-                                    
-                                    //Fast check for intersections with the reference ROI.
-                                    if(ref_tree.do_intersect(cgal_line)){
-                                        ++ref_accumulated_counts;
-                                    }
-
-                                    //Terminate the loop after desired number of intersections.
-                                    if(accumulated_counts >= MaxRaySurfaceIntersections) break;
-                                }
-                            }
-                        }
-                    }
+            tg.run([&,row]() -> void {
+                for(long int col = 0; col < SourceDetectorColumns; ++col) cast_ray(row, col);
+                progress.advance();
+            });
+        }
+        tg.wait();
+    } // Complete tasks and terminate thread pool.
 
-                    //Deposit the dose in the images.
-                    SourceImg->reference(row, col, 0)    = static_cast<float>(accumulated_counts);
-                    DetectImg->reference(row, col, 0)    = static_cast<float>(accumulated_totaldose);
-                    DetectRefImg->reference(row, col, 0) = static_cast<float>(ref_accumulated_counts);
-                    if(ref_accumulated_counts != 0){
-                        RefCroppedImg->reference(row, col, 0)    = static_cast<float>(accumulated_totaldose);
-                    }
+    //Adaptive ray casting. Cells span [r0,r1]x[c0,c1] (inclusive) so neighbouring cells share their edge rays. Each
+    // level of the quadtree casts all the rays it needs at once, and then decides which cells to subdivide.
+    if(0.0 < AdaptiveRayTolerance){
+        struct cell_t {
+            long int r0, r1, c0, c1;
+        };
+        const auto N_rows = SourceDetectorRows;
+        const auto N_cols = SourceDetectorColumns;
+        std::vector<uint8_t> is_cast(static_cast<size_t>(N_rows * N_cols), 0);
+        long int rays_cast = 0;
+        double max_accepted_error = 0.0;
+
+        std::vector<cell_t> cells;
+        for(long int r = 0; r < std::max<long int>(1, N_rows - 1); r += AdaptiveRayInitialSpacing){
+            for(long int c = 0; c < std::max<long int>(1, N_cols - 1); c += AdaptiveRayInitialSpacing){
+                cells.push_back( cell_t{ r, std::min(r + AdaptiveRayInitialSpacing, N_rows - 1),
+                                         c, std::min(c + AdaptiveRayInitialSpacing, N_cols - 1) } );
+            }
+        }
+
+        std::vector<cell_t> leaves;
+        while(!cells.empty()){
+            // Cast the corner and centre rays which have not yet been cast.
+            std::vector<std::pair<long int, long int>> rays;
+            const auto need = [&](long int r, long int c) -> void {
+                auto &f = is_cast[static_cast<size_t>(r * N_cols + c)];
+                if(f == 0) rays.emplace_back(r, c);
+                f = 1;
+            };
+            for(const auto &x : cells){
+                need(x.r0, x.c0);
+                need(x.r0, x.c1);
+                need(x.r1, x.c0);
+                need(x.r1, x.c1);
+                need((x.r0 + x.r1) / 2, (x.c0 + x.c1) / 2);
+            }
+            parallel_for(0, static_cast<long int>(rays.size()), [&](long int i) -> void {
+                cast_ray(rays[i].first, rays[i].second);
+            });
+            rays_cast += static_cast<long int>(rays.size());
+
+            // Subdivide cells where the corners and centre disagree.
+            std::vector<cell_t> next;
+            for(const auto &x : cells){
+                if( ((x.r1 - x.r0) < 2) && ((x.c1 - x.c0) < 2) ){
+                    leaves.push_back(x); // All of the cell's rays have been cast.
+                    continue;
+                }
+                const auto rm = (x.r0 + x.r1) / 2;
+                const auto cm = (x.c0 + x.c1) / 2;
+                const auto fr = static_cast<double>(rm - x.r0)
+                              / static_cast<double>(std::max<long int>(1, x.r1 - x.r0));
+                const auto fc = static_cast<double>(cm - x.c0)
+                              / static_cast<double>(std::max<long int>(1, x.c1 - x.c0));
+                const std::array<std::pair<long int, long int>, 4> corners = {{ {x.r0, x.c0}, {x.r0, x.c1},
+                                                                                {x.r1, x.c0}, {x.r1, x.c1} }};
+                const std::array<double, 4> weights = {{ (1.0 - fr) * (1.0 - fc), (1.0 - fr) * fc,
+                                                         fr * (1.0 - fc),         fr * fc }};
+                bool same_pattern = true;
+                double interpolated_dose = 0.0;
+                for(size_t k = 0; k < corners.size(); ++k){
+                    const auto &rc = corners[k];
+                    same_pattern = same_pattern
+                        && (SourceImg->value(rc.first, rc.second, 0) == SourceImg->value(rm, cm, 0))
+                        && (DetectRefImg->value(rc.first, rc.second, 0) == DetectRefImg->value(rm, cm, 0));
+                    interpolated_dose += weights[k] * static_cast<double>(DetectImg->value(rc.first, rc.second, 0));
                 }
 
-                {
-                    std::lock_guard<std::mutex> lock(printer);
-                    ++completed;
-                    FUNCINFO("Completed " << completed << " of " << SourceDetectorRows 
-                          << " --> " << static_cast<int>(1000.0*(completed)/SourceDetectorRows)/10.0 << "% done");
+                // The centre ray provides an estimate of the interpolation error within the cell.
+                const auto err = std::abs(interpolated_dose - static_cast<double>(DetectImg->value(rm, cm, 0)));
+                if(same_pattern && (err <= AdaptiveRayTolerance)){
+                    max_accepted_error = std::max(max_accepted_error, err);
+                    leaves.push_back(x);
+                    continue;
                 }
-            });
+
+                std::vector<std::pair<long int, long int>> r_spans = {{ x.r0, x.r1 }};
+                std::vector<std::pair<long int, long int>> c_spans = {{ x.c0, x.c1 }};
+                if(2 <= (x.r1 - x.r0)) r_spans = {{ x.r0, rm }, { rm, x.r1 }};
+                if(2 <= (x.c1 - x.c0)) c_spans = {{ x.c0, cm }, { cm, x.c1 }};
+                for(const auto &rr : r_spans){
+                    for(const auto &cc : c_spans){
+                        next.push_back( cell_t{ rr.first, rr.second, cc.first, cc.second } );
+                    }
+                }
+            }
+            cells.swap(next);
         }
-    } // Complete tasks and terminate thread pool.
+
+        // Interpolate the remaining pixels. Each cell fills the half-open range [r0,r1)x[c0,c1), along with the final
+        // row and column of the detector, so no pixel is filled by more than one cell.
+        parallel_for(0, static_cast<long int>(leaves.size()), [&](long int i) -> void {
+            const auto &x = leaves[i];
+            const auto r_end = (x.r1 == (N_rows - 1)) ? N_rows : x.r1;
+            const auto c_end = (x.c1 == (N_cols - 1)) ? N_cols : x.c1;
+            const auto counts = static_cast<long int>(SourceImg->value(x.r0, x.c0, 0));
+            const auto ref_counts = DetectRefImg->value(x.r0, x.c0, 0);
+            for(long int r = x.r0; r < r_end; ++r){
+                const auto fr = (x.r0 < x.r1) ? static_cast<double>(r - x.r0) / static_cast<double>(x.r1 - x.r0) : 0.0;
+                for(long int c = x.c0; c < c_end; ++c){
+                    if(is_cast[static_cast<size_t>(r * N_cols + c)] != 0) continue;
+                    const auto fc = (x.c0 < x.c1) ? static_cast<double>(c - x.c0) / static_cast<double>(x.c1 - x.c0)
+                                                  : 0.0;
+                    const auto bilinear = [&](const planar_image<float, double> *img, long int chnl) -> float {
+                        const auto v00 = static_cast<double>(img->value(x.r0, x.c0, chnl));
+                        const auto v01 = static_cast<double>(img->value(x.r0, x.c1, chnl));
+                        const auto v10 = static_cast<double>(img->value(x.r1, x.c0, chnl));
+                        const auto v11 = static_cast<double>(img->value(x.r1, x.c1, chnl));
+                        return static_cast<float>( (1.0 - fr) * ((1.0 - fc) * v00 + fc * v01)
+                                                 +        fr  * ((1.0 - fc) * v10 + fc * v11) );
+                    };
+
+                    // The corners of accepted cells share their intersection counts.
+                    const auto dose = bilinear(DetectImg, 0);
+                    SourceImg->reference(r, c, 0)    = static_cast<float>(counts);
+                    DetectImg->reference(r, c, 0)    = dose;
+                    DetectRefImg->reference(r, c, 0) = ref_counts;
+                    if(ref_counts != 0.0f) RefCroppedImg->reference(r, c, 0) = dose;
+                    for(long int chnl = 0; chnl < counts; ++chnl){
+                        DepthImg->reference(r, c, chnl)      = bilinear(DepthImg, chnl);
+                        RadialDistImg->reference(r, c, chnl) = bilinear(RadialDistImg, chnl);
+                    }
+                }
+            }
+        });
+
+        const auto N_pixels = N_rows * N_cols;
+        FUNCINFO("Adaptively cast " << rays_cast << " of " << N_pixels << " rays ("
+                 << (100.0 * static_cast<double>(rays_cast) / static_cast<double>(std::max<long int>(1, N_pixels)))
+                 << "%); the largest estimated interpolation error was " << max_accepted_error);
+        DetectImg->metadata["AdaptiveRayCount"] = std::to_string(rays_cast);
+        DetectImg->metadata["AdaptiveRayMaxEstimatedError"] = std::to_string(max_accepted_error);
+    }
 
 
     // Save image maps to file.
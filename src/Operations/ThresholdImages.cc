@@ -8,7 +8,6 @@
 #include <list>
 #include <map>
 #include <memory>
-#include <mutex>
 #include <regex>
 #include <set> 
 #include <stdexcept>
@@ -16,13 +15,15 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include "../Distribution_Sketch.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Paged_Images.h"
 #include "../Thread_Pool.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 
 #include "ThresholdImages.h"
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -118,7 +119,7 @@ Drover ThresholdImages(Drover DICOM_data,
                        /*InvocationMetadata*/,
                        const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+    const lexicon_translator X(FilenameLex);
 
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto LowerStr = OptArgs.getValueStr("Lower").value();
@@ -150,88 +151,138 @@ Drover ThresholdImages(Drover DICOM_data,
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
     for(auto & iap_it : IAs){
-        asio_thread_pool tp;
-        std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
-        long int completed = 0;
         const long int img_count = (*iap_it)->imagecoll.images.size();
+        progress_tracker progress("ThresholdImages", img_count,
+                                  [](long int completed, long int total, double) -> void {
+            FUNCINFO("Completed " << completed << " of " << total
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+        });
+        task_group tg;
 
         for(auto &animg : (*iap_it)->imagecoll.images){
             if( (animg.rows < 1) || (animg.columns < 1) || (Channel >= animg.channels) ){
                 throw std::runtime_error("Image or channel is empty -- cannot contour via thresholds.");
             }
-            std::reference_wrapper<planar_image<float,double>> img_refw( std::ref(animg) );
-
-            tp.submit_task([&,img_refw]() -> void {
-                const auto R = img_refw.get().rows;
-                const auto C = img_refw.get().columns;
-
-                //Determine the bounds in terms of pixel-value thresholds.
-                auto cl = Lower; // Will be replaced if percentages/percentiles requested.
-                auto cu = Upper; // Will be replaced if percentages/percentiles requested.
-          
-                {
-                    //Percentage-based.
-                    if(Lower_is_Percent || Upper_is_Percent){
-                        Stats::Running_MinMax<float> rmm;
-                        img_refw.get().apply_to_pixels([&rmm,Channel](long int, long int, long int chnl, float val) -> void {
-                             if(Channel == chnl) rmm.Digest(val);
-                             return;
-                        });
-                        if(Lower_is_Percent) cl = (rmm.Current_Min() + (rmm.Current_Max() - rmm.Current_Min()) * Lower / 100.0);
-                        if(Upper_is_Percent) cu = (rmm.Current_Min() + (rmm.Current_Max() - rmm.Current_Min()) * Upper / 100.0);
-                    }
+        }
 
-                    //Percentile-based.
-                    if(Lower_is_Ptile || Upper_is_Ptile){
-                        std::vector<float> pixel_vals;
-                        pixel_vals.reserve(img_refw.get().rows * img_refw.get().columns * img_refw.get().channels);
-                        img_refw.get().apply_to_pixels([&pixel_vals,Channel](long int, long int, long int chnl, float val) -> void {
-                             if(Channel == chnl) pixel_vals.push_back(val);
-                             return;
-                        });
-                        if(Lower_is_Ptile) cl = Stats::Percentile(pixel_vals, Lower / 100.0);
-                        if(Upper_is_Ptile) cu = Stats::Percentile(pixel_vals, Upper / 100.0);
-                    }
+        const auto threshold_image = [&](std::reference_wrapper<planar_image<float,double>> img_refw) -> void {
+            const auto R = img_refw.get().rows;
+            const auto C = img_refw.get().columns;
+
+            //Determine the bounds in terms of pixel-value thresholds.
+            auto cl = Lower; // Will be replaced if percentages/percentiles requested.
+            auto cu = Upper; // Will be replaced if percentages/percentiles requested.
+      
+            {
+                //Percentage-based.
+                if(Lower_is_Percent || Upper_is_Percent){
+                    Stats::Running_MinMax<float> rmm;
+                    img_refw.get().apply_to_pixels([&rmm,Channel](long int, long int, long int chnl, float val) -> void {
+                         if(Channel == chnl) rmm.Digest(val);
+                         return;
+                    });
+                    if(Lower_is_Percent) cl = (rmm.Current_Min() + (rmm.Current_Max() - rmm.Current_Min()) * Lower / 100.0);
+                    if(Upper_is_Percent) cu = (rmm.Current_Min() + (rmm.Current_Max() - rmm.Current_Min()) * Upper / 100.0);
                 }
 
-                //Construct pixel 'oracle' closures using the user-specified threshold criteria. 
-                // These functions identify whether pixels are within the threshold values.
-                auto lower_pixel_oracle = [cl](float p) -> bool {
-                    return (cl < p);
-                };
-                auto upper_pixel_oracle = [cu](float p) -> bool {
-                    return (p < cu);
-                };
-
-                //Iterate over each pixel, asking the oracle to identify each.
-                Stats::Running_MinMax<float> minmax_pixel;
-                for(auto r = 0; r < R; ++r){
-                    for(auto c = 0; c < C; ++c){
-                        const auto v = img_refw.get().value(r, c, Channel);
-
-                        if(!lower_pixel_oracle(v)){
-                            img_refw.get().reference(r, c, Channel) = Low;
-                        }
-                        if(!upper_pixel_oracle(v)){
-                            img_refw.get().reference(r, c, Channel) = High;
-                        }
-                        minmax_pixel.Digest( img_refw.get().value(r, c, Channel) );
-                    }
+                //Percentile-based.
+                if(Lower_is_Ptile || Upper_is_Ptile){
+                    std::vector<float> pixel_vals;
+                    pixel_vals.reserve(img_refw.get().rows * img_refw.get().columns * img_refw.get().channels);
+                    img_refw.get().apply_to_pixels([&pixel_vals,Channel](long int, long int, long int chnl, float val) -> void {
+                         if(Channel == chnl) pixel_vals.push_back(val);
+                         return;
+                    });
+                    const sorted_quantiles<float> ptiles(std::move(pixel_vals));
+                    if(Lower_is_Ptile) cl = ptiles.quantile(Lower / 100.0);
+                    if(Upper_is_Ptile) cu = ptiles.quantile(Upper / 100.0);
                 }
+            }
 
-                UpdateImageDescription( img_refw, "Thresholded" );
-                UpdateImageWindowCentreWidth( img_refw, minmax_pixel );
-
-                //Report operation progress.
-                {
-                    std::lock_guard<std::mutex> lock(saver_printer);
-                    ++completed;
-                    FUNCINFO("Completed " << completed << " of " << img_count
-                          << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+            //Construct pixel 'oracle' closures using the user-specified threshold criteria. 
+            // These functions identify whether pixels are within the threshold values.
+            auto lower_pixel_oracle = [cl](float p) -> bool {
+                return (cl < p);
+            };
+            auto upper_pixel_oracle = [cu](float p) -> bool {
+                return (p < cu);
+            };
+
+            //Iterate over each pixel, asking the oracle to identify each.
+            Stats::Running_MinMax<float> minmax_pixel;
+            for(auto r = 0; r < R; ++r){
+                for(auto c = 0; c < C; ++c){
+                    const auto v = img_refw.get().value(r, c, Channel);
+
+                    if(!lower_pixel_oracle(v)){
+                        img_refw.get().reference(r, c, Channel) = Low;
+                    }
+                    if(!upper_pixel_oracle(v)){
+                        img_refw.get().reference(r, c, Channel) = High;
+                    }
+                    minmax_pixel.Digest( img_refw.get().value(r, c, Channel) );
                 }
-            }); // thread pool task closure.
+            }
+
+            UpdateImageDescription( img_refw, "Thresholded" );
+            UpdateImageWindowCentreWidth( img_refw, minmax_pixel );
+
+            //Report operation progress.
+            progress.advance();
+        };
+
+        if(auto store = (*iap_it)->get_page_store()){
+            Stream_Images(*store, [&](paged_image_store::image_list_t::iterator img_it) -> void {
+                threshold_image( std::ref(*img_it) );
+            });
+        }else{
+            for(auto &animg : (*iap_it)->imagecoll.images){
+                std::reference_wrapper<planar_image<float,double>> img_refw( std::ref(animg) );
+                tg.run([&,img_refw]() -> void {
+                    threshold_image(img_refw);
+                }); // thread pool task closure.
+            }
+            tg.wait();
         }
     }
 
     return DICOM_data;
 }
+
+std::optional<pointwise_stage> PointwiseStageThresholdImages(Drover &DICOM_data, const OperationArgPkg& OptArgs){
+    const auto LowerStr = OptArgs.getValueStr("Lower").value();
+    const auto UpperStr = OptArgs.getValueStr("Upper").value();
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+
+    //Percentage- and percentile-based bounds depend on the whole image, so they cannot be applied voxel-by-voxel.
+    const auto regex_is_percent = Compile_Regex(".*[%].*");
+    const auto regex_is_tile = Compile_Regex(".*p?e?r?c?e?n?tile.*");
+    if( std::regex_match(LowerStr, regex_is_percent) || std::regex_match(UpperStr, regex_is_percent)
+    ||  std::regex_match(LowerStr, regex_is_tile)    || std::regex_match(UpperStr, regex_is_tile) ){
+        return std::nullopt;
+    }
+
+    const auto cl = std::stod( LowerStr );
+    const auto cu = std::stod( UpperStr );
+    const auto Low = std::stod( OptArgs.getValueStr("Low").value() );
+    const auto High = std::stod( OptArgs.getValueStr("High").value() );
+
+    pointwise_stage stage;
+    stage.name = "ThresholdImages";
+    stage.channel = std::stol( OptArgs.getValueStr("Channel").value() );
+    auto IAs_all = All_IAs( DICOM_data );
+    for(auto & iap_it : Whitelist( IAs_all, ImageSelectionStr )) stage.arrays.push_back(*iap_it);
+
+    stage.transform = [=](float *vals, size_t n, size_t stride, Stats::Running_MinMax<float> &minmax) -> void {
+        for(size_t i = 0; i < n; ++i){
+            auto &v = vals[i * stride];
+            const auto p = v;
+            if(!(cl < p)) v = Low;
+            if(!(p < cu)) v = High;
+            minmax.Digest(v);
+        }
+    };
+    stage.description = "Thresholded";
+    stage.update_window = true;
+    return stage;
+}
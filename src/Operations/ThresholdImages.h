@@ -3,9 +3,11 @@
 #pragma once
 
 #include <map>
+#include <optional>
 #include <string>
 
 #include "../Structs.h"
+#include "../YgorImages_Functors/Pointwise_Fusion.h"
 
 
 OperationDoc OpArgDocThresholdImages();
@@ -14,3 +16,5 @@ Drover ThresholdImages(Drover DICOM_data,
                        const OperationArgPkg& /*OptArgs*/,
                        const std::map<std::string, std::string>& /*InvocationMetadata*/,
                        const std::string& /*FilenameLex*/);
+
+std::optional<pointwise_stage> PointwiseStageThresholdImages(Drover &DICOM_data, const OperationArgPkg& OptArgs);
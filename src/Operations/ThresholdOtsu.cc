@@ -2,13 +2,14 @@
 
 #include <asio.hpp>
 #include <algorithm>
+#include <cmath>
 #include <optional>
 #include <fstream>
 #include <iterator>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
-#include <mutex>
 #include <regex>
 #include <set> 
 #include <stdexcept>
@@ -16,19 +17,21 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
-#include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
+#include "../Distribution_Sketch.h"
+#include "../Lexicon_Cache.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
+#include "../YgorImages_Functors/Voxel_Inclusion_Mask.h"
 
 #include "ThresholdOtsu.h"
 
@@ -45,11 +48,26 @@ OperationDoc OpArgDocThresholdOtsu(){
         " It works by finding the threshold that partitions the voxel intensity histogram"
         " into two parts, essentially so that the sum of each partition's variance is minimal."
         " The number of histogram bins (i.e., number of distinct voxel magnitude levels) is configurable."
-        " Voxels are binarized; the replacement values are also configurable.";
+        " Voxels are binarized; the replacement values are also configurable."
+        " Multiple thresholds can also be found, partitioning voxels into more than two classes.";
         
     out.notes.emplace_back(
         "The Otsu method will not necessarily cleanly separate bimodal peaks in the voxel intensity histogram."
     );
+    out.notes.emplace_back(
+        "Thresholds coincide with histogram bin boundaries. Voxels in the bin immediately above (inclusive) a"
+        " threshold are assigned to the class above it."
+    );
+    out.notes.emplace_back(
+        "Finding a single threshold takes time proportional to the number of histogram bins, but finding more than one"
+        " threshold takes time proportional to the square of the number of bins. When several thresholds are needed,"
+        " use as few bins as the analysis can tolerate."
+    );
+    out.notes.emplace_back(
+        "When this operation binarizes whole images (i.e., the selected ROIs enclose every voxel) of a single image"
+        " array and is immediately followed by other pointwise operations, the binarization is fused with them into a"
+        " single pass over the voxels."
+    );
     
     out.args.emplace_back();
     out.args.back() = IAWhitelistOpArgDoc();
@@ -74,16 +92,26 @@ OperationDoc OpArgDocThresholdOtsu(){
     out.args.back().expected = true;
     out.args.back().examples = { "10", "50", "100", "200", "500" };
 
+    out.args.emplace_back();
+    out.args.back().name = "ThresholdCount";
+    out.args.back().desc = "The number of thresholds to find. Classical Otsu thresholding finds a single threshold,"
+                           " splitting voxels into two classes. Multi-level Otsu thresholding finds N thresholds,"
+                           " splitting the voxels into N+1 classes so that the between-class variance is maximal."
+                           " Classes are assigned values evenly spaced from ReplacementLow to ReplacementHigh.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "2", "3" };
+
     out.args.emplace_back();
     out.args.back().name = "ReplacementLow";
-    out.args.back().desc = "The value to give voxels which are below (exclusive) the Otsu threshold value.";
+    out.args.back().desc = "The value to give voxels which are below (exclusive) the (lowest) Otsu threshold value.";
     out.args.back().default_val = "0.0";
     out.args.back().expected = true;
     out.args.back().examples = { "-1.0", "0.0", "1.23", "nan", "inf" };
 
     out.args.emplace_back();
     out.args.back().name = "ReplacementHigh";
-    out.args.back().desc = "The value to give voxels which are above (inclusive) the Otsu threshold value.";
+    out.args.back().desc = "The value to give voxels which are above (inclusive) the (highest) Otsu threshold value.";
     out.args.back().default_val = "1.0";
     out.args.back().expected = true;
     out.args.back().examples = { "-1.0", "0.0", "1.23", "nan", "inf" };
@@ -93,7 +121,8 @@ OperationDoc OpArgDocThresholdOtsu(){
     out.args.back().desc = "Controls whether voxels should actually be binarized or not."
                            " Whether or not voxel intensities are overwritten, the Otsu threshold value is"
                            " written into the image metadata as 'OtsuThreshold' in case further processing"
-                           " is needed.";
+                           " is needed. When multiple thresholds are found, 'OtsuThreshold' holds the lowest and"
+                           " 'OtsuThresholds' holds all of them, in ascending order, separated by backslashes.";
     out.args.back().default_val = "true";
     out.args.back().expected = true;
     out.args.back().examples = { "true", "false" };
@@ -148,25 +177,37 @@ OperationDoc OpArgDocThresholdOtsu(){
 
 
 
-Drover ThresholdOtsu(Drover DICOM_data,
-                     const OperationArgPkg& OptArgs,
-                     const std::map<std::string, std::string>&
-                     /*InvocationMetadata*/,
-                     const std::string& FilenameLex){
 
-    Explicator X(FilenameLex);
+
+namespace {
+
+struct otsu_params {
+    std::string ImageSelectionStr;
+    bool OverwriteVoxels = true;
+    long int HistogramBins = 255;
+    long int ThresholdCount = 1;
+    double ReplacementLow = 0.0;
+    double ReplacementHigh = 1.0;
+    long int Channel = 0;
+    Mutate_Voxels_Opts mutation_opts;
+    std::list<std::reference_wrapper<contour_collection<double>>> cc_ROIs;
+};
+
+otsu_params parse_otsu_params(Drover &DICOM_data, const OperationArgPkg& OptArgs){
+    otsu_params p;
 
     //---------------------------------------------- User Parameters --------------------------------------------------
-    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+    p.ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
 
     const auto OverwriteVoxelsStr = OptArgs.getValueStr("OverwriteVoxels").value();
 
-    const auto HistogramBins = std::stol( OptArgs.getValueStr("HistogramBins").value() );
+    p.HistogramBins = std::stol( OptArgs.getValueStr("HistogramBins").value() );
+    p.ThresholdCount = std::stol( OptArgs.getValueStr("ThresholdCount").value() );
 
-    const auto ReplacementLow = std::stod( OptArgs.getValueStr("ReplacementLow").value() );
-    const auto ReplacementHigh = std::stod( OptArgs.getValueStr("ReplacementHigh").value() );
+    p.ReplacementLow = std::stod( OptArgs.getValueStr("ReplacementLow").value() );
+    p.ReplacementHigh = std::stod( OptArgs.getValueStr("ReplacementHigh").value() );
 
-    const auto Channel = std::stol( OptArgs.getValueStr("Channel").value() );
+    p.Channel = std::stol( OptArgs.getValueStr("Channel").value() );
 
     const auto InclusivityStr = OptArgs.getValueStr("Inclusivity").value();
     const auto ContourOverlapStr = OptArgs.getValueStr("ContourOverlap").value();
@@ -182,169 +223,268 @@ Drover ThresholdOtsu(Drover DICOM_data,
     const auto regex_pci = Compile_Regex("^planar_?c?o?r?n?e?r?s?_?inc?l?u?s?i?v?e?$");
     const auto regex_pce = Compile_Regex("^planar_?c?o?r?n?e?r?s?_?exc?l?u?s?i?v?e?$");
 
-    const auto regex_interior = Compile_Regex("^int?e?r?i?o?r?$");
-    const auto regex_exterior = Compile_Regex("^ext?e?r?i?o?r?$");
-
     const auto regex_ignore = Compile_Regex("^ig?n?o?r?e?$");
     const auto regex_honopps = Compile_Regex("^ho?n?o?u?r?_?o?p?p?o?s?i?t?e?_?o?r?i?e?n?t?a?t?i?o?n?s?$");
     const auto regex_cancel = Compile_Regex("^ov?e?r?l?a?p?p?i?n?g?_?c?o?n?t?o?u?r?s?_?c?a?n?c?e?l?s?$");
 
-    if(!isininc(2,HistogramBins,100'000)){
+    p.OverwriteVoxels = std::regex_match(OverwriteVoxelsStr, regex_true);
+
+    if(!isininc(2,p.HistogramBins,100'000)){
         throw std::invalid_argument("Number of histogram bins requested cannot be accomodated. Refusing to continue.");
         // There is no need for an upper limit, but if it is too large it might indicate a failure somewhere.
         // The upper limit can be grown as needed.
     }
+    if( (p.ThresholdCount < 1) || (p.HistogramBins <= p.ThresholdCount) ){
+        throw std::invalid_argument("Number of thresholds requested cannot be accomodated by the histogram bins.");
+    }
 
-    std::function<void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &)> f_noop;
-
-    //-----------------------------------------------------------------------------------------------------------------
+    p.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
+    p.mutation_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
+    p.mutation_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+    p.mutation_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
+
+    if( std::regex_match(ContourOverlapStr, regex_ignore) ){
+        p.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+    }else if( std::regex_match(ContourOverlapStr, regex_honopps) ){
+        p.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
+    }else if( std::regex_match(ContourOverlapStr, regex_cancel) ){
+        p.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations;
+    }else{
+        throw std::invalid_argument("ContourOverlap argument '"_s + ContourOverlapStr + "' is not valid");
+    }
+    if( std::regex_match(InclusivityStr, regex_centre) ){
+        p.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
+    }else if( std::regex_match(InclusivityStr, regex_pci) ){
+        p.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
+    }else if( std::regex_match(InclusivityStr, regex_pce) ){
+        p.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Exclusive;
+    }else{
+        throw std::invalid_argument("Inclusivity argument '"_s + InclusivityStr + "' is not valid");
+    }
 
     // Gather contours.
     auto cc_all = All_CCs( DICOM_data );
-    auto cc_ROIs = Whitelist( cc_all, { { "ROIName", ROILabelRegex },
-                                        { "NormalizedROIName", NormalizedROILabelRegex } } );
-    if(cc_ROIs.empty()){
+    p.cc_ROIs = Whitelist( cc_all, { { "ROIName", ROILabelRegex },
+                                     { "NormalizedROIName", NormalizedROILabelRegex } } );
+    if(p.cc_ROIs.empty()){
         throw std::invalid_argument("No contours selected. Cannot continue.");
     }
+    return p;
+}
 
-    auto IAs_all = All_IAs( DICOM_data );
-    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
-    for(auto & iap_it : IAs){
-        if((*iap_it)->imagecoll.images.empty()) continue;
-
-        std::vector<double> voxel_vals;
-        std::mutex voxel_vals_access;
-
-        // First-pass: collect voxel magnitudes for analysis.
-        {
-            PartitionedImageVoxelVisitorMutatorUserData ud;
-
-            ud.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
-            ud.mutation_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
-            ud.mutation_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
-            ud.mutation_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
-            //ud.description = "";
-
-            if( std::regex_match(ContourOverlapStr, regex_ignore) ){
-                ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
-            }else if( std::regex_match(ContourOverlapStr, regex_honopps) ){
-                ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
-            }else if( std::regex_match(ContourOverlapStr, regex_cancel) ){
-                ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations;
-            }else{
-                throw std::invalid_argument("ContourOverlap argument '"_s + ContourOverlapStr + "' is not valid");
-            }
-            if( std::regex_match(InclusivityStr, regex_centre) ){
-                ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
-            }else if( std::regex_match(InclusivityStr, regex_pci) ){
-                ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
-            }else if( std::regex_match(InclusivityStr, regex_pce) ){
-                ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Exclusive;
-            }else{
-                throw std::invalid_argument("Inclusivity argument '"_s + InclusivityStr + "' is not valid");
+// Invokes f(voxel_val) for the selected channel(s) of every voxel in the spans.
+template <class F>
+void visit_spans(const planar_image<float,double> &img, const voxel_inclusion_mask &mask, long int channel, F f){
+    if(img.channels <= channel) return;
+    const auto c_begin = (channel < 0) ? 0L : channel;
+    const auto c_end = (channel < 0) ? img.channels : (channel + 1);
+    for(long int row = 0; row < img.rows; ++row){
+        for(auto r = mask.row_offsets[row]; r < mask.row_offsets[row + 1]; ++r){
+            const auto run_end = static_cast<long int>(mask.runs[r][1]);
+            for(auto col = static_cast<long int>(mask.runs[r][0]); col < run_end; ++col){
+                for(long int chnl = c_begin; chnl < c_end; ++chnl) f(img.value(row, col, chnl));
             }
+        }
+    }
+    return;
+}
 
-            ud.f_unbounded = f_noop;
-            ud.f_visitor = f_noop;
-            ud.f_bounded = [&]( long int /*row*/,
-                                long int /*col*/,
-                                long int chan,
-                                std::reference_wrapper<planar_image<float,double>> /*img_refw*/,
-                                float &voxel_val ) -> void {
-                if( (Channel < 0) || (Channel == chan) ){
-                    std::lock_guard<std::mutex> lock(voxel_vals_access);
-                    voxel_vals.emplace_back(voxel_val);
-                }
-                return;
-            };
-
-            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                              PartitionedImageVoxelVisitorMutator,
-                                                              {}, cc_ROIs, &ud )){
-                throw std::runtime_error("Unable to generate a histogram from the specified ROI(s).");
-            }
+// Finds the Otsu thresholds of the voxels bounded by the masks, in ascending order. The histogram is accumulated in
+// parallel, with one histogram per contiguous chunk of images, and the chunks are merged in order so the result does
+// not depend on scheduling. Returns nothing if no finite voxels are bounded.
+std::optional<std::vector<double>>
+find_otsu_thresholds(const std::vector<const planar_image<float,double> *> &imgs,
+                     const std::vector<std::shared_ptr<const voxel_inclusion_mask>> &masks,
+                     const otsu_params &p){
+    const auto N = static_cast<long int>(imgs.size());
+    const auto chunks = std::min(N, std::max<long int>(1, work_stealing_pool::get().concurrency()));
+    if(chunks == 0) return std::nullopt;
+    const auto chunk_begin = [=](long int c) -> long int { return (N * c) / chunks; };
+
+    // The bins span the extrema, so they are found first.
+    std::vector<std::pair<double, double>> extrema(chunks, { std::numeric_limits<double>::infinity(),
+                                                             -std::numeric_limits<double>::infinity() });
+    parallel_for(0, chunks, [&](long int c) -> void {
+        auto &[lo, hi] = extrema[c];
+        for(auto i = chunk_begin(c); i < chunk_begin(c + 1); ++i){
+            visit_spans(*(imgs[i]), *(masks[i]), p.Channel, [&](float v) -> void {
+                if(!std::isfinite(v)) return;
+                lo = std::min(lo, static_cast<double>(v));
+                hi = std::max(hi, static_cast<double>(v));
+            });
+        }
+    }, 1);
+    auto lo = std::numeric_limits<double>::infinity();
+    auto hi = -lo;
+    for(const auto &e : extrema){
+        lo = std::min(lo, e.first);
+        hi = std::max(hi, e.second);
+    }
+    if(!(lo <= hi)) return std::nullopt;
+
+    const auto bins = static_cast<size_t>(p.HistogramBins);
+    const auto width = (lo < hi) ? (hi - lo) / static_cast<double>(bins) : 1.0;
+    std::vector<fixed_bin_histogram> hists(chunks, fixed_bin_histogram(lo, width, bins));
+    parallel_for(0, chunks, [&](long int c) -> void {
+        auto &hist = hists[c];
+        for(auto i = chunk_begin(c); i < chunk_begin(c + 1); ++i){
+            visit_spans(*(imgs[i]), *(masks[i]), p.Channel, [&](float v) -> void {
+                hist.digest(static_cast<double>(v));
+            });
         }
+    }, 1);
+    for(long int c = 1; c < chunks; ++c) hists.front().merge(hists[c]);
 
+    std::vector<double> thresholds;
+    for(const auto &b : Otsu_Threshold_Bins(hists.front(), static_cast<size_t>(p.ThresholdCount))){
+        thresholds.push_back(hists.front().bin_lower(b));
+    }
+    return thresholds;
+}
 
-        // Generate a histogram.
-        if(voxel_vals.empty()){
-            throw std::invalid_argument("No voxels were selected; unable to perform Otsu thresholding.");
+// Finds the thresholds for the bounded voxels of an image array. If requested, returns nothing unless the selected
+// channel of every voxel is bounded.
+std::optional<std::vector<double>>
+find_otsu_thresholds(const Image_Array &ia, const otsu_params &p, bool require_whole_images = false){
+    std::vector<const planar_image<float,double> *> imgs;
+    for(const auto &img : ia.imagecoll.images) imgs.push_back( &img );
+
+    std::vector<std::shared_ptr<const voxel_inclusion_mask>> masks(imgs.size());
+    parallel_for(0, static_cast<long int>(imgs.size()), [&](long int i) -> void {
+        masks[i] = Get_Voxel_Inclusion_Mask(*(imgs[i]), p.cc_ROIs, p.mutation_opts);
+    }, 1);
+
+    if(require_whole_images){
+        for(size_t i = 0; i < imgs.size(); ++i){
+            if( (masks[i]->count() != (imgs[i]->rows * imgs[i]->columns))
+            ||  (imgs[i]->channels <= p.Channel) ) return std::nullopt;
         }
-        const bool ExplicitBins = false;
-        const samples_1D<double> hist = Bag_of_numbers_to_N_equal_bin_samples_1D_histogram(voxel_vals, HistogramBins, ExplicitBins);
+    }
+    return find_otsu_thresholds(imgs, masks, p);
+}
 
-        // Write the histogram to a file for inspection/debugging.
-        if(false){
-            if(!hist.Write_To_File("/tmp/histogram.dat")){
-                throw std::runtime_error("Unable to write histogram to file. Cannot continue.");
-            }
-        }
+// The values assigned to each class, evenly spaced from low to high.
+std::vector<double> class_replacements(const otsu_params &p){
+    const auto K = p.ThresholdCount;
+    std::vector<double> out;
+    for(long int k = 0; k <= K; ++k){
+        const auto t = static_cast<double>(k) / static_cast<double>(K);
+        out.push_back( (k == 0) ? p.ReplacementLow
+                     : ( (k == K) ? p.ReplacementHigh
+                                  : p.ReplacementLow + t * (p.ReplacementHigh - p.ReplacementLow) ) );
+    }
+    return out;
+}
+
+std::map<std::string, std::string> threshold_metadata(const std::vector<double> &thresholds){
+    std::map<std::string, std::string> out;
+    out["OtsuThreshold"] = std::to_string(thresholds.front());
+    if(1 < thresholds.size()){
+        std::string all;
+        for(const auto &t : thresholds) all += (all.empty() ? "" : "\\") + std::to_string(t);
+        out["OtsuThresholds"] = all;
+    }
+    return out;
+}
+
+std::string threshold_description(const otsu_params &p){
+    return (p.ThresholdCount == 1) ? "Otsu thresholded (binarized)"
+                                   : "Otsu thresholded (" + std::to_string(p.ThresholdCount + 1) + " classes)";
+}
+
+// Replaces each voxel with the value of its class. Voxels below (exclusive) the lowest threshold are in the first
+// class.
+struct otsu_classifier {
+    std::vector<float> thresholds;
+    std::vector<float> replacements;
+
+    otsu_classifier(const std::vector<double> &t, const std::vector<double> &r)
+      : thresholds(std::begin(t), std::end(t)), replacements(std::begin(r), std::end(r)) {}
+
+    void operator()(float &voxel_val) const {
+        size_t k = 0;
+        while( (k < this->thresholds.size()) && !(voxel_val < this->thresholds[k]) ) ++k;
+        voxel_val = this->replacements[k];
+    }
+};
+
+} // namespace
+
+
+Drover ThresholdOtsu(Drover DICOM_data,
+                     const OperationArgPkg& OptArgs,
+                     const std::map<std::string, std::string>&
+                     /*InvocationMetadata*/,
+                     const std::string& FilenameLex){
 
-        // Compute the Otsu threshold.
-        const auto f_threshold = hist.Find_Otsu_Binarization_Threshold();
+    const lexicon_translator X(FilenameLex);
+    const auto p = parse_otsu_params(DICOM_data, OptArgs);
 
-        FUNCINFO("Otsu threshold found to be " << f_threshold);
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, p.ImageSelectionStr );
+    for(auto & iap_it : IAs){
+        if((*iap_it)->imagecoll.images.empty()) continue;
 
-        // ==========================================================
+        // First-pass: histogram the bounded voxels and find the threshold(s).
+        const auto thresholds = find_otsu_thresholds(*(*iap_it), p);
+        if(!thresholds){
+            throw std::invalid_argument("No voxels were selected; unable to perform Otsu thresholding.");
+        }
+        for(const auto &t : thresholds.value()) FUNCINFO("Otsu threshold found to be " << t);
 
         // Imbue the images with the threshold.
+        const auto metadata = threshold_metadata(thresholds.value());
         for(auto &animg : (*iap_it)->imagecoll.images){
-            animg.metadata["OtsuThreshold"] = std::to_string(f_threshold);
+            for(const auto &kv : metadata) animg.metadata[kv.first] = kv.second;
         }
 
         // Second-pass: binarize voxels according to the threshold, if desired.
-        if( std::regex_match(OverwriteVoxelsStr, regex_true) ){
-            PartitionedImageVoxelVisitorMutatorUserData ud;
-
-            ud.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
-            ud.mutation_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
-            ud.mutation_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
-            ud.mutation_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
-            ud.description = "Otsu thresholded (binarized)";
-
-            if( std::regex_match(ContourOverlapStr, regex_ignore) ){
-                ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
-            }else if( std::regex_match(ContourOverlapStr, regex_honopps) ){
-                ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
-            }else if( std::regex_match(ContourOverlapStr, regex_cancel) ){
-                ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations;
-            }else{
-                throw std::invalid_argument("ContourOverlap argument '"_s + ContourOverlapStr + "' is not valid");
-            }
-            if( std::regex_match(InclusivityStr, regex_centre) ){
-                ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
-            }else if( std::regex_match(InclusivityStr, regex_pci) ){
-                ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
-            }else if( std::regex_match(InclusivityStr, regex_pce) ){
-                ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Exclusive;
-            }else{
-                throw std::invalid_argument("Inclusivity argument '"_s + InclusivityStr + "' is not valid");
-            }
-
-            ud.f_unbounded = f_noop;
-            ud.f_visitor = f_noop;
-            ud.f_bounded = [&]( long int /*row*/,
-                                long int /*col*/,
-                                long int chan,
-                                std::reference_wrapper<planar_image<float,double>> /*img_refw*/,
-                                float &voxel_val ) -> void {
-                if( (Channel < 0) || (Channel == chan) ){
-                    voxel_val = (voxel_val < f_threshold) ? ReplacementLow
-                                                          : ReplacementHigh;
-                }
-                return;
-            };
-
-            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                              PartitionedImageVoxelVisitorMutator,
-                                                              {}, cc_ROIs, &ud )){
-                throw std::runtime_error("Unable to implement Otsu thresholding within the specified ROI(s).");
-            }
+        if(p.OverwriteVoxels){
+            // Binarization only needs the voxel value, so the span-based mutator is used.
+            const otsu_classifier f_binarize(thresholds.value(), class_replacements(p));
+            using ud_t = PartitionedImageVoxelSpanMutatorUserData<otsu_classifier>;
+            ud_t ud(f_binarize);
+            ud.channel = p.Channel;
+            ud.mutation_opts = p.mutation_opts;
+            ud.description = threshold_description(p);
+
+            Mutate_Voxel_Spans_Balanced( (*iap_it)->imagecoll, p.cc_ROIs, ud );
         }
-
     }
 
-
     return DICOM_data;
 }
 
+
+std::optional<pointwise_stage> PointwiseStageThresholdOtsu(Drover &DICOM_data, const OperationArgPkg& OptArgs){
+    const auto p = parse_otsu_params(DICOM_data, OptArgs);
+    if(!p.OverwriteVoxels) return std::nullopt;
+
+    // Only whole, resident images of a single array can be thresholded without reference to the ROIs.
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, p.ImageSelectionStr );
+    if( (IAs.size() != 1)
+    ||  ((*IAs.front())->get_page_store() != nullptr)
+    ||  (*IAs.front())->imagecoll.images.empty() ) return std::nullopt;
+
+    const auto thresholds = find_otsu_thresholds(*(*IAs.front()), p, true);
+    if(!thresholds) return std::nullopt;
+
+    pointwise_stage stage;
+    stage.name = "ThresholdOtsu";
+    stage.channel = p.Channel;
+    stage.arrays.push_back(*IAs.front());
+
+    const otsu_classifier f_binarize(thresholds.value(), class_replacements(p));
+    stage.transform = [=](float *vals, size_t n, size_t stride, Stats::Running_MinMax<float> &minmax) -> void {
+        for(size_t i = 0; i < n; ++i){
+            auto &v = vals[i * stride];
+            f_binarize(v);
+            minmax.Digest(v);
+        }
+    };
+    stage.description = threshold_description(p);
+    stage.update_window = true;
+    stage.metadata = threshold_metadata(thresholds.value());
+    return stage;
+}
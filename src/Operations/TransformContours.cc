@@ -133,74 +133,74 @@ Drover TransformContours(const Drover& DICOM_data,
     }
     FUNCINFO("Selected " << cc_ROIs.size() << " contours");
 
-    for(auto & cc_refw : cc_ROIs){
+    // Applies the mapping to every vertex of the selected contours, processing contours in parallel.
+    const auto apply_to_vertices = [&](const auto &f) -> void {
+        std::vector<contour_of_points<double> *> contours;
+        for(auto & cc_refw : cc_ROIs){
+            for(auto &c : cc_refw.get().contours) contours.emplace_back( &c );
+        }
+        parallel_for(0, static_cast<long int>(contours.size()), [&](long int i) -> void {
+            for(auto &v : contours[i]->points) v = f(v);
+        });
+    };
 
-        // Translations.
-        if(std::regex_match(TransformStr, regex_trn)){
-            auto numbers = extract_function_parameters(TransformStr);
-            if(numbers.size() != 3){
-                throw std::invalid_argument("Unable to parse translation parameters. Cannot continue.");
-            }
-            const auto Tr = vec3<double>( numbers.at(0),
+    // Translations.
+    if(std::regex_match(TransformStr, regex_trn)){
+        auto numbers = extract_function_parameters(TransformStr);
+        if(numbers.size() != 3){
+            throw std::invalid_argument("Unable to parse translation parameters. Cannot continue.");
+        }
+        const auto Tr = vec3<double>( numbers.at(0),
+                                      numbers.at(1),
+                                      numbers.at(2) );
+        if(!Tr.isfinite()) throw std::invalid_argument("Translation vector invalid. Cannot continue.");
+
+        // Implement the transformation.
+        apply_to_vertices([&](const vec3<double> &v) -> vec3<double> {
+            return v + Tr;
+        });
+
+    // Scaling.
+    }else if(std::regex_match(TransformStr, regex_scl)){
+        auto numbers = extract_function_parameters(TransformStr);
+        if(numbers.size() != 4){
+            throw std::invalid_argument("Unable to parse scale parameters. Cannot continue.");
+        }
+        const auto centre = vec3<double>( numbers.at(0),
                                           numbers.at(1),
                                           numbers.at(2) );
-            if(!Tr.isfinite()) throw std::invalid_argument("Translation vector invalid. Cannot continue.");
-
-            // Implement the transformation.
-            for(auto &c : cc_refw.get().contours){
-                for(auto &v : c.points){
-                    v += Tr;
-                }
-            }
-
-        // Scaling.
-        }else if(std::regex_match(TransformStr, regex_scl)){
-            auto numbers = extract_function_parameters(TransformStr);
-            if(numbers.size() != 4){
-                throw std::invalid_argument("Unable to parse scale parameters. Cannot continue.");
-            }
-            const auto centre = vec3<double>( numbers.at(0),
-                                              numbers.at(1),
-                                              numbers.at(2) );
-            const auto factor = numbers.at(3);
-            if(!centre.isfinite()) throw std::invalid_argument("Scale centre invalid. Cannot continue.");
-            if(!std::isfinite(factor)) throw std::invalid_argument("Scale factor invalid. Cannot continue.");
-
-            for(auto &c : cc_refw.get().contours){
-                for(auto &v : c.points){
-                    const auto R = v - centre;
-                    v = centre + (R * factor);
-                }
-            }
-
-        // Rotations.
-        }else if(std::regex_match(TransformStr, regex_rot)){
-            auto numbers = extract_function_parameters(TransformStr);
-            if(numbers.size() != 7){
-                throw std::invalid_argument("Unable to parse rotation parameters. Cannot continue.");
-            }
-            const auto centre = vec3<double>( numbers.at(0),
-                                              numbers.at(1),
-                                              numbers.at(2) );
-            const auto axis = vec3<double>( numbers.at(3),
-                                            numbers.at(4),
-                                            numbers.at(5) ).unit();
-            const auto angle = numbers.at(6);
-            if(!centre.isfinite()) throw std::invalid_argument("Rotation centre invalid. Cannot continue.");
-            if(!axis.isfinite()) throw std::invalid_argument("Rotation axis invalid. Cannot continue.");
-            if(!std::isfinite(angle)) throw std::invalid_argument("Rotation angle invalid. Cannot continue.");
-
-            for(auto &c : cc_refw.get().contours){
-                for(auto &v : c.points){
-                    v = v - centre;
-                    v = v.rotate_around_unit(axis, angle); 
-                    v = v + centre;
-                }
-            }
-
-        }else{
-            throw std::invalid_argument("Transformation not understood. Cannot continue.");
+        const auto factor = numbers.at(3);
+        if(!centre.isfinite()) throw std::invalid_argument("Scale centre invalid. Cannot continue.");
+        if(!std::isfinite(factor)) throw std::invalid_argument("Scale factor invalid. Cannot continue.");
+
+        apply_to_vertices([&](const vec3<double> &v) -> vec3<double> {
+            const auto R = v - centre;
+            return centre + (R * factor);
+        });
+
+    // Rotations.
+    }else if(std::regex_match(TransformStr, regex_rot)){
+        auto numbers = extract_function_parameters(TransformStr);
+        if(numbers.size() != 7){
+            throw std::invalid_argument("Unable to parse rotation parameters. Cannot continue.");
         }
+        const auto centre = vec3<double>( numbers.at(0),
+                                          numbers.at(1),
+                                          numbers.at(2) );
+        const auto axis = vec3<double>( numbers.at(3),
+                                        numbers.at(4),
+                                        numbers.at(5) ).unit();
+        const auto angle = numbers.at(6);
+        if(!centre.isfinite()) throw std::invalid_argument("Rotation centre invalid. Cannot continue.");
+        if(!axis.isfinite()) throw std::invalid_argument("Rotation axis invalid. Cannot continue.");
+        if(!std::isfinite(angle)) throw std::invalid_argument("Rotation angle invalid. Cannot continue.");
+
+        apply_to_vertices([&](const vec3<double> &v) -> vec3<double> {
+            return (v - centre).rotate_around_unit(axis, angle) + centre;
+        });
+
+    }else{
+        throw std::invalid_argument("Transformation not understood. Cannot continue.");
     }
 
     return DICOM_data;
@@ -15,10 +15,15 @@
 #include <string>    
 #include <utility>            //Needed for std::pair.
 #include <vector>
+#include <variant>
+#include <limits>
+#include <functional>
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../Alignment_Field.h"
+#include "../YgorImages_Functors/Rectilinear_Volume.h"
 #include "TransformImages.h"
 #include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
@@ -34,7 +39,8 @@ OperationDoc OpArgDocTransformImages(){
     out.name = "TransformImages";
 
     out.desc = 
-        "This operation transforms images by translating, scaling, and rotating the positions of voxels.";
+        "This operation transforms images by translating, scaling, and rotating the positions of voxels, or by"
+        " resampling voxel values through a deformation field.";
         
     out.notes.emplace_back(
         "A single transformation can be specified at a time. Perform this operation sequentially to enforce order."
@@ -65,12 +71,25 @@ OperationDoc OpArgDocTransformImages(){
                            " the rotation centre 3-vector, the rotation axis 3-vector, and the rotation angle"
                            " in radians. A rotation of pi radians around the axis line parallel to vector"
                            " $(1.0, 0.0, 0.0)$ that intersects the point $(4.0, 5.0, 6.0)$ can be specified"
-                           " as 'rotate(4.0, 5.0, 6.0,  1.0, 0.0, 0.0,  3.141592653)'.";
+                           " as 'rotate(4.0, 5.0, 6.0,  1.0, 0.0, 0.0,  3.141592653)'."
+                           " Images can also be warped using a deformation field transformation (e.g., from a"
+                           " deformable image registration) selected via the TransformSelection parameter."
+                           " The image geometry is retained, and voxel values are resampled from the original"
+                           " images using trilinear interpolation. Voxels that map outside of the original images"
+                           " are set to NaN. Warping can be specified as 'warp'.";
     out.args.back().default_val = "translate(0.0, 0.0, 0.0)";
     out.args.back().expected = true;
     out.args.back().examples = { "translate(1.0, -2.0, 0.3)",
                                  "scale(1.23, -2.34, 3.45, 2.7)",
-                                 "rotate(4.0, 5.0, 6.0,  1.0, 0.0, 0.0,  3.141592653)" };
+                                 "rotate(4.0, 5.0, 6.0,  1.0, 0.0, 0.0,  3.141592653)",
+                                 "warp" };
+
+    out.args.emplace_back();
+    out.args.back() = T3WhitelistOpArgDoc();
+    out.args.back().name = "TransformSelection";
+    out.args.back().default_val = "last";
+    out.args.back().desc = "The transformation that will be applied when warping. "_s
+                         + out.args.back().desc;
 
     return out;
 }
@@ -86,12 +105,14 @@ Drover TransformImages(Drover DICOM_data,
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
 
     const auto TransformStr = OptArgs.getValueStr("Transform").value();
+    const auto TFormSelectionStr = OptArgs.getValueStr("TransformSelection").value();
 
     //-----------------------------------------------------------------------------------------------------------------
 
     const auto regex_trn = Compile_Regex("^tr?a?n?s?l?a?t?e?.*$");
     const auto regex_scl = Compile_Regex("^sc?a?l?e?.*$");
     const auto regex_rot = Compile_Regex("^ro?t?a?t?.*$");
+    const auto regex_wrp = Compile_Regex("^wa?r?p?.*$");
 
     const vec3<double> vec3_nan( std::numeric_limits<double>::quiet_NaN(),
                                  std::numeric_limits<double>::quiet_NaN(),
@@ -191,6 +212,43 @@ Drover TransformImages(Drover DICOM_data,
                                     new_offset );
             }
 
+        // Warps.
+        }else if(std::regex_match(TransformStr, regex_wrp)){
+            auto T3s_all = All_T3s( DICOM_data );
+            auto T3s = Whitelist( T3s_all, TFormSelectionStr );
+            if(T3s.size() != 1){
+                throw std::invalid_argument("A single transformation must be selected. Cannot continue.");
+            }
+            const auto *field = std::get_if<deformation_field>( &((*T3s.front())->transform) );
+            if(field == nullptr){
+                throw std::invalid_argument("Only deformation field transformations can be used to warp images. Cannot continue.");
+            }
+
+            // Voxel values are sampled from a packed copy of the original images.
+            auto &imagecoll = (*iap_it)->imagecoll;
+            if(imagecoll.images.empty()) continue;
+            const auto orientation_normal = imagecoll.images.front().image_plane().N_0.unit();
+            const auto vol = pack_along_normal(imagecoll, orientation_normal);
+            if(!vol.is_regular){
+                throw std::invalid_argument("Images are not evenly spaced. Cannot continue.");
+            }
+
+            std::vector<std::reference_wrapper<planar_image<float,double>>> imgs;
+            for(auto &animg : imagecoll.images) imgs.emplace_back( std::ref(animg) );
+            parallel_for(0, static_cast<long int>(imgs.size()), [&](long int i) -> void {
+                auto &animg = imgs[i].get();
+                std::vector<vec3<double>> pos(animg.columns);
+                for(long int row = 0; row < animg.rows; ++row){
+                    field->pull_back( animg.position(row, 0), animg.col_unit * animg.pxl_dy, animg.columns, pos.data() );
+                    for(long int col = 0; col < animg.columns; ++col){
+                        for(long int chnl = 0; chnl < animg.channels; ++chnl){
+                            animg.reference(row, col, chnl) = vol.interpolate(pos[col], chnl,
+                                                                              std::numeric_limits<float>::quiet_NaN());
+                        }
+                    }
+                }
+            }, /*grain=*/ 1);
+
         }else{
             throw std::invalid_argument("Transformation not understood. Cannot continue.");
         }
@@ -123,6 +123,13 @@ Drover TransformMeshes(Drover DICOM_data,
     const auto sm_count = SMs.size();
     FUNCINFO("Selected " << sm_count << " meshes");
 
+    // Applies the mapping to every vertex of the mesh in parallel.
+    const auto apply_to_vertices = [](std::vector<vec3<double>> &vertices, const auto &f) -> void {
+        parallel_for(0, static_cast<long int>(vertices.size()), [&](long int i) -> void {
+            vertices[i] = f(vertices[i]);
+        });
+    };
+
     long int completed = 0;
     for(auto & smp_it : SMs){
 
@@ -138,9 +145,9 @@ Drover TransformMeshes(Drover DICOM_data,
             if(!Tr.isfinite()) throw std::invalid_argument("Translation vector invalid. Cannot continue.");
 
             // Implement the transformation.
-            for(auto &v : (*smp_it)->meshes.vertices){
-                v += Tr;
-            }
+            apply_to_vertices((*smp_it)->meshes.vertices, [&](const vec3<double> &v) -> vec3<double> {
+                return v + Tr;
+            });
 
         // Scaling.
         }else if(std::regex_match(TransformStr, regex_scl)){
@@ -155,10 +162,10 @@ Drover TransformMeshes(Drover DICOM_data,
             if(!centre.isfinite()) throw std::invalid_argument("Scale centre invalid. Cannot continue.");
             if(!std::isfinite(factor)) throw std::invalid_argument("Scale factor invalid. Cannot continue.");
 
-            for(auto &v : (*smp_it)->meshes.vertices){
+            apply_to_vertices((*smp_it)->meshes.vertices, [&](const vec3<double> &v) -> vec3<double> {
                 const auto R = v - centre;
-                v = centre + (R * factor);
-            }
+                return centre + (R * factor);
+            });
 
         // Rotations.
         }else if(std::regex_match(TransformStr, regex_rot)){
@@ -177,11 +184,9 @@ Drover TransformMeshes(Drover DICOM_data,
             if(!axis.isfinite()) throw std::invalid_argument("Rotation axis invalid. Cannot continue.");
             if(!std::isfinite(angle)) throw std::invalid_argument("Rotation angle invalid. Cannot continue.");
 
-            for(auto &v : (*smp_it)->meshes.vertices){
-                v = v - centre;
-                v = v.rotate_around_unit(axis, angle); 
-                v = v + centre;
-            }
+            apply_to_vertices((*smp_it)->meshes.vertices, [&](const vec3<double> &v) -> vec3<double> {
+                return (v - centre).rotate_around_unit(axis, angle) + centre;
+            });
 
         }else{
             throw std::invalid_argument("Transformation not understood. Cannot continue.");
@@ -65,9 +65,8 @@ OperationDoc OpArgDocVolumetricSpatialBlur(){
     out.args.emplace_back();
     out.args.back().name = "Estimator";
     out.args.back().desc = "Controls which type of blur is computed."
-                           " Currently, 'Gaussian' refers to a fixed sigma=1 (in pixel coordinates, not DICOM units)"
-                           " Gaussian blur that extends for 3*sigma thus providing a 7x7x7 window."
-                           " Note that applying this kernel N times will approximate a Gaussian with sigma=N."
+                           " Currently, 'Gaussian' refers to a Gaussian blur (in pixel coordinates, not DICOM units)"
+                           " that extends for 3*sigma, e.g., providing a 7x7x7 window for sigma=1."
                            " Also note that boundary voxels will cause accessible voxels within the same window to be more"
                            " heavily weighted. Try avoid boundaries or add extra margins if possible.";
     out.args.back().default_val = "Gaussian";
@@ -75,6 +74,35 @@ OperationDoc OpArgDocVolumetricSpatialBlur(){
     out.args.back().examples = { "Gaussian" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
+
+    out.args.emplace_back();
+    out.args.back().name = "Sigma";
+    out.args.back().desc = "The Gaussian sigma, in pixel coordinates (not DICOM units)."
+                           " Large sigmas are supported efficiently; the cost is independent of sigma when the"
+                           " recursive method is used.";
+    out.args.back().default_val = "1.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.5",
+                                 "1.0",
+                                 "5.0",
+                                 "25.0" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "Controls how the blur is computed."
+                           " 'Separable' applies three successive 1D (finite) Gaussian kernels."
+                           " 'Recursive' applies three successive 1D recursive (i.e., infinite impulse response)"
+                           " Gaussian filters, which approximate the Gaussian slightly less accurately but have a"
+                           " cost that does not depend on sigma."
+                           " 'Automatic' uses separable kernels for small sigmas and recursive filters for large sigmas.";
+    out.args.back().default_val = "automatic";
+    out.args.back().expected = true;
+    out.args.back().examples = { "automatic",
+                                 "separable",
+                                 "recursive" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -93,10 +121,27 @@ Drover VolumetricSpatialBlur(Drover DICOM_data,
     const auto Channel = std::stol( OptArgs.getValueStr("Channel").value() );
 
     const auto EstimatorStr = OptArgs.getValueStr("Estimator").value();
+    const auto Sigma = std::stod( OptArgs.getValueStr("Sigma").value() );
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_gauss = Compile_Regex("^ga?u?s?s?i?a?n?$");
 
+    const auto regex_auto = Compile_Regex("^au?t?o?m?a?t?i?c?$");
+    const auto regex_sepr = Compile_Regex("^se?p?a?r?a?b?l?e?$");
+    const auto regex_recr = Compile_Regex("^re?c?u?r?s?i?v?e?$");
+
+    auto method = volume_convolution::method_t::Automatic;
+    if(std::regex_match(MethodStr, regex_auto)){
+        method = volume_convolution::method_t::Automatic;
+    }else if(std::regex_match(MethodStr, regex_sepr)){
+        method = volume_convolution::method_t::Separable;
+    }else if(std::regex_match(MethodStr, regex_recr)){
+        method = volume_convolution::method_t::Recursive;
+    }else{
+        throw std::invalid_argument("Method not understood. Refusing to continue.");
+    }
+
     auto cc_all = All_CCs( DICOM_data );
     auto cc_ROIs = Whitelist( cc_all, { { "ROIName", ROILabelRegex },
                                         { "NormalizedROIName", NormalizedROILabelRegex } } );
@@ -111,6 +156,8 @@ Drover VolumetricSpatialBlur(Drover DICOM_data,
         // Planar derivatives.
         ComputeVolumetricSpatialBlurUserData ud;
         ud.channel = Channel;
+        ud.sigma = Sigma;
+        ud.method = method;
         if(std::regex_match(EstimatorStr, regex_gauss)){
             ud.estimator = VolumetricSpatialBlurEstimator::Gaussian;
         }else{
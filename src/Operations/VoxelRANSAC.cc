@@ -1,6 +1,9 @@
 //VoxelRANSAC.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
+#include <algorithm>
 #include <any>
+#include <cmath>
+#include <limits>
 #include <optional>
 #include <functional>
 #include <iterator>
@@ -8,6 +11,7 @@
 #include <map>
 #include <mutex>
 #include <memory>
+#include <random>
 #include <regex>
 #include <stdexcept>
 #include <string>    
@@ -39,10 +43,12 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Parallel_RANSAC.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Image_Tiling.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
 
 #include "VoxelRANSAC.h"
@@ -248,9 +254,9 @@ Drover VoxelRANSAC(Drover DICOM_data,
         };
 
         // Locate voxels to consider.
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
+        if(!Process_Images_Balanced( (*iap_it)->imagecoll,
+                                     PartitionedImageVoxelVisitorMutator,
+                                     {}, cc_ROIs, &ud )){
             throw std::runtime_error("Unable to locate voxels to be used for RANSAC.");
         }
         const long int BeforeCount = p.size();
@@ -428,8 +434,8 @@ Drover VoxelRANSAC(Drover DICOM_data,
 */
         // Stage 1: grid orientation estimation.
         //
-        // The local neighbourhood surrounding each vertex needs to be queryable, so an r*-tree is used to index the
-        // vertices.
+        // The local neighbourhood surrounding each vertex needs to be queryable, so the vertices are bucketed into
+        // cells about one grid separation wide.
 
 /*
 using SpatialType = double;
@@ -458,57 +464,32 @@ std::array<SpatialType, SpatialDimensionCount> Coordinates;
 */
 
 
-        // DBSCAN setup.
-        constexpr size_t MaxElementsInANode = 6; // 16, 32, 128, 256, ... ?
-        using RTreeParameter_t = boost::geometry::index::rstar<MaxElementsInANode>;
+        const ransac_cell_index index(p, GridSeparation);
 
-        using UserData_t = uint8_t; //std::pair< planar_image<float,double>*, long int >;
-        using CDat_t = ClusteringDatum<3, double, // Spatial dimensions.
-                                       0, double, // Attribute dimensions (not used).
-                                       uint8_t,  // Cluster ID type.
-                                       UserData_t>;
-        //typedef boost::geometry::model::box<CDat_t> Box_t;
-        using RTree_t = boost::geometry::index::rtree<CDat_t,RTreeParameter_t>;
-
-
-        RTree_t rtree;
-        for(const auto &v : p){
-            rtree.insert(CDat_t({ v.x, v.y, v.z }));
-        }
-
-/*
-    OnEachDatum<RTree_t,CDat_t,std::function<void(const typename RTree_t::const_query_iterator &)>>(rtree,
-        [&ClusterIDMap,&ClusterIDUniques](const typename RTree_t::const_query_iterator &it) -> void {
-            ClusterIDMap[ it->UserData ] = it->CID;
-            ClusterIDUniques.insert( it->CID );
-        });
-*/
         long int random_seed = 11;
         std::mt19937 re( random_seed );
 
         std::vector<vec3<double>> samples;
         std::sample(std::begin(p), std::end(p), std::back_inserter(samples), 100, re);
 
-        // Query the local neighbourhood for the nearest N vertices. Remember that the self will be present and we
-        // cannot derive any useful orientation from it. 
+        // Query the local neighbourhood for the nearest N vertices. Remember that the self (and any coincident
+        // vertices) will be present and we cannot derive any useful orientation from them.
         const long int N_neighbours = 6; // legitimate neighbours.
         const double min_separation = 0.1; // minimal distance needed between vertices to consider a pair (in DICOM units; mm).
         std::vector<vec3<double>> unit_vecs;
         for(const auto &v : samples){
-            long int actual_neighbours = 0;
-            constexpr auto RTreeSpatialQueryGetAll = [](const CDat_t &) -> bool { return true; };
-            RTree_t::const_query_iterator it;
-            it = rtree.qbegin(boost::geometry::index::satisfies( RTreeSpatialQueryGetAll ));
-            for( ; it != rtree.qend(); ++it){
-                const auto l_v = vec3<double>( std::get<0>(it->Coordinates),
-                                               std::get<1>(it->Coordinates),
-                                               std::get<2>(it->Coordinates) );
-                // Check if the point is separated a reasonable distance away.
-                const auto d = v.distance(l_v);
-                if(d > min_separation) continue;
-                
+            std::vector<std::pair<double, size_t>> nearby;
+            for(const auto i : index.within(v, 1.5 * GridSeparation)){
+                const auto d = v.distance(p[i]);
+                if(d <= min_separation) continue;
+                nearby.emplace_back(d, i);
+            }
+            const auto n = std::min<size_t>(N_neighbours, nearby.size());
+            std::partial_sort(std::begin(nearby), std::next(std::begin(nearby), n), std::end(nearby));
+
+            for(size_t j = 0; j < n; ++j){
                 // Estimate the unit vector between vertices.
-                auto U = (v - l_v).unit();
+                auto U = (v - p[nearby[j].second]).unit();
 
                 // Ensure it points along the positive direction, reversing it if necessary.
                 // This approach does not result in any loss of generality.
@@ -517,9 +498,6 @@ std::array<SpatialType, SpatialDimensionCount> Coordinates;
                 if(U.z < 0.0) U.z *= -1.0;
 
                 unit_vecs.push_back(U);
-
-                ++actual_neighbours;
-                if(actual_neighbours >= N_neighbours) break;
             }
         }
 
@@ -554,6 +532,33 @@ std::array<SpatialType, SpatialDimensionCount> Coordinates;
 
         FUNCINFO(" grid units:  " << grid_u_a << ", " << grid_u_b << ", " << grid_u_c );
 
+        // Locate the most prominent plane of vertices, which should coincide with one of the grid planes.
+        {
+            ransac_parameters params;
+            params.sample_size = 3;
+            params.inlier_distance = 0.1 * GridSeparation;
+            params.max_hypotheses = 50'000;
+            params.seed = random_seed;
+
+            const auto fit = [](const std::vector<vec3<double>> &s) -> std::optional<plane<double>> {
+                const auto N = (s[1] - s[0]).Cross(s[2] - s[0]);
+                if(!N.isfinite() || (N.length() < std::numeric_limits<double>::min())) return {};
+                return plane<double>(N.unit(), s[0]);
+            };
+            const auto dist = [](const plane<double> &pl, double x, double y, double z) -> double {
+                return std::abs( pl.N_0.Dot(vec3<double>(x, y, z) - pl.R_0) );
+            };
+
+            const auto best = Parallel_RANSAC<plane<double>>(index, params, fit, dist);
+            if(best){
+                FUNCINFO("Most prominent plane has normal " << best->model.N_0 << " and contains "
+                         << best->inliers << " of " << p.size() << " vertices"
+                         << " (" << best->hypotheses << " hypotheses evaluated)");
+            }else{
+                FUNCWARN("Unable to locate a prominent plane");
+            }
+        }
+
 
 
         // Visualize the plane for debugging/development purposes. 
@@ -0,0 +1,133 @@
+//WarpMeshes.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <asio.hpp>
+#include <algorithm>
+#include <optional>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <set> 
+#include <stdexcept>
+#include <string>    
+#include <utility>            //Needed for std::pair.
+#include <vector>
+#include <variant>
+
+#include "Explicator.h"       //Needed for Explicator class.
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorStats.h"        //Needed for Stats:: namespace.
+#include "YgorString.h"       //Needed for GetFirstRegex(...)
+
+#include "../Structs.h"
+#include "../Alignment_TPSRPM.h"
+#include "../Alignment_Field.h"
+#include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
+
+#include "WarpMeshes.h"
+
+OperationDoc OpArgDocWarpMeshes(){
+    OperationDoc out;
+    out.name = "WarpMeshes";
+
+    out.desc = 
+        "This operation applies a vector-valued transformation (e.g., a deformation) to the vertices of a surface mesh.";
+        
+    out.notes.emplace_back(
+        "Transformations are not (generally) restricted to the coordinate frame of reference that they were"
+        " derived from. This permits a single transformation to be applicable to point clouds, surface meshes,"
+        " images, and contours."
+    );
+    out.notes.emplace_back(
+        "Mesh connectivity is not altered. Large or irregular deformations may cause faces to intersect or invert."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = SMWhitelistOpArgDoc();
+    out.args.back().name = "MeshSelection";
+    out.args.back().default_val = "last";
+    out.args.back().desc = "The surface mesh that will be transformed. "_s
+                         + out.args.back().desc;
+
+    out.args.emplace_back();
+    out.args.back() = T3WhitelistOpArgDoc();
+    out.args.back().name = "TransformSelection";
+    out.args.back().default_val = "last";
+    out.args.back().desc = "The transformation that will be applied. "_s
+                         + out.args.back().desc;
+
+    return out;
+}
+
+
+
+Drover WarpMeshes(Drover DICOM_data,
+                  const OperationArgPkg& OptArgs,
+                  const std::map<std::string, std::string>&
+                  /*InvocationMetadata*/,
+                  const std::string& /*FilenameLex*/){
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto MeshSelectionStr = OptArgs.getValueStr("MeshSelection").value();
+    const auto TFormSelectionStr = OptArgs.getValueStr("TransformSelection").value();
+
+    //-----------------------------------------------------------------------------------------------------------------
+
+    auto SMs_all = All_SMs( DICOM_data );
+    auto SMs = Whitelist( SMs_all, MeshSelectionStr );
+    FUNCINFO(SMs.size() << " surface meshes selected");
+
+    auto T3s_all = All_T3s( DICOM_data );
+    auto T3s = Whitelist( T3s_all, TFormSelectionStr );
+    FUNCINFO(T3s.size() << " transformations selected");
+    if(T3s.size() != 1){
+        throw std::invalid_argument("Only a single transformation must be selected to guarantee ordering. Cannot continue.");
+    }
+
+    for(auto & smp_it : SMs){
+        auto &vertices = (*smp_it)->meshes.vertices;
+        FUNCINFO("Processing a surface mesh with " << vertices.size() << " vertices");
+        for(auto & t3p_it : T3s){
+
+            // Apply transformation.
+            std::visit([&](auto && t){
+                using V = std::decay_t<decltype(t)>;
+                if constexpr (std::is_same_v<V, std::monostate>){
+                    throw std::invalid_argument("Transformation is invalid. Unable to continue.");
+
+                // Affine transformations.
+                }else if constexpr (std::is_same_v<V, affine_transform<double>>){
+                    FUNCINFO("Applying affine transformation now");
+                    parallel_for(0, static_cast<long int>(vertices.size()), [&](long int i) -> void {
+                        t.apply_to(vertices[i]);
+                    });
+                    (*smp_it)->meshes.metadata["Description"] = "Warped via affine transform";
+
+                // Thin-plate splines.
+                }else if constexpr (std::is_same_v<V, thin_plate_spline>){
+                    FUNCINFO("Applying thin plate spline transformation now");
+                    t.apply_to((*smp_it)->meshes);
+                    (*smp_it)->meshes.metadata["Description"] = "Warped via thin-plate spline transform";
+
+                // Deformation fields.
+                }else if constexpr (std::is_same_v<V, deformation_field>){
+                    FUNCINFO("Applying deformation field transformation now");
+                    t.apply_to((*smp_it)->meshes);
+                    (*smp_it)->meshes.metadata["Description"] = "Warped via deformation field transform";
+
+                }else{
+                    static_assert(std::is_same_v<V,void>, "Transformation not understood.");
+                }
+                return;
+            }, (*t3p_it)->transform);
+        }
+    }
+ 
+    return DICOM_data;
+}
@@ -26,6 +26,7 @@
 
 #include "../Structs.h"
 #include "../Alignment_TPSRPM.h"
+#include "../Alignment_Field.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 
@@ -99,7 +100,10 @@ Drover WarpPoints(Drover DICOM_data,
                 // Affine transformations.
                 }else if constexpr (std::is_same_v<V, affine_transform<double>>){
                     FUNCINFO("Applying affine transformation now");
-                    t.apply_to((*pcp_it)->pset);
+                    auto &points = (*pcp_it)->pset.points;
+                    parallel_for(0, static_cast<long int>(points.size()), [&](long int i) -> void {
+                        t.apply_to(points[i]);
+                    });
                     (*pcp_it)->pset.metadata["Description"] = "Warped via affine transform";
 
                 // Affine transformations.
@@ -108,6 +112,12 @@ Drover WarpPoints(Drover DICOM_data,
                     t.apply_to((*pcp_it)->pset);
                     (*pcp_it)->pset.metadata["Description"] = "Warped via thin-plate spline transform";
 
+                // Deformation fields.
+                }else if constexpr (std::is_same_v<V, deformation_field>){
+                    FUNCINFO("Applying deformation field transformation now");
+                    t.apply_to((*pcp_it)->pset);
+                    (*pcp_it)->pset.metadata["Description"] = "Warped via deformation field transform";
+
                 }else{
                     static_assert(std::is_same_v<V,void>, "Transformation not understood.");
                 }
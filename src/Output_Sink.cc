@@ -0,0 +1,212 @@
+//Output_Sink.cc - A part of DICOMautomaton 2026.
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/stream.hpp>
+
+#include "YgorFilesDirs.h"
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorTAR.h"
+
+#include "Output_Sink.h"
+
+
+namespace {
+
+bool ends_with(const std::string &s, const std::string &suffix){
+    return (suffix.size() <= s.size())
+        && (s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+bool is_gzipped_archive(const std::string &target){
+    return ends_with(target, ".tar.gz") || ends_with(target, ".tgz");
+}
+
+std::string pad_left_zeros(std::string in, size_t desired_length){
+    if(in.length() < desired_length) in.insert(0, desired_length - in.length(), '0');
+    return in;
+}
+
+} // namespace
+
+
+// The TAR writer is destroyed first so the archive is finalized before the compressor and file are flushed.
+struct output_sink::archive_t {
+    std::ofstream ofs;
+    boost::iostreams::filtering_ostream os;
+    std::unique_ptr<ustar_writer> ustar;
+
+    void close(){
+        this->ustar.reset();
+        this->os.reset();
+        if(this->ofs.is_open()){
+            this->ofs.close();
+            if(!this->ofs) throw std::runtime_error("Unable to finalize archive");
+        }else{
+            std::cout.flush();
+        }
+    }
+};
+
+
+bool output_sink::is_archive_target(const std::string &target){
+    return (target == "-")
+        || ends_with(target, ".tar")
+        || is_gzipped_archive(target);
+}
+
+output_sink::output_sink(const std::string &target,
+                         size_t max_queued_bytes) : max_queued_bytes(max_queued_bytes) {
+    if(target.empty()){
+        throw std::invalid_argument("No output target provided. Cannot continue.");
+    }
+
+    if(!is_archive_target(target)){
+        this->prefix = target + "_";
+
+    }else{
+        // Archive members are named after the archive.
+        std::string stem = "dcma";
+        if(target != "-"){
+            stem = std::filesystem::path(target).filename().string();
+            for(const auto &ext : { ".tar.gz", ".tgz", ".tar" }){
+                if(ends_with(stem, ext)){
+                    stem.resize(stem.size() - std::string(ext).size());
+                    break;
+                }
+            }
+        }
+        this->prefix = stem + "_";
+
+        this->archive = std::make_unique<archive_t>();
+        auto &a = *(this->archive);
+        if(target == "-"){
+            a.os.push(std::cout);
+        }else{
+            a.ofs.open(target, std::ios::out | std::ios::trunc | std::ios::binary);
+            if(!a.ofs) throw std::runtime_error("Unable to open '" + target + "' for writing");
+            if(is_gzipped_archive(target)){
+                boost::iostreams::gzip_params gzparams(boost::iostreams::gzip::best_speed);
+                a.os.push(boost::iostreams::gzip_compressor(gzparams));
+            }
+            a.os.push(a.ofs);
+        }
+        a.ustar = std::make_unique<ustar_writer>(a.os);
+    }
+
+    this->writer = std::thread([this](){ this->write_queued(); });
+}
+
+output_sink::~output_sink(){
+    try{
+        this->finish();
+    }catch(const std::exception &e){
+        FUNCWARN("Unable to complete output: '" << e.what() << "'");
+    }
+}
+
+bool output_sink::is_archive() const {
+    return (this->archive != nullptr);
+}
+
+std::string output_sink::next_name(const std::string &suffix){
+    std::lock_guard<std::mutex> lock(this->m);
+    while(true){
+        const auto name = this->prefix + pad_left_zeros(std::to_string(this->next_index++), 6) + suffix;
+
+        // Numbering continues from the last claimed name, so only names that were never claimed need to be checked.
+        if( this->is_archive()
+        ||  !Does_File_Exist_And_Can_Be_Read(name) ){
+            return name;
+        }
+    }
+}
+
+void output_sink::write(const std::string &name, std::string contents){
+    std::unique_lock<std::mutex> lock(this->m);
+    if(this->finished) throw std::logic_error("Output has already been finished");
+    const auto size = contents.size();
+    this->cv.wait(lock, [&](){
+        return this->error
+            || (this->queued_bytes == 0)
+            || (this->queued_bytes + size <= this->max_queued_bytes);
+    });
+    if(this->error) std::rethrow_exception(this->error);
+
+    this->queue.emplace_back(name, std::move(contents));
+    this->queued_bytes += size;
+    this->cv.notify_all();
+    return;
+}
+
+void output_sink::finish(){
+    {
+        std::lock_guard<std::mutex> lock(this->m);
+        if(this->finished) return;
+        this->finished = true;
+        this->stopping = true;
+    }
+    this->cv.notify_all();
+    if(this->writer.joinable()) this->writer.join();
+
+    if(this->error) std::rethrow_exception(this->error);
+    if(this->archive) this->archive->close();
+    return;
+}
+
+void output_sink::write_queued(){
+    std::unique_lock<std::mutex> lock(this->m);
+    while(true){
+        this->cv.wait(lock, [&](){ return this->stopping || !this->queue.empty(); });
+        if(this->queue.empty()) return;
+
+        auto file = std::move(this->queue.front());
+        this->queue.pop_front();
+        lock.unlock();
+
+        try{
+            this->write_one(file.first, file.second);
+        }catch(const std::exception &){
+            lock.lock();
+            this->error = std::current_exception();
+            this->queue.clear();
+            this->queued_bytes = 0;
+            this->cv.notify_all();
+            return;
+        }
+
+        lock.lock();
+        this->queued_bytes -= file.second.size();
+        this->cv.notify_all();
+    }
+}
+
+void output_sink::write_one(const std::string &name, const std::string &contents){
+    if(this->archive){
+        boost::iostreams::stream<boost::iostreams::array_source> is(contents.data(), contents.size());
+        this->archive->ustar->add_file(is, name, static_cast<long int>(contents.size()));
+        if(!this->archive->os) throw std::runtime_error("Unable to add '" + name + "' to archive");
+
+    }else{
+        std::ofstream ofs(name, std::ios::out | std::ios::trunc | std::ios::binary);
+        ofs.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        ofs.flush();
+        if(!ofs) throw std::runtime_error("Unable to write file '" + name + "'");
+    }
+    return;
+}
+
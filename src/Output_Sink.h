@@ -0,0 +1,68 @@
+//Output_Sink.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+
+// A destination for operations that export many files.
+//
+// The target selects how files are stored:
+//   - '-' writes a TAR archive to stdout,
+//   - a name ending in '.tar', '.tar.gz', or '.tgz' writes a (possibly gzipped) TAR archive,
+//   - anything else is a filename prefix, and each file is written individually.
+//
+// Files are queued and written by a background thread in the order they were added, so preparing the next file can
+// overlap with writing the last one. Write errors are rethrown from the next call to write() or finish().
+class output_sink {
+  public:
+    explicit output_sink(const std::string &target,
+                         size_t max_queued_bytes = 64 * 1024 * 1024);
+    ~output_sink(); // Calls finish(), but only warns on errors.
+
+    output_sink(const output_sink &) = delete;
+    output_sink & operator=(const output_sink &) = delete;
+
+    // Whether the target is an archive (or stdout), rather than a prefix for individual files.
+    static bool is_archive_target(const std::string &target);
+    bool is_archive() const;
+
+    // Claims a unique name for the next file, e.g., 'prefix_000012.fits'. For individual files, this is the full path
+    // of the first sequentially-numbered file that does not yet exist. For archives, it is the member name.
+    std::string next_name(const std::string &suffix);
+
+    // Queues a file for writing. Blocks while the queue is full.
+    void write(const std::string &name, std::string contents);
+
+    // Blocks until all queued files have been written and the archive, if any, has been finalized.
+    void finish();
+
+  private:
+    struct archive_t;
+
+    std::string prefix;
+    long int next_index = 0;
+    std::unique_ptr<archive_t> archive; // nullptr when writing individual files.
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::pair<std::string, std::string>> queue;
+    size_t queued_bytes = 0;
+    size_t max_queued_bytes;
+    bool stopping = false;
+    bool finished = false;
+    std::exception_ptr error;
+    std::thread writer;
+
+    void write_queued();
+    void write_one(const std::string &name, const std::string &contents);
+};
+
@@ -2,26 +2,32 @@
 //
 //This program de-duplicates DICOM files that are already in the PACS DB, deleting them.
 //
-// Note: A full, exact byte-wise comparison is not performed. Rather, the DICOM tags that
-//       are required to be unique are compared against the DB. If a match is found the file
-//       is deleted. Be careful not to run this on the PACS DB itself, since the DB files 
-//       will be deleted! (This is not checked because the PACS DB might be mounted in some
-//       exotic way that will confuse such efforts, such as sshfs.)
+// Note: A full, exact byte-wise comparison is not performed. Rather, the file's content hash
+//       (covering pixel data and identifying tags) is looked up in the DB's hash index, falling
+//       back to the DICOM tags that are required to be unique for records that predate content
+//       hashes. If a match is found the file is deleted. Be careful not to run this on the PACS
+//       DB itself, since the DB files will be deleted! (This is not checked because the PACS DB
+//       might be mounted in some exotic way that will confuse such efforts, such as sshfs.)
 //
 // Note: The file is NOT ingressed if it is not yet in the PACS DB.
 //
+// Duplicates within the PACS DB itself can also be reported, which requires only a single
+// GROUP BY over the content hash index.
+//
 
 #ifdef DCMA_USE_POSTGRES
 #else
     #error "Attempted to compile without PostgreSQL support, which is required."
 #endif
 
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <iostream>
 #include <list>
 #include <map>
 #include <pqxx/pqxx>            //PostgreSQL C++ interface.
+#include <sstream>
 #include <string>
 #include <tuple>
 
@@ -37,6 +43,7 @@ int main(int argc, char **argv){
     std::string DICOMFile;  //The filename to use.
     bool dryrun = false;    //Do not actually insert the file into the db, just test for errors.
     bool verbose = false;   //Print extra information. Normally successful info is suppresed.
+    bool report_db = false; //Report duplicates already within the PACS DB instead of checking a file.
 
     //---------------------------------------------------------------------------------------------------------
     //------------------------------------------ Argument Handling --------------------------------------------
@@ -45,16 +52,19 @@ int main(int argc, char **argv){
     const std::string progname(argv[0]);
     //----
     arger.description = "Given a DICOM file, check if it is in the PACS DB. If so, delete the file."
-                        " Note that a full, byte-by-byte comparison is NOT performed -- rather only the top-level"
-                        " DICOM unique identifiers are (currently) compared. No other metadata is considered."
-                        " So this program is not suitable if DICOM files have been modified without re-assigning"
-                        " unique identifiers! (Which is non-standard behaviour.) Note that if an /exact/ comparison"
+                        " Note that a full, byte-by-byte comparison is NOT performed -- rather a hash of the pixel"
+                        " data and the top-level DICOM unique identifiers is compared. Other metadata is not"
+                        " considered. Records without a hash are matched using only the unique identifiers, which"
+                        " is not suitable if DICOM files have been modified without re-assigning unique"
+                        " identifiers! (Which is non-standard behaviour.) Note that if an /exact/ comparison"
                         " is desired, using a traditional file de-duplicator will work.";
 
     arger.examples = { { " -f '/path/to/a/dicom/file.dcm'" ,
                          "Check if 'file.dcm' is already in the PACS DB. If so, delete it ('file.dcm')." },
                        { " -f '/path/to/a/dicom/file.dcm' -n " ,
-                         "Check if 'file.dcm' is already in the PACS DB, but do not delete anything." }
+                         "Check if 'file.dcm' is already in the PACS DB, but do not delete anything." },
+                       { " -r " ,
+                         "List groups of records within the PACS DB that share a content hash." }
     };
     //----
 
@@ -93,19 +103,56 @@ int main(int argc, char **argv){
         dryrun = true;
         return;
     }));
+    arger.push_back( std::make_tuple(2, 'r', "report-db-duplicates", false, "",
+                                     "Report records within the PACS DB that duplicate one another. Nothing is deleted.",
+                                     [&](const std::string &optarg) -> void {
+        report_db = true;
+        return;
+    }));
 
     arger.Launch(argc, argv);
 
     //---------------------------------------------------------------------------------------------------------
     //--------------------------------------- Requirement Verification ----------------------------------------
     //---------------------------------------------------------------------------------------------------------
+    if(report_db){
+        if(!DICOMFile.empty()) FUNCERR("A DICOM file cannot be provided when reporting duplicates within the PACS DB");
+        try{
+            pqxx::connection c(db_params);
+            pqxx::work txn(c);
+            const auto r = txn.exec("SELECT ContentHash, "
+                                    "       array_agg(pacsid ORDER BY pacsid) AS pacsids, "
+                                    "       array_agg(StoreFullPathName ORDER BY pacsid) AS storefullpathnames "
+                                    "FROM metadata "
+                                    "WHERE ContentHash IS NOT NULL "
+                                    "GROUP BY ContentHash "
+                                    "HAVING count(*) > 1 "
+                                    "ORDER BY min(pacsid);");
+            for(pqxx::result::size_type i = 0; i != r.size(); ++i){
+                FUNCINFO("Records with pacsids " << r[i]["pacsids"].as<std::string>() << " are duplicates: "
+                         << r[i]["storefullpathnames"].as<std::string>());
+            }
+            if(verbose || r.empty()) FUNCINFO("Found " << r.size() << " groups of duplicate records");
+        }catch(const std::exception &e){
+            FUNCERR("Unable to query database:\n" << e.what() << "\nCannot continue");
+        }
+        return 0;
+    }
     if(DICOMFile.empty()) FUNCERR("Cannot read DICOM file '" << DICOMFile << "'. Cannot continue");
 
     //---------------------------------------------------------------------------------------------------------
     //----------------------------------------- Data Loading & Prep -------------------------------------------
     //---------------------------------------------------------------------------------------------------------
     //Process the file.
-    auto mmap = get_metadata_top_level_tags(DICOMFile);
+    std::map<std::string,std::string> mmap;
+    uint64_t ContentHash = 0;
+    try{
+        const auto pdf = Parse_DICOM_File(DICOMFile);
+        mmap = get_metadata_top_level_tags(pdf);
+        ContentHash = get_content_hash(pdf);
+    }catch(const std::exception &e){
+        FUNCERR("File '" << DICOMFile << "' could not be parsed: " << e.what());
+    }
 
     //Basic information check.
     {
@@ -126,7 +173,8 @@ int main(int argc, char **argv){
     //---------------------------------------------------------------------------------------------------------
     //------------------------------------------- Database Querying -------------------------------------------
     //---------------------------------------------------------------------------------------------------------
-    //Query the DB using the uniquely-identifying DICOM information.
+    //Query the DB using the content hash index or, for records without a hash, the uniquely-identifying DICOM
+    // information.
 
     try{
         pqxx::connection c(db_params);
@@ -138,12 +186,14 @@ int main(int argc, char **argv){
 
         tb1.str(""); //Clear stringstream.
         tb2.str(""); //Clear stringstream.
-        tb1 << "SELECT StoreFullPathName FROM metadata WHERE ( ";
-        tb1 << "       ( PatientID         = " << txn.quote(mmap["PatientID"])         << " ) ";
-        tb1 << "   AND ( StudyInstanceUID  = " << txn.quote(mmap["StudyInstanceUID"])  << " ) ";
-        tb1 << "   AND ( SeriesInstanceUID = " << txn.quote(mmap["SeriesInstanceUID"]) << " ) ";
-        tb1 << "   AND ( SOPInstanceUID    = " << txn.quote(mmap["SOPInstanceUID"])    << " ) ";
-        tb1 << " );";
+        tb1 << "SELECT StoreFullPathName, ContentHash FROM metadata WHERE ( ";
+        tb1 << "       ( ContentHash = " << static_cast<int64_t>(ContentHash) << " ) ";
+        tb1 << "   OR  (     ( ContentHash IS NULL ) ";
+        tb1 << "         AND ( PatientID         = " << txn.quote(mmap["PatientID"])         << " ) ";
+        tb1 << "         AND ( StudyInstanceUID  = " << txn.quote(mmap["StudyInstanceUID"])  << " ) ";
+        tb1 << "         AND ( SeriesInstanceUID = " << txn.quote(mmap["SeriesInstanceUID"]) << " ) ";
+        tb1 << "         AND ( SOPInstanceUID    = " << txn.quote(mmap["SOPInstanceUID"])    << " ) ) ";
+        tb1 << " ) ORDER BY pacsid LIMIT 1;";
 
         r = txn.exec(tb1.str());
         if(r.empty()){
@@ -152,11 +202,11 @@ int main(int argc, char **argv){
         }
 
         //---------------------------------- Ensure existing file is accessible ----------------------------------
-        //Also ensure that the basic DICOM unique identifiers match the DB record.
+        //Also ensure that the file in the store matches the DB record.
+        //
+        // Note: when the DB returns multiple matches (i.e., the DB itself contains duplicates) only the earliest
+        // record is considered.
 
-        if(r.size() != 1){
-            FUNCERR("Multiple StoreFullPathName found for file '" << DICOMFile << "'. There should be 0 or 1");
-        }
         const auto StoreFullPathName = (r[0]["StoreFullPathName"].is_null()) ? "" :
                                                                                r[0]["StoreFullPathName"].as<std::string>();
 
@@ -167,6 +217,10 @@ int main(int argc, char **argv){
         || (mmap["SOPInstanceUID"]    != pmmap["SOPInstanceUID"]) ){
             FUNCERR("PACS DB file '" << StoreFullPathName << "' does not match the DB record! Aborting");
         }
+        if(!r[0]["ContentHash"].is_null()
+        && (r[0]["ContentHash"].as<int64_t>() != static_cast<int64_t>(get_content_hash(StoreFullPathName))) ){
+            FUNCERR("PACS DB file '" << StoreFullPathName << "' does not match the DB record's content hash! Aborting");
+        }
 
         //---------------------------------- Ensure existing file is accessible ----------------------------------
 
@@ -7,20 +7,39 @@
 // Note that, because this program essentially just distills files down to a collection of
 // DICOM key-values, routines are tightly coupled with the DICOM parser. 
 //
+// Many files can be provided at once. Metadata is extracted concurrently and files are registered in batches, each
+// within a single transaction: duplicates are detected with a prepared statement, pacsids are claimed in bulk, and the
+// metadata rows are loaded with COPY.
+//
+// Each file's content hash (see get_content_hash()) is stored in an indexed column. Files whose hash is already present
+// are rejected as duplicates before anything is copied into the filesystem store.
+//
+// Previews of each ingressed image series are generated from a few representative slices, stored alongside the files
+// in the filesystem store, and registered in the 'series_previews' table, so series can be browsed without loading the
+// full DICOM files. Series that are ingressed over several invocations are previewed from the latest invocation's
+// files.
+//
 
 #ifdef DCMA_USE_POSTGRES
 #else
     #error "Attempted to compile without PostgreSQL support, which is required."
 #endif
 
+#include <algorithm>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <iostream>
+#include <iterator>
 #include <list>
 #include <map>
+#include <optional>
 #include <pqxx/pqxx> //PostgreSQL C++ interface.
+#include <set>
+#include <stdexcept>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include "Imebra_Shim.h"     //Wrapper for Imebra library. Black-boxed to speed up compilation.
 #include "YgorArguments.h"
@@ -28,14 +47,166 @@
 #include "YgorMisc.h"           //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorString.h"         //Needed for stringtoX(), X_to_string().
 
+#include "Series_Preview.h"
+#include "Structs.h"
+#include "Thread_Pool.h"
+
+namespace {
+
+//The information needed to register a single file.
+struct ingress_file {
+    std::string DICOMFile;
+    std::string GDCMDump;
+    std::map<std::string, std::string> mmap;
+    uint64_t ContentHash = 0;
+
+    std::string NewFullDir;
+    std::string StoreFullPathName;
+    std::string StoreGDCMDumpFileName;
+
+    std::string error; //Non-empty if the file cannot be registered.
+};
+
+//Extracts the metadata and works out where the file should be kept in the filesystem store.
+void Prepare_File(ingress_file &f, const std::string &DICOMFileSystemStoreBase){
+    const auto pdf = Parse_DICOM_File(f.DICOMFile);
+    f.mmap = get_metadata_top_level_tags(pdf);
+    f.ContentHash = get_content_hash(pdf);
+
+    //Figure out a reasonable place to keep the file in the filesystem store. It isn't so important except to
+    // be reasonably human-readable, fairly balanced in the filesystem, and not already present.
+    const auto StudyInstanceUID  = f.mmap["StudyInstanceUID"];
+    const auto StudyDate         = f.mmap["StudyDate"];
+    const auto StudyTime         = f.mmap["StudyTime"];
+    const auto SeriesInstanceUID = f.mmap["SeriesInstanceUID"];
+    const auto SeriesNumber      = f.mmap["SeriesNumber"];
+    const auto SOPInstanceUID    = f.mmap["SOPInstanceUID"];
+
+    if(StudyInstanceUID.empty()  || StudyDate.empty()    || StudyTime.empty() 
+    || SeriesInstanceUID.empty() || SeriesNumber.empty() || SOPInstanceUID.empty() ){
+        f.error = "File is missing information and cannot be imported into the database";
+        return;
+    }
+
+    const auto TopDirName = Detox_String(StudyDate) + "-"_s
+                          + Detox_String(StudyTime) + "_"_s
+                          + Detox_String(StudyInstanceUID);
+
+    const auto MidDirName = Detox_String(SeriesNumber) + "-"_s
+                          + Detox_String(SeriesInstanceUID);
+
+    f.NewFullDir = DICOMFileSystemStoreBase + "/"_s
+                 + TopDirName + "/"_s
+                 + MidDirName + "/";    //Not the full path, just the complete directory.
+
+    f.StoreFullPathName = f.NewFullDir + Detox_String(SOPInstanceUID) + ".dcm";
+    f.StoreGDCMDumpFileName = f.NewFullDir + Detox_String(SOPInstanceUID) + ".gdcmdump";
+    return;
+}
+
+//Copies the file and the GDCMDump into the filesystem store. Returns an error message on failure.
+std::string Copy_File_Into_Store(const ingress_file &f){
+    //Ensure the destination location can be created and the file copied.
+    if(!Does_Dir_Exist_And_Can_Be_Read(f.NewFullDir) && !Create_Dir_and_Necessary_Parents(f.NewFullDir)){
+        return "Unable to create directory '"_s + f.NewFullDir + "'";
+    }
+
+    //Copy the file.
+    if(!CopyFile(f.DICOMFile, f.StoreFullPathName)){
+        return "Unable to copy file to filesystem store destination '"_s + f.StoreFullPathName + "'";
+    }
+
+    //Write the GDCMDump file into the store.
+    if(!WriteStringToFile(f.GDCMDump, f.StoreGDCMDumpFileName)){
+        return "Unable to write GDCMDump file '"_s + f.StoreGDCMDumpFileName + "' into the filesystem store";
+    }
+
+    //Set the permissions ...
+    // ... TODO ...
+    return "";
+}
+
+std::optional<std::string> Null_If_Empty(const std::string &s){
+    if(s.empty()) return std::nullopt;
+    return s;
+}
+
+//A single preview image written into the filesystem store.
+struct series_preview_file {
+    std::string SeriesInstanceUID;
+    std::string SOPInstanceUID;
+    long int slice = 0; //The rank of the representative slice within the series.
+    long int level = 0; //The mipmap level, with zero being the largest.
+    long int rows = 0;
+    long int columns = 0;
+    std::string StoreFullPathName;
+};
+
+//Generates previews for one series from representative slices among the provided (registered) files.
+std::vector<series_preview_file> Write_Series_Previews(const std::vector<const ingress_file *> &series,
+                                                       const series_preview_params &params){
+    //Only files that appear to contain pixel data can be previewed.
+    std::vector<const ingress_file *> images;
+    std::vector<std::map<std::string, std::string>> metadata;
+    for(const auto &f : series){
+        const auto rows = f->mmap.find("Rows");
+        if( (rows == std::end(f->mmap)) || rows->second.empty() ) continue;
+        images.push_back(f);
+        metadata.push_back(f->mmap);
+    }
+
+    std::vector<series_preview_file> out;
+    long int slice = 0;
+    for(const auto &i : Select_Representative_Slices(metadata, params.representative_slices)){
+        const auto &f = *(images[i]);
+        try{
+            auto ia = Load_Image_Array(f.StoreFullPathName);
+            if( (ia == nullptr) || ia->imagecoll.images.empty() ) continue;
+
+            //Multi-frame files are represented by their middle frame.
+            auto img_it = std::next(std::begin(ia->imagecoll.images), ia->imagecoll.images.size() / 2);
+            long int level = 0;
+            for(const auto &mip : Generate_Preview_Mipmaps(*img_it, params)){
+                series_preview_file p;
+                p.SeriesInstanceUID = f.mmap.at("SeriesInstanceUID");
+                p.SOPInstanceUID = f.mmap.at("SOPInstanceUID");
+                p.slice = slice;
+                p.level = level++;
+                p.rows = mip.rows;
+                p.columns = mip.columns;
+                p.StoreFullPathName = f.NewFullDir + "previews/" + Detox_String(p.SOPInstanceUID) + "_"
+                                    + std::to_string(p.rows) + "x" + std::to_string(p.columns) + ".png";
+                if( !Does_Dir_Exist_And_Can_Be_Read(f.NewFullDir + "previews/")
+                &&  !Create_Dir_and_Necessary_Parents(f.NewFullDir + "previews/") ){
+                    throw std::runtime_error("Unable to create preview directory");
+                }
+                if(!WriteStringToFile(Encode_Preview_PNG(mip), p.StoreFullPathName)){
+                    throw std::runtime_error("Unable to write preview '"_s + p.StoreFullPathName + "'");
+                }
+                out.push_back(p);
+            }
+            ++slice;
+        }catch(const std::exception &e){
+            FUNCWARN("'" << f.DICOMFile << "': Unable to generate preview: " << e.what() << ". Continuing");
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+
 int main(int argc, char **argv){
     //std::string db_params("dbname=pacs user=hal host=localhost port=63443");
     std::string db_params("dbname=pacs user=hal host=localhost");
     std::string DICOMFileSystemStoreBase("/home/pacs_store");
-    std::string DICOMFile;  //The filename to use.
+    std::list<std::string> DICOMFiles; //The filenames to use.
     std::string Project;    //Human-readable project of data origin. MSc, PhD, Special_Project_...
     std::string Comments;   //Human-readable general comments.
     std::string GDCMDump;   //Text of executing `gdcmdump` if available.
+    std::string GDCMDumpSuffix(".gdcmdump"); //Used to locate `gdcmdump` output when multiple files are provided.
+    long int BatchSize = 500; //The number of files registered per transaction.
+    series_preview_params PreviewParams;
     bool dryrun = false;    //Do not actually insert the file into the db, just test for errors.
     bool verbose = false;   //Print extra information. Normally successful info is suppresed.
 
@@ -45,12 +216,16 @@ int main(int argc, char **argv){
     class ArgumentHandler arger;
     const std::string progname(argv[0]);
     //----
-    arger.description = "Given a DICOM file and some additional metadata, insert the data    "
-                        " into the PACs system database. The file itself will be copied into "
-                        " the database and various bits of data will be deciphered.          ";
+    arger.description = "Given DICOM files and some additional metadata, insert the data      "
+                        " into the PACs system database. The files themselves will be copied  "
+                        " into the database and various bits of data will be deciphered.      "
+                        " Multiple files are registered in batches, one transaction per batch.";
 
     arger.examples = { { " -f '/tmp/a.dcm' -g '/tmp/a.gdcmdump' -p 'XYZ Study 2017' -c 'Bulk insert for XYZ.'" ,
-                         "Insert the file '/tmp/a.dcm' into the database." } 
+                         "Insert the file '/tmp/a.dcm' into the database." },
+                       { " -p 'XYZ Study 2017' -c 'Bulk insert for XYZ.' /tmp/xyz/*.dcm" ,
+                         "Insert all files in '/tmp/xyz/' into the database. Each file's `gdcmdump` output is read"
+                         " from a neighbouring file (e.g., '/tmp/xyz/a.dcm.gdcmdump')." }
     };
     //----
 
@@ -58,20 +233,15 @@ int main(int argc, char **argv){
         FUNCERR("Unrecognized option with argument: '" << optarg << "'");
     };
     arger.optionless_callback = [&](const std::string &optarg) -> void {
-        if(!DICOMFile.empty()){
-            FUNCERR("This program can only handle a single file at a time."
-                    " Earlier file: '" << DICOMFile << "'. This file: '" << optarg << "'");
-        }
-        DICOMFile = optarg;
+        DICOMFiles.emplace_back(optarg);
         return;
     };
     //----
 
     arger.push_back( std::make_tuple(1, 'f', "dicom-file", true, "/tmp/a",
-                                     "(req'd) The DICOM file to use.",
+                                     "(req'd) The DICOM file to use. Can be provided multiple times.",
                                      [&](const std::string &optarg) -> void {
-        if(!DICOMFile.empty()) FUNCERR("This program can only handle a single file at a time");
-        DICOMFile = optarg;
+        DICOMFiles.emplace_back(optarg);
         return;
     }));
     arger.push_back( std::make_tuple(2, 'p', "project", true, "MSc",
@@ -87,12 +257,43 @@ int main(int argc, char **argv){
         return;
     }));
     arger.push_back( std::make_tuple(1, 'g', "gdcmdump-file", true, "/tmp/a.dcm.gdcmdump",
-                                     "File containing output from `gdcmdump`.",
+                                     "File containing output from `gdcmdump`. Only applicable when a single file"
+                                     " is provided.",
                                      [&](const std::string &optarg) -> void {
         if(!Does_File_Exist_And_Can_Be_Read(optarg)) FUNCERR("Cannot read file '" << optarg << "'");
         GDCMDump = LoadFileToString(optarg);
         return;
     }));
+    arger.push_back( std::make_tuple(1, 's', "gdcmdump-suffix", true, GDCMDumpSuffix,
+                                     "When multiple files are provided, the output from `gdcmdump` is read from"
+                                     " the file with this suffix appended to each DICOM filename.",
+                                     [&](const std::string &optarg) -> void {
+        GDCMDumpSuffix = optarg;
+        return;
+    }));
+    arger.push_back( std::make_tuple(1, 'B', "batch-size", true, std::to_string(BatchSize),
+                                     "The maximum number of files to register within a single transaction.",
+                                     [&](const std::string &optarg) -> void {
+        BatchSize = std::stol(optarg);
+        if(BatchSize <= 0) FUNCERR("Batch size must be positive");
+        return;
+    }));
+    arger.push_back( std::make_tuple(1, 'P', "preview-extent", true, std::to_string(PreviewParams.max_extent),
+                                     "The largest row or column count of the series previews. Previews are not"
+                                     " generated if zero.",
+                                     [&](const std::string &optarg) -> void {
+        PreviewParams.max_extent = std::stol(optarg);
+        if(PreviewParams.max_extent < 0) FUNCERR("Preview extent must not be negative");
+        return;
+    }));
+    arger.push_back( std::make_tuple(1, 'S', "preview-slices", true,
+                                     std::to_string(PreviewParams.representative_slices),
+                                     "The number of representative slices previewed per series.",
+                                     [&](const std::string &optarg) -> void {
+        PreviewParams.representative_slices = std::stol(optarg);
+        if(PreviewParams.representative_slices < 0) FUNCERR("Preview slice count must not be negative");
+        return;
+    }));
     arger.push_back( std::make_tuple(3, 'n', "dry-run", false, "",
                                      "Do not perform ingress or file insertion. Just test DB ingress for errors.",
                                      [&](const std::string &optarg) -> void {
@@ -118,170 +319,249 @@ int main(int argc, char **argv){
     //---------------------------------------------------------------------------------------------------------
     //--------------------------------------- Requirement Verification ----------------------------------------
     //---------------------------------------------------------------------------------------------------------
-    if(DICOMFile.empty()) FUNCERR("Cannot read DICOM file '" << DICOMFile << "'. Cannot continue");
-    if(Project.empty())   FUNCERR("The 'project' string is mandatory. Cannot continue");
-    if(Comments.empty())  FUNCERR("The 'comments' string is mandatory. Cannot continue");
-    if(GDCMDump.empty())  FUNCERR("The 'gdcmdump' string is strongly suggested. Refusing to continue");
+    if(DICOMFiles.empty()) FUNCERR("No DICOM files provided. Cannot continue");
+    if(Project.empty())    FUNCERR("The 'project' string is mandatory. Cannot continue");
+    if(Comments.empty())   FUNCERR("The 'comments' string is mandatory. Cannot continue");
+    const bool single_file = (DICOMFiles.size() == 1);
+    if(!single_file && !GDCMDump.empty()){
+        FUNCERR("A 'gdcmdump' file can only be provided with a single DICOM file. Use the suffix option instead");
+    }
+    if(single_file && GDCMDump.empty()){
+        FUNCERR("The 'gdcmdump' string is strongly suggested. Refusing to continue");
+    }
 
     //---------------------------------------------------------------------------------------------------------
     //----------------------------------------- Data Loading & Prep -------------------------------------------
     //---------------------------------------------------------------------------------------------------------
-    //Process the file.
-    auto mmap = get_metadata_top_level_tags(DICOMFile);
-
-    //Figure out a reasonable place to keep the file in the filesystem store. It isn't so important except to
-    // be reasonably human-readable, fairly balanced in the filesystem, and not already present.
-    const auto StudyInstanceUID  = mmap["StudyInstanceUID"];
-    const auto StudyDate         = mmap["StudyDate"];
-    const auto StudyTime         = mmap["StudyTime"];
-    const auto SeriesInstanceUID = mmap["SeriesInstanceUID"];
-    const auto SeriesNumber      = mmap["SeriesNumber"];
-    const auto SOPInstanceUID    = mmap["SOPInstanceUID"];
-
-    if(StudyInstanceUID.empty()  || StudyDate.empty()    || StudyTime.empty() 
-    || SeriesInstanceUID.empty() || SeriesNumber.empty() || SOPInstanceUID.empty() ){
-        FUNCERR("File is '" << DICOMFile << "' missing information and cannot be imported into the database");
+    //Process the files concurrently.
+    std::vector<ingress_file> files;
+    for(const auto &f : DICOMFiles){
+        files.emplace_back();
+        files.back().DICOMFile = f;
+    }
+    if(single_file) files.front().GDCMDump = GDCMDump;
+
+    progress_tracker progress("metadata extraction", static_cast<long int>(files.size()),
+                              [](long int completed, long int total, double eta_s) -> void {
+        FUNCINFO("Extracted metadata from " << completed << "/" << total << " files (ETA " << eta_s << " s)");
+    });
+    parallel_for(0, static_cast<long int>(files.size()), [&](long int i) -> void {
+        auto &f = files[i];
+        try{
+            if(!single_file){
+                const auto DumpFile = f.DICOMFile + GDCMDumpSuffix;
+                if(Does_File_Exist_And_Can_Be_Read(DumpFile)) f.GDCMDump = LoadFileToString(DumpFile);
+                if(f.GDCMDump.empty()){
+                    f.error = "The 'gdcmdump' string is strongly suggested, but '"_s + DumpFile + "' could not be read";
+                }
+            }
+            if(f.error.empty()) Prepare_File(f, DICOMFileSystemStoreBase);
+        }catch(const std::exception &e){
+            f.error = "Unable to extract metadata: "_s + e.what();
+        }
+        progress.advance();
+    }, /*grain=*/ 1);
+
+    long int failures = 0;
+    long int duplicates = 0;
+    long int ingressed = 0;
+    for(const auto &f : files){
+        if(!f.error.empty()){
+            FUNCWARN("'" << f.DICOMFile << "': " << f.error << ". Not ingressing");
+            ++failures;
+        }
     }
-
-    const auto TopDirName = Detox_String(StudyDate) + "-"_s
-                          + Detox_String(StudyTime) + "_"_s
-                          + Detox_String(StudyInstanceUID);
-
-    const auto MidDirName = Detox_String(SeriesNumber) + "-"_s
-                          + Detox_String(SeriesInstanceUID);
-
-    const auto NewFullDir = DICOMFileSystemStoreBase + "/"_s
-                          + TopDirName + "/"_s
-                          + MidDirName + "/";    //Not the full path, just the complete directory.
-
-    const auto NewFileName = Detox_String(SOPInstanceUID) + ".dcm";
-    const auto StoreFullPathName = NewFullDir + NewFileName;
-
-    const auto NewGDCMDumpFileName = Detox_String(SOPInstanceUID) + ".gdcmdump";
-    const auto StoreGDCMDumpFileName = NewFullDir + NewGDCMDumpFileName;
 
     //---------------------------------------------------------------------------------------------------------
     //----------------------------------------- Database Registration -----------------------------------------
     //---------------------------------------------------------------------------------------------------------
-    //Now we convert the data into a format the database can use to verify/cast into the proper format. In some
-    // cases we cast to a REAL before an INT. This is because I've encountered INT fields printed in strings or
-    // reported by Imebra as '16.0000' which PostgreSQL doesn't like. Casting to REAL and then INT is a 
-    // logical workaround.
-
     try{
         pqxx::connection c(db_params);
-        pqxx::work txn(c);
-        std::stringstream tb1, tb2;
-        pqxx::result r;
 
-        //----------------------------- Determine if a record already exists ----------------------------------
-        //This is not a conclusive test, but will stop many unneccesary file insertion into the store.
-
-        tb1.str(""); //Clear stringstream.
-        tb2.str(""); //Clear stringstream.
-        tb1 << "SELECT PatientID FROM metadata WHERE ( ";
-
-        tb1 << "       ( PatientID         = " << txn.quote(mmap["PatientID"])         << " ) ";
-        tb1 << "   AND ( StudyInstanceUID  = " << txn.quote(mmap["StudyInstanceUID"])  << " ) ";
-        tb1 << "   AND ( SeriesInstanceUID = " << txn.quote(mmap["SeriesInstanceUID"]) << " ) ";
-        tb1 << "   AND ( SOPInstanceUID    = " << txn.quote(mmap["SOPInstanceUID"])    << " ) ";
-        tb1 << " );";
-
-        r = txn.exec(tb1.str());
-        if(!r.empty()){
-            FUNCWARN("Conflicting file already present. Treating as a duplicate and NOT ingressing");
-            return 0;
+        //Content hashes are looked up for every file, so they need to be indexed. Creating the column is idempotent, so
+        // it is done even for dry runs.
+        {
+            pqxx::work txn(c);
+            txn.exec("ALTER TABLE metadata ADD COLUMN IF NOT EXISTS ContentHash BIGINT;");
+            txn.exec("CREATE INDEX IF NOT EXISTS metadata_contenthash_idx ON metadata (ContentHash);");
+            txn.commit();
         }
 
-        //-------------------------------------- Import the files ---------------------------------------------
-        if(!dryrun){
-            //Ensure the destination location can be created and the file copied.
-            if(!Does_Dir_Exist_And_Can_Be_Read(NewFullDir) && !Create_Dir_and_Necessary_Parents(NewFullDir)){
-                FUNCERR("Unable to create directory '" << NewFullDir << "'. Cannot continue");
-            }
-
-            //if(!TouchFile(StoreFullPathName)){
-            //    FUNCERR("Unable to touch file '" << StoreFullPathName << "'. Cannot continue");
-            //}
+        //This is not a conclusive test, but will stop many unneccesary file insertion into the store.
+        c.prepare("find_duplicate",
+                  "SELECT PatientID FROM metadata WHERE ( "
+                  "       ( ContentHash       = $5 ) "
+                  "   OR  (     ( PatientID         = $1 ) "
+                  "         AND ( StudyInstanceUID  = $2 ) "
+                  "         AND ( SeriesInstanceUID = $3 ) "
+                  "         AND ( SOPInstanceUID    = $4 ) ) "
+                  " ) LIMIT 1;");
 
-            //Copy the file.
-            if(!CopyFile(DICOMFile, StoreFullPathName)){
-                FUNCERR("Unable to copy file '" << DICOMFile << "' to filesystem store destination '" << StoreFullPathName << "'");
+        //Don't worry about iterating the nidus unnecessarily. There is plenty of room to skip ids, and we can
+        // always squash holes at a later time (as required).
+        c.prepare("claim_pacsids",
+                  "INSERT INTO pacsid_nidus "
+                  "    (pacsid) SELECT nextval('pacsid_nidus_seq') FROM generate_series(1, $1) "
+                  "RETURNING pacsid;");
+
+        //Files that appear more than once in the input are only ingressed once.
+        std::set<std::tuple<std::string, std::string, std::string, std::string>> seen;
+        std::set<uint64_t> seen_hashes;
+
+        //The registered files of each series, for generating previews.
+        std::map<std::string, std::vector<const ingress_file *>> registered_series;
+
+        const auto N_files = static_cast<long int>(files.size());
+        for(long int batch_begin = 0; batch_begin < N_files; batch_begin += BatchSize){
+            const auto batch_end = std::min(N_files, batch_begin + BatchSize);
+
+            pqxx::work txn(c);
+
+            //----------------------------- Determine if a record already exists ----------------------------------
+            std::vector<ingress_file *> batch;
+            for(long int i = batch_begin; i < batch_end; ++i){
+                auto &f = files[i];
+                if(!f.error.empty()) continue;
+
+                const auto key = std::make_tuple(f.mmap["PatientID"], f.mmap["StudyInstanceUID"],
+                                                 f.mmap["SeriesInstanceUID"], f.mmap["SOPInstanceUID"]);
+                const auto ContentHash = static_cast<int64_t>(f.ContentHash); // Stored as a (signed) BIGINT.
+                const bool seen_uids = !seen.insert(key).second;
+                const bool seen_hash = !seen_hashes.insert(f.ContentHash).second;
+                if( seen_uids
+                ||  seen_hash
+                ||  !txn.exec_prepared("find_duplicate", std::get<0>(key), std::get<1>(key),
+                                                         std::get<2>(key), std::get<3>(key),
+                                                         ContentHash).empty() ){
+                    FUNCWARN("'" << f.DICOMFile << "': Conflicting file already present. Treating as a duplicate and NOT ingressing");
+                    ++duplicates;
+                    continue;
+                }
+
+                //-------------------------------------- Import the files ---------------------------------------------
+                if(!dryrun){
+                    const auto err = Copy_File_Into_Store(f);
+                    if(!err.empty()){
+                        FUNCWARN("'" << f.DICOMFile << "': " << err << ". Not ingressing");
+                        ++failures;
+                        continue;
+                    }
+                }
+                batch.push_back(&f);
             }
-
-            //Write the GDCMDump file into the store.
-            if(!WriteStringToFile(GDCMDump, StoreGDCMDumpFileName)){
-                FUNCERR("Unable to write GDCMDump file '" << StoreGDCMDumpFileName << "' into the filesystem store");
+            if(batch.empty()) continue;
+
+            //------------------------------------- Claim new pacsids ---------------------------------------------
+            const auto r = txn.exec_prepared("claim_pacsids", static_cast<long int>(batch.size()));
+            if(static_cast<size_t>(r.size()) != batch.size()) FUNCERR("Unable to create new pacsids. Cannot continue");
+
+            //All rows share the transaction's timestamp, as if now() had been used within the transaction.
+            const auto ImportTimepoint = txn.exec1("SELECT now();")[0].as<std::string>();
+
+            //------------------------------- Push the metadata to the database -----------------------------------
+            {
+                pqxx::stream_to stream(txn, "metadata",
+                                       std::vector<std::string>{ "pacsid",
+                                                                 //DICOM logical hierarchy fields.
+                                                                 "patientid",
+                                                                 "studyinstanceuid",
+                                                                 "seriesinstanceuid",
+                                                                 "sopinstanceuid",
+                                                                 "contenthash",
+                                                                 //Non-DICOM metadata fields.
+                                                                 "project",
+                                                                 "comments",
+                                                                 "fullpathname",
+                                                                 "importtimepoint",
+                                                                 "storefullpathname" });
+                for(size_t i = 0; i < batch.size(); ++i){
+                    auto &f = *(batch[i]);
+                    const auto pacsid = r[i]["pacsid"].as<long int>();
+                    stream << std::make_tuple( pacsid,
+                                               Null_If_Empty(f.mmap["PatientID"]),
+                                               Null_If_Empty(f.mmap["StudyInstanceUID"]),
+                                               Null_If_Empty(f.mmap["SeriesInstanceUID"]),
+                                               Null_If_Empty(f.mmap["SOPInstanceUID"]),
+                                               static_cast<int64_t>(f.ContentHash),
+                                               Null_If_Empty(Project),
+                                               Null_If_Empty(Comments),
+                                               Null_If_Empty(Fully_Expand_Filename(f.DICOMFile)),
+                                               ImportTimepoint,
+                                               f.StoreFullPathName );
+                    if(verbose) FUNCINFO("Success! PACS id=" << pacsid << " and StoreFullPathName='" << f.StoreFullPathName << "'");
+                }
+
+                //Remove filesystem store copied files if the insertion fails! TODO FIXME.
+                //Remove directory ... IFF nothing else is in it... TODO FIXME.
+                // ...
+                stream.complete();
             }
 
-            //Set the permissions ...
-            // ... TODO ...
-        }
-
-        //------------------------------------- Claim a new pacsid --------------------------------------------
-        //Don't worry about iterating the nidus unnecessarily. There is plenty of room to skip ids, and we can
-        // always squash holes at a later time (as required).
-        tb1.str(""); //Clear stringstream.
-        tb2.str(""); //Clear stringstream.
-        tb1 << "INSERT INTO pacsid_nidus                          ";
-        tb1 << "    (pacsid) VALUES (nextval('pacsid_nidus_seq')) ";
-        tb1 << "RETURNING pacsid;                                 ";
-
-        r = txn.exec(tb1.str());
-        if(r.affected_rows() != 1) FUNCERR("Unable to create new pacsid. Cannot continue");
-        const auto pacsid = r[0]["pacsid"].as<long int>(); 
-
-        //------------------------------- Push the metadata to the database -----------------------------------
-        tb1.str(""); //Clear stringstream.
-        tb2.str(""); //Clear stringstream.
-        tb1 << "INSERT INTO metadata ( ";
-
-        tb1 << "    pacsid,                      ";        tb2 << pacsid << ",";
-
-        //DICOM logical hierarchy fields.
-        tb1 << "    PatientID,                   ";        tb2 << "NULLIF(" << txn.quote(mmap["PatientID"]) << ",''),";
-        tb1 << "    StudyInstanceUID,            ";        tb2 << "NULLIF(" << txn.quote(mmap["StudyInstanceUID"]) << ",''),";
-        tb1 << "    SeriesInstanceUID,           ";        tb2 << "NULLIF(" << txn.quote(mmap["SeriesInstanceUID"]) << ",''),";
-        tb1 << "    SOPInstanceUID,              ";        tb2 << "NULLIF(" << txn.quote(mmap["SOPInstanceUID"]) << ",''),";
-
-/*
-        tb1 << "    StudyDate,                   ";        tb2 << "CAST( NULLIF(" << txn.quote(mmap["StudyDate"]) << ",'') AS DATE),";
-        tb1 << "    StudyTime,                   ";        tb2 << "CAST( NULLIF(" << txn.quote(mmap["StudyTime"]) << ",'') AS TIME),";
-        tb1 << "    SeriesNumber,                ";        tb2 << "CAST( CAST( NULLIF(" << txn.quote(mmap["SeriesNumber"]) << ",'') AS REAL) AS BIGINT),";
-*/
-
-        //Non-DICOM metadata fields.
-        tb1 << "    Project,                     ";        tb2 << "NULLIF(" << txn.quote(Project) << ",''),";
-        tb1 << "    Comments,                    ";        tb2 << "NULLIF(" << txn.quote(Comments) << ",''),";
-        tb1 << "    FullPathName,                ";        tb2 << "NULLIF(" << txn.quote(Fully_Expand_Filename(DICOMFile)) << ",''),";
-//        tb1 << "    gdcmdump,                    ";        tb2 << "NULLIF(" << txn.quote(GDCMDump) << ",''),";
-        tb1 << "    ImportTimepoint,             ";        tb2 << "now(),";
-        tb1 << "    StoreFullPathName            ";        tb2 << txn.quote(StoreFullPathName);
-
-        tb1 << ") VALUES (" << tb2.str() << ");";
-
-        r = txn.exec(tb1.str());
-        if(r.affected_rows() != 1){
-
-            //Remove filesystem store copied files! TODO FIXME.
-            //Remove directory ... IFF nothing else is in it... TODO FIXME.
-            // ...
-
-            FUNCERR("DB insertion affected " << r.affected_rows() << " rows. Since != 1 the insertion was aborted");
-        }else{
-            if(verbose) FUNCINFO("Success! PACS id=" << pacsid << " and StoreFullPathName='" << StoreFullPathName << "'");
+            if(!dryrun) txn.commit(); 
+            ingressed += static_cast<long int>(batch.size());
+            for(const auto &f : batch) registered_series[f->mmap["SeriesInstanceUID"]].push_back(f);
+            FUNCINFO("Registered " << ingressed << " files (" << batch_end << "/" << N_files << " processed)");
         }
 
-        if(dryrun){
-            if(verbose) FUNCINFO("Dry run successful. No errors encountered");
-            return 0;
-        }else{
-            txn.commit(); 
+        //------------------------------------- Generate series previews --------------------------------------
+        if( !dryrun && (0 < PreviewParams.max_extent) && (0 < PreviewParams.representative_slices)
+        &&  !registered_series.empty() ){
+            std::vector<const std::vector<const ingress_file *> *> series;
+            for(const auto &p : registered_series) series.push_back(&(p.second));
+
+            std::vector<std::vector<series_preview_file>> previews(series.size());
+            parallel_for(0, static_cast<long int>(series.size()), [&](long int i) -> void {
+                previews[i] = Write_Series_Previews(*(series[i]), PreviewParams);
+            }, /*grain=*/ 1);
+
+            {
+                pqxx::work txn(c);
+                txn.exec("CREATE TABLE IF NOT EXISTS series_previews ( "
+                         "    SeriesInstanceUID TEXT NOT NULL, "
+                         "    SOPInstanceUID TEXT NOT NULL, "
+                         "    slice INTEGER NOT NULL, "
+                         "    level INTEGER NOT NULL, "
+                         "    rows INTEGER NOT NULL, "
+                         "    columns INTEGER NOT NULL, "
+                         "    StoreFullPathName TEXT NOT NULL, "
+                         "    PRIMARY KEY (SeriesInstanceUID, slice, level) "
+                         ");");
+                txn.commit();
+            }
+            c.prepare("clear_previews",
+                      "DELETE FROM series_previews WHERE ( SeriesInstanceUID = $1 );");
+            c.prepare("insert_preview",
+                      "INSERT INTO series_previews "
+                      "    (SeriesInstanceUID, SOPInstanceUID, slice, level, rows, columns, StoreFullPathName) "
+                      "VALUES ($1, $2, $3, $4, $5, $6, $7);");
+
+            pqxx::work txn(c);
+
+            long int preview_count = 0;
+            for(size_t i = 0; i < series.size(); ++i){
+                if(previews[i].empty()) continue;
+                txn.exec_prepared("clear_previews", previews[i].front().SeriesInstanceUID);
+                for(const auto &p : previews[i]){
+                    txn.exec_prepared("insert_preview", p.SeriesInstanceUID, p.SOPInstanceUID, p.slice, p.level,
+                                                        p.rows, p.columns, p.StoreFullPathName);
+                    ++preview_count;
+                }
+            }
+            txn.commit();
+            FUNCINFO("Registered " << preview_count << " previews for " << series.size() << " series");
         }
 
     }catch(const std::exception &e){
         FUNCERR("Unable to push to database:\n" << e.what() << "\n" << "Cannot continue");
     }
 
+    if(dryrun && verbose) FUNCINFO("Dry run complete");
+    if(!single_file){
+        FUNCINFO("Ingressed " << ingressed << " files. Skipped " << duplicates << " duplicates and " << failures << " failures");
+    }
+    if(0 < failures){
+        if(single_file) FUNCERR("Unable to ingress file. Cannot continue");
+        return 1;
+    }
     return 0;
 }
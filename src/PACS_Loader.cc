@@ -14,16 +14,20 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <set> 
 #include <string>    
+#include <vector>
 //#include <cfenv>              //Needed for std::feclearexcept(FE_ALL_EXCEPT).
 
 #include <algorithm>
 #include <pqxx/pqxx>          //PostgreSQL C++ interface.
 #include <utility>            //Needed for std::pair.
 
-#include "Explicator.h"       //Needed for Explicator class.
+#include "File_Prefetcher.h"
 #include "Imebra_Shim.h"      //Wrapper for Imebra library. Black-boxed to speed up compilation.
+#include "Lexicon_Cache.h"
 #include "Structs.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorImages.h"
@@ -31,16 +35,92 @@
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 
 
-static
-std::unique_ptr<Contour_Data> 
-Concatenate_Contour_Data(std::unique_ptr<Contour_Data> A,
-                         std::unique_ptr<Contour_Data> B){
-    //This routine concatenates A and B's contour collections. No internal checking is performed.
-    // No copying is performed, but A and B are consumed. A is returned as if it were a new pointer.
-    A->ccs.splice( A->ccs.end(), std::move(B->ccs) );
-    return A;
+namespace {
+
+//A process-wide pool of database connections, keyed by the connection parameters. Establishing a connection (and
+// authenticating) is costly, especially against a remote database, so connections are retained and reused.
+//
+// Statements are prepared once per connection and remain available whenever the connection is reused.
+struct pooled_connection {
+    std::unique_ptr<pqxx::connection> conn;
+    bool prepared = false;
+};
+
+class pacs_connection_pool {
+    private:
+        std::mutex m;
+        std::map<std::string, std::list<std::unique_ptr<pooled_connection>>> idle;
+
+    public:
+        static pacs_connection_pool & get(){
+            static pacs_connection_pool pool;
+            return pool;
+        }
+
+        //The connection is returned to the pool when the last reference is dropped, unless it was closed or broken.
+        std::shared_ptr<pooled_connection> acquire(const std::string &db_connection_params){
+            std::unique_ptr<pooled_connection> pc;
+            {
+                std::lock_guard<std::mutex> lock(this->m);
+                auto &l = this->idle[db_connection_params];
+                while(!l.empty() && (pc == nullptr)){
+                    pc = std::move(l.front());
+                    l.pop_front();
+                    if(!pc->conn->is_open()) pc.reset();
+                }
+            }
+            if(pc == nullptr){
+                pc = std::make_unique<pooled_connection>();
+                pc->conn = std::make_unique<pqxx::connection>(db_connection_params);
+            }
+
+            return std::shared_ptr<pooled_connection>(pc.release(), [this, db_connection_params](pooled_connection *p){
+                std::unique_ptr<pooled_connection> returned(p);
+                if(!returned->conn->is_open()) return;
+                std::lock_guard<std::mutex> lock(this->m);
+                this->idle[db_connection_params].emplace_back(std::move(returned));
+            });
+        }
+};
+
+void Prepare_Statements(pooled_connection &pc){
+    if(pc.prepared) return;
+
+    //Query for any contours matching the specific FrameOfReferenceUIDs, which are provided as a text array.
+    pc.conn->prepare("select_contours_by_frame_of_reference",
+                     "SELECT * FROM contours WHERE FrameOfReferenceUID = ANY($1::text[]);");
+    pc.prepared = true;
+    return;
 }
 
+//Encodes strings as a PostgreSQL array literal, e.g., {"a","b"}.
+std::string To_Text_Array_Literal(const std::set<std::string> &strs){
+    std::string out = "{";
+    bool first = true;
+    for(const auto &s : strs){
+        if(!first) out += ",";
+        first = false;
+        out += '"';
+        for(const auto &c : s){
+            if((c == '"') || (c == '\\')) out += '\\';
+            out += c;
+        }
+        out += '"';
+    }
+    out += "}";
+    return out;
+}
+
+//The information needed from each record in order to load the corresponding file.
+struct pacs_record {
+    std::string StoreFullPathName;
+    std::string Modality;
+    std::optional<std::string> dt;
+    std::optional<std::string> FrameOfReferenceUID;
+};
+
+} // namespace
+
 
 bool Load_From_PACS_DB( Drover &DICOM_data,
                         std::map<std::string,std::string> & /* InvocationMetadata */,
@@ -64,60 +144,85 @@ bool Load_From_PACS_DB( Drover &DICOM_data,
     std::shared_ptr<Contour_Data> loaded_contour_data_storage = std::make_shared<Contour_Data>();
 
     try{
+        //Query1 stage: select records from the system pacs database.
+        //
+        //All groups are queried within a single transaction on a single (pooled) connection before any files are
+        // loaded, so the database is not kept waiting while files are parsed.
+        std::list<std::vector<pacs_record>> grouped_records;
+        {
+            //Note that the libpqxx documentaton states that transactional connections are required if using
+            // PostgreSQL large files.
+            auto pc = pacs_connection_pool::get().acquire(db_connection_params);
+            pqxx::work txn(*(pc->conn));
+
+            for(const auto &FilterQueryFiles : GroupedFilterQueryFiles){
+                //Whatever is in the file(s), let the database figure out if they're legal and valid.
+                pqxx::result r1;
+         
+                std::stringstream ss;
+                for(const auto &FilterQueryFile : FilterQueryFiles){ 
+                    ss << "'" << FilterQueryFile << "'"; //Save the names in case something goes wrong.
+                    const auto query1 = LoadFileToString(FilterQueryFile);
+                    r1 = txn.exec(query1);
+                }
+                if(r1.empty()){
+                    FUNCWARN("Database query1 stage " << ss.str() << " resulted in no records. Cannot continue");
+                    return false;
+                }
+                FUNCINFO("Query1 stage: number of records found = " << r1.size());
+
+                grouped_records.emplace_back();
+                auto &records = grouped_records.back();
+                records.reserve(r1.size());
+                for(pqxx::result::size_type i = 0; i != r1.size(); ++i){
+                    pacs_record rec;
+
+                    //Get the returned pacsid.
+                    //const auto pacsid = r1[i]["pacsid"].as<long int>();
+                    rec.StoreFullPathName = (r1[i]["StoreFullPathName"].is_null()) ? 
+                                            "" : r1[i]["StoreFullPathName"].as<std::string>();
+                    rec.Modality = r1[i]["Modality"].as<std::string>();
+                    if(!r1[i]["dt"].is_null()){
+                        rec.dt = r1[i]["dt"].c_str();
+                    }
+                    if(!r1[i]["FrameOfReferenceUID"].is_null()){
+                        rec.FrameOfReferenceUID = r1[i]["FrameOfReferenceUID"].as<std::string>();
+                    }
+                    records.emplace_back(std::move(rec));
+                }
+            }
+
+            txn.commit();
+        }
+
         //Loop over each group of filter query files.
-        for(const auto &FilterQueryFiles : GroupedFilterQueryFiles){
+        for(const auto &records : grouped_records){
             loaded_imgs_storage.emplace_back();
             loaded_dose_storage.emplace_back();
 
-            //Unfortunately, it seems one cannot reset or deactivate/reactivate a connection. So we are forced to 
-            // start anew each time.
-            //
-            // Also note that the libpqxx documentaton states that transactional connections are required if using
-            // PostgreSQL large files.
-            //
-            pqxx::connection c(db_connection_params);
-            pqxx::work txn(c);
-
-            //-------------------------------------------------------------------------------------------------------------
-            //Query1 stage: select records from the system pacs database.
-            //
-            //Whatever is in the file(s), let the database figure out if they're legal and valid.
-            pqxx::result r1;
-     
-            std::stringstream ss;
-            for(const auto &FilterQueryFile : FilterQueryFiles){ 
-                ss << "'" << FilterQueryFile << "'"; //Save the names in case something goes wrong.
-                const auto query1 = LoadFileToString(FilterQueryFile);
-                r1 = txn.exec(query1);
-            }
-            if(r1.empty()){
-                FUNCWARN("Database query1 stage " << ss.str() << " resulted in no records. Cannot continue");
-                return false;
-            }
-    
-    
-            //-------------------------------------------------------------------------------------------------------------
-            FUNCINFO("Query1 stage: number of records found = " << r1.size());
-    
             //-------------------------------------------------------------------------------------------------------------
             //Query2 stage: process each record, loading whatever data is needed later into memory.
-            for(pqxx::result::size_type i = 0; i != r1.size(); ++i){
-                FUNCINFO("Parsing file #" << i+1 << "/" << r1.size() << " = " << 100*(i+1)/r1.size() << "%");
+            //
+            //The store is often network-mounted, so upcoming files are read ahead while earlier files are decoded.
+            std::vector<std::string> paths;
+            for(const auto &rec : records) paths.emplace_back(rec.StoreFullPathName);
+            file_prefetcher prefetcher(paths);
+
+            for(size_t i = 0; i != records.size(); ++i){
+                FUNCINFO("Parsing file #" << i+1 << "/" << records.size() << " = " << 100*(i+1)/records.size() << "%");
+                prefetcher.consume(i);
 
-                //Get the returned pacsid.
-                //const auto pacsid = r1[i]["pacsid"].as<long int>();
-                const auto StoreFullPathName = (r1[i]["StoreFullPathName"].is_null()) ? 
-                                               "" : r1[i]["StoreFullPathName"].as<std::string>();
+                const auto &StoreFullPathName = records[i].StoreFullPathName;
 
                 //Parse the file and/or try load the data. Push it into the list (we can collate later).
                 // If we cannot ascertain the type then we will treat it as an image and hope it can be loaded.
-                const auto Modality = r1[i]["Modality"].as<std::string>();
+                const auto &Modality = records[i].Modality;
                 if(boost::iequals(Modality,"RTSTRUCT")){
                     const auto preloadcount = loaded_contour_data_storage->ccs.size();
                     try{
-                        auto combined = Concatenate_Contour_Data( loaded_contour_data_storage->Duplicate(),
-                                                                  get_Contour_Data(StoreFullPathName));
-                        loaded_contour_data_storage = std::move(combined);
+                        auto cd = get_Contour_Data(StoreFullPathName);
+                        loaded_contour_data_storage->ccs.splice( loaded_contour_data_storage->ccs.end(),
+                                                                 std::move(cd->ccs) );
                     }catch(const std::exception &e){
                         FUNCWARN("Difficulty encountered during contour data loading: '" << e.what() <<
                                  "'. Ignoring file and continuing");
@@ -167,25 +272,18 @@ bool Load_From_PACS_DB( Drover &DICOM_data,
                     //If we want to add any additional image metadata, or replace the default Imebra_Shim.cc populated metadata
                     // with, say, the non-null PostgreSQL metadata, it should be done here.
                     loaded_imgs_storage.back().back()->imagecoll.images.back().metadata["StoreFullPathName"] = StoreFullPathName;
-                    if(!r1[i]["dt"].is_null()){
-                        //DICOM_data.image_data.back()->imagecoll.images.back().metadata["dt"] = r1[i]["dt"].c_str();
-                        //loaded_imgs_storage.back()->imagecoll.images.back().metadata["dt"] = r1[i]["dt"].c_str();
-                        loaded_imgs_storage.back().back()->imagecoll.images.back().metadata["dt"] = r1[i]["dt"].c_str();
+                    if(records[i].dt){
+                        loaded_imgs_storage.back().back()->imagecoll.images.back().metadata["dt"] = records[i].dt.value();
                     }
                     // ... more metadata operations ...
                 }
 
                 //Whatever file type, 
-                if(!r1[i]["FrameOfReferenceUID"].is_null()){
-                    FrameOfReferenceUIDs.insert(r1[i]["FrameOfReferenceUID"].as<std::string>());
+                if(records[i].FrameOfReferenceUID){
+                    FrameOfReferenceUIDs.insert(records[i].FrameOfReferenceUID.value());
                 }
 
             }
-
-            //-------------------------------------------------------------------------------------------------------------
-            //Finish the transaction and drop the connection.
-            txn.commit();
-
         } // Loop over groups of query filter files.
 
     }catch(const std::exception &e){
@@ -196,25 +294,13 @@ bool Load_From_PACS_DB( Drover &DICOM_data,
     //Custom contour loading from an auxiliary database.
     if(!FrameOfReferenceUIDs.empty()){
         try{
-            pqxx::connection c(db_connection_params);
-            pqxx::work txn(c);
+            auto pc = pacs_connection_pool::get().acquire(db_connection_params);
+            Prepare_Statements(*pc);
+            pqxx::work txn(*(pc->conn));
 
-            //Query for any contours matching the specific FrameOfReferenceUID.
-            std::stringstream ss;
-            ss << "SELECT * FROM contours WHERE ";
-            {
-                bool first = true;
-                for(const auto &FrameOfReferenceUID : FrameOfReferenceUIDs){
-                    if(first){
-                        first = false;
-                        ss << "(FrameOfReferenceUID = " << txn.quote(FrameOfReferenceUID) << ") ";
-                    }else{
-                        ss << "OR (FrameOfReferenceUID = " << txn.quote(FrameOfReferenceUID) << ") ";
-                    }
-                }
-            }
-            ss << ";";
-            pqxx::result res = txn.exec(ss.str());
+            //Query for any contours matching the specific FrameOfReferenceUIDs.
+            pqxx::result res = txn.exec_prepared("select_contours_by_frame_of_reference",
+                                                 To_Text_Array_Literal(FrameOfReferenceUIDs));
 
             //Parse any matching contour collections. Store them for later. 
             for(pqxx::result::size_type i = 0; i != res.size(); ++i){
@@ -276,7 +362,7 @@ bool Load_From_PACS_DB( Drover &DICOM_data,
 
     //Attempt contour name normalization using the selected lexicon.
     {
-        Explicator X(FilenameLex);
+        const lexicon_translator X(FilenameLex);
         for(auto & cc : loaded_contour_data_storage->ccs){
              for(auto & c : cc.contours){
                  const auto NormalizedROIName = X(c.metadata["ROIName"]); //Could be cached, externally or internally.
@@ -287,10 +373,10 @@ bool Load_From_PACS_DB( Drover &DICOM_data,
 
     //Concatenate contour data into the Drover instance.
     {
-        if(DICOM_data.contour_data == nullptr) DICOM_data.contour_data = std::make_shared<Contour_Data>();
-        auto combined = Concatenate_Contour_Data( DICOM_data.contour_data->Duplicate(),
-                                                  loaded_contour_data_storage->Duplicate());
-        DICOM_data.contour_data = std::move(combined);
+        //The loaded contours are not shared, so they can be moved rather than copied. The Drover's contours are only
+        // copied if they are shared with another owner.
+        auto &cd = Detach_Shared(DICOM_data.contour_data);
+        cd.ccs.splice( cd.ccs.end(), std::move(loaded_contour_data_storage->ccs) );
     }
 
     //Collate each group of images into a single set, if possible. Also stuff the correct contour data in the same set.
@@ -3,6 +3,9 @@
 // This program is designed to update the database whenever the table structure has
 // been tweaked.
 //
+// Records can either be selected by import time or incrementally, in pacsid order, beyond a high-water mark that is
+// stored in the database and advanced as batches are committed.
+//
 
 #ifdef DCMA_USE_POSTGRES
 #else
@@ -10,705 +13,849 @@
 #endif
 
 #include <cmath>
+#include <cstdint>
 #include <exception>
 #include <fstream>
 #include <functional>
 #include <list>
 #include <map>
 #include <pqxx/pqxx>         //PostgreSQL C++ interface.
+#include <sstream>
 #include <string>    
+#include <utility>
+#include <vector>
 
 #include "Imebra_Shim.h"     //Wrapper for Imebra library. Black-boxed to speed up compilation.
 #include "YgorArguments.h"   //Needed for ArgumentHandler class.
 #include "YgorMisc.h"        //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorString.h"      //Needed for GetFirstRegex(...)
 
-int main(int argc, char* argv[]){
-//---------------------------------------------------------------------------------------------------------------------
-//------------------------------------------- Instances used throughout -----------------------------------------------
-//---------------------------------------------------------------------------------------------------------------------
-    //std::string db_params("dbname=pacs user=hal host=localhost port=63443");
-    std::string db_params("dbname=pacs user=hal host=localhost port=5432");
+#include "Thread_Pool.h"
 
-    long int NumberOfDaysRecent = 7; //Only update records imported within the specified days.
+namespace {
 
-//---------------------------------------------------------------------------------------------------------------------
-//------------------------------------------------ Option parsing -----------------------------------------------------
-//---------------------------------------------------------------------------------------------------------------------
+//Builds a single statement which fills any NULL columns of the given record using the metadata harvested from the
+// record's file. Columns which already hold a value are not altered.
+std::string Build_Refresh_Statement(pqxx::transaction_base &txn,
+                                    long int pacsid,
+                                    std::map<std::string,std::string> &mmap){
+    const auto null_if_empty_str = [](const std::string &value) -> std::string {
+        std::stringstream ss;
+        ss << " NULLIF( " << value << " ,'') ";
+        return ss.str();
+    };
+    const auto null_if_given_str = [](const std::string &value, const std::string &given) -> std::string {
+        std::stringstream ss;
+        ss << " NULLIF( " << value << " , " << given << " ) ";
+        return ss.str();
+    };
+    const auto cast_to_bigint = [](const std::string &value) -> std::string {
+        std::stringstream ss;
+        ss << " CAST( " << value << " AS BIGINT) ";
+        return ss.str();
+    };
+    const auto cast_to_int = [](const std::string &value) -> std::string {
+        std::stringstream ss;
+        ss << " CAST( " << value << " AS INT) ";
+        return ss.str();
+    };
+    const auto cast_to_real = [](const std::string &value) -> std::string {
+        std::stringstream ss;
+        ss << " CAST( " << value << " AS REAL) ";
+        return ss.str();
+    };
+    const auto cast_to_double = [](const std::string &value) -> std::string {
+        std::stringstream ss;
+        ss << " CAST( " << value << " AS DOUBLE PRECISION) ";
+        return ss.str();
+    };
+    const auto cast_to_date = [](const std::string &value) -> std::string {
+        std::stringstream ss;
+        ss << " CAST( " << value << " AS DATE) ";
+        return ss.str();
+    };
+    const auto cast_to_time = [](const std::string &value) -> std::string {
+        std::stringstream ss;
+        ss << " CAST( " << value << " AS TIME) ";
+        return ss.str();
+    };
+    const auto dicom_string_to_real_array = [&](const std::string &values) -> std::string {
+        auto tokens = SplitStringToVector(values, '\\', 'd');
+        bool first = true;
+        std::stringstream ss;
+        ss << " CAST( ARRAY[ ";
+        for(auto &x : tokens){
+            if(!first) ss << " , ";
+            first = false;
+            ss << cast_to_real( null_if_empty_str( txn.quote(x) ) );
+        }
+        ss << " ] AS REAL[]) ";
+        return ss.str();
+    };
+    const auto dicom_string_to_double_array = [&](const std::string &values) -> std::string {
+        auto tokens = SplitStringToVector(values, '\\', 'd');
+        bool first = true;
+        std::stringstream ss;
+        ss << " CAST( ARRAY[ ";
+        for(auto &x : tokens){
+            if(!first) ss << " , ";
+            first = false;
+            ss << cast_to_real( null_if_empty_str( txn.quote(x) ) );
+        }
+        ss << " ] AS DOUBLE PRECISION[]) ";
+        return ss.str();
+    };
+    const auto dicom_string_to_int_array = [&](const std::string &values) -> std::string {
+        auto tokens = SplitStringToVector(values, '\\', 'd');
+        bool first = true;
+        std::stringstream ss;
+        ss << " CAST( ARRAY[ ";
+        for(auto &x : tokens){
+            if(!first) ss << " , ";
+            first = false;
+            ss << cast_to_int( cast_to_real( null_if_empty_str( txn.quote(x) ) ) );
+        }
+        ss << " ] AS INT[]) ";
+        return ss.str();
+    };
+    std::string colname, value;
+    std::vector<std::pair<std::string, std::string>> updates;
 
+    //---------------------------------------------------------------------------------------------------------
+    //Push the data to the database.
+
+    //skipping "pacsid". (If it is NULL we could not have found it!)
+
+    //DICOM logical hierarchy fields.
+    colname = "PatientID";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "StudyInstanceUID";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "SeriesInstanceUID";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "SOPInstanceUID";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    //DICOM data collection, additional or fallback linkage metadata.
+    colname = "InstanceNumber";
+    value   = cast_to_bigint( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "InstanceCreationDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "InstanceCreationTime";
+    value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "StudyDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "StudyTime";
+    value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "StudyID";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "StudyDescription";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "SeriesDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "SeriesTime";
+    value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "SeriesNumber";
+    value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-    class ArgumentHandler arger;
-    const std::string progname(argv[0]);
-    arger.examples = { { "--help" , "Show the help screen and some info about the program." } };
-    arger.description = "A program for trying to replace database NULLs, if possible.";
+    colname = "SeriesDescription";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-    arger.default_callback = [](int, const std::string &optarg) -> void {
-      FUNCERR("Unrecognized option with argument: '" << optarg << "'");
-      return; 
-    };
-    arger.optionless_callback = [](const std::string &optarg) -> void {
-      FUNCERR("What do you want me to do with the option '" << optarg << "' ?");
-      return; 
-    };
+    colname = "AcquisitionDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-    arger.push_back( ygor_arg_handlr_t(1, 'd', "days-back", true, Xtostring(NumberOfDaysRecent), 
-      "The number of days back for which the import was considered 'recent'. (Only recent records are updated.)",
-      [&](const std::string &optarg) -> void {
-        if(!Is_String_An_X<long int>(optarg)) FUNCERR("'" << optarg << "' is not a valid number of days");
-        NumberOfDaysRecent = fabs(stringtoX<long int>(optarg));
-        return;
-      })
-    );
+    colname = "AcquisitionTime";
+    value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-    arger.Launch(argc, argv);
+    colname = "AcquisitionNumber";
+    value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-//---------------------------------------------------------------------------------------------------------------------
-//------------------------------------------------ Input Verification ---------------------------------------------------
-//---------------------------------------------------------------------------------------------------------------------
+    colname = "ContentDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-//---------------------------------------------------------------------------------------------------------------------
-//----------------------------------------------- Filename Testing ----------------------------------------------------
-//---------------------------------------------------------------------------------------------------------------------
+    colname = "ContentTime";
+    value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-//---------------------------------------------------------------------------------------------------------------------
-//----------------------------------------------- Database Initiation -------------------------------------------------
-//---------------------------------------------------------------------------------------------------------------------
- 
-    try{
-        pqxx::connection c(db_params);
-        pqxx::work txn(c);
-        std::stringstream tb1, tb2;
+    colname = "BodyPartExamined";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "ScanningSequence";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "SequenceVariant";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "ScanOptions";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "MRAcquisitionType";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    //DICOM image, dose map specifications and metadata.
+    colname = "SliceThickness";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "SliceNumber";
+    value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "SliceLocation";
+    value   = cast_to_real( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ) , txn.quote("0") ) );
+    updates.emplace_back(colname, value);
+
+    colname = "ImageIndex";
+    value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "SpacingBetweenSlices";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "ImagePositionPatient";
+    value   = dicom_string_to_real_array( mmap[colname] );
+    updates.emplace_back(colname, value);
+
+    colname = "ImageOrientationPatient";
+    value   = dicom_string_to_real_array( mmap[colname] );
+    updates.emplace_back(colname, value);
+
+    colname = "FrameOfReferenceUID";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "PositionReferenceIndicator";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "SamplesPerPixel";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "PhotometricInterpretation";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "NumberofFrames";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "FrameIncrementPointer";
+    value   = dicom_string_to_int_array( mmap[colname] );
+    updates.emplace_back(colname, value);
 
-        //-------------------------------------------------------------------------------------------------------------
-        //Select records from the system pacs database.
-        
-        pqxx::result r1;
-        {
-          std::stringstream ss;
-          ss << "SELECT * FROM metadata "
-             << "WHERE (metadata.ImportTimepoint > (now() - INTERVAL '" << NumberOfDaysRecent << " days'));"; 
-          r1 = txn.exec(ss.str());
-        }
-        if(r1.empty()) FUNCERR("Database table 'metadata' contains no records. Nothing to do");
-        FUNCINFO("Found " << r1.size() << " records to inspect");
-
-        //-------------------------------------------------------------------------------------------------------------
-        //Process each record, parsing the file, saving metadata, and walking over the columns to see if they are null.
-        for(pqxx::result::size_type i = 0; i != r1.size(); ++i){
-            //Get the returned pacsid.
-            const auto pacsid = r1[i]["pacsid"].as<long int>();
-
-            //Get the store filename and check if the file has been validated.
-            const auto storefullpathname = r1[i]["StoreFullPathName"].as<std::string>();
-
-            // TODO: if checksum non-NULL, verify it is correct. Fail with lots of info if not correct!
-            //       if checksum is NULL, compute it and update the db.
-
-            //Print to screen what the original filename was, so the user can inspect what files are being processed.
-            FUNCINFO("About to parse file with pacsid = " << pacsid << " at location '" << storefullpathname << "'");
-            FUNCINFO("Completion: " << i << "/" << r1.size() << " == " << static_cast<double>(10000*i/r1.size())/100.0 << "%");
-
-            //Harvest the metadata of interest.
-            auto mmap = get_metadata_top_level_tags(storefullpathname);
-
-            //Generate some conveniences for later.
-            pqxx::result r3;
-            const auto update_boilerplate = [&](const std::string &colname, const std::string &value) -> std::string {
-                std::stringstream ss;
-                ss << " UPDATE metadata ";
-                ss << " SET (" << colname << ") ";
-                ss << " = (COALESCE(" << colname << "," << value << ")) ";  //Avoid changing if something is already present.
-                ss << " WHERE pacsid = " << pacsid << " ";
-                ss << " RETURNING pacsid; ";
-                return ss.str();
-            };
-            const auto check_update_ok = [&](const std::string &colname) -> void {
-                if((r3.size() != 1) || (r3[0]["pacsid"].as<long int>() != pacsid)){
-                    FUNCERR("Update of column name '" << colname << "' failed. Refusing to continue");
-                }
-                return;
-            };
-            const auto null_if_empty_str = [](const std::string &value) -> std::string {
-                std::stringstream ss;
-                ss << " NULLIF( " << value << " ,'') ";
-                return ss.str();
-            };
-            const auto null_if_given_str = [](const std::string &value, const std::string &given) -> std::string {
-                std::stringstream ss;
-                ss << " NULLIF( " << value << " , " << given << " ) ";
-                return ss.str();
-            };
-            const auto cast_to_bigint = [](const std::string &value) -> std::string {
-                std::stringstream ss;
-                ss << " CAST( " << value << " AS BIGINT) ";
-                return ss.str();
-            };
-            const auto cast_to_int = [](const std::string &value) -> std::string {
-                std::stringstream ss;
-                ss << " CAST( " << value << " AS INT) ";
-                return ss.str();
-            };
-            const auto cast_to_real = [](const std::string &value) -> std::string {
-                std::stringstream ss;
-                ss << " CAST( " << value << " AS REAL) ";
-                return ss.str();
-            };
-            const auto cast_to_double = [](const std::string &value) -> std::string {
-                std::stringstream ss;
-                ss << " CAST( " << value << " AS DOUBLE PRECISION) ";
-                return ss.str();
-            };
-            const auto cast_to_date = [](const std::string &value) -> std::string {
-                std::stringstream ss;
-                ss << " CAST( " << value << " AS DATE) ";
-                return ss.str();
-            };
-            const auto cast_to_time = [](const std::string &value) -> std::string {
-                std::stringstream ss;
-                ss << " CAST( " << value << " AS TIME) ";
-                return ss.str();
-            };
-            const auto dicom_string_to_real_array = [&](const std::string &values) -> std::string {
-                auto tokens = SplitStringToVector(values, '\\', 'd');
-                bool first = true;
-                std::stringstream ss;
-                ss << " CAST( ARRAY[ ";
-                for(auto &x : tokens){
-                    if(!first) ss << " , ";
-                    first = false;
-                    ss << cast_to_real( null_if_empty_str( txn.quote(x) ) );
-                }
-                ss << " ] AS REAL[]) ";
-                return ss.str();
-            };
-            const auto dicom_string_to_double_array = [&](const std::string &values) -> std::string {
-                auto tokens = SplitStringToVector(values, '\\', 'd');
-                bool first = true;
-                std::stringstream ss;
-                ss << " CAST( ARRAY[ ";
-                for(auto &x : tokens){
-                    if(!first) ss << " , ";
-                    first = false;
-                    ss << cast_to_real( null_if_empty_str( txn.quote(x) ) );
-                }
-                ss << " ] AS DOUBLE PRECISION[]) ";
-                return ss.str();
-            };
-            const auto dicom_string_to_int_array = [&](const std::string &values) -> std::string {
-                auto tokens = SplitStringToVector(values, '\\', 'd');
-                bool first = true;
-                std::stringstream ss;
-                ss << " CAST( ARRAY[ ";
-                for(auto &x : tokens){
-                    if(!first) ss << " , ";
-                    first = false;
-                    ss << cast_to_int( cast_to_real( null_if_empty_str( txn.quote(x) ) ) );
-                }
-                ss << " ] AS INT[]) ";
-                return ss.str();
-            };
-            std::string colname, value;
-
-            //---------------------------------------------------------------------------------------------------------
-            //Push the data to the database.
-
-            //skipping "pacsid". (If it is NULL we could not have found it!)
-
-            //DICOM logical hierarchy fields.
-            colname = "PatientID";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "StudyInstanceUID";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "SeriesInstanceUID";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "SOPInstanceUID";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            //DICOM data collection, additional or fallback linkage metadata.
-            colname = "InstanceNumber";
-            value   = cast_to_bigint( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "InstanceCreationDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "InstanceCreationTime";
-            value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "StudyDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "StudyTime";
-            value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "StudyID";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "StudyDescription";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "SeriesDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "SeriesTime";
-            value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "SeriesNumber";
-            value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
 
-            colname = "SeriesDescription";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "Rows";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "AcquisitionDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "AcquisitionTime";
-            value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "AcquisitionNumber";
-            value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "ContentDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "ContentTime";
-            value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "BodyPartExamined";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "ScanningSequence";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "Columns";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "SequenceVariant";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "ScanOptions";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "MRAcquisitionType";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            //DICOM image, dose map specifications and metadata.
-            colname = "SliceThickness";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "SliceNumber";
-            value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "SliceLocation";
-            value   = cast_to_real( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ) , txn.quote("0") ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "ImageIndex";
-            value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PixelSpacing";
+    value   = dicom_string_to_real_array( mmap[colname] );
+    updates.emplace_back(colname, value);
 
-            colname = "SpacingBetweenSlices";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "BitsAllocated";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "ImagePositionPatient";
-            value   = dicom_string_to_real_array( mmap[colname] );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "BitsStored";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "ImageOrientationPatient";
-            value   = dicom_string_to_real_array( mmap[colname] );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "HighBit";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "FrameOfReferenceUID";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PixelRepresentation";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "PositionReferenceIndicator";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "DoseUnits";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "SamplesPerPixel";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "DoseType";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "PhotometricInterpretation";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "DoseSummationType";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "NumberofFrames";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "DoseGridScaling";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "FrameIncrementPointer";
-            value   = dicom_string_to_int_array( mmap[colname] );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "GridFrameOffsetVector";
+    value   = dicom_string_to_real_array( mmap[colname] );
+    updates.emplace_back(colname, value);
 
+    colname = "TemporalPositionIdentifier";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "Rows";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "NumberofTemporalPositions";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "Columns";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "TemporalResolution";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "PixelSpacing";
-            value   = dicom_string_to_real_array( mmap[colname] );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
 
-            colname = "BitsAllocated";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "TemporalPositionIndex";
+    value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "BitsStored";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "FrameReferenceTime"; //Not a true time. Integer number of msec.
+    value   = cast_to_bigint( cast_to_real( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0") ) ) );
+    //value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "HighBit";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "FrameTime";
+    value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "PixelRepresentation";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "TriggerTime";
+    //value   = cast_to_bigint( cast_to_real( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0") ) ) );
+    value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "DoseUnits";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "TriggerTimeOffset";
+    value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "DoseType";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PerformedProcedureStepStartDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    updates.emplace_back(colname, value);
 
-            colname = "DoseSummationType";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PerformedProcedureStepStartTime";
+    value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "DoseGridScaling";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PerformedProcedureStepEndDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    updates.emplace_back(colname, value);
 
-            colname = "GridFrameOffsetVector";
-            value   = dicom_string_to_real_array( mmap[colname] );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PerformedProcedureStepEndTime";
+    value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "TemporalPositionIdentifier";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "Exposure";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "NumberofTemporalPositions";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "ExposureTime";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "TemporalResolution";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "ExposureInMicroAmpereSeconds";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
+    colname = "XRayTubeCurrent";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "TemporalPositionIndex";
-            value   = cast_to_int( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "RepetitionTime";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "FrameReferenceTime"; //Not a true time. Integer number of msec.
-            value   = cast_to_bigint( cast_to_real( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0") ) ) );
-            //value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "EchoTime";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "FrameTime";
-            value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "NumberofAverages";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "TriggerTime";
-            //value   = cast_to_bigint( cast_to_real( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0") ) ) );
-            value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "ImagingFrequency";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "TriggerTimeOffset";
-            value   = cast_to_bigint( cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "ImagedNucleus";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "PerformedProcedureStepStartDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "EchoNumbers";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "PerformedProcedureStepStartTime";
-            value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "MagneticFieldStrength";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "PerformedProcedureStepEndDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "NumberofPhaseEncodingSteps";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "PerformedProcedureStepEndTime";
-            value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
 
-            colname = "Exposure";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "EchoTrainLength";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "ExposureTime";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PercentSampling";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "ExposureInMicroAmpereSeconds";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PercentPhaseFieldofView";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "XRayTubeCurrent";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "PixelBandwidth";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "RepetitionTime";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "DeviceSerialNumber";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "EchoTime";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "ProtocolName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "NumberofAverages";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "ReceiveCoilName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "ImagingFrequency";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "TransmitCoilName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "ImagedNucleus";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "InplanePhaseEncodingDirection";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
 
-            colname = "EchoNumbers";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "FlipAngle";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "MagneticFieldStrength";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "SAR";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
-            colname = "NumberofPhaseEncodingSteps";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    colname = "dB_dt";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
 
+    colname = "PatientPosition";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "AcquisitionDuration";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "Diffusion_bValue";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "DiffusionGradientOrientation";
+    value   = dicom_string_to_double_array( mmap[colname] );
+    updates.emplace_back(colname, value);
+
+    colname = "DiffusionDirection";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "WindowCenter";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "WindowWidth";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "RescaleIntercept";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "RescaleSlope";
+    value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "RescaleType";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    //DICOM radiotherapy plan metadata.
+    colname = "RTPlanLabel";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "RTPlanName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "RTPlanDescription";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "RTPlanDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "RTPlanTime";
+    value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "RTPlanGeometry";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    //DICOM patient, physician, operator metadata.
+    colname = "PatientsName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "PatientsBirthDate";
+    value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
+    updates.emplace_back(colname, value);
+
+    colname = "PatientsGender";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "PatientsWeight";
+    value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    colname = "OperatorsName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "ReferringPhysicianName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    //DICOM categorical fields.
+    colname = "SOPClassUID";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "Modality";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    //DICOM machine/device, institution fields.
+    colname = "Manufacturer";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "StationName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "ManufacturersModelName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "SoftwareVersions";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "InstitutionName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    colname = "InstitutionalDepartmentName";
+    value   = null_if_empty_str( txn.quote(mmap[colname]) );
+    updates.emplace_back(colname, value);
+
+    //Non-DICOM metadata fields.
+    colname = "ContentHash";
+    value   = cast_to_bigint( null_if_empty_str( txn.quote(mmap[colname]) ) );
+    updates.emplace_back(colname, value);
+
+    // - skipping "Project"
+    // - skipping "Comments"
+    // - skipping "FullPathName"
+    // - skipping "gdcmdump"
+    // - skipping "ImportTimepoint"
+
+    //Combine the updates so each record needs only a single round-trip.
+    std::stringstream ss;
+    ss << " UPDATE metadata SET ";
+    bool first = true;
+    for(const auto &u : updates){
+        if(!first) ss << " , ";
+        first = false;
+        ss << u.first << " = COALESCE(" << u.first << "," << u.second << ") ";  //Avoid changing if something is already present.
+    }
+    ss << " WHERE pacsid = " << pacsid << " ";
+    ss << " RETURNING pacsid; ";
+    return ss.str();
+}
 
-            colname = "EchoTrainLength";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+//A record to be refreshed.
+struct refresh_record {
+    long int pacsid = -1;
+    std::string StoreFullPathName;
+    std::map<std::string,std::string> mmap;
+};
+
+//Refreshes the given records. Files are parsed concurrently, but the database is updated sequentially because the
+// transaction cannot be shared between threads.
+void Refresh_Records(pqxx::transaction_base &txn, std::vector<refresh_record> &records){
+    //Harvest the metadata of interest.
+    parallel_for(0, static_cast<long int>(records.size()), [&](long int i) -> void {
+        // TODO: if checksum non-NULL, verify it is correct. Fail with lots of info if not correct!
+        //       if checksum is NULL, compute it and update the db.
+        try{
+            const auto pdf = Parse_DICOM_File(records[i].StoreFullPathName);
+            records[i].mmap = get_metadata_top_level_tags(pdf);
+
+            //The hash is stored as a (signed) BIGINT.
+            records[i].mmap["ContentHash"] = std::to_string(static_cast<int64_t>(get_content_hash(pdf)));
+        }catch(const std::exception &e){
+            FUNCWARN("Unable to parse file '" << records[i].StoreFullPathName << "': " << e.what());
+        }
+    }, /*grain=*/ 1);
+
+    //Push the data to the database.
+    for(auto &rec : records){
+        const auto r3 = txn.exec(Build_Refresh_Statement(txn, rec.pacsid, rec.mmap));
+        if((r3.size() != 1) || (r3[0]["pacsid"].as<long int>() != rec.pacsid)){
+            FUNCERR("Update of record with pacsid = " << rec.pacsid << " at location '"
+                    << rec.StoreFullPathName << "' failed. Refusing to continue");
+        }
+    }
+    return;
+}
 
-            colname = "PercentSampling";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+} // namespace
 
-            colname = "PercentPhaseFieldofView";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+int main(int argc, char* argv[]){
+//---------------------------------------------------------------------------------------------------------------------
+//------------------------------------------- Instances used throughout -----------------------------------------------
+//---------------------------------------------------------------------------------------------------------------------
+    //std::string db_params("dbname=pacs user=hal host=localhost port=63443");
+    std::string db_params("dbname=pacs user=hal host=localhost port=5432");
 
-            colname = "PixelBandwidth";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    long int NumberOfDaysRecent = 7; //Only update records imported within the specified days.
 
-            colname = "DeviceSerialNumber";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    bool Incremental = false; //Only update records beyond the stored high-water mark, advancing it as records are updated.
+    std::string MarkName("default"); //The name of the high-water mark, so distinct refresh tasks can be tracked.
+    long int BatchSize = 1000; //The number of records parsed concurrently (and, if incremental, per transaction).
 
-            colname = "ProtocolName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+//---------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------ Option parsing -----------------------------------------------------
+//---------------------------------------------------------------------------------------------------------------------
 
-            colname = "ReceiveCoilName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
 
-            colname = "TransmitCoilName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    class ArgumentHandler arger;
+    const std::string progname(argv[0]);
+    arger.examples = { { "--help" , "Show the help screen and some info about the program." } };
+    arger.description = "A program for trying to replace database NULLs, if possible.";
 
-            colname = "InplanePhaseEncodingDirection";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    arger.default_callback = [](int, const std::string &optarg) -> void {
+      FUNCERR("Unrecognized option with argument: '" << optarg << "'");
+      return; 
+    };
+    arger.optionless_callback = [](const std::string &optarg) -> void {
+      FUNCERR("What do you want me to do with the option '" << optarg << "' ?");
+      return; 
+    };
 
-            colname = "FlipAngle";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    arger.push_back( ygor_arg_handlr_t(1, 'd', "days-back", true, Xtostring(NumberOfDaysRecent), 
+      "The number of days back for which the import was considered 'recent'. (Only recent records are updated.)",
+      [&](const std::string &optarg) -> void {
+        if(!Is_String_An_X<long int>(optarg)) FUNCERR("'" << optarg << "' is not a valid number of days");
+        NumberOfDaysRecent = fabs(stringtoX<long int>(optarg));
+        return;
+      })
+    );
 
-            colname = "SAR";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    arger.push_back( ygor_arg_handlr_t(1, 'i', "incremental", false, "", 
+      "Rather than selecting by import time, update all records with a pacsid beyond the stored high-water mark."
+      " Records are processed in order, one batch per transaction, and the mark is advanced as each batch is"
+      " committed. Interrupted refreshes resume where they left off. The first incremental refresh processes all"
+      " records.",
+      [&](const std::string &) -> void {
+        Incremental = true;
+        return;
+      })
+    );
+
+    arger.push_back( ygor_arg_handlr_t(1, 'm', "mark-name", true, MarkName, 
+      "The name of the high-water mark used for incremental refreshes.",
+      [&](const std::string &optarg) -> void {
+        MarkName = optarg;
+        return;
+      })
+    );
 
-            colname = "dB_dt";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
+    arger.push_back( ygor_arg_handlr_t(1, 'B', "batch-size", true, Xtostring(BatchSize), 
+      "The number of records whose files are parsed concurrently. For incremental refreshes, this is also the"
+      " number of records updated per transaction.",
+      [&](const std::string &optarg) -> void {
+        if(!Is_String_An_X<long int>(optarg)) FUNCERR("'" << optarg << "' is not a valid batch size");
+        BatchSize = stringtoX<long int>(optarg);
+        if(BatchSize <= 0) FUNCERR("Batch size must be positive");
+        return;
+      })
+    );
 
-            colname = "PatientPosition";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "AcquisitionDuration";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "Diffusion_bValue";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "DiffusionGradientOrientation";
-            value   = dicom_string_to_double_array( mmap[colname] );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "DiffusionDirection";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "WindowCenter";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "WindowWidth";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "RescaleIntercept";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "RescaleSlope";
-            value   = cast_to_double( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "RescaleType";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            //DICOM radiotherapy plan metadata.
-            colname = "RTPlanLabel";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "RTPlanName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "RTPlanDescription";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "RTPlanDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            //value   = cast_to_date( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "RTPlanTime";
-            value   = cast_to_time( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "RTPlanGeometry";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            //DICOM patient, physician, operator metadata.
-            colname = "PatientsName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "PatientsBirthDate";
-            value   = cast_to_date( null_if_given_str( null_if_empty_str( txn.quote(mmap[colname]) ), txn.quote("0000-00-00")) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "PatientsGender";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "PatientsWeight";
-            value   = cast_to_real( null_if_empty_str( txn.quote(mmap[colname]) ) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "OperatorsName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "ReferringPhysicianName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            //DICOM categorical fields.
-            colname = "SOPClassUID";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "Modality";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            //DICOM machine/device, institution fields.
-            colname = "Manufacturer";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "StationName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "ManufacturersModelName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "SoftwareVersions";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "InstitutionName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            colname = "InstitutionalDepartmentName";
-            value   = null_if_empty_str( txn.quote(mmap[colname]) );
-            r3 = txn.exec(update_boilerplate(colname, value));            check_update_ok(colname);
-
-            //Non-DICOM metadata fields.
-            // - skipping "Project"
-            // - skipping "Comments"
-            // - skipping "FullPathName"
-            // - skipping "gdcmdump"
-            // - skipping "ImportTimepoint"
-
-            //---------------------------------------------------------------------------------------------------------
+    arger.Launch(argc, argv);
+
+//---------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------ Input Verification ---------------------------------------------------
+//---------------------------------------------------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------------------------------------------------
+//----------------------------------------------- Filename Testing ----------------------------------------------------
+//---------------------------------------------------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------------------------------------------------
+//----------------------------------------------- Database Initiation -------------------------------------------------
+//---------------------------------------------------------------------------------------------------------------------
+ 
+    try{
+        pqxx::connection c(db_params);
+
+        //Older databases may predate the content hash column.
+        {
+            pqxx::work txn(c);
+            txn.exec("ALTER TABLE metadata ADD COLUMN IF NOT EXISTS ContentHash BIGINT;");
+            txn.exec("CREATE INDEX IF NOT EXISTS metadata_contenthash_idx ON metadata (ContentHash);");
+            txn.commit();
         }
 
-        //-------------------------------------------------------------------------------------------------------------
-        //Finish the transaction and drop the connection.
-        txn.commit();
+        //Only the pacsid and store location are needed to refresh a record.
+        c.prepare("select_after_mark",
+                  "SELECT pacsid, StoreFullPathName FROM metadata "
+                  "WHERE (pacsid > $1) ORDER BY pacsid LIMIT $2;");
+
+        if(!Incremental){
+            pqxx::work txn(c);
+
+            //-------------------------------------------------------------------------------------------------------------
+            //Select records from the system pacs database.
+            pqxx::result r1;
+            {
+              std::stringstream ss;
+              ss << "SELECT pacsid, StoreFullPathName FROM metadata "
+                 << "WHERE (metadata.ImportTimepoint > (now() - INTERVAL '" << NumberOfDaysRecent << " days')) "
+                 << "ORDER BY pacsid;"; 
+              r1 = txn.exec(ss.str());
+            }
+            if(r1.empty()) FUNCERR("Database table 'metadata' contains no records. Nothing to do");
+            FUNCINFO("Found " << r1.size() << " records to inspect");
+
+            //Process each batch of records, parsing the files and filling in any null columns.
+            std::vector<refresh_record> records;
+            for(pqxx::result::size_type i = 0; i != r1.size(); ++i){
+                records.emplace_back();
+                records.back().pacsid = r1[i]["pacsid"].as<long int>();
+                records.back().StoreFullPathName = r1[i]["StoreFullPathName"].as<std::string>();
+
+                if( (static_cast<long int>(records.size()) == BatchSize)
+                ||  ((i + 1) == r1.size()) ){
+                    Refresh_Records(txn, records);
+                    records.clear();
+                    FUNCINFO("Completion: " << (i + 1) << "/" << r1.size() << " == "
+                             << static_cast<double>(10000*(i + 1)/r1.size())/100.0 << "%");
+                }
+            }
+
+            //-------------------------------------------------------------------------------------------------------------
+            //Finish the transaction and drop the connection.
+            txn.commit();
+
+        }else{
+            //The high-water mark is stored alongside the data so that it is only advanced when a batch is committed.
+            {
+                pqxx::work txn(c);
+                txn.exec("CREATE TABLE IF NOT EXISTS pacs_refresh_marks ( "
+                         "    name TEXT PRIMARY KEY, "
+                         "    last_pacsid BIGINT NOT NULL "
+                         ");");
+                txn.commit();
+            }
+            c.prepare("select_mark",
+                      "SELECT last_pacsid FROM pacs_refresh_marks WHERE name = $1;");
+            c.prepare("update_mark",
+                      "INSERT INTO pacs_refresh_marks (name, last_pacsid) VALUES ($1, $2) "
+                      "ON CONFLICT (name) DO UPDATE SET last_pacsid = EXCLUDED.last_pacsid;");
+
+            long int processed = 0;
+            while(true){
+                pqxx::work txn(c);
+
+                long int mark = 0;
+                {
+                    const auto r = txn.exec_prepared("select_mark", MarkName);
+                    if(!r.empty()) mark = r[0]["last_pacsid"].as<long int>();
+                }
+
+                //Keyset pagination over the pacsid index, so each batch costs the same regardless of table size.
+                const auto r1 = txn.exec_prepared("select_after_mark", mark, BatchSize);
+                if(r1.empty()){
+                    FUNCINFO("No records beyond pacsid " << mark << ". Refreshed " << processed << " records");
+                    break;
+                }
+
+                std::vector<refresh_record> records;
+                for(pqxx::result::size_type i = 0; i != r1.size(); ++i){
+                    records.emplace_back();
+                    records.back().pacsid = r1[i]["pacsid"].as<long int>();
+                    records.back().StoreFullPathName = r1[i]["StoreFullPathName"].as<std::string>();
+                }
+                Refresh_Records(txn, records);
+
+                txn.exec_prepared("update_mark", MarkName, records.back().pacsid);
+                txn.commit();
+
+                processed += static_cast<long int>(records.size());
+                FUNCINFO("Refreshed " << processed << " records (up to pacsid " << records.back().pacsid << ")");
+            }
+        }
 
     }catch(const std::exception &e){
         FUNCERR("Unable to push to database: " << e.what());
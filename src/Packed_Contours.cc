@@ -0,0 +1,233 @@
+//Packed_Contours.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+
+#include "Packed_Contours.h"
+
+
+packed_contours::packed_contours(std::pmr::memory_resource *mr) : x(mr), y(mr), z(mr), offsets(mr), closed(mr) {
+    this->offsets.push_back(0);
+}
+
+
+void packed_contours::reserve(size_t N_contours, size_t N_points){
+    this->x.reserve(N_points);
+    this->y.reserve(N_points);
+    this->z.reserve(N_points);
+    this->offsets.reserve(N_contours + 1);
+    this->closed.reserve(N_contours);
+    return;
+}
+
+
+void packed_contours::start_contour(bool is_closed){
+    this->offsets.push_back(this->offsets.back());
+    this->closed.push_back(is_closed ? 1 : 0);
+    return;
+}
+
+
+void packed_contours::reverse(size_t i){
+    const auto b = static_cast<std::ptrdiff_t>(this->offsets[i]);
+    const auto e = static_cast<std::ptrdiff_t>(this->offsets[i + 1]);
+    std::reverse(std::next(std::begin(this->x), b), std::next(std::begin(this->x), e));
+    std::reverse(std::next(std::begin(this->y), b), std::next(std::begin(this->y), e));
+    std::reverse(std::next(std::begin(this->z), b), std::next(std::begin(this->z), e));
+    return;
+}
+
+
+namespace {
+
+template <class C, class F>
+packed_contours Pack(const C &contours, bool include_metadata, std::pmr::memory_resource *mr, F get){
+    packed_contours out(mr);
+    size_t N_points = 0;
+    for(const auto &c : contours) N_points += get(c).points.size();
+    out.reserve(contours.size(), N_points);
+    if(include_metadata) out.metadata.reserve(contours.size());
+
+    for(const auto &c : contours){
+        const auto &cop = get(c);
+        out.start_contour(cop.closed);
+        if(include_metadata) out.metadata.emplace_back(cop.metadata);
+        for(const auto &v : cop.points) out.add_point(v);
+    }
+    return out;
+}
+
+} // namespace
+
+
+packed_contours Pack_Contours(const std::list<contour_of_points<double>> &contours,
+                              bool include_metadata,
+                              std::pmr::memory_resource *mr){
+    return Pack(contours, include_metadata, mr, [](const contour_of_points<double> &c) -> const auto & { return c; });
+}
+
+
+packed_contours Pack_Contours(const std::list<std::reference_wrapper<contour_of_points<double>>> &contours,
+                              bool include_metadata,
+                              std::pmr::memory_resource *mr){
+    return Pack(contours, include_metadata, mr,
+                [](const std::reference_wrapper<contour_of_points<double>> &c) -> const auto & { return c.get(); });
+}
+
+
+std::list<contour_of_points<double>> Unpack_Contours(const packed_contours &pc){
+    contour_collection<double> cc;
+    Unpack_Contours(pc, cc);
+    return std::move(cc.contours);
+}
+
+
+void Unpack_Contours(const packed_contours &pc, contour_collection<double> &out){
+    for(size_t i = 0; i < pc.size(); ++i){
+        out.contours.emplace_back();
+        auto &c = out.contours.back();
+        c.closed = (pc.closed[i] != 0);
+        for(auto k = pc.offsets[i]; k < pc.offsets[i + 1]; ++k) c.points.emplace_back(pc.point(k));
+        if(!pc.metadata.empty()) c.metadata = pc.metadata[i];
+    }
+    return;
+}
+
+
+// The area is accumulated from a fan of triangles around the first vertex, which needs no wrap-around and keeps the
+// magnitude of the summands small for contours far from the origin.
+double Contour_Signed_Area(const packed_contours &pc, size_t i, const vec3<double> &N){
+    const auto b = pc.offsets[i];
+    const auto e = pc.offsets[i + 1];
+    if((e - b) < 3) return 0.0;
+
+    const double *x = pc.x.data();
+    const double *y = pc.y.data();
+    const double *z = pc.z.data();
+    const double x0 = x[b], y0 = y[b], z0 = z[b];
+
+    double twice_area = 0.0;
+    for(auto k = b + 1; (k + 1) < e; ++k){
+        const double ax = x[k] - x0, ay = y[k] - y0, az = z[k] - z0;
+        const double bx = x[k + 1] - x0, by = y[k + 1] - y0, bz = z[k + 1] - z0;
+        twice_area += N.x * (ay * bz - az * by)
+                    + N.y * (az * bx - ax * bz)
+                    + N.z * (ax * by - ay * bx);
+    }
+    return 0.5 * twice_area;
+}
+
+
+vec3<double> Contour_Centroid(const packed_contours &pc, size_t i, const vec3<double> &N){
+    const auto b = pc.offsets[i];
+    const auto e = pc.offsets[i + 1];
+    if(e <= b) return vec3<double>(std::nan(""), std::nan(""), std::nan(""));
+
+    const double *x = pc.x.data();
+    const double *y = pc.y.data();
+    const double *z = pc.z.data();
+    const double x0 = x[b], y0 = y[b], z0 = z[b];
+
+    // Triangle centroids weighted by their signed areas, relative to the first vertex.
+    double sum_w = 0.0, sum_x = 0.0, sum_y = 0.0, sum_z = 0.0;
+    for(auto k = b + 1; (k + 1) < e; ++k){
+        const double ax = x[k] - x0, ay = y[k] - y0, az = z[k] - z0;
+        const double bx = x[k + 1] - x0, by = y[k + 1] - y0, bz = z[k + 1] - z0;
+        const double w = N.x * (ay * bz - az * by)
+                       + N.y * (az * bx - ax * bz)
+                       + N.z * (ax * by - ay * bx);
+        sum_w += w;
+        sum_x += w * (ax + bx);
+        sum_y += w * (ay + by);
+        sum_z += w * (az + bz);
+    }
+
+    // Fall back to the vertex average for degenerate contours, where the weights would be dominated by round-off.
+    const double perimeter = Contour_Perimeter(pc, i);
+    if( !std::isfinite(sum_w)
+    ||  !(std::abs(sum_w) > 1.0E-12 * perimeter * perimeter) ){
+        double avg_x = 0.0, avg_y = 0.0, avg_z = 0.0;
+        for(auto k = b; k < e; ++k){
+            avg_x += x[k];
+            avg_y += y[k];
+            avg_z += z[k];
+        }
+        const auto n = static_cast<double>(e - b);
+        return vec3<double>(avg_x / n, avg_y / n, avg_z / n);
+    }
+    return vec3<double>(x0 + sum_x / (3.0 * sum_w),
+                        y0 + sum_y / (3.0 * sum_w),
+                        z0 + sum_z / (3.0 * sum_w));
+}
+
+
+double Contour_Perimeter(const packed_contours &pc, size_t i){
+    const auto b = pc.offsets[i];
+    const auto e = pc.offsets[i + 1];
+    if((e - b) < 2) return 0.0;
+
+    const double *x = pc.x.data();
+    const double *y = pc.y.data();
+    const double *z = pc.z.data();
+
+    double length = 0.0;
+    for(auto k = b; (k + 1) < e; ++k){
+        const double dx = x[k + 1] - x[k], dy = y[k + 1] - y[k], dz = z[k + 1] - z[k];
+        length += std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    if(pc.closed[i] != 0){
+        const double dx = x[b] - x[e - 1], dy = y[b] - y[e - 1], dz = z[b] - z[e - 1];
+        length += std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    return length;
+}
+
+
+void Project_Contour(const packed_contours &pc, size_t i,
+                     const vec3<double> &origin, const vec3<double> &U, const vec3<double> &V,
+                     std::vector<double> &us, std::vector<double> &vs){
+    const auto b = pc.offsets[i];
+    const auto n = pc.vertex_count(i);
+    us.resize(n);
+    vs.resize(n);
+
+    const double *x = pc.x.data() + b;
+    const double *y = pc.y.data() + b;
+    const double *z = pc.z.data() + b;
+    double *u = us.data();
+    double *v = vs.data();
+    for(size_t k = 0; k < n; ++k){
+        const double dx = x[k] - origin.x, dy = y[k] - origin.y, dz = z[k] - origin.z;
+        u[k] = dx * U.x + dy * U.y + dz * U.z;
+        v[k] = dx * V.x + dy * V.y + dz * V.z;
+    }
+    return;
+}
+
+
+bool Point_In_Projected_Contour(const std::vector<double> &us, const std::vector<double> &vs, double u, double v){
+    const auto n = std::min(us.size(), vs.size());
+    if(n < 3) return false;
+
+    // Edges (k-1, k) are visited in order, and the closing edge (n-1, 0) separately, so the loop has no wrap-around.
+    // Divisions are guarded rather than skipped to keep the loop free of branches.
+    const auto crosses = [&](size_t i, size_t j) -> long int {
+        const bool straddles = ((vs[i] > v) != (vs[j] > v));
+        const double dv = straddles ? (vs[j] - vs[i]) : 1.0;
+        const double u_cross = us[i] + (us[j] - us[i]) * (v - vs[i]) / dv;
+        return (straddles && (u < u_cross)) ? 1 : 0;
+    };
+    long int crossings = crosses(0, n - 1);
+    for(size_t k = 1; k < n; ++k) crossings += crosses(k, k - 1);
+    return ((crossings % 2) == 1);
+}
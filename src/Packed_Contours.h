@@ -0,0 +1,97 @@
+//Packed_Contours.h.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+// Contours stored contiguously, as an alternative to contour_of_points (which holds a std::list of vertices, so every
+// vertex is a separate allocation). The coordinates of all vertices share three buffers (one per axis, so kernels can
+// stream through each with unit stride), and contour i spans the vertices [offsets[i], offsets[i+1]).
+//
+// Buffers are obtained from the provided memory resource, so routines that build many short-lived contours can supply
+// an arena (e.g., std::pmr::monotonic_buffer_resource) and release everything at once when finished. The memory
+// resource must outlive the packed contours.
+//
+// Conversions to and from the existing contour types are provided below. Vertices are copied exactly, so a round trip
+// is lossless.
+struct packed_contours {
+    std::pmr::vector<double> x;
+    std::pmr::vector<double> y;
+    std::pmr::vector<double> z;
+    std::pmr::vector<size_t> offsets;   // One more element than the number of contours.
+    std::pmr::vector<uint8_t> closed;
+
+    // Either empty or one element per contour. Callers that add contours maintain it.
+    std::vector<std::map<std::string, std::string>> metadata;
+
+    explicit packed_contours(std::pmr::memory_resource *mr = std::pmr::get_default_resource());
+
+    size_t size() const { return this->closed.size(); }
+    bool empty() const { return this->closed.empty(); }
+    size_t vertex_count(size_t i) const { return this->offsets[i + 1] - this->offsets[i]; }
+
+    // Vertex k of all contours, i.e., contour i holds vertices offsets[i] through offsets[i+1]-1.
+    vec3<double> point(size_t k) const { return vec3<double>(this->x[k], this->y[k], this->z[k]); }
+
+    void reserve(size_t N_contours, size_t N_points);
+
+    // Appends an empty contour. Vertices are then appended with add_point() until the next contour is started.
+    void start_contour(bool is_closed);
+    void add_point(const vec3<double> &v){
+        this->x.push_back(v.x);
+        this->y.push_back(v.y);
+        this->z.push_back(v.z);
+        ++(this->offsets.back());
+    }
+
+    // Reverses the order of the vertices of contour i.
+    void reverse(size_t i);
+};
+
+// Metadata is only copied when requested, since most routines that pack contours only need the vertices.
+packed_contours Pack_Contours(const std::list<contour_of_points<double>> &contours,
+                              bool include_metadata = true,
+                              std::pmr::memory_resource *mr = std::pmr::get_default_resource());
+
+packed_contours Pack_Contours(const std::list<std::reference_wrapper<contour_of_points<double>>> &contours,
+                              bool include_metadata = true,
+                              std::pmr::memory_resource *mr = std::pmr::get_default_resource());
+
+std::list<contour_of_points<double>> Unpack_Contours(const packed_contours &pc);
+
+// Appends the contours to the collection.
+void Unpack_Contours(const packed_contours &pc, contour_collection<double> &out);
+
+
+// Geometric kernels for a single contour i. The loops are free of branches and indirection, so compilers can
+// vectorize them. Contours are assumed to be planar, and are treated as closed unless noted otherwise.
+
+// The area enclosed by the contour, projected along the (unit) normal. It is positive when the contour is oriented
+// counter-clockwise when viewed from the tip of the normal.
+double Contour_Signed_Area(const packed_contours &pc, size_t i, const vec3<double> &N);
+
+// The centre of mass of the enclosed area. The vertex average is used for contours that enclose no area.
+vec3<double> Contour_Centroid(const packed_contours &pc, size_t i, const vec3<double> &N);
+
+// The total length of the contour's edges, including the closing edge only if the contour is closed.
+double Contour_Perimeter(const packed_contours &pc, size_t i);
+
+// Expresses the vertices in the in-plane coordinates (R - origin).Dot(U) and (R - origin).Dot(V), discarding the
+// out-of-plane component. The outputs are resized to hold one element per vertex.
+void Project_Contour(const packed_contours &pc, size_t i,
+                     const vec3<double> &origin, const vec3<double> &U, const vec3<double> &V,
+                     std::vector<double> &us, std::vector<double> &vs);
+
+// Tests whether the point is enclosed by the projected polygon (see Project_Contour) using the crossing rule, i.e.,
+// the point is interior when a ray cast along +u crosses an odd number of edges. Points on the boundary may be
+// classified either way.
+bool Point_In_Projected_Contour(const std::vector<double> &us, const std::vector<double> &vs, double u, double v);
@@ -0,0 +1,524 @@
+//Paged_Images.cc.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "YgorFilesDirs.h"
+#include "YgorImages.h"
+#include "YgorMisc.h"
+
+#include "Thread_Pool.h"
+#include "Paged_Images.h"
+
+
+// The scratch file. The file is removed as soon as possible so it does not outlive the process.
+struct paged_image_store::backing_t {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = -1;
+    float *map = nullptr;
+    size_t bytes = 0;
+
+    backing_t(const std::string &prefix, size_t count) : bytes(count * sizeof(float)) {
+        const auto path = Get_Unique_Filename(prefix, 6, ".pages");
+        this->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if(this->fd < 0){
+            throw std::runtime_error("Unable to create scratch file '" + path + "'");
+        }
+        ::unlink(path.c_str());
+        if(this->bytes == 0) return;
+
+    #if defined(__linux__)
+        // Reserve the space up-front so a full disk is reported here rather than as a fault while paging.
+        const bool sized = (::posix_fallocate(this->fd, 0, static_cast<off_t>(this->bytes)) == 0);
+    #else
+        const bool sized = (::ftruncate(this->fd, static_cast<off_t>(this->bytes)) == 0);
+    #endif
+        void *p = sized ? ::mmap(nullptr, this->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0)
+                        : MAP_FAILED;
+        if(p == MAP_FAILED){
+            ::close(this->fd);
+            throw std::runtime_error("Unable to map scratch file '" + path + "'");
+        }
+        this->map = static_cast<float *>(p);
+    }
+
+    ~backing_t(){
+        if(this->map != nullptr) ::munmap(this->map, this->bytes);
+        if(0 <= this->fd) ::close(this->fd);
+    }
+
+    void read(size_t offset, float *dst, size_t count){
+        std::memcpy(dst, this->map + offset, count * sizeof(float));
+    }
+
+    void write(size_t offset, const float *src, size_t count){
+        std::memcpy(this->map + offset, src, count * sizeof(float));
+    }
+
+#else
+    std::string path;
+    std::mutex io_m;
+    std::fstream fs;
+
+    backing_t(const std::string &prefix, size_t /*count*/) : path(Get_Unique_Filename(prefix, 6, ".pages")) {
+        this->fs.open(this->path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!this->fs){
+            throw std::runtime_error("Unable to create scratch file '" + this->path + "'");
+        }
+    }
+
+    ~backing_t(){
+        this->fs.close();
+        std::remove(this->path.c_str());
+    }
+
+    void read(size_t offset, float *dst, size_t count){
+        std::lock_guard<std::mutex> lock(this->io_m);
+        this->fs.seekg(static_cast<std::streamoff>(offset * sizeof(float)));
+        this->fs.read(reinterpret_cast<char *>(dst), static_cast<std::streamsize>(count * sizeof(float)));
+        if(!this->fs) throw std::runtime_error("Unable to read from scratch file '" + this->path + "'");
+    }
+
+    void write(size_t offset, const float *src, size_t count){
+        std::lock_guard<std::mutex> lock(this->io_m);
+        this->fs.seekp(static_cast<std::streamoff>(offset * sizeof(float)));
+        this->fs.write(reinterpret_cast<const char *>(src), static_cast<std::streamsize>(count * sizeof(float)));
+        if(!this->fs) throw std::runtime_error("Unable to write to scratch file '" + this->path + "'");
+    }
+#endif
+};
+
+
+paged_image_store::paged_image_store(image_list_t &images,
+                                     size_t max_resident_bytes,
+                                     const std::string &scratch_dir,
+                                     voxel_storage storage)
+  : images(images), budget(max_resident_bytes), storage(storage) {
+
+    size_t total = 0;
+    for(auto it = std::begin(images); it != std::end(images); ++it){
+        this->entries.emplace_back();
+        this->entries.back().it = it;
+        this->entries.back().offset = total;
+        this->entries.back().count = it->data.size();
+        total += it->data.size();
+        this->largest_bytes = std::max(this->largest_bytes, it->data.size() * sizeof(float));
+    }
+
+    if(this->storage != voxel_storage::float32){
+        parallel_for(0, static_cast<long int>(this->entries.size()), [&](long int i){
+            auto &e = this->entries[i];
+            auto encoded = Encode_Voxels(e.it->data.data(), e.count, this->storage);
+            e.compact = std::make_shared<const compact_voxels>(std::move(encoded));
+            std::vector<float>().swap(e.it->data);
+        }, 1);
+        for(const auto &e : this->entries) this->compact_resident_bytes += e.compact->bytes();
+        return;
+    }
+
+    const auto dir = scratch_dir.empty() ? std::filesystem::temp_directory_path()
+                                         : std::filesystem::path(scratch_dir);
+    this->backing_prefix = (dir / "dcma_paged_images_").string();
+    this->backing_count = total;
+    this->backing = std::make_unique<backing_t>(this->backing_prefix, this->backing_count);
+
+    for(auto &e : this->entries){
+        this->backing->write(e.offset, e.it->data.data(), e.count);
+        std::vector<float>().swap(e.it->data);
+    }
+}
+
+paged_image_store::paged_image_store(image_list_t &images,
+                                     std::vector<pixel_source_t> sources,
+                                     size_t max_resident_bytes,
+                                     const std::string &scratch_dir)
+  : images(images), budget(max_resident_bytes) {
+
+    if(sources.size() != images.size()){
+        throw std::invalid_argument("A pixel source is needed for every image");
+    }
+
+    size_t total = 0;
+    auto s_it = std::begin(sources);
+    for(auto it = std::begin(images); it != std::end(images); ++it, ++s_it){
+        this->entries.emplace_back();
+        auto &e = this->entries.back();
+        e.it = it;
+        e.offset = total;
+        e.source = std::move(*s_it);
+        if(e.source){
+            if(!it->data.empty()) throw std::invalid_argument("Images with a pixel source must not have pixel data");
+            e.count = static_cast<size_t>(std::max<long int>(0, it->rows * it->columns * it->channels));
+        }else{
+            e.count = it->data.size();
+            e.state = state_t::resident;
+            this->resident_bytes += e.count * sizeof(float);
+            this->lru.push_back(this->entries.size() - 1);
+            e.lru_it = std::prev(std::end(this->lru));
+            e.in_lru = true;
+        }
+        total += e.count;
+        this->largest_bytes = std::max(this->largest_bytes, e.count * sizeof(float));
+    }
+
+    const auto dir = scratch_dir.empty() ? std::filesystem::temp_directory_path()
+                                         : std::filesystem::path(scratch_dir);
+    this->backing_prefix = (dir / "dcma_paged_images_").string();
+    this->backing_count = total;
+
+    std::unique_lock<std::mutex> lock(this->m);
+    this->evict(lock);
+}
+
+paged_image_store::~paged_image_store() = default;
+
+size_t paged_image_store::size() const {
+    return this->entries.size();
+}
+
+voxel_storage paged_image_store::get_storage() const {
+    return this->storage;
+}
+
+size_t paged_image_store::compact_bytes(){
+    std::lock_guard<std::mutex> lock(this->m);
+    return this->compact_resident_bytes;
+}
+
+size_t paged_image_store::max_pinned() const {
+    if(this->largest_bytes == 0) return std::max<size_t>(1, this->entries.size());
+    return std::max<size_t>(1, this->budget / this->largest_bytes);
+}
+
+void paged_image_store::acquire(size_t i){
+    std::unique_lock<std::mutex> lock(this->m);
+    auto &e = this->entries.at(i);
+    while(true){
+        if(e.state == state_t::resident){
+            if(e.in_lru){
+                this->lru.erase(e.lru_it);
+                e.in_lru = false;
+            }
+            ++e.pins;
+            return;
+        }
+        if(e.state == state_t::paged_out) break;
+        this->cv.wait(lock);
+    }
+
+    // Claim the image and make room for it before reading it in.
+    e.state = state_t::loading;
+    ++e.pins;
+    this->resident_bytes += e.count * sizeof(float);
+    this->evict(lock);
+    lock.unlock();
+
+    try{
+        if(e.source){
+            e.source(*(e.it));
+            if(e.it->data.size() != e.count){
+                throw std::runtime_error("Pixel source provided the wrong number of pixels");
+            }
+        }else if(this->storage != voxel_storage::float32){
+            std::vector<float> data;
+            e.compact->decode(data);
+            e.it->data.swap(data);
+        }else{
+            std::vector<float> data(e.count);
+            this->backing->read(e.offset, data.data(), e.count);
+            e.it->data.swap(data);
+        }
+    }catch(const std::exception &){
+        std::vector<float>().swap(e.it->data);
+        lock.lock();
+        e.state = state_t::paged_out;
+        --e.pins;
+        this->resident_bytes -= e.count * sizeof(float);
+        this->cv.notify_all();
+        throw;
+    }
+
+    // The source and encoded pixels are no longer needed, but they are destroyed outside the lock since they may hold
+    // considerable resources.
+    pixel_source_t used;
+    std::shared_ptr<const compact_voxels> decoded;
+    lock.lock();
+    used.swap(e.source);
+    decoded.swap(e.compact);
+    if(decoded != nullptr) this->compact_resident_bytes -= decoded->bytes();
+    e.state = state_t::resident;
+    this->cv.notify_all();
+    lock.unlock();
+    return;
+}
+
+void paged_image_store::release(size_t i){
+    std::unique_lock<std::mutex> lock(this->m);
+    auto &e = this->entries.at(i);
+    --e.pins;
+    if(e.pins == 0){
+        this->lru.push_back(i);
+        e.lru_it = std::prev(std::end(this->lru));
+        e.in_lru = true;
+    }
+    this->evict(lock);
+    return;
+}
+
+void paged_image_store::evict(std::unique_lock<std::mutex> &lock){
+    while( (this->budget < this->resident_bytes) && !this->lru.empty() ){
+        if( (this->storage == voxel_storage::float32) && (this->backing == nullptr) ){
+            try{
+                this->backing = std::make_unique<backing_t>(this->backing_prefix, this->backing_count);
+            }catch(const std::exception &e){
+                FUNCWARN("Unable to create scratch file: '" << e.what() << "'. Keeping images resident");
+                break;
+            }
+        }
+
+        const auto j = this->lru.front();
+        this->lru.pop_front();
+        auto &v = this->entries[j];
+        v.in_lru = false;
+        v.state = state_t::writing;
+
+        std::vector<float> data;
+        data.swap(v.it->data);
+        lock.unlock();
+        bool written = true;
+        std::shared_ptr<const compact_voxels> encoded;
+        try{
+            if(this->storage == voxel_storage::float32){
+                this->backing->write(v.offset, data.data(), v.count);
+            }else{
+                encoded = std::make_shared<const compact_voxels>(Encode_Voxels(data.data(), v.count, this->storage));
+            }
+        }catch(const std::exception &e){
+            FUNCWARN("Unable to page out image: '" << e.what() << "'. Keeping it resident");
+            v.it->data.swap(data);
+            written = false;
+        }
+        lock.lock();
+
+        if(written){
+            v.state = state_t::paged_out;
+            this->resident_bytes -= v.count * sizeof(float);
+            if(encoded != nullptr) this->compact_resident_bytes += encoded->bytes();
+            v.compact = std::move(encoded);
+        }else{
+            v.state = state_t::resident;
+        }
+        this->cv.notify_all();
+        if(!written) break;
+    }
+    return;
+}
+
+void paged_image_store::copy_pixels(size_t i, planar_image<float,double> &dest){
+    pin p(*this, i);
+    dest.data = p.image()->data;
+    return;
+}
+
+void paged_image_store::accumulate_pixels(size_t i, float weight, planar_image<float,double> &dest){
+    // Compact data is immutable, so it can be read outside the lock even if the image is concurrently paged in.
+    std::shared_ptr<const compact_voxels> compact;
+    {
+        std::lock_guard<std::mutex> lock(this->m);
+        const auto &e = this->entries.at(i);
+        if(e.state == state_t::paged_out) compact = e.compact;
+    }
+    if(compact != nullptr){
+        if(dest.data.size() != compact->count){
+            throw std::invalid_argument("Images have different dimensions");
+        }
+        compact->accumulate(weight, dest.data.data());
+        return;
+    }
+
+    pin p(*this, i);
+    const auto &src = p.image()->data;
+    if(dest.data.size() != src.size()){
+        throw std::invalid_argument("Images have different dimensions");
+    }
+    for(size_t k = 0; k < src.size(); ++k) dest.data[k] += weight * src[k];
+    return;
+}
+
+void paged_image_store::retain(const std::function<bool(const planar_image<float,double> &)> &pred){
+    std::unique_lock<std::mutex> lock(this->m);
+    for(const auto &e : this->entries){
+        if(0 < e.pins) throw std::logic_error("Images cannot be removed while pinned");
+    }
+    // Wait for any eviction in progress to complete.
+    this->cv.wait(lock, [&](){
+        return std::none_of(std::begin(this->entries), std::end(this->entries),
+                            [](const entry_t &e){ return (e.state == state_t::writing); });
+    });
+
+    const auto N = this->entries.size();
+    std::vector<entry_t> kept;
+    std::vector<size_t> renumbered(N, N);
+    for(size_t i = 0; i < N; ++i){
+        auto &e = this->entries[i];
+        if(pred(*(e.it))){
+            renumbered[i] = kept.size();
+            kept.emplace_back(std::move(e));
+            continue;
+        }
+        if(e.in_lru) this->lru.erase(e.lru_it);
+        if(e.state == state_t::resident) this->resident_bytes -= e.count * sizeof(float);
+        if(e.compact != nullptr) this->compact_resident_bytes -= e.compact->bytes();
+        this->images.erase(e.it);
+    }
+    for(auto &j : this->lru) j = renumbered[j];
+    this->entries = std::move(kept);
+
+    this->largest_bytes = 0;
+    for(const auto &e : this->entries){
+        this->largest_bytes = std::max(this->largest_bytes, e.count * sizeof(float));
+    }
+    return;
+}
+
+void paged_image_store::restore(){
+    {
+        std::lock_guard<std::mutex> lock(this->m);
+        this->budget = std::numeric_limits<size_t>::max();
+    }
+    // Images with a source may be expensive to load, so they are loaded concurrently.
+    parallel_for(0, static_cast<long int>(this->entries.size()), [&](long int i){
+        this->acquire(static_cast<size_t>(i));
+    }, 1);
+
+    std::lock_guard<std::mutex> lock(this->m);
+    this->entries.clear();
+    this->lru.clear();
+    this->resident_bytes = 0;
+    this->compact_resident_bytes = 0;
+    this->largest_bytes = 0;
+    return;
+}
+
+
+paged_image_store::pin::pin(paged_image_store &store, size_t i) : store(store), i(i) {
+    this->store.acquire(this->i);
+}
+
+paged_image_store::pin::~pin(){
+    this->store.release(this->i);
+}
+
+paged_image_store::image_list_t::iterator paged_image_store::pin::image() const {
+    return this->store.entries[this->i].it;
+}
+
+
+void Stream_Images(paged_image_store &store,
+                   const std::function<void(paged_image_store::image_list_t::iterator)> &f){
+    const auto N = store.size();
+    const auto concurrency = static_cast<size_t>(std::max<long int>(1, work_stealing_pool::get().concurrency()));
+    const auto workers = std::min({ store.max_pinned(), concurrency, std::max<size_t>(1, N) });
+
+    // Up to one image per worker is paged in ahead of the workers by a dedicated thread, so reading or decoding the
+    // next images (e.g., deferred pixel sources) overlaps with processing the current ones. Read-ahead is limited by
+    // the budget. Workers never wait for the read-ahead thread to reach an image; they page in unclaimed images
+    // themselves.
+    const auto lookahead = std::min(store.max_pinned() - workers, workers);
+
+    std::mutex m;
+    std::condition_variable cv;
+    size_t next = 0; // The next image to be claimed by a worker.
+    bool failed = false;
+    std::vector<char> prefetching(N, 0);
+    std::vector<std::unique_ptr<paged_image_store::pin>> prefetched(N);
+
+    std::thread reader;
+    if( (0 < lookahead) && (workers < N) ){
+        reader = std::thread([&]() -> void {
+            for(size_t i = 0; i < N; ++i){
+                {
+                    std::unique_lock<std::mutex> lock(m);
+                    cv.wait(lock, [&](){ return failed || (i < next + lookahead); });
+                    if(failed) return;
+                    if(i < next) continue; // Already claimed by a worker.
+                    prefetching[i] = 1;
+                }
+
+                std::unique_ptr<paged_image_store::pin> p;
+                try{
+                    p = std::make_unique<paged_image_store::pin>(store, i);
+                }catch(const std::exception &){} // The worker will retry, and report the error.
+
+                std::lock_guard<std::mutex> lock(m);
+                prefetched[i] = std::move(p);
+                prefetching[i] = 0;
+                cv.notify_all();
+            }
+        });
+    }
+    const auto stop_reader = [&]() -> void {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            failed = true;
+        }
+        cv.notify_all();
+        if(reader.joinable()) reader.join();
+    };
+
+    // Each worker claims the next image, so images are visited roughly in order and at most 'workers' are pinned
+    // (along with those paged in ahead of time).
+    try{
+        parallel_for(0, static_cast<long int>(workers), [&](long int){
+            while(true){
+                std::unique_ptr<paged_image_store::pin> p;
+                size_t i = 0;
+                {
+                    std::unique_lock<std::mutex> lock(m);
+                    if(failed || (N <= next)) break;
+                    i = next++;
+                    cv.notify_all();
+                    cv.wait(lock, [&](){ return (prefetching[i] == 0); });
+                    p = std::move(prefetched[i]);
+                }
+                try{
+                    if(p == nullptr) p = std::make_unique<paged_image_store::pin>(store, i);
+                    f(p->image());
+                }catch(const std::exception &){
+                    std::lock_guard<std::mutex> lock(m);
+                    failed = true;
+                    cv.notify_all();
+                    throw;
+                }
+            }
+        }, 1);
+    }catch(const std::exception &){
+        stop_reader();
+        throw;
+    }
+    stop_reader();
+    return;
+}
+
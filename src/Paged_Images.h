@@ -0,0 +1,150 @@
+//Paged_Images.h.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "YgorImages.h"
+
+#include "Compact_Voxels.h"
+
+
+// An out-of-core backing store for the pixel data of a list of images.
+//
+// On construction the pixel data of every image is moved into a scratch file and released, leaving only the geometry
+// and metadata resident. Images are paged back in on demand (by pinning them) and unpinned images are evicted in
+// least-recently-used order whenever the resident pixel data exceeds the budget. Pinned images are never evicted, so
+// the budget is exceeded if more than max_pinned() images are pinned at once. On POSIX systems the scratch file is
+// memory-mapped, so paging is a copy and the operating system decides when the data actually reaches the disk.
+//
+// Instead of a scratch file, paged-out pixel data can be held compactly in memory (see Compact_Voxels.h), either with
+// reduced precision, which halves the memory and bandwidth consumed by large arrays, or sparsely, which elides regions
+// of zeros. Images are decoded when pinned and re-encoded when evicted, so the usual pinning rules provide transparent
+// float access.
+//
+// Alternatively, the pixel data of some images can be supplied by a source that is invoked when the image is first
+// pinned, e.g., to defer decoding until the pixels are actually needed. These images are not written to the scratch
+// file unless they are later evicted.
+//
+// The list must outlive the store, and images must not be added, removed, or resized while the store is attached
+// (except through retain()). Pixel data must only be accessed while an image is pinned. Destroying the store discards
+// the pixel data of images that are not resident; use restore() to keep it.
+class paged_image_store {
+  public:
+    using image_list_t = std::list<planar_image<float,double>>;
+
+    // Fills the (empty) pixel buffer of an image whose rows, columns, and channels are already set. Sources are invoked
+    // at most once, possibly concurrently for different images, and are released afterward.
+    using pixel_source_t = std::function<void(planar_image<float,double> &)>;
+
+    paged_image_store(image_list_t &images,
+                      size_t max_resident_bytes,
+                      const std::string &scratch_dir = "",
+                      voxel_storage storage = voxel_storage::float32);
+
+    // Images with a source must have an empty pixel buffer. Images without one (an empty function) remain resident
+    // until the budget requires them to be paged out. There must be one source per image, in list order.
+    paged_image_store(image_list_t &images,
+                      std::vector<pixel_source_t> sources,
+                      size_t max_resident_bytes,
+                      const std::string &scratch_dir = "");
+    ~paged_image_store();
+
+    paged_image_store(const paged_image_store &) = delete;
+    paged_image_store & operator=(const paged_image_store &) = delete;
+
+    // Keeps an image's pixel data resident while in scope. Thread-safe.
+    class pin {
+      public:
+        pin(paged_image_store &store, size_t i);
+        ~pin();
+
+        pin(const pin &) = delete;
+        pin & operator=(const pin &) = delete;
+
+        image_list_t::iterator image() const;
+
+      private:
+        paged_image_store &store;
+        size_t i;
+    };
+
+    // The number of images, in list order.
+    size_t size() const;
+
+    // The largest number of images that can be pinned at once without exceeding the budget (at least one).
+    size_t max_pinned() const;
+
+    // How paged-out pixel data is held. Only float32 storage uses a scratch file.
+    voxel_storage get_storage() const;
+
+    // The memory consumed by pixel data held in reduced precision.
+    size_t compact_bytes();
+
+    // Copies the pixel data of the i-th image into an image with the same dimensions.
+    void copy_pixels(size_t i, planar_image<float,double> &dest);
+
+    // Adds the weighted pixel data of the i-th image to an image with the same dimensions. Compactly-stored images
+    // are accumulated without being paged in, so only the stored blocks of sparse images are visited. Thread-safe.
+    void accumulate_pixels(size_t i, float weight, planar_image<float,double> &dest);
+
+    // Removes the images that do not satisfy the predicate from the list without loading their pixel data. The
+    // predicate must not access pixel data. No images may be pinned.
+    void retain(const std::function<bool(const planar_image<float,double> &)> &pred);
+
+    // Pages every image back in and detaches the store from the list. Afterward the store is empty.
+    void restore();
+
+  private:
+    enum class state_t { paged_out, loading, resident, writing };
+
+    struct entry_t {
+        image_list_t::iterator it;
+        size_t offset = 0;  // In floats.
+        size_t count = 0;   // In floats.
+        long int pins = 0;
+        state_t state = state_t::paged_out;
+        bool in_lru = false;
+        std::list<size_t>::iterator lru_it;
+        pixel_source_t source; // Only until first loaded.
+        std::shared_ptr<const compact_voxels> compact; // Only while paged out, and only with compact storage.
+    };
+
+    struct backing_t;
+
+    image_list_t &images;
+    std::vector<entry_t> entries;
+    std::list<size_t> lru; // Unpinned, resident images. Least-recently used first.
+    size_t budget;
+    voxel_storage storage = voxel_storage::float32;
+    size_t resident_bytes = 0;
+    size_t compact_resident_bytes = 0;
+    size_t largest_bytes = 0;
+    size_t backing_count = 0; // In floats.
+    std::string backing_prefix;
+    std::unique_ptr<backing_t> backing; // Created when first needed.
+
+    std::mutex m;
+    std::condition_variable cv;
+
+    void acquire(size_t i);
+    void release(size_t i);
+
+    // Evicts unpinned images until the budget is honoured. The lock is released while writing.
+    void evict(std::unique_lock<std::mutex> &lock);
+};
+
+// Applies the function to every image in list order, pinning each while it is processed. As many images are
+// processed concurrently as the budget allows. When the budget permits, upcoming images are paged in (or their sources
+// invoked) by a separate thread while earlier images are processed, so I/O and decoding overlap with processing.
+// Processing stops at the first exception, which is rethrown.
+void Stream_Images(paged_image_store &store,
+                   const std::function<void(paged_image_store::image_list_t::iterator)> &f);
+
@@ -0,0 +1,179 @@
+//Parallel_RANSAC.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Parallel_RANSAC.h"
+
+
+namespace {
+
+constexpr int64_t key_bits = 21;
+constexpr int64_t max_cells_per_axis = (int64_t(1) << key_bits);
+
+uint64_t splitmix64(uint64_t x){
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+
+ransac_cell_index::ransac_cell_index(const std::vector<vec3<double>> &points, double cell_width)
+  : width(cell_width) {
+
+    if(!std::isfinite(this->width) || (this->width <= 0.0)){
+        throw std::invalid_argument("Cell width must be positive and finite");
+    }
+    const auto N = points.size();
+    if(N == 0) return;
+
+    const auto inf = std::numeric_limits<double>::infinity();
+    vec3<double> lo(inf, inf, inf);
+    vec3<double> hi(-inf, -inf, -inf);
+    for(const auto &p : points){
+        if(!p.isfinite()) throw std::invalid_argument("Points must be finite");
+        lo = vec3<double>( std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) );
+        hi = vec3<double>( std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) );
+    }
+    this->origin = lo;
+    const auto extent = std::max({ hi.x - lo.x, hi.y - lo.y, hi.z - lo.z });
+    this->width = std::max(this->width, extent / static_cast<double>(max_cells_per_axis - 2));
+
+    std::vector<uint64_t> keys(N);
+    for(size_t i = 0; i < N; ++i){
+        const auto R = (points[i] - this->origin) / this->width;
+        keys[i] = this->key( static_cast<int64_t>(R.x), static_cast<int64_t>(R.y), static_cast<int64_t>(R.z) );
+    }
+
+    // Stable, so points within a cell retain their original order.
+    this->orig.resize(N);
+    std::iota(std::begin(this->orig), std::end(this->orig), static_cast<size_t>(0));
+    std::stable_sort(std::begin(this->orig), std::end(this->orig),
+                     [&](size_t l, size_t r){ return keys[l] < keys[r]; });
+
+    this->sorted.x.resize(N);
+    this->sorted.y.resize(N);
+    this->sorted.z.resize(N);
+    for(size_t i = 0; i < N; ++i){
+        const auto &p = points[this->orig[i]];
+        this->sorted.x[i] = p.x;
+        this->sorted.y[i] = p.y;
+        this->sorted.z[i] = p.z;
+
+        const auto k = keys[this->orig[i]];
+        if((i == 0) || (keys[this->orig[i-1]] != k)){
+            const auto mask = static_cast<uint64_t>(max_cells_per_axis - 1);
+            const auto ci = static_cast<double>((k >> (2 * key_bits)) & mask);
+            const auto cj = static_cast<double>((k >> key_bits) & mask);
+            const auto ck = static_cast<double>(k & mask);
+
+            cell_t c;
+            c.centre = this->origin + vec3<double>(ci + 0.5, cj + 0.5, ck + 0.5) * this->width;
+            c.begin = i;
+            this->lookup[k] = this->cell_list.size();
+            this->cell_list.push_back(c);
+        }
+        this->cell_list.back().end = i + 1;
+    }
+}
+
+uint64_t ransac_cell_index::key(int64_t i, int64_t j, int64_t k) const {
+    return (static_cast<uint64_t>(i) << (2 * key_bits))
+         | (static_cast<uint64_t>(j) << key_bits)
+         |  static_cast<uint64_t>(k);
+}
+
+size_t ransac_cell_index::size() const {
+    return this->orig.size();
+}
+
+const ransac_points & ransac_cell_index::points() const {
+    return this->sorted;
+}
+
+const std::vector<size_t> & ransac_cell_index::original_index() const {
+    return this->orig;
+}
+
+const std::vector<ransac_cell_index::cell_t> & ransac_cell_index::cells() const {
+    return this->cell_list;
+}
+
+double ransac_cell_index::cell_radius() const {
+    return 0.5 * std::sqrt(3.0) * this->width;
+}
+
+std::vector<size_t> ransac_cell_index::within(const vec3<double> &p, double r) const {
+    std::vector<size_t> out;
+    if(this->orig.empty() || !p.isfinite() || !(0.0 <= r)) return out;
+
+    // Clamp the range of cells to those that can be occupied.
+    const auto lo = (p - this->origin - vec3<double>(r, r, r)) / this->width;
+    const auto hi = (p - this->origin + vec3<double>(r, r, r)) / this->width;
+    const auto clamp = [](double v) -> int64_t {
+        return static_cast<int64_t>( std::clamp(std::floor(v), 0.0, static_cast<double>(max_cells_per_axis - 1)) );
+    };
+    if((hi.x < 0.0) || (hi.y < 0.0) || (hi.z < 0.0)) return out;
+
+    const auto r_sq = r * r;
+    for(int64_t i = clamp(lo.x); i <= clamp(hi.x); ++i){
+        for(int64_t j = clamp(lo.y); j <= clamp(hi.y); ++j){
+            for(int64_t k = clamp(lo.z); k <= clamp(hi.z); ++k){
+                const auto it = this->lookup.find(this->key(i, j, k));
+                if(it == std::end(this->lookup)) continue;
+                const auto &c = this->cell_list[it->second];
+                for(size_t n = c.begin; n < c.end; ++n){
+                    const auto dx = this->sorted.x[n] - p.x;
+                    const auto dy = this->sorted.y[n] - p.y;
+                    const auto dz = this->sorted.z[n] - p.z;
+                    if((dx * dx + dy * dy + dz * dz) <= r_sq) out.push_back(this->orig[n]);
+                }
+            }
+        }
+    }
+    std::sort(std::begin(out), std::end(out));
+    return out;
+}
+
+
+long int RANSAC_Required_Hypotheses(double inlier_fraction, size_t sample_size, double confidence){
+    const auto most = std::numeric_limits<long int>::max();
+    if(!(0.0 < inlier_fraction)) return most;
+    if(1.0 <= inlier_fraction) return 1;
+    confidence = std::clamp(confidence, 0.0, 1.0 - 1.0E-12);
+
+    const auto p_good = std::pow(inlier_fraction, static_cast<double>(sample_size));
+    const auto denom = std::log1p(-p_good);
+    if(!(denom < 0.0)) return most;
+    const auto n = std::ceil( std::log1p(-confidence) / denom );
+    if(!(n < static_cast<double>(most))) return most;
+    return std::max(1L, static_cast<long int>(n));
+}
+
+std::vector<size_t> RANSAC_Sample(uint64_t seed, long int hypothesis, size_t n, size_t N){
+    if(N < n) throw std::invalid_argument("Insufficient points to sample");
+
+    std::mt19937_64 re( splitmix64(seed ^ splitmix64(static_cast<uint64_t>(hypothesis))) );
+    std::uniform_int_distribution<size_t> rd(0, N - 1);
+    std::vector<size_t> out;
+    out.reserve(n);
+    while(out.size() < n){
+        const auto i = rd(re);
+        if(std::find(std::begin(out), std::end(out), i) == std::end(out)) out.push_back(i);
+    }
+    return out;
+}
+
@@ -0,0 +1,210 @@
+//Parallel_RANSAC.h.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Thread_Pool.h"
+
+
+// Point coordinates stored as separate, contiguous arrays so that scoring loops stream through memory.
+struct ransac_points {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+
+    size_t size() const { return this->x.size(); }
+    vec3<double> point(size_t i) const { return vec3<double>(this->x[i], this->y[i], this->z[i]); }
+};
+
+
+// A uniform grid of cubic cells over a point set.
+//
+// Points are stored sorted by cell, so each occupied cell is a contiguous range of the buffer. Cells far from a model
+// can be rejected as a whole when counting inliers, and fixed-radius neighbourhoods can be gathered without scanning
+// the whole set. Queries are const and may be issued concurrently.
+class ransac_cell_index {
+  public:
+    struct cell_t {
+        vec3<double> centre;
+        size_t begin = 0; // Range within the sorted points.
+        size_t end = 0;
+    };
+
+    // The cell width should be comparable to the inlier distance or neighbourhood radius. It is enlarged if the points
+    // would otherwise span more than about two million cells along any axis.
+    ransac_cell_index(const std::vector<vec3<double>> &points, double cell_width);
+
+    size_t size() const;
+
+    // The points, sorted by cell, and the index of each in the original set.
+    const ransac_points & points() const;
+    const std::vector<size_t> & original_index() const;
+
+    const std::vector<cell_t> & cells() const;
+
+    // Half of the cell diagonal; every point in a cell is within this distance of the cell centre.
+    double cell_radius() const;
+
+    // Returns the original indices of all points within distance r of p (inclusive), in increasing order.
+    std::vector<size_t> within(const vec3<double> &p, double r) const;
+
+  private:
+    double width;
+    vec3<double> origin;
+    ransac_points sorted;
+    std::vector<size_t> orig;
+    std::vector<cell_t> cell_list;
+    std::unordered_map<uint64_t, size_t> lookup; // Cell key to position in cell_list.
+
+    uint64_t key(int64_t i, int64_t j, int64_t k) const;
+};
+
+
+struct ransac_parameters {
+    size_t sample_size = 3;        // Points needed to fit a hypothesis.
+    double inlier_distance = 1.0;  // Points within this distance of a model are inliers (inclusive).
+    double confidence = 0.99;      // Desired probability that at least one all-inlier sample was drawn.
+    long int min_hypotheses = 0;
+    long int max_hypotheses = 10'000;
+    long int batch_size = 0;       // Hypotheses scored together. Zero selects a multiple of the thread count.
+    uint64_t seed = 0;
+};
+
+template <class Model>
+struct ransac_result {
+    Model model;
+    size_t inliers = 0;
+    long int hypotheses = 0; // The number of hypotheses generated before stopping.
+};
+
+// The number of hypotheses needed to draw an all-inlier sample with the given confidence.
+long int RANSAC_Required_Hypotheses(double inlier_fraction, size_t sample_size, double confidence);
+
+// Draws 'n' distinct indices in [0, N) from a generator seeded for the given hypothesis only, so samples do not depend
+// on the order in which hypotheses are generated.
+std::vector<size_t> RANSAC_Sample(uint64_t seed, long int hypothesis, size_t n, size_t N);
+
+
+// Counts the points within params.inlier_distance of a model.
+//
+// 'distance(model, x, y, z)' must be the Euclidean distance to the model (or any other function that is 1-Lipschitz),
+// so that a cell whose centre is farther than the inlier distance plus the cell radius can be skipped entirely.
+template <class Model, class Distance>
+size_t
+RANSAC_Count_Inliers(const ransac_cell_index &index,
+                     const Model &model,
+                     double inlier_distance,
+                     const Distance &distance){
+    const auto &pts = index.points();
+    const auto cull = inlier_distance + index.cell_radius();
+    size_t count = 0;
+    for(const auto &c : index.cells()){
+        if(cull < distance(model, c.centre.x, c.centre.y, c.centre.z)) continue;
+        for(size_t i = c.begin; i < c.end; ++i){
+            if(distance(model, pts.x[i], pts.y[i], pts.z[i]) <= inlier_distance) ++count;
+        }
+    }
+    return count;
+}
+
+// Returns the original indices of the inliers of a model, in increasing order.
+template <class Model, class Distance>
+std::vector<size_t>
+RANSAC_Inliers(const ransac_cell_index &index,
+               const Model &model,
+               double inlier_distance,
+               const Distance &distance){
+    const auto &pts = index.points();
+    const auto &orig = index.original_index();
+    const auto cull = inlier_distance + index.cell_radius();
+    std::vector<size_t> out;
+    for(const auto &c : index.cells()){
+        if(cull < distance(model, c.centre.x, c.centre.y, c.centre.z)) continue;
+        for(size_t i = c.begin; i < c.end; ++i){
+            if(distance(model, pts.x[i], pts.y[i], pts.z[i]) <= inlier_distance) out.push_back(orig[i]);
+        }
+    }
+    std::sort(std::begin(out), std::end(out));
+    return out;
+}
+
+
+// Finds the model with the most inliers using batches of hypotheses that are generated and scored concurrently.
+//
+// 'fit(sample)' receives params.sample_size distinct points drawn from the index and returns a model, or nothing if
+// the sample is degenerate. It is invoked concurrently and must be thread-safe. See RANSAC_Count_Inliers() for the
+// requirements on 'distance'.
+//
+// After each batch, the number of hypotheses needed is re-estimated from the best inlier fraction found so far and
+// the search stops once enough have been generated. Every hypothesis is sampled from its own seed and ties are broken
+// in favour of the earliest hypothesis, so the result does not depend on the number of threads. Returns nothing if
+// there are too few points or every sample was degenerate.
+template <class Model, class Fit, class Distance>
+std::optional<ransac_result<Model>>
+Parallel_RANSAC(const ransac_cell_index &index,
+                const ransac_parameters &params,
+                const Fit &fit,
+                const Distance &distance){
+    const auto N = index.size();
+    if((params.sample_size == 0) || (N < params.sample_size)) return {};
+
+    long int batch = params.batch_size;
+    if(batch <= 0) batch = 4 * std::max<long int>(1, work_stealing_pool::get().concurrency());
+
+    struct scored_t {
+        std::optional<Model> model;
+        size_t inliers = 0;
+    };
+    std::vector<scored_t> scored(static_cast<size_t>(batch));
+
+    std::optional<ransac_result<Model>> best;
+    long int required = params.max_hypotheses;
+    long int generated = 0;
+    while( (generated < std::max(params.min_hypotheses, required))
+       &&  (generated < params.max_hypotheses) ){
+        const auto n = std::min<long int>(batch, params.max_hypotheses - generated);
+        parallel_for(0, n, [&](long int j){
+            auto &s = scored[j];
+            s.model.reset();
+            s.inliers = 0;
+
+            std::vector<vec3<double>> sample;
+            sample.reserve(params.sample_size);
+            for(const auto i : RANSAC_Sample(params.seed, generated + j, params.sample_size, N)){
+                sample.push_back(index.points().point(i));
+            }
+            s.model = fit(sample);
+            if(s.model){
+                s.inliers = RANSAC_Count_Inliers(index, *(s.model), params.inlier_distance, distance);
+            }
+        }, 1);
+
+        for(long int j = 0; j < n; ++j){
+            auto &s = scored[j];
+            if(s.model && (!best || (best->inliers < s.inliers))){
+                best = ransac_result<Model>{ std::move(*(s.model)), s.inliers, 0 };
+            }
+        }
+        generated += n;
+
+        if(best){
+            const auto w = static_cast<double>(best->inliers) / static_cast<double>(N);
+            required = RANSAC_Required_Hypotheses(w, params.sample_size, params.confidence);
+        }
+    }
+
+    if(best) best->hypotheses = generated;
+    return best;
+}
+
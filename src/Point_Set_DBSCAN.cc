@@ -0,0 +1,307 @@
+//Point_Set_DBSCAN.cc.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Thread_Pool.h"
+#include "Point_Set_DBSCAN.h"
+
+
+namespace {
+
+// Cell coordinates are packed into a single key, 21 bits per axis.
+constexpr int64_t cell_bits = 21;
+constexpr int64_t max_cell_coord = (static_cast<int64_t>(1) << cell_bits) - 1;
+
+// Points within Eps of one another can be at most two cells apart along each axis.
+constexpr int64_t stencil_radius = 2;
+
+uint64_t pack_key(int64_t i, int64_t j, int64_t k){
+    return (static_cast<uint64_t>(i) << (2 * cell_bits))
+         | (static_cast<uint64_t>(j) << cell_bits)
+         |  static_cast<uint64_t>(k);
+}
+
+struct sorted_point_t {
+    double x[3];
+    uint32_t index; // In the original set.
+    uint8_t core;
+};
+
+struct cell_t {
+    uint64_t key;
+    int64_t ijk[3];
+    uint32_t begin; // Into the sorted points.
+    uint32_t end;
+};
+
+double sq_dist(const sorted_point_t &A, const sorted_point_t &B){
+    const auto dx = A.x[0] - B.x[0];
+    const auto dy = A.x[1] - B.x[1];
+    const auto dz = A.x[2] - B.x[2];
+    return dx*dx + dy*dy + dz*dz;
+}
+
+// Concurrent union-find over the original point indices. Roots are always linked to the lower-indexed root, so the
+// root of each set is its lowest index and parents never increase, which makes path halving safe without locks.
+class concurrent_disjoint_sets {
+    std::vector<std::atomic<uint32_t>> parent;
+
+  public:
+    explicit concurrent_disjoint_sets(size_t N) : parent(N) {
+        parallel_for(0, static_cast<long int>(N), [&](long int i) -> void {
+            this->parent[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+        });
+    }
+
+    uint32_t find(uint32_t x){
+        while(true){
+            auto p = this->parent[x].load(std::memory_order_acquire);
+            if(p == x) return x;
+            const auto gp = this->parent[p].load(std::memory_order_acquire);
+            if(p != gp) this->parent[x].compare_exchange_weak(p, gp, std::memory_order_acq_rel);
+            x = gp;
+        }
+    }
+
+    void unite(uint32_t a, uint32_t b){
+        while(true){
+            a = this->find(a);
+            b = this->find(b);
+            if(a == b) return;
+            if(a < b) std::swap(a, b);
+            auto expected = a;
+            if(this->parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return;
+        }
+    }
+};
+
+} // namespace
+
+
+std::vector<int64_t> Point_Set_DBSCAN(const std::vector<vec3<double>> &points,
+                                      const dbscan_options &opts){
+    if( !std::isfinite(opts.eps) || !(0.0 < opts.eps) ){
+        throw std::invalid_argument("DBSCAN Eps must be positive and finite");
+    }
+    if(opts.min_points < 1){
+        throw std::invalid_argument("DBSCAN MinPoints must be positive");
+    }
+    if(static_cast<size_t>(std::numeric_limits<uint32_t>::max()) <= points.size()){
+        throw std::invalid_argument("Too many points to cluster");
+    }
+
+    const auto N = points.size();
+    std::vector<int64_t> labels(N, dbscan_noise);
+    if(N == 0) return labels;
+
+    const auto eps_sq = opts.eps * opts.eps;
+    const auto min_pts = static_cast<size_t>(opts.min_points);
+
+    // The cell diagonal is shrunk slightly so that floating-point rounding cannot place two non-neighbours in the same
+    // cell.
+    const auto cell_width = (opts.eps / std::sqrt(3.0)) * (1.0 - 1E-9);
+
+    vec3<double> lo( std::numeric_limits<double>::infinity(),
+                     std::numeric_limits<double>::infinity(),
+                     std::numeric_limits<double>::infinity() );
+    for(const auto &p : points){
+        if(!p.isfinite()){
+            throw std::invalid_argument("Unable to cluster non-finite points");
+        }
+        lo.x = std::min(lo.x, p.x);
+        lo.y = std::min(lo.y, p.y);
+        lo.z = std::min(lo.z, p.z);
+    }
+
+    // Bin the points into cells, ordered by cell and then by original index.
+    std::vector<uint64_t> keys(N);
+    parallel_for(0, static_cast<long int>(N), [&](long int n) -> void {
+        const auto &p = points[n];
+        const auto i = static_cast<int64_t>(std::floor((p.x - lo.x) / cell_width));
+        const auto j = static_cast<int64_t>(std::floor((p.y - lo.y) / cell_width));
+        const auto k = static_cast<int64_t>(std::floor((p.z - lo.z) / cell_width));
+        if( (max_cell_coord < i) || (max_cell_coord < j) || (max_cell_coord < k) ){
+            throw std::invalid_argument("Points span too many cells; consider increasing Eps");
+        }
+        keys[n] = pack_key(i, j, k);
+    });
+
+    std::vector<uint32_t> order(N);
+    std::iota(std::begin(order), std::end(order), static_cast<uint32_t>(0));
+    std::sort(std::begin(order), std::end(order), [&](uint32_t A, uint32_t B) -> bool {
+        return (keys[A] == keys[B]) ? (A < B) : (keys[A] < keys[B]);
+    });
+
+    std::vector<sorted_point_t> sp(N);
+    parallel_for(0, static_cast<long int>(N), [&](long int n) -> void {
+        const auto &p = points[order[n]];
+        sp[n] = { { p.x, p.y, p.z }, order[n], 0 };
+    });
+
+    std::vector<cell_t> cells;
+    for(uint32_t n = 0; n < N; ){
+        const auto key = keys[order[n]];
+        auto e = n + 1;
+        while( (e < N) && (keys[order[e]] == key) ) ++e;
+        cells.push_back({ key,
+                          { static_cast<int64_t>(key >> (2 * cell_bits)),
+                            static_cast<int64_t>((key >> cell_bits) & max_cell_coord),
+                            static_cast<int64_t>(key & max_cell_coord) },
+                          n, e });
+        n = e;
+    }
+    keys = std::vector<uint64_t>();
+    order = std::vector<uint32_t>();
+    const auto N_cells = static_cast<long int>(cells.size());
+
+    // Locates occupied cells within the stencil, via binary search over the (sorted) cell keys.
+    const auto search_nearby_cells = [&](const cell_t &c, auto f) -> void {
+        for(auto di = -stencil_radius; di <= stencil_radius; ++di){
+            const auto i = c.ijk[0] + di;
+            if( (i < 0) || (max_cell_coord < i) ) continue;
+            for(auto dj = -stencil_radius; dj <= stencil_radius; ++dj){
+                const auto j = c.ijk[1] + dj;
+                if( (j < 0) || (max_cell_coord < j) ) continue;
+
+                // Cells along the last axis are contiguous, so the whole run is found with a single search.
+                const auto k_lo = std::max<int64_t>(0, c.ijk[2] - stencil_radius);
+                const auto k_hi = std::min<int64_t>(max_cell_coord, c.ijk[2] + stencil_radius);
+                const auto key_hi = pack_key(i, j, k_hi);
+                auto it = std::lower_bound(std::begin(cells), std::end(cells), pack_key(i, j, k_lo),
+                                           [](const cell_t &C, uint64_t key){ return C.key < key; });
+                for( ; (it != std::end(cells)) && (it->key <= key_hi); ++it){
+                    f(static_cast<uint32_t>(std::distance(std::begin(cells), it)));
+                }
+            }
+        }
+    };
+
+    // Unless memory is bounded, the search results are cached in compressed sparse row form.
+    std::vector<uint64_t> adj_offsets;
+    std::vector<uint32_t> adj;
+    if(!opts.bounded_memory){
+        adj_offsets.resize(cells.size() + 1, 0);
+        parallel_for(0, N_cells, [&](long int c) -> void {
+            uint64_t count = 0;
+            search_nearby_cells(cells[c], [&](uint32_t) -> void { ++count; });
+            adj_offsets[c + 1] = count;
+        });
+        std::partial_sum(std::begin(adj_offsets), std::end(adj_offsets), std::begin(adj_offsets));
+        adj.resize(adj_offsets.back());
+        parallel_for(0, N_cells, [&](long int c) -> void {
+            auto pos = adj_offsets[c];
+            search_nearby_cells(cells[c], [&](uint32_t n) -> void { adj[pos++] = n; });
+        });
+    }
+    const auto for_each_nearby_cell = [&](long int c, auto f) -> void {
+        if(opts.bounded_memory){
+            search_nearby_cells(cells[c], f);
+        }else{
+            for(auto i = adj_offsets[c]; i < adj_offsets[c + 1]; ++i) f(adj[i]);
+        }
+    };
+
+    // Identify core points.
+    parallel_for(0, N_cells, [&](long int c) -> void {
+        const auto &C = cells[c];
+        if(min_pts <= (C.end - C.begin)){
+            for(auto n = C.begin; n < C.end; ++n) sp[n].core = 1;
+            return;
+        }
+        for(auto n = C.begin; n < C.end; ++n){
+            size_t count = 0;
+            bool done = false;
+            for_each_nearby_cell(c, [&](uint32_t nc) -> void {
+                if(done) return;
+                const auto &NC = cells[nc];
+                for(auto m = NC.begin; m < NC.end; ++m){
+                    if( (sq_dist(sp[n], sp[m]) <= eps_sq) && (min_pts <= ++count) ){
+                        done = true;
+                        return;
+                    }
+                }
+            });
+            sp[n].core = done ? 1 : 0;
+        }
+    });
+
+    // Merge cores. Cores sharing a cell are always neighbours, and two cells are merged as soon as any pair of their
+    // cores are found to be neighbours.
+    concurrent_disjoint_sets ds(N);
+    parallel_for(0, N_cells, [&](long int c) -> void {
+        const auto &C = cells[c];
+        auto first_core = C.end;
+        for(auto n = C.begin; n < C.end; ++n){
+            if(!sp[n].core) continue;
+            if(first_core == C.end){
+                first_core = n;
+            }else{
+                ds.unite(sp[first_core].index, sp[n].index);
+            }
+        }
+        if(first_core == C.end) return;
+
+        for_each_nearby_cell(c, [&](uint32_t nc) -> void {
+            if(nc <= c) return; // Each pair of cells is considered once.
+            const auto &NC = cells[nc];
+            bool linked = false;
+            for(auto m = NC.begin; (m < NC.end) && !linked; ++m){
+                if(!sp[m].core) continue;
+                if(ds.find(sp[m].index) == ds.find(sp[first_core].index)) return;
+                for(auto n = first_core; n < C.end; ++n){
+                    if( sp[n].core && (sq_dist(sp[n], sp[m]) <= eps_sq) ){
+                        ds.unite(sp[n].index, sp[m].index);
+                        linked = true;
+                        break;
+                    }
+                }
+            }
+        });
+    });
+
+    // Number the clusters in order of their lowest-indexed core, which is the root of each set.
+    std::vector<uint32_t> roots;
+    for(const auto &p : sp){
+        if(p.core && (ds.find(p.index) == p.index)) roots.push_back(p.index);
+    }
+    std::sort(std::begin(roots), std::end(roots));
+    for(size_t i = 0; i < roots.size(); ++i) labels[roots[i]] = static_cast<int64_t>(i);
+
+    parallel_for(0, static_cast<long int>(N), [&](long int n) -> void {
+        const auto &p = sp[n];
+        const auto root = ds.find(p.index);
+        if(p.core && (root != p.index)) labels[p.index] = labels[root];
+    });
+
+    // Assign border points to the lowest-numbered cluster that can reach them, just as sequential DBSCAN would.
+    parallel_for(0, N_cells, [&](long int c) -> void {
+        const auto &C = cells[c];
+        for(auto n = C.begin; n < C.end; ++n){
+            if(sp[n].core) continue;
+            auto best = std::numeric_limits<int64_t>::max();
+            for_each_nearby_cell(c, [&](uint32_t nc) -> void {
+                const auto &NC = cells[nc];
+                for(auto m = NC.begin; m < NC.end; ++m){
+                    if( sp[m].core && (sq_dist(sp[n], sp[m]) <= eps_sq) ){
+                        best = std::min(best, labels[sp[m].index]);
+                    }
+                }
+            });
+            if(best != std::numeric_limits<int64_t>::max()) labels[sp[n].index] = best;
+        }
+    });
+
+    return labels;
+}
+
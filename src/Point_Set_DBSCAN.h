@@ -0,0 +1,37 @@
+//Point_Set_DBSCAN.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+// Parallel, grid-based DBSCAN clustering of 3D points.
+//
+// Space is partitioned into cubic cells with a diagonal of Eps, so every pair of points sharing a cell are neighbours.
+// Core points are identified in parallel (cells holding at least MinPoints points are entirely core), cores in the
+// same or nearby cells are merged with a lock-free union-find, and each border point is then assigned to a cluster.
+//
+// The result is identical to sequential DBSCAN visiting the points in the order given: clusters are numbered
+// (from zero) in order of their lowest-indexed core point, and border points reachable from more than one cluster are
+// assigned to the lowest-numbered one. It therefore does not depend on the number of threads.
+struct dbscan_options {
+    double eps = 4.0;           // Neighbourhood radius (inclusive).
+    long int min_points = 5;    // Minimum neighbourhood size of a core point, including the point itself.
+
+    // By default, the list of nearby cells is computed once per cell and reused, which is fastest but can consume a
+    // few hundred bytes per point when points are sparse. In bounded-memory mode, nearby cells are located on demand
+    // instead, so the working set is limited to a small, fixed number of bytes per point.
+    bool bounded_memory = false;
+};
+
+constexpr int64_t dbscan_noise = -1;
+
+// Returns the cluster number of each point, or dbscan_noise. Throws if the parameters are invalid or if the points
+// span too many cells to index.
+std::vector<int64_t> Point_Set_DBSCAN(const std::vector<vec3<double>> &points,
+                                      const dbscan_options &opts);
+
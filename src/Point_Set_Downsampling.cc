@@ -0,0 +1,170 @@
+//Point_Set_Downsampling.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Point_Set_Downsampling.h"
+
+
+namespace {
+
+// Rounds towards negative infinity, so voxel indices halve exactly when voxels are doubled in size.
+int64_t Floor_Half(int64_t i){
+    return (0 <= i) ? (i / 2) : -((1 - i) / 2);
+}
+
+} // namespace
+
+
+point_set_downsampler::point_set_downsampler(method m, double spacing, size_t max_points)
+  : m(m), spacing(spacing), max_points(max_points) {
+    if(!std::isfinite(spacing)){
+        throw std::invalid_argument("Downsampling spacing must be finite. Cannot continue.");
+    }
+    if(max_points == 0){
+        throw std::invalid_argument("Downsampling point budget must be positive. Cannot continue.");
+    }
+    if( (spacing <= 0.0)
+    &&  (max_points == std::numeric_limits<size_t>::max()) ){
+        throw std::invalid_argument("Either a downsampling spacing or a point budget is required. Cannot continue.");
+    }
+}
+
+
+size_t point_set_downsampler::key_hash::operator()(const key_t &key) const {
+    uint64_t h = static_cast<uint64_t>(key.i) * 0x9E3779B97F4A7C15ULL;
+    h ^= static_cast<uint64_t>(key.j) + 0xBF58476D1CE4E5B9ULL + (h << 6) + (h >> 2);
+    h ^= static_cast<uint64_t>(key.k) + 0x94D049BB133111EBULL + (h << 6) + (h >> 2);
+    return static_cast<size_t>(h);
+}
+
+
+point_set_downsampler::key_t
+point_set_downsampler::key_of(const vec3<double> &p) const {
+    const double lim = static_cast<double>(std::numeric_limits<int64_t>::max() / 4);
+    const double x = std::floor(p.x / this->spacing);
+    const double y = std::floor(p.y / this->spacing);
+    const double z = std::floor(p.z / this->spacing);
+    if( !(std::abs(x) < lim) || !(std::abs(y) < lim) || !(std::abs(z) < lim) ){
+        throw std::runtime_error("Point is too far from the origin to downsample. Cannot continue.");
+    }
+    return { static_cast<int64_t>(x), static_cast<int64_t>(y), static_cast<int64_t>(z) };
+}
+
+
+bool point_set_downsampler::try_accept(const vec3<double> &p){
+    const auto key = this->key_of(p);
+    const double sq_spacing = this->spacing * this->spacing;
+    for(int64_t di = -1; di <= 1; ++di){
+        for(int64_t dj = -1; dj <= 1; ++dj){
+            for(int64_t dk = -1; dk <= 1; ++dk){
+                const auto it = this->cells.find({ key.i + di, key.j + dj, key.k + dk });
+                if(it == std::end(this->cells)) continue;
+                for(const auto &n : it->second){
+                    if(this->accepted[n].sq_dist(p) < sq_spacing) return false;
+                }
+            }
+        }
+    }
+    this->cells[key].emplace_back( static_cast<uint64_t>(this->accepted.size()) );
+    this->accepted.emplace_back(p);
+    return true;
+}
+
+
+void point_set_downsampler::coarsen(){
+    if(this->m == method::voxel_grid){
+        this->spacing *= 2.0;
+        std::unordered_map<key_t, accum_t, key_hash> merged;
+        merged.reserve(this->voxels.size());
+        for(const auto &v : this->voxels){
+            auto &a = merged[{ Floor_Half(v.first.i), Floor_Half(v.first.j), Floor_Half(v.first.k) }];
+            for(int d = 0; d < 3; ++d) a.sum[d] += v.second.sum[d];
+            a.count += v.second.count;
+        }
+        this->voxels.swap(merged);
+
+    }else{
+        // Re-thin the accepted points in their original order. Surface scans are roughly two-dimensional, so this
+        // approximately halves their number.
+        this->spacing *= std::sqrt(2.0);
+        std::vector<vec3<double>> previous;
+        previous.swap(this->accepted);
+        this->cells.clear();
+        for(const auto &p : previous) this->try_accept(p);
+    }
+    return;
+}
+
+
+void point_set_downsampler::add(const std::vector<vec3<double>> &points){
+    if( (this->spacing <= 0.0) && !points.empty() ){
+        // Select a spacing that is small relative to the extent of the first batch, since the budget will grow it.
+        const auto inf = std::numeric_limits<double>::infinity();
+        vec3<double> lo(inf, inf, inf);
+        vec3<double> hi(-inf, -inf, -inf);
+        for(const auto &p : points){
+            if(!p.isfinite()) continue;
+            lo = vec3<double>( std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) );
+            hi = vec3<double>( std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) );
+        }
+        const auto extent = std::max({ hi.x - lo.x, hi.y - lo.y, hi.z - lo.z });
+        const auto budget = static_cast<double>(std::min<size_t>(this->max_points, 1'000'000'000));
+        this->spacing = (std::isfinite(extent) && (0.0 < extent)) ? (extent / budget) : 1.0E-3;
+    }
+
+    for(const auto &p : points){
+        if(!p.isfinite()) continue;
+        if(this->m == method::voxel_grid){
+            auto &a = this->voxels[this->key_of(p)];
+            a.sum[0] += p.x;
+            a.sum[1] += p.y;
+            a.sum[2] += p.z;
+            ++a.count;
+        }else{
+            this->try_accept(p);
+        }
+        while(this->max_points < this->size()) this->coarsen();
+    }
+    return;
+}
+
+
+std::vector<vec3<double>> point_set_downsampler::get_points() const {
+    if(this->m == method::poisson_disk) return this->accepted;
+
+    std::vector<std::pair<key_t, const accum_t *>> sorted;
+    sorted.reserve(this->voxels.size());
+    for(const auto &v : this->voxels) sorted.emplace_back(v.first, &(v.second));
+    std::sort(std::begin(sorted), std::end(sorted), [](const auto &l, const auto &r) -> bool {
+        return std::tie(l.first.k, l.first.j, l.first.i) < std::tie(r.first.k, r.first.j, r.first.i);
+    });
+
+    std::vector<vec3<double>> out;
+    out.reserve(sorted.size());
+    for(const auto &v : sorted){
+        const auto n = static_cast<double>(v.second->count);
+        out.emplace_back( v.second->sum[0] / n, v.second->sum[1] / n, v.second->sum[2] / n );
+    }
+    return out;
+}
+
+
+size_t point_set_downsampler::size() const {
+    return (this->m == method::voxel_grid) ? this->voxels.size() : this->accepted.size();
+}
+
+
+double point_set_downsampler::get_spacing() const {
+    return this->spacing;
+}
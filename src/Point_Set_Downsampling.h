@@ -0,0 +1,81 @@
+//Point_Set_Downsampling.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+// Incremental, bounded-memory downsampling of 3D points, suitable for point sets too large to hold in memory.
+//
+// Points are added in batches (e.g., as a file is parsed) and only the reduced set is retained. Two methods are
+// supported:
+//
+//  - Voxel grid: space is partitioned into cubic voxels aligned with the origin, and each occupied voxel is replaced by
+//    the centroid of the points it contains.
+//  - Poisson disk: points are accepted in the order given, unless they lie within the spacing of a previously
+//    accepted point, producing a subset with a guaranteed minimum separation.
+//
+// If a point budget is provided, the spacing grows whenever the reduced set would exceed it: voxels are doubled in
+// size and merged exactly, and Poisson disk radii are increased and the accepted points re-thinned. The retained
+// memory is therefore proportional to the budget. Apart from the automatic selection of an initial spacing, the result
+// depends only on the points and the order in which they are added, not on how they are divided into batches.
+// Non-finite points are discarded.
+class point_set_downsampler {
+  public:
+    enum class method {
+        voxel_grid,
+        poisson_disk,
+    };
+
+    // If the spacing is not positive, a small spacing is selected from the first batch and grown to meet the budget,
+    // in which case a finite budget is required.
+    point_set_downsampler(method m,
+                          double spacing,
+                          size_t max_points = std::numeric_limits<size_t>::max());
+
+    void add(const std::vector<vec3<double>> &points);
+
+    // Returns the reduced set. Voxel centroids are ordered by voxel and Poisson disk samples by acceptance.
+    std::vector<vec3<double>> get_points() const;
+
+    size_t size() const;
+    double get_spacing() const; // The current spacing, which may have grown to meet the budget.
+
+  private:
+    struct key_t {
+        int64_t i;
+        int64_t j;
+        int64_t k;
+        bool operator==(const key_t &rhs) const {
+            return (this->i == rhs.i) && (this->j == rhs.j) && (this->k == rhs.k);
+        }
+    };
+    struct key_hash {
+        size_t operator()(const key_t &key) const;
+    };
+    struct accum_t {
+        double sum[3] = { 0.0, 0.0, 0.0 };
+        uint64_t count = 0;
+    };
+
+    method m;
+    double spacing;
+    size_t max_points;
+
+    // Voxel grid state.
+    std::unordered_map<key_t, accum_t, key_hash> voxels;
+
+    // Poisson disk state. Accepted points are binned into cubic cells with sides equal to the spacing.
+    std::vector<vec3<double>> accepted;
+    std::unordered_map<key_t, std::vector<uint64_t>, key_hash> cells;
+
+    key_t key_of(const vec3<double> &p) const;
+    bool try_accept(const vec3<double> &p);
+    void coarsen();
+};
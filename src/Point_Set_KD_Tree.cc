@@ -0,0 +1,331 @@
+//Point_Set_KD_Tree.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Thread_Pool.h"
+#include "Point_Set_KD_Tree.h"
+
+
+namespace {
+
+constexpr int max_traversal_stack = 128; // Exceeds the depth of a balanced tree over 2^32 points.
+
+// Orders hits by distance, breaking ties in favour of the lowest index.
+bool closer(const Point_Set_KD_Tree::hit_t &l, const Point_Set_KD_Tree::hit_t &r){
+    return (l.sq_dist < r.sq_dist)
+        || ( (l.sq_dist == r.sq_dist) && (l.index < r.index) );
+}
+
+bool farther(const Point_Set_KD_Tree::hit_t &l, const Point_Set_KD_Tree::hit_t &r){
+    return (l.sq_dist > r.sq_dist)
+        || ( (l.sq_dist == r.sq_dist) && (l.index < r.index) );
+}
+
+// Squared distance from the point to the nearest and farthest points of the box.
+double box_min_sq_dist(const double lo[3], const double hi[3], const double p[3]){
+    double d2 = 0.0;
+    for(int a = 0; a < 3; ++a){
+        const double d = std::max({ lo[a] - p[a], 0.0, p[a] - hi[a] });
+        d2 += d * d;
+    }
+    return d2;
+}
+
+double box_max_sq_dist(const double lo[3], const double hi[3], const double p[3]){
+    double d2 = 0.0;
+    for(int a = 0; a < 3; ++a){
+        const double d = std::max(std::abs(p[a] - lo[a]), std::abs(hi[a] - p[a]));
+        d2 += d * d;
+    }
+    return d2;
+}
+
+} // namespace
+
+
+Point_Set_KD_Tree::Point_Set_KD_Tree(const std::vector<vec3<double>> &ps){
+    if(static_cast<size_t>(std::numeric_limits<uint32_t>::max()) < ps.size()){
+        throw std::invalid_argument("Too many points to build a k-d tree.");
+    }
+    this->points.reserve(ps.size());
+    for(size_t i = 0; i < ps.size(); ++i){
+        const auto &p = ps[i];
+        if(!p.isfinite()){
+            throw std::invalid_argument("Encountered a non-finite point. Cannot build k-d tree.");
+        }
+        this->points.push_back({ { p.x, p.y, p.z }, i });
+    }
+    if(this->points.empty()) return;
+
+    this->nodes.reserve(2 * (this->points.size() / leaf_size + 1));
+    this->build(0, static_cast<uint32_t>(this->points.size()));
+}
+
+
+uint32_t Point_Set_KD_Tree::build(uint32_t begin, uint32_t end){
+    const auto node_index = static_cast<uint32_t>(this->nodes.size());
+    this->nodes.emplace_back();
+    {
+        auto &n = this->nodes.back();
+        for(int a = 0; a < 3; ++a){
+            n.lo[a] =  std::numeric_limits<double>::infinity();
+            n.hi[a] = -std::numeric_limits<double>::infinity();
+        }
+        for(uint32_t i = begin; i < end; ++i){
+            for(int a = 0; a < 3; ++a){
+                n.lo[a] = std::min(n.lo[a], this->points[i].x[a]);
+                n.hi[a] = std::max(n.hi[a], this->points[i].x[a]);
+            }
+        }
+        if((end - begin) <= leaf_size){
+            n.offset = begin;
+            n.count = end - begin;
+            return node_index;
+        }
+    }
+
+    // Split at the median along the widest axis.
+    int axis = 0;
+    {
+        const auto &n = this->nodes[node_index];
+        for(int a = 1; a < 3; ++a){
+            if((n.hi[axis] - n.lo[axis]) < (n.hi[a] - n.lo[a])) axis = a;
+        }
+    }
+    const uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(std::begin(this->points) + begin,
+                     std::begin(this->points) + mid,
+                     std::begin(this->points) + end,
+                     [axis](const point_t &l, const point_t &r) -> bool {
+                         return (l.x[axis] < r.x[axis])
+                             || ( (l.x[axis] == r.x[axis]) && (l.index < r.index) );
+                     });
+
+    this->build(begin, mid);
+    const auto second = this->build(mid, end);
+
+    // Note: nodes may have been reallocated, so the node is re-acquired.
+    this->nodes[node_index].offset = second;
+    this->nodes[node_index].count = 0;
+    return node_index;
+}
+
+
+Point_Set_KD_Tree::hit_t
+Point_Set_KD_Tree::nearest(const vec3<double> &p) const {
+    hit_t best;
+    if(this->nodes.empty()) return best;
+    const double q[3] = { p.x, p.y, p.z };
+
+    uint32_t stack[max_traversal_stack];
+    int top = 0;
+    stack[top++] = 0;
+    while(0 < top){
+        const auto &n = this->nodes[ stack[--top] ];
+        if(best.sq_dist < box_min_sq_dist(n.lo, n.hi, q)) continue;
+
+        if(n.count != 0){
+            for(uint32_t i = n.offset; i < (n.offset + n.count); ++i){
+                const auto &pt = this->points[i];
+                const double dx = pt.x[0] - q[0];
+                const double dy = pt.x[1] - q[1];
+                const double dz = pt.x[2] - q[2];
+                const hit_t h = { pt.index, dx*dx + dy*dy + dz*dz };
+                if(closer(h, best)) best = h;
+            }
+            continue;
+        }
+
+        // Visit the nearer child first by pushing it last.
+        const auto first = static_cast<uint32_t>(&n - this->nodes.data()) + 1;
+        const auto second = n.offset;
+        const double d_first  = box_min_sq_dist(this->nodes[first].lo,  this->nodes[first].hi,  q);
+        const double d_second = box_min_sq_dist(this->nodes[second].lo, this->nodes[second].hi, q);
+        if(d_first <= d_second){
+            stack[top++] = second;
+            stack[top++] = first;
+        }else{
+            stack[top++] = first;
+            stack[top++] = second;
+        }
+    }
+    return best;
+}
+
+
+std::vector<Point_Set_KD_Tree::hit_t>
+Point_Set_KD_Tree::k_nearest(const vec3<double> &p, size_t k, double max_sq_dist) const {
+    std::vector<hit_t> out;
+    if(this->nodes.empty() || (k == 0)) return out;
+    const double q[3] = { p.x, p.y, p.z };
+
+    // A max-heap of the best candidates so far; the worst candidate is at the top.
+    std::priority_queue<hit_t, std::vector<hit_t>, decltype(&closer)> heap(&closer);
+
+    uint32_t stack[max_traversal_stack];
+    int top = 0;
+    stack[top++] = 0;
+    while(0 < top){
+        const auto &n = this->nodes[ stack[--top] ];
+        const auto box_sq_dist = box_min_sq_dist(n.lo, n.hi, q);
+        if(max_sq_dist < box_sq_dist) continue;
+        if( (heap.size() == k)
+        &&  (heap.top().sq_dist < box_sq_dist) ) continue;
+
+        if(n.count != 0){
+            for(uint32_t i = n.offset; i < (n.offset + n.count); ++i){
+                const auto &pt = this->points[i];
+                const double dx = pt.x[0] - q[0];
+                const double dy = pt.x[1] - q[1];
+                const double dz = pt.x[2] - q[2];
+                const hit_t h = { pt.index, dx*dx + dy*dy + dz*dz };
+                if(max_sq_dist < h.sq_dist) continue;
+                if(heap.size() < k){
+                    heap.push(h);
+                }else if(closer(h, heap.top())){
+                    heap.pop();
+                    heap.push(h);
+                }
+            }
+            continue;
+        }
+
+        const auto first = static_cast<uint32_t>(&n - this->nodes.data()) + 1;
+        const auto second = n.offset;
+        const double d_first  = box_min_sq_dist(this->nodes[first].lo,  this->nodes[first].hi,  q);
+        const double d_second = box_min_sq_dist(this->nodes[second].lo, this->nodes[second].hi, q);
+        if(d_first <= d_second){
+            stack[top++] = second;
+            stack[top++] = first;
+        }else{
+            stack[top++] = first;
+            stack[top++] = second;
+        }
+    }
+
+    out.resize(heap.size());
+    for(auto it = std::rbegin(out); it != std::rend(out); ++it){
+        *it = heap.top();
+        heap.pop();
+    }
+    return out;
+}
+
+
+std::vector<Point_Set_KD_Tree::hit_t>
+Point_Set_KD_Tree::within(const vec3<double> &p, double max_sq_dist) const {
+    std::vector<hit_t> out;
+    if(this->nodes.empty()) return out;
+    const double q[3] = { p.x, p.y, p.z };
+
+    uint32_t stack[max_traversal_stack];
+    int top = 0;
+    stack[top++] = 0;
+    while(0 < top){
+        const auto &n = this->nodes[ stack[--top] ];
+        if(max_sq_dist < box_min_sq_dist(n.lo, n.hi, q)) continue;
+
+        if(n.count != 0){
+            for(uint32_t i = n.offset; i < (n.offset + n.count); ++i){
+                const auto &pt = this->points[i];
+                const double dx = pt.x[0] - q[0];
+                const double dy = pt.x[1] - q[1];
+                const double dz = pt.x[2] - q[2];
+                const hit_t h = { pt.index, dx*dx + dy*dy + dz*dz };
+                if(h.sq_dist <= max_sq_dist) out.push_back(h);
+            }
+            continue;
+        }
+
+        const auto first = static_cast<uint32_t>(&n - this->nodes.data()) + 1;
+        stack[top++] = n.offset;
+        stack[top++] = first;
+    }
+
+    std::sort(std::begin(out), std::end(out), closer);
+    return out;
+}
+
+
+Point_Set_KD_Tree::hit_t
+Point_Set_KD_Tree::farthest(const vec3<double> &p) const {
+    hit_t best;
+    best.sq_dist = -std::numeric_limits<double>::infinity();
+    if(this->nodes.empty()){
+        best.sq_dist = std::numeric_limits<double>::infinity();
+        return best;
+    }
+    const double q[3] = { p.x, p.y, p.z };
+
+    uint32_t stack[max_traversal_stack];
+    int top = 0;
+    stack[top++] = 0;
+    while(0 < top){
+        const auto &n = this->nodes[ stack[--top] ];
+        if(box_max_sq_dist(n.lo, n.hi, q) < best.sq_dist) continue;
+
+        if(n.count != 0){
+            for(uint32_t i = n.offset; i < (n.offset + n.count); ++i){
+                const auto &pt = this->points[i];
+                const double dx = pt.x[0] - q[0];
+                const double dy = pt.x[1] - q[1];
+                const double dz = pt.x[2] - q[2];
+                const hit_t h = { pt.index, dx*dx + dy*dy + dz*dz };
+                if(farther(h, best)) best = h;
+            }
+            continue;
+        }
+
+        // Visit the farther child first by pushing it last.
+        const auto first = static_cast<uint32_t>(&n - this->nodes.data()) + 1;
+        const auto second = n.offset;
+        const double d_first  = box_max_sq_dist(this->nodes[first].lo,  this->nodes[first].hi,  q);
+        const double d_second = box_max_sq_dist(this->nodes[second].lo, this->nodes[second].hi, q);
+        if(d_first >= d_second){
+            stack[top++] = second;
+            stack[top++] = first;
+        }else{
+            stack[top++] = first;
+            stack[top++] = second;
+        }
+    }
+    return best;
+}
+
+
+std::vector<Point_Set_KD_Tree::hit_t>
+Point_Set_KD_Tree::nearest(const std::vector<vec3<double>> &ps) const {
+    std::vector<hit_t> out(ps.size());
+    parallel_for(0, static_cast<long int>(ps.size()), [&](long int i) -> void {
+        out[i] = this->nearest(ps[i]);
+    });
+    return out;
+}
+
+
+bool Point_Set_KD_Tree::is_current(const std::vector<vec3<double>> &ps) const {
+    if(ps.size() != this->points.size()) return false;
+    return std::all_of(std::begin(this->points), std::end(this->points), [&](const point_t &pt) -> bool {
+        const auto &p = ps[pt.index];
+        return (p.x == pt.x[0]) && (p.y == pt.x[1]) && (p.z == pt.x[2]);
+    });
+}
+
+
+size_t Point_Set_KD_Tree::size() const {
+    return this->points.size();
+}
+
+size_t Point_Set_KD_Tree::node_count() const {
+    return this->nodes.size();
+}
+
@@ -0,0 +1,74 @@
+//Point_Set_KD_Tree.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+// A static k-d tree for nearest-neighbour (and farthest-point) queries against a set of points.
+//
+// Points are recursively partitioned at the median along the widest axis of their bounding box. The tree is stored as
+// a flattened, depth-first node array with per-node bounding boxes (the first child of an interior node follows it
+// directly), and points are stored in leaf order, so traversal is iterative and cache-friendly. Ties are broken in
+// favour of the point with the lowest index in the original set, so results do not depend on the tree structure.
+//
+// The tree holds a copy of the points, so it remains valid if the original set is later altered. is_current() can be
+// used to detect such changes. Queries are const and may be issued concurrently.
+class Point_Set_KD_Tree {
+  public:
+    struct hit_t {
+        size_t index = std::numeric_limits<size_t>::max(); // Index of the point in the original set.
+        double sq_dist = std::numeric_limits<double>::infinity();
+    };
+
+    explicit Point_Set_KD_Tree(const std::vector<vec3<double>> &points);
+
+    // Returns the point nearest to p. If the tree is empty, the index is invalid and the distance infinite.
+    hit_t nearest(const vec3<double> &p) const;
+
+    // Returns up to k nearest points, sorted by increasing distance. Points farther than sqrt(max_sq_dist) are ignored.
+    std::vector<hit_t> k_nearest(const vec3<double> &p,
+                                 size_t k,
+                                 double max_sq_dist = std::numeric_limits<double>::infinity()) const;
+
+    // Returns all points within sqrt(max_sq_dist) of p, sorted by increasing distance.
+    std::vector<hit_t> within(const vec3<double> &p, double max_sq_dist) const;
+
+    // Returns the point farthest from p.
+    hit_t farthest(const vec3<double> &p) const;
+
+    // Performs nearest() for many points in parallel using the process-wide thread pool.
+    std::vector<hit_t> nearest(const std::vector<vec3<double>> &ps) const;
+
+    // Returns true if the set holds the same points, in the same order, as when the tree was built. This is linear in
+    // the number of points, but much cheaper than rebuilding.
+    bool is_current(const std::vector<vec3<double>> &points) const;
+
+    size_t size() const;
+    size_t node_count() const;
+
+  private:
+    static constexpr uint32_t leaf_size = 8;
+
+    struct point_t {
+        double x[3];
+        size_t index;
+    };
+    std::vector<point_t> points; // In leaf order.
+
+    struct node_t {
+        double lo[3];
+        double hi[3];
+        uint32_t offset;         // Leaves: first point. Interior nodes: index of the second child.
+        uint32_t count;          // Leaves: number of points. Interior nodes: zero.
+    };
+    std::vector<node_t> nodes;
+
+    uint32_t build(uint32_t begin, uint32_t end);
+};
+
@@ -0,0 +1,526 @@
+//Polygon_Overlay.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Polygon_Overlay.h"
+
+
+namespace {
+
+using pt = polygon_overlay_point;
+
+// Vertices closer than this fraction of the inputs' extent are merged.
+constexpr double relative_tolerance = 1.0E-9;
+
+pt sub(const pt &a, const pt &b){
+    return {{ a[0] - b[0], a[1] - b[1] }};
+}
+
+double dot(const pt &a, const pt &b){
+    return a[0] * b[0] + a[1] * b[1];
+}
+
+double cross(const pt &a, const pt &b){
+    return a[0] * b[1] - a[1] * b[0];
+}
+
+double signed_area(const polygon_overlay_ring &r){
+    double a = 0.0;
+    const auto N = r.size();
+    for(size_t i = 0; i < N; ++i){
+        a += cross(r[i], r[(i + 1) % N]);
+    }
+    return 0.5 * a;
+}
+
+// Even-odd point-in-ring test.
+bool encloses(const polygon_overlay_ring &r, const pt &p){
+    bool inside = false;
+    const auto N = r.size();
+    for(size_t i = 0, j = N - 1; i < N; j = i++){
+        const auto &a = r[i];
+        const auto &b = r[j];
+        if( (a[1] > p[1]) != (b[1] > p[1]) ){
+            const auto x = a[0] + (p[1] - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+            if(p[0] < x) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+struct input_edge_t {
+    pt a;
+    pt b;
+    int64_t ring;
+    std::vector<std::pair<double, pt>> splits; // (parameter, point), both exclusive of the endpoints.
+};
+
+// Records where edge F touches or crosses edge E, and vice versa.
+void intersect(input_edge_t &E, input_edge_t &F, double eps){
+    const auto r = sub(E.b, E.a);
+    const auto s = sub(F.b, F.a);
+
+    // Endpoints lying on the other edge. The endpoint itself is used so the vertices coincide exactly.
+    const auto touch = [eps](input_edge_t &X, const pt &d, const pt &q){
+        const auto dd = dot(d, d);
+        const auto t = dot(sub(q, X.a), d) / dd;
+        if( !(0.0 < t) || !(t < 1.0) ) return;
+        const pt c = {{ X.a[0] + t * d[0], X.a[1] + t * d[1] }};
+        if(dot(sub(q, c), sub(q, c)) <= eps * eps) X.splits.emplace_back(t, q);
+    };
+    touch(E, r, F.a);
+    touch(E, r, F.b);
+    touch(F, s, E.a);
+    touch(F, s, E.b);
+
+    // Proper crossings.
+    const auto den = cross(r, s);
+    if(den == 0.0) return;
+    const auto w = sub(F.a, E.a);
+    const auto t = cross(w, s) / den;
+    const auto u = cross(w, r) / den;
+    if( (0.0 < t) && (t < 1.0) && (0.0 < u) && (u < 1.0) ){
+        const pt X = {{ E.a[0] + t * r[0], E.a[1] + t * r[1] }};
+        E.splits.emplace_back(t, X);
+        F.splits.emplace_back(u, X);
+    }
+    return;
+}
+
+struct union_find_t {
+    std::vector<int64_t> parent;
+
+    explicit union_find_t(int64_t n) : parent(n) {
+        std::iota(std::begin(parent), std::end(parent), 0);
+    }
+    int64_t find(int64_t i){
+        while(parent[i] != i){
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+    void merge(int64_t i, int64_t j){
+        i = this->find(i);
+        j = this->find(j);
+        if(i == j) return;
+        if(j < i) std::swap(i, j);
+        parent[j] = i; // The lowest index represents the set, which keeps the result deterministic.
+    }
+};
+
+struct cell_hash_t {
+    size_t operator()(const std::pair<int64_t,int64_t> &c) const {
+        return std::hash<int64_t>()(c.first) ^ (std::hash<int64_t>()(c.second) * 0x9E3779B97F4A7C15ULL);
+    }
+};
+
+// Returns, for each point, the index of a representative point within the tolerance.
+std::vector<int64_t> snap(const std::vector<pt> &P, double eps){
+    const auto N = static_cast<int64_t>(P.size());
+    const auto cell = 2.0 * eps;
+    std::unordered_map<std::pair<int64_t,int64_t>, std::vector<int64_t>, cell_hash_t> cells;
+    cells.reserve(P.size());
+    const auto key = [cell](const pt &p){
+        return std::make_pair( static_cast<int64_t>(std::floor(p[0] / cell)),
+                               static_cast<int64_t>(std::floor(p[1] / cell)) );
+    };
+    for(int64_t i = 0; i < N; ++i) cells[key(P[i])].push_back(i);
+
+    union_find_t uf(N);
+    for(int64_t i = 0; i < N; ++i){
+        const auto c = key(P[i]);
+        for(int64_t dx = -1; dx <= 1; ++dx){
+            for(int64_t dy = -1; dy <= 1; ++dy){
+                const auto it = cells.find(std::make_pair(c.first + dx, c.second + dy));
+                if(it == std::end(cells)) continue;
+                for(const auto &j : it->second){
+                    if( (i < j) && (dot(sub(P[i], P[j]), sub(P[i], P[j])) <= eps * eps) ) uf.merge(i, j);
+                }
+            }
+        }
+    }
+    std::vector<int64_t> out(N);
+    for(int64_t i = 0; i < N; ++i) out[i] = uf.find(i);
+    return out;
+}
+
+// Buckets edges by their extent along one axis for ray casting.
+struct band_index_t {
+    double lo = 0.0;
+    double width = 1.0;
+    std::vector<std::vector<int64_t>> bands;
+
+    int64_t band(double x) const {
+        const auto b = static_cast<int64_t>(std::floor((x - lo) / width));
+        return std::clamp<int64_t>(b, 0, static_cast<int64_t>(bands.size()) - 1);
+    }
+};
+
+} // namespace
+
+
+polygon_overlay::polygon_overlay(const std::vector<polygon_overlay_ring> &A,
+                                 const std::vector<polygon_overlay_ring> &B,
+                                 const polygon_overlay_rule &rule_A,
+                                 const polygon_overlay_rule &rule_B){
+    const auto N_A = static_cast<int64_t>(A.size());
+    const auto N_B = static_cast<int64_t>(B.size());
+
+    // Gather the edges, keeping track of which ring they belong to. Rings A come first.
+    std::vector<input_edge_t> in;
+    pt lo = {{  std::numeric_limits<double>::infinity(),  std::numeric_limits<double>::infinity() }};
+    pt hi = {{ -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() }};
+    for(int64_t g = 0; g < (N_A + N_B); ++g){
+        const auto &r = (g < N_A) ? A[g] : B[g - N_A];
+        if(r.size() < 3) continue;
+        for(size_t i = 0; i < r.size(); ++i){
+            const auto &a = r[i];
+            const auto &b = r[(i + 1) % r.size()];
+            if(a == b) continue;
+            in.push_back( input_edge_t{ a, b, g, {} } );
+            for(size_t d = 0; d < 2; ++d){
+                lo[d] = std::min(lo[d], a[d]);
+                hi[d] = std::max(hi[d], a[d]);
+            }
+        }
+    }
+    if(in.empty()) return;
+    const auto extent = std::max(hi[0] - lo[0], hi[1] - lo[1]);
+    this->eps = relative_tolerance * std::max(extent, std::numeric_limits<double>::min());
+
+    // Split edges where they cross or touch, sweeping upward over the edges' vertical extents.
+    {
+        const auto ymin = [&](int64_t i){ return std::min(in[i].a[1], in[i].b[1]); };
+        const auto ymax = [&](int64_t i){ return std::max(in[i].a[1], in[i].b[1]); };
+        const auto xmin = [&](int64_t i){ return std::min(in[i].a[0], in[i].b[0]); };
+        const auto xmax = [&](int64_t i){ return std::max(in[i].a[0], in[i].b[0]); };
+
+        std::vector<int64_t> order(in.size());
+        std::iota(std::begin(order), std::end(order), 0);
+        std::sort(std::begin(order), std::end(order), [&](int64_t i, int64_t j){ return ymin(i) < ymin(j); });
+
+        std::vector<int64_t> active;
+        for(const auto &e : order){
+            const auto y = ymin(e) - this->eps;
+            active.erase( std::remove_if(std::begin(active), std::end(active),
+                                         [&](int64_t a){ return ymax(a) < y; }),
+                          std::end(active) );
+            for(const auto &a : active){
+                if( (xmax(a) < (xmin(e) - this->eps)) || ((xmax(e) + this->eps) < xmin(a)) ) continue;
+                intersect(in[a], in[e], this->eps);
+            }
+            active.push_back(e);
+        }
+    }
+
+    // Merge nearby vertices. Each edge becomes a chain of points ordered along it.
+    std::vector<pt> P;
+    std::vector<std::pair<size_t,size_t>> chains; // Extent of each edge's chain in P.
+    chains.reserve(in.size());
+    for(auto &e : in){
+        std::sort(std::begin(e.splits), std::end(e.splits),
+                  [](const auto &l, const auto &r){ return l.first < r.first; });
+        const auto begin = P.size();
+        P.push_back(e.a);
+        for(const auto &s : e.splits) P.push_back(s.second);
+        P.push_back(e.b);
+        chains.emplace_back(begin, P.size());
+    }
+    const auto rep = snap(P, this->eps);
+    std::vector<int64_t> vert_of(P.size(), -1);
+    for(size_t i = 0; i < P.size(); ++i){
+        const auto r = static_cast<size_t>(rep[i]);
+        if(vert_of[r] < 0){
+            vert_of[r] = static_cast<int64_t>(this->verts.size());
+            this->verts.push_back(P[r]);
+        }
+        vert_of[i] = vert_of[r];
+    }
+
+    // Form the unique edges, recording every ring that contributes each one. Coincident edges collapse.
+    const auto N_V = static_cast<uint64_t>(this->verts.size());
+    std::unordered_map<uint64_t, int64_t> edge_of;
+    std::vector<std::vector<int64_t>> rings_of;
+    for(size_t k = 0; k < in.size(); ++k){
+        for(size_t i = chains[k].first; (i + 1) < chains[k].second; ++i){
+            const auto u = vert_of[i];
+            const auto v = vert_of[i + 1];
+            if(u == v) continue;
+            const auto key = static_cast<uint64_t>(std::min(u, v)) * N_V + static_cast<uint64_t>(std::max(u, v));
+            const auto it = edge_of.find(key);
+            if(it == std::end(edge_of)){
+                edge_of.emplace(key, static_cast<int64_t>(this->edges.size()));
+                this->edges.push_back( edge_t{ u, v, false, false, false, false } );
+                rings_of.push_back( { in[k].ring } );
+            }else{
+                rings_of[it->second].push_back(in[k].ring);
+            }
+        }
+    }
+
+    // Index the edges for horizontal (x) and vertical (y) rays.
+    const auto N_E = static_cast<int64_t>(this->edges.size());
+    std::array<band_index_t, 2> index;
+    for(size_t d = 0; d < 2; ++d){
+        // Rays along axis 'd' need the edges bucketed by their extent along the other axis.
+        const auto o = 1 - d;
+        auto &ind = index[d];
+        const auto N_bands = std::clamp<int64_t>(N_E / 2, 1, 1 << 16);
+        ind.lo = lo[o];
+        ind.width = std::max(hi[o] - lo[o], std::numeric_limits<double>::min()) / static_cast<double>(N_bands);
+        ind.bands.resize(N_bands);
+        for(int64_t e = 0; e < N_E; ++e){
+            const auto &a = this->verts[this->edges[e].u];
+            const auto &b = this->verts[this->edges[e].v];
+            const auto b0 = ind.band(std::min(a[o], b[o]));
+            const auto b1 = ind.band(std::max(a[o], b[o]));
+            for(auto b = b0; b <= b1; ++b) ind.bands[b].push_back(e);
+        }
+    }
+
+    // Label each edge. A ray is cast from the midpoint along the axis most nearly perpendicular to the edge; the
+    // parity of the crossings (excluding the edge itself) gives ring membership on the ray's side, and the rings that
+    // contribute the edge flip membership on the other side.
+    std::vector<uint8_t> parity(N_A + N_B, 0);
+    std::vector<uint8_t> in_A(N_A, 0);
+    std::vector<uint8_t> in_B(N_B, 0);
+    const auto evaluate = [&](bool &A_member, bool &B_member){
+        std::copy(std::begin(parity), std::next(std::begin(parity), N_A), std::begin(in_A));
+        std::copy(std::next(std::begin(parity), N_A), std::end(parity), std::begin(in_B));
+        A_member = (N_A != 0) && rule_A(in_A);
+        B_member = (N_B != 0) && rule_B(in_B);
+    };
+    for(int64_t e = 0; e < N_E; ++e){
+        const auto &a = this->verts[this->edges[e].u];
+        const auto &b = this->verts[this->edges[e].v];
+        const pt m = {{ 0.5 * (a[0] + b[0]), 0.5 * (a[1] + b[1]) }};
+        const auto dir = sub(b, a);
+        const size_t d = (std::abs(dir[0]) <= std::abs(dir[1])) ? 0 : 1; // Ray axis.
+        const size_t o = 1 - d;
+
+        std::fill(std::begin(parity), std::end(parity), 0);
+        for(const auto &f : index[d].bands[index[d].band(m[o])]){
+            if(f == e) continue;
+            const auto &p = this->verts[this->edges[f].u];
+            const auto &q = this->verts[this->edges[f].v];
+            if( (p[o] > m[o]) == (q[o] > m[o]) ) continue;
+            const auto x = p[d] + (m[o] - p[o]) * (q[d] - p[d]) / (q[o] - p[o]);
+            if(m[d] < x){
+                for(const auto &g : rings_of[f]) parity[g] ^= 1;
+            }
+        }
+
+        // Whether the ray's side is to the left of u->v.
+        const bool ray_side_is_left = (d == 0) ? (dir[1] < 0.0) : (0.0 < dir[0]);
+
+        bool A_ray = false;
+        bool B_ray = false;
+        evaluate(A_ray, B_ray);
+        for(const auto &g : rings_of[e]) parity[g] ^= 1;
+        bool A_other = false;
+        bool B_other = false;
+        evaluate(A_other, B_other);
+
+        auto &E = this->edges[e];
+        E.A_left  = ray_side_is_left ? A_ray : A_other;
+        E.A_right = ray_side_is_left ? A_other : A_ray;
+        E.B_left  = ray_side_is_left ? B_ray : B_other;
+        E.B_right = ray_side_is_left ? B_other : B_ray;
+    }
+}
+
+double polygon_overlay::tolerance() const {
+    return this->eps;
+}
+
+std::vector<polygon_overlay_region>
+polygon_overlay::extract(const std::function<bool(bool, bool)> &op) const {
+    // Orient the boundary edges so the result is on their left.
+    std::vector<std::pair<int64_t,int64_t>> directed;
+    for(const auto &E : this->edges){
+        const auto L = op(E.A_left, E.B_left);
+        const auto R = op(E.A_right, E.B_right);
+        if(L && !R) directed.emplace_back(E.u, E.v);
+        if(R && !L) directed.emplace_back(E.v, E.u);
+    }
+
+    const auto N_V = this->verts.size();
+    std::vector<std::vector<int64_t>> outgoing(N_V);
+    for(size_t i = 0; i < directed.size(); ++i) outgoing[directed[i].first].push_back(static_cast<int64_t>(i));
+
+    // Trace the faces. At each vertex the walk continues along the first edge found by rotating clockwise from the
+    // incoming edge, which keeps regions that only touch at a vertex separate.
+    const auto pi = std::acos(-1.0);
+    std::vector<uint8_t> used(directed.size(), 0);
+    std::vector<polygon_overlay_ring> outers;
+    std::vector<polygon_overlay_ring> holes;
+    for(size_t start = 0; start < directed.size(); ++start){
+        if(used[start] != 0) continue;
+        polygon_overlay_ring loop;
+        auto cur = static_cast<int64_t>(start);
+        bool closed = false;
+        while(true){
+            used[cur] = 1;
+            const auto [from, to] = directed[cur];
+            loop.push_back(this->verts[from]);
+
+            const auto r = sub(this->verts[from], this->verts[to]);
+            int64_t next = -1;
+            double best = std::numeric_limits<double>::infinity();
+            for(const auto &c : outgoing[to]){
+                const auto o = sub(this->verts[directed[c].second], this->verts[to]);
+                auto angle = std::atan2(cross(o, r), dot(o, r));
+                if(angle <= 0.0) angle += 2.0 * pi;
+                if(angle < best){
+                    best = angle;
+                    next = c;
+                }
+            }
+            if(next == static_cast<int64_t>(start)){
+                closed = true;
+                break;
+            }
+            if( (next < 0) || (used[next] != 0) ) break;
+            cur = next;
+        }
+        if(!closed || (loop.size() < 3)) continue;
+
+        const auto area = signed_area(loop);
+        if(std::abs(area) <= (this->eps * this->eps)) continue;
+        ((0.0 < area) ? outers : holes).emplace_back(std::move(loop));
+    }
+
+    std::vector<polygon_overlay_region> out;
+    std::vector<double> areas;
+    for(auto &r : outers){
+        areas.push_back(signed_area(r));
+        out.emplace_back();
+        out.back().outer = std::move(r);
+    }
+
+    // Holes are assigned to the smallest enclosing outer ring. Holes never share vertices with outer rings (the faces
+    // would have been traced as a single ring) so testing a single vertex suffices.
+    for(auto &h : holes){
+        int64_t best = -1;
+        for(size_t i = 0; i < out.size(); ++i){
+            if( ((best < 0) || (areas[i] < areas[best])) && encloses(out[i].outer, h.front()) ){
+                best = static_cast<int64_t>(i);
+            }
+        }
+        if(0 <= best) out[best].holes.emplace_back(std::move(h));
+    }
+    return out;
+}
+
+
+polygon_overlay_ring
+Bridge_Holes(const polygon_overlay_region &region){
+    auto poly = region.outer;
+
+    // Holes are bridged rightward, starting with the rightmost, so that bridges do not cross holes yet to be bridged
+    // (Eberly's method, as used for ear clipping).
+    const auto rightmost = [](const polygon_overlay_ring &r) -> size_t {
+        size_t m = 0;
+        for(size_t i = 1; i < r.size(); ++i){
+            if(r[m][0] < r[i][0]) m = i;
+        }
+        return m;
+    };
+    std::vector<const polygon_overlay_ring *> holes;
+    for(const auto &h : region.holes){
+        if(3 <= h.size()) holes.push_back(&h);
+    }
+    std::sort(std::begin(holes), std::end(holes), [&](const auto *l, const auto *r){
+        return (*r)[rightmost(*r)][0] < (*l)[rightmost(*l)][0];
+    });
+
+    for(const auto *h_ptr : holes){
+        const auto &h = *h_ptr;
+        const auto mi = rightmost(h);
+        const auto M = h[mi];
+        const auto N = poly.size();
+
+        // Cast a ray from M in the +x direction and find the nearest edge it hits.
+        double hit_x = std::numeric_limits<double>::infinity();
+        int64_t P = -1;
+        for(size_t i = 0; i < N; ++i){
+            const auto &a = poly[i];
+            const auto &b = poly[(i + 1) % N];
+            if( (std::min(a[1], b[1]) <= M[1]) && (M[1] <= std::max(a[1], b[1])) ){
+                double x = 0.0;
+                if(a[1] == b[1]){
+                    x = std::max(M[0], std::min(a[0], b[0]));
+                    if(std::max(a[0], b[0]) < M[0]) continue;
+                }else{
+                    x = a[0] + (M[1] - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+                }
+                if( (M[0] <= x) && (x < hit_x) ){
+                    hit_x = x;
+                    P = static_cast<int64_t>( (b[0] < a[0]) ? i : (i + 1) % N );
+                }
+            }
+        }
+        if(P < 0) continue;
+
+        // Vertices within the triangle (M, hit, P) could block the bridge. If any exist, the one making the smallest
+        // angle with the ray is visible and is used instead.
+        const pt I = {{ hit_x, M[1] }};
+        const auto in_triangle = [&](const pt &q) -> bool {
+            const auto d1 = cross(sub(I, M), sub(q, M));
+            const auto d2 = cross(sub(poly[P], I), sub(q, I));
+            const auto d3 = cross(sub(M, poly[P]), sub(q, poly[P]));
+            const bool neg = (d1 < 0.0) || (d2 < 0.0) || (d3 < 0.0);
+            const bool pos = (d1 > 0.0) || (d2 > 0.0) || (d3 > 0.0);
+            return !(neg && pos);
+        };
+        const auto locally_inside = [&](size_t i) -> bool {
+            const auto &q = poly[i];
+            const auto &prev = poly[(i + N - 1) % N];
+            const auto &next = poly[(i + 1) % N];
+            const auto w = sub(M, q);
+            const auto c1 = cross(sub(next, q), w);
+            const auto c2 = cross(w, sub(prev, q));
+            const bool convex = (0.0 <= cross(sub(q, prev), sub(next, q)));
+            return convex ? ((0.0 <= c1) && (0.0 <= c2)) : ((0.0 <= c1) || (0.0 <= c2));
+        };
+        if(poly[P][0] != hit_x){
+            double best_tan = std::numeric_limits<double>::infinity();
+            double best_x = std::numeric_limits<double>::infinity();
+            const auto P_x = poly[P][0];
+            for(size_t i = 0; i < N; ++i){
+                const auto &q = poly[i];
+                if( (static_cast<int64_t>(i) == P) || (q[0] < M[0]) || (P_x < q[0]) ) continue;
+                if( !in_triangle(q) || !locally_inside(i) ) continue;
+                const auto dx = q[0] - M[0];
+                const auto tan = (dx == 0.0) ? std::numeric_limits<double>::infinity()
+                                             : std::abs(q[1] - M[1]) / dx;
+                if( (tan < best_tan) || ((tan == best_tan) && (q[0] < best_x)) ){
+                    best_tan = tan;
+                    best_x = q[0];
+                    P = static_cast<int64_t>(i);
+                }
+            }
+        }
+
+        // Splice the hole in after P: P, M, (the rest of the hole), M, P.
+        polygon_overlay_ring seamed;
+        seamed.reserve(N + h.size() + 2);
+        seamed.insert(std::end(seamed), std::begin(poly), std::next(std::begin(poly), P + 1));
+        for(size_t i = 0; i <= h.size(); ++i) seamed.push_back(h[(mi + i) % h.size()]);
+        seamed.push_back(poly[P]);
+        seamed.insert(std::end(seamed), std::next(std::begin(poly), P + 1), std::end(poly));
+        poly = std::move(seamed);
+    }
+    return poly;
+}
+
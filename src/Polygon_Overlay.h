@@ -0,0 +1,71 @@
+//Polygon_Overlay.h.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+// A floating-point overlay of two sets of planar polygons for evaluating Boolean operations without exact predicates.
+//
+// All edges are split wherever they cross or touch, vertices closer than a tolerance (relative to the extent of the
+// inputs) are merged so that coincident edges collapse, and each of the resulting edges is then labelled with the
+// membership of the regions immediately to either side of it. Membership is found by casting an axis-aligned ray from
+// the edge's midpoint through a banded edge index, so no perturbed test points are needed. Intersections are found by
+// sweeping over the edges' vertical extents, so the cost is roughly proportional to the number of edges plus the
+// number of candidate intersections, rather than their product.
+//
+// Once constructed, any number of operations can be extracted from the same overlay; only relabelling and chaining
+// the edges is needed per operation.
+//
+// Note: unlike an exact arrangement, nearly-degenerate inputs (e.g., features narrower than the tolerance) may produce
+//       slightly different results than exact arithmetic would. The inputs are never rejected.
+using polygon_overlay_point = std::array<double,2>;
+using polygon_overlay_ring  = std::vector<polygon_overlay_point>;   // Implicitly closed. Orientation is ignored.
+
+// Determines whether a point is a member of an operand given whether it is enclosed by each of the operand's rings
+// (in the order the rings were provided). For example, a union returns true if any element is non-zero.
+using polygon_overlay_rule = std::function<bool(const std::vector<uint8_t> &)>;
+
+// A region bounded by a counter-clockwise outer ring, with clockwise holes.
+struct polygon_overlay_region {
+    polygon_overlay_ring outer;
+    std::vector<polygon_overlay_ring> holes;
+};
+
+class polygon_overlay {
+  public:
+    polygon_overlay(const std::vector<polygon_overlay_ring> &A,
+                    const std::vector<polygon_overlay_ring> &B,
+                    const polygon_overlay_rule &rule_A,
+                    const polygon_overlay_rule &rule_B);
+
+    // Returns the regions for which op(in_A, in_B) is true. The operation must be false outside of both operands.
+    std::vector<polygon_overlay_region>
+    extract(const std::function<bool(bool, bool)> &op) const;
+
+    // The tolerance used to merge vertices.
+    double tolerance() const;
+
+  private:
+    struct edge_t {
+        int64_t u;    // Vertex indices.
+        int64_t v;
+        bool A_left;  // Membership of the regions to the left and right of u->v.
+        bool A_right;
+        bool B_left;
+        bool B_right;
+    };
+
+    std::vector<polygon_overlay_point> verts;
+    std::vector<edge_t> edges;
+    double eps = 0.0;
+};
+
+// Converts a region with holes into a single ring by connecting each hole to the outer boundary with a seam (a pair
+// of coincident, oppositely-directed edges). The outer orientation is preserved.
+polygon_overlay_ring
+Bridge_Holes(const polygon_overlay_region &region);
+
@@ -2,13 +2,19 @@
 
 #include "Regex_Selectors.h"
 
+#include <cctype>
 #include <string>
 #include <list>
 #include <initializer_list>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <optional>
+#include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include "YgorString.h"
 #include "YgorMath.h"
@@ -17,184 +23,217 @@
 
 // ------------------------------------- Templates -------------------------------------
 
-// Whitelist image arrays or point clouds using a limited vocabulary of specifiers.
-// 
-// Note: Positional specifiers (e.g., "first") act on the current whitelist. 
-//       Beware when chaining filters!
-template <class L> // L is a list of list::iterators of shared_ptr<Image_Array or Point_Cloud>.
-L
-Whitelist_Core( L lops,
-           const std::string& Specifier,
-           Regex_Selector_Opts Opts ){
+namespace {
+
+// A specifier parsed into its component parts. Parsing relies on several regexes, so parsed specifiers are cached.
+struct parsed_specifier {
+    enum class kind {
+        multi,      // Several specifiers separated by ';', applied in order.
+        key_value,  // "key@value".
+        none,
+        all,
+        nth,        // "first", "second", or "third".
+        last,
+        pnum,       // "#N".
+        nnum,       // "#-N".
+    } k = kind::none;
+
+    bool inverted = false;
+    size_t N = 0; // One-based for 'nth', zero-based for 'pnum' and 'nnum'.
+    std::vector<std::string> parts; // Sub-specifiers for 'multi', or the key and value regex for 'key_value'.
+};
+
+parsed_specifier
+Parse_Specifier(const std::string &Specifier){
+    parsed_specifier out;
 
     // Multiple key-value specifications stringified together.
     // For example, "key1@value1;key2@value2".
     do{
-        const auto regex_split = Compile_Regex("^.*;.*$");
+        static const auto regex_split = Compile_Regex("^.*;.*$");
         if(!std::regex_match(Specifier, regex_split)) break; // Not a multi-key@value statement.
 
         auto v_kvs = SplitStringToVector(Specifier, ';', 'd');
         if(v_kvs.size() <= 1) throw std::logic_error("Unable to separate multiple key@value specifiers");
 
-        for(auto & keyvalue : v_kvs){
-            lops = Whitelist(lops, keyvalue, Opts);
-        }
-        return lops;
+        out.k = parsed_specifier::kind::multi;
+        out.parts = std::move(v_kvs);
+        return out;
     }while(false);
 
     // A single key-value specifications stringified together.
     // For example, "key@value".
     do{
-        const auto regex_split = Compile_Regex("^.*@.*$");
+        static const auto regex_split = Compile_Regex("^.*@.*$");
         if(!std::regex_match(Specifier, regex_split)) break; // Not a key@value statement.
         
         auto v_k_v = SplitStringToVector(Specifier, '@', 'd');
         if(v_k_v.size() <= 1) throw std::logic_error("Unable to separate key@value specifier");
         if(v_k_v.size() != 2) break; // Not a key@value statement (hint: maybe multiple @'s present?).
 
-        lops = Whitelist(lops, v_k_v.front(), v_k_v.back(), Opts);
-        return lops;
+        out.k = parsed_specifier::kind::key_value;
+        out.parts = std::move(v_k_v);
+        return out;
     }while(false);
 
     // Single-word positional specifiers, i.e. "all", "none", "first", "last", or zero-based 
     // numerical specifiers, e.g., "#0" (front), "#1" (second), "#-0" (last), and "#-1" (second-from-last).
-    do{
-        const auto regex_none  = Compile_Regex("^no?n?e?$");
-        const auto regex_all   = Compile_Regex("^al?l?$");
-        const auto regex_1st   = Compile_Regex("^fi?r?s?t?$");
-        const auto regex_2nd   = Compile_Regex("^se?c?o?n?d?$");
-        const auto regex_3rd   = Compile_Regex("^th?i?r?d?$");
-        const auto regex_last  = Compile_Regex("^la?s?t?$");
-        const auto regex_pnum  = Compile_Regex("^[#][0-9].*$");
-        const auto regex_nnum  = Compile_Regex("^[#]-[0-9].*$");
-
-        const auto regex_i_none  = Compile_Regex("^[!]no?n?e?$"); // Inverted variants of the above.
-        const auto regex_i_all   = Compile_Regex("^[!]al?l?$");
-        const auto regex_i_1st   = Compile_Regex("^[!]fi?r?s?t?$");
-        const auto regex_i_2nd   = Compile_Regex("^[!]se?c?o?n?d?$");
-        const auto regex_i_3rd   = Compile_Regex("^[!]th?i?r?d?$");
-        const auto regex_i_last  = Compile_Regex("^[!]la?s?t?$");
-        const auto regex_i_pnum  = Compile_Regex("^[!][#][0-9].*$");
-        const auto regex_i_nnum  = Compile_Regex("^[!][#]-[0-9].*$");
-        
-        if(std::regex_match(Specifier, regex_i_none)){
-            return lops;
-        }
-        if(std::regex_match(Specifier, regex_none)){
-            lops.clear();
-            return lops;
-        }
+    // Each can be inverted by prefixing with a '!'.
+    std::string word = Specifier;
+    if(!word.empty() && (word.front() == '!')){
+        out.inverted = true;
+        word.erase(0, 1);
+    }
 
-        if(std::regex_match(Specifier, regex_i_all)){
-            lops.clear();
-            return lops;
-        }
-        if(std::regex_match(Specifier, regex_all)){
-            return lops;
-        }
+    static const auto regex_none  = Compile_Regex("^no?n?e?$");
+    static const auto regex_all   = Compile_Regex("^al?l?$");
+    static const auto regex_1st   = Compile_Regex("^fi?r?s?t?$");
+    static const auto regex_2nd   = Compile_Regex("^se?c?o?n?d?$");
+    static const auto regex_3rd   = Compile_Regex("^th?i?r?d?$");
+    static const auto regex_last  = Compile_Regex("^la?s?t?$");
+    static const auto regex_pnum  = Compile_Regex("^[#][0-9].*$");
+    static const auto regex_nnum  = Compile_Regex("^[#]-[0-9].*$");
+    static const auto pnum_extractor = std::regex("^[#]([0-9]*).*$", std::regex::icase |
+                                                                     std::regex::optimize |
+                                                                     std::regex::extended);
+    static const auto nnum_extractor = std::regex("^[#]-([0-9]*).*$", std::regex::icase |
+                                                                      std::regex::optimize |
+                                                                      std::regex::extended);
+
+    if(std::regex_match(word, regex_none)){
+        out.k = parsed_specifier::kind::none;
+    }else if(std::regex_match(word, regex_all)){
+        out.k = parsed_specifier::kind::all;
+    }else if(std::regex_match(word, regex_1st)){
+        out.k = parsed_specifier::kind::nth;
+        out.N = 1;
+    }else if(std::regex_match(word, regex_2nd)){
+        out.k = parsed_specifier::kind::nth;
+        out.N = 2;
+    }else if(std::regex_match(word, regex_3rd)){
+        out.k = parsed_specifier::kind::nth;
+        out.N = 3;
+    }else if(std::regex_match(word, regex_last)){
+        out.k = parsed_specifier::kind::last;
+    }else if(std::regex_match(word, regex_pnum)){
+        out.k = parsed_specifier::kind::pnum;
+        out.N = std::stoul(GetFirstRegex(word, pnum_extractor));
+    }else if(std::regex_match(word, regex_nnum)){
+        out.k = parsed_specifier::kind::nnum;
+        out.N = std::stoul(GetFirstRegex(word, nnum_extractor));
+    }else{
+        throw std::invalid_argument("Selection is not valid. Cannot continue.");
+    }
+    return out;
+}
 
-        if( std::regex_match(Specifier, regex_i_1st)
-        ||  std::regex_match(Specifier, regex_i_2nd) 
-        ||  std::regex_match(Specifier, regex_i_3rd)  ){
-            size_t N = 0; // Target.
-            if( std::regex_match(Specifier, regex_i_1st) ){ N = 1;
-            }else if( std::regex_match(Specifier, regex_i_2nd) ){ N = 2;
-            }else if( std::regex_match(Specifier, regex_i_3rd) ){ N = 3;
-            }else{
-                throw std::logic_error("Regex positional specifier not understood. Cannot continue.");
-            }
+// Returns the parsed specifier, parsing it only on first use. Invalid specifiers are not cached.
+std::shared_ptr<const parsed_specifier>
+Get_Parsed_Specifier(const std::string &Specifier){
+    static std::mutex m;
+    static std::map<std::string, std::shared_ptr<const parsed_specifier>> cache;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        const auto it = cache.find(Specifier);
+        if(it != std::end(cache)) return it->second;
+    }
+    auto parsed = std::make_shared<const parsed_specifier>( Parse_Specifier(Specifier) );
 
-            decltype(lops) out;
-            size_t i = 1;
-            for(const auto &l : lops) if(N != i++) out.emplace_back(l);
-            return out;
-        }
+    std::lock_guard<std::mutex> lock(m);
+    if(4096 <= cache.size()) cache.clear(); // Guard against unbounded growth from generated specifiers.
+    return cache.emplace(Specifier, std::move(parsed)).first->second;
+}
 
-        if( std::regex_match(Specifier, regex_1st)
-        ||  std::regex_match(Specifier, regex_2nd) 
-        ||  std::regex_match(Specifier, regex_3rd)  ){
-            size_t N = 0; // Target.
-            if( std::regex_match(Specifier, regex_1st) ){ N = 1;
-            }else if( std::regex_match(Specifier, regex_2nd) ){ N = 2;
-            }else if( std::regex_match(Specifier, regex_3rd) ){ N = 3;
-            }else{
-                throw std::logic_error("Regex positional specifier not understood. Cannot continue.");
-            }
+} // namespace
 
-            decltype(lops) out;
-            size_t i = 1;
-            for(const auto &l : lops) if(N == i++) out.emplace_back(l);
-            return out;
-        }
+// Whitelist image arrays or point clouds using a limited vocabulary of specifiers.
+// 
+// Note: Positional specifiers (e.g., "first") act on the current whitelist. 
+//       Beware when chaining filters!
+template <class L> // L is a list of list::iterators of shared_ptr<Image_Array or Point_Cloud>.
+L
+Whitelist_Core( L lops,
+           const std::string& Specifier,
+           Regex_Selector_Opts Opts ){
+
+    const auto spec_ptr = Get_Parsed_Specifier(Specifier);
+    const auto &spec = *spec_ptr;
+    const auto N = spec.N;
 
-        if(std::regex_match(Specifier, regex_i_last)){
-            if(!lops.empty()) lops.pop_back();
+    switch(spec.k){
+        case parsed_specifier::kind::multi:
+            for(const auto & keyvalue : spec.parts){
+                lops = Whitelist(lops, keyvalue, Opts);
+            }
             return lops;
-        }
-        if(std::regex_match(Specifier, regex_last)){
-            decltype(lops) out;
-            if(!lops.empty()) out.emplace_back(lops.back());
-            return out;
-        }
 
-        if(std::regex_match(Specifier, regex_i_pnum)){
-            auto pnum_extractor = std::regex("^[!][#]([0-9]*).*$", std::regex::icase |
-                                                                   std::regex::optimize |
-                                                                   std::regex::extended);
-            auto N = std::stoul(GetFirstRegex(Specifier, pnum_extractor));
+        case parsed_specifier::kind::key_value:
+            return Whitelist(lops, spec.parts.front(), spec.parts.back(), Opts);
 
-            if(N < lops.size()){
-                auto l_it = std::next( lops.begin(), N );
-                lops.erase( l_it );
-            }
+        case parsed_specifier::kind::none:
+            if(!spec.inverted) lops.clear();
             return lops;
-        }
-        if(std::regex_match(Specifier, regex_pnum)){
-            auto pnum_extractor = std::regex("^[#]([0-9]*).*$", std::regex::icase |
-                                                                std::regex::optimize |
-                                                                std::regex::extended);
-            auto N = std::stoul(GetFirstRegex(Specifier, pnum_extractor));
-
-            decltype(lops) out;
-            if(N < lops.size()){
-                auto l_it = std::next( lops.begin(), N );
-                out.emplace_back(*l_it);
-            }
-            return out;
-        }
 
-        if(std::regex_match(Specifier, regex_i_nnum)){
-            auto nnum_extractor = std::regex("^[!][#]-([0-9]*).*$", std::regex::icase |
-                                                                    std::regex::optimize |
-                                                                    std::regex::extended);
-            auto N = std::stoul(GetFirstRegex(Specifier, nnum_extractor));
+        case parsed_specifier::kind::all:
+            if(spec.inverted) lops.clear();
+            return lops;
 
-            if(N < lops.size()) return lops;
+        case parsed_specifier::kind::nth:
+            {
+                decltype(lops) out;
+                size_t i = 1;
+                for(const auto &l : lops) if((N == i++) != spec.inverted) out.emplace_back(l);
+                return out;
+            }
 
-            // Note: this one is slightly harder than the rest because you cannot directly erase() a reverse iterator.
-            decltype(lops) out;
-            size_t i = lops.size();
-            for(auto l_it = lops.begin(); l_it != lops.end(); ++l_it, --i){
-                if(i == N) continue;
-                out.emplace_back(*l_it);
+        case parsed_specifier::kind::last:
+            if(spec.inverted){
+                if(!lops.empty()) lops.pop_back();
+                return lops;
+            }else{
+                decltype(lops) out;
+                if(!lops.empty()) out.emplace_back(lops.back());
+                return out;
             }
-            return out;
-        }
-        if(std::regex_match(Specifier, regex_nnum)){
-            auto nnum_extractor = std::regex("^[#]-([0-9]*).*$", std::regex::icase |
-                                                                 std::regex::optimize |
-                                                                 std::regex::extended);
-            auto N = std::stoul(GetFirstRegex(Specifier, nnum_extractor));
-
-            decltype(lops) out;
-            if(N < lops.size()){
-                auto l_it = std::next( lops.rbegin(), N );
-                out.emplace_back(*l_it);
+
+        case parsed_specifier::kind::pnum:
+            if(spec.inverted){
+                if(N < lops.size()){
+                    auto l_it = std::next( lops.begin(), N );
+                    lops.erase( l_it );
+                }
+                return lops;
+            }else{
+                decltype(lops) out;
+                if(N < lops.size()){
+                    auto l_it = std::next( lops.begin(), N );
+                    out.emplace_back(*l_it);
+                }
+                return out;
             }
-            return out;
-        }
 
-    }while(false);
+        case parsed_specifier::kind::nnum:
+            if(spec.inverted){
+                if(N < lops.size()) return lops;
+
+                // Note: this one is slightly harder than the rest because you cannot directly erase() a reverse
+                // iterator.
+                decltype(lops) out;
+                size_t i = lops.size();
+                for(auto l_it = lops.begin(); l_it != lops.end(); ++l_it, --i){
+                    if(i == N) continue;
+                    out.emplace_back(*l_it);
+                }
+                return out;
+            }else{
+                decltype(lops) out;
+                if(N < lops.size()){
+                    auto l_it = std::next( lops.rbegin(), N );
+                    out.emplace_back(*l_it);
+                }
+                return out;
+            }
+    }
 
     throw std::invalid_argument("Selection is not valid. Cannot continue.");
     decltype(lops) out;
@@ -219,14 +258,155 @@ Whitelist_Core( L lops,
 // --------------------------------------- Misc. ---------------------------------------
 
 // Compile and return a regex using the application-wide default settings.
+//
+// Compiled regexes are cached, since compilation is costly and the same patterns are compiled repeatedly (e.g., by each
+// operation invoked in a loop). Copies share the compiled automaton, so returning a copy is cheap.
 std::regex
 Compile_Regex(const std::string& input){
-    return std::regex(input, std::regex::icase | 
-                             std::regex::nosubs |
-                             std::regex::optimize |
-                             std::regex::extended);
+    static std::mutex m;
+    static std::map<std::string, std::regex> cache;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        const auto it = cache.find(input);
+        if(it != std::end(cache)) return it->second;
+    }
+    auto compiled = std::regex(input, std::regex::icase | 
+                                      std::regex::nosubs |
+                                      std::regex::optimize |
+                                      std::regex::extended);
+
+    std::lock_guard<std::mutex> lock(m);
+    if(4096 <= cache.size()) cache.clear(); // Guard against unbounded growth from generated patterns.
+    return cache.emplace(input, std::move(compiled)).first->second;
+}
+
+struct regex_value_matcher::compiled_t {
+    enum class strategy {
+        everything,   // '.*', which matches any value without NUL characters.
+        literal,      // A literal, compared case-insensitively.
+        prefix,       // A literal followed by '.*'.
+        regex,
+    } how = strategy::regex;
+
+    std::string literal;
+    std::regex theregex;
+};
+
+namespace {
+
+bool Is_Plain_Literal(const std::string &x){
+    // Only ASCII characters without special meaning in extended POSIX syntax are considered, so that case-insensitive
+    // comparison is unambiguous.
+    for(const auto c : x){
+        const auto u = static_cast<unsigned char>(c);
+        if( (u < 0x20) || (0x7F <= u) ) return false;
+        if(std::string("^$.[]()|*+?{}\\").find(c) != std::string::npos) return false;
+    }
+    return true;
+}
+
+bool Equals_Ignoring_Case(const char *a, const char *b, size_t n){
+    for(size_t i = 0; i < n; ++i){
+        const auto u_a = static_cast<unsigned char>(a[i]);
+        const auto u_b = static_cast<unsigned char>(b[i]);
+        if( (u_a == u_b)
+        ||  ( (u_a < 0x80) && (u_b < 0x80) && (std::tolower(u_a) == std::tolower(u_b)) ) ) continue;
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const regex_value_matcher::compiled_t>
+Compile_Value_Matcher(const std::string &pattern){
+    static std::mutex m;
+    static std::map<std::string, std::shared_ptr<const regex_value_matcher::compiled_t>> cache;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        const auto it = cache.find(pattern);
+        if(it != std::end(cache)) return it->second;
+    }
+
+    using strategy = regex_value_matcher::compiled_t::strategy;
+    auto c = std::make_shared<regex_value_matcher::compiled_t>();
+
+    // Anchors are implied when matching the whole value.
+    std::string body = pattern;
+    if(!body.empty() && (body.front() == '^')) body.erase(0, 1);
+    if(!body.empty() && (body.back() == '$')) body.pop_back();
+
+    const std::string any = ".*";
+    const bool has_any_suffix = (any.size() <= body.size())
+                             && (body.compare(body.size() - any.size(), any.size(), any) == 0);
+    if(has_any_suffix && Is_Plain_Literal(body.substr(0, body.size() - any.size()))){
+        c->literal = body.substr(0, body.size() - any.size());
+        c->how = c->literal.empty() ? strategy::everything : strategy::prefix;
+    }else if(Is_Plain_Literal(body)){
+        c->literal = body;
+        c->how = strategy::literal;
+    }else{
+        c->theregex = Compile_Regex(pattern);
+        c->how = strategy::regex;
+    }
+
+    std::lock_guard<std::mutex> lock(m);
+    if(4096 <= cache.size()) cache.clear();
+    return cache.emplace(pattern, std::move(c)).first->second;
+}
+
+} // namespace
+
+regex_value_matcher::regex_value_matcher(const std::string &pattern) : compiled(Compile_Value_Matcher(pattern)) {}
+
+bool regex_value_matcher::operator()(const std::string &value) const {
+    using strategy = compiled_t::strategy;
+    const auto &c = *(this->compiled);
+    const auto &l = c.literal;
+    switch(c.how){
+        case strategy::everything:
+            return (value.find('\0') == std::string::npos);
+        case strategy::literal:
+            return (value.size() == l.size())
+                && Equals_Ignoring_Case(value.data(), l.data(), l.size());
+        case strategy::prefix:
+            return (l.size() <= value.size())
+                && Equals_Ignoring_Case(value.data(), l.data(), l.size())
+                && (value.find('\0', l.size()) == std::string::npos);
+        case strategy::regex:
+            break;
+    }
+    return std::regex_match(value, c.theregex);
+}
+
+bool regex_value_matcher::uses_regex_engine() const {
+    return (this->compiled->how == compiled_t::strategy::regex);
 }
 
+namespace {
+
+// Evaluates the regex at most once per distinct value, since many objects typically share a handful of values (e.g.,
+// every image in a series has the same Modality). Not thread-safe.
+class memoized_value_matcher {
+  public:
+    explicit memoized_value_matcher(const std::string &pattern) : matcher(pattern),
+                                                                   memoize(matcher.uses_regex_engine()) {}
+
+    bool operator()(const std::string &value){
+        if(!this->memoize) return this->matcher(value);
+        const auto it = this->memo.find(value);
+        if(it != std::end(this->memo)) return it->second;
+        const auto res = this->matcher(value);
+        this->memo.emplace(value, res);
+        return res;
+    }
+
+  private:
+    regex_value_matcher matcher;
+    bool memoize;
+    std::map<std::string, bool> memo;
+};
+
+} // namespace
+
 // Human-readable information about how selectors can be specified.
 static
 std::string
@@ -272,7 +452,7 @@ Whitelist( std::list<std::reference_wrapper<contour_collection<double>>> ccs,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
+    memoized_value_matcher matches(MetadataValueRegex);
 
     ccs.remove_if([&](std::reference_wrapper<contour_collection<double>> cc) -> bool {
         if(cc.get().contours.empty()) return true; // Remove collections containing no contours.
@@ -280,34 +460,35 @@ Whitelist( std::list<std::reference_wrapper<contour_collection<double>>> ccs,
         if(Opts.validation == Regex_Selector_Opts::Validation::Representative){
             auto ValueOpt = cc.get().contours.front().GetMetadataValueAs<std::string>(MetadataKey);
             if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
+                return !(matches(ValueOpt.value()));
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                 return false;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                 return true;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
+                return !(matches(""));
             }
             throw std::logic_error("Regex selector representative->NAs option not understood. Cannot continue.");
 
         }else if(Opts.validation == Regex_Selector_Opts::Validation::Pedantic){
-            const auto Values = cc.get().get_distinct_values_for_key(MetadataKey);
+            // Every value must match. Values are checked in place, rather than first collecting the distinct values.
+            bool found = false;
+            for(const auto & c : cc.get().contours){
+                const auto m_it = c.metadata.find(MetadataKey);
+                if(m_it == std::end(c.metadata)) continue;
+                found = true;
+                if( !matches(m_it->second) ) return true;
+            }
 
-            if(Values.empty()){
+            if(!found){
                 if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                     return false;
                 }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                     return true;
                 }
                 throw std::logic_error("Regex selector pedantic->NAs option not understood. Cannot continue.");
-
-            }else{
-                for(const auto & Value : Values){
-                    if( !std::regex_match(Value,theregex) ) return true;
-                }
-                return false;
             }
-            throw std::logic_error("Regex selector pedantic option not understood. Cannot continue.");
+            return false;
 
         }
         throw std::logic_error("Regex selector option not understood. Cannot continue.");
@@ -402,7 +583,7 @@ Whitelist( std::list<std::list<std::shared_ptr<Image_Array>>::iterator> ias,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
+    memoized_value_matcher matches(MetadataValueRegex);
 
     ias.remove_if([&](std::list<std::shared_ptr<Image_Array>>::iterator iap_it) -> bool {
         if((*iap_it) == nullptr) return true;
@@ -411,34 +592,35 @@ Whitelist( std::list<std::list<std::shared_ptr<Image_Array>>::iterator> ias,
         if(Opts.validation == Regex_Selector_Opts::Validation::Representative){
             auto ValueOpt = (*iap_it)->imagecoll.images.front().GetMetadataValueAs<std::string>(MetadataKey);
             if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
+                return !(matches(ValueOpt.value()));
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                 return false;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                 return true;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
+                return !(matches(""));
             }
             throw std::logic_error("Regex selector representative->NAs option not understood. Cannot continue.");
 
         }else if(Opts.validation == Regex_Selector_Opts::Validation::Pedantic){
-            const auto Values = (*iap_it)->imagecoll.get_distinct_values_for_key(MetadataKey);
+            // Every value must match. Values are checked in place, rather than first collecting the distinct values.
+            bool found = false;
+            for(const auto & img : (*iap_it)->imagecoll.images){
+                const auto m_it = img.metadata.find(MetadataKey);
+                if(m_it == std::end(img.metadata)) continue;
+                found = true;
+                if( !matches(m_it->second) ) return true;
+            }
 
-            if(Values.empty()){
+            if(!found){
                 if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                     return false;
                 }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                     return true;
                 }
                 throw std::logic_error("Regex selector pedantic->NAs option not understood. Cannot continue.");
-
-            }else{
-                for(const auto & Value : Values){
-                    if( !std::regex_match(Value,theregex) ) return true;
-                }
-                return false;
             }
-            throw std::logic_error("Regex selector pedantic option not understood. Cannot continue.");
+            return false;
 
         }
         throw std::logic_error("Regex selector option not understood. Cannot continue.");
@@ -512,7 +694,7 @@ Whitelist( std::list<std::list<std::shared_ptr<Point_Cloud>>::iterator> pcs,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
+    memoized_value_matcher matches(MetadataValueRegex);
 
     pcs.remove_if([&](std::list<std::shared_ptr<Point_Cloud>>::iterator pcp_it) -> bool {
         if((*pcp_it) == nullptr) return true;
@@ -525,13 +707,13 @@ Whitelist( std::list<std::list<std::shared_ptr<Point_Cloud>>::iterator> pcs,
 
             auto ValueOpt = (*pcp_it)->pset.GetMetadataValueAs<std::string>(MetadataKey);
             if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
+                return !(matches(ValueOpt.value()));
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                 return false;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                 return true;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
+                return !(matches(""));
             }
             throw std::logic_error("NAs option not understood. Cannot continue.");
         }
@@ -611,7 +793,7 @@ Whitelist( std::list<std::list<std::shared_ptr<Surface_Mesh>>::iterator> sms,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
+    memoized_value_matcher matches(MetadataValueRegex);
 
     sms.remove_if([&](std::list<std::shared_ptr<Surface_Mesh>>::iterator smp_it) -> bool {
         if((*smp_it) == nullptr) return true;
@@ -630,13 +812,13 @@ Whitelist( std::list<std::list<std::shared_ptr<Surface_Mesh>>::iterator> sms,
                       (*smp_it)->meshes.metadata[MetadataKey] :
                       std::optional<std::string>();
             if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
+                return !(matches(ValueOpt.value()));
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                 return false;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                 return true;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
+                return !(matches(""));
             }
             throw std::logic_error("NAs option not understood. Cannot continue.");
         }
@@ -716,7 +898,7 @@ Whitelist( std::list<std::list<std::shared_ptr<TPlan_Config>>::iterator> tps,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
+    memoized_value_matcher matches(MetadataValueRegex);
 
     tps.remove_if([&](std::list<std::shared_ptr<TPlan_Config>>::iterator tpp_it) -> bool {
         if((*tpp_it) == nullptr) return true;
@@ -736,13 +918,13 @@ Whitelist( std::list<std::list<std::shared_ptr<TPlan_Config>>::iterator> tps,
             // TODO: support selection of Dynamic_Machine_State and Static_Machine_State metadata too.
 
             if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
+                return !(matches(ValueOpt.value()));
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                 return false;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                 return true;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
+                return !(matches(""));
             }
             throw std::logic_error("NAs option not understood. Cannot continue.");
         }
@@ -821,7 +1003,7 @@ Whitelist( std::list<std::list<std::shared_ptr<Line_Sample>>::iterator> lss,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
+    memoized_value_matcher matches(MetadataValueRegex);
 
     lss.remove_if([&](std::list<std::shared_ptr<Line_Sample>>::iterator lsp_it) -> bool {
         if((*lsp_it) == nullptr) return true;
@@ -837,13 +1019,13 @@ Whitelist( std::list<std::list<std::shared_ptr<Line_Sample>>::iterator> lss,
                       (*lsp_it)->line.metadata[MetadataKey] :
                       std::optional<std::string>();
             if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
+                return !(matches(ValueOpt.value()));
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                 return false;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                 return true;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
+                return !(matches(""));
             }
             throw std::logic_error("NAs option not understood. Cannot continue.");
         }
@@ -920,7 +1102,7 @@ Whitelist( std::list<std::list<std::shared_ptr<Transform3>>::iterator> t3s,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
+    memoized_value_matcher matches(MetadataValueRegex);
 
     t3s.remove_if([&](std::list<std::shared_ptr<Transform3>>::iterator t3p_it) -> bool {
         if((*t3p_it) == nullptr) return true;
@@ -934,13 +1116,13 @@ Whitelist( std::list<std::list<std::shared_ptr<Transform3>>::iterator> t3s,
                       (*t3p_it)->metadata[MetadataKey] :
                       std::optional<std::string>();
             if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
+                return !(matches(ValueOpt.value()));
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
                 return false;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
                 return true;
             }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
+                return !(matches(""));
             }
             throw std::logic_error("NAs option not understood. Cannot continue.");
         }
@@ -6,6 +6,7 @@
 #include <list>
 #include <initializer_list>
 #include <functional>
+#include <memory>
 #include <regex>
 
 #include "YgorString.h"
@@ -38,10 +39,28 @@ struct Regex_Selector_Opts {
 
 // --------------------------------------- Misc. ---------------------------------------
 
-// Compile and return a regex using the application-wide default settings.
+// Compile and return a regex using the application-wide default settings. Compiled regexes are cached.
 std::regex
 Compile_Regex(const std::string& input);
 
+// Matches whole values against a regex, as std::regex_match() would with Compile_Regex(). Patterns are compiled once
+// per process, and patterns that are literals, literal prefixes followed by '.*', or '.*' alone are matched without the
+// regex engine.
+class regex_value_matcher {
+  public:
+    explicit regex_value_matcher(const std::string &pattern);
+
+    bool operator()(const std::string &value) const;
+
+    // Whether values are matched using the regex engine, rather than directly.
+    bool uses_regex_engine() const;
+
+    struct compiled_t;
+
+  private:
+    std::shared_ptr<const compiled_t> compiled;
+};
+
 
 // ---------------------------------- Contours / ROIs ----------------------------------
 
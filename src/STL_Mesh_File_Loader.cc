@@ -22,6 +22,8 @@
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorString.h"       //Needed for SplitStringToVector, Canonicalize_String2, SplitVector functions.
 
+#include "STL_Mesh_IO.h"
+
 
 bool Load_Mesh_From_STL_Files( Drover &DICOM_data,
                                std::map<std::string,std::string> & /* InvocationMetadata */,
@@ -38,9 +40,10 @@ bool Load_Mesh_From_STL_Files( Drover &DICOM_data,
     //
     if(Filenames.empty()) return true;
 
-    // Attempt to read as an ASCII file first.
+    // Attempt to read as a well-formed binary file first, and then as an ASCII file.
     //
-    // It is easier to reject non-matching files this way since the file syntax will rapidly fail to parse.
+    // Well-formed binary files are identified by their size, so other files are rejected without being parsed. It is
+    // also easy to reject non-matching files as ASCII since the file syntax will rapidly fail to parse.
     {
         size_t i = 0;
         const size_t N = Filenames.size();
@@ -56,11 +59,14 @@ bool Load_Mesh_From_STL_Files( Drover &DICOM_data,
             try{
                 //////////////////////////////////////////////////////////////
                 // Attempt to load the file.
-                std::ifstream FI(Filename.c_str(), std::ios::in);
-                if(!ReadFVSMeshFromASCIISTL(DICOM_data.smesh_data.back()->meshes, FI)){
-                    throw std::runtime_error("Unable to read mesh from file.");
+                auto &mesh = DICOM_data.smesh_data.back()->meshes;
+                if(!Read_FV_Surface_Mesh_From_Binary_STL(Filename, mesh)){
+                    std::ifstream FI(Filename.c_str(), std::ios::in);
+                    if(!ReadFVSMeshFromASCIISTL(mesh, FI)){
+                        throw std::runtime_error("Unable to read mesh from file.");
+                    }
+                    FI.close();
                 }
-                FI.close();
                 //////////////////////////////////////////////////////////////
 
                 // Reject the file if the mesh is not valid.
@@ -86,7 +92,7 @@ bool Load_Mesh_From_STL_Files( Drover &DICOM_data,
         }
     }
 
-    // Attempt to read as a binary file.
+    // Attempt to read any remaining files with the general binary reader.
     {
         size_t i = 0;
         const size_t N = Filenames.size();
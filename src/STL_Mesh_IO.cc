@@ -0,0 +1,224 @@
+//STL_Mesh_IO.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+
+#include "Text_Parsing.h"
+#include "Thread_Pool.h"
+
+#include "STL_Mesh_IO.h"
+
+
+namespace {
+
+// Binary STL layout: an 80 byte header, a 32-bit facet count, then 50 bytes per facet (a normal and three vertices as
+// single-precision floats, and a 16-bit attribute). All values are little-endian.
+const size_t header_bytes = 84;
+const size_t facet_bytes = 50;
+
+uint32_t Read_LE32(const char *p){
+    const auto *u = reinterpret_cast<const unsigned char *>(p);
+    return  static_cast<uint32_t>(u[0])
+         | (static_cast<uint32_t>(u[1]) << 8)
+         | (static_cast<uint32_t>(u[2]) << 16)
+         | (static_cast<uint32_t>(u[3]) << 24);
+}
+
+void Write_LE32(char *p, uint32_t x){
+    auto *u = reinterpret_cast<unsigned char *>(p);
+    u[0] = static_cast<unsigned char>(x & 0xFF);
+    u[1] = static_cast<unsigned char>((x >> 8) & 0xFF);
+    u[2] = static_cast<unsigned char>((x >> 16) & 0xFF);
+    u[3] = static_cast<unsigned char>((x >> 24) & 0xFF);
+    return;
+}
+
+float Bits_To_Float(uint32_t x){
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+uint32_t Float_To_Bits(float f){
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    return x;
+}
+
+using vert_key_t = std::array<uint32_t, 3>;
+
+struct vert_key_hash {
+    size_t operator()(const vert_key_t &k) const {
+        uint64_t h = (static_cast<uint64_t>(k[0]) << 32) ^ static_cast<uint64_t>(k[1]);
+        h ^= static_cast<uint64_t>(k[2]) * 0x9E3779B97F4A7C15ULL;
+        // Finalizer from splitmix64, so the low bits (used for sharding) depend on every coordinate bit.
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        return static_cast<size_t>(h ^ (h >> 31));
+    }
+};
+
+} // namespace
+
+
+bool Read_FV_Surface_Mesh_From_Binary_STL(const std::string &filename, fv_surface_mesh<double, uint64_t> &mesh){
+    const mapped_text_file FI(filename);
+    const char *b = FI.begin();
+    if(FI.size() < header_bytes) return false;
+
+    const auto N_facets = static_cast<uint64_t>(Read_LE32(b + 80));
+    if( (N_facets == 0)
+    ||  (FI.size() != (header_bytes + facet_bytes * N_facets)) ) return false;
+
+    // Each facet contributes three vertex occurrences, which are identified by their stored bit patterns.
+    const uint64_t N_occ = 3 * N_facets;
+    const auto key_of = [b](uint64_t i) -> vert_key_t {
+        const char *p = b + header_bytes + facet_bytes * (i / 3) + 12 + 12 * (i % 3);
+        vert_key_t k = {{ Read_LE32(p), Read_LE32(p + 4), Read_LE32(p + 8) }};
+        for(auto &x : k) if(x == 0x80000000U) x = 0; // Weld -0 with +0.
+        return k;
+    };
+
+    // Occurrences are distributed over shards by hash, preserving their relative order, so each shard can be welded
+    // independently.
+    const long int N_shards = 64;
+    const uint64_t chunk_occ = 3 * 64 * 1024;
+    const auto N_chunks = static_cast<long int>((N_occ + chunk_occ - 1) / chunk_occ);
+    const vert_key_hash hasher;
+
+    std::vector<uint64_t> counts(static_cast<size_t>(N_chunks * N_shards), 0); // Becomes offsets.
+    parallel_for(0, N_chunks, [&](long int c) -> void {
+        const uint64_t e = std::min<uint64_t>(N_occ, (c + 1) * chunk_occ);
+        for(uint64_t i = c * chunk_occ; i < e; ++i){
+            ++counts[c * N_shards + static_cast<long int>(hasher(key_of(i)) % N_shards)];
+        }
+    }, 1);
+
+    std::vector<uint64_t> shard_begin(N_shards + 1, 0);
+    {
+        uint64_t offset = 0;
+        for(long int s = 0; s < N_shards; ++s){
+            shard_begin[s] = offset;
+            for(long int c = 0; c < N_chunks; ++c){
+                const auto n = counts[c * N_shards + s];
+                counts[c * N_shards + s] = offset;
+                offset += n;
+            }
+        }
+        shard_begin[N_shards] = offset;
+    }
+
+    std::vector<uint64_t> by_shard(N_occ);
+    parallel_for(0, N_chunks, [&](long int c) -> void {
+        const uint64_t e = std::min<uint64_t>(N_occ, (c + 1) * chunk_occ);
+        for(uint64_t i = c * chunk_occ; i < e; ++i){
+            by_shard[ counts[c * N_shards + static_cast<long int>(hasher(key_of(i)) % N_shards)]++ ] = i;
+        }
+    }, 1);
+
+    // Map every occurrence to the first occurrence of the same position.
+    std::vector<uint64_t> rep(N_occ);
+    parallel_for(0, N_shards, [&](long int s) -> void {
+        std::unordered_map<vert_key_t, uint64_t, vert_key_hash> first;
+        first.reserve(static_cast<size_t>(shard_begin[s + 1] - shard_begin[s]) / 4);
+        for(uint64_t j = shard_begin[s]; j < shard_begin[s + 1]; ++j){
+            const auto i = by_shard[j];
+            rep[i] = first.emplace(key_of(i), i).first->second;
+        }
+    }, 1);
+    by_shard.clear();
+    by_shard.shrink_to_fit();
+
+    // Number the welded vertices in order of first appearance.
+    std::vector<uint64_t> vert_index(N_occ);
+    uint64_t N_verts = 0;
+    for(uint64_t i = 0; i < N_occ; ++i){
+        if(rep[i] == i) vert_index[i] = N_verts++;
+    }
+
+    fv_surface_mesh<double, uint64_t> out;
+    out.vertices.resize(N_verts);
+    out.faces.resize(N_facets);
+    parallel_for(0, static_cast<long int>(N_facets), [&](long int f) -> void {
+        auto &face = out.faces[f];
+        face.resize(3);
+        for(uint64_t j = 0; j < 3; ++j){
+            const uint64_t i = 3 * static_cast<uint64_t>(f) + j;
+            face[j] = vert_index[rep[i]];
+            if(rep[i] == i){
+                const auto k = key_of(i);
+                out.vertices[vert_index[i]] = vec3<double>( static_cast<double>(Bits_To_Float(k[0])),
+                                                            static_cast<double>(Bits_To_Float(k[1])),
+                                                            static_cast<double>(Bits_To_Float(k[2])) );
+            }
+        }
+    });
+
+    mesh = std::move(out);
+    return true;
+}
+
+
+bool Write_FV_Surface_Mesh_To_Binary_STL(const fv_surface_mesh<double, uint64_t> &mesh, std::ostream &os){
+    const auto N_verts = static_cast<uint64_t>(mesh.vertices.size());
+    const auto N_faces = static_cast<long int>(mesh.faces.size());
+
+    // Polygons are fanned, so each face with n vertices produces n-2 triangles.
+    std::vector<uint64_t> first_tri(N_faces + 1, 0);
+    for(long int f = 0; f < N_faces; ++f){
+        const auto &face = mesh.faces[f];
+        for(const auto &i : face){
+            if(N_verts <= i) return false;
+        }
+        first_tri[f + 1] = first_tri[f] + ((face.size() < 3) ? 0 : (face.size() - 2));
+    }
+    const uint64_t N_tris = first_tri[N_faces];
+    if(std::numeric_limits<uint32_t>::max() < N_tris) return false;
+
+    std::string buf(header_bytes + facet_bytes * N_tris, '\0');
+    const std::string header = "Binary STL written by DICOMautomaton"; // Must not begin with 'solid'.
+    std::copy(std::begin(header), std::end(header), std::begin(buf));
+    Write_LE32(&buf[80], static_cast<uint32_t>(N_tris));
+
+    parallel_for(0, N_faces, [&](long int f) -> void {
+        const auto &face = mesh.faces[f];
+        char *p = &buf[header_bytes + facet_bytes * first_tri[f]];
+
+        const auto write_vec = [&p](const vec3<double> &v) -> void {
+            Write_LE32(p, Float_To_Bits(static_cast<float>(v.x)));
+            Write_LE32(p + 4, Float_To_Bits(static_cast<float>(v.y)));
+            Write_LE32(p + 8, Float_To_Bits(static_cast<float>(v.z)));
+            p += 12;
+        };
+
+        for(size_t j = 2; j < face.size(); ++j){
+            const auto &A = mesh.vertices[face[0]];
+            const auto &B = mesh.vertices[face[j - 1]];
+            const auto &C = mesh.vertices[face[j]];
+
+            auto N = (B - A).Cross(C - A).unit();
+            if(!N.isfinite()) N = vec3<double>(0.0, 0.0, 0.0);
+
+            write_vec(N);
+            write_vec(A);
+            write_vec(B);
+            write_vec(C);
+            p += 2; // The attribute byte count is left zero.
+        }
+    });
+
+    os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    os.flush();
+    return !os.fail();
+}
@@ -0,0 +1,26 @@
+//STL_Mesh_IO.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "YgorMath.h"
+
+
+// Reads a binary STL file in bulk. Vertices shared between facets are welded.
+//
+// Returns false, leaving the mesh untouched, if the file is not a well-formed binary STL file (i.e., its size does not
+// match the facet count in its header). Throws if the file cannot be read.
+//
+// Vertices are welded when their stored (single-precision) coordinates are identical, which is how facets of a
+// watertight mesh share vertices in practice. Welded vertices are numbered in order of their first appearance, so the
+// result does not depend on the number of threads.
+bool Read_FV_Surface_Mesh_From_Binary_STL(const std::string &filename, fv_surface_mesh<double, uint64_t> &mesh);
+
+// Writes a binary STL file. Polygonal faces are fanned into triangles and facet normals are computed from the vertex
+// winding. Coordinates are narrowed to single-precision, as required by the format.
+//
+// The file is assembled in memory and emitted with a single write.
+bool Write_FV_Surface_Mesh_To_Binary_STL(const fv_surface_mesh<double, uint64_t> &mesh, std::ostream &os);
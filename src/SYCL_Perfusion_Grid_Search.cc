@@ -0,0 +1,253 @@
+//SYCL_Perfusion_Grid_Search.cc - A part of DICOMautomaton 2021. Written by hal clark.
+//
+// Note: this file must be compiled with a SYCL-aware toolchain. See WITH_SYCL in the top-level CMakeLists.txt.
+
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <CL/sycl.hpp>        //Needed for SYCL routines.
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "SYCL_Perfusion_Grid_Search.h"
+
+
+namespace {
+
+struct device_grid_t {
+    long int N_tauA;
+    long int N_tauV;
+    long int N_k2;
+    long int N_t;
+};
+
+} // namespace
+
+
+struct sycl_perfusion_grid_search::impl_t {
+    cl::sycl::queue q;
+    device_grid_t grid;
+
+    cl::sycl::buffer<double, 1> IA;
+    cl::sycl::buffer<double, 1> IV;
+
+    // Voxel-independent sums, indexed like the model tables but without the sample index.
+    cl::sycl::buffer<double, 1> S_IA_IA; // [a * N_k2 + k]
+    cl::sycl::buffer<double, 1> S_IV_IV; // [b * N_k2 + k]
+    cl::sycl::buffer<double, 1> S_IA_IV; // [(a * N_tauV + b) * N_k2 + k]
+
+    impl_t(cl::sycl::queue &&queue,
+           const device_grid_t &g,
+           const std::vector<double> &ia,
+           const std::vector<double> &iv,
+           const std::vector<double> &s_ia_ia,
+           const std::vector<double> &s_iv_iv,
+           const std::vector<double> &s_ia_iv)
+        : q(std::move(queue)),
+          grid(g),
+          IA(std::begin(ia), std::end(ia)),
+          IV(std::begin(iv), std::end(iv)),
+          S_IA_IA(std::begin(s_ia_ia), std::end(s_ia_ia)),
+          S_IV_IV(std::begin(s_iv_iv), std::end(s_iv_iv)),
+          S_IA_IV(std::begin(s_ia_iv), std::end(s_ia_iv)) {}
+};
+
+
+sycl_perfusion_grid_search::sycl_perfusion_grid_search(std::unique_ptr<impl_t> i) : impl(std::move(i)) {}
+
+sycl_perfusion_grid_search::~sycl_perfusion_grid_search() = default;
+
+
+std::unique_ptr<sycl_perfusion_grid_search>
+sycl_perfusion_grid_search::create(const model_table_t &table){
+    const auto N_tauA = table.N_tauA;
+    const auto N_tauV = table.N_tauV;
+    const auto N_k2   = table.N_k2;
+    const auto N_t    = table.N_t;
+    if( (N_tauA <= 0) || (N_tauV <= 0) || (N_k2 <= 0) || (N_t <= 0) ){
+        throw std::invalid_argument("Perfusion model grid is empty. Cannot continue.");
+    }
+    if( (max_tau_samples < N_tauA) || (max_tau_samples < N_tauV) ){
+        throw std::invalid_argument("Perfusion model grid has too many delay samples. Cannot continue.");
+    }
+    if( (static_cast<long int>(table.IA.size()) != (N_tauA * N_k2 * N_t))
+    ||  (static_cast<long int>(table.IV.size()) != (N_tauV * N_k2 * N_t)) ){
+        throw std::invalid_argument("Perfusion model table does not match the grid. Cannot continue.");
+    }
+
+    // The voxel-independent sums are computed once here, in the same order as the CPU implementation.
+    std::vector<double> s_ia_ia(N_tauA * N_k2, 0.0);
+    std::vector<double> s_iv_iv(N_tauV * N_k2, 0.0);
+    std::vector<double> s_ia_iv(N_tauA * N_tauV * N_k2, 0.0);
+    for(long int k = 0; k < N_k2; ++k){
+        for(long int a = 0; a < N_tauA; ++a){
+            const double *ia = &table.IA[(a * N_k2 + k) * N_t];
+            for(long int i = 0; i < N_t; ++i) s_ia_ia[a * N_k2 + k] += ia[i] * ia[i];
+
+            for(long int b = 0; b < N_tauV; ++b){
+                const double *iv = &table.IV[(b * N_k2 + k) * N_t];
+                auto &s = s_ia_iv[(a * N_tauV + b) * N_k2 + k];
+                for(long int i = 0; i < N_t; ++i) s += ia[i] * iv[i];
+            }
+        }
+        for(long int b = 0; b < N_tauV; ++b){
+            const double *iv = &table.IV[(b * N_k2 + k) * N_t];
+            for(long int i = 0; i < N_t; ++i) s_iv_iv[b * N_k2 + k] += iv[i] * iv[i];
+        }
+    }
+
+    const device_grid_t grid = { N_tauA, N_tauV, N_k2, N_t };
+    try{
+        cl::sycl::queue q{ cl::sycl::gpu_selector{} };
+        auto impl = std::make_unique<impl_t>(std::move(q), grid, table.IA, table.IV, s_ia_ia, s_iv_iv, s_ia_iv);
+        return std::unique_ptr<sycl_perfusion_grid_search>( new sycl_perfusion_grid_search(std::move(impl)) );
+
+    }catch(const std::exception &e){
+        FUNCINFO("No suitable SYCL device available (" << e.what() << ")");
+    }
+    return nullptr;
+}
+
+
+std::string
+sycl_perfusion_grid_search::device_name() const {
+    return this->impl->q.get_device().get_info<cl::sycl::info::device::name>();
+}
+
+
+void
+sycl_perfusion_grid_search::search(const double *courses, long int N, result_t *out){
+    if(N <= 0) return;
+
+    const auto grid = this->impl->grid;
+    const auto N_k2 = grid.N_k2;
+
+    // Each work item searches a single k2 plane for a single course; the planes are reduced on the host.
+    std::vector<double> plane_RSS(N * N_k2);
+    std::vector<double> plane_k1A(N * N_k2);
+    std::vector<double> plane_k1V(N * N_k2);
+    std::vector<long int> plane_tauA_idx(N * N_k2);
+    std::vector<long int> plane_tauV_idx(N * N_k2);
+
+    try{
+        cl::sycl::buffer<double, 1> buff_courses( courses, cl::sycl::range<1>( static_cast<size_t>(N * grid.N_t) ) );
+        cl::sycl::buffer<double, 1> buff_RSS( plane_RSS.data(), cl::sycl::range<1>( plane_RSS.size() ) );
+        cl::sycl::buffer<double, 1> buff_k1A( plane_k1A.data(), cl::sycl::range<1>( plane_k1A.size() ) );
+        cl::sycl::buffer<double, 1> buff_k1V( plane_k1V.data(), cl::sycl::range<1>( plane_k1V.size() ) );
+        cl::sycl::buffer<long int, 1> buff_a( plane_tauA_idx.data(), cl::sycl::range<1>( plane_tauA_idx.size() ) );
+        cl::sycl::buffer<long int, 1> buff_b( plane_tauV_idx.data(), cl::sycl::range<1>( plane_tauV_idx.size() ) );
+
+        this->impl->q.submit([&](cl::sycl::handler &cgh){
+            auto access_IA  = this->impl->IA.get_access< cl::sycl::access::mode::read >(cgh);
+            auto access_IV  = this->impl->IV.get_access< cl::sycl::access::mode::read >(cgh);
+            auto access_AA  = this->impl->S_IA_IA.get_access< cl::sycl::access::mode::read >(cgh);
+            auto access_VV  = this->impl->S_IV_IV.get_access< cl::sycl::access::mode::read >(cgh);
+            auto access_AV  = this->impl->S_IA_IV.get_access< cl::sycl::access::mode::read >(cgh);
+            auto access_R   = buff_courses.get_access< cl::sycl::access::mode::read >(cgh);
+            auto access_RSS = buff_RSS.get_access< cl::sycl::access::mode::discard_write >(cgh);
+            auto access_k1A = buff_k1A.get_access< cl::sycl::access::mode::discard_write >(cgh);
+            auto access_k1V = buff_k1V.get_access< cl::sycl::access::mode::discard_write >(cgh);
+            auto access_a   = buff_a.get_access< cl::sycl::access::mode::discard_write >(cgh);
+            auto access_b   = buff_b.get_access< cl::sycl::access::mode::discard_write >(cgh);
+
+            cgh.parallel_for<class sycl_perfusion_grid_search_search>(
+                cl::sycl::range<2>( static_cast<size_t>(N), static_cast<size_t>(N_k2) ),
+                [=](cl::sycl::id<2> tid){
+                    const long int j = static_cast<long int>(tid[0]);
+                    const long int k = static_cast<long int>(tid[1]);
+                    const long int R_offset = j * grid.N_t;
+
+                    // The course-dependent sums. This mirrors ComputeIntegralSummations() in the CPU implementation.
+                    double S_R_R = 0.0;
+                    for(long int i = 0; i < grid.N_t; ++i) S_R_R += access_R[R_offset + i] * access_R[R_offset + i];
+
+                    double S_IA_R[max_tau_samples];
+                    double S_IV_R[max_tau_samples];
+                    for(long int a = 0; a < grid.N_tauA; ++a){
+                        const long int offset = (a * grid.N_k2 + k) * grid.N_t;
+                        double s = 0.0;
+                        for(long int i = 0; i < grid.N_t; ++i) s += access_IA[offset + i] * access_R[R_offset + i];
+                        S_IA_R[a] = s;
+                    }
+                    for(long int b = 0; b < grid.N_tauV; ++b){
+                        const long int offset = (b * grid.N_k2 + k) * grid.N_t;
+                        double s = 0.0;
+                        for(long int i = 0; i < grid.N_t; ++i) s += access_IV[offset + i] * access_R[R_offset + i];
+                        S_IV_R[b] = s;
+                    }
+
+                    double best_RSS = cl::sycl::nan(0UL);
+                    double best_k1A = cl::sycl::nan(0UL);
+                    double best_k1V = cl::sycl::nan(0UL);
+                    long int best_a = -1;
+                    long int best_b = -1;
+                    for(long int a = 0; a < grid.N_tauA; ++a){
+                        const double S_AA = access_AA[a * grid.N_k2 + k];
+                        for(long int b = 0; b < grid.N_tauV; ++b){
+                            const double S_VV = access_VV[b * grid.N_k2 + k];
+                            const double S_AV = access_AV[(a * grid.N_tauV + b) * grid.N_k2 + k];
+
+                            const double common_den = S_AV * S_AV - S_AA * S_VV;
+                            const double k1A = (S_AV * S_IV_R[b] - S_IA_R[a] * S_VV) / common_den;
+                            const double k1V = (S_AV * S_IA_R[a] - S_IV_R[b] * S_AA) / common_den;
+                            const double F = S_R_R
+                                           + k1A * k1A * S_AA
+                                           + k1V * k1V * S_VV
+                                           + 2.0 * k1A * k1V * S_AV
+                                           - 2.0 * k1A * S_IA_R[a]
+                                           - 2.0 * k1V * S_IV_R[b];
+                            if( !cl::sycl::isfinite(k1A) || !cl::sycl::isfinite(k1V) || !cl::sycl::isfinite(F) ) continue;
+
+                            if( (best_a < 0) || (F < best_RSS) ){
+                                best_RSS = F;
+                                best_k1A = k1A;
+                                best_k1V = k1V;
+                                best_a = a;
+                                best_b = b;
+                            }
+                        }
+                    }
+
+                    const long int out_idx = j * grid.N_k2 + k;
+                    access_RSS[out_idx] = best_RSS;
+                    access_k1A[out_idx] = best_k1A;
+                    access_k1V[out_idx] = best_k1V;
+                    access_a[out_idx]   = best_a;
+                    access_b[out_idx]   = best_b;
+            });
+        });
+        this->impl->q.wait_and_throw();
+
+    }catch(const std::exception &e){
+        throw std::runtime_error(std::string("SYCL perfusion grid search failed: ") + e.what());
+    }
+
+    for(long int j = 0; j < N; ++j){
+        result_t r;
+        r.k1A = std::numeric_limits<double>::quiet_NaN();
+        r.k1V = std::numeric_limits<double>::quiet_NaN();
+        r.RSS = std::numeric_limits<double>::quiet_NaN();
+        for(long int k = 0; k < N_k2; ++k){
+            const auto idx = j * N_k2 + k;
+            if(plane_tauA_idx[idx] < 0) continue;
+            if( (r.k2_idx < 0) || (plane_RSS[idx] < r.RSS) ){
+                r.tauA_idx = plane_tauA_idx[idx];
+                r.tauV_idx = plane_tauV_idx[idx];
+                r.k2_idx   = k;
+                r.k1A = plane_k1A[idx];
+                r.k1V = plane_k1V[idx];
+                r.RSS = plane_RSS[idx];
+            }
+        }
+        out[j] = r;
+    }
+    return;
+}
+
@@ -0,0 +1,62 @@
+//SYCL_Perfusion_Grid_Search.h - A part of DICOMautomaton 2021. Written by hal clark.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// An accelerator implementation of an exhaustive parameter search for the reduced three-parameter, single-compartment,
+// dual-input liver perfusion model. It is only available when DICOMautomaton is built with SYCL support (i.e., when
+// DCMA_USE_SYCL is defined), and only used when a GPU is present.
+//
+// The model responses to the AIF, I_A(tauA, k2, t_i), and VIF, I_V(tauV, k2, t_i), are tabulated on the host over a grid
+// of parameters (using the same Chebyshev model as the CPU implementation) and uploaded once. Any number of voxel time
+// courses sampled at the same t_i can then be searched against the grid. For every grid point the optimal k1A and k1V
+// are computed in closed form, exactly as in the CPU implementation, and the grid point with the least residual sum of
+// squares is reported. The result is meant to seed the CPU optimizer, which polishes it.
+class sycl_perfusion_grid_search {
+  public:
+    // Model responses, indexed as IA[(a * N_k2 + k) * N_t + i] and IV[(b * N_k2 + k) * N_t + i] for tauA index a, tauV
+    // index b, k2 index k, and sample index i. Non-finite responses exclude the corresponding grid points.
+    struct model_table_t {
+        long int N_tauA = 0;
+        long int N_tauV = 0;
+        long int N_k2   = 0;
+        long int N_t    = 0;
+        std::vector<double> IA;
+        std::vector<double> IV;
+    };
+
+    struct result_t {
+        long int tauA_idx = -1; // Negative if no grid point produced a finite result.
+        long int tauV_idx = -1;
+        long int k2_idx   = -1;
+        double k1A;
+        double k1V;
+        double RSS;
+    };
+
+    // The maximum number of tauA and tauV grid points supported.
+    static constexpr long int max_tau_samples = 64;
+
+    // Returns nullptr if no suitable device is available, in which case the CPU implementation should be used instead.
+    // Throws if the table is invalid.
+    static std::unique_ptr<sycl_perfusion_grid_search> create(const model_table_t &table);
+
+    ~sycl_perfusion_grid_search();
+
+    // Searches each of the N time courses, which are stored contiguously (N_t samples each), storing the optimum grid
+    // point for course j in out[j]. Throws if the device fails.
+    void search(const double *courses, long int N, result_t *out);
+
+    std::string device_name() const;
+
+  private:
+    struct impl_t;
+    std::unique_ptr<impl_t> impl;
+
+    explicit sycl_perfusion_grid_search(std::unique_ptr<impl_t> i);
+};
+
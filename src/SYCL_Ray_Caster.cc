@@ -0,0 +1,198 @@
+//SYCL_Ray_Caster.cc - A part of DICOMautomaton 2021. Written by hal clark.
+//
+// Note: this file must be compiled with a SYCL-aware toolchain. See WITH_SYCL in the top-level CMakeLists.txt.
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <CL/sycl.hpp>        //Needed for SYCL routines.
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorMath.h"         //Needed for vec3 class.
+
+#include "YgorImages_Functors/Rectilinear_Volume.h"
+#include "YgorImages_Functors/Rectilinear_Volume_Ray_Caster.h"
+
+#include "SYCL_Ray_Caster.h"
+
+
+namespace {
+
+// A device-friendly copy of rectilinear_volume_ray_caster::index_space_t.
+struct device_index_space_t {
+    double origin[3];
+    double axes[3][3];
+    long int extent[3];
+    long int stride[3];
+    long int channel;
+};
+
+} // namespace
+
+
+struct sycl_volume_ray_caster::impl_t {
+    cl::sycl::queue q;
+    cl::sycl::buffer<float, 1> voxels;
+    device_index_space_t space;
+
+    impl_t(cl::sycl::queue &&queue, const rectilinear_volume &vol)
+        : q(std::move(queue)),
+          voxels(std::begin(vol.data), std::end(vol.data)) {}
+};
+
+
+sycl_volume_ray_caster::sycl_volume_ray_caster(std::unique_ptr<impl_t> i) : impl(std::move(i)) {}
+
+sycl_volume_ray_caster::~sycl_volume_ray_caster() = default;
+
+
+std::unique_ptr<sycl_volume_ray_caster>
+sycl_volume_ray_caster::create(const rectilinear_volume &vol, long int channel){
+    // Validates the volume and determines the index-space geometry.
+    const rectilinear_volume_ray_caster cpu_caster(vol, channel);
+    const auto &s = cpu_caster.get_index_space();
+
+    device_index_space_t space;
+    space.origin[0] = s.origin.x;
+    space.origin[1] = s.origin.y;
+    space.origin[2] = s.origin.z;
+    for(int a = 0; a < 3; ++a){
+        space.axes[a][0] = s.axes[a].x;
+        space.axes[a][1] = s.axes[a].y;
+        space.axes[a][2] = s.axes[a].z;
+        space.extent[a] = s.extent[a];
+        space.stride[a] = s.stride[a];
+    }
+    space.channel = channel;
+
+    try{
+        cl::sycl::queue q{ cl::sycl::gpu_selector{} };
+        auto impl = std::make_unique<impl_t>(std::move(q), vol);
+        impl->space = space;
+        return std::unique_ptr<sycl_volume_ray_caster>( new sycl_volume_ray_caster(std::move(impl)) );
+
+    }catch(const std::exception &e){
+        FUNCINFO("No suitable SYCL device available (" << e.what() << ")");
+    }
+    return nullptr;
+}
+
+
+std::string
+sycl_volume_ray_caster::device_name() const {
+    return this->impl->q.get_device().get_info<cl::sycl::info::device::name>();
+}
+
+
+void
+sycl_volume_ray_caster::integrate(const vec3<double> &source,
+                                  const vec3<double> *ends,
+                                  long int N,
+                                  const transform_t &f,
+                                  double *out){
+    if(N <= 0) return;
+
+    std::vector<double> ends_flat;
+    ends_flat.reserve(3 * N);
+    for(long int i = 0; i < N; ++i){
+        ends_flat.push_back(ends[i].x);
+        ends_flat.push_back(ends[i].y);
+        ends_flat.push_back(ends[i].z);
+    }
+    const double src[3] = { source.x, source.y, source.z };
+    const auto space = this->impl->space;
+    const auto xf = f;
+
+    try{
+        cl::sycl::buffer<double, 1> buff_ends( ends_flat.data(), cl::sycl::range<1>( ends_flat.size() ) );
+        cl::sycl::buffer<double, 1> buff_out( out, cl::sycl::range<1>( static_cast<size_t>(N) ) );
+
+        this->impl->q.submit([&](cl::sycl::handler &cgh){
+            auto access_vox  = this->impl->voxels.get_access< cl::sycl::access::mode::read  >(cgh);
+            auto access_ends = buff_ends.get_access< cl::sycl::access::mode::read  >(cgh);
+            auto access_out  = buff_out.get_access< cl::sycl::access::mode::discard_write >(cgh);
+
+            cgh.parallel_for<class sycl_volume_ray_caster_integrate>(
+                cl::sycl::range<1>( static_cast<size_t>(N) ),
+                [=](cl::sycl::id<1> tid){
+                    const size_t i = tid[0];
+
+                    // Transform into index space and clip against the volume. This mirrors
+                    // rectilinear_volume_ray_caster::clip().
+                    constexpr double tiny = 1.0E-200;
+                    const double ds[3] = { src[0] - space.origin[0], src[1] - space.origin[1], src[2] - space.origin[2] };
+                    const double de[3] = { access_ends[3*i + 0] - space.origin[0],
+                                           access_ends[3*i + 1] - space.origin[1],
+                                           access_ends[3*i + 2] - space.origin[2] };
+                    const double dw[3] = { de[0] - ds[0], de[1] - ds[1], de[2] - ds[2] };
+                    const double length = cl::sycl::sqrt(dw[0]*dw[0] + dw[1]*dw[1] + dw[2]*dw[2]);
+
+                    double g0[3];
+                    double d[3];
+                    double t_enter = 0.0;
+                    double t_exit = 1.0;
+                    for(int a = 0; a < 3; ++a){
+                        g0[a] = ds[0]*space.axes[a][0] + ds[1]*space.axes[a][1] + ds[2]*space.axes[a][2];
+                        double da = de[0]*space.axes[a][0] + de[1]*space.axes[a][1] + de[2]*space.axes[a][2] - g0[a];
+                        da = (cl::sycl::fabs(da) < tiny) ? cl::sycl::copysign(tiny, da) : da;
+                        d[a] = da;
+                        const double t0 = (-0.5 - g0[a]) / da;
+                        const double t1 = (static_cast<double>(space.extent[a]) - 0.5 - g0[a]) / da;
+                        t_enter = cl::sycl::fmax(t_enter, cl::sycl::fmin(t0, t1));
+                        t_exit  = cl::sycl::fmin(t_exit,  cl::sycl::fmax(t0, t1));
+                    }
+
+                    // Traverse. This mirrors rectilinear_volume_ray_caster::traverse().
+                    double acc = 0.0;
+                    if(t_enter < t_exit){
+                        long int idx[3];
+                        long int step[3];
+                        double t_next[3];
+                        double t_delta[3];
+                        long int offset = space.channel;
+                        for(int a = 0; a < 3; ++a){
+                            const double g = g0[a] + d[a] * t_enter;
+                            long int ia = static_cast<long int>(cl::sycl::floor(g + 0.5));
+                            ia = (ia < 0) ? 0 : ((space.extent[a] <= ia) ? (space.extent[a] - 1) : ia);
+                            idx[a] = ia;
+                            step[a] = (0.0 < d[a]) ? 1 : -1;
+                            const double boundary = static_cast<double>(ia) + 0.5 * static_cast<double>(step[a]);
+                            t_next[a] = (boundary - g0[a]) / d[a];
+                            t_delta[a] = cl::sycl::fabs(1.0 / d[a]);
+                            offset += ia * space.stride[a];
+                        }
+
+                        double t = t_enter;
+                        while(true){
+                            const int a = (t_next[0] < t_next[1]) ? ((t_next[0] < t_next[2]) ? 0 : 2)
+                                                                  : ((t_next[1] < t_next[2]) ? 1 : 2);
+                            const double t1 = cl::sycl::fmin(t_next[a], t_exit);
+                            if(t < t1){
+                                const double v = static_cast<double>(access_vox[offset]);
+                                acc += (xf.offset + xf.scale * cl::sycl::fmax(v, xf.lower)) * (t1 - t) * length;
+                            }
+                            if(t_exit <= t_next[a]) break;
+
+                            t = t1;
+                            idx[a] += step[a];
+                            if((idx[a] < 0) || (space.extent[a] <= idx[a])) break;
+                            offset += step[a] * space.stride[a];
+                            t_next[a] += t_delta[a];
+                        }
+                    }
+                    access_out[i] = acc;
+            });
+        });
+        this->impl->q.wait_and_throw();
+
+    }catch(const std::exception &e){
+        throw std::runtime_error(std::string("SYCL ray casting failed: ") + e.what());
+    }
+    return;
+}
+
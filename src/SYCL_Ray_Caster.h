@@ -0,0 +1,45 @@
+//SYCL_Ray_Caster.h - A part of DICOMautomaton 2021. Written by hal clark.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "YgorMath.h"
+
+#include "YgorImages_Functors/Rectilinear_Volume.h"
+
+
+// An accelerator implementation of rectilinear_volume_ray_caster::integrate(). It is only available when DICOMautomaton
+// is built with SYCL support (i.e., when DCMA_USE_SYCL is defined), and only used when a GPU is present.
+//
+// The volume is uploaded to the device once, after which any number of ray packets can be integrated against it.
+// Arbitrary functors cannot be shipped to the device, so voxel values are transformed with a clamped affine map:
+// f(v) = offset + scale * max(v, lower).
+class sycl_volume_ray_caster {
+  public:
+    struct transform_t {
+        double lower  = -1.0E300;
+        double scale  = 1.0;
+        double offset = 0.0;
+    };
+
+    // Returns nullptr if no suitable device is available, in which case the CPU implementation should be used instead.
+    // The volume must be regular. It is copied to the device, so it need not outlive the ray caster.
+    static std::unique_ptr<sycl_volume_ray_caster> create(const rectilinear_volume &vol, long int channel = 0);
+
+    ~sycl_volume_ray_caster();
+
+    // Computes the sum of f(value) * length over the voxels traversed by each of the N line segments from the source
+    // to ends[i], storing the result in out[i]. Throws if the device fails.
+    void integrate(const vec3<double> &source, const vec3<double> *ends, long int N, const transform_t &f, double *out);
+
+    std::string device_name() const;
+
+  private:
+    struct impl_t;
+    std::unique_ptr<impl_t> impl;
+
+    explicit sycl_volume_ray_caster(std::unique_ptr<impl_t> i);
+};
+
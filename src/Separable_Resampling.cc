@@ -0,0 +1,296 @@
+//Separable_Resampling.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Separable_Resampling.h"
+
+
+namespace {
+
+// Maps an index onto [0, N) by mirroring about the boundaries.
+int64_t mirror(int64_t i, int64_t N){
+    const auto period = 2 * N;
+    i %= period;
+    if(i < 0) i += period;
+    return (i < N) ? i : (period - 1 - i);
+}
+
+// Filters one input row along the columns.
+template <int64_t T>
+void filter_columns(const float *src, int64_t col_stride, const resampling_weights &w, float outside, float *dst){
+    const auto N = w.samples();
+    const int64_t *idx = w.index.data();
+    const float *wt = w.weight.data();
+    for(int64_t s = 0; s < N; ++s){
+        if(idx[s * T] < 0){
+            dst[s] = outside;
+            continue;
+        }
+        float acc = 0.0f;
+        for(int64_t k = 0; k < T; ++k){
+            acc += wt[s * T + k] * src[idx[s * T + k] * col_stride];
+        }
+        dst[s] = acc;
+    }
+    return;
+}
+
+// Filters the column-filtered rows along the rows. Rows are contiguous, so each tap is a vectorizable scaled addition.
+template <int64_t T>
+void filter_rows(const std::vector<float> &tmp, int64_t columns, const resampling_weights &w, float outside,
+                 std::vector<float> &out){
+    const auto N = w.samples();
+    for(int64_t s = 0; s < N; ++s){
+        float *o = out.data() + s * columns;
+        if(w.index[s * T] < 0){
+            for(int64_t c = 0; c < columns; ++c) o[c] = outside;
+            continue;
+        }
+        for(int64_t c = 0; c < columns; ++c) o[c] = 0.0f;
+        for(int64_t k = 0; k < T; ++k){
+            const float wk = w.weight[s * T + k];
+            const float *t = tmp.data() + w.index[s * T + k] * columns;
+            for(int64_t c = 0; c < columns; ++c) o[c] += wk * t[c];
+        }
+    }
+    return;
+}
+
+template <int64_t T>
+std::vector<float> resample(const planar_image<float,double> &img,
+                            int64_t chan,
+                            const resampling_weights &row_w,
+                            const resampling_weights &col_w,
+                            float outside){
+    const int64_t rows = img.rows;
+    const int64_t columns = img.columns;
+    const int64_t N_rows = row_w.samples();
+    const int64_t N_cols = col_w.samples();
+
+    const auto base = img.index(0, 0, chan);
+    const int64_t row_stride = (1 < rows) ? (img.index(1, 0, chan) - base) : 0;
+    const int64_t col_stride = (1 < columns) ? (img.index(0, 1, chan) - base) : 0;
+    const float *src = img.data.data() + base;
+
+    // Only the input rows that contribute are filtered.
+    std::vector<uint8_t> needed(rows, 0);
+    for(const auto &i : row_w.index){
+        if(0 <= i) needed[i] = 1;
+    }
+
+    std::vector<float> tmp(static_cast<size_t>(rows * N_cols));
+    for(int64_t r = 0; r < rows; ++r){
+        if(needed[r] == 0) continue;
+        filter_columns<T>(src + r * row_stride, col_stride, col_w, outside, tmp.data() + r * N_cols);
+    }
+
+    std::vector<float> out(static_cast<size_t>(N_rows * N_cols));
+    filter_rows<T>(tmp, N_cols, row_w, outside, out);
+    return out;
+}
+
+} // namespace
+
+
+int64_t resampling_weights::samples() const {
+    return (this->taps <= 0) ? 0 : static_cast<int64_t>(this->index.size()) / this->taps;
+}
+
+resampling_weights
+Compute_Resampling_Weights(int64_t N_in,
+                           const std::vector<double> &positions,
+                           resampling_kernel kernel){
+    if(N_in <= 0){
+        throw std::invalid_argument("Cannot resample an empty signal");
+    }
+
+    resampling_weights w;
+    w.taps = (kernel == resampling_kernel::linear) ? 2 : 4;
+    w.index.reserve(positions.size() * w.taps);
+    w.weight.reserve(positions.size() * w.taps);
+
+    const auto lo = -0.5;
+    const auto hi = static_cast<double>(N_in) - 0.5;
+    for(const auto &x : positions){
+        if( !std::isfinite(x) || (x < lo) || (hi < x) ){
+            for(int64_t k = 0; k < w.taps; ++k){
+                w.index.push_back(-1);
+                w.weight.push_back(0.0f);
+            }
+            continue;
+        }
+
+        const auto i0 = static_cast<int64_t>(std::floor(x));
+        const auto t = x - static_cast<double>(i0);
+        if(kernel == resampling_kernel::linear){
+            w.index.push_back(mirror(i0, N_in));
+            w.index.push_back(mirror(i0 + 1, N_in));
+            w.weight.push_back(static_cast<float>(1.0 - t));
+            w.weight.push_back(static_cast<float>(t));
+
+        }else if(kernel == resampling_kernel::cubic){
+            const auto t2 = t * t;
+            const auto t3 = t2 * t;
+            for(int64_t k = -1; k <= 2; ++k) w.index.push_back(mirror(i0 + k, N_in));
+            w.weight.push_back(static_cast<float>(0.5 * (-t3 + 2.0 * t2 - t)));
+            w.weight.push_back(static_cast<float>(0.5 * (3.0 * t3 - 5.0 * t2 + 2.0)));
+            w.weight.push_back(static_cast<float>(0.5 * (-3.0 * t3 + 4.0 * t2 + t)));
+            w.weight.push_back(static_cast<float>(0.5 * (t3 - t2)));
+
+        }else{
+            throw std::invalid_argument("Resampling kernel not understood");
+        }
+    }
+    return w;
+}
+
+std::vector<float>
+Resample_Image_Channel(const planar_image<float,double> &img,
+                       int64_t chan,
+                       const resampling_weights &row_w,
+                       const resampling_weights &col_w,
+                       float outside){
+    if( (img.rows <= 0) || (img.columns <= 0) ){
+        throw std::invalid_argument("Cannot resample an empty image");
+    }
+    if( (chan < 0) || (img.channels <= chan) ){
+        throw std::invalid_argument("Requested channel does not exist");
+    }
+    if(row_w.taps != col_w.taps){
+        throw std::invalid_argument("Row and column weights must use the same kernel");
+    }
+    for(const auto &p : { std::make_pair(&row_w, static_cast<int64_t>(img.rows)),
+                          std::make_pair(&col_w, static_cast<int64_t>(img.columns)) }){
+        for(const auto &i : p.first->index){
+            if(p.second <= i) throw std::invalid_argument("Weights do not match the image dimensions");
+        }
+    }
+
+    if(row_w.taps == 2) return resample<2>(img, chan, row_w, col_w, outside);
+    if(row_w.taps == 4) return resample<4>(img, chan, row_w, col_w, outside);
+    throw std::invalid_argument("Unsupported number of taps");
+}
+
+std::optional<std::pair<std::vector<double>, std::vector<double>>>
+Aligned_Sample_Positions(const planar_image<float,double> &source,
+                         const planar_image<float,double> &target){
+    const double tol = 1.0E-6;
+    const auto s_row = source.row_unit.unit();
+    const auto s_col = source.col_unit.unit();
+    const auto t_row = target.row_unit.unit();
+    const auto t_col = target.col_unit.unit();
+    if( (std::abs(t_row.Dot(s_row)) < (1.0 - tol)) || (std::abs(t_col.Dot(s_col)) < (1.0 - tol)) ){
+        return {};
+    }
+
+    const auto dR = target.position(0, 0) - source.position(0, 0);
+    std::pair<std::vector<double>, std::vector<double>> out;
+    out.first.reserve(target.rows);
+    out.second.reserve(target.columns);
+    for(long int r = 0; r < target.rows; ++r){
+        const auto d = dR + t_row * (target.pxl_dx * static_cast<double>(r));
+        out.first.push_back( d.Dot(s_row) / source.pxl_dx );
+    }
+    for(long int c = 0; c < target.columns; ++c){
+        const auto d = dR + t_col * (target.pxl_dy * static_cast<double>(c));
+        out.second.push_back( d.Dot(s_col) / source.pxl_dy );
+    }
+    return out;
+}
+
+
+planar_image<float,double>
+Decimate_Image(const planar_image<float,double> &img,
+               int64_t factor_r,
+               int64_t factor_c){
+    if( (img.rows <= 0) || (img.columns <= 0) || (img.channels <= 0) ){
+        throw std::invalid_argument("Cannot decimate an empty image");
+    }
+    if( (factor_r <= 0) || (factor_c <= 0) ){
+        throw std::invalid_argument("Decimation factors must be positive");
+    }
+
+    const int64_t rows = img.rows;
+    const int64_t cols = img.columns;
+    const int64_t chans = img.channels;
+    const auto out_rows = (rows + factor_r - 1) / factor_r;
+    const auto out_cols = (cols + factor_c - 1) / factor_c;
+
+    // The first pixel's centre is moved to the centre of the first block.
+    auto offset = img.offset;
+    offset += img.row_unit * (img.pxl_dx * 0.5 * static_cast<double>(factor_r - 1));
+    offset += img.col_unit * (img.pxl_dy * 0.5 * static_cast<double>(factor_c - 1));
+
+    planar_image<float,double> out;
+    out.init_buffer(out_rows, out_cols, chans);
+    out.init_spatial(img.pxl_dx * static_cast<double>(factor_r),
+                     img.pxl_dy * static_cast<double>(factor_c),
+                     img.pxl_dz,
+                     img.anchor,
+                     offset);
+    out.init_orientation(img.row_unit, img.col_unit);
+    out.metadata = img.metadata;
+    out.metadata["Rows"] = std::to_string(out_rows);
+    out.metadata["Columns"] = std::to_string(out_cols);
+
+    // Strides are queried rather than assumed. Each row's voxels are expected to be contiguous.
+    const auto base = img.index(0, 0, 0);
+    const int64_t row_stride = (1 < rows) ? (img.index(1, 0, 0) - base) : 0;
+    const int64_t col_stride = (1 < cols) ? (img.index(0, 1, 0) - base) : 0;
+    const int64_t chan_stride = (1 < chans) ? (img.index(0, 0, 1) - base) : 0;
+    const int64_t row_len = img.index(0, cols - 1, chans - 1) - base + 1;
+
+    std::vector<double> acc(row_len);
+    for(int64_t r_out = 0; r_out < out_rows; ++r_out){
+        const auto r_min = r_out * factor_r;
+        const auto r_max = std::min(r_min + factor_r, rows);
+
+        std::fill(std::begin(acc), std::end(acc), 0.0);
+        for(int64_t r = r_min; r < r_max; ++r){
+            const float *src = img.data.data() + base + r * row_stride;
+            for(int64_t i = 0; i < row_len; ++i) acc[i] += static_cast<double>(src[i]);
+        }
+
+        for(int64_t c_out = 0; c_out < out_cols; ++c_out){
+            const auto c_min = c_out * factor_c;
+            const auto c_max = std::min(c_min + factor_c, cols);
+            const auto norm = 1.0 / static_cast<double>((r_max - r_min) * (c_max - c_min));
+            for(int64_t chan = 0; chan < chans; ++chan){
+                double sum = 0.0;
+                for(int64_t c = c_min; c < c_max; ++c) sum += acc[c * col_stride + chan * chan_stride];
+                out.reference(r_out, c_out, chan) = static_cast<float>(sum * norm);
+            }
+        }
+    }
+    return out;
+}
+
+
+std::vector<planar_image<float,double>>
+Build_Image_Pyramid(const planar_image<float,double> &img,
+                    int64_t max_extent,
+                    int64_t max_levels){
+    std::vector<planar_image<float,double>> out;
+    if(max_levels <= 0) return out;
+    out.push_back(img);
+
+    while(static_cast<int64_t>(out.size()) < max_levels){
+        const auto &prev = out.back();
+        const auto fr = (std::max<int64_t>(max_extent, 1) < prev.rows) ? 2 : 1;
+        const auto fc = (std::max<int64_t>(max_extent, 1) < prev.columns) ? 2 : 1;
+        if( (fr == 1) && (fc == 1) ) break;
+        out.push_back( Decimate_Image(prev, fr, fc) );
+    }
+    return out;
+}
@@ -0,0 +1,80 @@
+//Separable_Resampling.h.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+
+
+// Separable interpolation of images whose sample positions are independent along rows and columns, e.g., supersampling
+// or regridding onto another grid with the same orientation.
+//
+// Per-row and per-column weights are computed once, then the image is filtered along columns and then rows. The
+// inner loops run over contiguous buffers with a fixed number of taps, so they vectorize well. Boundaries are handled
+// by mirroring (i.e., the virtual pixel at index -1 is pixel 0, -2 is pixel 1, etc.).
+enum class resampling_kernel {
+    linear,  // Two taps.
+    cubic,   // Four taps; the Catmull-Rom spline (Keys' cubic convolution with a = -1/2), which is equivalent to
+             // bicubic interpolation with derivatives estimated by central differences.
+};
+
+// Interpolation weights for sampling a 1D signal at a set of positions.
+struct resampling_weights {
+    int64_t taps = 0;
+    std::vector<int64_t> index;  // (sample * taps + tap) --> input index. Negative for samples outside the input.
+    std::vector<float> weight;   // (sample * taps + tap) --> weight.
+
+    int64_t samples() const;
+};
+
+// Computes weights for sampling a signal with N_in samples at the given fractional positions, expressed in sample
+// number space (so the first sample is at 0 and the last at N_in - 1). Positions outside of [-0.5, N_in - 0.5], i.e.,
+// outside the input's pixels, are marked as outside the input.
+resampling_weights
+Compute_Resampling_Weights(int64_t N_in,
+                           const std::vector<double> &positions,
+                           resampling_kernel kernel);
+
+// Resamples a single channel of an image, returning a row-major buffer with row_w.samples() rows and col_w.samples()
+// columns. Samples outside the image are assigned the provided value.
+std::vector<float>
+Resample_Image_Channel(const planar_image<float,double> &img,
+                       int64_t chan,
+                       const resampling_weights &row_w,
+                       const resampling_weights &col_w,
+                       float outside = std::numeric_limits<float>::quiet_NaN());
+
+// If the rows and columns of the target image are parallel (or anti-parallel) to those of the source image, returns
+// the fractional (row, column) positions of the target's rows and columns within the source, ignoring the separation
+// between the image planes. Returns nothing otherwise.
+std::optional<std::pair<std::vector<double>, std::vector<double>>>
+Aligned_Sample_Positions(const planar_image<float,double> &source,
+                         const planar_image<float,double> &target);
+
+
+// Box-filter decimation, which averages each block of factor_r x factor_c pixels into a single pixel. Blocks that
+// extend past the image (when the factors do not divide the image dimensions) average only the pixels within the
+// image. Non-finite pixels propagate, as with a plain average.
+//
+// Input rows are summed into a row-length accumulator, which is contiguous for all channels, and then the blocks are
+// reduced along the columns, so the image is read once and in order.
+//
+// The decimated image's pixels are factor_r x factor_c times as large as the original's, and the image covers the
+// same extent (plus any partial blocks). Metadata is copied, and the Rows and Columns are updated.
+planar_image<float,double>
+Decimate_Image(const planar_image<float,double> &img,
+               int64_t factor_r,
+               int64_t factor_c);
+
+// Builds a mipmap pyramid by repeated 2x2 decimation. The first level is a copy of the image, and each following
+// level is decimated from the previous one, until both dimensions are no larger than max_extent (or the image is a
+// single pixel) or the given number of levels is reached.
+std::vector<planar_image<float,double>>
+Build_Image_Pyramid(const planar_image<float,double> &img,
+                    int64_t max_extent = 1,
+                    int64_t max_levels = std::numeric_limits<int64_t>::max());
@@ -0,0 +1,218 @@
+//Series_Preview.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Separable_Resampling.h"
+#include "Series_Preview.h"
+
+
+namespace {
+
+// Parses a backslash-separated list of numbers, as used for multi-valued DICOM attributes.
+std::vector<double> parse_numbers(const std::map<std::string, std::string> &metadata, const std::string &key){
+    std::vector<double> out;
+    const auto it = metadata.find(key);
+    if(it == std::end(metadata)) return out;
+
+    std::stringstream ss(it->second);
+    std::string token;
+    while(std::getline(ss, token, '\\')){
+        try{
+            out.push_back(std::stod(token));
+        }catch(const std::exception &){
+            return {};
+        }
+    }
+    return out;
+}
+
+// The slice's position along the image normal, if available.
+std::optional<double> slice_position(const std::map<std::string, std::string> &metadata){
+    const auto ipp = parse_numbers(metadata, "ImagePositionPatient");
+    const auto iop = parse_numbers(metadata, "ImageOrientationPatient");
+    if( (ipp.size() != 3) || (iop.size() != 6) ) return std::nullopt;
+
+    const vec3<double> row_unit(iop[0], iop[1], iop[2]);
+    const vec3<double> col_unit(iop[3], iop[4], iop[5]);
+    const auto normal = row_unit.Cross(col_unit);
+    if(!(0.0 < normal.length())) return std::nullopt;
+    return vec3<double>(ipp[0], ipp[1], ipp[2]).Dot(normal.unit());
+}
+
+std::optional<double> instance_number(const std::map<std::string, std::string> &metadata){
+    const auto n = parse_numbers(metadata, "InstanceNumber");
+    if(n.size() != 1) return std::nullopt;
+    return n.front();
+}
+
+void append_be32(std::string &out, uint32_t x){
+    for(int shift = 24; 0 <= shift; shift -= 8) out.push_back(static_cast<char>((x >> shift) & 0xFF));
+    return;
+}
+
+uint32_t crc32(const std::string &s, size_t begin){
+    static const auto table = [](){
+        std::array<uint32_t, 256> t;
+        for(uint32_t n = 0; n < 256; ++n){
+            auto c = n;
+            for(int k = 0; k < 8; ++k) c = (c & 1U) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    uint32_t c = 0xFFFFFFFFU;
+    for(size_t i = begin; i < s.size(); ++i){
+        c = table[(c ^ static_cast<uint8_t>(s[i])) & 0xFFU] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFU;
+}
+
+// Appends a PNG chunk. The CRC covers the chunk type and data.
+void append_chunk(std::string &out, const std::string &type, const std::string &data){
+    append_be32(out, static_cast<uint32_t>(data.size()));
+    const auto begin = out.size();
+    out += type;
+    out += data;
+    append_be32(out, crc32(out, begin));
+    return;
+}
+
+// The display range of the image's first channel.
+std::pair<double, double> display_range(const planar_image<float,double> &img){
+    const auto centre = parse_numbers(img.metadata, "WindowCenter");
+    const auto width = parse_numbers(img.metadata, "WindowWidth");
+    if( !centre.empty() && !width.empty()
+    &&  std::isfinite(centre.front()) && std::isfinite(width.front()) && (0.0 < width.front()) ){
+        return { centre.front() - 0.5 * width.front(), centre.front() + 0.5 * width.front() };
+    }
+
+    auto lo = std::numeric_limits<double>::infinity();
+    auto hi = -lo;
+    for(int64_t r = 0; r < img.rows; ++r){
+        for(int64_t c = 0; c < img.columns; ++c){
+            const auto v = static_cast<double>(img.value(r, c, 0));
+            if(!std::isfinite(v)) continue;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+    }
+    return { lo, hi };
+}
+
+} // namespace
+
+
+std::vector<size_t>
+Select_Representative_Slices(const std::vector<std::map<std::string, std::string>> &metadata,
+                             int64_t count){
+    const auto N = metadata.size();
+    std::vector<size_t> order(N);
+    std::iota(std::begin(order), std::end(order), 0);
+    if( (N == 0) || (count <= 0) ) return {};
+
+    // Prefer the most informative key that every slice provides.
+    std::vector<double> keys(N);
+    bool have_keys = true;
+    for(const auto &key_of : { slice_position, instance_number }){
+        have_keys = true;
+        for(size_t i = 0; (i < N) && have_keys; ++i){
+            const auto k = key_of(metadata[i]);
+            have_keys = k.has_value();
+            if(have_keys) keys[i] = k.value();
+        }
+        if(have_keys) break;
+    }
+    if(have_keys){
+        std::stable_sort(std::begin(order), std::end(order), [&](size_t a, size_t b){ return keys[a] < keys[b]; });
+    }
+
+    // Slices are taken from the centres of equal partitions, so the middle slice is always included for odd counts.
+    const auto M = std::min(static_cast<size_t>(count), N);
+    std::vector<size_t> out;
+    out.reserve(M);
+    for(size_t j = 0; j < M; ++j){
+        const auto i = ((2 * j + 1) * N) / (2 * M);
+        out.push_back(order[i]);
+    }
+    return out;
+}
+
+
+std::vector<planar_image<float,double>>
+Generate_Preview_Mipmaps(const planar_image<float,double> &img,
+                         const series_preview_params &params){
+    auto levels = Build_Image_Pyramid(img);
+
+    // Levels are only generated while both axes can be halved, so previews retain the image's aspect ratio.
+    std::vector<planar_image<float,double>> out;
+    for(auto &l : levels){
+        if( (params.max_extent < l.rows) || (params.max_extent < l.columns) ) continue;
+        const auto smallest = std::min<int64_t>(l.rows, l.columns);
+        out.emplace_back( std::move(l) );
+        if(smallest <= params.min_extent) break;
+    }
+    if(out.empty() && !levels.empty()) out.emplace_back( std::move(levels.back()) );
+    return out;
+}
+
+
+std::string
+Encode_Preview_PNG(const planar_image<float,double> &img){
+    if( (img.rows <= 0) || (img.columns <= 0) || (img.channels <= 0) ){
+        throw std::invalid_argument("Cannot encode an empty image");
+    }
+    const auto [lo, hi] = display_range(img);
+    const auto scale = (lo < hi) ? (255.0 / (hi - lo)) : 0.0;
+
+    // Each scanline is prefixed with its filter type (none).
+    std::string raw;
+    raw.reserve(static_cast<size_t>(img.rows * (img.columns + 1)));
+    for(int64_t r = 0; r < img.rows; ++r){
+        raw.push_back(0);
+        for(int64_t c = 0; c < img.columns; ++c){
+            const auto v = static_cast<double>(img.value(r, c, 0));
+            const auto g = std::isfinite(v) ? std::clamp((v - lo) * scale, 0.0, 255.0) : 0.0;
+            raw.push_back(static_cast<char>(static_cast<uint8_t>(std::lround(g))));
+        }
+    }
+
+    std::string compressed;
+    {
+        boost::iostreams::filtering_ostream os;
+        os.push(boost::iostreams::zlib_compressor());
+        os.push(boost::iostreams::back_inserter(compressed));
+        os.write(raw.data(), static_cast<std::streamsize>(raw.size()));
+        os.reset(); // Flushes the compressor.
+    }
+
+    std::string ihdr;
+    append_be32(ihdr, static_cast<uint32_t>(img.columns));
+    append_be32(ihdr, static_cast<uint32_t>(img.rows));
+    ihdr += std::string("\x08\x00\x00\x00\x00", 5); // 8-bit greyscale, default compression, filter, no interlacing.
+
+    std::string out("\x89PNG\r\n\x1a\n", 8);
+    append_chunk(out, "IHDR", ihdr);
+    append_chunk(out, "IDAT", compressed);
+    append_chunk(out, "IEND", "");
+    return out;
+}
+
@@ -0,0 +1,40 @@
+//Series_Preview.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "YgorImages.h"
+
+
+// Small, pre-computed previews of image series, so a series can be browsed without loading its pixel data.
+//
+// A handful of representative slices are selected from each series using only their metadata, and each is reduced to
+// a short mipmap chain of 8-bit greyscale PNGs that can be served or displayed directly.
+struct series_preview_params {
+    int64_t representative_slices = 3; // The number of slices previewed per series.
+    int64_t max_extent = 128;          // The largest preview's row and column count.
+    int64_t min_extent = 16;           // Mipmap levels are generated until either dimension is no larger than this.
+};
+
+// Selects up to 'count' slices, evenly spaced through the series, from the slices' metadata. Slices are ordered by
+// their position along the image normal when ImagePositionPatient and ImageOrientationPatient are available, then by
+// InstanceNumber, and otherwise in the provided order. Returns indices into the metadata, in slice order.
+std::vector<size_t>
+Select_Representative_Slices(const std::vector<std::map<std::string, std::string>> &metadata,
+                             int64_t count);
+
+// Generates the preview mipmap levels of an image, largest first. Levels larger than max_extent are omitted, except
+// that an image which cannot be reduced below max_extent contributes its smallest level.
+std::vector<planar_image<float,double>>
+Generate_Preview_Mipmaps(const planar_image<float,double> &img,
+                         const series_preview_params &params = series_preview_params());
+
+// Encodes the first channel of the image as an 8-bit greyscale PNG. The image's WindowCenter and WindowWidth are
+// used if available, and otherwise the range of finite voxel values. Non-finite voxels are black.
+std::string
+Encode_Preview_PNG(const planar_image<float,double> &img);
+
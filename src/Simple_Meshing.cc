@@ -11,12 +11,12 @@
 #include <iterator>
 #include <thread>
 #include <array>
-#include <mutex>
 #include <limits>
 #include <cmath>
 #include <memory>
 #include <stdexcept>
 
+#include <cstdint>
 #include <cstdlib>            //Needed for exit() calls.
 #include <utility>            //Needed for std::pair.
 #include <algorithm>
@@ -24,12 +24,15 @@
 
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
 #include "YgorMathIOOBJ.h"
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 #include "YgorAlgorithms.h"   //Needed for For_Each_In_Parallel<..>(...)
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
 
 #include "Structs.h"
+#include "Thread_Pool.h"
+#include "Tracing.h"
 
 #include "Simple_Meshing.h"
 
@@ -739,3 +742,598 @@ Minimally_Amalgamate_Contours(
     return amal;
 }
 
+
+// Marching Cubes surface extraction.
+//
+// NOTE: This implementation borrows from the public domain implementation available at
+//       <https://paulbourke.net/geometry/polygonise/marchingsource.cpp> (accessed 20190217).
+//       The header lists Cory Bloyd as the author. The implementation provided here extends the public domain
+//       version to support rectangular cubes and avoid 3D interpolation. Thanks Cory! Thanks Paul!
+//
+namespace {
+
+// Use a curb vertex inclusivity int (8 bits) to determine which (of 12) edges are intersected by the ROI surface.
+const std::array<int32_t, 256> aiCubeEdgeFlags { {
+    0b000000000000, 0b000100001001, 0b001000000011, 0b001100001010, 0b010000000110, 0b010100001111, 0b011000000101,
+    0b011100001100, 0b100000001100, 0b100100000101, 0b101000001111, 0b101100000110, 0b110000001010, 0b110100000011,
+    0b111000001001, 0b111100000000, 0b000110010000, 0b000010011001, 0b001110010011, 0b001010011010, 0b010110010110,
+    0b010010011111, 0b011110010101, 0b011010011100, 0b100110011100, 0b100010010101, 0b101110011111, 0b101010010110,
+    0b110110011010, 0b110010010011, 0b111110011001, 0b111010010000, 0b001000110000, 0b001100111001, 0b000000110011,
+    0b000100111010, 0b011000110110, 0b011100111111, 0b010000110101, 0b010100111100, 0b101000111100, 0b101100110101,
+    0b100000111111, 0b100100110110, 0b111000111010, 0b111100110011, 0b110000111001, 0b110100110000, 0b001110100000,
+    0b001010101001, 0b000110100011, 0b000010101010, 0b011110100110, 0b011010101111, 0b010110100101, 0b010010101100,
+    0b101110101100, 0b101010100101, 0b100110101111, 0b100010100110, 0b111110101010, 0b111010100011, 0b110110101001,
+    0b110010100000, 0b010001100000, 0b010101101001, 0b011001100011, 0b011101101010, 0b000001100110, 0b000101101111,
+    0b001001100101, 0b001101101100, 0b110001101100, 0b110101100101, 0b111001101111, 0b111101100110, 0b100001101010,
+    0b100101100011, 0b101001101001, 0b101101100000, 0b010111110000, 0b010011111001, 0b011111110011, 0b011011111010,
+    0b000111110110, 0b000011111111, 0b001111110101, 0b001011111100, 0b110111111100, 0b110011110101, 0b111111111111,
+    0b111011110110, 0b100111111010, 0b100011110011, 0b101111111001, 0b101011110000, 0b011001010000, 0b011101011001,
+    0b010001010011, 0b010101011010, 0b001001010110, 0b001101011111, 0b000001010101, 0b000101011100, 0b111001011100,
+    0b111101010101, 0b110001011111, 0b110101010110, 0b101001011010, 0b101101010011, 0b100001011001, 0b100101010000,
+    0b011111000000, 0b011011001001, 0b010111000011, 0b010011001010, 0b001111000110, 0b001011001111, 0b000111000101,
+    0b000011001100, 0b111111001100, 0b111011000101, 0b110111001111, 0b110011000110, 0b101111001010, 0b101011000011,
+    0b100111001001, 0b100011000000, 0b100011000000, 0b100111001001, 0b101011000011, 0b101111001010, 0b110011000110,
+    0b110111001111, 0b111011000101, 0b111111001100, 0b000011001100, 0b000111000101, 0b001011001111, 0b001111000110,
+    0b010011001010, 0b010111000011, 0b011011001001, 0b011111000000, 0b100101010000, 0b100001011001, 0b101101010011,
+    0b101001011010, 0b110101010110, 0b110001011111, 0b111101010101, 0b111001011100, 0b000101011100, 0b000001010101,
+    0b001101011111, 0b001001010110, 0b010101011010, 0b010001010011, 0b011101011001, 0b011001010000, 0b101011110000,
+    0b101111111001, 0b100011110011, 0b100111111010, 0b111011110110, 0b111111111111, 0b110011110101, 0b110111111100,
+    0b001011111100, 0b001111110101, 0b000011111111, 0b000111110110, 0b011011111010, 0b011111110011, 0b010011111001,
+    0b010111110000, 0b101101100000, 0b101001101001, 0b100101100011, 0b100001101010, 0b111101100110, 0b111001101111,
+    0b110101100101, 0b110001101100, 0b001101101100, 0b001001100101, 0b000101101111, 0b000001100110, 0b011101101010,
+    0b011001100011, 0b010101101001, 0b010001100000, 0b110010100000, 0b110110101001, 0b111010100011, 0b111110101010,
+    0b100010100110, 0b100110101111, 0b101010100101, 0b101110101100, 0b010010101100, 0b010110100101, 0b011010101111,
+    0b011110100110, 0b000010101010, 0b000110100011, 0b001010101001, 0b001110100000, 0b110100110000, 0b110000111001,
+    0b111100110011, 0b111000111010, 0b100100110110, 0b100000111111, 0b101100110101, 0b101000111100, 0b010100111100,
+    0b010000110101, 0b011100111111, 0b011000110110, 0b000100111010, 0b000000110011, 0b001100111001, 0b001000110000,
+    0b111010010000, 0b111110011001, 0b110010010011, 0b110110011010, 0b101010010110, 0b101110011111, 0b100010010101,
+    0b100110011100, 0b011010011100, 0b011110010101, 0b010010011111, 0b010110010110, 0b001010011010, 0b001110010011,
+    0b000010011001, 0b000110010000, 0b111100000000, 0b111000001001, 0b110100000011, 0b110000001010, 0b101100000110,
+    0b101000001111, 0b100100000101, 0b100000001100, 0b011100001100, 0b011000000101, 0b010100001111, 0b010000000110,
+    0b001100001010, 0b001000000011, 0b000100001001, 0b000000000000
+} };
+
+// Determine which triangulation (0-5 triangles) is needed given the edge-surface intersections.
+const std::array< std::array<int32_t, 16>, 256> a2iTriangleConnectionTable  { {
+       { -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  1,  9,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  8,  3,    9,  8,  1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8,  3,    1,  2, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  2, 10,    0,  2,  9,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2,  8,  3,    2, 10,  8,   10,  9,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3, 11,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0, 11,  2,    8, 11,  0,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  9,  0,    2,  3, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1, 11,  2,    1,  9, 11,    9,  8, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3, 10,  1,   11, 10,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0, 10,  1,    0,  8, 10,    8, 11, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  9,  0,    3, 11,  9,   11, 10,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  8, 10,   10,  8, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  7,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  3,  0,    7,  3,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  1,  9,    8,  4,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  1,  9,    4,  7,  1,    7,  3,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2, 10,    8,  4,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  4,  7,    3,  0,  4,    1,  2, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  2, 10,    9,  0,  2,    8,  4,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2, 10,  9,    2,  9,  7,    2,  7,  3,    7,  9,  4,   -1, -1, -1,   -1 },
+       {  8,  4,  7,    3, 11,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 11,  4,  7,   11,  2,  4,    2,  0,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  0,  1,    8,  4,  7,    2,  3, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  7, 11,    9,  4, 11,    9, 11,  2,    9,  2,  1,   -1, -1, -1,   -1 },
+       {  3, 10,  1,    3, 11, 10,    7,  8,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1, 11, 10,    1,  4, 11,    1,  0,  4,    7, 11,  4,   -1, -1, -1,   -1 },
+       {  4,  7,  8,    9,  0, 11,    9, 11, 10,   11,  0,  3,   -1, -1, -1,   -1 },
+       {  4,  7, 11,    4, 11,  9,    9, 11, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  5,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  5,  4,    0,  8,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  5,  4,    1,  5,  0,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  8,  5,  4,    8,  3,  5,    3,  1,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2, 10,    9,  5,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  0,  8,    1,  2, 10,    4,  9,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5,  2, 10,    5,  4,  2,    4,  0,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2, 10,  5,    3,  2,  5,    3,  5,  4,    3,  4,  8,   -1, -1, -1,   -1 },
+       {  9,  5,  4,    2,  3, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0, 11,  2,    0,  8, 11,    4,  9,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  5,  4,    0,  1,  5,    2,  3, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2,  1,  5,    2,  5,  8,    2,  8, 11,    4,  8,  5,   -1, -1, -1,   -1 },
+       { 10,  3, 11,   10,  1,  3,    9,  5,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  9,  5,    0,  8,  1,    8, 10,  1,    8, 11, 10,   -1, -1, -1,   -1 },
+       {  5,  4,  0,    5,  0, 11,    5, 11, 10,   11,  0,  3,   -1, -1, -1,   -1 },
+       {  5,  4,  8,    5,  8, 10,   10,  8, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  7,  8,    5,  7,  9,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  3,  0,    9,  5,  3,    5,  7,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  7,  8,    0,  1,  7,    1,  5,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  5,  3,    3,  5,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  7,  8,    9,  5,  7,   10,  1,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  1,  2,    9,  5,  0,    5,  3,  0,    5,  7,  3,   -1, -1, -1,   -1 },
+       {  8,  0,  2,    8,  2,  5,    8,  5,  7,   10,  5,  2,   -1, -1, -1,   -1 },
+       {  2, 10,  5,    2,  5,  3,    3,  5,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  7,  9,  5,    7,  8,  9,    3, 11,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  5,  7,    9,  7,  2,    9,  2,  0,    2,  7, 11,   -1, -1, -1,   -1 },
+       {  2,  3, 11,    0,  1,  8,    1,  7,  8,    1,  5,  7,   -1, -1, -1,   -1 },
+       { 11,  2,  1,   11,  1,  7,    7,  1,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  5,  8,    8,  5,  7,   10,  1,  3,   10,  3, 11,   -1, -1, -1,   -1 },
+       {  5,  7,  0,    5,  0,  9,    7, 11,  0,    1,  0, 10,   11, 10,  0,   -1 },
+       { 11, 10,  0,   11,  0,  3,   10,  5,  0,    8,  0,  7,    5,  7,  0,   -1 },
+       { 11, 10,  5,    7, 11,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  6,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8,  3,    5, 10,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  0,  1,    5, 10,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  8,  3,    1,  9,  8,    5, 10,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  6,  5,    2,  6,  1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  6,  5,    1,  2,  6,    3,  0,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  6,  5,    9,  0,  6,    0,  2,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5,  9,  8,    5,  8,  2,    5,  2,  6,    3,  2,  8,   -1, -1, -1,   -1 },
+       {  2,  3, 11,   10,  6,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 11,  0,  8,   11,  2,  0,   10,  6,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  1,  9,    2,  3, 11,    5, 10,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5, 10,  6,    1,  9,  2,    9, 11,  2,    9,  8, 11,   -1, -1, -1,   -1 },
+       {  6,  3, 11,    6,  5,  3,    5,  1,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8, 11,    0, 11,  5,    0,  5,  1,    5, 11,  6,   -1, -1, -1,   -1 },
+       {  3, 11,  6,    0,  3,  6,    0,  6,  5,    0,  5,  9,   -1, -1, -1,   -1 },
+       {  6,  5,  9,    6,  9, 11,   11,  9,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5, 10,  6,    4,  7,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  3,  0,    4,  7,  3,    6,  5, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  9,  0,    5, 10,  6,    8,  4,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  6,  5,    1,  9,  7,    1,  7,  3,    7,  9,  4,   -1, -1, -1,   -1 },
+       {  6,  1,  2,    6,  5,  1,    4,  7,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2,  5,    5,  2,  6,    3,  0,  4,    3,  4,  7,   -1, -1, -1,   -1 },
+       {  8,  4,  7,    9,  0,  5,    0,  6,  5,    0,  2,  6,   -1, -1, -1,   -1 },
+       {  7,  3,  9,    7,  9,  4,    3,  2,  9,    5,  9,  6,    2,  6,  9,   -1 },
+       {  3, 11,  2,    7,  8,  4,   10,  6,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5, 10,  6,    4,  7,  2,    4,  2,  0,    2,  7, 11,   -1, -1, -1,   -1 },
+       {  0,  1,  9,    4,  7,  8,    2,  3, 11,    5, 10,  6,   -1, -1, -1,   -1 },
+       {  9,  2,  1,    9, 11,  2,    9,  4, 11,    7, 11,  4,    5, 10,  6,   -1 },
+       {  8,  4,  7,    3, 11,  5,    3,  5,  1,    5, 11,  6,   -1, -1, -1,   -1 },
+       {  5,  1, 11,    5, 11,  6,    1,  0, 11,    7, 11,  4,    0,  4, 11,   -1 },
+       {  0,  5,  9,    0,  6,  5,    0,  3,  6,   11,  6,  3,    8,  4,  7,   -1 },
+       {  6,  5,  9,    6,  9, 11,    4,  7,  9,    7, 11,  9,   -1, -1, -1,   -1 },
+       { 10,  4,  9,    6,  4, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4, 10,  6,    4,  9, 10,    0,  8,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  0,  1,   10,  6,  0,    6,  4,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  8,  3,  1,    8,  1,  6,    8,  6,  4,    6,  1, 10,   -1, -1, -1,   -1 },
+       {  1,  4,  9,    1,  2,  4,    2,  6,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  0,  8,    1,  2,  9,    2,  4,  9,    2,  6,  4,   -1, -1, -1,   -1 },
+       {  0,  2,  4,    4,  2,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  8,  3,  2,    8,  2,  4,    4,  2,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  4,  9,   10,  6,  4,   11,  2,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8,  2,    2,  8, 11,    4,  9, 10,    4, 10,  6,   -1, -1, -1,   -1 },
+       {  3, 11,  2,    0,  1,  6,    0,  6,  4,    6,  1, 10,   -1, -1, -1,   -1 },
+       {  6,  4,  1,    6,  1, 10,    4,  8,  1,    2,  1, 11,    8, 11,  1,   -1 },
+       {  9,  6,  4,    9,  3,  6,    9,  1,  3,   11,  6,  3,   -1, -1, -1,   -1 },
+       {  8, 11,  1,    8,  1,  0,   11,  6,  1,    9,  1,  4,    6,  4,  1,   -1 },
+       {  3, 11,  6,    3,  6,  0,    0,  6,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  6,  4,  8,   11,  6,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  7, 10,  6,    7,  8, 10,    8,  9, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  7,  3,    0, 10,  7,    0,  9, 10,    6,  7, 10,   -1, -1, -1,   -1 },
+       { 10,  6,  7,    1, 10,  7,    1,  7,  8,    1,  8,  0,   -1, -1, -1,   -1 },
+       { 10,  6,  7,   10,  7,  1,    1,  7,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2,  6,    1,  6,  8,    1,  8,  9,    8,  6,  7,   -1, -1, -1,   -1 },
+       {  2,  6,  9,    2,  9,  1,    6,  7,  9,    0,  9,  3,    7,  3,  9,   -1 },
+       {  7,  8,  0,    7,  0,  6,    6,  0,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  7,  3,  2,    6,  7,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2,  3, 11,   10,  6,  8,   10,  8,  9,    8,  6,  7,   -1, -1, -1,   -1 },
+       {  2,  0,  7,    2,  7, 11,    0,  9,  7,    6,  7, 10,    9, 10,  7,   -1 },
+       {  1,  8,  0,    1,  7,  8,    1, 10,  7,    6,  7, 10,    2,  3, 11,   -1 },
+       { 11,  2,  1,   11,  1,  7,   10,  6,  1,    6,  7,  1,   -1, -1, -1,   -1 },
+       {  8,  9,  6,    8,  6,  7,    9,  1,  6,   11,  6,  3,    1,  3,  6,   -1 },
+       {  0,  9,  1,   11,  6,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  7,  8,  0,    7,  0,  6,    3, 11,  0,   11,  6,  0,   -1, -1, -1,   -1 },
+       {  7, 11,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  7,  6, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  0,  8,   11,  7,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  1,  9,   11,  7,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  8,  1,  9,    8,  3,  1,   11,  7,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  1,  2,    6, 11,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2, 10,    3,  0,  8,    6, 11,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2,  9,  0,    2, 10,  9,    6, 11,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  6, 11,  7,    2, 10,  3,   10,  8,  3,   10,  9,  8,   -1, -1, -1,   -1 },
+       {  7,  2,  3,    6,  2,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  7,  0,  8,    7,  6,  0,    6,  2,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2,  7,  6,    2,  3,  7,    0,  1,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  6,  2,    1,  8,  6,    1,  9,  8,    8,  7,  6,   -1, -1, -1,   -1 },
+       { 10,  7,  6,   10,  1,  7,    1,  3,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  7,  6,    1,  7, 10,    1,  8,  7,    1,  0,  8,   -1, -1, -1,   -1 },
+       {  0,  3,  7,    0,  7, 10,    0, 10,  9,    6, 10,  7,   -1, -1, -1,   -1 },
+       {  7,  6, 10,    7, 10,  8,    8, 10,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  6,  8,  4,   11,  8,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  6, 11,    3,  0,  6,    0,  4,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  8,  6, 11,    8,  4,  6,    9,  0,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  4,  6,    9,  6,  3,    9,  3,  1,   11,  3,  6,   -1, -1, -1,   -1 },
+       {  6,  8,  4,    6, 11,  8,    2, 10,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2, 10,    3,  0, 11,    0,  6, 11,    0,  4,  6,   -1, -1, -1,   -1 },
+       {  4, 11,  8,    4,  6, 11,    0,  2,  9,    2, 10,  9,   -1, -1, -1,   -1 },
+       { 10,  9,  3,   10,  3,  2,    9,  4,  3,   11,  3,  6,    4,  6,  3,   -1 },
+       {  8,  2,  3,    8,  4,  2,    4,  6,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  4,  2,    4,  6,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  9,  0,    2,  3,  4,    2,  4,  6,    4,  3,  8,   -1, -1, -1,   -1 },
+       {  1,  9,  4,    1,  4,  2,    2,  4,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  8,  1,  3,    8,  6,  1,    8,  4,  6,    6, 10,  1,   -1, -1, -1,   -1 },
+       { 10,  1,  0,   10,  0,  6,    6,  0,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  6,  3,    4,  3,  8,    6, 10,  3,    0,  3,  9,   10,  9,  3,   -1 },
+       { 10,  9,  4,    6, 10,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  9,  5,    7,  6, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8,  3,    4,  9,  5,   11,  7,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5,  0,  1,    5,  4,  0,    7,  6, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 11,  7,  6,    8,  3,  4,    3,  5,  4,    3,  1,  5,   -1, -1, -1,   -1 },
+       {  9,  5,  4,   10,  1,  2,    7,  6, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  6, 11,  7,    1,  2, 10,    0,  8,  3,    4,  9,  5,   -1, -1, -1,   -1 },
+       {  7,  6, 11,    5,  4, 10,    4,  2, 10,    4,  0,  2,   -1, -1, -1,   -1 },
+       {  3,  4,  8,    3,  5,  4,    3,  2,  5,   10,  5,  2,   11,  7,  6,   -1 },
+       {  7,  2,  3,    7,  6,  2,    5,  4,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  5,  4,    0,  8,  6,    0,  6,  2,    6,  8,  7,   -1, -1, -1,   -1 },
+       {  3,  6,  2,    3,  7,  6,    1,  5,  0,    5,  4,  0,   -1, -1, -1,   -1 },
+       {  6,  2,  8,    6,  8,  7,    2,  1,  8,    4,  8,  5,    1,  5,  8,   -1 },
+       {  9,  5,  4,   10,  1,  6,    1,  7,  6,    1,  3,  7,   -1, -1, -1,   -1 },
+       {  1,  6, 10,    1,  7,  6,    1,  0,  7,    8,  7,  0,    9,  5,  4,   -1 },
+       {  4,  0, 10,    4, 10,  5,    0,  3, 10,    6, 10,  7,    3,  7, 10,   -1 },
+       {  7,  6, 10,    7, 10,  8,    5,  4, 10,    4,  8, 10,   -1, -1, -1,   -1 },
+       {  6,  9,  5,    6, 11,  9,   11,  8,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  6, 11,    0,  6,  3,    0,  5,  6,    0,  9,  5,   -1, -1, -1,   -1 },
+       {  0, 11,  8,    0,  5, 11,    0,  1,  5,    5,  6, 11,   -1, -1, -1,   -1 },
+       {  6, 11,  3,    6,  3,  5,    5,  3,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2, 10,    9,  5, 11,    9, 11,  8,   11,  5,  6,   -1, -1, -1,   -1 },
+       {  0, 11,  3,    0,  6, 11,    0,  9,  6,    5,  6,  9,    1,  2, 10,   -1 },
+       { 11,  8,  5,   11,  5,  6,    8,  0,  5,   10,  5,  2,    0,  2,  5,   -1 },
+       {  6, 11,  3,    6,  3,  5,    2, 10,  3,   10,  5,  3,   -1, -1, -1,   -1 },
+       {  5,  8,  9,    5,  2,  8,    5,  6,  2,    3,  8,  2,   -1, -1, -1,   -1 },
+       {  9,  5,  6,    9,  6,  0,    0,  6,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  5,  8,    1,  8,  0,    5,  6,  8,    3,  8,  2,    6,  2,  8,   -1 },
+       {  1,  5,  6,    2,  1,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  3,  6,    1,  6, 10,    3,  8,  6,    5,  6,  9,    8,  9,  6,   -1 },
+       { 10,  1,  0,   10,  0,  6,    9,  5,  0,    5,  6,  0,   -1, -1, -1,   -1 },
+       {  0,  3,  8,    5,  6, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  5,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 11,  5, 10,    7,  5, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 11,  5, 10,   11,  7,  5,    8,  3,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5, 11,  7,    5, 10, 11,    1,  9,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 10,  7,  5,   10, 11,  7,    9,  8,  1,    8,  3,  1,   -1, -1, -1,   -1 },
+       { 11,  1,  2,   11,  7,  1,    7,  5,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8,  3,    1,  2,  7,    1,  7,  5,    7,  2, 11,   -1, -1, -1,   -1 },
+       {  9,  7,  5,    9,  2,  7,    9,  0,  2,    2, 11,  7,   -1, -1, -1,   -1 },
+       {  7,  5,  2,    7,  2, 11,    5,  9,  2,    3,  2,  8,    9,  8,  2,   -1 },
+       {  2,  5, 10,    2,  3,  5,    3,  7,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  8,  2,  0,    8,  5,  2,    8,  7,  5,   10,  2,  5,   -1, -1, -1,   -1 },
+       {  9,  0,  1,    5, 10,  3,    5,  3,  7,    3, 10,  2,   -1, -1, -1,   -1 },
+       {  9,  8,  2,    9,  2,  1,    8,  7,  2,   10,  2,  5,    7,  5,  2,   -1 },
+       {  1,  3,  5,    3,  7,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8,  7,    0,  7,  1,    1,  7,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  0,  3,    9,  3,  5,    5,  3,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9,  8,  7,    5,  9,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5,  8,  4,    5, 10,  8,   10, 11,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  5,  0,  4,    5, 11,  0,    5, 10, 11,   11,  3,  0,   -1, -1, -1,   -1 },
+       {  0,  1,  9,    8,  4, 10,    8, 10, 11,   10,  4,  5,   -1, -1, -1,   -1 },
+       { 10, 11,  4,   10,  4,  5,   11,  3,  4,    9,  4,  1,    3,  1,  4,   -1 },
+       {  2,  5,  1,    2,  8,  5,    2, 11,  8,    4,  5,  8,   -1, -1, -1,   -1 },
+       {  0,  4, 11,    0, 11,  3,    4,  5, 11,    2, 11,  1,    5,  1, 11,   -1 },
+       {  0,  2,  5,    0,  5,  9,    2, 11,  5,    4,  5,  8,   11,  8,  5,   -1 },
+       {  9,  4,  5,    2, 11,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2,  5, 10,    3,  5,  2,    3,  4,  5,    3,  8,  4,   -1, -1, -1,   -1 },
+       {  5, 10,  2,    5,  2,  4,    4,  2,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3, 10,  2,    3,  5, 10,    3,  8,  5,    4,  5,  8,    0,  1,  9,   -1 },
+       {  5, 10,  2,    5,  2,  4,    1,  9,  2,    9,  4,  2,   -1, -1, -1,   -1 },
+       {  8,  4,  5,    8,  5,  3,    3,  5,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  4,  5,    1,  0,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  8,  4,  5,    8,  5,  3,    9,  0,  5,    0,  3,  5,   -1, -1, -1,   -1 },
+       {  9,  4,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4, 11,  7,    4,  9, 11,    9, 10, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  8,  3,    4,  9,  7,    9, 11,  7,    9, 10, 11,   -1, -1, -1,   -1 },
+       {  1, 10, 11,    1, 11,  4,    1,  4,  0,    7,  4, 11,   -1, -1, -1,   -1 },
+       {  3,  1,  4,    3,  4,  8,    1, 10,  4,    7,  4, 11,   10, 11,  4,   -1 },
+       {  4, 11,  7,    9, 11,  4,    9,  2, 11,    9,  1,  2,   -1, -1, -1,   -1 },
+       {  9,  7,  4,    9, 11,  7,    9,  1, 11,    2, 11,  1,    0,  8,  3,   -1 },
+       { 11,  7,  4,   11,  4,  2,    2,  4,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { 11,  7,  4,   11,  4,  2,    8,  3,  4,    3,  2,  4,   -1, -1, -1,   -1 },
+       {  2,  9, 10,    2,  7,  9,    2,  3,  7,    7,  4,  9,   -1, -1, -1,   -1 },
+       {  9, 10,  7,    9,  7,  4,   10,  2,  7,    8,  7,  0,    2,  0,  7,   -1 },
+       {  3,  7, 10,    3, 10,  2,    7,  4, 10,    1, 10,  0,    4,  0, 10,   -1 },
+       {  1, 10,  2,    8,  7,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  9,  1,    4,  1,  7,    7,  1,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  9,  1,    4,  1,  7,    0,  8,  1,    8,  7,  1,   -1, -1, -1,   -1 },
+       {  4,  0,  3,    7,  4,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  4,  8,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9, 10,  8,   10, 11,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  0,  9,    3,  9, 11,   11,  9, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  1, 10,    0, 10,  8,    8, 10, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  1, 10,   11,  3, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  2, 11,    1, 11,  9,    9, 11,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  0,  9,    3,  9, 11,    1,  2,  9,    2, 11,  9,   -1, -1, -1,   -1 },
+       {  0,  2, 11,    8,  0, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  3,  2, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2,  3,  8,    2,  8, 10,   10,  8,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  9, 10,  2,    0,  9,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  2,  3,  8,    2,  8, 10,    0,  1,  8,    1, 10,  8,   -1, -1, -1,   -1 },
+       {  1, 10,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  1,  3,  8,    9,  1,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  9,  1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       {  0,  3,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
+       { -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 }
+} };
+
+// Convert an edge index to the corner vertex indices for a cube.
+const std::array< std::array<int32_t, 2>, 12> a2iEdgeConnection { {
+    {0, 1}, {1, 2}, {2, 3}, {3, 0},  // Bottom face.
+    {4, 5}, {5, 6}, {6, 7}, {7, 4},  // Top face.
+    {0, 4}, {1, 5}, {2, 6}, {3, 7}   // Side faces.
+} };
+
+// The (image, row, column) offset of each cube corner relative to corner 0.
+const std::array< std::array<int32_t, 3>, 8> a2iCornerLattice { {
+    {0, 0, 0}, {0, 1, 0}, {0, 1, 1}, {0, 0, 1},
+    {1, 0, 0}, {1, 1, 0}, {1, 1, 1}, {1, 0, 1}
+} };
+
+// The lattice edge corresponding to each cube edge, specified as the (image, row, column) offset of the edge's lower
+// endpoint relative to cube corner 0 and the axis (0: row, 1: column, 2: image) along which the edge runs.
+const std::array< std::array<int32_t, 4>, 12> a2iEdgeLattice { {
+    {0, 0, 0, 0}, {0, 1, 0, 1}, {0, 0, 1, 0}, {0, 0, 0, 1},  // Bottom face.
+    {1, 0, 0, 0}, {1, 1, 0, 1}, {1, 0, 1, 0}, {1, 0, 0, 1},  // Top face.
+    {0, 0, 0, 2}, {0, 1, 0, 2}, {0, 1, 1, 2}, {0, 0, 1, 2}   // Side faces.
+} };
+
+// Vertices and triangles generated for a single slab of cubes (i.e., between two adjacent images).
+//
+// Vertices are identified by the lattice edge they lie on or, if they coincide with a lattice point, by that point.
+// A slab owns the vertices on its lower image and those between its images. Vertices on its upper image are owned by
+// the next slab, if it generated them.
+struct mc_slab_t {
+    std::vector<vec3<double>> verts;
+    std::unordered_map<uint64_t, uint64_t> owned;          // Key to index in verts.
+    std::unordered_map<uint64_t, vec3<double>> foreign;    // Key to position, for vertices on the upper image.
+    std::vector<std::array<uint64_t, 3>> tris;             // Keys.
+    long int degenerate_tris = 0;
+};
+
+} // namespace
+
+
+fv_surface_mesh<double, uint64_t>
+Marching_Cubes_Surface_Mesh(
+        const std::list<std::reference_wrapper<planar_image<float,double>>> &grid_imgs,
+        double inclusion_threshold,
+        bool below_is_interior ){
+    DCMA_TRACE_ZONE("meshing", "Marching_Cubes_Surface_Mesh");
+
+    const double ExteriorVal = inclusion_threshold + (below_is_interior ? 1.0 : -1.0);
+
+    if(grid_imgs.empty()){
+        throw std::invalid_argument("An insufficient number of images was provided. Cannot continue.");
+    }
+    if(!Images_Form_Rectilinear_Grid(grid_imgs)){
+        throw std::logic_error("Grid images do not form a rectilinear grid. Cannot continue");
+    }
+
+    // Order the images by adjacency.
+    const auto GridZ = grid_imgs.front().get().image_plane().N_0;
+    planar_image_adjacency<float,double> img_adj( grid_imgs, {}, GridZ );
+    std::vector<std::reference_wrapper<planar_image<float,double>>> imgs;
+    for(long int i = 0; img_adj.index_present(i); ++i){
+        imgs.emplace_back( img_adj.index_to_image(i) );
+    }
+    if(imgs.size() != grid_imgs.size()){
+        throw std::logic_error("Unable to order grid images by adjacency. Cannot continue");
+    }
+
+    const auto &first = imgs.front().get();
+    const auto N_imgs = static_cast<int64_t>(imgs.size());
+    const auto N_rows = static_cast<int64_t>(first.rows);
+    const auto N_cols = static_cast<int64_t>(first.columns);
+    const auto row_step = first.row_unit.unit() * first.pxl_dx;
+    const auto col_step = first.col_unit.unit() * first.pxl_dy;
+    const auto img_unit = first.row_unit.Cross(first.col_unit).unit();
+
+    // Note that the Marching cube and image voxels are not the same. They are offset such that the corner of the
+    // Marching Cube voxel is at the centre of the image voxel. This is done to avoid surface discontinuties that would
+    // arise from sampling the boundary of border voxels; numerical instability could potentially lead to random
+    // fluctuation by 1 voxel width on straight borders. Lattice points beyond the final row, column, and image are
+    // exterior.
+    std::vector<vec3<double>> layer_origins;
+    for(const auto &img_refw : imgs){
+        layer_origins.emplace_back( img_refw.get().position(0, 0) );
+    }
+    layer_origins.emplace_back( layer_origins.back() + img_unit * imgs.back().get().pxl_dz );
+
+    const auto lattice_value = [&](int64_t k, int64_t r, int64_t c) -> double {
+        if( (N_imgs <= k) || (N_rows <= r) || (N_cols <= c) ) return ExteriorVal;
+        return imgs[k].get().value(r, c, 0);
+    };
+    const auto lattice_position = [&](int64_t k, int64_t r, int64_t c) -> vec3<double> {
+        return layer_origins[k] + row_step * static_cast<double>(r) + col_step * static_cast<double>(c);
+    };
+    const auto point_id = [&](int64_t k, int64_t r, int64_t c) -> uint64_t {
+        return static_cast<uint64_t>( (k * (N_rows + 1) + r) * (N_cols + 1) + c );
+    };
+
+    // Generate the vertices and triangles for each slab independently.
+    std::vector<mc_slab_t> slabs(N_imgs);
+    progress_tracker progress("Marching cubes", N_imgs, [](long int completed, long int total, double) -> void {
+        FUNCINFO("Completed " << completed << " of " << total
+              << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+    });
+    parallel_for(0, N_imgs, [&](long int k) -> void {
+        auto &slab = slabs[k];
+
+        const auto get_vertex = [&](int64_t row, int64_t col, int32_t edge,
+                                    const std::array<double, 8> &afCubeValue) -> uint64_t {
+            const auto &el = a2iEdgeLattice[edge];
+            const int64_t lk = k + el[0];
+            const int64_t lr = row + el[1];
+            const int64_t lc = col + el[2];
+            const int64_t uk = lk + ((el[3] == 2) ? 1 : 0);
+            const int64_t ur = lr + ((el[3] == 0) ? 1 : 0);
+            const int64_t uc = lc + ((el[3] == 1) ? 1 : 0);
+
+            // Orient the edge canonically (lower to upper lattice point) so that the vertex position does not depend
+            // on which cube encounters the edge.
+            const auto &cA = a2iCornerLattice[ a2iEdgeConnection[edge][0] ];
+            const bool lower_is_A = (cA[0] == el[0]) && (cA[1] == el[1]) && (cA[2] == el[2]);
+            const double value_L = afCubeValue[a2iEdgeConnection[edge][lower_is_A ? 0 : 1]];
+            const double value_U = afCubeValue[a2iEdgeConnection[edge][lower_is_A ? 1 : 0]];
+
+            // Find the (approximate) point along the edge where the surface intersects, parameterized to [0:1].
+            const double lin_interp = (inclusion_threshold - value_L) / (value_U - value_L);
+            const double surf_dl = std::isfinite(lin_interp) ? lin_interp : static_cast<double>(0.5);
+            if(!isininc(0.0,surf_dl,1.0)){
+                throw std::logic_error("Interpolation of surface-edge intersection failed. Refusing to continue");
+            }
+
+            uint64_t key;
+            int64_t key_layer;
+            vec3<double> pos;
+            if(surf_dl == 0.0){
+                key = point_id(lk, lr, lc) * 4 + 3;
+                key_layer = lk;
+                pos = lattice_position(lk, lr, lc);
+            }else if(surf_dl == 1.0){
+                key = point_id(uk, ur, uc) * 4 + 3;
+                key_layer = uk;
+                pos = lattice_position(uk, ur, uc);
+            }else{
+                key = point_id(lk, lr, lc) * 4 + static_cast<uint64_t>(el[3]);
+                key_layer = lk; // Vertical edges belong to the slab they span.
+                const auto L = lattice_position(lk, lr, lc);
+                const auto U = lattice_position(uk, ur, uc);
+                pos = L + (U - L) * surf_dl;
+            }
+
+            if(key_layer == k){
+                if(slab.owned.count(key) == 0){
+                    slab.owned[key] = static_cast<uint64_t>(slab.verts.size());
+                    slab.verts.emplace_back(pos);
+                }
+            }else{
+                slab.foreign.emplace(key, pos);
+            }
+            return key;
+        };
+
+        for(int64_t row = 0; row < N_rows; ++row){
+            for(int64_t col = 0; col < N_cols; ++col){
+                // Sample voxel corner values.
+                const std::array<double, 8> afCubeValue { {
+                    lattice_value(k,     row,     col    ),
+                    lattice_value(k,     row + 1, col    ),
+                    lattice_value(k,     row + 1, col + 1),
+                    lattice_value(k,     row,     col + 1),
+                    lattice_value(k + 1, row,     col    ),
+                    lattice_value(k + 1, row + 1, col    ),
+                    lattice_value(k + 1, row + 1, col + 1),
+                    lattice_value(k + 1, row,     col + 1)
+                } };
+
+                // Convert vertex inclusion to a bitmask.
+                int32_t iFlagIndex = 0;
+                for(int32_t corner = 0; corner < 8; ++corner){
+                    if(below_is_interior){
+                        if(afCubeValue[corner] <= inclusion_threshold) iFlagIndex |= (1 << corner);
+                    }else{
+                        if(afCubeValue[corner] >= inclusion_threshold) iFlagIndex |= (1 << corner);
+                    }
+                }
+
+                // If the cube is entirely inside or outside of the surface, then there will be no intersections.
+                const int32_t iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
+                if(iEdgeFlags == 0) continue;
+
+                // Find the vertex on each edge that crosses the surface.
+                std::array<uint64_t, 12> asEdgeVertex;
+                for(int32_t edge = 0; edge < 12; edge++){
+                    if(iEdgeFlags & (1 << edge)){
+                        asEdgeVertex[edge] = get_vertex(row, col, edge, afCubeValue);
+                    }
+                }
+
+                // Process the triangles that were identified.
+                for(int32_t tri = 0; tri < 5; tri++){
+                    // Stop when the first -1 index is encountered (signifying there are no further triangles).
+                    if(a2iTriangleConnectionTable[iFlagIndex][3*tri] < 0) break;
+
+                    const std::array<uint64_t, 3> keys { {
+                        asEdgeVertex[ a2iTriangleConnectionTable[iFlagIndex][3*tri + 0] ],
+                        asEdgeVertex[ a2iTriangleConnectionTable[iFlagIndex][3*tri + 1] ],
+                        asEdgeVertex[ a2iTriangleConnectionTable[iFlagIndex][3*tri + 2] ]
+                    } };
+                    if( (keys[0] == keys[1])
+                    ||  (keys[0] == keys[2])
+                    ||  (keys[1] == keys[2]) ){
+                        ++slab.degenerate_tris;
+                        continue;
+                    }
+                    slab.tris.emplace_back(keys);
+                }
+            }
+        }
+
+        progress.advance();
+    }, /*grain=*/ 1);
+
+    // Vertices on a slab's upper image are usually also generated by the next slab, but not always (e.g., when a
+    // voxel exactly matching the threshold only neighbours exterior voxels below it). Adopt the missing vertices.
+    std::vector<std::unordered_map<uint64_t, uint64_t>> adopted(N_imgs);
+    parallel_for(0, N_imgs, [&](long int k) -> void {
+        auto &slab = slabs[k];
+        for(const auto &f : slab.foreign){
+            if( ((k + 1) < N_imgs) && (slabs[k + 1].owned.count(f.first) != 0) ) continue;
+            adopted[k][f.first] = static_cast<uint64_t>(slab.verts.size());
+            slab.verts.emplace_back(f.second);
+        }
+    }, /*grain=*/ 1);
+
+    std::vector<uint64_t> vert_offsets(N_imgs + 1, 0);
+    std::vector<uint64_t> tri_offsets(N_imgs + 1, 0);
+    long int degenerate_tris = 0;
+    for(int64_t k = 0; k < N_imgs; ++k){
+        vert_offsets[k + 1] = vert_offsets[k] + slabs[k].verts.size();
+        tri_offsets[k + 1] = tri_offsets[k] + slabs[k].tris.size();
+        degenerate_tris += slabs[k].degenerate_tris;
+    }
+    if(degenerate_tris != 0){
+        FUNCWARN("Encountered " << degenerate_tris << " zero-area triangle faces. Ignoring them");
+    }
+
+    // Assemble the mesh.
+    fv_surface_mesh<double, uint64_t> out;
+    out.vertices.resize(vert_offsets.back());
+    out.faces.resize(tri_offsets.back());
+    parallel_for(0, N_imgs, [&](long int k) -> void {
+        const auto &slab = slabs[k];
+        std::copy( std::begin(slab.verts), std::end(slab.verts), std::next(std::begin(out.vertices), vert_offsets[k]) );
+
+        const auto resolve = [&](uint64_t key) -> uint64_t {
+            auto it = slab.owned.find(key);
+            if(it != std::end(slab.owned)) return vert_offsets[k] + it->second;
+            it = adopted[k].find(key);
+            if(it != std::end(adopted[k])) return vert_offsets[k] + it->second;
+            return vert_offsets[k + 1] + slabs[k + 1].owned.at(key);
+        };
+        auto f_it = std::next(std::begin(out.faces), tri_offsets[k]);
+        for(const auto &t : slab.tris){
+            *f_it = { resolve(t[0]), resolve(t[1]), resolve(t[2]) };
+            ++f_it;
+        }
+    }, /*grain=*/ 1);
+    slabs.clear();
+
+    // Orient faces outward, which is indicated by a positive signed volume.
+    Stats::Running_Sum<double> signed_volume;
+    for(const auto &f : out.faces){
+        const auto &A = out.vertices[f[0]];
+        const auto &B = out.vertices[f[1]];
+        const auto &C = out.vertices[f[2]];
+        signed_volume.Digest( A.Dot( B.Cross(C) ) );
+    }
+    if(signed_volume.Current_Sum() < 0.0){
+        for(auto &f : out.faces){
+            std::swap(f[1], f[2]);
+        }
+    }
+
+    out.recreate_involved_face_index();
+    FUNCINFO("The triangulated surface has " << out.vertices.size() << " vertices"
+             " and " << out.faces.size() << " faces");
+    return out;
+}
+
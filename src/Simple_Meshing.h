@@ -15,11 +15,15 @@
 #include <limits>
 #include <cmath>
 
+#include <cstdint>
 #include <cstdlib>            //Needed for exit() calls.
 #include <utility>            //Needed for std::pair.
 #include <algorithm>
 #include <optional>
 
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
 // Low-level routine that joins the vertices of two contours.
 // Returns a list of faces where the vertex indices refer to A followed by B.
 std::vector< std::array<size_t, 3> >
@@ -33,6 +37,20 @@ Minimally_Amalgamate_Contours(
         const vec3<double> &pseudo_vert_offset,
         std::list<std::reference_wrapper<contour_of_points<double>>> B );
 
+// Extracts the surface of the region where voxels are at or below (or above) the threshold using Marching Cubes. Images
+// must form a rectilinear grid; only the first channel is considered. Voxels beyond the final row, column, and image
+// are treated as exterior.
+//
+// Images are processed as independent slabs (one per pair of adjacent images) in parallel. Vertices are identified by
+// the lattice edge (or, if a voxel exactly matches the threshold, the lattice point) they lie on, so they are welded
+// exactly within and across slabs without any spatial searching. Faces are oriented outward.
+fv_surface_mesh<double, uint64_t>
+Marching_Cubes_Surface_Mesh(
+        const std::list<std::reference_wrapper<planar_image<float,double>>> &grid_imgs,
+        double inclusion_threshold, // The voxel value threshold demarcating surface 'interior' and 'exterior.'
+        bool below_is_interior );   // If true, anything <= is considered to be interior to the surface.
+                                    // If false, anything >= is considered to be interior to the surface.
+
 /*
 Polyhedron
 Estimate_Surface_Mesh(
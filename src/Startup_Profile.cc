@@ -0,0 +1,150 @@
+//Startup_Profile.cc - A part of DICOMautomaton 2026.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Startup_Profile.h"
+
+
+namespace {
+
+struct phase_t {
+    std::string name;
+    double start;    // Seconds since main().
+    double duration; // Seconds.
+};
+
+struct startup_profile_state {
+    std::mutex m;
+    bool begun = false;
+    bool written = false;
+    std::string filename;
+
+    std::chrono::steady_clock::time_point t_main;
+    std::optional<double> pre_main; // Seconds between the launch and main().
+
+    std::vector<phase_t> phases;
+    std::optional<phase_t> current;
+};
+
+startup_profile_state & State(){
+    static startup_profile_state s;
+    return s;
+}
+
+double Seconds_Since_Main(const startup_profile_state &s){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - s.t_main).count();
+}
+
+void Begin_Locked(startup_profile_state &s){
+    if(s.begun) return;
+    s.begun = true;
+    s.t_main = std::chrono::steady_clock::now();
+
+    if(const char *e = std::getenv("DCMA_STARTUP_EPOCH_NS"); (e != nullptr) && (*e != '\0')){
+        char *end = nullptr;
+        const auto epoch_ns = std::strtoll(e, &end, 10);
+        const auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::system_clock::now().time_since_epoch() ).count();
+        // Ignore malformed values, and clock adjustments that would make the time negative.
+        if( (end != nullptr) && (*end == '\0') && (0 < epoch_ns) && (epoch_ns <= now_ns) ){
+            s.pre_main = static_cast<double>(now_ns - epoch_ns) * 1.0E-9;
+        }
+    }
+    if(const char *f = std::getenv("DCMA_STARTUP_PROFILE"); (f != nullptr) && (*f != '\0') && s.filename.empty()){
+        s.filename = f;
+    }
+    return;
+}
+
+void End_Locked(startup_profile_state &s){
+    if(!s.current) return;
+    s.current->duration = Seconds_Since_Main(s) - s.current->start;
+    s.phases.emplace_back(std::move(s.current.value()));
+    s.current.reset();
+    return;
+}
+
+} // namespace
+
+
+void Begin_Startup_Profile(){
+    auto &s = State();
+    std::lock_guard<std::mutex> lock(s.m);
+    Begin_Locked(s);
+    return;
+}
+
+void Begin_Startup_Phase(const std::string &name){
+    auto &s = State();
+    std::lock_guard<std::mutex> lock(s.m);
+    Begin_Locked(s);
+    End_Locked(s);
+    s.current = phase_t{ name, Seconds_Since_Main(s), 0.0 };
+    return;
+}
+
+void End_Startup_Phase(){
+    auto &s = State();
+    std::lock_guard<std::mutex> lock(s.m);
+    End_Locked(s);
+    return;
+}
+
+void Enable_Startup_Profile(const std::string &filename){
+    auto &s = State();
+    std::lock_guard<std::mutex> lock(s.m);
+    s.filename = filename;
+    return;
+}
+
+bool Startup_Profile_Enabled(){
+    auto &s = State();
+    std::lock_guard<std::mutex> lock(s.m);
+    Begin_Locked(s);
+    return !s.filename.empty();
+}
+
+void Write_Startup_Profile(){
+    auto &s = State();
+    std::lock_guard<std::mutex> lock(s.m);
+    Begin_Locked(s);
+    End_Locked(s);
+    if(s.written || s.filename.empty()) return;
+    s.written = true;
+
+    // When the launch time is known, everything is shifted so the launch is at zero.
+    std::vector<phase_t> phases;
+    const double offset = s.pre_main.value_or(0.0);
+    if(s.pre_main) phases.push_back(phase_t{ "pre_main", 0.0, offset });
+    for(const auto &p : s.phases) phases.push_back(phase_t{ p.name, p.start + offset, p.duration });
+
+    std::ofstream os(s.filename, std::ios::out | std::ios::trunc);
+    os << std::fixed << std::setprecision(9);
+    for(const auto &p : phases){
+        os << p.name << "\t" << p.start << "\t" << p.duration << "\n";
+    }
+    os.flush();
+    if(!os){
+        FUNCWARN("Unable to write startup profile to '" << s.filename << "'");
+        return;
+    }
+
+    double total = 0.0;
+    for(const auto &p : phases){
+        FUNCINFO("Startup phase '" << p.name << "' took " << p.duration * 1000.0 << " ms");
+        total = p.start + p.duration;
+    }
+    FUNCINFO("Profiled phases took " << total * 1000.0 << " ms in total");
+    FUNCINFO("Wrote startup profile to '" << s.filename << "'");
+    return;
+}
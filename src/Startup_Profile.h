@@ -0,0 +1,48 @@
+//Startup_Profile.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <string>
+
+
+// Attribution of the fixed cost of launching a program to sequential phases, e.g.,
+//
+//     int main(int argc, char* argv[]){
+//         Begin_Startup_Profile();
+//         Begin_Startup_Phase("arguments");
+//         ...
+//         Begin_Startup_Phase("lexicon");
+//         ...
+//         Write_Startup_Profile();
+//     }
+//
+// Phases are contiguous, so beginning a phase ends the previous one. Timing costs only a clock read per phase and is
+// always collected, but the profile is only written if a filename was provided, either by Enable_Startup_Profile() or
+// via the DCMA_STARTUP_PROFILE environment variable.
+//
+// The time spent before main() (i.e., creating the process, loading and relocating shared libraries, and static
+// initialization) cannot be measured from within the process. If the DCMA_STARTUP_EPOCH_NS environment variable holds
+// the time at which the program was launched, as nanoseconds since the Unix epoch, it is reported as the 'pre_main'
+// phase. dicomautomaton_benchmark provides it when measuring startup.
+//
+// The profile is written as tab-separated text with one line per phase containing the phase name, the start time,
+// and the duration, both in seconds. Start times are relative to the launch, if known, and otherwise to main().
+
+// Marks entry into main(). Should be called before anything else. Phases begun beforehand call it implicitly.
+void Begin_Startup_Profile();
+
+// Ends the current phase, if any, and begins a new phase.
+void Begin_Startup_Phase(const std::string &name);
+
+// Ends the current phase, if any.
+void End_Startup_Phase();
+
+// Requests that the profile be written to the given file. An empty filename disables writing.
+void Enable_Startup_Profile(const std::string &filename);
+
+// Whether the profile will be written.
+bool Startup_Profile_Enabled();
+
+// Ends the current phase and, if enabled, writes the profile and reports a summary. Only the first call has any
+// effect, so this can be called wherever startup might be considered complete.
+void Write_Startup_Profile();
@@ -7,7 +7,9 @@
 #include <optional>
 #include <functional>
 #include <initializer_list>
+#include <iterator>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <stdexcept>
 #include <string>
@@ -29,7 +31,16 @@
 #include "YgorString.h"
 
 #include "Structs.h"
+#include "Content_Hash.h"
 #include "Dose_Meld.h"
+#include "Bounded_Dose.h"
+#include "Image_Slice_Index.h"
+#include "Image_Pyramid.h"
+#include "Paged_Images.h"
+#include "Time_Course_Tensor.h"
+#include "Surface_Mesh_BVH.h"
+#include "Surface_Mesh_Adjacency.h"
+#include "Point_Set_KD_Tree.h"
 
 //This is a mapping from the segmentation history to a human-readable description.
 // Try avoid using commas or tabs to make dumping as csv easier. This should in
@@ -130,6 +141,10 @@ void Contour_Data::operator=(const Contour_Data &rhs){
     return;
 }
 
+uint64_t Contour_Data::content_hash() const {
+    return Content_Hash(this->ccs);
+}
+
 //This routine produces a very simple, default plot of the entirety of the data. 
 // If individual contour plots are required, use the contour_of_points::Plot() method instead.
 void Contour_Data::Plot() const {
@@ -530,11 +545,129 @@ Image_Array::Image_Array(const Image_Array &rhs){
 
 Image_Array & Image_Array::operator=(const Image_Array &rhs){
     if(this != &rhs){
+        this->page_store.reset();
         this->imagecoll  = rhs.imagecoll;
+        if(rhs.page_store != nullptr){
+            //Paged-out pixel data is fetched through the store so the copy is fully resident.
+            size_t i = 0;
+            for(auto &img : this->imagecoll.images) rhs.page_store->copy_pixels(i++, img);
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->slice_index_m);
+            this->slice_index.reset();
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->temporal_index_m);
+            this->temporal_index.reset();
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->time_course_tensor_m);
+            this->time_course_tensor.reset();
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->image_pyramid_m);
+            this->image_pyramids.clear();
+        }
     }
     return *this;
 }
 
+std::shared_ptr<const Image_Slice_Index> Image_Array::get_slice_index() const {
+    std::lock_guard<std::mutex> lock(this->slice_index_m);
+    if( (this->slice_index == nullptr)
+    ||  !this->slice_index->is_current(this->imagecoll) ){
+        this->slice_index = std::make_shared<const Image_Slice_Index>(this->imagecoll);
+    }
+    return this->slice_index;
+}
+
+std::shared_ptr<const Time_Course_Tensor> Image_Array::get_time_course_tensor() const {
+    const auto hash = this->content_hash(); // Outside the lock, since hashing runs on the worker pool.
+    std::lock_guard<std::mutex> lock(this->time_course_tensor_m);
+    if( (this->time_course_tensor == nullptr)
+    ||  (this->time_course_tensor_hash != hash)
+    ||  !this->time_course_tensor->is_current(this->imagecoll) ){
+        this->time_course_tensor = std::make_shared<const Time_Course_Tensor>(this->imagecoll, "dt",
+                                                                              this->get_temporal_index());
+        this->time_course_tensor_hash = hash;
+    }
+    return this->time_course_tensor;
+}
+
+std::shared_ptr<const Temporal_Index> Image_Array::get_temporal_index() const {
+    std::lock_guard<std::mutex> lock(this->temporal_index_m);
+    if( (this->temporal_index == nullptr)
+    ||  !this->temporal_index->is_current(this->imagecoll) ){
+        this->temporal_index = std::make_shared<const Temporal_Index>(this->imagecoll);
+    }
+    return this->temporal_index;
+}
+
+std::shared_ptr<const Image_Pyramid> Image_Array::get_image_pyramid(image_pyramid_filter filter) const {
+    const auto hash = this->content_hash(); // Outside the lock, since hashing runs on the worker pool.
+    std::lock_guard<std::mutex> lock(this->image_pyramid_m);
+    auto &cached = this->image_pyramids[filter];
+    if( (cached.second == nullptr)
+    ||  (cached.first != hash)
+    ||  !cached.second->is_current(this->imagecoll) ){
+        cached.second = std::make_shared<const Image_Pyramid>(this->imagecoll, filter);
+        cached.first = hash;
+    }
+    return cached.second;
+}
+
+uint64_t Image_Array::content_hash() const {
+    return Content_Hash(this->imagecoll);
+}
+
+std::map<std::string, std::string> Image_Array::common_metadata() const {
+    std::map<std::string, std::string> common;
+    auto it = std::begin(this->imagecoll.images);
+    const auto end = std::end(this->imagecoll.images);
+    if(it == end) return common;
+
+    common = it->metadata;
+    for(++it; (it != end) && !common.empty(); ++it){
+        for(auto c_it = std::begin(common); c_it != std::end(common); ){
+            const auto m_it = it->metadata.find(c_it->first);
+            if( (m_it == std::end(it->metadata))
+            ||  (m_it->second != c_it->second) ){
+                c_it = common.erase(c_it);
+            }else{
+                ++c_it;
+            }
+        }
+    }
+    return common;
+}
+
+void Image_Array::page_out(size_t max_resident_bytes, const std::string &scratch_dir, voxel_storage storage){
+    this->page_in();
+    this->page_store = std::make_shared<paged_image_store>(this->imagecoll.images, max_resident_bytes,
+                                                           scratch_dir, storage);
+    return;
+}
+
+void Image_Array::page_in(){
+    if(this->page_store == nullptr) return;
+    this->page_store->restore();
+    this->page_store.reset();
+    return;
+}
+
+std::shared_ptr<paged_image_store> Image_Array::get_page_store() const {
+    return this->page_store;
+}
+
+void Image_Array::defer_pixels(std::vector<std::function<void(planar_image<float,double> &)>> sources,
+                               size_t max_resident_bytes,
+                               const std::string &scratch_dir){
+    this->page_in();
+    this->page_store = std::make_shared<paged_image_store>(this->imagecoll.images, std::move(sources),
+                                                           max_resident_bytes, scratch_dir);
+    return;
+}
+
 //---------------------------------------------------------------------------------------------------------------------------
 //-------------------------------------------------------- Point_Cloud ------------------------------------------------------
 //---------------------------------------------------------------------------------------------------------------------------
@@ -547,11 +680,29 @@ Point_Cloud::Point_Cloud(const Point_Cloud &rhs){
 Point_Cloud & Point_Cloud::operator=(const Point_Cloud &rhs){
     //Performs a deep copy (unless copying self).
     if(this != &rhs){
-        this->pset = rhs.pset;
+        this->pset             = rhs.pset;
+        this->point_attributes = rhs.point_attributes;
+        {
+            std::lock_guard<std::mutex> lock(this->kd_tree_m);
+            this->kd_tree.reset();
+        }
     }
     return *this;
 }
 
+std::shared_ptr<const Point_Set_KD_Tree> Point_Cloud::get_kd_tree() const {
+    std::lock_guard<std::mutex> lock(this->kd_tree_m);
+    if( (this->kd_tree == nullptr)
+    ||  !this->kd_tree->is_current(this->pset.points) ){
+        this->kd_tree = std::make_shared<const Point_Set_KD_Tree>(this->pset.points);
+    }
+    return this->kd_tree;
+}
+
+uint64_t Point_Cloud::content_hash() const {
+    return Content_Hash(this->pset);
+}
+
 //---------------------------------------------------------------------------------------------------------------------------
 //---------------------------------------------------- Static_Machine_State -------------------------------------------------
 //---------------------------------------------------------------------------------------------------------------------------
@@ -908,6 +1059,44 @@ template std::optional<float      > TPlan_Config::GetMetadataValueAs(const std::
 template std::optional<double     > TPlan_Config::GetMetadataValueAs(const std::string &) const;
 template std::optional<std::string> TPlan_Config::GetMetadataValueAs(const std::string &) const;
 
+//---------------------------------------------------------------------------------------------------------------------------
+//---------------------------------------------------- attribute_columns ----------------------------------------------------
+//---------------------------------------------------------------------------------------------------------------------------
+bool attribute_columns::contains(const std::string &name) const {
+    return (this->columns.count(name) != 0);
+}
+
+bool attribute_columns::erase(const std::string &name){
+    return (this->columns.erase(name) != 0);
+}
+
+void attribute_columns::clear(){
+    this->columns.clear();
+}
+
+bool attribute_columns::empty() const {
+    return this->columns.empty();
+}
+
+std::any attribute_columns::get_any(const std::string &name) const {
+    const auto it = this->columns.find(name);
+    if(it == std::end(this->columns)) return std::any();
+    return std::visit([](const auto &col) -> std::any { return std::any(col); }, it->second);
+}
+
+void attribute_columns::set_any(const std::string &name, const std::any &val){
+    if(const auto *p = std::any_cast<std::vector<float>>(&val)){
+        this->columns[name] = *p;
+    }else if(const auto *p = std::any_cast<std::vector<double>>(&val)){
+        this->columns[name] = *p;
+    }else if(const auto *p = std::any_cast<std::vector<vec3<double>>>(&val)){
+        this->columns[name] = *p;
+    }else{
+        throw std::invalid_argument("Attribute '" + name + "' does not hold a supported column type");
+    }
+    return;
+}
+
 //---------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------- Surface_Mesh ------------------------------------------------------
 //---------------------------------------------------------------------------------------------------------------------------
@@ -923,10 +1112,40 @@ Surface_Mesh & Surface_Mesh::operator=(const Surface_Mesh &rhs){
         this->meshes            = rhs.meshes;
         this->vertex_attributes = rhs.vertex_attributes;
         this->face_attributes   = rhs.face_attributes;
+        {
+            std::lock_guard<std::mutex> lock(this->bvh_m);
+            this->bvh.reset();
+        }
+        {
+            std::lock_guard<std::mutex> lock(this->adjacency_m);
+            this->adjacency.reset();
+        }
     }
     return *this;
 }
 
+std::shared_ptr<const Surface_Mesh_BVH> Surface_Mesh::get_bvh() const {
+    std::lock_guard<std::mutex> lock(this->bvh_m);
+    if( (this->bvh == nullptr)
+    ||  !this->bvh->is_current(this->meshes) ){
+        this->bvh = std::make_shared<const Surface_Mesh_BVH>(this->meshes);
+    }
+    return this->bvh;
+}
+
+std::shared_ptr<const Surface_Mesh_Adjacency> Surface_Mesh::get_adjacency() const {
+    std::lock_guard<std::mutex> lock(this->adjacency_m);
+    if( (this->adjacency == nullptr)
+    ||  !this->adjacency->is_current(this->meshes) ){
+        this->adjacency = std::make_shared<const Surface_Mesh_Adjacency>(this->meshes);
+    }
+    return this->adjacency;
+}
+
+uint64_t Surface_Mesh::content_hash() const {
+    return Content_Hash(this->meshes);
+}
+
 //---------------------------------------------------------------------------------------------------------------------------
 //-------------------------------------------------------- Line_Sample ------------------------------------------------------
 //---------------------------------------------------------------------------------------------------------------------------
@@ -1019,6 +1238,10 @@ drover_bnded_dose_stat_moments_map_t drover_bnded_dose_stat_moments_map_factory(
     drover_bnded_dose_stat_moments_map_t out(/*25, */bnded_dose_map_cmp_lambda);
     return out;
 }
+drover_bnded_dose_quantiles_map_t drover_bnded_dose_quantiles_map_factory(){
+    drover_bnded_dose_quantiles_map_t out(/*25, */bnded_dose_map_cmp_lambda);
+    return out;
+}
 
 
 
@@ -1027,6 +1250,8 @@ Drover::Drover() = default;
 
 Drover::Drover( const Drover &in ) = default;
 
+Drover::Drover( Drover &&in ) noexcept = default;
+
 //Member functions.
 void Drover::operator=(const Drover &rhs){
     if(this != &rhs){
@@ -1041,6 +1266,49 @@ void Drover::operator=(const Drover &rhs){
     return;
 }
 
+void Drover::operator=(Drover &&rhs) noexcept {
+    if(this != &rhs){
+        this->contour_data    = std::move(rhs.contour_data);
+        this->image_data      = std::move(rhs.image_data);
+        this->point_data      = std::move(rhs.point_data);
+        this->smesh_data      = std::move(rhs.smesh_data);
+        this->tplan_data      = std::move(rhs.tplan_data);
+        this->lsamp_data      = std::move(rhs.lsamp_data);
+        this->trans_data      = std::move(rhs.trans_data);
+    }
+    return;
+}
+
+namespace {
+
+// Emulates the legacy handling of collections without any bounded voxels.
+void fix_empty_min_max(drover_bnded_dose_min_max_dose_map_t &min_max_doses,
+                       const drover_bnded_dose_mean_dose_map_t *mean_doses){
+    for(auto & min_max_dose : min_max_doses){
+        const auto min = min_max_dose.second.first, max = min_max_dose.second.second;
+        if(min > max){
+            //If there was no dose present, this is not an error.
+            bool no_dose = false;
+            if(mean_doses != nullptr){
+                const auto m_it = mean_doses->find(min_max_dose.first);
+                no_dose = (m_it != mean_doses->end()) && (m_it->second == 0.0);
+            }
+            if(no_dose){
+                min_max_dose.second.first  = 0.0;
+                min_max_dose.second.second = 0.0;
+
+            //Otherwise, we don't know if this is an error or not. Issue a warning but do not 
+            // adjust the values.
+            }else{
+                FUNCWARN("Contradictory min = " << min << " and max = " << max);
+            }
+        }
+    }
+    return;
+}
+
+} // namespace
+
 void Drover::Bounded_Dose_General( std::list<double> *pixel_doses, 
                                    drover_bnded_dose_bulk_doses_map_t *bulk_doses, //NOTE: similar to pixel_doses but not all grouped together...
                                    drover_bnded_dose_mean_dose_map_t *mean_doses, 
@@ -1048,12 +1316,8 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
                                    drover_bnded_dose_pos_dose_map_t *pos_doses,
                                    const std::function<bool(bnded_dose_pos_dose_tup_t)>& Fselection,
                                    drover_bnded_dose_stat_moments_map_t *cent_moms ) const {
-    //This function is a general routine for working with pixels bounded by contour data. It *might* be better to stick it in 
-    // the contour or pixel classes, but it seems better (at the moment) to place it in the Drover class, where we have clearly
-    // indicated which contour, which dose pixels, and which CT data we want to work with.
-    //
-    //This function should (probably) only be called internally. Use the wrapper member functions. There is no reason why one
-    // couldn't use this function, however, so do whatever you want to!
+    //This function is a general routine for working with pixels bounded by contour data. It adapts the results of
+    // Compute_Bounded_Dose() to the legacy containers; new code should call Compute_Bounded_Dose() directly.
     //
     //Output options:
     //  std::list<double> *pixel_doses;            <-- Holds the each voxel's dose. Discards spatial info about voxels.
@@ -1061,7 +1325,6 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
     //  ....many more implemented...   They should be fairly self-describing...
     //
     // Pass a pointer to the desired container to compute the desired quantities.
-    auto d = Isolate_Dose_Data(*this);
 
     //----------------------------------------- Sanity/Safety Checks ----------------------------------------
     if((pixel_doses == nullptr) && (mean_doses == nullptr) && (min_max_doses == nullptr) 
@@ -1069,7 +1332,7 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
         FUNCWARN("No valid output pointers provided. Nothing will be computed");
         return;
     }
-    if(!d.Has_Contour_Data() || !d.Has_Image_Data()){
+    if(!this->Has_Contour_Data() || !this->Has_Image_Data()){
         FUNCERR("Attempted to use bounded dose routine, but we do not have contours and/or dose");
     }
     if((pixel_doses != nullptr) && !pixel_doses->empty()){
@@ -1098,210 +1361,56 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
     }
     if((cent_moms != nullptr) && !cent_moms->empty()){
         FUNCWARN("Requesting centralized moments with a non-empty container. Emptying prior to continuing - we require the working space");
-        //Since we have to normalize them at the end, we have to begin with empty space.
+        cent_moms->clear();
     }
 
-    std::list<std::shared_ptr<Image_Array>> dose_data_to_use(d.image_data);
-    if((min_max_doses != nullptr) && (d.image_data.size() > 1)){ //Only dose data meld when needed. Moments, for instance, probably don't need to be melded!
-        dose_data_to_use = Meld_Image_Data(d.image_data);
-        if(dose_data_to_use.size() != 1){
-            FUNCERR("This routine cannot handle multiple dose data which cannot be melded. This has " << dose_data_to_use.size());
-        }
+    bounded_dose_opts opts;
+    opts.doses   = (pixel_doses != nullptr) || (bulk_doses != nullptr);
+    opts.mean    = (mean_doses != nullptr);
+    opts.min_max = (min_max_doses != nullptr);
+    opts.moments = (cent_moms != nullptr);
+    if(pos_doses != nullptr){
+        opts.selector = [&](const bnded_dose_pos_dose_tup_t &tup) -> bool { return Fselection(tup); };
     }
 
-
-    //This is currently ONLY used if (cent_moms != nullptr).
-    auto cc_centroids = drover_bnded_dose_centroid_map_factory();
-
-    for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it){
-        //Push back zeros for the output mean_doses so we can += our results to it. Probably not necessary.
-        if(mean_doses != nullptr) (*mean_doses)[cc_it] = 0.0;
-
-        //Push back impossible values for min/max doses. These will get replaced or will flag an error.
-        if(min_max_doses != nullptr) (*min_max_doses)[cc_it] = std::pair<double,double>(1E99, -1E99); //min, max.
-
-        //Pre-compute centroids for each cc. We do this because we end up looping over cc's and they are fairly costly.
-        if(cent_moms != nullptr) cc_centroids[cc_it] = cc_it->Centroid();
+    bounded_dose_results res;
+    try{
+        res = Compute_Bounded_Dose(*this, opts);
+    }catch(const std::exception &e){
+        FUNCERR("Unable to compute bounded dose: " << e.what());
     }
 
-    //This is used to store info about total accumulated dose and total number of voxels within the contours. 
-    // It can be used to compute the mean doses.
-    // map<cc_iter, pair<Total dose (in unscaled integer units), Number of voxels>>.
-    auto accumulated_dose = drover_bnded_dose_accm_dose_map_factory();
+    size_t i = 0;
+    for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it, ++i){
+        auto &roi = res.rois.at(i);
 
-    //Loop over the attached dose datasets (NOT the dose slices!). It is implied that we have to sum up doses 
-    // from each attached data in order to find the total (actual) dose.
-    //
-    //NOTE: Should I get rid of the idea of cycling through multiple dose data? The only way we get here is if the data
-    // cannot be melded... This is probably not a worthwhile feature to keep in this code.
-    for(auto & dd_it : dose_data_to_use){
-        //Clear the accumulation map/initialize the elements.
-        for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it){
-            accumulated_dose[cc_it] = std::pair<int64_t,int64_t>(0,0);
+        if(pixel_doses != nullptr){
+            pixel_doses->insert(pixel_doses->end(), roi.doses.begin(), roi.doses.end());
         }
-
-        //We now loop through all dose frames (slices) and accumulate dose within the contour bounds.
-        for(auto & image : dd_it->imagecoll.images){
-            //Note: i_it is something like std::list<planar_image<T,R>>::iterator.
-    
-            for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it){
-
-                for(auto c_it = cc_it->contours.begin(); c_it != cc_it->contours.end(); ++c_it){
-                    if(c_it->points.size() < 3) continue;
-
-                    const auto filtering_avg_point = c_it->First_N_Point_Avg(3); //Average_Point(); //Just need a point at the correct height, somewhere inside contour.
-                    if(!image.sandwiches_point_within_top_bottom_planes(filtering_avg_point)) continue;
- 
-                    //Now we have a contour of points and pixel data (note: we can ignore the z components for both) 
-                    // which may or may not lie within the contour. This is called the 'Point-in-polygon' problem and is
-                    // a well-known problem. Unfortunately, it can be a costly problem to solve. We will bound the contour with
-                    // a cartesian bounding box (in the XY plane) and poll each point. We can immediately ignore points outside the box.
-                    // This will save a considerable amount of time for small contours within a large volume, and probably won't greatly
-                    // slow the large contour/large volume case too much.
-                    //
-                    // We then examine line crossings. For a regular polygon, whether or not the number of line crossings (from the point
-                    // to infinity (in this case - the edge of the box)) is even or odd will determine whether or not the point is within
-                    // the contour. I *believe* there would be an issue if the contour would wrap around and touch exactly on some segment
-                    // (like a "C" where the two sharp edges touch to form an "O".) ***BEWARE*** that this is most likely the case!
-                    //
-                    // See http://www.visibone.com/inpoly/ (Accessed Jan 2012,) 
-                    //     http://paulbourke.net/geometry/insidepoly/ (January 2012,)
-                    //     http://stackoverflow.com/questions/217578/point-in-polygon-aka-hit-test (January 2012).
-                    //     NOTE: Some web servers/web applications used to have to implement this routine to deal with image maps. 
-                    //           Check their sources for leads if looking/scrounging for code. I would like a fully 3D version!
-                    //
-                    //     |---------------------|
-                    //     | /-----\  /--------\ |
-                    //     | |     |__|        / |
-                    //     |/                 /  |
-                    //     ||   X            /   |
-                    //     | \______________/    |
-                    //     |---------------------|
-                    //
-                    const contour_of_points<double> BB(c_it->Bounding_Box_Along(vec3<double>(1.0,0.0,0.0)));
-                    const float alrgnum(1E30);
-                    float min_x = alrgnum, max_x = -alrgnum;
-                    float min_y = alrgnum, max_y = -alrgnum;
-                    for(const auto & point : BB.points){
-                        if(point.x < min_x) min_x = point.x;
-                        if(point.x > max_x) max_x = point.x;
-                        if(point.y < min_y) min_y = point.y;
-                        if(point.y > max_y) max_y = point.y;
-                    }
-                    if((min_x == alrgnum) || (min_y == alrgnum) || (max_x == -alrgnum) || (max_y == -alrgnum)){
-                        FUNCERR("Unable to find a reasonable bounding box around this contour");
-                    }
-    
-                    //Now cycle through every pixel in the plane. This is kind of a shit way to do this, but then again this entire program is basically
-                    // a shit way to do it. I would like to have had more time to properly fix/plan/think about what I've got here...  -h
-                    for(long int i=0; i<image.rows; ++i)  for(long int j=0; j<image.columns; ++j){
-                        const auto pos = image.position(i,j);
-                        const float X = pos.x, Y = pos.y;
-    
-                        //Check if it is outside the bounding box.
-                        if(!isininc(min_x,X,max_x) || !isininc(min_y,Y,max_y)) continue;
-    
-                        bool is_in_the_polygon = false;
-                        auto p_j = --(c_it->points.end());
-                        for(auto p_i = c_it->points.begin(); p_i != c_it->points.end(); p_j = (p_i++)){
-                            //If the points cross a line, we simply toggle the 'bool is_in_the_polygon.'
-                            if( ((p_i->y <= Y) && (Y < p_j->y)) || ((p_j->y <= Y) && (Y < p_i->y)) ){ 
-                                const auto B = (p_j->x - p_i->x)*(Y - p_i->y)/(p_j->y - p_i->y);
-                                if(X < (B + p_i->x)){
-                                    is_in_the_polygon = !is_in_the_polygon;
-                                }
-                            }
-                        }
-
-                        if(is_in_the_polygon){
-                            //-----------------------------------------------------------------------------------------------------------------------
-                            //FUNCINFO("Bounding box (x,y)min (x,y)max = (" << min_x << "," << min_y << ") (" << max_x << "," << max_y << ")");
-                            //FUNCINFO("Point has (X,Y) = " << X << " " << Y);
-
-                            //NOTE: Remember: this is some integer representing dose. If we want a clamped [0:1] 
-                            // value, we would use the clamped_channel(...) member instead!
-                            const auto pointval = static_cast<int64_t>(image.value(i,j,0)); //Greyscale or R channel. We assume the channels satisfy: R = G = B.
-                            const auto pointdose = static_cast<double>(pointval); 
-
-                            if(mean_doses != nullptr){
-                                accumulated_dose[cc_it].first  += pointval;
-                                accumulated_dose[cc_it].second += 1;
-                            }
-                            if(bulk_doses != nullptr){
-                                (*bulk_doses)[cc_it].push_back(pointdose);
-                            }
-
-                            if(pixel_doses != nullptr){
-                                pixel_doses->push_back(pointdose); 
-                            }
-
-                            if(min_max_doses != nullptr){
-                                if(pointdose < (*min_max_doses)[cc_it].first)  (*min_max_doses)[cc_it].first  = pointdose; //min.
-                                if(pointdose > (*min_max_doses)[cc_it].second) (*min_max_doses)[cc_it].second = pointdose; //max.
-                            }
-
-                            if(pos_doses != nullptr){
-                                const vec3<double> r_dx = image.row_unit*image.pxl_dx*0.5;
-                                const vec3<double> r_dy = image.col_unit*image.pxl_dy*0.5;
-                                const auto tup = std::make_tuple(pos, r_dx, r_dy, pointdose, i, j);
-
-                                if(Fselection(tup)) (*pos_doses)[cc_it].push_back(tup);
-                            }
-                            if(cent_moms != nullptr){ //Centralized moments. This routine requires a centroid for each cc.
-                                const auto cc_centroid = cc_centroids[cc_it];
-                                for(int p = 0; p < 5; ++p) for(int q = 0; q < 5; ++q) for(int r = 0; r < 5; ++r){
-                                    //const std::array<int,3> triplet = {p,q,r};
-                                    const auto spatial = pow(pos.x-cc_centroid.x,p)*pow(pos.y-cc_centroid.y,q)*pow(pos.z-cc_centroid.z,r);
-                                    const auto grid_factor = image.pxl_dx * image.pxl_dy * image.pxl_dz;
-                                    (*cent_moms)[cc_it][{p,q,r}] += spatial*pointdose*grid_factor;
-                                }
-                            }
-
-                            //-----------------------------------------------------------------------------------------------------------------------
-                        }
-                    }
-                }
-            }
+        if((bulk_doses != nullptr) && !roi.doses.empty()){
+            auto &bulk = (*bulk_doses)[cc_it];
+            bulk.insert(bulk.end(), roi.doses.begin(), roi.doses.end());
         }
-
-        //Determine the mean dose if required.
         if(mean_doses != nullptr){
-            for(auto & it : accumulated_dose){
-                //If there were no voxels within the contour then we have nothing to do.
-                if(it.second.second == 0) continue;
-
-                const auto cc_iter = it.first;
-                const auto ttldose = static_cast<double>(it.second.first);
-                const auto numvxls = static_cast<double>(it.second.second);
-
-                if(ttldose < 0.0) FUNCERR("Total dose was negative (" << ttldose << "). This is not possible");
-                if(numvxls < 0.0) FUNCERR("Total number of voxels was negative (" << numvxls << "). This is not possible");
-
-                (*mean_doses)[cc_iter] += (ttldose/numvxls); //This dose is now in Gy (cGy?)
+            (*mean_doses)[cc_it] = roi.mean;
+        }
+        if(min_max_doses != nullptr){
+            (*min_max_doses)[cc_it] = std::make_pair(roi.min, roi.max);
+        }
+        if((pos_doses != nullptr) && !roi.voxels.empty()){
+            auto &pos = (*pos_doses)[cc_it];
+            std::move(roi.voxels.begin(), roi.voxels.end(), std::back_inserter(pos));
+        }
+        if((cent_moms != nullptr) && (roi.count != 0)){
+            auto &moms = (*cent_moms)[cc_it];
+            for(int p = 0; p < 5; ++p) for(int q = 0; q < 5; ++q) for(int r = 0; r < 5; ++r){
+                moms[{p,q,r}] = roi.moments.at(25*p + 5*q + r);
             }
         }
-    }//Loop over the distinct dose file data.
-
+    }
 
     //Verification.
-    if(min_max_doses != nullptr){
-         for(auto & min_max_dose : *min_max_doses){
-             const auto min = min_max_dose.second.first, max = min_max_dose.second.second;
-             if(min > max){
-                 //If there was no dose present, this is not an error.
-                 const auto cc_iter = min_max_dose.first;
-                 if((mean_doses != nullptr) && (mean_doses->find(cc_iter) != mean_doses->end()) && ((*mean_doses)[cc_iter] == 0.0)){
-                     min_max_dose.second.first  = 0.0;
-                     min_max_dose.second.second = 0.0;
-
-                 //Otherwise, we don't know if this is an error or not. Issue a warning but do not 
-                 // adjust the values.
-                 }else{
-                     FUNCWARN("Contradictory min = " << min << " and max = " << max);
-                 }
-             }
-         }
-    }
+    if(min_max_doses != nullptr) fix_empty_min_max(*min_max_doses, mean_doses);
     return;
 }
 
@@ -1340,15 +1449,11 @@ drover_bnded_dose_min_mean_max_dose_map_t Drover::Bounded_Dose_Min_Mean_Max() co
     auto minmaxs = drover_bnded_dose_min_max_dose_map_factory();
     this->Bounded_Dose_General(nullptr,nullptr,&means,&minmaxs,nullptr,nullptr,nullptr);
 
-    if(means.size() != minmaxs.size()){
-        FUNCERR("Number of means did not match number of min/maxs. Must have encountered a computational error");
-    }
-
     for(auto & it : means){
         const auto theiter = it.first;
-        const auto min    = minmaxs[theiter].first;
+        const auto min    = minmaxs.at(theiter).first;
         const auto mean   = it.second;
-        const auto max    = minmaxs[theiter].second;
+        const auto max    = minmaxs.at(theiter).second;
         outgoing[theiter] = std::make_tuple(min, mean, max); 
     }
     return outgoing;
@@ -1358,22 +1463,56 @@ drover_bnded_dose_min_mean_median_max_dose_map_t Drover::Bounded_Dose_Min_Mean_M
     //NOTE: See note in Drover::Bounded_Dose_Means() regarding invalidation of this map.
     auto outgoing = drover_bnded_dose_min_mean_median_max_dose_map_factory();
 
-    auto means   = drover_bnded_dose_mean_dose_map_factory();
-    auto minmaxs = drover_bnded_dose_min_max_dose_map_factory();
-    auto bulks   = drover_bnded_dose_bulk_doses_map_factory();
-    this->Bounded_Dose_General(nullptr,&bulks,&means,&minmaxs,nullptr,nullptr,nullptr);
+    bounded_dose_opts opts;
+    opts.mean = true;
+    opts.min_max = true;
+    opts.quantiles = { 0.5 };
+    bounded_dose_results res;
+    try{
+        res = Compute_Bounded_Dose(*this, opts);
+    }catch(const std::exception &e){
+        FUNCERR("Unable to compute bounded dose: " << e.what());
+    }
+
+    size_t i = 0;
+    for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it, ++i){
+        const auto &roi = res.rois.at(i);
+        auto min = roi.min;
+        auto max = roi.max;
+        if(min > max){
+            //If there was no dose present, this is not an error.
+            if(roi.mean == 0.0){
+                min = 0.0;
+                max = 0.0;
+            }else{
+                FUNCWARN("Contradictory min = " << min << " and max = " << max);
+            }
+        }
+        outgoing[cc_it] = std::make_tuple(min, roi.mean, roi.quantiles.at(0), max);
+    }
+    return outgoing;
+}
 
-    if(means.size() != minmaxs.size()){
-        FUNCERR("Number of means did not match number of min/maxs. Must have encountered a computational error");
+drover_bnded_dose_quantiles_map_t Drover::Bounded_Dose_Quantiles(const std::vector<double> &fractions) const {
+    //NOTE: See note in Drover::Bounded_Dose_Means() regarding invalidation of this map.
+    //
+    //NOTE: The quantiles are returned in the order the fractions were given. The dose to the hottest x% of a
+    //      collection (i.e., D_{x%}) corresponds to the fraction (1 - x/100).
+    auto outgoing = drover_bnded_dose_quantiles_map_factory();
+
+    bounded_dose_opts opts;
+    opts.quantiles = fractions;
+    bounded_dose_results res;
+    try{
+        res = Compute_Bounded_Dose(*this, opts);
+    }catch(const std::exception &e){
+        FUNCERR("Unable to compute bounded dose: " << e.what());
     }
 
-    for(auto & it : means){
-        const auto theiter = it.first;
-        const auto min    = minmaxs[theiter].first;
-        const auto mean   = it.second;
-        const auto median = Stats::Median(bulks[theiter]);
-        const auto max    = minmaxs[theiter].second;
-        outgoing[theiter] = std::make_tuple(min, mean, median, max);
+    size_t i = 0;
+    for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it, ++i){
+        auto &roi = res.rois.at(i);
+        if(roi.count != 0) outgoing[cc_it] = std::move(roi.quantiles);
     }
     return outgoing;
 }
@@ -1416,6 +1555,9 @@ Drover Drover::Segment_Contours_Heuristically(const std::function<bool(bnded_dos
  
     if(!Fselection) FUNCERR("Passed an unaccessible heuristic function. Unable to continue");
 
+    //The contours are replaced below, so the copy must not share them with this Drover.
+    Detach_Shared(out.contour_data);
+
     //First, get the positional dose data (using the copy).
     auto pos_dose = drover_bnded_dose_pos_dose_map_factory();
     out.Bounded_Dose_General(nullptr,nullptr,nullptr,nullptr,&pos_dose,Fselection,nullptr);
@@ -1491,17 +1633,43 @@ Drover Drover::Segment_Contours_Heuristically(const std::function<bool(bnded_dos
 }
 
 std::pair<double,double> Drover::Bounded_Dose_Limits() const {
-    std::list<double> doses;
-    this->Bounded_Dose_General(&doses,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr);
-    if(doses.empty()) return std::pair<double,double>(-1.0,-1.0);
-
-    return std::pair<double,double>(*std::min_element(doses.begin(),doses.end()), *std::max_element(doses.begin(),doses.end()));
+    bounded_dose_opts opts;
+    bounded_dose_results res;
+    try{
+        res = Compute_Bounded_Dose(*this, opts);
+    }catch(const std::exception &e){
+        FUNCERR("Unable to compute bounded dose: " << e.what());
+    }
+
+    //Note: the arrays are not melded, so these are the limits of the individual voxels.
+    std::pair<double,double> out(1E99, -1E99);
+    int64_t count = 0;
+    for(const auto &roi : res.rois){
+        count += roi.count;
+        out.first  = std::min(out.first, roi.min);
+        out.second = std::max(out.second, roi.max);
+    }
+    if(count == 0) return std::pair<double,double>(-1.0,-1.0);
+    return out;
 }
 
 std::map<double,double>  Drover::Get_DVH() const {
     std::map<double,double> output;
 
-    std::list<double> pixel_doses = this->Bounded_Dose_Bulk_Values();
+    bounded_dose_opts opts;
+    opts.doses = true;
+    bounded_dose_results res;
+    try{
+        res = Compute_Bounded_Dose(*this, opts);
+    }catch(const std::exception &e){
+        FUNCERR("Unable to compute bounded dose: " << e.what());
+    }
+
+    std::vector<double> pixel_doses;
+    for(auto &roi : res.rois){
+        pixel_doses.insert(pixel_doses.end(), roi.doses.begin(), roi.doses.end());
+        roi.doses = std::vector<double>();
+    }
     if(pixel_doses.empty()){
         //FUNCERR("Unable to compute DVH: There was no data in the pixel_doses structure!");
         FUNCWARN("Asked to compute DVH when no voxels appear to have any dose. This is physically possible, but please be sure it is what you expected");
@@ -1513,19 +1681,19 @@ std::map<double,double>  Drover::Get_DVH() const {
         return output;
     }
 
-    double cumulative;
+    //Sorting lets each bin be counted with a binary search rather than a pass over every voxel.
+    std::sort(pixel_doses.begin(), pixel_doses.end());
+    size_t cumulative;
     double test_dose = 0.0;
     do{
-        cumulative = 0.0;
-        for(double & pixel_dose : pixel_doses){
-            if(pixel_dose > test_dose) cumulative += 1.0;
-        }
+        cumulative = static_cast<size_t>(std::distance(std::upper_bound(pixel_doses.begin(), pixel_doses.end(), test_dose),
+                                                       pixel_doses.end()));
 
         const auto dose = test_dose;
         const auto frac = static_cast<double>(cumulative) / static_cast<double>(pixel_doses.size());
         output[dose] = frac;
         test_dose += 0.5;
-    }while(cumulative != 0.0);
+    }while(cumulative != 0);
     return output;
 }
 
@@ -1614,8 +1782,8 @@ void Drover::Concatenate(const std::shared_ptr<Contour_Data>& in){
     }
 
     auto dup = in->Duplicate();
-    this->contour_data->ccs.splice( this->contour_data->ccs.end(),
-                                    std::move(dup->ccs) );
+    auto &cd = Detach_Shared(this->contour_data); // *this' contours might have been shared with another owner.
+    cd.ccs.splice( cd.ccs.end(), std::move(dup->ccs) );
     return;
 }
 
@@ -1671,11 +1839,8 @@ void Drover::Consume(const std::shared_ptr<Contour_Data>& in){
     //       contour collection from a variety of sources.
     //
     if(in == nullptr) return;
-    if(this->contour_data == nullptr){
-        this->contour_data = std::make_shared<Contour_Data>();
-    }
-    this->contour_data->ccs.splice( this->contour_data->ccs.end(),
-                                    std::move(in->ccs) );
+    auto &cd = Detach_Shared(this->contour_data); // *this' contours might have been shared with another owner.
+    cd.ccs.splice( cd.ccs.end(), std::move(in->ccs) );
     in->ccs.clear();
     return;
 }
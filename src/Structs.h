@@ -3,11 +3,15 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <optional>
 #include <initializer_list>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <tuple>
@@ -21,6 +25,8 @@
 #include "YgorMath.h"
 
 #include "Alignment_TPSRPM.h"
+#include "Alignment_Field.h"
+#include "Compact_Voxels.h"
 
 
 //This is a wrapper around the YgorMath.h class "contour_of_points." It holds an instance of a contour_of_points, but also provides some meta information
@@ -80,6 +86,10 @@ class Contour_Data {
         //Member functions.
         void operator = (const Contour_Data &rhs);
 
+        //A hash of the data, recomputed on every call so that in-place edits of the public members are always
+        // reflected. Cached derived data (e.g., spatial indices and ROI masks) are validated against it.
+        uint64_t content_hash() const;
+
         void Plot() const;     //Spits out a default plot of the (entirety) of the data. Use the contour_of_points::Plot() method for individual contours.
     
         //Unique duplication (aka 'copy factory').
@@ -114,6 +124,13 @@ std::unique_ptr<Contour_Data> Split_Per_Volume_Along_Transverse_Plane() const;
 };
 
 
+class Image_Slice_Index;
+class Image_Pyramid;
+enum class image_pyramid_filter;
+class Temporal_Index;
+class Time_Course_Tensor;
+class paged_image_store;
+
 class Image_Array { //: public Base_Array {
     public:
 
@@ -127,34 +144,152 @@ class Image_Array { //: public Base_Array {
 
         //Member functions.
         Image_Array & operator=(const Image_Array &rhs); //Performs a deep copy (unless copying self).
+
+        //Returns an index for quickly locating the images which encompass a point. The index is cached and is rebuilt
+        // whenever images are found to have been added, removed, or repositioned. Callers performing many lookups
+        // should retrieve the index once and must not modify imagecoll while using it.
+        std::shared_ptr<const Image_Slice_Index> get_slice_index() const;
+
+        //Returns voxel time courses for the (spatially-grouped, temporally-ordered) images. The tensor is cached and is
+        // rebuilt whenever images are found to have been added or removed, or their content has changed. Operations
+        // alter pixel values in-place, so the images are hashed on every call.
+        std::shared_ptr<const Time_Course_Tensor> get_time_course_tensor() const;
+
+        //Returns the (parsed, time-ordered) image times, for locating images by time. The index is cached and is
+        // rebuilt whenever images are found to have been added or removed, or their time metadata has changed. The
+        // time course tensor shares this index.
+        std::shared_ptr<const Temporal_Index> get_temporal_index() const;
+
+        //Returns reduced-resolution copies of the images (see Image_Pyramid), so consumers needing coarse levels can
+        // share them. Each filter's pyramid is cached, and its levels are built on first access. The pyramid is rebuilt
+        // whenever images are found to have been added or removed, or their content has changed. As for the time
+        // course tensor, the images are hashed on every call.
+        std::shared_ptr<const Image_Pyramid> get_image_pyramid(image_pyramid_filter filter) const;
+
+        uint64_t content_hash() const; //See Contour_Data::content_hash().
+
+        //Returns the metadata entries (key and value) shared by every image. Writers can store these once per array
+        // and only the remainder per image. Empty if there are no images.
+        std::map<std::string, std::string> common_metadata() const;
+
+        //Moves the pixel data into an out-of-core store (see paged_image_store), keeping at most the given number of
+        // bytes resident, so arrays larger than memory can be streamed through slice-local operations. Until
+        // page_in() is called, pixel data must only be accessed through the store. Copies of a paged-out array are
+        // fully resident.
+        //
+        //Paged-out pixel data can instead be held in memory with reduced precision (see Compact_Voxels.h).
+        void page_out(size_t max_resident_bytes,
+                      const std::string &scratch_dir = "",
+                      voxel_storage storage = voxel_storage::float32);
+        void page_in();
+        std::shared_ptr<paged_image_store> get_page_store() const; //nullptr unless paged-out.
+
+        //Attaches a store, as with page_out(), but the pixel data of images with a source is only produced when first
+        // accessed. Such images must have an empty pixel buffer. There must be one source (or an empty function) per
+        // image, in list order.
+        void defer_pixels(std::vector<std::function<void(planar_image<float,double> &)>> sources,
+                          size_t max_resident_bytes = std::numeric_limits<size_t>::max(),
+                          const std::string &scratch_dir = "");
+
+    private:
+        mutable std::mutex slice_index_m;
+        mutable std::shared_ptr<const Image_Slice_Index> slice_index;
+        mutable std::mutex temporal_index_m;
+        mutable std::shared_ptr<const Temporal_Index> temporal_index;
+        mutable std::mutex time_course_tensor_m;
+        mutable std::shared_ptr<const Time_Course_Tensor> time_course_tensor;
+        mutable uint64_t time_course_tensor_hash = 0;
+        mutable std::mutex image_pyramid_m;
+        mutable std::map<image_pyramid_filter,
+                         std::pair<uint64_t, std::shared_ptr<const Image_Pyramid>>> image_pyramids; //(hash, pyramid)
+        std::shared_ptr<paged_image_store> page_store;
 };
 
 
+// Named columns of per-element values (e.g., one value per mesh vertex). Each column holds a single type and its
+// values are stored contiguously, so they can be processed with simple loops and serialized in bulk.
+//
+// Columns are not updated when the elements they describe are added, removed, or renumbered. Code altering the
+// elements should update or clear the columns.
+class attribute_columns {
+    public:
+        using column_t = std::variant< std::vector<float>,
+                                       std::vector<double>,
+                                       std::vector<vec3<double>> >;
+        std::map<std::string, column_t> columns;
+
+        //Returns the named column if it exists and holds the requested type, otherwise nullptr.
+        template <class T> std::vector<T> * get(const std::string &name){
+            const auto it = this->columns.find(name);
+            return (it == std::end(this->columns)) ? nullptr : std::get_if<std::vector<T>>(&(it->second));
+        }
+        template <class T> const std::vector<T> * get(const std::string &name) const {
+            const auto it = this->columns.find(name);
+            return (it == std::end(this->columns)) ? nullptr : std::get_if<std::vector<T>>(&(it->second));
+        }
+
+        //Creates (or replaces) the named column with N copies of the given value.
+        template <class T> std::vector<T> & emplace(const std::string &name, size_t N, const T &val = T()){
+            auto &col = this->columns[name];
+            col = std::vector<T>(N, val);
+            return std::get<std::vector<T>>(col);
+        }
+
+        bool contains(const std::string &name) const;
+        bool erase(const std::string &name); //Returns true if a column was removed.
+        void clear();
+        bool empty() const;
+
+        //Compatibility with dynamically-typed (std::any) attributes. Columns are exchanged as a std::any holding a
+        // std::vector of the column's type. set_any() throws if the value does not hold a supported column type.
+        std::any get_any(const std::string &name) const; //Empty if the column does not exist.
+        void set_any(const std::string &name, const std::any &val);
+};
+
+
+class Point_Set_KD_Tree;
+
 // This class is meant to hold a simple 3D point cloud.
 class Point_Cloud {
     public:
 
         point_set<double> pset;
 
+        // Used for defining attributes at run-time, e.g., per-point intensity. Columns should have one value per point.
+        attribute_columns point_attributes;
+
         //Constructor/Destructors.
         Point_Cloud();
         Point_Cloud(const Point_Cloud &rhs); //Performs a deep copy (unless copying self).
 
         //Member functions.
         Point_Cloud & operator=(const Point_Cloud &rhs); //Performs a deep copy (unless copying self).
+
+        uint64_t content_hash() const; //See Contour_Data::content_hash().
+
+        //Returns a k-d tree for nearest-neighbour and neighbourhood queries. The tree is cached and is rebuilt whenever
+        // the points are found to have changed. Callers must not modify the points while using it.
+        std::shared_ptr<const Point_Set_KD_Tree> get_kd_tree() const;
+
+    private:
+        mutable std::mutex kd_tree_m;
+        mutable std::shared_ptr<const Point_Set_KD_Tree> kd_tree;
 };
 
 
+class Surface_Mesh_BVH;
+class Surface_Mesh_Adjacency;
+
 // This class is meant to hold multiple surface meshes that represent a single logical object.
 class Surface_Mesh {
     public:
 
         fv_surface_mesh<double, uint64_t> meshes;
 
-        // Used for defining attributes at run-time.
-        // The std::any can be replaced by something like std::map<size_t, double> but doesn't have to.
-        std::map< std::string, std::any > vertex_attributes; 
-        std::map< std::string, std::any > face_attributes; 
+        // Used for defining attributes at run-time, e.g., per-vertex dose or curvature. Columns should have one value
+        // per vertex or face, respectively.
+        attribute_columns vertex_attributes;
+        attribute_columns face_attributes;
 
         //Constructor/Destructors.
         Surface_Mesh();
@@ -162,6 +297,22 @@ class Surface_Mesh {
 
         //Member functions.
         Surface_Mesh & operator=(const Surface_Mesh &rhs); //Performs a deep copy (unless copying self).
+
+        //Returns a bounding volume hierarchy for ray-mesh intersection queries. The hierarchy is cached and is rebuilt
+        // whenever the mesh vertices or faces are found to have changed. Callers must not modify the mesh while using it.
+        std::shared_ptr<const Surface_Mesh_BVH> get_bvh() const;
+
+        //Returns the connectivity (vertex-face and vertex-edge lists, an edge lookup table, and half-edge twins) of the
+        // mesh. Like the BVH, it is cached and rebuilt whenever the mesh faces are found to have changed.
+        std::shared_ptr<const Surface_Mesh_Adjacency> get_adjacency() const;
+
+        uint64_t content_hash() const; //See Contour_Data::content_hash().
+
+    private:
+        mutable std::mutex bvh_m;
+        mutable std::shared_ptr<const Surface_Mesh_BVH> bvh;
+        mutable std::mutex adjacency_m;
+        mutable std::shared_ptr<const Surface_Mesh_Adjacency> adjacency;
 };
 
 
@@ -298,7 +449,8 @@ class Transform3 {
 
         std::variant< std::monostate,
                       affine_transform<double>,
-                      thin_plate_spline > transform;
+                      thin_plate_spline,
+                      deformation_field > transform;
 
         std::map< std::string, std::string > metadata; //User-defined metadata.
 
@@ -394,6 +546,7 @@ typedef std::map<bnded_dose_map_key_t,std::tuple<double,double,double,double>,
 typedef std::tuple<vec3<double>,vec3<double>,vec3<double>,double,long int,long int> bnded_dose_pos_dose_tup_t;
 typedef std::map<bnded_dose_map_key_t,std::list<bnded_dose_pos_dose_tup_t>,         bnded_dose_map_cmp_func_t>  drover_bnded_dose_pos_dose_map_t; 
 typedef std::map<bnded_dose_map_key_t,std::map<std::array<int,3>,double>,           bnded_dose_map_cmp_func_t>  drover_bnded_dose_stat_moments_map_t;
+typedef std::map<bnded_dose_map_key_t,std::vector<double>,                          bnded_dose_map_cmp_func_t>  drover_bnded_dose_quantiles_map_t;
 
 drover_bnded_dose_mean_dose_map_t                drover_bnded_dose_mean_dose_map_factory();
 drover_bnded_dose_centroid_map_t                 drover_bnded_dose_centroid_map_factory();
@@ -404,6 +557,24 @@ drover_bnded_dose_min_mean_max_dose_map_t        drover_bnded_dose_min_mean_max_
 drover_bnded_dose_min_mean_median_max_dose_map_t drover_bnded_dose_min_mean_median_max_dose_map_factory();
 drover_bnded_dose_pos_dose_map_t                 drover_bnded_dose_pos_dose_map_factory();
 drover_bnded_dose_stat_moments_map_t             drover_bnded_dose_stat_moments_map_factory();
+drover_bnded_dose_quantiles_map_t                drover_bnded_dose_quantiles_map_factory();
+
+// Copy-on-write support.
+//
+// Copying a Drover is shallow: copies share ownership of the underlying data, so passing a Drover between operations
+// does not duplicate anything. Code that modifies data which might be shared with another owner should call this
+// routine first. The pointee is deep-copied only if other owners exist, so uniquely-owned data is modified in-place.
+// A nullptr is replaced with a default-constructed object.
+template <class T>
+T &
+Detach_Shared(std::shared_ptr<T> &ptr){
+    if(ptr == nullptr){
+        ptr = std::make_shared<T>();
+    }else if(ptr.use_count() != 1){
+        ptr = std::make_shared<T>(*ptr);
+    }
+    return *ptr;
+}
 
 class Drover {
     public:
@@ -418,10 +589,12 @@ class Drover {
     
         //Constructors.
         Drover();
-        Drover(const Drover &in);
+        Drover(const Drover &in); //Shallow; data is shared.
+        Drover(Drover &&in) noexcept;
     
         //Member functions.
-        void operator = (const Drover &rhs);
+        void operator = (const Drover &rhs); //Shallow; data is shared.
+        void operator = (Drover &&rhs) noexcept;
         void Bounded_Dose_General( std::list<double> *pixel_doses, 
                                    drover_bnded_dose_bulk_doses_map_t *bulk_doses, //NOTE: Similar to pixel_doses, but not all in a single bunch.
                                    drover_bnded_dose_mean_dose_map_t *mean_doses, 
@@ -435,6 +608,7 @@ class Drover {
         drover_bnded_dose_min_max_dose_map_t Bounded_Dose_Min_Max() const;  //Get the min & max dose for each contour collection. See note in source.
         drover_bnded_dose_min_mean_max_dose_map_t Bounded_Dose_Min_Mean_Max() const;  // " " " " ...
         drover_bnded_dose_min_mean_median_max_dose_map_t Bounded_Dose_Min_Mean_Median_Max() const; // " " " " ...
+        drover_bnded_dose_quantiles_map_t Bounded_Dose_Quantiles(const std::vector<double> &fractions) const; //Fractions in [0:1].
         drover_bnded_dose_stat_moments_map_t Bounded_Dose_Centralized_Moments() const;
         drover_bnded_dose_stat_moments_map_t Bounded_Dose_Normalized_Cent_Moments() const;
     
@@ -15,10 +15,11 @@
 
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/list.hpp>
-//#include <boost/serialization/vector.hpp>
+#include <boost/serialization/vector.hpp>
 //#include <boost/serialization/map.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/version.hpp>
+#include <boost/serialization/split_free.hpp>
 
 #include "Structs.h"
 
@@ -62,12 +63,55 @@ template<typename Archive>
 void serialize(Archive &a, Point_Cloud &p, const unsigned int version){
     if(version == 0){
         a & boost::serialization::make_nvp("pset",p.pset);
+    }else if(version == 1){
+        a & boost::serialization::make_nvp("pset",p.pset)
+          & boost::serialization::make_nvp("point_attributes",p.point_attributes);
     }else{
         FUNCWARN("Point_Cloud archives with version " << version << " are not recognized");
     }
     return;
 }
 
+//Class: attribute_columns.
+template<typename Archive>
+void save(Archive &a, const attribute_columns &c, const unsigned int /*version*/){
+    uint64_t N_columns = c.columns.size();
+    a << boost::serialization::make_nvp("N_columns",N_columns);
+    for(const auto &col : c.columns){
+        std::string name = col.first;
+        uint32_t type = static_cast<uint32_t>(col.second.index());
+        a << boost::serialization::make_nvp("name",name)
+          << boost::serialization::make_nvp("type",type);
+        std::visit([&](const auto &values){
+            a << boost::serialization::make_nvp("values",values);
+        }, col.second);
+    }
+    return;
+}
+
+template<typename Archive>
+void load(Archive &a, attribute_columns &c, const unsigned int /*version*/){
+    c.clear();
+    uint64_t N_columns = 0;
+    a >> boost::serialization::make_nvp("N_columns",N_columns);
+    for(uint64_t i = 0; i < N_columns; ++i){
+        std::string name;
+        uint32_t type = 0;
+        a >> boost::serialization::make_nvp("name",name)
+          >> boost::serialization::make_nvp("type",type);
+        if(type == 0){
+            a >> boost::serialization::make_nvp("values",c.emplace<float>(name, 0));
+        }else if(type == 1){
+            a >> boost::serialization::make_nvp("values",c.emplace<double>(name, 0));
+        }else if(type == 2){
+            a >> boost::serialization::make_nvp("values",c.emplace<vec3<double>>(name, 0));
+        }else{
+            throw std::runtime_error("Attribute column type not recognized. Cannot continue.");
+        }
+    }
+    return;
+}
+
 //Class: Surface_Mesh.
 template<typename Archive>
 void serialize(Archive &a, Surface_Mesh &p, const unsigned int version){
@@ -76,6 +120,10 @@ void serialize(Archive &a, Surface_Mesh &p, const unsigned int version){
         //       Until a suitable reflection mechanism is located, we are stuck ignoring members
         //       that make use of std::any.
         a & boost::serialization::make_nvp("meshes",p.meshes);
+    }else if(version == 1){
+        a & boost::serialization::make_nvp("meshes",p.meshes)
+          & boost::serialization::make_nvp("vertex_attributes",p.vertex_attributes)
+          & boost::serialization::make_nvp("face_attributes",p.face_attributes);
     }else{
         FUNCWARN("Surface_Mesh archives with version " << version << " are not recognized");
     }
@@ -198,9 +246,14 @@ void serialize(Archive &a, Drover &d, const unsigned int version){
 //BOOST_CLASS_VERSION(Image_Array, 0); // Initial version number.
 BOOST_CLASS_VERSION(Image_Array, 1) // After removing the disused 'bits' and 'filename' members.
 
-BOOST_CLASS_VERSION(Point_Cloud, 0) // Initial version number.
+//BOOST_CLASS_VERSION(Point_Cloud, 0) // Initial version number.
+BOOST_CLASS_VERSION(Point_Cloud, 1) // After adding typed point attribute columns.
+
+BOOST_SERIALIZATION_SPLIT_FREE(attribute_columns)
+BOOST_CLASS_VERSION(attribute_columns, 0) // Initial version number.
 
-BOOST_CLASS_VERSION(Surface_Mesh, 0) // Initial version number, effectively just a fv_surface_mesh wrapper class.
+//BOOST_CLASS_VERSION(Surface_Mesh, 0) // Initial version number, effectively just a fv_surface_mesh wrapper class.
+BOOST_CLASS_VERSION(Surface_Mesh, 1) // After adding typed vertex and face attribute columns.
 
 BOOST_CLASS_VERSION(Static_Machine_State, 0) // Initial version number.
 BOOST_CLASS_VERSION(Dynamic_Machine_State, 0) // Initial version number.
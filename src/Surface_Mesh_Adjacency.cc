@@ -0,0 +1,262 @@
+//Surface_Mesh_Adjacency.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+
+#include "Thread_Pool.h"
+
+#include "Surface_Mesh_Adjacency.h"
+
+
+namespace {
+
+uint64_t Mix(uint64_t h){
+    // Finalizer from splitmix64.
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+// Converts per-item counts into offsets, returning the total.
+uint64_t Exclusive_Scan(std::vector<uint64_t> &counts){
+    uint64_t offset = 0;
+    for(auto &c : counts){
+        const auto n = c;
+        c = offset;
+        offset += n;
+    }
+    return offset;
+}
+
+} // namespace
+
+
+Surface_Mesh_Adjacency::Surface_Mesh_Adjacency(const fv_surface_mesh<double, uint64_t> &mesh)
+  : N_vertices(static_cast<uint64_t>(mesh.vertices.size())),
+    N_faces(static_cast<uint64_t>(mesh.faces.size())) {
+
+    // Half-edges, one per face corner.
+    this->face_begin.assign(this->N_faces + 1, 0);
+    for(uint64_t f = 0; f < this->N_faces; ++f){
+        for(const auto &v : mesh.faces[f]){
+            if(this->N_vertices <= v){
+                throw std::invalid_argument("Face refers to a non-existent vertex. Cannot build adjacency.");
+            }
+        }
+        this->face_begin[f + 1] = this->face_begin[f] + static_cast<uint64_t>(mesh.faces[f].size());
+    }
+    const uint64_t N_he = this->face_begin[this->N_faces];
+
+    this->he_vertex.resize(N_he);
+    this->he_face.resize(N_he);
+    parallel_for(0, static_cast<long int>(this->N_faces), [&](long int f) -> void {
+        const auto &face = mesh.faces[f];
+        const auto b = this->face_begin[f];
+        for(size_t j = 0; j < face.size(); ++j){
+            this->he_vertex[b + j] = face[j];
+            this->he_face[b + j] = static_cast<uint64_t>(f);
+        }
+    });
+
+    // Outgoing half-edges (and thus incident faces) of each vertex, ordered by half-edge.
+    this->vh_offsets.assign(this->N_vertices + 1, 0);
+    for(const auto &v : this->he_vertex) ++this->vh_offsets[v];
+    Exclusive_Scan(this->vh_offsets);
+    this->vh_half_edges.resize(N_he);
+    {
+        auto fill = this->vh_offsets;
+        for(uint64_t h = 0; h < N_he; ++h) this->vh_half_edges[ fill[this->he_vertex[h]]++ ] = h;
+    }
+    this->vf_faces.resize(N_he);
+    parallel_for(0, static_cast<long int>(N_he), [&](long int i) -> void {
+        this->vf_faces[i] = this->he_face[ this->vh_half_edges[i] ];
+    });
+
+    // Group half-edges by their smaller vertex. Within each group, sorting by the larger vertex places the half-edges
+    // of each edge together, and concatenating the groups lists the half-edges of every edge in edge order.
+    std::vector<uint64_t> lo_offsets(this->N_vertices + 1, 0);
+    const auto lo_hi = [&](uint64_t h) -> std::pair<uint64_t, uint64_t> {
+        const auto a = this->tail(h);
+        const auto b = this->head(h);
+        return (a < b) ? std::make_pair(a, b) : std::make_pair(b, a);
+    };
+    for(uint64_t h = 0; h < N_he; ++h) ++lo_offsets[lo_hi(h).first];
+    Exclusive_Scan(lo_offsets);
+    this->eh_half_edges.resize(N_he);
+    {
+        auto fill = lo_offsets;
+        for(uint64_t h = 0; h < N_he; ++h) this->eh_half_edges[ fill[lo_hi(h).first]++ ] = h;
+    }
+
+    std::vector<uint64_t> edges_per_lo(this->N_vertices + 1, 0);
+    parallel_for(0, static_cast<long int>(this->N_vertices), [&](long int v) -> void {
+        const auto b = std::next(std::begin(this->eh_half_edges), lo_offsets[v]);
+        const auto e = std::next(std::begin(this->eh_half_edges), lo_offsets[v + 1]);
+        std::sort(b, e, [&](uint64_t h_a, uint64_t h_b) -> bool {
+            return std::make_pair(lo_hi(h_a).second, h_a) < std::make_pair(lo_hi(h_b).second, h_b);
+        });
+        uint64_t n = 0;
+        for(auto it = b; it != e; ++it){
+            if( (it == b) || (lo_hi(*std::prev(it)).second != lo_hi(*it).second) ) ++n;
+        }
+        edges_per_lo[v] = n;
+    });
+    const auto N_edges = Exclusive_Scan(edges_per_lo);
+
+    this->edge_v0.resize(N_edges);
+    this->edge_v1.resize(N_edges);
+    this->eh_offsets.resize(N_edges + 1);
+    this->eh_offsets[N_edges] = N_he;
+    this->he_edge.resize(N_he);
+    parallel_for(0, static_cast<long int>(this->N_vertices), [&](long int v) -> void {
+        uint64_t e = edges_per_lo[v];
+        for(uint64_t i = lo_offsets[v]; i < lo_offsets[v + 1]; ++i){
+            const auto h = this->eh_half_edges[i];
+            const auto hi = lo_hi(h).second;
+            if( (i == lo_offsets[v]) || (lo_hi(this->eh_half_edges[i - 1]).second != hi) ){
+                if(i != lo_offsets[v]) ++e;
+                this->edge_v0[e] = static_cast<uint64_t>(v);
+                this->edge_v1[e] = hi;
+                this->eh_offsets[e] = i;
+            }
+            this->he_edge[h] = e;
+        }
+    });
+
+    // Twins exist only for manifold edges.
+    this->he_twin.assign(N_he, none);
+    parallel_for(0, static_cast<long int>(N_edges), [&](long int e) -> void {
+        if( this->is_manifold_edge(e)
+        &&  !this->is_boundary_edge(e) ){
+            const auto h_a = this->eh_half_edges[ this->eh_offsets[e] ];
+            const auto h_b = this->eh_half_edges[ this->eh_offsets[e] + 1 ];
+            this->he_twin[h_a] = h_b;
+            this->he_twin[h_b] = h_a;
+        }
+    });
+
+    // Incident edges of each vertex, ordered by edge.
+    this->ve_offsets.assign(this->N_vertices + 1, 0);
+    for(uint64_t e = 0; e < N_edges; ++e){
+        ++this->ve_offsets[this->edge_v0[e]];
+        if(this->edge_v0[e] != this->edge_v1[e]) ++this->ve_offsets[this->edge_v1[e]];
+    }
+    const auto N_ve = Exclusive_Scan(this->ve_offsets);
+    this->ve_edges.resize(N_ve);
+    {
+        auto fill = this->ve_offsets;
+        for(uint64_t e = 0; e < N_edges; ++e){
+            this->ve_edges[ fill[this->edge_v0[e]]++ ] = e;
+            if(this->edge_v0[e] != this->edge_v1[e]) this->ve_edges[ fill[this->edge_v1[e]]++ ] = e;
+        }
+    }
+
+    // Edge lookup table, kept at most half full.
+    {
+        uint64_t capacity = 1;
+        while(capacity < 2 * N_edges) capacity *= 2;
+        this->edge_table.assign((N_edges == 0) ? 0 : capacity, none);
+        const uint64_t mask = capacity - 1;
+        for(uint64_t e = 0; e < N_edges; ++e){
+            uint64_t s = hash_pair(this->edge_v0[e], this->edge_v1[e]) & mask;
+            while(this->edge_table[s] != none) s = (s + 1) & mask;
+            this->edge_table[s] = e;
+        }
+    }
+
+    // Vertex classification.
+    this->vertex_flags.assign(this->N_vertices, 0);
+    parallel_for(0, static_cast<long int>(this->N_vertices), [&](long int v) -> void {
+        uint8_t flags = flag_manifold;
+        for(const auto &e : this->edges_of_vertex(v)){
+            if(this->is_boundary_edge(e)) flags |= flag_boundary;
+            if(!this->is_manifold_edge(e)) flags &= static_cast<uint8_t>(~flag_manifold);
+        }
+
+        // Walk around the vertex to confirm the faces form a single fan.
+        const auto hs = this->half_edges_of_vertex(v);
+        if( (flags & flag_manifold) && !hs.empty() ){
+            const auto start = hs[0];
+            uint64_t visited = 1;
+            uint64_t h = this->twin(this->prev(start));
+            while( (h != none) && (h != start) && (visited <= hs.size()) ){
+                ++visited;
+                h = this->twin(this->prev(h));
+            }
+            if(h == none){
+                for(uint64_t t = this->twin(start); (t != none) && (visited <= hs.size()); t = this->twin(h)){
+                    h = this->next(t);
+                    ++visited;
+                }
+            }
+            if(visited != hs.size()) flags &= static_cast<uint8_t>(~flag_manifold);
+        }
+        this->vertex_flags[v] = flags;
+    });
+
+    this->manifold = std::all_of(std::begin(this->vertex_flags), std::end(this->vertex_flags),
+                                 [](uint8_t flags){ return (flags & flag_manifold) != 0; });
+    for(uint64_t f = 0; this->manifold && (f < this->N_faces); ++f){
+        if(this->face_size(f) < 3) this->manifold = false;
+    }
+    for(uint64_t e = 0; this->manifold && (e < N_edges); ++e){
+        if(this->edge_v0[e] == this->edge_v1[e]) this->manifold = false;
+    }
+
+    this->digest = compute_digest(mesh);
+}
+
+
+bool Surface_Mesh_Adjacency::is_manifold_edge(uint64_t e) const {
+    const auto b = this->eh_offsets[e];
+    const auto n = this->eh_offsets[e + 1] - b;
+    if(n == 1) return true;
+    if(n != 2) return false;
+
+    // The two faces must traverse the edge in opposite directions.
+    const auto h_a = this->eh_half_edges[b];
+    const auto h_b = this->eh_half_edges[b + 1];
+    return (this->edge_v0[e] != this->edge_v1[e])
+        && (this->tail(h_a) != this->tail(h_b));
+}
+
+
+uint64_t Surface_Mesh_Adjacency::find_edge(uint64_t a, uint64_t b) const {
+    if(this->edge_table.empty()) return none;
+    if(b < a) std::swap(a, b);
+    const uint64_t mask = static_cast<uint64_t>(this->edge_table.size()) - 1;
+    for(uint64_t s = hash_pair(a, b) & mask; ; s = (s + 1) & mask){
+        const auto e = this->edge_table[s];
+        if(e == none) return none;
+        if( (this->edge_v0[e] == a) && (this->edge_v1[e] == b) ) return e;
+    }
+}
+
+
+bool Surface_Mesh_Adjacency::is_current(const fv_surface_mesh<double, uint64_t> &mesh) const {
+    return (mesh.vertices.size() == this->N_vertices)
+        && (mesh.faces.size() == this->N_faces)
+        && (compute_digest(mesh) == this->digest);
+}
+
+
+uint64_t Surface_Mesh_Adjacency::hash_pair(uint64_t a, uint64_t b){
+    return Mix(a * 0x9E3779B97F4A7C15ULL + b);
+}
+
+
+uint64_t Surface_Mesh_Adjacency::compute_digest(const fv_surface_mesh<double, uint64_t> &mesh){
+    uint64_t h = 0;
+    for(const auto &face : mesh.faces){
+        h = Mix(h + static_cast<uint64_t>(face.size()) + 0x9E3779B97F4A7C15ULL);
+        for(const auto &v : face) h = Mix(h ^ v);
+    }
+    return h;
+}
@@ -0,0 +1,130 @@
+//Surface_Mesh_Adjacency.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+// Connectivity of a face-vertex surface mesh, computed once so topology queries are constant-time.
+//
+// Every face corner contributes one half-edge, which runs from the corner's vertex to the next vertex of the face. The
+// half-edges of face f are numbered contiguously, so half-edge h of a face with n vertices is followed by
+// face_half_edge(f) + ((h - face_half_edge(f) + 1) % n). Half-edges joining the same pair of vertices (in either
+// direction) share an undirected edge. Edges are numbered in lexicographic order of their (smaller, larger) vertex
+// indices and can be looked up by vertex pair via a hash table.
+//
+// Arbitrary polygon soups are accepted. Edges shared by more than two faces, or by two faces with inconsistent
+// orientation, are flagged as non-manifold and their half-edges have no twin.
+//
+// All arrays are stored separately (structure-of-arrays) and vertex and edge incidences are compressed (CSR) lists.
+// The structure holds no reference to the mesh. is_current() can be used to detect changes to the faces.
+class Surface_Mesh_Adjacency {
+  public:
+    static constexpr uint64_t none = std::numeric_limits<uint64_t>::max();
+
+    // A contiguous, read-only list of indices.
+    struct index_range {
+        const uint64_t *b = nullptr;
+        const uint64_t *e = nullptr;
+
+        const uint64_t * begin() const { return this->b; }
+        const uint64_t * end() const { return this->e; }
+        size_t size() const { return static_cast<size_t>(this->e - this->b); }
+        bool empty() const { return (this->b == this->e); }
+        uint64_t operator[](size_t i) const { return this->b[i]; }
+    };
+
+    // Throws if a face refers to a non-existent vertex.
+    explicit Surface_Mesh_Adjacency(const fv_surface_mesh<double, uint64_t> &mesh);
+
+    uint64_t vertex_count() const { return this->N_vertices; }
+    uint64_t face_count() const { return this->N_faces; }
+    uint64_t half_edge_count() const { return static_cast<uint64_t>(this->he_vertex.size()); }
+    uint64_t edge_count() const { return static_cast<uint64_t>(this->edge_v0.size()); }
+
+    // Vertex queries. Faces that visit a vertex more than once are listed once per visit.
+    index_range faces_of_vertex(uint64_t v) const { return this->range(this->vh_offsets, this->vf_faces, v); }
+    index_range half_edges_of_vertex(uint64_t v) const { return this->range(this->vh_offsets, this->vh_half_edges, v); }
+    index_range edges_of_vertex(uint64_t v) const { return this->range(this->ve_offsets, this->ve_edges, v); }
+    bool is_boundary_vertex(uint64_t v) const { return (this->vertex_flags[v] & flag_boundary) != 0; }
+
+    // True if the faces around the vertex form a single fan (open or closed) joined by manifold edges.
+    bool is_manifold_vertex(uint64_t v) const { return (this->vertex_flags[v] & flag_manifold) != 0; }
+
+    // Half-edge queries. The half-edges of a face are listed in order and begin at face_half_edge(f).
+    uint64_t face_half_edge(uint64_t f) const { return this->face_begin[f]; }
+    uint64_t face_size(uint64_t f) const { return this->face_begin[f + 1] - this->face_begin[f]; }
+    uint64_t face_of(uint64_t h) const { return this->he_face[h]; }
+    uint64_t tail(uint64_t h) const { return this->he_vertex[h]; }
+    uint64_t head(uint64_t h) const { return this->he_vertex[this->next(h)]; }
+    uint64_t next(uint64_t h) const {
+        const auto f = this->he_face[h];
+        return (h + 1 == this->face_begin[f + 1]) ? this->face_begin[f] : (h + 1);
+    }
+    uint64_t prev(uint64_t h) const {
+        const auto f = this->he_face[h];
+        return (h == this->face_begin[f]) ? (this->face_begin[f + 1] - 1) : (h - 1);
+    }
+    uint64_t twin(uint64_t h) const { return this->he_twin[h]; } // 'none' for boundary and non-manifold edges.
+    uint64_t edge_of(uint64_t h) const { return this->he_edge[h]; }
+
+    // Edge queries. Edge vertices are ordered so the first is not larger than the second.
+    std::array<uint64_t, 2> edge_vertices(uint64_t e) const { return {{ this->edge_v0[e], this->edge_v1[e] }}; }
+    index_range half_edges_of_edge(uint64_t e) const { return this->range(this->eh_offsets, this->eh_half_edges, e); }
+    bool is_boundary_edge(uint64_t e) const { return (this->eh_offsets[e + 1] - this->eh_offsets[e]) == 1; }
+    bool is_manifold_edge(uint64_t e) const;
+
+    // Returns the edge joining the two vertices (in either order), or 'none' if there is no such edge.
+    uint64_t find_edge(uint64_t a, uint64_t b) const;
+
+    // True if every vertex is manifold, every face has at least three distinct consecutive vertices, and every edge
+    // joins distinct vertices. Such meshes are orientable 2-manifolds, possibly with boundaries.
+    bool is_manifold() const { return this->manifold; }
+
+    // Returns true if the mesh has the same number of vertices and the same faces as when the structure was built. This
+    // is linear in the number of faces, but much cheaper than rebuilding.
+    bool is_current(const fv_surface_mesh<double, uint64_t> &mesh) const;
+
+  private:
+    static constexpr uint8_t flag_boundary = 1;
+    static constexpr uint8_t flag_manifold = 2;
+
+    uint64_t N_vertices = 0;
+    uint64_t N_faces = 0;
+    uint64_t digest = 0;
+    bool manifold = false;
+
+    std::vector<uint64_t> face_begin;     // N_faces + 1.
+
+    std::vector<uint64_t> he_vertex;      // Tail vertex.
+    std::vector<uint64_t> he_face;
+    std::vector<uint64_t> he_twin;
+    std::vector<uint64_t> he_edge;
+
+    std::vector<uint64_t> vh_offsets;     // N_vertices + 1. Indexes both vh_half_edges and vf_faces.
+    std::vector<uint64_t> vh_half_edges;  // Outgoing half-edges.
+    std::vector<uint64_t> vf_faces;
+    std::vector<uint64_t> ve_offsets;     // N_vertices + 1.
+    std::vector<uint64_t> ve_edges;
+    std::vector<uint8_t> vertex_flags;
+
+    std::vector<uint64_t> edge_v0;
+    std::vector<uint64_t> edge_v1;
+    std::vector<uint64_t> eh_offsets;     // N_edges + 1.
+    std::vector<uint64_t> eh_half_edges;
+
+    std::vector<uint64_t> edge_table;     // Open addressing with linear probing. Holds edge indices or 'none'.
+
+    static uint64_t hash_pair(uint64_t a, uint64_t b);
+    static uint64_t compute_digest(const fv_surface_mesh<double, uint64_t> &mesh);
+
+    static index_range range(const std::vector<uint64_t> &offsets, const std::vector<uint64_t> &items, uint64_t i){
+        return { items.data() + offsets[i], items.data() + offsets[i + 1] };
+    }
+};
@@ -0,0 +1,374 @@
+//Surface_Mesh_BVH.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Surface_Mesh_BVH.h"
+
+
+namespace {
+
+// Binned SAH build parameters.
+constexpr int sah_bins = 16;
+constexpr size_t max_leaf_size = 4;
+constexpr double traversal_cost = 1.0;     // Relative to the cost of one triangle test.
+constexpr size_t max_sah_depth = 48;       // Beyond this depth, nodes are split in half to bound the tree depth.
+constexpr int max_traversal_stack = 128;   // Exceeds max_sah_depth plus the depth of a balanced tree over 2^32 triangles.
+
+struct aabb_t {
+    double lo[3] = {  std::numeric_limits<double>::infinity(),
+                      std::numeric_limits<double>::infinity(),
+                      std::numeric_limits<double>::infinity() };
+    double hi[3] = { -std::numeric_limits<double>::infinity(),
+                     -std::numeric_limits<double>::infinity(),
+                     -std::numeric_limits<double>::infinity() };
+
+    void grow(const double p[3]){
+        for(int a = 0; a < 3; ++a){
+            this->lo[a] = std::min(this->lo[a], p[a]);
+            this->hi[a] = std::max(this->hi[a], p[a]);
+        }
+    }
+    void grow(const aabb_t &b){
+        this->grow(b.lo);
+        this->grow(b.hi);
+    }
+    double half_area() const {
+        const double dx = this->hi[0] - this->lo[0];
+        const double dy = this->hi[1] - this->lo[1];
+        const double dz = this->hi[2] - this->lo[2];
+        if((dx < 0.0) || (dy < 0.0) || (dz < 0.0)) return 0.0;
+        return dx*dy + dy*dz + dz*dx;
+    }
+};
+
+struct build_prim_t {
+    aabb_t box;
+    double centroid[3];
+    size_t index; // Into the unordered triangle list.
+};
+
+// Slab test. Returns true if the ray overlaps the box within [t_min, t_max].
+inline bool Ray_Overlaps_Box(const double o[3], const double inv_d[3], double t_min, double t_max,
+                             const double lo[3], const double hi[3]){
+    for(int a = 0; a < 3; ++a){
+        double t0 = (lo[a] - o[a]) * inv_d[a];
+        double t1 = (hi[a] - o[a]) * inv_d[a];
+        if(t1 < t0) std::swap(t0, t1);
+        // Note: NaNs (from 0 * inf when the ray lies in a slab face) leave the interval unchanged.
+        t_min = (t_min < t0) ? t0 : t_min;
+        t_max = (t1 < t_max) ? t1 : t_max;
+        if(t_max < t_min) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+Surface_Mesh_BVH::Surface_Mesh_BVH(const fv_surface_mesh<double, uint64_t> &mesh){
+    this->N_vertices = mesh.vertices.size();
+    this->N_faces = mesh.faces.size();
+    this->digest = compute_digest(mesh);
+
+    // Triangulate the faces.
+    std::vector<triangle_t> unordered;
+    unordered.reserve(mesh.faces.size());
+    for(size_t f = 0; f < mesh.faces.size(); ++f){
+        const auto &face = mesh.faces[f];
+        if(face.size() < 3) continue;
+        for(const auto &v : face){
+            if(this->N_vertices <= v) throw std::invalid_argument("Face references a nonexistent vertex");
+        }
+        const auto &v0 = mesh.vertices[face[0]];
+        for(size_t i = 1; (i + 1) < face.size(); ++i){
+            triangle_t t;
+            t.v0 = v0;
+            t.e1 = mesh.vertices[face[i]] - v0;
+            t.e2 = mesh.vertices[face[i + 1]] - v0;
+            t.face = static_cast<uint64_t>(f);
+            unordered.emplace_back(t);
+        }
+    }
+    if(static_cast<size_t>(std::numeric_limits<uint32_t>::max()) <= unordered.size()){
+        throw std::invalid_argument("Mesh has too many faces for BVH construction");
+    }
+    if(unordered.empty()) return;
+
+    std::vector<build_prim_t> prims(unordered.size());
+    for(size_t i = 0; i < unordered.size(); ++i){
+        const auto &t = unordered[i];
+        const auto v1 = t.v0 + t.e1;
+        const auto v2 = t.v0 + t.e2;
+        for(const auto &v : { t.v0, v1, v2 }){
+            const double p[3] = { v.x, v.y, v.z };
+            prims[i].box.grow(p);
+        }
+        for(int a = 0; a < 3; ++a){
+            prims[i].centroid[a] = 0.5 * (prims[i].box.lo[a] + prims[i].box.hi[a]);
+        }
+        prims[i].index = i;
+    }
+
+    // Build top-down with an explicit stack. Nodes are emitted depth-first, so the first child of an interior node
+    // directly follows it.
+    struct pending_t {
+        size_t begin;
+        size_t end;
+        size_t parent;     // Node which needs the index of this (second) child, if any.
+        bool is_second;
+        size_t depth;
+    };
+    std::vector<pending_t> stack;
+    stack.push_back( pending_t{ 0, prims.size(), 0, false, 0 } );
+    this->nodes.reserve(2 * prims.size() / max_leaf_size + 1);
+
+    while(!stack.empty()){
+        const auto job = stack.back();
+        stack.pop_back();
+
+        const size_t node_index = this->nodes.size();
+        if(job.is_second) this->nodes[job.parent].offset = static_cast<uint32_t>(node_index);
+        this->nodes.emplace_back();
+
+        aabb_t box;
+        aabb_t centroid_box;
+        for(size_t i = job.begin; i < job.end; ++i){
+            box.grow(prims[i].box);
+            centroid_box.grow(prims[i].centroid);
+        }
+        for(int a = 0; a < 3; ++a){
+            this->nodes[node_index].lo[a] = box.lo[a];
+            this->nodes[node_index].hi[a] = box.hi[a];
+        }
+
+        const size_t N = job.end - job.begin;
+        const auto make_leaf = [&]() -> void {
+            this->nodes[node_index].offset = static_cast<uint32_t>(job.begin);
+            this->nodes[node_index].count = static_cast<uint32_t>(N);
+        };
+        if(N <= max_leaf_size){
+            make_leaf();
+            continue;
+        }
+
+        // Evaluate binned SAH splits along each axis.
+        double best_cost = std::numeric_limits<double>::infinity();
+        int best_axis = -1;
+        int best_bin = -1;
+        for(int a = 0; a < 3; ++a){
+            const double extent = centroid_box.hi[a] - centroid_box.lo[a];
+            if(!(0.0 < extent)) continue;
+            const double scale = static_cast<double>(sah_bins) / extent;
+
+            std::array<aabb_t, sah_bins> bin_boxes;
+            std::array<size_t, sah_bins> bin_counts{};
+            for(size_t i = job.begin; i < job.end; ++i){
+                const int b = std::min(sah_bins - 1, static_cast<int>((prims[i].centroid[a] - centroid_box.lo[a]) * scale));
+                bin_boxes[b].grow(prims[i].box);
+                ++bin_counts[b];
+            }
+
+            // Sweep from the right to accumulate suffix areas, then from the left to evaluate each split.
+            std::array<double, sah_bins> right_area{};
+            std::array<size_t, sah_bins> right_count{};
+            aabb_t acc;
+            size_t cnt = 0;
+            for(int b = sah_bins - 1; 0 < b; --b){
+                acc.grow(bin_boxes[b]);
+                cnt += bin_counts[b];
+                right_area[b] = acc.half_area();
+                right_count[b] = cnt;
+            }
+            acc = aabb_t();
+            cnt = 0;
+            for(int b = 0; (b + 1) < sah_bins; ++b){
+                acc.grow(bin_boxes[b]);
+                cnt += bin_counts[b];
+                if((cnt == 0) || (right_count[b + 1] == 0)) continue;
+                const double cost = acc.half_area() * static_cast<double>(cnt)
+                                  + right_area[b + 1] * static_cast<double>(right_count[b + 1]);
+                if(cost < best_cost){
+                    best_cost = cost;
+                    best_axis = a;
+                    best_bin = b;
+                }
+            }
+        }
+
+        // Compare against the cost of not splitting.
+        const double leaf_cost = box.half_area() * static_cast<double>(N);
+        const double split_cost = box.half_area() * traversal_cost + best_cost;
+        size_t mid = job.begin;
+        if(max_sah_depth <= job.depth){
+            mid = job.begin + N / 2;
+            std::nth_element(std::next(std::begin(prims), job.begin),
+                             std::next(std::begin(prims), mid),
+                             std::next(std::begin(prims), job.end),
+                             [](const build_prim_t &l, const build_prim_t &r) -> bool {
+                                 return (l.centroid[0] + l.centroid[1] + l.centroid[2])
+                                      < (r.centroid[0] + r.centroid[1] + r.centroid[2]);
+                             });
+
+        }else if((0 <= best_axis) && (split_cost < leaf_cost)){
+            const double scale = static_cast<double>(sah_bins) / (centroid_box.hi[best_axis] - centroid_box.lo[best_axis]);
+            const auto it = std::partition(std::next(std::begin(prims), job.begin),
+                                           std::next(std::begin(prims), job.end),
+                                           [&](const build_prim_t &p) -> bool {
+                const int b = std::min(sah_bins - 1, static_cast<int>((p.centroid[best_axis] - centroid_box.lo[best_axis]) * scale));
+                return (b <= best_bin);
+            });
+            mid = static_cast<size_t>(std::distance(std::begin(prims), it));
+
+        }else if(N <= 4 * max_leaf_size){
+            make_leaf();
+            continue;
+
+        }else{
+            // Degenerate distribution (e.g., coincident centroids). Split in half to bound leaf sizes.
+            mid = job.begin + N / 2;
+        }
+        if((mid == job.begin) || (mid == job.end)) mid = job.begin + N / 2;
+
+        // Push the second child first so the first child is emitted directly after this node.
+        stack.push_back( pending_t{ mid, job.end, node_index, true, job.depth + 1 } );
+        stack.push_back( pending_t{ job.begin, mid, node_index, false, job.depth + 1 } );
+    }
+
+    this->triangles.reserve(prims.size());
+    for(const auto &p : prims) this->triangles.emplace_back( unordered[p.index] );
+}
+
+
+uint64_t Surface_Mesh_BVH::compute_digest(const fv_surface_mesh<double, uint64_t> &mesh){
+    // FNV-1a over the raw vertex coordinates and face indices.
+    uint64_t h = 14695981039346656037ULL;
+    const auto mix = [&h](const void *p, size_t n) -> void {
+        const auto *c = static_cast<const unsigned char *>(p);
+        for(size_t i = 0; i < n; ++i){
+            h ^= static_cast<uint64_t>(c[i]);
+            h *= 1099511628211ULL;
+        }
+    };
+    for(const auto &v : mesh.vertices){
+        const double xyz[3] = { v.x, v.y, v.z };
+        mix(xyz, sizeof(xyz));
+    }
+    for(const auto &f : mesh.faces){
+        const uint64_t n = f.size();
+        mix(&n, sizeof(n));
+        if(!f.empty()) mix(f.data(), f.size() * sizeof(uint64_t));
+    }
+    return h;
+}
+
+
+template <class F>
+void Surface_Mesh_BVH::traverse(const vec3<double> &A, const vec3<double> &D, double t_min, double t_max, F &&f) const {
+    if(this->nodes.empty()) return;
+
+    const double o[3] = { A.x, A.y, A.z };
+    const double inv_d[3] = { 1.0 / D.x, 1.0 / D.y, 1.0 / D.z };
+    constexpr double eps = 1.0E-12;
+
+    uint32_t stack[max_traversal_stack];
+    int sp = 0;
+    stack[sp++] = 0;
+    while(0 < sp){
+        const auto &n = this->nodes[stack[--sp]];
+        if(!Ray_Overlaps_Box(o, inv_d, t_min, t_max, n.lo, n.hi)) continue;
+
+        if(n.count == 0){
+            const auto self = static_cast<uint32_t>(&n - this->nodes.data());
+            stack[sp++] = n.offset;
+            stack[sp++] = self + 1;
+            continue;
+        }
+
+        for(uint32_t i = n.offset; i < (n.offset + n.count); ++i){
+            // Moller-Trumbore.
+            const auto &tri = this->triangles[i];
+            const auto p = D.Cross(tri.e2);
+            const double det = tri.e1.Dot(p);
+            if(std::abs(det) < eps * tri.e1.length() * tri.e2.length() * D.length()) continue; // Parallel.
+            const double inv_det = 1.0 / det;
+            const auto s = A - tri.v0;
+            const double u = s.Dot(p) * inv_det;
+            if((u < 0.0) || (1.0 < u)) continue;
+            const auto q = s.Cross(tri.e1);
+            const double v = D.Dot(q) * inv_det;
+            if((v < 0.0) || (1.0 < (u + v))) continue;
+            const double t = tri.e2.Dot(q) * inv_det;
+            if((t < t_min) || (t_max < t)) continue;
+
+            hit_t h;
+            h.t = t;
+            h.point = A + D * t;
+            h.face = tri.face;
+            if(f(h)) return;
+        }
+    }
+    return;
+}
+
+
+std::vector<Surface_Mesh_BVH::hit_t>
+Surface_Mesh_BVH::all_intersections(const vec3<double> &A, const vec3<double> &B) const {
+    std::vector<hit_t> out;
+    this->traverse(A, B - A, 0.0, 1.0, [&](const hit_t &h) -> bool {
+        out.emplace_back(h);
+        return false;
+    });
+    std::sort(std::begin(out), std::end(out), [](const hit_t &l, const hit_t &r) -> bool {
+        return (l.t < r.t);
+    });
+    return out;
+}
+
+
+bool Surface_Mesh_BVH::any_intersection(const vec3<double> &A, const vec3<double> &B) const {
+    bool found = false;
+    this->traverse(A, B - A, 0.0, 1.0, [&](const hit_t &) -> bool {
+        found = true;
+        return true;
+    });
+    return found;
+}
+
+
+bool Surface_Mesh_BVH::any_intersection(const line<double> &L) const {
+    bool found = false;
+    this->traverse(L.R_0, L.U_0, -std::numeric_limits<double>::infinity(),
+                                  std::numeric_limits<double>::infinity(), [&](const hit_t &) -> bool {
+        found = true;
+        return true;
+    });
+    return found;
+}
+
+
+bool Surface_Mesh_BVH::is_current(const fv_surface_mesh<double, uint64_t> &mesh) const {
+    return (mesh.vertices.size() == this->N_vertices)
+        && (mesh.faces.size() == this->N_faces)
+        && (compute_digest(mesh) == this->digest);
+}
+
+
+size_t Surface_Mesh_BVH::triangle_count() const {
+    return this->triangles.size();
+}
+
+
+size_t Surface_Mesh_BVH::node_count() const {
+    return this->nodes.size();
+}
+
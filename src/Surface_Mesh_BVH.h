@@ -0,0 +1,73 @@
+//Surface_Mesh_BVH.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+// A bounding volume hierarchy for ray (i.e., line and line segment) queries against a surface mesh.
+//
+// Faces are triangulated (polygons are fanned) and partitioned using a binned surface area heuristic. The hierarchy is
+// stored as a flattened, depth-first node array so traversal is iterative and cache-friendly, and triangles are stored
+// in leaf order with precomputed edges. Intersections are computed with the Moller-Trumbore test; rays lying in the
+// plane of a triangle do not intersect it.
+//
+// The BVH holds a copy of the geometry, so it remains valid if the mesh is later altered. is_current() can be used to
+// detect such changes.
+class Surface_Mesh_BVH {
+  public:
+    struct hit_t {
+        double t = 0.0;          // Line parameter: the intersection is at A + t*(B - A).
+        vec3<double> point;
+        uint64_t face = 0;       // Index of the face in the mesh.
+    };
+
+    explicit Surface_Mesh_BVH(const fv_surface_mesh<double, uint64_t> &mesh);
+
+    // Returns all intersections of the line segment from A to B with the mesh, sorted by distance from A.
+    std::vector<hit_t> all_intersections(const vec3<double> &A, const vec3<double> &B) const;
+
+    // Returns true if the line segment from A to B intersects the mesh.
+    bool any_intersection(const vec3<double> &A, const vec3<double> &B) const;
+
+    // Returns true if the (infinite) line intersects the mesh.
+    bool any_intersection(const line<double> &L) const;
+
+    // Returns true if the mesh has the same vertices and faces as when the BVH was built. This is linear in the size of
+    // the mesh, but much cheaper than rebuilding.
+    bool is_current(const fv_surface_mesh<double, uint64_t> &mesh) const;
+
+    size_t triangle_count() const;
+    size_t node_count() const;
+
+  private:
+    struct triangle_t {
+        vec3<double> v0;
+        vec3<double> e1;         // v1 - v0.
+        vec3<double> e2;         // v2 - v0.
+        uint64_t face;
+    };
+    std::vector<triangle_t> triangles; // In leaf order.
+
+    struct node_t {
+        double lo[3];
+        double hi[3];
+        uint32_t offset;         // Leaves: first triangle. Interior nodes: index of the second child.
+        uint32_t count;          // Leaves: number of triangles. Interior nodes: zero. The first child follows directly.
+    };
+    std::vector<node_t> nodes;
+
+    size_t N_vertices = 0;
+    size_t N_faces = 0;
+    uint64_t digest = 0;
+    static uint64_t compute_digest(const fv_surface_mesh<double, uint64_t> &mesh);
+
+    // Visits every triangle intersected by A + t*D for t in [t_min, t_max]. Traversal stops early if f returns true.
+    template <class F>
+    void traverse(const vec3<double> &A, const vec3<double> &D, double t_min, double t_max, F &&f) const;
+};
+
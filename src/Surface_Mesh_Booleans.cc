@@ -0,0 +1,255 @@
+//Surface_Mesh_Booleans.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
+#include "Distance_Transform.h"
+#include "Simple_Meshing.h"
+#include "Surface_Mesh_BVH.h"
+#include "Thread_Pool.h"
+
+#include "Surface_Mesh_Booleans.h"
+
+
+namespace {
+
+// Grids are limited to roughly 512^3 voxels, which requires a few GiB of scratch space.
+constexpr int64_t max_voxels = static_cast<int64_t>(1) << 27;
+
+// Signed distances on a grid of cubic voxels with (image, row, column) ordering, like distance_transform_grid. Rows
+// run along x, columns along y, and images along z.
+struct sdf_grid_t {
+    vec3<double> origin;     // The centre of the first voxel.
+    double h = 1.0;          // Voxel size.
+    int64_t N_i = 0;
+    int64_t N_r = 0;
+    int64_t N_c = 0;
+
+    int64_t size() const { return this->N_i * this->N_r * this->N_c; }
+    distance_transform_grid dt_grid() const {
+        distance_transform_grid g;
+        g.images  = this->N_i;
+        g.rows    = this->N_r;
+        g.columns = this->N_c;
+        g.image_spacing = g.row_spacing = g.column_spacing = this->h;
+        return g;
+    }
+};
+
+void Bounds(const fv_surface_mesh<double, uint64_t> &mesh, vec3<double> &lo, vec3<double> &hi){
+    if(mesh.faces.empty()){
+        throw std::invalid_argument("Mesh has no faces. Cannot continue.");
+    }
+    for(const auto &f : mesh.faces){
+        for(const auto &v : f){
+            const auto &p = mesh.vertices.at(v);
+            lo.x = std::min(lo.x, p.x);
+            lo.y = std::min(lo.y, p.y);
+            lo.z = std::min(lo.z, p.z);
+            hi.x = std::max(hi.x, p.x);
+            hi.y = std::max(hi.y, p.y);
+            hi.z = std::max(hi.z, p.z);
+        }
+    }
+    if(!lo.isfinite() || !hi.isfinite()){
+        throw std::invalid_argument("Mesh vertices are not finite. Cannot continue.");
+    }
+    return;
+}
+
+// Creates a grid covering the given meshes, padded on all sides.
+sdf_grid_t Make_Grid(const std::vector<std::reference_wrapper<const fv_surface_mesh<double, uint64_t>>> &meshes,
+                     double pad,
+                     double voxel_size){
+    if( !std::isfinite(voxel_size) || (voxel_size <= 0.0) ){
+        throw std::invalid_argument("Voxel size must be positive and finite. Cannot continue.");
+    }
+
+    const auto inf = std::numeric_limits<double>::infinity();
+    vec3<double> lo(inf, inf, inf);
+    vec3<double> hi(-inf, -inf, -inf);
+    for(const auto &m : meshes) Bounds(m.get(), lo, hi);
+
+    // Two voxels of padding ensure the field is exterior along the grid boundary.
+    pad += 2.0 * voxel_size;
+    const vec3<double> pad3(pad, pad, pad);
+    lo = lo - pad3;
+    hi = hi + pad3;
+
+    sdf_grid_t g;
+    g.origin = lo;
+    g.h = voxel_size;
+    const auto count = [&](double extent) -> int64_t {
+        const auto n = std::ceil(extent / voxel_size) + 1.0;
+        if(!(n < static_cast<double>(max_voxels))){
+            throw std::invalid_argument("Voxel size is too small for the extent of the mesh. Cannot continue.");
+        }
+        return static_cast<int64_t>(n);
+    };
+    g.N_r = count(hi.x - lo.x);
+    g.N_c = count(hi.y - lo.y);
+    g.N_i = count(hi.z - lo.z);
+    if( (max_voxels / g.N_r) / g.N_c < g.N_i ){
+        throw std::invalid_argument("Voxel size is too small for the extent of the mesh. Cannot continue.");
+    }
+    return g;
+}
+
+// Samples the signed distance to the mesh surface (negative inside) at every voxel.
+std::vector<float> Sample_Signed_Distance(const fv_surface_mesh<double, uint64_t> &mesh, const sdf_grid_t &g){
+    const Surface_Mesh_BVH bvh(mesh);
+
+    // Face normals are computed with Newell's method so polygons are supported. Only their direction matters.
+    std::vector<vec3<double>> normals(mesh.faces.size());
+    parallel_for(0, static_cast<long int>(mesh.faces.size()), [&](long int f) -> void {
+        const auto &face = mesh.faces[f];
+        vec3<double> N(0.0, 0.0, 0.0);
+        for(size_t j = 0; j < face.size(); ++j){
+            const auto &A = mesh.vertices[face[j]];
+            const auto &B = mesh.vertices[face[(j + 1) % face.size()]];
+            N += A.Cross(B);
+        }
+        normals[f] = N;
+    });
+
+    // Classify voxel centres with one ray per grid line along the columns. Crossings are accumulated into a winding
+    // number. Coincident crossings (e.g., where a ray passes through an edge or vertex shared by several faces) are
+    // merged so each crossing of the surface is counted once, while grazing contacts cancel. Rays are displaced by a
+    // small fraction of a voxel so they do not systematically run along grid-aligned mesh edges.
+    const int64_t N_lines = g.N_i * g.N_r;
+    std::vector<uint8_t> mask(g.size(), 0);
+    const double jitter_x = g.h * 1.0E-4 * 0.6180339887498949;
+    const double jitter_z = g.h * 1.0E-4 * 0.4142135623730950;
+    const double L = static_cast<double>(g.N_c + 1) * g.h;
+    parallel_for(0, static_cast<long int>(N_lines), [&](long int line) -> void {
+        const int64_t k = line / g.N_r;
+        const int64_t r = line % g.N_r;
+        const vec3<double> A( g.origin.x + static_cast<double>(r) * g.h + jitter_x,
+                              g.origin.y - g.h,
+                              g.origin.z + static_cast<double>(k) * g.h + jitter_z );
+        const vec3<double> D(0.0, L, 0.0);
+        const auto hits = bvh.all_intersections(A, A + D);
+
+        const double eps = 1.0E-9;
+        uint8_t *m = &mask[static_cast<size_t>(line * g.N_c)];
+        int64_t w = 0;
+        size_t p = 0;
+        for(int64_t c = 0; c < g.N_c; ++c){
+            const double t_c = static_cast<double>(c + 1) * g.h / L;
+            while( (p < hits.size()) && (hits[p].t < t_c) ){
+                int64_t s = 0;
+                const auto t_p = hits[p].t;
+                for(; (p < hits.size()) && (hits[p].t <= t_p + eps); ++p){
+                    s += (normals[hits[p].face].Dot(D) < 0.0) ? 1 : -1;
+                }
+                w += (0 < s) ? 1 : ((s < 0) ? -1 : 0);
+            }
+            m[c] = (w != 0) ? 1 : 0;
+        }
+    });
+
+    // Distances are measured between voxel centres, which lie (on average) half a voxel from the surface.
+    const auto dt_grid = g.dt_grid();
+    const double far = static_cast<double>(g.N_i + g.N_r + g.N_c) * g.h;
+    std::vector<float> sdf(g.size());
+    {
+        const auto d2_in = Squared_Euclidean_Distance_Transform(mask, dt_grid);
+        parallel_for(0, static_cast<long int>(g.size()), [&](long int i) -> void {
+            if(mask[i] == 0) sdf[i] = static_cast<float>( std::min(far, std::sqrt(d2_in[i])) - 0.5 * g.h );
+        });
+    }
+    for(auto &x : mask) x = (x == 0) ? 1 : 0;
+    {
+        const auto d2_out = Squared_Euclidean_Distance_Transform(mask, dt_grid);
+        parallel_for(0, static_cast<long int>(g.size()), [&](long int i) -> void {
+            if(mask[i] == 0) sdf[i] = static_cast<float>( 0.5 * g.h - std::min(far, std::sqrt(d2_out[i])) );
+        });
+    }
+    return sdf;
+}
+
+// Extracts the surface where the field equals the given level, with the interior below.
+fv_surface_mesh<double, uint64_t> Extract_Surface(const sdf_grid_t &g, const std::vector<float> &field, double level){
+    planar_image_collection<float, double> imgs;
+    const vec3<double> row_unit(1.0, 0.0, 0.0);
+    const vec3<double> col_unit(0.0, 1.0, 0.0);
+    const vec3<double> img_unit(0.0, 0.0, 1.0);
+    const auto N_pxls = g.N_r * g.N_c;
+    for(int64_t k = 0; k < g.N_i; ++k){
+        imgs.images.emplace_back();
+        auto &img = imgs.images.back();
+        img.init_buffer(g.N_r, g.N_c, 1);
+        img.init_spatial(g.h, g.h, g.h, vec3<double>(0.0, 0.0, 0.0),
+                         g.origin + img_unit * (static_cast<double>(k) * g.h));
+        img.init_orientation(row_unit, col_unit);
+        std::copy( std::next(std::begin(field), k * N_pxls),
+                   std::next(std::begin(field), (k + 1) * N_pxls),
+                   std::begin(img.data) );
+    }
+
+    std::list<std::reference_wrapper<planar_image<float, double>>> img_refws;
+    for(auto &img : imgs.images) img_refws.emplace_back( std::ref(img) );
+    return Marching_Cubes_Surface_Mesh(img_refws, level, true);
+}
+
+} // namespace
+
+
+fv_surface_mesh<double, uint64_t>
+Offset_Surface_Mesh(const fv_surface_mesh<double, uint64_t> &mesh,
+                    double distance,
+                    double voxel_size){
+    if(!std::isfinite(distance)){
+        throw std::invalid_argument("Offset distance must be finite. Cannot continue.");
+    }
+    const auto g = Make_Grid({ std::cref(mesh) }, std::max(0.0, distance), voxel_size);
+    const auto sdf = Sample_Signed_Distance(mesh, g);
+    return Extract_Surface(g, sdf, distance);
+}
+
+
+fv_surface_mesh<double, uint64_t>
+Shell_Surface_Mesh(const fv_surface_mesh<double, uint64_t> &mesh,
+                   double thickness,
+                   double voxel_size){
+    if( !std::isfinite(thickness) || (thickness <= 0.0) ){
+        throw std::invalid_argument("Shell thickness must be positive and finite. Cannot continue.");
+    }
+    const auto g = Make_Grid({ std::cref(mesh) }, 0.0, voxel_size);
+    auto sdf = Sample_Signed_Distance(mesh, g);
+    const auto t = static_cast<float>(thickness);
+    parallel_for(0, static_cast<long int>(sdf.size()), [&](long int i) -> void {
+        sdf[i] = std::max(sdf[i], -sdf[i] - t);
+    });
+    return Extract_Surface(g, sdf, 0.0);
+}
+
+
+fv_surface_mesh<double, uint64_t>
+Boolean_Surface_Meshes(const fv_surface_mesh<double, uint64_t> &A,
+                       const fv_surface_mesh<double, uint64_t> &B,
+                       mesh_boolean_op op,
+                       double voxel_size){
+    const auto g = Make_Grid({ std::cref(A), std::cref(B) }, 0.0, voxel_size);
+    auto sdf = Sample_Signed_Distance(A, g);
+    const auto sdf_B = Sample_Signed_Distance(B, g);
+    parallel_for(0, static_cast<long int>(sdf.size()), [&](long int i) -> void {
+        if(op == mesh_boolean_op::Union){
+            sdf[i] = std::min(sdf[i], sdf_B[i]);
+        }else if(op == mesh_boolean_op::Intersection){
+            sdf[i] = std::max(sdf[i], sdf_B[i]);
+        }else{
+            sdf[i] = std::max(sdf[i], -sdf_B[i]);
+        }
+    });
+    return Extract_Surface(g, sdf, 0.0);
+}
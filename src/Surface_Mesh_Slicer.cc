@@ -0,0 +1,246 @@
+//Surface_Mesh_Slicer.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Thread_Pool.h"
+#include "Surface_Mesh_Slicer.h"
+
+
+namespace {
+
+// Planes whose normals differ by less than this (in terms of the dot product) share a sweep.
+constexpr double normal_grouping_tolerance = 1.0E-9;
+
+struct edge_key_hash {
+    size_t operator()(const std::pair<uint64_t, uint64_t> &k) const {
+        return static_cast<size_t>( (k.first * 0x9E3779B97F4A7C15ULL) ^ (k.second + 0x7F4A7C15ULL + (k.first << 6)) );
+    }
+};
+
+// Slices the given triangles against a single plane and chains the resulting segments into contours.
+contour_collection<double>
+Slice_Triangles(const fv_surface_mesh<double, uint64_t> &mesh,
+                const std::vector<std::array<uint64_t, 3>> &triangles,
+                const std::vector<size_t> &candidates,
+                const plane<double> &P){
+    contour_collection<double> cc;
+
+    std::vector<vec3<double>> nodes;
+    std::vector<int64_t> next;
+    std::vector<bool> has_prev;
+    std::unordered_map<std::pair<uint64_t, uint64_t>, int64_t, edge_key_hash> node_of;
+
+    // Each mesh edge that crosses the plane corresponds to a single node, which is computed from a canonical vertex
+    // ordering so the point does not depend on which neighbouring triangle encounters it first. Edges that cross at a
+    // vertex lying on the plane all share the vertex's node.
+    const auto get_node = [&](uint64_t i, uint64_t j, double d_i, double d_j) -> int64_t {
+        if(j < i){
+            std::swap(i, j);
+            std::swap(d_i, d_j);
+        }
+        const auto key = (d_i == 0.0) ? std::make_pair(i, i)
+                       : (d_j == 0.0) ? std::make_pair(j, j)
+                                      : std::make_pair(i, j);
+        const auto it = node_of.find(key);
+        if(it != std::end(node_of)) return it->second;
+
+        const auto &A = mesh.vertices[i];
+        const auto &B = mesh.vertices[j];
+        const auto t = d_i / (d_i - d_j);
+        nodes.emplace_back( (key.first != key.second) ? A + (B - A) * t : mesh.vertices[key.first] );
+        next.emplace_back(-1);
+        has_prev.emplace_back(false);
+        const auto n = static_cast<int64_t>(nodes.size()) - 1;
+        node_of.emplace(key, n);
+        return n;
+    };
+
+    for(const auto &t_i : candidates){
+        const auto &tri = triangles[t_i];
+        const double d[3] = { P.Get_Signed_Distance_To_Point(mesh.vertices[tri[0]]),
+                              P.Get_Signed_Distance_To_Point(mesh.vertices[tri[1]]),
+                              P.Get_Signed_Distance_To_Point(mesh.vertices[tri[2]]) };
+        const bool pos[3] = { (0.0 <= d[0]), (0.0 <= d[1]), (0.0 <= d[2]) };
+        if( (pos[0] == pos[1]) && (pos[1] == pos[2]) ) continue;
+
+        // Exactly two edges cross. Segments run from the edge leaving the positive side to the edge entering it,
+        // which makes contours counter-clockwise (viewed along the normal) for outward-oriented meshes.
+        int64_t exit_n = -1;
+        int64_t entry_n = -1;
+        for(int e = 0; e < 3; ++e){
+            const int a = e;
+            const int b = (e + 1) % 3;
+            if(pos[a] == pos[b]) continue;
+            const auto n = get_node(tri[a], tri[b], d[a], d[b]);
+            if(pos[a]){
+                exit_n = n;
+            }else{
+                entry_n = n;
+            }
+        }
+        if( (exit_n < 0) || (entry_n < 0) || (exit_n == entry_n) ) continue;
+
+        // Note: non-manifold edges may be shared by more than two faces. Extra segments are disregarded.
+        if( (next[exit_n] < 0) && !has_prev[entry_n] ){
+            next[exit_n] = entry_n;
+            has_prev[entry_n] = true;
+        }
+    }
+
+    std::vector<bool> visited(nodes.size(), false);
+    const auto walk = [&](int64_t n, bool closed) -> void {
+        contour_of_points<double> cop;
+        cop.closed = closed;
+        while( (0 <= n) && !visited[n] ){
+            visited[n] = true;
+            // Coincident nodes arise where distinct vertices (e.g., at a degenerate pole) lie on the plane.
+            if(cop.points.empty() || !(cop.points.back() == nodes[n])){
+                cop.points.emplace_back( nodes[n] );
+            }
+            n = next[n];
+        }
+        if( closed
+        &&  (1 < cop.points.size())
+        &&  (cop.points.back() == cop.points.front()) ){
+            cop.points.pop_back();
+        }
+        if(cop.points.size() < 3) return; // Disregard degenerate cases.
+        cc.contours.emplace_back( std::move(cop) );
+    };
+
+    // Open chains, which begin at a node without a predecessor.
+    for(size_t n = 0; n < nodes.size(); ++n){
+        if(!visited[n] && !has_prev[n] && (0 <= next[n])) walk(static_cast<int64_t>(n), false);
+    }
+    // Closed loops.
+    for(size_t n = 0; n < nodes.size(); ++n){
+        if(!visited[n] && (0 <= next[n])) walk(static_cast<int64_t>(n), true);
+    }
+    return cc;
+}
+
+} // namespace
+
+
+std::vector<contour_collection<double>>
+Slice_Surface_Mesh(const fv_surface_mesh<double, uint64_t> &mesh,
+                   const std::vector<plane<double>> &planes){
+    std::vector<contour_collection<double>> out(planes.size());
+    if(planes.empty()) return out;
+
+    // Triangulate the faces.
+    std::vector<std::array<uint64_t, 3>> triangles;
+    triangles.reserve(mesh.faces.size());
+    for(const auto &face : mesh.faces){
+        if(face.size() < 3) continue;
+        for(const auto &v : face){
+            if(mesh.vertices.size() <= v) throw std::invalid_argument("Face references a nonexistent vertex");
+        }
+        for(size_t i = 1; (i + 1) < face.size(); ++i){
+            triangles.push_back( {{ face[0], face[i], face[i + 1] }} );
+        }
+    }
+    if(triangles.empty()) return out;
+
+    // The mesh bounding box, used to bound the error incurred by sweeping planes along a shared normal.
+    const auto inf = std::numeric_limits<double>::infinity();
+    vec3<double> lo(inf, inf, inf);
+    vec3<double> hi(-inf, -inf, -inf);
+    for(const auto &v : mesh.vertices){
+        lo.x = std::min(lo.x, v.x);
+        lo.y = std::min(lo.y, v.y);
+        lo.z = std::min(lo.z, v.z);
+        hi.x = std::max(hi.x, v.x);
+        hi.y = std::max(hi.y, v.y);
+        hi.z = std::max(hi.z, v.z);
+    }
+    const auto farthest_corner_distance = [&](const vec3<double> &R) -> double {
+        const vec3<double> c( std::max(std::abs(lo.x - R.x), std::abs(hi.x - R.x)),
+                              std::max(std::abs(lo.y - R.y), std::abs(hi.y - R.y)),
+                              std::max(std::abs(lo.z - R.z), std::abs(hi.z - R.z)) );
+        return std::sqrt(c.Dot(c));
+    };
+
+    // Group the planes by orientation.
+    struct group_t {
+        vec3<double> N;
+        std::vector<size_t> planes;
+    };
+    std::vector<group_t> groups;
+    for(size_t i = 0; i < planes.size(); ++i){
+        const auto N = planes[i].N_0.unit();
+        if(!N.isfinite()) throw std::invalid_argument("Plane normal is invalid. Cannot slice mesh.");
+        auto g_it = std::find_if(std::begin(groups), std::end(groups), [&](const group_t &g) -> bool {
+            return ((1.0 - normal_grouping_tolerance) < g.N.Dot(N));
+        });
+        if(g_it == std::end(groups)){
+            groups.emplace_back();
+            groups.back().N = N;
+            g_it = std::prev(std::end(groups));
+        }
+        g_it->planes.push_back(i);
+    }
+
+    // Sweep each group to identify the triangles that might straddle each plane.
+    std::vector<std::vector<size_t>> candidates(planes.size());
+    std::vector<double> t_lo(triangles.size());
+    std::vector<double> t_hi(triangles.size());
+    std::vector<size_t> order(triangles.size());
+    for(auto &g : groups){
+        for(size_t t = 0; t < triangles.size(); ++t){
+            const auto &tri = triangles[t];
+            const auto d0 = g.N.Dot(mesh.vertices[tri[0]]);
+            const auto d1 = g.N.Dot(mesh.vertices[tri[1]]);
+            const auto d2 = g.N.Dot(mesh.vertices[tri[2]]);
+            t_lo[t] = std::min({ d0, d1, d2 });
+            t_hi[t] = std::max({ d0, d1, d2 });
+        }
+        std::iota(std::begin(order), std::end(order), static_cast<size_t>(0));
+        std::sort(std::begin(order), std::end(order), [&](size_t A, size_t B) -> bool {
+            return (t_lo[A] < t_lo[B]);
+        });
+
+        // Planes are not exactly parallel to the group normal, so the sweep is widened to bound the discrepancy.
+        std::vector<std::pair<double, size_t>> offsets;
+        double slack = 0.0;
+        for(const auto &p_i : g.planes){
+            const auto &P = planes[p_i];
+            offsets.emplace_back( g.N.Dot(P.R_0), p_i );
+            const auto dN = P.N_0.unit() - g.N;
+            slack = std::max(slack, std::sqrt(dN.Dot(dN)) * farthest_corner_distance(P.R_0));
+        }
+        slack += 1.0E-9 * (1.0 + farthest_corner_distance(vec3<double>(0.0, 0.0, 0.0)));
+        std::sort(std::begin(offsets), std::end(offsets));
+
+        std::vector<size_t> active;
+        size_t next_t = 0;
+        for(const auto &o : offsets){
+            while( (next_t < order.size()) && (t_lo[order[next_t]] <= (o.first + slack)) ){
+                active.push_back(order[next_t]);
+                ++next_t;
+            }
+            active.erase( std::remove_if(std::begin(active), std::end(active), [&](size_t t) -> bool {
+                              return (t_hi[t] < (o.first - slack));
+                          }), std::end(active) );
+            candidates[o.second] = active;
+        }
+    }
+
+    parallel_for(0, static_cast<long int>(planes.size()), [&](long int i) -> void {
+        out[i] = Slice_Triangles(mesh, triangles, candidates[i], planes[i]);
+    }, /*grain=*/ 1);
+    return out;
+}
+
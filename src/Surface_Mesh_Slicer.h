@@ -0,0 +1,25 @@
+//Surface_Mesh_Slicer.h.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "YgorMath.h"
+
+
+// Slices a surface mesh along each of the given planes, producing one contour_collection per plane.
+//
+// Faces are triangulated (polygons are fanned) and the planes are grouped by orientation. Within a group, a sweep over
+// the planes (sorted by offset) and the triangles (sorted by their extent along the shared normal) identifies the few
+// triangles that straddle each plane, so a triangle is only visited by the planes it spans. Planes are then sliced in
+// parallel.
+//
+// Intersection points are computed per mesh edge, so adjacent triangles produce bitwise-identical points and segments are
+// chained exactly. Vertices lying on a plane are treated as being on the positive side. Segments follow the face
+// orientation, so a consistently-oriented closed mesh produces consistently-oriented closed contours. Open chains (e.g.,
+// from a mesh with a boundary) produce open contours. Chains with fewer than three vertices are discarded.
+std::vector<contour_collection<double>>
+Slice_Surface_Mesh(const fv_surface_mesh<double, uint64_t> &mesh,
+                   const std::vector<plane<double>> &planes);
+
@@ -13,6 +13,8 @@
 #include <mutex>
 #include <limits>
 #include <cmath>
+#include <cstdint>
+#include <memory>
 
 #include <utility>            //Needed for std::pair.
 #include <algorithm>
@@ -65,7 +67,10 @@
 #include "YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
 
+#include "Content_Hash.h"
+#include "Simple_Meshing.h"
 #include "Surface_Meshes.h"
+#include "Tracing.h"
 
 // ----------------------------------------------- Pure contour meshing -----------------------------------------------
 namespace dcma_surface_meshes {
@@ -83,7 +88,8 @@ namespace dcma_surface_meshes {
 // NOTE: This routine does not handle ROIs with several disconnected components (e.g., "eyes"). In such cases 
 //       it is best to individually process each component (e.g., "left eye" and "right eye").
 //
-Polyhedron Estimate_Surface_Mesh(
+static
+Polyhedron Estimate_Surface_Mesh_Uncached(
         std::list<std::reference_wrapper<contour_collection<double>>> cc_ROIs,
         Parameters params ){
 
@@ -523,11 +529,7 @@ Polyhedron Estimate_Surface_Mesh(
 
 // Marching Cubes core implementation. This routine must be fed an image volume.
 //
-// NOTE: This implementation borrows from the public domain implementation available at
-//       <https://paulbourke.net/geometry/polygonise/marchingsource.cpp> (accessed 20190217).
-//       The header lists Cory Bloyd as the author. The implementation provided here extends the public domain
-//       version to support rectangular cubes, avoid 3D interpolation, and explicitly constructs a polyhedron mesh.
-//       Thanks Cory! Thanks Paul!
+// The surface is extracted as a face-vertex mesh (see Marching_Cubes_Surface_Mesh()) and then converted.
 //
 static
 Polyhedron
@@ -539,559 +541,22 @@ Marching_Cubes_Implementation(
                                  // If false, anything >= is considered to be interior to the surface.
         Parameters /*params*/ ){
 
-    const double ExteriorVal = inclusion_threshold + (below_is_interior ? 1.0 : -1.0);
-
-    if(grid_imgs.empty()){
-        throw std::invalid_argument("An insufficient number of images was provided. Cannot continue.");
-    }
-    if(!Images_Form_Rectilinear_Grid(grid_imgs)){
-        throw std::logic_error("Grid images do not form a rectilinear grid. Cannot continue");
-    }
+    const auto fvsm = Marching_Cubes_Surface_Mesh(grid_imgs, inclusion_threshold, below_is_interior);
 
-    const auto GridZ = grid_imgs.front().get().image_plane().N_0;
-
-    const vec3<double> zero3( static_cast<double>(0),
-                              static_cast<double>(0),
-                              static_cast<double>(0) );
-
-    planar_image_adjacency<float,double> img_adj( grid_imgs, {}, GridZ );
-
-    // ============================================== Marching Cubes ================================================
-
-    // Use a curb vertex inclusivity int (8 bits) to determine which (of 12) edges are intersected by the ROI surface.
-    std::array<int32_t, 256> aiCubeEdgeFlags { {
-        0b000000000000, 0b000100001001, 0b001000000011, 0b001100001010, 0b010000000110, 0b010100001111, 0b011000000101,
-        0b011100001100, 0b100000001100, 0b100100000101, 0b101000001111, 0b101100000110, 0b110000001010, 0b110100000011,
-        0b111000001001, 0b111100000000, 0b000110010000, 0b000010011001, 0b001110010011, 0b001010011010, 0b010110010110,
-        0b010010011111, 0b011110010101, 0b011010011100, 0b100110011100, 0b100010010101, 0b101110011111, 0b101010010110,
-        0b110110011010, 0b110010010011, 0b111110011001, 0b111010010000, 0b001000110000, 0b001100111001, 0b000000110011,
-        0b000100111010, 0b011000110110, 0b011100111111, 0b010000110101, 0b010100111100, 0b101000111100, 0b101100110101,
-        0b100000111111, 0b100100110110, 0b111000111010, 0b111100110011, 0b110000111001, 0b110100110000, 0b001110100000,
-        0b001010101001, 0b000110100011, 0b000010101010, 0b011110100110, 0b011010101111, 0b010110100101, 0b010010101100,
-        0b101110101100, 0b101010100101, 0b100110101111, 0b100010100110, 0b111110101010, 0b111010100011, 0b110110101001,
-        0b110010100000, 0b010001100000, 0b010101101001, 0b011001100011, 0b011101101010, 0b000001100110, 0b000101101111,
-        0b001001100101, 0b001101101100, 0b110001101100, 0b110101100101, 0b111001101111, 0b111101100110, 0b100001101010,
-        0b100101100011, 0b101001101001, 0b101101100000, 0b010111110000, 0b010011111001, 0b011111110011, 0b011011111010,
-        0b000111110110, 0b000011111111, 0b001111110101, 0b001011111100, 0b110111111100, 0b110011110101, 0b111111111111,
-        0b111011110110, 0b100111111010, 0b100011110011, 0b101111111001, 0b101011110000, 0b011001010000, 0b011101011001,
-        0b010001010011, 0b010101011010, 0b001001010110, 0b001101011111, 0b000001010101, 0b000101011100, 0b111001011100,
-        0b111101010101, 0b110001011111, 0b110101010110, 0b101001011010, 0b101101010011, 0b100001011001, 0b100101010000,
-        0b011111000000, 0b011011001001, 0b010111000011, 0b010011001010, 0b001111000110, 0b001011001111, 0b000111000101,
-        0b000011001100, 0b111111001100, 0b111011000101, 0b110111001111, 0b110011000110, 0b101111001010, 0b101011000011,
-        0b100111001001, 0b100011000000, 0b100011000000, 0b100111001001, 0b101011000011, 0b101111001010, 0b110011000110,
-        0b110111001111, 0b111011000101, 0b111111001100, 0b000011001100, 0b000111000101, 0b001011001111, 0b001111000110,
-        0b010011001010, 0b010111000011, 0b011011001001, 0b011111000000, 0b100101010000, 0b100001011001, 0b101101010011,
-        0b101001011010, 0b110101010110, 0b110001011111, 0b111101010101, 0b111001011100, 0b000101011100, 0b000001010101,
-        0b001101011111, 0b001001010110, 0b010101011010, 0b010001010011, 0b011101011001, 0b011001010000, 0b101011110000,
-        0b101111111001, 0b100011110011, 0b100111111010, 0b111011110110, 0b111111111111, 0b110011110101, 0b110111111100,
-        0b001011111100, 0b001111110101, 0b000011111111, 0b000111110110, 0b011011111010, 0b011111110011, 0b010011111001,
-        0b010111110000, 0b101101100000, 0b101001101001, 0b100101100011, 0b100001101010, 0b111101100110, 0b111001101111,
-        0b110101100101, 0b110001101100, 0b001101101100, 0b001001100101, 0b000101101111, 0b000001100110, 0b011101101010,
-        0b011001100011, 0b010101101001, 0b010001100000, 0b110010100000, 0b110110101001, 0b111010100011, 0b111110101010,
-        0b100010100110, 0b100110101111, 0b101010100101, 0b101110101100, 0b010010101100, 0b010110100101, 0b011010101111,
-        0b011110100110, 0b000010101010, 0b000110100011, 0b001010101001, 0b001110100000, 0b110100110000, 0b110000111001,
-        0b111100110011, 0b111000111010, 0b100100110110, 0b100000111111, 0b101100110101, 0b101000111100, 0b010100111100,
-        0b010000110101, 0b011100111111, 0b011000110110, 0b000100111010, 0b000000110011, 0b001100111001, 0b001000110000,
-        0b111010010000, 0b111110011001, 0b110010010011, 0b110110011010, 0b101010010110, 0b101110011111, 0b100010010101,
-        0b100110011100, 0b011010011100, 0b011110010101, 0b010010011111, 0b010110010110, 0b001010011010, 0b001110010011,
-        0b000010011001, 0b000110010000, 0b111100000000, 0b111000001001, 0b110100000011, 0b110000001010, 0b101100000110,
-        0b101000001111, 0b100100000101, 0b100000001100, 0b011100001100, 0b011000000101, 0b010100001111, 0b010000000110,
-        0b001100001010, 0b001000000011, 0b000100001001, 0b000000000000
-    } };
-
-    // Determine which triangulation (0-5 triangles) is needed given the edge-surface intersections.
-    std::array< std::array<int32_t, 16>, 256> a2iTriangleConnectionTable  { {
-           { -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  1,  9,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  8,  3,    9,  8,  1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8,  3,    1,  2, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  2, 10,    0,  2,  9,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2,  8,  3,    2, 10,  8,   10,  9,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3, 11,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0, 11,  2,    8, 11,  0,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  9,  0,    2,  3, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1, 11,  2,    1,  9, 11,    9,  8, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3, 10,  1,   11, 10,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0, 10,  1,    0,  8, 10,    8, 11, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  9,  0,    3, 11,  9,   11, 10,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  8, 10,   10,  8, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  7,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  3,  0,    7,  3,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  1,  9,    8,  4,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  1,  9,    4,  7,  1,    7,  3,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2, 10,    8,  4,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  4,  7,    3,  0,  4,    1,  2, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  2, 10,    9,  0,  2,    8,  4,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2, 10,  9,    2,  9,  7,    2,  7,  3,    7,  9,  4,   -1, -1, -1,   -1 },
-           {  8,  4,  7,    3, 11,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 11,  4,  7,   11,  2,  4,    2,  0,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  0,  1,    8,  4,  7,    2,  3, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  7, 11,    9,  4, 11,    9, 11,  2,    9,  2,  1,   -1, -1, -1,   -1 },
-           {  3, 10,  1,    3, 11, 10,    7,  8,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1, 11, 10,    1,  4, 11,    1,  0,  4,    7, 11,  4,   -1, -1, -1,   -1 },
-           {  4,  7,  8,    9,  0, 11,    9, 11, 10,   11,  0,  3,   -1, -1, -1,   -1 },
-           {  4,  7, 11,    4, 11,  9,    9, 11, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  5,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  5,  4,    0,  8,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  5,  4,    1,  5,  0,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  8,  5,  4,    8,  3,  5,    3,  1,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2, 10,    9,  5,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  0,  8,    1,  2, 10,    4,  9,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5,  2, 10,    5,  4,  2,    4,  0,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2, 10,  5,    3,  2,  5,    3,  5,  4,    3,  4,  8,   -1, -1, -1,   -1 },
-           {  9,  5,  4,    2,  3, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0, 11,  2,    0,  8, 11,    4,  9,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  5,  4,    0,  1,  5,    2,  3, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2,  1,  5,    2,  5,  8,    2,  8, 11,    4,  8,  5,   -1, -1, -1,   -1 },
-           { 10,  3, 11,   10,  1,  3,    9,  5,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  9,  5,    0,  8,  1,    8, 10,  1,    8, 11, 10,   -1, -1, -1,   -1 },
-           {  5,  4,  0,    5,  0, 11,    5, 11, 10,   11,  0,  3,   -1, -1, -1,   -1 },
-           {  5,  4,  8,    5,  8, 10,   10,  8, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  7,  8,    5,  7,  9,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  3,  0,    9,  5,  3,    5,  7,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  7,  8,    0,  1,  7,    1,  5,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  5,  3,    3,  5,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  7,  8,    9,  5,  7,   10,  1,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  1,  2,    9,  5,  0,    5,  3,  0,    5,  7,  3,   -1, -1, -1,   -1 },
-           {  8,  0,  2,    8,  2,  5,    8,  5,  7,   10,  5,  2,   -1, -1, -1,   -1 },
-           {  2, 10,  5,    2,  5,  3,    3,  5,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  7,  9,  5,    7,  8,  9,    3, 11,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  5,  7,    9,  7,  2,    9,  2,  0,    2,  7, 11,   -1, -1, -1,   -1 },
-           {  2,  3, 11,    0,  1,  8,    1,  7,  8,    1,  5,  7,   -1, -1, -1,   -1 },
-           { 11,  2,  1,   11,  1,  7,    7,  1,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  5,  8,    8,  5,  7,   10,  1,  3,   10,  3, 11,   -1, -1, -1,   -1 },
-           {  5,  7,  0,    5,  0,  9,    7, 11,  0,    1,  0, 10,   11, 10,  0,   -1 },
-           { 11, 10,  0,   11,  0,  3,   10,  5,  0,    8,  0,  7,    5,  7,  0,   -1 },
-           { 11, 10,  5,    7, 11,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  6,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8,  3,    5, 10,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  0,  1,    5, 10,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  8,  3,    1,  9,  8,    5, 10,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  6,  5,    2,  6,  1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  6,  5,    1,  2,  6,    3,  0,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  6,  5,    9,  0,  6,    0,  2,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5,  9,  8,    5,  8,  2,    5,  2,  6,    3,  2,  8,   -1, -1, -1,   -1 },
-           {  2,  3, 11,   10,  6,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 11,  0,  8,   11,  2,  0,   10,  6,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  1,  9,    2,  3, 11,    5, 10,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5, 10,  6,    1,  9,  2,    9, 11,  2,    9,  8, 11,   -1, -1, -1,   -1 },
-           {  6,  3, 11,    6,  5,  3,    5,  1,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8, 11,    0, 11,  5,    0,  5,  1,    5, 11,  6,   -1, -1, -1,   -1 },
-           {  3, 11,  6,    0,  3,  6,    0,  6,  5,    0,  5,  9,   -1, -1, -1,   -1 },
-           {  6,  5,  9,    6,  9, 11,   11,  9,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5, 10,  6,    4,  7,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  3,  0,    4,  7,  3,    6,  5, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  9,  0,    5, 10,  6,    8,  4,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  6,  5,    1,  9,  7,    1,  7,  3,    7,  9,  4,   -1, -1, -1,   -1 },
-           {  6,  1,  2,    6,  5,  1,    4,  7,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2,  5,    5,  2,  6,    3,  0,  4,    3,  4,  7,   -1, -1, -1,   -1 },
-           {  8,  4,  7,    9,  0,  5,    0,  6,  5,    0,  2,  6,   -1, -1, -1,   -1 },
-           {  7,  3,  9,    7,  9,  4,    3,  2,  9,    5,  9,  6,    2,  6,  9,   -1 },
-           {  3, 11,  2,    7,  8,  4,   10,  6,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5, 10,  6,    4,  7,  2,    4,  2,  0,    2,  7, 11,   -1, -1, -1,   -1 },
-           {  0,  1,  9,    4,  7,  8,    2,  3, 11,    5, 10,  6,   -1, -1, -1,   -1 },
-           {  9,  2,  1,    9, 11,  2,    9,  4, 11,    7, 11,  4,    5, 10,  6,   -1 },
-           {  8,  4,  7,    3, 11,  5,    3,  5,  1,    5, 11,  6,   -1, -1, -1,   -1 },
-           {  5,  1, 11,    5, 11,  6,    1,  0, 11,    7, 11,  4,    0,  4, 11,   -1 },
-           {  0,  5,  9,    0,  6,  5,    0,  3,  6,   11,  6,  3,    8,  4,  7,   -1 },
-           {  6,  5,  9,    6,  9, 11,    4,  7,  9,    7, 11,  9,   -1, -1, -1,   -1 },
-           { 10,  4,  9,    6,  4, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4, 10,  6,    4,  9, 10,    0,  8,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  0,  1,   10,  6,  0,    6,  4,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  8,  3,  1,    8,  1,  6,    8,  6,  4,    6,  1, 10,   -1, -1, -1,   -1 },
-           {  1,  4,  9,    1,  2,  4,    2,  6,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  0,  8,    1,  2,  9,    2,  4,  9,    2,  6,  4,   -1, -1, -1,   -1 },
-           {  0,  2,  4,    4,  2,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  8,  3,  2,    8,  2,  4,    4,  2,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  4,  9,   10,  6,  4,   11,  2,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8,  2,    2,  8, 11,    4,  9, 10,    4, 10,  6,   -1, -1, -1,   -1 },
-           {  3, 11,  2,    0,  1,  6,    0,  6,  4,    6,  1, 10,   -1, -1, -1,   -1 },
-           {  6,  4,  1,    6,  1, 10,    4,  8,  1,    2,  1, 11,    8, 11,  1,   -1 },
-           {  9,  6,  4,    9,  3,  6,    9,  1,  3,   11,  6,  3,   -1, -1, -1,   -1 },
-           {  8, 11,  1,    8,  1,  0,   11,  6,  1,    9,  1,  4,    6,  4,  1,   -1 },
-           {  3, 11,  6,    3,  6,  0,    0,  6,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  6,  4,  8,   11,  6,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  7, 10,  6,    7,  8, 10,    8,  9, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  7,  3,    0, 10,  7,    0,  9, 10,    6,  7, 10,   -1, -1, -1,   -1 },
-           { 10,  6,  7,    1, 10,  7,    1,  7,  8,    1,  8,  0,   -1, -1, -1,   -1 },
-           { 10,  6,  7,   10,  7,  1,    1,  7,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2,  6,    1,  6,  8,    1,  8,  9,    8,  6,  7,   -1, -1, -1,   -1 },
-           {  2,  6,  9,    2,  9,  1,    6,  7,  9,    0,  9,  3,    7,  3,  9,   -1 },
-           {  7,  8,  0,    7,  0,  6,    6,  0,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  7,  3,  2,    6,  7,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2,  3, 11,   10,  6,  8,   10,  8,  9,    8,  6,  7,   -1, -1, -1,   -1 },
-           {  2,  0,  7,    2,  7, 11,    0,  9,  7,    6,  7, 10,    9, 10,  7,   -1 },
-           {  1,  8,  0,    1,  7,  8,    1, 10,  7,    6,  7, 10,    2,  3, 11,   -1 },
-           { 11,  2,  1,   11,  1,  7,   10,  6,  1,    6,  7,  1,   -1, -1, -1,   -1 },
-           {  8,  9,  6,    8,  6,  7,    9,  1,  6,   11,  6,  3,    1,  3,  6,   -1 },
-           {  0,  9,  1,   11,  6,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  7,  8,  0,    7,  0,  6,    3, 11,  0,   11,  6,  0,   -1, -1, -1,   -1 },
-           {  7, 11,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  7,  6, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  0,  8,   11,  7,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  1,  9,   11,  7,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  8,  1,  9,    8,  3,  1,   11,  7,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  1,  2,    6, 11,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2, 10,    3,  0,  8,    6, 11,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2,  9,  0,    2, 10,  9,    6, 11,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  6, 11,  7,    2, 10,  3,   10,  8,  3,   10,  9,  8,   -1, -1, -1,   -1 },
-           {  7,  2,  3,    6,  2,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  7,  0,  8,    7,  6,  0,    6,  2,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2,  7,  6,    2,  3,  7,    0,  1,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  6,  2,    1,  8,  6,    1,  9,  8,    8,  7,  6,   -1, -1, -1,   -1 },
-           { 10,  7,  6,   10,  1,  7,    1,  3,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  7,  6,    1,  7, 10,    1,  8,  7,    1,  0,  8,   -1, -1, -1,   -1 },
-           {  0,  3,  7,    0,  7, 10,    0, 10,  9,    6, 10,  7,   -1, -1, -1,   -1 },
-           {  7,  6, 10,    7, 10,  8,    8, 10,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  6,  8,  4,   11,  8,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  6, 11,    3,  0,  6,    0,  4,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  8,  6, 11,    8,  4,  6,    9,  0,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  4,  6,    9,  6,  3,    9,  3,  1,   11,  3,  6,   -1, -1, -1,   -1 },
-           {  6,  8,  4,    6, 11,  8,    2, 10,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2, 10,    3,  0, 11,    0,  6, 11,    0,  4,  6,   -1, -1, -1,   -1 },
-           {  4, 11,  8,    4,  6, 11,    0,  2,  9,    2, 10,  9,   -1, -1, -1,   -1 },
-           { 10,  9,  3,   10,  3,  2,    9,  4,  3,   11,  3,  6,    4,  6,  3,   -1 },
-           {  8,  2,  3,    8,  4,  2,    4,  6,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  4,  2,    4,  6,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  9,  0,    2,  3,  4,    2,  4,  6,    4,  3,  8,   -1, -1, -1,   -1 },
-           {  1,  9,  4,    1,  4,  2,    2,  4,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  8,  1,  3,    8,  6,  1,    8,  4,  6,    6, 10,  1,   -1, -1, -1,   -1 },
-           { 10,  1,  0,   10,  0,  6,    6,  0,  4,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  6,  3,    4,  3,  8,    6, 10,  3,    0,  3,  9,   10,  9,  3,   -1 },
-           { 10,  9,  4,    6, 10,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  9,  5,    7,  6, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8,  3,    4,  9,  5,   11,  7,  6,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5,  0,  1,    5,  4,  0,    7,  6, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 11,  7,  6,    8,  3,  4,    3,  5,  4,    3,  1,  5,   -1, -1, -1,   -1 },
-           {  9,  5,  4,   10,  1,  2,    7,  6, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  6, 11,  7,    1,  2, 10,    0,  8,  3,    4,  9,  5,   -1, -1, -1,   -1 },
-           {  7,  6, 11,    5,  4, 10,    4,  2, 10,    4,  0,  2,   -1, -1, -1,   -1 },
-           {  3,  4,  8,    3,  5,  4,    3,  2,  5,   10,  5,  2,   11,  7,  6,   -1 },
-           {  7,  2,  3,    7,  6,  2,    5,  4,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  5,  4,    0,  8,  6,    0,  6,  2,    6,  8,  7,   -1, -1, -1,   -1 },
-           {  3,  6,  2,    3,  7,  6,    1,  5,  0,    5,  4,  0,   -1, -1, -1,   -1 },
-           {  6,  2,  8,    6,  8,  7,    2,  1,  8,    4,  8,  5,    1,  5,  8,   -1 },
-           {  9,  5,  4,   10,  1,  6,    1,  7,  6,    1,  3,  7,   -1, -1, -1,   -1 },
-           {  1,  6, 10,    1,  7,  6,    1,  0,  7,    8,  7,  0,    9,  5,  4,   -1 },
-           {  4,  0, 10,    4, 10,  5,    0,  3, 10,    6, 10,  7,    3,  7, 10,   -1 },
-           {  7,  6, 10,    7, 10,  8,    5,  4, 10,    4,  8, 10,   -1, -1, -1,   -1 },
-           {  6,  9,  5,    6, 11,  9,   11,  8,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  6, 11,    0,  6,  3,    0,  5,  6,    0,  9,  5,   -1, -1, -1,   -1 },
-           {  0, 11,  8,    0,  5, 11,    0,  1,  5,    5,  6, 11,   -1, -1, -1,   -1 },
-           {  6, 11,  3,    6,  3,  5,    5,  3,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2, 10,    9,  5, 11,    9, 11,  8,   11,  5,  6,   -1, -1, -1,   -1 },
-           {  0, 11,  3,    0,  6, 11,    0,  9,  6,    5,  6,  9,    1,  2, 10,   -1 },
-           { 11,  8,  5,   11,  5,  6,    8,  0,  5,   10,  5,  2,    0,  2,  5,   -1 },
-           {  6, 11,  3,    6,  3,  5,    2, 10,  3,   10,  5,  3,   -1, -1, -1,   -1 },
-           {  5,  8,  9,    5,  2,  8,    5,  6,  2,    3,  8,  2,   -1, -1, -1,   -1 },
-           {  9,  5,  6,    9,  6,  0,    0,  6,  2,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  5,  8,    1,  8,  0,    5,  6,  8,    3,  8,  2,    6,  2,  8,   -1 },
-           {  1,  5,  6,    2,  1,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  3,  6,    1,  6, 10,    3,  8,  6,    5,  6,  9,    8,  9,  6,   -1 },
-           { 10,  1,  0,   10,  0,  6,    9,  5,  0,    5,  6,  0,   -1, -1, -1,   -1 },
-           {  0,  3,  8,    5,  6, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  5,  6,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 11,  5, 10,    7,  5, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 11,  5, 10,   11,  7,  5,    8,  3,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5, 11,  7,    5, 10, 11,    1,  9,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 10,  7,  5,   10, 11,  7,    9,  8,  1,    8,  3,  1,   -1, -1, -1,   -1 },
-           { 11,  1,  2,   11,  7,  1,    7,  5,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8,  3,    1,  2,  7,    1,  7,  5,    7,  2, 11,   -1, -1, -1,   -1 },
-           {  9,  7,  5,    9,  2,  7,    9,  0,  2,    2, 11,  7,   -1, -1, -1,   -1 },
-           {  7,  5,  2,    7,  2, 11,    5,  9,  2,    3,  2,  8,    9,  8,  2,   -1 },
-           {  2,  5, 10,    2,  3,  5,    3,  7,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  8,  2,  0,    8,  5,  2,    8,  7,  5,   10,  2,  5,   -1, -1, -1,   -1 },
-           {  9,  0,  1,    5, 10,  3,    5,  3,  7,    3, 10,  2,   -1, -1, -1,   -1 },
-           {  9,  8,  2,    9,  2,  1,    8,  7,  2,   10,  2,  5,    7,  5,  2,   -1 },
-           {  1,  3,  5,    3,  7,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8,  7,    0,  7,  1,    1,  7,  5,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  0,  3,    9,  3,  5,    5,  3,  7,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9,  8,  7,    5,  9,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5,  8,  4,    5, 10,  8,   10, 11,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  5,  0,  4,    5, 11,  0,    5, 10, 11,   11,  3,  0,   -1, -1, -1,   -1 },
-           {  0,  1,  9,    8,  4, 10,    8, 10, 11,   10,  4,  5,   -1, -1, -1,   -1 },
-           { 10, 11,  4,   10,  4,  5,   11,  3,  4,    9,  4,  1,    3,  1,  4,   -1 },
-           {  2,  5,  1,    2,  8,  5,    2, 11,  8,    4,  5,  8,   -1, -1, -1,   -1 },
-           {  0,  4, 11,    0, 11,  3,    4,  5, 11,    2, 11,  1,    5,  1, 11,   -1 },
-           {  0,  2,  5,    0,  5,  9,    2, 11,  5,    4,  5,  8,   11,  8,  5,   -1 },
-           {  9,  4,  5,    2, 11,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2,  5, 10,    3,  5,  2,    3,  4,  5,    3,  8,  4,   -1, -1, -1,   -1 },
-           {  5, 10,  2,    5,  2,  4,    4,  2,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3, 10,  2,    3,  5, 10,    3,  8,  5,    4,  5,  8,    0,  1,  9,   -1 },
-           {  5, 10,  2,    5,  2,  4,    1,  9,  2,    9,  4,  2,   -1, -1, -1,   -1 },
-           {  8,  4,  5,    8,  5,  3,    3,  5,  1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  4,  5,    1,  0,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  8,  4,  5,    8,  5,  3,    9,  0,  5,    0,  3,  5,   -1, -1, -1,   -1 },
-           {  9,  4,  5,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4, 11,  7,    4,  9, 11,    9, 10, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  8,  3,    4,  9,  7,    9, 11,  7,    9, 10, 11,   -1, -1, -1,   -1 },
-           {  1, 10, 11,    1, 11,  4,    1,  4,  0,    7,  4, 11,   -1, -1, -1,   -1 },
-           {  3,  1,  4,    3,  4,  8,    1, 10,  4,    7,  4, 11,   10, 11,  4,   -1 },
-           {  4, 11,  7,    9, 11,  4,    9,  2, 11,    9,  1,  2,   -1, -1, -1,   -1 },
-           {  9,  7,  4,    9, 11,  7,    9,  1, 11,    2, 11,  1,    0,  8,  3,   -1 },
-           { 11,  7,  4,   11,  4,  2,    2,  4,  0,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { 11,  7,  4,   11,  4,  2,    8,  3,  4,    3,  2,  4,   -1, -1, -1,   -1 },
-           {  2,  9, 10,    2,  7,  9,    2,  3,  7,    7,  4,  9,   -1, -1, -1,   -1 },
-           {  9, 10,  7,    9,  7,  4,   10,  2,  7,    8,  7,  0,    2,  0,  7,   -1 },
-           {  3,  7, 10,    3, 10,  2,    7,  4, 10,    1, 10,  0,    4,  0, 10,   -1 },
-           {  1, 10,  2,    8,  7,  4,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  9,  1,    4,  1,  7,    7,  1,  3,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  9,  1,    4,  1,  7,    0,  8,  1,    8,  7,  1,   -1, -1, -1,   -1 },
-           {  4,  0,  3,    7,  4,  3,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  4,  8,  7,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9, 10,  8,   10, 11,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  0,  9,    3,  9, 11,   11,  9, 10,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  1, 10,    0, 10,  8,    8, 10, 11,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  1, 10,   11,  3, 10,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  2, 11,    1, 11,  9,    9, 11,  8,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  0,  9,    3,  9, 11,    1,  2,  9,    2, 11,  9,   -1, -1, -1,   -1 },
-           {  0,  2, 11,    8,  0, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  3,  2, 11,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2,  3,  8,    2,  8, 10,   10,  8,  9,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  9, 10,  2,    0,  9,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  2,  3,  8,    2,  8, 10,    0,  1,  8,    1, 10,  8,   -1, -1, -1,   -1 },
-           {  1, 10,  2,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  1,  3,  8,    9,  1,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  9,  1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           {  0,  3,  8,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 },
-           { -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 }
-    } };
-
-    // Convert an edge index to the corner vertex indices for a cube.
-    const std::array< std::array<int32_t, 2>, 12> a2iEdgeConnection { {
-        {0, 1}, {1, 2}, {2, 3}, {3, 0},  // Bottom face.
-        {4, 5}, {5, 6}, {6, 7}, {7, 4},  // Top face.
-        {0, 4}, {1, 5}, {2, 6}, {3, 7}   // Side faces.
-    } };
-
-    // Storage used for the final mesh triangle vertices and faces.
     std::vector<Kernel::Point_3> mesh_triangle_verts;
     std::vector< std::array<size_t, 3> > mesh_triangle_faces;
+    mesh_triangle_verts.reserve(fvsm.vertices.size());
+    mesh_triangle_faces.reserve(fvsm.faces.size());
+    for(const auto &v : fvsm.vertices){
+        mesh_triangle_verts.emplace_back( Kernel::Point_3( v.x, v.y, v.z ) );
+    }
+    for(const auto &f : fvsm.faces){
+        mesh_triangle_faces.push_back( {{ static_cast<size_t>(f.at(0)),
+                                          static_cast<size_t>(f.at(1)),
+                                          static_cast<size_t>(f.at(2)) }} );
+    }
 
-    std::mutex saver_printer; // Thread synchro lock for saving shared data, logging, and counter iterating.
-    long int completed = 0;
-    const long int img_count = grid_imgs.size();
-
-    // Iterate over all voxels, traversing the images in order of adjacency for consistency.
-    //
-    // NOTE: The order of traversal must reflect image adjacency. This requirement could be relaxed if candidate
-    //       vertices (below) were indexed, but even this would involve extra memory usage for little gain.
-    for(const auto &img_ptr : img_adj.int_to_img){
-        const auto img_refw = std::ref( *img_ptr );
-
-        const auto pxl_dx = img_refw.get().pxl_dx;
-        const auto pxl_dy = img_refw.get().pxl_dy;
-        const auto pxl_dz = img_refw.get().pxl_dz;
-
-        const auto row_unit = img_refw.get().row_unit.unit();
-        const auto col_unit = img_refw.get().col_unit.unit();
-        const auto img_unit = row_unit.Cross(col_unit).unit();
-
-        // Tolerance for deciding if meshed vertices are identical. If too lax, then topological inconsistencies may
-        // result; if too tight, then the mesh will either be non-watertight, non-manifold, or will be constructed in an
-        // invalid way by the mesher.
-        //
-        // The following tolerance was estimated with a Gaussian-smoothed spherical phantom.
-        // If these tolerances are increased, meshing will 'wobble' around the boundary and possibly create zero-area
-        // needles and surface crossovers. However, merely setting the tolerance to zero will likely cause meshing to
-        // fail outright.
-        constexpr auto machine_eps = std::numeric_limits<double>::epsilon();
-        const auto dvec3_tol = std::max(
-                                   std::min( { pxl_dx, pxl_dy, pxl_dz } ) * 1E-4,
-                                   std::sqrt(machine_eps) * 100.0 ); // Guard against pxl_dz = 0.
-
-        // List of Marching Cube voxel corner positions relative to image voxel centre.
-        //
-        // Note that the Marching cube and image voxels are not the same. They are offset such that
-        // the corner of the Marching Cube voxel is at the centre of the image voxel. This is done
-        // to avoid surface discontinuties that would arise from sampling the boundary of border
-        // voxels; numerical instability could potentially lead to random fluctuation by 1 voxel width on
-        // straight borders.
-        const std::array< vec3<double>, 8> a2fVertexOffset { {
-            (zero3),
-            (zero3 + row_unit * pxl_dx),
-            (zero3 + row_unit * pxl_dx + col_unit * pxl_dy),
-            (zero3 + col_unit * pxl_dy),
-
-            (zero3 + img_unit * pxl_dz),
-            (zero3 + row_unit * pxl_dx + img_unit * pxl_dz),
-            (zero3 + row_unit * pxl_dx + col_unit * pxl_dy + img_unit * pxl_dz),
-            (zero3 + col_unit * pxl_dy + img_unit * pxl_dz)
-        } };
-
-        // The vector needed to translate from tail to head for each edge.
-        const std::array< vec3<double>, 12> a2fEdgeDirection { {
-            row_unit * pxl_dx, // Bottom face.
-            col_unit * pxl_dy,
-            row_unit * -pxl_dx,
-            col_unit * -pxl_dy,
-
-            row_unit * pxl_dx, // Top face.
-            col_unit * pxl_dy,
-            row_unit * -pxl_dx,
-            col_unit * -pxl_dy,
-
-            img_unit * pxl_dz, // Side faces.
-            img_unit * pxl_dz,
-            img_unit * pxl_dz,
-            img_unit * pxl_dz
-        } };
-
-
-        const auto img_num = img_adj.image_to_index( img_refw );
-        const auto img_num_p1 = img_num + 1;
-        const auto img_is_adj = img_adj.index_present(img_num_p1);
-        const auto img_p1 = (img_is_adj) ? img_adj.index_to_image(img_num_p1) : img_refw;
-
-        const auto N_rows = img_refw.get().rows;
-        const auto N_cols = img_refw.get().columns;
-        for(long int row = 0; row < N_rows; ++row){
-            for(long int col = 0; col < N_cols; ++col){
-                const auto pos = img_refw.get().position(row, col);
-
-                // Sample voxel corner values.
-                std::array<double, 8> afCubeValue;
-                //
-                // Option A: Interpolate. This way is slow but extremely flexible.
-                //for(int32_t corner = 0; corner < 8; ++corner){
-                //    afCubeValue[corner] = surface_oracle(pos + a2fVertexOffset[corner]);
-                //}
-                //
-                // Option B: Align Marching Cube voxel corners with image voxel centres. This way is fast.
-                {
-                    const auto row_p1 = (row+1);
-                    const auto row_is_adj = (row_p1 < N_rows);
-
-                    const auto col_p1 = (col+1);
-                    const auto col_is_adj = (col_p1 < N_cols);
-
-                    afCubeValue[0] = img_refw.get().value(row, col, 0);
-                    afCubeValue[1] = (row_is_adj)                             ? img_refw.get().value(row_p1, col, 0)    : ExteriorVal;
-                    afCubeValue[2] = (row_is_adj && col_is_adj)               ? img_refw.get().value(row_p1, col_p1, 0) : ExteriorVal;
-                    afCubeValue[3] = (col_is_adj)                             ? img_refw.get().value(row, col_p1, 0)    : ExteriorVal;
-                    afCubeValue[4] = (img_is_adj)                             ? img_p1.get().value(row, col, 0)         : ExteriorVal;
-                    afCubeValue[5] = (row_is_adj && img_is_adj)               ? img_p1.get().value(row_p1, col, 0)      : ExteriorVal;
-                    afCubeValue[6] = (row_is_adj && col_is_adj && img_is_adj) ? img_p1.get().value(row_p1, col_p1, 0)   : ExteriorVal;
-                    afCubeValue[7] = (col_is_adj && img_is_adj)               ? img_p1.get().value(row, col_p1, 0)      : ExteriorVal;
-                }
-
-                // Convert vertex inclusion to a bitmask.
-                int32_t iFlagIndex = 0;
-                for(int32_t corner = 0; corner < 8; ++corner){
-                    if(below_is_interior){
-                        if(afCubeValue[corner] <= inclusion_threshold) iFlagIndex |= (1 << corner);
-                    }else{
-                        if(afCubeValue[corner] >= inclusion_threshold) iFlagIndex |= (1 << corner);
-                    }
-                }
-
-                // Convert vertex inclusion into a list of 'involved' edges that cross the ROI surface.
-                const int32_t iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
-
-                // If the cube is entirely inside or outside of the surface, then there will be no intersections.
-                if(iEdgeFlags == 0) continue;
-
-                // Find the point of intersection of the surface with each edge.
-                std::array<vec3<double>, 12> asEdgeVertex;
-                for(int32_t edge = 0; edge < 12; edge++){
-                    if(iEdgeFlags & (1 << edge)){ // continue iff involved.
-
-                        const double value_A = afCubeValue[a2iEdgeConnection[edge][0]];
-                        const double value_B = afCubeValue[a2iEdgeConnection[edge][1]];
-
-                        // Find the (approximate) point along the edge where the surface intersects, parameterized to [0:1].
-                        const double d_value = (value_B - value_A);
-                        const double inv_d_value = static_cast<double>(1.0)/d_value;
-                        const double lin_interp = (inclusion_threshold - value_A) * inv_d_value;
-                        const double surf_dl = std::isfinite(lin_interp) ? lin_interp : static_cast<double>(0.5);
-                        if(!isininc(0.0,surf_dl,1.0)){
-                            throw std::logic_error("Interpolation of surface-edge intersection failed. Refusing to continue");
-                        }
-
-                        asEdgeVertex[edge] = (a2fEdgeDirection[edge] * surf_dl);
-                        asEdgeVertex[edge] += a2fVertexOffset[a2iEdgeConnection[edge][0]];
-                        asEdgeVertex[edge] += pos;
-                    }
-                }
-
-                // Process the triangles that were identified.
-                for(int32_t tri = 0; tri < 5; tri++){
-
-                    // Stop when the first -1 index is encountered (signifying there are no further triangles).
-                    if(a2iTriangleConnectionTable[iFlagIndex][3*tri] < 0) break;
-
-                    std::array<vec3<double>, 3> tri_verts;
-                    for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
-                        const int32_t vert_idx = a2iTriangleConnectionTable[iFlagIndex][3*tri + tri_corner];
-                        tri_verts[tri_corner] = asEdgeVertex[vert_idx];
-    
-                    }
-
-                    // Determine which vertices should be used; if there are existing vertices sufficiently nearby, use
-                    // them rather than adding a new (disconnected) vertex.
-                    //
-                    // Note: Existing vertices created for adjacent voxels are more likely to be placed near the back of
-                    //       the vector. Using reverse iterators for searching rather than forward iterators more than
-                    //       halves the time this entire routine takes. 
-                    //
-                    // TODO: Below we use a generic lookup that considers the last N vertices added where N is selected
-                    //       so that it will include all possibly-adjacent voxels (in the worst case). While this works
-                    //       to limit needless complexity when there are many voxels, it is wasteful and could be
-                    //       improved. For example, spatial indexing of some kind could be used to speed up dupe vertex
-                    //       searching, or this could be fully eliminated by exploiting the grid nature or keeping an
-                    //       explicit list of vertices still reachable.
-                    //
-                    //       Note that the last-N-only lookup below implicitly assumes images are ordered AND traversed
-                    //       in adjacent order. 
-                    const auto min_consider = static_cast<long int>( ( N_rows * N_cols + 1 + std::max(N_rows, N_cols) + 1 ) * 5 * 3 );
-
-                    std::array<size_t, 3> vert_indices;
-                    std::vector<Kernel::Point_3> new_verts;
-                    for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
-                        const auto N_verts = static_cast<long int>( mesh_triangle_verts.size() );
-                        const auto consider = std::min( min_consider, N_verts );
-                        const auto rend = std::next(std::rbegin(mesh_triangle_verts), consider);
-                        auto v_it = std::find_if( //std::execution::par_unseq,
-                                                  std::rbegin(mesh_triangle_verts),
-                                                  rend,
-                                                  [=]( const Kernel::Point_3 &cv ) -> bool {
-                                                      const vec3<double> v( cv[0], cv[1], cv[2] );
-                                                      return (tri_verts[tri_corner].sq_dist(v) < (dvec3_tol*dvec3_tol));
-                                                  } );
-                        
-                        if(v_it != std::rend(mesh_triangle_verts)){
-                            vert_indices[tri_corner] = mesh_triangle_verts.size() - std::distance(std::rbegin(mesh_triangle_verts), v_it) - 1;
-                        }else{
-                            new_verts.emplace_back( Kernel::Point_3( 
-                                    tri_verts[tri_corner].x, tri_verts[tri_corner].y, tri_verts[tri_corner].z ) );
-                            vert_indices[tri_corner] = (mesh_triangle_verts.size() + new_verts.size() - 1);
-                        }
-                    }
-                    if( (vert_indices[0] != vert_indices[1]) // IFF all three vertices are distinct from one another.
-                    &&  (vert_indices[0] != vert_indices[2])
-                    &&  (vert_indices[1] != vert_indices[2]) ){
-                        mesh_triangle_faces.emplace_back(vert_indices);
-                        mesh_triangle_verts.insert( std::end(mesh_triangle_verts), 
-                                                    std::begin(new_verts), std::end(new_verts) );
-                    }else{
-                        FUNCWARN("Encountered a zero-area triangle face. Ignoring it");
-                    }
-                }
-
-            } // Loop over columns.
-        } // Loop over rows.
-
-        //Report operation progress.
-        {
-            std::lock_guard<std::mutex> lock(saver_printer);
-            ++completed;
-            FUNCINFO("Completed " << completed << " of " << img_count
-                  << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-        }
-    } // Loop over images.
-
+    // Note: faces are already consistently oriented, but this also splits any non-manifold vertices.
     FUNCINFO("Orienting face normals..");
     CGAL::Polygon_mesh_processing::orient_polygon_soup(mesh_triangle_verts, mesh_triangle_faces);
 
@@ -1141,9 +606,11 @@ Marching_Cubes_Implementation(
 // NOTE: This routine will handle ROIs with several disconnected components (e.g., "eyes"). But all components
 //       will be lumped together into a single polyhedron.
 //
-Polyhedron Estimate_Surface_Mesh_Marching_Cubes(
+static
+Polyhedron Estimate_Surface_Mesh_Marching_Cubes_Uncached(
         const std::list<std::reference_wrapper<contour_collection<double>>>& cc_ROIs,
         Parameters params ){
+    DCMA_TRACE_ZONE("meshing", "Estimate_Surface_Mesh_Marching_Cubes (contours)");
 
     // Define the convention we will use in our mask.
     const double inclusion_threshold = 0.0;
@@ -1326,6 +793,7 @@ Estimate_Surface_Mesh_Marching_Cubes(
                                  // If true, anything <= is considered to be interior to the surface.
                                  // If false, anything >= is considered to be interior to the surface.
         Parameters params ){
+    DCMA_TRACE_ZONE("meshing", "Estimate_Surface_Mesh_Marching_Cubes");
 
     if(grid_imgs.empty()){
         throw std::invalid_argument("An insufficient number of images was provided. Cannot continue.");
@@ -1511,8 +979,171 @@ FVSMeshToPolyhedron(
     return output_mesh;
 }
 
+
+// Converts a polyhedron into a face-vertex surface mesh. Faces are not triangulated.
+fv_surface_mesh<double, uint64_t>
+PolyhedronToFVSMesh(
+        const Polyhedron &in ){
+
+    fv_surface_mesh<double, uint64_t> out;
+    out.vertices.reserve(in.size_of_vertices());
+    out.faces.reserve(in.size_of_facets());
+
+    std::map<Polyhedron::Vertex_const_handle, uint64_t> v_index;
+    for(auto v_it = in.vertices_begin(); v_it != in.vertices_end(); ++v_it){
+        const auto &p = v_it->point();
+        v_index[v_it] = static_cast<uint64_t>(out.vertices.size());
+        out.vertices.emplace_back( static_cast<double>( CGAL::to_double( p.x() ) ),
+                                   static_cast<double>( CGAL::to_double( p.y() ) ),
+                                   static_cast<double>( CGAL::to_double( p.z() ) ) );
+    }
+
+    for(auto f_it = in.facets_begin(); f_it != in.facets_end(); ++f_it){
+        std::vector<uint64_t> face;
+        auto h_it = f_it->facet_begin();
+        do{
+            face.emplace_back( v_index.at(h_it->vertex()) );
+        }while(++h_it != f_it->facet_begin());
+        out.faces.emplace_back(face);
+    }
+    return out;
+}
+
 } // namespace dcma_surface_meshes.
 
+// ------------------------------------------------ Contour mesh caching ----------------------------------------------
+namespace dcma_surface_meshes {
+
+namespace {
+
+enum class meshing_method : uint64_t {
+    Extrusion,
+    MarchingCubes,
+};
+
+// Identifies a meshing request. The hash digests the contour vertices and all meshing parameters; the vertex and contour
+// counts are retained separately to further guard against collisions.
+struct mesh_cache_key {
+    meshing_method method;
+    uint64_t hash;
+    uint64_t N_contours;
+    uint64_t N_vertices;
+
+    bool operator==(const mesh_cache_key &rhs) const {
+        return (this->method == rhs.method)
+            && (this->hash == rhs.hash)
+            && (this->N_contours == rhs.N_contours)
+            && (this->N_vertices == rhs.N_vertices);
+    }
+};
+
+mesh_cache_key
+Make_Mesh_Cache_Key(meshing_method method,
+                    const std::list<std::reference_wrapper<contour_collection<double>>> &cc_ROIs,
+                    const Parameters &params){
+    mesh_cache_key key;
+    key.method = method;
+    key.N_contours = 0;
+    key.N_vertices = 0;
+
+    content_hasher H;
+    H.add(static_cast<uint64_t>(method));
+    H.add(static_cast<uint64_t>(params.NumberOfImages));
+    H.add(static_cast<uint64_t>(params.GridRows));
+    H.add(static_cast<uint64_t>(params.GridColumns));
+    H.add(static_cast<uint64_t>(params.MutateOpts.editstyle));
+    H.add(static_cast<uint64_t>(params.MutateOpts.inclusivity));
+    H.add(static_cast<uint64_t>(params.MutateOpts.contouroverlap));
+    H.add(static_cast<uint64_t>(params.MutateOpts.aggregate));
+    H.add(static_cast<uint64_t>(params.MutateOpts.adjacency));
+    H.add(static_cast<uint64_t>(params.MutateOpts.maskmod));
+    H.add(static_cast<uint64_t>(params.RQ));
+
+    for(const auto &cc_refw : cc_ROIs){
+        H.add(static_cast<uint64_t>(cc_refw.get().contours.size()));
+        for(const auto &c : cc_refw.get().contours){
+            H.add(static_cast<uint64_t>(c.closed));
+            H.add(static_cast<uint64_t>(c.points.size()));
+            for(const auto &p : c.points) H.add(p);
+            key.N_vertices += c.points.size();
+            ++key.N_contours;
+        }
+    }
+    key.hash = H.digest();
+    return key;
+}
+
+// A small, process-wide, least-recently-used cache. Meshes can be large, so only a handful are retained.
+constexpr size_t mesh_cache_capacity = 16;
+std::mutex mesh_cache_m;
+std::list<std::pair<mesh_cache_key, std::shared_ptr<const Polyhedron>>> mesh_cache;
+
+std::shared_ptr<const Polyhedron>
+Mesh_Cache_Lookup(const mesh_cache_key &key){
+    std::lock_guard<std::mutex> lock(mesh_cache_m);
+    const auto it = std::find_if(std::begin(mesh_cache), std::end(mesh_cache),
+                                 [&](const auto &e){ return (e.first == key); });
+    if(it == std::end(mesh_cache)) return nullptr;
+    mesh_cache.splice(std::begin(mesh_cache), mesh_cache, it);
+    return mesh_cache.front().second;
+}
+
+void
+Mesh_Cache_Insert(const mesh_cache_key &key, const Polyhedron &mesh){
+    auto p = std::make_shared<const Polyhedron>(mesh);
+    std::lock_guard<std::mutex> lock(mesh_cache_m);
+    mesh_cache.remove_if([&](const auto &e){ return (e.first == key); });
+    mesh_cache.emplace_front(key, std::move(p));
+    while(mesh_cache_capacity < mesh_cache.size()) mesh_cache.pop_back();
+}
+
+// Consults the cache before meshing. Concurrent requests for the same mesh may both compute it, but the cache is not
+// locked while meshing so unrelated requests are not serialized.
+template <class F>
+Polyhedron
+Cached_Mesh(meshing_method method,
+            const std::list<std::reference_wrapper<contour_collection<double>>> &cc_ROIs,
+            const Parameters &params,
+            F mesher){
+    if(!params.UseCache) return mesher();
+
+    const auto key = Make_Mesh_Cache_Key(method, cc_ROIs, params);
+    if(const auto cached = Mesh_Cache_Lookup(key)){
+        FUNCINFO("Re-using cached surface mesh");
+        return *cached;
+    }
+    auto mesh = mesher();
+    Mesh_Cache_Insert(key, mesh);
+    return mesh;
+}
+
+} // namespace
+
+void
+Clear_Surface_Mesh_Cache(){
+    std::lock_guard<std::mutex> lock(mesh_cache_m);
+    mesh_cache.clear();
+}
+
+Polyhedron Estimate_Surface_Mesh(
+        std::list<std::reference_wrapper<contour_collection<double>>> cc_ROIs,
+        Parameters params ){
+    return Cached_Mesh(meshing_method::Extrusion, cc_ROIs, params, [&](){
+        return Estimate_Surface_Mesh_Uncached(cc_ROIs, params);
+    });
+}
+
+Polyhedron Estimate_Surface_Mesh_Marching_Cubes(
+        const std::list<std::reference_wrapper<contour_collection<double>>>& cc_ROIs,
+        Parameters params ){
+    return Cached_Mesh(meshing_method::MarchingCubes, cc_ROIs, params, [&](){
+        return Estimate_Surface_Mesh_Marching_Cubes_Uncached(cc_ROIs, params);
+    });
+}
+
+} // namespace dcma_surface_meshes.
+
+
 
 
 namespace polyhedron_processing {
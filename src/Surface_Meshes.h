@@ -50,9 +50,15 @@ struct Parameters {
     //   many vertices to reasonably dilate or erode.
     ReproductionQuality RQ = ReproductionQuality::High;
 
+    // Whether to consult (and populate) the process-wide mesh cache. Contour-based meshing is expensive and the same
+    // ROIs are often meshed repeatedly within a single invocation, so meshes are cached, keyed on the contour vertices
+    // and the parameters above. Disable for one-off meshes that would needlessly displace other entries.
+    bool UseCache = true;
+
 };
 
 
+// Contour-based meshing routines. Results are cached (see Parameters::UseCache).
 Polyhedron
 Estimate_Surface_Mesh(
         std::list<std::reference_wrapper<contour_collection<double>>> cc_ROIs,
@@ -81,11 +87,21 @@ Estimate_Surface_Mesh_AdvancingFront(
         Parameters p );
 
 
+// Discards all cached contour-based meshes.
+void
+Clear_Surface_Mesh_Cache();
+
+
 Polyhedron
 FVSMeshToPolyhedron(
         const fv_surface_mesh<double, uint64_t> &mesh );
 
 
+fv_surface_mesh<double, uint64_t>
+PolyhedronToFVSMesh(
+        const Polyhedron &mesh );
+
+
 } // namespace dcma_surface_meshes
 
 
@@ -0,0 +1,133 @@
+//Synthetic_Images.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Common_Boost_Serialization.h"
+#include "Imebra_Shim.h"      //Needed for Generate_Random_UID().
+#include "Structs.h"
+#include "Thread_Pool.h"
+
+#include "Synthetic_Images.h"
+
+
+namespace {
+
+std::string to_dicom_vec3(const vec3<double> &v){
+    return std::to_string(v.x) + "\\" + std::to_string(v.y) + "\\" + std::to_string(v.z);
+}
+
+void validate(const synthetic_image_series &series){
+    if( (series.images < 0) || (series.rows <= 0) || (series.columns <= 0) || (series.channels <= 0) ){
+        throw std::invalid_argument("Synthetic image dimensions are invalid");
+    }
+    if(!series.fill){
+        throw std::invalid_argument("Synthetic images require a fill routine");
+    }
+    return;
+}
+
+// Generates images [first, first + imgs.size()) of the series into the given images, concurrently.
+void generate(const synthetic_image_series &series,
+              const std::map<std::string, std::string> &shared,
+              long int first,
+              const std::vector<planar_image<float,double> *> &imgs){
+
+    // UIDs are generated serially so user-provided generators need not be thread-safe, and so they follow image order.
+    std::vector<std::string> uids;
+    uids.reserve(imgs.size());
+    for(size_t i = 0; i < imgs.size(); ++i){
+        uids.emplace_back( (series.generate_uid) ? series.generate_uid() : Generate_Random_UID(60) );
+    }
+
+    parallel_for(0, static_cast<long int>(imgs.size()), [&](long int i) -> void {
+        const long int index = first + i;
+        const auto position = series.position + series.step * static_cast<double>(index);
+        auto &img = *(imgs[i]);
+
+        img.metadata = shared;
+        img.metadata["SOPInstanceUID"] = uids[i];
+        img.metadata["ImagePositionPatient"] = to_dicom_vec3(position);
+
+        img.init_orientation(series.row_unit, series.col_unit);
+        img.init_buffer(series.rows, series.columns, series.channels);
+        img.init_spatial(series.pxl_dx, series.pxl_dy, series.pxl_dz, series.anchor, position);
+
+        series.fill(index, img);
+    }, 1);
+    return;
+}
+
+// The metadata common to every image: the caller's along with the geometry.
+std::map<std::string, std::string> shared_metadata(const synthetic_image_series &series){
+    auto shared = series.metadata;
+    shared["Rows"] = std::to_string(series.rows);
+    shared["Columns"] = std::to_string(series.columns);
+    shared["SliceThickness"] = std::to_string(series.pxl_dz);
+    shared["PixelSpacing"] = std::to_string(series.pxl_dx) + "\\" + std::to_string(series.pxl_dy);
+    shared["ImageOrientationPatient"] = to_dicom_vec3(series.row_unit) + "\\" + to_dicom_vec3(series.col_unit);
+    return shared;
+}
+
+} // namespace
+
+
+std::unique_ptr<Image_Array> Generate_Synthetic_Images(const synthetic_image_series &series){
+    validate(series);
+
+    auto out = std::make_unique<Image_Array>();
+    out->imagecoll.images.resize(static_cast<size_t>(series.images));
+
+    std::vector<planar_image<float,double> *> imgs;
+    imgs.reserve(static_cast<size_t>(series.images));
+    for(auto &img : out->imagecoll.images) imgs.push_back( &img );
+
+    generate(series, shared_metadata(series), 0, imgs);
+    return out;
+}
+
+
+void Stream_Synthetic_Images_to_Native_Archive(const synthetic_image_series &series,
+                                               const boost::filesystem::path &Filename,
+                                               bool compress){
+    validate(series);
+    const auto shared = shared_metadata(series);
+
+    // Enough images to keep every worker busy, but no more.
+    const auto batch = static_cast<long int>( 2 * std::max<long int>(1, work_stealing_pool::get().concurrency()) );
+    std::vector<planar_image<float,double>> storage(static_cast<size_t>(std::min(batch, series.images)));
+
+    native_archive_writer writer(Filename, compress);
+    if(0 < series.images) writer.begin_image_array();
+    for(long int first = 0; first < series.images; first += batch){
+        const auto n = static_cast<size_t>(std::min(batch, series.images - first));
+
+        std::vector<planar_image<float,double> *> imgs;
+        std::vector<const planar_image<float,double> *> c_imgs;
+        for(size_t i = 0; i < n; ++i){
+            imgs.push_back( &storage[i] );
+            c_imgs.push_back( &storage[i] );
+        }
+        generate(series, shared, first, imgs);
+        writer.add_images(c_imgs);
+    }
+
+    Drover rest;
+    writer.finish(rest);
+    FUNCINFO("Wrote " << series.images << " synthetic images to '" << Filename.string() << "'");
+    return;
+}
+
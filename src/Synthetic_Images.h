@@ -0,0 +1,56 @@
+//Synthetic_Images.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Structs.h"
+
+
+// Describes a series of regularly-spaced synthetic images, e.g., for testing, benchmarking, or load-testing.
+struct synthetic_image_series {
+    long int images = 1;
+    long int rows = 1;
+    long int columns = 1;
+    long int channels = 1;
+
+    double pxl_dx = 1.0;
+    double pxl_dy = 1.0;
+    double pxl_dz = 1.0; // The slice thickness.
+
+    vec3<double> anchor = vec3<double>(0.0, 0.0, 0.0);
+    vec3<double> position = vec3<double>(0.0, 0.0, 0.0); // The centre of the first image's (0,0) voxel.
+    vec3<double> step = vec3<double>(0.0, 0.0, 1.0);     // The displacement of each image from the previous.
+    vec3<double> row_unit = vec3<double>(0.0, 1.0, 0.0);
+    vec3<double> col_unit = vec3<double>(1.0, 0.0, 0.0);
+
+    // Metadata shared by every image. The geometry (Rows, Columns, SliceThickness, PixelSpacing,
+    // ImageOrientationPatient, and ImagePositionPatient) and a SOPInstanceUID are then set for each image.
+    std::map<std::string, std::string> metadata;
+
+    // Generates the SOPInstanceUIDs, in order of image index. If empty, random UIDs are used.
+    std::function<std::string()> generate_uid;
+
+    // Fills the voxels of the image with the given index, and may adjust its metadata. The image has already been
+    // allocated and positioned. Called concurrently for distinct images.
+    std::function<void(long int, planar_image<float,double> &)> fill;
+};
+
+// Generates all images, concurrently, into a single Image_Array.
+std::unique_ptr<Image_Array> Generate_Synthetic_Images(const synthetic_image_series &series);
+
+// Generates the images in batches, writing each batch to a native archive before generating the next, so only a
+// handful of images are resident at once regardless of the size of the series. The archive holds only the series, as
+// a single Image_Array. Throws on failure.
+void Stream_Synthetic_Images_to_Native_Archive(const synthetic_image_series &series,
+                                               const boost::filesystem::path &Filename,
+                                               bool compress = false);
+
@@ -3,15 +3,19 @@
 // This program loads files that are encapsulated in TAR files.
 //
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <exception>
 #include <fstream>
+#include <iterator>
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
 #include <stdexcept>
 #include <string>    
+#include <utility>
 
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
@@ -22,7 +26,9 @@
 #include <cstdlib>            //Needed for exit() calls.
 
 #include "Structs.h"
+#include "Thread_Pool.h"
 #include "File_Loader.h"
+#include "DICOM_File_Loader.h"
 
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -32,6 +38,93 @@
 
 
 
+// Loads the files encapsulated in a TAR archive.
+//
+// DICOM files are decoded straight from memory on the thread pool while the following files are read from the
+// archive, and are then loaded together as if they had been found in a directory. Other files are written to a
+// temporary file and offered to the generic file loader.
+static
+void
+Load_TAR_Members( std::istream &is,
+                  const std::string &Filename,
+                  Drover &DICOM_data,
+                  std::map<std::string,std::string> &InvocationMetadata,
+                  const std::string &FilenameLex,
+                  long int &N_encapsulated_files,
+                  long int &N_successfully_loaded ){
+
+    // Bound the number of files held in memory while waiting to be decoded.
+    dicom_predecode_cache predecoded(4 * std::max<long int>(1, work_stealing_pool::get().concurrency()));
+    std::list<boost::filesystem::path> dicom_members;
+    std::set<std::string> names;
+
+    const auto file_handler = [&]( std::istream &member_is,
+                                   std::string fname,
+                                   long int fsize,
+                                   std::string /*fmode*/,
+                                   std::string /*fuser*/,
+                                   std::string /*fgroup*/,
+                                   long int /*ftime*/,
+                                   std::string /*o_name*/,
+                                   std::string /*g_name*/,
+                                   std::string fprefix) -> void {
+
+        // Indicate that a file was detected.
+        ++N_encapsulated_files;
+
+        std::string contents;
+        contents.reserve(static_cast<size_t>(std::max<long int>(0, fsize)));
+        contents.assign( std::istreambuf_iterator<char>(member_is), std::istreambuf_iterator<char>() );
+
+        // DICOM files have a 'DICM' marker following the 128-byte preamble.
+        if( (132 <= contents.size()) && (contents.compare(128, 4, "DICM") == 0) ){
+            // Name the file after its location in the archive. The name must be unique to be retrieved later.
+            auto name = (boost::filesystem::path(Filename) / fprefix / fname).string();
+            if(!names.insert(name).second){
+                const auto base = name;
+                for(long int n = 2; !names.insert(name = base + "#" + std::to_string(n)).second; ++n){}
+            }
+
+            predecoded.add(name, std::move(contents));
+            dicom_members.emplace_back(name);
+            return;
+        }
+
+        // Write the contents to a temporary file.
+        const std::string fname_tmp = Get_Unique_Sequential_Filename("/tmp/dcma_TAR_loading_temporary_");
+        {
+            std::ofstream ofs_tmp(fname_tmp, std::ios::out | std::ios::binary);
+            ofs_tmp.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            ofs_tmp.flush();
+        }
+
+        // Attempt to load the file.
+        std::list<boost::filesystem::path> path_tmp;
+        path_tmp.emplace_back(fname_tmp);
+        if(Load_Files(DICOM_data, InvocationMetadata, FilenameLex, path_tmp )){
+            // Iff successful, indicate the success.
+            ++N_successfully_loaded;
+        }
+
+        // Remove the temporary file.
+        if(!RemoveFile(fname_tmp)){
+            FUNCERR("Unable to remove temporary file '" << fname_tmp << "'. Refusing to continue");
+        }
+        return;
+    };
+
+    read_ustar(is, file_handler); // Will throw if TAR file cannot be processed.
+
+    if(!dicom_members.empty()){
+        const auto N_dicom = static_cast<long int>(dicom_members.size());
+        if(Load_From_DICOM_Files(DICOM_data, InvocationMetadata, FilenameLex, dicom_members, 1, &predecoded)){
+            N_successfully_loaded += N_dicom - static_cast<long int>(dicom_members.size());
+        }
+    }
+    return;
+}
+
+
 bool Load_From_TAR_Files( Drover &DICOM_data,
                           std::map<std::string,std::string> &InvocationMetadata,
                           const std::string &FilenameLex,
@@ -51,57 +144,20 @@ bool Load_From_TAR_Files( Drover &DICOM_data,
         ++i;
         const auto Filename = bfit->string();
 
-        // Encapsulated file handler.
-        //
-        // This routine merely writes the file to a temporary and invokes the generic file loader routine.
+        // Encapsulated files are loaded into a separate Drover so that nothing is retained from a partially-loaded
+        // or misidentified archive.
         long int N_encapsulated_files = 0;
         long int N_successfully_loaded = 0;
 
-        const auto file_handler = [&]( std::istream &is,
-                                       std::string fname,
-                                       long int fsize,
-                                       std::string fmode,
-                                       std::string fuser,
-                                       std::string fgroup,
-                                       long int ftime,
-                                       std::string o_name,
-                                       std::string g_name,
-                                       std::string fprefix) -> void {
-
-            // Indicate that a file was detected.
-            ++N_encapsulated_files;
-
-            // Write the stream to a temporary file.
-            const std::string fname_tmp = Get_Unique_Sequential_Filename("/tmp/dcma_TAR_loading_temporary_");
-            {
-                std::ofstream ofs_tmp(fname_tmp);
-                ofs_tmp << is.rdbuf();
-                ofs_tmp.flush();
-            }
-
-            // Attempt to load the file.
-            std::list<boost::filesystem::path> path_tmp;
-            path_tmp.emplace_back(fname_tmp);
-            if(Load_Files(DICOM_data, InvocationMetadata, FilenameLex, path_tmp )){
-                // Iff successful, indicate the success.
-                ++N_successfully_loaded;
-            }
-
-            // Remove the temporary file.
-            if(!RemoveFile(fname_tmp)){
-                FUNCERR("Unable to remove temporary file '" << fname_tmp << "'. Refusing to continue");
-            }
-
-            return;
-        };
-
         // un-compressed case.
         try{
             std::ifstream ifs(Filename, std::ios::in | std::ios::binary);
 
+            Drover loaded;
             N_encapsulated_files = 0;
             N_successfully_loaded = 0;
-            read_ustar(ifs, file_handler); // Will throw if TAR file cannot be processed.
+            Load_TAR_Members(ifs, Filename, loaded, InvocationMetadata, FilenameLex,
+                             N_encapsulated_files, N_successfully_loaded);
 
             if( N_encapsulated_files == 0L ){
                 throw std::runtime_error("Unable to load as a TAR file.");
@@ -110,6 +166,7 @@ bool Load_From_TAR_Files( Drover &DICOM_data,
                 throw std::runtime_error("Unable to load all encapsulated files inside TAR file.");
             }
 
+            DICOM_data.Consume(std::move(loaded));
             FUNCINFO("Loaded TAR file containing " << N_encapsulated_files << " encapsulated files");
             bfit = Filenames.erase( bfit ); 
             continue;
@@ -126,9 +183,11 @@ bool Load_From_TAR_Files( Drover &DICOM_data,
             ifsb.push(boost::iostreams::gzip_decompressor());
             ifsb.push(ifs);
 
+            Drover loaded;
             N_encapsulated_files = 0;
             N_successfully_loaded = 0;
-            read_ustar(ifsb, file_handler); // Will throw if TAR file cannot be processed.
+            Load_TAR_Members(ifsb, Filename, loaded, InvocationMetadata, FilenameLex,
+                             N_encapsulated_files, N_successfully_loaded);
 
             if( N_encapsulated_files == 0L ){
                 throw std::runtime_error("Unable to load as a gzipped-TAR file.");
@@ -137,6 +196,7 @@ bool Load_From_TAR_Files( Drover &DICOM_data,
                 throw std::runtime_error("Unable to load all encapsulated files inside gzipped-TAR file.");
             }
 
+            DICOM_data.Consume(std::move(loaded));
             FUNCINFO("Loaded gzipped TAR file containing " << N_encapsulated_files << " encapsulated files");
             bfit = Filenames.erase( bfit ); 
             continue;
@@ -0,0 +1,146 @@
+//Text_Parsing.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "Thread_Pool.h"
+
+#include "Text_Parsing.h"
+
+
+struct mapped_text_file::impl {
+    boost::iostreams::mapped_file_source mf;
+    std::string contents; // Used when the file cannot be mapped (or is empty).
+    const char *b = nullptr;
+    const char *e = nullptr;
+};
+
+mapped_text_file::mapped_text_file(const std::string &filename) : pimpl(std::make_unique<impl>()) {
+    auto &p = *(this->pimpl);
+    bool mapped = false;
+    try{
+        if(0 < boost::filesystem::file_size(filename)){
+            p.mf.open(filename);
+            mapped = p.mf.is_open();
+        }
+    }catch(const std::exception &){ }
+
+    if(mapped){
+        p.b = p.mf.data();
+        p.e = p.b + p.mf.size();
+    }else{
+        std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+        if(!ifs) throw std::runtime_error("Unable to read file '" + filename + "'");
+        p.contents.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        p.b = p.contents.data();
+        p.e = p.b + p.contents.size();
+    }
+}
+
+mapped_text_file::~mapped_text_file() = default;
+
+const char * mapped_text_file::begin() const {
+    return this->pimpl->b;
+}
+
+const char * mapped_text_file::end() const {
+    return this->pimpl->e;
+}
+
+size_t mapped_text_file::size() const {
+    return static_cast<size_t>(this->end() - this->begin());
+}
+
+
+const char * Parse_Number(const char *b, const char *e, double &out){
+    // std::from_chars does not accept a leading '+'.
+    const char *p = b;
+    if( (p != e) && (*p == '+') ){
+        ++p;
+        if( (p != e) && (*p == '-') ) return b;
+    }
+    const auto res = std::from_chars(p, e, out, std::chars_format::general);
+    return (res.ec == std::errc()) ? res.ptr : b;
+}
+
+std::pair<const char *, const char *> Next_Line(const char *&b, const char *e){
+    const char *line_b = b;
+    const char *line_e = std::find(b, e, '\n');
+    b = (line_e == e) ? e : std::next(line_e);
+    if( (line_b != line_e) && (*std::prev(line_e) == '\r') ) --line_e;
+    return { line_b, line_e };
+}
+
+std::vector<std::pair<const char *, const char *>> Split_At_Lines(const char *b, const char *e, size_t chunk_size){
+    std::vector<std::pair<const char *, const char *>> out;
+    chunk_size = std::max<size_t>(1, chunk_size);
+    while(b != e){
+        const char *c = b + std::min<size_t>(chunk_size, static_cast<size_t>(e - b));
+        c = std::find(c, e, '\n');
+        if(c != e) ++c;
+        out.emplace_back(b, c);
+        b = c;
+    }
+    return out;
+}
+
+void Append_Numbers(const char *b, const char *e, std::vector<double> &out){
+    const auto is_space = [](char c) -> bool {
+        return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') || (c == '\v') || (c == '\f');
+    };
+
+    const char *p = b;
+    while(p != e){
+        if(is_space(*p)){
+            ++p;
+            continue;
+        }
+        if(*p == '#'){
+            p = std::find(p, e, '\n');
+            continue;
+        }
+
+        double x;
+        const char *n = Parse_Number(p, e, x);
+        if(n != p) out.push_back(x);
+
+        // Skip the remainder of the token.
+        while( (n != e) && !is_space(*n) && (*n != '#') ) ++n;
+        p = n;
+    }
+    return;
+}
+
+std::vector<double> Parse_Numbers(const char *b, const char *e){
+    const size_t chunk_size = 4 * 1024 * 1024;
+    const auto chunks = Split_At_Lines(b, e, chunk_size);
+
+    std::vector<std::vector<double>> parsed(chunks.size());
+    parallel_for(0, static_cast<long int>(chunks.size()), [&](long int i) -> void {
+        // Estimate the number of values to avoid repeated reallocation. Most numbers are at least a few characters.
+        parsed[i].reserve( static_cast<size_t>(chunks[i].second - chunks[i].first) / 8 );
+        Append_Numbers(chunks[i].first, chunks[i].second, parsed[i]);
+    }, 1);
+
+    if(parsed.size() == 1) return std::move(parsed.front());
+
+    size_t N = 0;
+    for(const auto &v : parsed) N += v.size();
+    std::vector<double> out;
+    out.reserve(N);
+    for(const auto &v : parsed) out.insert(std::end(out), std::begin(v), std::end(v));
+    return out;
+}
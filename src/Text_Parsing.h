@@ -0,0 +1,53 @@
+//Text_Parsing.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Routines for quickly parsing large text files that mostly contain numbers.
+//
+// Numbers are parsed with std::from_chars, so parsing does not depend on the locale and does not allocate. Leading '+'
+// signs and 'nan' and 'inf' (in any case) are accepted, as they are by std::stod.
+
+
+// A read-only view of the contents of a file. Files are memory-mapped when possible.
+class mapped_text_file {
+  public:
+    explicit mapped_text_file(const std::string &filename); // Throws if the file cannot be read.
+    ~mapped_text_file();
+
+    mapped_text_file(const mapped_text_file &) = delete;
+    mapped_text_file & operator=(const mapped_text_file &) = delete;
+
+    const char *begin() const;
+    const char *end() const;
+    size_t size() const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+};
+
+
+// Parses a number from the beginning of [b, e). Returns the position after the number, or b if there is no number.
+const char * Parse_Number(const char *b, const char *e, double &out);
+
+// Returns the line beginning at b (without the line terminator) and advances b to the beginning of the next line.
+std::pair<const char *, const char *> Next_Line(const char *&b, const char *e);
+
+// Splits [b, e) into consecutive chunks of roughly the given size. Chunks only end at line boundaries.
+std::vector<std::pair<const char *, const char *>> Split_At_Lines(const char *b, const char *e, size_t chunk_size);
+
+// Appends the numbers in [b, e) to out. Tokens are delimited by whitespace and anything after a '#' on a line is
+// ignored. Tokens that begin with a number contribute that number (any trailing characters are ignored, like
+// std::stod), and other tokens are skipped.
+void Append_Numbers(const char *b, const char *e, std::vector<double> &out);
+
+// Same as Append_Numbers, but large inputs are split at line boundaries and the pieces are parsed concurrently. The
+// numbers are returned in order.
+std::vector<double> Parse_Numbers(const char *b, const char *e);
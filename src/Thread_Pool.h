@@ -2,49 +2,847 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-#include <asio.hpp>
-#include <boost/thread.hpp> // For class thread_group.
-#include <boost/bind.hpp>
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
 
-//#include <boost/asio/io_service.hpp>
-//#include <boost/thread/thread.hpp>
 
+// Settings for the process-wide scheduler.
+//
+// Since all parallel code paths share the process-wide pool, the thread count here is a global budget for the process.
+struct work_stealing_pool_config {
+    long int num_threads = 0;   // Non-positive: use the number of CPUs available to the process.
+    std::vector<long int> cpus; // CPUs to pin workers to, assigned round-robin. Empty: workers are not pinned.
+};
 
-class asio_thread_pool {
+
+// A process-wide, lazily-started, work-stealing task scheduler.
+//
+// Each worker thread owns a task deque. Tasks submitted from a worker are pushed onto that worker's own deque and the
+// owner executes them most-recent-first, which keeps recently-touched data warm in cache. Idle workers steal the
+// oldest task from other workers. Tasks submitted from threads outside the pool are placed in a shared queue.
+//
+// Threads that wait for tasks to complete (see task_group::wait()) help execute pending tasks rather than blocking, so
+// parallel code can be nested (e.g., a parallel operation invoked from within a parallel operation) without
+// deadlocking and without creating additional threads.
+//
+// The process-wide pool can be configured via configure() before it is first used. Otherwise the environment variables
+// DCMA_THREADS (a thread count) and DCMA_CPU_AFFINITY (a CPU list like '0-7,16,18-19') are consulted.
+//
+// Note: Tasks must not let exceptions escape. Use task_group, which captures and propagates exceptions.
+class work_stealing_pool {
+  public:
+    using task_t = std::function<void()>;
+
+  private:
+    struct task_queue {
+        std::mutex m;
+        std::deque<task_t> tasks;
+    };
+
+    std::vector<std::unique_ptr<task_queue>> local_queues; // One per worker.
+    task_queue shared_queue; // For tasks submitted by non-worker threads.
+    std::vector<std::thread> workers;
+
+    std::mutex sleep_m;
+    std::condition_variable sleep_cv;
+    std::atomic<long int> queued{0};
+    std::atomic<bool> stopping{false};
+
+    // The pool and worker index the current thread belongs to, if any.
+    struct worker_identity {
+        const work_stealing_pool *owner = nullptr;
+        long int index = -1;
+    };
+    static worker_identity & this_thread_identity(){
+        thread_local worker_identity id;
+        return id;
+    }
+
+    // The index of the worker the current thread represents, or -1 if the thread is not part of this pool.
+    long int this_thread_worker_index() const {
+        const auto &id = this_thread_identity();
+        return (id.owner == this) ? id.index : -1;
+    }
+
+    bool pop_from(task_queue &q, bool newest, task_t &t){
+        std::lock_guard<std::mutex> lock(q.m);
+        if(q.tasks.empty()) return false;
+        if(newest){
+            t = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }else{
+            t = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        return true;
+    }
+
+    bool find_task(task_t &t){
+        const auto N = static_cast<long int>(this->local_queues.size());
+        const auto self = this->this_thread_worker_index();
+
+        // Own queue first (newest), then the shared queue, then steal from the other workers (oldest).
+        if( (0 <= self)
+        &&  this->pop_from(*(this->local_queues[self]), true, t) ) return true;
+        if(this->pop_from(this->shared_queue, false, t)) return true;
+        for(long int i = 1; i <= N; ++i){
+            const auto victim = (std::max<long int>(self, 0) + i) % N;
+            if(victim == self) continue;
+            if(this->pop_from(*(this->local_queues[victim]), false, t)) return true;
+        }
+        return false;
+    }
+
+    struct global_state {
+        std::mutex m;
+        work_stealing_pool_config config;
+        bool configured = false;
+        bool started = false;
+    };
+    static global_state & global(){
+        static global_state g;
+        return g;
+    }
+
+    static work_stealing_pool_config claim_global_config(){
+        auto &g = global();
+        std::lock_guard<std::mutex> lock(g.m);
+        g.started = true;
+        if(g.configured) return g.config;
+        try{
+            return config_from_environment();
+        }catch(const std::exception &){ }
+        return work_stealing_pool_config();
+    }
+
+    // Restricts the given thread to a single CPU. Failures are ignored; pinning is only a performance hint.
+    static void pin_thread(std::thread &t, long int cpu){
+#if defined(__linux__)
+        if( (cpu < 0) || (CPU_SETSIZE <= cpu) ) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<int>(cpu), &set);
+        pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+        (void)(t);
+        (void)(cpu);
+#endif
+        return;
+    }
+
+    void worker_loop(long int index){
+        this_thread_identity().owner = this;
+        this_thread_identity().index = index;
+        while(!this->stopping.load()){
+            if(this->try_run_one()) continue;
+
+            std::unique_lock<std::mutex> lock(this->sleep_m);
+            this->sleep_cv.wait(lock, [&]() -> bool {
+                return this->stopping.load() || (0 < this->queued.load());
+            });
+        }
+        return;
+    }
+
+  public:
+
+    explicit work_stealing_pool(long int num_threads = 0, const std::vector<long int> &cpus = {}){
+        auto n = (num_threads <= 0) ? available_cpus() : num_threads;
+        if(n <= 0) n = 2;
+        for(long int i = 0; i < n; ++i){
+            this->local_queues.emplace_back(std::make_unique<task_queue>());
+        }
+        for(long int i = 0; i < n; ++i){
+            this->workers.emplace_back( [this,i]() -> void { this->worker_loop(i); } );
+            if(!cpus.empty()) pin_thread(this->workers.back(), cpus[i % cpus.size()]);
+        }
+    }
+
+    explicit work_stealing_pool(const work_stealing_pool_config &config)
+        : work_stealing_pool(config.num_threads, config.cpus) {}
+
+    ~work_stealing_pool(){
+        {
+            std::lock_guard<std::mutex> lock(this->sleep_m);
+            this->stopping.store(true);
+        }
+        this->sleep_cv.notify_all();
+        for(auto &w : this->workers) w.join();
+    }
+
+    work_stealing_pool(const work_stealing_pool &) = delete;
+    work_stealing_pool & operator=(const work_stealing_pool &) = delete;
+
+    // The process-wide instance. Worker threads are only created on first use.
+    static work_stealing_pool & get(){
+        static work_stealing_pool pool(claim_global_config());
+        return pool;
+    }
+
+    // Sets the configuration of the process-wide instance, overriding the environment. Returns false if the
+    // process-wide instance has already been started, in which case the configuration has no effect.
+    static bool configure(const work_stealing_pool_config &config){
+        auto &g = global();
+        std::lock_guard<std::mutex> lock(g.m);
+        if(g.started) return false;
+        g.config = config;
+        g.configured = true;
+        return true;
+    }
+
+    // Reads the configuration from the environment. Throws if a variable is set but cannot be parsed.
+    static work_stealing_pool_config config_from_environment(){
+        work_stealing_pool_config config;
+        if(const char *threads = std::getenv("DCMA_THREADS"); (threads != nullptr) && (*threads != '\0')){
+            try{
+                config.num_threads = std::stol(threads);
+            }catch(const std::exception &){
+                throw std::invalid_argument(std::string("Unable to parse DCMA_THREADS='") + threads + "'");
+            }
+        }
+        if(const char *cpus = std::getenv("DCMA_CPU_AFFINITY"); (cpus != nullptr) && (*cpus != '\0')){
+            config.cpus = parse_cpu_list(cpus);
+        }
+        return config;
+    }
+
+    // Parses a CPU list like '0-3,8,10-11'. Throws on malformed input.
+    static std::vector<long int> parse_cpu_list(const std::string &spec){
+        std::vector<long int> cpus;
+        std::stringstream ss(spec);
+        std::string item;
+        while(std::getline(ss, item, ',')){
+            if(item.empty()) continue;
+            try{
+                size_t pos = 0;
+                const auto first = std::stol(item, &pos);
+                auto last = first;
+                if(pos < item.size()){
+                    if(item[pos] != '-') throw std::invalid_argument("unexpected character");
+                    const auto rest = item.substr(pos + 1);
+                    last = std::stol(rest, &pos);
+                    if(pos != rest.size()) throw std::invalid_argument("unexpected character");
+                }
+                if( (first < 0) || (last < first) ) throw std::invalid_argument("invalid range");
+                for(auto c = first; c <= last; ++c) cpus.push_back(c);
+            }catch(const std::exception &){
+                throw std::invalid_argument("Unable to parse CPU list item '" + item + "'");
+            }
+        }
+        return cpus;
+    }
+
+    // The number of CPUs this process is permitted to run on, which respects external restrictions like taskset.
+    static long int available_cpus(){
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if(sched_getaffinity(0, sizeof(set), &set) == 0){
+            const auto n = static_cast<long int>(CPU_COUNT(&set));
+            if(0 < n) return n;
+        }
+#endif
+        return static_cast<long int>(std::thread::hardware_concurrency());
+    }
+
+    long int concurrency() const {
+        return static_cast<long int>(this->workers.size());
+    }
+
+    // Work submission routine.
+    void submit(task_t t){
+        const auto self = this->this_thread_worker_index();
+        auto &q = (0 <= self) ? *(this->local_queues[self]) : this->shared_queue;
+        {
+            std::lock_guard<std::mutex> lock(q.m);
+            q.tasks.emplace_back(std::move(t));
+        }
+        ++(this->queued);
+
+        // Acquire the lock so a worker cannot miss the notification between checking for work and sleeping.
+        { std::lock_guard<std::mutex> lock(this->sleep_m); }
+        this->sleep_cv.notify_one();
+        return;
+    }
+
+    // Executes a single pending task on the calling thread, if any are available. Returns false if no task was found.
+    bool try_run_one(){
+        task_t t;
+        if(!this->find_task(t)) return false;
+        --(this->queued);
+        try{
+            t();
+        }catch(const std::exception &){ }
+        return true;
+    }
+};
+
+
+// Thrown when work notices that it has been cancelled or has exceeded its deadline.
+class operation_cancelled : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+
+// A cooperative cancellation token.
+//
+// Copies share state. A token is cancelled when cancel() is called on it (or a copy), when its deadline passes, or when
+// the token it was derived from is cancelled. Cancellation is cooperative: long-running work should periodically call
+// throw_if_cancelled(), which consults the token associated with the calling thread.
+//
+// A token is associated with a thread using a cancellation_token::scope. Tasks submitted via task_group inherit the
+// submitting thread's token, and tasks that have not yet started when the token is cancelled are skipped, so parallel
+// loops stop promptly without explicit checks.
+class cancellation_token {
+  public:
+    using clock_t = std::chrono::steady_clock;
+
+  private:
+    struct state_t {
+        std::atomic<bool> cancelled{false};
+        clock_t::time_point deadline = clock_t::time_point::max();
+        std::shared_ptr<const state_t> parent;
+    };
+
+    std::shared_ptr<state_t> state; // nullptr for threads not associated with any token.
+
+    explicit cancellation_token(std::shared_ptr<state_t> s) : state(std::move(s)) {}
+
+    static std::shared_ptr<state_t> & current_state(){
+        static thread_local std::shared_ptr<state_t> s;
+        return s;
+    }
+
+  public:
+    cancellation_token() : state(std::make_shared<state_t>()) {}
+
+    // The token associated with the calling thread. The result is never cancelled if there is no such token.
+    static cancellation_token current(){
+        return cancellation_token(current_state());
+    }
+
+    // Creates a token that is cancelled when this one is, and also when the given deadline passes.
+    cancellation_token derive(clock_t::time_point deadline = clock_t::time_point::max()) const {
+        auto s = std::make_shared<state_t>();
+        s->deadline = deadline;
+        s->parent = this->state;
+        return cancellation_token(std::move(s));
+    }
+
+    void cancel() const {
+        if(this->state) this->state->cancelled.store(true);
+        return;
+    }
+
+    bool is_cancelled() const {
+        return !reason_for(this->state.get()).empty();
+    }
+
+    void throw_if_cancelled() const {
+        check(this->state.get());
+        return;
+    }
+
+    // Checks the token associated with the calling thread without copying it, so it is cheap enough for hot loops.
+    static bool current_is_cancelled(){
+        return !reason_for(current_state().get()).empty();
+    }
+
+    static void throw_if_current_cancelled(){
+        check(current_state().get());
+        return;
+    }
+
+  private:
+    // A description of why the token is cancelled, or an empty string if it is not.
+    static std::string reason_for(const state_t *state){
+        bool has_deadline = false;
+        for(const state_t *s = state; s != nullptr; s = s->parent.get()){
+            if(s->cancelled.load(std::memory_order_relaxed)) return "Cancelled";
+            has_deadline = has_deadline || (s->deadline != clock_t::time_point::max());
+        }
+        if(has_deadline){
+            const auto now = clock_t::now();
+            for(const state_t *s = state; s != nullptr; s = s->parent.get()){
+                if(s->deadline <= now) return "Deadline exceeded";
+            }
+        }
+        return "";
+    }
+
+    static void check(const state_t *state){
+        const auto r = reason_for(state);
+        if(!r.empty()) throw operation_cancelled(r);
+        return;
+    }
+
+  public:
+    // Associates a token with the calling thread for the lifetime of the scope.
+    class scope {
+      private:
+        std::shared_ptr<state_t> previous;
+
+      public:
+        explicit scope(const cancellation_token &t) : previous(std::move(current_state())) {
+            current_state() = t.state;
+        }
+        ~scope(){
+            current_state() = std::move(this->previous);
+        }
+
+        scope(const scope &) = delete;
+        scope & operator=(const scope &) = delete;
+    };
+};
+
+// Checks the token associated with the calling thread.
+inline bool is_cancelled(){
+    return cancellation_token::current_is_cancelled();
+}
+
+inline void throw_if_cancelled(){
+    cancellation_token::throw_if_current_cancelled();
+    return;
+}
+
+
+// A snapshot of the progress of a progress_tracker (see below).
+struct progress_report {
+    std::string label; // May be empty.
+    long int completed = 0;
+    long int total = 0;
+    double elapsed_s = 0.0;
+    double eta_s = 0.0;
+};
+
+// Routes progress reports to an observer associated with the calling thread, e.g., to forward them to a remote client.
+//
+// Like cancellation tokens, observers are associated with a thread using a scope and are inherited by tasks submitted
+// via task_group. Observers receive the rate-limited reports of all progress_trackers created within the scope. They
+// may be invoked concurrently from arbitrary worker threads, so they must be thread-safe.
+class progress_sink {
+  public:
+    using observer_t = std::function<void(const progress_report &)>;
+
+  private:
+    static std::shared_ptr<const observer_t> & current_observer(){
+        static thread_local std::shared_ptr<const observer_t> o;
+        return o;
+    }
+
+  public:
+    // The observer associated with the calling thread, or nullptr if there is none.
+    static std::shared_ptr<const observer_t> current(){
+        return current_observer();
+    }
+
+    class scope {
+      private:
+        std::shared_ptr<const observer_t> previous;
+
+      public:
+        explicit scope(std::shared_ptr<const observer_t> o) : previous(std::move(current_observer())) {
+            current_observer() = std::move(o);
+        }
+        explicit scope(observer_t o) : scope(std::make_shared<const observer_t>(std::move(o))) {}
+        ~scope(){
+            current_observer() = std::move(this->previous);
+        }
+
+        scope(const scope &) = delete;
+        scope & operator=(const scope &) = delete;
+    };
+};
+
+
+// A collection of related tasks that can be waited on as a unit.
+//
+// Exceptions thrown by tasks are captured and the first is re-thrown by wait(). The destructor waits for all tasks to
+// complete, but will not propagate exceptions, so wait() should be called explicitly whenever tasks might throw.
+//
+// An optional limit on the number of tasks in flight can be provided. If the limit is reached, run() will help
+// execute pending tasks until the number of tasks in flight drops below the limit.
+class task_group {
   private:
+    work_stealing_pool &pool;
+    std::atomic<long int> pending{0};
+    long int max_in_flight;
 
-    asio::io_service _io_service;
-    boost::thread_group _thread_pool;
-    using work_t = std::unique_ptr<asio::io_service::work>;
-    work_t _work;
+    std::mutex exception_m;
+    std::exception_ptr first_exception;
+
+    void help_while(const std::function<bool()> &cond){
+        long int idle_spins = 0;
+        while(cond()){
+            if(this->pool.try_run_one()){
+                idle_spins = 0;
+            }else if(++idle_spins < 64){
+                std::this_thread::yield();
+            }else{
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        return;
+    }
 
   public:
 
-    //Constructor and destructor.
-    asio_thread_pool(const size_t num_threads = 0) : _io_service(), 
-                                                     _work(new work_t::element_type(_io_service)) {
-        auto n = (num_threads == 0) ? std::thread::hardware_concurrency()
-                                    : num_threads;
-        if(n == 0) n = 2;
-        for(size_t i = 0 ; i < n; ++i){
-            this->_thread_pool.create_thread(
-                boost::bind(&asio::io_service::run, &this->_io_service)
-            );
+    explicit task_group(long int max_concurrency = 0,
+                        work_stealing_pool &p = work_stealing_pool::get()) : pool(p),
+                                                                            max_in_flight(max_concurrency) {}
+
+    ~task_group(){
+        this->help_while([&]() -> bool { return (0 < this->pending.load()); });
+    }
+
+    task_group(const task_group &) = delete;
+    task_group & operator=(const task_group &) = delete;
+
+    template <class F>
+    void run(F &&f){
+        if(0 < this->max_in_flight){
+            this->help_while([&]() -> bool { return (this->max_in_flight <= this->pending.load()); });
         }
+
+        ++(this->pending);
+        this->pool.submit( [this,
+                             token = cancellation_token::current(),
+                             sink = progress_sink::current(),
+                             f = std::forward<F>(f)]() mutable -> void {
+            try{
+                const cancellation_token::scope scope(token);
+                const progress_sink::scope sink_scope(std::move(sink));
+                token.throw_if_cancelled();
+                f();
+            }catch(...){
+                std::lock_guard<std::mutex> lock(this->exception_m);
+                if(!this->first_exception) this->first_exception = std::current_exception();
+            }
+            // Note: 'this' must not be accessed after this point; the group may be destroyed.
+            --(this->pending);
+        });
+        return;
     }
-    ~asio_thread_pool(){
-        this->_work.reset();
-        this->_thread_pool.join_all();
-        this->_io_service.stop();
+
+    // Blocks until all tasks have completed, executing pending tasks in the meantime.
+    void wait(){
+        this->help_while([&]() -> bool { return (0 < this->pending.load()); });
+
+        std::exception_ptr e;
+        {
+            std::lock_guard<std::mutex> lock(this->exception_m);
+            std::swap(e, this->first_exception);
+        }
+        if(e) std::rethrow_exception(e);
+        return;
     }
+};
+
 
-    //Work submission routine.
-    template<class T>
-    void submit_task(T atask){
-        this->_io_service.post(atask);
+// Invokes f(i) for each i in [begin, end), distributing contiguous blocks of indices over the process-wide pool.
+//
+// If the grain size (i.e., the number of indices per task) is not provided, one is selected to create a few tasks per
+// worker. Returns after all invocations have completed, re-throwing the first exception encountered, if any.
+template <class F>
+void parallel_for(long int begin, long int end, F f, long int grain = 0){
+    if(end <= begin) return;
+    const long int N = end - begin;
+    if(grain <= 0){
+        const long int n_tasks = 4 * work_stealing_pool::get().concurrency();
+        grain = std::max<long int>(1, N / std::max<long int>(1, n_tasks));
     }
-}; 
 
+    task_group tg;
+    for(long int b = begin; b < end; b += grain){
+        const long int e = std::min<long int>(end, b + grain);
+        tg.run([&f,b,e]() -> void {
+            for(long int i = b; i < e; ++i) f(i);
+        });
+    }
+    tg.wait();
+    return;
+}
+
+
+// The number of blocks parallel_reduce() divides a range into when no block size is provided.
+constexpr long int default_reduction_blocks = 64;
+
+// Reduces [begin, end) in parallel such that the result does not depend on the number of threads or on scheduling.
+//
+// Floating-point arithmetic is not associative, so reductions that combine partial results in the order tasks complete,
+// or over a partitioning derived from the number of threads, can differ from run to run. Here the range is divided into
+// blocks chosen from the range alone, reduce_block(b, e) reduces the indices [b, e) of each block, and block results
+// are combined pairwise in a fixed tree order via combine(lhs, rhs), which folds the later block rhs into lhs. Pairwise
+// combination also limits the accumulation of round-off error compared with folding the blocks one at a time.
+//
+// If the block size is not provided, the range is divided into at most default_reduction_blocks blocks. Returns the
+// identity if the range is empty.
+template <class T, class F, class C>
+T parallel_reduce(long int begin, long int end, T identity, F reduce_block, C combine, long int block = 0){
+    if(end <= begin) return identity;
+    const long int N = end - begin;
+    if(block <= 0) block = (N + default_reduction_blocks - 1) / default_reduction_blocks;
+    const long int N_blocks = (N + block - 1) / block;
+
+    std::vector<T> partials(N_blocks, identity);
+    parallel_for(0, N_blocks, [&](long int b) -> void {
+        const long int b_begin = begin + b * block;
+        partials[b] = reduce_block(b_begin, std::min<long int>(end, b_begin + block));
+    }, /*grain=*/ 1);
 
+    // Each level combines disjoint pairs of adjacent results, so the pairs of a level are combined concurrently.
+    for(long int stride = 1; stride < N_blocks; stride *= 2){
+        const long int N_pairs = (N_blocks + 2 * stride - 1) / (2 * stride);
+        parallel_for(0, N_pairs, [&](long int p) -> void {
+            const long int lhs = p * 2 * stride;
+            const long int rhs = lhs + stride;
+            if(rhs < N_blocks) combine(partials[lhs], std::move(partials[rhs]));
+        }, /*grain=*/ 1);
+    }
+    return std::move(partials.front());
+}
+
+
+// Placement of large buffers on NUMA systems.
+//
+// Pages are normally placed on the NUMA node of the thread that first writes them, so a buffer that is zero-filled or
+// copied by a single thread lands entirely on one node, and threads on other sockets then access it at remote-memory
+// speed. Large buffers should instead be initialized with a parallel_for() over the same partitioning later used to
+// process them (see numa_allocator), or be interleaved over all nodes. Placement is only a performance hint and has no
+// effect on systems with a single node.
+enum class numa_placement {
+    first_touch, // Pages are placed on the node of the thread that first writes them.
+    interleave,  // Pages of large buffers are spread round-robin over all nodes, for uniform average bandwidth.
+};
+
+namespace numa_detail {
+
+struct placement_state {
+    std::mutex m;
+    numa_placement placement = numa_placement::first_touch;
+    bool configured = false;
+};
+inline placement_state & state(){
+    static placement_state s;
+    return s;
+}
+
+// Buffers at least this large are page-aligned so their pages can be placed independently of other allocations.
+constexpr std::size_t large_buffer_bytes = 2 * 1024 * 1024;
+constexpr std::size_t page_bytes = 4096;
+
+// Applies the interleave policy to the (page-aligned) memory, which must not yet have been written.
+inline void interleave_pages(void *p, std::size_t bytes){
+#if defined(__linux__) && defined(SYS_mbind)
+    // The online nodes use the same list format as CPUs, e.g., '0-1'.
+    static const std::vector<unsigned long> node_mask = []() -> std::vector<unsigned long> {
+        std::ifstream ifs("/sys/devices/system/node/online");
+        std::string spec;
+        if(!std::getline(ifs, spec)) return {};
+        std::vector<unsigned long> mask;
+        long int N_nodes = 0;
+        try{
+            for(const auto node : work_stealing_pool::parse_cpu_list(spec)){
+                const auto word = static_cast<std::size_t>(node) / (8 * sizeof(unsigned long));
+                if(mask.size() <= word) mask.resize(word + 1, 0UL);
+                mask[word] |= 1UL << (static_cast<std::size_t>(node) % (8 * sizeof(unsigned long)));
+                ++N_nodes;
+            }
+        }catch(const std::exception &){
+            return {};
+        }
+        if(N_nodes < 2) return {};
+        return mask;
+    }();
+    if(node_mask.empty()) return;
+
+    constexpr int mpol_interleave = 3;
+    const auto max_node = node_mask.size() * 8 * sizeof(unsigned long) + 1;
+    (void) ::syscall(SYS_mbind, p, bytes, mpol_interleave, node_mask.data(), max_node, 0);
+#else
+    (void)(p);
+    (void)(bytes);
+#endif
+    return;
+}
+
+} // namespace numa_detail
+
+// Sets the placement of subsequently allocated large buffers, overriding the DCMA_NUMA_PLACEMENT environment variable
+// (either 'first-touch' or 'interleave').
+inline void Set_NUMA_Placement(numa_placement placement){
+    auto &s = numa_detail::state();
+    std::lock_guard<std::mutex> lock(s.m);
+    s.placement = placement;
+    s.configured = true;
+    return;
+}
+
+inline numa_placement Get_NUMA_Placement(){
+    auto &s = numa_detail::state();
+    std::lock_guard<std::mutex> lock(s.m);
+    if(!s.configured){
+        s.configured = true;
+        if(const char *p = std::getenv("DCMA_NUMA_PLACEMENT"); (p != nullptr) && (std::string(p) == "interleave")){
+            s.placement = numa_placement::interleave;
+        }
+    }
+    return s.placement;
+}
+
+// An allocator for large numeric buffers. Allocations are over-aligned so data can be loaded with wide vector
+// instructions, and large allocations are page-aligned and placed according to Get_NUMA_Placement().
+//
+// Elements are default-initialized, so resizing a buffer of arithmetic values leaves them indeterminate rather than
+// zero-filling them on the calling thread. Callers should initialize such buffers with a parallel_for() over the
+// partitioning later used to process them, so that each page is first touched by a thread likely to access it again.
+template <class T, std::size_t Alignment = 64>
+struct numa_allocator {
+    using value_type = T;
+
+    template <class U> struct rebind { using other = numa_allocator<U, Alignment>; };
+
+    numa_allocator() noexcept = default;
+    template <class U> numa_allocator(const numa_allocator<U, Alignment> &) noexcept {}
+
+    T * allocate(std::size_t n){
+        const auto bytes = n * sizeof(T);
+        if(bytes < numa_detail::large_buffer_bytes){
+            return static_cast<T *>(::operator new(bytes, std::align_val_t(Alignment)));
+        }
+        constexpr auto align = std::max(Alignment, numa_detail::page_bytes);
+        void *p = ::operator new(bytes, std::align_val_t(align));
+        if(Get_NUMA_Placement() == numa_placement::interleave) numa_detail::interleave_pages(p, bytes);
+        return static_cast<T *>(p);
+    }
+    void deallocate(T *p, std::size_t n) noexcept {
+        constexpr auto align = std::max(Alignment, numa_detail::page_bytes);
+        if(n * sizeof(T) < numa_detail::large_buffer_bytes){
+            ::operator delete(p, std::align_val_t(Alignment));
+        }else{
+            ::operator delete(p, std::align_val_t(align));
+        }
+    }
+
+    template <class U> void construct(U *p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new(static_cast<void *>(p)) U;
+    }
+    template <class U, class... Args> void construct(U *p, Args &&... args){
+        ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <class U> bool operator==(const numa_allocator<U, Alignment> &) const noexcept { return true; }
+    template <class U> bool operator!=(const numa_allocator<U, Alignment> &) const noexcept { return false; }
+};
+
+// Tracks the completion of a known number of work items from many threads and periodically reports progress.
+//
+// Workers call advance() as they complete items. At most one report is issued per interval (plus a final report when
+// all items are complete). The thread which observes that a report is due claims it with an atomic compare-and-swap,
+// so workers never wait on each other to report. The callback receives the number of items completed, the total, and
+// an estimate of the remaining time (in seconds) based on the average rate so far. It may be invoked from any worker
+// thread, so it should only perform thread-safe actions like logging.
+//
+// Reports are also forwarded, along with the label, to the progress_sink observer associated with the thread that
+// created the tracker, if any.
+class progress_tracker {
+  public:
+    using clock_t = std::chrono::steady_clock;
+    using callback_t = std::function<void(long int completed, long int total, double eta_s)>;
+
+  private:
+    std::string label;
+    long int total;
+    callback_t callback;
+    std::shared_ptr<const progress_sink::observer_t> observer;
+    clock_t::time_point start;
+    std::chrono::nanoseconds interval;
+
+    std::atomic<long int> completed{0};
+    std::atomic<long long int> next_report_ns; // Relative to start.
+
+    long long int elapsed_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - this->start).count();
+    }
+
+  public:
+    progress_tracker(std::string label_in,
+                     long int total_items,
+                     callback_t cb,
+                     std::chrono::milliseconds report_interval = std::chrono::milliseconds(2000))
+        : label(std::move(label_in)),
+          total(total_items),
+          callback(std::move(cb)),
+          observer(progress_sink::current()),
+          start(clock_t::now()),
+          interval(report_interval),
+          next_report_ns(static_cast<long long int>(interval.count())) {}
+
+    progress_tracker(long int total_items,
+                     callback_t cb,
+                     std::chrono::milliseconds report_interval = std::chrono::milliseconds(2000))
+        : progress_tracker(std::string(), total_items, std::move(cb), report_interval) {}
+
+    progress_tracker(const progress_tracker &) = delete;
+    progress_tracker & operator=(const progress_tracker &) = delete;
+
+    void advance(long int n = 1){
+        const auto done = (this->completed += n);
+        if(!this->callback && !this->observer) return;
+
+        const auto now = this->elapsed_ns();
+        const bool finished = (this->total <= done) && (done - n < this->total); // Only the final advance.
+        auto next = this->next_report_ns.load(std::memory_order_relaxed);
+        if(!finished){
+            if(now < next) return;
+            if(!this->next_report_ns.compare_exchange_strong(next, now + this->interval.count(),
+                                                             std::memory_order_relaxed)) return;
+        }
+
+        const double elapsed_s = static_cast<double>(now) * 1.0E-9;
+        const double eta_s = (0 < done) ? elapsed_s * static_cast<double>(std::max<long int>(0, this->total - done))
+                                                    / static_cast<double>(done)
+                                        : 0.0;
+        if(this->callback) this->callback(done, this->total, eta_s);
+        if(this->observer){
+            progress_report r;
+            r.label = this->label;
+            r.completed = done;
+            r.total = this->total;
+            r.elapsed_s = elapsed_s;
+            r.eta_s = eta_s;
+            (*this->observer)(r);
+        }
+        return;
+    }
+
+    long int get_completed() const {
+        return this->completed.load();
+    }
+};
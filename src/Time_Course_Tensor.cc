@@ -0,0 +1,331 @@
+//Time_Course_Tensor.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+#include "Thread_Pool.h"
+#include "Time_Course_Tensor.h"
+
+
+namespace {
+
+// Voxels are transposed in blocks so each block of the output is written by a single task.
+constexpr long int voxel_block_size = 4096;
+
+// The number of collections retained by Get_Temporal_Index().
+constexpr size_t temporal_index_cache_size = 8;
+
+} // namespace
+
+
+Temporal_Index::Temporal_Index(const planar_image_collection<float,double> &imagecoll,
+                               const std::string &time_key)
+  : Temporal_Index( [&](){
+                        std::vector<const image_t *> imgs;
+                        imgs.reserve(imagecoll.images.size());
+                        for(const auto &img : imagecoll.images) imgs.push_back(&img);
+                        return imgs;
+                    }(), time_key ) {}
+
+Temporal_Index::Temporal_Index(std::vector<const image_t *> imgs,
+                               const std::string &time_key)
+  : time_key(time_key), collection(std::move(imgs)) {
+
+    const auto N = this->collection.size();
+    this->raw.resize(N);
+    this->time_of.resize(N, std::numeric_limits<double>::quiet_NaN());
+    for(size_t i = 0; i < N; ++i){
+        const auto &img = *(this->collection[i]);
+        this->position_of.emplace(&img, i);
+        const auto it = img.metadata.find(this->time_key);
+        if(it == std::end(img.metadata)) continue;
+        this->raw[i] = it->second;
+
+        const auto t = img.GetMetadataValueAs<double>(this->time_key);
+        if(t && std::isfinite(t.value())) this->time_of[i] = t.value();
+    }
+
+    for(size_t i = 0; i < N; ++i){
+        if(std::isfinite(this->time_of[i])){
+            this->order.push_back(i);
+        }else{
+            this->untimed.push_back(this->collection[i]);
+        }
+    }
+    std::stable_sort(std::begin(this->order), std::end(this->order), [&](size_t L, size_t R) -> bool {
+        return this->time_of[L] < this->time_of[R];
+    });
+    for(const auto &i : this->order){
+        this->images.push_back(this->collection[i]);
+        this->times.push_back(this->time_of[i]);
+    }
+}
+
+const std::string & Temporal_Index::get_time_key() const {
+    return this->time_key;
+}
+
+const std::vector<const Temporal_Index::image_t *> & Temporal_Index::get_images() const {
+    return this->images;
+}
+
+const std::vector<double> & Temporal_Index::get_times() const {
+    return this->times;
+}
+
+const std::vector<const Temporal_Index::image_t *> & Temporal_Index::get_untimed_images() const {
+    return this->untimed;
+}
+
+double Temporal_Index::get_time(const image_t *img) const {
+    const auto it = this->position_of.find(img);
+    if(it == std::end(this->position_of)) return std::numeric_limits<double>::quiet_NaN();
+    return this->time_of[it->second];
+}
+
+std::vector<size_t> Temporal_Index::find_coincident(double t, double rel_tol) const {
+    std::vector<size_t> out;
+    if(!std::isfinite(t)) return out;
+    const auto matches = [&](size_t i) -> bool {
+        return (RELATIVE_DIFF(t, this->time_of[i]) < rel_tol);
+    };
+
+    if( !(0.0 < rel_tol) || !(rel_tol < 1.0) ){
+        for(const auto &i : this->order) if(matches(i)) out.push_back(i);
+
+    }else{
+        // A time t2 can only match if |t - t2| < rel_tol * max(|t|, |t2|), which bounds |t - t2| by
+        // rel_tol * |t| / (1 - rel_tol). The bound is slightly widened so rounding cannot exclude a match; the exact
+        // criteria are then applied to the candidates.
+        const auto w = (std::abs(t) * rel_tol / (1.0 - rel_tol)) * (1.0 + 1E-9);
+        const auto begin = std::lower_bound(std::begin(this->times), std::end(this->times), t - w);
+        const auto end = std::upper_bound(begin, std::end(this->times), t + w);
+        const auto offset = std::distance(std::begin(this->times), begin);
+        for(auto it = begin; it != end; ++it){
+            const auto i = this->order[offset + std::distance(begin, it)];
+            if(matches(i)) out.push_back(i);
+        }
+    }
+    std::sort(std::begin(out), std::end(out));
+    return out;
+}
+
+bool Temporal_Index::is_current(const planar_image_collection<float,double> &imagecoll) const {
+    if(imagecoll.images.size() != this->collection.size()) return false;
+    size_t i = 0;
+    for(const auto &img : imagecoll.images){
+        if(&img != this->collection[i]) return false;
+        const auto it = img.metadata.find(this->time_key);
+        const bool has = (it != std::end(img.metadata));
+        if( (has != this->raw[i].has_value())
+        ||  (has && (it->second != this->raw[i].value())) ) return false;
+        ++i;
+    }
+    return true;
+}
+
+std::shared_ptr<const Temporal_Index> Get_Temporal_Index(const planar_image_collection<float,double> &imagecoll,
+                                                         const std::string &time_key){
+    static std::mutex m;
+    static std::list<std::pair<const planar_image_collection<float,double> *,
+                               std::shared_ptr<const Temporal_Index>>> cache; // Most recently used first.
+
+    std::lock_guard<std::mutex> lock(m);
+    for(auto it = std::begin(cache); it != std::end(cache); ++it){
+        if( (it->first != &imagecoll) || (it->second->get_time_key() != time_key) ) continue;
+        if(!it->second->is_current(imagecoll)){
+            cache.erase(it);
+            break;
+        }
+        cache.splice(std::begin(cache), cache, it);
+        return cache.front().second;
+    }
+
+    cache.emplace_front(&imagecoll, std::make_shared<const Temporal_Index>(imagecoll, time_key));
+    if(temporal_index_cache_size < cache.size()) cache.pop_back();
+    return cache.front().second;
+}
+
+
+const std::vector<const Time_Course_Tensor::image_t *> &
+Time_Course_Tensor::group_t::get_images() const {
+    return this->images;
+}
+
+const std::vector<double> &
+Time_Course_Tensor::group_t::get_times() const {
+    return this->times;
+}
+
+bool Time_Course_Tensor::group_t::has_times() const {
+    return std::all_of(std::begin(this->times), std::end(this->times),
+                       [](double t){ return std::isfinite(t); });
+}
+
+size_t Time_Course_Tensor::group_t::size() const {
+    return this->images.size();
+}
+
+void Time_Course_Tensor::group_t::build() const {
+    if(this->images.empty()) return;
+    const auto &first = *(this->images.front());
+    for(const auto &img : this->images){
+        if( (img->rows     != first.rows)
+        ||  (img->columns  != first.columns)
+        ||  (img->channels != first.channels) ){
+            throw std::domain_error("Images have differing number of rows, columns, or channels."
+                                    " This is not currently supported -- though it could be if needed."
+                                    " Are you sure you've got the correct data?");
+        }
+    }
+
+    const auto N_t = static_cast<long int>(this->images.size());
+    const auto N_voxels = static_cast<long int>(first.data.size());
+    this->data.resize(static_cast<size_t>(N_voxels * N_t));
+
+    const auto N_blocks = (N_voxels + voxel_block_size - 1) / voxel_block_size;
+    parallel_for(0, N_blocks, [&](long int b) -> void {
+        const auto begin = b * voxel_block_size;
+        const auto end = std::min(N_voxels, begin + voxel_block_size);
+        for(long int t = 0; t < N_t; ++t){
+            const float *src = this->images[t]->data.data();
+            for(auto v = begin; v < end; ++v) this->data[v * N_t + t] = src[v];
+        }
+    }, /*grain=*/ 1);
+}
+
+const float * Time_Course_Tensor::group_t::get_series(long int row, long int col, long int chan) const {
+    if(this->images.empty()) throw std::out_of_range("Group has no images");
+    return this->get_series( this->images.front()->index(row, col, chan) );
+}
+
+const float * Time_Course_Tensor::group_t::get_series(long int index) const {
+    std::call_once(this->built, [this]() -> void { this->build(); });
+    if( this->images.empty() || (index < 0) || (static_cast<size_t>(index) >= this->images.front()->data.size()) ){
+        throw std::out_of_range("Requested voxel is outside the image");
+    }
+    return this->data.data() + static_cast<size_t>(index) * this->images.size();
+}
+
+
+Time_Course_Tensor::Time_Course_Tensor(const planar_image_collection<float,double> &imagecoll,
+                                       const std::string &time_key,
+                                       std::shared_ptr<const Temporal_Index> index)
+  : time_key(time_key), index(std::move(index)) {
+
+    for(const auto &img : imagecoll.images) this->collection.push_back(&img);
+    if( (this->index == nullptr)
+    ||  (this->index->get_time_key() != this->time_key)
+    ||  !this->index->is_current(imagecoll) ){
+        this->index = std::make_shared<const Temporal_Index>(this->collection, this->time_key);
+    }
+
+    // Seeds are taken in collection order, and each group gathers all as-of-yet-ungrouped images which encompass
+    // points near the centre of the seed image.
+    std::vector<bool> grouped(this->collection.size(), false);
+    for(size_t i = 0; i < this->collection.size(); ++i){
+        if(grouped[i]) continue;
+        const auto &seed = *(this->collection[i]);
+        const auto img_cntr = seed.center();
+        const auto ortho = seed.row_unit.Cross( seed.col_unit ).unit();
+        const std::vector<vec3<double>> points = { img_cntr, img_cntr + ortho * seed.pxl_dz * 0.25,
+                                                             img_cntr - ortho * seed.pxl_dz * 0.25 };
+
+        std::vector<const image_t *> imgs;
+        for(size_t j = i; j < this->collection.size(); ++j){
+            if(grouped[j]) continue;
+            const auto &img = *(this->collection[j]);
+            const bool encompasses = std::all_of(std::begin(points), std::end(points),
+                                                 [&](const vec3<double> &p){ return img.encompasses_point(p); });
+            if(!encompasses) continue;
+            grouped[j] = true;
+            imgs.push_back(&img);
+        }
+
+        // The seed may not encompass its own points if it is degenerate, but it should always form a group.
+        if(!grouped[i]){
+            grouped[i] = true;
+            imgs.insert(std::begin(imgs), &seed);
+        }
+        this->add_group(std::move(imgs));
+    }
+}
+
+Time_Course_Tensor::Time_Course_Tensor(const std::list<const image_t *> &imgs,
+                                       const std::string &time_key)
+  : time_key(time_key) {
+    this->collection.assign(std::begin(imgs), std::end(imgs));
+    this->index = std::make_shared<const Temporal_Index>(this->collection, this->time_key);
+    this->add_group(this->collection);
+}
+
+void Time_Course_Tensor::add_group(std::vector<const image_t *> imgs){
+    std::vector<double> times;
+    times.reserve(imgs.size());
+    for(const auto &img : imgs) times.push_back( this->index->get_time(img) );
+
+    std::vector<size_t> order(imgs.size());
+    std::iota(std::begin(order), std::end(order), 0);
+    std::stable_sort(std::begin(order), std::end(order), [&](size_t L, size_t R) -> bool {
+        if(!std::isfinite(times[L])) return false;
+        if(!std::isfinite(times[R])) return true;
+        return times[L] < times[R];
+    });
+
+    auto g = std::make_unique<group_t>();
+    for(const auto &i : order){
+        g->images.push_back(imgs[i]);
+        g->times.push_back(times[i]);
+        this->group_of[imgs[i]] = this->groups.size();
+    }
+    this->groups.push_back(std::move(g));
+}
+
+const std::string & Time_Course_Tensor::get_time_key() const {
+    return this->time_key;
+}
+
+const Temporal_Index & Time_Course_Tensor::get_temporal_index() const {
+    return *(this->index);
+}
+
+size_t Time_Course_Tensor::size() const {
+    return this->groups.size();
+}
+
+const Time_Course_Tensor::group_t & Time_Course_Tensor::get_group(size_t i) const {
+    return *(this->groups.at(i));
+}
+
+const Time_Course_Tensor::group_t * Time_Course_Tensor::find_group(const image_t *img) const {
+    const auto it = this->group_of.find(img);
+    if(it == std::end(this->group_of)) return nullptr;
+    return this->groups[it->second].get();
+}
+
+bool Time_Course_Tensor::is_current(const planar_image_collection<float,double> &imagecoll) const {
+    if(imagecoll.images.size() != this->collection.size()) return false;
+    auto c_it = std::begin(this->collection);
+    for(const auto &img : imagecoll.images){
+        if(&img != *c_it) return false;
+        ++c_it;
+    }
+    return true;
+}
+
@@ -0,0 +1,156 @@
+//Time_Course_Tensor.h.
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "YgorImages.h"
+
+
+// A collection-wide index of image times, for locating images by time without re-parsing their metadata.
+//
+// Each image's time metadata is parsed once, and the images are sorted by time so temporally-coincident images can be
+// found with a binary search. The index holds pointers into the collection, so it is invalidated whenever images are
+// added, removed, or their time metadata is altered; is_current() detects all of these.
+class Temporal_Index {
+  public:
+    using image_t = planar_image<float,double>;
+
+    explicit Temporal_Index(const planar_image_collection<float,double> &imagecoll,
+                            const std::string &time_key = "dt");
+    explicit Temporal_Index(std::vector<const image_t *> imgs,
+                            const std::string &time_key = "dt");
+
+    Temporal_Index(const Temporal_Index &) = delete;
+    Temporal_Index & operator=(const Temporal_Index &) = delete;
+
+    const std::string & get_time_key() const;
+
+    // The images having a finite time, ordered by time, and their times. Ties retain collection order.
+    const std::vector<const image_t *> & get_images() const;
+    const std::vector<double> & get_times() const;
+
+    // The images lacking a finite time, in collection order.
+    const std::vector<const image_t *> & get_untimed_images() const;
+
+    // Returns the time of the image, or NaN if the image lacks a finite time or is not part of the index.
+    double get_time(const image_t *img) const;
+
+    // Returns the collection positions of the images whose time matches the given time, in increasing order. Times
+    // match when RELATIVE_DIFF(t, t_image) < rel_tol, i.e., using the same criteria as
+    // GroupTemporallyOverlappingImages.
+    std::vector<size_t> find_coincident(double t, double rel_tol = 1E-3) const;
+
+    // Returns true if the collection still has the same images, in the same order, with the same (unparsed) time
+    // metadata as when the index was created.
+    bool is_current(const planar_image_collection<float,double> &imagecoll) const;
+
+  private:
+    std::string time_key;
+    std::vector<const image_t *> collection;       // In collection order.
+    std::vector<std::optional<std::string>> raw;   // The unparsed time of each image, in collection order.
+    std::vector<double> time_of;                   // In collection order.
+    std::unordered_map<const image_t *, size_t> position_of;
+
+    std::vector<size_t> order;                     // Positions of the timed images, ordered by time.
+    std::vector<const image_t *> images;
+    std::vector<double> times;
+    std::vector<const image_t *> untimed;
+};
+
+// Returns a cached index for the collection, rebuilding it when it is no longer current. This is meant for code which
+// only has access to the collection (e.g., image grouping functors, which are invoked once per group); prefer
+// Image_Array::get_temporal_index() otherwise. Checking currency is linear in the number of images, but does not
+// require the time metadata to be re-parsed.
+std::shared_ptr<const Temporal_Index> Get_Temporal_Index(const planar_image_collection<float,double> &imagecoll,
+                                                         const std::string &time_key = "dt");
+
+
+// A 4D (row, column, channel, time) tensor of voxel time courses for an image collection.
+//
+// Images are partitioned into groups of spatially-overlapping images (using the same criteria as
+// GroupSpatiallyOverlappingImages), and each group is ordered by a time metadata key. Each voxel's time course is
+// then stored contiguously, so analyses that need a voxel's value at every time point (e.g., per-ROI time courses)
+// read a single series rather than visiting every image and re-parsing its metadata for each voxel.
+//
+// Groups are built lazily on first access, so callers that only need a few voxels or groups only pay for those. The
+// tensor holds pointers into the collection, so it is invalidated whenever images are added, removed, or altered.
+// is_current() detects added or removed images; Image_Array::get_time_course_tensor() also detects in-place edits.
+class Time_Course_Tensor {
+  public:
+    using image_t = planar_image<float,double>;
+
+    class group_t {
+      public:
+        // The images, ordered by time. Ties retain collection order.
+        const std::vector<const image_t *> & get_images() const;
+
+        // The time of each image. Images lacking the time metadata are assigned NaN and ordered last.
+        const std::vector<double> & get_times() const;
+
+        // Returns true if every image has a finite time.
+        bool has_times() const;
+
+        // Returns a pointer to the contiguous time course of the voxel, ordered as get_images(). Builds the group's
+        // tensor on first access. Throws if the images have differing numbers of rows, columns, or channels.
+        const float * get_series(long int row, long int col, long int chan) const;
+        const float * get_series(long int index) const; // Using planar_image::index() indexing.
+
+        size_t size() const;
+
+      private:
+        friend class Time_Course_Tensor;
+
+        std::vector<const image_t *> images;
+        std::vector<double> times;
+
+        mutable std::once_flag built;
+        mutable std::vector<float> data; // Packed with (voxel, time) ordering.
+        void build() const;
+    };
+
+    // An existing index of the collection can be provided to avoid re-parsing the image times. It is only used if it
+    // is current and uses the same time key.
+    explicit Time_Course_Tensor(const planar_image_collection<float,double> &imagecoll,
+                                const std::string &time_key = "dt",
+                                std::shared_ptr<const Temporal_Index> index = nullptr);
+
+    // Builds a single group from the given images, bypassing the spatial grouping.
+    explicit Time_Course_Tensor(const std::list<const image_t *> &imgs,
+                                const std::string &time_key = "dt");
+
+    Time_Course_Tensor(const Time_Course_Tensor &) = delete;
+    Time_Course_Tensor & operator=(const Time_Course_Tensor &) = delete;
+
+    const std::string & get_time_key() const;
+
+    // The collection-wide index of image times.
+    const Temporal_Index & get_temporal_index() const;
+
+    // Number of groups.
+    size_t size() const;
+    const group_t & get_group(size_t i) const;
+
+    // Returns the group containing the image, or nullptr if the image is not part of the tensor.
+    const group_t * find_group(const image_t *img) const;
+
+    // Returns true if the collection still has the same images, in the same order, as when the tensor was created.
+    bool is_current(const planar_image_collection<float,double> &imagecoll) const;
+
+  private:
+    std::string time_key;
+    std::shared_ptr<const Temporal_Index> index;
+    std::vector<std::unique_ptr<group_t>> groups;
+    std::vector<const image_t *> collection; // In collection order.
+    std::unordered_map<const image_t *, size_t> group_of;
+
+    void add_group(std::vector<const image_t *> imgs);
+};
+
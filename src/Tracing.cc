@@ -0,0 +1,205 @@
+//Tracing.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Tracing.h"
+
+
+namespace {
+
+struct tracer_state {
+    std::mutex m;
+    std::string filename;
+    std::set<std::string> interned; // Node-based, so element addresses are stable.
+};
+
+tracer_state & State(){
+    static tracer_state s;
+    return s;
+}
+
+} // namespace
+
+
+#ifdef DCMA_USE_TRACING
+namespace dcma_trace {
+
+std::atomic<bool> enabled{false};
+
+namespace {
+
+// Events per thread. Each event is 32 bytes, so each thread that records events holds 2 MiB.
+constexpr uint64_t buffer_capacity = static_cast<uint64_t>(1) << 16;
+
+struct event_t {
+    const char *category;
+    const char *name;
+    int64_t start_ns;
+    int64_t stop_ns;
+};
+
+struct thread_buffer {
+    long int tid = 0;
+    std::vector<event_t> events;
+    std::atomic<uint64_t> count{0}; // The total number of events recorded, including overwritten events.
+};
+
+// Buffers are shared with the registry so events survive the thread that recorded them.
+std::mutex buffers_m;
+std::vector<std::shared_ptr<thread_buffer>> buffers;
+
+// Honour the environment at startup so zones are active without an explicit call.
+const bool environment_checked = [](){
+    if(const char *f = std::getenv("DCMA_TRACE"); (f != nullptr) && (*f != '\0')){
+        Enable_Tracing(f);
+    }
+    return true;
+}();
+
+std::string Escape_JSON(const std::string &in){
+    std::stringstream ss;
+    for(const auto c : in){
+        switch(c){
+            case '"':  ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20){
+                    ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                }else{
+                    ss << c;
+                }
+                break;
+        }
+    }
+    return ss.str();
+}
+
+} // namespace
+
+int64_t now_ns(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void record(const char *category, const char *name, int64_t start_ns, int64_t stop_ns){
+    thread_local std::shared_ptr<thread_buffer> buf;
+    if(!buf){
+        buf = std::make_shared<thread_buffer>();
+        buf->events.resize(buffer_capacity);
+        std::lock_guard<std::mutex> lock(buffers_m);
+        buf->tid = static_cast<long int>(buffers.size());
+        buffers.emplace_back(buf);
+    }
+
+    const auto n = buf->count.load(std::memory_order_relaxed);
+    buf->events[n % buffer_capacity] = event_t{ category, name, start_ns, stop_ns };
+    buf->count.store(n + 1, std::memory_order_release);
+    return;
+}
+
+} // namespace dcma_trace
+#endif // DCMA_USE_TRACING
+
+
+void Enable_Tracing(const std::string &filename){
+#ifdef DCMA_USE_TRACING
+    auto &s = State();
+    std::lock_guard<std::mutex> lock(s.m);
+    s.filename = filename;
+    dcma_trace::enabled.store(!filename.empty());
+#else
+    if(!filename.empty()){
+        FUNCWARN("Tracing was not enabled at compile time. Ignoring request to trace");
+    }
+#endif
+    return;
+}
+
+
+const char * Intern_Trace_Name(const std::string &name){
+    auto &s = State();
+    std::lock_guard<std::mutex> lock(s.m);
+    return s.interned.insert(name).first->c_str();
+}
+
+
+void Write_Trace(){
+#ifdef DCMA_USE_TRACING
+    std::string filename;
+    {
+        auto &s = State();
+        std::lock_guard<std::mutex> lock(s.m);
+        filename = s.filename;
+    }
+    if(filename.empty()) return;
+
+    std::vector<std::shared_ptr<dcma_trace::thread_buffer>> bufs;
+    {
+        std::lock_guard<std::mutex> lock(dcma_trace::buffers_m);
+        bufs = dcma_trace::buffers;
+    }
+
+    // Timestamps are reported relative to the earliest retained event.
+    uint64_t dropped = 0;
+    int64_t epoch = std::numeric_limits<int64_t>::max();
+    std::vector<std::pair<uint64_t, uint64_t>> ranges; // [first, last) event indices for each buffer.
+    for(const auto &b : bufs){
+        const auto count = b->count.load(std::memory_order_acquire);
+        const auto first = (dcma_trace::buffer_capacity < count) ? (count - dcma_trace::buffer_capacity) : 0;
+        dropped += first;
+        ranges.emplace_back(first, count);
+        for(auto i = first; i < count; ++i){
+            epoch = std::min(epoch, b->events[i % dcma_trace::buffer_capacity].start_ns);
+        }
+    }
+
+    std::ofstream os(filename, std::ios::out | std::ios::trunc);
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for(size_t j = 0; j < bufs.size(); ++j){
+        const auto &b = bufs[j];
+        os << (first ? "\n" : ",\n");
+        first = false;
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << b->tid
+           << ",\"args\":{\"name\":\"thread " << b->tid << "\"}}";
+
+        for(auto i = ranges[j].first; i < ranges[j].second; ++i){
+            const auto &e = b->events[i % dcma_trace::buffer_capacity];
+            const double ts = static_cast<double>(e.start_ns - epoch) * 1.0E-3;
+            const double dur = static_cast<double>(e.stop_ns - e.start_ns) * 1.0E-3;
+            os << ",\n{\"name\":\"" << dcma_trace::Escape_JSON(e.name) << "\","
+               << "\"cat\":\"" << dcma_trace::Escape_JSON(e.category) << "\","
+               << "\"ph\":\"X\",\"pid\":0,\"tid\":" << b->tid << ","
+               << "\"ts\":" << ts << ",\"dur\":" << dur << "}";
+        }
+    }
+    os << "\n]}\n";
+    os.flush();
+    if(!os){
+        FUNCWARN("Unable to write trace to '" << filename << "'");
+        return;
+    }
+    if(0 < dropped){
+        FUNCWARN("Trace buffers overflowed; the oldest " << dropped << " events were discarded");
+    }
+    FUNCINFO("Wrote trace to '" << filename << "'");
+#endif // DCMA_USE_TRACING
+    return;
+}
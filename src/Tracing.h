@@ -0,0 +1,84 @@
+//Tracing.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <string>
+
+#ifdef DCMA_USE_TRACING
+    #include <atomic>
+    #include <cstdint>
+#endif
+
+
+// Low-overhead tracing of hot paths using scoped zones.
+//
+// Zones record the wall time spent within a scope, e.g.,
+//
+//     void Some_Routine(){
+//         DCMA_TRACE_ZONE("meshing", "Some_Routine");
+//         ...
+//     }
+//
+// Each thread appends events to its own fixed-size ring buffer without synchronization, so zones are safe to use in
+// worker threads and do not serialize them. When a buffer fills, the oldest events are overwritten. The collected
+// events can be written in the Chrome trace event format, which can be viewed with Perfetto (ui.perfetto.dev) or
+// chrome://tracing.
+//
+// Tracing is selected at compile time via the DCMA_USE_TRACING definition; without it zones compile to nothing. When
+// compiled in, tracing is also disabled at runtime until a filename is provided, either by Enable_Tracing() or via the
+// DCMA_TRACE environment variable, and disabled zones only cost a relaxed atomic load.
+//
+// Zone categories and names must have static storage duration (e.g., string literals). Use Intern_Trace_Name() for
+// names that are only known at runtime.
+
+// Enables the collection of events, which will be written to the given file. An empty filename disables tracing.
+// Has no effect if tracing was not compiled in.
+void Enable_Tracing(const std::string &filename);
+
+// Returns a pointer to a copy of the name that remains valid for the lifetime of the program.
+const char * Intern_Trace_Name(const std::string &name);
+
+// Writes all events collected so far to the file provided to Enable_Tracing(). Events are mutated without
+// synchronization, so this should only be called when instrumented work is not running (e.g., between operations).
+void Write_Trace();
+
+
+#ifdef DCMA_USE_TRACING
+namespace dcma_trace {
+
+extern std::atomic<bool> enabled;
+
+int64_t now_ns();
+void record(const char *category, const char *name, int64_t start_ns, int64_t stop_ns);
+
+class zone {
+  private:
+    const char *category;
+    const char *name;
+    int64_t start_ns = 0;
+    bool active;
+
+  public:
+    zone(const char *category, const char *name) : category(category),
+                                                   name(name),
+                                                   active(enabled.load(std::memory_order_relaxed)) {
+        if(this->active) this->start_ns = now_ns();
+    }
+    ~zone(){
+        if(this->active) record(this->category, this->name, this->start_ns, now_ns());
+    }
+
+    zone(const zone &) = delete;
+    zone & operator=(const zone &) = delete;
+};
+
+} // namespace dcma_trace
+
+#define DCMA_TRACE_CONCAT_INNER(a, b) a ## b
+#define DCMA_TRACE_CONCAT(a, b) DCMA_TRACE_CONCAT_INNER(a, b)
+#define DCMA_TRACE_ZONE(category, name) \
+    const dcma_trace::zone DCMA_TRACE_CONCAT(dcma_trace_zone_, __LINE__)((category), (name))
+
+#else
+#define DCMA_TRACE_ZONE(category, name) static_cast<void>(0)
+#endif // DCMA_USE_TRACING
@@ -0,0 +1,175 @@
+//Uniform_LUT.cc - A part of DICOMautomaton 2026.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Uniform_LUT.h"
+
+
+namespace {
+
+// The number of grid points in the first (coarsest) table considered.
+constexpr size_t initial_lut_size = 257;
+
+// Values are transformed in chunks so the originals are at hand for out-of-domain values.
+constexpr size_t lut_chunk = 512;
+
+} // namespace
+
+
+bool uniform_lut::empty() const {
+    return (this->y.size() < 2);
+}
+
+float uniform_lut::operator()(float x) const {
+    const auto xd = static_cast<double>(x);
+    if( this->empty() || !(this->x_min <= xd) || !(xd <= this->x_max) ){
+        return static_cast<float>(this->exact(xd));
+    }
+    const auto last = static_cast<double>(this->y.size() - 1);
+    const auto t = std::min((xd - this->x_min) * this->inv_dx, last);
+    const auto i = std::min(static_cast<size_t>(t), this->y.size() - 2);
+    const auto f = static_cast<float>(t - static_cast<double>(i));
+    return this->y[i] + f * (this->y[i + 1] - this->y[i]);
+}
+
+void uniform_lut::apply(float *values, size_t n) const {
+    if(this->empty()){
+        for(size_t i = 0; i < n; ++i) values[i] = static_cast<float>(this->exact(static_cast<double>(values[i])));
+        return;
+    }
+
+    const float *y = this->y.data();
+    const auto N = this->y.size();
+    const auto last = static_cast<double>(N - 1);
+
+    std::array<float, lut_chunk> orig;
+    for(size_t b = 0; b < n; b += lut_chunk){
+        const auto m = std::min(lut_chunk, n - b);
+        float *v = values + b;
+        std::copy_n(v, m, orig.data());
+
+        // Clamping maps out-of-domain values (and NaNs) onto the table. They are replaced afterward.
+        for(size_t j = 0; j < m; ++j){
+            const auto t = std::max(0.0, std::min((static_cast<double>(v[j]) - this->x_min) * this->inv_dx, last));
+            const auto i = std::min(static_cast<size_t>(t), N - 2);
+            const auto f = static_cast<float>(t - static_cast<double>(i));
+            v[j] = y[i] + f * (y[i + 1] - y[i]);
+        }
+        for(size_t j = 0; j < m; ++j){
+            const auto x = static_cast<double>(orig[j]);
+            if( !(this->x_min <= x) || !(x <= this->x_max) ) v[j] = static_cast<float>(this->exact(x));
+        }
+    }
+    return;
+}
+
+
+uniform_lut Compile_LUT(const std::function<double(double)> &f,
+                        double x_min,
+                        double x_max,
+                        double tolerance,
+                        const std::vector<double> &knots,
+                        size_t max_size){
+    uniform_lut lut;
+    lut.exact = f;
+    lut.x_min = x_min;
+    lut.x_max = x_max;
+    if( !std::isfinite(x_min) || !std::isfinite(x_max) || !(x_min < x_max) ){
+        return lut; // Nothing to tabulate.
+    }
+
+    size_t N = std::min(initial_lut_size, std::max<size_t>(max_size, 2));
+    while(true){
+        // Generates the grid, then measures the error at each midpoint and knot.
+        const auto dx = (x_max - x_min) / static_cast<double>(N - 1);
+        lut.inv_dx = 1.0 / dx;
+        lut.y.resize(N);
+        for(size_t i = 0; i < N; ++i){
+            lut.y[i] = static_cast<float>(f(x_min + dx * static_cast<double>(i)));
+        }
+
+        std::vector<float> xs;
+        xs.reserve(N - 1 + knots.size());
+        for(size_t i = 0; (i + 1) < N; ++i){
+            xs.push_back(static_cast<float>(x_min + dx * (static_cast<double>(i) + 0.5)));
+        }
+        for(const auto &k : knots){
+            if( (x_min <= k) && (k <= x_max) ) xs.push_back(static_cast<float>(k));
+        }
+
+        std::vector<float> ys(xs);
+        lut.apply(ys.data(), ys.size());
+        lut.max_abs_error = 0.0;
+        for(size_t i = 0; i < xs.size(); ++i){
+            const auto err = std::abs(static_cast<double>(ys[i]) - f(static_cast<double>(xs[i])));
+            if(!(err <= lut.max_abs_error)) lut.max_abs_error = err; // Propagates NaNs.
+        }
+
+        if(lut.max_abs_error <= tolerance){
+            FUNCINFO("Compiled a lookup table with " << N << " grid points over [" << x_min << ", " << x_max
+                     << "]; the maximum error is " << lut.max_abs_error);
+            break;
+        }
+        if(max_size <= N){
+            FUNCWARN("Unable to compile a lookup table within the tolerance " << tolerance << " (error "
+                     << lut.max_abs_error << " with " << N << " grid points). Evaluating exactly instead");
+            lut.y.clear();
+            break;
+        }
+        N = std::min(2 * N - 1, max_size);
+    }
+    return lut;
+}
+
+uniform_lut Compile_LUT(const samples_1D<double> &curve,
+                        double tolerance,
+                        size_t max_size){
+    auto shared = std::make_shared<const samples_1D<double>>(curve);
+    const auto f = [shared](double x) -> double {
+        return shared->Interpolate_Linearly(x)[2];
+    };
+
+    std::vector<double> knots;
+    knots.reserve(curve.samples.size());
+    for(const auto &s : curve.samples) knots.push_back(s[0]);
+    if(knots.size() < 2){
+        uniform_lut lut;
+        lut.exact = f;
+        return lut;
+    }
+    const auto [min_it, max_it] = std::minmax_element(std::begin(knots), std::end(knots));
+    return Compile_LUT(f, *min_it, *max_it, tolerance, knots, max_size);
+}
+
+
+std::pair<double, double> Finite_Voxel_Range(const planar_image_collection<float,double> &imagecoll,
+                                             long int channel){
+    auto lo = std::numeric_limits<double>::infinity();
+    auto hi = -lo;
+    for(const auto &img : imagecoll.images){
+        const auto chans = static_cast<size_t>(img.channels);
+        if( (0 <= channel) && ((chans == 0) || (chans <= static_cast<size_t>(channel))) ) continue;
+        const auto first = (channel < 0) ? size_t(0) : static_cast<size_t>(channel);
+        const auto stride = (channel < 0) ? size_t(1) : chans;
+        for(size_t i = first; i < img.data.size(); i += stride){
+            const auto v = static_cast<double>(img.data[i]);
+            if(!std::isfinite(v)) continue;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+    }
+    return { lo, hi };
+}
+
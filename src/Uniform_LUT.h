@@ -0,0 +1,60 @@
+//Uniform_LUT.h - A part of DICOMautomaton 2026.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+
+// A scalar transform resampled onto a dense, uniform grid and evaluated by indexing and linear interpolation.
+//
+// Lookup tables replace per-voxel evaluation of curves (which requires a search over the samples) or closed-form
+// transforms (which often involve divisions, roots, or powers) with a constant-time lookup. The exact transform is
+// retained and used outside the tabulated domain, for NaNs, and entirely when the table is empty (e.g., when it
+// could not be compiled within the requested tolerance), so lookups always produce a usable value.
+struct uniform_lut {
+    double x_min = 0.0;
+    double x_max = 0.0;
+    double inv_dx = 0.0;  // The reciprocal of the grid spacing.
+    std::vector<float> y; // The transform evaluated at x_min + i/inv_dx.
+
+    std::function<double(double)> exact;
+
+    double max_abs_error = 0.0; // The largest difference from the exact transform found within the domain.
+
+    bool empty() const;
+
+    float operator()(float x) const;
+
+    // Transforms the values in-place. In-domain values are handled in bulk so the kernel can be vectorized.
+    void apply(float *values, size_t n) const;
+};
+
+// Compiles a lookup table for the transform over [x_min, x_max]. The grid is refined until the error, which is
+// evaluated midway between grid points and at the given knots (e.g., where the transform is not smooth), is within
+// the absolute tolerance. If the tolerance cannot be met with at most max_size grid points, the table is left empty.
+// The outcome and error bound are reported.
+uniform_lut Compile_LUT(const std::function<double(double)> &f,
+                        double x_min,
+                        double x_max,
+                        double tolerance,
+                        const std::vector<double> &knots = {},
+                        size_t max_size = (1UL << 20));
+
+// Compiles a lookup table for linear interpolation of the curve over the span of its samples. Because the curve is
+// piecewise linear, checking the error at the samples bounds it over the entire domain. Evaluation outside the domain
+// matches samples_1D::Interpolate_Linearly.
+uniform_lut Compile_LUT(const samples_1D<double> &curve,
+                        double tolerance,
+                        size_t max_size = (1UL << 20));
+
+// The extrema of the finite voxel values in the given channel (or all channels if negative) of the images. Returns
+// (+inf, -inf) if there are none.
+std::pair<double, double> Finite_Voxel_Range(const planar_image_collection<float,double> &imagecoll,
+                                             long int channel = -1);
+
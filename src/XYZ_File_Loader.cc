@@ -3,15 +3,20 @@
 // This program loads point cloud data from XYZ files.
 //
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <limits>
 #include <exception>
 #include <fstream>
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>    
+#include <utility>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <cstdlib>            //Needed for exit() calls.
@@ -22,6 +27,131 @@
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 #include "YgorString.h"       //Needed for SplitStringToVector, Canonicalize_String2, SplitVector functions.
 
+#include "Point_Set_Downsampling.h"
+#include "Text_Parsing.h"
+#include "Thread_Pool.h"
+
+namespace {
+
+// Parses lines of the form 'x y z' (optionally separated by commas or semicolons, and optionally followed by a
+// comment) into points. Returns false if any other line is encountered so that the general reader can be used.
+bool Parse_XYZ_Lines(const char *b, const char *e, std::vector<vec3<double>> &out){
+    const auto is_sep = [](char c) -> bool {
+        return (c == ' ') || (c == '\t') || (c == ',') || (c == ';') || (c == '\r') || (c == '\v') || (c == '\f');
+    };
+
+    while(b != e){
+        const auto aline = Next_Line(b, e);
+        const char *p = aline.first;
+        const char *l_e = std::find(aline.first, aline.second, '#');
+
+        double x[3];
+        long int n = 0;
+        while(true){
+            while( (p != l_e) && is_sep(*p) ) ++p;
+            if(p == l_e) break;
+            if(n == 3) return false;
+
+            const char *q = Parse_Number(p, l_e, x[n]);
+            if( (q == p)
+            ||  ((q != l_e) && !is_sep(*q)) ) return false;
+            p = q;
+            ++n;
+        }
+        if(n == 0) continue;
+        if(n != 3) return false;
+        out.emplace_back(x[0], x[1], x[2]);
+    }
+    return true;
+}
+
+// Reads regular XYZ files concurrently. Returns false if the file is irregular.
+bool Fast_Read_XYZ(const std::string &filename, point_set<double> &ps){
+    const mapped_text_file FI(filename);
+    const auto chunks = Split_At_Lines(FI.begin(), FI.end(), 4 * 1024 * 1024);
+
+    std::vector<std::vector<vec3<double>>> parsed(chunks.size());
+    std::vector<char> regular(chunks.size(), 1);
+    parallel_for(0, static_cast<long int>(chunks.size()), [&](long int i) -> void {
+        regular[i] = Parse_XYZ_Lines(chunks[i].first, chunks[i].second, parsed[i]) ? 1 : 0;
+    }, 1);
+    if(std::find(std::begin(regular), std::end(regular), 0) != std::end(regular)) return false;
+
+    size_t N = 0;
+    for(const auto &v : parsed) N += v.size();
+    ps.points.reserve(ps.points.size() + N);
+    for(const auto &v : parsed) ps.points.insert(std::end(ps.points), std::begin(v), std::end(v));
+    return true;
+}
+
+// Reads regular XYZ files concurrently, passing the points to the downsampler in file order as they are parsed so that
+// only a few chunks are held at once. Returns false if the file is irregular.
+bool Stream_XYZ(const std::string &filename, point_set_downsampler &ds){
+    const mapped_text_file FI(filename);
+    const auto chunks = Split_At_Lines(FI.begin(), FI.end(), 4 * 1024 * 1024);
+    const auto N_chunks = static_cast<long int>(chunks.size());
+    const long int batch = 2 * std::max<long int>(1, work_stealing_pool::get().concurrency());
+
+    for(long int b = 0; b < N_chunks; b += batch){
+        const long int e = std::min(N_chunks, b + batch);
+        std::vector<std::vector<vec3<double>>> parsed(e - b);
+        std::vector<char> regular(e - b, 1);
+        parallel_for(b, e, [&](long int i) -> void {
+            regular[i - b] = Parse_XYZ_Lines(chunks[i].first, chunks[i].second, parsed[i - b]) ? 1 : 0;
+        }, 1);
+        if(std::find(std::begin(regular), std::end(regular), 0) != std::end(regular)) return false;
+        for(const auto &v : parsed) ds.add(v);
+    }
+    return true;
+}
+
+struct downsampling_options {
+    point_set_downsampler::method m = point_set_downsampler::method::voxel_grid;
+    double spacing = 0.0;
+    size_t max_points = std::numeric_limits<size_t>::max();
+};
+
+// Reads the downsampling configuration from the environment. Throws if it is invalid.
+std::optional<downsampling_options> Get_Downsampling_Options(){
+    const auto get = [](const char *name) -> std::optional<std::string> {
+        const char *v = std::getenv(name);
+        return ((v == nullptr) || (*v == '\0')) ? std::optional<std::string>() : std::optional<std::string>(v);
+    };
+    const auto method_str = get("DCMA_XYZ_DOWNSAMPLE");
+    const auto max_points_str = get("DCMA_XYZ_MAX_POINTS");
+    const auto spacing_str = get("DCMA_XYZ_SPACING");
+    if(!method_str && !max_points_str && !spacing_str) return std::nullopt;
+
+    downsampling_options opts;
+    if(method_str){
+        if(*method_str == "voxel"){
+            opts.m = point_set_downsampler::method::voxel_grid;
+        }else if(*method_str == "poisson"){
+            opts.m = point_set_downsampler::method::poisson_disk;
+        }else if(*method_str == "none"){
+            return std::nullopt;
+        }else{
+            throw std::invalid_argument("DCMA_XYZ_DOWNSAMPLE not understood; use 'voxel', 'poisson', or 'none'");
+        }
+    }
+    try{
+        if(max_points_str){
+            const auto n = std::stoll(*max_points_str);
+            if(n <= 0) throw std::invalid_argument("not positive");
+            opts.max_points = static_cast<size_t>(n);
+        }
+        if(spacing_str){
+            opts.spacing = std::stod(*spacing_str);
+            if( !std::isfinite(opts.spacing) || (opts.spacing <= 0.0) ) throw std::invalid_argument("not positive");
+        }
+    }catch(const std::exception &){
+        throw std::invalid_argument("DCMA_XYZ_MAX_POINTS and DCMA_XYZ_SPACING must be positive numbers");
+    }
+    return opts;
+}
+
+} // namespace
+
 
 bool Load_From_XYZ_Files( Drover &DICOM_data,
                           std::map<std::string,std::string> & /* InvocationMetadata */,
@@ -55,11 +185,31 @@ bool Load_From_XYZ_Files( Drover &DICOM_data,
     // the file is considered to be in XYZ format. Therefore, it is best to attempt loading other, more strucured
     // formats if uncertain about the file type ahead of time.
     //
+    // Scans too large to hold in memory can be downsampled while they are read, retaining only the reduced point cloud.
+    // Downsampling is configured with the following environment variables:
+    //
+    //  - DCMA_XYZ_DOWNSAMPLE: 'voxel' (the default) replaces the points in each cubic voxel with their centroid, and
+    //    'poisson' retains a subset of the points with a minimum separation. 'none' disables downsampling.
+    //  - DCMA_XYZ_SPACING: the voxel size or minimum separation, in DICOM units (mm).
+    //  - DCMA_XYZ_MAX_POINTS: a point budget for each file. The spacing is increased as needed to meet it. If no
+    //    spacing is provided, one is selected automatically.
+    //
+    // Downsampling is enabled when any of these are set. See point_set_downsampler for details. Irregular files are
+    // read fully before being downsampled.
+    //
     // Note: This routine returns false only iff a file is suspected of being suited for this loader, but could not be
     //       loaded (e.g., the file seems appropriate, but a parsing failure was encountered).
     //
     if(Filenames.empty()) return true;
 
+    std::optional<downsampling_options> ds_opts;
+    try{
+        ds_opts = Get_Downsampling_Options();
+    }catch(const std::exception &e){
+        FUNCWARN("Invalid XYZ downsampling configuration: " << e.what());
+        return false;
+    }
+
     size_t i = 0;
     const size_t N = Filenames.size();
 
@@ -74,11 +224,32 @@ bool Load_From_XYZ_Files( Drover &DICOM_data,
         try{
             //////////////////////////////////////////////////////////////
             // Attempt to load the file.
-            std::ifstream FI(Filename.c_str(), std::ios::in);
-            if(!ReadPointSetFromXYZ(DICOM_data.point_data.back()->pset, FI)){
-                throw std::runtime_error("Unable to read mesh from file.");
+            //
+            // Regular files are parsed directly. Anything unusual is left to the more permissive general reader.
+            auto &pset = DICOM_data.point_data.back()->pset;
+            const auto read_generally = [&]() -> void {
+                pset.points.clear();
+                std::ifstream FI(Filename.c_str(), std::ios::in);
+                if(!ReadPointSetFromXYZ(pset, FI)){
+                    throw std::runtime_error("Unable to read mesh from file.");
+                }
+                FI.close();
+            };
+
+            if(ds_opts){
+                const auto &o = ds_opts.value();
+                point_set_downsampler ds(o.m, o.spacing, o.max_points);
+                if(!Stream_XYZ(Filename, ds)){
+                    ds = point_set_downsampler(o.m, o.spacing, o.max_points);
+                    read_generally();
+                    ds.add(pset.points);
+                }
+                pset.points = ds.get_points();
+                FUNCINFO("Downsampled point cloud using a spacing of " << ds.get_spacing());
+
+            }else if(!Fast_Read_XYZ(Filename, pset)){
+                read_generally();
             }
-            FI.close();
             //////////////////////////////////////////////////////////////
 
             // Reject the file if the point cloud is not valid.
@@ -0,0 +1,412 @@
+//Analytic_Rasterization.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Thread_Pool.h"
+#include "Voxel_Inclusion_Mask.h"
+#include "Analytic_Rasterization.h"
+
+
+namespace {
+
+using interval_t = std::pair<double, double>;
+constexpr double inf = std::numeric_limits<double>::infinity();
+
+// Appends the parameters t for which the line p0 + b*t is covered by a primitive. Intervals may overlap and need not be
+// bounded. The direction b may be zero, in which case the whole line is covered iff p0 is.
+using row_intervals_t = std::function<void(const vec3<double> &p0, const vec3<double> &b, std::vector<interval_t> &)>;
+
+// The interval of t where lo <= (s0 + s1*t) <= hi, or an empty (reversed) interval.
+interval_t linear_interval(double s0, double s1, double lo, double hi){
+    if(s1 == 0.0){
+        return ( (lo <= s0) && (s0 <= hi) ) ? interval_t(-inf, inf) : interval_t(inf, -inf);
+    }
+    const auto t0 = (lo - s0) / s1;
+    const auto t1 = (hi - s0) / s1;
+    return (t0 <= t1) ? interval_t(t0, t1) : interval_t(t1, t0);
+}
+
+// The interval of t where |w0 + w1*t|^2 <= r^2, or an empty (reversed) interval.
+template <class V>
+interval_t quadratic_interval(const V &w0, const V &w1, double r){
+    const auto A = w1.Dot(w1);
+    const auto B = 2.0 * w0.Dot(w1);
+    const auto C = w0.Dot(w0) - r * r;
+    if(!(0.0 < A)){
+        return (C <= 0.0) ? interval_t(-inf, inf) : interval_t(inf, -inf);
+    }
+    const auto disc = B * B - 4.0 * A * C;
+    if(disc < 0.0) return interval_t(inf, -inf);
+    const auto sq = std::sqrt(disc);
+    return interval_t( (-B - sq) / (2.0 * A), (-B + sq) / (2.0 * A) );
+}
+
+// A minimal 2D vector, for distances within the plane perpendicular to a family of grid lines.
+struct vec2_t {
+    double x;
+    double y;
+    double Dot(const vec2_t &o) const { return x * o.x + y * o.y; }
+};
+
+bool is_empty(const interval_t &i){
+    return !(i.first <= i.second);
+}
+
+// Converts the intervals for a row into sorted column runs, which may overlap.
+void append_runs(const std::vector<interval_t> &intervals,
+                 long int columns,
+                 std::vector<std::array<uint32_t, 2>> &runs){
+    const auto first = runs.size();
+    const auto last = static_cast<double>(columns - 1);
+    for(const auto &i : intervals){
+        if(is_empty(i)) continue;
+        const auto t0 = std::ceil(std::max(i.first, 0.0));
+        const auto t1 = std::floor(std::min(i.second, last));
+        if(!(t0 <= t1)) continue;
+        runs.push_back({ static_cast<uint32_t>(t0), static_cast<uint32_t>(t1) + 1U });
+    }
+    std::sort(std::next(std::begin(runs), first), std::end(runs));
+    return;
+}
+
+// Merges overlapping or adjacent runs in [first, runs.end()), which must be sorted.
+void merge_runs(std::vector<std::array<uint32_t, 2>> &runs, size_t first){
+    if(runs.size() <= first) return;
+    size_t out = first;
+    for(size_t i = first + 1; i < runs.size(); ++i){
+        if(runs[i][0] <= runs[out][1]){
+            runs[out][1] = std::max(runs[out][1], runs[i][1]);
+        }else{
+            runs[++out] = runs[i];
+        }
+    }
+    runs.resize(out + 1);
+    return;
+}
+
+voxel_inclusion_mask rasterize(const planar_image<float,double> &img, const row_intervals_t &f){
+    voxel_inclusion_mask out;
+    out.rows = img.rows;
+    out.columns = img.columns;
+    out.row_offsets.assign(static_cast<size_t>(std::max<long int>(img.rows, 0)) + 1, 0U);
+    if( (img.rows <= 0) || (img.columns <= 0) ) return out;
+
+    // Index-space axes. Verify they reproduce the image's own voxel positions.
+    const auto p00 = img.position(0, 0);
+    const auto a = img.row_unit * img.pxl_dx;
+    const auto b = img.col_unit * img.pxl_dy;
+    bool affine = true;
+    {
+        const double tol = 1.0E-6 * std::sqrt(a.Dot(a) + b.Dot(b));
+        const auto p_r = img.position(img.rows - 1, 0);
+        const auto p_c = img.position(0, img.columns - 1);
+        const auto p_rc = img.position(img.rows - 1, img.columns - 1);
+        const auto dr = static_cast<double>(img.rows - 1);
+        const auto dc = static_cast<double>(img.columns - 1);
+        affine = ((p00 + a * dr).distance(p_r) <= tol)
+              && ((p00 + b * dc).distance(p_c) <= tol)
+              && ((p00 + a * dr + b * dc).distance(p_rc) <= tol);
+    }
+
+    std::vector<interval_t> intervals;
+    const vec3<double> zero(0.0, 0.0, 0.0);
+    for(long int row = 0; row < img.rows; ++row){
+        const auto first = out.runs.size();
+        if(affine){
+            intervals.clear();
+            f(p00 + a * static_cast<double>(row), b, intervals);
+            append_runs(intervals, img.columns, out.runs);
+        }else{
+            for(long int col = 0; col < img.columns; ++col){
+                intervals.clear();
+                f(img.position(row, col), zero, intervals);
+                const bool covered = std::any_of(std::begin(intervals), std::end(intervals),
+                                                 [](const interval_t &i){ return !is_empty(i); });
+                if(covered) out.runs.push_back({ static_cast<uint32_t>(col), static_cast<uint32_t>(col) + 1U });
+            }
+        }
+        merge_runs(out.runs, first);
+        out.row_offsets[static_cast<size_t>(row) + 1] = static_cast<uint32_t>(out.runs.size());
+    }
+    return out;
+}
+
+// The interval covered by the capsule around segment [P, Q]. Since capsules are convex, the covered parameters form a
+// single interval spanning the cylinder and end caps.
+interval_t capsule_interval(const vec3<double> &P, const vec3<double> &Q, double r,
+                            const vec3<double> &p0, const vec3<double> &b){
+    auto out = quadratic_interval(p0 - P, b, r);
+    const auto cap = quadratic_interval(p0 - Q, b, r);
+    const auto widen = [&](const interval_t &i){
+        if(is_empty(i)) return;
+        if(is_empty(out)){
+            out = i;
+        }else{
+            out.first = std::min(out.first, i.first);
+            out.second = std::max(out.second, i.second);
+        }
+    };
+    widen(cap);
+
+    const auto PQ = Q - P;
+    const auto len = PQ.length();
+    if(0.0 < len){
+        const auto u = PQ / len;
+        const auto perp = [&](const vec3<double> &v){ return v - u * v.Dot(u); };
+        auto cyl = quadratic_interval(perp(p0 - P), perp(b), r);
+        const auto along = linear_interval((p0 - P).Dot(u), b.Dot(u), 0.0, len);
+        cyl.first = std::max(cyl.first, along.first);
+        cyl.second = std::min(cyl.second, along.second);
+        widen(cyl);
+    }
+    return out;
+}
+
+// Appends the intervals covered by lines perpendicular to e1 and e2 through origin + s*(i*e1 + j*e2), i, j in [-N, N].
+// The unit vectors must be orthonormal.
+void grid_family_intervals(const vec3<double> &origin,
+                           const vec3<double> &e1,
+                           const vec3<double> &e2,
+                           double s, double r, long int N,
+                           double t_max,
+                           const vec3<double> &p0, const vec3<double> &b,
+                           std::vector<interval_t> &intervals){
+
+    // The row projected onto the plane spanned by e1 and e2, in units where the lattice is unit-spaced.
+    double y0 = (p0 - origin).Dot(e1) / s;
+    double y1 = b.Dot(e1) / s;
+    double z0 = (p0 - origin).Dot(e2) / s;
+    double z1 = b.Dot(e2) / s;
+    const double R = r / s;
+
+    // Iterate over the lattice axis along which the row moves fastest.
+    if(std::abs(y1) < std::abs(z1)){
+        std::swap(y0, z0);
+        std::swap(y1, z1);
+    }
+    const auto clamp_index = [N](double x) -> double {
+        return std::max(-static_cast<double>(N), std::min(x, static_cast<double>(N)));
+    };
+    const auto lattice_range = [&](double lo, double hi) -> std::pair<long int, long int> {
+        lo = clamp_index(std::ceil(lo - R));
+        hi = clamp_index(std::floor(hi + R));
+        return { static_cast<long int>(lo), static_cast<long int>(hi) };
+    };
+    const auto add = [&](long int i, long int j){
+        const vec2_t w0 = { y0 - static_cast<double>(i), z0 - static_cast<double>(j) };
+        const vec2_t w1 = { y1, z1 };
+        intervals.push_back( quadratic_interval(w0, w1, R) );
+    };
+
+    if(y1 == 0.0){
+        // The row is parallel to the lines (or a single point), so it is either entirely covered or not at all.
+        const auto [i_lo, i_hi] = lattice_range(y0, y0);
+        const auto [j_lo, j_hi] = lattice_range(z0, z0);
+        for(long int i = i_lo; i <= i_hi; ++i){
+            for(long int j = j_lo; j <= j_hi; ++j) add(i, j);
+        }
+        return;
+    }
+
+    const auto y_a = y0;
+    const auto y_b = y0 + y1 * t_max;
+    const auto [i_lo, i_hi] = lattice_range(std::min(y_a, y_b), std::max(y_a, y_b));
+    for(long int i = i_lo; i <= i_hi; ++i){
+        // The portion of the row near lattice column i, and the lattice rows it passes near.
+        auto span = linear_interval(y0, y1, static_cast<double>(i) - R, static_cast<double>(i) + R);
+        span.first = std::max(span.first, 0.0);
+        span.second = std::min(span.second, t_max);
+        if(is_empty(span)) continue;
+        const auto z_a = z0 + z1 * span.first;
+        const auto z_b = z0 + z1 * span.second;
+        const auto [j_lo, j_hi] = lattice_range(std::min(z_a, z_b), std::max(z_a, z_b));
+        for(long int j = j_lo; j <= j_hi; ++j) add(i, j);
+    }
+    return;
+}
+
+} // namespace
+
+
+voxel_inclusion_mask Rasterize_Sphere(const planar_image<float,double> &img,
+                                      const vec3<double> &centre,
+                                      double radius){
+    return rasterize(img, [&](const vec3<double> &p0, const vec3<double> &b, std::vector<interval_t> &out){
+        out.push_back( quadratic_interval(p0 - centre, b, radius) );
+    });
+}
+
+voxel_inclusion_mask Rasterize_Capsules(const planar_image<float,double> &img,
+                                        const std::vector<line_segment<double>> &segments,
+                                        double radius){
+    return rasterize(img, [&](const vec3<double> &p0, const vec3<double> &b, std::vector<interval_t> &out){
+        for(const auto &l : segments){
+            out.push_back( capsule_interval(l.Get_R0(), l.Get_R1(), radius, p0, b) );
+        }
+    });
+}
+
+voxel_inclusion_mask Rasterize_Slab(const planar_image<float,double> &img,
+                                    const plane<double> &P,
+                                    double half_thickness){
+    const auto N = P.N_0.unit();
+    return rasterize(img, [&](const vec3<double> &p0, const vec3<double> &b, std::vector<interval_t> &out){
+        out.push_back( linear_interval((p0 - P.R_0).Dot(N), b.Dot(N), -half_thickness, half_thickness) );
+    });
+}
+
+voxel_inclusion_mask Rasterize_Grid(const planar_image<float,double> &img,
+                                    const vec3<double> &origin,
+                                    const vec3<double> &unit_x,
+                                    const vec3<double> &unit_y,
+                                    const vec3<double> &unit_z,
+                                    double separation,
+                                    double radius,
+                                    long int N){
+    if(!(0.0 < separation) || !std::isfinite(separation)){
+        throw std::invalid_argument("Grid separation must be positive");
+    }
+    const auto t_max = static_cast<double>(std::max<long int>(img.columns - 1, 0));
+    return rasterize(img, [&](const vec3<double> &p0, const vec3<double> &b, std::vector<interval_t> &out){
+        grid_family_intervals(origin, unit_y, unit_z, separation, radius, N, t_max, p0, b, out); // Lines along x.
+        grid_family_intervals(origin, unit_x, unit_y, separation, radius, N, t_max, p0, b, out); // Lines along z.
+        grid_family_intervals(origin, unit_x, unit_z, separation, radius, N, t_max, p0, b, out); // Lines along y.
+    });
+}
+
+
+voxel_inclusion_mask Intersect_Voxel_Spans(const voxel_inclusion_mask &A, const voxel_inclusion_mask &B){
+    if( (A.rows != B.rows) || (A.columns != B.columns) ){
+        throw std::invalid_argument("Voxel spans have differing dimensions");
+    }
+    voxel_inclusion_mask out;
+    out.rows = A.rows;
+    out.columns = A.columns;
+    out.row_offsets.assign(A.row_offsets.size(), 0U);
+    for(long int row = 0; row < A.rows; ++row){
+        auto i = A.row_offsets[row];
+        auto j = B.row_offsets[row];
+        while( (i < A.row_offsets[row + 1]) && (j < B.row_offsets[row + 1]) ){
+            const auto lo = std::max(A.runs[i][0], B.runs[j][0]);
+            const auto hi = std::min(A.runs[i][1], B.runs[j][1]);
+            if(lo < hi) out.runs.push_back({ lo, hi });
+            if(A.runs[i][1] < B.runs[j][1]){
+                ++i;
+            }else{
+                ++j;
+            }
+        }
+        out.row_offsets[row + 1] = static_cast<uint32_t>(out.runs.size());
+    }
+    return out;
+}
+
+voxel_inclusion_mask Invert_Voxel_Spans(const voxel_inclusion_mask &A){
+    voxel_inclusion_mask out;
+    out.rows = A.rows;
+    out.columns = A.columns;
+    out.row_offsets.assign(A.row_offsets.size(), 0U);
+    const auto cols = static_cast<uint32_t>(std::max<long int>(A.columns, 0));
+    for(long int row = 0; row < A.rows; ++row){
+        uint32_t c = 0;
+        for(auto r = A.row_offsets[row]; r < A.row_offsets[row + 1]; ++r){
+            if(c < A.runs[r][0]) out.runs.push_back({ c, A.runs[r][0] });
+            c = A.runs[r][1];
+        }
+        if(c < cols) out.runs.push_back({ c, cols });
+        out.row_offsets[row + 1] = static_cast<uint32_t>(out.runs.size());
+    }
+    return out;
+}
+
+void Fill_Voxel_Spans(planar_image<float,double> &img,
+                      const voxel_inclusion_mask &spans,
+                      long int channel,
+                      float value){
+    if( (spans.rows != img.rows) || (spans.columns != img.columns) ){
+        throw std::invalid_argument("Voxel spans do not match the image");
+    }
+    if(img.channels <= channel) return;
+    const long int chns = img.channels;
+    for(long int row = 0; row < img.rows; ++row){
+        for(auto r = spans.row_offsets[row]; r < spans.row_offsets[row + 1]; ++r){
+            const auto c_begin = static_cast<long int>(spans.runs[r][0]);
+            const auto c_end = static_cast<long int>(spans.runs[r][1]);
+            float *p = &img.reference(row, c_begin, 0);
+            if(channel < 0){
+                std::fill(p, p + (c_end - c_begin) * chns, value);
+            }else{
+                for(long int i = 0; i < (c_end - c_begin); ++i) p[i * chns + channel] = value;
+            }
+        }
+    }
+    return;
+}
+
+
+void Imprint_Points(std::list<planar_image<float,double>> &images,
+                    const std::vector<vec3<double>> &points,
+                    long int channel,
+                    float value){
+    if(images.empty() || points.empty()) return;
+
+    // Sort the points by their distance along the first image's normal.
+    const auto &front = images.front();
+    const auto n0 = front.row_unit.Cross(front.col_unit).unit();
+    std::vector<std::pair<double, size_t>> order;
+    order.reserve(points.size());
+    for(size_t i = 0; i < points.size(); ++i){
+        const auto d = points[i].Dot(n0);
+        if(std::isfinite(d)) order.emplace_back(d, i);
+    }
+    std::sort(std::begin(order), std::end(order));
+
+    std::vector<planar_image<float,double> *> imgs;
+    for(auto &img : images) imgs.push_back(&img);
+
+    parallel_for(0, static_cast<long int>(imgs.size()), [&](long int k) -> void {
+        auto &img = *(imgs[k]);
+        const auto n = img.row_unit.Cross(img.col_unit).unit();
+
+        // Every point within the image's voxels lies within this distance of the centre, along n0. Tilted images
+        // widen the window by the in-plane extent, so the candidates are always a superset.
+        const auto h_r = 0.5 * static_cast<double>(img.rows) * img.pxl_dx;
+        const auto h_c = 0.5 * static_cast<double>(img.columns) * img.pxl_dy;
+        const auto extent = std::sqrt(h_r * h_r + h_c * h_c);
+        const auto tilt = n.Cross(n0).length();
+        const auto half = 0.5 * img.pxl_dz * std::abs(n.Dot(n0)) + extent * tilt;
+        const auto pad = 1.0E-6 * (half + 1.0);
+        const auto c = img.center().Dot(n0);
+
+        if(!std::isfinite(half) || !std::isfinite(c)){
+            for(const auto &P : points){
+                const auto index = img.index(P, channel);
+                if(0 <= index) img.reference(index) = value;
+            }
+            return;
+        }
+
+        auto it = std::lower_bound(std::begin(order), std::end(order), std::make_pair(c - half - pad, size_t(0)));
+        const auto end = std::upper_bound(std::begin(order), std::end(order),
+                                          std::make_pair(c + half + pad, std::numeric_limits<size_t>::max()));
+        for( ; it != end; ++it){
+            const auto index = img.index(points[it->second], channel);
+            if(0 <= index) img.reference(index) = value;
+        }
+    }, 1);
+    return;
+}
+
@@ -0,0 +1,70 @@
+//Analytic_Rasterization.h.
+
+#pragma once
+
+#include <list>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Voxel_Inclusion_Mask.h"
+
+
+// Analytic rasterization of simple geometric primitives onto an image's voxel grid.
+//
+// Rather than testing every voxel against a primitive, each row of voxel centres is treated as a line and its
+// intersection with the primitive is solved for directly, yielding the covered columns as spans. Spans are stored in
+// the voxel_inclusion_mask layout so they can be combined with contour masks. Only voxels whose centres lie within a
+// primitive are covered. Images whose voxel positions are not an affine function of (row, column) are handled by
+// testing each voxel centre individually.
+
+// Voxels within the solid sphere.
+voxel_inclusion_mask Rasterize_Sphere(const planar_image<float,double> &img,
+                                      const vec3<double> &centre,
+                                      double radius);
+
+// Voxels within the given distance of any of the line segments, i.e., within a union of capsules ('pills').
+voxel_inclusion_mask Rasterize_Capsules(const planar_image<float,double> &img,
+                                        const std::vector<line_segment<double>> &segments,
+                                        double radius);
+
+// Voxels within the given distance of the plane, i.e., within a slab of thickness 2*half_thickness.
+voxel_inclusion_mask Rasterize_Slab(const planar_image<float,double> &img,
+                                    const plane<double> &P,
+                                    double half_thickness);
+
+// Voxels within the given distance of a regular grid of lines. Lines run parallel to each of the orthonormal unit
+// vectors through the points origin + separation * (i * u_a + j * u_b), where u_a and u_b are the other two unit
+// vectors and i, j are in [-N, N].
+voxel_inclusion_mask Rasterize_Grid(const planar_image<float,double> &img,
+                                    const vec3<double> &origin,
+                                    const vec3<double> &unit_x,
+                                    const vec3<double> &unit_y,
+                                    const vec3<double> &unit_z,
+                                    double separation,
+                                    double radius,
+                                    long int N);
+
+
+// Voxels covered by both sets of spans.
+voxel_inclusion_mask Intersect_Voxel_Spans(const voxel_inclusion_mask &A, const voxel_inclusion_mask &B);
+
+// Voxels not covered by the spans.
+voxel_inclusion_mask Invert_Voxel_Spans(const voxel_inclusion_mask &A);
+
+// Assigns the value to the given channel (or all channels if negative) of the covered voxels.
+void Fill_Voxel_Spans(planar_image<float,double> &img,
+                      const voxel_inclusion_mask &spans,
+                      long int channel,
+                      float value);
+
+
+// Assigns the value to the given channel of the voxels containing the points, like planar_image::index(P, channel),
+// for every image. Images are processed concurrently. When the images share an orientation, the points are sorted by
+// their distance along the image normal so that only the points within each image's slab are considered.
+void Imprint_Points(std::list<planar_image<float,double>> &images,
+                    const std::vector<vec3<double>> &points,
+                    long int channel,
+                    float value);
+
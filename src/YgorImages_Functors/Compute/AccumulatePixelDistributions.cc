@@ -1,6 +1,9 @@
 //AccumulatePixelDistributions.cc.
 
+#include <algorithm>
 #include <exception>
+#include <iterator>
+#include <memory>
 #include <any>
 #include <optional>
 #include <functional>
@@ -8,8 +11,12 @@
 #include <map>
 #include <ostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
+#include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
+#include "../Voxel_Inclusion_Mask.h"
 #include "AccumulatePixelDistributions.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -27,7 +34,9 @@ bool AccumulatePixelDistributions(planar_image_collection<float,double> &imageco
 
     //This routine accumulates pixel/voxel intensities on an individual ROI-basis. The entire distribution is collected
     // so that various quantities can be computed afterward. In particular, direct comparison of distributions. Another
-    // reason for collecting the entire distribution is that the action can be performed iteratively.
+    // reason for collecting the entire distribution is that the action can be performed iteratively. Streaming
+    // summaries (exact moments and estimated percentiles) are also produced, and collecting the entire distribution
+    // can be disabled if the summaries suffice.
     //
     // The primary need for this routine was computing dose distributions on 'SGF' data sets. This routine replaces an
     // older routine that performs a nearly identical computation, but is less flexible.
@@ -62,6 +71,7 @@ bool AccumulatePixelDistributions(planar_image_collection<float,double> &imageco
     //Generate a comprehensive list of iterators to all as-of-yet-unused images. This list will be
     // pruned after images have been successfully operated on.
     auto all_images = imagecoll.get_all_images();
+    std::vector<std::list<planar_image_collection<float,double>::images_list_it_t>> groups;
     while(!all_images.empty()){
         FUNCINFO("Images still to be processed: " << all_images.size());
 
@@ -98,109 +108,241 @@ bool AccumulatePixelDistributions(planar_image_collection<float,double> &imageco
              all_images.remove(an_img_it); //std::list::remove() erases all elements equal to input value.
         }
 
-        planar_image<float,double> &img = std::ref(*selected_imgs.front());
-        //Loop over the rois, rows, columns, channels, and finally any selected images (if applicable).
-        const auto row_unit   = img.row_unit;
-        const auto col_unit   = img.col_unit;
-        const auto ortho_unit = row_unit.Cross( col_unit ).unit();
+        groups.emplace_back(selected_imgs);
+    }
+
+    // Process each group of images in parallel. Each task accumulates into its own storage, and the results are merged
+    // in the original order afterward, so the merged distributions do not depend on the scheduling.
+    struct group_result_t {
+        bool ok = true;
+        std::map<std::string, std::vector<double>> voxels;
+        std::map<std::string, distribution_sketch> sketches;
+    };
+    std::vector<group_result_t> results(groups.size());
+    {
+        task_group tg;
+        for(size_t g = 0; g < groups.size(); ++g){
+            tg.run([&,g]() -> void {
+                const auto &selected_imgs = groups[g];
+                auto &result = results[g];
+                planar_image<float,double> &img = std::ref(*selected_imgs.front());
+                //Loop over the rois, rows, columns, channels, and finally any selected images (if applicable).
+                const auto row_unit   = img.row_unit;
+                const auto col_unit   = img.col_unit;
+                const auto ortho_unit = row_unit.Cross( col_unit ).unit();
+
+                //Loop over the ccsl, rois, rows, columns, channels, and finally any selected images (if applicable).
+                //for(const auto &roi : rois){
+                for(auto &ccs : ccsl){
+                    for(auto & contour : ccs.get().contours){
+                        if(contour.points.empty()) continue;
+                        if(! img.encompasses_contour_of_points(contour)) continue;
+
+                        const auto ROIName =  contour.GetMetadataValueAs<std::string>("ROIName");
+                        if(!ROIName){
+                            FUNCWARN("Missing necessary tags for reporting analysis results. Cannot continue");
+                            result.ok = false;
+                            return;
+                        }
+            
+                /*
+                        //Construct a bounding box to reduce computational demand of checking every voxel.
+                        auto BBox = roi_it->Bounding_Box_Along(row_unit, 1.0);
+                        auto BBoxBestFitPlane = BBox.Least_Squares_Best_Fit_Plane(vec3<double>(0.0,0.0,1.0));
+                        auto BBoxProjectedContour = BBox.Project_Onto_Plane_Orthogonally(BBoxBestFitPlane);
+                        const bool BBoxAlreadyProjected = true;
+                */
     
-        //Loop over the ccsl, rois, rows, columns, channels, and finally any selected images (if applicable).
-        //for(const auto &roi : rois){
-        for(auto &ccs : ccsl){
-            for(auto & contour : ccs.get().contours){
-                if(contour.points.empty()) continue;
-                if(! img.encompasses_contour_of_points(contour)) continue;
+                        //Prepare a contour for fast is-point-within-the-polygon checking.
+                        auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
+                        auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
+                        const bool AlreadyProjected = true;
     
-                const auto ROIName =  contour.GetMetadataValueAs<std::string>("ROIName");
-                if(!ROIName){
-                    FUNCWARN("Missing necessary tags for reporting analysis results. Cannot continue");
-                    return false;
-                }
-                
-        /*
-                //Construct a bounding box to reduce computational demand of checking every voxel.
-                auto BBox = roi_it->Bounding_Box_Along(row_unit, 1.0);
-                auto BBoxBestFitPlane = BBox.Least_Squares_Best_Fit_Plane(vec3<double>(0.0,0.0,1.0));
-                auto BBoxProjectedContour = BBox.Project_Onto_Plane_Orthogonally(BBoxBestFitPlane);
-                const bool BBoxAlreadyProjected = true;
-        */
-        
-                //Prepare a contour for fast is-point-within-the-polygon checking.
-                auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-                auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-                const bool AlreadyProjected = true;
-        
-                for(auto row = 0; row < img.rows; ++row){
-                    for(auto col = 0; col < img.columns; ++col){
-                        //Figure out the spatial location of the present voxel.
-                        const auto point = img.position(row,col);
-        
-        /*
-                        //Check if within the bounding box. It will generally be cheaper than the full contour (4 points vs. ? points).
-                        auto BBoxProjectedPoint = BBoxBestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                        if(!BBoxProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BBoxBestFitPlane,
-                                                                                            BBoxProjectedPoint,
-                                                                                            BBoxAlreadyProjected)) continue;
-        */
-        
-                        //Perform a more detailed check to see if we are in the ROI.
-                        auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                        if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                       ProjectedPoint,
-                                                                                       AlreadyProjected)){
-                            for(auto chan = 0; chan < img.channels; ++chan){
-                                //Cycle over the grouped images, accumulating the voxel intensity.
-                                double combined_voxel_intensity = 0.0;
-                                for(auto & img_it : selected_imgs){
-
-                                    //Collect the datum of voxels and nearby voxels for an average.
-                                    std::list<double> in_pixs;
-                                    const auto boxr = 0;
-                                    const auto min_datum = 1;
-                                    for(auto lrow = (row-boxr); lrow <= (row+boxr); ++lrow){
-                                        for(auto lcol = (col-boxr); lcol <= (col+boxr); ++lcol){
-                                            //Check if the coordinates are legal and in the ROI.
-                                            if( !isininc(0,lrow,img_it->rows-1) || !isininc(0,lcol,img_it->columns-1) ) continue;
-        
-                                            //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
-                                            //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
-                                            const auto neighbourpoint = img.position(lrow,lcol);
-                                            auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
-                                            if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                            ProjectedNeighbourPoint,
-                                                                                                            AlreadyProjected)) continue;
-                                            const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
-                                            in_pixs.push_back(val);
+                        for(auto row = 0; row < img.rows; ++row){
+                            for(auto col = 0; col < img.columns; ++col){
+                                //Figure out the spatial location of the present voxel.
+                                const auto point = img.position(row,col);
+    
+                /*
+                                //Check if within the bounding box. It will generally be cheaper than the full contour (4 points vs. ? points).
+                                auto BBoxProjectedPoint = BBoxBestFitPlane.Project_Onto_Plane_Orthogonally(point);
+                                if(!BBoxProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BBoxBestFitPlane,
+                                                                                                    BBoxProjectedPoint,
+                                                                                                    BBoxAlreadyProjected)) continue;
+                */
+    
+                                //Perform a more detailed check to see if we are in the ROI.
+                                auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
+                                if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
+                                                                                               ProjectedPoint,
+                                                                                               AlreadyProjected)){
+                                    for(auto chan = 0; chan < img.channels; ++chan){
+                                        //Cycle over the grouped images, accumulating the voxel intensity.
+                                        double combined_voxel_intensity = 0.0;
+                                        for(auto & img_it : selected_imgs){
+
+                                            //Collect the datum of voxels and nearby voxels for an average.
+                                            std::list<double> in_pixs;
+                                            const auto boxr = 0;
+                                            const auto min_datum = 1;
+                                            for(auto lrow = (row-boxr); lrow <= (row+boxr); ++lrow){
+                                                for(auto lcol = (col-boxr); lcol <= (col+boxr); ++lcol){
+                                                    //Check if the coordinates are legal and in the ROI.
+                                                    if( !isininc(0,lrow,img_it->rows-1) || !isininc(0,lcol,img_it->columns-1) ) continue;
+    
+                                                    //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
+                                                    //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
+                                                    const auto neighbourpoint = img.position(lrow,lcol);
+                                                    auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
+                                                    if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
+                                                                                                                    ProjectedNeighbourPoint,
+                                                                                                                    AlreadyProjected)) continue;
+                                                    const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
+                                                    in_pixs.push_back(val);
+                                                }
+                                            }
+                                            if(in_pixs.size() < min_datum) continue; //If contours are too narrow so that there is too few datum for meaningful results.
+                                            const auto combined_val = Stats::Sum(in_pixs);
+                                            combined_voxel_intensity += combined_val;
+                                        }
+    
+                                        // --------------- Incorporate the data into the user_data struct ------------------
+                                        result.sketches[ ROIName.value() ].digest(combined_voxel_intensity);
+                                        if(user_data_s->retain_voxels){
+                                            result.voxels[ ROIName.value() ].emplace_back(combined_voxel_intensity);
                                         }
-                                    }
-                                    if(in_pixs.size() < min_datum) continue; //If contours are too narrow so that there is too few datum for meaningful results.
-                                    const auto combined_val = Stats::Sum(in_pixs);
-                                    combined_voxel_intensity += combined_val;
-                                }
-        
-                                // --------------- Incorporate the data into the user_data struct ------------------
-                                user_data_s->accumulated_voxels[ ROIName.value() ].emplace_back(combined_voxel_intensity);
-        
-                                // ----------------------------------------------------------------------------
-        
-                            }//Loop over channels.
-        
-                        //If we're in the bounding box but not the ROI, do something.
-                        }else{
-                            //for(auto chan = 0; chan < first_img_it->channels; ++chan){
-                            //    const auto curr_val = working.value(row, col, chan);
-                            //    if(curr_val != 0) FUNCERR("There are overlapping ROI bboxes. This code currently cannot handle this. "
-                            //                              "You will need to run the functor individually on the overlapping ROIs.");
-                            //    working.reference(row, col, chan) = static_cast<float>(10);
-                            //}
-                        } // If is in ROI or ROI bbox.
-                    } //Loop over cols
-                } //Loop over rows
-            } //Loop over ROIs.
-        } //Loop over contour_collections.
+    
+                                        // ----------------------------------------------------------------------------
+    
+                                    }//Loop over channels.
+    
+                                //If we're in the bounding box but not the ROI, do something.
+                                }else{
+                                    //for(auto chan = 0; chan < first_img_it->channels; ++chan){
+                                    //    const auto curr_val = working.value(row, col, chan);
+                                    //    if(curr_val != 0) FUNCERR("There are overlapping ROI bboxes. This code currently cannot handle this. "
+                                    //                              "You will need to run the functor individually on the overlapping ROIs.");
+                                    //    working.reference(row, col, chan) = static_cast<float>(10);
+                                    //}
+                                } // If is in ROI or ROI bbox.
+                            } //Loop over cols
+                        } //Loop over rows
+                    } //Loop over ROIs.
+                } //Loop over contour_collections.
+            }); // thread pool task closure.
+        }
+        tg.wait();
+    }
 
+    for(auto &result : results){
+        if(!result.ok) return false;
+        for(auto &v : result.voxels){
+            auto &dest = user_data_s->accumulated_voxels[v.first];
+            dest.insert(std::end(dest), std::begin(v.second), std::end(v.second));
+            v.second = std::vector<double>();
+        }
+        for(const auto &k : result.sketches){
+            user_data_s->sketches[k.first].merge(k.second);
+        }
     }
 
     return true;
 }
 
+
+
+void Accumulate_Clipped_Pixel_Distributions(planar_image_collection<float,double> &imagecoll,
+                                            const std::vector<half_space_clipped_roi> &rois,
+                                            AccumulatePixelDistributionsUserData &ud){
+    Mutate_Voxels_Opts opts;
+    opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
+    opts.aggregate      = Mutate_Voxels_Opts::Aggregate::First;
+    opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+    opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
+    opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+    opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
+
+    // Group spatially overlapping images, which will be summed.
+    auto all_images = imagecoll.get_all_images();
+    std::vector<std::list<planar_image_collection<float,double>::images_list_it_t>> groups;
+    while(!all_images.empty()){
+        auto curr_img_it = all_images.front();
+        auto selected_imgs = GroupSpatiallyOverlappingImages(curr_img_it, std::ref(imagecoll));
+        if(selected_imgs.empty()){
+            throw std::logic_error("No spatially-overlapping images found. There should be at least one"
+                                   " image (the 'seed' image) which should match. Verify the spatial"
+                                   " overlap grouping routine.");
+        }
+        for(const auto &an_img_it : selected_imgs){
+            if( (curr_img_it->rows     != an_img_it->rows)
+            ||  (curr_img_it->columns  != an_img_it->columns)
+            ||  (curr_img_it->channels != an_img_it->channels) ){
+                throw std::domain_error("Images have differing number of rows, columns, or channels."
+                                        " This is not currently supported -- though it could be if needed."
+                                        " Are you sure you've got the correct data?");
+            }
+        }
+        for(auto &an_img_it : selected_imgs){
+            all_images.remove(an_img_it);
+        }
+        groups.emplace_back(selected_imgs);
+    }
+
+    // As above, each group accumulates into its own storage and the results are merged in order afterward.
+    struct group_result_t {
+        std::map<std::string, std::vector<double>> voxels;
+        std::map<std::string, distribution_sketch> sketches;
+    };
+    std::vector<group_result_t> results(groups.size());
+    parallel_for(0, static_cast<long int>(groups.size()), [&](long int g) -> void {
+        const auto &imgs = groups[g];
+        const auto &img = *(imgs.front());
+        auto &result = results[g];
+
+        std::vector<std::shared_ptr<const voxel_inclusion_mask>> masks;
+        masks.reserve(rois.size());
+        for(const auto &roi : rois) masks.emplace_back( Get_Voxel_Inclusion_Mask(img, roi.ccsl, opts) );
+
+        // Every region is visited while each row of the images is traversed.
+        for(long int row = 0; row < img.rows; ++row){
+            for(size_t i = 0; i < rois.size(); ++i){
+                const auto &mask = *(masks[i]);
+                const auto &half_spaces = rois[i].half_spaces;
+                for(auto r = mask.row_offsets[row]; r < mask.row_offsets[row + 1]; ++r){
+                    const auto run_end = static_cast<long int>(mask.runs[r][1]);
+                    for(auto col = static_cast<long int>(mask.runs[r][0]); col < run_end; ++col){
+                        const auto pos = img.position(row, col);
+                        const bool within = std::all_of(std::begin(half_spaces), std::end(half_spaces),
+                                                        [&](const plane<double> &P){
+                                                            return (0.0 <= P.Get_Signed_Distance_To_Point(pos));
+                                                        });
+                        if(!within) continue;
+
+                        for(long int chan = 0; chan < img.channels; ++chan){
+                            double combined_voxel_intensity = 0.0;
+                            for(const auto &img_it : imgs){
+                                combined_voxel_intensity += static_cast<double>(img_it->value(row, col, chan));
+                            }
+                            result.sketches[ rois[i].name ].digest(combined_voxel_intensity);
+                            if(ud.retain_voxels){
+                                result.voxels[ rois[i].name ].emplace_back(combined_voxel_intensity);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }, 1);
+
+    for(auto &result : results){
+        for(auto &v : result.voxels){
+            auto &dest = ud.accumulated_voxels[v.first];
+            dest.insert(std::end(dest), std::begin(v.second), std::end(v.second));
+            v.second = std::vector<double>();
+        }
+        for(const auto &k : result.sketches){
+            ud.sketches[k.first].merge(k.second);
+        }
+    }
+    return;
+}
@@ -8,13 +8,20 @@
 #include <string>
 #include <vector>
 
+#include "YgorMath.h"
+
+#include "../../Distribution_Sketch.h"
 
 template <class T, class R> class planar_image_collection;
-template <class T> class contour_collection;
 
 
 struct AccumulatePixelDistributionsUserData {
-    std::map<std::string, std::vector<double>> accumulated_voxels; // key: RawROIName.
+    // Whether to retain every voxel value. Summaries are always produced, so this can be disabled when only summary
+    // statistics or percentiles are needed, which bounds memory usage for large volumes.
+    bool retain_voxels = true;
+
+    std::map<std::string, std::vector<double>> accumulated_voxels; // key: RawROIName. Empty unless retain_voxels.
+    std::map<std::string, distribution_sketch> sketches; // key: RawROIName.
 };
 
 bool AccumulatePixelDistributions(planar_image_collection<float,double> &,
@@ -22,3 +29,20 @@ bool AccumulatePixelDistributions(planar_image_collection<float,double> &,
                           std::list<std::reference_wrapper<contour_collection<double>>>,
                           std::any ud );
 
+
+
+// A region of interest clipped to the intersection of half-spaces. Voxels belong to the region when their centres are
+// bounded by the contours and lie on or above every plane, i.e., on the side each plane's normal points toward.
+struct half_space_clipped_roi {
+    std::string name; // Used as the key when accumulating.
+    std::list<std::reference_wrapper<contour_collection<double>>> ccsl;
+    std::vector<plane<double>> half_spaces;
+};
+
+// Accumulates voxel intensities within each clipped region, like AccumulatePixelDistributions, without clipping any
+// contours. Each region's contours are rasterized once per image using the cached voxel inclusion masks (overlapping
+// contours are counted once), the bounded voxel centres are tested against the planes, and all regions are accumulated
+// in a single pass over the images. Spatially overlapping images are summed. Regions may share a name.
+void Accumulate_Clipped_Pixel_Distributions(planar_image_collection<float,double> &imagecoll,
+                                            const std::vector<half_space_clipped_roi> &rois,
+                                            AccumulatePixelDistributionsUserData &ud);
@@ -6,6 +6,8 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <algorithm>
 #include <random>
 #include <ostream>
@@ -14,6 +16,8 @@
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
+#include "../Gamma_Index_Search.h"
+#include "../Rectilinear_Volume.h"
 #include "Compare_Images.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -42,7 +46,11 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
     // It was proposed by Low et al. in 1998 (doi:10.1118/1.598248). Gamma analyses permits trade-offs between spatial
     // and dosimetric discrepancies which can arise when the image arrays slightly differ in alignment or pixel values.
     //
-    // The reference image array must be rectilinear.
+    // The gamma index can alternatively be computed by searching the reference neighbourhood directly for the minimum
+    // of the Low et al. gamma function, visiting a precomputed table of offsets sorted by distance. This is typically
+    // much faster than the wavefront search, and permits supersampling the reference images.
+    //
+    // The reference image array must be rectilinear (and regular if the gamma search is used).
     // For the fastest and most accurate results, test and reference image arrays should exactly align. However, it is not
     // necessary. Ii test and reference image arrays are aligned, image adjacency is precomputed. Otherwise image
     // adjacency is evaluated for every voxel.
@@ -100,6 +108,7 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
     }
 
     // Determine how discrepancy should be estimated.
+    double pinned_max_val = std::numeric_limits<double>::quiet_NaN();
     std::function< double (const double &, const double &) > estimate_discrepancy;
     if(user_data_s->discrepancy_type == ComputeCompareImagesUserData::DiscrepancyType::Relative){
         estimate_discrepancy = relative_diff;
@@ -122,6 +131,7 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
         // ...
 
         const auto max_val = rmm.Current_Max();
+        pinned_max_val = max_val;
         FUNCINFO("Maximum intensity found: " << max_val);
         estimate_discrepancy = [max_val](const double &A, const double &B) -> double {
             return std::abs( (A - B) / max_val );
@@ -131,6 +141,47 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
         throw std::invalid_argument("Unknown discrepancy method requested. Cannot continue.");
     }
 
+    // Prepare the distance-sorted gamma search, if needed.
+    std::unique_ptr<rectilinear_volume> ref_vol;
+    std::unique_ptr<gamma_index_search> gamma_search;
+    if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndexSearch){
+        const auto &first_ref_img = external_imgs.front().get().images.front();
+        planar_image_adjacency<float,double> ref_adj( {}, external_imgs, first_ref_img.image_plane().N_0.unit() );
+
+        std::list<std::reference_wrapper<planar_image<float,double>>> ordered_imgs;
+        for(long int i = 0; ref_adj.index_present(i); ++i){
+            ordered_imgs.push_back( ref_adj.index_to_image(i) );
+        }
+
+        try{
+            ref_vol = std::make_unique<rectilinear_volume>(ordered_imgs);
+
+            gamma_index_search::parameters gp;
+            gp.channel             = ud_channel;
+            gp.DTA_threshold       = user_data_s->gamma_DTA_threshold;
+            gp.Dis_threshold       = user_data_s->gamma_Dis_threshold;
+            gp.DTA_max             = user_data_s->DTA_max;
+            gp.supersample         = user_data_s->gamma_supersample;
+            gp.tolerance           = user_data_s->gamma_tolerance;
+            gp.terminate_above_one = user_data_s->gamma_terminate_when_max_exceeded;
+            gp.ref_lower_threshold = user_data_s->ref_img_inc_lower_threshold;
+            gp.ref_upper_threshold = user_data_s->ref_img_inc_upper_threshold;
+            if(user_data_s->discrepancy_type == ComputeCompareImagesUserData::DiscrepancyType::Relative){
+                gp.discrepancy = gamma_index_search::discrepancy_t::Relative;
+            }else if(user_data_s->discrepancy_type == ComputeCompareImagesUserData::DiscrepancyType::Difference){
+                gp.discrepancy = gamma_index_search::discrepancy_t::Difference;
+            }else{
+                gp.discrepancy = gamma_index_search::discrepancy_t::PinnedToMax;
+                gp.pinned_max = pinned_max_val;
+            }
+            gamma_search = std::make_unique<gamma_index_search>(*ref_vol, gp);
+        }catch(const std::exception &e){
+            FUNCWARN("Unable to prepare gamma search: " << e.what() << ". Cannot continue");
+            return false;
+        }
+        FUNCINFO("Gamma search table contains " << gamma_search->table_size() << " offsets");
+    }
+
     Mutate_Voxels_Opts mv_opts;
     mv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
     mv_opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
@@ -142,15 +193,74 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
 
     std::mutex passing_counter; // Used to tally the gamma passing rate.
 
-    asio_thread_pool tp;
-    std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
-    long int completed = 0;
     const long int img_count = imagecoll.images.size();
+    progress_tracker progress("image comparison", img_count,
+                              [](long int completed, long int total, double) -> void {
+        FUNCINFO("Completed " << completed << " of " << total
+              << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+    });
+    task_group tg;
+
+    if(gamma_search != nullptr){
+        for(auto &img : imagecoll.images){
+            std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
+
+            tg.run([&,img_refw]() -> void {
+                long int l_count = 0;
+                long int l_passed = 0;
+                auto f_search = [&,img_refw](long int E_row, long int E_col, long int channel,
+                                              std::reference_wrapper<planar_image<float,double>> /*img_refw*/,
+                                              float &voxel_val) {
+                    if( !isininc( user_data_s->inc_lower_threshold, voxel_val, user_data_s->inc_upper_threshold) ){
+                        return; // No-op if outside of the thresholds.
+                    }
+                    if( channel != ud_channel){
+                        return; // No-op if this is the wrong channel.
+                    }
+
+                    const auto pos = img_refw.get().position(E_row, E_col);
+                    double gamma = std::numeric_limits<double>::quiet_NaN();
+                    const auto outcome = gamma_search->evaluate(pos, static_cast<double>(voxel_val), gamma);
+                    if(outcome == gamma_index_search::outcome_t::Unavailable){
+                        voxel_val = inaccessible_val; // Cannot assess this voxel.
+                        return;
+                    }
+
+                    ++l_count;
+                    if(outcome == gamma_index_search::outcome_t::Terminated){
+                        voxel_val = user_data_s->gamma_terminated_early;
+                        return;
+                    }
+                    voxel_val = gamma;
+                    if(gamma < 1.0) ++l_passed;
+                    return;
+                };
+
+                Mutate_Voxels<float,double>( img_refw,
+                                             { img_refw },
+                                             ccsl, 
+                                             mv_opts, 
+                                             f_search );
+                {
+                    std::lock_guard<std::mutex> lock(passing_counter);
+                    user_data_s->count += l_count;
+                    user_data_s->passed += l_passed;
+                }
+                UpdateImageDescription( img_refw, "Compared (gamma-index)" );
+                UpdateImageWindowCentreWidth( img_refw );
+
+                //Report operation progress.
+                progress.advance();
+            }); // thread pool task closure.
+        }
+        tg.wait();
+        return true;
+    }
 
     for(auto &img : imagecoll.images){
         std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
 
-        tp.submit_task([&,img_refw]() -> void {
+        tg.run([&,img_refw]() -> void {
             const auto orientation_normal = img_refw.get().image_plane().N_0.unit();
 
             planar_image_adjacency<float,double> img_adj( {}, external_imgs, orientation_normal );
@@ -626,15 +736,11 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
             UpdateImageWindowCentreWidth( img_refw );
 
             //Report operation progress.
-            {
-                std::lock_guard<std::mutex> lock(saver_printer);
-                ++completed;
-                FUNCINFO("Completed " << completed << " of " << img_count
-                      << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-            }
+            progress.advance();
         }); // thread pool task closure.
 
     }
+    tg.wait();
 
 
     return true;
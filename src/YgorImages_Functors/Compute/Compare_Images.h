@@ -27,6 +27,8 @@ struct ComputeCompareImagesUserData {
         DTA,             // Distance-to-agreement (i.e., search neighbourhood until agreement is found).
         Discrepancy,     // Discrepancy (i.e., value comparison from voxel to nearest reference voxel only).
         GammaIndex,      // Gamma index -- a blend of DTA and discrepancy comparisons. 
+        GammaIndexSearch,// Gamma index, computed by directly minimizing the gamma function over a distance-sorted
+                         // table of neighbourhood offsets. Usually much faster. Requires a regular reference grid.
     } comparison_method = ComparisonMethod::GammaIndex;
 
 
@@ -132,6 +134,16 @@ struct ComputeCompareImagesUserData {
     double gamma_terminate_when_max_exceeded = true;
     double gamma_terminated_early = std::nextafter(1.0, std::numeric_limits<double>::infinity());
 
+    // Parameters specific to the GammaIndexSearch method.
+    //
+    // The reference images can be supersampled (via trilinear interpolation) to reduce the spatial discretization
+    // error. This factor specifies the number of samples per voxel along each axis; the cost grows with its cube.
+    long int gamma_supersample = 1;
+
+    // The search is halted once the reported gamma index is known to be within this tolerance of the true minimum.
+    // A tolerance of zero evaluates the minimum exactly (i.e., to within the sampling resolution).
+    double gamma_tolerance = 0.0;
+
     // Outgoing gamma passing counts.
     //
     // These can be read by the caller after performing a gamma analysis.
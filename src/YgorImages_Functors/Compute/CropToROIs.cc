@@ -1,20 +1,62 @@
 //CropToROIs.cc.
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <exception>
 #include <any>
 #include <functional>
+#include <iterator>
 #include <limits>
 #include <list>
 #include <map>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include "CropToROIs.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
 #include "YgorMisc.h"
 
+#include "../../Thread_Pool.h"
+
+
+namespace {
+
+// Copies the window starting at (row_min, col_min) into the destination image, one row span at a time when the
+// column and channel elements of a row are contiguous in both images.
+void copy_window(const planar_image<float,double> &src, long int row_min, long int col_min,
+                 planar_image<float,double> &dst){
+    if( (dst.rows < 1) || (dst.columns < 1) || (dst.channels < 1) ) return;
+
+    const auto span = dst.columns * dst.channels;
+    const auto is_contiguous = [&](const planar_image<float,double> &img, long int row, long int col) -> bool {
+        const auto base = img.index(row, col, 0);
+        return ( (dst.columns < 2) || ((img.index(row, col + 1, 0) - base) == img.channels) )
+            && ( (dst.channels < 2) || ((img.index(row, col, 1) - base) == 1) );
+    };
+
+    if(is_contiguous(src, row_min, col_min) && is_contiguous(dst, 0, 0)){
+        for(long int i = 0; i < dst.rows; ++i){
+            const auto from = std::next(std::begin(src.data), src.index(row_min + i, col_min, 0));
+            std::copy(from, std::next(from, span), std::next(std::begin(dst.data), dst.index(i, 0, 0)));
+        }
+    }else{
+        for(long int i = 0; i < dst.rows; ++i){
+            for(long int j = 0; j < dst.columns; ++j){
+                for(long int c = 0; c < dst.channels; ++c){
+                    dst.reference(i, j, c) = src.value(row_min + i, col_min + j, c);
+                }
+            }
+        }
+    }
+    return;
+}
+
+} // namespace
+
 
 bool ComputeCropToROIs(planar_image_collection<float,double> &imagecoll,
                           std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
@@ -78,23 +120,37 @@ bool ComputeCropToROIs(planar_image_collection<float,double> &imagecoll,
     const plane<double> GridYZeroPlane(GridY, zero);
     const plane<double> GridZZeroPlane(GridZ, zero);
 
+    //The bounds are reduced over contours in parallel, since large ROIs (e.g., body outlines) can have many vertices.
+    std::vector<std::reference_wrapper<const contour_of_points<double>>> cops;
     for(const auto &cc_ref : ccsl){
-        for(const auto &cop : cc_ref.get().contours){
-            for(const auto &v : cop.points){
-                //Compute the distance to each plane.
-                const auto distX = GridXZeroPlane.Get_Signed_Distance_To_Point(v);
-                const auto distY = GridYZeroPlane.Get_Signed_Distance_To_Point(v);
-                const auto distZ = GridZZeroPlane.Get_Signed_Distance_To_Point(v);
-                
-                //Score the minimum and maximum distances.
-                if(!std::isfinite(grid_x_min) || (distX < grid_x_min)) grid_x_min = distX;
-                if(!std::isfinite(grid_x_max) || (distX > grid_x_max)) grid_x_max = distX;
-                if(!std::isfinite(grid_y_min) || (distY < grid_y_min)) grid_y_min = distY;
-                if(!std::isfinite(grid_y_max) || (distY > grid_y_max)) grid_y_max = distY;
-                if(!std::isfinite(grid_z_min) || (distZ < grid_z_min)) grid_z_min = distZ;
-                if(!std::isfinite(grid_z_max) || (distZ > grid_z_max)) grid_z_max = distZ;
-            }
+        for(const auto &cop : cc_ref.get().contours) cops.emplace_back( std::cref(cop) );
+    }
+    std::vector<std::array<double, 6>> cop_bounds(cops.size());
+    parallel_for(0, static_cast<long int>(cops.size()), [&](long int i){
+        auto &b = cop_bounds[i];
+        b.fill( std::numeric_limits<double>::quiet_NaN() );
+        for(const auto &v : cops[i].get().points){
+            //Compute the distance to each plane.
+            const auto distX = GridXZeroPlane.Get_Signed_Distance_To_Point(v);
+            const auto distY = GridYZeroPlane.Get_Signed_Distance_To_Point(v);
+            const auto distZ = GridZZeroPlane.Get_Signed_Distance_To_Point(v);
+
+            //Score the minimum and maximum distances.
+            if(!std::isfinite(b[0]) || (distX < b[0])) b[0] = distX;
+            if(!std::isfinite(b[1]) || (distX > b[1])) b[1] = distX;
+            if(!std::isfinite(b[2]) || (distY < b[2])) b[2] = distY;
+            if(!std::isfinite(b[3]) || (distY > b[3])) b[3] = distY;
+            if(!std::isfinite(b[4]) || (distZ < b[4])) b[4] = distZ;
+            if(!std::isfinite(b[5]) || (distZ > b[5])) b[5] = distZ;
         }
+    });
+    for(const auto &b : cop_bounds){
+        if(!std::isfinite(grid_x_min) || (b[0] < grid_x_min)) grid_x_min = b[0];
+        if(!std::isfinite(grid_x_max) || (b[1] > grid_x_max)) grid_x_max = b[1];
+        if(!std::isfinite(grid_y_min) || (b[2] < grid_y_min)) grid_y_min = b[2];
+        if(!std::isfinite(grid_y_max) || (b[3] > grid_y_max)) grid_y_max = b[3];
+        if(!std::isfinite(grid_z_min) || (b[4] < grid_z_min)) grid_z_min = b[4];
+        if(!std::isfinite(grid_z_max) || (b[5] > grid_z_max)) grid_z_max = b[5];
     }
 
     //Add margins.
@@ -113,26 +169,29 @@ bool ComputeCropToROIs(planar_image_collection<float,double> &imagecoll,
     const auto ort_min_plane = plane<double>(GridZ, zero + (GridZ * grid_z_min));
     const auto ort_max_plane = plane<double>(GridZ, zero + (GridZ * grid_z_max));
 
-    //Cycle over images.
-    auto img_it = imagecoll.images.begin();
-    while(img_it != imagecoll.images.end()){
-
-        //Check if there enough dimensions to perform the check.
-        if( (img_it->rows < 1) || (img_it->columns < 1) ){
+    //Check if there enough dimensions to perform the check.
+    for(const auto &img : imagecoll.images){
+        if( (img.rows < 1) || (img.columns < 1) ){
             throw std::runtime_error("Asked to crop image with no spatial extent. Crop or keep? Cannot continue.");
         }
+    }
+
+    //Cycle over images. Each image is cropped independently, and images are only removed afterward so the list is not
+    // modified concurrently.
+    std::vector<decltype(imagecoll.images.begin())> img_its;
+    for(auto img_it = imagecoll.images.begin(); img_it != imagecoll.images.end(); ++img_it){
+        img_its.push_back(img_it);
+    }
+    std::vector<uint8_t> trim(img_its.size(), 0);
+    parallel_for(0, static_cast<long int>(img_its.size()), [&](long int n){
+        auto img_it = img_its[n];
 
         //Check if all corners are within the z-planes. If any are not, the image can be trimmed.
-        {
-            bool SkipToNext = false;
-            for(const auto &p : img_it->corners2D()){
-                if( ort_min_plane.Is_Point_Above_Plane(p) == ort_max_plane.Is_Point_Above_Plane(p) ){
-                    img_it = imagecoll.images.erase(img_it);
-                    SkipToNext = true;
-                    break;
-                }
+        for(const auto &p : img_it->corners2D()){
+            if( ort_min_plane.Is_Point_Above_Plane(p) == ort_max_plane.Is_Point_Above_Plane(p) ){
+                trim[n] = 1;
+                return;
             }
-            if(SkipToNext) continue;
         }
 
         //Scan inward, assuming row_unit and col_unit align with GridX and GridY. Stop when we first pass out of the
@@ -172,16 +231,13 @@ bool ComputeCropToROIs(planar_image_collection<float,double> &imagecoll,
                                   img_it->anchor, ( img_it->position(row_min, col_min) - img_it->anchor ) );
         replacement.init_orientation( img_it->row_unit, img_it->col_unit );
         replacement.metadata = img_it->metadata;
-                                  
-        for(long int i = 0; i < (row_max - row_min); ++i){
-            for(long int j = 0; j < (col_max - col_min); ++j){
-                for(long int c = 0; c < img_it->channels; ++c){
-                    replacement.reference(i, j, c) = img_it->value(row_min + i, col_min + j, c);
-                }
-            }
-        }
-        *img_it = replacement;
-        ++img_it;
+
+        copy_window(*img_it, row_min, col_min, replacement);
+        *img_it = std::move(replacement);
+    });
+
+    for(size_t n = 0; n < img_its.size(); ++n){
+        if(trim[n] != 0) imagecoll.images.erase(img_its[n]);
     }
     
     return true;
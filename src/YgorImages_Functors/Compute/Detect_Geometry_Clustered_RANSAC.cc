@@ -10,7 +10,9 @@
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <vector>
 
+#include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
 #include "Detect_Geometry_Clustered_RANSAC.h"
@@ -103,7 +105,7 @@ bool ComputeDetectGeometryClusteredRANSAC(planar_image_collection<float,double>
         //typedef boost::geometry::model::box<CDat_t> Box_t;
         typedef boost::geometry::index::rtree<CDat_t,RTreeParameter_t> RTree_t;
 
-        RTree_t rtree;
+        std::vector<CDat_t> cdats;
 
         long int BeforeCount = 0;
         for(auto & img_it : selected_imgs){
@@ -115,8 +117,8 @@ bool ComputeDetectGeometryClusteredRANSAC(planar_image_collection<float,double>
                             const auto p = img_it->position(row,col);
                             const auto index = img_it->index(row,col,chan);
 
-                            rtree.insert(CDat_t({ p.x, p.y, p.z }, {}, 
-                                                std::make_pair(&(*img_it), index) ));
+                            cdats.push_back(CDat_t({ p.x, p.y, p.z }, {}, 
+                                                 std::make_pair(&(*img_it), index) ));
                             ++BeforeCount;
                         }
                     }//Loop over channels.
@@ -125,6 +127,10 @@ bool ComputeDetectGeometryClusteredRANSAC(planar_image_collection<float,double>
         } // Loop over images.
         FUNCINFO("Number of voxels being clustered: " << BeforeCount);
 
+        // Bulk-load the tree using the packing algorithm, which is much faster than inserting one-by-one.
+        RTree_t rtree(std::begin(cdats), std::end(cdats));
+        cdats = std::vector<CDat_t>();
+
         //const size_t MinPts = 6; // 2 * dimensionality.
         const size_t MinPts = 6; // 2 * dimensionality.
         const double Eps = 4.0; // DICOM units (mm).
@@ -181,13 +187,30 @@ bool ComputeDetectGeometryClusteredRANSAC(planar_image_collection<float,double>
 
 
         // ----- Fit the clusters -----
+        //
+        // Clusters are fitted independently and concurrently. Results are reported afterward in cluster order.
+        struct cluster_fit_t {
+            uint32_t cluster_id = 0;
+            const std::vector<CDat_t> *cdats = nullptr;
+            bool failed = false;
+            std::optional<sphere<double>> asphere;
+            std::optional<plane<double>> aplane;
+        };
+        std::vector<cluster_fit_t> fits;
+        fits.reserve(Segregated.size());
         for(const auto &cluster_p : Segregated){
-            const auto ClusterID = cluster_p.first;
+            fits.emplace_back();
+            fits.back().cluster_id = cluster_p.first;
+            fits.back().cdats = &(cluster_p.second);
+        }
+
+        parallel_for(0, static_cast<long int>(fits.size()), [&](long int i){
+            auto &f = fits[i];
 
             std::vector<vec3<double>> positions;
-            positions.reserve( cluster_p.second.size() );
+            positions.reserve( f.cdats->size() );
 
-            for(const auto &cdat : cluster_p.second){
+            for(const auto &cdat : *(f.cdats)){
                 const auto img_ptr = cdat.UserData.first;
                 const auto index = cdat.UserData.second;
 
@@ -226,19 +249,29 @@ bool ComputeDetectGeometryClusteredRANSAC(planar_image_collection<float,double>
                     }
 
                     // Fit a sphere.
-                    const auto asphere = Sphere_Orthogonal_Regression( sampled, max_iters, centre_stopping_tol, radius_stopping_tol );
-                    FUNCINFO("The fitted sphere for cluster " << ClusterID << " has"
-                          << " centre = " << asphere.C_0 << " and radius = " << asphere.r_0);
-
-
-                    const auto aplane = Plane_Orthogonal_Regression( sampled );
-                    FUNCINFO("The fitted plane for cluster " << ClusterID << " has"
-                          << " anchor = " << aplane.R_0 << " and normal = " << aplane.N_0);
+                    f.asphere = Sphere_Orthogonal_Regression( sampled, max_iters, centre_stopping_tol, radius_stopping_tol );
+                    f.aplane = Plane_Orthogonal_Regression( sampled );
 
-                }catch(const std::exception &e){
-                    FUNCWARN("Fitting of cluster " << ClusterID << " failed to converge. Ignoring it");
+                }catch(const std::exception &){
+                    f.failed = true;
                 };
             }
+        }, 1);
+
+        for(const auto &f : fits){
+            const auto ClusterID = f.cluster_id;
+            if(f.failed){
+                FUNCWARN("Fitting of cluster " << ClusterID << " failed to converge. Ignoring it");
+                continue;
+            }
+            if(f.asphere){
+                FUNCINFO("The fitted sphere for cluster " << ClusterID << " has"
+                      << " centre = " << f.asphere->C_0 << " and radius = " << f.asphere->r_0);
+            }
+            if(f.aplane){
+                FUNCINFO("The fitted plane for cluster " << ClusterID << " has"
+                      << " anchor = " << f.aplane->R_0 << " and normal = " << f.aplane->N_0);
+            }
         }
 
 
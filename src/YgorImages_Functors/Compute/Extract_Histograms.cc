@@ -10,10 +10,13 @@
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <vector>
 
+#include "../../Distribution_Sketch.h"
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
+#include "../Voxel_Inclusion_Mask.h"
 #include "Extract_Histograms.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -35,7 +38,8 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
     // Note: Non-finite voxels are excluded from analysis and do not contribute to the volume. If absolute volume is
     //       required, ensure all voxels are finite prior to invoking this routine.
     //
-    // Note: This routine will consume a lot of memory if the resolution is too fine.
+    // Note: This routine will consume a lot of memory if the resolution is too fine. Each worker accumulates into
+    //       its own copy of the histograms, which are merged afterward.
     //
     // Note: The image collection and contour collections will not be altered.
     //
@@ -106,15 +110,18 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
                        voxel_extrema;
 
     { // Scope for thread pool.
-        asio_thread_pool tp;
-        std::mutex saver;
-        std::mutex printer;
-        long int completed = 0;
         const long int img_count = imagecoll.images.size();
+        progress_tracker progress("histogram extrema", img_count,
+                                  [](long int completed, long int total, double) -> void {
+            FUNCINFO("Completed " << completed << " of " << total
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+        });
+        task_group tg;
+        std::mutex saver;
 
         for(auto &img : imagecoll.images){
             std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
-            tp.submit_task([&,img_refw]() -> void {
+            tg.run([&,img_refw]() -> void {
 
                 // Cycle over all the alike-named contour collections.
                 for(auto & named_ccsl : named_ccsls){
@@ -136,11 +143,11 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
                         return;
                     };
 
-                    Mutate_Voxels<float,double>( img_refw,
-                                                 { img_refw },
-                                                 named_ccsl.second, 
-                                                 user_data_s->mutation_opts, 
-                                                 f_bounded );
+                    // Both passes share the cached rasterization of the contours.
+                    Mutate_Bounded_Voxels( img_refw,
+                                           named_ccsl.second,
+                                           user_data_s->mutation_opts,
+                                           f_bounded );
 
                     // Merge the results.
                     if( std::isfinite(local_minimum) 
@@ -158,24 +165,23 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
                 } // Loop over all named ccs.
 
                 //Report operation progress.
-                {
-                    std::lock_guard<std::mutex> lock(printer);
-                    ++completed;
-                    FUNCINFO("Completed " << completed << " of " << img_count
-                          << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-                }
+                progress.advance();
 
             }); // thread pool task closure.
         } // Loop over all images.
+        tg.wait();
     }
 
 
-    // Allocate storage for each logical partition.
+    // Determine the bin layout for each logical partition.
     std::map<std::string, size_t> bin_counts;
     std::map<std::string, double> bin_widths;
-    std::map<std::string,                        // ROIName.
-             std::vector<std::array<double,4>>>  // Differential histogram with implicit bin numbering (min to max).
+    std::map<std::string,               // ROIName.
+             fixed_bin_histogram>       // Differential histogram with implicit bin numbering (min to max).
                  raw_diff_histograms;
+    std::map<std::string,               // ROIName.
+             distribution_sketch>       // Volume-weighted quantile estimates.
+                 sketches;
     std::set<std::string> to_purge; // Groups to purge because they are invalid.
     for(const auto &extrema : voxel_extrema){
         const auto key = extrema.first;
@@ -194,62 +200,51 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
         const auto bin_count = static_cast<size_t>(std::ceil( count_f ));
         const auto bin_width = range / static_cast<double>(bin_count);
 
-        // Prepare the histograms bins.
-        //
-        // Note: bin values are centred.
-        std::vector<std::array<double,4>> hist(bin_count, {0.0, 0.0, 0.0, 0.0} );
-        for(size_t i = 0; i < bin_count; ++i){
-            hist[i][0] = voxel_min 
-                       + (bin_width * static_cast<double>(i)) 
-                       + (bin_width * 0.5);
-        }
-
         bin_counts.emplace(key, bin_count);
         bin_widths.emplace(key, bin_width);
-        raw_diff_histograms.emplace(key, hist);
+        raw_diff_histograms.emplace(key, fixed_bin_histogram(voxel_min, bin_width, bin_count));
+        sketches.emplace(key, distribution_sketch());
     }
     for(const auto &key : to_purge) voxel_extrema.extract(key);
 
 
     // Visit all voxels to build the histograms.
+    //
+    // Images are divided into contiguous blocks that accumulate into their own histograms, which avoids contention.
+    // The blocks do not depend on the number of threads and are merged in a fixed order, so the (volume-weighted) bin
+    // sums are reproducible.
     {
-        asio_thread_pool tp;
-        std::mutex saver;
-        std::mutex printer;
-        long int completed = 0;
-        const long int img_count = imagecoll.images.size();
-
-        for(auto &img : imagecoll.images){
-            std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
-            tp.submit_task([&,img_refw]() -> void {
-
+        std::vector<std::reference_wrapper<planar_image<float,double>>> imgs;
+        for(auto &img : imagecoll.images) imgs.emplace_back( std::ref(img) );
+
+        const long int img_count = imgs.size();
+        progress_tracker progress("histogram binning", img_count,
+                                  [](long int completed, long int total, double) -> void {
+            FUNCINFO("Completed " << completed << " of " << total
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+        });
+
+        // Block-specific histograms are only allocated for the groups the block's images intersect.
+        struct block_result_t {
+            std::map<std::string, fixed_bin_histogram> hists;
+            std::map<std::string, distribution_sketch> sketches;
+        };
+        auto merged = parallel_reduce(0L, img_count, block_result_t(),
+                                      [&](long int img_begin, long int img_end) -> block_result_t {
+            block_result_t out;
+            for(auto i = img_begin; i < img_end; ++i){
+                auto img_refw = imgs[i];
                 const auto pxl_dx = img_refw.get().pxl_dx;
                 const auto pxl_dy = img_refw.get().pxl_dy;
                 const auto pxl_dz = img_refw.get().pxl_dz;
                 const auto pxl_vol = pxl_dx * pxl_dy * pxl_dz;
 
-                std::vector<size_t> shuttle;  // Thread-specific storage buffer.
-                const size_t N_shuttle = 1000; // Size of buffer.
-                shuttle.reserve(N_shuttle);
-
                 for(auto & named_ccsl : named_ccsls){
                     const auto key = named_ccsl.first;
                     if(bin_counts.count(key) != 1) continue; // Group did not enclose any voxels.
 
-                    const auto bin_count = bin_counts.at(key);
-                    const auto bin_width = bin_widths.at(key);
-                    const auto voxel_min = voxel_extrema.at(key).first;
-                    //const auto voxel_max = voxel_extrema.at(key).second;
-                    std::vector<std::array<double,4>> &raw_diff_hist(raw_diff_histograms.at(key));
-
-                    // Sub-routine to add all counts from the buffer and then reset the buffer.
-                    const auto add_counts = [&]() -> void {
-                        std::lock_guard<std::mutex> lock(saver);
-                        for(const auto &bin_N : shuttle) raw_diff_hist[bin_N][2] += pxl_vol;
-                        shuttle.clear();
-                        shuttle.reserve(N_shuttle);
-                        return;
-                    };
+                    fixed_bin_histogram *hist = nullptr;
+                    distribution_sketch *sketch = nullptr;
 
                     auto f_bounded = [&](long int /*E_row*/, 
                                          long int /*E_col*/,
@@ -261,37 +256,47 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
                         &&  std::isfinite(voxel_val)  // Ignore infinite and NaN voxels.
                         &&  (user_data_s->lower_threshold <= voxel_val)
                         &&  (voxel_val <= user_data_s->upper_threshold) ){
-
-                            const auto d_low = voxel_val - voxel_min;
-                            const auto bin_N = std::clamp( static_cast<size_t>( std::floor(d_low/bin_width) ),
-                                                           static_cast<size_t>(0),
-                                                           static_cast<size_t>(bin_count-1) );
-                            //raw_diff_hist.at(bin_N)[2] += pxl_vol;
-                            shuttle.push_back(bin_N);
-                            if(N_shuttle == shuttle.size()) add_counts();
+                            if(hist == nullptr){
+                                auto h_it = out.hists.find(key);
+                                if(h_it == std::end(out.hists)){
+                                    h_it = out.hists.emplace(key, raw_diff_histograms.at(key).empty_copy()).first;
+                                }
+                                hist = &(h_it->second);
+                                sketch = &(out.sketches[key]);
+                            }
+                            hist->digest(voxel_val, pxl_vol);
+                            sketch->digest(voxel_val, pxl_vol);
                         }
                         return;
                     };
 
-                    Mutate_Voxels<float,double>( img_refw,
-                                                 { img_refw },
-                                                 named_ccsl.second, 
-                                                 user_data_s->mutation_opts, 
-                                                 f_bounded );
-
-                    add_counts(); // Commit all remaining bins from the shuttle.
+                    // Both passes share the cached rasterization of the contours.
+                    Mutate_Bounded_Voxels( img_refw,
+                                           named_ccsl.second,
+                                           user_data_s->mutation_opts,
+                                           f_bounded );
                 } // Loop over all named ccs.
 
                 //Report operation progress.
-                {
-                    std::lock_guard<std::mutex> lock(printer);
-                    ++completed;
-                    FUNCINFO("Completed " << completed << " of " << img_count
-                          << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+                progress.advance();
+            } // Loop over images in the block.
+            return out;
+
+        }, [](block_result_t &lhs, block_result_t &&rhs) -> void {
+            for(auto &h : rhs.hists){
+                auto h_it = lhs.hists.find(h.first);
+                if(h_it == std::end(lhs.hists)){
+                    lhs.hists.emplace(h.first, std::move(h.second));
+                }else{
+                    h_it->second.merge(h.second);
                 }
+            }
+            for(auto &k : rhs.sketches) lhs.sketches[k.first].merge(k.second);
+            return;
+        });
 
-            }); // thread pool task closure.
-        } // Loop over all images.
+        for(const auto &h : merged.hists) raw_diff_histograms.at(h.first).merge(h.second);
+        for(const auto &k : merged.sketches) sketches.at(k.first).merge(k.second);
     }
 
     // Prepare differential histograms.
@@ -309,7 +314,15 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
             // -dDose being too large.
         }
 
-        user_data_s->differential_histograms[key].samples.swap( raw_diff_histograms.at(key) );
+        {
+            const auto &hist = raw_diff_histograms.at(key);
+            auto &samples = user_data_s->differential_histograms[key].samples;
+            samples.clear();
+            samples.reserve(hist.size());
+            for(size_t i = 0; i < hist.size(); ++i){
+                samples.push_back({ hist.bin_centre(i), 0.0, hist.bin_weight(i), 0.0 }); // Note: bin values are centred.
+            }
+        }
 
         user_data_s->differential_histograms[key].metadata["Modality"]        = "Histogram"; 
         user_data_s->differential_histograms[key].metadata["HistogramType"]   = "Differential";
@@ -338,6 +351,10 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
         user_data_s->differential_histograms[key].metadata["DistributionMean"] = std::to_string(voxel_mean);
         user_data_s->differential_histograms[key].metadata["DistributionMax"]  = std::to_string(voxel_max);
 
+        // Estimated from the streaming quantile sketch, so it is not limited by the bin width.
+        const auto voxel_median = sketches.at(key).quantiles.quantile(0.5);
+        user_data_s->differential_histograms[key].metadata["DistributionMedian"] = std::to_string(voxel_median);
+
         const auto x_eps = std::numeric_limits<double>::infinity();  // Ignore the abscissa.
         //const auto y_eps = 0.0001;
         const auto y_eps = std::sqrt( 10.0 * std::numeric_limits<double>::epsilon() );
@@ -1,19 +1,26 @@
 //GenerateSurfaceMask.cc.
 
-#include <asio.hpp>
+#include <algorithm>
+#include <array>
 #include <exception>
 #include <any>
+#include <cstdint>
 #include <functional>
-#include <limits>
+#include <iterator>
 #include <list>
+#include <map>
 #include <memory>
 #include <ostream>
 #include <stdexcept>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "../../Thread_Pool.h"
+#include "../../Distance_Transform.h"
 #include "../Grouping/Misc_Functors.h"
+#include "../ROI_Mask_Volume.h"
+#include "../Voxel_Inclusion_Mask.h"
 #include "GenerateSurfaceMask.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -64,12 +71,41 @@ bool ComputeGenerateSurfaceMask(planar_image_collection<float,double> &imagecoll
         return false;
     }
 
+    //Classify the surface with a distance transform, if requested.
+    if(0.0 < user_data_s->surface_thickness){
+        Mutate_Voxels_Opts mutation_opts;
+        mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
+        mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+        const auto vol = Rasterize_ROI_Mask_Volume(imagecoll, ccsl, mutation_opts);
+
+        std::vector<uint8_t> exterior(vol.mask.size());
+        for(size_t i = 0; i < vol.mask.size(); ++i) exterior[i] = (vol.mask[i] == 0) ? 1 : 0;
+        const auto sq_dist_to_interior = Squared_Euclidean_Distance_Transform(vol.mask, vol.grid);
+        const auto sq_dist_to_exterior = Squared_Euclidean_Distance_Transform(exterior, vol.grid);
+
+        const auto sq_thickness = user_data_s->surface_thickness * user_data_s->surface_thickness * (1.0 + 1.0E-9);
+        const auto image_size = vol.grid.rows * vol.grid.columns;
+        parallel_for(0, vol.grid.images, [&](long int i){
+            auto &img = vol.images[i].get();
+            for(long int row = 0; row < img.rows; ++row){
+                for(long int col = 0; col < img.columns; ++col){
+                    const auto n = i * image_size + row * img.columns + col;
+                    const bool is_interior = (vol.mask[n] != 0);
+                    const auto sq_dist = is_interior ? sq_dist_to_exterior[n] : sq_dist_to_interior[n];
+                    img.reference(row, col, 0) = (sq_dist <= sq_thickness) ? user_data_s->surface_val
+                                                : (is_interior ? user_data_s->interior_val
+                                                               : user_data_s->background_val);
+                }
+            }
+        }, 1);
+        return true;
+    }
+
     //Generate a comprehensive list of iterators to all as-of-yet-unused images. This list will be
     // pruned after images have been successfully operated on.
+    std::vector<planar_image<float,double> *> imgs;
     auto all_images = imagecoll.get_all_images();
     while(!all_images.empty()){
-        FUNCINFO("Images still to be processed: " << all_images.size());
-
         // Find the images which spatially overlap with this image.
         auto curr_img_it = all_images.front();
         auto selected_imgs = GroupSpatiallyOverlappingImages(curr_img_it, std::ref(imagecoll));
@@ -87,130 +123,81 @@ bool ComputeGenerateSurfaceMask(planar_image_collection<float,double> &imagecoll
         for(auto &an_img_it : selected_imgs){
              all_images.remove(an_img_it); //std::list::remove() erases all elements equal to input value.
         }
+        imgs.push_back( &(*selected_imgs.front()) );
+    }
+    const auto N_imgs = static_cast<long int>(imgs.size());
+
+    //Find the nearest images (above and below, if there are any) for later use.
+    std::map<const planar_image<float,double> *, long int> img_index;
+    for(long int i = 0; i < N_imgs; ++i) img_index[imgs[i]] = i;
+    std::vector<std::array<long int, 2>> neighbours(imgs.size(), {{ -1, -1 }});
+    for(long int i = 0; i < N_imgs; ++i){
+        const auto ab_list_pair = imagecoll.get_nearest_images_above_below_not_encompassing_image(*imgs[i]);
+        if(!ab_list_pair.first.empty())  neighbours[i][0] = img_index.at( &(*ab_list_pair.first.front()) );
+        if(!ab_list_pair.second.empty()) neighbours[i][1] = img_index.at( &(*ab_list_pair.second.front()) );
+    }
 
-        planar_image<float,double> &img = std::ref(*selected_imgs.front());
-        //Loop over the rois, rows, columns, channels, and finally any selected images.
-        const auto row_unit   = img.row_unit;
-        const auto col_unit   = img.col_unit;
-        const auto ortho_unit = row_unit.Cross( col_unit ).unit();
-   
-        img.fill_pixels( 0, std::numeric_limits<float>::quiet_NaN() );
-        
-        //Find the (ranked) nearest images (above and below, if there are any) for later use.
-        const auto ab_list_pair = imagecoll.get_nearest_images_above_below_not_encompassing_image(img);
-        const auto above = ab_list_pair.first;
-        const auto below = ab_list_pair.second;
-
-        //Check if there are any contours on this image or it's neighbours. If not, skip checking the image.
-        auto cc_select = ccsl;
-        cc_select.remove_if([=](std::reference_wrapper<contour_collection<double>> cc) -> bool {
-            const auto present_img = img.encompasses_any_part_of_contour_in_collection( cc.get() );
-            if(present_img) return false; //Do not remove if img intersects a contour.
-
-            if(!above.empty()){
-                const auto present_above = above.front()->encompasses_any_part_of_contour_in_collection( cc.get() );
-                if(present_above) return false;
-            }
-            if(!below.empty()){
-                const auto present_below = below.front()->encompasses_any_part_of_contour_in_collection( cc.get() );
-                if(present_below) return false;
+    //Determine which voxels are within any ROI. Each image is rasterized once, with a single scanline pass per row,
+    // and shared with its neighbours.
+    Mutate_Voxels_Opts mutation_opts;
+    mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
+    mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+
+    std::vector<std::vector<uint8_t>> interior(imgs.size());
+    parallel_for(0, N_imgs, [&](long int i){
+        const auto &img = *imgs[i];
+        const auto mask = Get_Voxel_Inclusion_Mask(img, ccsl, mutation_opts);
+        auto &in = interior[i];
+        in.assign(static_cast<size_t>(img.rows * img.columns), 0);
+        for(long int row = 0; row < img.rows; ++row){
+            for(auto r = mask->row_offsets[row]; r < mask->row_offsets[row + 1]; ++r){
+                std::fill(std::next(std::begin(in), row * img.columns + mask->runs[r][0]),
+                          std::next(std::begin(in), row * img.columns + mask->runs[r][1]), 1);
             }
-            return true;
-        });
-
-        if(cc_select.empty()){
-            img.fill_pixels( 0, user_data_s->background_val );
-            continue;
         }
-
-        //Loop over the pixels of the image.
-        {
-            asio_thread_pool tp;
-
-            for(auto row = 0; row < img.rows; ++row){
-                tp.submit_task([&,row]() -> void {
-                    for(auto col = 0; col < img.columns; ++col){
-                        const auto point = img.position(row,col);
-
-                        //Check if there are any ROI's this voxel is inside. 
-                        bool is_in_an_roi = false;
-                        for(auto &ccs : cc_select){
-                            for(auto & contour : ccs.get().contours){
-                                if(contour.points.empty()) continue;
-                                if(! img.encompasses_contour_of_points(contour)) continue;
-
-                                //Prepare a contour for fast is-point-within-the-polygon checking.
-                                auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-                                auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-                                const bool AlreadyProjected = true;
-                
-                                auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                                is_in_an_roi = ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                           ProjectedPoint,
-                                                                                                           AlreadyProjected);
-                                if(is_in_an_roi) break;
-                            }
-                            if(is_in_an_roi) break;
-                        }
-                        img.reference(row, col, 0) =  (is_in_an_roi) ? (user_data_s->interior_val)
-                                                                     : (user_data_s->background_val);
-
-                        //Create a lambda routine that takes an image and checks in-plane if any neighbours are (!is_in_an_roi).
-                        auto check_inclusion = [&](const planar_image<float,double> &limg,
-                                                   long int boxr ) -> bool {
-
-                                //Project the original image's position onto the plane of this image, so we know where the central
-                                // neighbour point is.
-                                const auto limg_plane = limg.image_plane();
-                                const auto lpoint = limg_plane.Project_Onto_Plane_Orthogonally(point);
-                                const long int lindx = limg.index(lpoint, 0);
-                                const auto rcc = limg.row_column_channel_from_index(lindx);
-                                const auto lrow = std::get<0>(rcc);
-                                const auto lcol = std::get<1>(rcc);
-
-                                for(auto brow = (lrow-boxr); brow <= (lrow+boxr); ++brow){
-                                    for(auto bcol = (lcol-boxr); bcol <= (lcol+boxr); ++bcol){
-                                        //Check if the coordinates are legal and in the ROI.
-                                        if( !isininc(0,brow,limg.rows-1) || !isininc(0,bcol,limg.columns-1) ) continue;
-                                        const auto bpoint = limg.position(brow, bcol);
-
-                                        for(auto &ccs : cc_select){
-                                            for(auto & contour : ccs.get().contours){
-                                                if(contour.points.empty()) continue;
-                                                if(! limg.encompasses_contour_of_points(contour)) continue;
-
-                                                //Prepare a contour for fast is-point-within-the-polygon checking.
-                                                auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-                                                auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-                                                const bool AlreadyProjected = true;
-                                
-                                                auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(bpoint);
-                                                const auto bis_in_an_roi = ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                                                       ProjectedPoint,
-                                                                                                                                       AlreadyProjected);
-                                                if(bis_in_an_roi != is_in_an_roi) return true;
-                                            }
-                                        }
-                                    }
-                                }
-                                return false; //No point (!is_in_an_roi) was found.
-                        };
-
-
-                        if(check_inclusion(img, 1)){
-                            img.reference(row, col, 0) = user_data_s->surface_val;
-
-                        //Apply the check to the nearest neighbouring image slices.
-                        }else if( !above.empty() && check_inclusion(*(above.front()), 0) ){
-                            img.reference(row, col, 0) = user_data_s->surface_val;
-                        }else if( !below.empty() && check_inclusion(*(below.front()), 0) ){
-                            img.reference(row, col, 0) = user_data_s->surface_val;
-                        }
+    }, 1);
+
+    //Classify the voxels. Voxels are on the surface if any in-plane neighbour (including diagonals), or the nearest
+    // voxel on an adjacent image, is on the other side of the ROI boundary.
+    parallel_for(0, N_imgs, [&](long int i){
+        auto &img = *imgs[i];
+        const auto &in = interior[i];
+
+        // The voxel nearest to a point on a neighbouring image, if any.
+        const auto is_surface_on = [&](long int n, const vec3<double> &point, bool is_in_an_roi) -> bool {
+            if(n < 0) return false;
+            const auto &limg = *imgs[n];
+            const auto lpoint = limg.image_plane().Project_Onto_Plane_Orthogonally(point);
+            const long int lindx = limg.index(lpoint, 0);
+            if(lindx < 0) return false;
+            const auto rcc = limg.row_column_channel_from_index(lindx);
+            const auto lrow = std::get<0>(rcc);
+            const auto lcol = std::get<1>(rcc);
+            return (interior[n][lrow * limg.columns + lcol] != 0) != is_in_an_roi;
+        };
+
+        for(long int row = 0; row < img.rows; ++row){
+            for(long int col = 0; col < img.columns; ++col){
+                const bool is_in_an_roi = (in[row * img.columns + col] != 0);
+
+                bool is_surface = false;
+                for(auto brow = std::max<long int>(0, row - 1); brow <= std::min(img.rows - 1, row + 1); ++brow){
+                    for(auto bcol = std::max<long int>(0, col - 1); bcol <= std::min(img.columns - 1, col + 1); ++bcol){
+                        is_surface = is_surface || ((in[brow * img.columns + bcol] != 0) != is_in_an_roi);
                     }
-                });
+                }
+                if(!is_surface){
+                    const auto point = img.position(row, col);
+                    is_surface = is_surface_on(neighbours[i][0], point, is_in_an_roi)
+                              || is_surface_on(neighbours[i][1], point, is_in_an_roi);
+                }
+
+                img.reference(row, col, 0) = is_surface   ? user_data_s->surface_val
+                                           : is_in_an_roi ? user_data_s->interior_val
+                                                          : user_data_s->background_val;
             }
         }
-    } //Finish tasks and terminate thread pool.
+    }, 1);
 
     return true;
 }
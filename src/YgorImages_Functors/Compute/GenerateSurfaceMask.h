@@ -15,6 +15,11 @@ struct GenerateSurfaceMaskUserData {
     float surface_val    = 1.0;
     float interior_val   = 2.0;
 
+    // If positive, the surface comprises all voxels within this distance (in DICOM units; mm) of a voxel on the other
+    // side of the ROI boundary, computed with an exact Euclidean distance transform over the whole image volume. The
+    // images must then form a regular rectilinear grid. Otherwise, immediately neighbouring voxels are compared.
+    double surface_thickness = 0.0;
+
 //    bool assume_boundary_is_surface = false; //If the ROI overshoots an image boundary, assume the boundary is the 
 //    long int voxel_neighbour_family = 1; 
 };
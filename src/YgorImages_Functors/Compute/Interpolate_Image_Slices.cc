@@ -4,14 +4,18 @@
 #include <any>
 #include <optional>
 #include <functional>
+#include <limits>
 #include <list>
 #include <map>
 #include <algorithm>
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "../../Thread_Pool.h"
+#include "../../Separable_Resampling.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
 #include "Interpolate_Image_Slices.h"
@@ -125,15 +129,18 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
 
 
 
-    asio_thread_pool tp;
-    std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
-    long int completed = 0;
     const long int img_count = imagecoll.images.size();
+    progress_tracker progress("image slice interpolation", img_count,
+                              [](long int completed, long int total, double) -> void {
+        FUNCINFO("Completed " << completed << " of " << total
+              << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+    });
+    task_group tg;
 
     for(auto &img : imagecoll.images){
         std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
 
-        tp.submit_task([&,img_refw]() -> void {
+        tg.run([&,img_refw]() -> void {
 
             const auto N_rows = img_refw.get().rows;
             const auto N_columns = img_refw.get().columns;
@@ -210,7 +217,68 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
                     img_refw.get().data = nearest_above->data;
 
                 }else{
-                    std::logic_error("No neighbouring planes found. Cannot interpolate. Cannot continue.");
+                    throw std::logic_error("No neighbouring planes found. Cannot interpolate. Cannot continue.");
+                }
+
+            // If the reference images are all parallel to this image with aligned rows and columns, the neighbouring
+            // planes are the same for every voxel and the in-plane sample positions are separable, so the neighbours
+            // can be resampled with weights computed once per row and column.
+            }else if(std::all_of(std::begin(reference_imgs), std::end(reference_imgs),
+                                 [&](const std::reference_wrapper<planar_image<float,double>> &ref_img_refw){
+                                     return Aligned_Sample_Positions(ref_img_refw.get(), img_refw.get()).has_value();
+                                 })){
+                const auto v_pos = img_refw.get().position(0, 0); // Pick any point...
+                identify_nearest_adjacent_neighbours(v_pos);
+
+                // Routine for resampling a channel of a planar image onto this image's rows and columns. Samples that
+                // lie outside the planar image are NaN.
+                const auto make_weights = [&](planar_image<float,double> *img_ptr){
+                    const auto pos = Aligned_Sample_Positions(*img_ptr, img_refw.get()).value();
+                    return std::make_pair( Compute_Resampling_Weights(img_ptr->rows, pos.first, resampling_kernel::linear),
+                                           Compute_Resampling_Weights(img_ptr->columns, pos.second, resampling_kernel::linear) );
+                };
+                const auto resample = [&](planar_image<float,double> *img_ptr,
+                                          const std::pair<resampling_weights, resampling_weights> &w,
+                                          long int chan) -> std::vector<float> {
+                    if(img_ptr->channels <= chan){
+                        return std::vector<float>(N_rows * N_columns, std::numeric_limits<float>::quiet_NaN());
+                    }
+                    return Resample_Image_Channel(*img_ptr, chan, w.first, w.second);
+                };
+
+                std::pair<resampling_weights, resampling_weights> above_w;
+                std::pair<resampling_weights, resampling_weights> below_w;
+                if(nearest_above != nullptr) above_w = make_weights(nearest_above);
+                if(nearest_below != nullptr) below_w = make_weights(nearest_below);
+
+                for(auto chan = 0; chan < N_channels; ++chan){
+                    if( (chan != ud_channel) && (ud_channel >= 0) ) continue;
+
+                    std::vector<float> newvals;
+                    if( (nearest_above != nullptr) && (nearest_below != nullptr) ){
+                        const auto vals_a = resample(nearest_above, above_w, chan);
+                        const auto vals_b = resample(nearest_below, below_w, chan);
+                        newvals.resize(vals_a.size());
+                        for(size_t i = 0; i < newvals.size(); ++i){
+                            newvals[i] = ( vals_a[i] * below_dist
+                                         + vals_b[i] * above_dist ) / total_dist;  // Note: Not a typo! Weights should be anti-paired.
+                        }
+
+                    }else if( (nearest_above == nullptr) && (nearest_below != nullptr) ){
+                        newvals = resample(nearest_below, below_w, chan);
+
+                    }else if( (nearest_above != nullptr) && (nearest_below == nullptr) ){
+                        newvals = resample(nearest_above, above_w, chan);
+
+                    }else{
+                        throw std::logic_error("No neighbouring planes found. Cannot interpolate. Cannot continue.");
+                    }
+
+                    for(auto row = 0; row < N_rows; ++row){
+                        for(auto col = 0; col < N_columns; ++col){
+                            img_refw.get().reference(row, col, chan) = newvals[row * N_columns + col];
+                        }
+                    }
                 }
 
             // If all images are NOT rectilinear, then in-plane interpolation is needed because the voxel
@@ -247,7 +315,7 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
 
                             if( (nearest_above != nullptr) && (nearest_below != nullptr) ){
                                 const auto val_a = project_and_interpolate(nearest_above,v_pos);
-                                const auto val_b = project_and_interpolate(nearest_above,v_pos);
+                                const auto val_b = project_and_interpolate(nearest_below,v_pos);
                                 newval = ( val_a * below_dist
                                          + val_b * above_dist ) / total_dist;  // Note: Not a typo! Weights should be anti-paired.
                                 
@@ -258,7 +326,7 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
                                 newval = project_and_interpolate(nearest_above,v_pos);
 
                             }else{
-                                std::logic_error("No neighbouring planes found. Cannot interpolate. Cannot continue.");
+                                throw std::logic_error("No neighbouring planes found. Cannot interpolate. Cannot continue.");
                             }
 
                             img_refw.get().reference(row, col, chan) = newval;
@@ -271,15 +339,11 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
             UpdateImageWindowCentreWidth( img_refw );
 
             //Report operation progress.
-            {
-                std::lock_guard<std::mutex> lock(saver_printer);
-                ++completed;
-                FUNCINFO("Completed " << completed << " of " << img_count
-                      << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-            }
+            progress.advance();
         }); // thread pool task closure.
 
     }
+    tg.wait();
 
     return true;
 }
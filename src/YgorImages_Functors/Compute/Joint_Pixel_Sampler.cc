@@ -1,5 +1,6 @@
 //Joint_Pixel_Sampler.cc.
 
+#include <cmath>
 #include <exception>
 #include <any>
 #include <optional>
@@ -10,10 +11,12 @@
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <vector>
 
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
+#include "../Voxel_Inclusion_Mask.h"
 #include "Joint_Pixel_Sampler.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -23,6 +26,32 @@
 #include "YgorClustering.hpp"
 
 
+namespace {
+
+// Relative tolerance for comparing image geometry.
+constexpr double geometry_tolerance = 1.0E-6;
+
+} // namespace
+
+
+bool Images_Share_Geometry(const planar_image<float,double> &A,
+                           const planar_image<float,double> &B){
+    if( (A.rows != B.rows) || (A.columns != B.columns) ) return false;
+
+    const auto close = [](double a, double b){
+        return std::abs(a - b) <= geometry_tolerance * std::max(std::abs(a), std::abs(b));
+    };
+    if( !close(A.pxl_dx, B.pxl_dx) || !close(A.pxl_dy, B.pxl_dy) ) return false;
+
+    if( (A.row_unit.unit().Dot(B.row_unit.unit()) < (1.0 - geometry_tolerance))
+    ||  (A.col_unit.unit().Dot(B.col_unit.unit()) < (1.0 - geometry_tolerance)) ) return false;
+
+    // The first voxels must coincide to within a small fraction of a voxel, both in- and out-of-plane.
+    const auto scale = std::min(A.pxl_dx, A.pxl_dy);
+    return ( A.position(0, 0).distance(B.position(0, 0)) <= geometry_tolerance * scale );
+}
+
+
 bool ComputeJointPixelSampler(planar_image_collection<float,double> &imagecoll,
                               std::list<std::reference_wrapper<planar_image_collection<float,double>>> external_imgs,
                               std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
@@ -88,56 +117,64 @@ bool ComputeJointPixelSampler(planar_image_collection<float,double> &imagecoll,
     mv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
 
 
-    std::mutex passing_counter; // Used to tally the gamma passing rate.
+    // Adjacency lists are only built once for each reference image array, using the orientation of the first image to
+    // edit. Images with other orientations build their own.
+    const auto common_normal = imagecoll.images.empty() ? vec3<double>(0.0, 0.0, 1.0)
+                                                         : imagecoll.images.front().image_plane().N_0.unit();
+    std::list< planar_image_adjacency<float,double> > common_adj_l;
+    for(auto & picrw : external_imgs){
+        std::list< std::reference_wrapper< planar_image<float,double> > > empty;
+        common_adj_l.emplace_back( empty, decltype(external_imgs){ picrw }, common_normal );
+    }
 
-    asio_thread_pool tp;
-    std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
-    long int completed = 0;
     const long int img_count = imagecoll.images.size();
+    progress_tracker progress("joint pixel sampling", img_count,
+                              [](long int completed, long int total, double) -> void {
+        FUNCINFO("Completed " << completed << " of " << total
+              << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+    });
+    task_group tg;
+    std::mutex saver_printer; // Who gets to print to the console.
 
     for(auto &img : imagecoll.images){
         std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
 
-        tp.submit_task([&,img_refw]() -> void {
+        tg.run([&,img_refw]() -> void {
             const auto orientation_normal = img_refw.get().image_plane().N_0.unit();
 
-            // Prepare adjacency lists for each external image array.
-            std::list< planar_image_adjacency<float,double> > img_adj_l;
-            for(auto & picrw : external_imgs){
-                decltype(external_imgs) shtl;
-                shtl.emplace_back(picrw);
-                std::list< std::reference_wrapper< planar_image<float,double> > > empty;
-                img_adj_l.emplace_back( empty, shtl, orientation_normal );
+            std::list< planar_image_adjacency<float,double> > local_adj_l;
+            if(orientation_normal.Dot(common_normal) < (1.0 - geometry_tolerance)){
+                for(auto & picrw : external_imgs){
+                    std::list< std::reference_wrapper< planar_image<float,double> > > empty;
+                    local_adj_l.emplace_back( empty, decltype(external_imgs){ picrw }, orientation_normal );
+                }
             }
-
-            // Identify the reference images which wholly overlap with the image to edit, if any.
-            //
-            // This arrangement is common in many scenarios and can be exploited to reduce costly checks for each voxel.
-            // If no overlapping image is found, another lookup is performed for each voxel (which is much slower).
-            using img_ptr_t = planar_image<float,double> *;
-            std::list<img_ptr_t> int_img_ptr_l;
+            const auto &img_adj_l = local_adj_l.empty() ? common_adj_l : local_adj_l;
+
+            // Identify, for each reference image array, the image which wholly overlaps the image to edit, if any, and
+            // whether it shares the image's voxel grid. Arrays sharing the grid are sampled directly by (row, column)
+            // without any spatial lookup or interpolation. Otherwise a lookup is performed for each voxel.
+            struct sampler_t {
+                const planar_image_adjacency<float,double> *adj = nullptr;
+                const planar_image<float,double> *overlapping = nullptr;
+                bool same_grid = false;
+            };
+            std::vector<sampler_t> samplers;
             bool envel_overlap = true; // Images that are enveloped, but may have different spatial characteristics.
-            bool exact_overlap = true; // Images which have same spatial layout, number of rows and columns, etc.
+            bool exact_overlap = true; // Images which share the voxel grid.
             for(const auto & img_adj : img_adj_l){
+                samplers.emplace_back();
+                auto &sampler = samplers.back();
+                sampler.adj = &img_adj;
+
                 auto overlapping_img_refws = img_adj.get_wholly_overlapping_images(img_refw);
                 if(!overlapping_img_refws.empty()){
-                    int_img_ptr_l.emplace_back( std::addressof(overlapping_img_refws.front().get()) );
-
-                    if( (img_refw.get().rows == overlapping_img_refws.front().get().rows)
-                    &&  (img_refw.get().columns == overlapping_img_refws.front().get().columns)
-                    &&  (img_refw.get().channels == overlapping_img_refws.front().get().channels)
-                    &&  (0.99 < img_refw.get().row_unit.Dot(overlapping_img_refws.front().get().row_unit))
-                    &&  (0.99 < img_refw.get().col_unit.Dot(overlapping_img_refws.front().get().col_unit)) ){
-                        // exact_overlap *= 1.0;
-                    }else{
-                        exact_overlap = false;
-                    }
-
+                    sampler.overlapping = std::addressof(overlapping_img_refws.front().get());
+                    sampler.same_grid = Images_Share_Geometry(img_refw.get(), *(sampler.overlapping));
                 }else{
-                    int_img_ptr_l.emplace_back( nullptr );
                     envel_overlap = false;
-                    exact_overlap = false;
                 }
+                exact_overlap = exact_overlap && sampler.same_grid;
             }
             if(!envel_overlap){
                 std::lock_guard<std::mutex> lock(saver_printer);
@@ -148,6 +185,9 @@ bool ComputeJointPixelSampler(planar_image_collection<float,double> &imagecoll,
                 FUNCWARN("Reference images do not all exact-overlap; using per-image sampling");
             }
 
+            std::vector<float> vals; // Reused for every voxel.
+            vals.reserve(samplers.size() + 1);
+
             auto f_bounded = [&](long int E_row,  // "edit-image" row.
                                  long int E_col,  // "edit-image" column.
                                  long int channel, 
@@ -161,7 +201,7 @@ bool ComputeJointPixelSampler(planar_image_collection<float,double> &imagecoll,
                 }
 
                 // Tabulate all reference images sampled in order.
-                std::vector<float> vals;
+                vals.clear();
                 vals.emplace_back(voxel_val);
 
                 // Default the output to an invalid voxel value.
@@ -171,28 +211,20 @@ bool ComputeJointPixelSampler(planar_image_collection<float,double> &imagecoll,
                 const auto pos = img_refw.get().position(E_row, E_col);
 
                 // Sample each external image volume.
-                const size_t N_ext_img_arrs = int_img_ptr_l.size();
-                for(size_t i = 0; i < N_ext_img_arrs; ++i){                               // TODO: replace this dual iteration with iteration over a list of a class that combines both items (paired).
-                    auto int_img_it = std::next( std::begin(int_img_ptr_l), i );
-                    auto img_adj_it = std::next( std::begin(img_adj_l), i );
-
-                    // Sample the image.
-                    if(exact_overlap){
-                        try{
-                            vals.emplace_back( (*(int_img_it))->value(E_row, E_col, channel) );
-                        }catch(const std::exception &){
-                            vals.emplace_back(inaccessible_val); // Cannot access this voxel.
-                            continue;
-                        }
+                for(const auto &sampler : samplers){
+                    if(sampler.same_grid){
+                        vals.emplace_back( (channel < sampler.overlapping->channels)
+                                           ? sampler.overlapping->value(E_row, E_col, channel)
+                                           : inaccessible_val );
 
                     }else if(user_data_s->sampling_method == ComputeJointPixelSamplerUserData::SamplingMethod::NearestVoxel){
                         // If no wholly overlapping image was previously identified, perform a lookup for this specific voxel.
                         // 
                         // Note: this is a costly pathway, but is necessary if images are disaligned.
-                        img_ptr_t l_int_img_ptr = *(int_img_it); // De-reference the iterator to get the pointer..
+                        const planar_image<float,double> *l_int_img_ptr = sampler.overlapping;
                         if(l_int_img_ptr == nullptr){
                             try{
-                                l_int_img_ptr = std::addressof( img_adj_it->position_to_image(pos).get() );
+                                l_int_img_ptr = std::addressof( sampler.adj->position_to_image(pos).get() );
                             }catch(const std::exception &){
                                 vals.emplace_back(inaccessible_val); // Cannot access this voxel.
                                 continue;
@@ -216,7 +248,7 @@ bool ComputeJointPixelSampler(planar_image_collection<float,double> &imagecoll,
                         vals.emplace_back( sampled_val );
 
                     }else if(user_data_s->sampling_method == ComputeJointPixelSamplerUserData::SamplingMethod::LinearInterpolation){
-                        const auto sampled_val = img_adj_it->trilinearly_interpolate(pos, channel);
+                        const auto sampled_val = sampler.adj->trilinearly_interpolate(pos, channel);
                         vals.emplace_back( sampled_val );
 
                     }else{
@@ -233,25 +265,17 @@ bool ComputeJointPixelSampler(planar_image_collection<float,double> &imagecoll,
                 return;
             };
 
-            Mutate_Voxels<float,double>( img_refw,
-                                         { img_refw },
-                                         ccsl, 
-                                         mv_opts, 
-                                         f_bounded );
+            Mutate_Bounded_Voxels( img_refw, ccsl, mv_opts, f_bounded );
 
             UpdateImageDescription( img_refw, user_data_s->description );
             UpdateImageWindowCentreWidth( img_refw );
 
             //Report operation progress.
-            {
-                std::lock_guard<std::mutex> lock(saver_printer);
-                ++completed;
-                FUNCINFO("Completed " << completed << " of " << img_count
-                      << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-            }
+            progress.advance();
         }); // thread pool task closure.
 
     }
+    tg.wait();
 
 
     return true;
@@ -10,6 +10,7 @@
 
 #include "YgorMath.h"
 
+template <class T, class R> class planar_image;
 template <class T, class R> class planar_image_collection;
 template <class T> class contour_collection;
 
@@ -62,6 +63,11 @@ struct ComputeJointPixelSamplerUserData {
 
 };
 
+// Returns true if the images share a voxel grid, i.e., voxel (row, column) of one image is coincident with voxel
+// (row, column) of the other. Channels and pixel values are not compared. Such images can be sampled by index.
+bool Images_Share_Geometry(const planar_image<float,double> &A,
+                           const planar_image<float,double> &B);
+
 bool ComputeJointPixelSampler(planar_image_collection<float,double> &,
                           std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
                           std::list<std::reference_wrapper<contour_collection<double>>>,
@@ -5,10 +5,10 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <memory>
 #include <ostream>
-#include <stdexcept>
 
-#include "../Grouping/Misc_Functors.h"
+#include "../../Time_Course_Tensor.h"
 #include "Per_ROI_Time_Courses.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -43,7 +43,7 @@ bool ComputePerROICourses(planar_image_collection<float,double> &imagecoll,
 
     //This routine performs a number of calculations. It is experimental and excerpts you plan to rely on should be
     // made into their own analysis functors.
-    const bool InhibitSort = true; //Disable continuous sorting (defer to single sort later) to speed up data ingress.
+    const bool InhibitSort = true; //Samples are harvested in temporal order, so sorting is not needed.
 
 
     //Figure out if there are any contours for which are within the spatial extent of the image. 
@@ -73,53 +73,27 @@ bool ComputePerROICourses(planar_image_collection<float,double> &imagecoll,
 */
 
 
-    //Generate a comprehensive list of iterators to all as-of-yet-unused images. This list will be
-    // pruned after images have been successfully operated on.
-    auto all_images = imagecoll.get_all_images();
-    while(!all_images.empty()){
-        FUNCINFO("Images still to be processed: " << all_images.size());
+    //Use the shared time course tensor, if one was provided and it is still valid. Otherwise, build one. Either way,
+    // each voxel's time course is then read as a single contiguous series.
+    auto tensor = user_data_s->tensor;
+    if( (tensor == nullptr) || !tensor->is_current(imagecoll) ){
+        tensor = std::make_shared<const Time_Course_Tensor>(imagecoll);
+    }
 
-        //Find the images which spatially overlap with this image.
-        auto curr_img_it = all_images.front();
-        auto selected_imgs = GroupSpatiallyOverlappingImages(curr_img_it, std::ref(imagecoll));
+    for(size_t g = 0; g < tensor->size(); ++g){
+        FUNCINFO("Image groups still to be processed: " << (tensor->size() - g));
 
-        if(selected_imgs.empty()){
-            throw std::logic_error("No spatially-overlapping images found. There should be at least one"
-                                   " image (the 'seed' image) which should match. Verify the spatial" 
-                                   " overlap grouping routine.");
-        }
-        {
-          auto rows     = curr_img_it->rows;
-          auto columns  = curr_img_it->columns;
-          auto channels = curr_img_it->channels;
-
-          for(const auto &an_img_it : selected_imgs){
-              if( (rows     != an_img_it->rows)
-              ||  (columns  != an_img_it->columns)
-              ||  (channels != an_img_it->channels) ){
-                  throw std::domain_error("Images have differing number of rows, columns, or channels."
-                                          " This is not currently supported -- though it could be if needed."
-                                          " Are you sure you've got the correct data?");
-              }
-              // NOTE: We assume the first image in the selected_images set is representative of the following
-              //       images. We assume they all share identical row and column units, spatial extent, planar
-              //       orientation, and (possibly) that row and column indices for one image are spatially
-              //       equal to all other images. Breaking the last assumption would require an expensive 
-              //       position_space-to-row_and_column_index lookup for each voxel.
-          }
-        }
-        for(auto &an_img_it : selected_imgs){
-             all_images.remove(an_img_it); //std::list::remove() erases all elements equal to input value.
-        }
+        //The images in each group spatially overlap and are ordered temporally.
+        const auto &group = tensor->get_group(g);
+        const auto &times = group.get_times();
+        const bool has_times = group.has_times();
 
-        planar_image<float,double> &img = std::ref(*selected_imgs.front());
-        //Loop over the rois, rows, columns, channels, and finally any selected images (if applicable).
+        const planar_image<float,double> &img = *(group.get_images().front());
         const auto row_unit   = img.row_unit;
         const auto col_unit   = img.col_unit;
         const auto ortho_unit = row_unit.Cross( col_unit ).unit();
     
-        //Loop over the ccsl, rois, rows, columns, channels, and finally any selected images (if applicable).
-        //for(const auto &roi : rois){
+        //Loop over the ccsl, rois, rows, columns, and channels.
         for(auto &ccs : ccsl){
             for(auto & contour : ccs.get().contours){
                 if(contour.points.empty()) continue;
@@ -130,14 +104,6 @@ bool ComputePerROICourses(planar_image_collection<float,double> &imagecoll,
                     FUNCWARN("Missing necessary tags for reporting analysis results. Cannot continue");
                     return false;
                 }
-                
-        /*
-                //Construct a bounding box to reduce computational demand of checking every voxel.
-                auto BBox = roi_it->Bounding_Box_Along(row_unit, 1.0);
-                auto BBoxBestFitPlane = BBox.Least_Squares_Best_Fit_Plane(vec3<double>(0.0,0.0,1.0));
-                auto BBoxProjectedContour = BBox.Project_Onto_Plane_Orthogonally(BBoxBestFitPlane);
-                const bool BBoxAlreadyProjected = true;
-        */
         
                 //Prepare a contour for fast is-point-within-the-polygon checking.
                 auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
@@ -149,88 +115,32 @@ bool ComputePerROICourses(planar_image_collection<float,double> &imagecoll,
                         //Figure out the spatial location of the present voxel.
                         const auto point = img.position(row,col);
         
-        /*
-                        //Check if within the bounding box. It will generally be cheaper than the full contour (4 points vs. ? points).
-                        auto BBoxProjectedPoint = BBoxBestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                        if(!BBoxProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BBoxBestFitPlane,
-                                                                                            BBoxProjectedPoint,
-                                                                                            BBoxAlreadyProjected)) continue;
-        */
-        
                         //Perform a more detailed check to see if we are in the ROI.
                         auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                        if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                       ProjectedPoint,
-                                                                                       AlreadyProjected)){
-                            for(auto chan = 0; chan < img.channels; ++chan){
-                                //Cycle over the grouped images (temporal slices, or whatever the user has decided).
-                                // Harvest the time course or any other voxel-specific numbers.
-                                samples_1D<double> channel_time_course;
-                                channel_time_course.uncertainties_known_to_be_independent_and_random = true;
-                                for(auto & img_it : selected_imgs){
-                                    //Collect the datum of voxels and nearby voxels for an average.
-                                    std::list<double> in_pixs;
-                                    const auto boxr = 0;
-                                    const auto min_datum = 1;
-        
-                                    for(auto lrow = (row-boxr); lrow <= (row+boxr); ++lrow){
-                                        for(auto lcol = (col-boxr); lcol <= (col+boxr); ++lcol){
-                                            //Check if the coordinates are legal and in the ROI.
-                                            if( !isininc(0,lrow,img_it->rows-1) || !isininc(0,lcol,img_it->columns-1) ) continue;
-        
-                                            //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
-                                            //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
-                                            const auto neighbourpoint = img.position(lrow,lcol);
-                                            auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
-                                            if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                            ProjectedNeighbourPoint,
-                                                                                                            AlreadyProjected)) continue;
-                                            const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
-                                            in_pixs.push_back(val);
-                                        }
-                                    }
-                                    auto dt = img_it->GetMetadataValueAs<double>("dt");
-                                    if(!dt) FUNCERR("Image is missing time metadata. Bailing");
-
-                                    const auto avg_val = Stats::Mean(in_pixs);
-                                    if(in_pixs.size() < min_datum) continue; //If contours are too narrow so that there is too few datum for meaningful results.
-                                    //const auto avg_val_sigma = std::sqrt(Stats::Unbiased_Var_Est(in_pixs))/std::sqrt(1.0*in_pixs.size());
-                                    //channel_time_course.push_back(dt.value(), 0.0, avg_val, avg_val_sigma, InhibitSort);
-                                    channel_time_course.push_back(dt.value(), 0.0, avg_val, 0.0, InhibitSort);
-
-                                }
-                                channel_time_course.stable_sort();
-                                if(channel_time_course.empty()) continue;
-        
-                                //Fill in some basic time course metadata.
-         
-                                // ... TODO ...  (Worthwhile at this stage?)
+                        if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
+                                                                                        ProjectedPoint,
+                                                                                        AlreadyProjected)) continue;
+
+                        if(!has_times) FUNCERR("Image is missing time metadata. Bailing");
+                        for(auto chan = 0; chan < img.channels; ++chan){
+                            //Harvest the time course (temporal slices, or whatever the user has decided).
+                            const float *series = group.get_series(row, col, chan);
+                            samples_1D<double> channel_time_course;
+                            channel_time_course.uncertainties_known_to_be_independent_and_random = true;
+                            for(size_t t = 0; t < group.size(); ++t){
+                                channel_time_course.push_back(times[t], 0.0, static_cast<double>(series[t]), 0.0, InhibitSort);
+                            }
+                            if(channel_time_course.empty()) continue;
      
-                                // --------------- Append the time course data into the user_data struct ------------------
-                                //user_data_s->total_voxel_count[ std::ref(ccs) ] += channel_time_course.size();
-                                //user_data_s->voxel_count[ std::ref(ccs) ] += 1;
-                                user_data_s->time_courses[ ROIName.value() ] = user_data_s->time_courses[ ROIName.value() ].Sum_With(channel_time_course);
-                                user_data_s->total_voxel_count[ ROIName.value() ] += channel_time_course.size();
-                                user_data_s->voxel_count[ ROIName.value() ] += 1;
-        
-                                // ----------------------------------------------------------------------------
-        
-                            }//Loop over channels.
-        
-                        //If we're in the bounding box but not the ROI, do something.
-                        }else{
-                            //for(auto chan = 0; chan < first_img_it->channels; ++chan){
-                            //    const auto curr_val = working.value(row, col, chan);
-                            //    if(curr_val != 0) FUNCERR("There are overlapping ROI bboxes. This code currently cannot handle this. "
-                            //                              "You will need to run the functor individually on the overlapping ROIs.");
-                            //    working.reference(row, col, chan) = static_cast<float>(10);
-                            //}
-                        } // If is in ROI or ROI bbox.
+                            // --------------- Append the time course data into the user_data struct ------------------
+                            user_data_s->time_courses[ ROIName.value() ] = user_data_s->time_courses[ ROIName.value() ].Sum_With(channel_time_course);
+                            user_data_s->total_voxel_count[ ROIName.value() ] += channel_time_course.size();
+                            user_data_s->voxel_count[ ROIName.value() ] += 1;
+                        }//Loop over channels.
                     } //Loop over cols
                 } //Loop over rows
             } //Loop over ROIs.
         } //Loop over contour_collections.
-
     }
 
     return true;
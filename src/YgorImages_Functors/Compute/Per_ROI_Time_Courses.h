@@ -9,6 +9,7 @@
 #include <limits>
 #include <list>
 #include <map>
+#include <memory>
 #include <string>
 
 #include "YgorImages.h"
@@ -16,6 +17,7 @@
 #include "YgorMisc.h"
 
 template <class T, class R> class planar_image_collection;
+class Time_Course_Tensor;
 
 
 //User data struct for harvesting data afterward. Note that, because the driver routine calls the supplied functional
@@ -37,6 +39,10 @@ struct ComputePerROITimeCoursesUserData {
     std::map<std::string, uint64_t>           total_voxel_count; //Number of voxels in ROI, over (x,y,z,t).
     std::map<std::string, uint64_t>           voxel_count; //Number of voxels in ROI, over (x,y,z).
 
+    //Optional. If provided (e.g., via Image_Array::get_time_course_tensor()) and still valid, the voxel time courses
+    // are read from it rather than being gathered anew.
+    std::shared_ptr<const Time_Course_Tensor> tensor;
+
 };
 
 bool ComputePerROICourses(planar_image_collection<float,double> &,
@@ -7,10 +7,16 @@
 #include <list>
 #include <map>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <vector>
 
+#include "../../Distribution_Sketch.h"
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
@@ -23,6 +29,75 @@
 #include "YgorClustering.hpp"
 
 
+namespace {
+
+// Maps floats to unsigned integers with the same ordering. Negative zero is folded into positive zero so that the two
+// compare equal, as they do when compared as floats. NaNs never participate in the rank.
+uint32_t order_preserving_key(float f){
+    if(f == 0.0f) f = 0.0f;
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000U) ? ~u : (u | 0x80000000U);
+}
+
+// Stable, parallel least-significant-digit radix sort. Relies on 'scratch' having the same size as 'keys'.
+void parallel_radix_sort(std::vector<uint32_t> &keys, std::vector<uint32_t> &scratch){
+    constexpr int digit_bits = 11;
+    constexpr uint32_t N_buckets = 1U << digit_bits;
+    constexpr uint32_t digit_mask = N_buckets - 1U;
+
+    const auto N = static_cast<long int>(keys.size());
+    const long int min_chunk_size = 1L << 16;
+    const long int N_chunks = std::max<long int>(1, std::min<long int>(N / min_chunk_size,
+                                                  4L * work_stealing_pool::get().concurrency()));
+    const long int chunk_size = (N + N_chunks - 1) / N_chunks;
+
+    std::vector<uint64_t> offsets(static_cast<size_t>(N_chunks) * N_buckets);
+    for(int shift = 0; shift < 32; shift += digit_bits){
+        std::fill(std::begin(offsets), std::end(offsets), 0);
+
+        // Count the digits in each chunk.
+        parallel_for(0, N_chunks, [&](long int c) -> void {
+            auto *counts = &offsets[static_cast<size_t>(c) * N_buckets];
+            const auto end = std::min(N, (c + 1) * chunk_size);
+            for(auto i = c * chunk_size; i < end; ++i) ++counts[(keys[i] >> shift) & digit_mask];
+        }, /*grain=*/ 1);
+
+        // Skip passes where every key shares the same digit.
+        bool trivial = false;
+        for(uint32_t b = 0; b < N_buckets; ++b){
+            uint64_t total = 0;
+            for(long int c = 0; c < N_chunks; ++c) total += offsets[static_cast<size_t>(c) * N_buckets + b];
+            if(total != 0){
+                trivial = (total == static_cast<uint64_t>(N));
+                break;
+            }
+        }
+        if(trivial) continue;
+
+        // Convert counts to output positions, ordered by digit and then by chunk so the sort is stable.
+        uint64_t pos = 0;
+        for(uint32_t b = 0; b < N_buckets; ++b){
+            for(long int c = 0; c < N_chunks; ++c){
+                auto &o = offsets[static_cast<size_t>(c) * N_buckets + b];
+                const auto count = o;
+                o = pos;
+                pos += count;
+            }
+        }
+
+        parallel_for(0, N_chunks, [&](long int c) -> void {
+            auto *dest = &offsets[static_cast<size_t>(c) * N_buckets];
+            const auto end = std::min(N, (c + 1) * chunk_size);
+            for(auto i = c * chunk_size; i < end; ++i) scratch[dest[(keys[i] >> shift) & digit_mask]++] = keys[i];
+        }, /*grain=*/ 1);
+        keys.swap(scratch);
+    }
+}
+
+} // namespace
+
+
 bool ComputeRankPixels(planar_image_collection<float,double> &imagecoll,
                           std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
                           std::list<std::reference_wrapper<contour_collection<double>>>,
@@ -44,28 +119,58 @@ bool ComputeRankPixels(planar_image_collection<float,double> &imagecoll,
     }
 
     auto all_imgs = imagecoll.get_all_images();
-    size_t N_imgs = all_imgs.size();
-
-    // Construct the pixel ordering. 
-    std::vector<double> samples;
-    for(auto & img_it : all_imgs){
-        FUNCINFO("Images still to be assessed: " << N_imgs);
-        --N_imgs;
-
-        for(auto row = 0; row < img_it->rows; ++row){
-            for(auto col = 0; col < img_it->columns; ++col){
-                for(auto chan = 0; chan < img_it->channels; ++chan){
-                    const auto val = static_cast<double>(img_it->value(row, col, chan));
-                    if(isininc( user_data_s->inc_lower_threshold, val, user_data_s->inc_upper_threshold)){
-                        samples.emplace_back(val);
-                    }
-                }//Loop over channels.
-            } //Loop over cols
-        } //Loop over rows
-    } // Loop over images.
-
-    std::sort(std::begin(samples), std::end(samples));
-    const auto N_voxels = std::size(samples);
+    const std::vector<planar_image_collection<float,double>::images_list_it_t> imgs(std::begin(all_imgs), std::end(all_imgs));
+    const auto N_imgs = static_cast<long int>(imgs.size());
+
+    const auto is_included = [&](float val) -> bool {
+        return isininc( user_data_s->inc_lower_threshold, static_cast<double>(val), user_data_s->inc_upper_threshold);
+    };
+
+    // Construct the pixel ordering. Distinct values are recorded along with the rank of their first instance, so ties
+    // are all assigned the same rank.
+    std::vector<uint32_t> distinct_keys;
+    std::vector<uint64_t> first_ranks; // Has a trailing sentinel equal to the number of voxels.
+    tdigest sketch;
+
+    if(user_data_s->approximate){
+        std::vector<tdigest> sketches(imgs.size());
+        parallel_for(0, N_imgs, [&](long int i) -> void {
+            for(const auto &val : imgs[i]->data){
+                if(is_included(val)) sketches[i].digest(static_cast<double>(val));
+            }
+        }, /*grain=*/ 1);
+        for(const auto &s : sketches) sketch.merge(s);
+
+    }else{
+        std::vector<uint64_t> img_offsets(imgs.size() + 1, 0);
+        parallel_for(0, N_imgs, [&](long int i) -> void {
+            img_offsets[i + 1] = std::count_if(std::begin(imgs[i]->data), std::end(imgs[i]->data), is_included);
+        }, /*grain=*/ 1);
+        std::partial_sum(std::begin(img_offsets), std::end(img_offsets), std::begin(img_offsets));
+
+        std::vector<uint32_t> keys(img_offsets.back());
+        parallel_for(0, N_imgs, [&](long int i) -> void {
+            auto pos = img_offsets[i];
+            for(const auto &val : imgs[i]->data){
+                if(is_included(val)) keys[pos++] = order_preserving_key(val);
+            }
+        }, /*grain=*/ 1);
+        {
+            std::vector<uint32_t> scratch(keys.size());
+            parallel_radix_sort(keys, scratch);
+        }
+
+        for(size_t i = 0; i < keys.size(); ++i){
+            if( (i == 0) || (keys[i] != keys[i-1]) ){
+                distinct_keys.push_back(keys[i]);
+                first_ranks.push_back(i);
+            }
+        }
+        first_ranks.push_back(keys.size());
+    }
+
+    const auto N_voxels = user_data_s->approximate ? static_cast<size_t>(sketch.total_weight())
+                                                   : static_cast<size_t>(first_ranks.back());
     const auto N_voxels_f = static_cast<double>(N_voxels);
 
     // Update the images using the pixel ordering.
@@ -73,15 +178,18 @@ bool ComputeRankPixels(planar_image_collection<float,double> &imagecoll,
         FUNCWARN("No voxels were selected to participate in the rank; nothing to do");
 
     }else{
-        asio_thread_pool tp;
-        std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
-        long int completed = 0;
         const long int img_count = imagecoll.images.size();
+        progress_tracker progress("pixel ranking", img_count,
+                                  [](long int completed, long int total, double) -> void {
+            FUNCINFO("Completed " << completed << " of " << total
+                  << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+        });
+        task_group tg;
 
         for(auto & img_it : all_imgs){
             std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(*img_it) );
 
-            tp.submit_task([&,img_refw]() -> void {
+            tg.run([&,img_refw]() -> void {
                 //Record the min and max actual pixel values for windowing purposes.
                 Stats::Running_MinMax<float> minmax_pixel;
 
@@ -91,18 +199,25 @@ bool ComputeRankPixels(planar_image_collection<float,double> &imagecoll,
                             const auto origval = static_cast<double>(img_refw.get().value(row, col, chan));
                             if(isininc( user_data_s->inc_lower_threshold, origval, user_data_s->inc_upper_threshold)){
 
-                                auto l_it = std::lower_bound(std::begin(samples), std::end(samples), origval); // First instance of val.
-                                auto u_it = std::upper_bound(l_it, std::end(samples), origval); // One after last instance of val.
-
                                 double newval = std::numeric_limits<double>::quiet_NaN();
-                                const auto l_rank = std::distance(std::begin(samples), l_it);
+                                double l_rank = 0.0;
+                                double u_rank = 0.0;
+                                if(user_data_s->approximate){
+                                    l_rank = std::round(sketch.cdf(origval) * (N_voxels_f - 1.0));
+                                    u_rank = l_rank;
+                                }else{
+                                    const auto key = order_preserving_key(static_cast<float>(origval));
+                                    const auto k_it = std::lower_bound(std::begin(distinct_keys), std::end(distinct_keys), key);
+                                    const auto k = static_cast<size_t>(std::distance(std::begin(distinct_keys), k_it));
+                                    l_rank = static_cast<double>(first_ranks[k]); // First instance of val.
+                                    u_rank = static_cast<double>(first_ranks[k + 1] - 1); // Last instance of val.
+                                }
 
                                 if(user_data_s->replacement_method == RankPixelsUserData::ReplacementMethod::Rank){
                                     newval = l_rank;
                                 }else if(user_data_s->replacement_method == RankPixelsUserData::ReplacementMethod::Percentile){
-                                    const auto u_rank = std::distance(std::begin(samples), u_it) - 1;
-                                    const auto l_ptile = 100.0 * static_cast<double>(l_rank) / (N_voxels_f - 1.0);
-                                    const auto u_ptile = 100.0 * static_cast<double>(u_rank) / (N_voxels_f - 1.0);
+                                    const auto l_ptile = 100.0 * l_rank / (N_voxels_f - 1.0);
+                                    const auto u_ptile = 100.0 * u_rank / (N_voxels_f - 1.0);
                                     const auto ptile = 0.5 * (u_ptile + l_ptile);
                                     newval = ptile;
                                 }else{
@@ -123,15 +238,11 @@ bool ComputeRankPixels(planar_image_collection<float,double> &imagecoll,
                 UpdateImageWindowCentreWidth( img_refw, minmax_pixel );
 
                 //Report operation progress.
-                {
-                    std::lock_guard<std::mutex> lock(saver_printer);
-                    ++completed;
-                    FUNCINFO("Completed " << completed << " of " << img_count
-                          << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-                }
+                progress.advance();
             }); // thread pool task closure.
                 
         } // Loop over images.
+        tg.wait();
     }
 
     return true;
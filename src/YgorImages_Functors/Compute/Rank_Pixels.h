@@ -24,6 +24,10 @@ struct RankPixelsUserData {
 
     ReplacementMethod replacement_method = ReplacementMethod::Percentile;
 
+    // Whether to estimate ranks from a streaming quantile sketch rather than an exact sort. Memory use is then bounded
+    // regardless of the number of voxels, but ranks and percentiles are approximate (and ties are not distinguished).
+    bool approximate = false;
+
 };
 
 bool ComputeRankPixels(planar_image_collection<float,double> &,
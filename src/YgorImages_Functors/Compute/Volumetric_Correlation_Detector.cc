@@ -10,13 +10,15 @@
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "YgorImages.h"
 #include "YgorMath.h"
 #include "YgorMisc.h"
-#include "YgorStats.h"       //Needed for Stats:: namespace.
 
 #include "YgorClustering.hpp"
+#include "../../Distribution_Sketch.h"
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
@@ -122,49 +124,50 @@ bool ComputeVolumetricCorrelationDetector(planar_image_collection<float,double>
                 shtl2.emplace_back(std::abs(nv - v));
             }
         }
+        const sorted_quantiles<float> ptiles(std::move(shtl2));
 
 /*
 if((pos - vec3<double>(-15.9, 31.9, 1.15)).length() < 0.45){
     std::ofstream f("/tmp/percentile_filtering_good_01.data");
-    for(size_t i = 0; i < 100; ++i) f << i << " " << Stats::Percentile(shtl2, 1.0 * i / 100.0) << std::endl;
+    for(size_t i = 0; i < 100; ++i) f << i << " " << ptiles.quantile(1.0 * i / 100.0) << std::endl;
     f.close();
 }
 
 if((pos - vec3<double>(-7.91, 40.71, 7.45)).length() < 0.45){
     std::ofstream f("/tmp/percentile_filtering_bad_01.data");
-    for(size_t i = 0; i < 100; ++i) f << i << " " << Stats::Percentile(shtl2, 1.0 * i / 100.0) << std::endl;
+    for(size_t i = 0; i < 100; ++i) f << i << " " << ptiles.quantile(1.0 * i / 100.0) << std::endl;
     f.close();
 }
 
 if((pos - vec3<double>(-49.52, -17.69, 7.45)).length() < 0.45){
     std::ofstream f("/tmp/percentile_filtering_bad_02.data");
-    for(size_t i = 0; i < 100; ++i) f << i << " " << Stats::Percentile(shtl2, 1.0 * i / 100.0) << std::endl;
+    for(size_t i = 0; i < 100; ++i) f << i << " " << ptiles.quantile(1.0 * i / 100.0) << std::endl;
     f.close();
 }
 
 if((pos - vec3<double>(-63.91, 74.31, 7.45)).length() < 0.45){
     std::ofstream f("/tmp/percentile_filtering_bad_03.data");
-    for(size_t i = 0; i < 100; ++i) f << i << " " << Stats::Percentile(shtl2, 1.0 * i / 100.0) << std::endl;
+    for(size_t i = 0; i < 100; ++i) f << i << " " << ptiles.quantile(1.0 * i / 100.0) << std::endl;
     f.close();
 }
 
 if((pos - vec3<double>(0.08, 88.71, 57.85)).length() < 0.45){
     std::ofstream f("/tmp/percentile_filtering_bad_04.data");
-    for(size_t i = 0; i < 100; ++i) f << i << " " << Stats::Percentile(shtl2, 1.0 * i / 100.0) << std::endl;
+    for(size_t i = 0; i < 100; ++i) f << i << " " << ptiles.quantile(1.0 * i / 100.0) << std::endl;
     f.close();
 }
 */
 
         // Works pretty good for 5mm. Works OK for 15mm, but not great.
-        //const auto low = Stats::Percentile(shtl2, 0.01);
-        //const auto high = Stats::Percentile(shtl2, 0.25);
+        //const auto low = ptiles.quantile(0.01);
+        //const auto high = ptiles.quantile(0.25);
 
         // Tuned for 5mm, but works worse than previous.
-        //const auto low = Stats::Percentile(shtl2, 0.15);
-        //const auto high = Stats::Percentile(shtl2, 0.30);
+        //const auto low = ptiles.quantile(0.15);
+        //const auto high = ptiles.quantile(0.30);
 
-        const auto low = Stats::Percentile(shtl2, user_data_s->low);
-        const auto high = Stats::Percentile(shtl2, user_data_s->high);
+        const auto low = ptiles.quantile(user_data_s->low);
+        const auto high = ptiles.quantile(user_data_s->high);
 
         return (high - low);
     }; 
@@ -7,13 +7,20 @@
 #include <list>
 #include <map>
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <tuple>
+#include <vector>
 
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
+#include "../Rectilinear_Volume.h"
 #include "Volumetric_Neighbourhood_Sampler.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -23,6 +30,340 @@
 #include "YgorClustering.hpp"
 
 
+namespace {
+
+using VNSUD = ComputeVolumetricNeighbourhoodSamplerUserData;
+
+// A contiguous run of neighbourhood voxels along the column axis, relative to the current voxel.
+struct offset_run_t {
+    long int d_img;
+    long int d_row;
+    long int d_col_lo;
+    long int d_col_hi; // Inclusive.
+};
+
+// Decomposes a neighbourhood, given as (row, column, image) triplets, into column runs. An empty result is returned if
+// any triplets are duplicated since they would be weighted differently by the sliding-window reductions.
+std::vector<offset_run_t> decompose_into_runs(std::vector<std::array<long int, 3>> triplets){
+    std::sort(std::begin(triplets), std::end(triplets), [](const std::array<long int, 3> &L,
+                                                           const std::array<long int, 3> &R) -> bool {
+        return std::make_tuple(L[2], L[0], L[1]) < std::make_tuple(R[2], R[0], R[1]);
+    });
+    if(std::adjacent_find(std::begin(triplets), std::end(triplets)) != std::end(triplets)){
+        return {};
+    }
+
+    std::vector<offset_run_t> runs;
+    for(const auto &t : triplets){
+        if( !runs.empty()
+        &&  (runs.back().d_img == t[2])
+        &&  (runs.back().d_row == t[0])
+        &&  (runs.back().d_col_hi + 1 == t[1]) ){
+            runs.back().d_col_hi = t[1];
+        }else{
+            runs.push_back({ t[2], t[0], t[1], t[1] });
+        }
+    }
+    return runs;
+}
+
+// Computes out[i] = op(in[i], ..., in[i+L-1]) for i in [0, N-L] with a constant number of comparisons per element,
+// irrespective of the window width, using the van Herk/Gil-Werman algorithm.
+template <class Op>
+void van_herk_gil_werman(const float *in, long int stride, long int N, long int L, Op op,
+                         std::vector<float> &g, std::vector<float> &h, std::vector<float> &out){
+    g.resize(N);
+    h.resize(N);
+    out.resize(N);
+    for(long int i = 0; i < N; ++i){
+        const auto v = in[i * stride];
+        g[i] = ((i % L) == 0) ? v : op(g[i-1], v);
+    }
+    for(long int i = N - 1; 0 <= i; --i){
+        const auto v = in[i * stride];
+        h[i] = ( ((i % L) == (L - 1)) || (i == (N - 1)) ) ? v : op(h[i+1], v);
+    }
+    for(long int i = 0; (i + L) <= N; ++i){
+        out[i] = op(h[i], g[i + L - 1]);
+    }
+}
+
+// Histogram of voxel value ranks supporting incremental insertion, removal, and order statistic queries. Queries track
+// a cursor and skip over coarse blocks, so they are cheap when successive queries are near one another.
+class sliding_rank_histogram {
+    static constexpr long int block_bits = 8;
+    static constexpr long int block_size = 1L << block_bits;
+
+    std::vector<uint32_t> fine;
+    std::vector<uint32_t> coarse;
+    long int cursor = 0;
+    long int below = 0; // Number of ranks less than the cursor.
+
+  public:
+    explicit sliding_rank_histogram(size_t N_ranks)
+      : fine(((N_ranks / block_size) + 1) * block_size, 0),
+        coarse((N_ranks / block_size) + 1, 0) {}
+
+    void insert(uint32_t x){
+        ++this->fine[x];
+        ++this->coarse[x >> block_bits];
+        if(static_cast<long int>(x) < this->cursor) ++this->below;
+    }
+
+    void remove(uint32_t x){
+        --this->fine[x];
+        --this->coarse[x >> block_bits];
+        if(static_cast<long int>(x) < this->cursor) --this->below;
+    }
+
+    // The rank of the k-th smallest (zero-based) element, which must exist.
+    uint32_t kth(long int k){
+        while(k < this->below){
+            const auto b = this->cursor >> block_bits;
+            if( ((this->cursor % block_size) == 0)
+            &&  (0 < b)
+            &&  (k < this->below - static_cast<long int>(this->coarse[b - 1])) ){
+                this->below -= this->coarse[b - 1];
+                this->cursor -= block_size;
+                continue;
+            }
+            --this->cursor;
+            this->below -= this->fine[this->cursor];
+        }
+        while(true){
+            const auto b = this->cursor >> block_bits;
+            if( ((this->cursor % block_size) == 0)
+            &&  (this->below + static_cast<long int>(this->coarse[b]) <= k) ){
+                this->below += this->coarse[b];
+                this->cursor += block_size;
+                continue;
+            }
+            if(k < this->below + static_cast<long int>(this->fine[this->cursor])){
+                return static_cast<uint32_t>(this->cursor);
+            }
+            this->below += this->fine[this->cursor];
+            ++this->cursor;
+        }
+    }
+};
+
+// Integer voxel offsets of a neighbourhood within a packed volume, computed once per neighbourhood shape.
+struct offset_table_t {
+    std::vector<std::array<long int, 3>> triplets; // (row, column, image), as for user-provided selections.
+    std::vector<long int> linear;                   // The equivalent offsets within the packed buffer.
+    std::array<long int, 3> lo = {{ 0, 0, 0 }};     // Bounding box of the triplets.
+    std::array<long int, 3> hi = {{ 0, 0, 0 }};
+    bool pad_with_nan = false;                      // Whether out-of-bounds neighbours are emitted as NaN or omitted.
+};
+
+offset_table_t make_offset_table(const rectilinear_volume &vol,
+                                 std::vector<std::array<long int, 3>> triplets,
+                                 bool pad_with_nan){
+    offset_table_t t;
+    t.triplets = std::move(triplets);
+    t.pad_with_nan = pad_with_nan;
+    t.linear.reserve(t.triplets.size());
+    for(const auto &o : t.triplets){
+        for(size_t i = 0; i < 3; ++i){
+            t.lo[i] = std::min(t.lo[i], o[i]);
+            t.hi[i] = std::max(t.hi[i], o[i]);
+        }
+        t.linear.push_back( o[2] * vol.image_stride + o[0] * vol.row_stride + o[1] * vol.column_stride );
+    }
+    return t;
+}
+
+// Voxels with centres within the given distance, accounting for the (possibly anisotropic) grid spacing. Voxels are
+// ordered by image, row, and then column.
+std::vector<std::array<long int, 3>> spherical_triplets(const rectilinear_volume &vol, double max_dist){
+    std::vector<std::array<long int, 3>> out;
+    if(!(0.0 <= max_dist)) return out;
+    const auto dz = std::abs(vol.image_spacing());
+    const auto di_max = static_cast<long int>( std::floor(max_dist / vol.pxl_dx) );
+    const auto dj_max = static_cast<long int>( std::floor(max_dist / vol.pxl_dy) );
+    const auto dk_max = (0.0 < dz) ? static_cast<long int>( std::floor(max_dist / dz) ) : 0L;
+    for(long int k = -dk_max; k <= dk_max; ++k){
+        for(long int i = -di_max; i <= di_max; ++i){
+            for(long int j = -dj_max; j <= dj_max; ++j){
+                const auto x = static_cast<double>(i) * vol.pxl_dx;
+                const auto y = static_cast<double>(j) * vol.pxl_dy;
+                const auto z = static_cast<double>(k) * dz;
+                if(std::sqrt(x*x + y*y + z*z) <= max_dist) out.push_back({{ i, j, k }});
+            }
+        }
+    }
+    return out;
+}
+
+// Fills the scratch buffer with the neighbourhood of a voxel. Neighbourhoods entirely within the volume, which are
+// the vast majority, are gathered without any bounds checks.
+void gather_neighbourhood(const rectilinear_volume &vol, const offset_table_t &t,
+                          long int img, long int row, long int col, long int chan,
+                          std::vector<float> &shtl){
+    shtl.clear();
+    const auto i0 = vol.index(img, row, col, chan);
+    if( vol.in_bounds(img + t.lo[2], row + t.lo[0], col + t.lo[1])
+    &&  vol.in_bounds(img + t.hi[2], row + t.hi[0], col + t.hi[1]) ){
+        for(const auto &o : t.linear) shtl.push_back( vol.data[i0 + o] );
+        return;
+    }
+    for(size_t n = 0; n < t.triplets.size(); ++n){
+        const auto &o = t.triplets[n];
+        if(vol.in_bounds(img + o[2], row + o[0], col + o[1])){
+            shtl.push_back( vol.data[i0 + t.linear[n]] );
+        }else if(t.pad_with_nan){
+            shtl.push_back( std::numeric_limits<float>::quiet_NaN() );
+        }
+    }
+}
+
+constexpr uint32_t no_rank = std::numeric_limits<uint32_t>::max();
+
+// Sliding-window reductions for a single image. Voxels are laid out like the images of the volume.
+struct sliding_plane_t {
+    std::vector<float> values;
+    std::vector<uint8_t> valid; // Whether the voxel's entire neighbourhood was within the volume and finite.
+};
+
+void sliding_window_reduce(const rectilinear_volume &vol,
+                           long int img,
+                           long int channel,
+                           const std::vector<offset_run_t> &runs,
+                           VNSUD::Reduction reduction,
+                           const std::vector<float> &distinct_values,
+                           const std::vector<uint32_t> &ranks,
+                           sliding_plane_t &out){
+    out.values.assign(vol.image_stride, 0.0f);
+    out.valid.assign(vol.image_stride, 0);
+
+    long int dk_lo = 0, dk_hi = 0, dr_lo = 0, dr_hi = 0, dc_lo = 0, dc_hi = 0;
+    long int N_neighbours = 0;
+    for(const auto &run : runs){
+        dk_lo = std::min(dk_lo, run.d_img);
+        dk_hi = std::max(dk_hi, run.d_img);
+        dr_lo = std::min(dr_lo, run.d_row);
+        dr_hi = std::max(dr_hi, run.d_row);
+        dc_lo = std::min(dc_lo, run.d_col_lo);
+        dc_hi = std::max(dc_hi, run.d_col_hi);
+        N_neighbours += run.d_col_hi - run.d_col_lo + 1;
+    }
+    if( (img + dk_lo < 0) || (vol.images <= img + dk_hi) ) return;
+    const auto r_begin = -dr_lo;
+    const auto r_end = vol.rows - dr_hi;
+    const auto c_begin = -dc_lo;
+    const auto c_end = vol.columns - dc_hi;
+    if( (r_end <= r_begin) || (c_end <= c_begin) ) return;
+
+    const auto N_cols = vol.columns;
+    const auto cs = vol.column_stride;
+    std::vector<long int> nonfinite(N_cols);
+    std::vector<long int> prefix_nonfinite(N_cols + 1);
+    std::vector<double> sums(N_cols);
+    std::vector<double> prefix_sums(N_cols + 1);
+    std::vector<float> acc(N_cols);
+    std::vector<float> g, h, w;
+    std::optional<sliding_rank_histogram> hist;
+    if(reduction == VNSUD::Reduction::Median) hist.emplace(distinct_values.size());
+
+    const auto f_min = [](float a, float b) -> float { return (b < a) ? b : a; };
+    const auto f_max = [](float a, float b) -> float { return (a < b) ? b : a; };
+
+    for(long int chan = 0; chan < vol.channels; ++chan){
+        if( (0 <= channel) && (chan != channel) ) continue;
+
+        for(long int r = r_begin; r < r_end; ++r){
+            std::fill(std::begin(nonfinite), std::end(nonfinite), 0);
+            std::fill(std::begin(sums), std::end(sums), 0.0);
+            std::fill(std::begin(acc), std::end(acc), (reduction == VNSUD::Reduction::Min)
+                                                        ?  std::numeric_limits<float>::infinity()
+                                                        : -std::numeric_limits<float>::infinity());
+
+            for(const auto &run : runs){
+                const float *src = vol.data.data() + vol.index(img + run.d_img, r + run.d_row, 0, chan);
+                const auto L = run.d_col_hi - run.d_col_lo + 1;
+
+                // Non-finite voxels are excluded from the sums so they do not contaminate neighbouring windows.
+                for(long int c = 0; c < N_cols; ++c){
+                    const auto v = src[c * cs];
+                    const auto is_finite = std::isfinite(v);
+                    prefix_nonfinite[c + 1] = prefix_nonfinite[c] + (is_finite ? 0 : 1);
+                    prefix_sums[c + 1] = prefix_sums[c] + (is_finite ? static_cast<double>(v) : 0.0);
+                }
+                for(long int c = c_begin; c < c_end; ++c){
+                    nonfinite[c] += prefix_nonfinite[c + run.d_col_hi + 1] - prefix_nonfinite[c + run.d_col_lo];
+                }
+
+                if(reduction == VNSUD::Reduction::Mean){
+                    for(long int c = c_begin; c < c_end; ++c){
+                        sums[c] += prefix_sums[c + run.d_col_hi + 1] - prefix_sums[c + run.d_col_lo];
+                    }
+                }else if( (reduction == VNSUD::Reduction::Min)
+                      ||  (reduction == VNSUD::Reduction::Max) ){
+                    if(reduction == VNSUD::Reduction::Min){
+                        van_herk_gil_werman(src, cs, N_cols, L, f_min, g, h, w);
+                        for(long int c = c_begin; c < c_end; ++c) acc[c] = f_min(acc[c], w[c + run.d_col_lo]);
+                    }else{
+                        van_herk_gil_werman(src, cs, N_cols, L, f_max, g, h, w);
+                        for(long int c = c_begin; c < c_end; ++c) acc[c] = f_max(acc[c], w[c + run.d_col_lo]);
+                    }
+                }
+            }
+
+            // Slide the histogram along the row, exchanging the voxels that enter and leave each run.
+            if(hist){
+                const auto rank_at = [&](const offset_run_t &run, long int c) -> uint32_t {
+                    return ranks[vol.index(img + run.d_img, r + run.d_row, c, chan)];
+                };
+                for(long int c = c_begin; c < c_end; ++c){
+                    for(const auto &run : runs){
+                        if(c == c_begin){
+                            for(auto cc = c + run.d_col_lo; cc <= c + run.d_col_hi; ++cc){
+                                const auto x = rank_at(run, cc);
+                                if(x != no_rank) hist->insert(x);
+                            }
+                        }else{
+                            const auto x_out = rank_at(run, c - 1 + run.d_col_lo);
+                            const auto x_in = rank_at(run, c + run.d_col_hi);
+                            if(x_out != no_rank) hist->remove(x_out);
+                            if(x_in != no_rank) hist->insert(x_in);
+                        }
+                    }
+                    if(nonfinite[c] != 0) continue;
+
+                    if((N_neighbours % 2) == 1){
+                        acc[c] = distinct_values[hist->kth(N_neighbours / 2)];
+                    }else{
+                        const auto a = distinct_values[hist->kth(N_neighbours / 2 - 1)];
+                        const auto b = distinct_values[hist->kth(N_neighbours / 2)];
+                        acc[c] = (a + b) * 0.5f;
+                    }
+                }
+
+                // Empty the histogram for the next row.
+                const auto c = c_end - 1;
+                for(const auto &run : runs){
+                    for(auto cc = c + run.d_col_lo; cc <= c + run.d_col_hi; ++cc){
+                        const auto x = rank_at(run, cc);
+                        if(x != no_rank) hist->remove(x);
+                    }
+                }
+            }
+
+            for(long int c = c_begin; c < c_end; ++c){
+                if(nonfinite[c] != 0) continue;
+                const auto i = r * vol.row_stride + c * cs + chan;
+                out.values[i] = (reduction == VNSUD::Reduction::Mean)
+                              ? static_cast<float>(sums[c] / static_cast<double>(N_neighbours))
+                              : acc[c];
+                out.valid[i] = 1;
+            }
+        }
+    }
+}
+
+} // namespace
+
+
 bool ComputeVolumetricNeighbourhoodSampler(planar_image_collection<float,double> &imagecoll,
                       std::list<std::reference_wrapper<planar_image_collection<float,double>>> /*external_imgs*/,
                       std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
@@ -80,6 +421,88 @@ bool ComputeVolumetricNeighbourhoodSampler(planar_image_collection<float,double>
     const auto orientation_normal = Average_Contour_Normals(ccsl);
     planar_image_adjacency<float,double> img_adj( {}, { { std::ref(ref_imagecoll) } }, orientation_normal );
 
+    // For integer-addressable neighbourhoods, pack the reference images into a contiguous volume ordered to match the
+    // adjacency indices so neighbouring voxels can be addressed directly instead of via per-image lookups.
+    std::optional<rectilinear_volume> ref_vol;
+    if( (user_data_s->neighbourhood == VNSUD::Neighbourhood::Selection)
+    ||  ( (user_data_s->neighbourhood == VNSUD::Neighbourhood::Cubic) && is_regular_grid )
+    ||  ( (user_data_s->neighbourhood == VNSUD::Neighbourhood::Spherical) && is_regular_grid
+                                                                         && user_data_s->tabulate_spherical ) ){
+        std::list<std::reference_wrapper<planar_image<float,double>>> adj_ordered_imgs;
+        for(long int i = 0; img_adj.index_present(i); ++i){
+            adj_ordered_imgs.push_back( img_adj.index_to_image(i) );
+        }
+        if(adj_ordered_imgs.size() == ref_imagecoll.images.size()){
+            ref_vol.emplace(adj_ordered_imgs);
+        }
+    }
+
+    // Tabulate the neighbourhood offsets once so voxels can be sampled without any per-voxel geometry.
+    std::optional<offset_table_t> table;
+    if(ref_vol){
+        if(user_data_s->neighbourhood == VNSUD::Neighbourhood::Selection){
+            table = make_offset_table(*ref_vol, user_data_s->voxel_triplets, /*pad_with_nan=*/ true);
+
+        }else if(user_data_s->neighbourhood == VNSUD::Neighbourhood::Cubic){
+            // Note: The neighbouring voxel CENTRE must be within the user-provided maximum distance.
+            const auto dx_u = static_cast<long int>( std::floor( user_data_s->maximum_distance / ref_vol->pxl_dx ) );
+            const auto dy_u = static_cast<long int>( std::floor( user_data_s->maximum_distance / ref_vol->pxl_dy ) );
+            const auto dz_u = static_cast<long int>( std::floor( user_data_s->maximum_distance / ref_vol->pxl_dz ) );
+            std::vector<std::array<long int, 3>> triplets;
+            for(long int k = -dz_u; k <= dz_u; ++k){
+                for(long int i = -dx_u; i <= dx_u; ++i){
+                    for(long int j = -dy_u; j <= dy_u; ++j){
+                        triplets.push_back({{ i, j, k }});
+                    }
+                }
+            }
+            table = make_offset_table(*ref_vol, triplets, /*pad_with_nan=*/ false);
+
+        }else if(user_data_s->neighbourhood == VNSUD::Neighbourhood::Spherical){
+            table = make_offset_table(*ref_vol, spherical_triplets(*ref_vol, user_data_s->maximum_distance),
+                                      /*pad_with_nan=*/ false);
+        }
+    }
+    if(table){
+        FUNCINFO("Neighbourhood comprises " << table->triplets.size() << " tabulated voxel offsets");
+    }
+
+    // Prepare the sliding-window reductions, if possible. Other voxels use the generic sampling approach below.
+    std::vector<offset_run_t> runs;
+    std::vector<float> distinct_values;
+    std::vector<uint32_t> ranks;
+    if( table && (user_data_s->reduction != VNSUD::Reduction::Custom) ){
+        runs = decompose_into_runs(table->triplets);
+
+        // The median is tracked using the ranks of the participating voxel values.
+        if( !runs.empty() && (user_data_s->reduction == VNSUD::Reduction::Median) ){
+            const auto &vol = *ref_vol;
+            const auto participates = [&](long int chan, float v) -> bool {
+                return ( (user_data_s->channel < 0) || (chan == user_data_s->channel) ) && std::isfinite(v);
+            };
+            for(size_t i = 0; i < vol.data.size(); ++i){
+                const auto v = vol.data[i];
+                if(participates(static_cast<long int>(i) % vol.column_stride, v)) distinct_values.push_back(v);
+            }
+            std::sort(std::begin(distinct_values), std::end(distinct_values));
+            distinct_values.erase( std::unique(std::begin(distinct_values), std::end(distinct_values)),
+                                   std::end(distinct_values) );
+
+            ranks.resize(vol.data.size());
+            parallel_for(0, static_cast<long int>(vol.data.size()), [&](long int i) -> void {
+                const auto v = vol.data[i];
+                ranks[i] = no_rank;
+                if(participates(i % vol.column_stride, v)){
+                    const auto it = std::lower_bound(std::begin(distinct_values), std::end(distinct_values), v);
+                    ranks[i] = static_cast<uint32_t>(std::distance(std::begin(distinct_values), it));
+                }
+            });
+        }
+        if(!runs.empty()){
+            FUNCINFO("Using sliding-window reductions with " << runs.size() << " neighbourhood runs");
+        }
+    }
+
     Mutate_Voxels_Opts mv_opts;
     mv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
     mv_opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
@@ -89,14 +512,17 @@ bool ComputeVolumetricNeighbourhoodSampler(planar_image_collection<float,double>
     mv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
 
 
-    asio_thread_pool tp;
-    std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
-    long int completed = 0;
     const long int img_count = imagecoll.images.size();
+    progress_tracker progress("neighbourhood sampling", img_count,
+                              [](long int completed, long int total, double) -> void {
+        FUNCINFO("Completed " << completed << " of " << total
+              << " --> " << static_cast<int>(1000.0*(completed)/total)/10.0 << "% done");
+    });
+    task_group tg;
 
     for(auto &img : imagecoll.images){
         std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
-        tp.submit_task([&,img_refw]() -> void {
+        tg.run([&,img_refw]() -> void {
 
             // Identify the reference image which overlaps the whole image, if any.
             //
@@ -113,8 +539,21 @@ bool ComputeVolumetricNeighbourhoodSampler(planar_image_collection<float,double>
             const auto pxl_dy = ref_img_refw.get().pxl_dy;
             const auto pxl_dz = ref_img_refw.get().pxl_dz;
 
+            if(!img_adj.image_present( ref_img_refw )){
+                throw std::logic_error("One or more images were not included in the image adjacency determination. Refusing to continue.");
+            }
+            const auto R_num = img_adj.image_to_index( ref_img_refw );
+
+            // Compute the sliding-window reductions for the whole image up-front.
+            sliding_plane_t plane;
+            if(!runs.empty()){
+                sliding_window_reduce(*ref_vol, R_num, user_data_s->channel,
+                                      runs, user_data_s->reduction, distinct_values, ranks, plane);
+            }
+
+            // Scratch space, reused for every voxel.
             std::vector<float> shtl;
-            shtl.reserve(100); // An arbitrary guess.
+            shtl.reserve( table ? table->triplets.size() : 100 ); // An arbitrary guess for other neighbourhoods.
 
             auto f_bounded = [&,ref_img_refw](long int E_row, long int E_col, long int channel, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
                 // No-op if this is the wrong channel.
@@ -126,26 +565,27 @@ bool ComputeVolumetricNeighbourhoodSampler(planar_image_collection<float,double>
                 const auto E_pos = ref_img_refw.get().position(E_row, E_col);
                 const auto E_val = ref_img_refw.get().value(E_row, E_col, channel);
 
-                // Calculate the index in the intersecting image.
-                const auto index = ref_img_refw.get().index(E_pos, channel);
-                if(index < 0){
-                    throw std::logic_error("Duplicated image volume differs in position. Cannot continue.");
-                }
+                // The reference image is a copy of the image being edited, so they share row and column numbers.
+                const auto R_row = E_row;
+                const auto R_col = E_col;
 
-                // Determine the row, column, and image numbers for the reference image.
-                const auto rcc = ref_img_refw.get().row_column_channel_from_index(index);
-                const auto R_row = std::get<0>(rcc);
-                const auto R_col = std::get<1>(rcc);
-                if(!img_adj.image_present( ref_img_refw )){
-                    throw std::logic_error("One or more images were not included in the image adjacency determination. Refusing to continue.");
+                if(!plane.valid.empty()){
+                    const auto i = ref_vol->index(0, R_row, R_col, channel);
+                    if(plane.valid[i]){
+                        voxel_val = plane.values[i];
+                        return;
+                    }
                 }
-                const auto R_num = img_adj.image_to_index( ref_img_refw );
 
                 shtl.clear();
 
+                // Sample a tabulated neighbourhood.
+                if(table){
+                    gather_neighbourhood(*ref_vol, *table, R_num, R_row, R_col, channel, shtl);
+
                 // Sample the neighbourhood in a growing cubic pattern until a spherical boundary is reached.
                 // Growth of the pattern continues until the entire spherical neighbourhood has been sampled.
-                if(user_data_s->neighbourhood == ComputeVolumetricNeighbourhoodSamplerUserData::Neighbourhood::Spherical){
+                }else if(user_data_s->neighbourhood == ComputeVolumetricNeighbourhoodSamplerUserData::Neighbourhood::Spherical){
 
                     // Create a growing 3D 'wavefront' in which the outer shell of a rectangular bunch of adjacent
                     // voxels is evaluated compared to the edit image's voxel value.
@@ -254,8 +694,8 @@ bool ComputeVolumetricNeighbourhoodSampler(planar_image_collection<float,double>
 
                         float res = std::numeric_limits<float>::quiet_NaN();
                         if(img_adj.index_present(l_img)
-                        && isininc(0, l_row, ref_img_refw.get().rows - 1L)
-                        && isininc(0, l_col, ref_img_refw.get().columns - 1L) ){
+                             && isininc(0, l_row, ref_img_refw.get().rows - 1L)
+                             && isininc(0, l_col, ref_img_refw.get().columns - 1L) ){
                             auto adj_img_refw = img_adj.index_to_image(l_img);
                             res = adj_img_refw.get().value(l_row, l_col, channel);
                         }
@@ -285,15 +725,11 @@ bool ComputeVolumetricNeighbourhoodSampler(planar_image_collection<float,double>
             UpdateImageWindowCentreWidth( img_refw );
 
             //Report operation progress.
-            {
-                std::lock_guard<std::mutex> lock(saver_printer);
-                ++completed;
-                FUNCINFO("Completed " << completed << " of " << img_count
-                      << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-            }
+            progress.advance();
         }); // thread pool task closure.
 
     }
+    tg.wait();
 
 
     return true;
@@ -35,6 +35,13 @@ struct ComputeVolumetricNeighbourhoodSamplerUserData {
     // Note: Applicable only for whole-neighbourhood sampling.
     double maximum_distance = 3.0;
 
+    // Whether spherical neighbourhoods of regular grids are sampled using a table of voxel offsets computed once from
+    // the grid spacing, rather than by growing a wavefront and computing distances for every voxel.
+    //
+    // Note: Voxels lying on the spherical boundary (to within floating-point rounding) may be classified differently
+    //       by the two approaches.
+    bool tabulate_spherical = true;
+
     // -----------------------------
     // Voxel selection for specific voxel addressing relative to the current voxel (in integer voxel coordinates).
     //
@@ -64,6 +71,24 @@ struct ComputeVolumetricNeighbourhoodSamplerUserData {
         return v; // Effectively does nothing.
     };
 
+    // -----------------------------
+    // Identifies f_reduce as a standard reduction that can be computed incrementally while sliding the neighbourhood
+    // along each row (i.e., van Herk/Gil-Werman for min and max, running sums for the mean, and a sliding histogram
+    // for the median).
+    //
+    // Note: The sliding-window implementations are only used for integer-addressable neighbourhoods (i.e., cubic
+    //       neighbourhoods of regular grids and specific-voxel selections) and only for voxels whose entire
+    //       neighbourhood is within the volume and finite. f_reduce is used for all other voxels, so it must implement
+    //       the same reduction.
+    enum class
+    Reduction {
+        Custom,       // Only f_reduce is used.
+        Min,
+        Mean,
+        Median,
+        Max
+    } reduction = Reduction::Custom;
+
     // -----------------------------
     // Outgoing image description to imbue.
     std::string description;
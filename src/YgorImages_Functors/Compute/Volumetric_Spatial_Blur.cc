@@ -10,6 +10,8 @@
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <cmath>
+#include <string>
 
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -20,7 +22,8 @@
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
-#include "Volumetric_Neighbourhood_Sampler.h"
+#include "../Rectilinear_Volume.h"
+#include "../Volume_Convolution.h"
 
 #include "Volumetric_Spatial_Blur.h"
 
@@ -30,12 +33,13 @@ bool ComputeVolumetricSpatialBlur(planar_image_collection<float,double> &imageco
                       std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
                       std::any user_data ){
 
-    // This routine computes 3D blurs. Currently, only Gaussians are supported. Specifically, a 1-sigma Gaussian (in
-    // pixel units, not DICOM units) with a fixed 3*sigma extent. This blur is separable and is thus applied in three
-    // directions successively. The spacing between adjacent voxels is not taken into account, so voxels should have
-    // isotropic dimensions (or the blur will be non-isotropic). The effective window considered by this Gaussian is
-    // 7x7x7 voxels. If voxels are inaccessible or non-finite they will be ignored and other voxels in the neighbourhood
-    // will be more heavily weighted.
+    // This routine computes 3D blurs. Currently, only Gaussians are supported. Specifically, a Gaussian (in pixel
+    // units, not DICOM units) with a 3*sigma extent. This blur is separable and is thus applied in three directions
+    // successively. The spacing between adjacent voxels is not taken into account, so voxels should have isotropic
+    // dimensions (or the blur will be non-isotropic). For sigma=1 the effective window considered by this Gaussian is
+    // 7x7x7 voxels. For large sigmas a recursive filter is used, so the cost does not depend on sigma. If voxels are
+    // inaccessible or non-finite they will be ignored and other voxels in the neighbourhood will be more heavily
+    // weighted.
     //
     // Note: The provided image collection must be rectilinear. This requirement comes foremost from a limitation of the
     // implementation. 
@@ -56,117 +60,22 @@ bool ComputeVolumetricSpatialBlur(planar_image_collection<float,double> &imageco
     }
 
     if(user_data_s->estimator == VolumetricSpatialBlurEstimator::Gaussian){
-        auto f_reduce = [](float, std::vector<float> &shtl, vec3<double>) -> float {
-                          double f = 0.0;
-                          double w = 0.0;
-
-                          // Note: The following weights come from the 1D Gaussian with sigma=1 integrated over the
-                          //       length of each voxel. These weights are normalized to 1, so the w summation is only
-                          //       necessary in case some voxels are inaccessible.
-                          if(std::isfinite(shtl[0])){
-                              w += 0.006;
-                              f += 0.006 * shtl[0];
-                          }
-                          if(std::isfinite(shtl[1])){
-                              w += 0.061;
-                              f += 0.061 * shtl[1];
-                          }
-                          if(std::isfinite(shtl[2])){
-                              w += 0.242;
-                              f += 0.242 * shtl[2];
-                          }
-                          if(std::isfinite(shtl[3])){
-                              w += 0.382;
-                              f += 0.382 * shtl[3];
-                          }
-                          if(std::isfinite(shtl[4])){
-                              w += 0.242;
-                              f += 0.242 * shtl[4];
-                          }
-                          if(std::isfinite(shtl[5])){
-                              w += 0.061;
-                              f += 0.061 * shtl[5];
-                          }
-                          if(std::isfinite(shtl[6])){
-                              w += 0.006;
-                              f += 0.006 * shtl[6];
-                          }
-                          
-                          if(w < 1E-3){
-                              f = std::numeric_limits<double>::quiet_NaN();
-                          }
-                          return f / w;
-                      };
-
-        // row-direction.
-        {
-            FUNCINFO("Convolving row-aligned direction now..");
-            ComputeVolumetricNeighbourhoodSamplerUserData ud;
-            ud.channel = user_data_s->channel;
-            ud.neighbourhood = ComputeVolumetricNeighbourhoodSamplerUserData::Neighbourhood::Selection;
-            ud.f_reduce = f_reduce;
-
-            ud.voxel_triplets = {{ std::array<long int, 3>{ -3,  0,  0 },    // 0
-                                   std::array<long int, 3>{ -2,  0,  0 },    // 1
-                                   std::array<long int, 3>{ -1,  0,  0 },    // 2
-                                   std::array<long int, 3>{  0,  0,  0 },    // 3
-                                   std::array<long int, 3>{  1,  0,  0 },    // 4
-                                   std::array<long int, 3>{  2,  0,  0 },    // 5
-                                   std::array<long int, 3>{  3,  0,  0 } }}; // 6
-
-
-            // Invoke the volumetric sampling routine to compute the above functors.
-            if(!imagecoll.Compute_Images( ComputeVolumetricNeighbourhoodSampler, 
-                                          {}, ccsl, &ud )){
-                throw std::runtime_error("Unable to compute row-aligned volumetric spatial blur.");
-            }
+        const auto sigma = user_data_s->sigma;
+        if(!std::isfinite(sigma) || (sigma <= 0.0)){
+            FUNCWARN("Gaussian sigma must be finite and positive. Cannot continue with computation");
+            return false;
         }
 
-        // column-direction.
-        {
-            FUNCINFO("Convolving column-aligned direction now..");
-            ComputeVolumetricNeighbourhoodSamplerUserData ud;
-            ud.channel = user_data_s->channel;
-            ud.neighbourhood = ComputeVolumetricNeighbourhoodSamplerUserData::Neighbourhood::Selection;
-            ud.f_reduce = f_reduce;
-
-            ud.voxel_triplets = {{ std::array<long int, 3>{  0, -3,  0 },    // 0
-                                   std::array<long int, 3>{  0, -2,  0 },    // 1
-                                   std::array<long int, 3>{  0, -1,  0 },    // 2
-                                   std::array<long int, 3>{  0,  0,  0 },    // 3
-                                   std::array<long int, 3>{  0,  1,  0 },    // 4
-                                   std::array<long int, 3>{  0,  2,  0 },    // 5
-                                   std::array<long int, 3>{  0,  3,  0 } }}; // 6
-
-            // Invoke the volumetric sampling routine to compute the above functors.
-            if(!imagecoll.Compute_Images( ComputeVolumetricNeighbourhoodSampler, 
-                                          {}, ccsl, &ud )){
-                throw std::runtime_error("Unable to compute column-aligned volumetric blur.");
-            }
-        }
-
-        // ortho-direction.
-        {
-            FUNCINFO("Convolving ortho-aligned direction now..");
-            ComputeVolumetricNeighbourhoodSamplerUserData ud;
-            ud.channel = user_data_s->channel;
-            ud.neighbourhood = ComputeVolumetricNeighbourhoodSamplerUserData::Neighbourhood::Selection;
-            ud.f_reduce = f_reduce;
-
-            ud.voxel_triplets = {{ std::array<long int, 3>{  0,  0, -3 },    // 0
-                                   std::array<long int, 3>{  0,  0, -2 },    // 1
-                                   std::array<long int, 3>{  0,  0, -1 },    // 2
-                                   std::array<long int, 3>{  0,  0,  0 },    // 3
-                                   std::array<long int, 3>{  0,  0,  1 },    // 4
-                                   std::array<long int, 3>{  0,  0,  2 },    // 5
-                                   std::array<long int, 3>{  0,  0,  3 } }}; // 6
-
-            // Invoke the volumetric sampling routine to compute the above functors.
-            if(!imagecoll.Compute_Images( ComputeVolumetricNeighbourhoodSampler, 
-                                          {}, ccsl, &ud )){
-                throw std::runtime_error("Unable to compute ortho-aligned volumetric blur.");
-            }
-        }
+        // The blur is computed on a packed copy of the whole volume so that each 1D pass sees the complete output of
+        // the previous pass, and then written back only within the contours.
+        const auto orientation_normal = Average_Contour_Normals(ccsl);
+        const auto method = user_data_s->method;
+        volume_convolution::apply_within_contours(imagecoll, orientation_normal, ccsl, user_data_s->channel,
+            [&](rectilinear_volume &vol, long int c) -> void {
+                FUNCINFO("Blurring channel " << c << " with sigma = " << sigma);
+                volume_convolution::gaussian_blur(vol, c, {{ sigma, sigma, sigma }},
+                                                  volume_convolution::boundary_t::Renormalize, method);
+            });
 
     }else{
         throw std::invalid_argument("Unrecognized user-provided estimator argument.");
@@ -177,6 +86,9 @@ bool ComputeVolumetricSpatialBlur(planar_image_collection<float,double> &imageco
     std::string img_desc;
     if(user_data_s->estimator == VolumetricSpatialBlurEstimator::Gaussian){
         img_desc += "volumetric Gaussian blurred";
+        if(user_data_s->sigma != 1.0){
+            img_desc += " (sigma = " + std::to_string(user_data_s->sigma) + ")";
+        }
 
     }else{
         throw std::invalid_argument("Unrecognized user-provided estimator");
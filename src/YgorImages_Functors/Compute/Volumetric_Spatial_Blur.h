@@ -5,13 +5,15 @@
 #include <functional>
 #include <list>
 
+#include "../Volume_Convolution.h"
+
 
 template <class T, class R> class planar_image_collection;
 template <class T> class contour_collection;
 
 typedef enum { // Controls which blur is computed.
 
-    Gaussian // Numerically-approximated Gaussian with fixed (3-sigma) extent.
+    Gaussian // Numerically-approximated Gaussian with 3-sigma extent.
 
 } VolumetricSpatialBlurEstimator;
 
@@ -22,6 +24,13 @@ struct ComputeVolumetricSpatialBlurUserData {
     // The channel to analyze. If negative, all channels are analyzed.
     long int channel = -1;
 
+    // The Gaussian sigma, in pixel units (not DICOM units).
+    double sigma = 1.0;
+
+    // Controls how the blur is computed. Separable 1D passes are used for small sigmas and, if permitted, recursive
+    // filters for large sigmas.
+    volume_convolution::method_t method = volume_convolution::method_t::Automatic;
+
 };
 
 bool ComputeVolumetricSpatialBlur(planar_image_collection<float,double> &,
@@ -10,6 +10,10 @@
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
 
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -20,11 +24,185 @@
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
+#include "../Rectilinear_Volume.h"
+#include "../Voxel_Inclusion_Mask.h"
 #include "Volumetric_Neighbourhood_Sampler.h"
 
 #include "Volumetric_Spatial_Derivative.h"
 
 
+namespace {
+
+// A linear derivative estimator as weighted (row, column, image) voxel offsets.
+struct volumetric_stencil_t {
+    std::vector<std::array<long int, 3>> offsets;
+    std::vector<double> weights;
+};
+
+// The row-, column-, and image-aligned stencils of the estimator, matching the neighbourhood reductions below.
+std::array<volumetric_stencil_t, 3> volumetric_stencils(VolumetricSpatialDerivativeEstimator order){
+    std::array<volumetric_stencil_t, 3> out;
+    if(order == VolumetricSpatialDerivativeEstimator::first){
+        for(long int d : { -1L, 1L }){
+            const auto w = 0.5 * static_cast<double>(d);
+            out[0].offsets.push_back({{ 0, d, 0 }});
+            out[1].offsets.push_back({{ d, 0, 0 }});
+            out[2].offsets.push_back({{ 0, 0, d }});
+            for(auto &s : out) s.weights.push_back(w);
+        }
+
+    }else if(order == VolumetricSpatialDerivativeEstimator::Sobel_3x3x3){
+        // Derivative along one axis, smoothed along the others with (1, 2, 1) weights.
+        const auto smooth = [](long int d) -> double { return (d == 0) ? 2.0 : 1.0; };
+        for(long int di = -1; di <= 1; ++di){
+            for(long int dr = -1; dr <= 1; ++dr){
+                for(long int dc = -1; dc <= 1; ++dc){
+                    const std::array<long int, 3> o = {{ dr, dc, di }};
+                    if(dc != 0){
+                        out[0].offsets.push_back(o);
+                        out[0].weights.push_back(static_cast<double>(dc) * smooth(dr) * smooth(di) / 32.0);
+                    }
+                    if(dr != 0){
+                        out[1].offsets.push_back(o);
+                        out[1].weights.push_back(static_cast<double>(dr) * smooth(dc) * smooth(di) / 32.0);
+                    }
+                    if(di != 0){
+                        out[2].offsets.push_back(o);
+                        out[2].weights.push_back(static_cast<double>(di) * smooth(dr) * smooth(dc) / 32.0);
+                    }
+                }
+            }
+        }
+
+    }else{
+        throw std::invalid_argument("Unrecognized user-provided estimator argument.");
+    }
+    return out;
+}
+
+// Computes the derivatives directly, rather than sampling each voxel's neighbourhood. The voxels are packed into a
+// contiguous volume, and each row of the result is accumulated from the neighbouring rows one stencil weight at a time.
+// Rows are padded with NaNs, so voxels beyond the borders are handled the same way as non-finite voxels: they are
+// replaced by the central voxel's value, as in the neighbourhood reductions. All requested components are computed
+// together, and only the voxels bounded by the contours are updated.
+bool compute_with_stencils(planar_image_collection<float,double> &imagecoll,
+                           const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                           const ComputeVolumetricSpatialDerivativeUserData &ud){
+    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+    for(auto &img : imagecoll.images) selected_imgs.push_back( std::ref(img) );
+    if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+        FUNCWARN("Images do not form a rectilinear grid. Cannot continue");
+        return false;
+    }
+
+    // Order the images as the neighbourhood sampler would, and pack a pristine copy.
+    const auto orientation_normal = Average_Contour_Normals(ccsl);
+    planar_image_adjacency<float,double> img_adj( {}, { { std::ref(imagecoll) } }, orientation_normal );
+    std::list<std::reference_wrapper<planar_image<float,double>>> ordered_imgs;
+    for(long int i = 0; img_adj.index_present(i); ++i){
+        ordered_imgs.push_back( img_adj.index_to_image(i) );
+    }
+    if(ordered_imgs.size() != imagecoll.images.size()){
+        FUNCWARN("Unable to order images. Cannot continue");
+        return false;
+    }
+    const rectilinear_volume vol(ordered_imgs);
+    const std::vector<std::reference_wrapper<planar_image<float,double>>> dest(std::begin(ordered_imgs),
+                                                                               std::end(ordered_imgs));
+
+    const auto stencils = volumetric_stencils(ud.order);
+    std::vector<size_t> components;
+    if(ud.method == VolumetricSpatialDerivativeMethod::row_aligned){
+        components = { 0 };
+    }else if(ud.method == VolumetricSpatialDerivativeMethod::column_aligned){
+        components = { 1 };
+    }else if(ud.method == VolumetricSpatialDerivativeMethod::image_aligned){
+        components = { 2 };
+    }else if(ud.method == VolumetricSpatialDerivativeMethod::magnitude){
+        components = { 0, 1, 2 };
+    }else{
+        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
+    }
+
+    Mutate_Voxels_Opts mv_opts;
+    mv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
+    mv_opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
+    mv_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+    mv_opts.aggregate      = Mutate_Voxels_Opts::Aggregate::First;
+    mv_opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+    mv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
+
+    const auto C = vol.columns;
+    parallel_for(0, vol.images, [&](long int img) -> void {
+        auto &dest_img = dest[img].get();
+        const auto mask = Get_Voxel_Inclusion_Mask(dest_img, ccsl, mv_opts);
+
+        // Padded copies of the neighbouring rows, keyed on (image offset, row offset) in [-1, 1].
+        std::vector<float> centre(C);
+        std::array<std::vector<float>, 9> nbr_rows;
+        for(auto &r : nbr_rows) r.resize(C + 2);
+        std::array<std::vector<double>, 3> acc;
+        for(auto &a : acc) a.resize(C);
+        std::vector<float> result(C);
+
+        for(long int chan = 0; chan < vol.channels; ++chan){
+            if( (0 <= ud.channel) && (chan != ud.channel) ) continue;
+
+            for(long int row = 0; row < vol.rows; ++row){
+                if(mask->row_offsets[row] == mask->row_offsets[row + 1]) continue; // No bounded voxels.
+
+                for(long int col = 0; col < C; ++col) centre[col] = vol.value(img, row, col, chan);
+                for(long int di = -1; di <= 1; ++di){
+                    for(long int dr = -1; dr <= 1; ++dr){
+                        auto &r = nbr_rows[(di + 1) * 3 + (dr + 1)];
+                        std::fill(std::begin(r), std::end(r), std::numeric_limits<float>::quiet_NaN());
+                        if(!vol.in_bounds(img + di, row + dr, 0)) continue;
+                        const float *src = vol.data.data() + vol.index(img + di, row + dr, 0, chan);
+                        for(long int col = 0; col < C; ++col) r[col + 1] = src[col * vol.column_stride];
+                    }
+                }
+
+                for(const auto k : components){
+                    auto &a = acc[k];
+                    std::fill(std::begin(a), std::end(a), 0.0);
+                    const auto &s = stencils[k];
+                    for(size_t n = 0; n < s.weights.size(); ++n){
+                        const auto &o = s.offsets[n];
+                        const auto w = s.weights[n];
+                        const float *src = nbr_rows[(o[2] + 1) * 3 + (o[0] + 1)].data() + 1 + o[1];
+                        for(long int col = 0; col < C; ++col){
+                            const auto v = std::isfinite(src[col]) ? src[col] : centre[col];
+                            a[col] += w * static_cast<double>(v);
+                        }
+                    }
+                }
+
+                if(components.size() == 1){
+                    const auto &a = acc[components.front()];
+                    for(long int col = 0; col < C; ++col) result[col] = static_cast<float>(a[col]);
+                }else{
+                    for(long int col = 0; col < C; ++col){
+                        result[col] = static_cast<float>(std::sqrt( acc[0][col] * acc[0][col]
+                                                                  + acc[1][col] * acc[1][col]
+                                                                  + acc[2][col] * acc[2][col] ));
+                    }
+                }
+
+                for(auto r = mask->row_offsets[row]; r < mask->row_offsets[row + 1]; ++r){
+                    const auto run_end = static_cast<long int>(mask->runs[r][1]);
+                    for(auto col = static_cast<long int>(mask->runs[r][0]); col < run_end; ++col){
+                        dest_img.reference(row, col, chan) = result[col];
+                    }
+                }
+            }
+        }
+    }, 1);
+    return true;
+}
+
+} // namespace
+
+
 bool ComputeVolumetricSpatialDerivative(planar_image_collection<float,double> &imagecoll,
                       std::list<std::reference_wrapper<planar_image_collection<float,double>>> /*external_imgs*/,
                       std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
@@ -484,9 +662,14 @@ bool ComputeVolumetricSpatialDerivative(planar_image_collection<float,double> &i
         throw std::invalid_argument("Unrecognized user-provided estimator argument.");
     }
 
+    // Derivatives that are linear combinations of neighbouring voxels are computed directly. The functors above are
+    // equivalent; only edge thinning requires the volumetric sampling routine.
+    if(user_data_s->method != VolumetricSpatialDerivativeMethod::non_maximum_suppression){
+        if(!compute_with_stencils(imagecoll, ccsl, *user_data_s)) return false;
+
     // Invoke the volumetric sampling routine to compute the above functors.
-    if(!imagecoll.Compute_Images( ComputeVolumetricNeighbourhoodSampler, 
-                                  {}, ccsl, &ud )){
+    }else if(!imagecoll.Compute_Images( ComputeVolumetricNeighbourhoodSampler, 
+                                        {}, ccsl, &ud )){
         throw std::runtime_error("Unable to compute volumetric spatial derivative.");
     }
 
@@ -0,0 +1,352 @@
+//Dose_Volume_Stats.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+#include "../Bounded_Dose.h"
+#include "../Thread_Pool.h"
+#include "Grouping/Misc_Functors.h"
+#include "Voxel_Inclusion_Mask.h"
+#include "Dose_Volume_Stats.h"
+
+
+namespace {
+
+// Roughly 800 MB per ROI. A dose range this large relative to the bin width is almost certainly an error.
+constexpr size_t max_bin_count = 100'000'000;
+
+// The number of retained voxels integrated per task.
+constexpr size_t retained_voxel_block = 1 << 16;
+
+// Only a bounded number of partial results are held at once, and how the images are divided into chunks depends only
+// on the number of images so the results do not depend on the number of threads.
+constexpr size_t max_chunk_count = 64;
+
+using ccsl_t = std::list<std::reference_wrapper<contour_collection<double>>>;
+
+dose_volume_stats make_empty_stats(const dose_volume_options &opts){
+    dose_volume_stats s;
+    s.bin_width = opts.bin_width;
+    s.volume_above.assign(opts.thresholds.size(), 0.0);
+    s.integrals.assign(opts.integrands.size(), 0.0);
+    return s;
+}
+
+void check_bin_count(size_t N){
+    if(max_bin_count < N){
+        throw std::runtime_error("Dose range requires an excessive number of DVH bins. Increase the bin width");
+    }
+}
+
+// Ensures the histogram covers the range [lo, hi] of bin numbers.
+void cover_bins(dose_volume_stats &s, int64_t lo, int64_t hi){
+    if(s.bin_volumes.empty()){
+        check_bin_count(static_cast<size_t>(hi - lo + 1));
+        s.first_bin = lo;
+        s.bin_volumes.assign(static_cast<size_t>(hi - lo + 1), 0.0);
+        return;
+    }
+    const auto last_bin = s.first_bin + static_cast<int64_t>(s.bin_volumes.size()) - 1;
+    const auto new_lo = std::min(lo, s.first_bin);
+    const auto new_hi = std::max(hi, last_bin);
+    check_bin_count(static_cast<size_t>(new_hi - new_lo + 1));
+    if(new_lo < s.first_bin){
+        s.bin_volumes.insert(std::begin(s.bin_volumes), static_cast<size_t>(s.first_bin - new_lo), 0.0);
+        s.first_bin = new_lo;
+    }
+    if(last_bin < new_hi){
+        s.bin_volumes.resize(static_cast<size_t>(new_hi - new_lo + 1), 0.0);
+    }
+}
+
+void add_voxel(dose_volume_stats &s, const dose_volume_options &opts, double D, double vol){
+    s.moments.digest(D);
+    s.volume += vol;
+    for(size_t i = 0; i < opts.thresholds.size(); ++i){
+        if(opts.thresholds[i] < D) s.volume_above[i] += vol;
+    }
+    for(size_t i = 0; i < opts.integrands.size(); ++i){
+        s.integrals[i] += vol * opts.integrands[i](D);
+    }
+
+    const auto b = static_cast<int64_t>(std::floor(D / s.bin_width));
+    if( s.bin_volumes.empty()
+    ||  (b < s.first_bin)
+    ||  ((s.first_bin + static_cast<int64_t>(s.bin_volumes.size())) <= b) ){
+        cover_bins(s, b, b);
+    }
+    s.bin_volumes[static_cast<size_t>(b - s.first_bin)] += vol;
+
+    if(opts.retain_voxels){
+        s.voxels.push_back(static_cast<float>(D));
+        s.voxel_volumes.push_back(static_cast<float>(vol));
+    }
+}
+
+} // namespace
+
+
+double dose_volume_stats::V(double dose) const {
+    double v = 0.0;
+    for(size_t j = 0; j < this->bin_volumes.size(); ++j){
+        const auto i = this->bin_volumes.size() - 1 - j;
+        const auto lo = static_cast<double>(this->first_bin + static_cast<int64_t>(i)) * this->bin_width;
+        const auto hi = lo + this->bin_width;
+        if(dose <= lo){
+            v += this->bin_volumes[i];
+        }else if(dose < hi){
+            v += this->bin_volumes[i] * (hi - dose) / this->bin_width;
+        }else{
+            break;
+        }
+    }
+    return v;
+}
+
+double dose_volume_stats::D(double volume_fraction) const {
+    if(this->bin_volumes.empty() || !(0.0 < this->volume)){
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const auto D_min = this->moments.min();
+    const auto D_max = this->moments.max();
+    if(volume_fraction <= 0.0) return D_max;
+    if(1.0 <= volume_fraction) return D_min;
+
+    const auto target = volume_fraction * this->volume;
+    double cumulative = 0.0;
+    for(size_t j = 0; j < this->bin_volumes.size(); ++j){
+        const auto i = this->bin_volumes.size() - 1 - j;
+        const auto bv = this->bin_volumes[i];
+        if( (0.0 < bv) && (target <= cumulative + bv) ){
+            const auto hi = static_cast<double>(this->first_bin + static_cast<int64_t>(i) + 1) * this->bin_width;
+            const auto D = hi - this->bin_width * (target - cumulative) / bv;
+            return std::clamp(D, D_min, D_max);
+        }
+        cumulative += bv;
+    }
+    return D_min;
+}
+
+std::vector<double> dose_volume_stats::Quantiles(const std::vector<double> &fractions) const {
+    if(this->voxels.size() != this->moments.count()){
+        throw std::logic_error("Voxels were not retained, so exact quantiles cannot be evaluated");
+    }
+    std::vector<double> values(std::begin(this->voxels), std::end(this->voxels));
+    return Dose_Quantiles(values, fractions);
+}
+
+double dose_volume_stats::gEUD(size_t integral_index, double alpha) const {
+    return std::pow(this->integrals.at(integral_index) / this->volume, 1.0 / alpha);
+}
+
+samples_1D<double> dose_volume_stats::differential_DVH() const {
+    samples_1D<double> out;
+    out.metadata["Modality"]        = "Histogram";
+    out.metadata["HistogramType"]   = "Differential";
+    out.metadata["AbscissaScaling"] = "None";
+    out.metadata["OrdinateScaling"] = "None";
+    for(size_t i = 0; i < this->bin_volumes.size(); ++i){
+        const auto lo = static_cast<double>(this->first_bin + static_cast<int64_t>(i)) * this->bin_width;
+        out.samples.push_back({ lo + 0.5 * this->bin_width, 0.0, this->bin_volumes[i], 0.0 });
+    }
+    return out;
+}
+
+samples_1D<double> dose_volume_stats::cumulative_DVH() const {
+    samples_1D<double> out;
+    out.metadata["Modality"]        = "Histogram";
+    out.metadata["HistogramType"]   = "Cumulative";
+    out.metadata["AbscissaScaling"] = "None";
+    out.metadata["OrdinateScaling"] = "None";
+    out.samples.resize(this->bin_volumes.size() + 1, { 0.0, 0.0, 0.0, 0.0 });
+    double cumulative = 0.0;
+    for(size_t j = 0; j <= this->bin_volumes.size(); ++j){
+        const auto i = this->bin_volumes.size() - j;
+        if(i < this->bin_volumes.size()) cumulative += this->bin_volumes[i];
+        const auto lo = static_cast<double>(this->first_bin + static_cast<int64_t>(i)) * this->bin_width;
+        out.samples[i] = { lo, 0.0, cumulative, 0.0 };
+    }
+    return out;
+}
+
+void dose_volume_stats::merge(const dose_volume_stats &other){
+    if( (this->volume_above.size() != other.volume_above.size())
+    ||  (this->integrals.size() != other.integrals.size())
+    ||  (!this->bin_volumes.empty() && !other.bin_volumes.empty() && (this->bin_width != other.bin_width)) ){
+        throw std::invalid_argument("Unable to merge dose-volume statistics computed with differing options");
+    }
+    this->moments.merge(other.moments);
+    this->volume += other.volume;
+    for(size_t i = 0; i < this->volume_above.size(); ++i) this->volume_above[i] += other.volume_above[i];
+    for(size_t i = 0; i < this->integrals.size(); ++i) this->integrals[i] += other.integrals[i];
+
+    if(!other.bin_volumes.empty()){
+        this->bin_width = other.bin_width;
+        cover_bins(*this, other.first_bin, other.first_bin + static_cast<int64_t>(other.bin_volumes.size()) - 1);
+        const auto offset = static_cast<size_t>(other.first_bin - this->first_bin);
+        for(size_t i = 0; i < other.bin_volumes.size(); ++i) this->bin_volumes[offset + i] += other.bin_volumes[i];
+    }
+    this->voxels.insert(std::end(this->voxels), std::begin(other.voxels), std::end(other.voxels));
+    this->voxel_volumes.insert(std::end(this->voxel_volumes), std::begin(other.voxel_volumes),
+                                                               std::end(other.voxel_volumes));
+}
+
+
+std::function<double(double)> gEUD_Integrand(double alpha){
+    return [alpha](double D) -> double { return std::pow(D, alpha); };
+}
+
+
+std::vector<double>
+Integrate_Retained_Voxels(const dose_volume_stats &s,
+                          const std::vector<std::function<double(double)>> &integrands){
+    const auto N = s.voxels.size();
+    if( (N != s.voxel_volumes.size())
+    ||  (N != s.moments.count()) ){
+        throw std::invalid_argument("Voxels were not retained. Unable to integrate");
+    }
+
+    // Block sums are combined pairwise in a fixed order, so results do not depend on the number of threads.
+    std::vector<double> out;
+    out.reserve(integrands.size());
+    for(const auto &f : integrands){
+        const float *D = s.voxels.data();
+        const float *vol = s.voxel_volumes.data();
+        out.push_back( parallel_reduce(0L, static_cast<long int>(N), 0.0,
+                                       [&](long int i_begin, long int i_end) -> double {
+            double sum = 0.0;
+            for(auto i = i_begin; i < i_end; ++i){
+                sum += static_cast<double>(vol[i]) * f(static_cast<double>(D[i]));
+            }
+            return sum;
+        }, [](double &lhs, double rhs) -> void { lhs += rhs; },
+        static_cast<long int>(retained_voxel_block)) );
+    }
+    return out;
+}
+
+
+std::map<std::string, dose_volume_stats>
+Compute_Dose_Volume_Stats(planar_image_collection<float,double> &imagecoll,
+                          const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                          const dose_volume_options &opts){
+    if( !std::isfinite(opts.bin_width) || !(0.0 < opts.bin_width) ){
+        throw std::invalid_argument("DVH bin width must be positive and finite");
+    }
+
+    // Partition the contours by ROIName.
+    std::list<contour_collection<double>> cc_storage;
+    std::map<std::string, ccsl_t> named_ccsls;
+    for(auto &ccs : ccsl){
+        for(auto &contour : ccs.get().contours){
+            if(contour.points.empty()) continue;
+            const auto ROIName = contour.GetMetadataValueAs<std::string>("ROIName");
+            if(!ROIName){
+                FUNCWARN("Found contour missing ROIName metadata element. Using placeholder name");
+            }
+            const auto key = ROIName.value_or("unspecified");
+            if(named_ccsls.count(key) == 0){
+                cc_storage.emplace_back();
+                named_ccsls.emplace(key, ccsl_t{ std::ref(cc_storage.back()) });
+            }
+            named_ccsls.at(key).front().get().contours.emplace_back(contour);
+        }
+    }
+
+    // Group spatially overlapping images, which will be summed.
+    std::vector<std::list<planar_image_collection<float,double>::images_list_it_t>> groups;
+    auto all_images = imagecoll.get_all_images();
+    while(!all_images.empty()){
+        auto curr_img_it = all_images.front();
+        auto selected_imgs = GroupSpatiallyOverlappingImages(curr_img_it, std::ref(imagecoll));
+        if(selected_imgs.empty()){
+            throw std::logic_error("No spatially-overlapping images found. There should be at least one"
+                                   " image (the 'seed' image) which should match. Verify the spatial"
+                                   " overlap grouping routine.");
+        }
+        for(const auto &an_img_it : selected_imgs){
+            if( (curr_img_it->rows     != an_img_it->rows)
+            ||  (curr_img_it->columns  != an_img_it->columns)
+            ||  (curr_img_it->channels != an_img_it->channels) ){
+                throw std::domain_error("Images have differing number of rows, columns, or channels."
+                                        " This is not currently supported -- though it could be if needed."
+                                        " Are you sure you've got the correct data?");
+            }
+        }
+        for(auto &an_img_it : selected_imgs){
+            all_images.remove(an_img_it);
+        }
+        groups.emplace_back(selected_imgs);
+    }
+
+    // Traverse the groups in parallel, accumulating into chunk-local results.
+    const auto N_groups = groups.size();
+    const auto chunk_size = std::max<size_t>(1, (N_groups + max_chunk_count - 1) / max_chunk_count);
+    const auto N_chunks = (N_groups + chunk_size - 1) / chunk_size;
+    std::vector<std::map<std::string, dose_volume_stats>> partials(N_chunks);
+
+    parallel_for(0, static_cast<long int>(N_chunks), [&](long int c) -> void {
+        auto &partial = partials[c];
+        const auto g_end = std::min(N_groups, (static_cast<size_t>(c) + 1) * chunk_size);
+        for(auto g = static_cast<size_t>(c) * chunk_size; g < g_end; ++g){
+            const auto &imgs = groups[g];
+            const auto &img = *(imgs.front());
+            const auto pxl_vol = img.pxl_dx * img.pxl_dy * img.pxl_dz;
+
+            for(const auto &named_ccsl : named_ccsls){
+                const auto mask = Get_Voxel_Inclusion_Mask(img, named_ccsl.second, opts.mutation_opts);
+                if(mask->count() == 0) continue;
+
+                auto s_it = partial.find(named_ccsl.first);
+                if(s_it == std::end(partial)){
+                    s_it = partial.emplace(named_ccsl.first, make_empty_stats(opts)).first;
+                }
+                auto &s = s_it->second;
+
+                for(long int row = 0; row < img.rows; ++row){
+                    for(auto r = mask->row_offsets[row]; r < mask->row_offsets[row + 1]; ++r){
+                        const auto run_end = static_cast<long int>(mask->runs[r][1]);
+                        for(auto col = static_cast<long int>(mask->runs[r][0]); col < run_end; ++col){
+                            for(long int chan = 0; chan < img.channels; ++chan){
+                                if( (0 <= opts.channel) && (opts.channel != chan) ) continue;
+
+                                double D = 0.0;
+                                for(const auto &img_it : imgs) D += static_cast<double>(img_it->value(row, col, chan));
+                                if(!std::isfinite(D)) continue;
+                                add_voxel(s, opts, D, pxl_vol);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }, /*grain=*/ 1);
+
+    std::map<std::string, dose_volume_stats> out;
+    for(const auto &partial : partials){
+        for(const auto &p : partial){
+            auto o_it = out.find(p.first);
+            if(o_it == std::end(out)){
+                o_it = out.emplace(p.first, make_empty_stats(opts)).first;
+            }
+            o_it->second.merge(p.second);
+        }
+    }
+    return out;
+}
+
@@ -0,0 +1,110 @@
+//Dose_Volume_Stats.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Distribution_Sketch.h"
+
+template <class T> class contour_collection;
+
+
+// Dose-volume statistics for a single ROI.
+//
+// The differential dose-volume histogram (DVH) uses bins aligned to integer multiples of the bin width, so histograms
+// from different sources can be compared bin-for-bin. Doses within a bin are assumed to be uniformly distributed when
+// interpolating. Quantities that must be exact (e.g., the volume exceeding a prescription dose, or order statistics
+// like the median) can be requested explicitly via dose_volume_options.
+struct dose_volume_stats {
+    running_moments moments;            // Unweighted; each voxel counts once.
+    double volume = 0.0;                // Total volume of all voxels (in DICOM units; mm^3).
+
+    std::vector<double> volume_above;   // Exact volume with dose strictly above each requested threshold.
+    std::vector<double> integrals;      // Exact sum over voxels of (voxel volume)*f(dose) for each requested f.
+
+    double bin_width = 0.0;
+    int64_t first_bin = 0;              // Bin i covers [(first_bin + i)*bin_width, (first_bin + i + 1)*bin_width).
+    std::vector<double> bin_volumes;
+
+    std::vector<float> voxels;          // Voxel doses, in traversal order. Only retained if requested.
+    std::vector<float> voxel_volumes;   // The volume of each retained voxel.
+
+    // Volume receiving at least the given dose, interpolated from the DVH.
+    double V(double dose) const;
+
+    // Minimum dose received by the hottest fraction (in [0,1]) of the volume, interpolated from the DVH. D(0.5) is
+    // the median dose, and D(0.02) is commonly called D2%.
+    double D(double volume_fraction) const;
+
+    // Exact quantiles (in [0,1]) of the retained voxel doses, each voxel counting once and interpolating linearly
+    // between order statistics as Dose_Quantiles() does, so Quantiles({0.5}) is the conventional median. Throws if
+    // voxels were not retained. NaN if there are no voxels.
+    std::vector<double> Quantiles(const std::vector<double> &fractions) const;
+
+    // Generalized equivalent uniform dose, given the integral of f(D) = D^alpha.
+    double gEUD(size_t integral_index, double alpha) const;
+
+    // DVHs in the same format as ComputeExtractHistograms: bin-centred differential volumes, and cumulative volumes
+    // at the lower edge of each bin.
+    samples_1D<double> differential_DVH() const;
+    samples_1D<double> cumulative_DVH() const;
+
+    void merge(const dose_volume_stats &other);
+};
+
+
+struct dose_volume_options {
+    // Controls how contours are interpretted. Only the inclusivity, contour overlap, and mask modification options
+    // are honoured.
+    Mutate_Voxels_Opts mutation_opts;
+
+    // The channel to consider. Negative values will use all channels.
+    long int channel = -1;
+
+    // DVH bin width (in DICOM units; nominally Gy).
+    double bin_width = 0.01;
+
+    // Doses for which the volume strictly above is tallied exactly.
+    std::vector<double> thresholds;
+
+    // Functions of dose that are integrated exactly over the volume (e.g., D^alpha for gEUD, or the logarithm of a
+    // voxel-level response for TCP models). They are invoked concurrently and must be thread-safe. Non-finite values
+    // are accumulated as-is.
+    std::vector<std::function<double(double)>> integrands;
+
+    // Whether to retain every voxel dose and volume.
+    bool retain_voxels = false;
+};
+
+// Returns a ready-made integrand for gEUD, f(D) = D^alpha.
+std::function<double(double)> gEUD_Integrand(double alpha);
+
+// Integrates each function of dose over the retained voxels, as dose_volume_options::integrands are integrated
+// during traversal. This permits evaluating models for many parameter sets, e.g., for parameter sweeps, without
+// re-traversing the images. Blocks of voxels are integrated concurrently, and the integrands must be thread-safe.
+std::vector<double>
+Integrate_Retained_Voxels(const dose_volume_stats &s,
+                          const std::vector<std::function<double(double)>> &integrands);
+
+
+// Computes dose-volume statistics for every ROI (keyed on ROIName) in a single, parallel traversal of the images.
+//
+// Spatially overlapping images are combined by summing voxel doses, as with AccumulatePixelDistributions; they must
+// have identical geometry. Contours with the same ROIName are rasterized together using the cached voxel inclusion
+// masks, so each voxel is counted at most once per ROI. Non-finite voxels are ignored.
+//
+// Partial results are merged in image order, so results do not depend on the number of threads.
+std::map<std::string, dose_volume_stats>
+Compute_Dose_Volume_Stats(planar_image_collection<float,double> &imagecoll,
+                          const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                          const dose_volume_options &opts);
+
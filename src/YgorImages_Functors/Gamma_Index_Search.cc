@@ -0,0 +1,201 @@
+//Gamma_Index_Search.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Gamma_Index_Search.h"
+#include "Rectilinear_Volume.h"
+#include "Rectilinear_Volume_Ray_Caster.h"
+
+
+gamma_index_search::gamma_index_search(const rectilinear_volume &r, const parameters &p)
+    : ref(&r), params(p) {
+
+    if( !(0.0 < this->params.DTA_threshold) || !(0.0 < this->params.Dis_threshold) ){
+        throw std::invalid_argument("Gamma thresholds must be positive. Cannot create gamma search.");
+    }
+    if( !std::isfinite(this->params.DTA_max) || (this->params.DTA_max < 0.0) ){
+        throw std::invalid_argument("Search radius must be finite and non-negative. Cannot create gamma search.");
+    }
+    if(this->params.supersample < 1){
+        throw std::invalid_argument("Supersampling factor must be positive. Cannot create gamma search.");
+    }
+    this->params.tolerance = std::max(0.0, this->params.tolerance);
+
+    // Reuse the ray caster's index space so the geometry (and validation) is shared.
+    this->space = rectilinear_volume_ray_caster(r, this->params.channel).get_index_space();
+    for(int a = 0; a < 3; ++a){
+        this->spacing[a] = 1.0 / this->space.axes[a].length();
+    }
+
+    // Enumerate the fine nodes within the search radius, sorted by distance.
+    const double s = static_cast<double>(this->params.supersample);
+    long int reach[3];
+    for(int a = 0; a < 3; ++a){
+        reach[a] = static_cast<long int>(std::ceil(this->params.DTA_max * s / this->spacing[a]));
+        if(this->space.extent[a] == 1) reach[a] = 0; // Nothing to search along degenerate axes.
+    }
+
+    struct entry_t {
+        long int o[3];
+        double d;
+    };
+    std::vector<entry_t> entries;
+    for(long int k = -reach[2]; k <= reach[2]; ++k){
+        for(long int j = -reach[1]; j <= reach[1]; ++j){
+            for(long int i = -reach[0]; i <= reach[0]; ++i){
+                const double d = std::hypot( static_cast<double>(i) * this->spacing[0] / s,
+                                             static_cast<double>(j) * this->spacing[1] / s,
+                                             static_cast<double>(k) * this->spacing[2] / s );
+                if(this->params.DTA_max < d) continue;
+                entries.push_back({ { i, j, k }, d });
+            }
+        }
+    }
+    std::stable_sort(std::begin(entries), std::end(entries),
+                     [](const entry_t &l, const entry_t &r) -> bool { return (l.d < r.d); });
+
+    for(int a = 0; a < 3; ++a) this->offset[a].reserve(entries.size());
+    this->dist.reserve(entries.size());
+    for(const auto &e : entries){
+        for(int a = 0; a < 3; ++a) this->offset[a].emplace_back(e.o[a]);
+        this->dist.emplace_back(e.d);
+    }
+}
+
+
+gamma_index_search::outcome_t
+gamma_index_search::evaluate(const vec3<double> &pos, double value, double &gamma) const {
+    const long int S = this->params.supersample;
+    const double s = static_cast<double>(S);
+    const double inv_DTA2 = 1.0 / (this->params.DTA_threshold * this->params.DTA_threshold);
+    const double inv_Dis2 = 1.0 / (this->params.Dis_threshold * this->params.Dis_threshold);
+    constexpr double inf = std::numeric_limits<double>::infinity();
+
+    // Locate the test point in index space and snap it to the nearest fine node. The snapping error is used to keep
+    // the spatial lower bound conservative.
+    const auto dp = pos - this->space.origin;
+    double g[3];
+    long int c[3];
+    double snap2 = 0.0;
+    for(int a = 0; a < 3; ++a){
+        g[a] = dp.Dot(this->space.axes[a]);
+        if( !(-0.5 <= g[a]) || !(g[a] <= static_cast<double>(this->space.extent[a]) - 0.5) ){
+            return outcome_t::Unavailable;
+        }
+        c[a] = static_cast<long int>(std::floor(g[a] * s + 0.5));
+        const double e = (static_cast<double>(c[a]) / s - g[a]) * this->spacing[a];
+        snap2 += e * e;
+    }
+    const double snap_err = std::sqrt(snap2);
+
+    const float *data = this->ref->data.data();
+    const auto max_idx = [&](int a) -> long int { return this->space.extent[a] - 1; };
+    const auto disc = [&](double ref_val) -> double {
+        const double diff = std::abs(value - ref_val);
+        switch(this->params.discrepancy){
+            case discrepancy_t::Difference:
+                return diff;
+            case discrepancy_t::Relative:
+                {
+                    const double max_abs = std::max(std::abs(value), std::abs(ref_val));
+                    return (max_abs < 1.0E-8) ? 0.0 : diff / max_abs;
+                }
+            case discrepancy_t::PinnedToMax:
+            default:
+                return diff / this->params.pinned_max;
+        }
+    };
+
+    double best2 = inf;
+    double ref_vals[block_size];
+    double d2s[block_size];
+
+    const auto N = static_cast<long int>(this->dist.size());
+    for(long int b = 0; b < N; b += block_size){
+        // The table is sorted, so no remaining offset can improve on the best value once the spatial term alone
+        // exceeds it.
+        const double lb = std::max(0.0, this->dist[b] - snap_err);
+        const double lb_gamma = lb * std::sqrt(inv_DTA2);
+        const double best = std::sqrt(best2);
+        if(best - this->params.tolerance <= lb_gamma) break;
+        if( this->params.terminate_above_one
+        &&  (1.0 <= lb_gamma) ){
+            gamma = best;
+            return outcome_t::Terminated;
+        }
+
+        // Gather the reference values (NaN when unavailable) and spatial distances for this block.
+        const long int n = std::min<long int>(block_size, N - b);
+        for(long int q = 0; q < n; ++q){
+            double d2 = 0.0;
+            long int fine[3];
+            for(int a = 0; a < 3; ++a){
+                fine[a] = c[a] + this->offset[a][b + q];
+                const double e = (static_cast<double>(fine[a]) / s - g[a]) * this->spacing[a];
+                d2 += e * e;
+            }
+            d2s[q] = d2;
+
+            double v = std::numeric_limits<double>::quiet_NaN();
+            if(S == 1){
+                if( (0 <= fine[0]) && (fine[0] <= max_idx(0))
+                &&  (0 <= fine[1]) && (fine[1] <= max_idx(1))
+                &&  (0 <= fine[2]) && (fine[2] <= max_idx(2)) ){
+                    v = data[ this->params.channel
+                            + fine[0] * this->space.stride[0]
+                            + fine[1] * this->space.stride[1]
+                            + fine[2] * this->space.stride[2] ];
+                }
+            }else{
+                // Trilinearly interpolate between the surrounding voxels.
+                long int i0[3];
+                double f[3];
+                bool inside = true;
+                for(int a = 0; a < 3; ++a){
+                    i0[a] = (fine[a] < 0) ? -((-fine[a] + S - 1) / S) : (fine[a] / S);
+                    f[a] = static_cast<double>(fine[a] - i0[a] * S) / s;
+                    if( (i0[a] < 0) || (max_idx(a) < i0[a]) || ((0.0 < f[a]) && (max_idx(a) < i0[a] + 1)) ){
+                        inside = false;
+                    }
+                }
+                if(inside){
+                    v = 0.0;
+                    for(long int corner = 0; corner < 8; ++corner){
+                        double w = 1.0;
+                        long int idx = this->params.channel;
+                        for(int a = 0; a < 3; ++a){
+                            const long int bit = (corner >> a) & 1;
+                            w *= (bit == 0) ? (1.0 - f[a]) : f[a];
+                            idx += (i0[a] + bit) * this->space.stride[a];
+                        }
+                        if(w != 0.0) v += w * static_cast<double>(data[idx]);
+                    }
+                }
+            }
+            if( !( this->params.ref_lower_threshold <= v )
+            ||  !( v <= this->params.ref_upper_threshold ) ){
+                v = std::numeric_limits<double>::quiet_NaN();
+            }
+            ref_vals[q] = v;
+        }
+
+        // Evaluate the block. Unavailable voxels produce NaN, which never compares less than the best value.
+        for(long int q = 0; q < n; ++q){
+            const double dd = disc(ref_vals[q]);
+            const double g2 = d2s[q] * inv_DTA2 + dd * dd * inv_Dis2;
+            best2 = (g2 < best2) ? g2 : best2;
+        }
+    }
+
+    if(!std::isfinite(best2)) return outcome_t::Unavailable;
+    gamma = std::sqrt(best2);
+    return outcome_t::Evaluated;
+}
+
@@ -1,4 +1,5 @@
 
+#include <cmath>
 #include <optional>
 #include <functional>
 #include <list>
@@ -7,6 +8,8 @@
 #include "YgorMath.h"
 #include "YgorMisc.h"
 
+#include "../../Time_Course_Tensor.h"
+
 //--------------------------------------------------------------------------------------------------------------
 //------------------------------------------- Image Purging Functors -------------------------------------------
 //--------------------------------------------------------------------------------------------------------------
@@ -43,16 +46,27 @@ GroupTemporallyOverlappingImages(planar_image_collection<float,double>::images_l
 
     //NOTE: The units of time here are unknown and not standard. If possible, it would be best to check other
     //      metadata or have a more definite (standardized) interpretation.
-    auto L_time_opt = first_img_it->GetMetadataValueAs<double>("dt");
-    if(!L_time_opt) FUNCERR("Missing metadata info needed for temporal grouping (on L). Cannot continue");
-    const auto L_time = L_time_opt.value();
-  
-    auto overlapping_imgs = pic.get().get_images_satisfying([=](const planar_image<float,double> &animg) -> bool {
-        auto R_time_opt = animg.GetMetadataValueAs<double>("dt");
-        if(!R_time_opt) FUNCERR("Missing metadata info needed for spatial-temporal grouping (on R). Cannot continue");
-        const auto R_time = R_time_opt.value();
-        return (RELATIVE_DIFF(L_time,R_time) < 1E-3);
-    });
+    //
+    //The times are parsed and sorted once per collection (rather than once per group) and coincident images are
+    // located with a binary search.
+    const auto index = Get_Temporal_Index(pic.get(), "dt");
+    const auto L_time = index->get_time( &(*first_img_it) );
+    if(!std::isfinite(L_time)) FUNCERR("Missing metadata info needed for temporal grouping (on L). Cannot continue");
+    if(!index->get_untimed_images().empty()){
+        FUNCERR("Missing metadata info needed for spatial-temporal grouping (on R). Cannot continue");
+    }
+
+    //The overlapping images are returned in collection order.
+    const auto positions = index->find_coincident(L_time, 1E-3);
+    std::list<planar_image_collection<float,double>::images_list_it_t> overlapping_imgs;
+    auto p_it = std::begin(positions);
+    size_t i = 0;
+    for(auto it = std::begin(pic.get().images); it != std::end(pic.get().images); ++it, ++i){
+        if(p_it == std::end(positions)) break;
+        if(i != *p_it) continue;
+        overlapping_imgs.push_back(it);
+        ++p_it;
+    }
     return overlapping_imgs;
 }
 
@@ -71,13 +85,18 @@ GroupSpatiallyTemporallyOverlappingImages(planar_image_collection<float,double>:
 
     //NOTE: The units of time here are unknown and not standard. If possible, it would be best to check other
     //      metadata or have a more definite (standardized) interpretation.
-    auto L_time = first_img_it->GetMetadataValueAs<double>("dt");
-    if(!L_time) FUNCERR("Missing metadata info needed for spatial-temporal grouping (on L). Cannot continue");
+    const auto index = Get_Temporal_Index(pic.get(), "dt");
+    const auto L_time = index->get_time( &(*first_img_it) );
+    if(!std::isfinite(L_time)){
+        FUNCERR("Missing metadata info needed for spatial-temporal grouping (on L). Cannot continue");
+    }
 
     for(auto &an_img_it : candidate_images){
-        auto R_time = an_img_it->GetMetadataValueAs<double>("dt");
-        if(!R_time) FUNCERR("Missing metadata info needed for spatial-temporal grouping (on R). Cannot continue");
-        if(RELATIVE_DIFF(L_time.value(), R_time.value()) < 1E-3) out.push_back(an_img_it);
+        const auto R_time = index->get_time( &(*an_img_it) );
+        if(!std::isfinite(R_time)){
+            FUNCERR("Missing metadata info needed for spatial-temporal grouping (on R). Cannot continue");
+        }
+        if(RELATIVE_DIFF(L_time, R_time) < 1E-3) out.push_back(an_img_it);
     }
 
     return out;
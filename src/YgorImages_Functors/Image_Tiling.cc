@@ -0,0 +1,100 @@
+//Image_Tiling.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "../Thread_Pool.h"
+#include "Image_Tiling.h"
+
+
+namespace {
+
+constexpr double default_voxel_cost = 20.0E-9;   // seconds per voxel value; errs towards creating more tasks.
+constexpr double min_task_cost      = 100.0E-6;  // seconds; well above the cost of scheduling a task.
+constexpr long int tasks_per_worker = 4;          // Lets idle workers steal work when estimates are imperfect.
+constexpr double recent_weight      = 0.5;        // Weight of the newest measurement in the running estimate.
+
+struct voxel_cost_registry_t {
+    std::mutex m;
+    std::map<tile_cost_key, double> seconds_per_voxel;
+};
+
+voxel_cost_registry_t & voxel_cost_registry(){
+    static voxel_cost_registry_t registry;
+    return registry;
+}
+
+} // namespace
+
+
+double Get_Voxel_Cost(tile_cost_key key){
+    auto &r = voxel_cost_registry();
+    std::lock_guard<std::mutex> lock(r.m);
+    const auto it = r.seconds_per_voxel.find(key);
+    return (it == std::end(r.seconds_per_voxel)) ? default_voxel_cost : it->second;
+}
+
+void Record_Voxel_Cost(tile_cost_key key, double seconds, double voxels){
+    if( !std::isfinite(seconds) || !std::isfinite(voxels) || (voxels <= 0.0) ) return;
+    const auto measured = std::max(seconds, 0.0) / voxels;
+
+    auto &r = voxel_cost_registry();
+    std::lock_guard<std::mutex> lock(r.m);
+    auto it = r.seconds_per_voxel.find(key);
+    if(it == std::end(r.seconds_per_voxel)){
+        r.seconds_per_voxel[key] = measured;
+    }else{
+        it->second = recent_weight * measured + (1.0 - recent_weight) * it->second;
+    }
+    return;
+}
+
+
+std::vector<std::vector<image_tile>>
+Plan_Image_Tiles(const std::vector<image_extent> &extents, double seconds_per_voxel, bool split_rows){
+    if( !std::isfinite(seconds_per_voxel) || (seconds_per_voxel <= 0.0) ) seconds_per_voxel = default_voxel_cost;
+
+    const auto cost_of = [&](const image_extent &e) -> double {
+        return static_cast<double>(std::max<long int>(0, e.rows))
+             * static_cast<double>(std::max<long int>(0, e.voxels_per_row))
+             * seconds_per_voxel;
+    };
+
+    double total_cost = 0.0;
+    for(const auto &e : extents) total_cost += cost_of(e);
+    const auto workers = std::max<long int>(1, work_stealing_pool::get().concurrency());
+    const auto target = std::max(min_task_cost, total_cost / static_cast<double>(tasks_per_worker * workers));
+
+    std::vector<std::vector<image_tile>> tasks;
+    std::vector<image_tile> batch;
+    double batch_cost = 0.0;
+    const auto flush = [&]() -> void {
+        if(!batch.empty()) tasks.emplace_back(std::move(batch));
+        batch.clear();
+        batch_cost = 0.0;
+    };
+
+    for(size_t i = 0; i < extents.size(); ++i){
+        const auto rows = std::max<long int>(0, extents[i].rows);
+        const auto cost = cost_of(extents[i]);
+
+        if(split_rows && (target < cost) && (1 < rows)){
+            flush();
+            const auto bands = std::min<long int>(rows, static_cast<long int>(std::ceil(cost / target)));
+            for(long int b = 0; b < bands; ++b){
+                tasks.push_back({ image_tile{ i, (b * rows) / bands, ((b + 1) * rows) / bands } });
+            }
+        }else{
+            batch.push_back(image_tile{ i, 0, rows });
+            batch_cost += cost;
+            if(target <= batch_cost) flush();
+        }
+    }
+    flush();
+    return tasks;
+}
+
@@ -0,0 +1,152 @@
+//Image_Tiling.h.
+
+#pragma once
+
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include "YgorImages.h"
+
+#include "../Thread_Pool.h"
+
+template <class T> class contour_collection;
+
+
+// Identifies a kind of work (e.g., an image functor) for the purposes of cost estimation.
+using tile_cost_key = std::uintptr_t;
+
+// Functions are identified by address, and other functors by type.
+template <class F>
+tile_cost_key Tile_Cost_Key(F f){
+    if constexpr (std::is_pointer<F>::value){
+        return reinterpret_cast<tile_cost_key>(f);
+    }else{
+        return reinterpret_cast<tile_cost_key>(&typeid(F));
+    }
+}
+
+// The estimated cost of the work, in seconds of processing per voxel value. Estimates are shared process-wide. Work
+// that has not yet been measured is given a conservative default.
+double Get_Voxel_Cost(tile_cost_key key);
+
+// Folds a measurement of the total processing time (summed over all threads) for the given number of voxel values into
+// the estimated cost of the work. Recent measurements are weighted more heavily than older ones.
+void Record_Voxel_Cost(tile_cost_key key, double seconds, double voxels);
+
+
+// The dimensions of an image, for planning.
+struct image_extent {
+    long int rows = 0;
+    long int voxels_per_row = 0; // Columns times channels.
+};
+
+// A contiguous band of rows [row_begin, row_end) within one of the planned images.
+struct image_tile {
+    size_t image = 0;
+    long int row_begin = 0;
+    long int row_end = 0;
+};
+
+// Divides images into tasks of roughly equal estimated cost, each a list of tiles to be processed in order.
+//
+// Tasks are sized so each worker receives a few, but not so small that scheduling overhead dominates. Consecutive
+// inexpensive images are grouped into a single task and, if permitted, expensive images are cut into bands of rows
+// that become separate tasks. Otherwise every tile covers a whole image. Every image, including empty images, is
+// covered exactly once, and tiles are ordered by image and then by row.
+std::vector<std::vector<image_tile>>
+Plan_Image_Tiles(const std::vector<image_extent> &extents, double seconds_per_voxel, bool split_rows);
+
+
+// Invokes f_tile(img, row_begin, row_end) over the rows of every image in the collection, with the work divided
+// according to the measured cost of the work identified by the key, and then f_finish(img) once per image after all of
+// its rows have been processed.
+//
+// Tiles of a single image may be processed concurrently, so f_tile must only access the rows it was given (and
+// anything it shares must be safe to use concurrently). f_finish is invoked concurrently for distinct images. The first
+// exception encountered is rethrown.
+template <class F_tile, class F_finish>
+void Process_Image_Tiles(planar_image_collection<float,double> &imagecoll,
+                         tile_cost_key key,
+                         F_tile f_tile,
+                         F_finish f_finish){
+    std::vector<planar_image<float,double> *> imgs;
+    std::vector<image_extent> extents;
+    for(auto &img : imagecoll.images){
+        imgs.push_back(&img);
+        extents.push_back({ img.rows, img.columns * img.channels });
+    }
+    const auto tasks = Plan_Image_Tiles(extents, Get_Voxel_Cost(key), true);
+
+    std::atomic<int64_t> busy_ns{0};
+    std::atomic<int64_t> voxels{0};
+    parallel_for(0, static_cast<long int>(tasks.size()), [&](long int t) -> void {
+        const auto t_start = std::chrono::steady_clock::now();
+        int64_t n = 0;
+        for(const auto &tile : tasks[t]){
+            f_tile(*(imgs[tile.image]), tile.row_begin, tile.row_end);
+            n += static_cast<int64_t>(tile.row_end - tile.row_begin) * extents[tile.image].voxels_per_row;
+        }
+        const auto t_end = std::chrono::steady_clock::now();
+        busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start).count();
+        voxels += n;
+    }, /*grain=*/ 1);
+    Record_Voxel_Cost(key, 1.0E-9 * static_cast<double>(busy_ns.load()), static_cast<double>(voxels.load()));
+
+    parallel_for(0, static_cast<long int>(imgs.size()), [&](long int i) -> void {
+        f_finish(*(imgs[i]));
+    }, /*grain=*/ 1);
+    return;
+}
+
+
+// Equivalent to imagecoll.Process_Images_Parallel(GroupIndividualImages, f, ...), except that the functor is run on
+// the process-wide pool and tasks are sized according to the measured cost of the functor, so large numbers of
+// inexpensive images are batched rather than scheduled individually. The functor is invoked exactly once per image,
+// with the image as the only selected image, and may be invoked concurrently for distinct images.
+//
+// Returns false if the functor failed for any image. The first exception encountered is rethrown.
+template <class F>
+bool Process_Images_Balanced(planar_image_collection<float,double> &imagecoll,
+                             F f,
+                             std::list<std::reference_wrapper<planar_image_collection<float,double>>> external_imgs,
+                             std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
+                             std::any user_data = std::any()){
+    using img_it_t = planar_image_collection<float,double>::images_list_it_t;
+    const auto key = Tile_Cost_Key(f);
+
+    std::vector<img_it_t> img_its;
+    std::vector<image_extent> extents;
+    for(auto img_it = std::begin(imagecoll.images); img_it != std::end(imagecoll.images); ++img_it){
+        img_its.push_back(img_it);
+        extents.push_back({ img_it->rows, img_it->columns * img_it->channels });
+    }
+    const auto tasks = Plan_Image_Tiles(extents, Get_Voxel_Cost(key), false);
+
+    std::atomic<bool> failed{false};
+    std::atomic<int64_t> busy_ns{0};
+    std::atomic<int64_t> voxels{0};
+    parallel_for(0, static_cast<long int>(tasks.size()), [&](long int t) -> void {
+        const auto t_start = std::chrono::steady_clock::now();
+        int64_t n = 0;
+        for(const auto &tile : tasks[t]){
+            const auto img_it = img_its[tile.image];
+            if(!f(img_it, { img_it }, external_imgs, ccsl, user_data)) failed = true;
+            n += static_cast<int64_t>(extents[tile.image].rows) * extents[tile.image].voxels_per_row;
+        }
+        const auto t_end = std::chrono::steady_clock::now();
+        busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start).count();
+        voxels += n;
+    }, /*grain=*/ 1);
+    Record_Voxel_Cost(key, 1.0E-9 * static_cast<double>(busy_ns.load()), static_cast<double>(voxels.load()));
+
+    return !failed;
+}
+
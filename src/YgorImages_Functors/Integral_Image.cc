@@ -0,0 +1,121 @@
+//Integral_Image.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorImages.h"
+
+#include "Integral_Image.h"
+
+
+double integral_image::window_stats::sum() const {
+    return this->shifted_sum + static_cast<double>(this->count) * this->shift;
+}
+
+double integral_image::window_stats::mean() const {
+    if(this->count <= 0) return std::numeric_limits<double>::quiet_NaN();
+    return this->shift + this->shifted_sum / static_cast<double>(this->count);
+}
+
+double integral_image::window_stats::variance() const {
+    if(this->count <= 1) return std::numeric_limits<double>::quiet_NaN();
+    const auto n = static_cast<double>(this->count);
+    const auto var = (this->shifted_sum_sq - this->shifted_sum * this->shifted_sum / n) / (n - 1.0);
+    return std::max(0.0, var); // Guard against small negative values caused by round-off.
+}
+
+double integral_image::window_stats::standard_deviation() const {
+    return std::sqrt(this->variance());
+}
+
+
+integral_image::integral_image(const planar_image<float,double> &img, int64_t chan)
+  : rows(img.rows),
+    columns(img.columns){
+    if( (chan < 0) || (img.channels <= chan) ){
+        throw std::invalid_argument("Requested channel does not exist");
+    }
+
+    // The shift only needs to be near the typical pixel value, so it does not need to be exact.
+    double total = 0.0;
+    int64_t finite = 0;
+    for(int64_t row = 0; row < this->rows; ++row){
+        for(int64_t col = 0; col < this->columns; ++col){
+            const auto val = static_cast<double>(img.value(row, col, chan));
+            if(!std::isfinite(val)) continue;
+            total += val;
+            ++finite;
+        }
+    }
+    this->shift = (0 < finite) ? total / static_cast<double>(finite) : 0.0;
+
+    const auto N = static_cast<size_t>((this->rows + 1) * (this->columns + 1));
+    this->sums.assign(N, 0.0);
+    this->sums_sq.assign(N, 0.0);
+    this->counts.assign(N, 0);
+
+    // Each entry accumulates the pixels above and to the left, i.e., T(r,c) = x(r-1,c-1) + T(r-1,c) + T(r,c-1)
+    // - T(r-1,c-1), evaluated as a running row sum added to the previous row's entries.
+    for(int64_t row = 0; row < this->rows; ++row){
+        double row_sum = 0.0;
+        double row_sum_sq = 0.0;
+        int64_t row_count = 0;
+        for(int64_t col = 0; col < this->columns; ++col){
+            const auto val = static_cast<double>(img.value(row, col, chan));
+            if(std::isfinite(val)){
+                const auto x = val - this->shift;
+                row_sum += x;
+                row_sum_sq += x * x;
+                ++row_count;
+            }
+            const auto i = this->index(row + 1, col + 1);
+            const auto above = this->index(row, col + 1);
+            this->sums[i] = this->sums[above] + row_sum;
+            this->sums_sq[i] = this->sums_sq[above] + row_sum_sq;
+            this->counts[i] = this->counts[above] + row_count;
+        }
+    }
+}
+
+int64_t integral_image::get_rows() const {
+    return this->rows;
+}
+
+int64_t integral_image::get_columns() const {
+    return this->columns;
+}
+
+int64_t integral_image::index(int64_t row, int64_t col) const {
+    return row * (this->columns + 1) + col;
+}
+
+integral_image::window_stats
+integral_image::window(int64_t row_min, int64_t col_min, int64_t row_max, int64_t col_max) const {
+    window_stats out;
+    out.shift = this->shift;
+
+    row_min = std::max<int64_t>(row_min, 0);
+    col_min = std::max<int64_t>(col_min, 0);
+    row_max = std::min<int64_t>(row_max, this->rows - 1);
+    col_max = std::min<int64_t>(col_max, this->columns - 1);
+    if( (row_max < row_min) || (col_max < col_min) ) return out;
+
+    const auto br = this->index(row_max + 1, col_max + 1);
+    const auto tr = this->index(row_min, col_max + 1);
+    const auto bl = this->index(row_max + 1, col_min);
+    const auto tl = this->index(row_min, col_min);
+    out.count = this->counts[br] - this->counts[tr] - this->counts[bl] + this->counts[tl];
+    out.shifted_sum = this->sums[br] - this->sums[tr] - this->sums[bl] + this->sums[tl];
+    out.shifted_sum_sq = this->sums_sq[br] - this->sums_sq[tr] - this->sums_sq[bl] + this->sums_sq[tl];
+    return out;
+}
+
+integral_image::window_stats
+integral_image::box(int64_t row, int64_t col, int64_t radius) const {
+    return this->window(row - radius, col - radius, row + radius, col + radius);
+}
+
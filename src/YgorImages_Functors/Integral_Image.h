@@ -0,0 +1,56 @@
+//Integral_Image.h.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "YgorImages.h"
+
+
+// Summed-area tables of one channel of an image, for constant-time statistics over rectangular pixel windows.
+//
+// The sum, sum of squares, and count of the finite pixels in every window are each computed from four table lookups,
+// so local means and variances cost the same regardless of the window size. Non-finite pixels are excluded from all
+// statistics. Windows are clamped to the image.
+//
+// Values are shifted by the mean of the channel before being accumulated, which keeps the sums of squares small and
+// limits cancellation when variances are computed from them.
+class integral_image {
+  public:
+    struct window_stats {
+        int64_t count = 0;           // Number of finite pixels.
+        double shift = 0.0;
+        double shifted_sum = 0.0;    // Sum of (x - shift) over the finite pixels.
+        double shifted_sum_sq = 0.0; // Sum of (x - shift)^2 over the finite pixels.
+
+        double sum() const;
+        double mean() const;              // NaN if there are no finite pixels.
+        double variance() const;          // The unbiased estimate. NaN if there are fewer than two finite pixels.
+        double standard_deviation() const;
+    };
+
+    integral_image(const planar_image<float,double> &img, int64_t chan);
+
+    int64_t get_rows() const;
+    int64_t get_columns() const;
+
+    // Statistics over the inclusive window [row_min, row_max] x [col_min, col_max].
+    window_stats window(int64_t row_min, int64_t col_min, int64_t row_max, int64_t col_max) const;
+
+    // Statistics over the (2*radius + 1) x (2*radius + 1) window centred on the pixel.
+    window_stats box(int64_t row, int64_t col, int64_t radius) const;
+
+  private:
+    int64_t rows = 0;
+    int64_t columns = 0;
+    double shift = 0.0;
+
+    // Tables have (rows + 1) x (columns + 1) entries, with a leading row and column of zeros.
+    std::vector<double> sums;
+    std::vector<double> sums_sq;
+    std::vector<int64_t> counts;
+
+    int64_t index(int64_t row, int64_t col) const;
+};
+
@@ -0,0 +1,197 @@
+//Multiplanar_Reformat.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Thread_Pool.h"
+#include "Rectilinear_Volume.h"
+#include "Multiplanar_Reformat.h"
+
+
+namespace {
+
+// The number of planes (and lines within each plane) copied together when transposing.
+constexpr long int tile_size = 32;
+
+// Element strides of a planar_image's pixel buffer, derived from its own indexing so no layout is assumed.
+struct image_strides {
+    long int row  = 0;
+    long int col  = 0;
+    long int chnl = 0;
+};
+
+image_strides get_strides(const planar_image<float,double> &img){
+    image_strides s;
+    const auto base = img.index(0, 0, 0);
+    if(1 < img.rows)     s.row  = img.index(1, 0, 0) - base;
+    if(1 < img.columns)  s.col  = img.index(0, 1, 0) - base;
+    if(1 < img.channels) s.chnl = img.index(0, 0, 1) - base;
+    return s;
+}
+
+void check_volume(const rectilinear_volume &vol){
+    if( (vol.images < 1) || (vol.rows < 1) || (vol.columns < 1) || (vol.channels < 1) ){
+        throw std::invalid_argument("Volume is empty. Cannot reformat.");
+    }
+    if(!vol.is_regular){
+        throw std::invalid_argument("Volume images are not evenly spaced. Cannot reformat.");
+    }
+    return;
+}
+
+} // namespace
+
+
+std::list<planar_image<float,double>>
+Reformat_Orthogonal(const rectilinear_volume &vol,
+                    orthogonal_reformat plane,
+                    long int stride,
+                    const vec3<double> &anchor){
+    check_volume(vol);
+    if(stride < 1){
+        throw std::invalid_argument("Plane stride must be positive. Cannot reformat.");
+    }
+
+    // Output rows step from the first packed image toward the last.
+    const auto spacing = vol.image_spacing();
+    const auto step_unit = (spacing < 0.0) ? vol.ortho_unit * -1.0 : vol.ortho_unit;
+    const auto pxl_dx = (vol.images < 2) ? vol.pxl_dz : std::abs(spacing);
+
+    const bool fixed_row = (plane == orthogonal_reformat::FixedRow);
+    const auto N_src  = (fixed_row) ? vol.rows : vol.columns;
+    const auto N_cols = (fixed_row) ? vol.columns : vol.rows;
+    const auto col_unit = (fixed_row) ? vol.col_unit : vol.row_unit;
+    const auto pxl_dy = (fixed_row) ? vol.pxl_dy : vol.pxl_dx;
+    const auto pxl_dz = (fixed_row) ? vol.pxl_dx : vol.pxl_dy;
+    const auto plane_step = (fixed_row) ? vol.row_unit * vol.pxl_dx : vol.col_unit * vol.pxl_dy;
+    const auto src_plane_stride = (fixed_row) ? vol.row_stride : vol.column_stride;
+    const auto src_line_stride  = (fixed_row) ? vol.column_stride : vol.row_stride;
+
+    const auto N_out = (N_src + stride - 1) / stride;
+    std::vector<planar_image<float,double>> out(N_out);
+    for(long int p = 0; p < N_out; ++p){
+        const auto origin = vol.image_origins.front() + plane_step * static_cast<double>(p * stride);
+        out[p].init_buffer(vol.images, N_cols, vol.channels);
+        out[p].init_spatial(pxl_dx, pxl_dy, pxl_dz, anchor, origin - anchor);
+        out[p].init_orientation(step_unit, col_unit);
+    }
+    const auto ds = get_strides(out.front());
+
+    // Each task handles one source image and a tile of lines, visiting the output planes a tile at a time. Reads
+    // follow the packed buffer and each plane's writes stay within a short run of a single row.
+    const auto N_line_tiles = (N_cols + tile_size - 1) / tile_size;
+    parallel_for(0, vol.images * N_line_tiles, [&](long int t){
+        const auto k = t / N_line_tiles;
+        const auto j_begin = (t % N_line_tiles) * tile_size;
+        const auto j_end = std::min(N_cols, j_begin + tile_size);
+        const float *src = vol.image_data(k);
+
+        for(long int p_begin = 0; p_begin < N_out; p_begin += tile_size){
+            const auto p_end = std::min(N_out, p_begin + tile_size);
+            for(auto j = j_begin; j < j_end; ++j){
+                for(auto p = p_begin; p < p_end; ++p){
+                    const float *s = src + (p * stride) * src_plane_stride + j * src_line_stride;
+                    float *d = out[p].data.data() + k * ds.row + j * ds.col;
+                    for(long int c = 0; c < vol.channels; ++c) d[c * ds.chnl] = s[c];
+                }
+            }
+        }
+    }, 1);
+
+    return std::list<planar_image<float,double>>(std::make_move_iterator(std::begin(out)),
+                                                 std::make_move_iterator(std::end(out)));
+}
+
+
+planar_image<float,double>
+Reformat_Oblique(const rectilinear_volume &vol,
+                 const reformat_plane_geometry &geom,
+                 float out_of_bounds,
+                 const vec3<double> &anchor){
+    check_volume(vol);
+    if( (geom.rows < 1) || (geom.columns < 1) ){
+        throw std::invalid_argument("Plane must have at least one row and column. Cannot reformat.");
+    }
+
+    planar_image<float,double> out;
+    out.init_buffer(geom.rows, geom.columns, vol.channels);
+    out.init_spatial(geom.pxl_dx, geom.pxl_dy, geom.pxl_dz, anchor, geom.origin - anchor);
+    out.init_orientation(geom.row_unit, geom.col_unit);
+
+    parallel_for(0, geom.rows, [&](long int row){
+        const auto row_origin = geom.origin + geom.row_unit * (geom.pxl_dx * static_cast<double>(row));
+        for(long int col = 0; col < geom.columns; ++col){
+            const auto pos = row_origin + geom.col_unit * (geom.pxl_dy * static_cast<double>(col));
+            for(long int chnl = 0; chnl < vol.channels; ++chnl){
+                out.reference(row, col, chnl) = vol.interpolate(pos, chnl, out_of_bounds);
+            }
+        }
+    }, 1);
+    return out;
+}
+
+
+std::list<reformat_plane_geometry>
+Oblique_Reformat_Planes(const rectilinear_volume &vol,
+                        const vec3<double> &normal,
+                        double pxl_dxy,
+                        double separation){
+    check_volume(vol);
+    if(!normal.isfinite() || !(0.0 < normal.length())){
+        throw std::invalid_argument("Plane normal is invalid. Cannot reformat.");
+    }
+    if( !std::isfinite(pxl_dxy) || !(0.0 < pxl_dxy)
+    ||  !std::isfinite(separation) || !(0.0 < separation) ){
+        throw std::invalid_argument("Plane spacing must be finite and positive. Cannot reformat.");
+    }
+
+    // Follow the volume's row unit, falling back to the column unit when the normal is (nearly) parallel to it.
+    const auto N = normal.unit();
+    auto row_unit = vol.row_unit - N * vol.row_unit.Dot(N);
+    if(row_unit.length() < 1.0E-3) row_unit = vol.col_unit - N * vol.col_unit.Dot(N);
+    row_unit = row_unit.unit();
+    const auto col_unit = N.Cross(row_unit).unit();
+
+    // Bound the corner voxel centres along each axis.
+    const auto inf = std::numeric_limits<double>::infinity();
+    double min_r = inf, max_r = -inf, min_c = inf, max_c = -inf, min_n = inf, max_n = -inf;
+    for(const auto img : { 0L, vol.images - 1 }){
+        for(const auto row : { 0L, vol.rows - 1 }){
+            for(const auto col : { 0L, vol.columns - 1 }){
+                const auto p = vol.position(img, row, col);
+                min_r = std::min(min_r, p.Dot(row_unit));
+                max_r = std::max(max_r, p.Dot(row_unit));
+                min_c = std::min(min_c, p.Dot(col_unit));
+                max_c = std::max(max_c, p.Dot(col_unit));
+                min_n = std::min(min_n, p.Dot(N));
+                max_n = std::max(max_n, p.Dot(N));
+            }
+        }
+    }
+
+    reformat_plane_geometry geom;
+    geom.row_unit = row_unit;
+    geom.col_unit = col_unit;
+    geom.rows    = static_cast<long int>(std::floor((max_r - min_r) / pxl_dxy)) + 1;
+    geom.columns = static_cast<long int>(std::floor((max_c - min_c) / pxl_dxy)) + 1;
+    geom.pxl_dx = pxl_dxy;
+    geom.pxl_dy = pxl_dxy;
+    geom.pxl_dz = separation;
+
+    const auto N_planes = static_cast<long int>(std::floor((max_n - min_n) / separation)) + 1;
+    std::list<reformat_plane_geometry> out;
+    for(long int i = 0; i < N_planes; ++i){
+        geom.origin = row_unit * min_r + col_unit * min_c + N * (min_n + separation * static_cast<double>(i));
+        out.push_back(geom);
+    }
+    return out;
+}
@@ -0,0 +1,60 @@
+//Multiplanar_Reformat.h.
+
+#pragma once
+
+#include <list>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Rectilinear_Volume.h"
+
+
+// Multiplanar reformatting (reslicing) of regular rectilinear volumes.
+//
+// Orthogonal reformats copy voxels exactly, without interpolation. Every output row spans the volume's images, in the
+// order the images were packed, so the slowest-varying axis of the packed buffer becomes the fastest-varying axis of
+// each output image. Planes are generated together from cache-sized tiles so every source voxel is read once.
+//
+// Oblique reformats sample the volume with trilinear interpolation (see rectilinear_volume::interpolate()).
+
+enum class orthogonal_reformat {
+    FixedRow,     // One image per volume row, spanning (volume image, volume column).
+    FixedColumn,  // One image per volume column, spanning (volume image, volume row).
+};
+
+// Generates the reformatted planes, keeping every 'stride'-th plane starting with the first. Output images have rows
+// directed from the first packed image toward the last, and have no metadata. Throws if the volume is irregular.
+std::list<planar_image<float,double>>
+Reformat_Orthogonal(const rectilinear_volume &vol,
+                    orthogonal_reformat plane,
+                    long int stride = 1,
+                    const vec3<double> &anchor = vec3<double>(0.0, 0.0, 0.0));
+
+
+// The geometry of a single output plane.
+struct reformat_plane_geometry {
+    vec3<double> origin;    // Position of voxel (row=0, column=0).
+    vec3<double> row_unit;
+    vec3<double> col_unit;
+    long int rows    = 0;
+    long int columns = 0;
+    double pxl_dx = 1.0;    // Row spacing.
+    double pxl_dy = 1.0;    // Column spacing.
+    double pxl_dz = 1.0;    // Slice thickness.
+};
+
+// Samples every channel of the volume on the plane. Positions outside the volume receive the out-of-bounds value.
+planar_image<float,double>
+Reformat_Oblique(const rectilinear_volume &vol,
+                 const reformat_plane_geometry &geom,
+                 float out_of_bounds,
+                 const vec3<double> &anchor = vec3<double>(0.0, 0.0, 0.0));
+
+// Returns a stack of parallel planes with the given normal that covers the volume, with the given in-plane voxel
+// spacing and separation between planes. The planes' row units follow the volume's row unit as closely as possible.
+std::list<reformat_plane_geometry>
+Oblique_Reformat_Planes(const rectilinear_volume &vol,
+                        const vec3<double> &normal,
+                        double pxl_dxy,
+                        double separation);
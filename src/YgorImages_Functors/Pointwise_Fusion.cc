@@ -0,0 +1,110 @@
+//Pointwise_Fusion.cc.
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorStats.h"       //Needed for Stats:: namespace.
+
+#include "../Structs.h"
+#include "../Thread_Pool.h"
+#include "../Paged_Images.h"
+#include "ConvenienceRoutines.h"
+#include "Pointwise_Fusion.h"
+
+
+namespace {
+
+// The number of pixels transformed by every stage before moving on. Small enough to remain in the L1/L2 caches for
+// several channels.
+constexpr long int block_pixels = 2048;
+
+void apply_to_image(planar_image<float,double> &img, const std::vector<const pointwise_stage *> &stages){
+    const long int pixels = img.rows * img.columns;
+    const long int channels = img.channels;
+    if((pixels <= 0) || (channels <= 0)) return;
+    for(const auto &s : stages){
+        if(channels <= s->channel){
+            throw std::invalid_argument("Channel " + std::to_string(s->channel) + " is not present for operation '"
+                                        + s->name + "'");
+        }
+    }
+
+    // The value for (pixel p, channel c) is located at base[c] + p * stride.
+    std::vector<long int> base(channels);
+    for(long int c = 0; c < channels; ++c) base[c] = img.index(0, 0, c);
+    const long int stride = (pixels == 1) ? 1
+                          : (((1 < img.columns) ? img.index(0, 1, 0) : img.index(1, 0, 0)) - base[0]);
+    bool interleaved = (stride == channels);
+    for(long int c = 0; c < channels; ++c) interleaved = interleaved && (base[c] == base[0] + c);
+
+    std::vector<Stats::Running_MinMax<float>> minmax(stages.size());
+    float *data = img.data.data();
+    for(long int b = 0; b < pixels; b += block_pixels){
+        const auto n = static_cast<size_t>(std::min(block_pixels, pixels - b));
+        for(size_t k = 0; k < stages.size(); ++k){
+            const auto &s = *(stages[k]);
+            if((s.channel < 0) && interleaved){
+                s.transform(data + base[0] + b * stride, n * channels, 1, minmax[k]);
+            }else{
+                const auto c_begin = (s.channel < 0) ? 0 : s.channel;
+                const auto c_end   = (s.channel < 0) ? channels : s.channel + 1;
+                for(long int c = c_begin; c < c_end; ++c){
+                    s.transform(data + base[c] + b * stride, n, stride, minmax[k]);
+                }
+            }
+        }
+    }
+
+    for(size_t k = 0; k < stages.size(); ++k){
+        if(!stages[k]->description.empty()) UpdateImageDescription( std::ref(img), stages[k]->description );
+        if(stages[k]->update_window) UpdateImageWindowCentreWidth( std::ref(img), minmax[k] );
+        for(const auto &kv : stages[k]->metadata) img.metadata[kv.first] = kv.second;
+    }
+    return;
+}
+
+} // namespace
+
+
+void Apply_Pointwise_Stages(const std::vector<pointwise_stage> &stages){
+    // Group the stages by array, preserving their order.
+    std::vector<std::shared_ptr<Image_Array>> arrays;
+    std::vector<std::vector<const pointwise_stage *>> array_stages;
+    for(const auto &s : stages){
+        for(const auto &ia : s.arrays){
+            if(ia == nullptr) continue;
+            const auto it = std::find(std::begin(arrays), std::end(arrays), ia);
+            const auto i = static_cast<size_t>(std::distance(std::begin(arrays), it));
+            if(it == std::end(arrays)){
+                arrays.push_back(ia);
+                array_stages.emplace_back();
+            }
+            array_stages[i].push_back(&s);
+        }
+    }
+
+    for(size_t i = 0; i < arrays.size(); ++i){
+        const auto &a_stages = array_stages[i];
+        if(auto store = arrays[i]->get_page_store()){
+            Stream_Images(*store, [&](paged_image_store::image_list_t::iterator img_it) -> void {
+                apply_to_image(*img_it, a_stages);
+            });
+        }else{
+            std::vector<planar_image<float,double> *> imgs;
+            for(auto &img : arrays[i]->imagecoll.images) imgs.push_back( std::addressof(img) );
+            parallel_for(0, static_cast<long int>(imgs.size()), [&](long int j){
+                apply_to_image(*(imgs[j]), a_stages);
+            }, 1);
+        }
+    }
+    return;
+}
+
@@ -0,0 +1,45 @@
+//Pointwise_Fusion.h.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "YgorStats.h"       //Needed for Stats:: namespace.
+
+class Image_Array;
+
+
+// A per-voxel transformation that can be fused with others into a single traversal of the voxels.
+//
+// Operations can provide a stage when the new value of each voxel depends only on its current value, and the metadata
+// updates depend only on the transformed values. Fused stages are applied block-by-block, so each block of voxels is
+// transformed by every stage while it is still in cache, rather than each operation making a full pass over the images.
+struct pointwise_stage {
+    std::string name; // The operation name, for reporting.
+
+    // The arrays the stage applies to. Selections must be resolved before any of the fused stages are applied.
+    std::vector<std::shared_ptr<Image_Array>> arrays;
+
+    // The channel to transform, or -1 to transform all channels.
+    long int channel = -1;
+
+    // Transforms 'n' values, separated by 'stride', in-place. Transformed values that should contribute to the image
+    // window are digested. It is invoked concurrently for distinct blocks of voxels, so it must be thread-safe.
+    std::function<void(float *vals, size_t n, size_t stride, Stats::Running_MinMax<float> &minmax)> transform;
+
+    // Metadata updates that are applied after all voxels have been transformed.
+    std::string description;    // Appended to the image description, if not empty.
+    bool update_window = false; // Whether to derive the window centre and width from the digested values.
+    std::map<std::string, std::string> metadata; // Assigned to every image.
+};
+
+// Applies the stages, in order, to all images of the arrays they apply to. The result is the same as applying each
+// stage to every image before applying the next, but only a single pass over the voxels is needed. Paged-out arrays
+// are streamed.
+void Apply_Pointwise_Stages(const std::vector<pointwise_stage> &stages);
+
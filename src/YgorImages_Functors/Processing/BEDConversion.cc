@@ -15,6 +15,33 @@
 
 template <class T> class contour_collection;
 
+std::function<double(double)> BEDConversion_Transform(const BEDConversionUserData &ud, double abr){
+    const auto n = ud.NumberOfFractions;
+
+    if(ud.model == BEDConversionUserData::Model::BEDSimpleLinearQuadratic){
+        return [n, abr](double D){
+            return BEDabr_from_n_D_abr(n, D, abr).val;
+        };
+
+    }else if(ud.model == BEDConversionUserData::Model::EQDXSimpleLinearQuadratic){
+        const auto x = ud.TargetDosePerFraction;
+        return [n, x, abr](double D){
+            const auto numer = D * ( (D / n) + abr );
+            const auto denom = (x + abr);
+            return numer / denom;
+        };
+
+    }else if(ud.model == BEDConversionUserData::Model::EQDXPinnedLinearQuadratic){
+        // See the explanation in BEDConversion() below.
+        const auto BED_actual = BEDabr_from_n_D_abr(n, ud.PrescriptionDose, ud.AlphaBetaRatioEarly);
+        const auto EQD_n = D_from_d_BEDabr(ud.TargetDosePerFraction, BED_actual) / ud.TargetDosePerFraction;
+        return [n, abr, EQD_n](double D){
+            return D_from_n_BEDabr(EQD_n, BEDabr_from_n_D_abr(n, D, abr));
+        };
+    }
+    throw std::invalid_argument("Model not specified or invalid.");
+}
+
 bool BEDConversion(planar_image_collection<float,double>::images_list_it_t first_img_it,
                    std::list<planar_image_collection<float,double>::images_list_it_t> selected_img_its,
                    std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
@@ -51,9 +78,6 @@ bool BEDConversion(planar_image_collection<float,double>::images_list_it_t first
     ebv_opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
     ebv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
 
-    std::function< void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &) > f_bounded;
-    std::function< void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &) > f_unbounded;
-
     if(user_data_s->model == BEDConversionUserData::Model::BEDSimpleLinearQuadratic){
         if(user_data_s->NumberOfFractions <= 0){
             throw std::invalid_argument("NumberOfFractions not specified or invalid.");
@@ -63,24 +87,6 @@ bool BEDConversion(planar_image_collection<float,double>::images_list_it_t first
             throw std::invalid_argument("AlphaBetaRatioLate not specified or invalid.");
         }
 
-        f_bounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            const auto D_voxel = voxel_val;
-            const auto BED = BEDabr_from_n_D_abr(user_data_s->NumberOfFractions, D_voxel, user_data_s->AlphaBetaRatioEarly).val;
-            voxel_val = BED;
-            return;
-        };
-
-        f_unbounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            const auto D_voxel = voxel_val;
-            const auto BED = BEDabr_from_n_D_abr(user_data_s->NumberOfFractions, D_voxel, user_data_s->AlphaBetaRatioLate).val;
-            voxel_val = BED;
-            return;
-        };
-
         first_img_it->metadata["BED_NumberOfFractions"] = std::to_string(user_data_s->NumberOfFractions);
         first_img_it->metadata["BED_Model"] = "Simple LQ";
         first_img_it->metadata["BED_DosePerFraction"] = std::to_string(user_data_s->TargetDosePerFraction);
@@ -98,28 +104,6 @@ bool BEDConversion(planar_image_collection<float,double>::images_list_it_t first
             throw std::invalid_argument("AlphaBetaRatioLate not specified or invalid.");
         }
 
-        f_bounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            const auto D_voxel = voxel_val;
-            const auto numer = D_voxel * ( (D_voxel / user_data_s->NumberOfFractions) + user_data_s->AlphaBetaRatioEarly );
-            const auto denom = (user_data_s->TargetDosePerFraction + user_data_s->AlphaBetaRatioEarly );
-            const auto EQD = numer / denom;
-            voxel_val = EQD;
-            return;
-        };
-
-        f_unbounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            const auto D_voxel = voxel_val;
-            const auto numer = D_voxel * ( (D_voxel / user_data_s->NumberOfFractions) + user_data_s->AlphaBetaRatioLate );
-            const auto denom = (user_data_s->TargetDosePerFraction + user_data_s->AlphaBetaRatioLate );
-            const auto EQD = numer / denom;
-            voxel_val = EQD;
-            return;
-        };
-
         first_img_it->metadata["EQDx_NumberOfFractions"] = std::to_string(user_data_s->NumberOfFractions);
         first_img_it->metadata["EQDx_Model"] = "Simple LQ";
         first_img_it->metadata["EQDx_DosePerFraction"] = std::to_string(user_data_s->TargetDosePerFraction);
@@ -157,28 +141,6 @@ bool BEDConversion(planar_image_collection<float,double>::images_list_it_t first
             EQD_n = EQD_D / user_data_s->TargetDosePerFraction;
         }
 
-        f_bounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            BEDabr BED_voxel;
-            BED_voxel = BEDabr_from_n_D_abr(user_data_s->NumberOfFractions,
-                                            voxel_val,
-                                            user_data_s->AlphaBetaRatioEarly);
-            voxel_val = D_from_n_BEDabr(EQD_n, BED_voxel);
-            return;
-        };
-
-        f_unbounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            BEDabr BED_voxel;
-            BED_voxel = BEDabr_from_n_D_abr(user_data_s->NumberOfFractions,
-                                            voxel_val,
-                                            user_data_s->AlphaBetaRatioLate);
-            voxel_val = D_from_n_BEDabr(EQD_n, BED_voxel);
-            return;
-        };
-
         first_img_it->metadata["EQDx_PrescriptionDose"] = std::to_string(user_data_s->PrescriptionDose);
         first_img_it->metadata["EQDx_NumberOfFractions"] = std::to_string(user_data_s->NumberOfFractions);
         first_img_it->metadata["EQDx_PrescriptionDose"] = std::to_string(EQD_D);
@@ -192,6 +154,24 @@ bool BEDConversion(planar_image_collection<float,double>::images_list_it_t first
         throw std::invalid_argument("Model not specified or invalid.");
     }
 
+    //Voxels bounded by the ROI(s) are treated as early-responding tissue. Lookup tables are used when available.
+    const auto early = BEDConversion_Transform(*user_data_s, user_data_s->AlphaBetaRatioEarly);
+    const auto late = BEDConversion_Transform(*user_data_s, user_data_s->AlphaBetaRatioLate);
+    const auto &early_lut = user_data_s->EarlyLUT;
+    const auto &late_lut = user_data_s->LateLUT;
+
+    auto f_bounded = [&](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
+        if(voxel_val <= 0.0) return; // No-op if there is no dose.
+        voxel_val = early_lut.empty() ? static_cast<float>(early(voxel_val)) : early_lut(voxel_val);
+        return;
+    };
+
+    auto f_unbounded = [&](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
+        if(voxel_val <= 0.0) return; // No-op if there is no dose.
+        voxel_val = late_lut.empty() ? static_cast<float>(late(voxel_val)) : late_lut(voxel_val);
+        return;
+    };
+
     std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
     for(auto &img_it : selected_img_its) selected_imgs.push_back( std::ref(*img_it) );
 
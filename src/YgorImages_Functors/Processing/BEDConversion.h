@@ -8,6 +8,8 @@
 
 #include "YgorImages.h"
 
+#include "../../Uniform_LUT.h"
+
 template <class T> class contour_collection;
 
 
@@ -45,8 +47,17 @@ struct BEDConversionUserData {
     // PinnedLinearQuadratic parameters.
     double PrescriptionDose = -1.0;
 
+    // -----------------------------
+    // Optional lookup tables for the early- and late-responding tissue transforms (see BEDConversion_Transform),
+    // e.g., compiled once for all images. If empty, the transforms are evaluated for every voxel.
+    uniform_lut EarlyLUT;
+    uniform_lut LateLUT;
+
 };
 
+// The dose transform for the selected model, given the tissue alpha/beta ratio.
+std::function<double(double)> BEDConversion_Transform(const BEDConversionUserData &ud, double abr);
+
 
 bool BEDConversion(planar_image_collection<float,double>::images_list_it_t first_img_it,
                    std::list<planar_image_collection<float,double>::images_list_it_t> ,
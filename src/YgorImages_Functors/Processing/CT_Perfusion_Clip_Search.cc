@@ -1,10 +1,15 @@
 
 #include <algorithm>
 #include <any>
+#include <exception>
 #include <functional>
 #include <list>
+#include <stdexcept>
+#include <vector>
 
 #include "../ConvenienceRoutines.h"
+#include "../Integral_Image.h"
+#include "CT_Perfusion_Clip_Search.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
 #include "YgorStats.h"       //Needed for Stats:: namespace.
@@ -16,7 +21,7 @@ bool CTPerfusionSearchForLiverClips(planar_image_collection<float,double>::image
                                     std::list<planar_image_collection<float,double>::images_list_it_t> selected_img_its,
                                     std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
                                     std::list<std::reference_wrapper<contour_collection<double>>>, 
-                                    std::any ){
+                                    std::any user_data ){
 
     //This routine searches for surgically-implanted liver markers or 'clips' which appear in some CT slices.
     // The region around clips is slightly distorted. The basic idea is to figure out a generic signature which 
@@ -33,40 +38,67 @@ bool CTPerfusionSearchForLiverClips(planar_image_collection<float,double>::image
         return false;
     }
 
+    CTPerfusionSearchForLiverClipsUserData defaults;
+    CTPerfusionSearchForLiverClipsUserData *user_data_s = &defaults;
+    if(user_data.has_value()){
+        try{
+            user_data_s = std::any_cast<CTPerfusionSearchForLiverClipsUserData *>(user_data);
+        }catch(const std::exception &e){
+            FUNCWARN("Unable to cast user_data to appropriate format. Cannot continue with computation");
+            return false;
+        }
+    }
+
     //Paint all pixels black.
     working.fill_pixels(static_cast<float>(0));
 
     //Record the min and max actual pixel values for windowing purposes.
     Stats::Running_MinMax<float> minmax_pixel;
 
-    //Loop over the rows, columns, channels, and finally selected_images in the time course.
-    auto boxr = 2; //The inclusive 'radius' of the square box to use to average nearby pixels.
-    for(auto row = boxr; (row + boxr) < first_img_it->rows; ++row){
-        for(auto col = boxr; (col + boxr) < first_img_it->columns; ++col){
-            for(auto chan = 0; chan < first_img_it->channels; ++chan){
-
-                //Collect the datum of voxels and nearby voxels for an average.
-                std::list<double> in_pixs;
-                for(auto lrow = (row-boxr); lrow <= (row+boxr); ++lrow){
-                    for(auto lcol = (col-boxr); lcol <= (col+boxr); ++lcol){
-                        if( !isininc(0,lrow,first_img_it->rows-1) || !isininc(0,lcol,first_img_it->columns-1) ){
-                            FUNCERR("Check your boxr programming. Off by one?");
-                        }
-
-                        const auto val = static_cast<double>(first_img_it->value(lrow, lcol, chan));
-                        in_pixs.push_back(val);
+    //Only pixels whose box is entirely within the image are considered.
+    const auto boxr = user_data_s->box_radius;
+    if(boxr < 0) throw std::invalid_argument("Box radius must be non-negative.");
+    const auto rows = first_img_it->rows;
+    const auto cols = first_img_it->columns;
+
+    for(auto chan = 0; chan < first_img_it->channels; ++chan){
+        if(user_data_s->statistic == CTPerfusionSearchForLiverClipsUserData::Statistic::StandardDeviation){
+            const integral_image sat(*first_img_it, chan);
+            for(auto row = boxr; (row + boxr) < rows; ++row){
+                for(auto col = boxr; (col + boxr) < cols; ++col){
+                    const auto newval = static_cast<float>(sat.box(row, col, boxr).standard_deviation());
+                    working.reference(row, col, chan) = newval;
+                    minmax_pixel.Digest(newval);
+                }
+            }
+
+        }else if(user_data_s->statistic == CTPerfusionSearchForLiverClipsUserData::Statistic::Maximum){
+            //The maximum over each row segment is found first, and then the maximum of those over each column.
+            std::vector<float> row_max(static_cast<size_t>(rows * cols), 0.0f);
+            for(auto row = 0; row < rows; ++row){
+                for(auto col = boxr; (col + boxr) < cols; ++col){
+                    auto m = first_img_it->value(row, col - boxr, chan);
+                    for(auto lcol = (col - boxr + 1); lcol <= (col + boxr); ++lcol){
+                        m = std::max(m, first_img_it->value(row, lcol, chan));
                     }
+                    row_max[row * cols + col] = m;
                 }
-                //const auto RawNewVal = std::sqrt(Stats::Unbiased_Var_Est(in_pixs));
-                const auto RawNewVal = *std::max_element(in_pixs.begin(), in_pixs.end());
-
-                const auto newval = static_cast<float>(RawNewVal);
-                working.reference(row, col, chan) = newval;
-                minmax_pixel.Digest(newval);
+            }
+            for(auto row = boxr; (row + boxr) < rows; ++row){
+                for(auto col = boxr; (col + boxr) < cols; ++col){
+                    auto newval = row_max[(row - boxr) * cols + col];
+                    for(auto lrow = (row - boxr + 1); lrow <= (row + boxr); ++lrow){
+                        newval = std::max(newval, row_max[lrow * cols + col]);
+                    }
+                    working.reference(row, col, chan) = newval;
+                    minmax_pixel.Digest(newval);
+                }
+            }
 
-            }//Loop over channels.
-        } //Loop over cols
-    } //Loop over rows
+        }else{
+            throw std::invalid_argument("Unrecognized statistic.");
+        }
+    }//Loop over channels.
 
     //Swap the original image with the working image.
     *first_img_it = working;
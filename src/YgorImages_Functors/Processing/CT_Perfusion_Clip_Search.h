@@ -15,6 +15,20 @@
 #include "YgorImages.h"
 
 
+struct CTPerfusionSearchForLiverClipsUserData {
+
+    // The statistic computed over the box surrounding each pixel.
+    enum class Statistic {
+        Maximum,            // Computed with separable (row, then column) passes.
+        StandardDeviation,  // Computed from summed-area tables, so the cost does not depend on the box size.
+    } statistic = Statistic::Maximum;
+
+    long int box_radius = 2; // The inclusive 'radius' of the square box.
+
+};
+
+
+// The user data is optional; defaults are used if none is provided.
 bool CTPerfusionSearchForLiverClips(planar_image_collection<float,double>::images_list_it_t first_img_it,
                                     std::list<planar_image_collection<float,double>::images_list_it_t> selected_img_its,
                                     std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
@@ -8,6 +8,8 @@
 
 #include "YgorImages.h"
 
+#include "../../Uniform_LUT.h"
+
 template <class T> class contour_collection;
 
 typedef enum { // Controls how dose is decayed (i.e., selects the model).
@@ -52,8 +54,15 @@ struct DecayDoseOverTimeUserData {
                                              // one is claimed to be more conservative. So
                                              // it should preferably be used.
 
+    // Optional lookup table for the dose transform (see DecayDoseOverTime_Transform), e.g., compiled once for all
+    // images. If empty, the transform is evaluated for every voxel.
+    uniform_lut LUT;
+
 };
 
+// The dose transform for the selected model.
+std::function<double(double)> DecayDoseOverTime_Transform(const DecayDoseOverTimeUserData &ud);
+
 
 bool DecayDoseOverTime(planar_image_collection<float,double>::images_list_it_t first_img_it,
                     std::list<planar_image_collection<float,double>::images_list_it_t> ,
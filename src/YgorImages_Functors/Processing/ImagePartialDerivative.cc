@@ -1,4 +1,6 @@
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <exception>
 #include <functional>
@@ -6,15 +8,167 @@
 #include <list>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "../ConvenienceRoutines.h"
 #include "ImagePartialDerivative.h"
 #include "YgorImages.h"
+#include "YgorMath.h"
 #include "YgorMisc.h"
 #include "YgorStats.h"       //Needed for Stats:: namespace.
 
 template <class T> class contour_collection;
 
+
+namespace {
+
+using estimator_t = std::function<float(const planar_image<float,double> &, long int, long int, long int)>;
+
+// The components of each estimator: row- and column-aligned (or, for the Roberts cross, +row+column- and
+// -row+column-aligned) followed by the cross derivative, where applicable.
+std::array<estimator_t, 3> estimator_components(PartialDerivativeEstimator order){
+    using img_t = planar_image<float,double>;
+    switch(order){
+        case PartialDerivativeEstimator::first:
+            return {{ [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.row_aligned_derivative_centered_finite_difference(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.column_aligned_derivative_centered_finite_difference(r, c, ch); },
+                      estimator_t() }};
+        case PartialDerivativeEstimator::Roberts_cross_3x3:
+            return {{ [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.prow_pcol_aligned_Roberts_cross_3x3(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.nrow_pcol_aligned_Roberts_cross_3x3(r, c, ch); },
+                      estimator_t() }};
+        case PartialDerivativeEstimator::Prewitt_3x3:
+            return {{ [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.row_aligned_Prewitt_derivative_3x3(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.column_aligned_Prewitt_derivative_3x3(r, c, ch); },
+                      estimator_t() }};
+        case PartialDerivativeEstimator::Sobel_3x3:
+            return {{ [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.row_aligned_Sobel_derivative_3x3(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.column_aligned_Sobel_derivative_3x3(r, c, ch); },
+                      estimator_t() }};
+        case PartialDerivativeEstimator::Sobel_5x5:
+            return {{ [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.row_aligned_Sobel_derivative_5x5(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.column_aligned_Sobel_derivative_5x5(r, c, ch); },
+                      estimator_t() }};
+        case PartialDerivativeEstimator::Scharr_3x3:
+            return {{ [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.row_aligned_Scharr_derivative_3x3(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.column_aligned_Scharr_derivative_3x3(r, c, ch); },
+                      estimator_t() }};
+        case PartialDerivativeEstimator::Scharr_5x5:
+            return {{ [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.row_aligned_Scharr_derivative_5x5(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.column_aligned_Scharr_derivative_5x5(r, c, ch); },
+                      estimator_t() }};
+        case PartialDerivativeEstimator::second:
+            return {{ [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.row_aligned_second_derivative_centered_finite_difference(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.column_aligned_second_derivative_centered_finite_difference(r, c, ch); },
+                      [](const img_t &img, long int r, long int c, long int ch) -> float {
+                          return img.cross_second_derivative_centered_finite_difference(r, c, ch); } }};
+        default:
+            break;
+    }
+    throw std::invalid_argument("Unrecognized user-provided derivative order.");
+}
+
+// A linear estimator expressed as weighted voxel offsets. It is valid wherever the whole stencil is within the image.
+struct stencil_t {
+    std::vector<std::array<long int, 2>> offsets; // (row, column).
+    std::vector<float> weights;
+    long int radius = 0;
+};
+
+// The estimators are linear, so their weights are recovered by applying them to unit impulses in a small image. This
+// keeps the stencils consistent with the estimators, which are still used directly near the image borders. Impulses
+// are also replaced with NaNs to find the voxels the estimator reads, regardless of weight.
+stencil_t probe_stencil(const estimator_t &f){
+    constexpr long int probe_radius = 3; // Larger than any estimator's footprint.
+    constexpr long int N = 2 * probe_radius + 1;
+
+    planar_image<float,double> probe;
+    probe.init_orientation( vec3<double>(0.0, 1.0, 0.0), vec3<double>(1.0, 0.0, 0.0) );
+    probe.init_buffer(N, N, 1);
+    probe.init_spatial(1.0, 1.0, 1.0, vec3<double>(0.0, 0.0, 0.0), vec3<double>(0.0, 0.0, 0.0));
+    probe.fill_pixels(0.0f);
+
+    stencil_t out;
+    for(long int dr = -probe_radius; dr <= probe_radius; ++dr){
+        for(long int dc = -probe_radius; dc <= probe_radius; ++dc){
+            auto &impulse = probe.reference(probe_radius + dr, probe_radius + dc, 0);
+            impulse = 1.0f;
+            const auto w = f(probe, probe_radius, probe_radius, 0);
+            impulse = std::numeric_limits<float>::quiet_NaN();
+            const bool is_read = !std::isfinite(f(probe, probe_radius, probe_radius, 0));
+            impulse = 0.0f;
+
+            // Voxels that are read with zero weight are kept so non-finite values propagate as they otherwise would.
+            if( (w == 0.0f) && !is_read ) continue;
+
+            out.offsets.push_back({{ dr, dc }});
+            out.weights.push_back(w);
+            out.radius = std::max({ out.radius, std::abs(dr), std::abs(dc) });
+        }
+    }
+    return out;
+}
+
+// Evaluates the estimator for every voxel of a channel, packed row-major into 'plane'. Interior rows are computed by
+// accumulating each stencil weight over the row (in double precision), and only the border voxels and non-finite
+// results fall back to the estimator itself.
+void apply_estimator(const planar_image<float,double> &img,
+                     long int chan,
+                     const estimator_t &f,
+                     const stencil_t &stencil,
+                     const std::vector<float> &plane,
+                     std::vector<float> &out){
+    const auto R = img.rows;
+    const auto C = img.columns;
+    const auto S = stencil.radius;
+    out.resize(R * C);
+    std::vector<double> acc(C, 0.0);
+
+    for(long int row = 0; row < R; ++row){
+        float *o = out.data() + row * C;
+        if( (row < S) || ((R - S) <= row) || (C <= 2 * S) ){
+            for(long int col = 0; col < C; ++col) o[col] = f(img, row, col, chan);
+            continue;
+        }
+
+        for(long int col = 0; col < S; ++col) o[col] = f(img, row, col, chan);
+        for(long int col = C - S; col < C; ++col) o[col] = f(img, row, col, chan);
+
+        std::fill(std::begin(acc), std::end(acc), 0.0);
+        for(size_t k = 0; k < stencil.weights.size(); ++k){
+            const auto w = static_cast<double>(stencil.weights[k]);
+            const float *in = plane.data() + (row + stencil.offsets[k][0]) * C + stencil.offsets[k][1];
+            for(long int col = S; col < (C - S); ++col) acc[col] += w * static_cast<double>(in[col]);
+        }
+
+        // Non-finite voxels within the stencil are handled however the estimator handles them.
+        for(long int col = S; col < (C - S); ++col){
+            o[col] = static_cast<float>(acc[col]);
+            if(!std::isfinite(o[col])) o[col] = f(img, row, col, chan);
+        }
+    }
+    return;
+}
+
+} // namespace
+
+
 bool ImagePartialDerivative(
                     planar_image_collection<float,double>::images_list_it_t first_img_it,
                     std::list<planar_image_collection<float,double>::images_list_it_t> selected_img_its,
@@ -53,246 +207,90 @@ bool ImagePartialDerivative(
     Stats::Running_MinMax<float> minmax_pixel;
     const auto pi = std::acos(-1.0);
 
-    //Loop over the rows, columns, and channels.
-    for(auto row = 0; row < working.rows; ++row){
-        for(auto col = 0; col < working.columns; ++col){
-            for(auto chan = 0; chan < working.channels; ++chan){
-
-                auto newval = std::numeric_limits<float>::quiet_NaN();
-                auto nms_newval = std::numeric_limits<float>::quiet_NaN();
-
-                if(user_data_s->order == PartialDerivativeEstimator::first){
-                    if(user_data_s->method == PartialDerivativeMethod::row_aligned){
-                        newval = first_img_it->row_aligned_derivative_centered_finite_difference(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::column_aligned){
-                        newval = first_img_it->column_aligned_derivative_centered_finite_difference(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
-                        const auto ra = first_img_it->row_aligned_derivative_centered_finite_difference(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_derivative_centered_finite_difference(row, col, chan);
-                        newval = std::hypot(ra,ca);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
-                        const auto ra = first_img_it->row_aligned_derivative_centered_finite_difference(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_derivative_centered_finite_difference(row, col, chan);
-                        newval = std::atan2(ca,ra) + pi;
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                        const auto ra = first_img_it->row_aligned_derivative_centered_finite_difference(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_derivative_centered_finite_difference(row, col, chan);
-                        newval = std::hypot(ra,ca); // magnitude.
-                        nms_newval = std::atan2(ca,ra) + pi; // orientation.
-
-                    }else{
-                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
-                    }
-
-                }else if(user_data_s->order == PartialDerivativeEstimator::Roberts_cross_3x3){
-                    if(user_data_s->method == PartialDerivativeMethod::prow_pcol_aligned){
-                        newval = first_img_it->prow_pcol_aligned_Roberts_cross_3x3(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::nrow_pcol_aligned){
-                        newval = first_img_it->nrow_pcol_aligned_Roberts_cross_3x3(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
-                        const auto prpca = first_img_it->prow_pcol_aligned_Roberts_cross_3x3(row, col, chan);
-                        const auto nrpca = first_img_it->nrow_pcol_aligned_Roberts_cross_3x3(row, col, chan);
-                        newval = std::hypot(prpca,nrpca);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
-                        const auto prpca = first_img_it->prow_pcol_aligned_Roberts_cross_3x3(row, col, chan);
-                        const auto nrpca = first_img_it->nrow_pcol_aligned_Roberts_cross_3x3(row, col, chan);
-                        newval = std::atan2(prpca,nrpca) + pi/8.0 + pi/2.0; // For consistency with others.
-                        newval = std::fmod(newval + 2.0*pi, 2.0*pi); 
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                        const auto prpca = first_img_it->prow_pcol_aligned_Roberts_cross_3x3(row, col, chan);
-                        const auto nrpca = first_img_it->nrow_pcol_aligned_Roberts_cross_3x3(row, col, chan);
-                        newval = std::hypot(prpca,nrpca); // magnitude.
-                        nms_newval = std::atan2(prpca,nrpca) + pi/8.0 + pi/2.0; // For consistency with others.
-                        nms_newval = std::fmod(nms_newval + 2.0*pi, 2.0*pi); // orientation.
-
-                    }else{
-                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
-                    }
-
-                }else if(user_data_s->order == PartialDerivativeEstimator::Prewitt_3x3){
-                    if(user_data_s->method == PartialDerivativeMethod::row_aligned){
-                        newval = first_img_it->row_aligned_Prewitt_derivative_3x3(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::column_aligned){
-                        newval = first_img_it->column_aligned_Prewitt_derivative_3x3(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
-                        const auto ra = first_img_it->row_aligned_Prewitt_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Prewitt_derivative_3x3(row, col, chan);
-                        newval = std::hypot(ra,ca);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
-                        const auto ra = first_img_it->row_aligned_Prewitt_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Prewitt_derivative_3x3(row, col, chan);
-                        newval = std::atan2(ca,ra) + pi;
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                        const auto ra = first_img_it->row_aligned_Prewitt_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Prewitt_derivative_3x3(row, col, chan);
-                        newval = std::hypot(ra,ca); // magnitude.
-                        nms_newval = std::atan2(ca,ra) + pi; // orientation.
-
-                    }else{
-                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
-                    }
-
-                }else if(user_data_s->order == PartialDerivativeEstimator::Sobel_3x3){
-                    if(user_data_s->method == PartialDerivativeMethod::row_aligned){
-                        newval = first_img_it->row_aligned_Sobel_derivative_3x3(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::column_aligned){
-                        newval = first_img_it->column_aligned_Sobel_derivative_3x3(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
-                        const auto ra = first_img_it->row_aligned_Sobel_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Sobel_derivative_3x3(row, col, chan);
-                        newval = std::hypot(ra,ca);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
-                        const auto ra = first_img_it->row_aligned_Sobel_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Sobel_derivative_3x3(row, col, chan);
-                        newval = std::atan2(ca,ra) + pi;
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                        const auto ra = first_img_it->row_aligned_Sobel_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Sobel_derivative_3x3(row, col, chan);
-                        newval = std::hypot(ra,ca); // magnitude.
-                        nms_newval = std::atan2(ca,ra) + pi; // orientation.
-
-                    }else{
-                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
-                    }
-
-                }else if(user_data_s->order == PartialDerivativeEstimator::Sobel_5x5){
-                    if(user_data_s->method == PartialDerivativeMethod::row_aligned){
-                        newval = first_img_it->row_aligned_Sobel_derivative_5x5(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::column_aligned){
-                        newval = first_img_it->column_aligned_Sobel_derivative_5x5(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
-                        const auto ra = first_img_it->row_aligned_Sobel_derivative_5x5(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Sobel_derivative_5x5(row, col, chan);
-                        newval = std::hypot(ra,ca);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
-                        const auto ra = first_img_it->row_aligned_Sobel_derivative_5x5(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Sobel_derivative_5x5(row, col, chan);
-                        newval = std::atan2(ca,ra) + pi;
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                        const auto ra = first_img_it->row_aligned_Sobel_derivative_5x5(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Sobel_derivative_5x5(row, col, chan);
-                        newval = std::hypot(ra,ca); // magnitude.
-                        nms_newval = std::atan2(ca,ra) + pi; // orientation.
-
-                    }else{
-                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
-                    }
-
-                }else if(user_data_s->order == PartialDerivativeEstimator::Scharr_3x3){
-                    if(user_data_s->method == PartialDerivativeMethod::row_aligned){
-                        newval = first_img_it->row_aligned_Scharr_derivative_3x3(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::column_aligned){
-                        newval = first_img_it->column_aligned_Scharr_derivative_3x3(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
-                        const auto ra = first_img_it->row_aligned_Scharr_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Scharr_derivative_3x3(row, col, chan);
-                        newval = std::hypot(ra,ca);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
-                        const auto ra = first_img_it->row_aligned_Scharr_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Scharr_derivative_3x3(row, col, chan);
-                        newval = std::atan2(ca,ra) + pi;
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                        const auto ra = first_img_it->row_aligned_Scharr_derivative_3x3(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Scharr_derivative_3x3(row, col, chan);
-                        newval = std::hypot(ra,ca); // magnitude.
-                        nms_newval = std::atan2(ca,ra) + pi; // orientation.
-
-                    }else{
-                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
-                    }
-
-                }else if(user_data_s->order == PartialDerivativeEstimator::Scharr_5x5){
-                    if(user_data_s->method == PartialDerivativeMethod::row_aligned){
-                        newval = first_img_it->row_aligned_Scharr_derivative_5x5(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::column_aligned){
-                        newval = first_img_it->column_aligned_Scharr_derivative_5x5(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
-                        const auto ra = first_img_it->row_aligned_Scharr_derivative_5x5(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Scharr_derivative_5x5(row, col, chan);
-                        newval = std::hypot(ra,ca);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
-                        const auto ra = first_img_it->row_aligned_Scharr_derivative_5x5(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Scharr_derivative_5x5(row, col, chan);
-                        newval = std::atan2(ca,ra) + pi;
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                        const auto ra = first_img_it->row_aligned_Scharr_derivative_5x5(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_Scharr_derivative_5x5(row, col, chan);
-                        newval = std::hypot(ra,ca); // magnitude.
-                        nms_newval = std::atan2(ca,ra) + pi; // orientation.
-
-                    }else{
-                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
-                    }
-
-                }else if(user_data_s->order == PartialDerivativeEstimator::second){
-                    if(user_data_s->method == PartialDerivativeMethod::row_aligned){
-                        newval = first_img_it->row_aligned_second_derivative_centered_finite_difference(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::column_aligned){
-                        newval = first_img_it->column_aligned_second_derivative_centered_finite_difference(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::cross){
-                        newval = first_img_it->cross_second_derivative_centered_finite_difference(row, col, chan);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
-                        const auto ra = first_img_it->row_aligned_second_derivative_centered_finite_difference(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_second_derivative_centered_finite_difference(row, col, chan);
-                        newval = std::hypot(ra,ca);
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
-                        const auto ra = first_img_it->row_aligned_second_derivative_centered_finite_difference(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_second_derivative_centered_finite_difference(row, col, chan);
-                        newval = std::atan2(ca,ra) + pi;
-
-                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                        const auto ra = first_img_it->row_aligned_second_derivative_centered_finite_difference(row, col, chan);
-                        const auto ca = first_img_it->column_aligned_second_derivative_centered_finite_difference(row, col, chan);
-                        newval = std::hypot(ra,ca); // magnitude.
-                        nms_newval = std::atan2(ca,ra) + pi; // orientation.
-
-                    }else{
-                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
+    //Identify the estimator components needed and how they are combined.
+    const auto order = user_data_s->order;
+    const auto method = user_data_s->method;
+    const bool is_roberts = (order == PartialDerivativeEstimator::Roberts_cross_3x3);
+    const bool is_second = (order == PartialDerivativeEstimator::second);
+    const bool combined = (method == PartialDerivativeMethod::magnitude)
+                       || (method == PartialDerivativeMethod::orientation)
+                       || (method == PartialDerivativeMethod::non_maximum_suppression);
+    if( !combined
+    &&  !( !is_roberts && ( (method == PartialDerivativeMethod::row_aligned)
+                         || (method == PartialDerivativeMethod::column_aligned) ) )
+    &&  !( is_roberts && ( (method == PartialDerivativeMethod::prow_pcol_aligned)
+                        || (method == PartialDerivativeMethod::nrow_pcol_aligned) ) )
+    &&  !( is_second && (method == PartialDerivativeMethod::cross) ) ){
+        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
+    }
+    const auto comps = estimator_components(order);
+    const bool need_A = combined || (method == PartialDerivativeMethod::row_aligned)
+                                 || (method == PartialDerivativeMethod::prow_pcol_aligned)
+                                 || (method == PartialDerivativeMethod::cross);
+    const bool need_B = combined || (method == PartialDerivativeMethod::column_aligned)
+                                 || (method == PartialDerivativeMethod::nrow_pcol_aligned);
+    const auto &f_A = (method == PartialDerivativeMethod::cross) ? comps[2] : comps[0];
+    const auto &f_B = comps[1];
+    const auto stencil_A = need_A ? probe_stencil(f_A) : stencil_t();
+    const auto stencil_B = need_B ? probe_stencil(f_B) : stencil_t();
+
+    // The orientation of the gradient from its components.
+    const auto orientation = [&](float a, float b) -> float {
+        if(is_roberts){
+            const auto angle = std::atan2(a, b) + pi/8.0 + pi/2.0; // For consistency with others.
+            return std::fmod(angle + 2.0*pi, 2.0*pi);
+        }
+        return std::atan2(b, a) + pi;
+    };
+
+    //Compute the derivatives one channel at a time. Components are estimated row-by-row with stencils, and then
+    // combined in a single pass.
+    const auto &src = *first_img_it;
+    const auto R = src.rows;
+    const auto C = src.columns;
+    std::vector<float> plane, A, B, M;
+    for(long int chan = 0; chan < src.channels; ++chan){
+        plane.resize(R * C);
+        for(long int row = 0; row < R; ++row){
+            for(long int col = 0; col < C; ++col){
+                plane[row * C + col] = src.value(row, col, chan);
+            }
+        }
+        if(need_A) apply_estimator(src, chan, f_A, stencil_A, plane, A);
+        if(need_B) apply_estimator(src, chan, f_B, stencil_B, plane, B);
+
+        // The magnitude is computed in double precision, so it cannot overflow.
+        const auto N = R * C;
+        if( (method == PartialDerivativeMethod::magnitude)
+        ||  (method == PartialDerivativeMethod::non_maximum_suppression) ){
+            M.resize(N);
+            for(long int i = 0; i < N; ++i){
+                const auto a = static_cast<double>(A[i]);
+                const auto b = static_cast<double>(B[i]);
+                M[i] = static_cast<float>(std::sqrt(a * a + b * b));
+            }
+        }
+
+        for(long int row = 0; row < R; ++row){
+            for(long int col = 0; col < C; ++col){
+                const auto i = row * C + col;
+                float newval;
+                if( (method == PartialDerivativeMethod::magnitude)
+                ||  (method == PartialDerivativeMethod::non_maximum_suppression) ){
+                    newval = M[i];
+                    if(method == PartialDerivativeMethod::non_maximum_suppression){
+                        nms_working.reference(row, col, chan) = orientation(A[i], B[i]);
                     }
+                }else if(method == PartialDerivativeMethod::orientation){
+                    newval = orientation(A[i], B[i]);
                 }else{
-                    throw std::invalid_argument("Unrecognized user-provided derivative order.");
+                    newval = need_A ? A[i] : B[i];
                 }
-
                 working.reference(row, col, chan) = newval;
-                if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
-                    nms_working.reference(row, col, chan) = nms_newval; // orientation.
-                }
                 minmax_pixel.Digest(newval);
-            }//Loop over channels.
-        } //Loop over cols
-    } //Loop over rows
+            }
+        }
+    }
 
 
     //Thin edges if requested.
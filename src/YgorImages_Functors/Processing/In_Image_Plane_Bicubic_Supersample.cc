@@ -4,7 +4,9 @@
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
+#include "../../Separable_Resampling.h"
 #include "../ConvenienceRoutines.h"
 #include "In_Image_Plane_Bicubic_Supersample.h"
 #include "YgorImages.h"
@@ -23,6 +25,8 @@ bool InImagePlaneBicubicSupersample(
     //This routine supersamples images, making them have a greater number of pixels. It uses an
     // in-plane bicubic supersampling technique that is completely oblivious to the pixel dimensions.
     // Only nearest-neighbour adjacent pixels are used. "Mirror" boundaries are used.
+    //
+    // The interpolation is separable, so weights are computed once per row and column and shared by all pixels.
 
     if(selected_img_its.size() != 1) FUNCERR("This routine operates on individual images only");
  
@@ -82,19 +86,28 @@ bool InImagePlaneBicubicSupersample(
     //Record the min and max actual pixel values for windowing purposes.
     Stats::Running_MinMax<float> minmax_pixel;
 
-    //Loop over the rows, columns, and channels.
+    //Sample positions in the pixel number space of the original image. They are shared by all channels.
+    std::vector<double> row_sample_pos;
+    std::vector<double> col_sample_pos;
     for(auto row = 0; row < working.rows; ++row){
-        for(auto col = 0; col < working.columns; ++col){
-            for(auto chan = 0; chan < working.channels; ++chan){
-                const double row_sample_pos = (2.0*row + 1.0 - RowScaleFactorR)/(2.0*RowScaleFactorR);
-                const double col_sample_pos = (2.0*col + 1.0 - ColumnScaleFactorR)/(2.0*ColumnScaleFactorR);
-                const auto newval = first_img_it->bicubically_interpolate_in_pixel_number_space(row_sample_pos, col_sample_pos, chan);
-
+        row_sample_pos.push_back( (2.0*row + 1.0 - RowScaleFactorR)/(2.0*RowScaleFactorR) );
+    }
+    for(auto col = 0; col < working.columns; ++col){
+        col_sample_pos.push_back( (2.0*col + 1.0 - ColumnScaleFactorR)/(2.0*ColumnScaleFactorR) );
+    }
+    const auto row_w = Compute_Resampling_Weights(first_img_it->rows, row_sample_pos, resampling_kernel::cubic);
+    const auto col_w = Compute_Resampling_Weights(first_img_it->columns, col_sample_pos, resampling_kernel::cubic);
+
+    for(auto chan = 0; chan < working.channels; ++chan){
+        const auto resampled = Resample_Image_Channel(*first_img_it, chan, row_w, col_w);
+        for(auto row = 0; row < working.rows; ++row){
+            for(auto col = 0; col < working.columns; ++col){
+                const auto newval = resampled[row * working.columns + col];
                 working.reference(row, col, chan) = newval;
                 minmax_pixel.Digest(newval);
-            }//Loop over channels.
-        } //Loop over cols
-    } //Loop over rows
+            } //Loop over cols
+        } //Loop over rows
+    }//Loop over channels.
 
     //Replace the old image data with the new image data.
     *first_img_it = working;
@@ -7,6 +7,9 @@
 #include <string>
 
 #include "../ConvenienceRoutines.h"
+#include "../Integral_Image.h"
+#include "../Rectilinear_Volume.h"
+#include "../Volume_Convolution.h"
 #include "In_Image_Plane_Blur.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
@@ -39,9 +42,15 @@ bool InPlaneImageBlur(
     //Record the min and max actual pixel values for windowing purposes.
     Stats::Running_MinMax<float> minmax_pixel;
 
-    //There is a dedicated function for non-fixed ("open") Gaussian blur.
+    //Non-fixed ("open") Gaussian blurs are separable, so they are applied as 1D passes (or, for large sigmas, recursive
+    //filters) on a packed copy of the image.
     if(user_data_s->estimator == BlurEstimator::gaussian_open){
-        working.Gaussian_Pixel_Blur({ }, user_data_s->gaussian_sigma);
+        const auto sigma = user_data_s->gaussian_sigma;
+        rectilinear_volume vol({ std::ref(working) });
+        for(long int chan = 0; chan < vol.channels; ++chan){
+            volume_convolution::gaussian_blur(vol, chan, {{ sigma, sigma, 0.0 }});
+        }
+        vol.write_back();
 
         //Loop over the rows, columns, and channels.
         for(auto row = 0; row < working.rows; ++row){
@@ -52,6 +61,21 @@ bool InPlaneImageBlur(
             } //Loop over cols
         } //Loop over rows
 
+    //Non-fixed box blurs use summed-area tables, so the cost per pixel does not depend on the box size.
+    }else if(user_data_s->estimator == BlurEstimator::box_open){
+        const auto boxr = user_data_s->box_radius;
+        if(boxr < 0) throw std::invalid_argument("Box radius must be non-negative.");
+        for(auto chan = 0; chan < working.channels; ++chan){
+            const integral_image sat(*first_img_it, chan);
+            for(auto row = 0; row < working.rows; ++row){
+                for(auto col = 0; col < working.columns; ++col){
+                    const auto newval = static_cast<float>(sat.box(row, col, boxr).mean());
+                    working.reference(row, col, chan) = newval;
+                    minmax_pixel.Digest(newval);
+                }
+            }
+        }
+
     }else{
         //Loop over the rows, columns, and channels.
         for(auto row = 0; row < working.rows; ++row){
@@ -105,6 +129,11 @@ bool InPlaneImageBlur(
         img_desc += std::to_string(user_data_s->gaussian_sigma);
         img_desc += ")";
 
+    }else if(user_data_s->estimator == BlurEstimator::box_open){
+        img_desc += "Box blur (open; radius=";
+        img_desc += std::to_string(user_data_s->box_radius);
+        img_desc += ")";
+
     }else{
         throw std::invalid_argument("Unrecognized user-provided blur estimator.");
     }
@@ -21,7 +21,8 @@ typedef enum { // Controls which estimator is used to approximate the blur opera
     gaussian_5x5,
 
     //Non-fixed (adaptive) estimators.
-    gaussian_open
+    gaussian_open,
+    box_open
 
 } BlurEstimator;
 
@@ -31,6 +32,8 @@ struct InPlaneImageBlurUserData {
 
     //Parameters for non-fixed estimators.
     double gaussian_sigma = 1.5; // sigma in pixel coordinates.
+    long int box_radius = 2;     // The box is (2*box_radius + 1) pixels wide. Non-finite and out-of-image pixels are
+                                 // excluded from the average.
 
 };
 
@@ -4,7 +4,9 @@
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
+#include "../../Separable_Resampling.h"
 #include "../ConvenienceRoutines.h"
 #include "In_Image_Plane_Pixel_Decimate.h"
 #include "YgorImages.h"
@@ -56,50 +58,17 @@ bool InImagePlanePixelDecimate(
                                 std::to_string(first_img_it->columns));
     } 
 
-    vec3<double> newOffset = first_img_it->offset;
-    newOffset -= first_img_it->row_unit * first_img_it->pxl_dx * 0.5;
-    newOffset -= first_img_it->col_unit * first_img_it->pxl_dy * 0.5;
-    newOffset += first_img_it->row_unit * first_img_it->pxl_dx * ScaleFactorR * 0.5;
-    newOffset += first_img_it->col_unit * first_img_it->pxl_dy * ScaleFactorR * 0.5;
-
     if(selected_img_its.size() != 1) FUNCERR("This routine operates on individual images only");
  
-    //Make a destination image that has twice the linear dimensions as the input image.
-    planar_image<float,double> working;
-    working.init_buffer( NumberOfRowsRequired, 
-                         NumberOfColsRequired, 
-                         first_img_it->channels );
-    working.init_spatial( first_img_it->pxl_dx * ScaleFactorR,
-                          first_img_it->pxl_dy * ScaleFactorC,
-                          first_img_it->pxl_dz,
-                          first_img_it->anchor,
-                          newOffset );
-    working.init_orientation( first_img_it->row_unit,
-                              first_img_it->col_unit );
-    working.metadata = first_img_it->metadata;
+    //Make a destination image with each pixel aggregating a block of pixels.
+    auto working = Decimate_Image(*first_img_it, ScaleFactorR, ScaleFactorC);
 
     //Record the min and max actual pixel values for windowing purposes.
     Stats::Running_MinMax<float> minmax_pixel;
-
-    //Loop over the rows, columns, and channels.
-    for(auto row = 0; row < working.rows; ++row){
-        for(auto col = 0; col < working.columns; ++col){
-            for(auto chan = 0; chan < working.channels; ++chan){
-                const long int old_row_min = row * ScaleFactorR;
-                const long int old_row_max = old_row_min + ScaleFactorR - 1;
-                const long int old_col_min = col * ScaleFactorC;
-                const long int old_col_max = old_col_min + ScaleFactorC - 1;
-
-                const auto newval = first_img_it->block_average(old_row_min, old_row_max, old_col_min, old_col_max, chan);
-
-                working.reference(row, col, chan) = newval;
-                minmax_pixel.Digest(newval);
-            }//Loop over channels.
-        } //Loop over cols
-    } //Loop over rows
+    for(const auto &v : working.data) minmax_pixel.Digest(v);
 
     //Replace the old image data with the new image data.
-    *first_img_it = working;
+    *first_img_it = std::move(working);
 
     UpdateImageDescription( std::ref(*first_img_it), 
                             "In-plane Pixel Decimated "_s 
@@ -107,9 +76,6 @@ bool InImagePlanePixelDecimate(
                             + std::to_string(ScaleFactorC) + "x ");
     UpdateImageWindowCentreWidth( std::ref(*first_img_it), minmax_pixel );
 
-    first_img_it->metadata["Rows"] = std::to_string(first_img_it->rows);
-    first_img_it->metadata["Columns"] = std::to_string(first_img_it->columns);
-
     return true;
 }
 
@@ -23,6 +23,10 @@ struct KineticModel_Liver_1C2I_5Param_Chebyshev_UserData {
 
     size_t ExpApproxTrunc;
     double MultiplicationCoeffTrunc;
+
+    // Initialize each voxel's fit from already-fitted neighbouring voxels, falling back to the global initial guess
+    // if the warm-started fit fails.
+    bool WarmStart = false;
 };
 
 #endif // DCMA_USE_GNU_GSL
@@ -6,6 +6,7 @@
 #include <boost/iterator/iterator_traits.hpp>
 #include <cstddef>
 #include <array>
+#include <cmath>
 #include <exception>
 #include <any>
 #include <optional>
@@ -22,6 +23,7 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "../../Common_Boost_Serialization.h"
 #include "../../Common_Plotting.h"
@@ -249,6 +251,36 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
 
 
 
+    //When warm-starting, voxels are fitted in raster order and each fit is seeded from the already-fitted neighbours in
+    // the preceding row and column. Neighbouring voxels tend to have similar parameters, so the optimizer typically
+    // converges in far fewer iterations.
+    struct fitted_params_t {
+        bool valid = false;
+        double k1A  = 0.0;
+        double tauA = 0.0;
+        double k1V  = 0.0;
+        double tauV = 0.0;
+        double k2   = 0.0;
+    };
+    const bool WarmStart = user_data_s->WarmStart;
+    const long int N_rows = first_img_it->rows;
+    const long int N_cols = first_img_it->columns;
+    const long int N_chns = first_img_it->channels;
+    std::vector<fitted_params_t> fitted_params( WarmStart ? (N_rows * N_cols * N_chns) : 0 );
+    const auto fitted_index = [&](long int r, long int c, long int ch) -> long int {
+        return (r * N_cols + c) * N_chns + ch;
+    };
+    const auto is_converged = [](const KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters &s) -> bool {
+        return s.FittingSuccess
+            && std::isfinite(s.k1A) && std::isfinite(s.tauA) && std::isfinite(s.k1V)
+            && std::isfinite(s.tauV) && std::isfinite(s.k2)  && std::isfinite(s.RSS);
+    };
+
+    size_t Fit_Count = 0;
+    size_t Total_Iteration_Count = 0;
+    size_t Warm_Start_Count = 0;
+    size_t Warm_Start_Fallback_Count = 0;
+
     //Loop over the cc_ROIs, rois, rows, columns, channels, and finally any selected images (if applicable).
     //for(const auto &roi : rois){
     boost::posix_time::ptime start_t = boost::posix_time::microsec_clock::local_time();
@@ -383,8 +415,65 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
                             model_state.tauV = std::numeric_limits<double>::quiet_NaN();
                             model_state.k2   = std::numeric_limits<double>::quiet_NaN();
 
+                            //Seed the fit with the mean of the already-fitted neighbours, if any.
+                            bool warm_started = false;
+                            if(WarmStart){
+                                const long int d_row[] = { -1, -1, -1,  0 };
+                                const long int d_col[] = { -1,  0,  1, -1 };
+                                fitted_params_t seed;
+                                long int N_seeds = 0;
+                                for(size_t n = 0; n < 4; ++n){
+                                    const long int r = row + d_row[n];
+                                    const long int c = col + d_col[n];
+                                    if( !isininc(0L, r, N_rows-1) || !isininc(0L, c, N_cols-1) ) continue;
+                                    const auto &p = fitted_params[fitted_index(r, c, chan)];
+                                    if(!p.valid) continue;
+                                    seed.k1A  += p.k1A;
+                                    seed.tauA += p.tauA;
+                                    seed.k1V  += p.k1V;
+                                    seed.tauV += p.tauV;
+                                    seed.k2   += p.k2;
+                                    ++N_seeds;
+                                }
+                                if(0 < N_seeds){
+                                    const double w = 1.0 / static_cast<double>(N_seeds);
+                                    model_state.k1A  = seed.k1A * w;
+                                    model_state.tauA = seed.tauA * w;
+                                    model_state.k1V  = seed.k1V * w;
+                                    model_state.tauV = seed.tauV * w;
+                                    model_state.k2   = seed.k2 * w;
+                                    warm_started = true;
+                                }
+                            }
+
                             //KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters after_state = Optimize_LevenbergMarquardt_3Param(model_state);
                             KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters after_state = Optimize_LevenbergMarquardt_5Param(model_state);
+                            Total_Iteration_Count += after_state.FittingIterations;
+                            ++Fit_Count;
+
+                            //If the warm-started fit diverged, fall back to the global initial guess.
+                            if(warm_started){
+                                ++Warm_Start_Count;
+                                if(!is_converged(after_state)){
+                                    ++Warm_Start_Fallback_Count;
+                                    model_state.k1A  = std::numeric_limits<double>::quiet_NaN();
+                                    model_state.tauA = std::numeric_limits<double>::quiet_NaN();
+                                    model_state.k1V  = std::numeric_limits<double>::quiet_NaN();
+                                    model_state.tauV = std::numeric_limits<double>::quiet_NaN();
+                                    model_state.k2   = std::numeric_limits<double>::quiet_NaN();
+                                    after_state = Optimize_LevenbergMarquardt_5Param(model_state);
+                                    Total_Iteration_Count += after_state.FittingIterations;
+                                }
+                            }
+                            if(WarmStart && is_converged(after_state)){
+                                auto &p = fitted_params[fitted_index(row, col, chan)];
+                                p.valid = true;
+                                p.k1A  = after_state.k1A;
+                                p.tauA = after_state.tauA;
+                                p.k1V  = after_state.k1V;
+                                p.tauV = after_state.tauV;
+                                p.k2   = after_state.k2;
+                            }
 
                             if(!after_state.FittingSuccess) ++Minimization_Failure_Count;
 
@@ -464,6 +553,14 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
     } //Loop over contour_collections.
 
     FUNCWARN("Minimization failure count: " << Minimization_Failure_Count);
+    if(0 < Fit_Count){
+        FUNCINFO("Optimizer iterations: " << Total_Iteration_Count << " total, "
+                 << static_cast<double>(Total_Iteration_Count) / static_cast<double>(Fit_Count) << " per voxel");
+    }
+    if(WarmStart){
+        FUNCINFO("Warm-started " << Warm_Start_Count << " of " << Fit_Count << " voxel fits, of which "
+                 << Warm_Start_Fallback_Count << " fell back to the global initial guess");
+    }
 
 
     //Serialize the state so we have enough info to apply the model later. But remove the per-voxel information (which
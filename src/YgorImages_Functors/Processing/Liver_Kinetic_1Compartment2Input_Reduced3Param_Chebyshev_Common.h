@@ -25,6 +25,9 @@ struct KineticModel_Liver_1C2I_Reduced3Param_Chebyshev_UserData {
 
     size_t ExpApproxTrunc;
     double MultiplicationCoeffTrunc;
+
+    // Seed the per-voxel fits with an exhaustive search on a SYCL device, if one is available.
+    bool UseAccelerator = false;
 };
 
 
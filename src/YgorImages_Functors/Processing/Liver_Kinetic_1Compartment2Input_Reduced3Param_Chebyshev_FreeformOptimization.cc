@@ -2,10 +2,10 @@
 
 #ifdef DCMA_USE_GNU_GSL
 
-#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/iterator/iterator_traits.hpp>
 #include <cstddef>
 #include <array>
+#include <cmath>
 #include <exception>
 #include <any>
 #include <optional>
@@ -21,12 +21,15 @@
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "../../Common_Boost_Serialization.h"
 #include "../../Common_Plotting.h"
 #include "../../KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_Common.h"
 #include "../../KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_FreeformOptimization.h"
+#include "../../Thread_Pool.h"
 #include "../ConvenienceRoutines.h"
 #include "Liver_Kinetic_1Compartment2Input_Reduced3Param_Chebyshev_Common.h"
 #include "Liver_Kinetic_1Compartment2Input_Reduced3Param_Chebyshev_FreeformOptimization.h"
@@ -34,11 +37,81 @@
 #include "YgorImages.h"
 #include "YgorMath.h"
 #include "YgorMathChebyshev.h"
+#include "YgorMathChebyshevFunctions.h"
 #include "YgorMisc.h"
 #include "YgorStats.h"       //Needed for Stats:: namespace.
 
+#ifdef DCMA_USE_SYCL
+    #include "../../SYCL_Perfusion_Grid_Search.h"
+#endif // DCMA_USE_SYCL
+
 static std::mutex out_img_mutex;
 
+#ifdef DCMA_USE_SYCL
+// The parameter grid searched on the accelerator. The delays span the (commented-out) bounds used by the optimizer,
+// and k2 is logarithmically spaced.
+static
+std::vector<double>
+Grid_Search_Linspace(double lo, double hi, long int N){
+    std::vector<double> out;
+    for(long int i = 0; i < N; ++i) out.push_back(lo + (hi - lo) * static_cast<double>(i) / static_cast<double>(N - 1));
+    return out;
+}
+
+static const std::vector<double> grid_tauA = Grid_Search_Linspace(-20.0, 20.0, 21);
+static const std::vector<double> grid_tauV = Grid_Search_Linspace(-20.0, 20.0, 21);
+static const std::vector<double> grid_log_k2 = Grid_Search_Linspace(std::log(1.0E-3), std::log(1.0), 16);
+
+// Tabulates the model's responses to the AIF and VIF at the given sample times over the parameter grid. This mirrors
+// ComputeIntegralSummations() in the CPU implementation, so that grid points are evaluated identically.
+static
+sycl_perfusion_grid_search::model_table_t
+Tabulate_Model_Responses(const KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_Parameters &state,
+                         const std::vector<double> &ts){
+    sycl_perfusion_grid_search::model_table_t table;
+    table.N_tauA = static_cast<long int>(grid_tauA.size());
+    table.N_tauV = static_cast<long int>(grid_tauV.size());
+    table.N_k2   = static_cast<long int>(grid_log_k2.size());
+    table.N_t    = static_cast<long int>(ts.size());
+    table.IA.resize(table.N_tauA * table.N_k2 * table.N_t, std::numeric_limits<double>::quiet_NaN());
+    table.IV.resize(table.N_tauV * table.N_k2 * table.N_t, std::numeric_limits<double>::quiet_NaN());
+
+    const size_t exp_approx_N = 10;
+    const auto tabulate = [&](const cheby_approx<double> &c,
+                              const std::vector<double> &taus,
+                              std::vector<double> &out) -> void {
+        double exp_min, exp_max;
+        std::tie(exp_min, exp_max) = c.Get_Domain();
+
+        parallel_for(0, table.N_k2, [&](long int k) -> void {
+            const double k2 = std::exp(grid_log_k2[k]);
+            cheby_approx<double> integral;
+            try{
+                const auto exp_kern = Chebyshev_Basis_Approx_Exp_Analytic1(exp_approx_N, exp_min, exp_max, k2, 0.0, 1.0);
+                integral = (exp_kern * c).Chebyshev_Integral();
+            }catch(const std::exception &){
+                return; // Leave the responses as NaN, which excludes them from the search.
+            }
+
+            for(size_t a = 0; a < taus.size(); ++a){
+                const double tau = taus[a];
+                try{
+                    const double integral_at_taumin = integral.Sample(-tau);
+                    for(long int i = 0; i < table.N_t; ++i){
+                        const double ti = ts[i];
+                        const double scale = std::exp(k2 * (tau - ti));
+                        out[(a * table.N_k2 + k) * table.N_t + i] = scale * (integral.Sample(ti - tau) - integral_at_taumin);
+                    }
+                }catch(const std::exception &){ }
+            }
+        }, /*grain=*/ 1);
+    };
+    tabulate(*(state.cAIF), grid_tauA, table.IA);
+    tabulate(*(state.cVIF), grid_tauV, table.IV);
+    return table;
+}
+#endif // DCMA_USE_SYCL
+
 bool
 KineticModel_Liver_1C2I_Reduced3Param_Chebyshev_FreeformOptimization(planar_image_collection<float,double>::images_list_it_t first_img_it,
                         std::list<planar_image_collection<float,double>::images_list_it_t> selected_img_its,
@@ -182,77 +255,16 @@ KineticModel_Liver_1C2I_Reduced3Param_Chebyshev_FreeformOptimization(planar_imag
     Stats::Running_MinMax<float> minmax_k2;
 
 
-    //Perform a loop with no payload to determine how many optimizations will be needed.
-    //
-    // NOTE: We expect optimization to take far longer than cycling through the contours and images.
-    double Expected_Operation_Count = 0.0;
-    for(auto &ccs : cc_ROIs){
-        for(auto & contour : ccs.get().contours){
-            if(contour.points.empty()) continue;
-            if(! first_img_it->encompasses_contour_of_points(contour)) continue;
-
-            const auto ROIName =  contour.GetMetadataValueAs<std::string>("ROIName");
-            if(!ROIName){
-                FUNCWARN("Missing necessary tags for reporting analysis results. Cannot continue");
-                return false;
-            }
-            
-    /*
-            //Construct a bounding box to reduce computational demand of checking every voxel.
-            auto BBox = roi_it->Bounding_Box_Along(row_unit, 1.0);
-            auto BBoxBestFitPlane = BBox.Least_Squares_Best_Fit_Plane(vec3<double>(0.0,0.0,1.0));
-            auto BBoxProjectedContour = BBox.Project_Onto_Plane_Orthogonally(BBoxBestFitPlane);
-            const bool BBoxAlreadyProjected = true;
-    */
-    
-            //Prepare a contour for fast is-point-within-the-polygon checking.
-            auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-            auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-            const bool AlreadyProjected = true;
-    
-            for(auto row = 0; row < first_img_it->rows; ++row){
-                for(auto col = 0; col < first_img_it->columns; ++col){
-                    //Figure out the spatial location of the present voxel.
-                    const auto point = first_img_it->position(row,col);
-    
-    /*
-                    //Check if within the bounding box. It will generally be cheaper than the full contour (4 points vs. ? points).
-                    auto BBoxProjectedPoint = BBoxBestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                    if(!BBoxProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BBoxBestFitPlane,
-                                                                                        BBoxProjectedPoint,
-                                                                                        BBoxAlreadyProjected)) continue;
-    */
-    
-                    //Perform a more detailed check to see if we are in the ROI.
-                    auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                    if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                   ProjectedPoint,
-                                                                                   AlreadyProjected)){
-                        for(auto chan = 0; chan < first_img_it->channels; ++chan){
-   
-                            Expected_Operation_Count += 1.0;
-                        }//Loop over channels.
-    
-                    //If we're in the bounding box but not the ROI, do something.
-                    }else{
-                        //for(auto chan = 0; chan < first_img_it->channels; ++chan){
-                        //    const auto curr_val = working.value(row, col, chan);
-                        //    if(curr_val != 0) FUNCERR("There are overlapping ROI bboxes. This code currently cannot handle this. "
-                        //                              "You will need to run the functor individually on the overlapping ROIs.");
-                        //    working.reference(row, col, chan) = static_cast<float>(10);
-                        //}
-                    } // If is in ROI or ROI bbox.
-                } //Loop over cols
-            } //Loop over rows
-        } //Loop over ROIs.
-    } //Loop over contour_collections.
-
-
-
     //Loop over the cc_ROIs, rois, rows, columns, channels, and finally any selected images (if applicable).
-    //for(const auto &roi : rois){
-    boost::posix_time::ptime start_t = boost::posix_time::microsec_clock::local_time();
-    double Actual_Operation_Count = 0.0;
+    //
+    // Voxel time courses are harvested first, and then all voxels are fitted concurrently.
+    struct voxel_fit_t {
+        long int row;
+        long int col;
+        long int chan;
+        KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_Parameters state;
+    };
+    std::vector<voxel_fit_t> voxel_fits;
     for(auto &ccs : cc_ROIs){
         for(auto & contour : ccs.get().contours){
             if(contour.points.empty()) continue;
@@ -300,20 +312,6 @@ KineticModel_Liver_1C2I_Reduced3Param_Chebyshev_FreeformOptimization(planar_imag
                                                                                    AlreadyProjected)){
                         for(auto chan = 0; chan < first_img_it->channels; ++chan){
 
-                            //Provide a prediction time.
-                            if(Actual_Operation_Count > 0.5){
-                                boost::posix_time::ptime current_t = boost::posix_time::microsec_clock::local_time();
-                                auto elapsed_dt = (current_t - start_t).total_milliseconds();
-                                auto expected_dt_f = static_cast<double>(elapsed_dt) * (Expected_Operation_Count/Actual_Operation_Count);
-                                auto expected_dt = static_cast<long int>(expected_dt_f);
-                                boost::posix_time::ptime predicted_dt( start_t + boost::posix_time::milliseconds(expected_dt) );
-                                FUNCINFO("Progress: " 
-                                    << Actual_Operation_Count << "/" << Expected_Operation_Count << " = " 
-                                    << static_cast<double>(static_cast<size_t>(1000.0*Actual_Operation_Count/Expected_Operation_Count))/10.0 
-                                    << "%. Expected finish time: " << predicted_dt);
-                            }
-                            Actual_Operation_Count += 1.0;
-
                             //Cycle over the grouped images (temporal slices, or whatever the user has decided).
                             // Harvest the time course or any other voxel-specific numbers.
                             auto channel_time_course = std::make_shared<samples_1D<double>>();
@@ -369,83 +367,16 @@ KineticModel_Liver_1C2I_Reduced3Param_Chebyshev_FreeformOptimization(planar_imag
                             }
 
 
-                            //==============================================================================
-                            //Fit the model.
-
-                            // This routine fits a pharmacokinetic model to the observed liver perfusion data using a 
-                            // Chebyshev polynomial approximation scheme.
-
-                            model_state.FittingPerformed = false;
-                            model_state.cROI = channel_time_course;
-                            model_state.k1A  = std::numeric_limits<double>::quiet_NaN();
-                            model_state.tauA = std::numeric_limits<double>::quiet_NaN();
-                            model_state.k1V  = std::numeric_limits<double>::quiet_NaN();
-                            model_state.tauV = std::numeric_limits<double>::quiet_NaN();
-                            model_state.k2   = std::numeric_limits<double>::quiet_NaN();
-
-                            KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_Parameters after_state = Optimize_FreeformOptimization_Reduced3Param(model_state);
-
-                            if(!after_state.FittingSuccess) ++Minimization_Failure_Count;
-
-                            const double RSS  = after_state.RSS;
-                            const double k1A  = after_state.k1A;
-                            const double tauA = after_state.tauA;
-                            const double k1V  = after_state.k1V;
-                            const double tauV = after_state.tauV;
-                            const double k2   = after_state.k2;
-                            if(true) FUNCINFO("k1A,tauA,k1V,tauV,k2,RSS = " << k1A << ", " << tauA << ", " 
-                                              << k1V << ", " << tauV << ", " << k2 << ", " << RSS);
-
-                            const auto LiverPerfusion = (k1A + k1V);
-                            const auto MeanTransitTime = 1.0 / k2;
-                            const auto ArterialFraction = 100.0 * k1A / LiverPerfusion;
-                            const auto DistributionVolume = 100.0 * LiverPerfusion * MeanTransitTime;
-
-                            //==============================================================================
-                            // Plot the fitted model with the ROI time course.
-                            if(PixelsToPlot.count( {row, col}) != 0){ 
-                                std::map<std::string, samples_1D<double>> time_courses;
-                                std::string title;
-                                //Add the ROI.
-                                title = "Chebyshev Approximation: ROI time course: row = " + std::to_string(row) + ", col = " + std::to_string(col);
-                                time_courses[title] = *(after_state.cROI);
-                                samples_1D<double> fitted_model;
-                                KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_Results eval_res;
-                                for(const auto &P : after_state.cROI->samples){
-                                    const double t = P[0];
-                                    Evaluate_Model(after_state,t,eval_res);
-                                    fitted_model.push_back(t, 0.0, eval_res.I, 0.0);
-                                }
-                                title = "Fitted model";
-                                time_courses[title] = fitted_model;
-
-                                PlotTimeCourses("Raw ROI and Fitted Model", time_courses, {});
-                            }
-                            
-                            //==============================================================================
- 
-                            //Update pixel values.
-                            const auto k1A_f  = static_cast<float>(k1A);
-                            const auto tauA_f = static_cast<float>(tauA);
-                            const auto k1V_f  = static_cast<float>(k1V);
-                            const auto tauV_f = static_cast<float>(tauV);
-                            const auto k2_f   = static_cast<float>(k2);
-
-                            minmax_k1A.Digest(k1A_f);
-                            minmax_tauA.Digest(tauA_f);
-                            minmax_k1V.Digest(k1V_f);
-                            minmax_tauV.Digest(tauV_f);
-                            minmax_k2.Digest(k2_f);
-
-                            {
-                                out_img_k1A.get().reference(row, col, chan)  = k1A_f;
-                                out_img_tauA.get().reference(row, col, chan) = tauA_f;
-                                out_img_k1V.get().reference(row, col, chan)  = k1V_f;
-                                out_img_tauV.get().reference(row, col, chan) = tauV_f;
-                                out_img_k2.get().reference(row, col, chan)   = k2_f;
-                            }
-                            // ----------------------------------------------------------------------------
-    
+                            //Queue the voxel for fitting.
+                            voxel_fits.push_back({ row, col, chan, model_state });
+                            auto &fit_state = voxel_fits.back().state;
+                            fit_state.FittingPerformed = false;
+                            fit_state.cROI = channel_time_course;
+                            fit_state.k1A  = std::numeric_limits<double>::quiet_NaN();
+                            fit_state.tauA = std::numeric_limits<double>::quiet_NaN();
+                            fit_state.k1V  = std::numeric_limits<double>::quiet_NaN();
+                            fit_state.tauV = std::numeric_limits<double>::quiet_NaN();
+                            fit_state.k2   = std::numeric_limits<double>::quiet_NaN();
                         }//Loop over channels.
     
                     //If we're in the bounding box but not the ROI, do something.
@@ -462,6 +393,132 @@ KineticModel_Liver_1C2I_Reduced3Param_Chebyshev_FreeformOptimization(planar_imag
         } //Loop over ROIs.
     } //Loop over contour_collections.
 
+#ifdef DCMA_USE_SYCL
+    // Seed the fits with an exhaustive search on the accelerator, if one is available. The CPU optimizer then polishes
+    // the seeds, so the fitted parameters are those of the CPU model.
+    if(user_data_s->UseAccelerator && !voxel_fits.empty()){
+        try{
+            // Only courses sampled at the same times can share the tabulated model responses. This is nearly always
+            // all of them; the remainder are fitted without a seed.
+            std::vector<double> ts;
+            for(const auto &R : voxel_fits.front().state.cROI->samples) ts.push_back(R[0]);
+
+            std::vector<size_t> searched;
+            std::vector<double> courses;
+            for(size_t i = 0; i < voxel_fits.size(); ++i){
+                const auto &samples = voxel_fits[i].state.cROI->samples;
+                bool same_times = (samples.size() == ts.size());
+                for(size_t j = 0; same_times && (j < ts.size()); ++j) same_times = (samples[j][0] == ts[j]);
+                if(!same_times) continue;
+
+                searched.push_back(i);
+                for(const auto &R : samples) courses.push_back(R[2]);
+            }
+
+            auto grid_search = sycl_perfusion_grid_search::create( Tabulate_Model_Responses(model_state, ts) );
+            if(grid_search == nullptr){
+                FUNCWARN("No suitable accelerator available. Fitting on the CPU without seeding");
+            }else{
+                FUNCINFO("Seeding " << searched.size() << " voxel fits via grid search on device '"
+                         << grid_search->device_name() << "'");
+                std::vector<sycl_perfusion_grid_search::result_t> results(searched.size());
+                grid_search->search(courses.data(), static_cast<long int>(searched.size()), results.data());
+
+                for(size_t n = 0; n < searched.size(); ++n){
+                    const auto &r = results[n];
+                    if(r.k2_idx < 0) continue;
+                    auto &s = voxel_fits[searched[n]].state;
+                    s.tauA = grid_tauA[r.tauA_idx];
+                    s.tauV = grid_tauV[r.tauV_idx];
+                    s.k2   = std::exp(grid_log_k2[r.k2_idx]);
+                }
+            }
+        }catch(const std::exception &e){
+            FUNCWARN("Accelerated grid search failed (" << e.what() << "). Fitting on the CPU without seeding");
+        }
+    }
+#endif // DCMA_USE_SYCL
+
+    //==============================================================================
+    //Fit the model.
+
+    // This routine fits a pharmacokinetic model to the observed liver perfusion data using a 
+    // Chebyshev polynomial approximation scheme. Voxels are independent, so they are fitted concurrently. Fits have
+    // highly variable cost, so they are scheduled individually.
+    progress_tracker progress("liver perfusion model fitting", static_cast<long int>(voxel_fits.size()),
+                              [](long int completed, long int total, double eta_s) -> void {
+        FUNCINFO("Progress: " << completed << "/" << total << " = "
+                 << static_cast<double>(static_cast<size_t>(1000.0 * completed / total)) / 10.0
+                 << "%. Expected time remaining: " << static_cast<long int>(eta_s) << " s");
+    });
+    parallel_for(0, static_cast<long int>(voxel_fits.size()), [&](long int i) -> void {
+        auto &vf = voxel_fits[i];
+        vf.state = Optimize_FreeformOptimization_Reduced3Param(vf.state);
+        progress.advance();
+    }, /*grain=*/ 1);
+
+    for(const auto &vf : voxel_fits){
+        const auto row = vf.row;
+        const auto col = vf.col;
+        const auto chan = vf.chan;
+        const auto &after_state = vf.state;
+
+        if(!after_state.FittingSuccess) ++Minimization_Failure_Count;
+
+        const double RSS  = after_state.RSS;
+        const double k1A  = after_state.k1A;
+        const double tauA = after_state.tauA;
+        const double k1V  = after_state.k1V;
+        const double tauV = after_state.tauV;
+        const double k2   = after_state.k2;
+        if(true) FUNCINFO("k1A,tauA,k1V,tauV,k2,RSS = " << k1A << ", " << tauA << ", " 
+                          << k1V << ", " << tauV << ", " << k2 << ", " << RSS);
+
+        //==============================================================================
+        // Plot the fitted model with the ROI time course.
+        if(PixelsToPlot.count( {row, col}) != 0){ 
+            std::map<std::string, samples_1D<double>> time_courses;
+            std::string title;
+            //Add the ROI.
+            title = "Chebyshev Approximation: ROI time course: row = " + std::to_string(row) + ", col = " + std::to_string(col);
+            time_courses[title] = *(after_state.cROI);
+            samples_1D<double> fitted_model;
+            KineticModel_1Compartment2Input_Reduced3Param_Chebyshev_Results eval_res;
+            for(const auto &P : after_state.cROI->samples){
+                const double t = P[0];
+                Evaluate_Model(after_state,t,eval_res);
+                fitted_model.push_back(t, 0.0, eval_res.I, 0.0);
+            }
+            title = "Fitted model";
+            time_courses[title] = fitted_model;
+
+            PlotTimeCourses("Raw ROI and Fitted Model", time_courses, {});
+        }
+        
+        //==============================================================================
+
+        //Update pixel values.
+        const auto k1A_f  = static_cast<float>(k1A);
+        const auto tauA_f = static_cast<float>(tauA);
+        const auto k1V_f  = static_cast<float>(k1V);
+        const auto tauV_f = static_cast<float>(tauV);
+        const auto k2_f   = static_cast<float>(k2);
+
+        minmax_k1A.Digest(k1A_f);
+        minmax_tauA.Digest(tauA_f);
+        minmax_k1V.Digest(k1V_f);
+        minmax_tauV.Digest(tauV_f);
+        minmax_k2.Digest(k2_f);
+
+        {
+            out_img_k1A.get().reference(row, col, chan)  = k1A_f;
+            out_img_tauA.get().reference(row, col, chan) = tauA_f;
+            out_img_k1V.get().reference(row, col, chan)  = k1V_f;
+            out_img_tauV.get().reference(row, col, chan) = tauV_f;
+            out_img_k2.get().reference(row, col, chan)   = k2_f;
+        }
+    }
+
     FUNCWARN("Minimization failure count: " << Minimization_Failure_Count);
 
 
@@ -9,12 +9,15 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <utility>
 
 //#include "../Grouping/Misc_Functors.h"
 #include "Orthogonal_Slices.h"
+#include "../Rectilinear_Volume.h"
+#include "../Multiplanar_Reformat.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
 #include "YgorMisc.h"
@@ -101,6 +104,42 @@ bool OrthogonalSlices(planar_image_collection<float,double>::images_list_it_t fi
     const auto numb_of_chns = first_img_it->channels;
     const long int img_skip = 50;  //Reduces output. Keep every Nth image; 1: keep all, 2: keep every other, etc..
 
+    //When the images form a regular grid, reslice a packed copy of the volume directly. This avoids searching the
+    // images for every outgoing voxel. Other image sets are sampled by intersection below.
+    {
+        std::list<std::reference_wrapper<planar_image<float,double>>> imgs;
+        for(const auto &img_it : selected_img_its) imgs.emplace_back( std::ref(*img_it) );
+        imgs.sort([&](const planar_image<float,double> &A, const planar_image<float,double> &B) -> bool {
+            return A.offset.Dot(old_orto_unit) < B.offset.Dot(old_orto_unit);
+        });
+
+        std::optional<rectilinear_volume> vol;
+        try{
+            vol.emplace(imgs);
+        }catch(const std::exception &){ }
+
+        if(vol && vol->is_regular){
+            const auto emplace_reformats = [&](orthogonal_reformat plane,
+                                               planar_image_collection<float,double> &dest,
+                                               const std::string &desc){
+                for(auto &img : Reformat_Orthogonal(*vol, plane, img_skip, anchor)){
+                    img.metadata = common_metadata;
+                    img.metadata["Rows"] = std::to_string(img.rows);
+                    img.metadata["Columns"] = std::to_string(img.columns);
+                    img.metadata["PixelSpacing"] = std::to_string(img.pxl_dx) + "^" + std::to_string(img.pxl_dy);
+                    img.metadata["SliceThickness"] = std::to_string(img.pxl_dz);
+                    img.metadata["Description"] = desc;
+                    dest.images.emplace_back( std::move(img) );
+                }
+            };
+            emplace_reformats(orthogonal_reformat::FixedColumn, out_imgs.front().get(),
+                              "Ortho Volume Intersection: Row");
+            emplace_reformats(orthogonal_reformat::FixedRow, out_imgs.back().get(),
+                              "Ortho Volume Intersection: Column");
+            return true;
+        }
+    }
+
     // ---- First set: 'row' aligned orthogonal images ----
     {
         const auto& new_col_unit = old_row_unit; //Chosen to new_row x new_col = old_col
@@ -5,6 +5,8 @@
 #include <stdexcept>
 
 #include "../ConvenienceRoutines.h"
+#include "../Voxel_Inclusion_Mask.h"
+#include "../../Tracing.h"
 #include "Partitioned_Image_Voxel_Visitor_Mutator.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
@@ -16,6 +18,7 @@ bool PartitionedImageVoxelVisitorMutator(planar_image_collection<float,double>::
                         std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
                         std::list<std::reference_wrapper<contour_collection<double>>> ccsl, 
                         std::any user_data){
+    DCMA_TRACE_ZONE("voxel visitor", "PartitionedImageVoxelVisitorMutator");
 
     //This routine walks over all voxels in the first image, overwriting voxel values (or just visiting them) according
     // to the routines provided by the user. The function called depends on whether the voxel is interior or exterior to
@@ -44,16 +47,57 @@ bool PartitionedImageVoxelVisitorMutator(planar_image_collection<float,double>::
         throw std::invalid_argument("No contours provided. Cannot continue");
     }
 
-    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
-    for(auto &img_it : selected_img_its) selected_imgs.push_back( std::ref(*img_it) );
-
-    Mutate_Voxels<float,double>( std::ref(*first_img_it),
-                                 selected_imgs, 
-                                 ccsl, 
-                                 user_data_s->mutation_opts, 
-                                 user_data_s->f_bounded,
-                                 user_data_s->f_unbounded,
-                                 user_data_s->f_visitor );
+    // When voxels are edited in-place using only their own value, the cached rasterization of the contours can be used
+    // in lieu of testing every voxel against every contour.
+    const auto &opts = user_data_s->mutation_opts;
+    const bool single_img = (selected_img_its.size() == 1)
+                         && (&(*(selected_img_its.front())) == &(*first_img_it));
+    if( single_img
+    &&  (opts.editstyle == Mutate_Voxels_Opts::EditStyle::InPlace)
+    &&  (opts.adjacency == Mutate_Voxels_Opts::Adjacency::SingleVoxel) ){
+        auto &img = *first_img_it;
+        auto img_refw = std::ref(img);
+        const auto mask = Get_Voxel_Inclusion_Mask(img, ccsl, opts);
+
+        const auto &f_bounded = user_data_s->f_bounded;
+        const auto &f_unbounded = user_data_s->f_unbounded;
+        const auto &f_visitor = user_data_s->f_visitor;
+        const auto visit = [&](long int row, long int c_begin, long int c_end, bool bounded) -> void {
+            const auto &f = (bounded) ? f_bounded : f_unbounded;
+            if(!f && !f_visitor) return;
+            for(long int col = c_begin; col < c_end; ++col){
+                for(long int chnl = 0; chnl < img.channels; ++chnl){
+                    float &val = img.reference(row, col, chnl);
+                    if(f) f(row, col, chnl, img_refw, val);
+                    if(f_visitor) f_visitor(row, col, chnl, img_refw, val);
+                }
+            }
+        };
+
+        for(long int row = 0; row < img.rows; ++row){
+            long int c_begin = 0;
+            for(auto r = mask->row_offsets[row]; r < mask->row_offsets[row + 1]; ++r){
+                const auto run_begin = static_cast<long int>(mask->runs[r][0]);
+                const auto run_end   = static_cast<long int>(mask->runs[r][1]);
+                visit(row, c_begin, run_begin, false);
+                visit(row, run_begin, run_end, true);
+                c_begin = run_end;
+            }
+            visit(row, c_begin, img.columns, false);
+        }
+
+    }else{
+        std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+        for(auto &img_it : selected_img_its) selected_imgs.push_back( std::ref(*img_it) );
+
+        Mutate_Voxels<float,double>( std::ref(*first_img_it),
+                                     selected_imgs, 
+                                     ccsl, 
+                                     opts, 
+                                     user_data_s->f_bounded,
+                                     user_data_s->f_unbounded,
+                                     user_data_s->f_visitor );
+    }
 
 
     //Alter the first image's metadata to reflect that averaging has occurred. You might want to consider
@@ -66,7 +110,3 @@ bool PartitionedImageVoxelVisitorMutator(planar_image_collection<float,double>::
     return true;
 }
 
-
-
-
-
@@ -8,12 +8,25 @@
 #include <limits>
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "YgorImages.h"
 #include "YgorMath.h"
 #include "YgorMisc.h"
 
+#include "../../Thread_Pool.h"
+#include "../ConvenienceRoutines.h"
+#include "../Image_Tiling.h"
+#include "../Voxel_Inclusion_Mask.h"
+
 template <class T> class contour_collection;
 
 
@@ -37,6 +50,145 @@ bool PartitionedImageVoxelVisitorMutator(planar_image_collection<float,double>::
                         std::any );
 
 
+// A functor that does nothing. Using it for either partition skips traversal of that partition altogether.
+struct voxel_span_noop {
+    void operator()(float &) const {}
+};
+
+// A compile-time-specialized alternative to PartitionedImageVoxelVisitorMutatorUserData for simple, per-voxel
+// mutations (e.g., scaling, thresholding, or negation) that only need the voxel value.
+//
+// Functors are invoked as f(float &val) once per (selected) voxel value. Rather than visiting voxels individually, the
+// (cached) inclusion mask is retrieved and each row is traversed as spans of consecutive bounded or unbounded voxels, so the
+// functor can be inlined and contiguous spans vectorized. Functors may be invoked concurrently for different images, or
+// for different rows of an image (see Mutate_Voxel_Spans_Balanced()).
+//
+// Only in-place edits of single voxels are supported, i.e., the behaviour matches the generic routine with
+// EditStyle::InPlace, Aggregate::First, and Adjacency::SingleVoxel.
+template <class F_bounded, class F_unbounded = voxel_span_noop>
+struct PartitionedImageVoxelSpanMutatorUserData {
+
+    // Options controlling which voxels are considered bounded. Only inclusivity, contour overlap, and mask
+    // modification options are honoured.
+    Mutate_Voxels_Opts mutation_opts;
+
+    // The channel to mutate. If negative, all channels are mutated.
+    long int channel = -1;
+
+    F_bounded f_bounded;     // Applied to voxels bounded by contours.
+    F_unbounded f_unbounded; // Applied to voxels NOT bounded by contours.
+
+    std::string description; // If non-empty, used to update image metadata.
+
+    explicit PartitionedImageVoxelSpanMutatorUserData(F_bounded fb, F_unbounded fu = F_unbounded())
+        : f_bounded(std::move(fb)), f_unbounded(std::move(fu)) {}
+};
+
+// Applies the span mutator's functors to rows [row_begin, row_end) of the image, using the given inclusion mask.
+template <class F_bounded, class F_unbounded>
+void Mutate_Voxel_Span_Rows(planar_image<float,double> &img,
+                            const voxel_inclusion_mask &mask,
+                            PartitionedImageVoxelSpanMutatorUserData<F_bounded, F_unbounded> &ud,
+                            long int row_begin,
+                            long int row_end){
+    constexpr bool do_bounded   = !std::is_same<F_bounded,   voxel_span_noop>::value;
+    constexpr bool do_unbounded = !std::is_same<F_unbounded, voxel_span_noop>::value;
+
+    const long int cols = img.columns;
+    const long int chns = img.channels;
+    const long int channel = ud.channel;
+    if(chns <= channel) return;
+
+    // Applies the functor to all selected values of voxels [c_begin, c_end) in the given row. When all channels of a
+    // single-channel image are selected, the values are contiguous.
+    const auto apply_span = [&](auto &f, long int row, long int c_begin, long int c_end) -> void {
+        float *p = &img.reference(row, c_begin, 0);
+        if(channel < 0){
+            const long int n = (c_end - c_begin) * chns;
+            for(long int i = 0; i < n; ++i) f(p[i]);
+        }else{
+            p += channel;
+            const long int n = (c_end - c_begin);
+            for(long int i = 0; i < n; ++i) f(p[i * chns]);
+        }
+    };
+
+    for(long int row = row_begin; row < row_end; ++row){
+        // Alternate between the unbounded gaps and the bounded runs.
+        long int c_begin = 0;
+        for(auto r = mask.row_offsets[row]; r < mask.row_offsets[row + 1]; ++r){
+            const auto run_begin = static_cast<long int>(mask.runs[r][0]);
+            const auto run_end   = static_cast<long int>(mask.runs[r][1]);
+            if constexpr (do_unbounded) if(c_begin < run_begin) apply_span(ud.f_unbounded, row, c_begin, run_begin);
+            if constexpr (do_bounded) apply_span(ud.f_bounded, row, run_begin, run_end);
+            c_begin = run_end;
+        }
+        if constexpr (do_unbounded) if(c_begin < cols) apply_span(ud.f_unbounded, row, c_begin, cols);
+    }
+    return;
+}
+
+template <class F_bounded, class F_unbounded = voxel_span_noop>
+bool PartitionedImageVoxelSpanMutator(planar_image_collection<float,double>::images_list_it_t first_img_it,
+                        std::list<planar_image_collection<float,double>::images_list_it_t>,
+                        std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
+                        std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
+                        std::any user_data){
+
+    using ud_t = PartitionedImageVoxelSpanMutatorUserData<F_bounded, F_unbounded>;
+    ud_t *user_data_s;
+    try{
+        user_data_s = std::any_cast<ud_t *>(user_data);
+    }catch(const std::exception &e){
+        FUNCWARN("Unable to cast user_data to appropriate format. Cannot continue with computation");
+        return false;
+    }
+    if(ccsl.empty()){
+        throw std::invalid_argument("No contours provided. Cannot continue");
+    }
+
+    auto &img = *first_img_it;
+    const auto mask = Get_Voxel_Inclusion_Mask(img, ccsl, user_data_s->mutation_opts);
+    Mutate_Voxel_Span_Rows(img, *mask, *user_data_s, 0, img.rows);
+
+    if( !(user_data_s->description.empty()) ){
+        UpdateImageDescription( std::ref(img), user_data_s->description );
+    }
+    UpdateImageWindowCentreWidth( std::ref(img) );
+
+    return true;
+}
+
+// Applies the span mutator to every image in the collection. Equivalent to Process_Images_Parallel() with
+// GroupIndividualImages and PartitionedImageVoxelSpanMutator, except that work is divided according to the measured
+// cost of the functors: large images are cut into bands of rows that are mutated concurrently, and small images are
+// batched. Throws on error.
+template <class F_bounded, class F_unbounded>
+void Mutate_Voxel_Spans_Balanced(planar_image_collection<float,double> &imagecoll,
+                                 std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
+                                 PartitionedImageVoxelSpanMutatorUserData<F_bounded, F_unbounded> &ud){
+    if(ccsl.empty()){
+        throw std::invalid_argument("No contours provided. Cannot continue");
+    }
 
+    // Rasterize the contours for every image up-front so the bands of an image share a single mask.
+    std::map<const planar_image<float,double> *, std::shared_ptr<const voxel_inclusion_mask>> masks;
+    std::vector<decltype(masks)::iterator> mask_its;
+    for(auto &img : imagecoll.images) mask_its.push_back( masks.emplace(&img, nullptr).first );
+    parallel_for(0, static_cast<long int>(mask_its.size()), [&](long int i) -> void {
+        mask_its[i]->second = Get_Voxel_Inclusion_Mask(*(mask_its[i]->first), ccsl, ud.mutation_opts);
+    }, /*grain=*/ 1);
 
+    Process_Image_Tiles(imagecoll, Tile_Cost_Key(&PartitionedImageVoxelSpanMutator<F_bounded, F_unbounded>),
+        [&](planar_image<float,double> &img, long int row_begin, long int row_end) -> void {
+            Mutate_Voxel_Span_Rows(img, *(masks.at(&img)), ud, row_begin, row_end);
+        },
+        [&](planar_image<float,double> &img) -> void {
+            if( !(ud.description.empty()) ){
+                UpdateImageDescription( std::ref(img), ud.description );
+            }
+            UpdateImageWindowCentreWidth( std::ref(img) );
+        });
+    return;
+}
 
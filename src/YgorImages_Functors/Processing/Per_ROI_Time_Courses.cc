@@ -7,6 +7,7 @@
 #include <list>
 #include <map>
 
+#include "../../Time_Course_Tensor.h"
 #include "../ConvenienceRoutines.h"
 #include "Per_ROI_Time_Courses.h"
 #include "YgorImages.h"
@@ -38,7 +39,7 @@ bool PerROITimeCourses(planar_image_collection<float,double>::images_list_it_t f
 
     //This routine performs a number of calculations. It is experimental and excerpts you plan to rely on should be
     // made into their own analysis functors.
-    const bool InhibitSort = true; //Disable continuous sorting (defer to single sort later) to speed up data ingress.
+    const bool InhibitSort = true; //Samples are harvested in temporal order, so sorting is not needed.
 
 
     //Figure out if there are any contours for which are within the spatial extent of the image. 
@@ -64,6 +65,18 @@ bool PerROITimeCourses(planar_image_collection<float,double>::images_list_it_t f
         }
     }
 */
+    //Gather the selected images into a tensor so each voxel's time course can be read as a single contiguous series.
+    // The images are ordered temporally.
+    std::list<const planar_image<float,double> *> selected_imgs;
+    for(auto & img_it : selected_img_its) selected_imgs.push_back( &(*img_it) );
+    const Time_Course_Tensor tensor(selected_imgs);
+    const auto &group = tensor.get_group(0);
+    const auto &times = group.get_times();
+    const bool has_times = group.has_times();
+
+    //Each datum is a single voxel, so the uncertainty estimate is the same for all of them.
+    const auto single_datum_sigma = std::sqrt(Stats::Unbiased_Var_Est(std::list<double>{ 0.0 }));
+
     //Make a 'working' image which we can edit. Start by duplicating the first image.
     planar_image<float,double> working;
     working = *first_img_it;
@@ -149,41 +162,14 @@ bool PerROITimeCourses(planar_image_collection<float,double>::images_list_it_t f
                                                           "You will need to run the functor individually on the overlapping ROIs.");
                             }
     
-                            //Cycle over the grouped images (temporal slices, or whatever the user has decided).
-                            // Harvest the time course or any other voxel-specific numbers.
+                            //Harvest the time course (temporal slices, or whatever the user has decided).
+                            if(!has_times) FUNCERR("Image is missing time metadata. Bailing");
+                            const float *series = group.get_series(row, col, chan);
                             samples_1D<double> channel_time_course;
                             channel_time_course.uncertainties_known_to_be_independent_and_random = true;
-                            for(auto & img_it : selected_img_its){
-                                //Collect the datum of voxels and nearby voxels for an average.
-                                std::list<double> in_pixs;
-                                const auto boxr = 0;
-                                const auto min_datum = 1;
-    
-                                for(auto lrow = (row-boxr); lrow <= (row+boxr); ++lrow){
-                                    for(auto lcol = (col-boxr); lcol <= (col+boxr); ++lcol){
-                                        //Check if the coordinates are legal and in the ROI.
-                                        if( !isininc(0,lrow,img_it->rows-1) || !isininc(0,lcol,img_it->columns-1) ) continue;
-    
-                                        //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
-                                        //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
-                                        const auto neighbourpoint = first_img_it->position(lrow,lcol);
-                                        auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
-                                        if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                        ProjectedNeighbourPoint,
-                                                                                                        AlreadyProjected)) continue;
-                                        const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
-                                        in_pixs.push_back(val);
-                                    }
-                                }
-                                const auto avg_val = Stats::Mean(in_pixs);
-                                if(in_pixs.size() < min_datum) continue; //If contours are too narrow so that there is too few datum for meaningful results.
-                                const auto avg_val_sigma = std::sqrt(Stats::Unbiased_Var_Est(in_pixs))/std::sqrt(1.0*in_pixs.size());
-    
-                                auto dt = img_it->GetMetadataValueAs<double>("dt");
-                                if(!dt) FUNCERR("Image is missing time metadata. Bailing");
-                                channel_time_course.push_back(dt.value(), 0.0, avg_val, avg_val_sigma, InhibitSort);
+                            for(size_t t = 0; t < group.size(); ++t){
+                                channel_time_course.push_back(times[t], 0.0, static_cast<double>(series[t]), single_datum_sigma, InhibitSort);
                             }
-                            channel_time_course.stable_sort();
                             if(channel_time_course.empty()) continue;
     
                             //Fill in some basic time course metadata.
@@ -0,0 +1,170 @@
+//ROI_Mask_Volume.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Thread_Pool.h"
+#include "Voxel_Inclusion_Mask.h"
+#include "ROI_Mask_Volume.h"
+
+
+roi_mask_volume
+Rasterize_ROI_Mask_Volume(planar_image_collection<float,double> &imagecoll,
+                          const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                          const Mutate_Voxels_Opts &opts){
+    if(imagecoll.images.empty()){
+        throw std::invalid_argument("No images provided. Cannot rasterize ROIs.");
+    }
+    std::list<std::reference_wrapper<planar_image<float,double>>> imgs;
+    for(auto &img : imagecoll.images) imgs.push_back( std::ref(img) );
+    if(!Images_Form_Rectilinear_Grid(imgs) || !Images_Form_Regular_Grid(imgs)){
+        throw std::invalid_argument("Images do not form a regular rectilinear grid. Cannot rasterize ROIs.");
+    }
+
+    const auto &first = imagecoll.images.front();
+    const auto ortho_unit = first.row_unit.Cross(first.col_unit).unit();
+
+    roi_mask_volume out;
+    out.images.assign(std::begin(imgs), std::end(imgs));
+    std::stable_sort(std::begin(out.images), std::end(out.images),
+                     [&](const planar_image<float,double> &L, const planar_image<float,double> &R) -> bool {
+                         return L.position(0, 0).Dot(ortho_unit) < R.position(0, 0).Dot(ortho_unit);
+                     });
+
+    auto &grid = out.grid;
+    grid.images  = static_cast<int64_t>(out.images.size());
+    grid.rows    = first.rows;
+    grid.columns = first.columns;
+    grid.row_spacing    = first.pxl_dx;
+    grid.column_spacing = first.pxl_dy;
+    grid.image_spacing  = std::numeric_limits<double>::infinity(); // A lone image has no neighbours to reach.
+    if(1 < grid.images){
+        grid.image_spacing = (out.images.back().get().position(0, 0) - out.images.front().get().position(0, 0))
+                               .Dot(ortho_unit) / static_cast<double>(grid.images - 1);
+        if(!(0.0 < grid.image_spacing)){
+            throw std::invalid_argument("Images are not separated along their normal. Cannot rasterize ROIs.");
+        }
+    }
+    for(const auto &img_refw : out.images){
+        if( (img_refw.get().rows != grid.rows) || (img_refw.get().columns != grid.columns) ){
+            throw std::invalid_argument("Images have differing dimensions. Cannot rasterize ROIs.");
+        }
+    }
+
+    const auto image_size = grid.rows * grid.columns;
+    out.mask.assign(static_cast<size_t>(grid.size()), 0);
+    parallel_for(0, grid.images, [&](long int i){
+        const auto m = Get_Voxel_Inclusion_Mask(out.images[i].get(), ccsl, opts);
+        uint8_t *dst = out.mask.data() + i * image_size;
+        for(long int row = 0; row < m->rows; ++row){
+            for(auto r = m->row_offsets[row]; r < m->row_offsets[row + 1]; ++r){
+                std::fill(dst + row * grid.columns + m->runs[r][0],
+                          dst + row * grid.columns + m->runs[r][1], 1);
+            }
+        }
+    }, 1);
+    return out;
+}
+
+
+contour_collection<double>
+Contour_ROI_Mask_Volume(const roi_mask_volume &vol){
+    contour_collection<double> out;
+    const auto &grid = vol.grid;
+    if(static_cast<int64_t>(vol.mask.size()) != grid.size()){
+        throw std::invalid_argument("Mask size does not match grid dimensions. Cannot contour mask.");
+    }
+    if(static_cast<int64_t>(vol.images.size()) != grid.images){
+        throw std::invalid_argument("Mask images do not match grid dimensions. Cannot contour mask.");
+    }
+
+    const auto R = grid.rows;
+    const auto C = grid.columns;
+    const auto image_size = R * C;
+
+    std::vector<contour_collection<double>> ccs(vol.images.size());
+    parallel_for(0, grid.images, [&](long int i){
+        const auto &img = vol.images[i].get();
+        const auto origin = img.position(0, 0);
+        const auto row_step = img.row_unit.unit() * img.pxl_dx;
+        const auto col_step = img.col_unit.unit() * img.pxl_dy;
+        const uint8_t *m = vol.mask.data() + i * image_size;
+
+        // The lattice is padded with a ring of excluded voxels, so lattice point (r,c) is voxel (r-1,c-1) and every
+        // contour is closed. Each lattice edge is identified by its lower lattice point and direction.
+        const auto included = [&](int64_t r, int64_t c) -> bool {
+            return (1 <= r) && (r <= R) && (1 <= c) && (c <= C) && (m[(r - 1) * C + (c - 1)] != 0);
+        };
+        const auto row_edge = [&](int64_t r, int64_t c) -> int64_t { return 2 * (r * (C + 2) + c); };
+        const auto col_edge = [&](int64_t r, int64_t c) -> int64_t { return 2 * (r * (C + 2) + c) + 1; };
+        const auto edge_midpoint = [&](int64_t e) -> vec3<double> {
+            const auto k = e / 2;
+            const auto r = static_cast<double>(k / (C + 2)) - ((e % 2 == 0) ? 0.5 : 1.0);
+            const auto c = static_cast<double>(k % (C + 2)) - ((e % 2 == 0) ? 1.0 : 0.5);
+            return origin + row_step * r + col_step * c;
+        };
+
+        // Marching squares. Cell corners are visited counter-clockwise around the image normal (row_unit x col_unit),
+        // and each segment runs from an edge leaving the included region to an edge entering it, so contours are
+        // counter-clockwise around included regions. Diagonally-adjacent included voxels are not joined.
+        std::unordered_map<int64_t, int64_t> next;
+        for(int64_t r = 0; r <= R; ++r){
+            for(int64_t c = 0; c <= C; ++c){
+                const bool v[4] = { included(r, c), included(r + 1, c), included(r + 1, c + 1), included(r, c + 1) };
+                const int64_t e[4] = { row_edge(r, c), col_edge(r + 1, c), row_edge(r, c + 1), col_edge(r, c) };
+                if( (v[0] == v[1]) && (v[1] == v[2]) && (v[2] == v[3]) ) continue;
+
+                if( (v[0] == v[2]) && (v[1] == v[3]) ){ // Saddle.
+                    const int a = v[0] ? 0 : 1;
+                    next[e[a]] = e[(a + 3) % 4];
+                    next[e[a + 2]] = e[(a + 1) % 4];
+                    continue;
+                }
+                int64_t exit_e = -1;
+                int64_t entry_e = -1;
+                for(int k = 0; k < 4; ++k){
+                    if(v[k] && !v[(k + 1) % 4]) exit_e = e[k];
+                    if(!v[k] && v[(k + 1) % 4]) entry_e = e[k];
+                }
+                next[exit_e] = entry_e;
+            }
+        }
+
+        // Sort the starting edges so the output does not depend on the hash map's iteration order.
+        std::vector<int64_t> starts;
+        starts.reserve(next.size());
+        for(const auto &p : next) starts.push_back(p.first);
+        std::sort(std::begin(starts), std::end(starts));
+
+        for(const auto &s : starts){
+            auto it = next.find(s);
+            if(it == std::end(next)) continue; // Already visited.
+
+            contour_of_points<double> cop;
+            cop.closed = true;
+            auto e = s;
+            while(it != std::end(next)){
+                cop.points.emplace_back( edge_midpoint(e) );
+                e = it->second;
+                next.erase(it);
+                it = next.find(e);
+            }
+            ccs[i].contours.emplace_back( std::move(cop) );
+        }
+    }, 1);
+
+    for(auto &cc : ccs) out.contours.splice(std::end(out.contours), cc.contours);
+    return out;
+}
+
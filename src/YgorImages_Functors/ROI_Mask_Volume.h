@@ -0,0 +1,45 @@
+//ROI_Mask_Volume.h.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Distance_Transform.h"
+
+template <class T> class contour_collection;
+
+
+// A binary rasterization of ROIs on a regular, rectilinear stack of images, suitable for the distance transforms in
+// Distance_Transform.h.
+//
+// The mask has (image, row, column) ordering, with images ordered along the grid's normal.
+struct roi_mask_volume {
+    std::vector<std::reference_wrapper<planar_image<float,double>>> images;
+    distance_transform_grid grid;
+    std::vector<uint8_t> mask;
+};
+
+// Rasterizes all contours together using the cached voxel inclusion masks, honouring the inclusivity, contour overlap,
+// and mask modification options. Throws if the images do not form a regular rectilinear grid.
+//
+// Only the portion of the ROIs within the images is captured, so the images should cover the ROIs (and any margin
+// that will be applied) to avoid truncation.
+roi_mask_volume
+Rasterize_ROI_Mask_Volume(planar_image_collection<float,double> &imagecoll,
+                          const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                          const Mutate_Voxels_Opts &opts);
+
+// Contours a mask on each of its images' planes using marching squares.
+//
+// Lattice points are voxel centres, so contours pass midway between included and excluded voxels. Voxels beyond the
+// images are treated as excluded, so every contour is closed. Contours are counter-clockwise around included regions
+// when viewed along the image normal, and have no metadata.
+contour_collection<double>
+Contour_ROI_Mask_Volume(const roi_mask_volume &vol);
+
@@ -0,0 +1,265 @@
+//ROI_Similarity.cc.
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+#include "../Thread_Pool.h"
+#include "../Distance_Transform.h"
+#include "ROI_Mask_Volume.h"
+#include "ROI_Similarity.h"
+
+
+namespace {
+
+using ccsl_t = std::list<std::reference_wrapper<contour_collection<double>>>;
+
+// Partitions the contours by ROIName, copying them into the provided storage.
+void partition_by_ROIName(const ccsl_t &ccsl,
+                          std::list<contour_collection<double>> &cc_storage,
+                          std::map<std::string, ccsl_t> &named_ccsls){
+    for(auto &ccs : ccsl){
+        for(auto &contour : ccs.get().contours){
+            if(contour.points.empty()) continue;
+            const auto ROIName = contour.GetMetadataValueAs<std::string>("ROIName");
+            if(!ROIName){
+                FUNCWARN("Found contour missing ROIName metadata element. Using placeholder name");
+            }
+            const auto key = ROIName.value_or("unspecified");
+            if(named_ccsls.count(key) == 0){
+                cc_storage.emplace_back();
+                named_ccsls.emplace(key, ccsl_t{ std::ref(cc_storage.back()) });
+            }
+            named_ccsls.at(key).front().get().contours.emplace_back(contour);
+        }
+    }
+    return;
+}
+
+std::set<std::string> ROINames(const ccsl_t &ccsl){
+    std::set<std::string> names;
+    for(auto &ccs : ccsl){
+        for(auto &contour : ccs.get().contours){
+            if(contour.points.empty()) continue;
+            names.insert( contour.GetMetadataValueAs<std::string>("ROIName").value_or("unspecified") );
+        }
+    }
+    return names;
+}
+
+struct rasterized_roi_t {
+    std::vector<uint64_t> bits;      // The mask, 64 voxels per word.
+    int64_t voxels = 0;
+    std::vector<int64_t> surface;    // Indices of surface voxels, in increasing order.
+};
+
+rasterized_roi_t rasterize(const roi_mask_volume &vol){
+    const auto &g = vol.grid;
+    const auto N = g.size();
+    rasterized_roi_t out;
+    out.bits.assign(static_cast<size_t>((N + 63) / 64), 0);
+
+    // Each image is handled independently; images are not aligned to word boundaries, so words are filled in a
+    // separate pass.
+    const auto image_size = g.rows * g.columns;
+    std::vector<std::vector<int64_t>> surfaces(g.images);
+    std::vector<int64_t> counts(g.images, 0);
+    parallel_for(0, g.images, [&](long int i){
+        const uint8_t *m = vol.mask.data() + i * image_size;
+        const auto included = [&](int64_t img, int64_t row, int64_t col) -> bool {
+            return (0 <= img) && (img < g.images)
+                && (0 <= row) && (row < g.rows)
+                && (0 <= col) && (col < g.columns)
+                && (vol.mask[(img * g.rows + row) * g.columns + col] != 0);
+        };
+        for(int64_t row = 0; row < g.rows; ++row){
+            for(int64_t col = 0; col < g.columns; ++col){
+                if(m[row * g.columns + col] == 0) continue;
+                ++counts[i];
+                if( !included(i - 1, row, col) || !included(i + 1, row, col)
+                ||  !included(i, row - 1, col) || !included(i, row + 1, col)
+                ||  !included(i, row, col - 1) || !included(i, row, col + 1) ){
+                    surfaces[i].push_back(i * image_size + row * g.columns + col);
+                }
+            }
+        }
+    }, 1);
+
+    parallel_for(0, static_cast<long int>(out.bits.size()), [&](long int w){
+        uint64_t word = 0;
+        const auto end = std::min<int64_t>(N, (w + 1) * 64);
+        for(int64_t n = w * 64; n < end; ++n){
+            if(vol.mask[n] != 0) word |= (static_cast<uint64_t>(1) << (n - w * 64));
+        }
+        out.bits[w] = word;
+    });
+
+    for(int64_t i = 0; i < g.images; ++i){
+        out.voxels += counts[i];
+        out.surface.insert(std::end(out.surface), std::begin(surfaces[i]), std::end(surfaces[i]));
+    }
+    return out;
+}
+
+int64_t count_overlap(const rasterized_roi_t &A, const rasterized_roi_t &B){
+    int64_t n = 0;
+    for(size_t w = 0; w < A.bits.size(); ++w){
+        n += static_cast<int64_t>( std::bitset<64>(A.bits[w] & B.bits[w]).count() );
+    }
+    return n;
+}
+
+// Nearest-rank percentile. The distances are reordered.
+double percentile(std::vector<double> &d, double p){
+    if(d.empty()) return std::numeric_limits<double>::quiet_NaN();
+    const auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(d.size())));
+    const auto k = std::clamp<size_t>(rank, 1, d.size()) - 1;
+    std::nth_element(std::begin(d), std::next(std::begin(d), k), std::end(d));
+    return d[k];
+}
+
+} // namespace
+
+
+std::vector<roi_similarity>
+Compute_ROI_Similarities(planar_image_collection<float,double> &imagecoll,
+                         const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl_A,
+                         const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl_B,
+                         const roi_similarity_options &opts){
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+    // Collections selected in both sets are only considered once.
+    ccsl_t ccsl_all = ccsl_A;
+    for(const auto &cc : ccsl_B){
+        const auto it = std::find_if(std::begin(ccsl_A), std::end(ccsl_A), [&](const auto &x) -> bool {
+            return (&(x.get()) == &(cc.get()));
+        });
+        if(it == std::end(ccsl_A)) ccsl_all.push_back(cc);
+    }
+    std::list<contour_collection<double>> cc_storage;
+    std::map<std::string, ccsl_t> named_ccsls;
+    partition_by_ROIName(ccsl_all, cc_storage, named_ccsls);
+    const auto names_A = ROINames(ccsl_A);
+    const auto names_B = ROINames(ccsl_B);
+
+    // Enumerate the unordered pairs.
+    std::set<std::pair<std::string, std::string>> seen;
+    std::vector<std::pair<std::string, std::string>> pairs;
+    for(const auto &a : names_A){
+        for(const auto &b : names_B){
+            if(a == b) continue;
+            const std::pair<std::string, std::string> key = std::minmax(a, b);
+            if(!seen.insert(key).second) continue;
+            const bool both_in_both = (names_A.count(b) != 0) && (names_B.count(a) != 0);
+            pairs.emplace_back( both_in_both ? key : std::make_pair(a, b) );
+        }
+    }
+    std::vector<roi_similarity> out;
+    if(pairs.empty()) return out;
+
+    // Rasterize every ROI once.
+    std::vector<std::string> names;
+    for(const auto &p : named_ccsls) names.push_back(p.first);
+    std::map<std::string, size_t> index_of;
+    for(size_t i = 0; i < names.size(); ++i) index_of[names[i]] = i;
+
+    distance_transform_grid grid;
+    std::vector<rasterized_roi_t> rois;
+    rois.reserve(names.size());
+    double voxel_volume = 0.0;
+    for(const auto &name : names){
+        auto vol = Rasterize_ROI_Mask_Volume(imagecoll, named_ccsls.at(name), opts.mutation_opts);
+        grid = vol.grid;
+        const auto dz = std::isfinite(grid.image_spacing) ? grid.image_spacing
+                                                          : vol.images.front().get().pxl_dz;
+        voxel_volume = grid.row_spacing * grid.column_spacing * dz;
+        rois.emplace_back( rasterize(vol) );
+    }
+
+    out.resize(pairs.size());
+    parallel_for(0, static_cast<long int>(pairs.size()), [&](long int p){
+        auto &s = out[p];
+        s.ROIName_A = pairs[p].first;
+        s.ROIName_B = pairs[p].second;
+        const auto &A = rois[index_of.at(s.ROIName_A)];
+        const auto &B = rois[index_of.at(s.ROIName_B)];
+        s.voxels_A = A.voxels;
+        s.voxels_B = B.voxels;
+        s.voxels_overlap = count_overlap(A, B);
+        s.voxel_volume = voxel_volume;
+
+        const auto nA = static_cast<double>(s.voxels_A);
+        const auto nB = static_cast<double>(s.voxels_B);
+        const auto nAB = static_cast<double>(s.voxels_overlap);
+        const bool both_empty = (s.voxels_A == 0) && (s.voxels_B == 0);
+        s.dice    = both_empty ? nan : (2.0 * nAB) / (nA + nB);
+        s.jaccard = both_empty ? nan : nAB / (nA + nB - nAB);
+
+        s.hausdorff = nan;
+        s.hausdorff_95 = nan;
+        s.mean_surface = nan;
+    }, 1);
+    if(!opts.surface_distances) return out;
+
+    // Directed surface distances for each pair: from A's surface to B's, and from B's surface to A's. Each ROI's
+    // surface distance transform is computed once and used for every pair it participates in.
+    std::vector<std::vector<double>> d_AB(pairs.size());
+    std::vector<std::vector<double>> d_BA(pairs.size());
+    for(size_t j = 0; j < names.size(); ++j){
+        const auto &target = rois[j];
+        if(target.surface.empty()) continue;
+
+        std::vector<size_t> involved;
+        for(size_t p = 0; p < pairs.size(); ++p){
+            if( (pairs[p].first == names[j]) || (pairs[p].second == names[j]) ) involved.push_back(p);
+        }
+        if(involved.empty()) continue;
+
+        std::vector<uint8_t> surface_mask(static_cast<size_t>(grid.size()), 0);
+        for(const auto &n : target.surface) surface_mask[n] = 1;
+        const auto sq_dist = Squared_Euclidean_Distance_Transform(surface_mask, grid);
+
+        parallel_for(0, static_cast<long int>(involved.size()), [&](long int k){
+            const auto p = involved[k];
+            const bool target_is_B = (pairs[p].second == names[j]);
+            const auto &source = rois[index_of.at(target_is_B ? pairs[p].first : pairs[p].second)];
+            auto &d = target_is_B ? d_AB[p] : d_BA[p];
+            d.reserve(source.surface.size());
+            for(const auto &n : source.surface) d.push_back( std::sqrt(sq_dist[n]) );
+        }, 1);
+    }
+
+    parallel_for(0, static_cast<long int>(pairs.size()), [&](long int p){
+        auto &s = out[p];
+        auto &ab = d_AB[p];
+        auto &ba = d_BA[p];
+        if(ab.empty() || ba.empty()) return;
+
+        double sum = 0.0;
+        double max = 0.0;
+        for(const auto &d : { std::cref(ab), std::cref(ba) }){
+            for(const auto &x : d.get()){
+                sum += x;
+                max = std::max(max, x);
+            }
+        }
+        s.hausdorff = max;
+        s.mean_surface = sum / static_cast<double>(ab.size() + ba.size());
+        s.hausdorff_95 = std::max(percentile(ab, 0.95), percentile(ba, 0.95));
+    }, 1);
+    return out;
+}
+
@@ -0,0 +1,59 @@
+//ROI_Similarity.h.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+template <class T> class contour_collection;
+
+
+// Similarity metrics for a pair of ROIs, estimated on a voxel grid.
+struct roi_similarity {
+    std::string ROIName_A;
+    std::string ROIName_B;
+
+    int64_t voxels_A = 0;
+    int64_t voxels_B = 0;
+    int64_t voxels_overlap = 0;
+    double voxel_volume = 0.0;       // In DICOM units; mm^3.
+
+    double dice = 0.0;               // NaN if both ROIs are empty.
+    double jaccard = 0.0;            // NaN if both ROIs are empty.
+
+    // Distances (in DICOM units; mm) between the surface voxels of each ROI, i.e., included voxels with an excluded
+    // face-adjacent neighbour. Voxels beyond the grid are considered excluded. All are NaN if either ROI is empty, or
+    // if surface distances were not requested.
+    double hausdorff = 0.0;          // Maximum over both directions.
+    double hausdorff_95 = 0.0;       // Maximum over both directions of the 95th percentile (nearest rank).
+    double mean_surface = 0.0;       // Mean over the surface voxels of both ROIs.
+};
+
+struct roi_similarity_options {
+    // Controls how contours are interpretted. Only the inclusivity, contour overlap, and mask modification options
+    // are honoured.
+    Mutate_Voxels_Opts mutation_opts;
+
+    // Whether to compute surface distances, which requires a distance transform per ROI.
+    bool surface_distances = true;
+};
+
+// Compares every ROI (keyed on ROIName) in the first set with every differently-named ROI in the second set. Each
+// unordered pair is reported once, ordered by ROIName when both ROIs appear in both sets.
+//
+// Every ROI is rasterized once onto the images, which must form a regular rectilinear grid, and packed into a bitset
+// so overlaps are computed with population counts. Surface distances are computed exactly (at the resolution of the
+// grid) with one Euclidean distance transform per ROI. Use a grid that covers all ROIs with a resolution at least as
+// fine as the contours to avoid truncation and discretization errors.
+std::vector<roi_similarity>
+Compute_ROI_Similarities(planar_image_collection<float,double> &imagecoll,
+                         const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl_A,
+                         const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl_B,
+                         const roi_similarity_options &opts);
+
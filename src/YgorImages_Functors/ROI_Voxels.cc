@@ -0,0 +1,253 @@
+//ROI_Voxels.cc.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Content_Hash.h"
+#include "../Structs.h"
+#include "../Thread_Pool.h"
+#include "Voxel_Inclusion_Mask.h"
+#include "ROI_Voxels.h"
+
+
+namespace {
+
+// Images with equal keys have identical voxel grids.
+using grid_key_t = std::array<double, 17>;
+
+grid_key_t make_grid_key(const planar_image<float,double> &img){
+    return {{ static_cast<double>(img.rows), static_cast<double>(img.columns), static_cast<double>(img.channels),
+              img.anchor.x, img.anchor.y, img.anchor.z,
+              img.offset.x, img.offset.y, img.offset.z,
+              img.row_unit.x, img.row_unit.y, img.row_unit.z,
+              img.col_unit.x, img.col_unit.y, img.col_unit.z,
+              img.pxl_dx, img.pxl_dy }};
+}
+
+} // namespace
+
+
+ROI_Voxels::ROI_Voxels(const planar_image_collection<float,double> &imagecoll, const ccsl_t &ccsl){
+    Mutate_Voxels_Opts opts;
+    opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
+    opts.aggregate      = Mutate_Voxels_Opts::Aggregate::First;
+    opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+    opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
+    opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+    opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
+
+    this->collection.reserve(imagecoll.images.size());
+    for(const auto &img : imagecoll.images) this->collection.push_back(&img);
+    const auto N_imgs = static_cast<long int>(this->collection.size());
+
+    // Rasterization dominates, so the images are rasterized concurrently.
+    std::vector<std::shared_ptr<const voxel_inclusion_mask>> masks(this->collection.size());
+    parallel_for(0, N_imgs, [&](long int i) -> void {
+        masks[i] = Get_Voxel_Inclusion_Mask(*(this->collection[i]), ccsl, opts);
+    }, /*grain=*/ 1);
+
+    std::map<grid_key_t, size_t> grid_of;
+    size_t N_voxels = 0;
+    size_t N_values = 0;
+    for(long int i = 0; i < N_imgs; ++i){
+        const auto N = static_cast<size_t>(masks[i]->count());
+        if(N == 0) continue;
+
+        const auto &img = *(this->collection[i]);
+        image_voxels iv;
+        iv.img = &img;
+        iv.mask = std::move(masks[i]);
+        iv.channels = img.channels;
+        iv.voxel_begin = N_voxels;
+        iv.voxel_end = N_voxels + N;
+        iv.value_begin = N_values;
+        iv.grid = grid_of.emplace(make_grid_key(img), grid_of.size()).first->second;
+        this->images.push_back(std::move(iv));
+
+        N_voxels += N;
+        N_values += N * static_cast<size_t>(img.channels);
+    }
+    this->grids = grid_of.size();
+
+    this->values.resize(N_values);
+    this->positions.resize(N_voxels);
+    parallel_for(0, static_cast<long int>(this->images.size()), [&](long int i) -> void {
+        const auto &iv = this->images[i];
+        const auto &img = *(iv.img);
+        const auto &mask = *(iv.mask);
+        auto v = iv.voxel_begin;
+        auto val = iv.value_begin;
+        for(long int row = 0; row < img.rows; ++row){
+            for(auto r = mask.row_offsets[row]; r < mask.row_offsets[row + 1]; ++r){
+                const auto run_end = static_cast<long int>(mask.runs[r][1]);
+                for(auto col = static_cast<long int>(mask.runs[r][0]); col < run_end; ++col){
+                    this->positions[v++] = img.position(row, col);
+                    for(long int chnl = 0; chnl < img.channels; ++chnl){
+                        this->values[val++] = static_cast<double>(img.value(row, col, chnl));
+                    }
+                }
+            }
+        }
+    }, /*grain=*/ 1);
+}
+
+const std::vector<ROI_Voxels::image_voxels> & ROI_Voxels::get_images() const {
+    return this->images;
+}
+
+size_t ROI_Voxels::get_grid_count() const {
+    return this->grids;
+}
+
+size_t ROI_Voxels::size() const {
+    return this->positions.size();
+}
+
+const std::vector<double> & ROI_Voxels::get_values() const {
+    return this->values;
+}
+
+const std::vector<vec3<double>> & ROI_Voxels::get_positions() const {
+    return this->positions;
+}
+
+std::vector<double> ROI_Voxels::get_combined_values() const {
+    std::vector<const image_voxels *> first_of(this->grids, nullptr);
+    std::vector<size_t> begin_of(this->grids, 0);
+    size_t N = 0;
+    for(const auto &iv : this->images){
+        if(first_of[iv.grid] != nullptr) continue;
+        first_of[iv.grid] = &iv;
+        begin_of[iv.grid] = N;
+        N += (iv.voxel_end - iv.voxel_begin) * static_cast<size_t>(iv.channels);
+    }
+
+    std::vector<double> out(N, 0.0);
+    for(const auto &iv : this->images){
+        const auto N_vals = (iv.voxel_end - iv.voxel_begin) * static_cast<size_t>(iv.channels);
+        const double *src = this->values.data() + iv.value_begin;
+        double *dest = out.data() + begin_of[iv.grid];
+        for(size_t k = 0; k < N_vals; ++k) dest[k] += src[k];
+    }
+    return out;
+}
+
+bool ROI_Voxels::is_current(const planar_image_collection<float,double> &imagecoll) const {
+    if(imagecoll.images.size() != this->collection.size()) return false;
+    auto c_it = std::begin(this->collection);
+    for(const auto &img : imagecoll.images){
+        if(&img != *(c_it++)) return false;
+    }
+    return true;
+}
+
+size_t ROI_Voxels::footprint() const {
+    return sizeof(*this)
+         + this->collection.capacity() * sizeof(const image_t *)
+         + this->images.capacity() * sizeof(image_voxels)
+         + this->values.capacity() * sizeof(double)
+         + this->positions.capacity() * sizeof(vec3<double>);
+}
+
+
+namespace {
+
+// (image content hash, contour hash).
+using roi_key_t = std::pair<uint64_t, uint64_t>;
+
+// A least-recently-used cache of extractions. Masks are owned by the extractions (and shared with the mask cache), so
+// they are not counted against this cache's budget.
+class roi_voxels_cache_t {
+  private:
+    static constexpr std::size_t max_footprint = 512UL * 1024UL * 1024UL; // bytes.
+
+    using entry_t = std::pair<roi_key_t, std::shared_ptr<const ROI_Voxels>>;
+
+    std::mutex m;
+    std::list<entry_t> lru; // Most-recently used at the front.
+    std::map<roi_key_t, std::list<entry_t>::iterator> index;
+    std::size_t footprint = 0;
+
+    void erase(std::map<roi_key_t, std::list<entry_t>::iterator>::iterator it){
+        this->footprint -= it->second->second->footprint();
+        this->lru.erase(it->second);
+        this->index.erase(it);
+    }
+
+  public:
+    std::shared_ptr<const ROI_Voxels> find(const roi_key_t &k, const planar_image_collection<float,double> &imagecoll){
+        std::lock_guard<std::mutex> lock(this->m);
+        const auto it = this->index.find(k);
+        if(it == std::end(this->index)) return nullptr;
+        if(!it->second->second->is_current(imagecoll)){
+            this->erase(it);
+            return nullptr;
+        }
+        this->lru.splice(std::begin(this->lru), this->lru, it->second);
+        return it->second->second;
+    }
+
+    std::shared_ptr<const ROI_Voxels> insert(const roi_key_t &k, const std::shared_ptr<const ROI_Voxels> &voxels){
+        std::lock_guard<std::mutex> lock(this->m);
+        const auto it = this->index.find(k);
+        if(it != std::end(this->index)) return it->second->second; // Another thread got there first.
+        this->lru.emplace_front(k, voxels);
+        this->index[k] = std::begin(this->lru);
+        this->footprint += voxels->footprint();
+
+        while( (max_footprint < this->footprint) && (1 < this->lru.size()) ){
+            this->erase(this->index.find(this->lru.back().first));
+        }
+        return voxels;
+    }
+
+    void clear(){
+        std::lock_guard<std::mutex> lock(this->m);
+        this->index.clear();
+        this->lru.clear();
+        this->footprint = 0;
+    }
+};
+
+roi_voxels_cache_t & roi_voxels_cache(){
+    static roi_voxels_cache_t cache;
+    return cache;
+}
+
+} // namespace
+
+
+std::shared_ptr<const ROI_Voxels>
+Get_ROI_Voxels(const Image_Array &ia, const ROI_Voxels::ccsl_t &ccsl){
+    content_hasher h;
+    for(const auto &cc_refw : ccsl) h.add(Content_Hash(cc_refw.get()));
+    const roi_key_t k(Content_Hash(ia.imagecoll), h.digest());
+
+    auto voxels = roi_voxels_cache().find(k, ia.imagecoll);
+    if(voxels == nullptr){
+        // Extract without holding the lock, so distinct ROIs can be extracted concurrently.
+        voxels = std::make_shared<const ROI_Voxels>(ia.imagecoll, ccsl);
+        voxels = roi_voxels_cache().insert(k, voxels);
+    }
+    return voxels;
+}
+
+void Clear_ROI_Voxels_Cache(){
+    roi_voxels_cache().clear();
+    return;
+}
+
@@ -0,0 +1,96 @@
+//ROI_Voxels.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Voxel_Inclusion_Mask.h"
+
+class Image_Array;
+template <class T> class contour_collection;
+
+
+// The voxels of an image collection that are bounded by a set of contours, with their values and positions stored in
+// flat buffers so per-ROI reports can be computed without revisiting the images.
+//
+// Voxels are bounded when their centres are bounded by the contours; overlapping contours are counted once. Voxels are
+// ordered by image (in collection order), then row, then column. Only images with at least one bounded voxel are
+// listed.
+//
+// The images are referred to by pointer, so the extraction is only valid while the collection is unmodified.
+class ROI_Voxels {
+  public:
+    using image_t = planar_image<float,double>;
+    using ccsl_t = std::list<std::reference_wrapper<contour_collection<double>>>;
+
+    struct image_voxels {
+        const image_t *img = nullptr;
+        std::shared_ptr<const voxel_inclusion_mask> mask;
+        int64_t channels = 0;
+        size_t voxel_begin = 0; // The image's voxels are [voxel_begin, voxel_end).
+        size_t voxel_end = 0;
+        size_t value_begin = 0; // Values of the image's voxels start here, with channels adjacent.
+
+        // Images sharing a grid have identical geometry (and thus identical masks), so their voxels correspond
+        // one-to-one in order.
+        size_t grid = 0;
+    };
+
+    ROI_Voxels(const planar_image_collection<float,double> &imagecoll, const ccsl_t &ccsl);
+
+    ROI_Voxels(const ROI_Voxels &) = delete;
+    ROI_Voxels & operator=(const ROI_Voxels &) = delete;
+
+    const std::vector<image_voxels> & get_images() const;
+    size_t get_grid_count() const;
+
+    // The number of bounded voxels, summed over all images.
+    size_t size() const;
+
+    // Every channel of every bounded voxel, voxel-major.
+    const std::vector<double> & get_values() const;
+
+    // The centre of every bounded voxel.
+    const std::vector<vec3<double>> & get_positions() const;
+
+    // The values of images sharing a grid summed voxel-wise (like AccumulatePixelDistributions), voxel-major and in
+    // order of each grid's first image.
+    std::vector<double> get_combined_values() const;
+
+    // Returns true if the collection still has the same images, in the same order, as when the voxels were extracted.
+    // In-place pixel edits are not detected.
+    bool is_current(const planar_image_collection<float,double> &imagecoll) const;
+
+    // Approximate memory footprint, in bytes.
+    size_t footprint() const;
+
+  private:
+    std::vector<const image_t *> collection; // In collection order.
+    std::vector<image_voxels> images;
+    size_t grids = 0;
+    std::vector<double> values;
+    std::vector<vec3<double>> positions;
+};
+
+
+// Returns the voxels of the array bounded by the contours.
+//
+// Extractions are cached process-wide, keyed on the content of the images and of the contours, so several reports over
+// the same ROIs share a single traversal of the voxels. Since operations alter pixel values in-place, the images are
+// hashed on every call, which is far cheaper than rasterizing the contours.
+// The cache is bounded in size, evicting the least-recently-used extractions first, and is safe to use from multiple
+// threads.
+std::shared_ptr<const ROI_Voxels>
+Get_ROI_Voxels(const Image_Array &ia, const ROI_Voxels::ccsl_t &ccsl);
+
+// Discards all cached extractions.
+void Clear_ROI_Voxels_Cache();
+
@@ -0,0 +1,186 @@
+//Rectilinear_Volume.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Thread_Pool.h"
+#include "Rectilinear_Volume.h"
+
+
+rectilinear_volume::rectilinear_volume(const std::list<std::reference_wrapper<planar_image<float,double>>> &imgs){
+    if(imgs.empty()){
+        throw std::invalid_argument("No images provided. Cannot create volume.");
+    }
+    if(!Images_Form_Rectilinear_Grid(imgs)){
+        throw std::invalid_argument("Images do not form a rectilinear grid. Cannot create volume.");
+    }
+    this->is_regular = Images_Form_Regular_Grid(imgs);
+
+    const auto &first = imgs.front().get();
+    this->images   = static_cast<long int>(imgs.size());
+    this->rows     = first.rows;
+    this->columns  = first.columns;
+    this->channels = first.channels;
+
+    this->column_stride = this->channels;
+    this->row_stride    = this->columns * this->column_stride;
+    this->image_stride  = this->rows * this->row_stride;
+
+    this->row_unit   = first.row_unit;
+    this->col_unit   = first.col_unit;
+    this->ortho_unit = first.row_unit.Cross(first.col_unit).unit();
+    this->pxl_dx     = first.pxl_dx;
+    this->pxl_dy     = first.pxl_dy;
+    this->pxl_dz     = first.pxl_dz;
+
+    this->image_origins.reserve(imgs.size());
+    this->sources.reserve(imgs.size());
+    for(const auto &img_refw : imgs){
+        const auto &src = img_refw.get();
+        if( (src.rows != this->rows)
+        ||  (src.columns != this->columns)
+        ||  (src.channels != this->channels) ){
+            throw std::invalid_argument("Images have differing dimensions. Cannot create volume.");
+        }
+        this->image_origins.emplace_back( src.position(0, 0) );
+        this->sources.emplace_back( img_refw );
+    }
+
+    // The buffer is not zero-filled; each image's pages are first touched by the thread that copies it.
+    this->data.resize( static_cast<size_t>(this->images * this->image_stride) );
+    parallel_for(0, this->images, [&](long int img){
+        const auto &src = this->sources[img].get();
+        float *dst = this->data.data() + img * this->image_stride;
+        for(long int row = 0; row < this->rows; ++row){
+            for(long int col = 0; col < this->columns; ++col){
+                for(long int chnl = 0; chnl < this->channels; ++chnl){
+                    *(dst++) = src.value(row, col, chnl);
+                }
+            }
+        }
+    }, 1);
+}
+
+rectilinear_volume::rectilinear_volume(long int n_images, long int n_rows, long int n_columns, long int n_channels,
+                                       const vec3<double> &origin,
+                                       const vec3<double> &r_unit,
+                                       const vec3<double> &c_unit,
+                                       double dx, double dy, double img_spacing){
+    if( (n_images <= 0) || (n_rows <= 0) || (n_columns <= 0) || (n_channels <= 0) ){
+        throw std::invalid_argument("Volume dimensions must be positive. Cannot create volume.");
+    }
+    if( !std::isfinite(dx) || !std::isfinite(dy) || !std::isfinite(img_spacing)
+    ||  (dx <= 0.0) || (dy <= 0.0) || (img_spacing == 0.0) ){
+        throw std::invalid_argument("Volume has invalid voxel spacing. Cannot create volume.");
+    }
+    this->is_regular = true;
+
+    this->images   = n_images;
+    this->rows     = n_rows;
+    this->columns  = n_columns;
+    this->channels = n_channels;
+
+    this->column_stride = this->channels;
+    this->row_stride    = this->columns * this->column_stride;
+    this->image_stride  = this->rows * this->row_stride;
+
+    this->row_unit   = r_unit.unit();
+    this->col_unit   = c_unit.unit();
+    this->ortho_unit = this->row_unit.Cross(this->col_unit).unit();
+    this->pxl_dx     = dx;
+    this->pxl_dy     = dy;
+    this->pxl_dz     = std::abs(img_spacing);
+
+    this->data.resize( static_cast<size_t>(this->images * this->image_stride) );
+    parallel_for(0, this->images, [&](long int img){
+        std::fill_n(this->data.data() + img * this->image_stride, this->image_stride, 0.0f);
+    }, 1);
+    this->image_origins.reserve(this->images);
+    for(long int img = 0; img < this->images; ++img){
+        this->image_origins.emplace_back( origin + this->ortho_unit * (img_spacing * static_cast<double>(img)) );
+    }
+}
+
+void rectilinear_volume::write_back() const {
+    if(this->sources.empty()) return;
+    for(long int img = 0; img < this->images; ++img){
+        auto &dst = this->sources[img].get();
+        const float *src = this->image_data(img);
+        for(long int row = 0; row < this->rows; ++row){
+            for(long int col = 0; col < this->columns; ++col){
+                for(long int chnl = 0; chnl < this->channels; ++chnl){
+                    dst.reference(row, col, chnl) = *(src++);
+                }
+            }
+        }
+    }
+    return;
+}
+
+double rectilinear_volume::image_spacing() const {
+    if(this->images < 2) return this->pxl_dz;
+    return (this->image_origins.back() - this->image_origins.front()).Dot(this->ortho_unit)
+         / static_cast<double>(this->images - 1);
+}
+
+float rectilinear_volume::interpolate(const vec3<double> &pos, long int chnl, float out_of_bounds) const {
+    const auto d = pos - this->image_origins.front();
+    const double f[3] = { d.Dot(this->row_unit) / this->pxl_dx,
+                          d.Dot(this->col_unit) / this->pxl_dy,
+                          d.Dot(this->ortho_unit) / this->image_spacing() };
+    const long int extent[3] = { this->rows, this->columns, this->images };
+    const long int stride[3] = { this->row_stride, this->column_stride, this->image_stride };
+
+    // Locate the lower corner of the surrounding cell, clamping within half a voxel of the boundary.
+    long int i0[3];
+    double w[3];
+    for(int a = 0; a < 3; ++a){
+        if( !(-0.5 <= f[a]) || !(f[a] <= (static_cast<double>(extent[a]) - 0.5)) ) return out_of_bounds;
+        const double fc = std::clamp(f[a], 0.0, static_cast<double>(extent[a] - 1));
+        i0[a] = std::min<long int>(static_cast<long int>(fc), std::max<long int>(extent[a] - 2, 0));
+        w[a] = fc - static_cast<double>(i0[a]);
+    }
+
+    const float *base = this->data.data() + i0[0] * stride[0] + i0[1] * stride[1] + i0[2] * stride[2] + chnl;
+    const long int s[3] = { (1 < extent[0]) ? stride[0] : 0,
+                            (1 < extent[1]) ? stride[1] : 0,
+                            (1 < extent[2]) ? stride[2] : 0 };
+    double acc = 0.0;
+    for(int c = 0; c < 8; ++c){
+        const int b0 = (c & 1), b1 = ((c >> 1) & 1), b2 = ((c >> 2) & 1);
+        const double wc = (b0 ? w[0] : 1.0 - w[0])
+                        * (b1 ? w[1] : 1.0 - w[1])
+                        * (b2 ? w[2] : 1.0 - w[2]);
+        if(wc == 0.0) continue;
+        acc += wc * static_cast<double>( base[ b0 * s[0] + b1 * s[1] + b2 * s[2] ] );
+    }
+    return static_cast<float>(acc);
+}
+
+
+rectilinear_volume
+pack_along_normal(planar_image_collection<float,double> &imagecoll,
+                  const vec3<double> &orientation_normal){
+    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+    for(auto &img : imagecoll.images) selected_imgs.push_back( std::ref(img) );
+    if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+        throw std::invalid_argument("Images do not form a rectilinear grid. Cannot continue");
+    }
+
+    planar_image_adjacency<float,double> img_adj( {}, { { std::ref(imagecoll) } }, orientation_normal );
+    std::list<std::reference_wrapper<planar_image<float,double>>> ordered_imgs;
+    for(long int i = 0; img_adj.index_present(i); ++i){
+        ordered_imgs.push_back( img_adj.index_to_image(i) );
+    }
+    if(ordered_imgs.size() != imagecoll.images.size()){
+        throw std::invalid_argument("Unable to order images along the normal. Cannot continue");
+    }
+    return rectilinear_volume(ordered_imgs);
+}
@@ -0,0 +1,116 @@
+//Rectilinear_Volume.h.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Thread_Pool.h"
+
+
+// A packed, contiguous copy of a rectilinear stack of images.
+//
+// planar_image_collection stores each image in an independent allocation, so volumetric routines must chase list nodes
+// and perform plane lookups to reach neighbouring voxels. This class packs a stack of images that share rows, columns,
+// channels, and orientation into a single aligned buffer with (image, row, column, channel) ordering, so 3D kernels
+// can address voxels with integer arithmetic and iterate linearly.
+//
+// The images are stacked in the order provided, which lets callers match an existing image adjacency ordering. The
+// packed buffer is a copy; modifications can be propagated back to the images with write_back().
+//
+// The buffer is initialized one image at a time in parallel, so on NUMA systems each image's pages are placed near
+// the threads that will likely process it (or are interleaved; see numa_placement).
+class rectilinear_volume {
+  public:
+    using buffer_t = std::vector<float, numa_allocator<float>>;
+
+    long int images   = 0;
+    long int rows     = 0;
+    long int columns  = 0;
+    long int channels = 0;
+
+    // Strides (in units of voxel values) for each index.
+    long int image_stride  = 0;
+    long int row_stride    = 0;
+    long int column_stride = 0;
+
+    // Geometry shared by all images.
+    vec3<double> row_unit;
+    vec3<double> col_unit;
+    vec3<double> ortho_unit; // row_unit x col_unit.
+    double pxl_dx = 0.0;     // Row spacing.
+    double pxl_dy = 0.0;     // Column spacing.
+    double pxl_dz = 0.0;     // Slice thickness, as reported by the images.
+
+    // The position of voxel (row=0, column=0) of each image, and whether the images are evenly spaced.
+    std::vector<vec3<double>> image_origins;
+    bool is_regular = false;
+
+    buffer_t data;
+
+    // Packs the provided images. Throws if the images do not form a rectilinear grid.
+    explicit rectilinear_volume(const std::list<std::reference_wrapper<planar_image<float,double>>> &imgs);
+
+    // Allocates a zero-filled, regular volume that is not backed by any images, e.g., for intermediate results. Images
+    // are stacked along row_unit x col_unit with the given (signed) spacing, starting at the origin.
+    rectilinear_volume(long int images, long int rows, long int columns, long int channels,
+                       const vec3<double> &origin,
+                       const vec3<double> &row_unit,
+                       const vec3<double> &col_unit,
+                       double pxl_dx, double pxl_dy, double img_spacing);
+
+    // Copies the packed voxel values back into the images that were packed. Has no effect for unbacked volumes.
+    void write_back() const;
+
+    // The signed distance between adjacent images along ortho_unit. Only meaningful for regular volumes.
+    double image_spacing() const;
+
+    // Trilinearly interpolates a channel at the given position. Positions more than half a voxel outside the volume
+    // produce the out-of-bounds value. Only meaningful for regular volumes.
+    float interpolate(const vec3<double> &pos, long int chnl, float out_of_bounds) const;
+
+    long int index(long int img, long int row, long int col, long int chnl) const {
+        return img * this->image_stride + row * this->row_stride + col * this->column_stride + chnl;
+    }
+
+    bool in_bounds(long int img, long int row, long int col) const {
+        return (0 <= img) && (img < this->images)
+            && (0 <= row) && (row < this->rows)
+            && (0 <= col) && (col < this->columns);
+    }
+
+    float value(long int img, long int row, long int col, long int chnl) const {
+        return this->data[ this->index(img, row, col, chnl) ];
+    }
+
+    float & reference(long int img, long int row, long int col, long int chnl){
+        return this->data[ this->index(img, row, col, chnl) ];
+    }
+
+    // The voxel values of a single image, which are contiguous.
+    const float * image_data(long int img) const {
+        return this->data.data() + img * this->image_stride;
+    }
+
+    vec3<double> position(long int img, long int row, long int col) const {
+        return this->image_origins[img]
+             + this->row_unit * (this->pxl_dx * static_cast<double>(row))
+             + this->col_unit * (this->pxl_dy * static_cast<double>(col));
+    }
+
+  private:
+    std::vector<std::reference_wrapper<planar_image<float,double>>> sources;
+};
+
+
+// Orders the images of a collection along the given normal and packs them. Throws if the images do not form a
+// rectilinear grid.
+rectilinear_volume
+pack_along_normal(planar_image_collection<float,double> &imagecoll,
+                  const vec3<double> &orientation_normal);
+
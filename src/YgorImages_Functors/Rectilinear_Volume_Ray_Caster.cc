@@ -0,0 +1,81 @@
+//Rectilinear_Volume_Ray_Caster.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "YgorMath.h"
+
+#include "Rectilinear_Volume.h"
+#include "Rectilinear_Volume_Ray_Caster.h"
+
+
+rectilinear_volume_ray_caster::rectilinear_volume_ray_caster(const rectilinear_volume &v, long int chnl)
+    : vol(&v), channel(chnl) {
+
+    if((this->channel < 0) || (v.channels <= this->channel)){
+        throw std::invalid_argument("Channel is not present in volume. Cannot create ray caster.");
+    }
+    if(!v.is_regular){
+        throw std::invalid_argument("Volume is not regular. Cannot create ray caster.");
+    }
+
+    // Slices may be stacked in either direction along the normal, so the spacing is signed.
+    double img_spacing = v.pxl_dz;
+    if(1 < v.images){
+        img_spacing = (v.image_origins.back() - v.image_origins.front()).Dot(v.ortho_unit)
+                    / static_cast<double>(v.images - 1);
+    }
+    if( !std::isfinite(v.pxl_dx) || !std::isfinite(v.pxl_dy) || !std::isfinite(img_spacing)
+    ||  (v.pxl_dx <= 0.0) || (v.pxl_dy <= 0.0) || (img_spacing == 0.0) ){
+        throw std::invalid_argument("Volume has invalid voxel spacing. Cannot create ray caster.");
+    }
+
+    this->space.origin = v.image_origins.front();
+    this->space.axes[0] = v.row_unit / v.pxl_dx;
+    this->space.axes[1] = v.col_unit / v.pxl_dy;
+    this->space.axes[2] = v.ortho_unit / img_spacing;
+
+    this->space.extent[0] = v.rows;
+    this->space.extent[1] = v.columns;
+    this->space.extent[2] = v.images;
+
+    this->space.stride[0] = v.row_stride;
+    this->space.stride[1] = v.column_stride;
+    this->space.stride[2] = v.image_stride;
+}
+
+
+void rectilinear_volume_ray_caster::clip(const vec3<double> &source,
+                                         const vec3<double> *ends,
+                                         long int N,
+                                         segment_t *out) const {
+
+    // Axis-aligned directions are nudged so that the slab computation remains finite and branch-free.
+    constexpr double tiny = 1.0E-200;
+
+    const auto ds = source - this->space.origin;
+    const double s[3] = { ds.Dot(this->space.axes[0]), ds.Dot(this->space.axes[1]), ds.Dot(this->space.axes[2]) };
+
+    for(long int i = 0; i < N; ++i){
+        auto &seg = out[i];
+        const auto de = ends[i] - this->space.origin;
+        seg.length = ends[i].distance(source);
+        seg.t_enter = 0.0;
+        seg.t_exit = 1.0;
+        for(int a = 0; a < 3; ++a){
+            double d = de.Dot(this->space.axes[a]) - s[a];
+            d = (std::abs(d) < tiny) ? std::copysign(tiny, d) : d;
+            const double inv = 1.0 / d;
+            const double t0 = (-0.5 - s[a]) * inv;
+            const double t1 = (static_cast<double>(this->space.extent[a]) - 0.5 - s[a]) * inv;
+
+            seg.g0[a] = s[a];
+            seg.d[a] = d;
+            seg.t_enter = std::max(seg.t_enter, std::min(t0, t1));
+            seg.t_exit  = std::min(seg.t_exit,  std::max(t0, t1));
+        }
+    }
+    return;
+}
+
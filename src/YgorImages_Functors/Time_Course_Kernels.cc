@@ -0,0 +1,314 @@
+//Time_Course_Kernels.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorImages.h"
+
+#include "../Content_Hash.h"
+#include "../Thread_Pool.h"
+#include "Time_Course_Kernels.h"
+
+
+namespace time_course_kernels {
+
+namespace {
+
+// Voxels are processed in blocks so per-voxel accumulators stay in L1 and each block is a single parallel task.
+constexpr size_t block_size = 1024;
+
+// Only a few slices are ever in flight, so only a few results are retained.
+constexpr size_t max_cached_vfa_maps = 16;
+
+template <class F>
+void for_each_block(size_t N, F f){
+    const auto N_blocks = static_cast<long int>((N + block_size - 1) / block_size);
+    parallel_for(0, N_blocks, [&](long int b) -> void {
+        const auto begin = static_cast<size_t>(b) * block_size;
+        const auto end = std::min(N, begin + block_size);
+        f(begin, end);
+    }, /*grain=*/ 1);
+}
+
+void check_parameter_count(const packed_time_courses &p, size_t N){
+    if(p.N_t != N){
+        throw std::invalid_argument("Number of parameters does not match the number of packed images");
+    }
+}
+
+struct vfa_cache_entry_t {
+    uint64_t key;
+    std::shared_ptr<const vfa_maps> maps;
+};
+
+std::mutex vfa_cache_mutex;
+std::list<vfa_cache_entry_t> vfa_cache; // Ordered from most to least recently used.
+
+} // namespace
+
+
+packed_time_courses pack(const std::vector<const planar_image<float,double> *> &imgs){
+    packed_time_courses p;
+    if(imgs.empty()) return p;
+
+    p.rows     = imgs.front()->rows;
+    p.columns  = imgs.front()->columns;
+    p.channels = imgs.front()->channels;
+    p.N_voxels = static_cast<size_t>(p.rows * p.columns * p.channels);
+    p.N_t      = imgs.size();
+    for(const auto &img : imgs){
+        if( (img->rows != p.rows) || (img->columns != p.columns) || (img->channels != p.channels) ){
+            throw std::invalid_argument("Images have differing dimensions and cannot be packed");
+        }
+    }
+
+    p.data.resize(p.N_voxels * p.N_t);
+    parallel_for(0, static_cast<long int>(p.N_t), [&](long int t) -> void {
+        std::copy(std::begin(imgs[t]->data), std::end(imgs[t]->data), p.course(static_cast<size_t>(t)));
+    }, /*grain=*/ 1);
+    return p;
+}
+
+void box_mean(packed_time_courses &p, long int radius){
+    if(radius <= 0) return;
+    const auto R = p.rows;
+    const auto C = p.columns;
+    const auto H = p.channels;
+
+    parallel_for(0, static_cast<long int>(p.N_t), [&](long int t) -> void {
+        float *plane = p.course(static_cast<size_t>(t));
+
+        // Separable running sums: along rows first, then along columns. Voxel counts are tracked separately so the
+        // image edges are handled the same way as the interior.
+        std::vector<double> row_sums(p.N_voxels, 0.0);
+        std::vector<double> col_sums(p.N_voxels, 0.0);
+        for(long int row = 0; row < R; ++row){
+            for(long int col = 0; col < C; ++col){
+                const auto c_lo = std::max<long int>(0, col - radius);
+                const auto c_hi = std::min<long int>(C - 1, col + radius);
+                for(long int chan = 0; chan < H; ++chan){
+                    double s = 0.0;
+                    for(auto c = c_lo; c <= c_hi; ++c) s += plane[(row * C + c) * H + chan];
+                    row_sums[(row * C + col) * H + chan] = s;
+                }
+            }
+        }
+        for(long int row = 0; row < R; ++row){
+            const auto r_lo = std::max<long int>(0, row - radius);
+            const auto r_hi = std::min<long int>(R - 1, row + radius);
+            for(long int col = 0; col < C; ++col){
+                const auto c_lo = std::max<long int>(0, col - radius);
+                const auto c_hi = std::min<long int>(C - 1, col + radius);
+                const auto count = static_cast<double>((r_hi - r_lo + 1) * (c_hi - c_lo + 1));
+                for(long int chan = 0; chan < H; ++chan){
+                    double s = 0.0;
+                    for(auto r = r_lo; r <= r_hi; ++r) s += row_sums[(r * C + col) * H + chan];
+                    col_sums[(row * C + col) * H + chan] = s / count;
+                }
+            }
+        }
+        std::copy(std::begin(col_sums), std::end(col_sums), plane);
+    }, /*grain=*/ 1);
+}
+
+
+void variable_flip_angle(const packed_time_courses &p,
+                         const std::vector<double> &sinFA,
+                         const std::vector<double> &cosFA,
+                         double RepTime,
+                         float *T1_out,
+                         float *S0_out){
+    const auto N = p.N_t;
+    check_parameter_count(p, sinFA.size());
+    check_parameter_count(p, cosFA.size());
+    if(N < 2){
+        throw std::invalid_argument("Two or more flip angles are needed to estimate T1");
+    }
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+    for_each_block(p.N_voxels, [&](size_t begin, size_t end) -> void {
+        const auto L = end - begin;
+        double k[block_size];
+        double S0[block_size];
+
+        if(N == 2){
+            // This solution solves the unbounded least-squares problem exactly for two datum:
+            // --> minimize the sum_i of (S_i - S0*(1-k)*sin(FA_i)/(1-k*cos(FA_i)))^2 via [S0,k]
+            // [where k = exp(-TR/T1)] resulting in a tidy analytic solution.
+            //
+            // No change of variables is performed; an action that can potentially bias the result
+            // giving the datum unequal or inappropriate implicit weighting.
+            const float *S_0 = p.course(0) + begin;
+            const float *S_1 = p.course(1) + begin;
+            for(size_t i = 0; i < L; ++i){
+                const double a = S_0[i];
+                const double b = S_1[i];
+                const auto knumer = a*sinFA[1] - b*sinFA[0];
+                const auto kdenom = a*sinFA[1]*cosFA[0] - b*sinFA[0]*cosFA[1];
+                const auto l_k = knumer/kdenom;
+
+                const auto decayL = ((1.0-l_k)*sinFA[0])/(1.0-l_k*cosFA[0]);
+                const auto decayR = ((1.0-l_k)*sinFA[1])/(1.0-l_k*cosFA[1]);
+                k[i] = l_k;
+                S0[i] = (a*decayL + b*decayR)/(decayL*decayL + decayR*decayR);
+            }
+
+        }else{
+            // This solution alters the unbounded least-squares problem by linearizing the objective function.
+            // Measurements become pairs (x_i, y_i) == (S_i*cos(FA_i)/sin(FA_i), S_i/sin(FA_i)) and the model
+            // becomes y = k*x + S0*(1-k). This is tractable for any N>=2, but the change of variables weights the
+            // measurements unequally, so in the face of noise the result is biased.
+            double Sx[block_size];
+            double Sy[block_size];
+            double Sxx[block_size];
+            double Syx[block_size];
+            std::fill(Sx, Sx + L, 0.0);
+            std::fill(Sy, Sy + L, 0.0);
+            std::fill(Sxx, Sxx + L, 0.0);
+            std::fill(Syx, Syx + L, 0.0);
+            for(size_t t = 0; t < N; ++t){
+                const float *S = p.course(t) + begin;
+                const auto cot = cosFA[t]/sinFA[t];
+                const auto csc = 1.0/sinFA[t];
+                for(size_t i = 0; i < L; ++i){
+                    const auto x = S[i] * cot;
+                    const auto y = S[i] * csc;
+                    Sx[i] += x;
+                    Sy[i] += y;
+                    Sxx[i] += x*x;
+                    Syx[i] += y*x;
+                }
+            }
+            const auto dN = static_cast<double>(N);
+            for(size_t i = 0; i < L; ++i){
+                const auto m = (Syx[i] - Sx[i]*Sy[i]/dN)/(Sxx[i] - Sx[i]*Sx[i]/dN);
+                const auto b = (Sy[i] - m*Sx[i])/dN;
+                k[i] = m;
+                S0[i] = b/(1.0 - m);
+            }
+        }
+
+        for(size_t i = 0; i < L; ++i){
+            const auto T1 = -RepTime / std::log(k[i]);
+            const bool ok = std::isfinite(T1) && std::isfinite(S0[i]);
+            T1_out[begin + i] = static_cast<float>(ok ? T1 : nan);
+            S0_out[begin + i] = static_cast<float>(ok ? S0[i] : nan);
+        }
+    });
+}
+
+std::shared_ptr<const vfa_maps>
+variable_flip_angle(const std::vector<const planar_image<float,double> *> &imgs,
+                    const std::vector<double> &sinFA,
+                    const std::vector<double> &cosFA,
+                    double RepTime){
+    content_hasher H;
+    H.add(static_cast<uint64_t>(imgs.size()));
+    for(const auto &img : imgs) H.add(Content_Hash(*img));
+    for(const auto &x : sinFA) H.add(x);
+    for(const auto &x : cosFA) H.add(x);
+    H.add(RepTime);
+    const auto key = H.digest();
+    {
+        std::lock_guard<std::mutex> lock(vfa_cache_mutex);
+        for(auto it = std::begin(vfa_cache); it != std::end(vfa_cache); ++it){
+            if(it->key == key){
+                vfa_cache.splice(std::begin(vfa_cache), vfa_cache, it);
+                return vfa_cache.front().maps;
+            }
+        }
+    }
+
+    const auto p = pack(imgs);
+    auto maps = std::make_shared<vfa_maps>();
+    maps->T1.resize(p.N_voxels);
+    maps->S0.resize(p.N_voxels);
+    variable_flip_angle(p, sinFA, cosFA, RepTime, maps->T1.data(), maps->S0.data());
+
+    std::lock_guard<std::mutex> lock(vfa_cache_mutex);
+    vfa_cache.push_front({ key, maps });
+    while(max_cached_vfa_maps < vfa_cache.size()) vfa_cache.pop_back();
+    return maps;
+}
+
+
+void contrast_concentration(const float *S,
+                            const float *S0,
+                            const float *T1,
+                            size_t N,
+                            double sinFA,
+                            double cosFA,
+                            double RepTime,
+                            float *C_out){
+    const auto RepTime_s = RepTime * (1E-3);
+    for_each_block(N, [&](size_t begin, size_t end) -> void {
+        for(size_t i = begin; i < end; ++i){
+            const double Sval  = S[i];
+            const double S0val = S0[i];
+            const double T1val = T1[i];
+
+            const auto numer = Sval*cosFA - S0val*sinFA;
+            const auto denom = Sval       - S0val*sinFA;
+            const auto T1prime = RepTime_s / std::log(numer / denom);
+
+            C_out[i] = static_cast<float>( (1.0/0.0045)*((1.0/T1prime) - (1.0/T1val)) );
+        }
+    });
+}
+
+
+void log_linear_slope(const packed_time_courses &p,
+                      const std::vector<double> &x,
+                      float *slope_out){
+    const auto N = p.N_t;
+    check_parameter_count(p, x.size());
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+    // The abscissae are shared by all voxels, so their sums are computed once.
+    double Sx = 0.0;
+    double Sxx = 0.0;
+    for(const auto &l_x : x){
+        Sx += l_x;
+        Sxx += l_x * l_x;
+    }
+    const auto dN = static_cast<double>(N);
+    const auto denom = dN * Sxx - Sx * Sx;
+    if( (N < 2) || !(0.0 < std::abs(denom)) ){
+        std::fill(slope_out, slope_out + p.N_voxels, static_cast<float>(nan));
+        return;
+    }
+
+    for_each_block(p.N_voxels, [&](size_t begin, size_t end) -> void {
+        const auto L = end - begin;
+        double Sy[block_size];
+        double Sxy[block_size];
+        std::fill(Sy, Sy + L, 0.0);
+        std::fill(Sxy, Sxy + L, 0.0);
+        for(size_t t = 0; t < N; ++t){
+            const float *S = p.course(t) + begin;
+            const auto l_x = x[t];
+            for(size_t i = 0; i < L; ++i){
+                // Non-positive signals produce non-finite logarithms, which propagate to the slope.
+                const auto y = std::log(static_cast<double>(S[i]));
+                Sy[i] += y;
+                Sxy[i] += l_x * y;
+            }
+        }
+        for(size_t i = 0; i < L; ++i){
+            const auto m = (dN * Sxy[i] - Sx * Sy[i]) / denom;
+            slope_out[begin + i] = static_cast<float>(std::isfinite(m) ? m : nan);
+        }
+    });
+}
+
+} // namespace time_course_kernels
+
@@ -0,0 +1,88 @@
+//Time_Course_Kernels.h.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "YgorImages.h"
+
+
+// Vectorized per-voxel models for co-registered image series (e.g., DCE-MRI flip angle series or IVIM b-value
+// series).
+//
+// The images are packed once into a contiguous buffer, and each model is then evaluated as a tight loop over voxels
+// with no per-voxel allocation or image lookups, which compilers readily vectorize. Voxels are evaluated
+// independently, so the buffer is planar (i.e., all voxels for one image, then all voxels for the next) such that
+// consecutive SIMD lanes handle consecutive voxels.
+//
+// Voxel indices match planar_image::index(row, column, channel), so kernel outputs can be written directly into an
+// image with the same geometry.
+namespace time_course_kernels {
+
+struct packed_time_courses {
+    long int rows = 0;
+    long int columns = 0;
+    long int channels = 0;
+    size_t N_voxels = 0;
+    size_t N_t = 0;          // Number of images (time points, flip angles, b-values, etc.).
+    std::vector<float> data; // Packed with (image, voxel) ordering.
+
+    const float * course(size_t t) const {
+        return this->data.data() + t * this->N_voxels;
+    }
+    float * course(size_t t){
+        return this->data.data() + t * this->N_voxels;
+    }
+};
+
+// Packs the images, which must all share the same rows, columns, and channels. Throws otherwise.
+packed_time_courses pack(const std::vector<const planar_image<float,double> *> &imgs);
+
+// Replaces each voxel with the mean over the in-plane (2*radius+1)^2 box centred on it, considering only voxels
+// within the image.
+void box_mean(packed_time_courses &p, long int radius);
+
+
+// Variable flip angle (VFA) T1 and S0 estimation for a spoiled gradient echo signal model. With two flip angles, the
+// exact solution is used; with more, the linearized (DESPOT1) least-squares solution is used. Voxels for which
+// either T1 or S0 is not finite are set to NaN in both outputs. T1 has the same units as RepTime.
+void variable_flip_angle(const packed_time_courses &p,
+                         const std::vector<double> &sinFA,
+                         const std::vector<double> &cosFA,
+                         double RepTime,
+                         float *T1_out,
+                         float *S0_out);
+
+// Memoized variant of the above. Results are keyed by the image contents and the parameters, so repeated requests
+// for the same slice (e.g., producing a T1 map and then an S0 map) share a single packing and fit. Thread-safe.
+struct vfa_maps {
+    std::vector<float> T1;
+    std::vector<float> S0;
+};
+std::shared_ptr<const vfa_maps>
+variable_flip_angle(const std::vector<const planar_image<float,double> *> &imgs,
+                    const std::vector<double> &sinFA,
+                    const std::vector<double> &cosFA,
+                    double RepTime);
+
+// Contrast agent concentration from the signal, a pre-contrast S0 map, and a T1 map (in seconds). RepTime is in
+// msec. Relaxivity is 4.5 /(mM*s).
+void contrast_concentration(const float *S,
+                            const float *S0,
+                            const float *T1,
+                            size_t N,
+                            double sinFA,
+                            double cosFA,
+                            double RepTime,
+                            float *C_out);
+
+// Least-squares slope of ln(signal) against x for each voxel. Voxels with any non-positive signal, or lacking at least
+// two distinct x, are set to NaN.
+void log_linear_slope(const packed_time_courses &p,
+                      const std::vector<double> &x,
+                      float *slope_out);
+
+} // namespace time_course_kernels
+
@@ -9,6 +9,7 @@
 #include <memory>
 
 #include "../ConvenienceRoutines.h"
+#include "../Time_Course_Kernels.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
 #include "YgorMisc.h"
@@ -58,64 +59,26 @@ bool DCEMRICMap(planar_image_collection<float,double>::images_list_it_t  local_i
     const auto sinFA = std::sin(FlipAngle*pi/180.0);
     const auto cosFA = std::cos(FlipAngle*pi/180.0);
 
+    const auto N = local_img_it->data.size();
+    if( (S0_img_it->data.size() != N) || (T1_img_it->data.size() != N) ){
+        FUNCWARN("S0 and T1 maps do not have the same dimensions as the image being transformed. Cannot continue");
+        return false;
+    }
+    time_course_kernels::contrast_concentration(local_img_it->data.data(),
+                                                S0_img_it->data.data(),
+                                                T1_img_it->data.data(),
+                                                N, sinFA, cosFA, RepTime,
+                                                local_img_it->data.data());
+
     //Record the min and max actual pixel values for windowing purposes.
     Stats::Running_MinMax<float> minmax_pixel;
-
-    //Loop over the rows, columns, and channels.
-    for(auto row = 0; row < local_img_it->rows; ++row){
-        for(auto col = 0; col < local_img_it->columns; ++col){
-            for(auto chan = 0; chan < local_img_it->channels; ++chan){
-
-                auto Sval  = static_cast<double>( local_img_it->value(row, col, chan) );
-                auto S0val = static_cast<double>( S0_img_it->value(row, col, chan) );
-                auto T1val = static_cast<double>( T1_img_it->value(row, col, chan) );
-
-                const auto numer = Sval*cosFA - S0val*sinFA;
-                const auto denom = Sval       - S0val*sinFA;
-                const auto T1prime = (RepTime * (1E-3)) / std::log(numer / denom);
-
-                const double C = (1.0/0.0045)*((1.0/T1prime) - (1.0/T1val));
-                const auto C_f = static_cast<float>(C);
-
-                if( std::isfinite(C_f) 
-//                &&  std::isnormal(C_f) 
-//                &&  (C_f >= 0) 
-//                &&  std::isfinite(S0val) 
-//                &&  std::isnormal(S0val) 
-//                &&  std::isfinite(T1val) 
-//                &&  std::isnormal(T1val) ){
-                            ){
-//                &&  (T1val > 10.0)
-//                &&  (Sval > 10.0)
-//                &&  (S0val > 10.0) ){
-                    //Update the value.
-                    const auto newval = C_f;
-                    local_img_it->reference(row, col, chan) = newval;
-                    if(isininc(-0.5,C_f,20.0)){
-                        minmax_pixel.Digest(newval);
-                    }
-                }else{
-                    local_img_it->reference(row, col, chan) = std::numeric_limits<float>::quiet_NaN();
-                }
-/*
-FUNCERR("Need to double check that you can delete the extra 1000.0x scaling factor in this C computation!");
-                double C = 1000.0*(1.0/0.0045)*((1.0/T1prime) - (1.0/T1val));
-                //double C = (1.0/4.5)*((1.0/T1prime) - (1.0/T1val));
-
-                //Handle errors in reconstruction due to missing tissues (air), uncertainty, 
-                // numerical instabilities, etc..
-                if( (S0val < 10.0) || (T1val < 10.0)    || (Sval < 10.0)
-                                   || (C < 1.0)         || (C > 1500.0)
-                                   || !std::isfinite(C) || !std::isnormal(C) ){
-                    C = 0.0;
-                }
-
-                //Update the value.
-                const auto newval = static_cast<float>(C);
-                local_img_it->reference(row, col, chan) = newval;
-                minmax_pixel.Digest(newval);
-*/
+    for(auto &C_f : local_img_it->data){
+        if(std::isfinite(C_f)){
+            if(isininc(-0.5,C_f,20.0)){
+                minmax_pixel.Digest(C_f);
             }
+        }else{
+            C_f = std::numeric_limits<float>::quiet_NaN();
         }
     }
 
@@ -0,0 +1,657 @@
+//Volume_Convolution.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+#include "../Thread_Pool.h"
+#include "Rectilinear_Volume.h"
+#include "Volume_Convolution.h"
+
+
+namespace volume_convolution {
+
+namespace {
+
+using cplx = std::complex<double>;
+
+// Renormalized outputs are discarded when the accessible weight falls below this fraction of the total weight.
+constexpr double min_accessible_weight = 1.0E-3;
+
+// Gaussians wider than this (in voxels) are blurred recursively when the method is selected automatically.
+constexpr double recursive_sigma_threshold = 4.0;
+
+// The geometry of a single channel of a volume, indexed by axis (0 = row, 1 = column, 2 = image).
+struct layout_t {
+    long int extent[3];
+    long int stride[3];
+    long int channel;
+
+    layout_t(const rectilinear_volume &vol, long int chnl){
+        if((chnl < 0) || (vol.channels <= chnl)){
+            throw std::invalid_argument("Channel is not present in volume. Cannot convolve.");
+        }
+        this->extent[0] = vol.rows;
+        this->extent[1] = vol.columns;
+        this->extent[2] = vol.images;
+        this->stride[0] = vol.row_stride;
+        this->stride[1] = vol.column_stride;
+        this->stride[2] = vol.image_stride;
+        this->channel = chnl;
+    }
+
+    long int voxels() const {
+        return this->extent[0] * this->extent[1] * this->extent[2];
+    }
+
+    long int offset(long int row, long int col, long int img) const {
+        return this->channel + row * this->stride[0] + col * this->stride[1] + img * this->stride[2];
+    }
+};
+
+// Invokes f(start, stride, length) for every line of voxels along the given axis, in parallel.
+template <class F>
+void for_each_line(const layout_t &L, long int axis, F &&f){
+    const long int b = (axis + 1) % 3;
+    const long int c = (axis + 2) % 3;
+    const long int N_lines = L.extent[b] * L.extent[c];
+    parallel_for(0, N_lines, [&](long int i) -> void {
+        const long int ib = i % L.extent[b];
+        const long int ic = i / L.extent[b];
+        f(L.channel + ib * L.stride[b] + ic * L.stride[c], L.stride[axis], L.extent[axis]);
+    });
+    return;
+}
+
+bool is_power_of_two(long int n){
+    return (0 < n) && ((n & (n - 1)) == 0);
+}
+
+long int next_power_of_two(long int n){
+    long int p = 1;
+    while(p < n) p *= 2;
+    return p;
+}
+
+// In-place iterative radix-2 FFT of a contiguous sequence. The inverse transform is not normalized.
+void fft_1d(cplx *a, long int n, bool inverse){
+    if(!is_power_of_two(n)) throw std::logic_error("FFT length must be a power of two.");
+
+    for(long int i = 1, j = 0; i < n; ++i){
+        long int bit = n >> 1;
+        for( ; (j & bit) != 0; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if(i < j) std::swap(a[i], a[j]);
+    }
+
+    const double pi = std::acos(-1.0);
+    for(long int len = 2; len <= n; len <<= 1){
+        const double ang = 2.0 * pi / static_cast<double>(len) * (inverse ? 1.0 : -1.0);
+        const cplx w_len(std::cos(ang), std::sin(ang));
+        for(long int i = 0; i < n; i += len){
+            cplx w(1.0, 0.0);
+            for(long int j = 0; j < len / 2; ++j){
+                const cplx u = a[i + j];
+                const cplx v = a[i + j + len / 2] * w;
+                a[i + j] = u + v;
+                a[i + j + len / 2] = u - v;
+                w *= w_len;
+            }
+        }
+    }
+    return;
+}
+
+// In-place 3D FFT of a buffer with dimensions P[0] x P[1] x P[2], packed with axis 0 varying fastest.
+void fft_3d(std::vector<cplx> &buf, const std::array<long int, 3> &P, bool inverse, std::vector<cplx> &line){
+    const long int strides[3] = { 1, P[0], P[0] * P[1] };
+    for(long int axis = 0; axis < 3; ++axis){
+        const long int n = P[axis];
+        if(n == 1) continue;
+        line.resize(n);
+        const long int b = (axis + 1) % 3;
+        const long int c = (axis + 2) % 3;
+        for(long int ic = 0; ic < P[c]; ++ic){
+            for(long int ib = 0; ib < P[b]; ++ib){
+                cplx *base = buf.data() + ib * strides[b] + ic * strides[c];
+                for(long int i = 0; i < n; ++i) line[i] = base[i * strides[axis]];
+                fft_1d(line.data(), n, inverse);
+                for(long int i = 0; i < n; ++i) base[i * strides[axis]] = line[i];
+            }
+        }
+    }
+    return;
+}
+
+// Copies a channel out of the volume as doubles, packed with axis 0 varying fastest.
+std::vector<double> extract(const rectilinear_volume &vol, const layout_t &L){
+    std::vector<double> out(L.voxels());
+    parallel_for(0, L.extent[2], [&](long int img) -> void {
+        for(long int col = 0; col < L.extent[1]; ++col){
+            for(long int row = 0; row < L.extent[0]; ++row){
+                out[(img * L.extent[1] + col) * L.extent[0] + row] = vol.data[L.offset(row, col, img)];
+            }
+        }
+    });
+    return out;
+}
+
+// Sums a packed (axis 0 fastest) indicator over a sliding window [x - centre, x - centre + k) along one axis.
+void box_sum(std::vector<double> &v, const long int ext[3], long int axis, long int k, long int centre){
+    const long int strides[3] = { 1, ext[0], ext[0] * ext[1] };
+    const long int b = (axis + 1) % 3;
+    const long int c = (axis + 2) % 3;
+    const long int n = ext[axis];
+    parallel_for(0, ext[b] * ext[c], [&](long int i) -> void {
+        const long int base = (i % ext[b]) * strides[b] + (i / ext[b]) * strides[c];
+        std::vector<double> prefix(n + 1, 0.0);
+        for(long int x = 0; x < n; ++x) prefix[x + 1] = prefix[x] + v[base + x * strides[axis]];
+        for(long int x = 0; x < n; ++x){
+            const long int lo = std::clamp<long int>(x - centre, 0, n);
+            const long int hi = std::clamp<long int>(x - centre + k, 0, n);
+            v[base + x * strides[axis]] = prefix[hi] - prefix[lo];
+        }
+    });
+    return;
+}
+
+void apply_direct(rectilinear_volume &vol, const layout_t &L, const kernel_t &k, boundary_t boundary){
+    const auto in = extract(vol, L);
+    const double w_total = std::accumulate(std::begin(k.weights), std::end(k.weights), 0.0,
+                                           [](double acc, double w) -> double { return acc + std::abs(w); });
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+    parallel_for(0, L.extent[2] * L.extent[1], [&](long int i) -> void {
+        const long int img = i / L.extent[1];
+        const long int col = i % L.extent[1];
+        for(long int row = 0; row < L.extent[0]; ++row){
+            double f = 0.0;
+            double w_sum = 0.0;
+            bool invalid = false;
+            for(long int kz = 0; (kz < k.extent[2]) && !invalid; ++kz){
+                const long int z = img + kz - k.centre[2];
+                for(long int ky = 0; (ky < k.extent[1]) && !invalid; ++ky){
+                    const long int y = col + ky - k.centre[1];
+                    for(long int kx = 0; kx < k.extent[0]; ++kx){
+                        const long int x = row + kx - k.centre[0];
+                        const bool inside = (0 <= x) && (x < L.extent[0])
+                                         && (0 <= y) && (y < L.extent[1])
+                                         && (0 <= z) && (z < L.extent[2]);
+                        const double v = inside ? in[(z * L.extent[1] + y) * L.extent[0] + x] : nan;
+                        if(!std::isfinite(v)){
+                            if(boundary == boundary_t::Propagate){
+                                invalid = true;
+                                break;
+                            }
+                            continue;
+                        }
+                        const double w = k.at(kx, ky, kz);
+                        f += w * v;
+                        w_sum += w;
+                    }
+                }
+            }
+
+            double out = f;
+            if(invalid){
+                out = nan;
+            }else if(boundary == boundary_t::Renormalize){
+                out = (std::abs(w_sum) < min_accessible_weight * w_total) ? nan : f / w_sum;
+            }
+            vol.data[L.offset(row, col, img)] = static_cast<float>(out);
+        }
+    });
+    return;
+}
+
+void apply_fft(rectilinear_volume &vol, const layout_t &L, const kernel_t &k, boundary_t boundary){
+    const auto in = extract(vol, L);
+    const double w_total = std::accumulate(std::begin(k.weights), std::end(k.weights), 0.0,
+                                           [](double acc, double w) -> double { return acc + std::abs(w); });
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+    // Select tile dimensions. Each tile produces (P - k + 1) outputs along each axis (overlap-save).
+    std::array<long int, 3> P;
+    std::array<long int, 3> T; // Valid outputs per tile.
+    std::array<long int, 3> N_tiles;
+    for(long int a = 0; a < 3; ++a){
+        const long int valid_target = std::max<long int>(k.extent[a], 32);
+        P[a] = std::min( next_power_of_two(valid_target + k.extent[a] - 1),
+                         next_power_of_two(L.extent[a] + k.extent[a] - 1) );
+        T[a] = P[a] - k.extent[a] + 1;
+        N_tiles[a] = (L.extent[a] + T[a] - 1) / T[a];
+    }
+    const long int P_vol = P[0] * P[1] * P[2];
+    const auto P_index = [&](long int x, long int y, long int z) -> long int {
+        return (z * P[1] + y) * P[0] + x;
+    };
+
+    // Transform the kernel once. Correlation is obtained by multiplying with the conjugate spectrum.
+    std::vector<cplx> K(P_vol, cplx(0.0, 0.0));
+    {
+        std::vector<cplx> line;
+        for(long int z = 0; z < k.extent[2]; ++z){
+            for(long int y = 0; y < k.extent[1]; ++y){
+                for(long int x = 0; x < k.extent[0]; ++x){
+                    K[P_index(x, y, z)] = cplx(k.at(x, y, z), 0.0);
+                }
+            }
+        }
+        fft_3d(K, P, false, line);
+        for(auto &c : K) c = std::conj(c) / static_cast<double>(P_vol);
+    }
+
+    // When renormalizing, the accessibility mask is correlated alongside the values in the imaginary component. This
+    // works because the kernel is real.
+    const bool renormalize = (boundary == boundary_t::Renormalize);
+
+    parallel_for(0, N_tiles[0] * N_tiles[1] * N_tiles[2], [&](long int t) -> void {
+        const long int t0 = (t % N_tiles[0]) * T[0];
+        const long int t1 = ((t / N_tiles[0]) % N_tiles[1]) * T[1];
+        const long int t2 = (t / (N_tiles[0] * N_tiles[1])) * T[2];
+
+        std::vector<cplx> buf(P_vol, cplx(0.0, 0.0));
+        std::vector<cplx> line;
+        for(long int z = 0; z < P[2]; ++z){
+            const long int vz = t2 - k.centre[2] + z;
+            if((vz < 0) || (L.extent[2] <= vz)) continue;
+            for(long int y = 0; y < P[1]; ++y){
+                const long int vy = t1 - k.centre[1] + y;
+                if((vy < 0) || (L.extent[1] <= vy)) continue;
+                for(long int x = 0; x < P[0]; ++x){
+                    const long int vx = t0 - k.centre[0] + x;
+                    if((vx < 0) || (L.extent[0] <= vx)) continue;
+                    const double v = in[(vz * L.extent[1] + vy) * L.extent[0] + vx];
+                    if(!std::isfinite(v)) continue;
+                    buf[P_index(x, y, z)] = cplx(v, renormalize ? 1.0 : 0.0);
+                }
+            }
+        }
+
+        fft_3d(buf, P, false, line);
+        for(long int i = 0; i < P_vol; ++i) buf[i] *= K[i];
+        fft_3d(buf, P, true, line);
+
+        for(long int z = 0; (z < T[2]) && (t2 + z < L.extent[2]); ++z){
+            for(long int y = 0; (y < T[1]) && (t1 + y < L.extent[1]); ++y){
+                for(long int x = 0; (x < T[0]) && (t0 + x < L.extent[0]); ++x){
+                    const auto c = buf[P_index(x, y, z)];
+                    double out = c.real();
+                    if(renormalize){
+                        out = (std::abs(c.imag()) < min_accessible_weight * w_total) ? nan : c.real() / c.imag();
+                    }
+                    vol.data[L.offset(t0 + x, t1 + y, t2 + z)] = static_cast<float>(out);
+                }
+            }
+        }
+    });
+
+    // Voxels whose footprint includes inaccessible voxels were given zero weight above, so mark them explicitly.
+    if(boundary == boundary_t::Propagate){
+        std::vector<double> invalid(L.voxels(), 0.0);
+        for(size_t i = 0; i < in.size(); ++i){
+            if(!std::isfinite(in[i])) invalid[i] = 1.0;
+        }
+        for(long int a = 0; a < 3; ++a) box_sum(invalid, L.extent, a, k.extent[a], k.centre[a]);
+
+        parallel_for(0, L.extent[2], [&](long int img) -> void {
+            for(long int col = 0; col < L.extent[1]; ++col){
+                for(long int row = 0; row < L.extent[0]; ++row){
+                    const bool inside = (0 <= row - k.centre[0]) && (row - k.centre[0] + k.extent[0] <= L.extent[0])
+                                     && (0 <= col - k.centre[1]) && (col - k.centre[1] + k.extent[1] <= L.extent[1])
+                                     && (0 <= img - k.centre[2]) && (img - k.centre[2] + k.extent[2] <= L.extent[2]);
+                    if( !inside
+                    ||  (0.5 < invalid[(img * L.extent[1] + col) * L.extent[0] + row]) ){
+                        vol.data[L.offset(row, col, img)] = std::numeric_limits<float>::quiet_NaN();
+                    }
+                }
+            }
+        });
+    }
+    return;
+}
+
+// The Young-van Vliet recursive Gaussian, applied forward and backward along a zero-padded sequence.
+struct recursive_gaussian_t {
+    double B;
+    double b[4];
+
+    explicit recursive_gaussian_t(double sigma){
+        if(sigma < 0.5) throw std::invalid_argument("Sigma is too small for a recursive Gaussian.");
+        const double q = (2.5 <= sigma) ? (0.98711 * sigma - 0.96330)
+                                        : (3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma));
+        const double q2 = q * q;
+        const double q3 = q2 * q;
+        this->b[0] = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+        this->b[1] = (2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / this->b[0];
+        this->b[2] = -(1.4281 * q2 + 1.26661 * q3) / this->b[0];
+        this->b[3] = (0.422205 * q3) / this->b[0];
+        this->B = 1.0 - (this->b[1] + this->b[2] + this->b[3]);
+    }
+
+    void filter(std::vector<double> &x) const {
+        const long int n = static_cast<long int>(x.size());
+        double w1 = 0.0, w2 = 0.0, w3 = 0.0;
+        for(long int i = 0; i < n; ++i){
+            const double w = this->B * x[i] + this->b[1] * w1 + this->b[2] * w2 + this->b[3] * w3;
+            w3 = w2; w2 = w1; w1 = w;
+            x[i] = w;
+        }
+        w1 = w2 = w3 = 0.0;
+        for(long int i = n - 1; 0 <= i; --i){
+            const double w = this->B * x[i] + this->b[1] * w1 + this->b[2] * w2 + this->b[3] * w3;
+            w3 = w2; w2 = w1; w1 = w;
+            x[i] = w;
+        }
+        return;
+    }
+};
+
+void recursive_gaussian_1d(rectilinear_volume &vol, const layout_t &L, long int axis, double sigma){
+    const recursive_gaussian_t g(sigma);
+    const long int pad = static_cast<long int>(std::ceil(3.0 * sigma));
+    const auto nan = std::numeric_limits<float>::quiet_NaN();
+
+    for_each_line(L, axis, [&](long int start, long int stride, long int n) -> void {
+        std::vector<double> num(n + 2 * pad, 0.0);
+        std::vector<double> den(n + 2 * pad, 0.0);
+        for(long int i = 0; i < n; ++i){
+            const double v = vol.data[start + i * stride];
+            if(std::isfinite(v)){
+                num[pad + i] = v;
+                den[pad + i] = 1.0;
+            }
+        }
+        g.filter(num);
+        g.filter(den);
+        for(long int i = 0; i < n; ++i){
+            const double d = den[pad + i];
+            vol.data[start + i * stride] = (d < min_accessible_weight) ? nan
+                                                                        : static_cast<float>(num[pad + i] / d);
+        }
+    });
+    return;
+}
+
+} // namespace
+
+
+kernel_t flip(const kernel_t &k){
+    kernel_t out = k;
+    for(long int a = 0; a < 3; ++a) out.centre[a] = k.extent[a] - 1 - k.centre[a];
+    for(long int z = 0; z < k.extent[2]; ++z){
+        for(long int y = 0; y < k.extent[1]; ++y){
+            for(long int x = 0; x < k.extent[0]; ++x){
+                out.at(k.extent[0] - 1 - x, k.extent[1] - 1 - y, k.extent[2] - 1 - z) = k.at(x, y, z);
+            }
+        }
+    }
+    return out;
+}
+
+
+bool decompose(const kernel_t &k, std::array<std::vector<double>, 3> &factors, double rel_tol){
+    if(k.size() == 0) return false;
+
+    // Use the largest-magnitude tap as a pivot. For a separable kernel, the lines through the pivot are proportional to
+    // the 1D factors.
+    const auto max_it = std::max_element(std::begin(k.weights), std::end(k.weights),
+                                         [](double l, double r) -> bool { return std::abs(l) < std::abs(r); });
+    const double pivot = *max_it;
+    if(pivot == 0.0) return false;
+    const long int p = static_cast<long int>(std::distance(std::begin(k.weights), max_it));
+    const long int pcol = p % k.extent[1];
+    const long int prow = (p / k.extent[1]) % k.extent[0];
+    const long int pimg = p / (k.extent[1] * k.extent[0]);
+
+    factors[0].resize(k.extent[0]);
+    factors[1].resize(k.extent[1]);
+    factors[2].resize(k.extent[2]);
+    for(long int x = 0; x < k.extent[0]; ++x) factors[0][x] = k.at(x, pcol, pimg);
+    for(long int y = 0; y < k.extent[1]; ++y) factors[1][y] = k.at(prow, y, pimg) / pivot;
+    for(long int z = 0; z < k.extent[2]; ++z) factors[2][z] = k.at(prow, pcol, z) / pivot;
+
+    const double tol = rel_tol * std::abs(pivot);
+    for(long int z = 0; z < k.extent[2]; ++z){
+        for(long int y = 0; y < k.extent[1]; ++y){
+            for(long int x = 0; x < k.extent[0]; ++x){
+                const double r = factors[0][x] * factors[1][y] * factors[2][z];
+                if(tol < std::abs(r - k.at(x, y, z))) return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+void apply_1d(rectilinear_volume &vol,
+              long int channel,
+              long int axis,
+              const std::vector<double> &taps,
+              long int centre,
+              boundary_t boundary){
+    const layout_t L(vol, channel);
+    if((axis < 0) || (2 < axis)) throw std::invalid_argument("Invalid axis. Cannot convolve.");
+    const long int k = static_cast<long int>(taps.size());
+    if(k == 0) throw std::invalid_argument("Kernel is empty. Cannot convolve.");
+    const double w_total = std::accumulate(std::begin(taps), std::end(taps), 0.0,
+                                           [](double acc, double w) -> double { return acc + std::abs(w); });
+    const auto nan = std::numeric_limits<float>::quiet_NaN();
+
+    for_each_line(L, axis, [&](long int start, long int stride, long int n) -> void {
+        std::vector<double> in(n);
+        for(long int i = 0; i < n; ++i) in[i] = vol.data[start + i * stride];
+
+        for(long int i = 0; i < n; ++i){
+            double f = 0.0;
+            double w_sum = 0.0;
+            bool invalid = false;
+            for(long int t = 0; t < k; ++t){
+                const long int j = i + t - centre;
+                const double v = ((0 <= j) && (j < n)) ? in[j] : std::numeric_limits<double>::quiet_NaN();
+                if(!std::isfinite(v)){
+                    if(boundary == boundary_t::Propagate){
+                        invalid = true;
+                        break;
+                    }
+                    continue;
+                }
+                f += taps[t] * v;
+                w_sum += taps[t];
+            }
+
+            float out = static_cast<float>(f);
+            if(invalid){
+                out = nan;
+            }else if(boundary == boundary_t::Renormalize){
+                out = (std::abs(w_sum) < min_accessible_weight * w_total) ? nan : static_cast<float>(f / w_sum);
+            }
+            vol.data[start + i * stride] = out;
+        }
+    });
+    return;
+}
+
+
+void apply(rectilinear_volume &vol,
+           long int channel,
+           const kernel_t &k,
+           boundary_t boundary,
+           method_t method){
+    const layout_t L(vol, channel);
+    if( (k.size() == 0)
+    ||  (static_cast<long int>(k.weights.size()) != k.size()) ){
+        throw std::invalid_argument("Kernel is empty or malformed. Cannot convolve.");
+    }
+
+    std::array<std::vector<double>, 3> factors;
+    const bool separable = decompose(k, factors);
+
+    if(method == method_t::Automatic){
+        // Estimate the cost of each method in (roughly) multiply-adds.
+        const double N = static_cast<double>(L.voxels());
+        const double direct_cost = N * static_cast<double>(k.size());
+        double fft_cost = 0.0;
+        {
+            double tiles = 1.0;
+            double P_vol = 1.0;
+            for(long int a = 0; a < 3; ++a){
+                const long int valid_target = std::max<long int>(k.extent[a], 32);
+                const long int P = std::min( next_power_of_two(valid_target + k.extent[a] - 1),
+                                             next_power_of_two(L.extent[a] + k.extent[a] - 1) );
+                tiles *= std::ceil(static_cast<double>(L.extent[a]) / static_cast<double>(P - k.extent[a] + 1));
+                P_vol *= static_cast<double>(P);
+            }
+            fft_cost = tiles * P_vol * (2.0 * 5.0 * std::log2(std::max(2.0, P_vol)) + 8.0);
+        }
+
+        if(separable){
+            method = method_t::Separable;
+        }else if(fft_cost < direct_cost){
+            method = method_t::FFT;
+        }else{
+            method = method_t::Direct;
+        }
+    }
+
+    if(method == method_t::Separable){
+        if(!separable) throw std::invalid_argument("Kernel is not separable. Cannot convolve with 1D passes.");
+        for(long int a = 0; a < 3; ++a){
+            // Identity passes are skipped.
+            if( (k.extent[a] == 1)
+            &&  (factors[a][0] == 1.0) ) continue;
+            apply_1d(vol, channel, a, factors[a], k.centre[a], boundary);
+        }
+
+    }else if(method == method_t::FFT){
+        apply_fft(vol, L, k, boundary);
+
+    }else if(method == method_t::Direct){
+        apply_direct(vol, L, k, boundary);
+
+    }else{
+        throw std::invalid_argument("Requested convolution method is not applicable to arbitrary kernels.");
+    }
+    return;
+}
+
+
+std::vector<double> gaussian_taps(double sigma){
+    if(!(0.0 < sigma)) throw std::invalid_argument("Sigma must be positive.");
+    const long int r = std::max<long int>(1, static_cast<long int>(std::ceil(3.0 * sigma)));
+    const double s = sigma * std::sqrt(2.0);
+    std::vector<double> taps;
+    taps.reserve(2 * r + 1);
+    for(long int i = -r; i <= r; ++i){
+        const double lo = (static_cast<double>(i) - 0.5) / s;
+        const double hi = (static_cast<double>(i) + 0.5) / s;
+        taps.emplace_back( 0.5 * (std::erf(hi) - std::erf(lo)) );
+    }
+    return taps;
+}
+
+
+void gaussian_blur(rectilinear_volume &vol,
+                   long int channel,
+                   const std::array<double, 3> &sigmas,
+                   boundary_t boundary,
+                   method_t method){
+    const layout_t L(vol, channel);
+    if( (method == method_t::Recursive)
+    &&  (boundary != boundary_t::Renormalize) ){
+        throw std::invalid_argument("Recursive Gaussians only support renormalized boundaries.");
+    }
+    if( (method == method_t::Direct)
+    ||  (method == method_t::FFT) ){
+        throw std::invalid_argument("Gaussian blurs are separable; use the separable or recursive methods.");
+    }
+
+    for(long int a = 0; a < 3; ++a){
+        const double sigma = sigmas[a];
+        if(!(0.0 < sigma) || (L.extent[a] == 1)) continue;
+
+        const bool recursive = (method == method_t::Recursive)
+                            || ( (method == method_t::Automatic)
+                              && (boundary == boundary_t::Renormalize)
+                              && (recursive_sigma_threshold < sigma) );
+        if(recursive){
+            recursive_gaussian_1d(vol, L, a, sigma);
+        }else{
+            const auto taps = gaussian_taps(sigma);
+            apply_1d(vol, channel, a, taps, static_cast<long int>(taps.size() / 2), boundary);
+        }
+    }
+    return;
+}
+
+
+void apply_within_contours(planar_image_collection<float,double> &imagecoll,
+                           const vec3<double> &orientation_normal,
+                           std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
+                           long int channel,
+                           const std::function<void(rectilinear_volume &, long int channel)> &f){
+    if(imagecoll.images.empty()) return;
+
+    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+    for(auto &img : imagecoll.images) selected_imgs.push_back( std::ref(img) );
+    if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+        throw std::invalid_argument("Images do not form a rectilinear grid. Cannot continue");
+    }
+
+    // Order the images along the normal so that the volume's image axis is spatially coherent.
+    planar_image_adjacency<float,double> img_adj( {}, { { std::ref(imagecoll) } }, orientation_normal );
+    std::list<std::reference_wrapper<planar_image<float,double>>> ordered_imgs;
+    for(long int i = 0; img_adj.index_present(i); ++i){
+        ordered_imgs.push_back( img_adj.index_to_image(i) );
+    }
+    if(ordered_imgs.size() != imagecoll.images.size()){
+        throw std::invalid_argument("Unable to order images along the normal. Cannot continue");
+    }
+
+    rectilinear_volume vol(ordered_imgs);
+    for(long int c = 0; c < vol.channels; ++c){
+        if( (0 <= channel) && (c != channel) ) continue;
+        f(vol, c);
+    }
+
+    Mutate_Voxels_Opts mv_opts;
+    mv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
+    mv_opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
+    mv_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+    mv_opts.aggregate      = Mutate_Voxels_Opts::Aggregate::First;
+    mv_opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+    mv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
+
+    std::vector<std::reference_wrapper<planar_image<float,double>>> imgs( std::begin(ordered_imgs),
+                                                                          std::end(ordered_imgs) );
+    parallel_for(0, static_cast<long int>(imgs.size()), [&](long int img) -> void {
+        auto img_refw = imgs[img];
+        auto f_write = [&,img](long int row, long int col, long int chnl,
+                               std::reference_wrapper<planar_image<float,double>>,
+                               float &voxel_val) -> void {
+            if( (0 <= channel) && (chnl != channel) ) return;
+            voxel_val = vol.value(img, row, col, chnl);
+        };
+        Mutate_Voxels<float,double>( img_refw,
+                                     { img_refw },
+                                     ccsl,
+                                     mv_opts,
+                                     f_write );
+    }, /*grain=*/ 1);
+    return;
+}
+
+} // namespace volume_convolution
+
@@ -0,0 +1,112 @@
+//Volume_Convolution.h.
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <list>
+#include <vector>
+
+#include "YgorImages.h"
+
+#include "Rectilinear_Volume.h"
+
+
+template <class T> class contour_collection;
+
+
+// Convolution of packed rectilinear volumes.
+//
+// Kernels are applied in correlation form with an explicit centre, i.e.,
+//     out(x) = sum_r w(r) * in(x + r - centre)
+// where x and r index (row, column, image). Convolution is correlation with a flipped kernel; see flip().
+//
+// Several algorithms are available, and by default the cheapest one for a given kernel is selected:
+//   - Direct: evaluates the sum above for every voxel. Cost is proportional to the kernel size.
+//   - Separable: kernels that factor into a product of three 1D kernels are applied as three 1D passes.
+//   - FFT: tiled (overlap-save) FFT convolution, with cost nearly independent of the kernel size.
+// Gaussian blurs additionally support a recursive (Young-van Vliet IIR) filter whose cost is independent of sigma.
+//
+// All algorithms operate on a single channel of the packed buffer and are parallelized over the process-wide thread
+// pool.
+namespace volume_convolution {
+
+enum class method_t {
+    Automatic,  // Select the cheapest applicable method.
+    Direct,
+    Separable,  // Requires a separable kernel.
+    FFT,
+    Recursive,  // Gaussian blurs only.
+};
+
+// How voxels outside the volume, or voxels with non-finite values, are treated.
+enum class boundary_t {
+    Propagate,   // The output is NaN whenever the kernel footprint includes any such voxel.
+    Renormalize, // Such voxels are skipped and the remaining weights are renormalized. If the accessible weight is
+                 // negligible, the output is NaN. For separable kernels, renormalization is performed per pass.
+};
+
+struct kernel_t {
+    std::array<long int, 3> extent = {{ 0, 0, 0 }}; // Number of taps along (row, column, image).
+    std::array<long int, 3> centre = {{ 0, 0, 0 }}; // The tap aligned with the output voxel.
+    std::vector<double> weights;                     // Packed with (image, row, column) ordering.
+
+    double & at(long int row, long int col, long int img){
+        return this->weights[ (img * this->extent[0] + row) * this->extent[1] + col ];
+    }
+    double at(long int row, long int col, long int img) const {
+        return this->weights[ (img * this->extent[0] + row) * this->extent[1] + col ];
+    }
+    long int size() const {
+        return this->extent[0] * this->extent[1] * this->extent[2];
+    }
+};
+
+// Returns a spatially-inverted copy of the kernel, converting between convolution and correlation.
+kernel_t flip(const kernel_t &k);
+
+// Attempts to factor the kernel into 1D kernels along (row, column, image). Returns false if the kernel is not
+// separable to within the relative tolerance.
+bool decompose(const kernel_t &k, std::array<std::vector<double>, 3> &factors, double rel_tol = 1.0E-6);
+
+// Applies the kernel to a channel of the volume, overwriting it.
+void apply(rectilinear_volume &vol,
+           long int channel,
+           const kernel_t &k,
+           boundary_t boundary = boundary_t::Propagate,
+           method_t method = method_t::Automatic);
+
+// Applies a 1D kernel along the given axis (0 = row, 1 = column, 2 = image), overwriting the channel.
+void apply_1d(rectilinear_volume &vol,
+              long int channel,
+              long int axis,
+              const std::vector<double> &taps,
+              long int centre,
+              boundary_t boundary);
+
+// The taps of a Gaussian with the given sigma (in voxels) integrated over each voxel, extending 3 sigma from the
+// centre.
+std::vector<double> gaussian_taps(double sigma);
+
+// Blurs a channel with an axis-aligned Gaussian. The sigmas are in voxels along (row, column, image); non-positive
+// sigmas disable blurring along that axis. Only Automatic, Separable, and Recursive methods are meaningful.
+void gaussian_blur(rectilinear_volume &vol,
+                   long int channel,
+                   const std::array<double, 3> &sigmas,
+                   boundary_t boundary = boundary_t::Renormalize,
+                   method_t method = method_t::Automatic);
+
+
+// Packs a rectilinear image array into a volume (ordered along the provided normal) and invokes the functor, once for
+// every channel selected (negative channels select all channels). Afterward, voxels with centres inside the contours
+// are overwritten with the corresponding volume voxel values; other voxels are left untouched.
+//
+// Throws if the images do not form a rectilinear grid.
+void apply_within_contours(planar_image_collection<float,double> &imagecoll,
+                           const vec3<double> &orientation_normal,
+                           std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
+                           long int channel,
+                           const std::function<void(rectilinear_volume &, long int channel)> &f);
+
+} // namespace volume_convolution
+
@@ -0,0 +1,420 @@
+//Voxel_Inclusion_Mask.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "../Packed_Contours.h"
+#include "Voxel_Inclusion_Mask.h"
+
+
+bool voxel_inclusion_mask::is_bounded(long int row, long int col) const {
+    const auto first = std::next(std::begin(this->runs), this->row_offsets[row]);
+    const auto last  = std::next(std::begin(this->runs), this->row_offsets[row + 1]);
+    const auto it = std::upper_bound(first, last, static_cast<uint32_t>(col),
+                                     [](uint32_t c, const std::array<uint32_t, 2> &r) -> bool { return (c < r[0]); });
+    return (it != first) && (static_cast<uint32_t>(col) < std::prev(it)->at(1));
+}
+
+long int voxel_inclusion_mask::count() const {
+    long int n = 0;
+    for(const auto &r : this->runs) n += static_cast<long int>(r[1] - r[0]);
+    return n;
+}
+
+std::size_t voxel_inclusion_mask::footprint() const {
+    return sizeof(*this)
+         + this->row_offsets.size() * sizeof(uint32_t)
+         + this->runs.size() * sizeof(std::array<uint32_t, 2>);
+}
+
+
+namespace {
+
+// Cache keys are sequences of 64-bit words: the image geometry, the options, and two independent digests of the
+// contour vertices.
+using mask_key_t = std::vector<uint64_t>;
+
+struct key_hash {
+    std::size_t operator()(const mask_key_t &k) const {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for(const auto &w : k) h = (h ^ w) * 0x100000001b3ULL;
+        return static_cast<std::size_t>(h);
+    }
+};
+
+uint64_t bits(double x){
+    if(x == 0.0) x = 0.0; // Collapse signed zeros.
+    uint64_t out;
+    std::memcpy(&out, &x, sizeof(out));
+    return out;
+}
+
+uint64_t mix(uint64_t h, uint64_t v){
+    // A splitmix64-style finalizer applied after combining.
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+mask_key_t make_key(const planar_image<float,double> &img,
+               const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+               const Mutate_Voxels_Opts &opts){
+    mask_key_t k;
+    k.reserve(24);
+    k.push_back(static_cast<uint64_t>(img.rows));
+    k.push_back(static_cast<uint64_t>(img.columns));
+    for(const auto &v : { img.anchor, img.offset, img.row_unit, img.col_unit }){
+        k.push_back(bits(v.x));
+        k.push_back(bits(v.y));
+        k.push_back(bits(v.z));
+    }
+    k.push_back(bits(img.pxl_dx));
+    k.push_back(bits(img.pxl_dy));
+    k.push_back(bits(img.pxl_dz));
+    k.push_back(static_cast<uint64_t>(opts.inclusivity));
+    k.push_back(static_cast<uint64_t>(opts.contouroverlap));
+    k.push_back(static_cast<uint64_t>(opts.maskmod));
+
+    uint64_t h1 = 0x243f6a8885a308d3ULL;
+    uint64_t h2 = 0x13198a2e03707344ULL;
+    uint64_t n = 0;
+    for(const auto &cc_refw : ccsl){
+        h1 = mix(h1, 0xa5a5a5a5ULL); // Delimit collections.
+        h2 = mix(h2, 0x5a5a5a5aULL);
+        for(const auto &c : cc_refw.get().contours){
+            h1 = mix(h1, (c.closed ? 1ULL : 0ULL) + (static_cast<uint64_t>(c.points.size()) << 1));
+            h2 = mix(h2, (c.closed ? 2ULL : 3ULL) + (static_cast<uint64_t>(c.points.size()) << 2));
+            for(const auto &p : c.points){
+                const auto x = bits(p.x), y = bits(p.y), z = bits(p.z);
+                h1 = mix(mix(mix(h1, x), y), z);
+                h2 = mix(h2, x ^ mix(y, z ^ 0x452821e638d01377ULL));
+                ++n;
+            }
+        }
+    }
+    k.push_back(n);
+    k.push_back(h1);
+    k.push_back(h2);
+    return k;
+}
+
+// Rasterizes the contours with an edge-table scanline algorithm. Returns false if the options or geometry are not
+// supported, in which case the generic routine should be used.
+//
+// Contours are projected orthogonally onto the image plane and expressed in in-plane coordinates. Points are then tested using the same crossing rule as the generic point-in-polygon test, but all points on a
+// scanline are tested at once: each edge contributes a single crossing to each scanline it spans, and interior points
+// lie between alternating (sorted) crossings. The cost is proportional to the number of crossings plus the number of
+// voxels, rather than to the product of the number of voxels and contour vertices.
+//
+// Points are centres for 'centre' inclusivity, and voxel corners for the planar corner inclusivity options. In the
+// latter case, a voxel is bounded by a contour if any (inclusive) or all (exclusive) of its four corners are. Contours
+// are then combined according to the contour overlap option.
+bool scanline_rasterize(const planar_image<float,double> &img,
+                        const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                        const Mutate_Voxels_Opts &opts,
+                        std::vector<uint8_t> &dense){
+    if(opts.maskmod != Mutate_Voxels_Opts::MaskMod::Noop) return false;
+
+    const bool use_corners = (opts.inclusivity == Mutate_Voxels_Opts::Inclusivity::Inclusive)
+                          || (opts.inclusivity == Mutate_Voxels_Opts::Inclusivity::Exclusive);
+    if( !use_corners
+    &&  (opts.inclusivity != Mutate_Voxels_Opts::Inclusivity::Centre) ) return false;
+
+    const bool overlap_ignore = (opts.contouroverlap == Mutate_Voxels_Opts::ContourOverlap::Ignore);
+    const bool overlap_honour = (opts.contouroverlap == Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations);
+    const bool overlap_cancel = (opts.contouroverlap == Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations);
+    if(!overlap_ignore && !overlap_honour && !overlap_cancel) return false;
+
+    const long int rows = img.rows;
+    const long int cols = img.columns;
+    if( (rows <= 0) || (cols <= 0) ) return false;
+
+    // Index-space axes. Verify they reproduce the image's own voxel positions.
+    const auto p00 = img.position(0, 0);
+    const auto a = img.row_unit * img.pxl_dx;
+    const auto b = img.col_unit * img.pxl_dy;
+    const double a2 = a.Dot(a);
+    const double b2 = b.Dot(b);
+    if( !(0.0 < a2) || !(0.0 < b2) || !(std::abs(a.Dot(b)) < 1.0E-6 * std::sqrt(a2 * b2)) ) return false;
+    {
+        const double tol = 1.0E-6 * std::sqrt(a2 + b2);
+        const auto p_r = img.position(rows - 1, 0);
+        const auto p_c = img.position(0, cols - 1);
+        if( !((p00 + a * static_cast<double>(rows - 1)).distance(p_r) <= tol)
+        ||  !((p00 + b * static_cast<double>(cols - 1)).distance(p_c) <= tol) ) return false;
+    }
+
+    // The lattice of test points: voxel centres, or voxel corners.
+    const double offset = (use_corners) ? -0.5 : 0.0;
+    const long int L_rows = (use_corners) ? rows + 1 : rows;
+    const long int L_cols = (use_corners) ? cols + 1 : cols;
+
+    // In-plane distances of the test points from the first voxel.
+    // Corners are offset by half a voxel from the voxel centres, evaluated the same way as voxel corner positions.
+    const auto lattice_y = [&](long int i) -> double { return img.pxl_dx * static_cast<double>(i) + img.pxl_dx * offset; };
+    const auto lattice_x = [&](long int j) -> double { return img.pxl_dy * static_cast<double>(j) + img.pxl_dy * offset; };
+
+    // Count (or signed count) of the contours bounding each voxel.
+    std::vector<int32_t> tally(static_cast<size_t>(rows * cols), 0);
+
+    std::vector<double> ys, xs;
+    std::vector<std::vector<double>> crossings;
+    std::vector<uint8_t> corner_in;
+    std::pmr::monotonic_buffer_resource arena;
+    for(const auto &cc_refw : ccsl){
+        const auto &contours = cc_refw.get().contours;
+        const auto pc = Pack_Contours(contours, false, &arena);
+        auto c_it = std::begin(contours);
+        for(size_t c_i = 0; c_i < pc.size(); ++c_i, ++c_it){
+            if(pc.vertex_count(c_i) < 3) continue;
+            if(!img.encompasses_contour_of_points(*c_it)) continue;
+
+            // Express the vertices as in-plane distances (in DICOM units) from the first voxel.
+            Project_Contour(pc, c_i, p00, img.row_unit, img.col_unit, ys, xs);
+            double area2 = 0.0;
+            const auto N = ys.size();
+            double y_min = std::numeric_limits<double>::infinity();
+            double y_max = -y_min;
+            for(size_t i = 0, j = N - 1; i < N; j = i++){
+                area2 += (xs[j] - xs[i]) * (ys[j] + ys[i]);
+                y_min = std::min(y_min, ys[i]);
+                y_max = std::max(y_max, ys[i]);
+            }
+            if(!std::isfinite(area2)) continue;
+            const int32_t weight = (overlap_honour && (area2 < 0.0)) ? -1 : 1;
+
+            // Scanlines spanned by an edge satisfy min(y_i, y_j) <= y < max(y_i, y_j). Index ranges are estimated
+            // generously and then refined with the exact test, so round-off in the estimate has no effect.
+            const auto to_row = [&](double y) -> long int {
+                return static_cast<long int>(std::floor(y / img.pxl_dx - offset));
+            };
+            const long int s_begin = std::max<long int>(0, to_row(y_min));
+            const long int s_end   = std::min<long int>(L_rows, to_row(y_max) + 2);
+            if(s_end <= s_begin) continue;
+            crossings.resize(static_cast<size_t>(s_end - s_begin));
+            for(auto &x : crossings) x.clear();
+
+            for(size_t i = 0, j = N - 1; i < N; j = i++){
+                const double yi = ys[i], yj = ys[j];
+                const double xi = xs[i], xj = xs[j];
+                const long int e_begin = std::max(s_begin, to_row(std::min(yi, yj)));
+                const long int e_end   = std::min(s_end,   to_row(std::max(yi, yj)) + 2);
+                for(long int y = e_begin; y < e_end; ++y){
+                    const double yd = lattice_y(y);
+                    if((yi > yd) == (yj > yd)) continue;
+                    crossings[y - s_begin].push_back( (xj - xi) * (yd - yi) / (yj - yi) + xi );
+                }
+            }
+
+            // Points strictly left of an odd number of crossings are interior, i.e., points x in [x_{2m+1}, x_{2m+2})
+            // for sorted crossings.
+            const auto first_at_or_above = [&](double x) -> long int {
+                long int j = static_cast<long int>(std::ceil(x / img.pxl_dy - offset));
+                j = std::min<long int>(L_cols, std::max<long int>(0, j));
+                while( (0 < j) && (x <= lattice_x(j - 1)) ) --j;
+                while( (j < L_cols) && (lattice_x(j) < x) ) ++j;
+                return j;
+            };
+            const auto for_each_span = [&](long int y, auto &&f) -> void {
+                auto &x = crossings[y - s_begin];
+                std::sort(std::begin(x), std::end(x));
+                for(size_t k = 0; (k + 1) < x.size(); k += 2){
+                    const long int x_begin = first_at_or_above(x[k]);
+                    const long int x_end   = first_at_or_above(x[k + 1]);
+                    if(x_begin < x_end) f(x_begin, x_end);
+                }
+            };
+
+            if(!use_corners){
+                for(long int y = s_begin; y < s_end; ++y){
+                    int32_t *t = tally.data() + y * cols;
+                    for_each_span(y, [&](long int x_begin, long int x_end){
+                        for(long int x = x_begin; x < x_end; ++x) t[x] += weight;
+                    });
+                }
+
+            }else{
+                // Corner y is shared by voxel rows y - 1 and y.
+                const long int c_rows = s_end - s_begin;
+                corner_in.assign(static_cast<size_t>(c_rows * L_cols), 0);
+                for(long int y = s_begin; y < s_end; ++y){
+                    uint8_t *m = corner_in.data() + (y - s_begin) * L_cols;
+                    for_each_span(y, [&](long int x_begin, long int x_end){
+                        for(long int x = x_begin; x < x_end; ++x) m[x] = 1;
+                    });
+                }
+                const auto corner = [&](long int y, long int x) -> bool {
+                    return (s_begin <= y) && (y < s_end) && (corner_in[(y - s_begin) * L_cols + x] != 0);
+                };
+                const bool inclusive = (opts.inclusivity == Mutate_Voxels_Opts::Inclusivity::Inclusive);
+                const long int r_begin = std::max<long int>(0, s_begin - 1);
+                const long int r_end   = std::min<long int>(rows, s_end);
+                for(long int row = r_begin; row < r_end; ++row){
+                    int32_t *t = tally.data() + row * cols;
+                    for(long int col = 0; col < cols; ++col){
+                        const bool c00 = corner(row, col);
+                        const bool c01 = corner(row, col + 1);
+                        const bool c10 = corner(row + 1, col);
+                        const bool c11 = corner(row + 1, col + 1);
+                        const bool in = (inclusive) ? (c00 || c01 || c10 || c11)
+                                                    : (c00 && c01 && c10 && c11);
+                        if(in) t[col] += weight;
+                    }
+                }
+            }
+        }
+    }
+
+    dense.assign(static_cast<size_t>(rows * cols), 0);
+    for(size_t i = 0; i < tally.size(); ++i){
+        const auto t = tally[i];
+        dense[i] = (overlap_cancel) ? static_cast<uint8_t>((t % 2) != 0)
+                 : (overlap_honour) ? static_cast<uint8_t>(t != 0)
+                                    : static_cast<uint8_t>(0 < t);
+    }
+    return true;
+}
+
+std::shared_ptr<const voxel_inclusion_mask>
+rasterize(const planar_image<float,double> &img,
+          const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+          const Mutate_Voxels_Opts &opts){
+
+    std::vector<uint8_t> dense;
+    if(!scanline_rasterize(img, ccsl, opts, dense)){
+        // Rasterize the contours onto a single-channel image sharing the geometry, relying on the generic routine so
+        // the interpretation of all options is identical.
+        planar_image<float,double> mask_img;
+        mask_img.init_orientation(img.row_unit, img.col_unit);
+        mask_img.init_buffer(img.rows, img.columns, 1);
+        mask_img.init_spatial(img.pxl_dx, img.pxl_dy, img.pxl_dz, img.anchor, img.offset);
+
+        Mutate_Voxels_Opts mask_opts = opts;
+        mask_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
+        mask_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
+        mask_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+
+        dense.assign(static_cast<size_t>(img.rows * img.columns), 0);
+        auto f_bounded = [&](long int row, long int col, long int, std::reference_wrapper<planar_image<float,double>>, float &){
+            dense[ static_cast<size_t>(row * img.columns + col) ] = 1;
+        };
+        Mutate_Voxels<float,double>( std::ref(mask_img),
+                                     { std::ref(mask_img) },
+                                     ccsl,
+                                     mask_opts,
+                                     f_bounded );
+    }
+
+    // Encode the runs.
+    auto out = std::make_shared<voxel_inclusion_mask>();
+    out->rows = img.rows;
+    out->columns = img.columns;
+    out->row_offsets.reserve(static_cast<size_t>(img.rows + 1));
+    for(long int row = 0; row < img.rows; ++row){
+        out->row_offsets.push_back(static_cast<uint32_t>(out->runs.size()));
+        const uint8_t *m = dense.data() + row * img.columns;
+        long int col = 0;
+        while(col < img.columns){
+            if(m[col] == 0){
+                ++col;
+                continue;
+            }
+            const long int begin = col;
+            while( (col < img.columns) && (m[col] != 0) ) ++col;
+            out->runs.push_back({{ static_cast<uint32_t>(begin), static_cast<uint32_t>(col) }});
+        }
+    }
+    out->row_offsets.push_back(static_cast<uint32_t>(out->runs.size()));
+    out->runs.shrink_to_fit();
+    return out;
+}
+
+
+// A least-recently-used cache of rasterized masks.
+class mask_cache_t {
+  private:
+    static constexpr std::size_t max_footprint = 256UL * 1024UL * 1024UL; // bytes.
+
+    using entry_t = std::pair<mask_key_t, std::shared_ptr<const voxel_inclusion_mask>>;
+
+    std::mutex m;
+    std::list<entry_t> lru; // Most-recently used at the front.
+    std::unordered_map<mask_key_t, std::list<entry_t>::iterator, key_hash> index;
+    std::size_t footprint = 0;
+
+  public:
+    std::shared_ptr<const voxel_inclusion_mask> find(const mask_key_t &k){
+        std::lock_guard<std::mutex> lock(this->m);
+        const auto it = this->index.find(k);
+        if(it == std::end(this->index)) return nullptr;
+        this->lru.splice(std::begin(this->lru), this->lru, it->second);
+        return it->second->second;
+    }
+
+    void insert(const mask_key_t &k, const std::shared_ptr<const voxel_inclusion_mask> &mask){
+        std::lock_guard<std::mutex> lock(this->m);
+        if(this->index.count(k) != 0) return; // Another thread got there first.
+        this->lru.emplace_front(k, mask);
+        this->index[k] = std::begin(this->lru);
+        this->footprint += mask->footprint();
+
+        while( (max_footprint < this->footprint) && (1 < this->lru.size()) ){
+            this->footprint -= this->lru.back().second->footprint();
+            this->index.erase(this->lru.back().first);
+            this->lru.pop_back();
+        }
+    }
+
+    void clear(){
+        std::lock_guard<std::mutex> lock(this->m);
+        this->index.clear();
+        this->lru.clear();
+        this->footprint = 0;
+    }
+};
+
+mask_cache_t & mask_cache(){
+    static mask_cache_t cache;
+    return cache;
+}
+
+} // namespace
+
+
+std::shared_ptr<const voxel_inclusion_mask>
+Get_Voxel_Inclusion_Mask(const planar_image<float,double> &img,
+                         const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                         const Mutate_Voxels_Opts &opts){
+    const auto k = make_key(img, ccsl, opts);
+    auto mask = mask_cache().find(k);
+    if(mask == nullptr){
+        // Rasterize without holding the lock, so distinct images can be rasterized concurrently.
+        mask = rasterize(img, ccsl, opts);
+        mask_cache().insert(k, mask);
+    }
+    return mask;
+}
+
+void Clear_Voxel_Inclusion_Mask_Cache(){
+    mask_cache().clear();
+    return;
+}
+
@@ -0,0 +1,87 @@
+//Voxel_Inclusion_Mask.h.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+template <class T> class contour_collection;
+
+
+// The voxels of a single image that are bounded by a set of contours, stored as run-length spans.
+//
+// Each row holds zero or more non-overlapping, increasing runs [begin, end) of bounded columns. Voxels outside the runs
+// are unbounded.
+struct voxel_inclusion_mask {
+    long int rows    = 0;
+    long int columns = 0;
+
+    std::vector<uint32_t> row_offsets;          // rows + 1 entries; runs of row r are [row_offsets[r], row_offsets[r+1]).
+    std::vector<std::array<uint32_t, 2>> runs;  // Column ranges [begin, end) of bounded voxels.
+
+    bool is_bounded(long int row, long int col) const;
+
+    // The number of bounded voxels.
+    long int count() const;
+
+    // Approximate memory footprint, in bytes.
+    std::size_t footprint() const;
+};
+
+
+// Rasterizes the contours onto the image's voxel grid, honouring the inclusivity, contour overlap, and mask
+// modification options. Other options (edit style, aggregation, and adjacency) do not affect which voxels are bounded
+// and are ignored. Interior spans are computed for each row at once with a scanline algorithm; uncommon options fall
+// back to testing voxels individually with Mutate_Voxels.
+//
+// Rasterizations are cached process-wide, keyed on the image geometry, the contour vertices, and the options. Since the
+// contour vertices themselves are part of the key, modified contours are never matched with stale masks. The cache is
+// bounded in size, evicting the least-recently-used masks first, and is safe to use from multiple threads.
+std::shared_ptr<const voxel_inclusion_mask>
+Get_Voxel_Inclusion_Mask(const planar_image<float,double> &img,
+                         const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                         const Mutate_Voxels_Opts &opts);
+
+// Discards all cached masks.
+void Clear_Voxel_Inclusion_Mask_Cache();
+
+
+// Invokes f_bounded(row, col, chnl, img_refw, voxel_val) for every voxel bounded by the contours, like
+// Mutate_Voxels<float,double>(img_refw, { img_refw }, ccsl, opts, f_bounded).
+//
+// When voxels are edited in-place using only their own value, the cached rasterization is used. Otherwise, this
+// routine defers to Mutate_Voxels.
+template <class F>
+void Mutate_Bounded_Voxels(std::reference_wrapper<planar_image<float,double>> img_refw,
+                           const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                           const Mutate_Voxels_Opts &opts,
+                           F f_bounded){
+    if( (opts.editstyle != Mutate_Voxels_Opts::EditStyle::InPlace)
+    ||  (opts.adjacency != Mutate_Voxels_Opts::Adjacency::SingleVoxel) ){
+        Mutate_Voxels<float,double>( img_refw, { img_refw }, ccsl, opts, f_bounded );
+        return;
+    }
+
+    auto &img = img_refw.get();
+    const auto mask = Get_Voxel_Inclusion_Mask(img, ccsl, opts);
+    for(long int row = 0; row < img.rows; ++row){
+        for(auto r = mask->row_offsets[row]; r < mask->row_offsets[row + 1]; ++r){
+            const auto run_end = static_cast<long int>(mask->runs[r][1]);
+            for(auto col = static_cast<long int>(mask->runs[r][0]); col < run_end; ++col){
+                for(long int chnl = 0; chnl < img.channels; ++chnl){
+                    f_bounded(row, col, chnl, img_refw, img.reference(row, col, chnl));
+                }
+            }
+        }
+    }
+    return;
+}
+
@@ -0,0 +1,79 @@
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "Native_Contour_Codec.h"
+
+
+// Encodes and decodes the coordinates, and returns whether every coordinate was reproduced bit-for-bit.
+static bool round_trips(const std::vector<double> &xs){
+    std::string buf;
+    Native_Archive_Encode_Coordinate(buf, xs);
+
+    std::vector<double> out(xs.size());
+    native_contour_reader r{ buf.data(), buf.data() + buf.size() };
+    Native_Archive_Decode_Coordinate(r, out);
+    if(r.cur != r.end) return false;
+
+    return (std::memcmp(xs.data(), out.data(), xs.size() * sizeof(double)) == 0);
+}
+
+TEST_CASE( "Native_Contour_Codec" ){
+    SUBCASE("constant coordinates round-trip"){
+        REQUIRE(round_trips({ 1.5 }));
+        REQUIRE(round_trips({ -12.25, -12.25, -12.25 }));
+        REQUIRE(round_trips({ -0.0, -0.0 }));
+    }
+
+    SUBCASE("decimal coordinates round-trip"){
+        REQUIRE(round_trips({ 0.0, 1.0, -2.0, 3.0 }));
+        REQUIRE(round_trips({ -101.5, 12.25, 0.125, 7.0 }));
+        REQUIRE(round_trips({ 0.1, 0.2, 0.3, -123.456789 }));
+    }
+
+    SUBCASE("decimal coordinates are stored compactly"){
+        std::vector<double> xs;
+        for(long int i = 0; i < 1000; ++i) xs.push_back(-250.0 + 0.5 * static_cast<double>(i));
+        std::string buf;
+        Native_Archive_Encode_Coordinate(buf, xs);
+        REQUIRE(buf.size() < 2 * xs.size());
+    }
+
+    SUBCASE("signed zeros round-trip"){
+        REQUIRE(round_trips({ -0.0, 1.0 }));
+        REQUIRE(round_trips({ 0.0, -0.0, 0.0 }));
+        REQUIRE(round_trips({ 1.5, -0.0, -2.25 }));
+    }
+
+    SUBCASE("other coordinates round-trip"){
+        REQUIRE(round_trips({ 1.0 / 3.0, -2.0 / 7.0, std::sqrt(2.0) }));
+        REQUIRE(round_trips({ 1.0E-300, -1.0E300, std::numeric_limits<double>::denorm_min() }));
+        const auto inf = std::numeric_limits<double>::infinity();
+        REQUIRE(round_trips({ 1.0, inf, -inf }));
+        REQUIRE(round_trips({ 0.5, std::numeric_limits<double>::quiet_NaN() }));
+    }
+
+    SUBCASE("truncated data are rejected"){
+        std::string buf;
+        Native_Archive_Encode_Coordinate(buf, { 1.0 / 3.0, 2.0 / 3.0 });
+        buf.pop_back();
+
+        std::vector<double> out(2);
+        native_contour_reader r{ buf.data(), buf.data() + buf.size() };
+        REQUIRE_THROWS_AS(Native_Archive_Decode_Coordinate(r, out), std::runtime_error);
+    }
+
+    SUBCASE("invalid codecs are rejected"){
+        const std::string buf("\x7F", 1);
+        std::vector<double> out(2);
+        native_contour_reader r{ buf.data(), buf.data() + buf.size() };
+        REQUIRE_THROWS_AS(Native_Archive_Decode_Coordinate(r, out), std::runtime_error);
+    }
+}
@@ -0,0 +1,96 @@
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "Thread_Pool.h"
+
+
+TEST_CASE( "task_group" ){
+    SUBCASE("all tasks are executed before wait() returns"){
+        std::atomic<long int> count{0};
+        task_group tg;
+        for(long int i = 0; i < 1000; ++i){
+            tg.run([&](){ ++count; });
+        }
+        tg.wait();
+        REQUIRE(count.load() == 1000);
+    }
+
+    SUBCASE("the number of tasks in flight can be limited"){
+        std::atomic<long int> in_flight{0};
+        std::atomic<long int> max_seen{0};
+        task_group tg(2);
+        for(long int i = 0; i < 200; ++i){
+            tg.run([&](){
+                const auto n = ++in_flight;
+                long int prev = max_seen.load();
+                while( (prev < n) && !max_seen.compare_exchange_weak(prev, n) ){ }
+                --in_flight;
+            });
+        }
+        tg.wait();
+        REQUIRE(max_seen.load() <= 2);
+    }
+
+    SUBCASE("exceptions are propagated by wait()"){
+        task_group tg;
+        tg.run([](){ throw std::runtime_error("test"); });
+        REQUIRE_THROWS_AS(tg.wait(), std::runtime_error);
+    }
+
+    SUBCASE("a separate pool can be used"){
+        work_stealing_pool p(3);
+        REQUIRE(p.concurrency() == 3);
+        std::atomic<long int> count{0};
+        task_group tg(0, p);
+        for(long int i = 0; i < 100; ++i){
+            tg.run([&](){ ++count; });
+        }
+        tg.wait();
+        REQUIRE(count.load() == 100);
+    }
+}
+
+TEST_CASE( "parallel_for" ){
+    SUBCASE("every index is visited exactly once"){
+        std::vector<long int> v(10'000, 0);
+        parallel_for(0, static_cast<long int>(v.size()), [&](long int i){ v[i] += i; });
+        for(long int i = 0; i < static_cast<long int>(v.size()); ++i){
+            REQUIRE(v[i] == i);
+        }
+    }
+
+    SUBCASE("nested invocations do not deadlock"){
+        std::atomic<long int> count{0};
+        parallel_for(0, 64, [&](long int){
+            parallel_for(0, 64, [&](long int){ ++count; });
+        });
+        REQUIRE(count.load() == 64*64);
+    }
+
+    SUBCASE("empty ranges are no-ops"){
+        long int count = 0;
+        parallel_for(5, 5, [&](long int){ ++count; });
+        parallel_for(5, 1, [&](long int){ ++count; });
+        REQUIRE(count == 0);
+    }
+}
+
+TEST_CASE( "work_stealing_pool::parse_cpu_list" ){
+    SUBCASE("individual CPUs and ranges are expanded"){
+        const auto cpus = work_stealing_pool::parse_cpu_list("0-3,8,10-11");
+        const std::vector<long int> expected = {0, 1, 2, 3, 8, 10, 11};
+        REQUIRE(cpus == expected);
+    }
+
+    SUBCASE("malformed lists are rejected"){
+        REQUIRE_THROWS_AS(work_stealing_pool::parse_cpu_list("0-"), std::invalid_argument);
+        REQUIRE_THROWS_AS(work_stealing_pool::parse_cpu_list("3-1"), std::invalid_argument);
+        REQUIRE_THROWS_AS(work_stealing_pool::parse_cpu_list("a"), std::invalid_argument);
+        REQUIRE_THROWS_AS(work_stealing_pool::parse_cpu_list("1x"), std::invalid_argument);
+    }
+}
+
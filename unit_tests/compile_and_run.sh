@@ -26,6 +26,8 @@ fi
 g++ -std=c++17 -Wall -I. -I"${REPOROOT}/src" \
   Main.cc \
   {,"${REPOROOT}/src/"}Alignment_TPSRPM.cc \
+  {,"${REPOROOT}/src/"}Native_Contour_Codec.cc \
+  Thread_Pool.cc \
   -o run_tests \
   -pthread \
   -lboost_system \